@@ -0,0 +1,190 @@
+#ifndef OSMIUM_BENCHMARK_HARNESS_HPP
+#define OSMIUM_BENCHMARK_HARNESS_HPP
+
+/*
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+/*
+
+  Small harness for the benchmark suite. Every benchmark is run a number of
+  times after some warmup runs. The statistics of the measured run times
+  are written as one JSON object per line, so that results of different
+  versions can be compared with compare_benchmarks.sh.
+
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace benchmark {
+
+    struct statistics {
+        double min = 0.0;
+        double median = 0.0;
+        double mean = 0.0;
+        double stddev = 0.0;
+    };
+
+    /**
+     * Calculate statistics of the given run times (in seconds). The
+     * standard deviation is the sample standard deviation.
+     */
+    inline statistics calculate_statistics(std::vector<double> times) {
+        statistics stats;
+        if (times.empty()) {
+            return stats;
+        }
+
+        std::sort(times.begin(), times.end());
+        stats.min = times.front();
+
+        const auto mid = times.size() / 2;
+        stats.median = times.size() % 2 ? times[mid] : (times[mid - 1] + times[mid]) / 2;
+
+        double sum = 0.0;
+        for (const double t : times) {
+            sum += t;
+        }
+        stats.mean = sum / static_cast<double>(times.size());
+
+        if (times.size() > 1) {
+            double sq = 0.0;
+            for (const double t : times) {
+                sq += (t - stats.mean) * (t - stats.mean);
+            }
+            stats.stddev = std::sqrt(sq / static_cast<double>(times.size() - 1));
+        }
+
+        return stats;
+    }
+
+    /**
+     * Escape a string for use in JSON output. Only quotes, backslashes
+     * and control characters need escaping.
+     */
+    inline std::string json_escape(const std::string& str) {
+        static const char* hex = "0123456789abcdef";
+        std::string out;
+        out.reserve(str.size());
+        for (const char c : str) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                out += "\\u00";
+                out += hex[(c >> 4) & 0xf];
+                out += hex[c & 0xf];
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    class Harness {
+
+        std::ostream& m_out;
+        std::string m_input;
+        std::string m_filter;
+        int m_warmup;
+        int m_runs;
+
+        using clock = std::chrono::steady_clock;
+
+        static double seconds_since(const clock::time_point start) {
+            return std::chrono::duration<double>(clock::now() - start).count();
+        }
+
+        void report(const std::string& name, const std::vector<double>& times, uint64_t items) {
+            const auto stats = calculate_statistics(times);
+
+            m_out << std::setprecision(6)
+                  << "{\"benchmark\":\"" << json_escape(name)
+                  << "\",\"input\":\"" << json_escape(m_input)
+                  << "\",\"warmup\":" << m_warmup
+                  << ",\"runs\":" << m_runs
+                  << ",\"items\":" << items
+                  << ",\"min_s\":" << stats.min
+                  << ",\"median_s\":" << stats.median
+                  << ",\"mean_s\":" << stats.mean
+                  << ",\"stddev_s\":" << stats.stddev
+                  << ",\"items_per_s\":" << (stats.median > 0.0 ? static_cast<double>(items) / stats.median : 0.0)
+                  << "}\n" << std::flush;
+        }
+
+    public:
+
+        /**
+         * @param out Stream the results are written to.
+         * @param input Name of the input, reported with every result.
+         * @param filter Only run benchmarks whose name contains this.
+         * @param warmup Number of untimed runs before the timed runs.
+         * @param runs Number of timed runs.
+         */
+        Harness(std::ostream& out, std::string input, std::string filter, int warmup, int runs) :
+            m_out(out),
+            m_input(std::move(input)),
+            m_filter(std::move(filter)),
+            m_warmup(warmup),
+            m_runs(runs < 1 ? 1 : runs) {
+        }
+
+        bool enabled(const std::string& name) const {
+            return name.find(m_filter) != std::string::npos;
+        }
+
+        /**
+         * Run a benchmark. The function is called for every run and must
+         * return the number of items (objects, blobs, ...) it processed.
+         */
+        template <typename TFunc>
+        void run(const std::string& name, TFunc&& func) {
+            run_with_setup(name, []() { return 0; }, [&func](int /*context*/) {
+                return func();
+            });
+        }
+
+        /**
+         * Run a benchmark with an untimed setup. The setup function is
+         * called before every run, its result is handed to the benchmark
+         * function. Only the benchmark function is timed.
+         */
+        template <typename TSetup, typename TFunc>
+        void run_with_setup(const std::string& name, TSetup&& setup, TFunc&& func) {
+            if (!enabled(name)) {
+                return;
+            }
+
+            for (int n = 0; n < m_warmup; ++n) {
+                auto context = setup();
+                func(std::move(context));
+            }
+
+            std::vector<double> times;
+            uint64_t items = 0;
+            for (int n = 0; n < m_runs; ++n) {
+                auto context = setup();
+                const auto start = clock::now();
+                items = func(std::move(context));
+                times.push_back(seconds_since(start));
+            }
+
+            report(name, times, items);
+        }
+
+    }; // class Harness
+
+} // namespace benchmark
+
+#endif // OSMIUM_BENCHMARK_HARNESS_HPP
@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+#  compare_benchmarks.sh OLD NEW [THRESHOLD]
+#
+#  Compare two result files written by run_benchmark_suite.sh. For every
+#  benchmark and input in both files the median run times are compared.
+#  Changes slower than THRESHOLD percent (default 10) are marked as
+#  regressions and make the script exit with status 1.
+#
+
+set -e
+
+if [ $# -lt 2 -o $# -gt 3 ]; then
+    echo "Usage: $0 OLD NEW [THRESHOLD]" >&2
+    exit 2
+fi
+
+THRESHOLD=${3:-10}
+
+awk -v threshold=$THRESHOLD '
+function field(line, name,    re, s) {
+    re = "\"" name "\":\"?[^,\"}]*"
+    if (match(line, re)) {
+        s = substr(line, RSTART, RLENGTH)
+        sub("\"" name "\":\"?", "", s)
+        return s
+    }
+    return ""
+}
+FNR == 1 { file++ }
+/^\{/ {
+    key = field($0, "input") " " field($0, "benchmark")
+    if (file == 1) {
+        old[key] = field($0, "median_s")
+    } else if (key in old) {
+        keys[++n] = key
+        new[key] = field($0, "median_s")
+    }
+}
+END {
+    regressions = 0
+    printf "%-60s %12s %12s %8s\n", "# input benchmark", "old_s", "new_s", "change"
+    for (i = 1; i <= n; i++) {
+        k = keys[i]
+        change = old[k] > 0 ? (new[k] - old[k]) * 100 / old[k] : 0
+        mark = ""
+        if (change > threshold) {
+            mark = " REGRESSION"
+            regressions++
+        }
+        printf "%-60s %12g %12g %+7.1f%%%s\n", k, old[k], new[k], change, mark
+    }
+    exit regressions > 0
+}
+' "$1" "$2"
+
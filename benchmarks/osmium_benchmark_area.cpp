@@ -0,0 +1,496 @@
+/*
+
+  Benchmark for the area assembler. Assembles generated pathological
+  multipolygons (thousands of inner rings, long nested coastlines, many
+  touching rings, a huge admin boundary) and optionally all multipolygons
+  from the OSM files given on the command line, for instance the
+  multipolygon.osm file from the osm-testdata repository used by the data
+  tests. The results are written as JSON lines to stdout in the same format
+  as the results of the benchmark suite (with some additional fields), so
+  they can be compared with compare_benchmarks.sh.
+
+  For each benchmark the number of memory allocations per run is reported.
+  If the benchmark is compiled with OSMIUM_WITH_TIMER defined, the time
+  spent in each phase of the assembler (sorting segments, removing
+  duplicates, finding intersections, etc.) is reported, too.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include "benchmark_harness.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/visitor.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Count all memory allocations of the program.
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(std::size_t size) {
+    ++allocations;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+// GCC does not know that the memory freed here was allocated with malloc()
+// in the operator new above.
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+namespace {
+
+    const char* const phase_names[] = {
+        "sort", "dupl", "intersection", "locations", "split", "simple_case", "complex_case", "roles_check"
+    };
+
+    enum {
+        num_phases = sizeof(phase_names) / sizeof(phase_names[0])
+    };
+
+    /**
+     * With OSMIUM_WITH_TIMER the assembler writes a line with the number of
+     * nodes, outer rings, inner rings and the microseconds spent in each
+     * phase to stdout for every area. This captures these lines while the
+     * benchmark runs and adds up the times for each phase.
+     */
+    class phase_timer_capture {
+
+        std::ostringstream m_out;
+        std::streambuf* m_old;
+
+    public:
+
+        phase_timer_capture() :
+            m_old(std::cout.rdbuf(m_out.rdbuf())) {
+        }
+
+        phase_timer_capture(const phase_timer_capture&) = delete;
+        phase_timer_capture& operator=(const phase_timer_capture&) = delete;
+
+        phase_timer_capture(phase_timer_capture&&) = delete;
+        phase_timer_capture& operator=(phase_timer_capture&&) = delete;
+
+        ~phase_timer_capture() {
+            std::cout.rdbuf(m_old);
+        }
+
+        void add_to(std::vector<double>& phases) const {
+            std::istringstream in{m_out.str()};
+            std::string line;
+            while (std::getline(in, line)) {
+                if (line.empty() || line[0] < '0' || line[0] > '9') {
+                    continue; // header line
+                }
+                std::istringstream values{line};
+                int64_t ignored = 0;
+                values >> ignored >> ignored >> ignored; // nodes, outer, inner
+                for (auto& phase : phases) {
+                    int64_t microseconds = 0;
+                    values >> microseconds;
+                    phase += static_cast<double>(microseconds) / 1000000.0;
+                }
+            }
+        }
+
+    }; // class phase_timer_capture
+
+    struct test_case {
+        std::string name;
+        osmium::memory::Buffer ways{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        osmium::memory::Buffer relation{1024UL, osmium::memory::Buffer::auto_grow::yes};
+        std::vector<const osmium::Way*> members;
+        uint64_t num_nodes = 0;
+    };
+
+    /**
+     * Builds the ways and the relation of a generated test case. Rings
+     * are split into ways of at most max_way_nodes nodes.
+     */
+    class case_builder {
+
+        enum {
+            max_way_nodes = 500
+        };
+
+        test_case& m_case;
+        std::vector<std::pair<osmium::object_id_type, const char*>> m_members;
+        osmium::object_id_type m_node_id = 1;
+        osmium::object_id_type m_way_id = 1;
+
+        void add_way(const std::vector<osmium::NodeRef>& nodes, const char* role) {
+            {
+                osmium::builder::WayBuilder builder{m_case.ways};
+                builder.set_id(m_way_id);
+                osmium::builder::WayNodeListBuilder wnl_builder{builder};
+                for (const auto& node_ref : nodes) {
+                    wnl_builder.add_node_ref(node_ref);
+                }
+            }
+            m_case.ways.commit();
+            m_members.emplace_back(m_way_id++, role);
+        }
+
+    public:
+
+        explicit case_builder(test_case& tc) :
+            m_case(tc) {
+        }
+
+        /// Add a closed ring with the given locations.
+        void add_ring(const std::vector<osmium::Location>& locations, const char* role) {
+            const auto first_id = m_node_id;
+            std::vector<osmium::NodeRef> nodes;
+            for (const auto& location : locations) {
+                nodes.emplace_back(m_node_id++, location);
+                if (nodes.size() == max_way_nodes) {
+                    add_way(nodes, role);
+                    nodes.erase(nodes.begin(), nodes.end() - 1);
+                }
+            }
+            nodes.emplace_back(first_id, locations.front());
+            add_way(nodes, role);
+            m_case.num_nodes += locations.size();
+        }
+
+        /// Add a closed square ring.
+        void add_square(double x, double y, double size, const char* role) {
+            add_ring({osmium::Location{x, y},
+                      osmium::Location{x + size, y},
+                      osmium::Location{x + size, y + size},
+                      osmium::Location{x, y + size}}, role);
+        }
+
+        /// Add the relation and remember pointers to the member ways.
+        void finish() {
+            {
+                osmium::builder::RelationBuilder builder{m_case.relation};
+                builder.set_id(1);
+                builder.add_tags({{"type", "multipolygon"}, {"landuse", "forest"}});
+                osmium::builder::RelationMemberListBuilder rml_builder{builder};
+                for (const auto& member : m_members) {
+                    rml_builder.add_member(osmium::item_type::way, member.first, member.second);
+                }
+            }
+            m_case.relation.commit();
+
+            for (const auto& way : m_case.ways.select<osmium::Way>()) {
+                m_case.members.push_back(&way);
+            }
+        }
+
+    }; // class case_builder
+
+    // Ring around the center with the given radius. The radius changes
+    // with a wave of the given amplitude to make it look more like a
+    // coastline than a circle.
+    std::vector<osmium::Location> wavy_ring(double cx, double cy, double radius, double amplitude, std::size_t num_nodes) {
+        const double pi = 3.14159265358979323846;
+        std::vector<osmium::Location> locations;
+        locations.reserve(num_nodes);
+        for (std::size_t i = 0; i < num_nodes; ++i) {
+            const double angle = 2 * pi * static_cast<double>(i) / static_cast<double>(num_nodes);
+            const double r = radius + amplitude * std::sin(angle * 97) + amplitude / 2 * std::sin(angle * 1013);
+            locations.emplace_back(cx + r * std::cos(angle), cy + r * std::sin(angle));
+        }
+        return locations;
+    }
+
+    // One outer ring with a grid of small inner rings.
+    void generate_many_inner_rings(test_case& tc, int grid) {
+        case_builder builder{tc};
+        builder.add_square(0.0, 0.0, 1.0, "outer");
+        const double cell = 1.0 / (grid + 1);
+        for (int y = 0; y < grid; ++y) {
+            for (int x = 0; x < grid; ++x) {
+                builder.add_square(cell * (x + 0.75), cell * (y + 0.75), cell / 2, "inner");
+            }
+        }
+        builder.finish();
+    }
+
+    // Nested rings alternating between outer and inner with many nodes.
+    void generate_nested_coastline(test_case& tc, int depth, std::size_t nodes_per_ring) {
+        case_builder builder{tc};
+        for (int i = 0; i < depth; ++i) {
+            builder.add_ring(wavy_ring(0.0, 0.0, 10.0 - i * 0.9, 0.1, nodes_per_ring), i % 2 ? "inner" : "outer");
+        }
+        builder.finish();
+    }
+
+    // Checkerboard of squares, each square touches its neighbours at the
+    // corners, so the assembler has to use the complex algorithm. The time
+    // for this grows exponentially with the size of the grid.
+    void generate_touching_rings(test_case& tc, int grid) {
+        case_builder builder{tc};
+        for (int y = 0; y < grid; ++y) {
+            for (int x = y % 2; x < grid; x += 2) {
+                builder.add_square(x * 0.01, y * 0.01, 0.01, "outer");
+            }
+        }
+        builder.finish();
+    }
+
+    // One huge ring split into many ways with some exclaves and enclaves.
+    void generate_admin_boundary(test_case& tc, std::size_t num_nodes) {
+        case_builder builder{tc};
+        builder.add_ring(wavy_ring(0.0, 0.0, 10.0, 0.2, num_nodes), "outer");
+        for (int i = 0; i < 20; ++i) {
+            builder.add_ring(wavy_ring(-5.0 + i * 0.5, 0.0, 0.2, 0.01, 1000), "inner");
+            builder.add_ring(wavy_ring(12.0 + i * 0.5, 12.0, 0.2, 0.01, 1000), "outer");
+        }
+        builder.finish();
+    }
+
+    class Runner {
+
+        std::string m_filter;
+        int m_warmup;
+        int m_runs;
+
+    public:
+
+        Runner(std::string filter, int warmup, int runs) :
+            m_filter(std::move(filter)),
+            m_warmup(warmup),
+            m_runs(runs < 1 ? 1 : runs) {
+        }
+
+        bool enabled(const std::string& name) const {
+            return name.find(m_filter) != std::string::npos;
+        }
+
+        /**
+         * Run the benchmark function the configured number of times and
+         * report the results. The function must return the number of
+         * items processed.
+         */
+        void run(const std::string& name, const std::string& input, const std::function<uint64_t()>& func) {
+            if (!enabled(name)) {
+                return;
+            }
+
+            for (int n = 0; n < m_warmup; ++n) {
+                const phase_timer_capture capture;
+                func();
+            }
+
+            std::vector<double> times;
+            std::vector<double> phases(num_phases, 0.0);
+            uint64_t items = 0;
+            uint64_t allocs = 0;
+            for (int n = 0; n < m_runs; ++n) {
+                const phase_timer_capture capture;
+                const uint64_t allocs_start = allocations;
+                const auto start = std::chrono::steady_clock::now();
+                items = func();
+                times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                allocs += allocations - allocs_start;
+                capture.add_to(phases);
+            }
+
+            const auto stats = benchmark::calculate_statistics(times);
+
+            std::cout << std::setprecision(6)
+                      << "{\"benchmark\":\"" << benchmark::json_escape(name)
+                      << "\",\"input\":\"" << benchmark::json_escape(input)
+                      << "\",\"warmup\":" << m_warmup
+                      << ",\"runs\":" << m_runs
+                      << ",\"items\":" << items
+                      << ",\"min_s\":" << stats.min
+                      << ",\"median_s\":" << stats.median
+                      << ",\"mean_s\":" << stats.mean
+                      << ",\"stddev_s\":" << stats.stddev
+                      << ",\"items_per_s\":" << (stats.median > 0.0 ? static_cast<double>(items) / stats.median : 0.0)
+                      << ",\"allocations\":" << allocs / static_cast<uint64_t>(m_runs);
+#ifdef OSMIUM_WITH_TIMER
+            for (int i = 0; i < num_phases; ++i) {
+                std::cout << ",\"phase_" << phase_names[i] << "_s\":" << phases[i] / m_runs;
+            }
+#endif
+            std::cout << "}\n" << std::flush;
+        }
+
+    }; // class Runner
+
+    // Assemble the multipolygon of a generated test case. The items are
+    // the number of nodes in all rings.
+    void benchmark_generated(Runner& runner, const std::string& name, const std::function<void(test_case&)>& generate) {
+        if (!runner.enabled("area/" + name)) {
+            return;
+        }
+
+        test_case tc;
+        generate(tc);
+
+        runner.run("area/" + name, "generated", [&tc]() {
+            osmium::memory::Buffer out{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+            const osmium::area::Assembler::config_type config;
+            osmium::area::Assembler assembler{config};
+            if (!assembler(tc.relation.get<osmium::Relation>(0), tc.members, out)) {
+                std::cerr << "Assembling area/" << tc.name << " failed\n";
+                std::exit(1);
+            }
+            return tc.num_nodes;
+        });
+    }
+
+    osmium::memory::Buffer read_all(const std::string& filename) {
+        osmium::memory::Buffer all{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+        osmium::io::Reader reader{filename};
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            all.add_buffer(buffer);
+            all.commit();
+        }
+        reader.close();
+
+        return all;
+    }
+
+    // Assemble all multipolygons in the file with the MultipolygonManager.
+    // The first pass is not timed. The items are the areas created.
+    void benchmark_file(Runner& runner, const std::string& filename) {
+        if (!runner.enabled("area/file")) {
+            return;
+        }
+
+        const auto slash = filename.find_last_of('/');
+        const std::string input{slash == std::string::npos ? filename : filename.substr(slash + 1)};
+
+        osmium::memory::Buffer data{read_all(filename)};
+
+        using manager_type = osmium::area::MultipolygonManager<osmium::area::Assembler>;
+        runner.run("area/file", input, [&data]() {
+            manager_type manager{osmium::area::Assembler::config_type{}};
+            osmium::apply(data, manager);
+            manager.prepare_for_lookup();
+
+            using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+            index_type index;
+            osmium::handler::NodeLocationsForWays<index_type> location_handler{index};
+            location_handler.ignore_errors();
+
+            uint64_t count = 0;
+            osmium::apply(data, location_handler, manager.handler([&count](osmium::memory::Buffer&& buffer) {
+                for (const auto& area : buffer.select<osmium::Area>()) {
+                    (void)area;
+                    ++count;
+                }
+            }));
+            return count;
+        });
+    }
+
+    void print_usage(const char* prgname) {
+        std::cerr << "Usage: " << prgname << " [-w WARMUP] [-r RUNS] [-b FILTER] [OSMFILE...]\n"
+                  << "  -w, --warmup=NUM     Number of untimed runs per benchmark (default: 1)\n"
+                  << "  -r, --runs=NUM       Number of timed runs per benchmark (default: 5)\n"
+                  << "  -b, --benchmark=STR  Only run benchmarks with STR in their name\n";
+    }
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    static struct option long_options[] = {
+        {"benchmark", required_argument, nullptr, 'b'},
+        {"help",            no_argument, nullptr, 'h'},
+        {"runs",      required_argument, nullptr, 'r'},
+        {"warmup",    required_argument, nullptr, 'w'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int warmup = 1;
+    int runs = 5;
+    std::string filter;
+
+    while (true) {
+        const int c = getopt_long(argc, argv, "b:hr:w:", long_options, nullptr);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+            case 'b':
+                filter = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                std::exit(0);
+            case 'r':
+                runs = std::atoi(optarg);
+                break;
+            case 'w':
+                warmup = std::atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                std::exit(1);
+        }
+    }
+
+    try {
+        Runner runner{filter, warmup, runs};
+
+        benchmark_generated(runner, "many_inner_rings", [](test_case& tc) {
+            tc.name = "many_inner_rings";
+            generate_many_inner_rings(tc, 70);
+        });
+        benchmark_generated(runner, "nested_coastline", [](test_case& tc) {
+            tc.name = "nested_coastline";
+            generate_nested_coastline(tc, 10, 20000);
+        });
+        benchmark_generated(runner, "touching_rings", [](test_case& tc) {
+            tc.name = "touching_rings";
+            generate_touching_rings(tc, 6);
+        });
+        benchmark_generated(runner, "admin_boundary", [](test_case& tc) {
+            tc.name = "admin_boundary";
+            generate_admin_boundary(tc, 200000);
+        });
+
+        for (int i = optind; i < argc; ++i) {
+            benchmark_file(runner, argv[i]);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        std::exit(1);
+    }
+}
@@ -37,6 +37,8 @@ int main(int argc, char* argv[]) {
 
         osmium::apply(reader, location_handler);
         reader.close();
+
+        std::cout << location_store << ": " << index->statistics() << '\n';
     } catch (const std::exception& e) {
         std::cerr << e.what() << '\n';
         std::exit(1);
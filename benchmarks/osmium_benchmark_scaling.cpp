@@ -0,0 +1,228 @@
+/*
+
+  Read an OSM file with different thread pool and reader configurations
+  and report throughput, CPU use and peak memory for each one. The results
+  are written as JSON lines to stdout in the same format as the results of
+  the benchmark suite (with some additional fields), so they can be
+  compared with compare_benchmarks.sh.
+
+  Each configuration is run in its own child process, so that the peak
+  memory use reported is that of this configuration alone.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include "benchmark_harness.hpp"
+
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/reader_options.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/memory.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+struct configuration {
+    int threads;
+    osmium::thread::pool_scheduling scheduling;
+    bool pool_parsing;
+    std::size_t queue_size;
+
+    std::string name() const {
+        std::ostringstream out;
+        out << "scaling/threads=" << threads
+            << "/scheduling=" << (scheduling == osmium::thread::pool_scheduling::work_stealing ? "work_stealing" : "shared_queue")
+            << "/parsing=" << (pool_parsing ? "pool" : "parser_thread")
+            << "/queue=" << queue_size;
+        return out.str();
+    }
+};
+
+static double cpu_seconds() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000000.0;
+}
+
+static uint64_t read_file(const std::string& filename, osmium::thread::Pool& pool, bool pool_parsing) {
+    uint64_t count = 0;
+    osmium::io::Reader reader{filename, pool, pool_parsing ? osmium::io::decode_window{} : osmium::io::decode_window{0}};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            (void)object;
+            ++count;
+        }
+    }
+    reader.close();
+    return count;
+}
+
+// Runs in the child process.
+static void run_configuration(const configuration& config, const std::string& filename, const std::string& input, int runs) {
+    // The reader reads its queue sizes from the environment.
+    const std::string queue_size = std::to_string(config.queue_size);
+    setenv("OSMIUM_MAX_INPUT_QUEUE_SIZE", queue_size.c_str(), 1);
+    setenv("OSMIUM_MAX_OSMDATA_QUEUE_SIZE", queue_size.c_str(), 1);
+
+    osmium::thread::Pool pool{config.threads, config.queue_size, config.scheduling};
+
+    std::vector<double> times;
+    double cpu = 0.0;
+    uint64_t count = 0;
+    for (int n = 0; n < runs; ++n) {
+        const double cpu_start = cpu_seconds();
+        const auto start = std::chrono::steady_clock::now();
+        count = read_file(filename, pool, config.pool_parsing);
+        times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        cpu += cpu_seconds() - cpu_start;
+    }
+
+    const auto stats = benchmark::calculate_statistics(times);
+    const double wall = stats.mean * static_cast<double>(runs);
+    const osmium::MemoryUsage memory;
+
+    std::cout << std::setprecision(6)
+              << "{\"benchmark\":\"" << benchmark::json_escape(config.name())
+              << "\",\"input\":\"" << benchmark::json_escape(input)
+              << "\",\"warmup\":0"
+              << ",\"runs\":" << runs
+              << ",\"items\":" << count
+              << ",\"min_s\":" << stats.min
+              << ",\"median_s\":" << stats.median
+              << ",\"mean_s\":" << stats.mean
+              << ",\"stddev_s\":" << stats.stddev
+              << ",\"items_per_s\":" << (stats.median > 0.0 ? static_cast<double>(count) / stats.median : 0.0)
+              << ",\"threads\":" << pool.num_threads()
+              << ",\"cpu_s\":" << cpu / static_cast<double>(runs)
+              << ",\"cpu_per_wall\":" << (wall > 0.0 ? cpu / wall : 0.0)
+              << ",\"items_per_cpu_s\":" << (cpu > 0.0 ? static_cast<double>(count) * static_cast<double>(runs) / cpu : 0.0)
+              << ",\"peak_rss_mb\":" << memory.peak()
+              << "}\n" << std::flush;
+}
+
+static std::vector<int> parse_list(const char* str) {
+    std::vector<int> result;
+    std::istringstream in{str};
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        result.push_back(std::atoi(item.c_str()));
+    }
+    return result;
+}
+
+static void print_usage(const char* prgname) {
+    std::cerr << "Usage: " << prgname << " [OPTIONS] OSMFILE\n"
+              << "  -r, --runs=NUM        Number of runs per configuration (default: 3)\n"
+              << "  -t, --threads=LIST    Comma-separated list of pool sizes\n"
+              << "                        (default: 1, 2, 4, ... up to the number of CPUs)\n"
+              << "  -q, --queue-size=LIST Comma-separated list of queue sizes (default: 20)\n";
+}
+
+int main(int argc, char* argv[]) {
+    static struct option long_options[] = {
+        {"help",             no_argument, nullptr, 'h'},
+        {"queue-size", required_argument, nullptr, 'q'},
+        {"runs",       required_argument, nullptr, 'r'},
+        {"threads",    required_argument, nullptr, 't'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int runs = 3;
+    std::vector<int> thread_counts;
+    std::vector<int> queue_sizes{20};
+
+    while (true) {
+        const int c = getopt_long(argc, argv, "hq:r:t:", long_options, nullptr);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+            case 'h':
+                print_usage(argv[0]);
+                std::exit(0);
+            case 'q':
+                queue_sizes = parse_list(optarg);
+                break;
+            case 'r':
+                runs = std::atoi(optarg);
+                break;
+            case 't':
+                thread_counts = parse_list(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                std::exit(1);
+        }
+    }
+
+    if (optind != argc - 1 || runs < 1) {
+        print_usage(argv[0]);
+        std::exit(1);
+    }
+
+    if (thread_counts.empty()) {
+        const int max_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        for (int n = 1; n < max_threads; n *= 2) {
+            thread_counts.push_back(n);
+        }
+        thread_counts.push_back(max_threads);
+    }
+
+    const std::string filename{argv[optind]};
+    const auto slash = filename.find_last_of('/');
+    const std::string input{slash == std::string::npos ? filename : filename.substr(slash + 1)};
+
+    std::vector<configuration> configs;
+    for (const int threads : thread_counts) {
+        for (const auto scheduling : {osmium::thread::pool_scheduling::shared_queue, osmium::thread::pool_scheduling::work_stealing}) {
+            for (const bool pool_parsing : {true, false}) {
+                for (const int queue_size : queue_sizes) {
+                    configs.push_back(configuration{threads, scheduling, pool_parsing, static_cast<std::size_t>(queue_size)});
+                }
+            }
+        }
+    }
+
+    int exit_code = 0;
+    for (const auto& config : configs) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            std::cerr << "Can not fork\n";
+            std::exit(1);
+        }
+        if (pid == 0) {
+            try {
+                run_configuration(config, filename, input, runs);
+            } catch (const std::exception& e) {
+                std::cerr << config.name() << ": " << e.what() << '\n';
+                std::_Exit(1);
+            }
+            std::_Exit(0);
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            exit_code = 1;
+        }
+    }
+
+    return exit_code;
+}
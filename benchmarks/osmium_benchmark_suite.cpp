@@ -0,0 +1,310 @@
+/*
+
+  Run a suite of benchmarks for the hot paths of libosmium on one input
+  file and write the results as JSON lines (one object per benchmark) to
+  stdout. See README.md for how to compare the results of two runs.
+
+  The input file is read into memory once and converted into all formats
+  needed by the benchmarks. The temporary files are written into the
+  current directory and removed at the end.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include "benchmark_harness.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/any_input.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/relations/relations_manager.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using location_pair = std::pair<osmium::unsigned_object_id_type, osmium::Location>;
+
+// Completes all relations with way members without doing anything else,
+// used to benchmark the relations manager itself.
+class CountingManager : public osmium::relations::RelationsManager<CountingManager, false, true, false> {
+
+public:
+
+    uint64_t count = 0;
+
+    void complete_relation(const osmium::Relation& /*relation*/) noexcept {
+        ++count;
+    }
+
+}; // class CountingManager
+
+static osmium::memory::Buffer read_all(const std::string& filename) {
+    osmium::memory::Buffer all{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::io::Reader reader{filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        all.add_buffer(buffer);
+        all.commit();
+    }
+    reader.close();
+
+    return all;
+}
+
+static void write_all(const osmium::memory::Buffer& buffer, const std::string& filename) {
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(osmium::memory::Buffer{buffer.data(), buffer.committed()});
+    writer.close();
+}
+
+static uint64_t count_objects(const std::string& filename) {
+    uint64_t count = 0;
+    osmium::io::Reader reader{filename};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            (void)object;
+            ++count;
+        }
+    }
+    reader.close();
+    return count;
+}
+
+static std::string read_file_contents(const std::string& filename) {
+    const auto size = osmium::file_size(filename);
+    std::string data(size, '\0');
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    std::size_t done = 0;
+    while (done < size) {
+        const auto nread = osmium::io::detail::reliable_read(fd, &data[done], size - done);
+        if (nread == 0) {
+            break;
+        }
+        done += nread;
+    }
+    osmium::io::detail::reliable_close(fd);
+    return data;
+}
+
+template <typename TIndex>
+static void benchmark_location_index(benchmark::Harness& harness, const std::string& name, const std::vector<location_pair>& locations) {
+    harness.run_with_setup(name + "_set", []() {
+        return std::unique_ptr<TIndex>{new TIndex{}};
+    }, [&locations](std::unique_ptr<TIndex> index) {
+        for (const auto& l : locations) {
+            index->set(l.first, l.second);
+        }
+        index->sort();
+        return static_cast<uint64_t>(locations.size());
+    });
+
+    TIndex index;
+    for (const auto& l : locations) {
+        index.set(l.first, l.second);
+    }
+    index.sort();
+
+    harness.run(name + "_get", [&locations, &index]() {
+        uint64_t found = 0;
+        for (const auto& l : locations) {
+            if (index.get_noexcept(l.first).valid()) {
+                ++found;
+            }
+        }
+        return found;
+    });
+}
+
+static void print_usage(const char* prgname) {
+    std::cerr << "Usage: " << prgname << " [-w WARMUP] [-r RUNS] [-b FILTER] OSMFILE\n"
+              << "  -w, --warmup=NUM     Number of untimed runs per benchmark (default: 1)\n"
+              << "  -r, --runs=NUM       Number of timed runs per benchmark (default: 5)\n"
+              << "  -b, --benchmark=STR  Only run benchmarks with STR in their name\n";
+}
+
+int main(int argc, char* argv[]) {
+    static struct option long_options[] = {
+        {"benchmark", required_argument, nullptr, 'b'},
+        {"help",            no_argument, nullptr, 'h'},
+        {"runs",      required_argument, nullptr, 'r'},
+        {"warmup",    required_argument, nullptr, 'w'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    int warmup = 1;
+    int runs = 5;
+    std::string filter;
+
+    while (true) {
+        const int c = getopt_long(argc, argv, "b:hr:w:", long_options, nullptr);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+            case 'b':
+                filter = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                std::exit(0);
+            case 'r':
+                runs = std::atoi(optarg);
+                break;
+            case 'w':
+                warmup = std::atoi(optarg);
+                break;
+            default:
+                print_usage(argv[0]);
+                std::exit(1);
+        }
+    }
+
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        std::exit(1);
+    }
+
+    const std::string input_filename{argv[optind]};
+    const std::string tmp_prefix{"osmium_benchmark_suite_tmp."};
+    const std::vector<std::string> formats = {"pbf", "xml", "opl", "o5m"};
+
+    try {
+        const auto slash = input_filename.find_last_of('/');
+        benchmark::Harness harness{std::cout,
+                                   slash == std::string::npos ? input_filename : input_filename.substr(slash + 1),
+                                   filter,
+                                   warmup,
+                                   runs};
+
+        osmium::memory::Buffer data{read_all(input_filename)};
+
+        for (const auto& format : formats) {
+            write_all(data, tmp_prefix + format);
+        }
+
+        // Reading complete files, including decompression and decoding
+        // in the thread pool.
+        for (const auto& format : formats) {
+            const std::string filename{tmp_prefix + format};
+            harness.run("parse_" + format, [&filename]() {
+                return count_objects(filename);
+            });
+        }
+
+        // Decoding single PBF blobs without any threads involved.
+        if (harness.enabled("pbf_decode_blob")) {
+            const auto pbf = std::make_shared<std::string>(read_file_contents(tmp_prefix + "pbf"));
+            std::vector<protozero::data_view> blobs;
+            osmium::io::detail::for_each_pbf_blob(pbf->data(), pbf->size(), [&blobs](std::size_t offset, std::size_t /*size*/, const protozero::data_view& blob) {
+                if (offset != 0) {
+                    blobs.push_back(blob);
+                }
+            });
+
+            harness.run("pbf_decode_blob", [&pbf, &blobs]() {
+                for (const auto& blob : blobs) {
+                    osmium::io::detail::PBFDataBlobDecoder decoder{pbf, blob, osmium::osm_entity_bits::all, osmium::io::read_meta::yes};
+                    decoder();
+                }
+                return static_cast<uint64_t>(blobs.size());
+            });
+        }
+
+        // Setting and getting node locations in the most often used
+        // location indexes.
+        if (harness.enabled("location_index")) {
+            std::vector<location_pair> locations;
+            for (const auto& node : data.select<osmium::Node>()) {
+                if (node.id() >= 0) {
+                    locations.emplace_back(static_cast<osmium::unsigned_object_id_type>(node.id()), node.location());
+                }
+            }
+
+            benchmark_location_index<osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>>(harness, "location_index_flex_mem", locations);
+            benchmark_location_index<osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>>(harness, "location_index_sparse_mem_array", locations);
+        }
+
+        // Matching the tags of all objects against a typical filter.
+        harness.run("tag_filter", [&data]() {
+            osmium::TagsFilter filter{false};
+            filter.add_rule(true, "highway");
+            filter.add_rule(true, "building");
+            filter.add_rule(true, "amenity", "restaurant");
+            filter.add_rule(true, "landuse", "forest");
+
+            uint64_t count = 0;
+            for (const auto& object : data.select<osmium::OSMObject>()) {
+                if (osmium::tags::match_any_of(object.tags(), filter)) {
+                    ++count;
+                }
+            }
+            return count;
+        });
+
+        // The second pass of the relations manager, the first pass is done
+        // in the untimed setup.
+        harness.run_with_setup("relations_second_pass", [&data]() {
+            std::unique_ptr<CountingManager> manager{new CountingManager{}};
+            osmium::apply(data, *manager);
+            manager->prepare_for_lookup();
+            return manager;
+        }, [&data](std::unique_ptr<CountingManager> manager) {
+            osmium::apply(data, manager->handler());
+            return manager->count;
+        });
+
+        // Assembling all multipolygons, this includes the second pass.
+        using assembler_manager = osmium::area::MultipolygonManager<osmium::area::Assembler>;
+        harness.run_with_setup("area_assembly", [&data]() {
+            std::unique_ptr<assembler_manager> manager{new assembler_manager{osmium::area::Assembler::config_type{}}};
+            osmium::apply(data, *manager);
+            manager->prepare_for_lookup();
+            return manager;
+        }, [&data](std::unique_ptr<assembler_manager> manager) {
+            using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+            index_type index;
+            osmium::handler::NodeLocationsForWays<index_type> location_handler{index};
+            location_handler.ignore_errors();
+
+            uint64_t count = 0;
+            osmium::apply(data, location_handler, manager->handler([&count](osmium::memory::Buffer&& buffer) {
+                for (const auto& area : buffer.select<osmium::Area>()) {
+                    (void)area;
+                    ++count;
+                }
+            }));
+            return count;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        for (const auto& format : formats) {
+            std::remove((tmp_prefix + format).c_str());
+        }
+        std::exit(1);
+    }
+
+    for (const auto& format : formats) {
+        std::remove((tmp_prefix + format).c_str());
+    }
+}
@@ -0,0 +1,512 @@
+/*
+
+  Generate synthetic OSM data for benchmarks.
+
+  The data is generated in a streaming fashion, so files of any size can be
+  written. The same options and seed always result in the same data.
+
+  * Nodes are grouped into cells of 1000 nodes. The nodes in a cell lie on
+    a circle in id order, so ways built from consecutive nodes of a cell
+    never self-intersect.
+  * Node ids are dense (1, 2, 3, ...) or have random gaps (see -g).
+  * About 8% of the nodes are tagged, with tag frequencies roughly following
+    a Zipf distribution.
+  * Ways are built in blocks of 200 ways using nodes of the same cell. Each
+    block starts with a ring of ways that is used as the outer ring of a
+    multipolygon relation. Every few blocks there is a large multipolygon
+    with more than 100 member ways.
+  * Every fourth block also has a route relation with node and way members.
+  * With -u the objects in each output buffer are shuffled and written in
+    the order relations, ways, nodes.
+
+  The code in this file is released into the Public Domain.
+
+*/
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/any_output.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    const uint64_t nodes_per_cell = 1000;
+    const uint64_t ways_per_block = 200;
+    const std::size_t buffer_size = 10UL * 1024UL * 1024UL;
+
+    struct options_type {
+        uint64_t nodes = 1000000;
+        uint64_t ways = 0; // 0: nodes / 8
+        uint64_t id_gap = 1;
+        uint64_t seed = 1;
+        uint64_t large_every = 100;
+        bool unsorted = false;
+        bool metadata = true;
+    };
+
+    // Random number generator with the same results on all platforms
+    // (unlike the distributions in <random>).
+    class SplitMix64 {
+
+        uint64_t m_state;
+
+    public:
+
+        explicit SplitMix64(uint64_t seed) noexcept :
+            m_state(seed) {
+        }
+
+        uint64_t operator()() noexcept {
+            uint64_t z = (m_state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31U);
+        }
+
+        // Random number in [0, n).
+        uint64_t below(uint64_t n) noexcept {
+            return n == 0 ? 0 : (*this)() % n;
+        }
+
+        // Random number in [0, 1).
+        double real() noexcept {
+            return static_cast<double>((*this)() >> 11U) / static_cast<double>(1ULL << 53U);
+        }
+
+        // Zipf-like random index in [0, n): index i is about 1/(i+1) as
+        // often chosen as index 0.
+        std::size_t zipf(std::size_t n) noexcept {
+            const double h = std::log(static_cast<double>(n) + 1.0);
+            const auto i = static_cast<std::size_t>(std::exp(real() * h)) - 1;
+            return std::min(i, n - 1);
+        }
+
+    }; // class SplitMix64
+
+    using tag_pair = std::pair<const char*, const char*>;
+
+    const std::vector<tag_pair> node_tags = {
+        {"highway", "crossing"},
+        {"natural", "tree"},
+        {"highway", "traffic_signals"},
+        {"power", "pole"},
+        {"amenity", "bench"},
+        {"barrier", "gate"},
+        {"amenity", "restaurant"},
+        {"shop", "supermarket"},
+        {"amenity", "post_box"},
+        {"tourism", "hotel"}
+    };
+
+    const std::vector<tag_pair> way_tags = {
+        {"highway", "residential"},
+        {"highway", "service"},
+        {"highway", "track"},
+        {"waterway", "stream"},
+        {"highway", "footway"},
+        {"highway", "primary"},
+        {"railway", "rail"},
+        {"power", "line"},
+        {"barrier", "fence"},
+        {"highway", "motorway"}
+    };
+
+    const std::vector<tag_pair> area_tags = {
+        {"landuse", "residential"},
+        {"natural", "water"},
+        {"landuse", "forest"},
+        {"leisure", "park"},
+        {"landuse", "farmland"},
+        {"natural", "wood"}
+    };
+
+    class Generator {
+
+        options_type m_options;
+        SplitMix64 m_random;
+        osmium::io::Writer& m_writer;
+        osmium::memory::Buffer m_buffer{buffer_size, osmium::memory::Buffer::auto_grow::yes};
+        uint64_t m_num_cells;
+        uint64_t m_num_blocks;
+        uint64_t m_num_ways_written = 0;
+
+        // Strings referenced from the objects while they are built.
+        std::string m_user;
+        std::string m_name;
+        std::vector<tag_pair> m_tags;
+        std::vector<osmium::object_id_type> m_refs;
+        std::vector<member_type> m_members;
+
+        osmium::object_id_type node_id(uint64_t n) const noexcept {
+            if (m_options.id_gap <= 1) {
+                return static_cast<osmium::object_id_type>(n + 1);
+            }
+            // The gap is derived from the node number only, so that ways
+            // can compute the id of any node.
+            SplitMix64 hash{m_options.seed ^ (n * 0x2545f4914f6cdd1dULL)};
+            return static_cast<osmium::object_id_type>(1 + n * m_options.id_gap + hash.below(m_options.id_gap));
+        }
+
+        static osmium::Location node_location(uint64_t n) noexcept {
+            const uint64_t cell = n / nodes_per_cell;
+            const double center_lon = -179.9 + static_cast<double>(cell % 3500) * 0.1;
+            const double center_lat = -79.9 + static_cast<double>((cell / 3500) % 1600) * 0.1;
+            const double angle = 2.0 * 3.141592653589793 * static_cast<double>(n % nodes_per_cell) / static_cast<double>(nodes_per_cell);
+            return osmium::Location{center_lon + 0.04 * std::cos(angle), center_lat + 0.04 * std::sin(angle)};
+        }
+
+        // Returns number of the first node of the cell used by a block.
+        uint64_t cell_start(uint64_t block) const noexcept {
+            return (block % m_num_cells) * nodes_per_cell;
+        }
+
+        // Number of ways in the multipolygon ring of the block.
+        uint64_t ring_size(uint64_t block) const noexcept {
+            if (m_options.large_every > 0 && block % m_options.large_every == m_options.large_every - 1) {
+                return 150;
+            }
+            return 2 + block % 4;
+        }
+
+        osmium::Timestamp timestamp() noexcept {
+            return osmium::Timestamp{static_cast<uint32_t>(1200000000 + m_random.below(500000000))};
+        }
+
+        void set_user() {
+            m_user = "user_" + std::to_string(m_random.below(1000));
+        }
+
+        void flush_if_full() {
+            if (m_buffer.committed() > buffer_size - 64 * 1024) {
+                flush();
+            }
+        }
+
+        void write_node(uint64_t n) {
+            m_tags.clear();
+            if (m_random.below(100) < 8) {
+                m_tags.push_back(node_tags[m_random.zipf(node_tags.size())]);
+                if (m_random.below(8) == 0) {
+                    m_tags.emplace_back("source", "survey");
+                }
+                if (m_random.below(4) == 0) {
+                    m_name = "Name " + std::to_string(m_random.below(100000));
+                    m_tags.emplace_back("name", m_name.c_str());
+                }
+            }
+
+            if (m_options.metadata) {
+                set_user();
+                osmium::builder::add_node(m_buffer,
+                    _id(node_id(n)),
+                    _version(1 + m_random.zipf(8)),
+                    _cid(1 + m_random.below(60000000)),
+                    _timestamp(timestamp()),
+                    _uid(m_random.below(1000)),
+                    _user(m_user),
+                    _location(node_location(n)),
+                    _tags(m_tags));
+            } else {
+                osmium::builder::add_node(m_buffer,
+                    _id(node_id(n)),
+                    _location(node_location(n)),
+                    _tags(m_tags));
+            }
+            flush_if_full();
+        }
+
+        void add_way() {
+            const auto id = static_cast<osmium::object_id_type>(m_num_ways_written + 1);
+            if (m_options.metadata) {
+                set_user();
+                osmium::builder::add_way(m_buffer,
+                    _id(id),
+                    _version(1 + m_random.zipf(8)),
+                    _cid(1 + m_random.below(60000000)),
+                    _timestamp(timestamp()),
+                    _uid(m_random.below(1000)),
+                    _user(m_user),
+                    _nodes(m_refs),
+                    _tags(m_tags));
+            } else {
+                osmium::builder::add_way(m_buffer,
+                    _id(id),
+                    _nodes(m_refs),
+                    _tags(m_tags));
+            }
+            ++m_num_ways_written;
+            flush_if_full();
+        }
+
+        void write_block_ways(uint64_t block, uint64_t count) {
+            const uint64_t start = cell_start(block);
+            const uint64_t ring = std::min(ring_size(block), count);
+            const uint64_t nodes_per_ring_way = (nodes_per_cell - 1) / (ring + 1);
+
+            // Ways of the multipolygon ring: consecutive arcs of the circle,
+            // the last way closes the ring.
+            for (uint64_t w = 0; w < ring; ++w) {
+                m_refs.clear();
+                m_tags.clear();
+                for (uint64_t i = 0; i <= nodes_per_ring_way; ++i) {
+                    m_refs.push_back(node_id(start + w * nodes_per_ring_way + i));
+                }
+                if (w == ring - 1) {
+                    m_refs.push_back(node_id(start));
+                }
+                add_way();
+            }
+
+            // Other ways: mostly short open ways, some closed areas.
+            for (uint64_t w = ring; w < count; ++w) {
+                m_refs.clear();
+                m_tags.clear();
+                const uint64_t length = 2 + m_random.zipf(40);
+                const uint64_t first = start + m_random.below(nodes_per_cell - length);
+                for (uint64_t i = 0; i < length; ++i) {
+                    m_refs.push_back(node_id(first + i));
+                }
+                if (length > 2 && m_random.below(4) == 0) {
+                    m_refs.push_back(m_refs.front());
+                    m_tags.push_back(m_random.below(2) ? tag_pair{"building", "yes"} : area_tags[m_random.zipf(area_tags.size())]);
+                } else {
+                    m_tags.push_back(way_tags[m_random.zipf(way_tags.size())]);
+                    if (m_random.below(3) == 0) {
+                        m_name = "Street " + std::to_string(m_random.below(100000));
+                        m_tags.emplace_back("name", m_name.c_str());
+                    }
+                }
+                add_way();
+            }
+        }
+
+        void add_relation(osmium::object_id_type id) {
+            if (m_options.metadata) {
+                set_user();
+                osmium::builder::add_relation(m_buffer,
+                    _id(id),
+                    _version(1 + m_random.zipf(8)),
+                    _cid(1 + m_random.below(60000000)),
+                    _timestamp(timestamp()),
+                    _uid(m_random.below(1000)),
+                    _user(m_user),
+                    _members(m_members),
+                    _tags(m_tags));
+            } else {
+                osmium::builder::add_relation(m_buffer,
+                    _id(id),
+                    _members(m_members),
+                    _tags(m_tags));
+            }
+            flush_if_full();
+        }
+
+        void write_relations() {
+            osmium::object_id_type id = 1;
+            for (uint64_t block = 0; block < m_num_blocks; ++block) {
+                const uint64_t first_way = block * ways_per_block + 1;
+                const uint64_t ways_in_block = std::min(ways_per_block, m_options.ways - block * ways_per_block);
+                const uint64_t ring = std::min(ring_size(block), ways_in_block);
+
+                m_members.clear();
+                m_tags.clear();
+                for (uint64_t w = 0; w < ring; ++w) {
+                    m_members.emplace_back(osmium::item_type::way, static_cast<osmium::object_id_type>(first_way + w), "outer");
+                }
+                m_tags.emplace_back("type", "multipolygon");
+                m_tags.push_back(area_tags[m_random.zipf(area_tags.size())]);
+                add_relation(id++);
+
+                if (block % 4 == 0 && ways_in_block > ring) {
+                    m_members.clear();
+                    m_tags.clear();
+                    const uint64_t start = cell_start(block);
+                    m_members.emplace_back(osmium::item_type::node, node_id(start + m_random.below(nodes_per_cell)), "stop");
+                    m_members.emplace_back(osmium::item_type::node, node_id(start + m_random.below(nodes_per_cell)), "stop");
+                    for (uint64_t w = ring; w < std::min(ways_in_block, ring + 5); ++w) {
+                        m_members.emplace_back(osmium::item_type::way, static_cast<osmium::object_id_type>(first_way + w), "");
+                    }
+                    m_tags.emplace_back("type", "route");
+                    m_tags.emplace_back("route", "bus");
+                    add_relation(id++);
+                }
+            }
+        }
+
+        void write_ways() {
+            for (uint64_t block = 0; block < m_num_blocks; ++block) {
+                write_block_ways(block, std::min(ways_per_block, m_options.ways - block * ways_per_block));
+            }
+        }
+
+        void write_nodes() {
+            for (uint64_t n = 0; n < m_options.nodes; ++n) {
+                write_node(n);
+            }
+        }
+
+        void shuffle_buffer() {
+            std::vector<osmium::memory::Item*> items;
+            for (auto& item : m_buffer) {
+                items.push_back(&item);
+            }
+            for (std::size_t i = items.size(); i > 1; --i) {
+                std::swap(items[i - 1], items[m_random.below(i)]);
+            }
+
+            osmium::memory::Buffer shuffled{m_buffer.committed() + 1024, osmium::memory::Buffer::auto_grow::yes};
+            for (const auto* item : items) {
+                shuffled.push_back(*item);
+                shuffled.commit();
+            }
+            m_buffer = std::move(shuffled);
+        }
+
+    public:
+
+        Generator(const options_type& options, osmium::io::Writer& writer) :
+            m_options(options),
+            m_random(options.seed),
+            m_writer(writer),
+            m_num_cells(options.nodes / nodes_per_cell) {
+            if (m_options.ways == 0) {
+                m_options.ways = m_options.nodes / 8;
+            }
+            // Ways need at least one complete cell of nodes.
+            if (m_num_cells == 0) {
+                m_options.ways = 0;
+            }
+            m_num_blocks = (m_options.ways + ways_per_block - 1) / ways_per_block;
+        }
+
+        void flush() {
+            if (m_options.unsorted) {
+                shuffle_buffer();
+            }
+            m_writer(std::move(m_buffer));
+            m_buffer = osmium::memory::Buffer{buffer_size, osmium::memory::Buffer::auto_grow::yes};
+        }
+
+        void run() {
+            if (m_options.unsorted) {
+                write_relations();
+                flush();
+                write_ways();
+                flush();
+                write_nodes();
+            } else {
+                write_nodes();
+                flush();
+                write_ways();
+                flush();
+                write_relations();
+            }
+            flush();
+        }
+
+    }; // class Generator
+
+} // anonymous namespace
+
+static void print_usage(const char* prgname) {
+    std::cerr << "Usage: " << prgname << " [OPTIONS] OUTFILE\n"
+              << "  -n, --nodes=NUM      Number of nodes (default: 1000000)\n"
+              << "  -w, --ways=NUM       Number of ways (default: nodes / 8)\n"
+              << "  -g, --id-gap=NUM     Average gap between node ids (default: 1, dense ids)\n"
+              << "  -l, --large=NUM      Every NUM-th multipolygon is large (default: 100, 0: never)\n"
+              << "  -s, --seed=NUM       Seed for the random number generator (default: 1)\n"
+              << "  -u, --unsorted       Write objects in unsorted order\n"
+              << "  -M, --no-metadata    Do not add metadata to the objects\n"
+              << "The format of the output file is taken from its suffix.\n";
+}
+
+int main(int argc, char* argv[]) {
+    static struct option long_options[] = {
+        {"help",              no_argument, nullptr, 'h'},
+        {"id-gap",      required_argument, nullptr, 'g'},
+        {"large",       required_argument, nullptr, 'l'},
+        {"no-metadata",       no_argument, nullptr, 'M'},
+        {"nodes",       required_argument, nullptr, 'n'},
+        {"seed",        required_argument, nullptr, 's'},
+        {"unsorted",          no_argument, nullptr, 'u'},
+        {"ways",        required_argument, nullptr, 'w'},
+        {nullptr, 0, nullptr, 0}
+    };
+
+    options_type options;
+
+    while (true) {
+        const int c = getopt_long(argc, argv, "g:hl:Mn:s:uw:", long_options, nullptr);
+        if (c == -1) {
+            break;
+        }
+
+        switch (c) {
+            case 'g':
+                options.id_gap = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                std::exit(0);
+            case 'l':
+                options.large_every = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'M':
+                options.metadata = false;
+                break;
+            case 'n':
+                options.nodes = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 's':
+                options.seed = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'u':
+                options.unsorted = true;
+                break;
+            case 'w':
+                options.ways = std::strtoull(optarg, nullptr, 10);
+                break;
+            default:
+                print_usage(argv[0]);
+                std::exit(1);
+        }
+    }
+
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        std::exit(1);
+    }
+
+    try {
+        osmium::io::Header header;
+        header.set("generator", "osmium_generate_data");
+        header.add_box(osmium::Box{-180.0, -80.0, 180.0, 80.0});
+
+        osmium::io::Writer writer{argv[optind], header, osmium::io::overwrite::allow};
+        Generator generator{options, writer};
+        generator.run();
+        writer.close();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        std::exit(1);
+    }
+}
@@ -0,0 +1,21 @@
+#!/bin/sh
+#
+#  run_benchmark_area.sh
+#
+#  Assembles generated pathological multipolygons and all multipolygons in
+#  the data files. Writes the results as JSON lines to stdout.
+#
+#  Set OB_AREA_OPTIONS to pass options to the benchmark, for instance
+#  OB_AREA_OPTIONS="-r 10 -b touching".
+#
+
+set -e
+
+BENCHMARK_NAME=area
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh >&2
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+$CMD $OB_AREA_OPTIONS $OB_DATA_FILES
+
@@ -0,0 +1,24 @@
+#!/bin/sh
+#
+#  run_benchmark_scaling.sh
+#
+#  Reads each data file with different thread pool sizes, pool scheduling
+#  strategies, with and without decoding in the pool, and with different
+#  queue sizes. Writes the results as JSON lines to stdout.
+#
+#  Set OB_SCALING_OPTIONS to pass options to the benchmark, for instance
+#  OB_SCALING_OPTIONS="-t 1,2,4,8 -q 10,20,40".
+#
+
+set -e
+
+BENCHMARK_NAME=scaling
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh >&2
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+for data in $OB_DATA_FILES; do
+    $CMD $OB_SCALING_OPTIONS $data
+done
+
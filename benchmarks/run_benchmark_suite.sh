@@ -0,0 +1,24 @@
+#!/bin/sh
+#
+#  run_benchmark_suite.sh
+#
+#  Runs the benchmark suite on all data files and writes the results as
+#  JSON lines to stdout. Everything else goes to stderr, so the output can
+#  be redirected into a file and compared with compare_benchmarks.sh.
+#
+#  Set OB_SUITE_OPTIONS to pass options to the suite, for instance
+#  OB_SUITE_OPTIONS="-r 10 -b parse".
+#
+
+set -e
+
+BENCHMARK_NAME=suite
+
+. @CMAKE_BINARY_DIR@/benchmarks/setup.sh >&2
+
+CMD=$OB_DIR/osmium_benchmark_$BENCHMARK_NAME
+
+for data in $OB_DATA_FILES; do
+    $CMD $OB_SUITE_OPTIONS $data
+done
+
@@ -34,6 +34,11 @@
 #      gdal       - include if you want to use any of the OGR functions
 #      proj       - include if you want to use any of the Proj.4 functions
 #      sparsehash - include if you use the sparsehash index
+#      lz4        - include to read and write lz4 compressed PBF blobs
+#      zstd       - include to read and write zstd compressed PBF blobs
+#      libdeflate - include to use libdeflate instead of zlib for PBF blobs
+#      isal       - include to use ISA-L instead of zlib for reading gzip files
+#      re2        - include to use RE2 instead of std::regex for osmium::Regex
 #
 #    You can check for success with something like this:
 #
@@ -131,6 +136,92 @@ if(Osmium_USE_PBF)
     endif()
 endif()
 
+#----------------------------------------------------------------------
+# Component 'lz4'
+if(Osmium_USE_LZ4)
+    find_path(LZ4_INCLUDE_DIR lz4.h)
+    find_library(LZ4_LIBRARY NAMES lz4)
+
+    list(APPEND OSMIUM_EXTRA_FIND_VARS LZ4_INCLUDE_DIR LZ4_LIBRARY)
+    if(LZ4_INCLUDE_DIR AND LZ4_LIBRARY)
+        set(LZ4_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_LZ4)
+        list(APPEND OSMIUM_PBF_LIBRARIES ${LZ4_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${LZ4_INCLUDE_DIR})
+    else()
+        message(WARNING "Osmium: lz4 library is required but not found, please install it or configure the paths.")
+    endif()
+endif()
+
+#----------------------------------------------------------------------
+# Component 'zstd'
+if(Osmium_USE_ZSTD)
+    find_path(ZSTD_INCLUDE_DIR zstd.h)
+    find_library(ZSTD_LIBRARY NAMES zstd)
+
+    list(APPEND OSMIUM_EXTRA_FIND_VARS ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
+    if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+        set(ZSTD_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_ZSTD)
+        list(APPEND OSMIUM_PBF_LIBRARIES ${ZSTD_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+    else()
+        message(WARNING "Osmium: zstd library is required but not found, please install it or configure the paths.")
+    endif()
+endif()
+
+#----------------------------------------------------------------------
+# Component 'libdeflate'
+if(Osmium_USE_LIBDEFLATE)
+    find_path(LIBDEFLATE_INCLUDE_DIR libdeflate.h)
+    find_library(LIBDEFLATE_LIBRARY NAMES deflate)
+
+    list(APPEND OSMIUM_EXTRA_FIND_VARS LIBDEFLATE_INCLUDE_DIR LIBDEFLATE_LIBRARY)
+    if(LIBDEFLATE_INCLUDE_DIR AND LIBDEFLATE_LIBRARY)
+        set(LIBDEFLATE_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_LIBDEFLATE)
+        list(APPEND OSMIUM_PBF_LIBRARIES ${LIBDEFLATE_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${LIBDEFLATE_INCLUDE_DIR})
+    else()
+        message(WARNING "Osmium: libdeflate library is required but not found, please install it or configure the paths.")
+    endif()
+endif()
+
+#----------------------------------------------------------------------
+# Component 'isal'
+if(Osmium_USE_ISAL)
+    find_path(ISAL_INCLUDE_DIR isa-l/igzip_lib.h)
+    find_library(ISAL_LIBRARY NAMES isal)
+
+    list(APPEND OSMIUM_EXTRA_FIND_VARS ISAL_INCLUDE_DIR ISAL_LIBRARY)
+    if(ISAL_INCLUDE_DIR AND ISAL_LIBRARY)
+        set(ISAL_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_ISAL)
+        list(APPEND OSMIUM_PBF_LIBRARIES ${ISAL_LIBRARY})
+        list(APPEND OSMIUM_XML_LIBRARIES ${ISAL_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${ISAL_INCLUDE_DIR})
+    else()
+        message(WARNING "Osmium: ISA-L library is required but not found, please install it or configure the paths.")
+    endif()
+endif()
+
+#----------------------------------------------------------------------
+# Component 're2'
+if(Osmium_USE_RE2)
+    find_path(RE2_INCLUDE_DIR re2/re2.h)
+    find_library(RE2_LIBRARY NAMES re2)
+
+    list(APPEND OSMIUM_EXTRA_FIND_VARS RE2_INCLUDE_DIR RE2_LIBRARY)
+    if(RE2_INCLUDE_DIR AND RE2_LIBRARY)
+        set(RE2_FOUND 1)
+        add_definitions(-DOSMIUM_WITH_RE2)
+        list(APPEND OSMIUM_LIBRARIES ${RE2_LIBRARY})
+        list(APPEND OSMIUM_INCLUDE_DIRS ${RE2_INCLUDE_DIR})
+    else()
+        message(WARNING "Osmium: RE2 library is required but not found, please install it or configure the paths.")
+    endif()
+endif()
+
 #----------------------------------------------------------------------
 # Component 'xml'
 if(Osmium_USE_XML)
@@ -0,0 +1,357 @@
+#ifndef OSMIUM_AREA_AREA_DEPENDENCIES_HPP
+#define OSMIUM_AREA_AREA_DEPENDENCIES_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * The ways and relations whose areas are affected by changes as
+         * returned from AreaDependencies::update().
+         */
+        struct affected_areas {
+
+            /// Ids of the ways whose areas have to be reassembled (sorted).
+            std::vector<osmium::object_id_type> ways;
+
+            /// Ids of the relations whose areas have to be reassembled (sorted).
+            std::vector<osmium::object_id_type> relations;
+
+            /**
+             * Ids of unchanged ways which became members of a relation and
+             * are not tracked yet (sorted). Their nodes are not known, so
+             * they have to be added with AreaDependencies::way() followed
+             * by AreaDependencies::sort().
+             */
+            std::vector<osmium::object_id_type> untracked_ways;
+
+        }; // struct affected_areas
+
+        /**
+         * Keeps track of the nodes and ways the areas depend on, so that
+         * after applying a change file only the areas affected by the
+         * changes have to be reassembled instead of all of them.
+         *
+         * Four multimap indexes are used: from nodes to the ways they are
+         * in and from ways to the multipolygon (or boundary) relations
+         * they are members of, plus the reverse of both which is needed
+         * to remove outdated entries when a way or relation changes. Use
+         * osmium::index::multimap::SparseFileArray for indexes that are
+         * persisted on disk between updates, or SparseMemArray for keeping
+         * them in memory. The indexes are not owned by this class.
+         *
+         * Build the indexes in two passes through the data, first all
+         * relations, then all ways:
+         *
+         * @code
+         * using index_type = osmium::index::multimap::SparseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+         * index_type node_to_way, way_to_node, way_to_relation, relation_to_way;
+         * osmium::area::AreaDependencies<index_type> deps{node_to_way, way_to_node, way_to_relation, relation_to_way};
+         * osmium::io::Reader reader1{file, osmium::osm_entity_bits::relation};
+         * osmium::apply(reader1, deps);
+         * reader1.close();
+         * deps.sort();
+         * osmium::io::Reader reader2{file, osmium::osm_entity_bits::way};
+         * osmium::apply(reader2, deps);
+         * reader2.close();
+         * deps.sort();
+         * @endcode
+         *
+         * For each change file call update() with the changes and
+         * reassemble the areas it returns, using the node locations from
+         * a location cache (see osmium::index::LocationCache) which is
+         * updated with the same changes. Areas of ways and relations
+         * which were deleted or are not valid any more have to be removed.
+         *
+         * Closed ways and the way members of multipolygon and boundary
+         * relations are tracked. Tags are not checked, so this can return
+         * more areas than the assembler creates, but never less.
+         *
+         * @tparam TIndex Multimap index type from unsigned object ids to
+         *                unsigned object ids which supports get_all(),
+         *                remove(), sort() and erase_removed().
+         */
+        template <typename TIndex>
+        class AreaDependencies : public osmium::handler::Handler {
+
+            static_assert(std::is_same<typename TIndex::key_type, osmium::unsigned_object_id_type>::value, "TIndex must have osmium::unsigned_object_id_type keys");
+
+            using id_type = osmium::unsigned_object_id_type;
+
+            TIndex& m_node_to_way;
+            TIndex& m_way_to_node;
+            TIndex& m_way_to_relation;
+            TIndex& m_relation_to_way;
+
+            static bool is_removed(const id_type value) noexcept {
+                return value == osmium::index::empty_value<id_type>();
+            }
+
+            // Call func with all (not removed) values for the id.
+            template <typename TFunc>
+            static void for_each_value(TIndex& index, const id_type id, TFunc&& func) {
+                const auto range = index.get_all(id);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (!is_removed(it->second)) {
+                        std::forward<TFunc>(func)(it->second);
+                    }
+                }
+            }
+
+            // Remove all entries for the id from the reverse index and
+            // the matching entries from the forward index.
+            static void remove_entries(TIndex& forward, TIndex& reverse, const id_type id) {
+                const auto range = reverse.get_all(id);
+                for (auto it = range.first; it != range.second; ++it) {
+                    if (!is_removed(it->second)) {
+                        forward.remove(it->second, id);
+                        it->second = osmium::index::empty_value<id_type>();
+                    }
+                }
+            }
+
+            static bool has_values(TIndex& index, const id_type id) {
+                const auto range = index.get_all(id);
+                return std::any_of(range.first, range.second, [](const typename TIndex::element_type& element) {
+                    return !is_removed(element.second);
+                });
+            }
+
+            bool is_tracked_way(const osmium::Way& way) {
+                return (way.nodes().size() >= 4 && way.is_closed()) ||
+                       has_values(m_way_to_relation, way.positive_id());
+            }
+
+            // Return the latest version of each object with the given
+            // type in the changes.
+            template <typename TObject>
+            static std::vector<const TObject*> latest_versions(const osmium::memory::Buffer& changes) {
+                std::vector<const TObject*> objects;
+                for (const auto& object : changes.select<TObject>()) {
+                    objects.push_back(&object);
+                }
+                std::stable_sort(objects.begin(), objects.end(), [](const TObject* lhs, const TObject* rhs) {
+                    return lhs->positive_id() < rhs->positive_id();
+                });
+                const auto last = std::unique(objects.rbegin(), objects.rend(), [](const TObject* lhs, const TObject* rhs) {
+                    return lhs->positive_id() == rhs->positive_id();
+                });
+                objects.erase(objects.begin(), last.base());
+                return objects;
+            }
+
+            template <typename T>
+            static void sort_unique(std::vector<T>& ids) {
+                std::sort(ids.begin(), ids.end());
+                ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            }
+
+        public:
+
+            AreaDependencies(TIndex& node_to_way, TIndex& way_to_node, TIndex& way_to_relation, TIndex& relation_to_way) :
+                m_node_to_way(node_to_way),
+                m_way_to_node(way_to_node),
+                m_way_to_relation(way_to_relation),
+                m_relation_to_way(relation_to_way) {
+            }
+
+            /**
+             * Is this relation tracked? These are multipolygon and boundary
+             * relations with at least one way member.
+             */
+            static bool is_tracked_relation(const osmium::Relation& relation) {
+                const char* type = relation.tags().get_value_by_key("type");
+                if (type == nullptr || (std::strcmp(type, "multipolygon") && std::strcmp(type, "boundary"))) {
+                    return false;
+                }
+                return std::any_of(relation.members().cbegin(), relation.members().cend(), [](const osmium::RelationMember& member) {
+                    return member.type() == osmium::item_type::way;
+                });
+            }
+
+            /**
+             * Add the way members of the relation to the indexes if this
+             * relation is tracked. Call sort() before using the indexes.
+             */
+            void relation(const osmium::Relation& relation) {
+                if (!is_tracked_relation(relation)) {
+                    return;
+                }
+                std::vector<id_type> way_ids;
+                for (const auto& member : relation.members()) {
+                    if (member.type() == osmium::item_type::way) {
+                        way_ids.push_back(member.positive_ref());
+                    }
+                }
+                sort_unique(way_ids);
+                for (const auto way_id : way_ids) {
+                    m_way_to_relation.set(way_id, relation.positive_id());
+                    m_relation_to_way.set(relation.positive_id(), way_id);
+                }
+            }
+
+            /**
+             * Add the nodes of the way to the indexes if the way is closed
+             * or a member of a tracked relation. The relations must have
+             * been added and the indexes sorted before. Call sort() before
+             * using the indexes.
+             */
+            void way(const osmium::Way& way) {
+                if (!is_tracked_way(way)) {
+                    return;
+                }
+                std::vector<id_type> node_ids;
+                for (const auto& node_ref : way.nodes()) {
+                    node_ids.push_back(node_ref.positive_ref());
+                }
+                sort_unique(node_ids);
+                for (const auto node_id : node_ids) {
+                    m_node_to_way.set(node_id, way.positive_id());
+                    m_way_to_node.set(way.positive_id(), node_id);
+                }
+            }
+
+            /**
+             * Sort the indexes and remove entries marked as removed. Call
+             * this after adding ways or relations.
+             */
+            void sort() {
+                for (auto* index : {&m_node_to_way, &m_way_to_node, &m_way_to_relation, &m_relation_to_way}) {
+                    index->sort();
+                    index->erase_removed();
+                }
+            }
+
+            /**
+             * Find the areas affected by the changes and update the indexes
+             * with them. The areas of changed (or deleted) ways and
+             * relations, of ways with changed nodes and of relations with
+             * affected member ways are returned. Changed ways are always
+             * returned, because they might have become areas.
+             *
+             * @param changes Buffer with the contents of a change file.
+             *                If it contains several versions of an object
+             *                the last one is used for the update.
+             */
+            affected_areas update(const osmium::memory::Buffer& changes) {
+                affected_areas result;
+
+                // Find the affected areas with the indexes before the changes.
+                for (const auto& node : changes.select<osmium::Node>()) {
+                    for_each_value(m_node_to_way, node.positive_id(), [&result](const id_type way_id) {
+                        result.ways.push_back(static_cast<osmium::object_id_type>(way_id));
+                    });
+                }
+                for (const auto& way : changes.select<osmium::Way>()) {
+                    result.ways.push_back(static_cast<osmium::object_id_type>(way.positive_id()));
+                }
+                sort_unique(result.ways);
+
+                for (const auto way_id : result.ways) {
+                    for_each_value(m_way_to_relation, static_cast<id_type>(way_id), [&result](const id_type relation_id) {
+                        result.relations.push_back(static_cast<osmium::object_id_type>(relation_id));
+                    });
+                }
+                for (const auto& relation : changes.select<osmium::Relation>()) {
+                    result.relations.push_back(static_cast<osmium::object_id_type>(relation.positive_id()));
+                }
+                sort_unique(result.relations);
+
+                // Update the indexes. Relations first, because the way
+                // membership decides which ways are tracked.
+                const auto relations = latest_versions<osmium::Relation>(changes);
+                for (const auto* relation : relations) {
+                    remove_entries(m_way_to_relation, m_relation_to_way, relation->positive_id());
+                }
+                for (const auto* relation : relations) {
+                    if (relation->visible()) {
+                        this->relation(*relation);
+                    }
+                }
+                m_way_to_relation.sort();
+                m_way_to_relation.erase_removed();
+                m_relation_to_way.sort();
+                m_relation_to_way.erase_removed();
+
+                const auto ways = latest_versions<osmium::Way>(changes);
+                for (const auto* way : ways) {
+                    remove_entries(m_node_to_way, m_way_to_node, way->positive_id());
+                }
+                for (const auto* way : ways) {
+                    if (way->visible()) {
+                        this->way(*way);
+                    }
+                }
+                sort();
+
+                for (const auto* relation : relations) {
+                    if (!relation->visible() || !is_tracked_relation(*relation)) {
+                        continue;
+                    }
+                    for (const auto& member : relation->members()) {
+                        if (member.type() == osmium::item_type::way &&
+                            !has_values(m_way_to_node, member.positive_ref()) &&
+                            !std::binary_search(result.ways.cbegin(), result.ways.cend(), static_cast<osmium::object_id_type>(member.positive_ref()))) {
+                            result.untracked_ways.push_back(static_cast<osmium::object_id_type>(member.positive_ref()));
+                        }
+                    }
+                }
+                sort_unique(result.untracked_ways);
+
+                return result;
+            }
+
+        }; // class AreaDependencies
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_AREA_DEPENDENCIES_HPP
@@ -47,6 +47,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/way.hpp>
 
 #include <cassert>
+#include <cstddef>
 #include <iostream>
 #include <vector>
 
@@ -57,6 +58,11 @@ namespace osmium {
         /**
          * Assembles area objects from closed ways or multipolygon relations
          * and their members.
+         *
+         * The same assembler can be used for many objects one after the
+         * other. It keeps the memory it allocated, so assembling many
+         * simple areas doesn't need any new allocations. The stats()
+         * always refer to the last object assembled.
          */
         class Assembler : public detail::BasicAssemblerWithTags {
 
@@ -79,6 +85,35 @@ namespace osmium {
                 return area_okay || config().create_empty_areas;
             }
 
+            bool create_simple_area(osmium::memory::Buffer& out_buffer, const osmium::Way& way) {
+                std::size_t start = 0;
+                bool ccw = true;
+                if (!check_simple_way(way, start, ccw)) {
+                    return false;
+                }
+
+                if (debug()) {
+                    std::cerr << "  Way is a simple ring -> creating area directly\n";
+                }
+
+                {
+                    osmium::builder::AreaBuilder builder{out_buffer};
+                    builder.initialize_from_object(way);
+                    builder.add_item(way.tags());
+                    add_simple_ring_to_area(builder, way.nodes(), start, ccw);
+                }
+
+                stats().nodes += way.nodes().size() - 1;
+                ++stats().area_simple_case;
+                stats().outer_rings = 1;
+
+                if (report_ways()) {
+                    config().problem_reporter->report_way(way);
+                }
+
+                return true;
+            }
+
             bool create_area(osmium::memory::Buffer& out_buffer, const osmium::Relation& relation, const std::vector<const osmium::Way*>& members) {
                 set_num_members(members.size());
                 osmium::builder::AreaBuilder builder{out_buffer};
@@ -119,6 +154,8 @@ namespace osmium {
              *          area, true otherwise.
              */
             bool operator()(const osmium::Way& way, osmium::memory::Buffer& out_buffer) {
+                reset();
+
                 if (!config().create_way_polygons) {
                     return true;
                 }
@@ -142,6 +179,14 @@ namespace osmium {
                 }
 
                 ++stats().from_ways;
+
+                // Most closed ways are simple rings which don't need the
+                // full assembly.
+                if (create_simple_area(out_buffer, way)) {
+                    out_buffer.commit();
+                    return true;
+                }
+
                 stats().invalid_locations = segment_list().extract_segments_from_way(config().problem_reporter,
                                                                                      stats().duplicate_nodes,
                                                                                      way);
@@ -177,6 +222,8 @@ namespace osmium {
              *          area(s), true otherwise.
              */
             bool operator()(const osmium::Relation& relation, const std::vector<const osmium::Way*>& members, osmium::memory::Buffer& out_buffer) {
+                reset();
+
                 if (!config().create_new_style_polygons) {
                     return true;
                 }
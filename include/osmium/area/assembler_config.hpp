@@ -124,6 +124,18 @@ namespace osmium {
              */
             bool ignore_invalid_locations = false;
 
+            /**
+             * Closed ways with only a few nodes are normally checked for
+             * self-intersections with a quick test and then written to the
+             * area directly, all other ways go through the full assembly.
+             * If this is set, the intersection test is skipped and all
+             * closed ways whose consecutive nodes have different, valid
+             * locations are written directly. Only set this if you know
+             * that the ways in your input are valid polygons, otherwise
+             * you will get invalid areas.
+             */
+            bool assume_valid_ways = false;
+
             AssemblerConfig() noexcept = default;
 
             /**
@@ -36,10 +36,13 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/area/assembler_config.hpp>
 #include <osmium/area/detail/node_ref_segment.hpp>
 #include <osmium/area/detail/proto_ring.hpp>
+#include <osmium/area/detail/segment_index.hpp>
 #include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/detail/vector.hpp>
 #include <osmium/area/problem_reporter.hpp>
 #include <osmium/area/stats.hpp>
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/types.hpp>
@@ -49,6 +52,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
@@ -132,13 +136,6 @@ namespace osmium {
                         return reverse ? segment.second() : segment.first();
                     }
 
-                    osmium::Location location(const SegmentList& segment_list, const osmium::Location& default_location) const noexcept {
-                        if (item == invalid_item) {
-                            return default_location;
-                        }
-                        return location(segment_list);
-                    }
-
                 }; // struct slocation
 
                 // Configuration settings for this Assembler
@@ -147,12 +144,28 @@ namespace osmium {
                 // List of segments (connection between two nodes)
                 SegmentList m_segment_list;
 
+                // Index of the segments by x coordinate, only built for
+                // areas with many rings
+                SegmentIndex m_segment_index;
+
                 // The rings we are building from the segments
                 std::list<ProtoRing> m_rings;
 
+                // Rings no longer in use. They are kept to be reused by
+                // add_ring() without allocating memory.
+                std::list<ProtoRing> m_free_rings;
+
                 // All node locations
                 std::vector<slocation> m_locations;
 
+                // Packed keys (see location_key()) of the locations in
+                // m_locations at the same positions, used for fast scans
+                // and lookups
+                std::vector<uint64_t> m_location_keys;
+
+                // Temporary list used for sorting the locations
+                std::vector<std::pair<uint64_t, slocation>> m_location_entries;
+
                 // All locations where more than two segments start/end
                 std::vector<Location> m_split_locations;
 
@@ -220,10 +233,17 @@ namespace osmium {
 
                 }
 
+                // Return the range of positions in m_locations with the
+                // specified location.
+                std::pair<std::size_t, std::size_t> find_locations(const osmium::Location& location) const {
+                    const auto range = std::equal_range(m_location_keys.cbegin(), m_location_keys.cend(), location_key(location));
+                    return {static_cast<std::size_t>(range.first - m_location_keys.cbegin()),
+                            static_cast<std::size_t>(range.second - m_location_keys.cbegin())};
+                }
+
                 NodeRefSegment* get_next_segment(const osmium::Location& location) {
-                    auto it = std::lower_bound(m_locations.begin(), m_locations.end(), slocation{}, [this, &location](const slocation& lhs, const slocation& rhs) {
-                        return lhs.location(m_segment_list, location) < rhs.location(m_segment_list, location);
-                    });
+                    const auto key_it = std::lower_bound(m_location_keys.cbegin(), m_location_keys.cend(), location_key(location));
+                    auto it = m_locations.begin() + (key_it - m_location_keys.cbegin());
 
                     assert(it != m_locations.end());
                     if (m_segment_list[it->item].is_done()) {
@@ -281,88 +301,66 @@ namespace osmium {
                     }
                 }
 
-                ProtoRing* find_enclosing_ring(NodeRefSegment* segment) {
+                void check_enclosing_segment(NodeRefSegment* segment, const osmium::Location& location, const osmium::Location& end_location, int& nesting, rings_stack& outer_rings) const {
                     if (debug()) {
-                        std::cerr << "    Looking for ring enclosing " << *segment << "\n";
-                    }
-
-                    const auto location = segment->first().location();
-                    const auto end_location = segment->second().location();
-
-                    while (segment->first().location() == location) {
-                        if (segment == &m_segment_list.back()) {
-                            break;
-                        }
-                        ++segment;
-                    }
-
-                    int nesting = 0;
-
-                    rings_stack outer_rings;
-                    while (segment >= &m_segment_list.front()) {
-                        if (!segment->is_direction_done()) {
-                            --segment;
-                            continue;
-                        }
+                        std::cerr << "      Checking against " << *segment << "\n";
+                    }
+                    const osmium::Location& a = segment->first().location();
+                    const osmium::Location& b = segment->second().location();
+
+                    if (segment->first().location() == location) {
+                        const int64_t ax = a.x();
+                        const int64_t bx = b.x();
+                        const int64_t lx = end_location.x();
+                        const int64_t ay = a.y();
+                        const int64_t by = b.y();
+                        const int64_t ly = end_location.y();
+                        const auto z = (bx - ax)*(ly - ay) - (by - ay)*(lx - ax);
                         if (debug()) {
-                            std::cerr << "      Checking against " << *segment << "\n";
+                            std::cerr << "      Segment z=" << z << '\n';
                         }
-                        const osmium::Location& a = segment->first().location();
-                        const osmium::Location& b = segment->second().location();
-
-                        if (segment->first().location() == location) {
-                            const int64_t ax = a.x();
-                            const int64_t bx = b.x();
-                            const int64_t lx = end_location.x();
-                            const int64_t ay = a.y();
-                            const int64_t by = b.y();
-                            const int64_t ly = end_location.y();
-                            const auto z = (bx - ax)*(ly - ay) - (by - ay)*(lx - ax);
+                        if (z > 0) {
+                            nesting += segment->is_reverse() ? -1 : 1;
                             if (debug()) {
-                                std::cerr << "      Segment z=" << z << '\n';
+                                std::cerr << "        Segment is below (nesting=" << nesting << ")\n";
                             }
-                            if (z > 0) {
-                                nesting += segment->is_reverse() ? -1 : 1;
+                            if (segment->ring()->is_outer()) {
                                 if (debug()) {
-                                    std::cerr << "        Segment is below (nesting=" << nesting << ")\n";
+                                    std::cerr << "        Segment belongs to outer ring (y=" << a.y() << " ring=" << *segment->ring() << ")\n";
                                 }
-                                if (segment->ring()->is_outer()) {
-                                    if (debug()) {
-                                        std::cerr << "        Segment belongs to outer ring (y=" << a.y() << " ring=" << *segment->ring() << ")\n";
-                                    }
-                                    outer_rings.emplace_back(a.y(), segment->ring());
-                                }
-                            }
-                        } else if (a.x() <= location.x() && location.x() < b.x()) {
-                            if (debug()) {
-                                std::cerr << "        Is in x range\n";
+                                outer_rings.emplace_back(a.y(), segment->ring());
                             }
+                        }
+                    } else if (a.x() <= location.x() && location.x() < b.x()) {
+                        if (debug()) {
+                            std::cerr << "        Is in x range\n";
+                        }
 
-                            const int64_t ax = a.x();
-                            const int64_t bx = b.x();
-                            const int64_t lx = location.x();
-                            const int64_t ay = a.y();
-                            const int64_t by = b.y();
-                            const int64_t ly = location.y();
-                            const auto z = (bx - ax)*(ly - ay) - (by - ay)*(lx - ax);
+                        const int64_t ax = a.x();
+                        const int64_t bx = b.x();
+                        const int64_t lx = location.x();
+                        const int64_t ay = a.y();
+                        const int64_t by = b.y();
+                        const int64_t ly = location.y();
+                        const auto z = (bx - ax)*(ly - ay) - (by - ay)*(lx - ax);
 
-                            if (z >= 0) {
-                                nesting += segment->is_reverse() ? -1 : 1;
+                        if (z >= 0) {
+                            nesting += segment->is_reverse() ? -1 : 1;
+                            if (debug()) {
+                                std::cerr << "        Segment is below (nesting=" << nesting << ")\n";
+                            }
+                            if (segment->ring()->is_outer()) {
+                                const double y = ay + (by - ay) * (lx - ax) / double(bx - ax);
                                 if (debug()) {
-                                    std::cerr << "        Segment is below (nesting=" << nesting << ")\n";
-                                }
-                                if (segment->ring()->is_outer()) {
-                                    const double y = ay + (by - ay) * (lx - ax) / double(bx - ax);
-                                    if (debug()) {
-                                        std::cerr << "        Segment belongs to outer ring (y=" << y << " ring=" << *segment->ring() << ")\n";
-                                    }
-                                    outer_rings.emplace_back(y, segment->ring());
+                                    std::cerr << "        Segment belongs to outer ring (y=" << y << " ring=" << *segment->ring() << ")\n";
                                 }
+                                outer_rings.emplace_back(y, segment->ring());
                             }
                         }
-                        --segment;
                     }
+                }
 
+                ProtoRing* enclosing_ring(int nesting, rings_stack& outer_rings) {
                     if (nesting % 2 == 0) {
                         if (debug()) {
                             std::cerr << "    Decided that this is an outer ring\n";
@@ -394,6 +392,58 @@ namespace osmium {
                     return outer_rings.front().ring_ptr();
                 }
 
+                ProtoRing* find_enclosing_ring(NodeRefSegment* segment) {
+                    if (debug()) {
+                        std::cerr << "    Looking for ring enclosing " << *segment << "\n";
+                    }
+
+                    const auto location = segment->first().location();
+                    const auto end_location = segment->second().location();
+
+                    int nesting = 0;
+                    rings_stack outer_rings;
+
+                    if (!m_segment_index.empty()) {
+                        m_segment_index.for_each_reverse(location.x(), [&](uint32_t n) {
+                            NodeRefSegment* s = &m_segment_list[n];
+                            if (s->is_direction_done()) {
+                                check_enclosing_segment(s, location, end_location, nesting, outer_rings);
+                            }
+                        });
+                        return enclosing_ring(nesting, outer_rings);
+                    }
+
+                    while (segment->first().location() == location) {
+                        if (segment == &m_segment_list.back()) {
+                            break;
+                        }
+                        ++segment;
+                    }
+
+                    while (segment >= &m_segment_list.front()) {
+                        if (segment->is_direction_done()) {
+                            check_enclosing_segment(segment, location, end_location, nesting, outer_rings);
+                        }
+                        --segment;
+                    }
+
+                    return enclosing_ring(nesting, outer_rings);
+                }
+
+                ProtoRing* add_ring(NodeRefSegment* segment) {
+                    if (m_free_rings.empty()) {
+                        m_rings.emplace_back(segment);
+                    } else {
+                        m_rings.splice(m_rings.end(), m_free_rings, m_free_rings.begin());
+                        m_rings.back().reset(segment);
+                    }
+                    return &m_rings.back();
+                }
+
+                void remove_ring(std::list<ProtoRing>::iterator ring) {
+                    m_free_rings.splice(m_free_rings.end(), m_rings, ring);
+                }
+
                 bool is_split_location(const osmium::Location& location) const noexcept {
                     return std::find(m_split_locations.cbegin(), m_split_locations.cend(), location) != m_split_locations.cend();
                 }
@@ -417,8 +467,7 @@ namespace osmium {
                     }
                     segment->mark_direction_done();
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = add_ring(segment);
                     if (outer_ring) {
                         if (debug()) {
                             std::cerr << "    This is an inner ring. Outer ring is " << *outer_ring << "\n";
@@ -468,8 +517,7 @@ namespace osmium {
                         segment->reverse();
                     }
 
-                    m_rings.emplace_back(segment);
-                    ProtoRing* ring = &m_rings.back();
+                    ProtoRing* ring = add_ring(segment);
 
                     const osmium::Location& first_location = node.location(m_segment_list);
                     osmium::Location last_location = segment->stop().location();
@@ -500,16 +548,31 @@ namespace osmium {
                 }
 
                 void create_locations_list() {
-                    m_locations.reserve(m_segment_list.size() * 2);
+                    m_location_entries.clear();
+                    m_location_entries.reserve(m_segment_list.size() * 2);
 
                     for (uint32_t n = 0; n < m_segment_list.size(); ++n) {
-                        m_locations.emplace_back(n, false);
-                        m_locations.emplace_back(n, true);
+                        const auto& segment = m_segment_list[n];
+                        m_location_entries.emplace_back(location_key(segment.first().location()), slocation{n, false});
+                        m_location_entries.emplace_back(location_key(segment.second().location()), slocation{n, true});
                     }
 
-                    std::stable_sort(m_locations.begin(), m_locations.end(), [this](const slocation& lhs, const slocation& rhs) {
-                        return lhs.location(m_segment_list) < rhs.location(m_segment_list);
+                    // Equal locations are ordered by their position in the
+                    // list, which gives the same result as a stable sort
+                    // without the temporary buffer it needs.
+                    std::sort(m_location_entries.begin(), m_location_entries.end(), [](const std::pair<uint64_t, slocation>& lhs, const std::pair<uint64_t, slocation>& rhs) {
+                        if (lhs.first != rhs.first) {
+                            return lhs.first < rhs.first;
+                        }
+                        return lhs.second.item < rhs.second.item || (lhs.second.item == rhs.second.item && lhs.second.reverse < rhs.second.reverse);
                     });
+
+                    m_locations.reserve(m_location_entries.size());
+                    m_location_keys.reserve(m_location_entries.size());
+                    for (const auto& entry : m_location_entries) {
+                        m_location_keys.push_back(entry.first);
+                        m_locations.push_back(entry.second);
+                    }
                 }
 
                 void find_inner_outer_complex(ProtoRing* ring) {
@@ -542,6 +605,10 @@ namespace osmium {
                         return a->min_segment() < b->min_segment();
                     });
 
+                    if (rings.size() >= segment_index_min_rings) {
+                        m_segment_index.build(m_segment_list);
+                    }
+
                     rings.front()->fix_direction();
                     rings.front()->mark_direction_done();
                     if (debug()) {
@@ -556,6 +623,8 @@ namespace osmium {
                             std::cerr << "    Ring is " << ((*it)->is_outer() ? "OUTER: " : "INNER: ") << **it << "\n";
                         }
                     }
+
+                    m_segment_index.clear();
                 }
 
                 /**
@@ -564,29 +633,32 @@ namespace osmium {
                  * and the function returns false.
                  */
                 bool find_split_locations() {
-                    osmium::Location previous_location;
-                    for (auto it = m_locations.cbegin(); it != m_locations.cend(); ++it) {
-                        const osmium::NodeRef& nr = it->node_ref(m_segment_list);
-                        const osmium::Location& loc = nr.location();
-                        if (std::next(it) == m_locations.cend() || loc != std::next(it)->location(m_segment_list)) {
+                    // The scan only compares the location keys, the
+                    // locations are only looked up when needed.
+                    const std::size_t size = m_location_keys.size();
+                    uint64_t previous_key = location_key(osmium::Location{});
+                    for (std::size_t n = 0; n < size; ++n) {
+                        const uint64_t key = m_location_keys[n];
+                        if (n + 1 == size || key != m_location_keys[n + 1]) {
+                            const osmium::NodeRef& nr = m_locations[n].node_ref(m_segment_list);
                             if (debug()) {
                                 std::cerr << "  Found open ring at " << nr << "\n";
                             }
                             if (m_config.problem_reporter) {
-                                const auto& segment = m_segment_list[it->item];
+                                const auto& segment = m_segment_list[m_locations[n].item];
                                 m_config.problem_reporter->report_ring_not_closed(nr, segment.way());
                             }
                             ++m_stats.open_rings;
                         } else {
-                            if (loc == previous_location && (m_split_locations.empty() || m_split_locations.back() != previous_location )) {
-                                m_split_locations.push_back(previous_location);
-                            }
-                            ++it;
-                            if (it == m_locations.end()) {
-                                break;
+                            if (key == previous_key) {
+                                const auto location = m_locations[n].location(m_segment_list);
+                                if (m_split_locations.empty() || m_split_locations.back() != location) {
+                                    m_split_locations.push_back(location);
+                                }
                             }
+                            ++n;
                         }
-                        previous_location = loc;
+                        previous_key = key;
                     }
                     return m_stats.open_rings == 0;
                 }
@@ -640,7 +712,7 @@ namespace osmium {
                     }
 
                     open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r2));
-                    m_rings.erase(r2);
+                    remove_ring(r2);
 
                     if (r1->closed()) {
                         open_ring_its.erase(std::find(open_ring_its.begin(), open_ring_its.end(), r1));
@@ -864,12 +936,9 @@ namespace osmium {
                     // First create all the (partial) rings starting at the split locations
                     auto count_remaining = m_segment_list.size();
                     for (const osmium::Location& location : m_split_locations) {
-                        const auto locs = make_range(std::equal_range(m_locations.begin(),
-                                                                    m_locations.end(),
-                                                                    slocation{},
-                                                                    [this, &location](const slocation& lhs, const slocation& rhs) {
-                            return lhs.location(m_segment_list, location) < rhs.location(m_segment_list, location);
-                        }));
+                        const auto positions = find_locations(location);
+                        const auto locs = make_range(std::make_pair(m_locations.begin() + static_cast<std::ptrdiff_t>(positions.first),
+                                                                    m_locations.begin() + static_cast<std::ptrdiff_t>(positions.second)));
                         for (auto& loc : locs) {
                             if (!m_segment_list[loc.item].is_done()) {
                                 count_remaining -= add_new_ring_complex(loc);
@@ -963,6 +1032,85 @@ namespace osmium {
                     return m_segment_list;
                 }
 
+                /**
+                 * Check whether the closed way can be turned into an area
+                 * without going through the full assembly: It must have
+                 * at most simple_way_max_nodes nodes, the first and last
+                 * node must be the same, all other nodes must have valid
+                 * and different locations, and no two segments may
+                 * intersect. If assume_valid_ways is set in the config,
+                 * only consecutive nodes are checked, regardless of the
+                 * number of nodes.
+                 *
+                 * @param way The way to check.
+                 * @param start Set to the position of the node with the
+                 *              smallest location.
+                 * @param ccw Set to true if the nodes are in counter-
+                 *            clockwise order.
+                 * @returns true if the way is a simple ring.
+                 */
+                bool check_simple_way(const osmium::Way& way, std::size_t& start, bool& ccw) const {
+                    const auto& nodes = way.nodes();
+                    if (nodes.size() < 4 || nodes.front().ref() != nodes.back().ref()) {
+                        return false;
+                    }
+                    const std::size_t size = nodes.size() - 1;
+                    if (size > simple_way_max_nodes && !m_config.assume_valid_ways) {
+                        return false;
+                    }
+
+                    start = 0;
+                    int64_t sum = 0;
+                    for (std::size_t n = 0; n < size; ++n) {
+                        const osmium::Location& location = nodes[n].location();
+                        if (!location.valid() || location == nodes[n + 1].location()) {
+                            return false;
+                        }
+                        if (location < nodes[start].location()) {
+                            start = n;
+                        }
+                        sum += vec{nodes[n]} * vec{nodes[n + 1]};
+                    }
+                    if (sum == 0) {
+                        return false;
+                    }
+                    ccw = sum > 0;
+
+                    if (m_config.assume_valid_ways) {
+                        return true;
+                    }
+
+                    for (std::size_t i = 0; i < size - 1; ++i) {
+                        const NodeRefSegment s1{nodes[i], nodes[i + 1], role_type::unknown, &way};
+                        for (std::size_t j = i + 1; j < size; ++j) {
+                            if (nodes[i].location() == nodes[j].location()) {
+                                return false;
+                            }
+                            const NodeRefSegment s2{nodes[j], nodes[j + 1], role_type::unknown, &way};
+                            if (!outside_x_range(s1, s2) && !outside_x_range(s2, s1) && y_range_overlap(s1, s2) && calculate_intersection(s1, s2)) {
+                                return false;
+                            }
+                        }
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * Add the nodes of a way checked with check_simple_way() as
+                 * outer ring to the area in the buffer. The ring starts at
+                 * the smallest location and goes counter-clockwise, the same
+                 * as a ring created by the full assembly.
+                 */
+                static void add_simple_ring_to_area(osmium::builder::AreaBuilder& builder, const osmium::WayNodeList& nodes, std::size_t start, bool ccw) {
+                    const std::size_t size = nodes.size() - 1;
+                    osmium::builder::OuterRingBuilder ring_builder{builder};
+                    for (std::size_t n = 0; n <= size; ++n) {
+                        const std::size_t pos = ccw ? (start + n) % size : (start + size - n) % size;
+                        ring_builder.add_node_ref(nodes[pos]);
+                    }
+                }
+
                 /**
                  * Append each outer ring together with its inner rings to the
                  * area in the buffer.
@@ -1051,11 +1199,9 @@ namespace osmium {
                         }
                         for (const auto& location : m_split_locations) {
                             if (m_config.problem_reporter) {
-                                auto it = std::lower_bound(m_locations.cbegin(), m_locations.cend(), slocation{}, [this, &location](const slocation& lhs, const slocation& rhs) {
-                                    return lhs.location(m_segment_list, location) < rhs.location(m_segment_list, location);
-                                });
-                                assert(it != m_locations.cend());
-                                const osmium::object_id_type id = it->node_ref(m_segment_list).ref();
+                                const auto pos = find_locations(location).first;
+                                assert(pos != m_locations.size());
+                                const osmium::object_id_type id = m_locations[pos].node_ref(m_segment_list).ref();
                                 m_config.problem_reporter->report_touching_ring(id, location);
                             }
                             if (debug()) {
@@ -1094,8 +1240,9 @@ namespace osmium {
 
                     // If the assembler was so configured, now check whether the
                     // member roles are correctly tagged.
+                    osmium::Timer timer_roles;
                     if (m_config.check_roles && m_stats.from_relations) {
-                        osmium::Timer timer_roles;
+                        timer_roles.start();
                         check_inner_outer_roles();
                         timer_roles.stop();
                     }
@@ -1121,13 +1268,13 @@ namespace osmium {
                                     ' ' << timer_complex_case.elapsed_microseconds();
                     }
 
-                    std::cout <<
-# ifdef OSMIUM_AREA_CHECK_INNER_OUTER_ROLES
-                                ' ' << timer_roles.elapsed_microseconds() <<
-# else
-                                " 0" <<
-# endif
-                                '\n';
+                    if (m_config.check_roles && m_stats.from_relations) {
+                        std::cout << ' ' << timer_roles.elapsed_microseconds();
+                    } else {
+                        std::cout << " 0";
+                    }
+
+                    std::cout << '\n';
 #endif
 
                     return true;
@@ -1137,6 +1284,24 @@ namespace osmium {
 
                 using config_type = osmium::area::AssemblerConfig;
 
+                /**
+                 * Closed ways with at most this many nodes are checked with
+                 * a quick test whether they are simple rings. If they are,
+                 * the area is created directly from the way nodes.
+                 */
+                enum : std::size_t {
+                    simple_way_max_nodes = 32
+                };
+
+                /**
+                 * If an area has at least this many closed rings, an index
+                 * of the segments is used to find out which rings are
+                 * inside which other rings.
+                 */
+                enum : std::size_t {
+                    segment_index_min_rings = 32
+                };
+
                 explicit BasicAssembler(const config_type& config) :
                     m_config(config),
                     m_segment_list(config.debug_level > 1) {
@@ -1149,6 +1314,22 @@ namespace osmium {
                     return m_config;
                 }
 
+                /**
+                 * Clear all data from assembling the last object, so the
+                 * assembler can be used for the next one. The memory used
+                 * is kept and reused. This also resets the statistics.
+                 */
+                void reset() {
+                    m_segment_list.clear();
+                    m_segment_index.clear();
+                    m_free_rings.splice(m_free_rings.end(), m_rings);
+                    m_locations.clear();
+                    m_location_keys.clear();
+                    m_split_locations.clear();
+                    m_stats = area_stats{};
+                    m_num_members = 0;
+                }
+
                 bool debug() const noexcept {
                     return m_config.debug_level > 1;
                 }
@@ -255,6 +255,17 @@ namespace osmium {
                 return lhs.first().location() < rhs.first().location();
             }
 
+            /**
+             * Pack a location into a 64 bit key with the x coordinate in
+             * the upper and the y coordinate in the lower 32 bits. Keys
+             * compare like the locations with operator<, so they can be
+             * used for radix sorting and fast comparisons.
+             */
+            inline uint64_t location_key(const osmium::Location& location) noexcept {
+                return (static_cast<uint64_t>(static_cast<uint32_t>(location.x()) ^ 0x80000000U) << 32U) |
+                        static_cast<uint64_t>(static_cast<uint32_t>(location.y()) ^ 0x80000000U);
+            }
+
             template <typename TChar, typename TTraits>
             inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const NodeRefSegment& segment) {
                 return out << segment.start() << "--" << segment.stop()
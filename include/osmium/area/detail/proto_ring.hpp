@@ -99,6 +99,22 @@ namespace osmium {
                     add_segment_back(segment);
                 }
 
+                /**
+                 * Reinitialize this ring so that it only contains the given
+                 * segment. The memory used by the ring is kept for reuse.
+                 */
+                void reset(NodeRefSegment* segment) {
+                    m_segments.clear();
+                    m_inner.clear();
+                    m_min_segment = segment;
+                    m_outer_ring = nullptr;
+#ifdef OSMIUM_DEBUG_RING_NO
+                    m_num = next_num();
+#endif
+                    m_sum = 0;
+                    add_segment_back(segment);
+                }
+
                 void add_segment_back(NodeRefSegment* segment) {
                     assert(segment);
                     if (*segment < *m_min_segment) {
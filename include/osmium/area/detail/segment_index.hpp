@@ -0,0 +1,185 @@
+#ifndef OSMIUM_AREA_DETAIL_SEGMENT_INDEX_HPP
+#define OSMIUM_AREA_DETAIL_SEGMENT_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/detail/node_ref_segment.hpp>
+#include <osmium/area/detail/segment_list.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * @brief Namespace for Osmium internal use
+         */
+        namespace detail {
+
+            /**
+             * Index of the segments in a SegmentList by x coordinate.
+             * The x range of all segments is split into columns of equal
+             * width and each segment is added to all columns its x range
+             * overlaps. This allows finding all segments crossing a given
+             * x coordinate without looking at all segments.
+             */
+            class SegmentIndex {
+
+                // Segments are added to at most this many columns per
+                // segment on average. If there are many long segments,
+                // the number of columns is reduced.
+                enum : std::size_t {
+                    max_entries_per_segment = 4,
+                    segments_per_column = 8
+                };
+
+                std::vector<uint32_t> m_offsets;
+                std::vector<uint32_t> m_segments;
+                int64_t m_min_x = 0;
+                int64_t m_column_width = 1;
+
+                std::size_t column(int64_t x) const noexcept {
+                    return static_cast<std::size_t>((x - m_min_x) / m_column_width);
+                }
+
+                std::size_t count_entries(const SegmentList& segments) const noexcept {
+                    std::size_t count = 0;
+                    for (std::size_t n = 0; n < segments.size(); ++n) {
+                        count += column(segments[n].second().location().x()) - column(segments[n].first().location().x()) + 1;
+                    }
+                    return count;
+                }
+
+            public:
+
+                /**
+                 * Build the index for the segments in the list. The
+                 * segments must not be changed while the index is in use.
+                 */
+                void build(const SegmentList& segments) {
+                    clear();
+                    if (segments.empty()) {
+                        return;
+                    }
+
+                    int64_t min_x = segments[0].first().location().x();
+                    int64_t max_x = min_x;
+                    for (std::size_t n = 0; n < segments.size(); ++n) {
+                        const int64_t ax = segments[n].first().location().x();
+                        const int64_t bx = segments[n].second().location().x();
+                        if (ax < min_x) {
+                            min_x = ax;
+                        }
+                        if (bx > max_x) {
+                            max_x = bx;
+                        }
+                    }
+                    m_min_x = min_x;
+
+                    std::size_t num_columns = segments.size() / segments_per_column + 1;
+                    std::size_t num_entries = 0;
+                    while (true) {
+                        m_column_width = (max_x - min_x) / static_cast<int64_t>(num_columns) + 1;
+                        num_entries = count_entries(segments);
+                        if (num_columns == 1 || num_entries <= max_entries_per_segment * segments.size()) {
+                            break;
+                        }
+                        num_columns /= 2;
+                    }
+                    num_columns = column(max_x) + 1;
+
+                    m_offsets.assign(num_columns + 1, 0);
+                    for (std::size_t n = 0; n < segments.size(); ++n) {
+                        const auto last = column(segments[n].second().location().x());
+                        for (auto c = column(segments[n].first().location().x()); c <= last; ++c) {
+                            ++m_offsets[c + 1];
+                        }
+                    }
+                    for (std::size_t c = 1; c <= num_columns; ++c) {
+                        m_offsets[c] += m_offsets[c - 1];
+                    }
+
+                    m_segments.resize(num_entries);
+                    std::vector<uint32_t> pos{m_offsets.begin(), m_offsets.end() - 1};
+                    for (std::size_t n = 0; n < segments.size(); ++n) {
+                        const auto last = column(segments[n].second().location().x());
+                        for (auto c = column(segments[n].first().location().x()); c <= last; ++c) {
+                            m_segments[pos[c]++] = static_cast<uint32_t>(n);
+                        }
+                    }
+                }
+
+                void clear() {
+                    m_offsets.clear();
+                    m_segments.clear();
+                }
+
+                bool empty() const noexcept {
+                    return m_offsets.empty();
+                }
+
+                /**
+                 * Call func with the position in the segment list of all
+                 * segments whose x range could contain x. The positions
+                 * are visited in descending order. Segments not containing
+                 * x might also be visited, so the caller has to check.
+                 */
+                template <typename TFunc>
+                void for_each_reverse(int64_t x, TFunc&& func) const {
+                    assert(!empty());
+                    if (x < m_min_x) {
+                        return;
+                    }
+                    const auto c = column(x);
+                    if (c + 1 >= m_offsets.size()) {
+                        return;
+                    }
+                    for (auto n = m_offsets[c + 1]; n > m_offsets[c]; --n) {
+                        std::forward<TFunc>(func)(m_segments[n - 1]);
+                    }
+                }
+
+            }; // class SegmentIndex
+
+        } // namespace detail
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_DETAIL_SEGMENT_INDEX_HPP
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/area/detail/node_ref_segment.hpp>
 #include <osmium/area/problem_reporter.hpp>
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -44,12 +45,16 @@ DEALINGS IN THE SOFTWARE.
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <iterator>
+#include <limits>
 #include <numeric>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -141,6 +146,20 @@ namespace osmium {
                     return invalid_locations;
                 }
 
+                void check_intersection(const NodeRefSegment& s1, const NodeRefSegment& s2, uint32_t& found_intersections, ProblemReporter* problem_reporter) const {
+                    const osmium::Location intersection{calculate_intersection(s1, s2)};
+                    if (intersection) {
+                        ++found_intersections;
+                        if (m_debug) {
+                            std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
+                        }
+                        if (problem_reporter) {
+                            problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
+                                                                  s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
+                        }
+                    }
+                }
+
             public:
 
                 explicit SegmentList(bool debug) noexcept :
@@ -165,6 +184,11 @@ namespace osmium {
                     return m_segments.empty();
                 }
 
+                /// Remove all segments, keeping the allocated memory.
+                void clear() noexcept {
+                    m_segments.clear();
+                }
+
                 using const_iterator = slist_type::const_iterator;
                 using iterator = slist_type::iterator;
 
@@ -210,9 +234,52 @@ namespace osmium {
                     m_debug = debug;
                 }
 
-                /// Sort the list of segments.
+                /**
+                 * Minimum number of segments for which sort() radix sorts
+                 * the segments by the packed key of their first location.
+                 */
+                enum : std::size_t {
+                    sort_by_key_min_segments = 4096
+                };
+
+                /**
+                 * Sort the list of segments.
+                 *
+                 * Large lists are radix sorted by the first location. Only
+                 * the (usually very short) runs of segments with the same
+                 * first location are then sorted with the full comparison.
+                 */
                 void sort() {
-                    std::sort(m_segments.begin(), m_segments.end());
+                    if (m_segments.size() < sort_by_key_min_segments) {
+                        std::sort(m_segments.begin(), m_segments.end());
+                        return;
+                    }
+
+                    std::vector<std::pair<uint64_t, uint32_t>> keys;
+                    keys.reserve(m_segments.size());
+                    for (std::size_t n = 0; n < m_segments.size(); ++n) {
+                        keys.emplace_back(location_key(m_segments[n].first().location()), static_cast<uint32_t>(n));
+                    }
+                    osmium::index::detail::radix_sort(keys, [](const std::pair<uint64_t, uint32_t>& key) noexcept {
+                        return key.first;
+                    });
+
+                    slist_type sorted;
+                    sorted.reserve(m_segments.capacity());
+                    for (auto it = keys.cbegin(); it != keys.cend();) {
+                        auto last = std::next(it);
+                        while (last != keys.cend() && last->first == it->first) {
+                            ++last;
+                        }
+                        const auto run_begin = sorted.size();
+                        for (; it != last; ++it) {
+                            sorted.push_back(m_segments[it->second]);
+                        }
+                        if (sorted.size() - run_begin > 1) {
+                            std::sort(sorted.begin() + static_cast<std::ptrdiff_t>(run_begin), sorted.end());
+                        }
+                    }
+                    m_segments.swap(sorted);
                 }
 
                 /**
@@ -310,11 +377,41 @@ namespace osmium {
                 /**
                  * Find intersection between segments.
                  *
+                 * Uses find_intersections_sweep() if there are at least
+                 * sweep_line_min_segments segments, otherwise
+                 * find_intersections_simple(). Both find the same
+                 * intersections and report them in the same order.
+                 *
                  * @param problem_reporter Any intersections found are
                  *                         reported to this object.
                  * @returns true if there are intersections.
                  */
                 uint32_t find_intersections(ProblemReporter* problem_reporter) const {
+                    if (m_segments.size() >= sweep_line_min_segments) {
+                        return find_intersections_sweep(problem_reporter);
+                    }
+                    return find_intersections_simple(problem_reporter);
+                }
+
+                /**
+                 * Minimum number of segments for which find_intersections()
+                 * uses the sweep line algorithm.
+                 */
+                enum : std::size_t {
+                    sweep_line_min_segments = 1024
+                };
+
+                /**
+                 * Find intersection between segments by comparing each
+                 * segment with all later segments in the sorted list until
+                 * they are outside its x range. This is quadratic if many
+                 * segments have overlapping x ranges.
+                 *
+                 * @param problem_reporter Any intersections found are
+                 *                         reported to this object.
+                 * @returns true if there are intersections.
+                 */
+                uint32_t find_intersections_simple(ProblemReporter* problem_reporter) const {
                     if (m_segments.empty()) {
                         return 0;
                     }
@@ -333,21 +430,82 @@ namespace osmium {
                             }
 
                             if (y_range_overlap(s1, s2)) {
-                                osmium::Location intersection{calculate_intersection(s1, s2)};
-                                if (intersection) {
-                                    ++found_intersections;
-                                    if (m_debug) {
-                                        std::cerr << "  segments " << s1 << " and " << s2 << " intersecting at " << intersection << "\n";
-                                    }
-                                    if (problem_reporter) {
-                                        problem_reporter->report_intersection(s1.way()->id(), s1.first().location(), s1.second().location(),
-                                                                              s2.way()->id(), s2.first().location(), s2.second().location(), intersection);
-                                    }
+                                check_intersection(s1, s2, found_intersections, problem_reporter);
+                            }
+                        }
+                    }
+
+                    return found_intersections;
+                }
+
+                /**
+                 * Find intersection between segments with a sweep line
+                 * over the x axis. The segments whose x range contains the
+                 * sweep line are kept in buckets by their y range, so only
+                 * segments with overlapping x and y ranges are compared.
+                 * Segments no longer reached by the sweep line are removed
+                 * lazily when a bucket is searched.
+                 *
+                 * @param problem_reporter Any intersections found are
+                 *                         reported to this object.
+                 * @returns true if there are intersections.
+                 */
+                uint32_t find_intersections_sweep(ProblemReporter* problem_reporter) const {
+                    if (m_segments.empty()) {
+                        return 0;
+                    }
+
+                    int64_t min_y = std::numeric_limits<int32_t>::max();
+                    int64_t max_y = std::numeric_limits<int32_t>::min();
+                    for (const auto& segment : m_segments) {
+                        min_y = std::min<int64_t>(min_y, std::min(segment.first().location().y(), segment.second().location().y()));
+                        max_y = std::max<int64_t>(max_y, std::max(segment.first().location().y(), segment.second().location().y()));
+                    }
+
+                    const auto num_buckets = static_cast<int64_t>(std::sqrt(static_cast<double>(m_segments.size()))) + 1;
+                    const int64_t bucket_height = (max_y - min_y) / num_buckets + 1;
+                    const auto bucket = [min_y, bucket_height](int32_t y) {
+                        return static_cast<std::size_t>((y - min_y) / bucket_height);
+                    };
+
+                    std::vector<std::vector<std::size_t>> buckets(static_cast<std::size_t>(num_buckets));
+                    std::vector<std::pair<std::size_t, std::size_t>> candidates;
+
+                    for (std::size_t n = 0; n < m_segments.size(); ++n) {
+                        const NodeRefSegment& s2 = m_segments[n];
+                        const std::pair<int32_t, int32_t> y2 = std::minmax(s2.first().location().y(), s2.second().location().y());
+                        const auto first_bucket = bucket(y2.first);
+                        const auto last_bucket = bucket(y2.second);
+                        for (auto b = first_bucket; b <= last_bucket; ++b) {
+                            auto& active = buckets[b];
+                            for (std::size_t i = 0; i < active.size();) {
+                                const NodeRefSegment& s1 = m_segments[active[i]];
+                                if (outside_x_range(s2, s1)) {
+                                    active[i] = active.back();
+                                    active.pop_back();
+                                    continue;
                                 }
+                                // Overlapping segments are in several
+                                // buckets, only check them in the bucket
+                                // where their overlap starts.
+                                if (y_range_overlap(s1, s2) &&
+                                    bucket(std::max(y2.first, std::min(s1.first().location().y(), s1.second().location().y()))) == b) {
+                                    candidates.emplace_back(active[i], n);
+                                }
+                                ++i;
                             }
+                            active.push_back(n);
                         }
                     }
 
+                    std::sort(candidates.begin(), candidates.end());
+
+                    uint32_t found_intersections = 0;
+                    for (const auto& candidate : candidates) {
+                        assert(m_segments[candidate.first] != m_segments[candidate.second]);
+                        check_intersection(m_segments[candidate.first], m_segments[candidate.second], found_intersections, problem_reporter);
+                    }
+
                     return found_intersections;
                 }
 
@@ -38,10 +38,18 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/area/detail/segment_list.hpp>
 #include <osmium/area/stats.hpp>
 #include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/geom/factory.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
+#include <cstddef>
+#include <vector>
+
 namespace osmium {
 
     namespace area {
@@ -60,6 +68,50 @@ namespace osmium {
          */
         class GeomAssembler : public detail::BasicAssembler {
 
+            // Node references of one ring, reused for all rings
+            std::vector<osmium::NodeRef> m_ring_nodes;
+
+            template <typename TFactory>
+            void add_ring_to_multipolygon(TFactory& factory, const detail::ProtoRing& ring) {
+                m_ring_nodes.clear();
+                m_ring_nodes.push_back(ring.get_node_ref_start());
+                for (const auto& segment : ring.segments()) {
+                    m_ring_nodes.push_back(segment->stop());
+                }
+                factory.fill_multipolygon_ring_unique(m_ring_nodes.cbegin(), m_ring_nodes.cend());
+            }
+
+            template <typename TFactory>
+            typename TFactory::multipolygon_type create_multipolygon_from_rings(TFactory& factory) {
+                std::size_t num_polygons = 0;
+                factory.multipolygon_start();
+                for (const detail::ProtoRing& ring : rings()) {
+                    if (!ring.is_outer()) {
+                        continue;
+                    }
+                    if (num_polygons > 0) {
+                        factory.multipolygon_polygon_finish();
+                    }
+                    factory.multipolygon_polygon_start();
+                    factory.multipolygon_outer_ring_start();
+                    add_ring_to_multipolygon(factory, ring);
+                    factory.multipolygon_outer_ring_finish();
+                    ++num_polygons;
+                    for (const detail::ProtoRing* inner : ring.inner_rings()) {
+                        factory.multipolygon_inner_ring_start();
+                        add_ring_to_multipolygon(factory, *inner);
+                        factory.multipolygon_inner_ring_finish();
+                    }
+                }
+
+                if (num_polygons == 0) {
+                    throw osmium::geometry_error{"invalid area"};
+                }
+
+                factory.multipolygon_polygon_finish();
+                return factory.multipolygon_finish();
+            }
+
         public:
 
             using config_type = osmium::area::AssemblerConfig;
@@ -93,6 +145,44 @@ namespace osmium {
                 return true;
             }
 
+            /**
+             * Assemble an area from the given way and create a multipolygon
+             * geometry from it with the geometry factory. No Area object
+             * is created. The geometry is the same as the one the factory
+             * creates from an area built with operator()().
+             *
+             * The assembler is reset first, so it can be used for any
+             * number of ways.
+             *
+             * @param way The way.
+             * @param factory The geometry factory, for instance a
+             *                osmium::geom::WKBFactory.
+             * @param geometry The geometry is put here.
+             *
+             * @returns false if there was some kind of error building the
+             *          area, true otherwise.
+             * @throws osmium::geometry_error if the geometry can not be
+             *         created.
+             */
+            template <typename TFactory>
+            bool create_multipolygon(const osmium::Way& way, TFactory& factory, typename TFactory::multipolygon_type& geometry) {
+                reset();
+                segment_list().extract_segments_from_way(config().problem_reporter, stats().duplicate_nodes, way);
+
+                if (!create_rings()) {
+                    return false;
+                }
+
+                try {
+                    geometry = create_multipolygon_from_rings(factory);
+                } catch (osmium::geometry_error& e) {
+                    e.set_id("area", osmium::object_id_to_area_id(way.id(), osmium::item_type::way));
+                    throw;
+                }
+
+                return true;
+            }
+
             /**
              * Assemble an area from the given relation and its member ways
              * which are in the ways_buffer.
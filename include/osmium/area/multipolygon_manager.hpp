@@ -45,12 +45,15 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/tags/taglist.hpp>
 #include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <future>
+#include <mutex>
 #include <vector>
 
 namespace osmium {
@@ -78,12 +81,126 @@ namespace osmium {
             using assembler_config_type = typename TAssembler::config_type;
             const assembler_config_type m_assembler_config;
 
+            // Assembler reused for all areas assembled in the main thread.
+            TAssembler m_assembler;
+
             area_stats m_stats;
 
+            // Protects m_stats when complete_relation() is called from
+            // several threads.
+            std::mutex m_stats_mutex;
+
             osmium::TagsFilter m_filter;
 
+            // Closed ways found in handle_buffer() which are assembled in
+            // several threads after all objects in the buffer are handled.
+            std::vector<const osmium::Way*> m_closed_ways;
+            bool m_collect_closed_ways = false;
+
+            using base_type = osmium::relations::RelationsManager<MultipolygonManager<TAssembler>, false, true, false>;
+
+            bool wanted_closed_way(const osmium::Way& way) const {
+                // you need at least 4 nodes to make up a polygon
+                if (way.nodes().size() <= 3) {
+                    return false;
+                }
+
+                if (!way.nodes().front().location() || !way.nodes().back().location()) {
+                    return false;
+                }
+
+                if (!way.ends_have_same_location()) {
+                    return false;
+                }
+
+                if (way.tags().has_tag("area", "no")) {
+                    return false;
+                }
+
+                return !osmium::tags::match_none_of(way.tags(), m_filter);
+            }
+
+            void assemble_way(TAssembler& assembler, const osmium::Way& way, osmium::memory::Buffer& buffer) {
+                try {
+                    assembler(way, buffer);
+                    const std::lock_guard<std::mutex> lock{m_stats_mutex};
+                    m_stats += assembler.stats();
+                } catch (const osmium::invalid_location&) {
+                    // XXX ignore
+                }
+            }
+
+            void assemble_relation(TAssembler& assembler, const osmium::Relation& relation, osmium::memory::Buffer& buffer) {
+                std::vector<const osmium::Way*> ways;
+                ways.reserve(relation.members().size());
+                for (const auto& member : relation.members()) {
+                    if (member.ref() != 0) {
+                        ways.push_back(this->get_member_way(member.ref()));
+                        assert(ways.back() != nullptr);
+                    }
+                }
+
+                try {
+                    assembler(relation, ways, buffer);
+                    const std::lock_guard<std::mutex> lock{m_stats_mutex};
+                    m_stats += assembler.stats();
+                } catch (const osmium::invalid_location&) {
+                    // XXX ignore
+                }
+            }
+
+            void assemble_closed_ways(osmium::thread::Pool& pool) {
+                const std::size_t num_tasks = std::min(m_closed_ways.size() / min_ways_per_task, static_cast<std::size_t>(pool.num_threads()) * 4);
+                if (num_tasks <= 1) {
+                    for (const auto* way : m_closed_ways) {
+                        assemble_way(m_assembler, *way, this->buffer());
+                        this->possibly_flush();
+                    }
+                    m_closed_ways.clear();
+                    return;
+                }
+
+                std::vector<osmium::memory::Buffer> buffers;
+                buffers.reserve(num_tasks);
+                std::vector<std::future<void>> futures;
+                futures.reserve(num_tasks);
+                for (std::size_t n = 0; n < num_tasks; ++n) {
+                    buffers.emplace_back(base_type::initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes);
+                    auto* buffer = &buffers.back();
+                    const std::size_t begin = m_closed_ways.size() * n / num_tasks;
+                    const std::size_t end = m_closed_ways.size() * (n + 1) / num_tasks;
+                    futures.push_back(pool.submit([this, buffer, begin, end]() {
+                        TAssembler assembler{m_assembler_config};
+                        for (std::size_t i = begin; i < end; ++i) {
+                            assemble_way(assembler, *m_closed_ways[i], *buffer);
+                        }
+                    }));
+                }
+                for (auto& future : futures) {
+                    future.wait();
+                }
+                m_closed_ways.clear();
+                for (auto& future : futures) {
+                    future.get();
+                }
+
+                for (const auto& buffer : buffers) {
+                    this->buffer().add_buffer(buffer);
+                    this->buffer().commit();
+                    this->possibly_flush();
+                }
+            }
+
         public:
 
+            /**
+             * Minimum number of closed ways per task when areas are
+             * assembled from closed ways in several threads.
+             */
+            enum : std::size_t {
+                min_ways_per_task = 64
+            };
+
             /**
              * Construct a MultipolygonManager.
              *
@@ -95,7 +212,18 @@ namespace osmium {
              */
             explicit MultipolygonManager(assembler_config_type assembler_config, osmium::TagsFilter filter = osmium::TagsFilter{true}) :
                 m_assembler_config(std::move(assembler_config)),
+                m_assembler(m_assembler_config),
                 m_filter(std::move(filter)) {
+                m_filter.compile();
+            }
+
+            /**
+             * The filter used to decide which closed ways and relations
+             * should become areas. Add it to a TagsClassifier to check
+             * it together with other filters.
+             */
+            const osmium::TagsFilter& filter() const noexcept {
+                return m_filter;
             }
 
             /**
@@ -133,51 +261,58 @@ namespace osmium {
              * assembler.
              */
             void complete_relation(const osmium::Relation& relation) {
-                std::vector<const osmium::Way*> ways;
-                ways.reserve(relation.members().size());
-                for (const auto& member : relation.members()) {
-                    if (member.ref() != 0) {
-                        ways.push_back(this->get_member_way(member.ref()));
-                        assert(ways.back() != nullptr);
-                    }
-                }
+                assemble_relation(m_assembler, relation, this->buffer());
+            }
 
-                try {
-                    TAssembler assembler{m_assembler_config};
-                    assembler(relation, ways, this->buffer());
-                    m_stats += assembler.stats();
-                } catch (const osmium::invalid_location&) {
-                    // XXX ignore
-                }
+            /**
+             * Build the area for a complete relation into the given buffer.
+             * This is used by RelationsManager::handle_buffer() to build
+             * areas in several threads.
+             */
+            void complete_relation(const osmium::Relation& relation, osmium::memory::Buffer& buffer) {
+                TAssembler assembler{m_assembler_config};
+                assemble_relation(assembler, relation, buffer);
             }
 
             void after_way(const osmium::Way& way) {
-                // you need at least 4 nodes to make up a polygon
-                if (way.nodes().size() <= 3) {
+                if (!wanted_closed_way(way)) {
                     return;
                 }
 
-                try {
-                    if (!way.nodes().front().location() || !way.nodes().back().location()) {
-                        throw osmium::invalid_location{"invalid location"};
-                    }
-                    if (way.ends_have_same_location()) {
-                        if (way.tags().has_tag("area", "no")) {
-                            return;
-                        }
+                if (m_collect_closed_ways) {
+                    m_closed_ways.push_back(&way);
+                    return;
+                }
 
-                        if (osmium::tags::match_none_of(way.tags(), m_filter)) {
-                            return;
-                        }
+                assemble_way(m_assembler, way, this->buffer());
+                this->possibly_flush();
+            }
 
-                        TAssembler assembler{m_assembler_config};
-                        assembler(way, this->buffer());
-                        m_stats += assembler.stats();
-                        this->possibly_flush();
-                    }
-                } catch (const osmium::invalid_location&) {
-                    // XXX ignore
+            /**
+             * Handle all objects in the buffer for the second pass using
+             * several threads. See RelationsManager::handle_buffer() for
+             * details.
+             *
+             * In addition to areas from relations, the areas from closed
+             * ways are also assembled in several threads, each writing
+             * into its own buffer. They are added to the output in the
+             * order of the ways after the areas from relations completed
+             * by this buffer.
+             *
+             * @param buffer Buffer with the objects.
+             * @param pool Thread pool to use.
+             */
+            void handle_buffer(const osmium::memory::Buffer& buffer, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                m_collect_closed_ways = true;
+                try {
+                    base_type::handle_buffer(buffer, pool);
+                } catch (...) {
+                    m_collect_closed_ways = false;
+                    m_closed_ways.clear();
+                    throw;
                 }
+                m_collect_closed_ways = false;
+                assemble_closed_ways(pool);
             }
 
         }; // class MultipolygonManager
@@ -0,0 +1,194 @@
+#ifndef OSMIUM_AREA_PARALLEL_GEOM_ASSEMBLER_HPP
+#define OSMIUM_AREA_PARALLEL_GEOM_ASSEMBLER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/assembler_config.hpp>
+#include <osmium/area/geom_assembler.hpp>
+#include <osmium/geom/factory.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        /**
+         * Creates multipolygon geometries from all closed ways in a buffer
+         * using the GeomAssembler and a geometry factory. The ways are
+         * split into chunks which are assembled in parallel in a thread
+         * pool. No Area objects are created, the geometries are written
+         * by the factory directly from the rings found by the assembler.
+         *
+         * This is intended for loading polygons into a database, for
+         * instance as WKB created by osmium::geom::WKBFactory. Like the
+         * GeomAssembler, this doesn't look at tags. Use the
+         * MultipolygonManager if you need Area objects.
+         *
+         * @tparam TFactory Geometry factory class. Every task works on
+         *                  its own copy of the factory given to the
+         *                  constructor.
+         */
+        template <typename TFactory>
+        class ParallelGeomAssembler {
+
+        public:
+
+            using geometry_type = typename TFactory::multipolygon_type;
+
+            /**
+             * The geometry created from a way together with the way id.
+             */
+            struct way_geometry {
+                osmium::object_id_type id;
+                geometry_type geometry;
+            };
+
+            /**
+             * Minimum number of closed ways per task.
+             */
+            enum : std::size_t {
+                min_ways_per_task = 64
+            };
+
+        private:
+
+            AssemblerConfig m_config;
+            TFactory m_factory;
+            osmium::thread::Pool* m_pool;
+
+            static bool is_closed_way(const osmium::Way& way) noexcept {
+                return way.nodes().size() > 3 &&
+                       way.nodes().front().location() &&
+                       way.nodes().back().location() &&
+                       way.ends_have_same_location();
+            }
+
+            void assemble(const std::vector<const osmium::Way*>& ways, std::size_t begin, std::size_t end, std::vector<way_geometry>& result) const {
+                TFactory factory{m_factory};
+                GeomAssembler assembler{m_config};
+                geometry_type geometry;
+                for (std::size_t n = begin; n < end; ++n) {
+                    try {
+                        if (assembler.create_multipolygon(*ways[n], factory, geometry)) {
+                            result.push_back(way_geometry{ways[n]->id(), std::move(geometry)});
+                        }
+                    } catch (const osmium::geometry_error&) {
+                        // ignore ways for which no geometry can be created
+                    } catch (const osmium::invalid_location&) {
+                        // ignore ways with invalid locations
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Constructor.
+             *
+             * @param config Configuration for the assemblers.
+             * @param factory Geometry factory. It is copied for each task.
+             * @param pool Thread pool to use.
+             */
+            explicit ParallelGeomAssembler(const AssemblerConfig& config, TFactory factory = TFactory{}, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) :
+                m_config(config),
+                m_factory(std::move(factory)),
+                m_pool(&pool) {
+            }
+
+            /**
+             * Create geometries for all closed ways in the buffer. Other
+             * objects in the buffer are ignored, as are ways for which no
+             * valid area can be assembled.
+             *
+             * @returns Geometries in the order of the ways in the buffer.
+             */
+            std::vector<way_geometry> operator()(const osmium::memory::Buffer& buffer) const {
+                std::vector<const osmium::Way*> ways;
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    if (is_closed_way(way)) {
+                        ways.push_back(&way);
+                    }
+                }
+
+                std::vector<way_geometry> result;
+                const std::size_t num_tasks = std::min(ways.size() / min_ways_per_task, static_cast<std::size_t>(m_pool->num_threads()) * 4);
+                if (num_tasks <= 1) {
+                    result.reserve(ways.size());
+                    assemble(ways, 0, ways.size(), result);
+                    return result;
+                }
+
+                std::vector<std::vector<way_geometry>> results(num_tasks);
+                std::vector<std::future<void>> futures;
+                futures.reserve(num_tasks);
+                for (std::size_t n = 0; n < num_tasks; ++n) {
+                    const std::size_t begin = ways.size() * n / num_tasks;
+                    const std::size_t end = ways.size() * (n + 1) / num_tasks;
+                    auto* task_result = &results[n];
+                    futures.push_back(m_pool->submit([this, &ways, begin, end, task_result]() {
+                        task_result->reserve(end - begin);
+                        assemble(ways, begin, end, *task_result);
+                    }));
+                }
+                for (auto& future : futures) {
+                    future.wait();
+                }
+                for (auto& future : futures) {
+                    future.get();
+                }
+
+                result.reserve(ways.size());
+                for (auto& task_result : results) {
+                    std::move(task_result.begin(), task_result.end(), std::back_inserter(result));
+                }
+                return result;
+            }
+
+        }; // class ParallelGeomAssembler
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_PARALLEL_GEOM_ASSEMBLER_HPP
@@ -0,0 +1,451 @@
+#ifndef OSMIUM_AREA_POLYGON_INDEX_HPP
+#define OSMIUM_AREA_POLYGON_INDEX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+namespace osmium {
+
+    namespace area {
+
+        namespace detail {
+
+            /**
+             * A segment of a polygon ring in the fixed-point coordinates
+             * of osmium::Location.
+             */
+            struct polygon_segment {
+
+                int32_t x1;
+                int32_t y1;
+                int32_t x2;
+                int32_t y2;
+
+                /**
+                 * Does a ray from the point (px, py) in the positive x
+                 * direction cross this segment? Uses the usual half-open
+                 * rule so that a ray through a vertex is counted once.
+                 * All calculations are exact.
+                 */
+                bool crossed_by_ray(int64_t px, int64_t py) const noexcept {
+                    if ((y1 > py) == (y2 > py)) {
+                        return false;
+                    }
+                    const int64_t dy = static_cast<int64_t>(y2) - y1;
+                    const int64_t lhs = (px - x1) * dy;
+                    const int64_t rhs = (py - y1) * (static_cast<int64_t>(x2) - x1);
+                    return dy > 0 ? lhs < rhs : lhs > rhs;
+                }
+
+            }; // struct polygon_segment
+
+            /**
+             * Point-in-polygon index for a single (multi)polygon. The
+             * bounding box of the polygon is divided into a grid. Cells
+             * which are not touched by any segment are classified as
+             * completely inside or outside when the index is built, so
+             * looking up a location in these cells is a constant time
+             * operation.
+             *
+             * Consecutive boundary cells in a row of the grid form a run.
+             * Each run knows the segments in it and whether the cell after
+             * it is inside or outside. For a location in a boundary cell,
+             * a ray crossing test is done with only the segments of its
+             * run.
+             */
+            class PolygonGrid {
+
+                enum : uint32_t {
+                    cell_outside  = 0,
+                    cell_inside   = 1,
+                    first_run     = 2, // cells with this or larger values are in run (value - first_run)
+                    cell_boundary = std::numeric_limits<uint32_t>::max() // used while building only
+                };
+
+                enum : int32_t {
+                    max_cells_per_direction = 1024
+                };
+
+                struct run {
+                    // Segments in this run are at [begin, end) in m_run_segments.
+                    uint32_t begin;
+                    uint32_t end;
+                    int32_t row;
+                    int32_t col_begin;
+                    bool inside_after;
+                };
+
+                std::vector<polygon_segment> m_segments;
+                std::vector<run> m_runs;
+                std::vector<uint32_t> m_run_segments;
+                std::vector<uint32_t> m_cells;
+
+                int32_t m_min_x = std::numeric_limits<int32_t>::max();
+                int32_t m_min_y = std::numeric_limits<int32_t>::max();
+                int32_t m_max_x = std::numeric_limits<int32_t>::min();
+                int32_t m_max_y = std::numeric_limits<int32_t>::min();
+                int64_t m_cell_width = 1;
+                int64_t m_cell_height = 1;
+                int32_t m_cols = 0;
+                int32_t m_rows = 0;
+
+                int32_t col(int64_t x) const noexcept {
+                    return static_cast<int32_t>(std::min((x - m_min_x) / m_cell_width, static_cast<int64_t>(m_cols - 1)));
+                }
+
+                int32_t row(int64_t y) const noexcept {
+                    return static_cast<int32_t>(std::min((y - m_min_y) / m_cell_height, static_cast<int64_t>(m_rows - 1)));
+                }
+
+                uint32_t& cell(int32_t r, int32_t c) noexcept {
+                    return m_cells[static_cast<std::size_t>(r) * m_cols + c];
+                }
+
+                bool crossing_test(const run& cell_run, int64_t x, int64_t y) const noexcept {
+                    bool inside = cell_run.inside_after;
+                    for (auto n = cell_run.begin; n < cell_run.end; ++n) {
+                        if (m_segments[m_run_segments[n]].crossed_by_ray(x, y)) {
+                            inside = !inside;
+                        }
+                    }
+                    return inside;
+                }
+
+                void add_ring(const osmium::NodeRefList& ring) {
+                    for (auto it = ring.begin(); it != ring.end() && std::next(it) != ring.end(); ++it) {
+                        const osmium::Location l1 = it->location();
+                        const osmium::Location l2 = std::next(it)->location();
+                        if (!l1.valid() || !l2.valid()) {
+                            throw osmium::invalid_location{"invalid location"};
+                        }
+                        if (l1 != l2) {
+                            m_segments.push_back(polygon_segment{l1.x(), l1.y(), l2.x(), l2.y()});
+                            m_min_x = std::min(m_min_x, std::min(l1.x(), l2.x()));
+                            m_min_y = std::min(m_min_y, std::min(l1.y(), l2.y()));
+                            m_max_x = std::max(m_max_x, std::max(l1.x(), l2.x()));
+                            m_max_y = std::max(m_max_y, std::max(l1.y(), l2.y()));
+                        }
+                    }
+                }
+
+                // Call func(row, first col, last col) for each row with
+                // the range of cells the segment passes through in that
+                // row. To be safe from rounding errors, the range is one
+                // cell larger on each side.
+                template <typename TFunc>
+                void for_each_cell_range(const polygon_segment& segment, TFunc&& func) const {
+                    const int32_t row_begin = row(std::min(segment.y1, segment.y2));
+                    const int32_t row_end = row(std::max(segment.y1, segment.y2));
+                    for (int32_t r = row_begin; r <= row_end; ++r) {
+                        int64_t x_from = std::min(segment.x1, segment.x2);
+                        int64_t x_to = std::max(segment.x1, segment.x2);
+                        if (row_begin != row_end) {
+                            const double y_bottom = std::max(static_cast<double>(m_min_y) + static_cast<double>(r) * m_cell_height, static_cast<double>(std::min(segment.y1, segment.y2)));
+                            const double y_top = std::min(static_cast<double>(m_min_y) + static_cast<double>(r + 1) * m_cell_height, static_cast<double>(std::max(segment.y1, segment.y2)));
+                            const double slope = static_cast<double>(static_cast<int64_t>(segment.x2) - segment.x1) / static_cast<double>(static_cast<int64_t>(segment.y2) - segment.y1);
+                            const double xa = segment.x1 + (y_bottom - segment.y1) * slope;
+                            const double xb = segment.x1 + (y_top - segment.y1) * slope;
+                            x_from = std::max(x_from, static_cast<int64_t>(std::floor(std::min(xa, xb))));
+                            x_to = std::min(x_to, static_cast<int64_t>(std::ceil(std::max(xa, xb))));
+                        }
+                        func(r, std::max(col(x_from) - 1, 0), std::min(col(x_to) + 1, m_cols - 1));
+                    }
+                }
+
+                void mark_boundary_cells() {
+                    for (const auto& segment : m_segments) {
+                        for_each_cell_range(segment, [this](int32_t r, int32_t col_begin, int32_t col_end) {
+                            for (int32_t c = col_begin; c <= col_end; ++c) {
+                                cell(r, c) = cell_boundary;
+                            }
+                        });
+                    }
+                }
+
+                void build_runs() {
+                    for (int32_t r = 0; r < m_rows; ++r) {
+                        for (int32_t c = 0; c < m_cols; ++c) {
+                            if (cell(r, c) == cell_boundary) {
+                                if (c == 0 || cell(r, c - 1) < first_run) {
+                                    m_runs.push_back(run{0, 0, r, c, false});
+                                }
+                                cell(r, c) = first_run + static_cast<uint32_t>(m_runs.size() - 1);
+                            }
+                        }
+                    }
+
+                    // Horizontal segments are never crossed by a ray, so
+                    // they are not needed in the runs.
+                    std::vector<uint32_t> counts(m_runs.size() + 1, 0);
+                    for (const auto& segment : m_segments) {
+                        if (segment.y1 != segment.y2) {
+                            for_each_cell_range(segment, [&](int32_t r, int32_t col_begin, int32_t /*col_end*/) {
+                                ++counts[cell(r, col_begin) - first_run + 1];
+                            });
+                        }
+                    }
+                    for (std::size_t n = 1; n < counts.size(); ++n) {
+                        counts[n] += counts[n - 1];
+                    }
+                    for (std::size_t n = 0; n < m_runs.size(); ++n) {
+                        m_runs[n].begin = counts[n];
+                        m_runs[n].end = counts[n + 1];
+                    }
+                    m_run_segments.resize(counts.back());
+                    for (uint32_t n = 0; n < m_segments.size(); ++n) {
+                        const auto& segment = m_segments[n];
+                        if (segment.y1 != segment.y2) {
+                            for_each_cell_range(segment, [&](int32_t r, int32_t col_begin, int32_t /*col_end*/) {
+                                m_run_segments[counts[cell(r, col_begin) - first_run]++] = n;
+                            });
+                        }
+                    }
+                }
+
+                // Go through each row from right to left, everything to
+                // the right of the grid is outside. All cells between two
+                // runs are either inside or outside. Whether this changes
+                // at a run is found by counting how often the segments of
+                // the run cross a line through the middle of the row.
+                void classify_cells() {
+                    for (int32_t r = 0; r < m_rows; ++r) {
+                        const int64_t y = m_min_y + r * m_cell_height + m_cell_height / 2;
+                        bool inside = false;
+                        for (int32_t c = m_cols - 1; c >= 0; --c) {
+                            auto& value = cell(r, c);
+                            if (value < first_run) {
+                                value = inside ? cell_inside : cell_outside;
+                                continue;
+                            }
+                            auto& cell_run = m_runs[value - first_run];
+                            if (cell_run.col_begin == c) {
+                                cell_run.inside_after = inside;
+                                inside = crossing_test(cell_run, m_min_x + c * m_cell_width - 1, y);
+                            }
+                        }
+                    }
+                }
+
+            public:
+
+                /**
+                 * Build index from the rings of the area.
+                 *
+                 * @throws osmium::invalid_location if any of the locations
+                 *         in the area is invalid.
+                 */
+                explicit PolygonGrid(const osmium::Area& area) {
+                    for (const auto& ring : area.outer_rings()) {
+                        add_ring(ring);
+                        for (const auto& inner_ring : area.inner_rings(ring)) {
+                            add_ring(inner_ring);
+                        }
+                    }
+
+                    if (m_segments.empty()) {
+                        return;
+                    }
+
+                    const int64_t width = static_cast<int64_t>(m_max_x) - m_min_x + 1;
+                    const int64_t height = static_cast<int64_t>(m_max_y) - m_min_y + 1;
+
+                    // Aim for a few segments per boundary cell.
+                    const auto cells_per_direction = static_cast<int64_t>(std::sqrt(static_cast<double>(m_segments.size())) * 2) + 1;
+                    m_cols = static_cast<int32_t>(std::min(std::min(cells_per_direction, width), static_cast<int64_t>(max_cells_per_direction)));
+                    m_rows = static_cast<int32_t>(std::min(std::min(cells_per_direction, height), static_cast<int64_t>(max_cells_per_direction)));
+                    m_cell_width = (width + m_cols - 1) / m_cols;
+                    m_cell_height = (height + m_rows - 1) / m_rows;
+
+                    m_cells.assign(static_cast<std::size_t>(m_cols) * m_rows, cell_outside);
+                    mark_boundary_cells();
+                    build_runs();
+                    classify_cells();
+                }
+
+                /// Is this polygon empty, ie. did the area have no rings?
+                bool empty() const noexcept {
+                    return m_segments.empty();
+                }
+
+                int32_t min_x() const noexcept {
+                    return m_min_x;
+                }
+
+                int32_t min_y() const noexcept {
+                    return m_min_y;
+                }
+
+                int32_t max_x() const noexcept {
+                    return m_max_x;
+                }
+
+                int32_t max_y() const noexcept {
+                    return m_max_y;
+                }
+
+                /**
+                 * Is the location inside the polygon? Locations exactly
+                 * on the boundary might be reported as inside or outside.
+                 *
+                 * @pre @code location.valid() @endcode
+                 */
+                bool contains(const osmium::Location& location) const noexcept {
+                    const int32_t x = location.x();
+                    const int32_t y = location.y();
+                    if (x < m_min_x || x > m_max_x || y < m_min_y || y > m_max_y) {
+                        return false;
+                    }
+
+                    const uint32_t value = m_cells[static_cast<std::size_t>(row(y)) * m_cols + col(x)];
+                    if (value < first_run) {
+                        return value == cell_inside;
+                    }
+                    return crossing_test(m_runs[value - first_run], x, y);
+                }
+
+            }; // class PolygonGrid
+
+        } // namespace detail
+
+        /**
+         * A spatial index answering the question which of a set of
+         * polygons contain a location. The polygons are built from
+         * osmium::Area objects, no external geometry library is used,
+         * and all tests are done on the fixed-point coordinates of the
+         * locations.
+         *
+         * Each polygon gets its own grid index, see detail::PolygonGrid.
+         * A global grid with one cell per degree is used to find the
+         * polygons that might contain a location.
+         */
+        class PolygonIndex {
+
+            enum : int32_t {
+                global_cols = 360,
+                global_rows = 180
+            };
+
+            std::vector<detail::PolygonGrid> m_polygons;
+            std::vector<std::vector<uint32_t>> m_global_cells;
+
+            static int32_t global_col(int32_t x) noexcept {
+                return std::min((static_cast<int64_t>(x) + 180 * static_cast<int64_t>(osmium::detail::coordinate_precision)) / osmium::detail::coordinate_precision, static_cast<int64_t>(global_cols - 1));
+            }
+
+            static int32_t global_row(int32_t y) noexcept {
+                return std::min((static_cast<int64_t>(y) + 90 * static_cast<int64_t>(osmium::detail::coordinate_precision)) / osmium::detail::coordinate_precision, static_cast<int64_t>(global_rows - 1));
+            }
+
+        public:
+
+            PolygonIndex() :
+                m_global_cells(static_cast<std::size_t>(global_cols) * global_rows) {
+            }
+
+            /**
+             * Add the polygon(s) of the area to the index.
+             *
+             * @returns The id of the new polygon. Polygons are numbered
+             *          consecutively from 0 in the order they are added.
+             * @throws osmium::invalid_location if any of the locations
+             *         in the area is invalid.
+             */
+            std::size_t add(const osmium::Area& area) {
+                const auto id = static_cast<uint32_t>(m_polygons.size());
+                m_polygons.emplace_back(area);
+
+                const auto& polygon = m_polygons.back();
+                if (!polygon.empty()) {
+                    const int32_t col_end = global_col(polygon.max_x());
+                    const int32_t row_end = global_row(polygon.max_y());
+                    for (int32_t r = global_row(polygon.min_y()); r <= row_end; ++r) {
+                        for (int32_t c = global_col(polygon.min_x()); c <= col_end; ++c) {
+                            m_global_cells[static_cast<std::size_t>(r) * global_cols + c].push_back(id);
+                        }
+                    }
+                }
+
+                return id;
+            }
+
+            /// The number of polygons in the index.
+            std::size_t size() const noexcept {
+                return m_polygons.size();
+            }
+
+            /**
+             * Does the polygon with the specified id contain the location?
+             * Invalid locations are never contained in any polygon.
+             */
+            bool contains(std::size_t id, const osmium::Location& location) const noexcept {
+                return location.valid() && m_polygons[id].contains(location);
+            }
+
+            /**
+             * Call func with the id of every polygon containing the
+             * location in order of the ids. Invalid locations are never
+             * contained in any polygon.
+             */
+            template <typename TFunc>
+            void for_each_containing(const osmium::Location& location, TFunc&& func) const {
+                if (!location.valid()) {
+                    return;
+                }
+                const auto& cell = m_global_cells[static_cast<std::size_t>(global_row(location.y())) * global_cols + global_col(location.x())];
+                for (const auto id : cell) {
+                    if (m_polygons[id].contains(location)) {
+                        func(static_cast<std::size_t>(id));
+                    }
+                }
+            }
+
+        }; // class PolygonIndex
+
+    } // namespace area
+
+} // namespace osmium
+
+#endif // OSMIUM_AREA_POLYGON_INDEX_HPP
@@ -45,6 +45,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/area/problem_reporter.hpp>
 #include <osmium/geom/factory.hpp>
 #include <osmium/geom/ogr.hpp>
+#include <osmium/geom/ogr_batch_writer.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node_ref.hpp>
@@ -55,6 +56,7 @@ DEALINGS IN THE SOFTWARE.
 #include <gdalcpp.hpp>
 
 #include <memory>
+#include <utility>
 
 namespace osmium {
 
@@ -63,6 +65,11 @@ namespace osmium {
         /**
          * Report problems when assembling areas by adding them to
          * layers in an OGR datasource.
+         *
+         * By default each problem is written immediately. Set an
+         * OGRBatchWriter with set_batch_writer() to write them in batches
+         * inside transactions, which is much faster with most database
+         * drivers.
          */
         class ProblemReporterOGR : public ProblemReporter {
 
@@ -72,7 +79,19 @@ namespace osmium {
             gdalcpp::Layer m_layer_lerror;
             gdalcpp::Layer m_layer_ways;
 
-            void set_object(gdalcpp::Feature& feature) {
+            osmium::geom::OGRBatchWriter* m_batch_writer = nullptr;
+
+            using feature_type = osmium::geom::OGRBatchWriter::Feature;
+
+            void add_feature(feature_type&& feature) {
+                if (m_batch_writer) {
+                    m_batch_writer->add(std::move(feature));
+                } else {
+                    feature.add_to_layer();
+                }
+            }
+
+            void set_object(feature_type& feature) {
                 const char t[2] = {osmium::item_type_to_char(m_object_type), '\0'};
                 feature.set_field("obj_type", t);
                 feature.set_field("obj_id", int32_t(m_object_id));
@@ -80,12 +99,12 @@ namespace osmium {
             }
 
             void write_point(const char* problem_type, osmium::object_id_type id1, osmium::object_id_type id2, osmium::Location location) {
-                gdalcpp::Feature feature{m_layer_perror, m_ogr_factory.create_point(location)};
+                feature_type feature{m_layer_perror, m_ogr_factory.create_point(location)};
                 set_object(feature);
                 feature.set_field("id1", double(id1));
                 feature.set_field("id2", double(id2));
                 feature.set_field("problem", problem_type);
-                feature.add_to_layer();
+                add_feature(std::move(feature));
             }
 
             void write_line(const char* problem_type, osmium::object_id_type id1, osmium::object_id_type id2, osmium::Location loc1, osmium::Location loc2) {
@@ -93,12 +112,12 @@ namespace osmium {
                 ogr_linestring->addPoint(loc1.lon(), loc1.lat());
                 ogr_linestring->addPoint(loc2.lon(), loc2.lat());
 
-                gdalcpp::Feature feature{m_layer_lerror, std::move(ogr_linestring)};
+                feature_type feature{m_layer_lerror, std::move(ogr_linestring)};
                 set_object(feature);
                 feature.set_field("id1", static_cast<double>(id1));
                 feature.set_field("id2", static_cast<double>(id2));
                 feature.set_field("problem", problem_type);
-                feature.add_to_layer();
+                add_feature(std::move(feature));
             }
 
         public:
@@ -137,6 +156,15 @@ namespace osmium {
                 ;
             }
 
+            /**
+             * Write the problems through this batch writer. It must use the
+             * dataset given to the constructor and outlive this reporter
+             * or be unset (with nullptr) before.
+             */
+            void set_batch_writer(osmium::geom::OGRBatchWriter* batch_writer) noexcept {
+                m_batch_writer = batch_writer;
+            }
+
             void report_duplicate_node(osmium::object_id_type node_id1, osmium::object_id_type node_id2, osmium::Location location) override {
                 write_point("duplicate_node", node_id1, node_id2, location);
             }
@@ -177,12 +205,12 @@ namespace osmium {
                     return;
                 }
                 try {
-                    gdalcpp::Feature feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
+                    feature_type feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
                     set_object(feature);
                     feature.set_field("id1", int32_t(way.id()));
                     feature.set_field("id2", 0);
                     feature.set_field("problem", "way_in_multiple_rings");
-                    feature.add_to_layer();
+                    add_feature(std::move(feature));
                 } catch (const osmium::geometry_error&) {
                     // XXX
                 }
@@ -193,12 +221,12 @@ namespace osmium {
                     return;
                 }
                 try {
-                    gdalcpp::Feature feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
+                    feature_type feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
                     set_object(feature);
                     feature.set_field("id1", int32_t(way.id()));
                     feature.set_field("id2", 0);
                     feature.set_field("problem", "inner_with_same_tags");
-                    feature.add_to_layer();
+                    add_feature(std::move(feature));
                 } catch (const osmium::geometry_error&) {
                     // XXX
                 }
@@ -209,12 +237,12 @@ namespace osmium {
                     return;
                 }
                 try {
-                    gdalcpp::Feature feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
+                    feature_type feature{m_layer_lerror, m_ogr_factory.create_linestring(way)};
                     set_object(feature);
                     feature.set_field("id1", int32_t(way.id()));
                     feature.set_field("id2", 0);
                     feature.set_field("problem", "duplicate_way");
-                    feature.add_to_layer();
+                    add_feature(std::move(feature));
                 } catch (const osmium::geometry_error&) {
                     // XXX
                 }
@@ -230,10 +258,10 @@ namespace osmium {
                     return;
                 }
                 try {
-                    gdalcpp::Feature feature{m_layer_ways, m_ogr_factory.create_linestring(way)};
+                    feature_type feature{m_layer_ways, m_ogr_factory.create_linestring(way)};
                     set_object(feature);
                     feature.set_field("way_id", int32_t(way.id()));
-                    feature.add_to_layer();
+                    add_feature(std::move(feature));
                 } catch (const osmium::geometry_error&) {
                     // XXX
                 }
@@ -45,7 +45,9 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/timestamp.hpp>
 #include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
 
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <ctime>
@@ -945,6 +947,128 @@ namespace osmium {
             return buffer.commit();
         }
 
+        /**
+         * A prototype of an OSM object with fixed attributes, tags and
+         * (for ways and relations) member lists. The layout of the object
+         * in memory is built only once when the template is created, every
+         * add() only copies those bytes into the buffer and patches the id
+         * (and the location for nodes). This is much faster than using a
+         * builder when creating many objects that only differ in their
+         * ids and locations.
+         *
+         * Usually created using make_node_template(), make_way_template(),
+         * or make_relation_template().
+         *
+         * @tparam TObject Type of the object (osmium::Node, osmium::Way,
+         *                 or osmium::Relation).
+         */
+        template <typename TObject>
+        class ObjectTemplate {
+
+            static_assert(std::is_base_of<osmium::OSMObject, TObject>::value, "TObject must be derived from osmium::OSMObject");
+
+            osmium::memory::Buffer m_buffer;
+
+        public:
+
+            /**
+             * Create template from a buffer containing exactly one object
+             * of type TObject.
+             */
+            explicit ObjectTemplate(osmium::memory::Buffer&& buffer) :
+                m_buffer(std::move(buffer)) {
+                assert(m_buffer.committed() > 0);
+                assert(m_buffer.get<TObject>(0).padded_size() == m_buffer.committed());
+            }
+
+            /// The object all copies are made from.
+            const TObject& prototype() const noexcept {
+                return m_buffer.get<TObject>(0);
+            }
+
+            /// Number of bytes each copy of the object uses in a buffer.
+            std::size_t byte_size() const noexcept {
+                return m_buffer.committed();
+            }
+
+            /**
+             * Add a copy of the prototype with the given id to the buffer
+             * and commit it.
+             *
+             * @returns A reference to the new object in the buffer, it can
+             *          be used to patch more attributes. The reference is
+             *          only valid until the buffer grows.
+             */
+            TObject& add(osmium::memory::Buffer& buffer, osmium::object_id_type id) const {
+                auto& object = buffer.add_item(prototype());
+                buffer.commit();
+                object.set_id(id);
+                return object;
+            }
+
+            /**
+             * Add a copy of the prototype with the given id and location
+             * to the buffer and commit it. Only available for nodes.
+             *
+             * @returns A reference to the new node in the buffer. The
+             *          reference is only valid until the buffer grows.
+             */
+            template <typename T = TObject, typename std::enable_if<std::is_same<T, osmium::Node>::value, int>::type = 0>
+            osmium::Node& add(osmium::memory::Buffer& buffer, osmium::object_id_type id, const osmium::Location& location) const {
+                auto& node = add(buffer, id);
+                node.set_location(location);
+                return node;
+            }
+
+        }; // class ObjectTemplate
+
+        namespace detail {
+
+            inline osmium::memory::Buffer template_buffer() {
+                return osmium::memory::Buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            }
+
+        } // namespace detail
+
+        /**
+         * Create a node template from the given attributes. The id and
+         * location set here are used if add() is not given different ones.
+         *
+         * @param args The attributes of the node.
+         */
+        template <typename... TArgs>
+        inline ObjectTemplate<osmium::Node> make_node_template(const TArgs&... args) {
+            auto buffer = detail::template_buffer();
+            add_node(buffer, args...);
+            return ObjectTemplate<osmium::Node>{std::move(buffer)};
+        }
+
+        /**
+         * Create a way template from the given attributes. The number of
+         * way nodes is fixed by the template, their ids can be patched
+         * through the way returned from add().
+         *
+         * @param args The attributes of the way.
+         */
+        template <typename... TArgs>
+        inline ObjectTemplate<osmium::Way> make_way_template(const TArgs&... args) {
+            auto buffer = detail::template_buffer();
+            add_way(buffer, args...);
+            return ObjectTemplate<osmium::Way>{std::move(buffer)};
+        }
+
+        /**
+         * Create a relation template from the given attributes.
+         *
+         * @param args The attributes of the relation.
+         */
+        template <typename... TArgs>
+        inline ObjectTemplate<osmium::Relation> make_relation_template(const TArgs&... args) {
+            auto buffer = detail::template_buffer();
+            add_relation(buffer, args...);
+            return ObjectTemplate<osmium::Relation>{std::move(buffer)};
+        }
+
     } // namespace builder
 
 } // namespace osmium
@@ -0,0 +1,271 @@
+#ifndef OSMIUM_BUILDER_BATCH_BUILDER_HPP
+#define OSMIUM_BUILDER_BATCH_BUILDER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace builder {
+
+        /**
+         * The tags of a batch of objects in flat arrays. The tags of object
+         * n are keys[offsets[n]] to keys[offsets[n + 1] - 1] with the values
+         * at the same positions in values. The offsets array has one more
+         * entry than there are objects.
+         *
+         * A default constructed batch_tags means the objects have no tags.
+         */
+        struct batch_tags {
+
+            const char* const* keys = nullptr;
+            const char* const* values = nullptr;
+            const std::size_t* offsets = nullptr;
+
+            batch_tags() noexcept = default;
+
+            batch_tags(const char* const* k, const char* const* v, const std::size_t* o) noexcept :
+                keys(k),
+                values(v),
+                offsets(o) {
+            }
+
+        }; // struct batch_tags
+
+        namespace detail {
+
+            /// Default for the function setting the attributes of objects.
+            struct batch_no_attributes {
+
+                void operator()(osmium::OSMObject& /*object*/, std::size_t /*n*/) const noexcept {
+                }
+
+            }; // struct batch_no_attributes
+
+            /**
+             * Builds an object with all its sub-items in the space reserved
+             * by one call to reserve_subitems().
+             */
+            template <typename T>
+            class BatchObjectBuilder : public OSMObjectBuilder<BatchObjectBuilder<T>, T> {
+
+            public:
+
+                explicit BatchObjectBuilder(osmium::memory::Buffer& buffer) :
+                    OSMObjectBuilder<BatchObjectBuilder<T>, T>(buffer) {
+                }
+
+                unsigned char* reserve_subitems(std::size_t size) {
+                    unsigned char* data = this->reserve_space(size);
+                    this->add_size(static_cast<osmium::memory::item_size_type>(size));
+                    return data;
+                }
+
+                static unsigned char* write_tags(unsigned char* data, const batch_tags& tags, std::size_t n, const uint32_t* lengths, std::size_t tag_list_size) {
+                    auto* tag_list = new (data) osmium::TagList{};
+                    Builder::add_item_size(*tag_list, static_cast<osmium::memory::item_size_type>(tag_list_size - sizeof(osmium::TagList)));
+                    unsigned char* out = data + sizeof(osmium::TagList);
+                    for (std::size_t t = tags.offsets[n]; t < tags.offsets[n + 1]; ++t) {
+                        std::memcpy(out, tags.keys[t], *lengths);
+                        out += *lengths++;
+                        std::memcpy(out, tags.values[t], *lengths);
+                        out += *lengths++;
+                    }
+                    const auto padded = osmium::memory::padded_length(tag_list_size);
+                    std::memset(out, 0, padded - tag_list_size);
+                    return data + padded;
+                }
+
+                static unsigned char* write_nodes(unsigned char* data, const osmium::object_id_type* refs, std::size_t count) {
+                    auto* node_list = new (data) osmium::WayNodeList{};
+                    Builder::add_item_size(*node_list, static_cast<osmium::memory::item_size_type>(count * sizeof(osmium::NodeRef)));
+                    auto* node_refs = reinterpret_cast<osmium::NodeRef*>(data + sizeof(osmium::WayNodeList));
+                    for (std::size_t i = 0; i < count; ++i) {
+                        new (node_refs + i) osmium::NodeRef{refs[i]};
+                    }
+                    return data + sizeof(osmium::WayNodeList) + count * sizeof(osmium::NodeRef);
+                }
+
+            }; // class BatchObjectBuilder
+
+            /**
+             * Calculate the lengths (including the \0 bytes) of the tag
+             * strings of object n and return the unpadded size of its tag
+             * list or 0 if it has no tags.
+             *
+             * @throws std::length_error If a key or value is too long.
+             */
+            inline std::size_t batch_tag_list_size(const batch_tags& tags, std::size_t n, std::vector<uint32_t>& lengths) {
+                lengths.clear();
+                if (!tags.offsets || tags.offsets[n] == tags.offsets[n + 1]) {
+                    return 0;
+                }
+                std::size_t size = sizeof(osmium::TagList);
+                for (std::size_t t = tags.offsets[n]; t < tags.offsets[n + 1]; ++t) {
+                    const auto key_length = std::strlen(tags.keys[t]);
+                    if (key_length > osmium::max_osm_string_length) {
+                        throw std::length_error{"OSM tag key is too long"};
+                    }
+                    const auto value_length = std::strlen(tags.values[t]);
+                    if (value_length > osmium::max_osm_string_length) {
+                        throw std::length_error{"OSM tag value is too long"};
+                    }
+                    lengths.push_back(static_cast<uint32_t>(key_length + 1));
+                    lengths.push_back(static_cast<uint32_t>(value_length + 1));
+                    size += key_length + value_length + 2;
+                }
+                return size;
+            }
+
+        } // namespace detail
+
+        /**
+         * Add many nodes to a buffer. The sizes of all sub-items of a node
+         * are calculated before it is written in one go, which is much
+         * faster than using the NodeBuilder and TagListBuilder for
+         * generated data. Each node is committed.
+         *
+         * @param buffer The buffer to add the nodes to.
+         * @param count The number of nodes.
+         * @param ids Array with the ids of the nodes.
+         * @param locations Array with the locations of the nodes.
+         * @param tags The tags of the nodes.
+         * @param set_attributes Function called as
+         *        @code set_attributes(osmium::OSMObject&, std::size_t n) @endcode
+         *        to set other attributes of the node n.
+         * @returns The offset of the first node in the buffer.
+         * @throws std::length_error If a tag key or value is too long.
+         * @throws osmium::buffer_is_full If the buffer can not grow.
+         */
+        template <typename TFunc = detail::batch_no_attributes>
+        std::size_t add_nodes(osmium::memory::Buffer& buffer,
+                              std::size_t count,
+                              const osmium::object_id_type* ids,
+                              const osmium::Location* locations,
+                              const batch_tags& tags = batch_tags{},
+                              TFunc&& set_attributes = TFunc{}) {
+            const std::size_t offset = buffer.committed();
+            std::vector<uint32_t> lengths;
+            for (std::size_t n = 0; n < count; ++n) {
+                const auto tag_list_size = detail::batch_tag_list_size(tags, n, lengths);
+                {
+                    detail::BatchObjectBuilder<osmium::Node> builder{buffer};
+                    if (tag_list_size > 0) {
+                        unsigned char* data = builder.reserve_subitems(osmium::memory::padded_length(tag_list_size));
+                        builder.write_tags(data, tags, n, lengths.data(), tag_list_size);
+                    }
+                    auto& node = builder.object();
+                    node.set_id(ids[n]);
+                    node.set_location(locations[n]);
+                    set_attributes(static_cast<osmium::OSMObject&>(node), n);
+                }
+                buffer.commit();
+            }
+            return offset;
+        }
+
+        /**
+         * Add many ways to a buffer. The sizes of all sub-items of a way
+         * are calculated before it is written in one go, which is much
+         * faster than using the WayBuilder, TagListBuilder, and
+         * WayNodeListBuilder for generated data. Each way is committed.
+         *
+         * @param buffer The buffer to add the ways to.
+         * @param count The number of ways.
+         * @param ids Array with the ids of the ways.
+         * @param node_offsets Array with count + 1 entries. The node
+         *        references of way n are node_refs[node_offsets[n]] to
+         *        node_refs[node_offsets[n + 1] - 1].
+         * @param node_refs Array with the node ids of all ways.
+         * @param tags The tags of the ways.
+         * @param set_attributes Function called as
+         *        @code set_attributes(osmium::OSMObject&, std::size_t n) @endcode
+         *        to set other attributes of the way n.
+         * @returns The offset of the first way in the buffer.
+         * @throws std::length_error If a tag key or value is too long.
+         * @throws osmium::buffer_is_full If the buffer can not grow.
+         */
+        template <typename TFunc = detail::batch_no_attributes>
+        std::size_t add_ways(osmium::memory::Buffer& buffer,
+                             std::size_t count,
+                             const osmium::object_id_type* ids,
+                             const std::size_t* node_offsets,
+                             const osmium::object_id_type* node_refs,
+                             const batch_tags& tags = batch_tags{},
+                             TFunc&& set_attributes = TFunc{}) {
+            const std::size_t offset = buffer.committed();
+            std::vector<uint32_t> lengths;
+            for (std::size_t n = 0; n < count; ++n) {
+                const auto tag_list_size = detail::batch_tag_list_size(tags, n, lengths);
+                const auto num_nodes = node_offsets[n + 1] - node_offsets[n];
+                const auto size = osmium::memory::padded_length(tag_list_size) +
+                                  sizeof(osmium::WayNodeList) + num_nodes * sizeof(osmium::NodeRef);
+                {
+                    detail::BatchObjectBuilder<osmium::Way> builder{buffer};
+                    unsigned char* data = builder.reserve_subitems(size);
+                    if (tag_list_size > 0) {
+                        data = builder.write_tags(data, tags, n, lengths.data(), tag_list_size);
+                    }
+                    builder.write_nodes(data, node_refs + node_offsets[n], num_nodes);
+                    auto& way = builder.object();
+                    way.set_id(ids[n]);
+                    set_attributes(static_cast<osmium::OSMObject&>(way), n);
+                }
+                buffer.commit();
+            }
+            return offset;
+        }
+
+    } // namespace builder
+
+} // namespace osmium
+
+#endif // OSMIUM_BUILDER_BATCH_BUILDER_HPP
@@ -134,6 +134,14 @@ namespace osmium {
                 return item().byte_size();
             }
 
+            /**
+             * Add to the size of a sub-item that was written directly into
+             * the space reserved for this builder.
+             */
+            static void add_item_size(osmium::memory::Item& item, osmium::memory::item_size_type size) noexcept {
+                item.add_size(size);
+            }
+
             /**
              * Reserve space for an object of class T in buffer and return
              * pointer to it.
@@ -34,22 +34,53 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
 
 #include <memory>
 #include <utility>
 
 namespace osmium {
 
-    class Node;
-    class Way;
-    class Relation;
-    class Area;
-    class Changeset;
-
     namespace handler {
 
         namespace detail {
 
+            /**
+             * Call the callbacks of the target for all entities in the
+             * buffer. If the callbacks of TTarget are final, they are
+             * called directly and can be inlined.
+             */
+            template <typename TTarget>
+            inline void dispatch_buffer(const osmium::memory::Buffer& buffer, TTarget& target) {
+                for (auto it = buffer.cbegin(); it != buffer.cend(); ++it) {
+                    switch (it->type()) {
+                        case osmium::item_type::node:
+                            target.node(static_cast<const osmium::Node&>(*it));
+                            break;
+                        case osmium::item_type::way:
+                            target.way(static_cast<const osmium::Way&>(*it));
+                            break;
+                        case osmium::item_type::relation:
+                            target.relation(static_cast<const osmium::Relation&>(*it));
+                            break;
+                        case osmium::item_type::area:
+                            target.area(static_cast<const osmium::Area&>(*it));
+                            break;
+                        case osmium::item_type::changeset:
+                            target.changeset(static_cast<const osmium::Changeset&>(*it));
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
             class HandlerWrapperBase {
 
             public:
@@ -82,6 +113,15 @@ namespace osmium {
                 virtual void flush() {
                 }
 
+                /**
+                 * Call the callbacks for all entities in the buffer. The
+                 * wrapper for a concrete handler overrides this with a
+                 * version without virtual calls for each entity.
+                 */
+                virtual void handle_buffer(const osmium::memory::Buffer& buffer) {
+                    dispatch_buffer(buffer, *this);
+                }
+
             }; // class HandlerWrapperBase
 
 
@@ -150,6 +190,10 @@ auto _name_##_dispatch(THandler& handler, const osmium::_type_& object, long) ->
                     flush_dispatch(m_handler, 0);
                 }
 
+                void handle_buffer(const osmium::memory::Buffer& buffer) final {
+                    dispatch_buffer(buffer, *this);
+                }
+
             }; // class HandlerWrapper
 
         } // namespace detail
@@ -194,10 +238,35 @@ auto _name_##_dispatch(THandler& handler, const osmium::_type_& object, long) ->
                 m_impl->flush();
             }
 
+            /**
+             * Call the callbacks of the handler for all entities in the
+             * buffer. This only needs one virtual call for the whole
+             * buffer instead of one for each entity. The flush() function
+             * is not called.
+             */
+            void handle_buffer(const osmium::memory::Buffer& buffer) {
+                m_impl->handle_buffer(buffer);
+            }
+
         }; // class DynamicHandler
 
     } // namespace handler
 
+    /**
+     * Apply the DynamicHandler to all entities in the buffer and call its
+     * flush() function. This overload of osmium::apply() dispatches to the
+     * handler once for the whole buffer instead of once for each entity.
+     */
+    inline void apply(const osmium::memory::Buffer& buffer, osmium::handler::DynamicHandler& handler) {
+        handler.handle_buffer(buffer);
+        handler.flush();
+    }
+
+    inline void apply(osmium::memory::Buffer& buffer, osmium::handler::DynamicHandler& handler) {
+        handler.handle_buffer(buffer);
+        handler.flush();
+    }
+
 } // namespace osmium
 
 #endif // OSMIUM_DYNAMIC_HANDLER_HPP
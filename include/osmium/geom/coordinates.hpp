@@ -38,6 +38,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <cmath>
 #include <iosfwd>
+#include <iterator>
 #include <limits>
 #include <string>
 
@@ -126,6 +127,35 @@ namespace osmium {
 
         }; // struct coordinates
 
+        namespace detail {
+
+            /**
+             * Convert location to text and append to given string. If the
+             * precision is 7 digits, which is the precision of the
+             * fixed-point values stored in the location, they are written
+             * out directly, which is much faster than going through
+             * double. Otherwise this is the same as converting to
+             * Coordinates and calling append_to_string() on them.
+             *
+             * @throws osmium::invalid_location if the location is invalid.
+             */
+            inline void append_location_to_string(std::string& s, const osmium::Location& location, const char infix, int precision) {
+                if (precision == 7) {
+                    location.as_string(std::back_inserter(s), infix);
+                } else {
+                    const Coordinates xy{location};
+                    xy.append_to_string(s, infix, precision);
+                }
+            }
+
+            inline void append_location_to_string(std::string& s, const osmium::Location& location, const char prefix, const char infix, const char suffix, int precision) {
+                s += prefix;
+                append_location_to_string(s, location, infix, precision);
+                s += suffix;
+            }
+
+        } // namespace detail
+
         /**
          * Check whether two Coordinates are equal. Invalid coordinates are
          * equal to other invalid coordinates but not equal to any valid
@@ -34,6 +34,8 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/simplify.hpp>
+#include <osmium/geom/way_geometry_cache.hpp>
 #include <osmium/memory/collection.hpp>
 #include <osmium/memory/item.hpp>
 #include <osmium/osm/area.hpp>
@@ -48,7 +50,9 @@ DEALINGS IN THE SOFTWARE.
 #include <cstddef>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -141,6 +145,24 @@ namespace osmium {
 
         }; // class IdentityProjection
 
+        namespace detail {
+
+            /**
+             * The multilinestring type of a geometry factory implementation
+             * or void if the implementation doesn't support multilinestrings.
+             */
+            template <typename TGeomImpl, typename = void>
+            struct multilinestring_type_of {
+                using type = void;
+            };
+
+            template <typename TGeomImpl>
+            struct multilinestring_type_of<TGeomImpl, typename std::conditional<true, void, typename TGeomImpl::multilinestring_type>::type> {
+                using type = typename TGeomImpl::multilinestring_type;
+            };
+
+        } // namespace detail
+
         /**
          * Geometry factory.
          */
@@ -151,17 +173,85 @@ namespace osmium {
              * Add all points of an outer or inner ring to a multipolygon.
              */
             void add_points(const osmium::NodeRefList& nodes) {
-                osmium::Location last_location;
-                for (const osmium::NodeRef& node_ref : nodes) {
-                    if (last_location != node_ref.location()) {
-                        last_location = node_ref.location();
-                        m_impl.multipolygon_add_location(m_projection(last_location));
+                if (m_simplify_tolerance > 0.0) {
+                    for (const auto& location : simplified_locations(nodes.cbegin(), nodes.cend(), use_nodes::unique, 4)) {
+                        m_impl.multipolygon_add_location(project(location));
                     }
+                    return;
                 }
+                fill_multipolygon_ring_unique(nodes.cbegin(), nodes.cend());
             }
 
             TProjection m_projection;
             TGeomImpl m_impl;
+            double m_simplify_tolerance = 0.0;
+            std::vector<osmium::Location> m_simplify_locations;
+            std::vector<bool> m_simplify_keep;
+            WayGeometryCache* m_way_cache = nullptr;
+
+            /**
+             * The cache is only used for projections other than the
+             * IdentityProjection (which doesn't cost anything and where
+             * the implementations get the locations unchanged) and only
+             * if nodes with the same location are removed and the
+             * geometry is not simplified.
+             */
+            bool use_way_cache(use_nodes un) const noexcept {
+                return m_way_cache && !std::is_same<TProjection, IdentityProjection>::value &&
+                       un == use_nodes::unique && m_simplify_tolerance <= 0.0;
+            }
+
+            /**
+             * Collect the locations from the node refs and simplify them.
+             * If the simplified geometry would have fewer than min_points
+             * points, the unsimplified locations are returned instead.
+             * The vectors used are reused between calls, so this does not
+             * allocate memory once they have grown large enough.
+             */
+            template <typename TIter>
+            const std::vector<osmium::Location>& simplified_locations(TIter it, TIter end, use_nodes un, std::size_t min_points) {
+                m_simplify_locations.clear();
+                for (; it != end; ++it) {
+                    const osmium::Location location = it->location();
+                    if (!location.valid()) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+                    if (un == use_nodes::all || m_simplify_locations.empty() || m_simplify_locations.back() != location) {
+                        m_simplify_locations.push_back(location);
+                    }
+                }
+
+                m_simplify_keep.resize(m_simplify_locations.size());
+                const auto num_kept = simplify_douglas_peucker(m_simplify_locations.data(), m_simplify_locations.size(), m_simplify_tolerance, m_simplify_keep.begin());
+                if (num_kept >= min_points) {
+                    std::size_t out = 0;
+                    for (std::size_t n = 0; n < m_simplify_locations.size(); ++n) {
+                        if (m_simplify_keep[n]) {
+                            m_simplify_locations[out++] = m_simplify_locations[n];
+                        }
+                    }
+                    m_simplify_locations.resize(out);
+                }
+
+                return m_simplify_locations;
+            }
+
+            /**
+             * With the IdentityProjection the location is handed to the
+             * implementation unchanged. Implementations that write out
+             * text can then use the fixed-point values in the location
+             * directly instead of going through double. Implementations
+             * that only take Coordinates will convert implicitly.
+             */
+            template <typename T = TProjection, typename std::enable_if<std::is_same<T, IdentityProjection>::value, int>::type = 0>
+            const osmium::Location& project(const osmium::Location& location) const noexcept {
+                return location;
+            }
+
+            template <typename T = TProjection, typename std::enable_if<!std::is_same<T, IdentityProjection>::value, int>::type = 0>
+            Coordinates project(const osmium::Location& location) const {
+                return m_projection(location);
+            }
 
         public:
 
@@ -197,6 +287,9 @@ namespace osmium {
             using multipolygon_type = typename TGeomImpl::multipolygon_type;
             using ring_type         = typename TGeomImpl::ring_type;
 
+            /// void if the implementation doesn't support multilinestrings.
+            using multilinestring_type = typename detail::multilinestring_type_of<TGeomImpl>::type;
+
             int epsg() const noexcept {
                 return m_projection.epsg();
             }
@@ -205,10 +298,44 @@ namespace osmium {
                 return m_projection.proj_string();
             }
 
+            /**
+             * Set the tolerance (in degrees) for simplifying linestrings,
+             * polygons, and multipolygon rings created from ways and areas
+             * with the Douglas-Peucker algorithm. A tolerance of 0 (the
+             * default) disables simplification. Use
+             * simplify_tolerance_for_zoom() to get a tolerance suitable
+             * for a zoom level.
+             *
+             * Rings are only simplified if they still have at least four
+             * points afterwards.
+             */
+            void set_simplify_tolerance(double tolerance) noexcept {
+                m_simplify_tolerance = tolerance;
+            }
+
+            double simplify_tolerance() const noexcept {
+                return m_simplify_tolerance;
+            }
+
+            /**
+             * Use the specified cache for the projected coordinates of
+             * ways in create_linestring() and create_polygon() when they
+             * are called with a Way. Set to nullptr (the default) to not
+             * use a cache. The cache must outlive this factory (or be
+             * unset before) and must not be used with other projections.
+             */
+            void set_way_geometry_cache(WayGeometryCache* cache) noexcept {
+                m_way_cache = cache;
+            }
+
+            WayGeometryCache* way_geometry_cache() const noexcept {
+                return m_way_cache;
+            }
+
             /* Point */
 
             point_type create_point(const osmium::Location& location) const {
-                return m_impl.make_point(m_projection(location));
+                return m_impl.make_point(project(location));
             }
 
             point_type create_point(const osmium::Node& node) {
@@ -239,7 +366,7 @@ namespace osmium {
             size_t fill_linestring(TIter it, TIter end) {
                 size_t num_points = 0;
                 for (; it != end; ++it, ++num_points) {
-                    m_impl.linestring_add_location(m_projection(it->location()));
+                    m_impl.linestring_add_location(project(it->location()));
                 }
                 return num_points;
             }
@@ -251,7 +378,7 @@ namespace osmium {
                 for (; it != end; ++it) {
                     if (last_location != it->location()) {
                         last_location = it->location();
-                        m_impl.linestring_add_location(m_projection(last_location));
+                        m_impl.linestring_add_location(project(last_location));
                         ++num_points;
                     }
                 }
@@ -266,7 +393,14 @@ namespace osmium {
                 linestring_start();
                 size_t num_points = 0;
 
-                if (un == use_nodes::unique) {
+                if (m_simplify_tolerance > 0.0) {
+                    const auto& locations = dir == direction::forward ? simplified_locations(wnl.cbegin(), wnl.cend(), un, 2)
+                                                                      : simplified_locations(wnl.crbegin(), wnl.crend(), un, 2);
+                    for (const auto& location : locations) {
+                        m_impl.linestring_add_location(project(location));
+                    }
+                    num_points = locations.size();
+                } else if (un == use_nodes::unique) {
                     switch (dir) {
                         case direction::forward:
                             num_points = fill_linestring_unique(wnl.cbegin(), wnl.cend());
@@ -295,6 +429,23 @@ namespace osmium {
 
             linestring_type create_linestring(const osmium::Way& way, use_nodes un = use_nodes::unique, direction dir = direction::forward) {
                 try {
+                    if (use_way_cache(un)) {
+                        const auto& coordinates = m_way_cache->get(way, m_projection).coordinates;
+                        if (coordinates.size() < 2) {
+                            throw osmium::geometry_error{"need at least two points for linestring"};
+                        }
+                        linestring_start();
+                        if (dir == direction::forward) {
+                            for (const auto& c : coordinates) {
+                                m_impl.linestring_add_location(c);
+                            }
+                        } else {
+                            for (auto it = coordinates.crbegin(); it != coordinates.crend(); ++it) {
+                                m_impl.linestring_add_location(*it);
+                            }
+                        }
+                        return linestring_finish(coordinates.size());
+                    }
                     return create_linestring(way.nodes(), un, dir);
                 } catch (osmium::geometry_error& e) {
                     e.set_id("way", way.id());
@@ -302,6 +453,73 @@ namespace osmium {
                 }
             }
 
+            /* MultiLineString */
+
+            void multilinestring_start() {
+                m_impl.multilinestring_start();
+            }
+
+            void multilinestring_linestring_start() {
+                m_impl.multilinestring_linestring_start();
+            }
+
+            void multilinestring_linestring_finish() {
+                m_impl.multilinestring_linestring_finish();
+            }
+
+            multilinestring_type multilinestring_finish() {
+                return m_impl.multilinestring_finish();
+            }
+
+            /**
+             * Create a multilinestring from a container of lines. Each line
+             * is a range of objects with a location() member function, for
+             * instance a WayNodeList or a std::vector<osmium::NodeRef>.
+             * Consecutive nodes with the same location are always removed.
+             *
+             * Only available if the implementation supports
+             * multilinestrings (currently WKT, WKB, and GeoJSON).
+             *
+             * @throws osmium::geometry_error If there are no lines or a
+             *         line has less than two points.
+             */
+            template <typename TLines>
+            multilinestring_type create_multilinestring(const TLines& lines) {
+                m_impl.multilinestring_start();
+                std::size_t num_linestrings = 0;
+
+                for (const auto& line : lines) {
+                    m_impl.multilinestring_linestring_start();
+                    std::size_t num_points = 0;
+                    if (m_simplify_tolerance > 0.0) {
+                        for (const auto& location : simplified_locations(line.begin(), line.end(), use_nodes::unique, 2)) {
+                            m_impl.multilinestring_add_location(project(location));
+                            ++num_points;
+                        }
+                    } else {
+                        osmium::Location last_location;
+                        for (const auto& node : line) {
+                            if (last_location != node.location()) {
+                                last_location = node.location();
+                                m_impl.multilinestring_add_location(project(last_location));
+                                ++num_points;
+                            }
+                        }
+                    }
+                    if (num_points < 2) {
+                        throw osmium::geometry_error{"need at least two points for linestring"};
+                    }
+                    m_impl.multilinestring_linestring_finish();
+                    ++num_linestrings;
+                }
+
+                if (num_linestrings == 0) {
+                    throw osmium::geometry_error{"need at least one linestring for multilinestring"};
+                }
+
+                return m_impl.multilinestring_finish();
+            }
+
             /* Polygon */
 
             void polygon_start() {
@@ -312,7 +530,7 @@ namespace osmium {
             size_t fill_polygon(TIter it, TIter end) {
                 size_t num_points = 0;
                 for (; it != end; ++it, ++num_points) {
-                    m_impl.polygon_add_location(m_projection(it->location()));
+                    m_impl.polygon_add_location(project(it->location()));
                 }
                 return num_points;
             }
@@ -324,7 +542,7 @@ namespace osmium {
                 for (; it != end; ++it) {
                     if (last_location != it->location()) {
                         last_location = it->location();
-                        m_impl.polygon_add_location(m_projection(last_location));
+                        m_impl.polygon_add_location(project(last_location));
                         ++num_points;
                     }
                 }
@@ -339,7 +557,14 @@ namespace osmium {
                 polygon_start();
                 size_t num_points = 0;
 
-                if (un == use_nodes::unique) {
+                if (m_simplify_tolerance > 0.0) {
+                    const auto& locations = dir == direction::forward ? simplified_locations(wnl.cbegin(), wnl.cend(), un, 4)
+                                                                      : simplified_locations(wnl.crbegin(), wnl.crend(), un, 4);
+                    for (const auto& location : locations) {
+                        m_impl.polygon_add_location(project(location));
+                    }
+                    num_points = locations.size();
+                } else if (un == use_nodes::unique) {
                     switch (dir) {
                         case direction::forward:
                             num_points = fill_polygon_unique(wnl.cbegin(), wnl.cend());
@@ -368,6 +593,23 @@ namespace osmium {
 
             polygon_type create_polygon(const osmium::Way& way, use_nodes un = use_nodes::unique, direction dir = direction::forward) {
                 try {
+                    if (use_way_cache(un)) {
+                        const auto& coordinates = m_way_cache->get(way, m_projection).coordinates;
+                        if (coordinates.size() < 4) {
+                            throw osmium::geometry_error{"need at least four points for polygon"};
+                        }
+                        polygon_start();
+                        if (dir == direction::forward) {
+                            for (const auto& c : coordinates) {
+                                m_impl.polygon_add_location(c);
+                            }
+                        } else {
+                            for (auto it = coordinates.crbegin(); it != coordinates.crend(); ++it) {
+                                m_impl.polygon_add_location(*it);
+                            }
+                        }
+                        return polygon_finish(coordinates.size());
+                    }
                     return create_polygon(way.nodes(), un, dir);
                 } catch (osmium::geometry_error& e) {
                     e.set_id("way", way.id());
@@ -377,6 +619,49 @@ namespace osmium {
 
             /* MultiPolygon */
 
+            void multipolygon_start() {
+                m_impl.multipolygon_start();
+            }
+
+            void multipolygon_polygon_start() {
+                m_impl.multipolygon_polygon_start();
+            }
+
+            void multipolygon_polygon_finish() {
+                m_impl.multipolygon_polygon_finish();
+            }
+
+            void multipolygon_outer_ring_start() {
+                m_impl.multipolygon_outer_ring_start();
+            }
+
+            void multipolygon_outer_ring_finish() {
+                m_impl.multipolygon_outer_ring_finish();
+            }
+
+            void multipolygon_inner_ring_start() {
+                m_impl.multipolygon_inner_ring_start();
+            }
+
+            void multipolygon_inner_ring_finish() {
+                m_impl.multipolygon_inner_ring_finish();
+            }
+
+            template <typename TIter>
+            void fill_multipolygon_ring_unique(TIter it, TIter end) {
+                osmium::Location last_location;
+                for (; it != end; ++it) {
+                    if (last_location != it->location()) {
+                        last_location = it->location();
+                        m_impl.multipolygon_add_location(project(last_location));
+                    }
+                }
+            }
+
+            multipolygon_type multipolygon_finish() {
+                return m_impl.multipolygon_finish();
+            }
+
             multipolygon_type create_multipolygon(const osmium::Area& area) {
                 try {
                     size_t num_polygons = 0;
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/geom/coordinates.hpp>
 #include <osmium/geom/factory.hpp>
+#include <osmium/osm/tag.hpp>
 
 #include <cassert>
 #include <cstddef>
@@ -50,27 +51,85 @@ namespace osmium {
             class GeoJSONFactoryImpl {
 
                 std::string m_str;
+                std::string* m_output = nullptr;
                 int m_precision;
 
+                std::string& data() noexcept {
+                    return m_output ? *m_output : m_str;
+                }
+
+                void start(const char* str) {
+                    if (m_output) {
+                        *m_output += str;
+                    } else {
+                        m_str = str;
+                    }
+                }
+
+                std::string finish(const char* str) {
+                    assert(!data().empty());
+                    data().back() = ']';
+                    data() += str;
+
+                    if (m_output) {
+                        return std::string{};
+                    }
+
+                    std::string result;
+
+                    using std::swap;
+                    swap(result, m_str);
+
+                    return result;
+                }
+
             public:
 
-                using point_type        = std::string;
-                using linestring_type   = std::string;
-                using polygon_type      = std::string;
-                using multipolygon_type = std::string;
-                using ring_type         = std::string;
+                using point_type           = std::string;
+                using linestring_type      = std::string;
+                using polygon_type         = std::string;
+                using multipolygon_type    = std::string;
+                using ring_type            = std::string;
+                using multilinestring_type = std::string;
 
                 explicit GeoJSONFactoryImpl(int /*srid*/, int precision = 7) :
                     m_precision(precision) {
                 }
 
+                /**
+                 * Create a factory which appends all geometries to the
+                 * output string instead of returning them. The create
+                 * functions return empty strings in this mode. This
+                 * avoids memory allocations per geometry when writing many
+                 * geometries, see also append_geojson_feature().
+                 *
+                 * The output string must outlive the factory. If
+                 * creating a geometry fails with an exception, partial
+                 * data might have been appended to the output.
+                 */
+                GeoJSONFactoryImpl(int /*srid*/, int precision, std::string& output) :
+                    m_output(&output),
+                    m_precision(precision) {
+                }
+
                 /* Point */
 
                 // { "type": "Point", "coordinates": [100.0, 0.0] }
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
-                    std::string str{"{\"type\":\"Point\",\"coordinates\":"};
-                    xy.append_to_string(str, '[', ',', ']', m_precision);
-                    str += "}";
+                    std::string str;
+                    std::string& out = m_output ? *m_output : str;
+                    out += "{\"type\":\"Point\",\"coordinates\":";
+                    xy.append_to_string(out, '[', ',', ']', m_precision);
+                    out += "}";
+                    return str;
+                }
+
+                point_type make_point(const osmium::Location& location) const {
+                    std::string str;
+                    std::string& out = m_output ? *m_output : str;
+                    out += "{\"type\":\"Point\",\"coordinates\":";
+                    append_location_to_string(out, location, '[', ',', ']', m_precision);
+                    out += "}";
                     return str;
                 }
 
@@ -78,95 +137,117 @@ namespace osmium {
 
                 // { "type": "LineString", "coordinates": [ [100.0, 0.0], [101.0, 1.0] ] }
                 void linestring_start() {
-                    m_str = "{\"type\":\"LineString\",\"coordinates\":[";
+                    start("{\"type\":\"LineString\",\"coordinates\":[");
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']', m_precision);
-                    m_str += ',';
+                    xy.append_to_string(data(), '[', ',', ']', m_precision);
+                    data() += ',';
+                }
+
+                void linestring_add_location(const osmium::Location& location) {
+                    append_location_to_string(data(), location, '[', ',', ']', m_precision);
+                    data() += ',';
                 }
 
                 linestring_type linestring_finish(size_t /*num_points*/) {
-                    assert(!m_str.empty());
-                    std::string str;
+                    return finish("}");
+                }
 
-                    using std::swap;
-                    swap(str, m_str);
+                /* MultiLineString */
 
-                    str.back() = ']';
-                    str += "}";
-                    return str;
+                // { "type": "MultiLineString", "coordinates": [ [ [100.0, 0.0], [101.0, 1.0] ], [ [102.0, 2.0], [103.0, 3.0] ] ] }
+                void multilinestring_start() {
+                    start("{\"type\":\"MultiLineString\",\"coordinates\":[");
+                }
+
+                void multilinestring_linestring_start() {
+                    data() += '[';
+                }
+
+                void multilinestring_linestring_finish() {
+                    assert(!data().empty());
+                    data().back() = ']';
+                    data() += ',';
+                }
+
+                void multilinestring_add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(data(), '[', ',', ']', m_precision);
+                    data() += ',';
+                }
+
+                void multilinestring_add_location(const osmium::Location& location) {
+                    append_location_to_string(data(), location, '[', ',', ']', m_precision);
+                    data() += ',';
+                }
+
+                multilinestring_type multilinestring_finish() {
+                    return finish("}");
                 }
 
                 /* Polygon */
                 void polygon_start() {
-                    m_str = "{\"type\":\"Polygon\",\"coordinates\":[[";
+                    start("{\"type\":\"Polygon\",\"coordinates\":[[");
                 }
 
                 void polygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']', m_precision);
-                    m_str += ',';
+                    xy.append_to_string(data(), '[', ',', ']', m_precision);
+                    data() += ',';
                 }
 
-                polygon_type polygon_finish(size_t /*num_points*/) {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
+                void polygon_add_location(const osmium::Location& location) {
+                    append_location_to_string(data(), location, '[', ',', ']', m_precision);
+                    data() += ',';
+                }
 
-                    str.back() = ']';
-                    str += "]}";
-                    return str;
+                polygon_type polygon_finish(size_t /*num_points*/) {
+                    return finish("]}");
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_str = "{\"type\":\"MultiPolygon\",\"coordinates\":[";
+                    start("{\"type\":\"MultiPolygon\",\"coordinates\":[");
                 }
 
                 void multipolygon_polygon_start() {
-                    m_str += '[';
+                    data() += '[';
                 }
 
                 void multipolygon_polygon_finish() {
-                    m_str += "],";
+                    data() += "],";
                 }
 
                 void multipolygon_outer_ring_start() {
-                    m_str += '[';
+                    data() += '[';
                 }
 
                 void multipolygon_outer_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
+                    assert(!data().empty());
+                    data().back() = ']';
                 }
 
                 void multipolygon_inner_ring_start() {
-                    m_str += ",[";
+                    data() += ",[";
                 }
 
                 void multipolygon_inner_ring_finish() {
-                    assert(!m_str.empty());
-                    m_str.back() = ']';
+                    assert(!data().empty());
+                    data().back() = ']';
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    xy.append_to_string(m_str, '[', ',', ']', m_precision);
-                    m_str += ',';
+                    xy.append_to_string(data(), '[', ',', ']', m_precision);
+                    data() += ',';
                 }
 
-                multipolygon_type multipolygon_finish() {
-                    assert(!m_str.empty());
-                    std::string str;
-
-                    using std::swap;
-                    swap(str, m_str);
+                void multipolygon_add_location(const osmium::Location& location) {
+                    append_location_to_string(data(), location, '[', ',', ']', m_precision);
+                    data() += ',';
+                }
 
-                    str.back() = ']';
-                    str += "}";
-                    return str;
+                multipolygon_type multipolygon_finish() {
+                    return finish("}");
                 }
 
             }; // class GeoJSONFactoryImpl
@@ -176,6 +257,87 @@ namespace osmium {
         template <typename TProjection = IdentityProjection>
         using GeoJSONFactory = GeometryFactory<osmium::geom::detail::GeoJSONFactoryImpl, TProjection>;
 
+        namespace detail {
+
+            /**
+             * Append str to out as JSON string including the quotes.
+             */
+            inline void append_json_string(std::string& out, const char* str) {
+                static const char* lookup_hex = "0123456789abcdef";
+                out += '"';
+                for (; *str != '\0'; ++str) {
+                    const auto c = static_cast<unsigned char>(*str);
+                    if (c == '"' || c == '\\') {
+                        out += '\\';
+                        out += *str;
+                    } else if (c < 0x20U) {
+                        switch (c) {
+                            case '\n':
+                                out += "\\n";
+                                break;
+                            case '\r':
+                                out += "\\r";
+                                break;
+                            case '\t':
+                                out += "\\t";
+                                break;
+                            default:
+                                out += "\\u00";
+                                out += lookup_hex[c >> 4U];
+                                out += lookup_hex[c & 0xfU];
+                        }
+                    } else {
+                        out += *str;
+                    }
+                }
+                out += '"';
+            }
+
+        } // namespace detail
+
+        /**
+         * Append the tags as GeoJSON "properties" object, i.e. a JSON
+         * object with the keys and values of the tags, to the string.
+         */
+        inline void append_geojson_properties(std::string& out, const osmium::TagList& tags) {
+            out += '{';
+            for (const auto& tag : tags) {
+                detail::append_json_string(out, tag.key());
+                out += ':';
+                detail::append_json_string(out, tag.value());
+                out += ',';
+            }
+            if (out.back() == ',') {
+                out.back() = '}';
+            } else {
+                out += '}';
+            }
+        }
+
+        /**
+         * Append a GeoJSON Feature with the given tags as properties to
+         * the string. The geometry is added by calling add_geometry(),
+         * usually with a GeoJSONFactory writing to the same string:
+         *
+         * @code
+         * std::string out;
+         * osmium::geom::GeoJSONFactory<> factory{7, out};
+         * ...
+         * osmium::geom::append_geojson_feature(out, node.tags(), [&]() {
+         *     factory.create_point(node);
+         * });
+         * out += '\n';
+         * @endcode
+         */
+        template <typename TFunc>
+        inline void append_geojson_feature(std::string& out, const osmium::TagList& tags, TFunc&& add_geometry) {
+            out += "{\"type\":\"Feature\",\"geometry\":";
+            std::forward<TFunc>(add_geometry)();
+            out += ",\"properties\":";
+            append_geojson_properties(out, tags);
+            out += '}';
+        }
+
     } // namespace geom
 
 } // namespace osmium
@@ -57,6 +57,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/util/compatibility.hpp>
 
 #include <geos/geom/Coordinate.h>
+#include <geos/geom/Envelope.h>
 #include <geos/geom/CoordinateSequence.h>
 #include <geos/geom/CoordinateSequenceFactory.h>
 #include <geos/geom/GeometryFactory.h>
@@ -65,6 +66,8 @@ DEALINGS IN THE SOFTWARE.
 #include <geos/geom/Point.h>
 #include <geos/geom/Polygon.h>
 #include <geos/geom/PrecisionModel.h>
+#include <geos/geom/prep/PreparedGeometry.h>
+#include <geos/geom/prep/PreparedGeometryFactory.h>
 #include <geos/util/GEOSException.h>
 
 #include <algorithm>
@@ -260,6 +263,109 @@ namespace osmium {
         template <typename TProjection = IdentityProjection>
         using GEOSFactory = GeometryFactory<osmium::geom::detail::GEOSFactoryImpl, TProjection>;
 
+        /**
+         * Returns a GEOS geometry factory for the current thread. It can
+         * be handed to the GEOSFactory constructor so that not every
+         * GEOSFactory creates its own GEOS factory and precision model.
+         *
+         * @deprecated
+         */
+        inline geos::geom::GeometryFactory& thread_geos_factory() {
+            static thread_local geos::geom::PrecisionModel precision_model;
+            static thread_local geos::geom::GeometryFactory geos_factory{&precision_model};
+            return geos_factory;
+        }
+
+        /**
+         * A GEOS geometry, usually a (multi)polygon, prepared for fast
+         * repeated point-in-polygon and intersects tests, for instance
+         * for extracts. Locations outside the bounding box of the
+         * geometry are rejected without calling into GEOS.
+         *
+         * The geometry must have been created with a GEOS factory that
+         * lives at least as long as this object. Because GEOS builds
+         * its indexes lazily, one object must not be used from several
+         * threads at the same time.
+         *
+         * @deprecated
+         */
+        class GEOSPreparedGeometry {
+
+            struct prepared_deleter {
+                void operator()(const geos::geom::prep::PreparedGeometry* prepared) const {
+                    geos::geom::prep::PreparedGeometryFactory::destroy(prepared);
+                }
+            };
+
+            std::unique_ptr<geos::geom::Geometry> m_geometry;
+            std::unique_ptr<const geos::geom::prep::PreparedGeometry, prepared_deleter> m_prepared;
+            geos::geom::Envelope m_envelope;
+
+        public:
+
+            /**
+             * Prepare the geometry. Takes ownership of it.
+             *
+             * @throws geos_geometry_error if GEOS fails.
+             */
+            template <typename TGeometry>
+            explicit GEOSPreparedGeometry(std::unique_ptr<TGeometry>&& geometry) :
+                m_geometry(std::move(geometry)) {
+                assert(m_geometry);
+                try {
+                    m_prepared.reset(geos::geom::prep::PreparedGeometryFactory::prepare(m_geometry.get()));
+                    m_envelope = *m_geometry->getEnvelopeInternal();
+                } catch (const geos::util::GEOSException& e) {
+                    THROW(osmium::geos_geometry_error(e.what()));
+                }
+            }
+
+            const geos::geom::Geometry& geometry() const noexcept {
+                return *m_geometry;
+            }
+
+            /**
+             * Does the geometry contain the point with these coordinates?
+             * Points on the boundary are not contained.
+             */
+            bool contains(const osmium::geom::Coordinates& xy) const {
+                if (!m_envelope.contains(xy.x, xy.y)) {
+                    return false;
+                }
+                try {
+                    const std::unique_ptr<geos::geom::Point> point{m_geometry->getFactory()->createPoint(geos::geom::Coordinate{xy.x, xy.y})};
+                    return m_prepared->contains(point.get());
+                } catch (const geos::util::GEOSException& e) {
+                    THROW(osmium::geos_geometry_error(e.what()));
+                }
+            }
+
+            /// Does the geometry contain the other geometry?
+            bool contains(const geos::geom::Geometry& other) const {
+                if (!m_envelope.contains(other.getEnvelopeInternal())) {
+                    return false;
+                }
+                try {
+                    return m_prepared->contains(&other);
+                } catch (const geos::util::GEOSException& e) {
+                    THROW(osmium::geos_geometry_error(e.what()));
+                }
+            }
+
+            /// Does the geometry intersect the other geometry?
+            bool intersects(const geos::geom::Geometry& other) const {
+                if (!m_envelope.intersects(other.getEnvelopeInternal())) {
+                    return false;
+                }
+                try {
+                    return m_prepared->intersects(&other);
+                } catch (const geos::util::GEOSException& e) {
+                    THROW(osmium::geos_geometry_error(e.what()));
+                }
+            }
+
+        }; // class GEOSPreparedGeometry
+
     } // namespace geom
 
 } // namespace osmium
@@ -39,7 +39,6 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/way.hpp>
 
 #include <cmath>
-#include <iterator>
 
 namespace osmium {
 
@@ -58,30 +57,56 @@ namespace osmium {
             /// @brief Earth's quadratic mean radius for WGS84
             constexpr const double EARTH_RADIUS_IN_METERS = 6372797.560856;
 
+            namespace detail {
+
+                // The haversine formula with the product of the cosines
+                // of both latitudes already calculated.
+                inline double distance(const osmium::geom::Coordinates& c1, const osmium::geom::Coordinates& c2, double cos_product) {
+                    double lonh = sin(deg_to_rad(c1.x - c2.x) * 0.5);
+                    lonh *= lonh;
+                    double lath = sin(deg_to_rad(c1.y - c2.y) * 0.5);
+                    lath *= lath;
+                    return 2.0 * EARTH_RADIUS_IN_METERS * asin(sqrt(lath + cos_product * lonh));
+                }
+
+            } // namespace detail
+
             /**
              * Calculate distance in meters between two sets of coordinates.
              *
              * @pre @code c1.valid() && c2.valid() @endcode
              */
             inline double distance(const osmium::geom::Coordinates& c1, const osmium::geom::Coordinates& c2) {
-                double lonh = sin(deg_to_rad(c1.x - c2.x) * 0.5);
-                lonh *= lonh;
-                double lath = sin(deg_to_rad(c1.y - c2.y) * 0.5);
-                lath *= lath;
-                const double tmp = cos(deg_to_rad(c1.y)) * cos(deg_to_rad(c2.y));
-                return 2.0 * EARTH_RADIUS_IN_METERS * asin(sqrt(lath + tmp * lonh));
+                return detail::distance(c1, c2, cos(deg_to_rad(c1.y)) * cos(deg_to_rad(c2.y)));
             }
 
             /**
              * Calculate length of way.
+             *
+             * Each location is converted and the cosine of its latitude
+             * calculated only once, not once for each of the two segments
+             * it belongs to.
+             *
+             * @throws osmium::invalid_location if the way has at least two
+             *         nodes and any of the locations is invalid.
              */
             inline double distance(const osmium::WayNodeList& wnl) {
+                if (wnl.size() < 2) {
+                    return 0.0;
+                }
+
                 double sum_length = 0;
 
-                for (auto it = wnl.begin(); it != wnl.end(); ++it) {
-                    if (std::next(it) != wnl.end()) {
-                        sum_length += distance(it->location(), std::next(it)->location());
-                    }
+                auto it = wnl.begin();
+                osmium::geom::Coordinates c1{it->location()};
+                double cos1 = cos(deg_to_rad(c1.y));
+
+                for (++it; it != wnl.end(); ++it) {
+                    const osmium::geom::Coordinates c2{it->location()};
+                    const double cos2 = cos(deg_to_rad(c2.y));
+                    sum_length += detail::distance(c1, c2, cos1 * cos2);
+                    c1 = c2;
+                    cos1 = cos2;
                 }
 
                 return sum_length;
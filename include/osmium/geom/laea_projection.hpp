@@ -0,0 +1,175 @@
+#ifndef OSMIUM_GEOM_LAEA_PROJECTION_HPP
+#define OSMIUM_GEOM_LAEA_PROJECTION_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * This file contains an Osmium-internal implementation of the Lambert
+ * Azimuthal Equal Area projection. It does not need the proj library.
+ */
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/util.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            /**
+             * Lambert Azimuthal Equal Area projection (oblique aspect)
+             * on an ellipsoid. Uses the closed formulas from the EPSG
+             * Guidance Note 7-2.
+             */
+            class lambert_azimuthal_equal_area {
+
+                double m_e;
+                double m_one_minus_e2;
+                double m_qp;
+                double m_lon0;
+                double m_sin_beta0;
+                double m_cos_beta0;
+                double m_rq;
+                double m_d;
+                double m_false_easting;
+                double m_false_northing;
+
+                double q(double sin_lat) const noexcept {
+                    const double e_sin_lat = m_e * sin_lat;
+                    return m_one_minus_e2 * (sin_lat / (1.0 - e_sin_lat * e_sin_lat) -
+                                             std::log((1.0 - e_sin_lat) / (1.0 + e_sin_lat)) / (2.0 * m_e));
+                }
+
+            public:
+
+                /**
+                 * @param a Semi-major axis of the ellipsoid.
+                 * @param inverse_flattening Inverse flattening of the ellipsoid.
+                 * @param lon0 Longitude of the natural origin (degrees).
+                 * @param lat0 Latitude of the natural origin (degrees).
+                 * @param false_easting False easting.
+                 * @param false_northing False northing.
+                 */
+                lambert_azimuthal_equal_area(double a, double inverse_flattening, double lon0, double lat0, double false_easting, double false_northing) noexcept :
+                    m_lon0(deg_to_rad(lon0)),
+                    m_false_easting(false_easting),
+                    m_false_northing(false_northing) {
+                    const double f = 1.0 / inverse_flattening;
+                    const double e2 = f * (2.0 - f);
+                    m_e = std::sqrt(e2);
+                    m_one_minus_e2 = 1.0 - e2;
+                    m_qp = q(1.0);
+
+                    const double sin_lat0 = std::sin(deg_to_rad(lat0));
+                    const double cos_lat0 = std::cos(deg_to_rad(lat0));
+                    const double beta0 = std::asin(q(sin_lat0) / m_qp);
+                    m_sin_beta0 = std::sin(beta0);
+                    m_cos_beta0 = std::cos(beta0);
+                    m_rq = a * std::sqrt(m_qp / 2.0);
+                    m_d = a * (cos_lat0 / std::sqrt(1.0 - e2 * sin_lat0 * sin_lat0)) / (m_rq * m_cos_beta0);
+                }
+
+                Coordinates operator()(double lon, double lat) const noexcept {
+                    const double beta = std::asin(q(std::sin(deg_to_rad(lat))) / m_qp);
+                    const double sin_beta = std::sin(beta);
+                    const double cos_beta = std::cos(beta);
+                    const double dlon = deg_to_rad(lon) - m_lon0;
+                    const double cos_dlon = std::cos(dlon);
+                    const double b = m_rq * std::sqrt(2.0 / (1.0 + m_sin_beta0 * sin_beta + m_cos_beta0 * cos_beta * cos_dlon));
+
+                    return Coordinates{m_false_easting + b * m_d * cos_beta * std::sin(dlon),
+                                       m_false_northing + (b / m_d) * (m_cos_beta0 * sin_beta - m_sin_beta0 * cos_beta * cos_dlon)};
+                }
+
+            }; // class lambert_azimuthal_equal_area
+
+        } // namespace detail
+
+        /**
+         * Functor that does projection from WGS84 (EPSG:4326) to the
+         * "ETRS89 / LAEA Europe" projection (EPSG:3035). The ETRS89
+         * datum is treated as identical to WGS84 (which is what the proj
+         * library does, too).
+         */
+        class LAEAEuropeProjection {
+
+            detail::lambert_azimuthal_equal_area m_laea{6378137.0, 298.257222101, 10.0, 52.0, 4321000.0, 3210000.0};
+
+        public:
+
+            // Not "= default", see MercatorProjection.
+            LAEAEuropeProjection() { // NOLINT(hicpp-use-equals-default, modernize-use-equals-default)
+            }
+
+            Coordinates operator()(osmium::Location location) const {
+                return m_laea(location.lon(), location.lat());
+            }
+
+            /**
+             * Project count locations into the coordinates array. This
+             * gives the same results as calling operator() for each
+             * location.
+             *
+             * @throws invalid_location if any of the locations is invalid.
+             *         The output array is undefined in this case.
+             */
+            void project_many(const osmium::Location* locations, const std::size_t count, Coordinates* coordinates) const {
+                for (std::size_t n = 0; n < count; ++n) {
+                    coordinates[n] = operator()(locations[n]);
+                }
+            }
+
+            int epsg() const noexcept {
+                return 3035;
+            }
+
+            std::string proj_string() const {
+                return "+proj=laea +lat_0=52 +lon_0=10 +x_0=4321000 +y_0=3210000 +ellps=GRS80 +towgs84=0,0,0,0,0,0,0 +units=m +no_defs";
+            }
+
+        }; // class LAEAEuropeProjection
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_LAEA_PROJECTION_HPP
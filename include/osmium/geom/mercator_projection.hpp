@@ -38,6 +38,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/location.hpp>
 
 #include <cmath>
+#include <cstddef>
 #include <string>
 
 namespace osmium {
@@ -63,14 +64,9 @@ namespace osmium {
             }
 #else
 
-            // This is a much faster implementation than the canonical
-            // implementation using the tan() function. For details
-            // see https://github.com/osmcode/mercator-projection .
-            inline double lat_to_y(double lat) { // not constexpr because math functions aren't
-                if (lat < -78.0 || lat > 78.0) {
-                    return lat_to_y_with_tan(lat);
-                }
-
+            // The rational polynomial used by lat_to_y(). It is only
+            // accurate for latitudes between -78 and 78 degrees.
+            constexpr inline double lat_to_y_polynomial(double lat) {
                 return earth_radius_for_epsg3857 *
                     ((((((((((-3.1112583378460085319e-23  * lat +
                                2.0465852743943268009e-19) * lat +
@@ -94,6 +90,17 @@ namespace osmium {
                               -3.4554675198786337842e-4)  * lat +
                               -5.4367203601085991108e-4)  * lat + 1.0);
             }
+
+            // This is a much faster implementation than the canonical
+            // implementation using the tan() function. For details
+            // see https://github.com/osmcode/mercator-projection .
+            inline double lat_to_y(double lat) { // not constexpr because math functions aren't
+                if (lat < -78.0 || lat > 78.0) {
+                    return lat_to_y_with_tan(lat);
+                }
+
+                return lat_to_y_polynomial(lat);
+            }
 #endif
 
             constexpr inline double x_to_lon(double x) {
@@ -149,6 +156,43 @@ namespace osmium {
                 return Coordinates{detail::lon_to_x(location.lon()), detail::lat_to_y(location.lat())};
             }
 
+            /**
+             * Project count locations into the coordinates array. This
+             * gives the same results as calling operator() for each
+             * location, but is faster for many locations: The main loop
+             * has no branches or function calls, so the compiler can
+             * vectorize it. Latitudes outside the range of the fast
+             * polynomial approximation are fixed up afterwards.
+             *
+             * @param locations Pointer to the first location.
+             * @param count Number of locations.
+             * @param coordinates Pointer to the output array which must
+             *                    have space for count coordinates.
+             * @throws invalid_location if any of the locations is invalid.
+             *         The output array is undefined in this case.
+             */
+            void project_many(const osmium::Location* locations, const std::size_t count, Coordinates* coordinates) const {
+#ifdef OSMIUM_USE_SLOW_MERCATOR_PROJECTION
+                for (std::size_t n = 0; n < count; ++n) {
+                    coordinates[n] = operator()(locations[n]);
+                }
+#else
+                for (std::size_t n = 0; n < count; ++n) {
+                    coordinates[n].x = detail::lon_to_x(locations[n].lon_without_check());
+                    coordinates[n].y = detail::lat_to_y_polynomial(locations[n].lat_without_check());
+                }
+                for (std::size_t n = 0; n < count; ++n) {
+                    if (!locations[n].valid()) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+                    const double lat = locations[n].lat_without_check();
+                    if (lat < -78.0 || lat > 78.0) {
+                        coordinates[n].y = detail::lat_to_y_with_tan(lat);
+                    }
+                }
+#endif
+            }
+
             int epsg() const noexcept {
                 return 3857;
             }
@@ -0,0 +1,349 @@
+#ifndef OSMIUM_GEOM_OGR_BATCH_WRITER_HPP
+#define OSMIUM_GEOM_OGR_BATCH_WRITER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * This file contains code for writing features to OGR datasources in
+ * batches.
+ *
+ * @attention If you include this file, you'll need to link with `libgdal`.
+ */
+
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/util.hpp>
+
+#include <gdalcpp.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Should the OGRBatchWriter write the features in a background
+         * thread?
+         */
+        enum class ogr_background_thread : bool {
+            no  = false,
+            yes = true
+        };
+
+        /**
+         * Writes features to the layers of an OGR dataset in batches. Each
+         * batch is written inside one transaction. Writing features one by
+         * one, each in its own transaction, is very slow with drivers like
+         * SQLite/GPKG or PostgreSQL.
+         *
+         * Optionally the batches are written in a background thread, so
+         * the thread creating the features doesn't wait for the database.
+         * In that case the dataset and its layers must not be used in any
+         * other way while the writer is open and all layers must be
+         * created before the first feature is added.
+         *
+         * Don't use this together with gdalcpp::Dataset's auto
+         * transactions.
+         *
+         * Call close() at the end to write the remaining features and to
+         * get any errors.
+         */
+        class OGRBatchWriter {
+
+            struct ogr_feature_deleter {
+
+                void operator()(OGRFeature* feature) const noexcept {
+                    OGRFeature::DestroyFeature(feature);
+                }
+
+            }; // struct ogr_feature_deleter
+
+        public:
+
+            /**
+             * A feature for writing with the OGRBatchWriter. This has the
+             * same interface as gdalcpp::Feature.
+             */
+            class Feature {
+
+                friend class OGRBatchWriter;
+
+                gdalcpp::Layer* m_layer;
+                std::unique_ptr<OGRFeature, ogr_feature_deleter> m_feature;
+
+            public:
+
+                Feature(gdalcpp::Layer& layer, std::unique_ptr<OGRGeometry>&& geometry) :
+                    m_layer(&layer),
+                    m_feature(OGRFeature::CreateFeature(layer.get().GetLayerDefn())) {
+                    if (!m_feature) {
+                        throw std::bad_alloc{};
+                    }
+                    const auto result = m_feature->SetGeometryDirectly(geometry.release());
+                    if (result != OGRERR_NONE) {
+                        throw gdalcpp::gdal_error{std::string{"setting feature geometry in layer '"} + layer.name() + "' failed",
+                                                  result,
+                                                  layer.dataset().driver_name(),
+                                                  layer.dataset().dataset_name()};
+                    }
+                }
+
+                template <typename T>
+                Feature& set_field(int n, T&& arg) {
+                    m_feature->SetField(n, std::forward<T>(arg));
+                    return *this;
+                }
+
+                template <typename T>
+                Feature& set_field(const char* name, T&& arg) {
+                    m_feature->SetField(name, std::forward<T>(arg));
+                    return *this;
+                }
+
+                /**
+                 * Write this feature to its layer immediately without
+                 * going through an OGRBatchWriter.
+                 */
+                void add_to_layer() {
+                    m_layer->create_feature(m_feature.get());
+                }
+
+            }; // class Feature
+
+        private:
+
+            using batch_type = std::vector<Feature>;
+
+            gdalcpp::Dataset* m_dataset;
+            std::size_t m_batch_size;
+            batch_type m_batch{};
+            uint64_t m_count = 0;
+
+            std::unique_ptr<osmium::thread::Queue<batch_type>> m_queue{};
+            std::future<void> m_done{};
+            osmium::thread::thread_handler m_thread{};
+            bool m_closed = false;
+
+            static void write_batch(gdalcpp::Dataset& dataset, const batch_type& batch) {
+                dataset.start_transaction();
+                for (const auto& feature : batch) {
+                    const auto result = feature.m_layer->get().CreateFeature(feature.m_feature.get());
+                    if (result != OGRERR_NONE) {
+                        throw gdalcpp::gdal_error{std::string{"creating feature in layer '"} + feature.m_layer->name() + "' failed",
+                                                  result,
+                                                  dataset.driver_name(),
+                                                  dataset.dataset_name(),
+                                                  feature.m_layer->name()};
+                    }
+                }
+                dataset.commit_transaction();
+            }
+
+            // Runs in the background thread until an empty batch is read
+            // from the queue. After an error the queue is still emptied,
+            // so the producer doesn't block.
+            static void write_thread(osmium::thread::Queue<batch_type>& queue, gdalcpp::Dataset& dataset, std::promise<void>&& promise) {
+                osmium::thread::set_thread_name("_osmium_ogr");
+
+                bool failed = false;
+                while (true) {
+                    batch_type batch;
+                    queue.wait_and_pop(batch);
+                    if (batch.empty()) {
+                        break;
+                    }
+                    if (failed) {
+                        continue;
+                    }
+                    try {
+                        write_batch(dataset, batch);
+                    } catch (...) {
+                        failed = true;
+                        promise.set_exception(std::current_exception());
+                    }
+                }
+
+                if (!failed) {
+                    promise.set_value();
+                }
+            }
+
+        public:
+
+            /**
+             * Create an OGRBatchWriter.
+             *
+             * @param dataset The dataset containing all layers the
+             *                features are written to. Must outlive the
+             *                writer.
+             * @param batch_size Number of features written in one
+             *                   transaction.
+             * @param thread Write the batches in a background thread?
+             * @param max_queue_size Maximum number of batches waiting to
+             *                       be written by the background thread.
+             */
+            explicit OGRBatchWriter(gdalcpp::Dataset& dataset,
+                                    std::size_t batch_size = 10000,
+                                    ogr_background_thread thread = ogr_background_thread::no,
+                                    std::size_t max_queue_size = 4) :
+                m_dataset(&dataset),
+                m_batch_size(batch_size > 0 ? batch_size : 1) {
+                m_batch.reserve(m_batch_size);
+                if (thread == ogr_background_thread::yes) {
+                    m_queue.reset(new osmium::thread::Queue<batch_type>{max_queue_size, "ogr_batch"});
+                    std::promise<void> promise;
+                    m_done = promise.get_future();
+                    m_thread = osmium::thread::thread_handler{write_thread, std::ref(*m_queue), std::ref(dataset), std::move(promise)};
+                }
+            }
+
+            OGRBatchWriter(const OGRBatchWriter&) = delete;
+            OGRBatchWriter& operator=(const OGRBatchWriter&) = delete;
+
+            OGRBatchWriter(OGRBatchWriter&&) = delete;
+            OGRBatchWriter& operator=(OGRBatchWriter&&) = delete;
+
+            ~OGRBatchWriter() noexcept {
+                try {
+                    close();
+                } catch (...) { // NOLINT(bugprone-empty-catch)
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /// Does this writer use a background thread?
+            bool background_thread() const noexcept {
+                return static_cast<bool>(m_queue);
+            }
+
+            /// The number of features added so far.
+            uint64_t count() const noexcept {
+                return m_count;
+            }
+
+            /**
+             * Add a feature. It is written when the batch is full.
+             *
+             * @throws gdalcpp::gdal_error If writing this or (with a
+             *         background thread) an earlier batch failed.
+             */
+            void add(Feature&& feature) {
+                if (m_closed) {
+                    throw std::runtime_error{"Can not add features to OGRBatchWriter after close()"};
+                }
+                m_batch.push_back(std::move(feature));
+                ++m_count;
+                if (m_batch.size() >= m_batch_size) {
+                    flush();
+                }
+            }
+
+            /**
+             * Write all features added so far (or hand them to the
+             * background thread).
+             *
+             * @throws gdalcpp::gdal_error If writing failed.
+             */
+            void flush() {
+                if (m_batch.empty()) {
+                    return;
+                }
+
+                batch_type batch;
+                batch.reserve(m_batch_size);
+                using std::swap;
+                swap(batch, m_batch);
+
+                if (m_queue) {
+                    osmium::thread::check_for_exception(m_done);
+                    m_queue->push(std::move(batch));
+                } else {
+                    write_batch(*m_dataset, batch);
+                }
+            }
+
+            /**
+             * Write all remaining features and wait for the background
+             * thread to finish. Can be called several times.
+             *
+             * @throws gdalcpp::gdal_error If writing failed.
+             */
+            void close() {
+                if (m_closed) {
+                    return;
+                }
+                m_closed = true;
+
+                std::exception_ptr error;
+                try {
+                    flush();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                if (m_queue) {
+                    m_queue->push(batch_type{});
+                    try {
+                        osmium::thread::wait_until_done(m_done);
+                    } catch (...) {
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+        }; // class OGRBatchWriter
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_OGR_BATCH_WRITER_HPP
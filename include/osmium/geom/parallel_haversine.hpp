@@ -0,0 +1,142 @@
+#ifndef OSMIUM_GEOM_PARALLEL_HAVERSINE_HPP
+#define OSMIUM_GEOM_PARALLEL_HAVERSINE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/haversine.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <future>
+#include <numeric>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace haversine {
+
+            namespace detail {
+
+                enum {
+                    ways_per_chunk = 1024
+                };
+
+                inline double sum_lengths(const std::vector<const osmium::Way*>& ways, std::size_t begin, std::size_t end) {
+                    double sum_length = 0;
+                    for (std::size_t n = begin; n < end; ++n) {
+                        sum_length += haversine::distance(ways[n]->nodes());
+                    }
+                    return sum_length;
+                }
+
+            } // namespace detail
+
+            /**
+             * Calculate the sum of the lengths of all ways in the buffer
+             * for which the predicate returns true using the threads in
+             * the pool. The ways need locations, for instance from the
+             * NodeLocationsForWays handler.
+             *
+             * The ways are split into chunks of fixed size, each chunk is
+             * summed up in a separate task, and the sums of the chunks
+             * are added up in order. So the result does not depend on the
+             * number of threads, but it can differ in the last digits
+             * from adding up the lengths of the ways one by one.
+             *
+             * @param buffer Buffer with ways. Other objects are ignored.
+             * @param predicate Called with each way from the calling
+             *                  thread, only ways for which it returns true
+             *                  are counted.
+             * @param pool Thread pool to use.
+             * @throws osmium::invalid_location if a counted way has an
+             *         invalid location.
+             */
+            template <typename TPredicate>
+            double total_length(const osmium::memory::Buffer& buffer, TPredicate&& predicate, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                std::vector<const osmium::Way*> ways;
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    if (predicate(way)) {
+                        ways.push_back(&way);
+                    }
+                }
+
+                const std::size_t num_chunks = (ways.size() + detail::ways_per_chunk - 1) / detail::ways_per_chunk;
+                if (num_chunks <= 1) {
+                    return detail::sum_lengths(ways, 0, ways.size());
+                }
+
+                std::vector<double> sums(num_chunks);
+                std::vector<std::future<void>> futures;
+                futures.reserve(num_chunks);
+                for (std::size_t n = 0; n < num_chunks; ++n) {
+                    const std::size_t begin = n * detail::ways_per_chunk;
+                    const std::size_t end = std::min(begin + detail::ways_per_chunk, ways.size());
+                    double* sum = &sums[n];
+                    futures.push_back(pool.submit([&ways, begin, end, sum]() {
+                        *sum = detail::sum_lengths(ways, begin, end);
+                    }));
+                }
+                for (auto& future : futures) {
+                    future.wait();
+                }
+                for (auto& future : futures) {
+                    future.get();
+                }
+
+                return std::accumulate(sums.begin(), sums.end(), 0.0);
+            }
+
+            /**
+             * Calculate the sum of the lengths of all ways in the buffer
+             * using the threads in the pool. See the version with a
+             * predicate for details.
+             */
+            inline double total_length(const osmium::memory::Buffer& buffer, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                return total_length(buffer, [](const osmium::Way& /*way*/) {
+                    return true;
+                }, pool);
+            }
+
+        } // namespace haversine
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_PARALLEL_HAVERSINE_HPP
@@ -43,12 +43,17 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/laea_projection.hpp>
 #include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/utm_projection.hpp>
 #include <osmium/geom/util.hpp>
 #include <osmium/osm/location.hpp>
 
 #include <proj_api.h>
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -120,6 +125,26 @@ namespace osmium {
             return c;
         }
 
+        /**
+         * Transform count coordinates from one CRS into another in place
+         * using a single call into the proj library. This is much faster
+         * than calling transform() for each of the coordinates.
+         *
+         * Coordinates have to be in radians and are produced in radians.
+         *
+         * @throws osmium::projection_error if the projection fails
+         */
+        inline void transform(const CRS& src, const CRS& dest, Coordinates* coordinates, std::size_t count) {
+            static_assert(sizeof(Coordinates) == 2 * sizeof(double), "Coordinates must consist of exactly two doubles");
+            if (count == 0) {
+                return;
+            }
+            const int result = pj_transform(src.get(), dest.get(), static_cast<long>(count), 2, &coordinates->x, &coordinates->y, nullptr); // NOLINT(google-runtime-int)
+            if (result != 0) {
+                throw osmium::projection_error{std::string{"projection failed: "} + pj_strerrno(result)};
+            }
+        }
+
         /**
          * Functor that does projection from WGS84 (EPSG:4326) to the given
          * CRS.
@@ -127,16 +152,75 @@ namespace osmium {
          * If this Projection is initialized with the constructor taking
          * an integer with the epsg code 4326, no projection is done. If it
          * is initialized with epsg code 3857 the Osmium-internal
-         * implementation of the Mercator projection is used, otherwise this
-         * falls back to using the proj.4 library. Note that this "magic" does
-         * not work if you use any of the constructors taking a string.
+         * implementation of the Mercator projection is used, for the WGS84
+         * UTM zones (32601 to 32660 and 32701 to 32760) and for 3035 (LAEA
+         * Europe) the Osmium-internal implementations in UTMProjection
+         * and LAEAEuropeProjection are used. Otherwise this falls back to
+         * using the proj.4 library. Note that this "magic" does not work if
+         * you use any of the constructors taking a string.
+         *
+         * When the proj library is used, the results for the last few
+         * locations are cached, so locations that appear several times
+         * in a row or in neighbouring ways (such as the first and last
+         * node of a closed way) are only transformed once. Because of this
+         * cache (and because the proj library itself is not thread-safe)
+         * a Projection object must not be used from several threads at
+         * the same time.
          */
         class Projection {
 
+            enum class method {
+                identity,
+                mercator,
+                utm,
+                laea,
+                proj
+            };
+
+            struct cache_entry {
+                osmium::Location location{};
+                Coordinates coordinates{};
+            };
+
+            enum {
+                cache_size = 64
+            };
+
             int m_epsg;
             std::string m_proj_string;
             CRS m_crs_wgs84{4326};
             CRS m_crs_user;
+            method m_method = method::proj;
+            UTMProjection m_utm{1};
+            LAEAEuropeProjection m_laea;
+            mutable std::array<cache_entry, cache_size> m_cache{};
+
+            static std::size_t cache_index(osmium::Location location) noexcept {
+                const auto hash = static_cast<uint32_t>(location.x()) * 31U + static_cast<uint32_t>(location.y());
+                return (hash ^ (hash >> 6U)) % cache_size;
+            }
+
+            Coordinates from_proj(Coordinates c) const noexcept {
+                if (m_crs_user.is_latlong()) {
+                    c.x = rad_to_deg(c.x);
+                    c.y = rad_to_deg(c.y);
+                }
+                return c;
+            }
+
+            Coordinates project_with_proj(osmium::Location location) const {
+                cache_entry& entry = m_cache[cache_index(location)];
+                if (entry.location == location && location.valid()) {
+                    return entry.coordinates;
+                }
+
+                const Coordinates c{from_proj(transform(m_crs_wgs84, m_crs_user, Coordinates{deg_to_rad(location.lon()),
+                                                                                            deg_to_rad(location.lat())}))};
+                entry.location = location;
+                entry.coordinates = c;
+
+                return c;
+            }
 
         public:
 
@@ -156,26 +240,72 @@ namespace osmium {
                 m_epsg(epsg),
                 m_proj_string(std::string{"+init=epsg:"} + std::to_string(epsg)),
                 m_crs_user(epsg) {
+                if (epsg == 4326) {
+                    m_method = method::identity;
+                } else if (epsg == 3857) {
+                    m_method = method::mercator;
+                } else if (UTMProjection::is_utm_epsg(epsg)) {
+                    m_method = method::utm;
+                    m_utm = UTMProjection::from_epsg(epsg);
+                } else if (epsg == 3035) {
+                    m_method = method::laea;
+                }
             }
 
             Coordinates operator()(osmium::Location location) const {
-                if (m_epsg == 4326) {
-                    return Coordinates{location.lon(), location.lat()};
+                switch (m_method) {
+                    case method::identity:
+                        return Coordinates{location.lon(), location.lat()};
+                    case method::mercator:
+                        return Coordinates{detail::lon_to_x(location.lon()),
+                                           detail::lat_to_y(location.lat())};
+                    case method::utm:
+                        return m_utm(location);
+                    case method::laea:
+                        return m_laea(location);
+                    default:
+                        break;
                 }
 
-                if (m_epsg == 3857) {
-                    return Coordinates{detail::lon_to_x(location.lon()),
-                                       detail::lat_to_y(location.lat())};
-                }
+                return project_with_proj(location);
+            }
 
-                Coordinates c{transform(m_crs_wgs84, m_crs_user, Coordinates{deg_to_rad(location.lon()),
-                                                                             deg_to_rad(location.lat())})};
-                if (m_crs_user.is_latlong()) {
-                    c.x = rad_to_deg(c.x);
-                    c.y = rad_to_deg(c.y);
+            /**
+             * Project count locations into the coordinates array. This
+             * gives the same results as calling operator() for each
+             * location, but is much faster if the proj library is used,
+             * because all locations are handed to it in one call.
+             *
+             * @param locations Pointer to the first location.
+             * @param count Number of locations.
+             * @param coordinates Pointer to the output array which must
+             *                    have space for count coordinates.
+             * @throws invalid_location if any of the locations is invalid.
+             * @throws osmium::projection_error if the projection fails.
+             *         The output array is undefined in both cases.
+             */
+            void project_many(const osmium::Location* locations, const std::size_t count, Coordinates* coordinates) const {
+                switch (m_method) {
+                    case method::mercator:
+                        MercatorProjection{}.project_many(locations, count, coordinates);
+                        return;
+                    case method::proj:
+                        break;
+                    default:
+                        for (std::size_t n = 0; n < count; ++n) {
+                            coordinates[n] = operator()(locations[n]);
+                        }
+                        return;
                 }
 
-                return c;
+                for (std::size_t n = 0; n < count; ++n) {
+                    coordinates[n].x = deg_to_rad(locations[n].lon());
+                    coordinates[n].y = deg_to_rad(locations[n].lat());
+                }
+                transform(m_crs_wgs84, m_crs_user, coordinates, count);
+                for (std::size_t n = 0; n < count; ++n) {
+                    coordinates[n] = from_proj(coordinates[n]);
+                }
             }
 
             int epsg() const noexcept {
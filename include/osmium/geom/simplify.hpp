@@ -0,0 +1,185 @@
+#ifndef OSMIUM_GEOM_SIMPLIFY_HPP
+#define OSMIUM_GEOM_SIMPLIFY_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/location.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            /**
+             * Squared distance of the location p from the line segment
+             * between a and b in coordinate units.
+             */
+            inline double squared_distance_from_segment(const osmium::Location p, const osmium::Location a, const osmium::Location b) noexcept {
+                const double ax = a.x();
+                const double ay = a.y();
+                double dx = static_cast<double>(b.x()) - ax;
+                double dy = static_cast<double>(b.y()) - ay;
+                double px = static_cast<double>(p.x()) - ax;
+                double py = static_cast<double>(p.y()) - ay;
+
+                const double length2 = dx * dx + dy * dy;
+                if (length2 > 0) {
+                    const double t = (px * dx + py * dy) / length2;
+                    if (t >= 1.0) {
+                        px -= dx;
+                        py -= dy;
+                    } else if (t > 0.0) {
+                        px -= t * dx;
+                        py -= t * dy;
+                    }
+                }
+
+                return px * px + py * py;
+            }
+
+        } // namespace detail
+
+        /**
+         * Get a simplification tolerance (in degrees) suitable for
+         * creating geometries for web map tiles of the given zoom level.
+         * This is the width of a pixel of a 256 pixel wide tile
+         * measured at the equator.
+         *
+         * @param zoom Zoom level.
+         * @param pixels Tolerance in pixels.
+         */
+        inline double simplify_tolerance_for_zoom(unsigned zoom, double pixels = 1.0) noexcept {
+            return pixels * 360.0 / (256.0 * static_cast<double>(1ULL << zoom));
+        }
+
+        /**
+         * Simplify a sequence of locations with the Douglas-Peucker
+         * algorithm. All locations with a distance of more than
+         * tolerance from the simplified line are kept. The first and
+         * last locations are always kept.
+         *
+         * This uses no recursion and doesn't allocate any memory. The
+         * keep flags double as the stack: The segment between a kept
+         * location and the next one is checked and either split or
+         * accepted, in which case the algorithm moves on to the next
+         * segment.
+         *
+         * The distance is calculated in the WGS84 coordinate space, so
+         * the tolerance is in degrees.
+         *
+         * @param locations Pointer to the first location.
+         * @param count Number of locations.
+         * @param tolerance Tolerance in degrees.
+         * @param keep Random access iterator to count bools. On return
+         *             it is true for each location that is kept.
+         * @returns The number of kept locations.
+         *
+         * @pre All locations must be valid.
+         */
+        template <typename TKeepIterator>
+        std::size_t simplify_douglas_peucker(const osmium::Location* locations, const std::size_t count, const double tolerance, TKeepIterator keep) {
+            if (count < 3) {
+                for (std::size_t n = 0; n < count; ++n) {
+                    keep[n] = true;
+                }
+                return count;
+            }
+
+            keep[0] = true;
+            for (std::size_t n = 1; n < count - 1; ++n) {
+                keep[n] = false;
+            }
+            keep[count - 1] = true;
+
+            const double max_distance2 = tolerance * tolerance * osmium::detail::coordinate_precision * osmium::detail::coordinate_precision;
+            std::size_t num_kept = 2;
+            std::size_t first = 0;
+            std::size_t last = count - 1;
+
+            while (first < count - 1) {
+                double farthest_distance2 = max_distance2;
+                std::size_t farthest = 0;
+                for (std::size_t n = first + 1; n < last; ++n) {
+                    const double distance2 = detail::squared_distance_from_segment(locations[n], locations[first], locations[last]);
+                    if (distance2 > farthest_distance2) {
+                        farthest_distance2 = distance2;
+                        farthest = n;
+                    }
+                }
+
+                if (farthest != 0) {
+                    keep[farthest] = true;
+                    ++num_kept;
+                    last = farthest;
+                } else {
+                    first = last;
+                    for (++last; last < count && !keep[last]; ++last) {
+                    }
+                }
+            }
+
+            return num_kept;
+        }
+
+        /**
+         * Simplify a vector of locations in place with the Douglas-Peucker
+         * algorithm. See simplify_douglas_peucker() for details.
+         *
+         * @param locations The locations.
+         * @param tolerance Tolerance in degrees.
+         * @param keep Scratch space. Reuse it between calls to avoid
+         *             allocations.
+         */
+        inline void simplify_douglas_peucker(std::vector<osmium::Location>& locations, const double tolerance, std::vector<bool>& keep) {
+            keep.resize(locations.size());
+            simplify_douglas_peucker(locations.data(), locations.size(), tolerance, keep.begin());
+
+            std::size_t out = 0;
+            for (std::size_t n = 0; n < locations.size(); ++n) {
+                if (keep[n]) {
+                    locations[out++] = locations[n];
+                }
+            }
+            locations.resize(out);
+        }
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_SIMPLIFY_HPP
@@ -0,0 +1,232 @@
+#ifndef OSMIUM_GEOM_SPATIAL_SORT_HPP
+#define OSMIUM_GEOM_SPATIAL_SORT_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * The space-filling curves which can be used to order objects
+         * spatially.
+         */
+        enum class space_filling_curve {
+            morton  = 0,
+            hilbert = 1
+        };
+
+        /// Name of the curve as used in file options and file headers.
+        inline const char* space_filling_curve_name(space_filling_curve curve) noexcept {
+            return curve == space_filling_curve::hilbert ? "hilbert" : "morton";
+        }
+
+        /**
+         * Get the curve from its name ("morton" or "hilbert").
+         *
+         * @throws std::invalid_argument if the name is unknown.
+         */
+        inline space_filling_curve space_filling_curve_from_name(const std::string& name) {
+            if (name == "morton") {
+                return space_filling_curve::morton;
+            }
+            if (name == "hilbert") {
+                return space_filling_curve::hilbert;
+            }
+            throw std::invalid_argument{"Unknown space filling curve '" + name + "' (allowed are 'morton' and 'hilbert')"};
+        }
+
+        namespace detail {
+
+            // Map the coordinate onto the unsigned range keeping the order.
+            inline constexpr uint32_t unsigned_coordinate(int32_t coordinate) noexcept {
+                return static_cast<uint32_t>(coordinate) ^ 0x80000000U;
+            }
+
+            // Spread the bits of the value out so that there is a zero
+            // bit between each of them.
+            inline uint64_t spread_bits(uint32_t value) noexcept {
+                uint64_t x = value;
+                x = (x | (x << 16U)) & 0x0000ffff0000ffffULL;
+                x = (x | (x <<  8U)) & 0x00ff00ff00ff00ffULL;
+                x = (x | (x <<  4U)) & 0x0f0f0f0f0f0f0f0fULL;
+                x = (x | (x <<  2U)) & 0x3333333333333333ULL;
+                x = (x | (x <<  1U)) & 0x5555555555555555ULL;
+                return x;
+            }
+
+        } // namespace detail
+
+        /**
+         * The key used for objects without any valid location. It sorts
+         * after all real keys.
+         */
+        constexpr const uint64_t invalid_spatial_key = std::numeric_limits<uint64_t>::max();
+
+        /**
+         * Position of the location along the Morton (Z-order) curve
+         * over the full 32 bit coordinate space. Invalid and undefined
+         * locations get the invalid_spatial_key.
+         */
+        inline uint64_t morton_key(const osmium::Location& location) noexcept {
+            if (!location.valid()) {
+                return invalid_spatial_key;
+            }
+            return (detail::spread_bits(detail::unsigned_coordinate(location.y())) << 1U) |
+                    detail::spread_bits(detail::unsigned_coordinate(location.x()));
+        }
+
+        /**
+         * Position of the location along the Hilbert curve over the full
+         * 32 bit coordinate space. Neighbouring keys are always adjacent
+         * on the curve, so ranges of keys are more compact in space than
+         * with the Morton curve. Invalid and undefined locations get the
+         * invalid_spatial_key.
+         */
+        inline uint64_t hilbert_key(const osmium::Location& location) noexcept {
+            if (!location.valid()) {
+                return invalid_spatial_key;
+            }
+
+            uint32_t x = detail::unsigned_coordinate(location.x());
+            uint32_t y = detail::unsigned_coordinate(location.y());
+            uint64_t key = 0;
+            for (uint32_t s = 0x80000000U; s > 0; s >>= 1U) {
+                const uint32_t rx = (x & s) ? 1 : 0;
+                const uint32_t ry = (y & s) ? 1 : 0;
+                key += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+                if (ry == 0) {
+                    if (rx == 1) {
+                        x = ~x;
+                        y = ~y;
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return key;
+        }
+
+        /// Position of the location along the given curve.
+        inline uint64_t spatial_key(space_filling_curve curve, const osmium::Location& location) noexcept {
+            return curve == space_filling_curve::hilbert ? hilbert_key(location) : morton_key(location);
+        }
+
+        /**
+         * Position of an object along the given curve. Nodes use their
+         * location, ways the center of the envelope of their node
+         * locations. Ways without locations and all other objects get
+         * the invalid_spatial_key.
+         */
+        inline uint64_t spatial_key(space_filling_curve curve, const osmium::memory::Item& item) noexcept {
+            if (item.type() == osmium::item_type::node) {
+                return spatial_key(curve, static_cast<const osmium::Node&>(item).location());
+            }
+            if (item.type() == osmium::item_type::way) {
+                const osmium::Box box{static_cast<const osmium::Way&>(item).envelope()};
+                if (!box.valid()) {
+                    return invalid_spatial_key;
+                }
+                const osmium::Location center{
+                    static_cast<int32_t>((static_cast<int64_t>(box.bottom_left().x()) + box.top_right().x()) / 2),
+                    static_cast<int32_t>((static_cast<int64_t>(box.bottom_left().y()) + box.top_right().y()) / 2)
+                };
+                return spatial_key(curve, center);
+            }
+            return invalid_spatial_key;
+        }
+
+        /**
+         * Reorder the objects in the buffer along the given space-filling
+         * curve. Objects are grouped by type first (nodes, then ways, then
+         * relations, ...), inside each type they are ordered by their
+         * spatial_key(). Objects with the same key, which includes all
+         * objects without location, keep their relative order.
+         *
+         * The buffer is the window in which objects are reordered, so the
+         * result gets better with larger buffers. Ways need node locations
+         * (for instance from the NodeLocationsForWays handler) to be
+         * ordered.
+         *
+         * Because this takes a buffer by reference it can be used as
+         * an osmium::io::buffer_transform.
+         */
+        inline void spatial_sort(osmium::memory::Buffer& buffer, space_filling_curve curve) {
+            struct entry {
+                uint64_t key;
+                std::size_t offset;
+                osmium::item_type type;
+            };
+
+            std::vector<entry> entries;
+            for (auto it = buffer.cbegin(); it != buffer.cend(); ++it) {
+                entries.push_back(entry{spatial_key(curve, *it),
+                                        static_cast<std::size_t>(it.data() - buffer.data()),
+                                        it->type()});
+            }
+
+            std::stable_sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) {
+                return std::make_pair(a.type, a.key) < std::make_pair(b.type, b.key);
+            });
+
+            osmium::memory::Buffer sorted{buffer.committed(), osmium::memory::Buffer::auto_grow::yes};
+            for (const auto& e : entries) {
+                sorted.add_item(*reinterpret_cast<const osmium::memory::Item*>(buffer.data() + e.offset));
+                sorted.commit();
+            }
+
+            using std::swap;
+            swap(buffer, sorted);
+        }
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_SPATIAL_SORT_HPP
@@ -37,7 +37,9 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/geom/mercator_projection.hpp>
 #include <osmium/osm/location.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 
 namespace osmium {
@@ -203,6 +205,40 @@ namespace osmium {
             return lhs.y < rhs.y;
         }
 
+        /**
+         * Compute the tiles with the given zoom level containing each of
+         * the locations in the range [begin, end) and write them to the
+         * output iterator. The result is the same as creating a Tile from
+         * each location, but it is faster, because the locations are
+         * projected in batches using MercatorProjection::project_many().
+         *
+         * @pre @code zoom <= 30 @endcode
+         * @returns Output iterator after the last tile written.
+         * @throws osmium::invalid_location if any location is invalid.
+         */
+        template <typename TOutputIterator>
+        TOutputIterator tiles_for_locations(uint32_t zoom, const osmium::Location* begin, const osmium::Location* end, TOutputIterator out) {
+            assert(zoom <= Tile::max_zoom);
+
+            enum {
+                batch_size = 256
+            };
+
+            const MercatorProjection projection;
+            Coordinates coordinates[batch_size];
+
+            while (begin != end) {
+                const auto count = std::min(static_cast<std::size_t>(end - begin), static_cast<std::size_t>(batch_size));
+                projection.project_many(begin, count, coordinates);
+                for (std::size_t n = 0; n < count; ++n) {
+                    *out++ = Tile{zoom, mercx_to_tilex(zoom, coordinates[n].x), mercy_to_tiley(zoom, coordinates[n].y)};
+                }
+                begin += count;
+            }
+
+            return out;
+        }
+
     } // namespace geom
 
 } // namespace osmium
@@ -0,0 +1,210 @@
+#ifndef OSMIUM_GEOM_TILE_BUCKETER_HPP
+#define OSMIUM_GEOM_TILE_BUCKETER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/tile.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Sorts nodes and ways into per-tile buffers. Use it like this:
+         *
+         * @code
+         * osmium::geom::TileBucketer bucketer{14, [](const osmium::geom::Tile& tile, osmium::memory::Buffer&& buffer) {
+         *     ... write out buffer for tile ...
+         * }};
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     bucketer(buffer);
+         * }
+         * bucketer.flush();
+         * @endcode
+         *
+         * Nodes go into the bucket of the tile containing their location.
+         * Ways go into the buckets of all tiles containing any of their
+         * node locations, so they need locations, for instance from the
+         * NodeLocationsForWays handler. Nodes and ways without any valid
+         * locations and all other objects are ignored. The order of the
+         * objects in each bucket is the same as in the input.
+         *
+         * Whenever a bucket has reached the configured size, the callback
+         * is called with its tile and buffer. Call flush() at the end to
+         * get the remaining buckets.
+         */
+        class TileBucketer {
+
+        public:
+
+            using callback_type = std::function<void(const Tile&, osmium::memory::Buffer&&)>;
+
+        private:
+
+            enum {
+                initial_bucket_capacity = 4UL * 1024UL
+            };
+
+            std::map<Tile, osmium::memory::Buffer> m_buckets;
+            callback_type m_callback;
+
+            // Valid locations of all objects in the current buffer and the
+            // objects together with how many of those locations they have.
+            std::vector<osmium::Location> m_locations;
+            std::vector<std::pair<const osmium::OSMObject*, std::size_t>> m_objects;
+            std::vector<Tile> m_tiles;
+
+            std::size_t m_bucket_size;
+            uint32_t m_zoom;
+
+            void add_location(const osmium::Location& location) {
+                if (location.valid()) {
+                    m_locations.push_back(location);
+                    ++m_objects.back().second;
+                }
+            }
+
+            void add_to_bucket(const Tile& tile, const osmium::OSMObject& object) {
+                auto it = m_buckets.find(tile);
+                if (it == m_buckets.end()) {
+                    it = m_buckets.emplace(tile, osmium::memory::Buffer{initial_bucket_capacity, osmium::memory::Buffer::auto_grow::yes}).first;
+                }
+
+                it->second.add_item(object);
+                it->second.commit();
+
+                if (it->second.committed() >= m_bucket_size) {
+                    osmium::memory::Buffer buffer{std::move(it->second)};
+                    m_buckets.erase(it);
+                    m_callback(tile, std::move(buffer));
+                }
+            }
+
+        public:
+
+            /**
+             * Create a TileBucketer.
+             *
+             * @param zoom The zoom level of the tiles.
+             * @param callback Function called with full buckets.
+             * @param bucket_size Buckets are handed to the callback once
+             *                    they contain this many bytes.
+             *
+             * @pre @code zoom <= 30 @endcode
+             */
+            TileBucketer(uint32_t zoom, callback_type callback, std::size_t bucket_size = 1024UL * 1024UL) :
+                m_callback(std::move(callback)),
+                m_bucket_size(bucket_size),
+                m_zoom(zoom) {
+                assert(zoom <= Tile::max_zoom);
+                assert(m_callback);
+            }
+
+            uint32_t zoom() const noexcept {
+                return m_zoom;
+            }
+
+            /// The number of buckets that currently hold objects.
+            std::size_t num_buckets() const noexcept {
+                return m_buckets.size();
+            }
+
+            /**
+             * Add all nodes and ways in the buffer to their buckets. The
+             * tiles for all locations in the buffer are computed in one
+             * batch.
+             */
+            void operator()(const osmium::memory::Buffer& buffer) {
+                m_locations.clear();
+                m_objects.clear();
+
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (object.type() == osmium::item_type::node) {
+                        m_objects.emplace_back(&object, 0);
+                        add_location(static_cast<const osmium::Node&>(object).location());
+                    } else if (object.type() == osmium::item_type::way) {
+                        m_objects.emplace_back(&object, 0);
+                        for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                            add_location(node_ref.location());
+                        }
+                    }
+                }
+
+                m_tiles.assign(m_locations.size(), Tile{m_zoom, 0, 0});
+                tiles_for_locations(m_zoom, m_locations.data(), m_locations.data() + m_locations.size(), m_tiles.data());
+
+                auto tiles_begin = m_tiles.begin();
+                for (const auto& object : m_objects) {
+                    const auto tiles_end = tiles_begin + static_cast<std::ptrdiff_t>(object.second);
+                    std::sort(tiles_begin, tiles_end);
+                    std::for_each(tiles_begin, std::unique(tiles_begin, tiles_end), [&](const Tile& tile) {
+                        add_to_bucket(tile, *object.first);
+                    });
+                    tiles_begin = tiles_end;
+                }
+            }
+
+            /**
+             * Hand all remaining buckets to the callback in tile order
+             * and clear them.
+             */
+            void flush() {
+                for (auto& bucket : m_buckets) {
+                    m_callback(bucket.first, std::move(bucket.second));
+                }
+                m_buckets.clear();
+            }
+
+        }; // class TileBucketer
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_TILE_BUCKETER_HPP
@@ -0,0 +1,515 @@
+#ifndef OSMIUM_GEOM_TILE_CLIPPER_HPP
+#define OSMIUM_GEOM_TILE_CLIPPER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/tile.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/node_ref_list.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Clips linestrings and polygons to the bounds of a tile, for
+         * instance for generating vector tiles. The tile can be extended by
+         * a buffer on all sides.
+         *
+         * Clipping is done on the integer coordinates of the locations. The
+         * tile bounds are converted from Web Mercator to WGS84 once, so this
+         * is exact for the tile bounds, but segments are treated as straight
+         * lines in WGS84 when calculating intersections with the bounds.
+         *
+         * Linestrings are clipped with the Cohen-Sutherland algorithm, the
+         * parts inside the tile are returned as separate lines. Polygon rings
+         * are clipped with the Sutherland-Hodgman algorithm. Points on the
+         * tile bounds that are only there because the ring went outside and
+         * came back (zero-width spikes along the bounds) are removed, as are
+         * rings with no area left. Like with all Sutherland-Hodgman
+         * implementations, a ring that has several separate parts inside
+         * the tile is not split, the parts stay connected along the tile
+         * bounds.
+         *
+         * The results are vectors of NodeRefs (with id 0), so they can be
+         * used with the fill_*() functions of the GeometryFactory. The
+         * create_*() functions do this directly.
+         *
+         * A TileClipper has no shared state, so use one per thread to clip
+         * for different tiles in parallel. Clipping the same TileClipper
+         * again reuses the memory of the vectors returned before, so
+         * references to them are only valid until the next call.
+         */
+        class TileClipper {
+
+        public:
+
+            using line_type = std::vector<osmium::NodeRef>;
+
+        private:
+
+            enum : unsigned int {
+                inside = 0U,
+                left   = 1U,
+                right  = 2U,
+                bottom = 4U,
+                top    = 8U
+            };
+
+            osmium::Box m_box;
+            int32_t m_min_x;
+            int32_t m_min_y;
+            int32_t m_max_x;
+            int32_t m_max_y;
+
+            std::vector<line_type> m_lines;
+            line_type m_ring;
+            line_type m_ring_tmp;
+
+            static osmium::Box tile_box(const Tile& tile, double buffer) {
+                assert(tile.valid());
+                assert(buffer >= 0.0);
+
+                const double extent = tile_extent_in_zoom(tile.z);
+                const double max = detail::max_coordinate_epsg3857;
+
+                const auto bottom_left = mercator_to_lonlat(Coordinates{
+                    std::max(-max, -max + (tile.x - buffer) * extent),
+                    max - (tile.y + 1 + buffer) * extent
+                });
+                const auto top_right = mercator_to_lonlat(Coordinates{
+                    std::min(max, -max + (tile.x + 1 + buffer) * extent),
+                    max - (tile.y - buffer) * extent
+                });
+
+                return osmium::Box{osmium::Location{bottom_left.x, bottom_left.y},
+                                   osmium::Location{top_right.x, top_right.y}};
+            }
+
+            unsigned int outcode(const osmium::Location& location) const noexcept {
+                unsigned int code = inside;
+                if (location.x() < m_min_x) {
+                    code |= left;
+                } else if (location.x() > m_max_x) {
+                    code |= right;
+                }
+                if (location.y() < m_min_y) {
+                    code |= bottom;
+                } else if (location.y() > m_max_y) {
+                    code |= top;
+                }
+                return code;
+            }
+
+            static int32_t clamp_coordinate(double value, int32_t min, int32_t max) noexcept {
+                const auto rounded = std::round(value);
+                if (rounded < min) {
+                    return min;
+                }
+                if (rounded > max) {
+                    return max;
+                }
+                return static_cast<int32_t>(rounded);
+            }
+
+            // Intersection of the segment a-b with the vertical line at x.
+            // The result is clamped to the box to make up for rounding.
+            osmium::Location intersect_x(const osmium::Location& a, const osmium::Location& b, int32_t x) const noexcept {
+                const double t = (static_cast<double>(x) - a.x()) / (static_cast<double>(b.x()) - a.x());
+                const double y = a.y() + t * (static_cast<double>(b.y()) - a.y());
+                return osmium::Location{x, clamp_coordinate(y, m_min_y, m_max_y)};
+            }
+
+            // Intersection of the segment a-b with the horizontal line at y.
+            osmium::Location intersect_y(const osmium::Location& a, const osmium::Location& b, int32_t y) const noexcept {
+                const double t = (static_cast<double>(y) - a.y()) / (static_cast<double>(b.y()) - a.y());
+                const double x = a.x() + t * (static_cast<double>(b.x()) - a.x());
+                return osmium::Location{clamp_coordinate(x, m_min_x, m_max_x), y};
+            }
+
+            osmium::Location intersect(const osmium::Location& a, const osmium::Location& b, unsigned int edge) const noexcept {
+                switch (edge) {
+                    case left:
+                        return intersect_x(a, b, m_min_x);
+                    case right:
+                        return intersect_x(a, b, m_max_x);
+                    case bottom:
+                        return intersect_y(a, b, m_min_y);
+                    default: // top
+                        return intersect_y(a, b, m_max_y);
+                }
+            }
+
+            /**
+             * Cohen-Sutherland clipping of a single segment. Returns false
+             * if the segment is completely outside the box, otherwise a and
+             * b are set to the part inside.
+             */
+            bool clip_segment(osmium::Location& a, osmium::Location& b) const noexcept {
+                unsigned int code_a = outcode(a);
+                unsigned int code_b = outcode(b);
+
+                while (true) {
+                    if ((code_a | code_b) == inside) {
+                        return true;
+                    }
+                    if ((code_a & code_b) != inside) {
+                        return false;
+                    }
+
+                    const unsigned int code = code_a != inside ? code_a : code_b;
+                    unsigned int edge = left;
+                    while (!(code & edge)) {
+                        edge <<= 1U;
+                    }
+
+                    if (code == code_a) {
+                        a = intersect(a, b, edge);
+                        code_a = outcode(a);
+                    } else {
+                        b = intersect(a, b, edge);
+                        code_b = outcode(b);
+                    }
+                }
+            }
+
+            bool is_inside(const osmium::Location& location, unsigned int edge) const noexcept {
+                switch (edge) {
+                    case left:
+                        return location.x() >= m_min_x;
+                    case right:
+                        return location.x() <= m_max_x;
+                    case bottom:
+                        return location.y() >= m_min_y;
+                    default: // top
+                        return location.y() <= m_max_y;
+                }
+            }
+
+            // Clip the open ring in m_ring against one edge of the box
+            // (one step of Sutherland-Hodgman).
+            void clip_ring_at_edge(unsigned int edge) {
+                m_ring_tmp.clear();
+                if (m_ring.empty()) {
+                    return;
+                }
+
+                osmium::Location prev = m_ring.back().location();
+                for (const auto& node_ref : m_ring) {
+                    const osmium::Location current = node_ref.location();
+                    if (is_inside(current, edge)) {
+                        if (!is_inside(prev, edge)) {
+                            m_ring_tmp.emplace_back(0, intersect(prev, current, edge));
+                        }
+                        m_ring_tmp.emplace_back(0, current);
+                    } else if (is_inside(prev, edge)) {
+                        m_ring_tmp.emplace_back(0, intersect(prev, current, edge));
+                    }
+                    prev = current;
+                }
+
+                using std::swap;
+                swap(m_ring, m_ring_tmp);
+            }
+
+            static double cross(const osmium::Location& a, const osmium::Location& b, const osmium::Location& c) noexcept {
+                return (static_cast<double>(b.x()) - a.x()) * (static_cast<double>(c.y()) - a.y()) -
+                       (static_cast<double>(b.y()) - a.y()) * (static_cast<double>(c.x()) - a.x());
+            }
+
+            // Remove duplicate points and points on a straight line between
+            // their neighbours (including spikes going out and back along
+            // the same line) from the open ring in m_ring. Clears the ring
+            // if there is no area left.
+            void repair_ring() {
+                const auto last = std::unique(m_ring.begin(), m_ring.end(), [](const osmium::NodeRef& a, const osmium::NodeRef& b) {
+                    return a.location() == b.location();
+                });
+                m_ring.erase(last, m_ring.end());
+                while (m_ring.size() > 1 && m_ring.front().location() == m_ring.back().location()) {
+                    m_ring.pop_back();
+                }
+
+                bool changed = true;
+                while (changed && m_ring.size() >= 3) {
+                    changed = false;
+                    m_ring_tmp.clear();
+                    const auto size = m_ring.size();
+                    for (std::size_t i = 0; i < size; ++i) {
+                        const osmium::Location prev = m_ring_tmp.empty() ? m_ring[(i + size - 1) % size].location() : m_ring_tmp.back().location();
+                        const osmium::Location current = m_ring[i].location();
+                        const osmium::Location next = m_ring[(i + 1) % size].location();
+                        if (current == prev || cross(prev, current, next) == 0.0) {
+                            changed = true;
+                        } else {
+                            m_ring_tmp.push_back(m_ring[i]);
+                        }
+                    }
+                    using std::swap;
+                    swap(m_ring, m_ring_tmp);
+                }
+
+                if (m_ring.size() < 3) {
+                    m_ring.clear();
+                }
+            }
+
+            // Add the clipped ring in m_ring to the multipolygon.
+            template <typename TFactory>
+            void add_ring(TFactory& factory, bool outer) {
+                if (outer) {
+                    factory.multipolygon_outer_ring_start();
+                } else {
+                    factory.multipolygon_inner_ring_start();
+                }
+                factory.fill_multipolygon_ring_unique(m_ring.cbegin(), m_ring.cend());
+                if (outer) {
+                    factory.multipolygon_outer_ring_finish();
+                } else {
+                    factory.multipolygon_inner_ring_finish();
+                }
+            }
+
+        public:
+
+            /**
+             * Create a clipper for the given tile.
+             *
+             * @param tile The tile.
+             * @param buffer Size of the buffer added on all sides of the
+             *               tile as a fraction of the tile size. For a
+             *               vector tile with extent 4096 and a buffer of
+             *               64 this is 64/4096.
+             *
+             * @pre @code tile.valid() && buffer >= 0 @endcode
+             */
+            explicit TileClipper(const Tile& tile, double buffer = 0.0) :
+                m_box(tile_box(tile, buffer)),
+                m_min_x(m_box.bottom_left().x()),
+                m_min_y(m_box.bottom_left().y()),
+                m_max_x(m_box.top_right().x()),
+                m_max_y(m_box.top_right().y()) {
+            }
+
+            /// The bounds used for clipping (including the buffer).
+            const osmium::Box& box() const noexcept {
+                return m_box;
+            }
+
+            /**
+             * Clip a linestring. Consecutive nodes with the same location
+             * are ignored.
+             *
+             * @returns The parts of the linestring inside the tile. Each of
+             *          them has at least two different points. Valid until
+             *          the next call to clip_linestring().
+             * @throws osmium::invalid_location if a location is invalid.
+             */
+            const std::vector<line_type>& clip_linestring(const osmium::NodeRefList& nodes) {
+                m_lines.clear();
+
+                osmium::Location last;
+                for (const auto& node_ref : nodes) {
+                    const auto& location = node_ref.location();
+                    if (!location.valid()) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+                    if (last.valid() && last != location) {
+                        osmium::Location a = last;
+                        osmium::Location b = location;
+                        if (clip_segment(a, b) && a != b) {
+                            if (m_lines.empty() || m_lines.back().back().location() != a) {
+                                m_lines.emplace_back();
+                                m_lines.back().emplace_back(0, a);
+                            }
+                            m_lines.back().emplace_back(0, b);
+                        }
+                    }
+                    last = location;
+                }
+
+                return m_lines;
+            }
+
+            /**
+             * Clip a polygon ring. The ring must be closed.
+             *
+             * @returns The clipped ring (closed again) or an empty vector if
+             *          nothing with an area is left of the ring. Valid
+             *          until the next call to clip_ring().
+             * @throws osmium::invalid_location if a location is invalid.
+             */
+            const line_type& clip_ring(const osmium::NodeRefList& ring) {
+                m_ring.clear();
+                for (const auto& node_ref : ring) {
+                    if (!node_ref.location().valid()) {
+                        throw osmium::invalid_location{"invalid location"};
+                    }
+                    if (m_ring.empty() || m_ring.back().location() != node_ref.location()) {
+                        m_ring.emplace_back(0, node_ref.location());
+                    }
+                }
+                // Remove closing point, the ring is handled as open ring.
+                if (m_ring.size() > 1 && m_ring.front().location() == m_ring.back().location()) {
+                    m_ring.pop_back();
+                }
+
+                for (const unsigned int edge : {left, right, bottom, top}) {
+                    clip_ring_at_edge(edge);
+                }
+                repair_ring();
+
+                if (!m_ring.empty()) {
+                    m_ring.push_back(m_ring.front());
+                }
+                return m_ring;
+            }
+
+            /**
+             * Create a multilinestring from the parts of the way inside the
+             * tile.
+             *
+             * @throws osmium::geometry_error if no part of the way is
+             *         inside the tile.
+             */
+            template <typename TFactory>
+            typename TFactory::multilinestring_type create_multilinestring(TFactory& factory, const osmium::Way& way) {
+                try {
+                    const auto& lines = clip_linestring(way.nodes());
+                    if (lines.empty()) {
+                        throw osmium::geometry_error{"way outside of tile"};
+                    }
+                    return factory.create_multilinestring(lines);
+                } catch (osmium::geometry_error& e) {
+                    e.set_id("way", way.id());
+                    throw;
+                }
+            }
+
+            /**
+             * Create a polygon from the part of the closed way inside the
+             * tile.
+             *
+             * @throws osmium::geometry_error if the way is not closed or no
+             *         part of it is inside the tile.
+             */
+            template <typename TFactory>
+            typename TFactory::polygon_type create_polygon(TFactory& factory, const osmium::Way& way) {
+                try {
+                    if (!way.nodes().empty() && !way.nodes().ends_have_same_location()) {
+                        throw osmium::geometry_error{"way is not closed"};
+                    }
+                    const auto& ring = clip_ring(way.nodes());
+                    if (ring.empty()) {
+                        throw osmium::geometry_error{"way outside of tile"};
+                    }
+                    factory.polygon_start();
+                    const auto num_points = factory.fill_polygon_unique(ring.cbegin(), ring.cend());
+                    return factory.polygon_finish(num_points);
+                } catch (osmium::geometry_error& e) {
+                    e.set_id("way", way.id());
+                    throw;
+                }
+            }
+
+            /**
+             * Create a multipolygon from the parts of the area inside the
+             * tile. Inner rings of outer rings that are completely outside
+             * the tile are ignored.
+             *
+             * @throws osmium::geometry_error if no part of the area is
+             *         inside the tile.
+             */
+            template <typename TFactory>
+            typename TFactory::multipolygon_type create_multipolygon(TFactory& factory, const osmium::Area& area) {
+                try {
+                    std::size_t num_polygons = 0;
+                    bool in_polygon = false;
+                    factory.multipolygon_start();
+
+                    for (const auto& item : area) {
+                        if (item.type() == osmium::item_type::outer_ring) {
+                            if (in_polygon) {
+                                factory.multipolygon_polygon_finish();
+                                in_polygon = false;
+                            }
+                            if (!clip_ring(static_cast<const osmium::OuterRing&>(item)).empty()) {
+                                factory.multipolygon_polygon_start();
+                                add_ring(factory, true);
+                                in_polygon = true;
+                                ++num_polygons;
+                            }
+                        } else if (item.type() == osmium::item_type::inner_ring && in_polygon) {
+                            if (!clip_ring(static_cast<const osmium::InnerRing&>(item)).empty()) {
+                                add_ring(factory, false);
+                            }
+                        }
+                    }
+
+                    if (num_polygons == 0) {
+                        throw osmium::geometry_error{"area outside of tile"};
+                    }
+
+                    factory.multipolygon_polygon_finish();
+                    return factory.multipolygon_finish();
+                } catch (osmium::geometry_error& e) {
+                    e.set_id("area", area.id());
+                    throw;
+                }
+            }
+
+        }; // class TileClipper
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_TILE_CLIPPER_HPP
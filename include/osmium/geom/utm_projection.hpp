@@ -0,0 +1,223 @@
+#ifndef OSMIUM_GEOM_UTM_PROJECTION_HPP
+#define OSMIUM_GEOM_UTM_PROJECTION_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * This file contains an Osmium-internal implementation of the Transverse
+ * Mercator projection and of the UTM zones based on it. It does not need
+ * the proj library.
+ */
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/util.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+namespace osmium {
+
+    namespace geom {
+
+        namespace detail {
+
+            /**
+             * Transverse Mercator projection on an ellipsoid using the
+             * Krüger series to sixth order in the third flattening (see
+             * C. F. F. Karney, "Transverse Mercator with an accuracy of a
+             * few nanometers", J. Geodesy 85(8), 2011). Within a few
+             * thousand kilometers of the central meridian the result
+             * matches the exact projection to well below a millimeter.
+             */
+            class transverse_mercator {
+
+                double m_e;
+                double m_lon0;
+                double m_scale; // scale factor * rectifying radius
+                double m_alpha[6];
+                double m_false_easting;
+                double m_false_northing;
+
+                Coordinates project_radians(double lon, double lat) const noexcept {
+                    const double sin_lat = std::sin(lat);
+                    const double t = std::sinh(std::atanh(sin_lat) - m_e * std::atanh(m_e * sin_lat));
+                    const double dlon = lon - m_lon0;
+                    const double xi = std::atan2(t, std::cos(dlon));
+                    const double eta = std::atanh(std::sin(dlon) / std::sqrt(1.0 + t * t));
+
+                    double x = eta;
+                    double y = xi;
+                    for (int j = 0; j < 6; ++j) {
+                        const double k = 2.0 * (j + 1);
+                        x += m_alpha[j] * std::cos(k * xi) * std::sinh(k * eta);
+                        y += m_alpha[j] * std::sin(k * xi) * std::cosh(k * eta);
+                    }
+
+                    return Coordinates{m_scale * x, m_scale * y};
+                }
+
+            public:
+
+                /**
+                 * @param a Semi-major axis of the ellipsoid.
+                 * @param inverse_flattening Inverse flattening of the ellipsoid.
+                 * @param lon0 Longitude of the central meridian (degrees).
+                 * @param lat0 Latitude of origin (degrees).
+                 * @param k0 Scale factor on the central meridian.
+                 * @param false_easting False easting.
+                 * @param false_northing False northing.
+                 */
+                transverse_mercator(double a, double inverse_flattening, double lon0, double lat0, double k0, double false_easting, double false_northing) noexcept :
+                    m_lon0(deg_to_rad(lon0)),
+                    m_false_easting(false_easting) {
+                    const double f = 1.0 / inverse_flattening;
+                    const double n = f / (2.0 - f);
+                    const double n2 = n * n;
+                    const double n3 = n2 * n;
+                    const double n4 = n3 * n;
+                    const double n5 = n4 * n;
+                    const double n6 = n5 * n;
+
+                    m_e = 2.0 * std::sqrt(n) / (1.0 + n);
+                    m_scale = k0 * a / (1.0 + n) * (1.0 + n2 / 4.0 + n4 / 64.0 + n6 / 256.0);
+
+                    m_alpha[0] = n / 2.0 - 2.0 * n2 / 3.0 + 5.0 * n3 / 16.0 + 41.0 * n4 / 180.0 - 127.0 * n5 / 288.0 + 7891.0 * n6 / 37800.0;
+                    m_alpha[1] = 13.0 * n2 / 48.0 - 3.0 * n3 / 5.0 + 557.0 * n4 / 1440.0 + 281.0 * n5 / 630.0 - 1983433.0 * n6 / 1935360.0;
+                    m_alpha[2] = 61.0 * n3 / 240.0 - 103.0 * n4 / 140.0 + 15061.0 * n5 / 26880.0 + 167603.0 * n6 / 181440.0;
+                    m_alpha[3] = 49561.0 * n4 / 161280.0 - 179.0 * n5 / 168.0 + 6601661.0 * n6 / 7257600.0;
+                    m_alpha[4] = 34729.0 * n5 / 80640.0 - 3418889.0 * n6 / 1995840.0;
+                    m_alpha[5] = 212378941.0 * n6 / 319334400.0;
+
+                    m_false_northing = false_northing - project_radians(m_lon0, deg_to_rad(lat0)).y;
+                }
+
+                Coordinates operator()(double lon, double lat) const noexcept {
+                    const Coordinates c{project_radians(deg_to_rad(lon), deg_to_rad(lat))};
+                    return Coordinates{m_false_easting + c.x, m_false_northing + c.y};
+                }
+
+            }; // class transverse_mercator
+
+        } // namespace detail
+
+        /**
+         * Functor that does projection from WGS84 (EPSG:4326) to one of
+         * the UTM zones on the WGS84 ellipsoid (EPSG:32601 to EPSG:32660
+         * for the northern and EPSG:32701 to EPSG:32760 for the southern
+         * hemisphere).
+         */
+        class UTMProjection {
+
+            detail::transverse_mercator m_tm;
+            int m_zone;
+            bool m_south;
+
+        public:
+
+            /**
+             * @param zone UTM zone (1 to 60).
+             * @param south Use the southern variant of the zone (with
+             *              a false northing of 10,000 km).
+             * @throws osmium::projection_error if the zone is out of range.
+             */
+            explicit UTMProjection(int zone, bool south = false) :
+                m_tm(6378137.0, 298.257223563, -183.0 + 6.0 * zone, 0.0, 0.9996, 500000.0, south ? 10000000.0 : 0.0),
+                m_zone(zone),
+                m_south(south) {
+                if (zone < 1 || zone > 60) {
+                    throw osmium::projection_error{"invalid UTM zone " + std::to_string(zone)};
+                }
+            }
+
+            /**
+             * Is the EPSG code one of the WGS84 UTM zones?
+             */
+            static bool is_utm_epsg(int epsg) noexcept {
+                return (epsg >= 32601 && epsg <= 32660) || (epsg >= 32701 && epsg <= 32760);
+            }
+
+            /**
+             * Create the UTM projection for the given EPSG code.
+             *
+             * @pre @code is_utm_epsg(epsg) @endcode
+             */
+            static UTMProjection from_epsg(int epsg) {
+                return UTMProjection{epsg % 100, epsg > 32700};
+            }
+
+            Coordinates operator()(osmium::Location location) const {
+                return m_tm(location.lon(), location.lat());
+            }
+
+            /**
+             * Project count locations into the coordinates array. This
+             * gives the same results as calling operator() for each
+             * location.
+             *
+             * @throws invalid_location if any of the locations is invalid.
+             *         The output array is undefined in this case.
+             */
+            void project_many(const osmium::Location* locations, const std::size_t count, Coordinates* coordinates) const {
+                for (std::size_t n = 0; n < count; ++n) {
+                    coordinates[n] = operator()(locations[n]);
+                }
+            }
+
+            int zone() const noexcept {
+                return m_zone;
+            }
+
+            bool south() const noexcept {
+                return m_south;
+            }
+
+            int epsg() const noexcept {
+                return (m_south ? 32700 : 32600) + m_zone;
+            }
+
+            std::string proj_string() const {
+                return "+proj=utm +zone=" + std::to_string(m_zone) + (m_south ? " +south" : "") + " +datum=WGS84 +units=m +no_defs";
+            }
+
+        }; // class UTMProjection
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_UTM_PROJECTION_HPP
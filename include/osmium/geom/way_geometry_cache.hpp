@@ -0,0 +1,227 @@
+#ifndef OSMIUM_GEOM_WAY_GEOMETRY_CACHE_HPP
+#define OSMIUM_GEOM_WAY_GEOMETRY_CACHE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace geom {
+
+        /**
+         * Cache for the projected coordinates and the envelopes of ways.
+         * Ways are often members of several relations (for instance
+         * boundaries on several admin levels or several routes), so
+         * their geometries are built again and again. With an expensive
+         * projection most of the time goes into projecting the same
+         * locations. This cache remembers the projected coordinates of
+         * each way.
+         *
+         * Ways are identified by their ID and version. A cached way with
+         * a different version is calculated again.
+         *
+         * The memory use of the cache is bounded, the least recently used
+         * ways are removed when it is reached.
+         *
+         * A cache must only be used with one projection. Give it to a
+         * GeometryFactory with GeometryFactory::set_way_geometry_cache().
+         *
+         * This class is not thread safe.
+         */
+        class WayGeometryCache {
+
+        public:
+
+            /**
+             * The geometry of a way: The projected coordinates of its
+             * nodes (without consecutive duplicate locations) and the
+             * envelope of the (unprojected) locations.
+             */
+            struct geometry {
+                std::vector<Coordinates> coordinates{};
+                osmium::Box envelope{};
+            };
+
+        private:
+
+            struct entry {
+                osmium::object_id_type id;
+                osmium::object_version_type version;
+                geometry geom;
+            };
+
+            using list_type = std::list<entry>;
+
+            // Most recently used entries are at the front.
+            list_type m_entries{};
+            std::unordered_map<osmium::object_id_type, list_type::iterator> m_map{};
+            std::size_t m_max_memory;
+            std::size_t m_memory = 0;
+            uint64_t m_hits = 0;
+            uint64_t m_misses = 0;
+
+            static std::size_t memory_of(const entry& e) noexcept {
+                // Rough estimate including the list and map nodes.
+                return sizeof(entry) + e.geom.coordinates.capacity() * sizeof(Coordinates) +
+                       4 * sizeof(void*) + sizeof(std::pair<osmium::object_id_type, list_type::iterator>);
+            }
+
+            void remove(list_type::iterator it) {
+                m_memory -= memory_of(*it);
+                m_map.erase(it->id);
+                m_entries.erase(it);
+            }
+
+            void shrink() {
+                // The most recently used entry is always kept, even if it
+                // alone is larger than the limit.
+                while (m_memory > m_max_memory && m_entries.size() > 1) {
+                    remove(std::prev(m_entries.end()));
+                }
+            }
+
+        public:
+
+            /**
+             * Create a cache using at most (approximately) the specified
+             * number of bytes.
+             */
+            explicit WayGeometryCache(std::size_t max_memory = 64UL * 1024UL * 1024UL) :
+                m_max_memory(max_memory) {
+            }
+
+            /**
+             * Get the geometry of the way, calculating and caching it if
+             * it isn't in the cache.
+             *
+             * The returned reference is valid until the next call to
+             * get() or clear().
+             *
+             * @param way The way.
+             * @param projection The projection, called with each location.
+             * @throws osmium::invalid_location If a node location is
+             *         invalid (from the projection). Nothing is cached
+             *         then.
+             */
+            template <typename TProjection>
+            const geometry& get(const osmium::Way& way, const TProjection& projection) {
+                const auto found = m_map.find(way.id());
+                if (found != m_map.end()) {
+                    const auto it = found->second;
+                    if (it->version == way.version()) {
+                        ++m_hits;
+                        m_entries.splice(m_entries.begin(), m_entries, it);
+                        return it->geom;
+                    }
+                    remove(it);
+                }
+
+                ++m_misses;
+                entry e{way.id(), way.version(), geometry{}};
+                e.geom.coordinates.reserve(way.nodes().size());
+                osmium::Location last_location;
+                for (const auto& node_ref : way.nodes()) {
+                    if (last_location != node_ref.location()) {
+                        last_location = node_ref.location();
+                        e.geom.coordinates.push_back(projection(last_location));
+                        e.geom.envelope.extend(last_location);
+                    }
+                }
+                e.geom.coordinates.shrink_to_fit();
+
+                m_entries.push_front(std::move(e));
+                m_map.emplace(way.id(), m_entries.begin());
+                m_memory += memory_of(m_entries.front());
+                shrink();
+
+                return m_entries.front().geom;
+            }
+
+            /// Is the geometry of this way in the cache?
+            bool contains(const osmium::Way& way) const {
+                const auto found = m_map.find(way.id());
+                return found != m_map.end() && found->second->version == way.version();
+            }
+
+            /// The number of ways in the cache.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            /// The approximate number of bytes used by the cache.
+            std::size_t used_memory() const noexcept {
+                return m_memory;
+            }
+
+            std::size_t max_memory() const noexcept {
+                return m_max_memory;
+            }
+
+            /// The number of calls to get() that found the way.
+            uint64_t hits() const noexcept {
+                return m_hits;
+            }
+
+            /// The number of calls to get() that had to calculate it.
+            uint64_t misses() const noexcept {
+                return m_misses;
+            }
+
+            /// Remove all ways from the cache.
+            void clear() {
+                m_entries.clear();
+                m_map.clear();
+                m_memory = 0;
+            }
+
+        }; // class WayGeometryCache
+
+    } // namespace geom
+
+} // namespace osmium
+
+#endif // OSMIUM_GEOM_WAY_GEOMETRY_CACHE_HPP
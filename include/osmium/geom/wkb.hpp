@@ -40,6 +40,7 @@ DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <string>
 
 namespace osmium {
@@ -76,6 +77,24 @@ namespace osmium {
                 return out;
             }
 
+            /**
+             * Convert the binary data in str starting at offset to hex
+             * in place. This needs no temporary string.
+             */
+            inline void convert_to_hex_in_place(std::string& str, const std::size_t offset) {
+                static const char* lookup_hex = "0123456789ABCDEF";
+                const std::size_t size = str.size() - offset;
+                str.resize(offset + size * 2);
+
+                // Work backwards so the input is never overwritten
+                // before it has been read.
+                for (std::size_t n = size; n > 0; --n) {
+                    const auto c = static_cast<unsigned int>(str[offset + n - 1]);
+                    str[offset + n * 2 - 1] = lookup_hex[ c        & 0xfu];
+                    str[offset + n * 2 - 2] = lookup_hex[(c >> 4u) & 0xfu];
+                }
+            }
+
             class WKBFactoryImpl {
 
                 /**
@@ -107,12 +126,16 @@ namespace osmium {
                 }; // enum class wkb_byte_order_type
 
                 std::string m_data;
+                std::string* m_output = nullptr;
+                std::size_t m_start = 0;
                 uint32_t m_points = 0;
                 int m_srid;
                 wkb_type m_wkb_type;
                 out_type m_out_type;
 
                 std::size_t m_linestring_size_offset = 0;
+                std::size_t m_linestrings = 0;
+                std::size_t m_multilinestring_size_offset = 0;
                 std::size_t m_polygons = 0;
                 std::size_t m_rings = 0;
                 std::size_t m_multipolygon_size_offset = 0;
@@ -143,16 +166,49 @@ namespace osmium {
                         throw geometry_error{"Too many points in geometry"};
                     }
                     const auto s = static_cast<uint32_t>(size);
-                    std::copy_n(reinterpret_cast<const char*>(&s), sizeof(uint32_t), &m_data[offset]);
+                    std::copy_n(reinterpret_cast<const char*>(&s), sizeof(uint32_t), &data()[offset]);
+                }
+
+                std::string& data() noexcept {
+                    return m_output ? *m_output : m_data;
+                }
+
+                void start() {
+                    if (m_output) {
+                        m_start = m_output->size();
+                    } else {
+                        m_data.clear();
+                    }
+                }
+
+                std::string finish() {
+                    if (m_output) {
+                        if (m_out_type == out_type::hex) {
+                            convert_to_hex_in_place(*m_output, m_start);
+                        }
+                        return std::string{};
+                    }
+
+                    std::string result;
+
+                    using std::swap;
+                    swap(result, m_data);
+
+                    if (m_out_type == out_type::hex) {
+                        return convert_to_hex(result);
+                    }
+
+                    return result;
                 }
 
             public:
 
-                using point_type        = std::string;
-                using linestring_type   = std::string;
-                using polygon_type      = std::string;
-                using multipolygon_type = std::string;
-                using ring_type         = std::string;
+                using point_type           = std::string;
+                using linestring_type      = std::string;
+                using polygon_type         = std::string;
+                using multipolygon_type    = std::string;
+                using ring_type            = std::string;
+                using multilinestring_type = std::string;
 
                 explicit WKBFactoryImpl(int srid, wkb_type wtype = wkb_type::wkb, out_type otype = out_type::binary) :
                     m_srid(srid),
@@ -160,9 +216,39 @@ namespace osmium {
                     m_out_type(otype) {
                 }
 
+                /**
+                 * Create a factory which appends all geometries to the
+                 * output string instead of returning them. The create
+                 * functions return empty strings in this mode. This
+                 * avoids one or two memory allocations per geometry,
+                 * for instance when writing many geometries into a
+                 * buffer for the PostgreSQL COPY command.
+                 *
+                 * The output string must outlive the factory. If
+                 * creating a geometry fails with an exception, partial
+                 * data might have been appended to the output.
+                 */
+                WKBFactoryImpl(int srid, wkb_type wtype, out_type otype, std::string& output) :
+                    m_output(&output),
+                    m_srid(srid),
+                    m_wkb_type(wtype),
+                    m_out_type(otype) {
+                }
+
                 /* Point */
 
                 point_type make_point(const osmium::geom::Coordinates& xy) const {
+                    if (m_output) {
+                        const std::size_t start = m_output->size();
+                        header(*m_output, wkbPoint, false);
+                        str_push(*m_output, xy.x);
+                        str_push(*m_output, xy.y);
+                        if (m_out_type == out_type::hex) {
+                            convert_to_hex_in_place(*m_output, start);
+                        }
+                        return std::string{};
+                    }
+
                     std::string data;
                     header(data, wkbPoint, false);
                     str_push(data, xy.x);
@@ -178,41 +264,61 @@ namespace osmium {
                 /* LineString */
 
                 void linestring_start() {
-                    m_data.clear();
-                    m_linestring_size_offset = header(m_data, wkbLineString, true);
+                    start();
+                    m_linestring_size_offset = header(data(), wkbLineString, true);
                 }
 
                 void linestring_add_location(const osmium::geom::Coordinates& xy) {
-                    str_push(m_data, xy.x);
-                    str_push(m_data, xy.y);
+                    str_push(data(), xy.x);
+                    str_push(data(), xy.y);
                 }
 
                 linestring_type linestring_finish(std::size_t num_points) {
                     set_size(m_linestring_size_offset, num_points);
-                    std::string data;
+                    return finish();
+                }
 
-                    using std::swap;
-                    swap(data, m_data);
+                /* MultiLineString */
 
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    }
+                void multilinestring_start() {
+                    start();
+                    m_linestrings = 0;
+                    m_multilinestring_size_offset = header(data(), wkbMultiLineString, true);
+                }
 
-                    return data;
+                void multilinestring_linestring_start() {
+                    ++m_linestrings;
+                    m_points = 0;
+                    m_linestring_size_offset = header(data(), wkbLineString, true);
+                }
+
+                void multilinestring_linestring_finish() {
+                    set_size(m_linestring_size_offset, m_points);
+                }
+
+                void multilinestring_add_location(const osmium::geom::Coordinates& xy) {
+                    str_push(data(), xy.x);
+                    str_push(data(), xy.y);
+                    ++m_points;
+                }
+
+                multilinestring_type multilinestring_finish() {
+                    set_size(m_multilinestring_size_offset, m_linestrings);
+                    return finish();
                 }
 
                 /* MultiPolygon */
 
                 void multipolygon_start() {
-                    m_data.clear();
+                    start();
                     m_polygons = 0;
-                    m_multipolygon_size_offset = header(m_data, wkbMultiPolygon, true);
+                    m_multipolygon_size_offset = header(data(), wkbMultiPolygon, true);
                 }
 
                 void multipolygon_polygon_start() {
                     ++m_polygons;
                     m_rings = 0;
-                    m_polygon_size_offset = header(m_data, wkbPolygon, true);
+                    m_polygon_size_offset = header(data(), wkbPolygon, true);
                 }
 
                 void multipolygon_polygon_finish() {
@@ -222,8 +328,8 @@ namespace osmium {
                 void multipolygon_outer_ring_start() {
                     ++m_rings;
                     m_points = 0;
-                    m_ring_size_offset = m_data.size();
-                    str_push(m_data, static_cast<uint32_t>(0));
+                    m_ring_size_offset = data().size();
+                    str_push(data(), static_cast<uint32_t>(0));
                 }
 
                 void multipolygon_outer_ring_finish() {
@@ -233,8 +339,8 @@ namespace osmium {
                 void multipolygon_inner_ring_start() {
                     ++m_rings;
                     m_points = 0;
-                    m_ring_size_offset = m_data.size();
-                    str_push(m_data, static_cast<uint32_t>(0));
+                    m_ring_size_offset = data().size();
+                    str_push(data(), static_cast<uint32_t>(0));
                 }
 
                 void multipolygon_inner_ring_finish() {
@@ -242,23 +348,14 @@ namespace osmium {
                 }
 
                 void multipolygon_add_location(const osmium::geom::Coordinates& xy) {
-                    str_push(m_data, xy.x);
-                    str_push(m_data, xy.y);
+                    str_push(data(), xy.x);
+                    str_push(data(), xy.y);
                     ++m_points;
                 }
 
                 multipolygon_type multipolygon_finish() {
                     set_size(m_multipolygon_size_offset, m_polygons);
-                    std::string data;
-
-                    using std::swap;
-                    swap(data, m_data);
-
-                    if (m_out_type == out_type::hex) {
-                        return convert_to_hex(data);
-                    }
-
-                    return data;
+                    return finish();
                 }
 
             }; // class WKBFactoryImpl
@@ -61,11 +61,12 @@ namespace osmium {
 
             public:
 
-                using point_type        = std::string;
-                using linestring_type   = std::string;
-                using polygon_type      = std::string;
-                using multipolygon_type = std::string;
-                using ring_type         = std::string;
+                using point_type           = std::string;
+                using linestring_type      = std::string;
+                using polygon_type         = std::string;
+                using multipolygon_type    = std::string;
+                using ring_type            = std::string;
+                using multilinestring_type = std::string;
 
                 explicit WKTFactoryImpl(int srid, int precision = 7, wkt_type wtype = wkt_type::wkt) :
                     m_precision(precision),
@@ -86,6 +87,13 @@ namespace osmium {
                     return str;
                 }
 
+                point_type make_point(const osmium::Location& location) const {
+                    std::string str{m_srid_prefix};
+                    str += "POINT";
+                    append_location_to_string(str, location, '(', ' ', ')', m_precision);
+                    return str;
+                }
+
                 /* LineString */
 
                 void linestring_start() {
@@ -98,6 +106,11 @@ namespace osmium {
                     m_str += ',';
                 }
 
+                void linestring_add_location(const osmium::Location& location) {
+                    append_location_to_string(m_str, location, ' ', m_precision);
+                    m_str += ',';
+                }
+
                 linestring_type linestring_finish(size_t /* num_points */) {
                     assert(!m_str.empty());
                     std::string str;
@@ -109,6 +122,44 @@ namespace osmium {
                     return str;
                 }
 
+                /* MultiLineString */
+
+                void multilinestring_start() {
+                    m_str = m_srid_prefix;
+                    m_str += "MULTILINESTRING(";
+                }
+
+                void multilinestring_linestring_start() {
+                    m_str += '(';
+                }
+
+                void multilinestring_linestring_finish() {
+                    assert(!m_str.empty());
+                    m_str.back() = ')';
+                    m_str += ',';
+                }
+
+                void multilinestring_add_location(const osmium::geom::Coordinates& xy) {
+                    xy.append_to_string(m_str, ' ', m_precision);
+                    m_str += ',';
+                }
+
+                void multilinestring_add_location(const osmium::Location& location) {
+                    append_location_to_string(m_str, location, ' ', m_precision);
+                    m_str += ',';
+                }
+
+                multilinestring_type multilinestring_finish() {
+                    assert(!m_str.empty());
+                    std::string str;
+
+                    using std::swap;
+                    swap(str, m_str);
+
+                    str.back() = ')';
+                    return str;
+                }
+
                 /* Polygon */
                 void polygon_start() {
                     m_str = m_srid_prefix;
@@ -120,6 +171,11 @@ namespace osmium {
                     m_str += ',';
                 }
 
+                void polygon_add_location(const osmium::Location& location) {
+                    append_location_to_string(m_str, location, ' ', m_precision);
+                    m_str += ',';
+                }
+
                 polygon_type polygon_finish(size_t /* num_points */) {
                     assert(!m_str.empty());
                     std::string str;
@@ -170,6 +226,11 @@ namespace osmium {
                     m_str += ',';
                 }
 
+                void multipolygon_add_location(const osmium::Location& location) {
+                    append_location_to_string(m_str, location, ' ', m_precision);
+                    m_str += ',';
+                }
+
                 multipolygon_type multipolygon_finish() {
                     assert(!m_str.empty());
                     std::string str;
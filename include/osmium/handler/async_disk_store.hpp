@@ -0,0 +1,311 @@
+#ifndef OSMIUM_HANDLER_ASYNC_DISK_STORE_HPP
+#define OSMIUM_HANDLER_ASYNC_DISK_STORE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/vector_map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/util.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Writes OSM data in the Osmium-internal serialized format to disk
+         * in a background thread keeping track of the object offsets.
+         *
+         * This works like the DiskStore handler, but the buffers are
+         * handed over to a separate thread which writes them out and
+         * records the offsets of all objects in one pass over each
+         * buffer. So the thread calling this handler doesn't wait for
+         * the disk. The offsets are kept in sorted arrays (one each for
+         * nodes, ways, and relations) which are available after close()
+         * and can be written to disk with dump_indexes(). The format is
+         * the same as the one written by dump_as_list() of the
+         * SparseMemArray index, so they can be used with the sparse file
+         * array indexes for lookups.
+         *
+         * Note: This handler will only work if either all object IDs are
+         *       positive or all object IDs are negative.
+         */
+        class AsyncDiskStore {
+
+        public:
+
+            using element_type = std::pair<osmium::unsigned_object_id_type, std::size_t>;
+            using offset_index_type = std::vector<element_type>;
+
+        private:
+
+            struct offset_indexes {
+                offset_index_type nodes{};
+                offset_index_type ways{};
+                offset_index_type relations{};
+            };
+
+            osmium::thread::Queue<osmium::memory::Buffer> m_queue;
+            offset_indexes m_offsets{};
+            std::future<std::size_t> m_done{};
+            std::size_t m_bytes_written = 0;
+            osmium::thread::thread_handler m_thread{};
+            bool m_closed = false;
+
+            static void record_offsets(const osmium::memory::Buffer& buffer, std::size_t buffer_offset, offset_indexes& offsets) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    const element_type element{object.positive_id(),
+                                               buffer_offset + static_cast<std::size_t>(object.data() - buffer.data())};
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            offsets.nodes.push_back(element);
+                            break;
+                        case osmium::item_type::way:
+                            offsets.ways.push_back(element);
+                            break;
+                        default: // relation
+                            offsets.relations.push_back(element);
+                            break;
+                    }
+                }
+            }
+
+            // Runs in the background thread until an invalid buffer is
+            // read from the queue. After an error the queue is still
+            // emptied, so the producer doesn't block.
+            static void write_thread(osmium::thread::Queue<osmium::memory::Buffer>& queue, int fd, offset_indexes& offsets, std::promise<std::size_t>&& promise) {
+                osmium::thread::set_thread_name("_osmium_store");
+
+                std::size_t offset = 0;
+                bool failed = false;
+                while (true) {
+                    osmium::memory::Buffer buffer;
+                    queue.wait_and_pop(buffer);
+                    if (!buffer) {
+                        break;
+                    }
+                    if (failed) {
+                        continue;
+                    }
+                    try {
+                        osmium::io::detail::reliable_write(fd, buffer.data(), buffer.committed());
+                        record_offsets(buffer, offset, offsets);
+                        offset += buffer.committed();
+                    } catch (...) {
+                        failed = true;
+                        promise.set_exception(std::current_exception());
+                    }
+                }
+
+                if (!failed) {
+                    try {
+                        osmium::index::map::detail::sort_by_id(offsets.nodes);
+                        osmium::index::map::detail::sort_by_id(offsets.ways);
+                        osmium::index::map::detail::sort_by_id(offsets.relations);
+                        promise.set_value(offset);
+                    } catch (...) {
+                        promise.set_exception(std::current_exception());
+                    }
+                }
+            }
+
+            static void dump(const offset_index_type& offsets, const int fd) {
+                osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(element_type));
+            }
+
+            static std::size_t find(const offset_index_type& offsets, const osmium::unsigned_object_id_type id) noexcept {
+                const auto it = std::lower_bound(offsets.cbegin(), offsets.cend(), id, [](const element_type& element, osmium::unsigned_object_id_type value) {
+                    return element.first < value;
+                });
+                if (it == offsets.cend() || it->first != id) {
+                    return not_found();
+                }
+                return it->second;
+            }
+
+        public:
+
+            /// Returned by offset() for objects not in the store.
+            static constexpr std::size_t not_found() noexcept {
+                return static_cast<std::size_t>(-1);
+            }
+
+            /**
+             * Create an AsyncDiskStore writing to the specified file
+             * descriptor. This starts the background thread.
+             *
+             * @param data_fd File descriptor the data is written to.
+             * @param max_queue_size Maximum number of buffers waiting to
+             *                       be written.
+             */
+            explicit AsyncDiskStore(int data_fd, std::size_t max_queue_size = 20) :
+                m_queue(max_queue_size, "disk_store") {
+                std::promise<std::size_t> promise;
+                m_done = promise.get_future();
+                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_queue), data_fd, std::ref(m_offsets), std::move(promise)};
+            }
+
+            AsyncDiskStore(const AsyncDiskStore&) = delete;
+            AsyncDiskStore& operator=(const AsyncDiskStore&) = delete;
+
+            AsyncDiskStore(AsyncDiskStore&&) = delete;
+            AsyncDiskStore& operator=(AsyncDiskStore&&) = delete;
+
+            ~AsyncDiskStore() noexcept {
+                try {
+                    close();
+                } catch (...) { // NOLINT(bugprone-empty-catch)
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Hand the buffer over to the background thread for writing.
+             * This only blocks if too many buffers are waiting already.
+             *
+             * @throws std::system_error If an earlier write failed.
+             * @throws osmium::io_error If the store was closed.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                if (m_closed) {
+                    throw osmium::io_error{"Can not write to AsyncDiskStore after close()"};
+                }
+                osmium::thread::check_for_exception(m_done);
+                if (buffer && buffer.committed() > 0) {
+                    m_queue.push(std::move(buffer));
+                }
+            }
+
+            /**
+             * Copy the buffer and hand the copy over to the background
+             * thread for writing.
+             *
+             * @throws std::system_error If an earlier write failed.
+             * @throws osmium::io_error If the store was closed.
+             */
+            void operator()(const osmium::memory::Buffer& buffer) {
+                if (buffer && buffer.committed() > 0) {
+                    osmium::memory::Buffer copy{buffer.committed(), osmium::memory::Buffer::auto_grow::no};
+                    copy.add_buffer(buffer);
+                    copy.commit();
+                    (*this)(std::move(copy));
+                }
+            }
+
+            /**
+             * Wait until all buffers are written and the offsets are
+             * sorted. Call this before using any of the offsets. Can be
+             * called several times.
+             *
+             * @returns The number of bytes written.
+             * @throws std::system_error If writing failed.
+             */
+            std::size_t close() {
+                if (!m_closed) {
+                    m_closed = true;
+                    m_queue.push(osmium::memory::Buffer{});
+                }
+                if (m_done.valid()) {
+                    m_bytes_written = m_done.get();
+                }
+                return m_bytes_written;
+            }
+
+            /// The sorted offsets of all nodes. Only valid after close().
+            const offset_index_type& node_offsets() const noexcept {
+                return m_offsets.nodes;
+            }
+
+            /// The sorted offsets of all ways. Only valid after close().
+            const offset_index_type& way_offsets() const noexcept {
+                return m_offsets.ways;
+            }
+
+            /// The sorted offsets of all relations. Only valid after close().
+            const offset_index_type& relation_offsets() const noexcept {
+                return m_offsets.relations;
+            }
+
+            /**
+             * The offset of the object with the specified type and ID in
+             * the data file or not_found(). Only valid after close().
+             */
+            std::size_t offset(osmium::item_type type, osmium::unsigned_object_id_type id) const noexcept {
+                switch (type) {
+                    case osmium::item_type::node:
+                        return find(m_offsets.nodes, id);
+                    case osmium::item_type::way:
+                        return find(m_offsets.ways, id);
+                    case osmium::item_type::relation:
+                        return find(m_offsets.relations, id);
+                    default:
+                        break;
+                }
+                return not_found();
+            }
+
+            /**
+             * Write the offset indexes to the specified file descriptors
+             * as compact sorted arrays of (ID, offset) pairs. This calls
+             * close() first.
+             *
+             * @throws std::system_error If writing failed.
+             */
+            void dump_indexes(const int node_fd, const int way_fd, const int relation_fd) {
+                close();
+                dump(m_offsets.nodes, node_fd);
+                dump(m_offsets.ways, way_fd);
+                dump(m_offsets.relations, relation_fd);
+            }
+
+        }; // class AsyncDiskStore
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_ASYNC_DISK_STORE_HPP
@@ -0,0 +1,295 @@
+#ifndef OSMIUM_HANDLER_CHANGESET_TABLE_HPP
+#define OSMIUM_HANDLER_CHANGESET_TABLE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/handler.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace handler {
+
+        namespace detail {
+
+            /**
+             * Stores each distinct string once and hands out 32bit indexes
+             * for them. Index 0 is always the empty string.
+             */
+            class string_dictionary {
+
+                std::vector<std::string> m_strings{std::string{}};
+                std::unordered_map<std::string, uint32_t> m_index{{std::string{}, 0}};
+
+            public:
+
+                uint32_t add(const char* str) {
+                    if (!*str) {
+                        return 0;
+                    }
+                    const auto result = m_index.emplace(str, static_cast<uint32_t>(m_strings.size()));
+                    if (result.second) {
+                        m_strings.push_back(result.first->first);
+                    }
+                    return result.first->second;
+                }
+
+                const std::string& get(const uint32_t index) const {
+                    assert(index < m_strings.size());
+                    return m_strings[index];
+                }
+
+                std::size_t size() const noexcept {
+                    return m_strings.size();
+                }
+
+                // Each string is stored twice, in the vector and as key
+                // in the map.
+                std::size_t used_memory() const noexcept {
+                    std::size_t size = m_strings.capacity() * sizeof(std::string) +
+                                       m_index.bucket_count() * sizeof(void*) +
+                                       m_index.size() * (sizeof(std::string) + sizeof(uint32_t) + sizeof(void*));
+                    for (const auto& str : m_strings) {
+                        size += 2 * str.capacity();
+                    }
+                    return size;
+                }
+
+            }; // class string_dictionary
+
+        } // namespace detail
+
+        /**
+         * Handler storing the changesets it sees in a compact columnar
+         * layout for analytics queries. Each attribute of the changesets
+         * is stored in its own vector, all vectors have the same size and
+         * the changesets are kept in the order they were seen. User names
+         * and the values of the tags selected in the constructor are
+         * dictionary encoded. Discussions are not stored.
+         *
+         * To read a large changeset file fast, use a Reader with the
+         * options osmium::io::parallel_decompression::yes and
+         * osmium::io::xml_tokenizer::builtin. The table is copyable and
+         * can be merged with append(), so it can also be used with
+         * osmium::apply_parallel() in ordered mode.
+         */
+        class ChangesetTable : public osmium::handler::Handler {
+
+            std::vector<std::string> m_tag_keys;
+
+            std::vector<osmium::changeset_id_type> m_ids;
+            std::vector<osmium::user_id_type> m_uids;
+            std::vector<uint32_t> m_users;
+            std::vector<osmium::Timestamp> m_created_at;
+            std::vector<osmium::Timestamp> m_closed_at;
+            std::vector<osmium::num_changes_type> m_num_changes;
+            std::vector<osmium::num_comments_type> m_num_comments;
+            std::vector<osmium::Box> m_bounds;
+
+            // One column for each tag key in m_tag_keys
+            std::vector<std::vector<uint32_t>> m_tags;
+
+            detail::string_dictionary m_strings;
+
+        public:
+
+            /**
+             * Construct table.
+             *
+             * @param tag_keys The values of the tags with these keys are
+             *                 stored in columns of their own.
+             */
+            explicit ChangesetTable(std::vector<std::string> tag_keys = {}) :
+                m_tag_keys(std::move(tag_keys)),
+                m_tags(m_tag_keys.size()) {
+            }
+
+            void changeset(const osmium::Changeset& changeset) {
+                m_ids.push_back(changeset.id());
+                m_uids.push_back(changeset.uid());
+                m_users.push_back(m_strings.add(changeset.user()));
+                m_created_at.push_back(changeset.created_at());
+                m_closed_at.push_back(changeset.closed_at());
+                m_num_changes.push_back(changeset.num_changes());
+                m_num_comments.push_back(changeset.num_comments());
+                m_bounds.push_back(changeset.bounds());
+                for (std::size_t i = 0; i < m_tag_keys.size(); ++i) {
+                    const char* value = changeset.tags().get_value_by_key(m_tag_keys[i].c_str(), "");
+                    m_tags[i].push_back(m_strings.add(value));
+                }
+            }
+
+            /**
+             * Add all changesets from the other table at the end of this
+             * table. Both tables must have been constructed with the same
+             * tag keys.
+             */
+            void append(ChangesetTable&& other) {
+                assert(m_tag_keys == other.m_tag_keys);
+                m_ids.insert(m_ids.end(), other.m_ids.begin(), other.m_ids.end());
+                m_uids.insert(m_uids.end(), other.m_uids.begin(), other.m_uids.end());
+                m_created_at.insert(m_created_at.end(), other.m_created_at.begin(), other.m_created_at.end());
+                m_closed_at.insert(m_closed_at.end(), other.m_closed_at.begin(), other.m_closed_at.end());
+                m_num_changes.insert(m_num_changes.end(), other.m_num_changes.begin(), other.m_num_changes.end());
+                m_num_comments.insert(m_num_comments.end(), other.m_num_comments.begin(), other.m_num_comments.end());
+                m_bounds.insert(m_bounds.end(), other.m_bounds.begin(), other.m_bounds.end());
+
+                // Map the string indexes of the other table to this one.
+                std::vector<uint32_t> map;
+                map.reserve(other.m_strings.size());
+                for (std::size_t i = 0; i < other.m_strings.size(); ++i) {
+                    map.push_back(m_strings.add(other.m_strings.get(static_cast<uint32_t>(i)).c_str()));
+                }
+                for (const auto user : other.m_users) {
+                    m_users.push_back(map[user]);
+                }
+                for (std::size_t i = 0; i < m_tags.size(); ++i) {
+                    for (const auto value : other.m_tags[i]) {
+                        m_tags[i].push_back(map[value]);
+                    }
+                }
+                other.clear();
+            }
+
+            /// The number of changesets in the table.
+            std::size_t size() const noexcept {
+                return m_ids.size();
+            }
+
+            bool empty() const noexcept {
+                return m_ids.empty();
+            }
+
+            const std::vector<osmium::changeset_id_type>& ids() const noexcept {
+                return m_ids;
+            }
+
+            const std::vector<osmium::user_id_type>& uids() const noexcept {
+                return m_uids;
+            }
+
+            /**
+             * The user names as indexes into the string dictionary. Use
+             * string() to get the names.
+             */
+            const std::vector<uint32_t>& users() const noexcept {
+                return m_users;
+            }
+
+            const std::vector<osmium::Timestamp>& created_at() const noexcept {
+                return m_created_at;
+            }
+
+            /// Closing times, invalid timestamps for open changesets.
+            const std::vector<osmium::Timestamp>& closed_at() const noexcept {
+                return m_closed_at;
+            }
+
+            const std::vector<osmium::num_changes_type>& num_changes() const noexcept {
+                return m_num_changes;
+            }
+
+            const std::vector<osmium::num_comments_type>& num_comments() const noexcept {
+                return m_num_comments;
+            }
+
+            const std::vector<osmium::Box>& bounds() const noexcept {
+                return m_bounds;
+            }
+
+            /**
+             * The values of the tag with the n-th key given in the
+             * constructor as indexes into the string dictionary. Index 0
+             * (the empty string) is used for changesets without this tag.
+             */
+            const std::vector<uint32_t>& tag_values(const std::size_t n) const {
+                assert(n < m_tags.size());
+                return m_tags[n];
+            }
+
+            /// Get string from the dictionary.
+            const std::string& string(const uint32_t index) const {
+                return m_strings.get(index);
+            }
+
+            /// The user name of the n-th changeset.
+            const std::string& user(const std::size_t n) const {
+                assert(n < size());
+                return m_strings.get(m_users[n]);
+            }
+
+            /// The number of distinct strings in the dictionary.
+            std::size_t num_strings() const noexcept {
+                return m_strings.size();
+            }
+
+            std::size_t used_memory() const noexcept {
+                std::size_t size = m_ids.capacity() * sizeof(osmium::changeset_id_type) +
+                                   m_uids.capacity() * sizeof(osmium::user_id_type) +
+                                   m_users.capacity() * sizeof(uint32_t) +
+                                   m_created_at.capacity() * sizeof(osmium::Timestamp) +
+                                   m_closed_at.capacity() * sizeof(osmium::Timestamp) +
+                                   m_num_changes.capacity() * sizeof(osmium::num_changes_type) +
+                                   m_num_comments.capacity() * sizeof(osmium::num_comments_type) +
+                                   m_bounds.capacity() * sizeof(osmium::Box) +
+                                   m_strings.used_memory();
+                for (const auto& column : m_tags) {
+                    size += column.capacity() * sizeof(uint32_t);
+                }
+                return size;
+            }
+
+            /// Remove all changesets and strings.
+            void clear() {
+                *this = ChangesetTable{std::move(m_tag_keys)};
+            }
+
+        }; // class ChangesetTable
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_CHANGESET_TABLE_HPP
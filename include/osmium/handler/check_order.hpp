@@ -34,12 +34,16 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/object_comparisons.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
+#include <cstddef>
 #include <limits>
 #include <stdexcept>
 #include <string>
@@ -66,6 +70,26 @@ namespace osmium {
 
     }; // struct out_of_order_error
 
+    /**
+     * Summary of the objects in a buffer as returned by
+     * CheckOrder::check_buffer().
+     */
+    struct order_summary {
+
+        /// Types of the OSM objects (nodes, ways, relations) in the buffer.
+        osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+        /// Smallest ID of any of those objects.
+        osmium::object_id_type min_id = std::numeric_limits<osmium::object_id_type>::max();
+
+        /// Largest ID of any of those objects.
+        osmium::object_id_type max_id = std::numeric_limits<osmium::object_id_type>::min();
+
+        /// Number of those objects.
+        std::size_t count = 0;
+
+    }; // struct order_summary
+
     namespace handler {
 
         /**
@@ -90,6 +114,25 @@ namespace osmium {
             osmium::object_id_type m_max_way_id      = std::numeric_limits<osmium::object_id_type>::min();
             osmium::object_id_type m_max_relation_id = std::numeric_limits<osmium::object_id_type>::min();
 
+            // Check one object, returns a pointer to the member with the
+            // largest ID for its type or nullptr if it isn't checked.
+            osmium::object_id_type* check_object(const osmium::OSMObject& object) {
+                switch (object.type()) {
+                    case osmium::item_type::node:
+                        node(static_cast<const osmium::Node&>(object));
+                        return &m_max_node_id;
+                    case osmium::item_type::way:
+                        way(static_cast<const osmium::Way&>(object));
+                        return &m_max_way_id;
+                    case osmium::item_type::relation:
+                        relation(static_cast<const osmium::Relation&>(object));
+                        return &m_max_relation_id;
+                    default:
+                        break;
+                }
+                return nullptr;
+            }
+
         public:
 
             void node(const osmium::Node& node) {
@@ -133,6 +176,59 @@ namespace osmium {
                 m_max_relation_id = relation.id();
             }
 
+            /**
+             * Check the order of all nodes, ways, and relations in the
+             * buffer. This is the same as calling node(), way(), and
+             * relation() for each object, but the common case of an object
+             * of the same type as the one before is handled in a tight
+             * loop with one comparison.
+             *
+             * @returns Summary of the objects in the buffer.
+             * @throws out_of_order_error if the input is not in order.
+             */
+            order_summary check_buffer(const osmium::memory::Buffer& buffer) {
+                order_summary summary;
+                osmium::item_type type = osmium::item_type::undefined;
+                osmium::object_id_type* max_id = nullptr;
+                osmium::object_id_type last_id = 0;
+
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    const osmium::object_id_type id = object.id();
+                    if (object.type() == type) {
+                        if (!id_order{}(last_id, id)) {
+                            // Slow path only to throw the right error.
+                            *max_id = last_id;
+                            check_object(object);
+                        }
+                    } else {
+                        if (max_id) {
+                            *max_id = last_id;
+                        }
+                        max_id = check_object(object);
+                        if (!max_id) {
+                            // Areas are not checked.
+                            type = osmium::item_type::undefined;
+                            continue;
+                        }
+                        type = object.type();
+                        summary.types |= osmium::osm_entity_bits::from_item_type(type);
+                    }
+                    last_id = id;
+                    if (id < summary.min_id) {
+                        summary.min_id = id;
+                    }
+                    if (id > summary.max_id) {
+                        summary.max_id = id;
+                    }
+                    ++summary.count;
+                }
+
+                if (max_id) {
+                    *max_id = last_id;
+                }
+                return summary;
+            }
+
             osmium::object_id_type max_node_id() const noexcept {
                 return m_max_node_id;
             }
@@ -0,0 +1,232 @@
+#ifndef OSMIUM_HANDLER_EXTRACT_FILTER_HPP
+#define OSMIUM_HANDLER_EXTRACT_FILTER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/area/polygon_index.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * Handler that sorts objects into extracts, one for each polygon
+         * in a PolygonIndex:
+         *
+         * - Nodes are in an extract if their location is inside the
+         *   polygon.
+         * - Ways are in an extract if any of their nodes is.
+         * - Relations are in an extract if any of their member nodes or
+         *   ways or any of their member relations seen earlier is.
+         *
+         * This is the "simple" extract strategy, ways and relations are
+         * not completed with nodes outside the polygon. The input must
+         * be ordered in the usual way (nodes, then ways, then
+         * relations). If the ways have node locations (from the
+         * NodeLocationsForWays handler), the polygon index is used for
+         * them which is much faster with many extracts than checking the
+         * node ids.
+         *
+         * The objects are copied into one buffer per extract. Whenever a
+         * buffer has reached the configured size, the callback is called
+         * with the extract id and the buffer. Call flush() at the end to
+         * get the remaining buffers.
+         */
+        class ExtractFilter : public osmium::handler::Handler {
+
+        public:
+
+            using callback_type = std::function<void(std::size_t, osmium::memory::Buffer&&)>;
+
+        private:
+
+            enum {
+                initial_buffer_size = 16UL * 1024UL
+            };
+
+            struct extract {
+                osmium::memory::Buffer buffer{};
+                osmium::index::IdSetDense<osmium::unsigned_object_id_type> node_ids{};
+                osmium::index::IdSetDense<osmium::unsigned_object_id_type> way_ids{};
+                osmium::index::IdSetDense<osmium::unsigned_object_id_type> relation_ids{};
+            };
+
+            const osmium::area::PolygonIndex* m_index;
+            callback_type m_callback;
+            std::vector<extract> m_extracts;
+            std::vector<std::size_t> m_matches;
+            std::vector<bool> m_matched;
+            std::size_t m_buffer_size;
+
+            void match(std::size_t id) {
+                if (!m_matched[id]) {
+                    m_matched[id] = true;
+                    m_matches.push_back(id);
+                }
+            }
+
+            void add_to_matches(const osmium::OSMObject& object) {
+                std::sort(m_matches.begin(), m_matches.end());
+                for (const auto id : m_matches) {
+                    m_matched[id] = false;
+
+                    auto& e = m_extracts[id];
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            e.node_ids.set(object.positive_id());
+                            break;
+                        case osmium::item_type::way:
+                            e.way_ids.set(object.positive_id());
+                            break;
+                        default:
+                            e.relation_ids.set(object.positive_id());
+                            break;
+                    }
+
+                    if (!e.buffer) {
+                        e.buffer = osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                    }
+                    e.buffer.add_item(object);
+                    e.buffer.commit();
+                    if (e.buffer.committed() >= m_buffer_size) {
+                        osmium::memory::Buffer buffer{std::move(e.buffer)};
+                        e.buffer = osmium::memory::Buffer{};
+                        m_callback(id, std::move(buffer));
+                    }
+                }
+                m_matches.clear();
+            }
+
+        public:
+
+            /**
+             * Create an ExtractFilter.
+             *
+             * @param index Polygons of the extracts. Must outlive the
+             *              filter.
+             * @param callback Function called with full buffers.
+             * @param buffer_size Buffers are handed to the callback once
+             *                    they contain this many bytes.
+             */
+            ExtractFilter(const osmium::area::PolygonIndex& index, callback_type callback, std::size_t buffer_size = 1024UL * 1024UL) :
+                m_index(&index),
+                m_callback(std::move(callback)),
+                m_extracts(index.size()),
+                m_matched(index.size()),
+                m_buffer_size(buffer_size) {
+            }
+
+            void node(const osmium::Node& node) {
+                m_index->for_each_containing(node.location(), [this](std::size_t id) {
+                    m_matches.push_back(id);
+                });
+                add_to_matches(node);
+            }
+
+            void way(const osmium::Way& way) {
+                for (const auto& node_ref : way.nodes()) {
+                    if (node_ref.location().valid()) {
+                        m_index->for_each_containing(node_ref.location(), [this](std::size_t id) {
+                            match(id);
+                        });
+                    } else {
+                        for (std::size_t id = 0; id < m_extracts.size(); ++id) {
+                            if (m_extracts[id].node_ids.get(node_ref.positive_ref())) {
+                                match(id);
+                            }
+                        }
+                    }
+                }
+                add_to_matches(way);
+            }
+
+            void relation(const osmium::Relation& relation) {
+                for (std::size_t id = 0; id < m_extracts.size(); ++id) {
+                    const auto& e = m_extracts[id];
+                    const bool found = std::any_of(relation.members().begin(), relation.members().end(), [&e](const osmium::RelationMember& member) {
+                        switch (member.type()) {
+                            case osmium::item_type::node:
+                                return e.node_ids.get(member.positive_ref());
+                            case osmium::item_type::way:
+                                return e.way_ids.get(member.positive_ref());
+                            case osmium::item_type::relation:
+                                return e.relation_ids.get(member.positive_ref());
+                            default:
+                                return false;
+                        }
+                    });
+                    if (found) {
+                        m_matches.push_back(id);
+                    }
+                }
+                add_to_matches(relation);
+            }
+
+            /**
+             * Hand all remaining non-empty buffers to the callback in order
+             * of the extract ids.
+             */
+            void flush() {
+                for (std::size_t id = 0; id < m_extracts.size(); ++id) {
+                    auto& e = m_extracts[id];
+                    if (e.buffer && e.buffer.committed() > 0) {
+                        osmium::memory::Buffer buffer{std::move(e.buffer)};
+                        e.buffer = osmium::memory::Buffer{};
+                        m_callback(id, std::move(buffer));
+                    }
+                }
+            }
+
+        }; // class ExtractFilter
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_EXTRACT_FILTER_HPP
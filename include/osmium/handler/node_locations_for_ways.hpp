@@ -34,17 +34,21 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/handler.hpp>
+#include <osmium/index/envelope_cache.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map/dummy.hpp>
 #include <osmium/index/node_locations_map.hpp>
+#include <osmium/memory/buffer.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/node_ref.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
+#include <cstddef>
 #include <limits>
 #include <type_traits>
+#include <vector>
 
 namespace osmium {
 
@@ -55,6 +59,13 @@ namespace osmium {
         /**
          * Handler to retrieve locations from nodes and add them to ways.
          *
+         * When the storage classes allow concurrent set() calls (such as
+         * ConcurrentDenseMmapArray and ConcurrentSparseMemArray), nodes
+         * can be handled in several threads at once, each with its own
+         * handler object using the same storage. Call sort() on the
+         * storage once after all nodes are handled and before any ways
+         * are handled.
+         *
          * @tparam TStoragePosIDs Class that handles the actual storage of the node locations
          *                        (for positive IDs). It must support the set(id, value) and
          *                        get(id) methods.
@@ -88,6 +99,15 @@ namespace osmium {
 
             bool m_must_sort = false;
 
+            osmium::index::EnvelopeCache* m_envelope_cache = nullptr;
+
+            // Scratch space for batched lookups, reused to avoid allocations.
+            std::vector<osmium::unsigned_object_id_type> m_ids_pos;
+            std::vector<osmium::unsigned_object_id_type> m_ids_neg;
+            std::vector<osmium::NodeRef*> m_refs_pos;
+            std::vector<osmium::NodeRef*> m_refs_neg;
+            std::vector<osmium::Location> m_locations;
+
             // It is okay to have this static dummy instance, even when using several threads,
             // because it is read-only.
             static dummy_type& get_dummy() {
@@ -115,6 +135,16 @@ namespace osmium {
                 m_ignore_errors = true;
             }
 
+            /**
+             * Add the envelopes of all ways handled from now on to this
+             * cache. They are calculated right after the locations are
+             * added. The cache must outlive this handler or be unset (by
+             * calling this with nullptr) before it is destroyed.
+             */
+            void set_envelope_cache(osmium::index::EnvelopeCache* cache) noexcept {
+                m_envelope_cache = cache;
+            }
+
             /**
              * Store the location of the node in the storage.
              */
@@ -142,29 +172,134 @@ namespace osmium {
                 return m_storage_neg.get_noexcept(static_cast<osmium::unsigned_object_id_type>(-id));
             }
 
-            /**
-             * Retrieve locations of all nodes in the way from storage and add
-             * them to the way object.
-             */
-            void way(osmium::Way& way) {
+        private:
+
+            void sort_if_needed() {
                 if (m_must_sort) {
                     m_storage_pos.sort();
                     m_storage_neg.sort();
                     m_must_sort = false;
                     m_last_id = std::numeric_limits<osmium::unsigned_object_id_type>::max();
                 }
-                bool error = false;
+            }
+
+            void gather(osmium::Way& way) {
                 for (auto& node_ref : way.nodes()) {
-                    node_ref.set_location(get_node_location(node_ref.ref()));
-                    if (!node_ref.location()) {
+                    const auto id = node_ref.ref();
+                    if (id >= 0) {
+                        m_ids_pos.push_back(static_cast<osmium::unsigned_object_id_type>(id));
+                        m_refs_pos.push_back(&node_ref);
+                    } else {
+                        m_ids_neg.push_back(static_cast<osmium::unsigned_object_id_type>(-id));
+                        m_refs_neg.push_back(&node_ref);
+                    }
+                }
+            }
+
+            template <typename TStorage>
+            bool resolve(const TStorage& storage, const std::vector<osmium::unsigned_object_id_type>& ids, const std::vector<osmium::NodeRef*>& refs) {
+                if (ids.empty()) {
+                    return false;
+                }
+                m_locations.resize(ids.size());
+                storage.get_many(ids.data(), ids.size(), m_locations.data());
+                bool error = false;
+                for (std::size_t i = 0; i < refs.size(); ++i) {
+                    refs[i]->set_location(m_locations[i]);
+                    if (!m_locations[i]) {
                         error = true;
                     }
                 }
+                return error;
+            }
+
+            // Look up all gathered node refs in the storage and set their
+            // locations. Returns true if any location was not found.
+            bool resolve_gathered() {
+                const bool error_pos = resolve(m_storage_pos, m_ids_pos, m_refs_pos);
+                const bool error_neg = resolve(m_storage_neg, m_ids_neg, m_refs_neg);
+
+                m_ids_pos.clear();
+                m_ids_neg.clear();
+                m_refs_pos.clear();
+                m_refs_neg.clear();
+
+                return error_pos || error_neg;
+            }
+
+            void check_error(const bool error) const {
                 if (!m_ignore_errors && error) {
                     throw osmium::not_found{"location for one or more nodes not found in node location index"};
                 }
             }
 
+        public:
+
+            /**
+             * Retrieve locations of all nodes in the way from storage and add
+             * them to the way object.
+             */
+            void way(osmium::Way& way) {
+                sort_if_needed();
+                gather(way);
+                const bool error = resolve_gathered();
+                if (m_envelope_cache) {
+                    m_envelope_cache->add(way);
+                }
+                check_error(error);
+            }
+
+            /**
+             * Retrieve locations of all nodes in all ways in the buffer
+             * from storage and add them to the ways. This does the same as
+             * calling way() for each way, but all lookups are done in one
+             * batch, so the storage can overlap the memory accesses.
+             *
+             * Use this instead of way() when handling whole buffers. Call
+             * it after the nodes in the buffer are handled.
+             *
+             * @throws osmium::not_found if a location is not found and
+             *         ignore_errors() was not called. All ways are still
+             *         updated in this case.
+             */
+            void ways(osmium::memory::Buffer& buffer) {
+                sort_if_needed();
+                for (auto& way : buffer.select<osmium::Way>()) {
+                    gather(way);
+                }
+                const bool error = resolve_gathered();
+                if (m_envelope_cache) {
+                    for (const auto& way : buffer.select<osmium::Way>()) {
+                        m_envelope_cache->add(way);
+                    }
+                }
+                check_error(error);
+            }
+
+            /**
+             * Tell the storage which node locations the ways in this
+             * buffer will need. Call this for the next buffer before
+             * calling ways() for the current one, then file based indexes
+             * (like DenseFileArray) can read the pages needed for the next
+             * buffer in the background while the current one is handled.
+             */
+            void prefetch(const osmium::memory::Buffer& buffer) {
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    for (const auto& node_ref : way.nodes()) {
+                        const auto id = node_ref.ref();
+                        if (id >= 0) {
+                            m_ids_pos.push_back(static_cast<osmium::unsigned_object_id_type>(id));
+                        } else {
+                            m_ids_neg.push_back(static_cast<osmium::unsigned_object_id_type>(-id));
+                        }
+                    }
+                }
+                m_storage_pos.prefetch(m_ids_pos.data(), m_ids_pos.size());
+                m_storage_neg.prefetch(m_ids_neg.data(), m_ids_neg.size());
+                m_ids_pos.clear();
+                m_ids_neg.clear();
+            }
+
             /**
              * Call clear on the location indexes. Makes the
              * NodeLocationsForWays handler unusable. Used to explicitly free
@@ -177,6 +312,68 @@ namespace osmium {
 
         }; // class NodeLocationsForWays
 
+        /**
+         * Function object adding node locations from the storage to all
+         * ways in a buffer. It does the same as NodeLocationsForWays::ways(),
+         * but can be called from several threads at once, so it can be
+         * used with the osmium::io::buffer_transform option of the Reader.
+         * The locations are then added in the threads of the pool decoding
+         * the input and the buffers returned from Reader::read() already
+         * have the locations set:
+         *
+         * @code
+         * osmium::io::Reader reader{"ways.osm.pbf", osmium::osm_entity_bits::way,
+         *     osmium::io::buffer_transform{NodeLocationsForWaysTransform<index_type>{index}}};
+         * @endcode
+         *
+         * The storage is only read. It must be complete and sorted (call
+         * sort() if the nodes were not sorted) before reading starts, and
+         * must not be changed while the Reader is running.
+         *
+         * @tparam TStoragePosIDs Class that handles the actual storage of the node locations
+         *                        (for positive IDs).
+         * @tparam TStorageNegIDs Same but for negative IDs.
+         */
+        template <typename TStoragePosIDs, typename TStorageNegIDs = dummy_type>
+        class NodeLocationsForWaysTransform {
+
+            TStoragePosIDs* m_storage_pos;
+            TStorageNegIDs* m_storage_neg;
+            bool m_ignore_errors = false;
+
+            static dummy_type& get_dummy() {
+                static dummy_type instance;
+                return instance;
+            }
+
+        public:
+
+            explicit NodeLocationsForWaysTransform(TStoragePosIDs& storage_pos,
+                                                   TStorageNegIDs& storage_neg = get_dummy()) noexcept :
+                m_storage_pos(&storage_pos),
+                m_storage_neg(&storage_neg) {
+            }
+
+            void ignore_errors() noexcept {
+                m_ignore_errors = true;
+            }
+
+            /**
+             * Add locations to all ways in the buffer.
+             *
+             * @throws osmium::not_found if a location is not found and
+             *         ignore_errors() was not called.
+             */
+            void operator()(osmium::memory::Buffer& buffer) const {
+                NodeLocationsForWays<TStoragePosIDs, TStorageNegIDs> handler{*m_storage_pos, *m_storage_neg};
+                if (m_ignore_errors) {
+                    handler.ignore_errors();
+                }
+                handler.ways(buffer);
+            }
+
+        }; // class NodeLocationsForWaysTransform
+
     } // namespace handler
 
 } // namespace osmium
@@ -0,0 +1,152 @@
+#ifndef OSMIUM_HANDLER_OBJECT_BACK_REFERENCES_HPP
+#define OSMIUM_HANDLER_OBJECT_BACK_REFERENCES_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/handler.hpp>
+#include <osmium/index/back_references.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+namespace osmium {
+
+    namespace handler {
+
+        /**
+         * This handler builds compact indexes from objects to the ways
+         * and relations referencing them. Unlike the ObjectRelations
+         * handler it needs two passes over the same data:
+         *
+         * @code
+         * osmium::handler::ObjectBackReferences refs;
+         * osmium::apply(reader1, refs); // counts references
+         * refs.prepare();
+         * osmium::apply(reader2, refs); // fills in the indexes
+         * const auto ways = refs.node_to_ways().get_all(node_id);
+         * @endcode
+         *
+         * See osmium::index::BackReferences for details.
+         *
+         * Note: This handler will only work if either all object IDs are
+         *       positive or all object IDs are negative.
+         */
+        class ObjectBackReferences : public osmium::handler::Handler {
+
+        public:
+
+            using index_type = osmium::index::BackReferences<osmium::unsigned_object_id_type>;
+
+        private:
+
+            index_type m_index_n2w;
+            index_type m_index_n2r;
+            index_type m_index_w2r;
+            index_type m_index_r2r;
+
+            void add(index_type& index, const osmium::unsigned_object_id_type id, const osmium::unsigned_object_id_type value) {
+                if (index.prepared()) {
+                    index.set(id, value);
+                } else {
+                    index.reserve(id);
+                }
+            }
+
+        public:
+
+            ObjectBackReferences() = default;
+
+            /**
+             * Switch from counting to filling in the indexes. Call this
+             * between the first and the second pass.
+             */
+            void prepare() {
+                m_index_n2w.prepare();
+                m_index_n2r.prepare();
+                m_index_w2r.prepare();
+                m_index_r2r.prepare();
+            }
+
+            void way(const osmium::Way& way) {
+                for (const auto& node_ref : way.nodes()) {
+                    add(m_index_n2w, node_ref.positive_ref(), way.positive_id());
+                }
+            }
+
+            void relation(const osmium::Relation& relation) {
+                for (const auto& member : relation.members()) {
+                    switch (member.type()) {
+                        case osmium::item_type::node:
+                            add(m_index_n2r, member.positive_ref(), relation.positive_id());
+                            break;
+                        case osmium::item_type::way:
+                            add(m_index_w2r, member.positive_ref(), relation.positive_id());
+                            break;
+                        case osmium::item_type::relation:
+                            add(m_index_r2r, member.positive_ref(), relation.positive_id());
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+
+            /// Index from node ids to the ids of the ways they are in.
+            const index_type& node_to_ways() const noexcept {
+                return m_index_n2w;
+            }
+
+            /// Index from node ids to the ids of the relations they are in.
+            const index_type& node_to_relations() const noexcept {
+                return m_index_n2r;
+            }
+
+            /// Index from way ids to the ids of the relations they are in.
+            const index_type& way_to_relations() const noexcept {
+                return m_index_w2r;
+            }
+
+            /// Index from relation ids to the ids of their parent relations.
+            const index_type& relation_to_relations() const noexcept {
+                return m_index_r2r;
+            }
+
+        }; // class ObjectBackReferences
+
+    } // namespace handler
+
+} // namespace osmium
+
+#endif // OSMIUM_HANDLER_OBJECT_BACK_REFERENCES_HPP
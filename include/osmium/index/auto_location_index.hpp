@@ -0,0 +1,371 @@
+#ifndef OSMIUM_INDEX_AUTO_LOCATION_INDEX_HPP
+#define OSMIUM_INDEX_AUTO_LOCATION_INDEX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/map.hpp>
+#include <osmium/index/map/dense_file_array.hpp>
+#include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * What is known about the input data when choosing a node
+         * location index with choose_location_index(). Everything is
+         * optional, the more is known, the better the choice.
+         */
+        struct location_index_input {
+
+            enum : uint64_t {
+                /// Assumed largest node ID if nothing else is known.
+                default_max_id = 13000000000ULL
+            };
+
+            /// Size of the input file in bytes (0 if unknown).
+            std::size_t file_size = 0;
+
+            /// Format of the input file.
+            osmium::io::file_format format = osmium::io::file_format::unknown;
+
+            /// Compression of the input file.
+            osmium::io::file_compression compression = osmium::io::file_compression::none;
+
+            /// Expected number of nodes (0 if unknown).
+            std::size_t node_count = 0;
+
+            /// Largest node ID expected (0 if unknown).
+            osmium::unsigned_object_id_type max_id = 0;
+
+            /// Bounding box from the file header (invalid if unknown).
+            osmium::Box bbox{};
+
+            /// Is this a planet file (or a large part of it)?
+            bool planet = false;
+
+            /// Are there nodes with negative IDs?
+            bool negative_ids = false;
+
+            /// Memory available for the index in bytes (0 to detect).
+            std::size_t available_memory = 0;
+
+            /**
+             * Set file size, format and compression from the file. The
+             * size is not set if the file can not be accessed, for instance
+             * when reading from stdin.
+             */
+            void set_file(const osmium::io::File& file) {
+                format = file.format();
+                compression = file.compression();
+                if (!file.filename().empty() && file.filename() != "-") {
+                    try {
+                        file_size = osmium::file_size(file.filename());
+                    } catch (...) {
+                        file_size = 0;
+                    }
+                }
+            }
+
+            /**
+             * Set bounding box and planet flag from the header of the input
+             * file. Files with a bounding box covering the whole world or
+             * with replication information from planet diffs are considered
+             * planet files.
+             */
+            void set_header(const osmium::io::Header& header) {
+                bbox = header.joined_boxes();
+                if (bbox.valid()) {
+                    const int64_t width = int64_t{bbox.top_right().x()} - bbox.bottom_left().x();
+                    const int64_t height = int64_t{bbox.top_right().y()} - bbox.bottom_left().y();
+                    if (width >= int64_t{340} * osmium::detail::coordinate_precision &&
+                        height >= int64_t{150} * osmium::detail::coordinate_precision) {
+                        planet = true;
+                    }
+                }
+                if (header.get("osmosis_replication_base_url").find("planet") != std::string::npos) {
+                    planet = true;
+                }
+            }
+
+        }; // struct location_index_input
+
+        /**
+         * The result of choose_location_index().
+         */
+        struct location_index_choice {
+
+            /// Map type for the node locations with positive IDs.
+            std::string map_type;
+
+            /// Map type for negative IDs (empty if none are expected).
+            std::string negative_map_type;
+
+            /// Estimated number of nodes (0 if unknown).
+            std::size_t estimated_nodes = 0;
+
+            /// Estimated memory or disk space needed in bytes.
+            std::size_t estimated_bytes = 0;
+
+            /// Human readable explanation of the choice.
+            std::string reason;
+
+        }; // struct location_index_choice
+
+        namespace detail {
+
+            /**
+             * Rough number of bytes in an input file per node. These are
+             * taken from planet and extract files, the nodes make up most
+             * of the objects in a typical file.
+             */
+            inline std::size_t bytes_per_node(const osmium::io::file_format format, const osmium::io::file_compression compression) noexcept {
+                std::size_t bytes = 0;
+                switch (format) {
+                    case osmium::io::file_format::pbf:
+                        return 8; // always compressed internally
+                    case osmium::io::file_format::o5m:
+                        bytes = 12;
+                        break;
+                    case osmium::io::file_format::opl:
+                        bytes = 70;
+                        break;
+                    case osmium::io::file_format::xml:
+                        bytes = 130;
+                        break;
+                    default:
+                        return 0;
+                }
+                if (compression != osmium::io::file_compression::none) {
+                    bytes /= 8;
+                }
+                return bytes;
+            }
+
+            /**
+             * Memory available for new allocations in bytes. On Linux this
+             * is MemAvailable from /proc/meminfo, otherwise half of the
+             * physical memory. Returns 0 if it can not be determined.
+             */
+            inline std::size_t available_memory() {
+#ifdef __linux__
+                std::ifstream meminfo{"/proc/meminfo"};
+                std::string line;
+                while (std::getline(meminfo, line)) {
+                    if (line.compare(0, 13, "MemAvailable:") == 0) {
+                        std::istringstream in{line.substr(13)};
+                        std::size_t kbytes = 0;
+                        in >> kbytes;
+                        return kbytes * 1024;
+                    }
+                }
+#endif
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGESIZE)
+                const long pages = ::sysconf(_SC_PHYS_PAGES); // NOLINT(google-runtime-int)
+                const long page_size = ::sysconf(_SC_PAGESIZE); // NOLINT(google-runtime-int)
+                if (pages > 0 && page_size > 0) {
+                    return static_cast<std::size_t>(pages) * static_cast<std::size_t>(page_size) / 2;
+                }
+#endif
+                return 0;
+            }
+
+            inline std::string format_bytes(const std::size_t bytes) {
+                std::ostringstream out;
+                out << (bytes / (1024UL * 1024UL)) << " MB";
+                return out.str();
+            }
+
+        } // namespace detail
+
+        /**
+         * Choose a node location index for the input. The index is chosen
+         * from flex_mem (for everything that fits into memory except
+         * planets, it switches between sparse and dense storage as
+         * needed), dense_mmap_array (planets fitting into memory),
+         * and dense_file_array or sparse_file_array if there isn't enough
+         * memory. Only three quarters of the available memory are
+         * considered usable for the index.
+         *
+         * The map types can be given to the MapFactory. The choice
+         * contains the estimated size and a description of why the index
+         * was chosen which can be shown to the user.
+         */
+        inline location_index_choice choose_location_index(const location_index_input& input) {
+            location_index_choice choice;
+            std::ostringstream reason;
+
+            std::size_t nodes = input.node_count;
+            if (nodes == 0 && input.file_size > 0) {
+                const auto bpn = detail::bytes_per_node(input.format, input.compression);
+                if (bpn > 0) {
+                    nodes = input.file_size / bpn;
+                    reason << "estimated " << nodes << " nodes from file size " << detail::format_bytes(input.file_size);
+                }
+            } else if (nodes > 0) {
+                reason << nodes << " nodes expected";
+            }
+
+            const std::size_t max_id = input.max_id > 0 ? input.max_id
+                                                        : static_cast<std::size_t>(location_index_input::default_max_id);
+
+            const bool planet = input.planet || (nodes > 0 && nodes > max_id / 4);
+            if (planet) {
+                reason << (reason.tellp() > 0 ? ", " : "") << "planet sized input";
+            }
+
+            std::size_t memory = input.available_memory;
+            if (memory == 0) {
+                memory = detail::available_memory();
+            }
+            const std::size_t usable_memory = memory / 4 * 3;
+            if (memory > 0) {
+                reason << (reason.tellp() > 0 ? ", " : "") << detail::format_bytes(memory) << " memory available";
+            }
+
+            // An entry in a sparse index is the ID and the location, a
+            // dense index has one location for each possible ID.
+            const std::size_t sparse_bytes = nodes * (sizeof(osmium::unsigned_object_id_type) + sizeof(osmium::Location));
+            const std::size_t dense_bytes = max_id * sizeof(osmium::Location);
+
+            choice.estimated_nodes = nodes;
+
+            if (nodes == 0 && !planet) {
+                choice.map_type = "flex_mem";
+                choice.estimated_bytes = 0;
+                reason << (reason.tellp() > 0 ? ", " : "") << "size of input unknown: using flex_mem which adapts to the input";
+            } else if (planet) {
+                choice.estimated_bytes = dense_bytes;
+                if (memory == 0 || dense_bytes <= usable_memory) {
+                    choice.map_type = "dense_mmap_array";
+                    reason << ": dense index needs " << detail::format_bytes(dense_bytes) << " which fits into memory";
+                } else {
+                    choice.map_type = "dense_file_array";
+                    reason << ": dense index needs " << detail::format_bytes(dense_bytes) << " which doesn't fit into memory";
+                }
+            } else {
+                choice.estimated_bytes = std::min(sparse_bytes, dense_bytes);
+                if (memory == 0 || choice.estimated_bytes <= usable_memory) {
+                    choice.map_type = "flex_mem";
+                    reason << ": index needs " << detail::format_bytes(choice.estimated_bytes) << " which fits into memory";
+                } else if (sparse_bytes < dense_bytes) {
+                    choice.map_type = "sparse_file_array";
+                    reason << ": sparse index needs " << detail::format_bytes(sparse_bytes) << " which doesn't fit into memory";
+                } else {
+                    choice.map_type = "dense_file_array";
+                    reason << ": dense index needs " << detail::format_bytes(dense_bytes) << " which doesn't fit into memory";
+                }
+            }
+
+            if (input.negative_ids) {
+                // There are usually few nodes with negative IDs.
+                choice.negative_map_type = "sparse_mem_array";
+            }
+
+            choice.reason = reason.str();
+            return choice;
+        }
+
+        namespace detail {
+
+            /**
+             * Create a map from the config string "auto" with optional
+             * settings "nodes=N", "max_id=N", "memory=MB", and "planet".
+             */
+            inline osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>* create_auto_location_index(const std::vector<std::string>& config) {
+                location_index_input input;
+                for (std::size_t i = 1; i < config.size(); ++i) {
+                    const std::string& option = config[i];
+                    const auto pos = option.find('=');
+                    const std::string key = option.substr(0, pos);
+                    const std::string value = pos == std::string::npos ? std::string{} : option.substr(pos + 1);
+                    try {
+                        if (key == "planet" && pos == std::string::npos) {
+                            input.planet = true;
+                        } else if (key == "nodes" && !value.empty()) {
+                            input.node_count = std::stoull(value);
+                        } else if (key == "max_id" && !value.empty()) {
+                            input.max_id = std::stoull(value);
+                        } else if (key == "memory" && !value.empty()) {
+                            input.available_memory = std::stoull(value) * 1024UL * 1024UL;
+                        } else {
+                            throw osmium::map_factory_error{std::string{"Unknown option '"} + option + "' for map type 'auto'"};
+                        }
+                    } catch (const std::logic_error&) { // from std::stoull
+                        throw osmium::map_factory_error{std::string{"Invalid option '"} + option + "' for map type 'auto'"};
+                    }
+                }
+
+                const auto choice = choose_location_index(input);
+                return osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance().create_map(choice.map_type).release();
+            }
+
+            const bool registered_auto_location_index = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance().register_map("auto", create_auto_location_index);
+
+            inline bool get_registered_auto_location_index() noexcept {
+                return registered_auto_location_index;
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_AUTO_LOCATION_INDEX_HPP
@@ -0,0 +1,180 @@
+#ifndef OSMIUM_INDEX_BACK_REFERENCES_HPP
+#define OSMIUM_INDEX_BACK_REFERENCES_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/osm/types.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Index from an (unsigned) object id to the ids of the objects
+         * referencing it, for instance from a node to the ways it is in.
+         *
+         * The index is built in two passes over the same data: In the
+         * first pass reserve() is called for every reference to count the
+         * references per id. Then prepare() turns the counts into offsets
+         * with a prefix sum and allocates exactly the memory needed for
+         * the values. In the second pass set() is called for the same
+         * references which fills in the values. The result is a
+         * compressed sparse row (CSR) layout: get_all() is a simple
+         * array lookup and the values for an id are contiguous in memory.
+         *
+         * The offsets array is indexed by the id, so it needs 8 bytes per
+         * id up to the largest referenced id. This is the same trade-off
+         * as with the dense location indexes.
+         *
+         * Values for the same id are kept in the order they were set.
+         */
+        template <typename TValue = osmium::unsigned_object_id_type>
+        class BackReferences {
+
+            // While counting, m_offsets[id] is the number of references
+            // to id. After prepare(), m_offsets[id + 1] is the position
+            // where the next value for id will be written. When all values
+            // are set, the values for id are in [m_offsets[id],
+            // m_offsets[id + 1]).
+            std::vector<std::size_t> m_offsets;
+            std::vector<TValue> m_values;
+            bool m_prepared = false;
+
+        public:
+
+            using value_iterator = const TValue*;
+
+            BackReferences() = default;
+
+            /**
+             * Count a reference to the id. Must be called for all
+             * references before prepare().
+             */
+            void reserve(const osmium::unsigned_object_id_type id) {
+                assert(!m_prepared);
+                if (id >= m_offsets.size()) {
+                    m_offsets.resize(id + 1);
+                }
+                ++m_offsets[id];
+            }
+
+            /**
+             * Allocate the values array and switch from counting to
+             * filling. Call after the first pass.
+             */
+            void prepare() {
+                assert(!m_prepared);
+                m_offsets.push_back(0);
+                std::size_t sum = 0;
+                for (auto& offset : m_offsets) {
+                    const std::size_t count = offset;
+                    offset = sum;
+                    sum += count;
+                }
+                // Shift by one so that m_offsets[id + 1] is the start of
+                // the values for id and can be used as write cursor.
+                m_offsets.insert(m_offsets.begin(), 0);
+                m_offsets.pop_back();
+                m_offsets.shrink_to_fit();
+                m_values.resize(sum);
+                m_prepared = true;
+            }
+
+            /// Has prepare() been called?
+            bool prepared() const noexcept {
+                return m_prepared;
+            }
+
+            /**
+             * Add the value for a reference to the id. Must be called
+             * after prepare() for exactly the references counted with
+             * reserve().
+             */
+            void set(const osmium::unsigned_object_id_type id, const TValue value) noexcept {
+                assert(m_prepared);
+                assert(id + 1 < m_offsets.size());
+                assert(m_offsets[id + 1] < m_values.size());
+                m_values[m_offsets[id + 1]++] = value;
+            }
+
+            /**
+             * Get all values for the id.
+             *
+             * @returns Pair of pointers to the first and one past the
+             *          last value.
+             */
+            std::pair<value_iterator, value_iterator> get_all(const osmium::unsigned_object_id_type id) const noexcept {
+                assert(m_prepared);
+                if (id + 1 >= m_offsets.size()) {
+                    return std::make_pair(nullptr, nullptr);
+                }
+                const TValue* values = m_values.data();
+                return std::make_pair(values + m_offsets[id], values + m_offsets[id + 1]);
+            }
+
+            /// The number of values for the id.
+            std::size_t count(const osmium::unsigned_object_id_type id) const noexcept {
+                const auto range = get_all(id);
+                return static_cast<std::size_t>(range.second - range.first);
+            }
+
+            /// The number of values in the index (after prepare()).
+            std::size_t size() const noexcept {
+                return m_values.size();
+            }
+
+            std::size_t used_memory() const noexcept {
+                return m_offsets.capacity() * sizeof(std::size_t) +
+                       m_values.capacity() * sizeof(TValue);
+            }
+
+            void clear() {
+                m_offsets.clear();
+                m_offsets.shrink_to_fit();
+                m_values.clear();
+                m_values.shrink_to_fit();
+                m_prepared = false;
+            }
+
+        }; // class BackReferences
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_BACK_REFERENCES_HPP
@@ -0,0 +1,205 @@
+#ifndef OSMIUM_INDEX_DETAIL_MMAP_HINTS_HPP
+#define OSMIUM_INDEX_DETAIL_MMAP_HINTS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/map.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Hints on how the kernel should back anonymous memory mappings
+         * used by index maps. All hints are best effort, they are silently
+         * ignored if the system doesn't support them.
+         */
+        struct mmap_hints {
+
+            /// Use transparent huge pages (MADV_HUGEPAGE).
+            bool huge_pages = false;
+
+            /// Interleave pages over all NUMA nodes (mbind MPOL_INTERLEAVE).
+            bool interleave = false;
+
+            /// Fault in pages before they are first written to.
+            bool prefault = false;
+
+            bool any() const noexcept {
+                return huge_pages || interleave || prefault;
+            }
+
+        }; // struct mmap_hints
+
+        /**
+         * Apply hints to the memory range. Must be called before the
+         * memory is first touched, because the kernel decides on page
+         * size and NUMA node when a page is faulted in.
+         */
+        inline void apply_mmap_hints(void* addr, const std::size_t length, const mmap_hints& hints) noexcept {
+#ifdef __linux__
+            if (length == 0) {
+                return;
+            }
+# ifdef MADV_HUGEPAGE
+            if (hints.huge_pages) {
+                ::madvise(addr, length, MADV_HUGEPAGE);
+            }
+# endif
+# ifdef SYS_mbind
+            if (hints.interleave) {
+                // The kernel restricts the mask to the nodes actually
+                // available to this process.
+                constexpr const int mpol_interleave = 3;
+                const uint64_t nodemask = ~uint64_t{0};
+                ::syscall(SYS_mbind, addr, length, mpol_interleave, &nodemask, 64 + 1, 0);
+            }
+# endif
+# ifdef MADV_POPULATE_WRITE
+            if (hints.prefault) {
+                ::madvise(addr, length, MADV_POPULATE_WRITE);
+            }
+# endif
+#else
+            (void)addr;
+            (void)length;
+            (void)hints;
+#endif
+        }
+
+    } // namespace detail
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Parse mmap hints from a map factory config string split at
+             * commas, such as "dense_mmap_array,hugepages,interleave". The
+             * first element is the map type name and is ignored.
+             *
+             * @throws osmium::map_factory_error if there is an unknown
+             *         option.
+             */
+            inline osmium::detail::mmap_hints parse_mmap_hints(const std::vector<std::string>& config) {
+                osmium::detail::mmap_hints hints;
+
+                for (std::size_t i = 1; i < config.size(); ++i) {
+                    const std::string& option = config[i];
+                    if (option == "hugepages") {
+                        hints.huge_pages = true;
+                    } else if (option == "interleave") {
+                        hints.interleave = true;
+                    } else if (option == "prefault") {
+                        hints.prefault = true;
+                    } else {
+                        throw osmium::map_factory_error{std::string{"Unknown option '"} + option + "' for map type '" + config[0] + "'"};
+                    }
+                }
+
+                return hints;
+            }
+
+            /**
+             * Tell the kernel that the memory pages containing the given
+             * elements of an array will be needed soon (MADV_WILLNEED).
+             * For a file backed mapping the kernel then starts reading
+             * them in the background, so later accesses don't have to wait
+             * for page faults one at a time. Runs of adjacent pages are
+             * advised in one call. Ids not smaller than size are ignored.
+             * This is best effort, errors are ignored.
+             *
+             * @param data Pointer to the start of the array.
+             * @param element_size Size of one element in bytes.
+             * @param size Number of elements in the array.
+             * @param ids Pointer to the first of the ids (indexes into the
+             *            array) which will be needed.
+             * @param count Number of ids.
+             */
+            template <typename TId>
+            void advise_will_need(const void* data, const std::size_t element_size, const std::size_t size, const TId* ids, const std::size_t count) {
+#if defined(__linux__) && defined(MADV_WILLNEED)
+                if (count == 0) {
+                    return;
+                }
+
+                const auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+                const auto base = reinterpret_cast<std::uintptr_t>(data);
+
+                std::vector<std::uintptr_t> pages;
+                pages.reserve(count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    if (static_cast<std::size_t>(ids[i]) < size) {
+                        pages.push_back((base + static_cast<std::size_t>(ids[i]) * element_size) / page_size);
+                    }
+                }
+                std::sort(pages.begin(), pages.end());
+                pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+                auto it = pages.begin();
+                while (it != pages.end()) {
+                    const auto first = *it;
+                    auto last = first;
+                    while (++it != pages.end() && *it == last + 1) {
+                        last = *it;
+                    }
+                    ::madvise(reinterpret_cast<void*>(first * page_size), (last - first + 1) * page_size, MADV_WILLNEED); // NOLINT(performance-no-int-to-ptr)
+                }
+#else
+                (void)data;
+                (void)element_size;
+                (void)size;
+                (void)ids;
+                (void)count;
+#endif
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_MMAP_HINTS_HPP
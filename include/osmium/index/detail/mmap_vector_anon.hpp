@@ -54,6 +54,10 @@ namespace osmium {
                 mmap_vector_base<T>() {
             }
 
+            explicit mmap_vector_anon(const mmap_hints& hints) :
+                mmap_vector_base<T>(hints) {
+            }
+
         }; // class mmap_vector_anon
 
     } // namespace detail
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/mmap_hints.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/util/memory_mapping.hpp>
 
@@ -62,6 +63,13 @@ namespace osmium {
 
             std::size_t m_size = 0;
             osmium::TypedMemoryMapping<T> m_mapping;
+            mmap_hints m_hints;
+
+            void apply_hints(const std::size_t from, const std::size_t to) noexcept {
+                if (m_hints.any()) {
+                    apply_mmap_hints(data() + from, (to - from) * sizeof(T), m_hints);
+                }
+            }
 
         public:
 
@@ -78,6 +86,13 @@ namespace osmium {
                 std::fill_n(data(), capacity, osmium::index::empty_value<T>());
             }
 
+            explicit mmap_vector_base(const mmap_hints& hints, const std::size_t capacity = mmap_vector_size_increment) :
+                m_mapping(capacity),
+                m_hints(hints) {
+                apply_hints(0, capacity);
+                std::fill_n(data(), capacity, osmium::index::empty_value<T>());
+            }
+
             using value_type      = T;
             using pointer         = value_type*;
             using const_pointer   = const value_type*;
@@ -146,6 +161,7 @@ namespace osmium {
                 if (new_capacity > capacity()) {
                     const std::size_t old_capacity = capacity();
                     m_mapping.resize(new_capacity);
+                    apply_hints(old_capacity, new_capacity);
                     std::fill(data() + old_capacity, data() + new_capacity, osmium::index::empty_value<value_type>());
                 }
             }
@@ -0,0 +1,188 @@
+#ifndef OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
+#define OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/config.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            enum : std::size_t {
+                // Sorting less data than this is done in one thread.
+                parallel_sort_min_size = 1024UL * 1024UL,
+
+                // Below this size std::stable_sort is faster than radix sort.
+                radix_sort_min_size = 4096,
+
+                radix_sort_bits = 11,
+                radix_sort_buckets = 1UL << radix_sort_bits
+            };
+
+            /**
+             * The number of threads to use for sorting and other work on
+             * this many elements. Uses the same setting as the thread pool
+             * (OSMIUM_POOL_THREADS).
+             */
+            inline int parallel_work_threads(const std::size_t size) {
+                if (size < parallel_sort_min_size) {
+                    return 1;
+                }
+                return osmium::thread::detail::get_pool_size(0, osmium::config::get_pool_threads(), std::thread::hardware_concurrency());
+            }
+
+            /**
+             * Call func(n) for n = 0 .. num_threads-1, each in its own
+             * thread, and wait for all of them. The function must not
+             * throw.
+             */
+            template <typename TFunc>
+            void run_in_threads(const int num_threads, TFunc&& func) {
+                std::vector<std::thread> threads;
+                threads.reserve(static_cast<std::size_t>(num_threads));
+                for (int n = 1; n < num_threads; ++n) {
+                    threads.emplace_back([&func, n]() {
+                        func(n);
+                    });
+                }
+                func(0);
+                for (auto& thread : threads) {
+                    thread.join();
+                }
+            }
+
+            /**
+             * Sort a vector by an unsigned integer key using a stable LSD
+             * radix sort. Histograms and scattering are done in several
+             * threads for large inputs. Passes over digits where all keys
+             * are the same are skipped, so only as many passes as needed
+             * for the largest key are done.
+             *
+             * Needs a temporary copy of the data. The element type must be
+             * default constructible and cheap to copy.
+             *
+             * @param data The vector to sort.
+             * @param key Function returning the key (uint64_t) of an
+             *            element.
+             */
+            template <typename T, typename TKey>
+            void radix_sort(std::vector<T>& data, TKey&& key) {
+                const std::size_t size = data.size();
+                if (size < radix_sort_min_size) {
+                    std::stable_sort(data.begin(), data.end(), [&key](const T& a, const T& b) {
+                        return key(a) < key(b);
+                    });
+                    return;
+                }
+
+                const int num_threads = parallel_work_threads(size);
+                const auto begin = [size, num_threads](const int n) noexcept {
+                    return size * static_cast<std::size_t>(n) / static_cast<std::size_t>(num_threads);
+                };
+
+                std::vector<uint64_t> max_keys(static_cast<std::size_t>(num_threads), 0);
+                run_in_threads(num_threads, [&](const int n) {
+                    uint64_t max_key = 0;
+                    for (std::size_t i = begin(n); i < begin(n + 1); ++i) {
+                        max_key = std::max(max_key, static_cast<uint64_t>(key(data[i])));
+                    }
+                    max_keys[static_cast<std::size_t>(n)] = max_key;
+                });
+                const uint64_t max_key = *std::max_element(max_keys.cbegin(), max_keys.cend());
+
+                using histogram = std::array<std::size_t, radix_sort_buckets>;
+                std::vector<histogram> counts(static_cast<std::size_t>(num_threads));
+                std::vector<T> buffer(size);
+
+                for (unsigned int shift = 0; shift < 64 && (max_key >> shift) != 0; shift += radix_sort_bits) {
+                    const auto digit = [&key, shift](const T& element) noexcept {
+                        return static_cast<std::size_t>((static_cast<uint64_t>(key(element)) >> shift) & (radix_sort_buckets - 1));
+                    };
+
+                    run_in_threads(num_threads, [&](const int n) {
+                        auto& count = counts[static_cast<std::size_t>(n)];
+                        count.fill(0);
+                        for (std::size_t i = begin(n); i < begin(n + 1); ++i) {
+                            ++count[digit(data[i])];
+                        }
+                    });
+
+                    // Turn counts into start positions for each thread and
+                    // digit. Skip the pass if all keys have the same digit.
+                    bool all_same = false;
+                    std::size_t pos = 0;
+                    for (std::size_t d = 0; d < radix_sort_buckets; ++d) {
+                        std::size_t total = 0;
+                        for (auto& count : counts) {
+                            const std::size_t c = count[d];
+                            count[d] = pos;
+                            pos += c;
+                            total += c;
+                        }
+                        if (total == size) {
+                            all_same = true;
+                        }
+                    }
+                    if (all_same) {
+                        continue;
+                    }
+
+                    run_in_threads(num_threads, [&](const int n) {
+                        auto& position = counts[static_cast<std::size_t>(n)];
+                        for (std::size_t i = begin(n); i < begin(n + 1); ++i) {
+                            buffer[position[digit(data[i])]++] = data[i];
+                        }
+                    });
+
+                    data.swap(buffer);
+                }
+            }
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_PARALLEL_SORT_HPP
@@ -0,0 +1,161 @@
+#ifndef OSMIUM_INDEX_DETAIL_SEARCH_TREE_HPP
+#define OSMIUM_INDEX_DETAIL_SEARCH_TREE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/prefetch.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Search tree for a sorted array of ids. The ids are cut into
+             * blocks of one cache line each, and the largest id of each
+             * block goes into a small search tree stored in Eytzinger
+             * order, ie. as a binary tree laid out breadth-first. The tree
+             * is padded to a perfect tree so that every lookup takes the
+             * same number of steps and ends up directly at the block which
+             * can contain the id. The tree nodes several levels further
+             * down are next to each other in memory so they can be
+             * prefetched while walking down. The block is then scanned for
+             * the id.
+             *
+             * The tree does not contain the ids itself, they are given to
+             * build() and lower_bound(). It must be rebuilt whenever the
+             * ids change.
+             */
+            template <typename T>
+            class search_tree {
+
+            public:
+
+                enum : std::size_t {
+                    block_size = 64 / sizeof(T) > 0 ? 64 / sizeof(T) : 1
+                };
+
+            private:
+
+                // Largest id of each block in Eytzinger order, 1-based.
+                // Has 2^m_height entries (including the unused first one).
+                std::vector<T> m_tree;
+                std::size_t m_height = 0;
+
+                static std::size_t num_blocks(const std::vector<T>& ids) noexcept {
+                    return (ids.size() + block_size - 1) / block_size;
+                }
+
+                // Fill the tree nodes in order of an in-order traversal,
+                // which visits them in sorted order.
+                std::size_t build_tree(const std::vector<T>& ids, std::size_t block, const std::size_t node) {
+                    if (node < m_tree.size()) {
+                        block = build_tree(ids, block, 2 * node);
+                        if (block < num_blocks(ids)) {
+                            m_tree[node] = ids[std::min((block + 1) * block_size, ids.size()) - 1];
+                        } else {
+                            m_tree[node] = std::numeric_limits<T>::max();
+                        }
+                        block = build_tree(ids, block + 1, 2 * node + 1);
+                    }
+                    return block;
+                }
+
+            public:
+
+                /**
+                 * Build the tree for the ids, which must be sorted.
+                 */
+                void build(const std::vector<T>& ids) {
+                    m_height = 0;
+                    while ((std::size_t{1} << m_height) - 1 < num_blocks(ids)) {
+                        ++m_height;
+                    }
+                    m_tree.assign(std::size_t{1} << m_height, T{});
+                    build_tree(ids, 0, 1);
+                }
+
+                /**
+                 * Position of the first id not smaller than id or
+                 * ids.size() if there is none. The ids must be the same
+                 * the tree was built with.
+                 */
+                std::size_t lower_bound(const std::vector<T>& ids, const T id) const noexcept {
+                    if (ids.empty()) {
+                        return 0;
+                    }
+
+                    std::size_t node = 1;
+                    for (std::size_t level = 0; level < m_height; ++level) {
+                        // prefetch the nodes four levels further down
+                        if (16 * node < m_tree.size()) {
+                            prefetch(m_tree.data() + 16 * node);
+                        }
+                        node = 2 * node + (m_tree[node] < id ? 1 : 0);
+                    }
+
+                    // In a perfect tree the leaf we end up at is the
+                    // number of blocks with all ids smaller than id.
+                    std::size_t pos = (node - m_tree.size()) * block_size;
+                    const std::size_t end = std::min(pos + block_size, ids.size());
+                    while (pos < end && ids[pos] < id) {
+                        ++pos;
+                    }
+                    return pos < end ? pos : ids.size();
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return m_tree.capacity() * sizeof(T);
+                }
+
+                void clear() {
+                    m_tree.clear();
+                    m_tree.shrink_to_fit();
+                    m_height = 0;
+                }
+
+            }; // class search_tree
+
+        } // namespace detail
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_DETAIL_SEARCH_TREE_HPP
@@ -35,7 +35,14 @@ DEALINGS IN THE SOFTWARE.
 
 #include <cerrno>
 #include <cstdio>
+#include <string>
 #include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+# include <cstdlib>
+# include <unistd.h>
+#endif
 
 namespace osmium {
 
@@ -55,6 +62,32 @@ namespace osmium {
             return fileno(file);
         }
 
+        /**
+         * Create and open a temporary file in the given directory. It is
+         * removed after opening. If the directory is empty, this is the
+         * same as create_tmp_file(). On Windows the directory is ignored.
+         *
+         * @returns File descriptor of temporary file.
+         * @throws std::system_error if something went wrong.
+         */
+        inline int create_tmp_file(const std::string& directory) {
+#ifndef _WIN32
+            if (!directory.empty()) {
+                const std::string name_template{directory + "/osmium-XXXXXX"};
+                std::vector<char> name(name_template.begin(), name_template.end());
+                name.push_back('\0');
+                const int fd = ::mkstemp(name.data());
+                if (fd < 0) {
+                    throw std::system_error{errno, std::system_category(), "mkstemp failed"};
+                }
+                ::unlink(name.data());
+                return fd;
+            }
+#endif
+            (void)directory;
+            return create_tmp_file();
+        }
+
     } // namespace detail
 
 } // namespace osmium
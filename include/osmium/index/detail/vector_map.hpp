@@ -33,15 +33,18 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/mmap_hints.hpp>
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
 #include <osmium/io/detail/read_write.hpp>
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <utility>
-
+#include <vector>
 
 namespace osmium {
 
@@ -49,6 +52,26 @@ namespace osmium {
 
         namespace map {
 
+            namespace detail {
+
+                // In-memory vectors are sorted with a parallel radix sort
+                // on the id.
+                template <typename TId, typename TValue>
+                void sort_by_id(std::vector<std::pair<TId, TValue>>& data) {
+                    osmium::index::detail::radix_sort(data, [](const std::pair<TId, TValue>& element) noexcept {
+                        return static_cast<uint64_t>(element.first);
+                    });
+                }
+
+                // Other (mmap based) vectors might not fit into memory
+                // twice, so they are sorted in place.
+                template <typename TVector>
+                void sort_by_id(TVector& data) {
+                    std::sort(data.begin(), data.end());
+                }
+
+            } // namespace detail
+
             template <typename TVector, typename TId, typename TValue>
             class VectorBasedDenseMap : public Map<TId, TValue> {
 
@@ -69,6 +92,10 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                explicit VectorBasedDenseMap(const osmium::detail::mmap_hints& hints) :
+                    m_vector(hints) {
+                }
+
                 void reserve(const std::size_t size) final {
                     m_vector.reserve(size);
                 }
@@ -82,20 +109,48 @@ namespace osmium {
 
                 TValue get(const TId id) const final {
                     if (id >= m_vector.size()) {
+                        this->count_lookup(false);
                         throw osmium::not_found{id};
                     }
                     const TValue value = m_vector[id];
                     if (value == osmium::index::empty_value<TValue>()) {
+                        this->count_lookup(false);
                         throw osmium::not_found{id};
                     }
+                    this->count_lookup(true);
                     return value;
                 }
 
                 TValue get_noexcept(const TId id) const noexcept final {
                     if (id >= m_vector.size()) {
+                        this->count_lookup(false);
                         return osmium::index::empty_value<TValue>();
                     }
-                    return m_vector[id];
+                    const TValue value = m_vector[id];
+                    this->count_lookup(value != osmium::index::empty_value<TValue>());
+                    return value;
+                }
+
+                void get_many(const TId* ids, const std::size_t count, TValue* values) const noexcept final {
+                    const std::size_t size = m_vector.size();
+                    const TValue* data = m_vector.data();
+                    for (std::size_t i = 0; i < count && i < osmium::index::detail::prefetch_distance; ++i) {
+                        if (ids[i] < size) {
+                            osmium::index::detail::prefetch(data + ids[i]);
+                        }
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const std::size_t ahead = i + osmium::index::detail::prefetch_distance;
+                        if (ahead < count && ids[ahead] < size) {
+                            osmium::index::detail::prefetch(data + ids[ahead]);
+                        }
+                        values[i] = ids[i] < size ? data[ids[i]] : osmium::index::empty_value<TValue>();
+                        this->count_lookup(values[i] != osmium::index::empty_value<TValue>());
+                    }
+                }
+
+                void prefetch(const TId* ids, const std::size_t count) const final {
+                    osmium::index::detail::advise_will_need(m_vector.data(), sizeof(TValue), m_vector.size(), ids, count);
                 }
 
                 std::size_t size() const final {
@@ -119,6 +174,15 @@ namespace osmium {
                     osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(m_vector.data()), byte_size());
                 }
 
+                map_stats statistics() const final {
+                    map_stats result{Map<TId, TValue>::statistics()};
+                    result.capacity = m_vector.size();
+                    result.size = static_cast<std::size_t>(std::count_if(m_vector.cbegin(), m_vector.cend(), [](const TValue& value) {
+                        return value != osmium::index::empty_value<TValue>();
+                    }));
+                    return result;
+                }
+
                 iterator begin() {
                     return m_vector.begin();
                 }
@@ -180,6 +244,10 @@ namespace osmium {
                     m_vector(fd) {
                 }
 
+                explicit VectorBasedSparseMap(const osmium::detail::mmap_hints& hints) :
+                    m_vector(hints) {
+                }
+
                 void set(const TId id, const TValue value) final {
                     m_vector.push_back(element_type(id, value));
                 }
@@ -187,18 +255,22 @@ namespace osmium {
                 TValue get(const TId id) const final {
                     const auto result = find_id(id);
                     if (result == m_vector.end() || result->first != id) {
+                        this->count_lookup(false);
                         throw osmium::not_found{id};
                     }
 
+                    this->count_lookup(true);
                     return result->second;
                 }
 
                 TValue get_noexcept(const TId id) const noexcept final {
                     const auto result = find_id(id);
                     if (result == m_vector.end() || result->first != id) {
+                        this->count_lookup(false);
                         return osmium::index::empty_value<TValue>();
                     }
 
+                    this->count_lookup(true);
                     return result->second;
                 }
 
@@ -220,7 +292,15 @@ namespace osmium {
                 }
 
                 void sort() final {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    detail::sort_by_id(m_vector);
+                }
+
+                map_stats statistics() const final {
+                    map_stats result{Map<TId, TValue>::statistics()};
+                    result.sorted = std::is_sorted(m_vector.cbegin(), m_vector.cend(), [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+                    return result;
                 }
 
                 void dump_as_array(const int fd) final {
@@ -33,13 +33,16 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/multimap.hpp>
 #include <osmium/io/detail/read_write.hpp>
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -47,6 +50,37 @@ namespace osmium {
 
         namespace multimap {
 
+            namespace detail {
+
+                // In-memory vectors are radix sorted on the id, then the
+                // (usually very short) runs with the same id are sorted by
+                // value. This gives the same order as sorting the pairs.
+                template <typename TId, typename TValue>
+                void sort_pairs(std::vector<std::pair<TId, TValue>>& data) {
+                    osmium::index::detail::radix_sort(data, [](const std::pair<TId, TValue>& element) noexcept {
+                        return static_cast<uint64_t>(element.first);
+                    });
+                    for (auto it = data.begin(); it != data.end();) {
+                        auto last = it + 1;
+                        while (last != data.end() && last->first == it->first) {
+                            ++last;
+                        }
+                        if (last - it > 1) {
+                            std::sort(it, last);
+                        }
+                        it = last;
+                    }
+                }
+
+                // Other (mmap based) vectors might not fit into memory
+                // twice, so they are sorted in place.
+                template <typename TVector>
+                void sort_pairs(TVector& data) {
+                    std::sort(data.begin(), data.end());
+                }
+
+            } // namespace detail
+
             template <typename TId, typename TValue, template <typename...> class TVector>
             class VectorBasedSparseMultimap : public Multimap<TId, TValue> {
 
@@ -121,28 +155,35 @@ namespace osmium {
                 }
 
                 void sort() final {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    detail::sort_pairs(m_vector);
+                }
+
+                map_stats statistics() const final {
+                    map_stats result{Multimap<TId, TValue>::statistics()};
+                    result.sorted = std::is_sorted(m_vector.cbegin(), m_vector.cend());
+                    return result;
                 }
 
                 void remove(const TId id, const TValue value) {
                     const auto r = get_all(id);
                     for (auto it = r.first; it != r.second; ++it) {
                         if (it->second == value) {
-                            it->second = 0;
+                            it->second = osmium::index::empty_value<TValue>();
                             return;
                         }
                     }
                 }
 
                 void consolidate() {
-                    std::sort(m_vector.begin(), m_vector.end());
+                    detail::sort_pairs(m_vector);
                 }
 
                 void erase_removed() {
-                    m_vector.erase(
-                        std::remove_if(m_vector.begin(), m_vector.end(), is_removed),
-                        m_vector.end()
-                    );
+                    // The elements after the new end are overwritten, because
+                    // file based vectors get their size from the file size.
+                    const auto last = std::remove_if(m_vector.begin(), m_vector.end(), is_removed);
+                    std::fill(last, m_vector.end(), osmium::index::empty_value<element_type>());
+                    m_vector.resize(static_cast<std::size_t>(last - m_vector.begin()));
                 }
 
                 void dump_as_list(const int fd) final {
@@ -0,0 +1,214 @@
+#ifndef OSMIUM_INDEX_ENVELOPE_CACHE_HPP
+#define OSMIUM_INDEX_ENVELOPE_CACHE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Cache for the envelopes of ways and areas. Calculating the
+         * envelope of a way or area means iterating over all its
+         * locations, this cache remembers it for each object, so code
+         * needing the envelope of the same object several times (like
+         * several bounding box filters) doesn't have to do that again.
+         *
+         * The objects are identified by their address, so the cache is
+         * only valid as long as the buffers containing the objects are
+         * not changed or freed. Call clear() before that happens.
+         *
+         * Lookups of objects in the order they were added (which is the
+         * usual case when going through a buffer several times) are
+         * constant time, other lookups need a binary search. If objects
+         * from several buffers are added, call sort() before any lookups.
+         *
+         * The NodeLocationsForWays handler can fill this cache while it
+         * is adding the locations to the ways (see
+         * NodeLocationsForWays::set_envelope_cache()).
+         *
+         * This class is not thread safe, not even for lookups.
+         */
+        class EnvelopeCache {
+
+            struct entry {
+                const osmium::memory::Item* item;
+                osmium::Box box;
+
+                bool operator<(const entry& other) const noexcept {
+                    return std::less<const osmium::memory::Item*>{}(item, other.item);
+                }
+            };
+
+            std::vector<entry> m_entries;
+
+            // Position after the entry found by the last lookup.
+            std::size_t m_next = 0;
+
+            bool m_sorted = true;
+
+            void add_entry(const osmium::memory::Item& item, const osmium::Box& box) {
+                if (!m_entries.empty() && !std::less<const osmium::memory::Item*>{}(m_entries.back().item, &item)) {
+                    m_sorted = false;
+                }
+                m_entries.push_back(entry{&item, box});
+            }
+
+        public:
+
+            EnvelopeCache() = default;
+
+            /// The number of objects in the cache.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            /// Is the cache empty?
+            bool empty() const noexcept {
+                return m_entries.empty();
+            }
+
+            /**
+             * Add the envelope of a way. The box must be the envelope of
+             * the way, this is not checked.
+             */
+            void add(const osmium::Way& way, const osmium::Box& box) {
+                add_entry(way, box);
+            }
+
+            /**
+             * Add the envelope of an area. The box must be the envelope
+             * of the area, this is not checked.
+             */
+            void add(const osmium::Area& area, const osmium::Box& box) {
+                add_entry(area, box);
+            }
+
+            /// Calculate the envelope of a way and add it.
+            void add(const osmium::Way& way) {
+                add_entry(way, way.envelope());
+            }
+
+            /// Calculate the envelope of an area and add it.
+            void add(const osmium::Area& area) {
+                add_entry(area, area.envelope());
+            }
+
+            /**
+             * Sort the cache. This is only needed if objects were not
+             * added in the order they are in memory, for instance if they
+             * are from several buffers.
+             */
+            void sort() {
+                if (!m_sorted) {
+                    std::stable_sort(m_entries.begin(), m_entries.end());
+                    // Keep the last entry added for each object.
+                    const auto last = std::unique(m_entries.rbegin(), m_entries.rend(), [](const entry& a, const entry& b) {
+                        return a.item == b.item;
+                    });
+                    m_entries.erase(m_entries.begin(), last.base());
+                    m_sorted = true;
+                }
+                m_next = 0;
+            }
+
+            /**
+             * Find the cached envelope of an object.
+             *
+             * @pre The cache is sorted (see sort()).
+             * @returns Pointer to the envelope or nullptr if the object
+             *          is not in the cache.
+             */
+            const osmium::Box* find(const osmium::memory::Item& item) noexcept {
+                assert(m_sorted);
+                if (m_next < m_entries.size() && m_entries[m_next].item == &item) {
+                    return &m_entries[m_next++].box;
+                }
+
+                const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), entry{&item, osmium::Box{}});
+                if (it == m_entries.end() || it->item != &item) {
+                    return nullptr;
+                }
+                m_next = static_cast<std::size_t>(std::distance(m_entries.begin(), it)) + 1;
+                return &it->box;
+            }
+
+            /**
+             * Get the envelope of a way from the cache or calculate it if
+             * it is not in the cache.
+             *
+             * @pre The cache is sorted (see sort()).
+             */
+            osmium::Box envelope(const osmium::Way& way) noexcept {
+                const auto* box = find(way);
+                return box ? *box : way.envelope();
+            }
+
+            /**
+             * Get the envelope of an area from the cache or calculate it
+             * if it is not in the cache.
+             *
+             * @pre The cache is sorted (see sort()).
+             */
+            osmium::Box envelope(const osmium::Area& area) noexcept {
+                const auto* box = find(area);
+                return box ? *box : area.envelope();
+            }
+
+            /// Remove all entries from the cache.
+            void clear() noexcept {
+                m_entries.clear();
+                m_next = 0;
+                m_sorted = true;
+            }
+
+        }; // class EnvelopeCache
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ENVELOPE_CACHE_HPP
@@ -0,0 +1,244 @@
+#ifndef OSMIUM_INDEX_ID_FILTER_HPP
+#define OSMIUM_INDEX_ID_FILTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/relations_map.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * A blocked Bloom filter for Ids. It answers the question "is this
+         * Id in the set?" with either "definitely not" or "maybe". Use it
+         * as a cheap pre-check in front of an exact IdSet or index when most
+         * lookups are for Ids that are not in the set. The filter is much
+         * smaller than the exact structure (about 10 bits per Id with the
+         * default settings) so it usually fits into the CPU caches.
+         *
+         * All bits for one Id are in the same 64 byte block, so a lookup
+         * touches only one cache line. The number of blocks is rounded up
+         * to a power of two.
+         *
+         * @code
+         * osmium::index::IdSetDense<osmium::unsigned_object_id_type> ids;
+         * ...
+         * const auto filter = osmium::index::IdFilter<osmium::unsigned_object_id_type>::from_id_set(ids);
+         * ...
+         * if (filter.get(id) && ids.get(id)) {
+         *     ...
+         * }
+         * @endcode
+         */
+        template <typename T>
+        class IdFilter {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+
+            enum : std::size_t {
+                block_words = 8, // 64 bytes
+                block_bits = block_words * 64
+            };
+
+            std::vector<uint64_t> m_data;
+
+            // Offset of the first block in m_data to align the blocks to
+            // cache lines.
+            std::size_t m_offset = 0;
+
+            std::size_t m_block_mask = 0;
+            std::size_t m_size = 0;
+            unsigned int m_num_hashes;
+
+            static uint64_t hash(const T id) noexcept {
+                // finalizer from splitmix64
+                uint64_t h = static_cast<uint64_t>(id) + 0x9e3779b97f4a7c15ULL;
+                h = (h ^ (h >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+                h = (h ^ (h >> 27U)) * 0x94d049bb133111ebULL;
+                return h ^ (h >> 31U);
+            }
+
+            const uint64_t* block(const uint64_t h) const noexcept {
+                return m_data.data() + m_offset + (static_cast<std::size_t>(h >> 32U) & m_block_mask) * block_words;
+            }
+
+            // Set the bits for the hash in the block or check that they are
+            // all set. Bit positions are derived from the lower half of the
+            // hash with double hashing.
+            template <typename TFunc>
+            bool for_each_bit(const uint64_t h, TFunc&& func) const noexcept {
+                auto pos = static_cast<uint32_t>(h);
+                const auto step = static_cast<uint32_t>(h >> 41U) | 1U;
+                for (unsigned int i = 0; i < m_num_hashes; ++i) {
+                    const auto bit = pos % block_bits;
+                    if (!func(bit / 64, uint64_t(1) << (bit % 64))) {
+                        return false;
+                    }
+                    pos += step;
+                }
+                return true;
+            }
+
+        public:
+
+            /**
+             * Create a filter.
+             *
+             * @param expected_ids The number of Ids that will be added.
+             * @param bits_per_id Bits of memory to use per Id. The false
+             *        positive rate is about 1% with the default of 10 and
+             *        about 0.1% with 16.
+             */
+            explicit IdFilter(const std::size_t expected_ids, const unsigned int bits_per_id = 10) :
+                m_num_hashes(std::max(1U, std::min(16U, bits_per_id * 7U / 10U))) {
+                const std::size_t min_blocks = (std::max(expected_ids, static_cast<std::size_t>(1)) * std::max(bits_per_id, 1U) + block_bits - 1) / block_bits;
+                std::size_t num_blocks = 1;
+                while (num_blocks < min_blocks) {
+                    num_blocks <<= 1U;
+                }
+                m_block_mask = num_blocks - 1;
+                m_data.resize(num_blocks * block_words + block_words - 1);
+                const auto misalignment = reinterpret_cast<std::uintptr_t>(m_data.data()) % (block_words * sizeof(uint64_t));
+                if (misalignment != 0) {
+                    m_offset = (block_words * sizeof(uint64_t) - misalignment) / sizeof(uint64_t);
+                }
+            }
+
+            /**
+             * Create a filter from all Ids in an IdSet. The set must have
+             * a size() function and be iterable, like IdSetDense,
+             * IdSetSmall, or IdSetCompressed.
+             */
+            template <typename TIdSet>
+            static IdFilter from_id_set(const TIdSet& set, const unsigned int bits_per_id = 10) {
+                IdFilter filter{static_cast<std::size_t>(set.size()), bits_per_id};
+                for (const auto id : set) {
+                    filter.set(static_cast<T>(id));
+                }
+                return filter;
+            }
+
+            /**
+             * Create a filter from all member Ids in a RelationsMapStash.
+             * Call this before building the index from the stash.
+             */
+            static IdFilter from_relations_map_stash(const RelationsMapStash& stash, const unsigned int bits_per_id = 10) {
+                IdFilter filter{stash.size(), bits_per_id};
+                stash.for_each_member([&filter](const osmium::unsigned_object_id_type id) {
+                    filter.set(static_cast<T>(id));
+                });
+                return filter;
+            }
+
+            /**
+             * Add the Id to the filter.
+             */
+            void set(const T id) noexcept {
+                const auto h = hash(id);
+                auto* b = const_cast<uint64_t*>(block(h));
+                for_each_bit(h, [b](const std::size_t word, const uint64_t mask) noexcept {
+                    b[word] |= mask;
+                    return true;
+                });
+                ++m_size;
+            }
+
+            /**
+             * Might the Id be in the filter? Returns false only if the Id
+             * was definitely not added, but can return true for Ids that
+             * were not added.
+             */
+            bool get(const T id) const noexcept {
+                const auto h = hash(id);
+                const auto* b = block(h);
+                return for_each_bit(h, [b](const std::size_t word, const uint64_t mask) noexcept {
+                    return (b[word] & mask) != 0;
+                });
+            }
+
+            /**
+             * Is the filter empty?
+             */
+            bool empty() const noexcept {
+                return m_size == 0;
+            }
+
+            /**
+             * The number of times set() was called. Ids added several
+             * times are counted several times.
+             */
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * The number of 64 byte blocks in this filter.
+             */
+            std::size_t num_blocks() const noexcept {
+                return m_block_mask + 1;
+            }
+
+            /**
+             * Number of bits set for each Id.
+             */
+            unsigned int num_hashes() const noexcept {
+                return m_num_hashes;
+            }
+
+            /**
+             * Clear the filter. The memory is kept.
+             */
+            void clear() noexcept {
+                std::fill(m_data.begin(), m_data.end(), 0);
+                m_size = 0;
+            }
+
+            std::size_t used_memory() const noexcept {
+                return m_data.size() * sizeof(uint64_t);
+            }
+
+        }; // class IdFilter
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_FILTER_HPP
@@ -39,6 +39,7 @@ DEALINGS IN THE SOFTWARE.
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <iterator>
 #include <memory>
@@ -105,6 +106,31 @@ namespace osmium {
                 default_chunk_bits = 22u
             };
 
+            inline int popcount64(uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+                return __builtin_popcountll(value);
+#else
+                int count = 0;
+                for (; value != 0; value &= value - 1) {
+                    ++count;
+                }
+                return count;
+#endif
+            }
+
+            // value must not be 0
+            inline int count_trailing_zeros64(uint64_t value) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+                return __builtin_ctzll(value);
+#else
+                int count = 0;
+                for (; (value & 1U) == 0; value >>= 1U) {
+                    ++count;
+                }
+                return count;
+#endif
+            }
+
         } // namespace detail
 
         template <typename T, std::size_t chunk_bits = detail::default_chunk_bits>
@@ -126,21 +152,7 @@ namespace osmium {
             T m_last;
 
             void next() noexcept {
-                while (m_value != m_last && !m_set->get(m_value)) {
-                    const T cid = id_set::chunk_id(m_value);
-                    assert(cid < m_set->m_data.size());
-                    if (!m_set->m_data[cid]) {
-                        m_value = (cid + 1) << (chunk_bits + 3);
-                    } else {
-                        const auto slot = m_set->m_data[cid][id_set::offset(m_value)];
-                        if (slot == 0) {
-                            m_value += 8;
-                            m_value &= ~0x7ull;
-                        } else {
-                            ++m_value;
-                        }
-                    }
-                }
+                m_value = std::min(m_set->next_set(m_value), m_last);
             }
 
         public:
@@ -224,6 +236,39 @@ namespace osmium {
                 return static_cast<T>(m_data.size()) * chunk_size * 8;
             }
 
+            // Read the 8 bytes at p as one 64 bit word in which bit n is
+            // the bit for the n-th Id from the start of the word.
+            static uint64_t load_word(const unsigned char* p) noexcept {
+                uint64_t word = 0;
+                for (unsigned int i = 0; i < 8; ++i) {
+                    word |= static_cast<uint64_t>(p[i]) << (i * 8U);
+                }
+                return word;
+            }
+
+            // Returns the smallest Id >= id in the set or last() if there
+            // is none. Works on whole 64 bit words and skips unallocated
+            // chunks.
+            T next_set(T id) const noexcept {
+                std::size_t cid = chunk_id(id);
+                std::size_t pos = offset(id) & ~static_cast<std::size_t>(7U);
+                uint64_t mask = ~uint64_t(0) << (id & 0x3fU);
+                for (; cid < m_data.size(); ++cid, pos = 0, mask = ~uint64_t(0)) {
+                    const unsigned char* chunk = m_data[cid].get();
+                    if (!chunk) {
+                        continue;
+                    }
+                    for (; pos < chunk_size; pos += 8, mask = ~uint64_t(0)) {
+                        const uint64_t word = load_word(chunk + pos) & mask;
+                        if (word != 0) {
+                            return static_cast<T>((static_cast<T>(cid) << (chunk_bits + 3U)) + pos * 8 +
+                                                  static_cast<std::size_t>(detail::count_trailing_zeros64(word)));
+                        }
+                    }
+                }
+                return last();
+            }
+
             unsigned char& get_element(T id) {
                 const auto cid = chunk_id(id);
                 if (cid >= m_data.size()) {
@@ -328,6 +373,57 @@ namespace osmium {
                 return m_data.size() * chunk_size;
             }
 
+            /**
+             * Call func for each Id in the set in order. This is faster
+             * than using the iterators.
+             *
+             * @param func Function called with the Id as only parameter.
+             */
+            template <typename TFunc>
+            void for_each_set(TFunc&& func) const {
+                for (std::size_t cid = 0; cid < m_data.size(); ++cid) {
+                    const unsigned char* chunk = m_data[cid].get();
+                    if (!chunk) {
+                        continue;
+                    }
+                    const T chunk_start = static_cast<T>(cid) << (chunk_bits + 3U);
+                    for (std::size_t pos = 0; pos < chunk_size; pos += 8) {
+                        for (uint64_t word = load_word(chunk + pos); word != 0; word &= word - 1) {
+                            func(static_cast<T>(chunk_start + pos * 8 + static_cast<std::size_t>(detail::count_trailing_zeros64(word))));
+                        }
+                    }
+                }
+            }
+
+            /**
+             * The number of Ids in the set in the range [lo, hi).
+             */
+            T count_range(T lo, T hi) const noexcept {
+                hi = std::min(hi, last());
+                if (lo >= hi) {
+                    return 0;
+                }
+
+                T count = 0;
+                T id = lo & ~static_cast<T>(0x3fU);
+                uint64_t mask = ~uint64_t(0) << (lo & 0x3fU);
+                while (id < hi) {
+                    const auto* chunk = m_data[chunk_id(id)].get();
+                    if (!chunk) {
+                        id = static_cast<T>((chunk_id(id) + 1) << (chunk_bits + 3U));
+                        mask = ~uint64_t(0);
+                        continue;
+                    }
+                    if (hi - id < 64) {
+                        mask &= ~(~uint64_t(0) << (hi - id));
+                    }
+                    count += static_cast<T>(detail::popcount64(load_word(chunk + offset(id)) & mask));
+                    id += 64;
+                    mask = ~uint64_t(0);
+                }
+                return count;
+            }
+
             const_iterator begin() const {
                 return {this, 0, last()};
             }
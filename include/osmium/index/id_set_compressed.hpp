@@ -0,0 +1,1103 @@
+#ifndef OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
+#define OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * Container for the lower 16 bits of all Ids in an IdSetCompressed
+             * with the same upper bits. Depending on the contents it is
+             * stored as a sorted array of values, as a bitmap, or as a list
+             * of runs of consecutive values.
+             */
+            class id_set_container {
+
+            public:
+
+                enum class container_type : uint8_t {
+                    array  = 0,
+                    bitmap = 1,
+                    run    = 2
+                };
+
+                enum : uint32_t {
+                    max_array_size = 4096,
+                    bitmap_words   = 1024,
+                    range          = 65536
+                };
+
+                /// Position in a container while iterating.
+                struct position {
+                    uint32_t value = 0;
+                    std::size_t index = 0;
+                };
+
+            private:
+
+                // Sorted values for array containers, pairs of (start,
+                // length - 1) for run containers.
+                std::vector<uint16_t> m_values;
+
+                // Bits for bitmap containers.
+                std::vector<uint64_t> m_bitmap;
+
+                uint32_t m_cardinality = 0;
+
+                container_type m_type = container_type::array;
+
+                std::size_t num_runs() const noexcept {
+                    return m_values.size() / 2;
+                }
+
+                uint32_t run_start(const std::size_t run) const noexcept {
+                    return m_values[2 * run];
+                }
+
+                uint32_t run_last(const std::size_t run) const noexcept {
+                    return static_cast<uint32_t>(m_values[2 * run]) + m_values[2 * run + 1];
+                }
+
+                static bool test_bit(const uint64_t* words, const uint32_t value) noexcept {
+                    return ((words[value >> 6U] >> (value & 63U)) & 1U) != 0;
+                }
+
+                static void set_bit(uint64_t* words, const uint32_t value) noexcept {
+                    words[value >> 6U] |= uint64_t{1} << (value & 63U);
+                }
+
+                static void clear_bit(uint64_t* words, const uint32_t value) noexcept {
+                    words[value >> 6U] &= ~(uint64_t{1} << (value & 63U));
+                }
+
+                static void set_range(uint64_t* words, const uint32_t first, const uint32_t last) noexcept {
+                    const uint32_t first_word = first >> 6U;
+                    const uint32_t last_word = last >> 6U;
+                    const uint64_t first_mask = ~uint64_t{0} << (first & 63U);
+                    const uint64_t last_mask = ~uint64_t{0} >> (63U - (last & 63U));
+                    if (first_word == last_word) {
+                        words[first_word] |= first_mask & last_mask;
+                        return;
+                    }
+                    words[first_word] |= first_mask;
+                    for (uint32_t w = first_word + 1; w < last_word; ++w) {
+                        words[w] = ~uint64_t{0};
+                    }
+                    words[last_word] |= last_mask;
+                }
+
+                // First set bit at or after value, range if there is none.
+                static uint32_t next_bit(const uint64_t* words, const uint32_t value) noexcept {
+                    uint32_t w = value >> 6U;
+                    if (w >= bitmap_words) {
+                        return range;
+                    }
+                    uint64_t word = words[w] & (~uint64_t{0} << (value & 63U));
+                    while (word == 0) {
+                        if (++w == bitmap_words) {
+                            return range;
+                        }
+                        word = words[w];
+                    }
+                    return (w << 6U) + static_cast<uint32_t>(count_trailing_zeros64(word));
+                }
+
+                bool run_contains(const uint32_t value) const noexcept {
+                    std::size_t lo = 0;
+                    std::size_t hi = num_runs();
+                    while (lo < hi) {
+                        const std::size_t mid = lo + (hi - lo) / 2;
+                        if (run_start(mid) <= value) {
+                            lo = mid + 1;
+                        } else {
+                            hi = mid;
+                        }
+                    }
+                    return lo > 0 && value <= run_last(lo - 1);
+                }
+
+                // Convert a run container into an array or bitmap container
+                // so it can be changed.
+                void make_mutable() {
+                    if (m_type != container_type::run) {
+                        return;
+                    }
+                    if (m_cardinality <= max_array_size) {
+                        std::vector<uint16_t> values;
+                        values.reserve(m_cardinality);
+                        for_each([&values](const uint32_t value) {
+                            values.push_back(static_cast<uint16_t>(value));
+                        });
+                        m_values.swap(values);
+                        m_type = container_type::array;
+                    } else {
+                        m_bitmap.assign(bitmap_words, 0);
+                        to_words(m_bitmap.data());
+                        std::vector<uint16_t>{}.swap(m_values);
+                        m_type = container_type::bitmap;
+                    }
+                }
+
+                void array_to_bitmap() {
+                    m_bitmap.assign(bitmap_words, 0);
+                    for (const auto value : m_values) {
+                        set_bit(m_bitmap.data(), value);
+                    }
+                    std::vector<uint16_t>{}.swap(m_values);
+                    m_type = container_type::bitmap;
+                }
+
+                // Check the invariants after reading a container.
+                bool valid() const noexcept {
+                    switch (m_type) {
+                        case container_type::array:
+                            return m_values.size() == m_cardinality &&
+                                   m_cardinality <= max_array_size &&
+                                   std::adjacent_find(m_values.cbegin(), m_values.cend(), std::greater_equal<uint16_t>{}) == m_values.cend();
+                        case container_type::bitmap: {
+                            uint32_t cardinality = 0;
+                            for (const auto word : m_bitmap) {
+                                cardinality += static_cast<uint32_t>(popcount64(word));
+                            }
+                            return m_bitmap.size() == bitmap_words &&
+                                   cardinality == m_cardinality &&
+                                   cardinality > max_array_size;
+                        }
+                        case container_type::run:
+                            break;
+                    }
+                    if (m_values.size() % 2 != 0) {
+                        return false;
+                    }
+                    uint32_t cardinality = 0;
+                    for (std::size_t r = 0; r < num_runs(); ++r) {
+                        if (run_last(r) >= range || (r > 0 && run_start(r) <= run_last(r - 1) + 1)) {
+                            return false;
+                        }
+                        cardinality += run_last(r) - run_start(r) + 1;
+                    }
+                    return cardinality == m_cardinality;
+                }
+
+                void bitmap_to_array() {
+                    m_values.clear();
+                    m_values.reserve(m_cardinality);
+                    for_each([this](const uint32_t value) {
+                        m_values.push_back(static_cast<uint16_t>(value));
+                    });
+                    std::vector<uint64_t>{}.swap(m_bitmap);
+                    m_type = container_type::array;
+                }
+
+            public:
+
+                id_set_container() = default;
+
+                /**
+                 * Create container from bitmap words, choosing an array or
+                 * bitmap container depending on the number of bits set.
+                 */
+                static id_set_container from_words(std::vector<uint64_t>&& words) {
+                    id_set_container result;
+                    uint32_t cardinality = 0;
+                    for (const auto word : words) {
+                        cardinality += static_cast<uint32_t>(popcount64(word));
+                    }
+                    result.m_cardinality = cardinality;
+                    result.m_bitmap = std::move(words);
+                    result.m_type = container_type::bitmap;
+                    if (cardinality <= max_array_size) {
+                        result.bitmap_to_array();
+                    }
+                    return result;
+                }
+
+                static id_set_container from_array(std::vector<uint16_t>&& values) {
+                    id_set_container result;
+                    result.m_cardinality = static_cast<uint32_t>(values.size());
+                    result.m_values = std::move(values);
+                    if (result.m_cardinality > max_array_size) {
+                        result.array_to_bitmap();
+                    }
+                    return result;
+                }
+
+                container_type type() const noexcept {
+                    return m_type;
+                }
+
+                uint32_t cardinality() const noexcept {
+                    return m_cardinality;
+                }
+
+                bool empty() const noexcept {
+                    return m_cardinality == 0;
+                }
+
+                const std::vector<uint16_t>& values() const noexcept {
+                    return m_values;
+                }
+
+                const std::vector<uint64_t>& bitmap() const noexcept {
+                    return m_bitmap;
+                }
+
+                std::size_t used_memory() const noexcept {
+                    return m_values.capacity() * sizeof(uint16_t) +
+                           m_bitmap.capacity() * sizeof(uint64_t);
+                }
+
+                bool contains(const uint32_t value) const noexcept {
+                    switch (m_type) {
+                        case container_type::array:
+                            return std::binary_search(m_values.cbegin(), m_values.cend(), static_cast<uint16_t>(value));
+                        case container_type::bitmap:
+                            return test_bit(m_bitmap.data(), value);
+                        case container_type::run:
+                            break;
+                    }
+                    return run_contains(value);
+                }
+
+                /// Add value, return true if it was not in the container.
+                bool add(const uint32_t value) {
+                    make_mutable();
+                    if (m_type == container_type::array) {
+                        const auto it = std::lower_bound(m_values.begin(), m_values.end(), static_cast<uint16_t>(value));
+                        if (it != m_values.end() && *it == value) {
+                            return false;
+                        }
+                        if (m_cardinality < max_array_size) {
+                            m_values.insert(it, static_cast<uint16_t>(value));
+                            ++m_cardinality;
+                            return true;
+                        }
+                        array_to_bitmap();
+                    }
+                    if (test_bit(m_bitmap.data(), value)) {
+                        return false;
+                    }
+                    set_bit(m_bitmap.data(), value);
+                    ++m_cardinality;
+                    return true;
+                }
+
+                /// Remove value, return true if it was in the container.
+                bool remove(const uint32_t value) {
+                    if (!contains(value)) {
+                        return false;
+                    }
+                    make_mutable();
+                    if (m_type == container_type::array) {
+                        m_values.erase(std::lower_bound(m_values.begin(), m_values.end(), static_cast<uint16_t>(value)));
+                        --m_cardinality;
+                        return true;
+                    }
+                    clear_bit(m_bitmap.data(), value);
+                    if (--m_cardinality <= max_array_size) {
+                        bitmap_to_array();
+                    }
+                    return true;
+                }
+
+                /// Set all bits for values in this container in words.
+                void to_words(uint64_t* words) const noexcept {
+                    switch (m_type) {
+                        case container_type::array:
+                            for (const auto value : m_values) {
+                                set_bit(words, value);
+                            }
+                            break;
+                        case container_type::bitmap:
+                            for (uint32_t w = 0; w < bitmap_words; ++w) {
+                                words[w] |= m_bitmap[w];
+                            }
+                            break;
+                        case container_type::run:
+                            for (std::size_t r = 0; r < num_runs(); ++r) {
+                                set_range(words, run_start(r), run_last(r));
+                            }
+                            break;
+                    }
+                }
+
+                std::vector<uint64_t> words() const {
+                    std::vector<uint64_t> result(bitmap_words, 0);
+                    to_words(result.data());
+                    return result;
+                }
+
+                /**
+                 * Call func with each value in the container in order.
+                 */
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    switch (m_type) {
+                        case container_type::array:
+                            for (const auto value : m_values) {
+                                std::forward<TFunc>(func)(static_cast<uint32_t>(value));
+                            }
+                            break;
+                        case container_type::bitmap:
+                            for (uint32_t w = 0; w < bitmap_words; ++w) {
+                                for (uint64_t word = m_bitmap[w]; word != 0; word &= word - 1) {
+                                    std::forward<TFunc>(func)((w << 6U) + static_cast<uint32_t>(count_trailing_zeros64(word)));
+                                }
+                            }
+                            break;
+                        case container_type::run:
+                            for (std::size_t r = 0; r < num_runs(); ++r) {
+                                const uint32_t last = run_last(r);
+                                for (uint32_t value = run_start(r); value <= last; ++value) {
+                                    std::forward<TFunc>(func)(value);
+                                }
+                            }
+                            break;
+                    }
+                }
+
+                /// Set pos to first value, return false if container is empty.
+                bool first(position& pos) const noexcept {
+                    pos.index = 0;
+                    switch (m_type) {
+                        case container_type::array:
+                            if (m_values.empty()) {
+                                return false;
+                            }
+                            pos.value = m_values[0];
+                            return true;
+                        case container_type::bitmap:
+                            pos.value = next_bit(m_bitmap.data(), 0);
+                            return pos.value != range;
+                        case container_type::run:
+                            break;
+                    }
+                    if (m_values.empty()) {
+                        return false;
+                    }
+                    pos.value = run_start(0);
+                    return true;
+                }
+
+                /// Advance pos to next value, return false if there is none.
+                bool next(position& pos) const noexcept {
+                    switch (m_type) {
+                        case container_type::array:
+                            if (++pos.index == m_values.size()) {
+                                return false;
+                            }
+                            pos.value = m_values[pos.index];
+                            return true;
+                        case container_type::bitmap:
+                            pos.value = next_bit(m_bitmap.data(), pos.value + 1);
+                            return pos.value != range;
+                        case container_type::run:
+                            break;
+                    }
+                    if (pos.value < run_last(pos.index)) {
+                        ++pos.value;
+                        return true;
+                    }
+                    if (++pos.index == num_runs()) {
+                        return false;
+                    }
+                    pos.value = run_start(pos.index);
+                    return true;
+                }
+
+                /**
+                 * Convert the container into the type using the least
+                 * memory. This is the only way run containers are created.
+                 */
+                void optimize() {
+                    if (m_cardinality == 0) {
+                        return;
+                    }
+
+                    std::size_t runs = 0;
+                    if (m_type == container_type::run) {
+                        runs = num_runs();
+                    } else {
+                        uint32_t last = range + 1;
+                        for_each([&runs, &last](const uint32_t value) {
+                            if (value != last + 1) {
+                                ++runs;
+                            }
+                            last = value;
+                        });
+                    }
+
+                    const std::size_t run_bytes = runs * 2 * sizeof(uint16_t);
+                    const std::size_t array_bytes = m_cardinality * sizeof(uint16_t);
+                    const std::size_t bitmap_bytes = bitmap_words * sizeof(uint64_t);
+
+                    if (run_bytes < std::min(array_bytes, bitmap_bytes)) {
+                        if (m_type != container_type::run) {
+                            std::vector<uint16_t> values;
+                            values.reserve(runs * 2);
+                            uint32_t start = range;
+                            uint32_t last = range;
+                            for_each([&](const uint32_t value) {
+                                if (start != range && value == last + 1) {
+                                    last = value;
+                                    return;
+                                }
+                                if (start != range) {
+                                    values.push_back(static_cast<uint16_t>(start));
+                                    values.push_back(static_cast<uint16_t>(last - start));
+                                }
+                                start = value;
+                                last = value;
+                            });
+                            values.push_back(static_cast<uint16_t>(start));
+                            values.push_back(static_cast<uint16_t>(last - start));
+                            m_values.swap(values);
+                            std::vector<uint64_t>{}.swap(m_bitmap);
+                            m_type = container_type::run;
+                        }
+                    } else {
+                        make_mutable();
+                    }
+                    m_values.shrink_to_fit();
+                }
+
+                /// Union of two containers.
+                static id_set_container unite(const id_set_container& a, const id_set_container& b) {
+                    if (a.m_type == container_type::array && b.m_type == container_type::array &&
+                        a.m_cardinality + b.m_cardinality <= max_array_size) {
+                        std::vector<uint16_t> values;
+                        values.reserve(a.m_cardinality + b.m_cardinality);
+                        std::set_union(a.m_values.cbegin(), a.m_values.cend(),
+                                       b.m_values.cbegin(), b.m_values.cend(),
+                                       std::back_inserter(values));
+                        return from_array(std::move(values));
+                    }
+                    std::vector<uint64_t> result{a.words()};
+                    b.to_words(result.data());
+                    return from_words(std::move(result));
+                }
+
+                /// Intersection of two containers.
+                static id_set_container intersect(const id_set_container& a, const id_set_container& b) {
+                    if (a.m_type == container_type::array && b.m_type == container_type::array) {
+                        const auto& small = a.m_cardinality <= b.m_cardinality ? a.m_values : b.m_values;
+                        const auto& large = a.m_cardinality <= b.m_cardinality ? b.m_values : a.m_values;
+                        std::vector<uint16_t> values;
+                        values.reserve(small.size());
+                        if (small.size() * 32 < large.size()) {
+                            // Very different sizes: binary search in larger
+                            for (const auto value : small) {
+                                if (std::binary_search(large.cbegin(), large.cend(), value)) {
+                                    values.push_back(value);
+                                }
+                            }
+                        } else {
+                            std::set_intersection(small.cbegin(), small.cend(),
+                                                  large.cbegin(), large.cend(),
+                                                  std::back_inserter(values));
+                        }
+                        return from_array(std::move(values));
+                    }
+                    if (a.m_type == container_type::array || b.m_type == container_type::array) {
+                        const auto& array = a.m_type == container_type::array ? a : b;
+                        const auto& other = a.m_type == container_type::array ? b : a;
+                        std::vector<uint16_t> values;
+                        values.reserve(array.m_cardinality);
+                        for (const auto value : array.m_values) {
+                            if (other.contains(value)) {
+                                values.push_back(value);
+                            }
+                        }
+                        return from_array(std::move(values));
+                    }
+                    std::vector<uint64_t> result{a.words()};
+                    const std::vector<uint64_t> other{b.words()};
+                    for (uint32_t w = 0; w < bitmap_words; ++w) {
+                        result[w] &= other[w];
+                    }
+                    return from_words(std::move(result));
+                }
+
+                /// All values in a but not in b.
+                static id_set_container subtract(const id_set_container& a, const id_set_container& b) {
+                    if (a.m_type == container_type::array) {
+                        std::vector<uint16_t> values;
+                        values.reserve(a.m_cardinality);
+                        for (const auto value : a.m_values) {
+                            if (!b.contains(value)) {
+                                values.push_back(value);
+                            }
+                        }
+                        return from_array(std::move(values));
+                    }
+                    std::vector<uint64_t> result{a.words()};
+                    const std::vector<uint64_t> other{b.words()};
+                    for (uint32_t w = 0; w < bitmap_words; ++w) {
+                        result[w] &= ~other[w];
+                    }
+                    return from_words(std::move(result));
+                }
+
+                /// Append the container in binary form to out.
+                void serialize(std::string& out) const {
+                    out += static_cast<char>(m_type);
+                    const uint32_t cardinality = m_cardinality;
+                    out.append(reinterpret_cast<const char*>(&cardinality), sizeof(cardinality));
+                    if (m_type == container_type::bitmap) {
+                        out.append(reinterpret_cast<const char*>(m_bitmap.data()), m_bitmap.size() * sizeof(uint64_t));
+                    } else {
+                        const auto size = static_cast<uint32_t>(m_values.size());
+                        out.append(reinterpret_cast<const char*>(&size), sizeof(size));
+                        out.append(reinterpret_cast<const char*>(m_values.data()), m_values.size() * sizeof(uint16_t));
+                    }
+                }
+
+                /**
+                 * Read container in binary form from data. Returns the
+                 * pointer after the container or nullptr on error.
+                 */
+                const char* deserialize(const char* data, const char* end) {
+                    if (end - data < 5) {
+                        return nullptr;
+                    }
+                    const auto type = static_cast<container_type>(*data++);
+                    std::memcpy(&m_cardinality, data, sizeof(m_cardinality));
+                    data += sizeof(m_cardinality);
+                    m_type = type;
+                    if (type == container_type::bitmap) {
+                        constexpr const std::size_t size = bitmap_words * sizeof(uint64_t);
+                        if (static_cast<std::size_t>(end - data) < size) {
+                            return nullptr;
+                        }
+                        m_bitmap.resize(bitmap_words);
+                        std::memcpy(m_bitmap.data(), data, size);
+                        return valid() ? data + size : nullptr;
+                    }
+                    if (type != container_type::array && type != container_type::run) {
+                        return nullptr;
+                    }
+                    uint32_t size = 0;
+                    if (end - data < static_cast<std::ptrdiff_t>(sizeof(size))) {
+                        return nullptr;
+                    }
+                    std::memcpy(&size, data, sizeof(size));
+                    data += sizeof(size);
+                    if (static_cast<std::size_t>(end - data) / sizeof(uint16_t) < size) {
+                        return nullptr;
+                    }
+                    m_values.resize(size);
+                    std::memcpy(m_values.data(), data, size * sizeof(uint16_t));
+                    return valid() ? data + size * sizeof(uint16_t) : nullptr;
+                }
+
+            }; // class id_set_container
+
+        } // namespace detail
+
+        template <typename T>
+        class IdSetCompressed;
+
+        /**
+         * Const_iterator for iterating over an IdSetCompressed.
+         */
+        template <typename T>
+        class IdSetCompressedIterator {
+
+            using id_set = IdSetCompressed<T>;
+
+            const id_set* m_set;
+            std::size_t m_container;
+            detail::id_set_container::position m_pos;
+
+            void skip_empty() noexcept {
+                while (m_container < m_set->m_containers.size() && !m_set->m_containers[m_container].first(m_pos)) {
+                    ++m_container;
+                }
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            IdSetCompressedIterator(const id_set* set, std::size_t container) noexcept :
+                m_set(set),
+                m_container(container) {
+                skip_empty();
+            }
+
+            IdSetCompressedIterator& operator++() noexcept {
+                if (!m_set->m_containers[m_container].next(m_pos)) {
+                    ++m_container;
+                    skip_empty();
+                }
+                return *this;
+            }
+
+            IdSetCompressedIterator operator++(int) noexcept {
+                IdSetCompressedIterator tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const IdSetCompressedIterator& rhs) const noexcept {
+                return m_set == rhs.m_set &&
+                       m_container == rhs.m_container &&
+                       (m_container == m_set->m_containers.size() || m_pos.value == rhs.m_pos.value);
+            }
+
+            bool operator!=(const IdSetCompressedIterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            T operator*() const noexcept {
+                return static_cast<T>((m_set->m_keys[m_container] << 16U) | m_pos.value);
+            }
+
+        }; // class IdSetCompressedIterator
+
+        /**
+         * A compressed set of Ids using the layout of "roaring bitmaps".
+         *
+         * The Ids are grouped by their upper bits into containers for
+         * ranges of 65536 Ids each. Containers with up to 4096 Ids store
+         * the lower 16 bits in a sorted array, larger containers use a
+         * bitmap of 8 kB. After calling optimize() containers with long
+         * runs of consecutive Ids are stored as a list of runs. This
+         * needs much less memory than IdSetDense for sparse sets while
+         * still being fast for dense sets.
+         *
+         * The set operators (|=, &=, -=) work container by container on
+         * the compressed data. Operations on bitmaps work on whole 64 bit
+         * words in simple loops the compiler can vectorize.
+         *
+         * Use for_each() for the fastest way of getting all Ids in the
+         * set in order, iterators are also available.
+         */
+        template <typename T>
+        class IdSetCompressed : public IdSet<T> {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+
+            friend class IdSetCompressedIterator<T>;
+
+            using container = detail::id_set_container;
+
+            std::vector<uint64_t> m_keys;
+            std::vector<container> m_containers;
+            std::size_t m_size = 0;
+
+            static uint64_t key(const T id) noexcept {
+                return static_cast<uint64_t>(id) >> 16U;
+            }
+
+            static uint32_t low(const T id) noexcept {
+                return static_cast<uint32_t>(id & 0xffffU);
+            }
+
+            // Index of container with key k or m_keys.size() if none.
+            std::size_t find_container(const uint64_t k) const noexcept {
+                if (!m_keys.empty() && m_keys.back() == k) {
+                    return m_keys.size() - 1;
+                }
+                const auto it = std::lower_bound(m_keys.cbegin(), m_keys.cend(), k);
+                if (it == m_keys.cend() || *it != k) {
+                    return m_keys.size();
+                }
+                return static_cast<std::size_t>(std::distance(m_keys.cbegin(), it));
+            }
+
+            container& get_container(const uint64_t k) {
+                // Ids are often set in order, check last container first
+                if (m_keys.empty() || m_keys.back() < k) {
+                    m_keys.push_back(k);
+                    m_containers.emplace_back();
+                    return m_containers.back();
+                }
+                const auto it = std::lower_bound(m_keys.begin(), m_keys.end(), k);
+                const auto n = std::distance(m_keys.begin(), it);
+                if (it == m_keys.end() || *it != k) {
+                    m_keys.insert(it, k);
+                    m_containers.emplace(m_containers.begin() + n);
+                }
+                return m_containers[static_cast<std::size_t>(n)];
+            }
+
+            void remove_empty_containers() {
+                std::size_t out = 0;
+                for (std::size_t n = 0; n < m_containers.size(); ++n) {
+                    if (!m_containers[n].empty()) {
+                        if (out != n) {
+                            m_keys[out] = m_keys[n];
+                            m_containers[out] = std::move(m_containers[n]);
+                        }
+                        ++out;
+                    }
+                }
+                m_keys.resize(out);
+                m_containers.resize(out);
+            }
+
+            void recalculate_size() noexcept {
+                m_size = 0;
+                for (const auto& c : m_containers) {
+                    m_size += c.cardinality();
+                }
+            }
+
+        public:
+
+            using const_iterator = IdSetCompressedIterator<T>;
+
+            IdSetCompressed() = default;
+
+            /**
+             * Add the Id to the set if it is not already in there.
+             *
+             * @param id The Id to set.
+             * @returns true if the Id was added, false if it was already set.
+             */
+            bool check_and_set(T id) {
+                if (get_container(key(id)).add(low(id))) {
+                    ++m_size;
+                    return true;
+                }
+                return false;
+            }
+
+            /**
+             * Add the given Id to the set.
+             *
+             * @param id The Id to set.
+             */
+            void set(T id) final {
+                (void)check_and_set(id);
+            }
+
+            /**
+             * Remove the given Id from the set.
+             *
+             * @param id The Id to unset.
+             */
+            void unset(T id) {
+                const auto n = find_container(key(id));
+                if (n == m_keys.size()) {
+                    return;
+                }
+                if (m_containers[n].remove(low(id))) {
+                    --m_size;
+                    if (m_containers[n].empty()) {
+                        m_keys.erase(m_keys.begin() + static_cast<std::ptrdiff_t>(n));
+                        m_containers.erase(m_containers.begin() + static_cast<std::ptrdiff_t>(n));
+                    }
+                }
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept final {
+                const auto n = find_container(key(id));
+                return n != m_keys.size() && m_containers[n].contains(low(id));
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept final {
+                return m_size == 0;
+            }
+
+            /**
+             * The number of Ids stored in the set.
+             */
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * Clear the set.
+             */
+            void clear() final {
+                m_keys.clear();
+                m_containers.clear();
+                m_size = 0;
+            }
+
+            std::size_t used_memory() const noexcept final {
+                std::size_t memory = m_keys.capacity() * sizeof(uint64_t) +
+                                     m_containers.capacity() * sizeof(container);
+                for (const auto& c : m_containers) {
+                    memory += c.used_memory();
+                }
+                return memory;
+            }
+
+            /// The number of containers (one per 65536 Id range in use).
+            std::size_t num_containers() const noexcept {
+                return m_containers.size();
+            }
+
+            /**
+             * Store each container in the form needing the least memory,
+             * using run containers for long runs of consecutive Ids. Call
+             * this after building the set. Changing the set later is
+             * still possible, but slower for run containers.
+             */
+            void optimize() {
+                for (auto& c : m_containers) {
+                    c.optimize();
+                }
+                m_keys.shrink_to_fit();
+                m_containers.shrink_to_fit();
+            }
+
+            /**
+             * Call func with each Id in the set in order.
+             */
+            template <typename TFunc>
+            void for_each(TFunc&& func) const {
+                for (std::size_t n = 0; n < m_containers.size(); ++n) {
+                    const uint64_t base = m_keys[n] << 16U;
+                    m_containers[n].for_each([&func, base](const uint32_t value) {
+                        std::forward<TFunc>(func)(static_cast<T>(base | value));
+                    });
+                }
+            }
+
+            /// Add all Ids in other to this set.
+            IdSetCompressed& operator|=(const IdSetCompressed& other) {
+                if (&other == this) {
+                    return *this;
+                }
+
+                std::vector<uint64_t> keys;
+                std::vector<container> containers;
+                keys.reserve(m_keys.size() + other.m_keys.size());
+                containers.reserve(m_keys.size() + other.m_keys.size());
+
+                std::size_t a = 0;
+                std::size_t b = 0;
+                while (a < m_keys.size() || b < other.m_keys.size()) {
+                    if (b == other.m_keys.size() || (a < m_keys.size() && m_keys[a] < other.m_keys[b])) {
+                        keys.push_back(m_keys[a]);
+                        containers.push_back(std::move(m_containers[a]));
+                        ++a;
+                    } else if (a == m_keys.size() || other.m_keys[b] < m_keys[a]) {
+                        keys.push_back(other.m_keys[b]);
+                        containers.push_back(other.m_containers[b]);
+                        ++b;
+                    } else {
+                        keys.push_back(m_keys[a]);
+                        containers.push_back(container::unite(m_containers[a], other.m_containers[b]));
+                        ++a;
+                        ++b;
+                    }
+                }
+
+                m_keys.swap(keys);
+                m_containers.swap(containers);
+                recalculate_size();
+                return *this;
+            }
+
+            /// Remove all Ids from this set that are not in other.
+            IdSetCompressed& operator&=(const IdSetCompressed& other) {
+                std::size_t a = 0;
+                std::size_t b = 0;
+                while (a < m_keys.size()) {
+                    while (b < other.m_keys.size() && other.m_keys[b] < m_keys[a]) {
+                        ++b;
+                    }
+                    if (b < other.m_keys.size() && other.m_keys[b] == m_keys[a]) {
+                        m_containers[a] = container::intersect(m_containers[a], other.m_containers[b]);
+                    } else {
+                        m_containers[a] = container{};
+                    }
+                    ++a;
+                }
+
+                remove_empty_containers();
+                recalculate_size();
+                return *this;
+            }
+
+            /// Remove all Ids in other from this set.
+            IdSetCompressed& operator-=(const IdSetCompressed& other) {
+                std::size_t b = 0;
+                for (std::size_t a = 0; a < m_keys.size(); ++a) {
+                    while (b < other.m_keys.size() && other.m_keys[b] < m_keys[a]) {
+                        ++b;
+                    }
+                    if (b < other.m_keys.size() && other.m_keys[b] == m_keys[a]) {
+                        m_containers[a] = container::subtract(m_containers[a], other.m_containers[b]);
+                    }
+                }
+
+                remove_empty_containers();
+                recalculate_size();
+                return *this;
+            }
+
+            /**
+             * Serialize the set into a binary string. The format uses the
+             * native byte order, so it can only be read on machines with
+             * the same byte order.
+             */
+            std::string serialize() const {
+                std::string out{"OSMIDSC1"};
+                const uint64_t count = m_keys.size();
+                out.append(reinterpret_cast<const char*>(&count), sizeof(count));
+                for (std::size_t n = 0; n < m_keys.size(); ++n) {
+                    out.append(reinterpret_cast<const char*>(&m_keys[n]), sizeof(uint64_t));
+                    m_containers[n].serialize(out);
+                }
+                return out;
+            }
+
+            /**
+             * Create a set from a binary string created by serialize().
+             *
+             * @throws std::runtime_error if the data is not valid.
+             */
+            static IdSetCompressed deserialize(const std::string& data) {
+                const char* ptr = data.data();
+                const char* const end = ptr + data.size();
+
+                if (data.size() < 16 || std::memcmp(ptr, "OSMIDSC1", 8) != 0) {
+                    throw std::runtime_error{"Invalid IdSetCompressed data"};
+                }
+                ptr += 8;
+                uint64_t count = 0;
+                std::memcpy(&count, ptr, sizeof(count));
+                ptr += sizeof(count);
+
+                IdSetCompressed result;
+                for (uint64_t n = 0; n < count; ++n) {
+                    uint64_t k = 0;
+                    if (end - ptr < static_cast<std::ptrdiff_t>(sizeof(k))) {
+                        throw std::runtime_error{"Invalid IdSetCompressed data"};
+                    }
+                    std::memcpy(&k, ptr, sizeof(k));
+                    ptr += sizeof(k);
+                    if (!result.m_keys.empty() && k <= result.m_keys.back()) {
+                        throw std::runtime_error{"Invalid IdSetCompressed data"};
+                    }
+                    container c;
+                    ptr = c.deserialize(ptr, end);
+                    if (!ptr) {
+                        throw std::runtime_error{"Invalid IdSetCompressed data"};
+                    }
+                    result.m_keys.push_back(k);
+                    result.m_containers.push_back(std::move(c));
+                }
+
+                result.recalculate_size();
+                return result;
+            }
+
+            const_iterator begin() const {
+                return {this, 0};
+            }
+
+            const_iterator end() const {
+                return {this, m_containers.size()};
+            }
+
+            const_iterator cbegin() const {
+                return begin();
+            }
+
+            const_iterator cend() const {
+                return end();
+            }
+
+        }; // class IdSetCompressed
+
+        template <typename T>
+        inline bool operator==(const IdSetCompressed<T>& lhs, const IdSetCompressed<T>& rhs) {
+            return lhs.size() == rhs.size() && std::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin());
+        }
+
+        template <typename T>
+        inline bool operator!=(const IdSetCompressed<T>& lhs, const IdSetCompressed<T>& rhs) {
+            return !(lhs == rhs);
+        }
+
+        template <typename T>
+        inline IdSetCompressed<T> operator|(IdSetCompressed<T> lhs, const IdSetCompressed<T>& rhs) {
+            lhs |= rhs;
+            return lhs;
+        }
+
+        template <typename T>
+        inline IdSetCompressed<T> operator&(IdSetCompressed<T> lhs, const IdSetCompressed<T>& rhs) {
+            lhs &= rhs;
+            return lhs;
+        }
+
+        template <typename T>
+        inline IdSetCompressed<T> operator-(IdSetCompressed<T> lhs, const IdSetCompressed<T>& rhs) {
+            lhs -= rhs;
+            return lhs;
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_COMPRESSED_HPP
@@ -0,0 +1,363 @@
+#ifndef OSMIUM_INDEX_ID_SET_CONCURRENT_HPP
+#define OSMIUM_INDEX_ID_SET_CONCURRENT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        template <typename T, std::size_t chunk_bits = detail::default_chunk_bits>
+        class IdSetDenseConcurrent;
+
+        /**
+         * Const_iterator for iterating over an IdSetDenseConcurrent. Do not
+         * change the set while iterating.
+         */
+        template <typename T, std::size_t chunk_bits>
+        class IdSetDenseConcurrentIterator {
+
+            using id_set = IdSetDenseConcurrent<T, chunk_bits>;
+
+            const id_set* m_set;
+            uint64_t m_value;
+
+            void next() noexcept {
+                m_value = m_set->next_set(m_value);
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            IdSetDenseConcurrentIterator(const id_set* set, uint64_t value) noexcept :
+                m_set(set),
+                m_value(value) {
+                next();
+            }
+
+            IdSetDenseConcurrentIterator& operator++() noexcept {
+                if (m_value != m_set->max_ids()) {
+                    ++m_value;
+                    next();
+                }
+                return *this;
+            }
+
+            IdSetDenseConcurrentIterator operator++(int) noexcept {
+                IdSetDenseConcurrentIterator tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const IdSetDenseConcurrentIterator& rhs) const noexcept {
+                return m_set == rhs.m_set && m_value == rhs.m_value;
+            }
+
+            bool operator!=(const IdSetDenseConcurrentIterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            T operator*() const noexcept {
+                return static_cast<T>(m_value);
+            }
+
+        }; // class IdSetDenseConcurrentIterator
+
+        /**
+         * A set of Ids like IdSetDense that can be changed from several
+         * threads at the same time, for instance from the handlers used
+         * with osmium::apply_parallel().
+         *
+         * The directory of chunks is allocated up front for the maximum
+         * number of Ids given in the constructor. Chunks are allocated
+         * when first needed and installed with an atomic compare-and-swap,
+         * bits are set with atomic fetch_or, so set(), check_and_set(),
+         * unset(), and get() can be called concurrently. The number of
+         * Ids is not tracked while setting to avoid contention between
+         * threads, size() counts the bits instead.
+         *
+         * clear() and iterating over the set must not happen at the same
+         * time as changes from other threads.
+         */
+        template <typename T, std::size_t chunk_bits>
+        class IdSetDenseConcurrent : public IdSet<T> {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+
+            friend class IdSetDenseConcurrentIterator<T, chunk_bits>;
+
+            using word_type = std::atomic<uint64_t>;
+
+            enum : uint64_t {
+                // Number of Ids in each chunk, the chunk needs
+                // 2^chunk_bits bytes as in IdSetDense.
+                ids_per_chunk = uint64_t{1} << (chunk_bits + 3U),
+                words_per_chunk = ids_per_chunk / 64
+            };
+
+            std::unique_ptr<std::atomic<word_type*>[]> m_chunks;
+            std::size_t m_num_chunks;
+
+            static std::size_t chunk_id(const uint64_t id) noexcept {
+                return static_cast<std::size_t>(id >> (chunk_bits + 3U));
+            }
+
+            static std::size_t word_id(const uint64_t id) noexcept {
+                return static_cast<std::size_t>((id >> 6U) & (words_per_chunk - 1));
+            }
+
+            static uint64_t bitmask(const uint64_t id) noexcept {
+                return uint64_t{1} << (id & 63U);
+            }
+
+            word_type* get_chunk(const std::size_t cid) const noexcept {
+                return m_chunks[cid].load(std::memory_order_acquire);
+            }
+
+            word_type& get_word(const uint64_t id) {
+                const auto cid = chunk_id(id);
+                if (cid >= m_num_chunks) {
+                    throw std::out_of_range{"Id too large for IdSetDenseConcurrent"};
+                }
+
+                word_type* chunk = get_chunk(cid);
+                if (!chunk) {
+                    std::unique_ptr<word_type[]> new_chunk{new word_type[words_per_chunk]()};
+                    word_type* expected = nullptr;
+                    if (m_chunks[cid].compare_exchange_strong(expected, new_chunk.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+                        chunk = new_chunk.release();
+                    } else {
+                        // another thread was faster
+                        chunk = expected;
+                    }
+                }
+
+                return chunk[word_id(id)];
+            }
+
+            // First Id set at or after id, max_ids() if there is none.
+            uint64_t next_set(uint64_t id) const noexcept {
+                while (id < max_ids()) {
+                    const word_type* chunk = get_chunk(chunk_id(id));
+                    if (!chunk) {
+                        id = (chunk_id(id) + 1) * ids_per_chunk;
+                        continue;
+                    }
+                    const uint64_t word = chunk[word_id(id)].load(std::memory_order_relaxed) & (~uint64_t{0} << (id & 63U));
+                    if (word != 0) {
+                        return (id & ~uint64_t{63}) + static_cast<uint64_t>(detail::count_trailing_zeros64(word));
+                    }
+                    id = (id & ~uint64_t{63}) + 64;
+                }
+                return max_ids();
+            }
+
+            void free_chunks() noexcept {
+                for (std::size_t n = 0; n < m_num_chunks; ++n) {
+                    delete[] m_chunks[n].exchange(nullptr);
+                }
+            }
+
+        public:
+
+            using const_iterator = IdSetDenseConcurrentIterator<T, chunk_bits>;
+
+            /**
+             * Create an empty set.
+             *
+             * @param max_ids All Ids must be smaller than this. The
+             *        default is large enough for all current OSM node Ids.
+             *        Only a small directory of the size
+             *        max_ids / 2^(chunk_bits+3) pointers is allocated up
+             *        front.
+             */
+            explicit IdSetDenseConcurrent(const uint64_t max_ids = uint64_t{1} << 36U) :
+                m_chunks(new std::atomic<word_type*>[(max_ids + ids_per_chunk - 1) / ids_per_chunk]),
+                m_num_chunks(static_cast<std::size_t>((max_ids + ids_per_chunk - 1) / ids_per_chunk)) {
+                for (std::size_t n = 0; n < m_num_chunks; ++n) {
+                    m_chunks[n].store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            IdSetDenseConcurrent(const IdSetDenseConcurrent&) = delete;
+            IdSetDenseConcurrent& operator=(const IdSetDenseConcurrent&) = delete;
+
+            IdSetDenseConcurrent(IdSetDenseConcurrent&&) = delete;
+            IdSetDenseConcurrent& operator=(IdSetDenseConcurrent&&) = delete;
+
+            ~IdSetDenseConcurrent() noexcept final {
+                free_chunks();
+            }
+
+            /// One more than the largest Id that can be stored.
+            uint64_t max_ids() const noexcept {
+                return static_cast<uint64_t>(m_num_chunks) * ids_per_chunk;
+            }
+
+            /**
+             * Add the Id to the set if it is not already in there. If
+             * several threads add the same Id at the same time, exactly
+             * one of them will get true.
+             *
+             * @param id The Id to set.
+             * @returns true if the Id was added, false if it was already set.
+             * @throws std::out_of_range if the Id is too large.
+             */
+            bool check_and_set(T id) {
+                const auto mask = bitmask(id);
+                return (get_word(id).fetch_or(mask, std::memory_order_relaxed) & mask) == 0;
+            }
+
+            /**
+             * Add the given Id to the set.
+             *
+             * @param id The Id to set.
+             * @throws std::out_of_range if the Id is too large.
+             */
+            void set(T id) final {
+                const auto mask = bitmask(id);
+                word_type& word = get_word(id);
+                // Avoid the atomic write if the bit is already set, this
+                // is much cheaper if many threads set the same Ids.
+                if ((word.load(std::memory_order_relaxed) & mask) == 0) {
+                    word.fetch_or(mask, std::memory_order_relaxed);
+                }
+            }
+
+            /**
+             * Remove the given Id from the set.
+             *
+             * @param id The Id to unset.
+             */
+            void unset(T id) {
+                const auto cid = chunk_id(id);
+                if (cid >= m_num_chunks) {
+                    return;
+                }
+                word_type* chunk = get_chunk(cid);
+                if (chunk) {
+                    chunk[word_id(id)].fetch_and(~bitmask(id), std::memory_order_relaxed);
+                }
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept final {
+                const auto cid = chunk_id(id);
+                if (cid >= m_num_chunks) {
+                    return false;
+                }
+                const word_type* chunk = get_chunk(cid);
+                if (!chunk) {
+                    return false;
+                }
+                return (chunk[word_id(id)].load(std::memory_order_relaxed) & bitmask(id)) != 0;
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept final {
+                return next_set(0) == max_ids();
+            }
+
+            /**
+             * The number of Ids stored in the set. This counts all bits
+             * set, so it is expensive for large sets.
+             */
+            std::size_t size() const noexcept {
+                std::size_t count = 0;
+                for (std::size_t n = 0; n < m_num_chunks; ++n) {
+                    const word_type* chunk = get_chunk(n);
+                    if (chunk) {
+                        for (std::size_t w = 0; w < words_per_chunk; ++w) {
+                            count += static_cast<std::size_t>(detail::popcount64(chunk[w].load(std::memory_order_relaxed)));
+                        }
+                    }
+                }
+                return count;
+            }
+
+            /**
+             * Clear the set. Must not be called while other threads are
+             * using the set.
+             */
+            void clear() final {
+                free_chunks();
+            }
+
+            std::size_t used_memory() const noexcept final {
+                std::size_t memory = m_num_chunks * sizeof(std::atomic<word_type*>);
+                for (std::size_t n = 0; n < m_num_chunks; ++n) {
+                    if (get_chunk(n)) {
+                        memory += words_per_chunk * sizeof(word_type);
+                    }
+                }
+                return memory;
+            }
+
+            const_iterator begin() const {
+                return {this, 0};
+            }
+
+            const_iterator end() const {
+                return {this, max_ids()};
+            }
+
+        }; // class IdSetDenseConcurrent
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_CONCURRENT_HPP
@@ -0,0 +1,559 @@
+#ifndef OSMIUM_INDEX_ID_SET_MMAP_HPP
+#define OSMIUM_INDEX_ID_SET_MMAP_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    /**
+     * Exception thrown when an Id set file can not be used.
+     */
+    struct id_set_file_error : public std::runtime_error {
+
+        explicit id_set_file_error(const char* message) :
+            std::runtime_error(message) {
+        }
+
+        explicit id_set_file_error(const std::string& message) :
+            std::runtime_error(message) {
+        }
+
+    }; // struct id_set_file_error
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * The header at the start of an Id set file. All numbers are
+             * in the byte order of the machine that wrote the file.
+             */
+            struct id_set_file_header {
+                char magic[8];
+                uint32_t version;
+                uint32_t flags;
+                uint64_t data_offset;
+                uint64_t num_ids;
+                uint64_t count;
+            };
+
+        } // namespace detail
+
+        template <typename T>
+        class IdSetDenseMmap;
+
+        /**
+         * Const_iterator for iterating over an IdSetDenseMmap.
+         */
+        template <typename T>
+        class IdSetDenseMmapIterator {
+
+            using id_set = IdSetDenseMmap<T>;
+
+            const id_set* m_set;
+            uint64_t m_value;
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            IdSetDenseMmapIterator(const id_set* set, uint64_t value) noexcept :
+                m_set(set),
+                m_value(set->next_set(value)) {
+            }
+
+            IdSetDenseMmapIterator& operator++() noexcept {
+                if (m_value != m_set->num_ids()) {
+                    m_value = m_set->next_set(m_value + 1);
+                }
+                return *this;
+            }
+
+            IdSetDenseMmapIterator operator++(int) noexcept {
+                IdSetDenseMmapIterator tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const IdSetDenseMmapIterator& rhs) const noexcept {
+                return m_set == rhs.m_set && m_value == rhs.m_value;
+            }
+
+            bool operator!=(const IdSetDenseMmapIterator& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            T operator*() const noexcept {
+                return static_cast<T>(m_value);
+            }
+
+        }; // class IdSetDenseMmapIterator
+
+        /**
+         * A dense set of Ids like IdSetDense, but stored as one bitmap in
+         * a memory mapping. The mapping is either anonymous or backed by a
+         * file, so the set can be larger than main memory and can be
+         * saved and opened again without rebuilding it. Opening a file
+         * only maps it, so it is instant and the operating system only
+         * reads the parts of the file that are actually used.
+         *
+         * The file starts with a header (see detail::id_set_file_header)
+         * followed, at a page-aligned offset, by the bitmap. The file is
+         * created as a sparse file, so ranges without any Ids set need no
+         * space on disk on most file systems.
+         *
+         * While a file is open for writing it is marked as dirty. The mark
+         * is only removed by close(), a file that was not closed properly
+         * can not be opened again.
+         *
+         * This class is not thread-safe.
+         */
+        template <typename T>
+        class IdSetDenseMmap : public IdSet<T> {
+
+            static_assert(std::is_unsigned<T>::value, "Needs unsigned type");
+            static_assert(sizeof(T) >= 4, "Needs at least 32bit type");
+
+            friend class IdSetDenseMmapIterator<T>;
+
+        public:
+
+            enum class mode {
+                /// Open existing file for reading.
+                read_only,
+                /// Open existing file for reading and writing.
+                read_write,
+                /// Create new file or truncate existing file.
+                create
+            };
+
+            enum : uint32_t {
+                format_version = 1
+            };
+
+            enum : std::size_t {
+                header_size = 4096,
+                /// The bitmap grows in steps of this many Ids.
+                size_increment = 1UL << 26U
+            };
+
+        private:
+
+            enum : uint32_t {
+                flag_dirty = 0x01U
+            };
+
+            static constexpr const char* magic() noexcept {
+                return "OSMIDSET";
+            }
+
+            std::string m_filename;
+            int m_fd = -1;
+            mode m_mode = mode::create;
+            osmium::util::MemoryMapping m_mapping;
+            detail::id_set_file_header m_header;
+
+            static int open_file(const std::string& filename, const mode m) {
+                int flags = m == mode::read_only ? O_RDONLY : O_RDWR; // NOLINT(hicpp-signed-bitwise)
+                if (m == mode::create) {
+                    flags |= O_CREAT | O_TRUNC; // NOLINT(hicpp-signed-bitwise)
+                }
+#ifdef O_BINARY
+                flags |= O_BINARY; // NOLINT(hicpp-signed-bitwise)
+#endif
+                const int fd = ::open(filename.c_str(), flags, 0666);
+                if (fd < 0) {
+                    throw std::system_error{errno, std::system_category(), std::string{"Open failed for '"} + filename + "'"};
+                }
+                if (m != mode::create && osmium::file_size(fd) < header_size) {
+                    ::close(fd);
+                    throw id_set_file_error{"Id set file '" + filename + "' is too short"};
+                }
+                return fd;
+            }
+
+            static std::size_t file_bytes(const uint64_t num_ids) noexcept {
+                return header_size + static_cast<std::size_t>(num_ids / 8);
+            }
+
+            static osmium::util::MemoryMapping::mapping_mode mapping_mode(const mode m) noexcept {
+                return m == mode::read_only ? osmium::util::MemoryMapping::mapping_mode::readonly
+                                            : osmium::util::MemoryMapping::mapping_mode::write_shared;
+            }
+
+            uint64_t* words() const noexcept {
+                return reinterpret_cast<uint64_t*>(m_mapping.get_addr<char>() + header_size);
+            }
+
+            void init_header() noexcept {
+                std::memcpy(m_header.magic, magic(), sizeof(m_header.magic));
+                m_header.version = format_version;
+                m_header.data_offset = header_size;
+            }
+
+            void read_header() {
+                std::memcpy(&m_header, m_mapping.get_addr<char>(), sizeof(m_header));
+                if (std::strncmp(m_header.magic, magic(), sizeof(m_header.magic)) != 0) {
+                    throw id_set_file_error{"File '" + m_filename + "' is not an Id set file"};
+                }
+                if (m_header.version != format_version) {
+                    throw id_set_file_error{"Id set file '" + m_filename + "' has unsupported version " + std::to_string(m_header.version)};
+                }
+                if (m_header.data_offset != header_size || m_header.num_ids % 64 != 0) {
+                    throw id_set_file_error{"Id set file '" + m_filename + "' has unsupported layout"};
+                }
+                if (m_header.flags & flag_dirty) {
+                    throw id_set_file_error{"Id set file '" + m_filename + "' was not closed properly"};
+                }
+                if (osmium::file_size(m_fd) < file_bytes(m_header.num_ids)) {
+                    throw id_set_file_error{"Id set file '" + m_filename + "' is truncated"};
+                }
+            }
+
+            void write_header() noexcept {
+                std::memcpy(m_mapping.get_addr<char>(), &m_header, sizeof(m_header));
+            }
+
+            void sync_to_disk() {
+#ifndef _WIN32
+                if (::msync(m_mapping.get_addr(), m_mapping.size(), MS_SYNC) != 0) {
+                    throw std::system_error{errno, std::system_category(), "msync failed"};
+                }
+#endif
+            }
+
+            void check_writable() const {
+                if (m_mode == mode::read_only) {
+                    throw id_set_file_error{"Id set file '" + m_filename + "' is opened read-only"};
+                }
+            }
+
+            // New space is zero-filled by the operating system for both
+            // anonymous mappings and files.
+            void grow(const uint64_t id) {
+                const uint64_t new_ids = ((id / size_increment) + 1) * size_increment;
+#ifndef __linux__
+                // Anonymous mappings can only be resized on Linux.
+                if (m_fd < 0) {
+                    osmium::util::MemoryMapping mapping{file_bytes(new_ids), osmium::util::MemoryMapping::mapping_mode::write_private};
+                    std::memcpy(mapping.get_addr(), m_mapping.get_addr(), m_mapping.size());
+                    m_mapping = std::move(mapping);
+                    m_header.num_ids = new_ids;
+                    return;
+                }
+#endif
+                m_mapping.resize(file_bytes(new_ids));
+                m_header.num_ids = new_ids;
+            }
+
+            // First Id set at or after id, num_ids() if there is none.
+            uint64_t next_set(uint64_t id) const noexcept {
+                const uint64_t* data = words();
+                const uint64_t num_words = m_header.num_ids / 64;
+                uint64_t w = id / 64;
+                if (w >= num_words) {
+                    return m_header.num_ids;
+                }
+                uint64_t word = data[w] & (~uint64_t{0} << (id & 63U));
+                while (word == 0) {
+                    if (++w == num_words) {
+                        return m_header.num_ids;
+                    }
+                    word = data[w];
+                }
+                return w * 64 + static_cast<uint64_t>(detail::count_trailing_zeros64(word));
+            }
+
+        public:
+
+            using const_iterator = IdSetDenseMmapIterator<T>;
+
+            /**
+             * Create an empty set in an anonymous memory mapping. Use
+             * save() to write it to a file.
+             */
+            IdSetDenseMmap() :
+                m_mapping(header_size, osmium::util::MemoryMapping::mapping_mode::write_private),
+                m_header() {
+                init_header();
+            }
+
+            /**
+             * Open or create an Id set file.
+             *
+             * @param filename Name of the file.
+             * @param m Open mode.
+             * @throws std::system_error if the file can not be opened or
+             *         mapped.
+             * @throws osmium::id_set_file_error if the file is not a valid
+             *         Id set file, has an unsupported version, or was not
+             *         closed properly.
+             */
+            explicit IdSetDenseMmap(const std::string& filename, const mode m = mode::read_only) :
+                m_filename(filename),
+                m_fd(open_file(filename, m)),
+                m_mode(m),
+                m_mapping(header_size, mapping_mode(m), m_fd),
+                m_header() {
+                try {
+                    if (m == mode::create) {
+                        init_header();
+                    } else {
+                        read_header();
+                        m_mapping.resize(file_bytes(m_header.num_ids));
+                    }
+                    if (m != mode::read_only) {
+                        m_header.flags |= flag_dirty;
+                        write_header();
+                        sync_to_disk();
+                    }
+                } catch (...) {
+                    m_mapping.unmap();
+                    ::close(m_fd);
+                    throw;
+                }
+            }
+
+            IdSetDenseMmap(const IdSetDenseMmap&) = delete;
+            IdSetDenseMmap& operator=(const IdSetDenseMmap&) = delete;
+
+            IdSetDenseMmap(IdSetDenseMmap&&) = delete;
+            IdSetDenseMmap& operator=(IdSetDenseMmap&&) = delete;
+
+            ~IdSetDenseMmap() noexcept final {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /// The file name or an empty string for anonymous sets.
+            const std::string& filename() const noexcept {
+                return m_filename;
+            }
+
+            /// The number of Ids the bitmap currently has space for.
+            uint64_t num_ids() const noexcept {
+                return m_header.num_ids;
+            }
+
+            /**
+             * Add the Id to the set if it is not already in there.
+             *
+             * @param id The Id to set.
+             * @returns true if the Id was added, false if it was already set.
+             * @throws osmium::id_set_file_error if the file is read-only.
+             */
+            bool check_and_set(T id) {
+                check_writable();
+                if (id >= m_header.num_ids) {
+                    grow(id);
+                }
+                uint64_t& word = words()[id / 64];
+                const uint64_t mask = uint64_t{1} << (id & 63U);
+                if (word & mask) {
+                    return false;
+                }
+                word |= mask;
+                ++m_header.count;
+                return true;
+            }
+
+            /**
+             * Add the given Id to the set.
+             *
+             * @param id The Id to set.
+             * @throws osmium::id_set_file_error if the file is read-only.
+             */
+            void set(T id) final {
+                (void)check_and_set(id);
+            }
+
+            /**
+             * Remove the given Id from the set.
+             *
+             * @param id The Id to unset.
+             * @throws osmium::id_set_file_error if the file is read-only.
+             */
+            void unset(T id) {
+                check_writable();
+                if (id >= m_header.num_ids) {
+                    return;
+                }
+                uint64_t& word = words()[id / 64];
+                const uint64_t mask = uint64_t{1} << (id & 63U);
+                if (word & mask) {
+                    word &= ~mask;
+                    --m_header.count;
+                }
+            }
+
+            /**
+             * Is the Id in the set?
+             *
+             * @param id The Id to check.
+             */
+            bool get(T id) const noexcept final {
+                if (id >= m_header.num_ids) {
+                    return false;
+                }
+                return (words()[id / 64] & (uint64_t{1} << (id & 63U))) != 0;
+            }
+
+            /**
+             * Is the set empty?
+             */
+            bool empty() const noexcept final {
+                return m_header.count == 0;
+            }
+
+            /**
+             * The number of Ids stored in the set.
+             */
+            std::size_t size() const noexcept {
+                return static_cast<std::size_t>(m_header.count);
+            }
+
+            /**
+             * Clear the set. The file keeps its size.
+             */
+            void clear() final {
+                check_writable();
+                std::memset(words(), 0, static_cast<std::size_t>(m_header.num_ids / 8));
+                m_header.count = 0;
+            }
+
+            std::size_t used_memory() const noexcept final {
+                return m_mapping.size();
+            }
+
+            /**
+             * Write the set to a new Id set file. Works for anonymous and
+             * file based sets.
+             */
+            void save(const std::string& filename) const {
+                const int fd = open_file(filename, mode::create);
+                try {
+                    detail::id_set_file_header header = m_header;
+                    header.flags &= ~static_cast<uint32_t>(flag_dirty);
+                    std::string buffer(header_size, '\0');
+                    std::memcpy(&buffer[0], &header, sizeof(header));
+                    osmium::io::detail::reliable_write(fd, buffer.data(), buffer.size());
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(words()), static_cast<std::size_t>(m_header.num_ids / 8));
+                    osmium::io::detail::reliable_fsync(fd);
+                } catch (...) {
+                    ::close(fd);
+                    throw;
+                }
+                if (::close(fd) != 0) {
+                    throw std::system_error{errno, std::system_category(), "Close failed"};
+                }
+            }
+
+            /**
+             * Write header and all changes to disk. The file stays marked
+             * as dirty until close() is called. Does nothing for anonymous
+             * sets.
+             */
+            void flush() {
+                if (m_fd >= 0 && m_mode != mode::read_only && m_mapping) {
+                    write_header();
+                    sync_to_disk();
+                }
+            }
+
+            /**
+             * Write all changes to disk, mark file as cleanly closed, and
+             * close it. The object can not be used any more after this.
+             * Does nothing for anonymous sets.
+             */
+            void close() {
+                if (m_fd < 0) {
+                    return;
+                }
+                if (m_mode != mode::read_only) {
+                    m_header.flags &= ~static_cast<uint32_t>(flag_dirty);
+                    flush();
+                }
+                m_mapping.unmap();
+                const int fd = m_fd;
+                m_fd = -1;
+                if (::close(fd) != 0) {
+                    throw std::system_error{errno, std::system_category(), "Close failed"};
+                }
+            }
+
+            const_iterator begin() const {
+                return {this, 0};
+            }
+
+            const_iterator end() const {
+                return {this, m_header.num_ids};
+            }
+
+        }; // class IdSetDenseMmap
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_ID_SET_MMAP_HPP
@@ -0,0 +1,489 @@
+#ifndef OSMIUM_INDEX_LOCATION_CACHE_HPP
+#define OSMIUM_INDEX_LOCATION_CACHE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/index/detail/mmap_hints.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+namespace osmium {
+
+    /**
+     * Exception thrown when a location cache file can not be used.
+     */
+    struct location_cache_error : public std::runtime_error {
+
+        explicit location_cache_error(const char* message) :
+            std::runtime_error(message) {
+        }
+
+        explicit location_cache_error(const std::string& message) :
+            std::runtime_error(message) {
+        }
+
+    }; // struct location_cache_error
+
+    namespace index {
+
+        namespace detail {
+
+            /**
+             * The header at the start of a location cache file. All
+             * numbers are in the byte order of the machine that wrote the
+             * file.
+             */
+            struct location_cache_header {
+                char magic[8];
+                uint32_t version;
+                uint32_t flags;
+                uint64_t data_offset;
+                uint64_t num_ids;
+                int64_t timestamp;
+                uint64_t sequence_number;
+                int32_t bbox[4]; // min x, min y, max x, max y
+            };
+
+        } // namespace detail
+
+        /**
+         * A node location index in a file with a header describing its
+         * contents. It can be used in place of the DenseFileArray used
+         * by a lot of programs as persistent location cache, but it can
+         * also be kept up to date by applying change files.
+         *
+         * The file starts with a header (see
+         * detail::location_cache_header) containing the number of IDs in
+         * the file, the timestamp and sequence number of the replication
+         * state the data corresponds to, and the bounding box of all
+         * locations ever set. It is followed, at a page-aligned offset, by
+         * a dense array of locations indexed by node ID. The whole file is
+         * memory mapped.
+         *
+         * While a cache file is open for writing it is marked as dirty.
+         * The mark is only removed by close(), so a file that was not
+         * closed properly, for instance because a program crashed while
+         * applying updates, is detected and can not be opened again. Such
+         * a file has to be rebuilt.
+         *
+         * Only positive node IDs are supported.
+         */
+        class LocationCache : public osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location> {
+
+        public:
+
+            enum class mode {
+                /// Open existing file for reading.
+                read_only,
+                /// Open existing file for reading and writing.
+                read_write,
+                /// Create new file or truncate existing file.
+                create
+            };
+
+            enum : uint32_t {
+                format_version = 1
+            };
+
+            enum : std::size_t {
+                header_size = 4096,
+                /// The file grows in steps of this many IDs.
+                size_increment = 1024UL * 1024UL
+            };
+
+        private:
+
+            enum : uint32_t {
+                flag_dirty = 0x01U
+            };
+
+            static constexpr const char* magic() noexcept {
+                return "OSMLOCC";
+            }
+
+            std::string m_filename;
+            int m_fd = -1;
+            mode m_mode;
+            osmium::util::MemoryMapping m_mapping;
+            detail::location_cache_header m_header;
+            osmium::Box m_bbox;
+
+            static int open_file(const std::string& filename, const mode m) {
+                int flags = m == mode::read_only ? O_RDONLY : O_RDWR; // NOLINT(hicpp-signed-bitwise)
+                if (m == mode::create) {
+                    flags |= O_CREAT | O_TRUNC; // NOLINT(hicpp-signed-bitwise)
+                }
+#ifdef O_BINARY
+                flags |= O_BINARY; // NOLINT(hicpp-signed-bitwise)
+#endif
+                const int fd = ::open(filename.c_str(), flags, 0666);
+                if (fd < 0) {
+                    throw std::system_error{errno, std::system_category(), std::string{"Open failed for '"} + filename + "'"};
+                }
+                if (m != mode::create && osmium::file_size(fd) < header_size) {
+                    ::close(fd);
+                    throw location_cache_error{"Location cache file '" + filename + "' is too short"};
+                }
+                return fd;
+            }
+
+            std::size_t file_bytes(const std::size_t num_ids) const noexcept {
+                return header_size + num_ids * sizeof(osmium::Location);
+            }
+
+            osmium::util::MemoryMapping::mapping_mode mapping_mode() const noexcept {
+                return m_mode == mode::read_only ? osmium::util::MemoryMapping::mapping_mode::readonly
+                                                 : osmium::util::MemoryMapping::mapping_mode::write_shared;
+            }
+
+            osmium::Location* data() const noexcept {
+                return reinterpret_cast<osmium::Location*>(m_mapping.get_addr<char>() + header_size);
+            }
+
+            void read_header() {
+                std::memcpy(&m_header, m_mapping.get_addr<char>(), sizeof(m_header));
+                if (std::strncmp(m_header.magic, magic(), sizeof(m_header.magic)) != 0) {
+                    throw location_cache_error{"File '" + m_filename + "' is not a location cache"};
+                }
+                if (m_header.version != format_version) {
+                    throw location_cache_error{"Location cache file '" + m_filename + "' has unsupported version " + std::to_string(m_header.version)};
+                }
+                if (m_header.data_offset != header_size) {
+                    throw location_cache_error{"Location cache file '" + m_filename + "' has unsupported data offset"};
+                }
+                if (m_header.flags & flag_dirty) {
+                    throw location_cache_error{"Location cache file '" + m_filename + "' was not closed properly"};
+                }
+                if (osmium::file_size(m_fd) < file_bytes(m_header.num_ids)) {
+                    throw location_cache_error{"Location cache file '" + m_filename + "' is truncated"};
+                }
+                m_bbox = osmium::Box{osmium::Location{m_header.bbox[0], m_header.bbox[1]},
+                                     osmium::Location{m_header.bbox[2], m_header.bbox[3]}};
+            }
+
+            void write_header() {
+                m_header.bbox[0] = m_bbox.bottom_left().x();
+                m_header.bbox[1] = m_bbox.bottom_left().y();
+                m_header.bbox[2] = m_bbox.top_right().x();
+                m_header.bbox[3] = m_bbox.top_right().y();
+                std::memcpy(m_mapping.get_addr<char>(), &m_header, sizeof(m_header));
+            }
+
+            void sync_to_disk() {
+#ifndef _WIN32
+                if (::msync(m_mapping.get_addr(), m_mapping.size(), MS_SYNC) != 0) {
+                    throw std::system_error{errno, std::system_category(), "msync failed"};
+                }
+#endif
+            }
+
+            void check_writable() const {
+                if (m_mode == mode::read_only) {
+                    throw location_cache_error{"Location cache file '" + m_filename + "' is opened read-only"};
+                }
+            }
+
+            void grow(const std::size_t min_ids) {
+                const std::size_t old_ids = m_header.num_ids;
+                const std::size_t new_ids = ((min_ids / size_increment) + 1) * size_increment;
+                m_mapping.resize(file_bytes(new_ids));
+                std::fill(data() + old_ids, data() + new_ids, osmium::index::empty_value<osmium::Location>());
+                m_header.num_ids = new_ids;
+            }
+
+        public:
+
+            /**
+             * Open or create a location cache file.
+             *
+             * @param filename Name of the cache file.
+             * @param m Open mode.
+             * @throws std::system_error if the file can not be opened or
+             *         mapped.
+             * @throws osmium::location_cache_error if the file is not a
+             *         valid location cache, has an unsupported version, or
+             *         was not closed properly.
+             */
+            explicit LocationCache(const std::string& filename, const mode m = mode::read_only) :
+                m_filename(filename),
+                m_fd(open_file(filename, m)),
+                m_mode(m),
+                m_mapping(header_size, mapping_mode(), m_fd),
+                m_header() {
+                try {
+                    if (m == mode::create) {
+                        std::memcpy(m_header.magic, magic(), sizeof(m_header.magic));
+                        m_header.version = format_version;
+                        m_header.data_offset = header_size;
+                    } else {
+                        read_header();
+                        m_mapping.resize(file_bytes(m_header.num_ids));
+                    }
+                    if (m != mode::read_only) {
+                        m_header.flags |= flag_dirty;
+                        write_header();
+                        sync_to_disk();
+                    }
+                } catch (...) {
+                    m_mapping.unmap();
+                    ::close(m_fd);
+                    throw;
+                }
+            }
+
+            LocationCache(const LocationCache&) = delete;
+            LocationCache& operator=(const LocationCache&) = delete;
+
+            LocationCache(LocationCache&&) = delete;
+            LocationCache& operator=(LocationCache&&) = delete;
+
+            ~LocationCache() noexcept final {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            const std::string& filename() const noexcept {
+                return m_filename;
+            }
+
+            /// The timestamp of the replication state of the data.
+            osmium::Timestamp timestamp() const noexcept {
+                return osmium::Timestamp{static_cast<uint32_t>(m_header.timestamp)};
+            }
+
+            /// The sequence number of the replication state of the data.
+            uint64_t sequence_number() const noexcept {
+                return m_header.sequence_number;
+            }
+
+            /**
+             * Set the replication state the data corresponds to. Call this
+             * after applying a change file.
+             */
+            void set_replication_state(const osmium::Timestamp timestamp, const uint64_t sequence_number) {
+                check_writable();
+                m_header.timestamp = timestamp.seconds_since_epoch();
+                m_header.sequence_number = sequence_number;
+            }
+
+            /**
+             * The bounding box of all locations set. It is never made
+             * smaller when locations are removed or changed.
+             */
+            const osmium::Box& bbox() const noexcept {
+                return m_bbox;
+            }
+
+            void reserve(const std::size_t size) final {
+                check_writable();
+                if (size > m_header.num_ids) {
+                    grow(size - 1);
+                }
+            }
+
+            void set(const osmium::unsigned_object_id_type id, const osmium::Location value) final {
+                check_writable();
+                if (id >= m_header.num_ids) {
+                    grow(id);
+                }
+                data()[id] = value;
+                if (value.valid()) {
+                    m_bbox.extend(value);
+                }
+            }
+
+            /**
+             * Remove the location for the ID.
+             */
+            void remove(const osmium::unsigned_object_id_type id) {
+                check_writable();
+                if (id < m_header.num_ids) {
+                    data()[id] = osmium::index::empty_value<osmium::Location>();
+                }
+            }
+
+            osmium::Location get(const osmium::unsigned_object_id_type id) const final {
+                const osmium::Location value = get_noexcept(id);
+                if (value == osmium::index::empty_value<osmium::Location>()) {
+                    throw osmium::not_found{id};
+                }
+                return value;
+            }
+
+            osmium::Location get_noexcept(const osmium::unsigned_object_id_type id) const noexcept final {
+                if (id >= m_header.num_ids) {
+                    count_lookup(false);
+                    return osmium::index::empty_value<osmium::Location>();
+                }
+                const osmium::Location value = data()[id];
+                count_lookup(value != osmium::index::empty_value<osmium::Location>());
+                return value;
+            }
+
+            void get_many(const osmium::unsigned_object_id_type* ids, const std::size_t count, osmium::Location* values) const noexcept final {
+                const osmium::Location* locations = data();
+                for (std::size_t i = 0; i < count && i < detail::prefetch_distance; ++i) {
+                    if (ids[i] < m_header.num_ids) {
+                        detail::prefetch(locations + ids[i]);
+                    }
+                }
+                for (std::size_t i = 0; i < count; ++i) {
+                    const std::size_t ahead = i + detail::prefetch_distance;
+                    if (ahead < count && ids[ahead] < m_header.num_ids) {
+                        detail::prefetch(locations + ids[ahead]);
+                    }
+                    values[i] = ids[i] < m_header.num_ids ? locations[ids[i]] : osmium::index::empty_value<osmium::Location>();
+                    count_lookup(values[i] != osmium::index::empty_value<osmium::Location>());
+                }
+            }
+
+            void prefetch(const osmium::unsigned_object_id_type* ids, const std::size_t count) const final {
+                detail::advise_will_need(data(), sizeof(osmium::Location), m_header.num_ids, ids, count);
+            }
+
+            /// The number of IDs the file has space for.
+            std::size_t size() const final {
+                return m_header.num_ids;
+            }
+
+            std::size_t used_memory() const final {
+                return m_header.num_ids * sizeof(osmium::Location);
+            }
+
+            /**
+             * Remove all locations. The file keeps its size.
+             */
+            void clear() final {
+                check_writable();
+                std::fill(data(), data() + m_header.num_ids, osmium::index::empty_value<osmium::Location>());
+                m_bbox = osmium::Box{};
+            }
+
+            /**
+             * Write header and all changes to disk. The file stays marked
+             * as dirty until close() is called.
+             */
+            void flush() {
+                if (m_mode != mode::read_only && m_mapping) {
+                    write_header();
+                    sync_to_disk();
+                }
+            }
+
+            /**
+             * Write all changes to disk, mark file as cleanly closed, and
+             * close it. The object can not be used any more after this.
+             */
+            void close() {
+                if (m_fd < 0) {
+                    return;
+                }
+                if (m_mode != mode::read_only) {
+                    m_header.flags &= ~static_cast<uint32_t>(flag_dirty);
+                    flush();
+                }
+                m_mapping.unmap();
+                const int fd = m_fd;
+                m_fd = -1;
+                if (::close(fd) != 0) {
+                    throw std::system_error{errno, std::system_category(), "Close failed"};
+                }
+            }
+
+        }; // class LocationCache
+
+        /**
+         * Handler to update a LocationCache from a change file. Nodes
+         * that are visible are set in the cache, deleted nodes are
+         * removed. Nodes with negative IDs are ignored.
+         *
+         * The changes must be applied in order of versions, which is how
+         * they are stored in change files. After all changes are applied,
+         * call LocationCache::set_replication_state().
+         */
+        class LocationCacheUpdater : public osmium::handler::Handler {
+
+            LocationCache* m_cache;
+
+        public:
+
+            explicit LocationCacheUpdater(LocationCache& cache) noexcept :
+                m_cache(&cache) {
+            }
+
+            void node(const osmium::Node& node) {
+                if (node.id() <= 0) {
+                    return;
+                }
+                if (node.visible()) {
+                    m_cache->set(node.positive_id(), node.location());
+                } else {
+                    m_cache->remove(node.positive_id());
+                }
+            }
+
+        }; // class LocationCacheUpdater
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_LOCATION_CACHE_HPP
@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/prefetch.hpp>
+#include <osmium/index/map_stats.hpp>
 #include <osmium/util/string.hpp>
 
 #include <algorithm>
@@ -40,6 +42,7 @@ DEALINGS IN THE SOFTWARE.
 #include <functional>
 #include <map>
 #include <memory>
+#include <ostream>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
@@ -93,16 +96,27 @@ namespace osmium {
              *                Copied by value, so should be "small" type.
              */
             template <typename TId, typename TValue>
-            class Map {
+            class Map : public osmium::index::detail::stats_source {
 
                 static_assert(std::is_integral<TId>::value && std::is_unsigned<TId>::value,
                               "TId template parameter for class Map must be unsigned integral type");
 
+                osmium::index::detail::lookup_counter m_lookup_counter;
+
             protected:
 
                 Map(Map&&) noexcept = default;
                 Map& operator=(Map&&) noexcept = default;
 
+                /**
+                 * Count a lookup for the statistics. Implementations call
+                 * this from get() and get_noexcept(). Does nothing unless
+                 * compiled with OSMIUM_WITH_INDEX_STATS defined.
+                 */
+                void count_lookup(const bool found) const noexcept {
+                    m_lookup_counter.count(found);
+                }
+
             public:
 
                 /// The "key" type, usually osmium::unsigned_object_id_type.
@@ -145,6 +159,36 @@ namespace osmium {
                  */
                 virtual TValue get_noexcept(const TId id) const noexcept = 0;
 
+                /**
+                 * Retrieve values for many ids at once. This is the same as
+                 * calling get_noexcept() for each id, but maps can implement
+                 * it more efficiently, for instance by prefetching memory
+                 * for later ids while looking up earlier ones.
+                 *
+                 * @param ids Pointer to the first of the ids to look for.
+                 * @param count The number of ids.
+                 * @param values Pointer to space for count values. Filled
+                 *               with the values found or the empty value.
+                 */
+                virtual void get_many(const TId* ids, const std::size_t count, TValue* values) const noexcept {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        values[i] = get_noexcept(ids[i]);
+                    }
+                }
+
+                /**
+                 * Hint that the values for these ids will be looked up
+                 * soon. File based maps use this to have the operating
+                 * system read the data in the background. This doesn't
+                 * change the map and it is fine to never call it. The
+                 * default implementation does nothing.
+                 *
+                 * @param ids Pointer to the first of the ids.
+                 * @param count The number of ids.
+                 */
+                virtual void prefetch(const TId* /*ids*/, const std::size_t /*count*/) const {
+                }
+
                 /**
                  * Get the approximate number of items in the storage. The storage
                  * might allocate memory in blocks, so this size might not be
@@ -190,6 +234,21 @@ namespace osmium {
                     throw std::runtime_error{"can't dump as array"};
                 }
 
+                /**
+                 * Get statistics about this map. Implementations add
+                 * details such as the fill ratio of dense storage or the
+                 * number of blocks allocated where they are available.
+                 * This might have to look at all the data, so it is not
+                 * meant to be called often.
+                 */
+                map_stats statistics() const override {
+                    map_stats result;
+                    result.size = size();
+                    result.used_memory = used_memory();
+                    m_lookup_counter.add_to(result);
+                    return result;
+                }
+
             }; // class Map
 
         } // namespace map
@@ -254,12 +313,23 @@ namespace osmium {
 
                 const auto it = m_callbacks.find(config[0]);
                 if (it != m_callbacks.end()) {
-                    return std::unique_ptr<map_type>((it->second)(config));
+                    std::unique_ptr<map_type> map{(it->second)(config)};
+                    osmium::index::detail::map_stats_registry::instance().set_name(map.get(), config_string);
+                    return map;
                 }
 
                 throw map_factory_error{std::string{"Support for map type '"} + config[0] + "' not compiled into this binary"};
             }
 
+            /**
+             * Write statistics for all live maps to the stream. See
+             * osmium::index::dump_map_stats().
+             */
+            template <typename TChar, typename TTraits>
+            void dump_stats(std::basic_ostream<TChar, TTraits>& out) const {
+                osmium::index::dump_map_stats(out);
+            }
+
         }; // class MapFactory
 
         namespace map {
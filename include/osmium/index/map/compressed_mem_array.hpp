@@ -0,0 +1,486 @@
+#ifndef OSMIUM_INDEX_MAP_COMPRESSED_MEM_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_COMPRESSED_MEM_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_COMPRESSED_MEM_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            namespace detail {
+
+                inline uint64_t zigzag_encode(const int64_t value) noexcept {
+                    return (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(value >> 63); // NOLINT(hicpp-signed-bitwise)
+                }
+
+                inline int64_t zigzag_decode(const uint64_t value) noexcept {
+                    return static_cast<int64_t>(value >> 1U) ^ -static_cast<int64_t>(value & 1U); // NOLINT(hicpp-signed-bitwise)
+                }
+
+                inline unsigned int bits_needed(uint64_t value) noexcept {
+                    unsigned int bits = 0;
+                    while (value) {
+                        ++bits;
+                        value >>= 1U;
+                    }
+                    return bits;
+                }
+
+                /**
+                 * Appends values with a given number of bits (at most 57)
+                 * to a byte array, least significant bits first.
+                 */
+                class bit_writer {
+
+                    unsigned char* m_data;
+                    uint64_t m_bits = 0;
+                    unsigned int m_count = 0;
+
+                public:
+
+                    explicit bit_writer(unsigned char* data) noexcept :
+                        m_data(data) {
+                    }
+
+                    void write(const uint64_t value, const unsigned int bits) noexcept {
+                        if (bits == 0) {
+                            return;
+                        }
+                        m_bits |= value << m_count;
+                        m_count += bits;
+                        while (m_count >= 8) {
+                            *m_data++ = static_cast<unsigned char>(m_bits);
+                            m_bits >>= 8U;
+                            m_count -= 8;
+                        }
+                    }
+
+                    unsigned char* flush() noexcept {
+                        if (m_count > 0) {
+                            *m_data++ = static_cast<unsigned char>(m_bits);
+                            m_bits = 0;
+                            m_count = 0;
+                        }
+                        return m_data;
+                    }
+
+                }; // class bit_writer
+
+                class bit_reader {
+
+                    const unsigned char* m_data;
+                    uint64_t m_bits = 0;
+                    unsigned int m_count = 0;
+
+                public:
+
+                    explicit bit_reader(const unsigned char* data) noexcept :
+                        m_data(data) {
+                    }
+
+                    uint64_t read(const unsigned int bits) noexcept {
+                        if (bits == 0) {
+                            return 0;
+                        }
+                        while (m_count < bits) {
+                            m_bits |= static_cast<uint64_t>(*m_data++) << m_count;
+                            m_count += 8;
+                        }
+                        const uint64_t value = m_bits & ((uint64_t{1} << bits) - 1);
+                        m_bits >>= bits;
+                        m_count -= bits;
+                        return value;
+                    }
+
+                }; // class bit_reader
+
+            } // namespace detail
+
+            /**
+             * Dense map for node locations which stores the locations in
+             * compressed blocks in memory. It needs about half the memory
+             * of DenseMemArray for typical OSM data.
+             *
+             * Locations of nodes with consecutive IDs are usually close to
+             * each other. The IDs are grouped into blocks of 256, and in
+             * each block only the first location is stored in full, all
+             * others as differences to the previous location, bit-packed
+             * with the smallest number of bits needed for all of them.
+             *
+             * Locations are best set in order of IDs, as is the case when
+             * reading an OSM file. Each block is compressed when a location
+             * for an ID in a different block is set. Setting a location in
+             * a block that was already compressed works, but is slow and
+             * wastes the memory used by the old version of the block.
+             *
+             * For get() the block is decompressed and kept in a thread-local
+             * cache, so looking up locations of nearby nodes, as is common
+             * when adding locations to ways, is fast. get() and
+             * get_noexcept() can be called from several threads at the same
+             * time, but not while set() is called.
+             *
+             * @tparam TValue Must be osmium::Location.
+             */
+            template <typename TId, typename TValue>
+            class CompressedMemArray : public Map<TId, TValue> {
+
+                static_assert(std::is_same<TValue, osmium::Location>::value, "CompressedMemArray can only store osmium::Location");
+
+                enum : std::size_t {
+                    block_bits = 8U,
+                    block_size = 1U << block_bits,
+                    block_mask = block_size - 1,
+                    chunk_size = 16UL * 1024UL * 1024UL,
+                    // flags + count + bitmap + first location + bit widths + deltas
+                    max_compressed_size = 1 + 2 + block_size / 8 + 8 + 2 + (block_size - 1) * 2 * 33 / 8 + 1
+                };
+
+                enum : uint64_t {
+                    no_block = std::numeric_limits<uint64_t>::max()
+                };
+
+                enum : unsigned char {
+                    flag_full = 0x01U
+                };
+
+                using block_type = std::array<TValue, block_size>;
+
+                struct block_cache {
+                    uint64_t serial = 0;
+                    uint64_t generation = 0;
+                    uint64_t block = no_block;
+                    block_type values;
+                };
+
+                // Position of each compressed block in the chunks.
+                std::vector<uint64_t> m_offsets;
+
+                std::vector<std::unique_ptr<unsigned char[]>> m_chunks;
+                std::size_t m_chunk_used = chunk_size;
+                std::size_t m_compressed_bytes = 0;
+
+                // The block locations are currently set in.
+                block_type m_open;
+                uint64_t m_open_block = no_block;
+
+                std::size_t m_size = 0;
+
+                // Identify the data for the thread-local block caches.
+                uint64_t m_serial;
+                uint64_t m_generation = 0;
+
+                static uint64_t next_serial() noexcept {
+                    static std::atomic<uint64_t> serial{0};
+                    return ++serial;
+                }
+
+                static void empty_block(block_type& values) noexcept {
+                    values.fill(osmium::index::empty_value<TValue>());
+                }
+
+                const unsigned char* block_data(const uint64_t offset) const noexcept {
+                    return m_chunks[offset / chunk_size].get() + offset % chunk_size;
+                }
+
+                static std::size_t compress(const block_type& values, unsigned char* out) noexcept {
+                    unsigned char* const start = out;
+
+                    std::array<unsigned char, block_size / 8> bitmap{};
+                    std::size_t count = 0;
+                    for (std::size_t i = 0; i < block_size; ++i) {
+                        if (values[i].is_defined()) {
+                            bitmap[i / 8] |= static_cast<unsigned char>(1U << (i % 8));
+                            ++count;
+                        }
+                    }
+
+                    *out++ = count == block_size ? flag_full : 0;
+                    if (count != block_size) {
+                        std::memcpy(out, bitmap.data(), bitmap.size());
+                        out += bitmap.size();
+                    }
+
+                    unsigned int bits_x = 0;
+                    unsigned int bits_y = 0;
+                    const TValue* prev = nullptr;
+                    for (const auto& value : values) {
+                        if (!value.is_defined()) {
+                            continue;
+                        }
+                        if (prev) {
+                            bits_x = std::max(bits_x, detail::bits_needed(detail::zigzag_encode(int64_t{value.x()} - prev->x())));
+                            bits_y = std::max(bits_y, detail::bits_needed(detail::zigzag_encode(int64_t{value.y()} - prev->y())));
+                        }
+                        prev = &value;
+                    }
+
+                    *out++ = static_cast<unsigned char>(bits_x);
+                    *out++ = static_cast<unsigned char>(bits_y);
+
+                    detail::bit_writer writer{out};
+                    prev = nullptr;
+                    for (const auto& value : values) {
+                        if (!value.is_defined()) {
+                            continue;
+                        }
+                        if (prev) {
+                            writer.write(detail::zigzag_encode(int64_t{value.x()} - prev->x()), bits_x);
+                            writer.write(detail::zigzag_encode(int64_t{value.y()} - prev->y()), bits_y);
+                        } else {
+                            writer.write(static_cast<uint32_t>(value.x()), 32);
+                            writer.write(static_cast<uint32_t>(value.y()), 32);
+                        }
+                        prev = &value;
+                    }
+                    out = writer.flush();
+
+                    return static_cast<std::size_t>(out - start);
+                }
+
+                static void decompress(const unsigned char* data, block_type& values) noexcept {
+                    const bool full = (*data++ & flag_full) != 0;
+                    const unsigned char* bitmap = data;
+                    if (!full) {
+                        data += block_size / 8;
+                    }
+
+                    const unsigned int bits_x = *data++;
+                    const unsigned int bits_y = *data++;
+
+                    detail::bit_reader reader{data};
+                    bool first = true;
+                    int64_t x = 0;
+                    int64_t y = 0;
+                    for (std::size_t i = 0; i < block_size; ++i) {
+                        if (!full && (bitmap[i / 8] & (1U << (i % 8))) == 0) {
+                            values[i] = osmium::index::empty_value<TValue>();
+                            continue;
+                        }
+                        if (first) {
+                            x = static_cast<int32_t>(static_cast<uint32_t>(reader.read(32)));
+                            y = static_cast<int32_t>(static_cast<uint32_t>(reader.read(32)));
+                            first = false;
+                        } else {
+                            x += detail::zigzag_decode(reader.read(bits_x));
+                            y += detail::zigzag_decode(reader.read(bits_y));
+                        }
+                        values[i] = TValue{static_cast<int32_t>(x), static_cast<int32_t>(y)};
+                    }
+                }
+
+                void flush_open_block() {
+                    if (m_open_block == no_block) {
+                        return;
+                    }
+
+                    if (m_open_block >= m_offsets.size()) {
+                        m_offsets.resize(m_open_block + 1, no_block);
+                    }
+
+                    if (std::none_of(m_open.cbegin(), m_open.cend(), [](const TValue& value) {
+                        return value.is_defined();
+                    })) {
+                        m_offsets[m_open_block] = no_block;
+                    } else {
+                        if (m_chunk_used + max_compressed_size > chunk_size) {
+                            m_chunks.emplace_back(new unsigned char[chunk_size]);
+                            m_chunk_used = 0;
+                        }
+                        const std::size_t length = compress(m_open, m_chunks.back().get() + m_chunk_used);
+                        m_offsets[m_open_block] = (m_chunks.size() - 1) * chunk_size + m_chunk_used;
+                        m_chunk_used += length;
+                        m_compressed_bytes += length;
+                    }
+
+                    m_open_block = no_block;
+                    ++m_generation;
+                }
+
+                void load_block(const uint64_t block, block_type& values) const noexcept {
+                    if (block < m_offsets.size() && m_offsets[block] != no_block) {
+                        decompress(block_data(m_offsets[block]), values);
+                    } else {
+                        empty_block(values);
+                    }
+                }
+
+                TValue lookup(const TId id) const noexcept {
+                    if (id >= m_size) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+
+                    const uint64_t block = static_cast<uint64_t>(id) >> block_bits;
+                    if (block == m_open_block) {
+                        return m_open[id & block_mask];
+                    }
+
+                    static thread_local block_cache cache;
+                    if (cache.block != block || cache.serial != m_serial || cache.generation != m_generation) {
+                        load_block(block, cache.values);
+                        cache.serial = m_serial;
+                        cache.generation = m_generation;
+                        cache.block = block;
+                    }
+                    return cache.values[id & block_mask];
+                }
+
+            public:
+
+                CompressedMemArray() :
+                    m_serial(next_serial()) {
+                }
+
+                CompressedMemArray(const CompressedMemArray&) = delete;
+                CompressedMemArray& operator=(const CompressedMemArray&) = delete;
+
+                CompressedMemArray(CompressedMemArray&&) = delete;
+                CompressedMemArray& operator=(CompressedMemArray&&) = delete;
+
+                ~CompressedMemArray() noexcept final = default;
+
+                void set(const TId id, const TValue value) final {
+                    const uint64_t block = static_cast<uint64_t>(id) >> block_bits;
+                    if (block != m_open_block) {
+                        flush_open_block();
+                        load_block(block, m_open);
+                        m_open_block = block;
+                    }
+                    m_open[id & block_mask] = value;
+                    if (id >= m_size) {
+                        m_size = static_cast<std::size_t>(id) + 1;
+                    }
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (!value.is_defined()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const TValue value = lookup(id);
+                    this->count_lookup(value.is_defined());
+                    return value;
+                }
+
+                /**
+                 * One more than the largest ID set so far.
+                 */
+                std::size_t size() const final {
+                    return m_size;
+                }
+
+                std::size_t used_memory() const final {
+                    return m_offsets.capacity() * sizeof(uint64_t) +
+                           m_chunks.size() * chunk_size +
+                           sizeof(block_type);
+                }
+
+                /**
+                 * The number of bytes used by the compressed blocks,
+                 * including old versions of blocks that were changed.
+                 */
+                std::size_t compressed_bytes() const noexcept {
+                    return m_compressed_bytes;
+                }
+
+                void clear() final {
+                    m_offsets.clear();
+                    m_offsets.shrink_to_fit();
+                    m_chunks.clear();
+                    m_chunk_used = chunk_size;
+                    m_compressed_bytes = 0;
+                    m_open_block = no_block;
+                    m_size = 0;
+                    m_serial = next_serial();
+                }
+
+                /**
+                 * Compress the block currently being written to. Call this
+                 * after all locations are set.
+                 */
+                void sort() final {
+                    flush_open_block();
+                }
+
+                map_stats statistics() const final {
+                    map_stats result{Map<TId, TValue>::statistics()};
+                    result.blocks = m_offsets.size();
+                    return result;
+                }
+
+                void dump_as_array(const int fd) final {
+                    flush_open_block();
+                    block_type values;
+                    for (std::size_t start = 0; start < m_size; start += block_size) {
+                        load_block(start >> block_bits, values);
+                        const std::size_t count = std::min(static_cast<std::size_t>(block_size), m_size - start);
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(values.data()), count * sizeof(TValue));
+                    }
+                }
+
+            }; // class CompressedMemArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedMemArray, compressed_mem_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_COMPRESSED_MEM_ARRAY_HPP
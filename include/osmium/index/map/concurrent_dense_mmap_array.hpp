@@ -0,0 +1,277 @@
+#ifndef OSMIUM_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef _WIN32
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+
+#define OSMIUM_HAS_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Dense map which many threads can set() values in at the same
+             * time without any locks. This is useful for storing node
+             * locations when the input is decoded in parallel, for instance
+             * with one NodeLocationsForWays handler per thread all using
+             * the same index.
+             *
+             * The memory for the largest possible ID is reserved (but not
+             * allocated) in the constructor, so the map never has to grow
+             * and move its data. Each value is stored with one atomic 64bit
+             * store. The operating system only allocates the memory for
+             * pages actually written to. Values are stored XOR'ed with the
+             * empty value, so these zero-filled pages read as empty.
+             *
+             * set(), get(), get_noexcept(), and size() can be called from
+             * any number of threads at the same time. clear() and the dump
+             * functions must not be called while other threads use the map.
+             *
+             * @tparam TValue Must be a trivially copyable type of 8 bytes,
+             *                such as osmium::Location.
+             */
+            template <typename TId, typename TValue>
+            class ConcurrentDenseMmapArray : public Map<TId, TValue> {
+
+                static_assert(sizeof(TValue) == sizeof(uint64_t), "TValue must have 8 bytes");
+                static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "std::atomic<uint64_t> must have 8 bytes");
+
+                std::size_t m_max_ids;
+                std::atomic<uint64_t>* m_data = nullptr;
+                std::atomic<std::size_t> m_size{0};
+
+                static uint64_t empty_bits() noexcept {
+                    const TValue empty = osmium::index::empty_value<TValue>();
+                    uint64_t bits = 0;
+                    std::memcpy(&bits, &empty, sizeof(bits));
+                    return bits;
+                }
+
+                static uint64_t encode(const TValue value) noexcept {
+                    uint64_t bits = 0;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    return bits ^ empty_bits();
+                }
+
+                static TValue decode(const uint64_t bits) noexcept {
+                    const uint64_t value_bits = bits ^ empty_bits();
+                    TValue value;
+                    std::memcpy(static_cast<void*>(&value), &value_bits, sizeof(value_bits));
+                    return value;
+                }
+
+                std::size_t mapped_bytes() const noexcept {
+                    return m_max_ids * sizeof(uint64_t);
+                }
+
+                void map_memory() {
+                    int flags = MAP_PRIVATE | MAP_ANONYMOUS; // NOLINT(hicpp-signed-bitwise)
+#ifdef MAP_NORESERVE
+                    flags |= MAP_NORESERVE; // NOLINT(hicpp-signed-bitwise)
+#endif
+                    void* addr = ::mmap(nullptr, mapped_bytes(), PROT_READ | PROT_WRITE, flags, -1, 0); // NOLINT(hicpp-signed-bitwise)
+                    if (addr == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                        throw std::system_error{errno, std::system_category(), "mmap failed"};
+                    }
+                    m_data = static_cast<std::atomic<uint64_t>*>(addr);
+                }
+
+                void unmap_memory() noexcept {
+                    if (m_data) {
+                        ::munmap(m_data, mapped_bytes());
+                        m_data = nullptr;
+                    }
+                }
+
+            public:
+
+                enum : std::size_t {
+                    /// Enough for the IDs in OSM planet files for some time.
+                    default_max_ids = 1ULL << 34U
+                };
+
+                /**
+                 * Create map.
+                 *
+                 * @param max_ids The number of IDs the map can hold, ie.
+                 *                all IDs must be smaller than this. The
+                 *                memory for this many values is reserved
+                 *                in the virtual address space.
+                 * @throws std::system_error if the memory can't be mapped.
+                 */
+                explicit ConcurrentDenseMmapArray(std::size_t max_ids = default_max_ids) :
+                    m_max_ids(max_ids) {
+                    map_memory();
+                }
+
+                ConcurrentDenseMmapArray(const ConcurrentDenseMmapArray&) = delete;
+                ConcurrentDenseMmapArray& operator=(const ConcurrentDenseMmapArray&) = delete;
+
+                ConcurrentDenseMmapArray(ConcurrentDenseMmapArray&&) = delete;
+                ConcurrentDenseMmapArray& operator=(ConcurrentDenseMmapArray&&) = delete;
+
+                ~ConcurrentDenseMmapArray() noexcept final {
+                    unmap_memory();
+                }
+
+                /// The number of IDs this map can hold.
+                std::size_t max_ids() const noexcept {
+                    return m_max_ids;
+                }
+
+                /**
+                 * Set the value for an ID. Can be called from several
+                 * threads at the same time.
+                 *
+                 * @throws std::out_of_range if the ID is not smaller than
+                 *         max_ids().
+                 */
+                void set(const TId id, const TValue value) final {
+                    if (id >= m_max_ids) {
+                        throw std::out_of_range{"ID too large for ConcurrentDenseMmapArray"};
+                    }
+                    m_data[id].store(encode(value), std::memory_order_relaxed);
+                    std::size_t size = m_size.load(std::memory_order_relaxed);
+                    while (id >= size && !m_size.compare_exchange_weak(size, static_cast<std::size_t>(id) + 1, std::memory_order_relaxed)) {
+                    }
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (id >= m_size.load(std::memory_order_relaxed)) {
+                        this->count_lookup(false);
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    const TValue value = decode(m_data[id].load(std::memory_order_relaxed));
+                    this->count_lookup(value != osmium::index::empty_value<TValue>());
+                    return value;
+                }
+
+                void get_many(const TId* ids, const std::size_t count, TValue* values) const noexcept final {
+                    const std::size_t size = m_size.load(std::memory_order_relaxed);
+                    for (std::size_t i = 0; i < count && i < osmium::index::detail::prefetch_distance; ++i) {
+                        if (ids[i] < size) {
+                            osmium::index::detail::prefetch(m_data + ids[i]);
+                        }
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const std::size_t ahead = i + osmium::index::detail::prefetch_distance;
+                        if (ahead < count && ids[ahead] < size) {
+                            osmium::index::detail::prefetch(m_data + ids[ahead]);
+                        }
+                        values[i] = ids[i] < size ? decode(m_data[ids[i]].load(std::memory_order_relaxed)) : osmium::index::empty_value<TValue>();
+                        this->count_lookup(values[i] != osmium::index::empty_value<TValue>());
+                    }
+                }
+
+                /**
+                 * One more than the largest ID set so far.
+                 */
+                std::size_t size() const final {
+                    return m_size.load(std::memory_order_relaxed);
+                }
+
+                /**
+                 * The memory used at most. This assumes all memory up to
+                 * the largest ID set was actually written to.
+                 */
+                std::size_t used_memory() const final {
+                    return size() * sizeof(uint64_t);
+                }
+
+                /**
+                 * Give all memory back to the operating system. The map is
+                 * empty after this and can be used again.
+                 */
+                void clear() final {
+                    unmap_memory();
+                    m_size = 0;
+                    map_memory();
+                }
+
+                void dump_as_array(const int fd) final {
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / sizeof(TValue);
+                    std::unique_ptr<TValue[]> output_buffer{new TValue[buffer_size]};
+
+                    const std::size_t num = size();
+                    for (std::size_t start = 0; start < num; start += buffer_size) {
+                        const std::size_t count = std::min(buffer_size, num - start);
+                        for (std::size_t i = 0; i < count; ++i) {
+                            output_buffer[i] = decode(m_data[start + i].load(std::memory_order_relaxed));
+                        }
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), count * sizeof(TValue));
+                    }
+                }
+
+            }; // class ConcurrentDenseMmapArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::ConcurrentDenseMmapArray, concurrent_dense_mmap_array)
+#endif
+
+#endif // _WIN32
+
+#endif // OSMIUM_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY_HPP
@@ -0,0 +1,241 @@
+#ifndef OSMIUM_INDEX_MAP_CONCURRENT_SPARSE_MEM_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_CONCURRENT_SPARSE_MEM_ARRAY_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_CONCURRENT_SPARSE_MEM_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            namespace detail {
+
+                inline uint64_t next_concurrent_map_serial() noexcept {
+                    static std::atomic<uint64_t> serial{0};
+                    return ++serial;
+                }
+
+            } // namespace detail
+
+            /**
+             * Sparse map which many threads can set() values in at the same
+             * time. Each thread appends to its own buffer, so no locks are
+             * needed except the first time a thread uses the map. The
+             * buffers are merged into one sorted array when sort() is
+             * called.
+             *
+             * set() can be called from any number of threads at the same
+             * time. All other functions must only be called when no other
+             * thread uses the map. sort() must be called after the last
+             * set() and before the first get().
+             */
+            template <typename TId, typename TValue>
+            class ConcurrentSparseMemArray : public Map<TId, TValue> {
+
+                using element_type = std::pair<TId, TValue>;
+                using buffer_type = std::vector<element_type>;
+
+                struct thread_cache {
+                    uint64_t serial = 0;
+                    buffer_type* buffer = nullptr;
+                };
+
+                std::vector<element_type> m_vector;
+
+                std::mutex m_mutex;
+                std::vector<std::unique_ptr<buffer_type>> m_buffers;
+                std::unordered_map<std::thread::id, buffer_type*> m_buffer_by_thread;
+
+                // Unique for each map object (and each clear()), so the
+                // thread local cache never refers to a buffer of another
+                // (possibly destroyed) map.
+                uint64_t m_serial = detail::next_concurrent_map_serial();
+
+                buffer_type& thread_buffer() {
+                    static thread_local thread_cache cache;
+
+                    const auto serial = m_serial;
+                    if (cache.serial != serial) {
+                        const std::lock_guard<std::mutex> lock{m_mutex};
+                        auto& buffer = m_buffer_by_thread[std::this_thread::get_id()];
+                        if (!buffer) {
+                            m_buffers.emplace_back(new buffer_type{});
+                            buffer = m_buffers.back().get();
+                        }
+                        cache.serial = serial;
+                        cache.buffer = buffer;
+                    }
+
+                    return *cache.buffer;
+                }
+
+                std::size_t buffered() const noexcept {
+                    std::size_t count = 0;
+                    for (const auto& buffer : m_buffers) {
+                        count += buffer->size();
+                    }
+                    return count;
+                }
+
+                typename std::vector<element_type>::const_iterator find(const TId id) const {
+                    const element_type element{id, osmium::index::empty_value<TValue>()};
+                    const auto it = std::lower_bound(m_vector.cbegin(), m_vector.cend(), element, [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+                    if (it == m_vector.cend() || it->first != id) {
+                        return m_vector.cend();
+                    }
+                    return it;
+                }
+
+            public:
+
+                ConcurrentSparseMemArray() = default;
+
+                ConcurrentSparseMemArray(const ConcurrentSparseMemArray&) = delete;
+                ConcurrentSparseMemArray& operator=(const ConcurrentSparseMemArray&) = delete;
+
+                ConcurrentSparseMemArray(ConcurrentSparseMemArray&&) = delete;
+                ConcurrentSparseMemArray& operator=(ConcurrentSparseMemArray&&) = delete;
+
+                ~ConcurrentSparseMemArray() noexcept final = default;
+
+                /**
+                 * Set the value for an ID. Can be called from several
+                 * threads at the same time. The value is not visible to
+                 * get() before sort() is called.
+                 */
+                void set(const TId id, const TValue value) final {
+                    thread_buffer().emplace_back(id, value);
+                }
+
+                TValue get(const TId id) const final {
+                    const auto it = find(id);
+                    if (it == m_vector.cend()) {
+                        this->count_lookup(false);
+                        throw osmium::not_found{id};
+                    }
+                    this->count_lookup(true);
+                    return it->second;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const auto it = find(id);
+                    if (it == m_vector.cend()) {
+                        this->count_lookup(false);
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    this->count_lookup(true);
+                    return it->second;
+                }
+
+                /**
+                 * The number of entries in the map, including those set()
+                 * but not yet sorted.
+                 */
+                std::size_t size() const final {
+                    return m_vector.size() + buffered();
+                }
+
+                std::size_t used_memory() const final {
+                    std::size_t memory = m_vector.capacity() * sizeof(element_type);
+                    for (const auto& buffer : m_buffers) {
+                        memory += buffer->capacity() * sizeof(element_type);
+                    }
+                    return memory;
+                }
+
+                void clear() final {
+                    m_vector.clear();
+                    m_vector.shrink_to_fit();
+                    m_buffer_by_thread.clear();
+                    m_buffers.clear();
+                    m_serial = detail::next_concurrent_map_serial();
+                }
+
+                /**
+                 * Merge the buffers of all threads into the sorted array.
+                 * Must not be called while other threads call set().
+                 */
+                void sort() final {
+                    m_vector.reserve(m_vector.size() + buffered());
+                    for (auto& buffer : m_buffers) {
+                        m_vector.insert(m_vector.end(), buffer->cbegin(), buffer->cend());
+                        buffer_type{}.swap(*buffer);
+                    }
+                    std::sort(m_vector.begin(), m_vector.end(), [](const element_type& a, const element_type& b) {
+                        return a.first < b.first;
+                    });
+                }
+
+                void dump_as_list(const int fd) final {
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(m_vector.data()), sizeof(element_type) * m_vector.size());
+                }
+
+                map_stats statistics() const final {
+                    map_stats result{Map<TId, TValue>::statistics()};
+                    result.sorted = buffered() == 0;
+                    return result;
+                }
+
+            }; // class ConcurrentSparseMemArray
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::ConcurrentSparseMemArray, concurrent_sparse_mem_array)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_CONCURRENT_SPARSE_MEM_ARRAY_HPP
@@ -61,10 +61,12 @@ namespace osmium {
                 }
 
                 TValue get(const TId id) const final {
+                    this->count_lookup(false);
                     throw osmium::not_found{id};
                 }
 
                 TValue get_noexcept(const TId /*id*/) const noexcept final {
+                    this->count_lookup(false);
                     return osmium::index::empty_value<TValue>();
                 }
 
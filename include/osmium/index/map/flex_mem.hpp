@@ -33,12 +33,15 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/index/index.hpp>
 #include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
 
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -85,11 +88,18 @@ namespace osmium {
                     density_factor = 3
                 };
 
+                // Dense blocks are allocated in slabs of this many blocks.
+                enum : std::size_t {
+                    blocks_per_slab = 16
+                };
+
                 // An entry in the sparse index
                 struct entry {
                     uint64_t id;
                     TValue value;
 
+                    entry() = default;
+
                     entry(uint64_t i, TValue v) :
                         id(i),
                         value(std::move(v)) {
@@ -102,7 +112,15 @@ namespace osmium {
 
                 std::vector<entry> m_sparse_entries;
 
-                std::vector<std::vector<TValue>> m_dense_blocks;
+                // Pointers to the dense blocks, nullptr for blocks not
+                // used (yet).
+                std::vector<TValue*> m_dense_blocks;
+
+                // The memory for the dense blocks.
+                std::vector<std::unique_ptr<TValue[]>> m_slabs;
+
+                // Number of blocks not handed out yet from last slab.
+                std::size_t m_slab_free = 0;
 
                 // The maximum Id that was seen yet. Only set in sparse mode.
                 uint64_t m_max_id = 0;
@@ -118,15 +136,27 @@ namespace osmium {
                     return id & (block_size - 1);
                 }
 
+                TValue* allocate_block() {
+                    if (m_slab_free == 0) {
+                        m_slabs.emplace_back(new TValue[blocks_per_slab * block_size]);
+                        m_slab_free = blocks_per_slab;
+                    }
+                    TValue* block = m_slabs.back().get() + (blocks_per_slab - m_slab_free) * block_size;
+                    --m_slab_free;
+                    std::fill_n(block, block_size, osmium::index::empty_value<TValue>());
+                    return block;
+                }
+
                 // Assure that the block with the given number exists. Create
                 // it if needed.
-                void assure_block(const uint64_t num) {
+                TValue* assure_block(const uint64_t num) {
                     if (num >= m_dense_blocks.size()) {
-                        m_dense_blocks.resize(num + 1);
+                        m_dense_blocks.resize(num + 1, nullptr);
                     }
-                    if (m_dense_blocks[num].empty()) {
-                        m_dense_blocks[num].assign(block_size, osmium::index::empty_value<TValue>());
+                    if (!m_dense_blocks[num]) {
+                        m_dense_blocks[num] = allocate_block();
                     }
+                    return m_dense_blocks[num];
                 }
 
                 void set_sparse(const uint64_t id, const TValue value) {
@@ -153,12 +183,11 @@ namespace osmium {
                 }
 
                 void set_dense(const uint64_t id, const TValue value) {
-                    assure_block(block(id));
-                    m_dense_blocks[block(id)][offset(id)] = value;
+                    assure_block(block(id))[offset(id)] = value;
                 }
 
                 TValue get_dense(const uint64_t id) const noexcept {
-                    if (m_dense_blocks.size() <= block(id) || m_dense_blocks[block(id)].empty()) {
+                    if (m_dense_blocks.size() <= block(id) || !m_dense_blocks[block(id)]) {
                         return osmium::index::empty_value<TValue>();
                     }
                     return m_dense_blocks[block(id)][offset(id)];
@@ -193,7 +222,8 @@ namespace osmium {
                 std::size_t used_memory() const noexcept final {
                     return sizeof(FlexMem) +
                            m_sparse_entries.size() * sizeof(entry) +
-                           m_dense_blocks.size() * (block_size * sizeof(TValue) + sizeof(std::vector<TValue>));
+                           m_dense_blocks.size() * sizeof(TValue*) +
+                           m_slabs.size() * blocks_per_slab * block_size * sizeof(TValue);
                 }
 
                 void set(const TId id, const TValue value) final {
@@ -205,10 +235,9 @@ namespace osmium {
                 }
 
                 TValue get_noexcept(const TId id) const noexcept final {
-                    if (m_dense) {
-                        return get_dense(id);
-                    }
-                    return get_sparse(id);
+                    const TValue value = m_dense ? get_dense(id) : get_sparse(id);
+                    this->count_lookup(value != osmium::index::empty_value<TValue>());
+                    return value;
                 }
 
                 TValue get(const TId id) const final {
@@ -224,12 +253,82 @@ namespace osmium {
                     m_sparse_entries.shrink_to_fit();
                     m_dense_blocks.clear();
                     m_dense_blocks.shrink_to_fit();
+                    m_slabs.clear();
+                    m_slabs.shrink_to_fit();
+                    m_slab_free = 0;
                     m_max_id = 0;
                     m_dense = false;
                 }
 
+                /**
+                 * Sort the sparse index. This uses several threads for
+                 * large indexes.
+                 */
                 void sort() final {
-                    std::sort(m_sparse_entries.begin(), m_sparse_entries.end());
+                    osmium::index::detail::radix_sort(m_sparse_entries, [](const entry& e) noexcept {
+                        return e.id;
+                    });
+                }
+
+                /**
+                 * Write all entries as (id, value) pairs ordered by id to
+                 * the file. In sparse mode this sorts the index first.
+                 */
+                void dump_as_list(const int fd) final {
+                    using element_type = std::pair<TId, TValue>;
+                    std::vector<element_type> buffer;
+                    buffer.reserve(block_size);
+
+                    const auto flush = [&]() {
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(buffer.data()), sizeof(element_type) * buffer.size());
+                        buffer.clear();
+                    };
+
+                    if (m_dense) {
+                        for (std::size_t b = 0; b < m_dense_blocks.size(); ++b) {
+                            const TValue* block = m_dense_blocks[b];
+                            if (!block) {
+                                continue;
+                            }
+                            for (std::size_t i = 0; i < block_size; ++i) {
+                                if (block[i] != osmium::index::empty_value<TValue>()) {
+                                    buffer.emplace_back(static_cast<TId>((b << bits) + i), block[i]);
+                                }
+                            }
+                            flush();
+                        }
+                        return;
+                    }
+
+                    sort();
+                    for (const auto& e : m_sparse_entries) {
+                        buffer.emplace_back(static_cast<TId>(e.id), e.value);
+                        if (buffer.size() == block_size) {
+                            flush();
+                        }
+                    }
+                    flush();
+                }
+
+                map_stats statistics() const final {
+                    map_stats result{Map<TId, TValue>::statistics()};
+                    if (m_dense) {
+                        result.blocks = static_cast<std::size_t>(std::count_if(m_dense_blocks.cbegin(), m_dense_blocks.cend(), [](const TValue* block) {
+                            return block != nullptr;
+                        }));
+                        result.capacity = result.blocks * block_size;
+                        result.size = 0;
+                        for (const TValue* block : m_dense_blocks) {
+                            if (block) {
+                                result.size += static_cast<std::size_t>(std::count_if(block, block + block_size, [](const TValue& value) {
+                                    return value != osmium::index::empty_value<TValue>();
+                                }));
+                            }
+                        }
+                    } else {
+                        result.sorted = std::is_sorted(m_sparse_entries.cbegin(), m_sparse_entries.cend());
+                    }
+                    return result;
                 }
 
                 /**
@@ -239,14 +338,51 @@ namespace osmium {
                  * efficient.
                  *
                  * Does nothing if the index is already in dense mode.
+                 *
+                 * The sparse entries are sorted first, then all needed
+                 * blocks are allocated and the entries are copied over in
+                 * several threads each working on different blocks.
                  */
                 void switch_to_dense() {
                     if (m_dense) {
                         return;
                     }
-                    for (const auto entry : m_sparse_entries) {
-                        set_dense(entry.id, entry.value);
+
+                    sort();
+
+                    const std::size_t size = m_sparse_entries.size();
+                    if (size > 0) {
+                        // Allocate blocks. Entries are sorted so we can jump
+                        // from block to block.
+                        for (auto it = m_sparse_entries.cbegin(); it != m_sparse_entries.cend();) {
+                            const uint64_t num = block(it->id);
+                            assure_block(num);
+                            it = std::lower_bound(it, m_sparse_entries.cend(), entry{(num + 1) << bits, osmium::index::empty_value<TValue>()});
+                        }
+
+                        // Split work at block boundaries, so no two threads
+                        // write to the same block.
+                        const int num_threads = osmium::index::detail::parallel_work_threads(size);
+                        std::vector<std::size_t> starts;
+                        starts.push_back(0);
+                        for (int n = 1; n < num_threads; ++n) {
+                            std::size_t start = std::max(starts.back(), size * static_cast<std::size_t>(n) / static_cast<std::size_t>(num_threads));
+                            while (start > 0 && start < size && block(m_sparse_entries[start].id) == block(m_sparse_entries[start - 1].id)) {
+                                ++start;
+                            }
+                            starts.push_back(start);
+                        }
+                        starts.push_back(size);
+
+                        osmium::index::detail::run_in_threads(num_threads, [this, &starts](const int n) noexcept {
+                            const auto end = starts[static_cast<std::size_t>(n) + 1];
+                            for (std::size_t i = starts[static_cast<std::size_t>(n)]; i < end; ++i) {
+                                const auto& e = m_sparse_entries[i];
+                                m_dense_blocks[block(e.id)][offset(e.id)] = e.value;
+                            }
+                        });
                     }
+
                     m_sparse_entries.clear();
                     m_sparse_entries.shrink_to_fit();
                     m_max_id = 0;
@@ -257,8 +393,8 @@ namespace osmium {
                     std::size_t used_blocks = 0;
                     std::size_t empty_blocks = 0;
 
-                    for (const auto& block : m_dense_blocks) {
-                        if (block.empty()) {
+                    for (const auto* block : m_dense_blocks) {
+                        if (!block) {
                             ++empty_blocks;
                         } else {
                             ++used_blocks;
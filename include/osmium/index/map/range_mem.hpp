@@ -0,0 +1,369 @@
+#ifndef OSMIUM_INDEX_MAP_RANGE_MEM_HPP
+#define OSMIUM_INDEX_MAP_RANGE_MEM_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_RANGE_MEM
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Statistics about the IDs in some data used to decide which
+             * range of IDs should be stored densely in a RangeMem index.
+             * Add all IDs (for instance in a first pass over the input),
+             * then call dense_range().
+             */
+            class RangeMemStatistics {
+
+                // Number of IDs in each block of 2^bits IDs.
+                std::vector<uint32_t> m_counts;
+
+            public:
+
+                enum {
+                    bits = 16
+                };
+
+                enum : uint64_t {
+                    block_size = 1ull << bits
+                };
+
+                // A block is worth storing densely if at least one in
+                // density_factor of its IDs are used. This is the same
+                // compromise between memory use and speed as in FlexMem.
+                enum {
+                    density_factor = 3
+                };
+
+                void add(const uint64_t id) {
+                    const auto block = static_cast<std::size_t>(id >> bits);
+                    if (block >= m_counts.size()) {
+                        m_counts.resize(block + 1);
+                    }
+                    ++m_counts[block];
+                }
+
+                /**
+                 * The range [first, last) of IDs to be stored densely. It
+                 * starts at the first and ends after the last block dense
+                 * enough to be worth it. Returns an empty range if there is
+                 * no such block.
+                 */
+                std::pair<uint64_t, uint64_t> dense_range() const noexcept {
+                    const auto is_dense = [](uint32_t count) noexcept {
+                        return static_cast<uint64_t>(count) * density_factor >= block_size;
+                    };
+                    const auto first = std::find_if(m_counts.cbegin(), m_counts.cend(), is_dense);
+                    if (first == m_counts.cend()) {
+                        return std::make_pair(0, 0);
+                    }
+                    const auto last = std::find_if(m_counts.crbegin(), m_counts.crend(), is_dense).base();
+                    return std::make_pair(static_cast<uint64_t>(first - m_counts.cbegin()) << bits,
+                                          static_cast<uint64_t>(last - m_counts.cbegin()) << bits);
+                }
+
+            }; // class RangeMemStatistics
+
+            /**
+             * Index that stores one range of IDs densely and all other IDs
+             * in a sparse array. This uses less memory and is faster than
+             * a dense index if most IDs are in one range, but some are far
+             * outside of it (old or synthetic IDs in extracts, or the
+             * negative IDs of editor data in a separate index). Blocks of
+             * the dense range are only allocated when they are used.
+             *
+             * The dense range is set in the constructor, for instance from
+             * a RangeMemStatistics object filled in a first pass. Without
+             * a range all IDs go into the sparse array, so this is also a
+             * good index for small sets of IDs like negative node IDs.
+             *
+             * Call sort() after all set() calls and before any get().
+             */
+            template <typename TId, typename TValue>
+            class RangeMem : public osmium::index::map::Map<TId, TValue> {
+
+                enum {
+                    bits = RangeMemStatistics::bits
+                };
+
+                enum : uint64_t {
+                    block_size = 1ull << bits
+                };
+
+                struct entry {
+                    uint64_t id;
+                    TValue value;
+
+                    entry() = default;
+
+                    entry(uint64_t i, TValue v) :
+                        id(i),
+                        value(std::move(v)) {
+                    }
+
+                    bool operator<(const entry other) const noexcept {
+                        return id < other.id;
+                    }
+                };
+
+                uint64_t m_first;
+                uint64_t m_last;
+
+                std::vector<std::unique_ptr<TValue[]>> m_dense_blocks;
+                std::size_t m_dense_size = 0;
+
+                std::vector<entry> m_sparse_entries;
+
+                bool in_range(const uint64_t id) const noexcept {
+                    return id >= m_first && id < m_last;
+                }
+
+                TValue get_sparse(const uint64_t id) const noexcept {
+                    const auto it = std::lower_bound(m_sparse_entries.begin(),
+                                                     m_sparse_entries.end(),
+                                                     entry{id, osmium::index::empty_value<TValue>()});
+                    if (it == m_sparse_entries.end() || it->id != id) {
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    return it->value;
+                }
+
+            public:
+
+                /**
+                 * Create RangeMem index.
+                 *
+                 * @param first First ID of the range stored densely.
+                 * @param last One past the last ID of the range stored
+                 *             densely.
+                 */
+                explicit RangeMem(const TId first = 0, const TId last = 0) :
+                    m_first(static_cast<uint64_t>(first) & ~(block_size - 1)),
+                    m_last(std::max(static_cast<uint64_t>(first), static_cast<uint64_t>(last))) {
+                    m_dense_blocks.resize(static_cast<std::size_t>((m_last - m_first + block_size - 1) >> bits));
+                }
+
+                /**
+                 * Create RangeMem index with the dense range from the
+                 * statistics.
+                 */
+                explicit RangeMem(const RangeMemStatistics& statistics) :
+                    RangeMem(static_cast<TId>(statistics.dense_range().first),
+                             static_cast<TId>(statistics.dense_range().second)) {
+                }
+
+                /// The range of IDs stored densely.
+                std::pair<TId, TId> dense_range() const noexcept {
+                    return std::make_pair(static_cast<TId>(m_first), static_cast<TId>(m_last));
+                }
+
+                std::size_t size() const noexcept final {
+                    return m_dense_size * block_size + m_sparse_entries.size();
+                }
+
+                std::size_t used_memory() const noexcept final {
+                    return sizeof(RangeMem) +
+                           m_dense_blocks.size() * sizeof(std::unique_ptr<TValue[]>) +
+                           m_dense_size * block_size * sizeof(TValue) +
+                           m_sparse_entries.size() * sizeof(entry);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    const auto uid = static_cast<uint64_t>(id);
+                    if (!in_range(uid)) {
+                        m_sparse_entries.emplace_back(uid, value);
+                        return;
+                    }
+                    auto& block = m_dense_blocks[static_cast<std::size_t>((uid - m_first) >> bits)];
+                    if (!block) {
+                        block.reset(new TValue[block_size]);
+                        std::fill_n(block.get(), block_size, osmium::index::empty_value<TValue>());
+                        ++m_dense_size;
+                    }
+                    block[(uid - m_first) & (block_size - 1)] = value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const auto uid = static_cast<uint64_t>(id);
+                    TValue value = osmium::index::empty_value<TValue>();
+                    if (in_range(uid)) {
+                        const auto& block = m_dense_blocks[static_cast<std::size_t>((uid - m_first) >> bits)];
+                        if (block) {
+                            value = block[(uid - m_first) & (block_size - 1)];
+                        }
+                    } else {
+                        value = get_sparse(uid);
+                    }
+                    this->count_lookup(value != osmium::index::empty_value<TValue>());
+                    return value;
+                }
+
+                TValue get(const TId id) const final {
+                    const auto value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                void clear() final {
+                    for (auto& block : m_dense_blocks) {
+                        block.reset();
+                    }
+                    m_dense_size = 0;
+                    m_sparse_entries.clear();
+                    m_sparse_entries.shrink_to_fit();
+                }
+
+                /**
+                 * Sort the sparse part of the index. This uses several
+                 * threads for large indexes.
+                 */
+                void sort() final {
+                    osmium::index::detail::radix_sort(m_sparse_entries, [](const entry& e) noexcept {
+                        return e.id;
+                    });
+                }
+
+                /**
+                 * Write all entries as (id, value) pairs ordered by id to
+                 * the file. This sorts the sparse part of the index first.
+                 */
+                void dump_as_list(const int fd) final {
+                    using element_type = std::pair<TId, TValue>;
+                    std::vector<element_type> buffer;
+                    buffer.reserve(block_size);
+
+                    const auto flush = [&]() {
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const char*>(buffer.data()), sizeof(element_type) * buffer.size());
+                        buffer.clear();
+                    };
+
+                    sort();
+
+                    // Sparse entries before the dense range, then the
+                    // dense range, then sparse entries after it.
+                    auto it = m_sparse_entries.cbegin();
+                    for (; it != m_sparse_entries.cend() && it->id < m_first; ++it) {
+                        buffer.emplace_back(static_cast<TId>(it->id), it->value);
+                        if (buffer.size() == block_size) {
+                            flush();
+                        }
+                    }
+                    flush();
+
+                    for (std::size_t b = 0; b < m_dense_blocks.size(); ++b) {
+                        const TValue* block = m_dense_blocks[b].get();
+                        if (!block) {
+                            continue;
+                        }
+                        for (std::size_t i = 0; i < block_size; ++i) {
+                            if (block[i] != osmium::index::empty_value<TValue>()) {
+                                buffer.emplace_back(static_cast<TId>(m_first + (b << bits) + i), block[i]);
+                            }
+                        }
+                        flush();
+                    }
+
+                    for (; it != m_sparse_entries.cend(); ++it) {
+                        buffer.emplace_back(static_cast<TId>(it->id), it->value);
+                        if (buffer.size() == block_size) {
+                            flush();
+                        }
+                    }
+                    flush();
+                }
+
+                map_stats statistics() const final {
+                    map_stats result{Map<TId, TValue>::statistics()};
+                    result.blocks = m_dense_size;
+                    result.capacity = m_dense_size * block_size;
+                    result.size = m_sparse_entries.size();
+                    for (const auto& block : m_dense_blocks) {
+                        if (block) {
+                            result.size += static_cast<std::size_t>(std::count_if(block.get(), block.get() + block_size, [](const TValue& value) {
+                                return value != osmium::index::empty_value<TValue>();
+                            }));
+                        }
+                    }
+                    result.sorted = std::is_sorted(m_sparse_entries.cbegin(), m_sparse_entries.cend());
+                    return result;
+                }
+
+            }; // class RangeMem
+
+            /**
+             * Create a RangeMem index from a config string. The dense range
+             * is given as "range_mem,FIRST,LAST". Without the range all IDs
+             * are stored in the sparse array.
+             */
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, RangeMem> {
+                RangeMem<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    if (config.size() == 3) {
+                        return new RangeMem<TId, TValue>(static_cast<TId>(std::stoull(config[1])),
+                                                         static_cast<TId>(std::stoull(config[2])));
+                    }
+                    return new RangeMem<TId, TValue>();
+                }
+            };
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::RangeMem, range_mem)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_RANGE_MEM_HPP
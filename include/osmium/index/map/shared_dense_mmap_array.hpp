@@ -0,0 +1,485 @@
+#ifndef OSMIUM_INDEX_MAP_SHARED_DENSE_MMAP_ARRAY_HPP
+#define OSMIUM_INDEX_MAP_SHARED_DENSE_MMAP_ARRAY_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#ifndef _WIN32
+
+#include <osmium/index/detail/prefetch.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/util/file.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define OSMIUM_HAS_INDEX_MAP_SHARED_DENSE_MMAP_ARRAY
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            namespace detail {
+
+                /**
+                 * Header at the beginning of the file used by the
+                 * SharedDenseMmapArray. It takes up a whole page so that the
+                 * data after it is page aligned.
+                 */
+                struct shared_dense_mmap_array_header {
+
+                    enum : uint32_t {
+                        current_version = 1
+                    };
+
+                    enum : uint32_t {
+                        state_loading = 0,
+                        state_ready   = 1
+                    };
+
+                    static const char* magic_string() noexcept {
+                        return "OSMSHDMA";
+                    }
+
+                    char magic[8];
+                    uint32_t version;
+                    uint32_t value_size;
+                    uint64_t max_ids;
+                    std::atomic<uint64_t> size;
+                    std::atomic<uint32_t> state;
+
+                }; // struct shared_dense_mmap_array_header
+
+            } // namespace detail
+
+            /**
+             * Dense map stored in a file which can be used by several
+             * processes at the same time. One loader process creates the
+             * file and fills it, any number of consumer processes then
+             * attach to it read-only. All processes share the same memory
+             * through the page cache, so the index needs the memory only
+             * once, and attaching to it is instantaneous.
+             *
+             * Put the file on a tmpfs (for instance in /dev/shm) to keep
+             * it in memory only, or on a normal file system to keep it
+             * after a reboot.
+             *
+             * The file starts with a header (see
+             * detail::shared_dense_mmap_array_header) which contains the
+             * maximum number of IDs, the size, and the state of the map.
+             * The protocol is:
+             *
+             * 1. The loader creates the map with a file name and the
+             *    maximum number of IDs. The file is created (or
+             *    truncated) and marked as "loading".
+             * 2. The loader calls set() from any number of threads at the
+             *    same time, like with the ConcurrentDenseMmapArray.
+             * 3. The loader calls mark_ready().
+             * 4. Consumers create the map with only the file name. This
+             *    fails if the file is not marked as ready. Consumers can
+             *    not change the map.
+             *
+             * The file is a sparse file, only pages actually written to
+             * use memory or disk space. Values are stored XOR'ed with the
+             * empty value, so unwritten pages read as empty.
+             *
+             * @tparam TValue Must be a trivially copyable type of 8 bytes,
+             *                such as osmium::Location.
+             */
+            template <typename TId, typename TValue>
+            class SharedDenseMmapArray : public Map<TId, TValue> {
+
+                static_assert(sizeof(TValue) == sizeof(uint64_t), "TValue must have 8 bytes");
+                static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "std::atomic<uint64_t> must have 8 bytes");
+
+                using header_type = detail::shared_dense_mmap_array_header;
+
+                enum : std::size_t {
+                    header_size = 4096
+                };
+
+                static_assert(sizeof(header_type) <= header_size, "Header too large");
+
+                std::string m_filename;
+                int m_fd = -1;
+                std::size_t m_max_ids = 0;
+                void* m_mapping = nullptr;
+                header_type* m_header = nullptr;
+                std::atomic<uint64_t>* m_data = nullptr;
+                bool m_read_only;
+
+                static uint64_t empty_bits() noexcept {
+                    const TValue empty = osmium::index::empty_value<TValue>();
+                    uint64_t bits = 0;
+                    std::memcpy(&bits, &empty, sizeof(bits));
+                    return bits;
+                }
+
+                static uint64_t encode(const TValue value) noexcept {
+                    uint64_t bits = 0;
+                    std::memcpy(&bits, &value, sizeof(bits));
+                    return bits ^ empty_bits();
+                }
+
+                static TValue decode(const uint64_t bits) noexcept {
+                    const uint64_t value_bits = bits ^ empty_bits();
+                    TValue value;
+                    std::memcpy(static_cast<void*>(&value), &value_bits, sizeof(value_bits));
+                    return value;
+                }
+
+                std::size_t file_bytes() const noexcept {
+                    return header_size + m_max_ids * sizeof(uint64_t);
+                }
+
+                void map_file(int prot) {
+                    void* addr = ::mmap(nullptr, file_bytes(), prot, MAP_SHARED, m_fd, 0); // NOLINT(hicpp-signed-bitwise)
+                    if (addr == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                        throw std::system_error{errno, std::system_category(), "mmap failed"};
+                    }
+                    m_mapping = addr;
+                    m_header = static_cast<header_type*>(addr);
+                    m_data = reinterpret_cast<std::atomic<uint64_t>*>(static_cast<char*>(addr) + header_size);
+                }
+
+                void unmap_and_close() noexcept {
+                    if (m_mapping) {
+                        ::munmap(m_mapping, file_bytes());
+                        m_mapping = nullptr;
+                    }
+                    if (m_fd >= 0) {
+                        ::close(m_fd);
+                        m_fd = -1;
+                    }
+                }
+
+                void resize_file() {
+                    if (::ftruncate(m_fd, static_cast<off_t>(file_bytes())) != 0) {
+                        throw std::system_error{errno, std::system_category(), "ftruncate failed"};
+                    }
+                }
+
+                [[noreturn]] void throw_invalid(const char* reason) {
+                    unmap_and_close();
+                    throw std::runtime_error{std::string{"invalid shared location index file '"} + m_filename + "': " + reason};
+                }
+
+                void check_writable() const {
+                    if (m_read_only) {
+                        throw std::runtime_error{"SharedDenseMmapArray is attached read-only"};
+                    }
+                }
+
+            public:
+
+                enum : std::size_t {
+                    /// Enough for the IDs in OSM planet files for some time.
+                    default_max_ids = 1ULL << 34U
+                };
+
+                /**
+                 * Create a new map in the given file for loading. An
+                 * existing file is truncated. The map is not visible to
+                 * consumers until mark_ready() is called.
+                 *
+                 * @param filename Name of the file.
+                 * @param max_ids The number of IDs the map can hold, ie.
+                 *                all IDs must be smaller than this.
+                 * @throws std::system_error if the file can't be created
+                 *         or mapped.
+                 */
+                SharedDenseMmapArray(std::string filename, std::size_t max_ids) :
+                    m_filename(std::move(filename)),
+                    m_max_ids(max_ids),
+                    m_read_only(false) {
+                    m_fd = ::open(m_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644); // NOLINT(hicpp-signed-bitwise)
+                    if (m_fd < 0) {
+                        throw std::system_error{errno, std::system_category(), std::string{"Open failed for '"} + m_filename + "'"};
+                    }
+                    try {
+                        resize_file();
+                        map_file(PROT_READ | PROT_WRITE); // NOLINT(hicpp-signed-bitwise)
+                    } catch (...) {
+                        unmap_and_close();
+                        throw;
+                    }
+
+                    new (m_header) header_type{};
+                    std::memcpy(m_header->magic, header_type::magic_string(), sizeof(m_header->magic));
+                    m_header->version = header_type::current_version;
+                    m_header->value_size = sizeof(TValue);
+                    m_header->max_ids = m_max_ids;
+                    m_header->size.store(0, std::memory_order_relaxed);
+                    m_header->state.store(header_type::state_loading, std::memory_order_release);
+                }
+
+                /**
+                 * Attach to an existing map read-only.
+                 *
+                 * @param filename Name of the file.
+                 * @throws std::system_error if the file can't be opened or
+                 *         mapped.
+                 * @throws std::runtime_error if the file is not a valid
+                 *         map file for this value type or isn't ready.
+                 */
+                explicit SharedDenseMmapArray(std::string filename) :
+                    m_filename(std::move(filename)),
+                    m_read_only(true) {
+                    m_fd = ::open(m_filename.c_str(), O_RDONLY); // NOLINT(hicpp-signed-bitwise)
+                    if (m_fd < 0) {
+                        throw std::system_error{errno, std::system_category(), std::string{"Open failed for '"} + m_filename + "'"};
+                    }
+
+                    const auto size = osmium::file_size(m_fd);
+                    if (size < header_size) {
+                        throw_invalid("file too small");
+                    }
+                    m_max_ids = (size - header_size) / sizeof(uint64_t);
+                    try {
+                        map_file(PROT_READ);
+                    } catch (...) {
+                        unmap_and_close();
+                        throw;
+                    }
+
+                    if (std::memcmp(m_header->magic, header_type::magic_string(), sizeof(m_header->magic)) != 0) {
+                        throw_invalid("wrong magic");
+                    }
+                    if (m_header->version != header_type::current_version ||
+                        m_header->value_size != sizeof(TValue) ||
+                        m_header->max_ids != m_max_ids ||
+                        size != file_bytes()) {
+                        throw_invalid("wrong version, value size, or file size");
+                    }
+                    if (m_header->state.load(std::memory_order_acquire) != header_type::state_ready) {
+                        throw_invalid("not ready (still loading)");
+                    }
+                }
+
+                SharedDenseMmapArray(const SharedDenseMmapArray&) = delete;
+                SharedDenseMmapArray& operator=(const SharedDenseMmapArray&) = delete;
+
+                SharedDenseMmapArray(SharedDenseMmapArray&&) = delete;
+                SharedDenseMmapArray& operator=(SharedDenseMmapArray&&) = delete;
+
+                ~SharedDenseMmapArray() noexcept final {
+                    unmap_and_close();
+                }
+
+                /// The name of the file.
+                const std::string& filename() const noexcept {
+                    return m_filename;
+                }
+
+                /// Is this map attached read-only?
+                bool read_only() const noexcept {
+                    return m_read_only;
+                }
+
+                /// Is the map marked as ready?
+                bool ready() const noexcept {
+                    return m_header->state.load(std::memory_order_acquire) == header_type::state_ready;
+                }
+
+                /// The number of IDs this map can hold.
+                std::size_t max_ids() const noexcept {
+                    return m_max_ids;
+                }
+
+                /**
+                 * Mark the map as ready, consumers can attach to it after
+                 * this. Do not call set() after this, consumers might
+                 * already be reading.
+                 *
+                 * @throws std::runtime_error if the map is read-only.
+                 */
+                void mark_ready() {
+                    check_writable();
+                    m_header->state.store(header_type::state_ready, std::memory_order_release);
+                }
+
+                /**
+                 * Set the value for an ID. Can be called from several
+                 * threads at the same time.
+                 *
+                 * @throws std::out_of_range if the ID is not smaller than
+                 *         max_ids().
+                 * @throws std::runtime_error if the map is read-only.
+                 */
+                void set(const TId id, const TValue value) final {
+                    check_writable();
+                    if (id >= m_max_ids) {
+                        throw std::out_of_range{"ID too large for SharedDenseMmapArray"};
+                    }
+                    m_data[id].store(encode(value), std::memory_order_relaxed);
+                    uint64_t size = m_header->size.load(std::memory_order_relaxed);
+                    while (id >= size && !m_header->size.compare_exchange_weak(size, static_cast<uint64_t>(id) + 1, std::memory_order_relaxed)) {
+                    }
+                }
+
+                TValue get(const TId id) const final {
+                    const TValue value = get_noexcept(id);
+                    if (value == osmium::index::empty_value<TValue>()) {
+                        throw osmium::not_found{id};
+                    }
+                    return value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    if (id >= m_header->size.load(std::memory_order_relaxed)) {
+                        this->count_lookup(false);
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    const TValue value = decode(m_data[id].load(std::memory_order_relaxed));
+                    this->count_lookup(value != osmium::index::empty_value<TValue>());
+                    return value;
+                }
+
+                void get_many(const TId* ids, const std::size_t count, TValue* values) const noexcept final {
+                    const std::size_t size = m_header->size.load(std::memory_order_relaxed);
+                    for (std::size_t i = 0; i < count && i < osmium::index::detail::prefetch_distance; ++i) {
+                        if (ids[i] < size) {
+                            osmium::index::detail::prefetch(m_data + ids[i]);
+                        }
+                    }
+                    for (std::size_t i = 0; i < count; ++i) {
+                        const std::size_t ahead = i + osmium::index::detail::prefetch_distance;
+                        if (ahead < count && ids[ahead] < size) {
+                            osmium::index::detail::prefetch(m_data + ids[ahead]);
+                        }
+                        values[i] = ids[i] < size ? decode(m_data[ids[i]].load(std::memory_order_relaxed)) : osmium::index::empty_value<TValue>();
+                        this->count_lookup(values[i] != osmium::index::empty_value<TValue>());
+                    }
+                }
+
+                /**
+                 * One more than the largest ID set so far.
+                 */
+                std::size_t size() const final {
+                    return static_cast<std::size_t>(m_header->size.load(std::memory_order_relaxed));
+                }
+
+                /**
+                 * The memory used at most. This assumes all memory up to
+                 * the largest ID set was actually written to. The memory
+                 * is shared between all processes using the map.
+                 */
+                std::size_t used_memory() const final {
+                    return size() * sizeof(uint64_t);
+                }
+
+                /**
+                 * Remove all values from the map and give the memory
+                 * back. The map is marked as loading again.
+                 *
+                 * @throws std::runtime_error if the map is read-only.
+                 */
+                void clear() final {
+                    check_writable();
+                    m_header->state.store(header_type::state_loading, std::memory_order_release);
+                    const std::size_t bytes = size() * sizeof(uint64_t);
+                    if (bytes > 0) {
+                        if (::ftruncate(m_fd, static_cast<off_t>(header_size)) != 0) {
+                            throw std::system_error{errno, std::system_category(), "ftruncate failed"};
+                        }
+                        resize_file();
+                    }
+                    m_header->size.store(0, std::memory_order_relaxed);
+                }
+
+                void dump_as_array(const int fd) final {
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / sizeof(TValue);
+                    std::unique_ptr<TValue[]> output_buffer{new TValue[buffer_size]};
+
+                    const std::size_t num = size();
+                    for (std::size_t start = 0; start < num; start += buffer_size) {
+                        const std::size_t count = std::min(buffer_size, num - start);
+                        for (std::size_t i = 0; i < count; ++i) {
+                            output_buffer[i] = decode(m_data[start + i].load(std::memory_order_relaxed));
+                        }
+                        osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer.get()), count * sizeof(TValue));
+                    }
+                }
+
+            }; // class SharedDenseMmapArray
+
+            /**
+             * The map factory needs the file name as argument. The map is
+             * attached read-only ("shared_dense_mmap_array,FILENAME")
+             * unless the third argument is "create"
+             * ("shared_dense_mmap_array,FILENAME,create").
+             */
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, SharedDenseMmapArray> {
+                SharedDenseMmapArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    if (config.size() < 2 || config[1].empty()) {
+                        throw osmium::map_factory_error{"Need file name for shared_dense_mmap_array"};
+                    }
+                    if (config.size() > 2 && config[2] == "create") {
+                        return new SharedDenseMmapArray<TId, TValue>{config[1], SharedDenseMmapArray<TId, TValue>::default_max_ids};
+                    }
+                    return new SharedDenseMmapArray<TId, TValue>{config[1]};
+                }
+            };
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SharedDenseMmapArray, shared_dense_mmap_array)
+#endif
+
+#endif // _WIN32
+
+#endif // OSMIUM_INDEX_MAP_SHARED_DENSE_MMAP_ARRAY_HPP
@@ -0,0 +1,257 @@
+#ifndef OSMIUM_INDEX_MAP_SPARSE_MEM_ARRAY_COMPACT_HPP
+#define OSMIUM_INDEX_MAP_SPARSE_MEM_ARRAY_COMPACT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#define OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_ARRAY_COMPACT
+
+namespace osmium {
+
+    namespace index {
+
+        namespace map {
+
+            /**
+             * Sparse map like SparseMemArray, but storing only the lower
+             * 32 bits of each id with the value. The upper bits are kept
+             * once per run of entries with the same upper bits in a small
+             * directory. For node locations this needs 12 instead of 16
+             * bytes per entry.
+             *
+             * Ids can be set in any order, but setting them in ascending
+             * order (as they are in OSM files) is fastest and needs no
+             * extra memory in sort(). Like with SparseMemArray, sort()
+             * must be called after setting values and before looking them
+             * up.
+             */
+            template <typename TId, typename TValue>
+            class SparseMemArrayCompact : public Map<TId, TValue> {
+
+                struct entry {
+                    uint32_t low;
+                    TValue value;
+                };
+
+                struct run {
+                    uint64_t high;
+                    std::size_t begin;
+                };
+
+                std::vector<entry> m_entries;
+
+                // Runs of entries with the same upper id bits in the order
+                // they were set. After sort() there is one run for each
+                // distinct value of the upper bits, in ascending order.
+                std::vector<run> m_runs;
+
+                bool m_sorted = true;
+
+                static uint64_t high_bits(const TId id) noexcept {
+                    return static_cast<uint64_t>(id) >> 32U;
+                }
+
+                static uint32_t low_bits(const TId id) noexcept {
+                    return static_cast<uint32_t>(static_cast<uint64_t>(id) & 0xffffffffU);
+                }
+
+                static TId make_id(const uint64_t high, const uint32_t low) noexcept {
+                    return static_cast<TId>((high << 32U) | low);
+                }
+
+                std::size_t run_end(const std::size_t n) const noexcept {
+                    return n + 1 < m_runs.size() ? m_runs[n + 1].begin : m_entries.size();
+                }
+
+                template <typename TFunc>
+                void for_each(TFunc&& func) const {
+                    for (std::size_t n = 0; n < m_runs.size(); ++n) {
+                        const auto end = run_end(n);
+                        for (std::size_t i = m_runs[n].begin; i < end; ++i) {
+                            std::forward<TFunc>(func)(make_id(m_runs[n].high, m_entries[i].low), m_entries[i].value);
+                        }
+                    }
+                }
+
+                const entry* find(const TId id) const noexcept {
+                    const auto high = high_bits(id);
+                    const auto it = std::lower_bound(m_runs.cbegin(), m_runs.cend(), high, [](const run& r, const uint64_t h) noexcept {
+                        return r.high < h;
+                    });
+                    if (it == m_runs.cend() || it->high != high) {
+                        return nullptr;
+                    }
+
+                    const auto begin = m_entries.cbegin() + static_cast<std::ptrdiff_t>(it->begin);
+                    const auto end = m_entries.cbegin() + static_cast<std::ptrdiff_t>(run_end(static_cast<std::size_t>(it - m_runs.cbegin())));
+                    const auto low = low_bits(id);
+                    const auto e = std::lower_bound(begin, end, low, [](const entry& a, const uint32_t l) noexcept {
+                        return a.low < l;
+                    });
+                    if (e == end || e->low != low) {
+                        return nullptr;
+                    }
+                    return &*e;
+                }
+
+            public:
+
+                SparseMemArrayCompact() = default;
+
+                ~SparseMemArrayCompact() noexcept final = default;
+
+                void reserve(const std::size_t size) final {
+                    m_entries.reserve(size);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    const auto high = high_bits(id);
+                    const auto low = low_bits(id);
+                    if (m_runs.empty() || m_runs.back().high != high) {
+                        if (!m_runs.empty() && m_runs.back().high > high) {
+                            m_sorted = false;
+                        }
+                        m_runs.push_back(run{high, m_entries.size()});
+                    } else if (m_sorted && m_entries.back().low > low) {
+                        m_sorted = false;
+                    }
+                    m_entries.push_back(entry{low, value});
+                }
+
+                TValue get(const TId id) const final {
+                    const entry* e = find(id);
+                    if (!e) {
+                        this->count_lookup(false);
+                        throw osmium::not_found{id};
+                    }
+                    this->count_lookup(true);
+                    return e->value;
+                }
+
+                TValue get_noexcept(const TId id) const noexcept final {
+                    const entry* e = find(id);
+                    if (!e) {
+                        this->count_lookup(false);
+                        return osmium::index::empty_value<TValue>();
+                    }
+                    this->count_lookup(true);
+                    return e->value;
+                }
+
+                std::size_t size() const final {
+                    return m_entries.size();
+                }
+
+                std::size_t used_memory() const final {
+                    return m_entries.capacity() * sizeof(entry) +
+                           m_runs.capacity() * sizeof(run);
+                }
+
+                void clear() final {
+                    m_entries.clear();
+                    m_entries.shrink_to_fit();
+                    m_runs.clear();
+                    m_runs.shrink_to_fit();
+                    m_sorted = true;
+                }
+
+                /**
+                 * Sort all entries. This does nothing if the ids were set
+                 * in ascending order. Otherwise a temporary copy of all
+                 * entries with full ids is sorted and the entries are
+                 * rebuilt from it.
+                 */
+                void sort() final {
+                    if (m_sorted) {
+                        return;
+                    }
+
+                    using element_type = std::pair<TId, TValue>;
+                    std::vector<element_type> elements;
+                    elements.reserve(m_entries.size());
+                    for_each([&elements](const TId id, const TValue& value) {
+                        elements.emplace_back(id, value);
+                    });
+
+                    osmium::index::detail::radix_sort(elements, [](const element_type& element) noexcept {
+                        return static_cast<uint64_t>(element.first);
+                    });
+
+                    m_entries.clear();
+                    m_runs.clear();
+                    for (const auto& element : elements) {
+                        set(element.first, element.second);
+                    }
+                    m_sorted = true;
+                }
+
+                map_stats statistics() const final {
+                    map_stats result{Map<TId, TValue>::statistics()};
+                    result.sorted = m_sorted;
+                    return result;
+                }
+
+                void dump_as_list(const int fd) final {
+                    sort();
+
+                    std::vector<std::pair<TId, TValue>> elements;
+                    elements.reserve(m_entries.size());
+                    for_each([&elements](const TId id, const TValue& value) {
+                        elements.emplace_back(id, value);
+                    });
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(elements.data()), sizeof(std::pair<TId, TValue>) * elements.size());
+                }
+
+            }; // class SparseMemArrayCompact
+
+        } // namespace map
+
+    } // namespace index
+
+} // namespace osmium
+
+#ifdef OSMIUM_WANT_NODE_LOCATION_MAPS
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemArrayCompact, sparse_mem_array_compact)
+#endif
+
+#endif // OSMIUM_INDEX_MAP_SPARSE_MEM_ARRAY_COMPACT_HPP
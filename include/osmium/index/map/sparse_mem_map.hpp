@@ -79,16 +79,20 @@ namespace osmium {
                 TValue get(const TId id) const final {
                     const auto it = m_elements.find(id);
                     if (it == m_elements.end()) {
+                        this->count_lookup(false);
                         throw osmium::not_found{id};
                     }
+                    this->count_lookup(true);
                     return it->second;
                 }
 
                 TValue get_noexcept(const TId id) const noexcept final {
                     const auto it = m_elements.find(id);
                     if (it == m_elements.end()) {
+                        this->count_lookup(false);
                         return osmium::index::empty_value<TValue>();
                     }
+                    this->count_lookup(true);
                     return it->second;
                 }
 
@@ -96,10 +96,7 @@ namespace osmium {
                 }
 
                 TValue get(const TId id) const final {
-                    if (id >= m_elements.size()) {
-                        throw osmium::not_found{id};
-                    }
-                    const TValue value = m_elements[id];
+                    const TValue value = get_noexcept(id);
                     if (value == osmium::index::empty_value<TValue>()) {
                         throw osmium::not_found{id};
                     }
@@ -108,9 +105,12 @@ namespace osmium {
 
                 TValue get_noexcept(const TId id) const noexcept final {
                     if (id >= m_elements.size()) {
+                        this->count_lookup(false);
                         return osmium::index::empty_value<TValue>();
                     }
-                    return m_elements[id];
+                    const TValue value = m_elements[id];
+                    this->count_lookup(value != osmium::index::empty_value<TValue>());
+                    return value;
                 }
 
                 size_t size() const final {
@@ -127,6 +127,13 @@ namespace osmium {
                     m_elements.clear();
                 }
 
+                map_stats statistics() const final {
+                    map_stats result{Map<TId, TValue>::statistics()};
+                    result.size = m_elements.num_nonempty();
+                    result.capacity = m_elements.size();
+                    return result;
+                }
+
                 void dump_as_list(const int fd) final {
                     std::vector<std::pair<TId, TValue>> v;
                     v.reserve(m_elements.size());
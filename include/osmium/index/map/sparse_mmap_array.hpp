@@ -35,9 +35,13 @@ DEALINGS IN THE SOFTWARE.
 
 #ifdef __linux__
 
+#include <osmium/index/detail/mmap_hints.hpp>
 #include <osmium/index/detail/mmap_vector_anon.hpp>
 #include <osmium/index/detail/vector_map.hpp>
 
+#include <string>
+#include <vector>
+
 #define OSMIUM_HAS_INDEX_MAP_SPARSE_MMAP_ARRAY
 
 namespace osmium {
@@ -49,6 +53,18 @@ namespace osmium {
             template <typename TId, typename TValue>
             using SparseMmapArray = VectorBasedSparseMap<TId, TValue, osmium::detail::mmap_vector_anon>;
 
+            /**
+             * The map can be created with options "hugepages",
+             * "interleave", and "prefault", for instance with the config
+             * string "sparse_mmap_array,hugepages". See osmium::detail::mmap_hints.
+             */
+            template <typename TId, typename TValue>
+            struct create_map<TId, TValue, SparseMmapArray> {
+                SparseMmapArray<TId, TValue>* operator()(const std::vector<std::string>& config) {
+                    return new SparseMmapArray<TId, TValue>{osmium::index::detail::parse_mmap_hints(config)};
+                }
+            };
+
         } // namespace map
 
     } // namespace index
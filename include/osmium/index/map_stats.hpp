@@ -0,0 +1,307 @@
+#ifndef OSMIUM_INDEX_MAP_STATS_HPP
+#define OSMIUM_INDEX_MAP_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#ifdef OSMIUM_WITH_INDEX_STATS
+# include <atomic>
+#endif
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Statistics about an index map or multimap as returned by the
+         * statistics() function of the map.
+         *
+         * The lookup and miss counters are only updated if the code
+         * was compiled with OSMIUM_WITH_INDEX_STATS defined, otherwise
+         * they are always 0.
+         */
+        struct map_stats {
+
+            /// Number of entries stored. For dense maps this is the number
+            /// of non-empty slots.
+            std::size_t size = 0;
+
+            /// Memory used in bytes (see Map::used_memory()).
+            std::size_t used_memory = 0;
+
+            /// Number of slots allocated in dense storage, 0 if the map
+            /// has no dense storage.
+            std::size_t capacity = 0;
+
+            /// Number of memory blocks for maps allocating in blocks, 0
+            /// otherwise.
+            std::size_t blocks = 0;
+
+            /// Is the data sorted, ie. ready for lookups?
+            bool sorted = true;
+
+            /// Number of lookups.
+            uint64_t lookups = 0;
+
+            /// Number of lookups for ids not in the map.
+            uint64_t misses = 0;
+
+            /// Fraction of the allocated slots in use, 1 if the map has
+            /// no dense storage.
+            double fill_ratio() const noexcept {
+                return capacity == 0 ? 1.0 : static_cast<double>(size) / static_cast<double>(capacity);
+            }
+
+        }; // struct map_stats
+
+        template <typename TChar, typename TTraits>
+        inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const map_stats& stats) {
+            out << "size=" << stats.size
+                << " used_memory=" << stats.used_memory;
+            if (stats.capacity != 0) {
+                const auto flags = out.flags();
+                const auto precision = out.precision();
+                out << " capacity=" << stats.capacity
+                    << " fill_ratio=" << std::fixed << std::setprecision(3) << stats.fill_ratio();
+                out.flags(flags);
+                out.precision(precision);
+            }
+            if (stats.blocks != 0) {
+                out << " blocks=" << stats.blocks;
+            }
+            return out << " sorted=" << (stats.sorted ? "yes" : "no")
+                       << " lookups=" << stats.lookups
+                       << " misses=" << stats.misses;
+        }
+
+        namespace detail {
+
+            class stats_source;
+
+            /**
+             * Registry of all live maps. Maps are only registered if
+             * OSMIUM_WITH_INDEX_STATS is defined.
+             */
+            class map_stats_registry {
+
+                std::mutex m_mutex;
+                std::map<const stats_source*, std::string> m_sources;
+
+                map_stats_registry() = default;
+
+            public:
+
+                static map_stats_registry& instance() {
+                    static map_stats_registry registry;
+                    return registry;
+                }
+
+                void add(const stats_source* source) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_sources.emplace(source, std::string{});
+                }
+
+                void remove(const stats_source* source) noexcept {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    m_sources.erase(source);
+                }
+
+                void set_name(const stats_source* source, const std::string& name) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    const auto it = m_sources.find(source);
+                    if (it != m_sources.end()) {
+                        it->second = name;
+                    }
+                }
+
+                template <typename TFunc>
+                void for_each(TFunc&& func) {
+                    const std::lock_guard<std::mutex> lock{m_mutex};
+                    for (const auto& source : m_sources) {
+                        std::forward<TFunc>(func)(*source.first, source.second);
+                    }
+                }
+
+            }; // class map_stats_registry
+
+            /**
+             * Common base class of all maps and multimaps for reporting
+             * statistics.
+             */
+            class stats_source {
+
+#ifdef OSMIUM_WITH_INDEX_STATS
+                void add_to_registry() noexcept {
+                    try {
+                        map_stats_registry::instance().add(this);
+                    } catch (...) {
+                        // statistics are optional, ignore errors
+                    }
+                }
+#endif
+
+            protected:
+
+#ifdef OSMIUM_WITH_INDEX_STATS
+                stats_source() noexcept {
+                    add_to_registry();
+                }
+
+                stats_source(const stats_source& /*other*/) noexcept {
+                    add_to_registry();
+                }
+
+                stats_source(stats_source&& /*other*/) noexcept {
+                    add_to_registry();
+                }
+
+                stats_source& operator=(const stats_source& /*other*/) noexcept {
+                    return *this;
+                }
+
+                stats_source& operator=(stats_source&& /*other*/) noexcept {
+                    return *this;
+                }
+
+                ~stats_source() noexcept {
+                    map_stats_registry::instance().remove(this);
+                }
+#else
+                stats_source() noexcept = default;
+                stats_source(const stats_source&) noexcept = default;
+                stats_source(stats_source&&) noexcept = default;
+                stats_source& operator=(const stats_source&) noexcept = default;
+                stats_source& operator=(stats_source&&) noexcept = default;
+                ~stats_source() noexcept = default;
+#endif
+
+            public:
+
+                virtual map_stats statistics() const = 0;
+
+            }; // class stats_source
+
+            /**
+             * Counts lookups and misses if OSMIUM_WITH_INDEX_STATS is
+             * defined, does nothing otherwise.
+             */
+            class lookup_counter {
+
+#ifdef OSMIUM_WITH_INDEX_STATS
+                mutable std::atomic<uint64_t> m_lookups{0};
+                mutable std::atomic<uint64_t> m_misses{0};
+
+            public:
+
+                lookup_counter() noexcept = default;
+
+                lookup_counter(const lookup_counter& other) noexcept :
+                    m_lookups(other.lookups()),
+                    m_misses(other.misses()) {
+                }
+
+                lookup_counter& operator=(const lookup_counter& other) noexcept {
+                    m_lookups.store(other.lookups(), std::memory_order_relaxed);
+                    m_misses.store(other.misses(), std::memory_order_relaxed);
+                    return *this;
+                }
+
+                ~lookup_counter() noexcept = default;
+
+                void count(const bool found) const noexcept {
+                    m_lookups.fetch_add(1, std::memory_order_relaxed);
+                    if (!found) {
+                        m_misses.fetch_add(1, std::memory_order_relaxed);
+                    }
+                }
+
+                uint64_t lookups() const noexcept {
+                    return m_lookups.load(std::memory_order_relaxed);
+                }
+
+                uint64_t misses() const noexcept {
+                    return m_misses.load(std::memory_order_relaxed);
+                }
+#else
+            public:
+
+                void count(const bool /*found*/) const noexcept {
+                }
+
+                uint64_t lookups() const noexcept {
+                    return 0;
+                }
+
+                uint64_t misses() const noexcept {
+                    return 0;
+                }
+#endif
+
+                void add_to(map_stats& stats) const noexcept {
+                    stats.lookups = lookups();
+                    stats.misses = misses();
+                }
+
+            }; // class lookup_counter
+
+        } // namespace detail
+
+        /**
+         * Write statistics for all live maps and multimaps to the stream,
+         * one line per map. Maps created through the MapFactory are
+         * labeled with the map type name. This only reports anything if
+         * the code was compiled with OSMIUM_WITH_INDEX_STATS defined.
+         *
+         * Do not call this while maps are being created or destroyed in
+         * other threads.
+         */
+        template <typename TChar, typename TTraits>
+        inline void dump_map_stats(std::basic_ostream<TChar, TTraits>& out) {
+            detail::map_stats_registry::instance().for_each([&out](const detail::stats_source& source, const std::string& name) {
+                out << (name.empty() ? "(unnamed)" : name) << ": " << source.statistics() << '\n';
+            });
+        }
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MAP_STATS_HPP
@@ -33,6 +33,8 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/map_stats.hpp>
+
 #include <cstddef>
 #include <stdexcept>
 #include <type_traits>
@@ -48,7 +50,7 @@ namespace osmium {
         namespace multimap {
 
             template <typename TId, typename TValue>
-            class Multimap {
+            class Multimap : public osmium::index::detail::stats_source {
 
                 static_assert(std::is_integral<TId>::value && std::is_unsigned<TId>::value, "TId template parameter for class Multimap must be unsigned integral type");
 
@@ -116,6 +118,17 @@ namespace osmium {
                     throw std::runtime_error{"can't dump as list"};
                 }
 
+                /**
+                 * Get statistics about this multimap. Lookups are not
+                 * counted for multimaps.
+                 */
+                map_stats statistics() const override {
+                    map_stats result;
+                    result.size = size();
+                    result.used_memory = used_memory();
+                    return result;
+                }
+
             }; // class Multimap
 
         } // namespace multimap
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/multimap/flat_multimap.hpp>       // IWYU pragma: keep
 #include <osmium/index/multimap/sparse_file_array.hpp>   // IWYU pragma: keep
 #include <osmium/index/multimap/sparse_mem_array.hpp>    // IWYU pragma: keep
 #include <osmium/index/multimap/sparse_mem_multimap.hpp> // IWYU pragma: keep
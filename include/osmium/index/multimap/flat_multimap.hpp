@@ -0,0 +1,270 @@
+#ifndef OSMIUM_INDEX_MULTIMAP_FLAT_MULTIMAP_HPP
+#define OSMIUM_INDEX_MULTIMAP_FLAT_MULTIMAP_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/multimap.hpp>
+#include <osmium/io/detail/read_write.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace index {
+
+        namespace multimap {
+
+            /**
+             * Multimap for the "build once, query many" pattern, for
+             * instance to look up the ways a node is in.
+             *
+             * Values are added with set(). After all values are added,
+             * sort() radix sorts them by key and builds a compressed sparse
+             * row (CSR) layout: an array of the distinct keys, an array of
+             * offsets into the values array for each key, and the values
+             * themselves, stored contiguously without the keys. A directory
+             * indexed by the high bits of the key points into the keys
+             * array, so a lookup only needs to search a handful of keys.
+             *
+             * Values for the same key are kept in the order they were set.
+             *
+             * set() can be called again after sort(), but the new values
+             * are only visible after the next sort(), which rebuilds the
+             * whole index.
+             */
+            template <typename TId, typename TValue>
+            class FlatMultimap : public Multimap<TId, TValue> {
+
+                enum : unsigned int {
+                    directory_bits = 8
+                };
+
+                using element_type = std::pair<TId, TValue>;
+
+                std::vector<element_type> m_unsorted;
+
+                std::vector<TId> m_keys;
+                std::vector<std::size_t> m_offsets;
+                std::vector<TValue> m_values;
+                std::vector<std::size_t> m_directory;
+
+                // Position in m_keys of the first key not smaller than
+                // the given key.
+                std::size_t find_key(const TId id) const noexcept {
+                    const std::size_t bucket = static_cast<std::size_t>(id >> directory_bits);
+                    if (bucket + 1 >= m_directory.size()) {
+                        return m_keys.size();
+                    }
+                    const auto first = m_keys.cbegin() + static_cast<std::ptrdiff_t>(m_directory[bucket]);
+                    const auto last = m_keys.cbegin() + static_cast<std::ptrdiff_t>(m_directory[bucket + 1]);
+                    const auto it = std::lower_bound(first, last, id);
+                    return static_cast<std::size_t>(it - m_keys.cbegin());
+                }
+
+                void build(const std::vector<element_type>& elements) {
+                    m_keys.clear();
+                    m_offsets.clear();
+                    m_values.clear();
+                    m_directory.clear();
+
+                    m_values.reserve(elements.size());
+                    for (const auto& element : elements) {
+                        if (m_keys.empty() || m_keys.back() != element.first) {
+                            m_keys.push_back(element.first);
+                            m_offsets.push_back(m_values.size());
+                        }
+                        m_values.push_back(element.second);
+                    }
+                    m_offsets.push_back(m_values.size());
+
+                    if (m_keys.empty()) {
+                        return;
+                    }
+
+                    const std::size_t buckets = static_cast<std::size_t>(m_keys.back() >> directory_bits) + 1;
+                    m_directory.reserve(buckets + 1);
+                    std::size_t pos = 0;
+                    for (std::size_t bucket = 0; bucket <= buckets; ++bucket) {
+                        while (pos < m_keys.size() && static_cast<std::size_t>(m_keys[pos] >> directory_bits) < bucket) {
+                            ++pos;
+                        }
+                        m_directory.push_back(pos);
+                    }
+
+                    m_keys.shrink_to_fit();
+                    m_offsets.shrink_to_fit();
+                }
+
+            public:
+
+                using value_iterator = const TValue*;
+
+                FlatMultimap() = default;
+
+                ~FlatMultimap() noexcept final = default;
+
+                void reserve(const std::size_t size) {
+                    m_unsorted.reserve(size);
+                }
+
+                void set(const TId id, const TValue value) final {
+                    m_unsorted.emplace_back(id, value);
+                }
+
+                /**
+                 * Get all values for the key. Only values set before the
+                 * last call to sort() are found.
+                 *
+                 * @returns Pair of pointers to the first and one past the
+                 *          last value.
+                 */
+                std::pair<value_iterator, value_iterator> get_all(const TId id) const noexcept {
+                    const std::size_t pos = find_key(id);
+                    if (pos == m_keys.size() || m_keys[pos] != id) {
+                        return std::make_pair(nullptr, nullptr);
+                    }
+                    const TValue* values = m_values.data();
+                    return std::make_pair(values + m_offsets[pos], values + m_offsets[pos + 1]);
+                }
+
+                /// The number of values for the key.
+                std::size_t count(const TId id) const noexcept {
+                    const auto range = get_all(id);
+                    return static_cast<std::size_t>(range.second - range.first);
+                }
+
+                /// The number of distinct keys in the sorted index.
+                std::size_t num_keys() const noexcept {
+                    return m_keys.size();
+                }
+
+                std::size_t size() const final {
+                    return m_values.size() + m_unsorted.size();
+                }
+
+                std::size_t used_memory() const final {
+                    return m_unsorted.capacity() * sizeof(element_type) +
+                           m_keys.capacity() * sizeof(TId) +
+                           m_offsets.capacity() * sizeof(std::size_t) +
+                           m_values.capacity() * sizeof(TValue) +
+                           m_directory.capacity() * sizeof(std::size_t);
+                }
+
+                void clear() final {
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+                    m_keys.clear();
+                    m_keys.shrink_to_fit();
+                    m_offsets.clear();
+                    m_offsets.shrink_to_fit();
+                    m_values.clear();
+                    m_values.shrink_to_fit();
+                    m_directory.clear();
+                    m_directory.shrink_to_fit();
+                }
+
+                /**
+                 * Build the index from all values set. Must be called before
+                 * get_all().
+                 */
+                void sort() final {
+                    if (m_unsorted.empty()) {
+                        return;
+                    }
+
+                    // Put values already in the index in front, so they stay
+                    // in front of newer values for the same key after the
+                    // stable sort.
+                    std::vector<element_type> elements;
+                    elements.reserve(m_values.size() + m_unsorted.size());
+                    for (std::size_t k = 0; k < m_keys.size(); ++k) {
+                        for (std::size_t i = m_offsets[k]; i < m_offsets[k + 1]; ++i) {
+                            elements.emplace_back(m_keys[k], m_values[i]);
+                        }
+                    }
+                    elements.insert(elements.end(), m_unsorted.cbegin(), m_unsorted.cend());
+                    m_unsorted.clear();
+                    m_unsorted.shrink_to_fit();
+
+                    osmium::index::detail::radix_sort(elements, [](const element_type& element) noexcept {
+                        return static_cast<uint64_t>(element.first);
+                    });
+
+                    build(elements);
+                }
+
+                map_stats statistics() const final {
+                    map_stats result{Multimap<TId, TValue>::statistics()};
+                    result.sorted = m_unsorted.empty();
+                    return result;
+                }
+
+                /**
+                 * Write out all (key, value) pairs of the sorted index in
+                 * order.
+                 */
+                void dump_as_list(const int fd) final {
+                    sort();
+
+                    constexpr const std::size_t buffer_size = (10UL * 1024UL * 1024UL) / sizeof(element_type);
+                    std::vector<element_type> buffer;
+                    buffer.reserve(buffer_size);
+
+                    for (std::size_t k = 0; k < m_keys.size(); ++k) {
+                        for (std::size_t i = m_offsets[k]; i < m_offsets[k + 1]; ++i) {
+                            buffer.emplace_back(m_keys[k], m_values[i]);
+                            if (buffer.size() == buffer_size) {
+                                osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(buffer.data()), buffer.size() * sizeof(element_type));
+                                buffer.clear();
+                            }
+                        }
+                    }
+                    osmium::io::detail::reliable_write(fd, reinterpret_cast<const unsigned char*>(buffer.data()), buffer.size() * sizeof(element_type));
+                }
+
+            }; // class FlatMultimap
+
+        } // namespace multimap
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_MULTIMAP_FLAT_MULTIMAP_HPP
@@ -39,6 +39,18 @@ DEALINGS IN THE SOFTWARE.
 
 #define OSMIUM_WANT_NODE_LOCATION_MAPS
 
+#ifdef OSMIUM_HAS_INDEX_MAP_COMPRESSED_MEM_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::CompressedMemArray, compressed_mem_array)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_CONCURRENT_DENSE_MMAP_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::ConcurrentDenseMmapArray, concurrent_dense_mmap_array)
+#endif
+
+#ifdef OSMIUM_HAS_INDEX_MAP_CONCURRENT_SPARSE_MEM_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::ConcurrentSparseMemArray, concurrent_sparse_mem_array)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_DENSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseFileArray, dense_file_array)
 #endif
@@ -51,6 +63,10 @@ DEALINGS IN THE SOFTWARE.
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::DenseMmapArray, dense_mmap_array)
 #endif
 
+#ifdef OSMIUM_HAS_INDEX_MAP_SHARED_DENSE_MMAP_ARRAY
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SharedDenseMmapArray, shared_dense_mmap_array)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_FILE_ARRAY
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseFileArray, sparse_file_array)
 #endif
@@ -59,6 +75,13 @@ DEALINGS IN THE SOFTWARE.
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemArray, sparse_mem_array)
 #endif
 
+#ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_ARRAY_BTREE
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemArrayBtree, sparse_mem_array_btree)
+#endif
+#ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_ARRAY_COMPACT
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemArrayCompact, sparse_mem_array_compact)
+#endif
+
 #ifdef OSMIUM_HAS_INDEX_MAP_SPARSE_MEM_MAP
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::SparseMemMap, sparse_mem_map)
 #endif
@@ -75,4 +98,8 @@ DEALINGS IN THE SOFTWARE.
     REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::FlexMem, flex_mem)
 #endif
 
+#ifdef OSMIUM_HAS_INDEX_MAP_RANGE_MEM
+    REGISTER_MAP(osmium::unsigned_object_id_type, osmium::Location, osmium::index::map::RangeMem, range_mem)
+#endif
+
 #endif // OSMIUM_INDEX_NODE_LOCATIONS_MAP_HPP
@@ -0,0 +1,347 @@
+#ifndef OSMIUM_INDEX_NWR_INDEX_BUNDLE_HPP
+#define OSMIUM_INDEX_NWR_INDEX_BUNDLE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/id_set_compressed.hpp>
+#include <osmium/index/index.hpp>
+#include <osmium/index/map.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/string.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#else
+# include <io.h>
+#endif
+
+namespace osmium {
+
+    namespace index {
+
+        /**
+         * Owns an Id set and an Id to value map for each of nodes, ways,
+         * and relations and keeps their combined memory use under a
+         * budget.
+         *
+         * Id sets start out as IdSetDense. Maps are created with the
+         * MapFactory from the given map type config string. Every
+         * check_interval calls to set() or set_id() the memory use is
+         * checked. If it is over the budget, the structures are switched
+         * to more compact or disk-backed modes, cheapest first:
+         *
+         * 1. Id sets are converted to IdSetCompressed.
+         * 2. The largest map is copied into a new map of the fallback map
+         *    type. Maps of the fallback type are expected to be disk-backed
+         *    (such as "sparse_file_array") and are not counted against the
+         *    budget any more.
+         *
+         * Switching maps only works for map types implementing
+         * dump_as_list(), such as "flex_mem" or "sparse_mem_array".
+         *
+         * The maps for all three types must use the same value type. If
+         * only nodes need values, the way and relation maps are simply not
+         * used and stay empty.
+         *
+         * @tparam TValue The value type of the maps.
+         */
+        template <typename TValue>
+        class NWRIndexBundle {
+
+        public:
+
+            using id_type = osmium::unsigned_object_id_type;
+            using value_type = TValue;
+            using map_type = osmium::index::map::Map<id_type, TValue>;
+            using id_set_type = osmium::index::IdSet<id_type>;
+
+            enum : std::size_t {
+                check_interval = 1UL << 16U
+            };
+
+        private:
+
+            osmium::nwr_array<std::unique_ptr<map_type>> m_maps;
+            osmium::nwr_array<std::unique_ptr<id_set_type>> m_id_sets;
+            osmium::nwr_array<bool> m_map_switched;
+            osmium::nwr_array<bool> m_id_set_compressed;
+
+            std::string m_fallback_map_type;
+            std::size_t m_memory_budget;
+            std::size_t m_updates = 0;
+
+            static constexpr osmium::item_type types[3] = {
+                osmium::item_type::node,
+                osmium::item_type::way,
+                osmium::item_type::relation
+            };
+
+            void updated() {
+                if (++m_updates % check_interval == 0) {
+                    check_budget();
+                }
+            }
+
+            void compress_id_set(const osmium::item_type type) {
+                using dense_type = osmium::index::IdSetDense<id_type>;
+                std::unique_ptr<osmium::index::IdSetCompressed<id_type>> compressed{new osmium::index::IdSetCompressed<id_type>{}};
+                for (const auto id : static_cast<const dense_type&>(*m_id_sets(type))) {
+                    compressed->set(id);
+                }
+                compressed->optimize();
+                m_id_sets(type) = std::move(compressed);
+                m_id_set_compressed(type) = true;
+            }
+
+            void switch_map(const osmium::item_type type) {
+                using element_type = std::pair<id_type, TValue>;
+
+                const int fd = osmium::detail::create_tmp_file();
+                try {
+                    m_maps(type)->dump_as_list(fd);
+                    m_maps(type).reset();
+                    m_maps(type) = MapFactory<id_type, TValue>::instance().create_map(m_fallback_map_type);
+                    m_map_switched(type) = true;
+
+#ifdef _MSC_VER
+                    const auto offset = _lseeki64(fd, 0, SEEK_SET);
+#else
+                    const auto offset = ::lseek(fd, 0, SEEK_SET);
+#endif
+                    if (offset != 0) {
+                        throw std::system_error{errno, std::system_category(), "lseek failed"};
+                    }
+
+                    std::vector<element_type> buffer(check_interval);
+                    auto* data = reinterpret_cast<char*>(buffer.data());
+                    const std::size_t capacity = buffer.size() * sizeof(element_type);
+                    std::size_t filled = 0;
+                    while (true) {
+                        const auto nread = osmium::io::detail::reliable_read(fd, data + filled, static_cast<unsigned int>(capacity - filled));
+                        filled += static_cast<std::size_t>(nread);
+                        const std::size_t count = filled / sizeof(element_type);
+                        for (std::size_t i = 0; i < count; ++i) {
+                            m_maps(type)->set(buffer[i].first, buffer[i].second);
+                        }
+                        if (nread == 0) {
+                            break;
+                        }
+                        filled -= count * sizeof(element_type);
+                        std::memmove(data, data + count * sizeof(element_type), filled);
+                    }
+                } catch (...) {
+                    osmium::io::detail::reliable_close(fd);
+                    throw;
+                }
+                osmium::io::detail::reliable_close(fd);
+            }
+
+        public:
+
+            /**
+             * Create a bundle.
+             *
+             * @param memory_budget Maximum number of bytes the in-memory
+             *        structures should use.
+             * @param map_type Config string for the maps (see MapFactory).
+             * @param fallback_map_type Config string for the maps used after
+             *        the budget was exceeded.
+             * @throws map_factory_error If a map type is not available.
+             */
+            explicit NWRIndexBundle(const std::size_t memory_budget,
+                                    const std::string& map_type = "flex_mem",
+                                    std::string fallback_map_type = "sparse_file_array") :
+                m_fallback_map_type(std::move(fallback_map_type)),
+                m_memory_budget(memory_budget) {
+                const auto& factory = MapFactory<id_type, TValue>::instance();
+                if (!factory.has_map_type(osmium::split_string(m_fallback_map_type, ',').front())) {
+                    throw map_factory_error{std::string{"Support for map type '"} + m_fallback_map_type + "' not compiled into this binary"};
+                }
+                for (const auto type : types) {
+                    m_maps(type) = factory.create_map(map_type);
+                    m_id_sets(type).reset(new osmium::index::IdSetDense<id_type>{});
+                    m_map_switched(type) = false;
+                    m_id_set_compressed(type) = false;
+                }
+            }
+
+            /// The map for the given type.
+            map_type& map(const osmium::item_type type) noexcept {
+                return *m_maps(type);
+            }
+
+            /// The map for the given type.
+            const map_type& map(const osmium::item_type type) const noexcept {
+                return *m_maps(type);
+            }
+
+            /// The Id set for the given type.
+            const id_set_type& id_set(const osmium::item_type type) const noexcept {
+                return *m_id_sets(type);
+            }
+
+            /**
+             * Set the value for the Id of the given type. Use this instead
+             * of map(type).set() so the memory budget is checked.
+             */
+            void set(const osmium::item_type type, const id_type id, const TValue value) {
+                m_maps(type)->set(id, value);
+                updated();
+            }
+
+            /// Get the value for the Id of the given type.
+            TValue get(const osmium::item_type type, const id_type id) const {
+                return m_maps(type)->get(id);
+            }
+
+            /// Get the value for the Id of the given type.
+            TValue get_noexcept(const osmium::item_type type, const id_type id) const noexcept {
+                return m_maps(type)->get_noexcept(id);
+            }
+
+            /**
+             * Add the Id of the given type to the Id set. Use this instead
+             * of id_set(type).set() so the memory budget is checked.
+             */
+            void set_id(const osmium::item_type type, const id_type id) {
+                m_id_sets(type)->set(id);
+                updated();
+            }
+
+            /// Is the Id of the given type in the Id set?
+            bool get_id(const osmium::item_type type, const id_type id) const noexcept {
+                return m_id_sets(type)->get(id);
+            }
+
+            /**
+             * Sort all maps. Call this after adding all values and before
+             * any lookups.
+             */
+            void sort() {
+                for (const auto type : types) {
+                    m_maps(type)->sort();
+                }
+            }
+
+            /// The memory budget in bytes.
+            std::size_t memory_budget() const noexcept {
+                return m_memory_budget;
+            }
+
+            /**
+             * The memory counted against the budget: All Id sets and all
+             * maps that have not been switched to the fallback map type.
+             */
+            std::size_t used_memory() const {
+                std::size_t memory = 0;
+                for (const auto type : types) {
+                    memory += m_id_sets(type)->used_memory();
+                    if (!m_map_switched(type)) {
+                        memory += m_maps(type)->used_memory();
+                    }
+                }
+                return memory;
+            }
+
+            /// Has the map for this type been switched to the fallback type?
+            bool map_switched(const osmium::item_type type) const noexcept {
+                return m_map_switched(type);
+            }
+
+            /// Has the Id set for this type been converted to IdSetCompressed?
+            bool id_set_compressed(const osmium::item_type type) const noexcept {
+                return m_id_set_compressed(type);
+            }
+
+            /**
+             * Check the memory use and switch structures to compact or
+             * disk-backed modes until it is under the budget or there is
+             * nothing left to switch. This is called automatically from
+             * set() and set_id(), but you can call it at any time.
+             *
+             * @returns true if the memory use is under the budget.
+             */
+            bool check_budget() {
+                if (used_memory() <= m_memory_budget) {
+                    return true;
+                }
+
+                for (const auto type : types) {
+                    if (!m_id_set_compressed(type) && !m_id_sets(type)->empty()) {
+                        compress_id_set(type);
+                    }
+                }
+
+                while (used_memory() > m_memory_budget) {
+                    const osmium::item_type* largest = nullptr;
+                    for (const auto& type : types) {
+                        if (!m_map_switched(type) && m_maps(type)->size() > 0 &&
+                            (!largest || m_maps(type)->used_memory() > m_maps(*largest)->used_memory())) {
+                            largest = &type;
+                        }
+                    }
+                    if (!largest) {
+                        return false;
+                    }
+                    switch_map(*largest);
+                }
+
+                return true;
+            }
+
+        }; // class NWRIndexBundle
+
+        template <typename TValue>
+        constexpr osmium::item_type NWRIndexBundle<TValue>::types[3];
+
+    } // namespace index
+
+} // namespace osmium
+
+#endif // OSMIUM_INDEX_NWR_INDEX_BUNDLE_HPP
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/types.hpp>
@@ -66,6 +67,11 @@ namespace osmium {
                     TKeyInternal key;
                     TValueInternal value;
 
+                    kv_pair() noexcept :
+                        key(),
+                        value() {
+                    }
+
                     explicit kv_pair(const key_type key_id) :
                         key(static_cast<TKeyInternal>(key_id)),
                         value() {
@@ -104,17 +110,24 @@ namespace osmium {
 
                 flat_map<TValue, TValueInternal, TKey, TKeyInternal> flip_copy() {
                     flat_map<TValue, TValueInternal, TKey, TKeyInternal> map;
-                    map.reserve(m_map.size());
-
-                    for (const auto& p : m_map) {
-                        map.set(p.value, p.key);
-                    }
+                    map.resize(m_map.size());
+
+                    // Large maps are flipped in shards, one per thread.
+                    const std::size_t size = m_map.size();
+                    const int num_threads = osmium::index::detail::parallel_work_threads(size);
+                    osmium::index::detail::run_in_threads(num_threads, [&](const int n) {
+                        const auto end = size * static_cast<std::size_t>(n + 1) / static_cast<std::size_t>(num_threads);
+                        for (auto i = size * static_cast<std::size_t>(n) / static_cast<std::size_t>(num_threads); i < end; ++i) {
+                            map.m_map[i].key = m_map[i].value;
+                            map.m_map[i].value = m_map[i].key;
+                        }
+                    });
 
                     return map;
                 }
 
                 void sort_unique() {
-                    std::sort(m_map.begin(), m_map.end());
+                    sort(std::integral_constant<bool, (sizeof(TKeyInternal) + sizeof(TValueInternal) <= sizeof(uint64_t))>{});
                     const auto last = std::unique(m_map.begin(), m_map.end());
                     m_map.erase(last, m_map.end());
                 }
@@ -133,10 +146,40 @@ namespace osmium {
                     return m_map.size();
                 }
 
+                template <typename TFunc>
+                void for_each_key(TFunc&& func) const {
+                    for (const auto& p : m_map) {
+                        func(static_cast<key_type>(p.key));
+                    }
+                }
+
                 void reserve(const std::size_t size) {
                     m_map.reserve(size);
                 }
 
+                void resize(const std::size_t size) {
+                    m_map.resize(size);
+                }
+
+            private:
+
+                template <typename, typename, typename, typename>
+                friend class flat_map;
+
+                // If key and value fit into 64 bits together (they do for
+                // the 32 bit internal ids used in the relations maps), the
+                // pairs are sorted with a parallel radix sort on the combined
+                // key.
+                void sort(std::true_type /*packed*/) {
+                    osmium::index::detail::radix_sort(m_map, [](const kv_pair& p) noexcept {
+                        return (static_cast<uint64_t>(p.key) << (sizeof(TValueInternal) * 8U)) | static_cast<uint64_t>(p.value);
+                    });
+                }
+
+                void sort(std::false_type /*packed*/) {
+                    std::sort(m_map.begin(), m_map.end());
+                }
+
             }; // class flat_map
 
         } // namespace detail
@@ -373,6 +416,17 @@ namespace osmium {
                 return m_map.size();
             }
 
+            /**
+             * Call the function with the member id of each entry in the
+             * stash. The ids are in the order they were added and can
+             * contain duplicates.
+             */
+            template <typename TFunc>
+            void for_each_member(TFunc&& func) const {
+                assert(m_valid && "You can't use the RelationsMap any more after calling build_index()");
+                m_map.for_each_key(std::forward<TFunc>(func));
+            }
+
             /**
              * Build an index for member to parent lookups from the contents
              * of this stash and return it.
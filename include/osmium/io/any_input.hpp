@@ -47,6 +47,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/o5m_input.hpp> // IWYU pragma: export
 #include <osmium/io/opl_input.hpp> // IWYU pragma: export
+#include <osmium/io/osmbuf_input.hpp> // IWYU pragma: export
 #include <osmium/io/pbf_input.hpp> // IWYU pragma: export
 #include <osmium/io/xml_input.hpp> // IWYU pragma: export
 
@@ -0,0 +1,377 @@
+#ifndef OSMIUM_IO_APPLY_CHANGES_HPP
+#define OSMIUM_IO_APPLY_CHANGES_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_input_format.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/merge_reader.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/reader_options.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <protozero/data_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Statistics returned by osmium::io::apply_changes().
+         */
+        struct apply_changes_statistics {
+
+            /// Number of blobs copied from the base file without decoding.
+            std::size_t blobs_copied = 0;
+
+            /// Number of blobs from the base file which had to be decoded.
+            std::size_t blobs_decoded = 0;
+
+            /// Number of objects created or modified by the changes.
+            std::size_t objects_changed = 0;
+
+            /// Number of objects deleted by the changes.
+            std::size_t objects_deleted = 0;
+
+        }; // struct apply_changes_statistics
+
+        namespace detail {
+
+            /**
+             * Merges the objects from a base file with the latest versions
+             * of the objects from the change files and writes the result.
+             */
+            class change_applier {
+
+                enum : std::size_t {
+                    output_buffer_size = 1024UL * 1024UL
+                };
+
+                osmium::io::MergeReader m_changes;
+                osmium::memory::Buffer m_change_buffer{};
+                std::vector<merge_key> m_change_keys{};
+                std::vector<const osmium::OSMObject*> m_change_objects{};
+                std::size_t m_change_pos = 0;
+
+                osmium::io::Writer& m_writer;
+                osmium::memory::Buffer m_output{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+
+                apply_changes_statistics m_statistics{};
+
+                // Does key a belong to an object sorted before the object of
+                // key b? The version is not taken into account.
+                static bool object_less(const merge_key& a, const merge_key& b) noexcept {
+                    if (a.type_sign != b.type_sign) {
+                        return a.type_sign < b.type_sign;
+                    }
+                    return a.id < b.id;
+                }
+
+                void next_change_buffer() {
+                    m_change_keys.clear();
+                    m_change_objects.clear();
+                    m_change_pos = 0;
+                    while ((m_change_buffer = m_changes.read())) {
+                        for (const auto& object : m_change_buffer.select<osmium::OSMObject>()) {
+                            m_change_keys.emplace_back(object);
+                            m_change_objects.push_back(&object);
+                        }
+                        if (!m_change_keys.empty()) {
+                            return;
+                        }
+                    }
+                }
+
+                bool has_change() const noexcept {
+                    return m_change_pos < m_change_keys.size();
+                }
+
+                void next_change() {
+                    ++m_change_pos;
+                    if (m_change_pos == m_change_keys.size()) {
+                        next_change_buffer();
+                    }
+                }
+
+                void add(const osmium::OSMObject& object) {
+                    m_output.add_item(object);
+                    m_output.commit();
+                    if (m_output.committed() >= output_buffer_size - output_buffer_size / 8) {
+                        flush_output();
+                    }
+                }
+
+                void add_change() {
+                    const auto& object = *m_change_objects[m_change_pos];
+                    if (object.visible()) {
+                        add(object);
+                        ++m_statistics.objects_changed;
+                    } else {
+                        ++m_statistics.objects_deleted;
+                    }
+                    next_change();
+                }
+
+                void add_changes_before(const merge_key& key) {
+                    while (has_change() && object_less(m_change_keys[m_change_pos], key)) {
+                        add_change();
+                    }
+                }
+
+                void flush_output() {
+                    if (m_output.committed() > 0) {
+                        m_writer(std::move(m_output));
+                        m_output = osmium::memory::Buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                    }
+                }
+
+                // Is there no change for any object in the blob? The changes
+                // for objects before the blob are written out first. Only
+                // blobs with objects of one type and positive ids are
+                // checked, because only then the first and last key of the
+                // objects in the blob are known from the index entry.
+                bool untouched(const PBFBlobIndex::entry& entry) {
+                    osmium::item_type type = osmium::item_type::undefined;
+                    switch (entry.types) {
+                        case osmium::osm_entity_bits::node:
+                            type = osmium::item_type::node;
+                            break;
+                        case osmium::osm_entity_bits::way:
+                            type = osmium::item_type::way;
+                            break;
+                        case osmium::osm_entity_bits::relation:
+                            type = osmium::item_type::relation;
+                            break;
+                        default:
+                            return false;
+                    }
+                    if (entry.min_id <= 0) {
+                        return false;
+                    }
+
+                    merge_key first;
+                    first.type_sign = (static_cast<uint64_t>(type) << 1U) | 1U;
+                    first.id = static_cast<uint64_t>(entry.min_id);
+                    add_changes_before(first);
+
+                    return !has_change() ||
+                           m_change_keys[m_change_pos].type_sign != first.type_sign ||
+                           m_change_keys[m_change_pos].id > static_cast<uint64_t>(entry.max_id);
+                }
+
+                void decode_blob(const protozero::data_view& blob) {
+                    PBFDataBlobDecoder decoder{std::string{blob.data(), blob.size()}, osmium::osm_entity_bits::all, osmium::io::read_meta::yes};
+                    auto buffer = decoder();
+                    while (buffer.has_nested_buffers()) {
+                        merge_buffer(*buffer.get_last_nested());
+                    }
+                    merge_buffer(buffer);
+                    ++m_statistics.blobs_decoded;
+                }
+
+            public:
+
+                change_applier(const std::vector<osmium::io::File>& changes, osmium::io::Writer& writer) :
+                    m_changes(changes, merge_duplicates::latest_version),
+                    m_writer(writer) {
+                    next_change_buffer();
+                }
+
+                /**
+                 * Write all objects from the base buffer merged with the
+                 * changes for them and for all objects before them.
+                 */
+                void merge_buffer(const osmium::memory::Buffer& buffer) {
+                    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                        const merge_key key{object};
+                        add_changes_before(key);
+                        if (has_change() && m_change_keys[m_change_pos].same_object(key)) {
+                            // A change older than the object in the base
+                            // file is ignored.
+                            if (!(m_change_keys[m_change_pos] < key)) {
+                                add_change();
+                                continue;
+                            }
+                            next_change();
+                        }
+                        add(object);
+                    }
+                }
+
+                /**
+                 * Write all blobs from the PBF data merged with the changes.
+                 * Blobs without changes are copied without decoding them
+                 * if the index has an entry for them and the writer
+                 * supports it.
+                 */
+                void merge_pbf(const char* data, std::size_t size, const PBFBlobIndex& index) {
+                    auto entry = index.begin();
+                    for_each_pbf_blob(data, size, [&](std::size_t offset, std::size_t blob_size, const protozero::data_view& blob) {
+                        if (offset == 0) {
+                            return; // OSMHeader blob
+                        }
+                        while (entry != index.end() && entry->offset < offset) {
+                            ++entry;
+                        }
+                        if (entry != index.end() && entry->offset == offset && entry->size == blob_size && untouched(*entry)) {
+                            flush_output();
+                            if (m_writer.write_raw(std::string{data + offset, blob_size}, osmium::io::file_format::pbf)) {
+                                ++m_statistics.blobs_copied;
+                                return;
+                            }
+                        }
+                        decode_blob(blob);
+                    });
+                }
+
+                /**
+                 * Write all remaining changes and close the change files.
+                 */
+                apply_changes_statistics finish() {
+                    while (has_change()) {
+                        add_change();
+                    }
+                    flush_output();
+                    m_changes.close();
+                    return m_statistics;
+                }
+
+            }; // class change_applier
+
+        } // namespace detail
+
+        /**
+         * Apply one or more change files to a base file and write the
+         * result to a Writer. The base file and each change file must be
+         * sorted by type, id, and version (see
+         * osmium::object_order_type_id_version). The base file must not
+         * contain more than one version of an object.
+         *
+         * The inputs are merged in one pass. For each object only the
+         * latest version is kept, if it is the same in several inputs the
+         * one from the last change file wins. Objects whose latest version
+         * is deleted are removed. Objects without changes are written as
+         * they are. Any items in the inputs which are not OSM objects are
+         * ignored.
+         *
+         * The Writer is not closed and its header is not changed, open
+         * it with the header of the base file (maybe with an updated
+         * timestamp) before calling this function.
+         *
+         * @param base The base file.
+         * @param changes The change files.
+         * @param writer The writer for the result.
+         * @returns Statistics.
+         * @throws Any exception the Reader or Writer throw.
+         */
+        inline apply_changes_statistics apply_changes(const osmium::io::File& base, const std::vector<osmium::io::File>& changes, osmium::io::Writer& writer) {
+            detail::change_applier applier{changes, writer};
+
+            osmium::io::Reader reader{base};
+            while (osmium::memory::Buffer buffer = reader.read()) {
+                applier.merge_buffer(buffer);
+            }
+            reader.close();
+
+            return applier.finish();
+        }
+
+        /**
+         * Apply one or more change files to a base PBF file with a blob
+         * index and write the result to a Writer. See the version without
+         * index for details.
+         *
+         * Blobs from the base file which only contain objects of one type
+         * and an ID range without any changes are copied into the output
+         * without decoding them. Usually this is most of the file, which
+         * makes this much faster than decoding and encoding everything.
+         * The copied blobs keep their compression and metadata, so the
+         * output should be written with the same options as the base
+         * file. Blobs are only copied if the Writer supports it (see
+         * osmium::io::Writer::write_raw()), all other blobs are decoded.
+         *
+         * The index should be the one written as sidecar file together
+         * with the base file (see the "pbf_index_sidecar" output option)
+         * or be built once with PBFBlobIndex::build(). If the base file
+         * isn't an uncompressed PBF file on disk, the index is not used.
+         *
+         * @param base The base file.
+         * @param index The blob index of the base file.
+         * @param changes The change files.
+         * @param writer The writer for the result.
+         * @returns Statistics.
+         * @throws osmium::pbf_error If the base file is not a valid PBF file.
+         * @throws Any exception the Reader or Writer throw.
+         */
+        inline apply_changes_statistics apply_changes(const osmium::io::File& base, const PBFBlobIndex& index, const std::vector<osmium::io::File>& changes, osmium::io::Writer& writer) {
+            if (base.format() != osmium::io::file_format::pbf ||
+                base.compression() != osmium::io::file_compression::none ||
+                base.filename().empty() || base.filename() == "-" || base.buffer()) {
+                return apply_changes(base, changes, writer);
+            }
+
+            detail::change_applier applier{changes, writer};
+
+            const auto file_size = osmium::file_size(base.filename());
+            if (file_size > 0) {
+                const int fd = osmium::io::detail::open_for_reading(base.filename());
+                const osmium::util::MemoryMapping mapping{file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                osmium::io::detail::reliable_close(fd);
+                applier.merge_pbf(mapping.get_addr<const char>(), file_size, index);
+            }
+
+            return applier.finish();
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_APPLY_CHANGES_HPP
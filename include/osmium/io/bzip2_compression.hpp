@@ -43,10 +43,13 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compressor.hpp>
+#include <osmium/io/detail/parallel_decompressor.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/compatibility.hpp>
 #include <osmium/util/file.hpp>
 
@@ -56,6 +59,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cerrno>
 #include <cstdio>
 #include <limits>
+#include <memory>
 #include <string>
 #include <system_error>
 
@@ -154,6 +158,27 @@ namespace osmium {
 
             }; // class file_wrapper
 
+            /**
+             * Compress the input into one complete bzip2 stream.
+             */
+            inline std::string bzip2_compress_stream(const std::string& input) {
+                // bzlib documentation: 1% larger than the input plus 600 bytes
+                unsigned int size = static_cast<unsigned int>(input.size() + input.size() / 100 + 600);
+                std::string output(size, '\0');
+
+                const int result = ::BZ2_bzBuffToBuffCompress(&*output.begin(),
+                                                               &size,
+                                                               const_cast<char*>(input.data()),
+                                                               static_cast<unsigned int>(input.size()),
+                                                               6, 0, 0);
+                if (result != BZ_OK) {
+                    throw bzip2_error{"bzip2 error: compression failed", result};
+                }
+
+                output.resize(size);
+                return output;
+            }
+
         } // namespace detail
 
         class Bzip2Compressor : public Compressor {
@@ -223,6 +248,25 @@ namespace osmium {
 
         }; // class Bzip2Compressor
 
+        /**
+         * Bzip2 compressor compressing chunks of the data in the thread
+         * pool. The result is a multi-stream bzip2 file.
+         */
+        class ParallelBzip2Compressor final : public detail::ParallelCompressor {
+
+        public:
+
+            enum : std::size_t {
+                // one bzip2 block with the block size used (6 * 100k)
+                chunk_size = 600ul * 1000ul
+            };
+
+            ParallelBzip2Compressor(const int fd, const fsync sync, osmium::thread::Pool& pool) :
+                ParallelCompressor(fd, sync, pool, chunk_size, detail::bzip2_compress_stream) {
+            }
+
+        }; // class ParallelBzip2Compressor
+
         class Bzip2Decompressor : public Decompressor {
 
             detail::file_wrapper m_file;
@@ -319,6 +363,124 @@ namespace osmium {
 
         }; // class Bzip2Decompressor
 
+        namespace detail {
+
+            /**
+             * Does the data look like the start of a bzip2 stream? Checks
+             * the stream header and the magic number of the first block
+             * (or of the end of stream marker for empty streams).
+             */
+            inline bool is_bzip2_stream_start(const char* data, const std::size_t size) noexcept {
+                if (size < 10) {
+                    return false;
+                }
+                if (data[0] != 'B' || data[1] != 'Z' || data[2] != 'h' || data[3] < '1' || data[3] > '9') {
+                    return false;
+                }
+                const auto* d = reinterpret_cast<const unsigned char*>(data + 4);
+                return (d[0] == 0x31 && d[1] == 0x41 && d[2] == 0x59 && d[3] == 0x26 && d[4] == 0x53 && d[5] == 0x59) ||
+                       (d[0] == 0x17 && d[1] == 0x72 && d[2] == 0x45 && d[3] == 0x38 && d[4] == 0x50 && d[5] == 0x90);
+            }
+
+            class bzip2_stream_decoder : public stream_decoder {
+
+                enum : std::size_t {
+                    output_chunk_size = 1024ul * 1024ul
+                };
+
+                bz_stream m_stream;
+                bool m_initialized = false;
+
+                void init() {
+                    const int result = ::BZ2_bzDecompressInit(&m_stream, 0, 0);
+                    if (result != BZ_OK) {
+                        throw bzip2_error{"bzip2 error: decompression init failed", result};
+                    }
+                    m_initialized = true;
+                }
+
+                void end() noexcept {
+                    if (m_initialized) {
+                        ::BZ2_bzDecompressEnd(&m_stream);
+                        m_initialized = false;
+                    }
+                }
+
+            public:
+
+                bzip2_stream_decoder() :
+                    m_stream() {
+                    init();
+                }
+
+                ~bzip2_stream_decoder() noexcept final {
+                    end();
+                }
+
+                bool decode(const char* data, const std::size_t size, std::string& output) final {
+                    assert(size < std::numeric_limits<unsigned int>::max());
+                    m_stream.next_in = const_cast<char*>(data);
+                    m_stream.avail_in = static_cast<unsigned int>(size);
+
+                    while (true) {
+                        const auto old_size = output.size();
+                        output.resize(old_size + output_chunk_size);
+                        m_stream.next_out = &output[old_size];
+                        m_stream.avail_out = static_cast<unsigned int>(output_chunk_size);
+
+                        const int result = ::BZ2_bzDecompress(&m_stream);
+                        const bool output_full = m_stream.avail_out == 0;
+                        output.resize(old_size + output_chunk_size - m_stream.avail_out);
+
+                        if (result == BZ_STREAM_END) {
+                            char* next_in = m_stream.next_in;
+                            const auto avail_in = m_stream.avail_in;
+                            end();
+                            m_stream = bz_stream();
+                            init();
+                            if (avail_in == 0) {
+                                return true;
+                            }
+                            m_stream.next_in = next_in;
+                            m_stream.avail_in = avail_in;
+                        } else if (result == BZ_OK) {
+                            if (m_stream.avail_in == 0 && !output_full) {
+                                return false;
+                            }
+                        } else {
+                            throw bzip2_error{"bzip2 error: decompression failed", result};
+                        }
+                    }
+                }
+
+                void end_of_input() final {
+                    throw bzip2_error{"bzip2 error: unexpected end of file", BZ_UNEXPECTED_EOF};
+                }
+
+            }; // class bzip2_stream_decoder
+
+        } // namespace detail
+
+        /**
+         * Bzip2 decompressor decompressing the streams of a multi-stream
+         * bzip2 file in the thread pool.
+         */
+        class ParallelBzip2Decompressor final : public detail::ParallelDecompressor {
+
+        public:
+
+            enum : std::size_t {
+                segment_size = 1024ul * 1024ul
+            };
+
+            ParallelBzip2Decompressor(const int fd, osmium::thread::Pool& pool) :
+                ParallelDecompressor(fd, pool, segment_size, 'B', detail::is_bzip2_stream_start, []() {
+                    return std::unique_ptr<detail::stream_decoder>{new detail::bzip2_stream_decoder{}};
+                }) {
+            }
+
+        }; // class ParallelBzip2Decompressor
+
         class Bzip2BufferDecompressor : public Decompressor {
 
             const char* m_buffer;
@@ -395,9 +557,17 @@ namespace osmium {
                 [](const char* buffer, const std::size_t size) { return new osmium::io::Bzip2BufferDecompressor{buffer, size}; }
             );
 
+            const bool registered_parallel_bzip2_compression = osmium::io::CompressionFactory::instance().register_parallel_compressor(osmium::io::file_compression::bzip2,
+                [](const int fd, const fsync sync, osmium::thread::Pool& pool) { return new osmium::io::ParallelBzip2Compressor{fd, sync, pool}; }
+            );
+
+            const bool registered_parallel_bzip2_decompression = osmium::io::CompressionFactory::instance().register_parallel_decompressor(osmium::io::file_compression::bzip2,
+                [](const int fd, osmium::thread::Pool& pool) { return new osmium::io::ParallelBzip2Decompressor{fd, pool}; }
+            );
+
             // dummy function to silence the unused variable warning from above
             inline bool get_registered_bzip2_compression() noexcept {
-                return registered_bzip2_compression;
+                return registered_bzip2_compression && registered_parallel_bzip2_compression && registered_parallel_bzip2_decompression;
             }
 
         } // namespace detail
@@ -37,6 +37,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/file.hpp>
 
 #include <atomic>
@@ -49,9 +50,14 @@ DEALINGS IN THE SOFTWARE.
 #include <system_error>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
+    namespace thread {
+        class Pool;
+    } // namespace thread
+
     namespace io {
 
         class Compressor {
@@ -80,6 +86,17 @@ namespace osmium {
 
             virtual void write(const std::string& data) = 0;
 
+            /**
+             * Write several strings in order. Compressors can override
+             * this to write the data more efficiently than with one
+             * write() call per string.
+             */
+            virtual void write_all(const std::vector<std::string>& data) {
+                for (const auto& str : data) {
+                    write(str);
+                }
+            }
+
             virtual void close() = 0;
 
         }; // class Compressor
@@ -133,6 +150,9 @@ namespace osmium {
          *
          * For each algorithm we store two functions that construct
          * a compressor and decompressor object, respectively.
+         *
+         * Algorithms can also register a compressor that compresses
+         * the data in a thread pool.
          */
         class CompressionFactory {
 
@@ -141,6 +161,8 @@ namespace osmium {
             using create_compressor_type          = std::function<osmium::io::Compressor*(int, fsync)>;
             using create_decompressor_type_fd     = std::function<osmium::io::Decompressor*(int)>;
             using create_decompressor_type_buffer = std::function<osmium::io::Decompressor*(const char*, std::size_t)>;
+            using create_parallel_compressor_type = std::function<osmium::io::Compressor*(int, fsync, osmium::thread::Pool&)>;
+            using create_parallel_decompressor_type = std::function<osmium::io::Decompressor*(int, osmium::thread::Pool&)>;
 
         private:
 
@@ -152,6 +174,10 @@ namespace osmium {
 
             compression_map_type m_callbacks;
 
+            std::map<const osmium::io::file_compression, create_parallel_compressor_type> m_parallel_callbacks;
+
+            std::map<const osmium::io::file_compression, create_parallel_decompressor_type> m_parallel_decompressor_callbacks;
+
             CompressionFactory() = default;
 
             const callbacks_type& find_callbacks(const osmium::io::file_compression compression) const {
@@ -202,6 +228,26 @@ namespace osmium {
                 return std::unique_ptr<osmium::io::Compressor>(std::get<0>(callbacks)(std::forward<TArgs>(args)...));
             }
 
+            bool register_parallel_compressor(
+                osmium::io::file_compression compression,
+                create_parallel_compressor_type create_parallel_compressor) {
+
+                return m_parallel_callbacks.emplace(compression, create_parallel_compressor).second;
+            }
+
+            /**
+             * Create a compressor that compresses the data in the given
+             * thread pool. If there is no such compressor for this
+             * compression type, the normal compressor is returned.
+             */
+            std::unique_ptr<osmium::io::Compressor> create_parallel_compressor(const osmium::io::file_compression compression, const int fd, const fsync sync, osmium::thread::Pool& pool) const {
+                const auto it = m_parallel_callbacks.find(compression);
+                if (it == m_parallel_callbacks.end()) {
+                    return create_compressor(compression, fd, sync);
+                }
+                return std::unique_ptr<osmium::io::Compressor>(it->second(fd, sync, pool));
+            }
+
             std::unique_ptr<osmium::io::Decompressor> create_decompressor(const osmium::io::file_compression compression, const int fd) const {
                 const auto callbacks = find_callbacks(compression);
                 auto p = std::unique_ptr<osmium::io::Decompressor>(std::get<1>(callbacks)(fd));
@@ -214,6 +260,28 @@ namespace osmium {
                 return std::unique_ptr<osmium::io::Decompressor>(std::get<2>(callbacks)(buffer, size));
             }
 
+            bool register_parallel_decompressor(
+                osmium::io::file_compression compression,
+                create_parallel_decompressor_type create_parallel_decompressor) {
+
+                return m_parallel_decompressor_callbacks.emplace(compression, create_parallel_decompressor).second;
+            }
+
+            /**
+             * Create a decompressor that decompresses the data in the given
+             * thread pool. If there is no such decompressor for this
+             * compression type, the normal decompressor is returned.
+             */
+            std::unique_ptr<osmium::io::Decompressor> create_parallel_decompressor(const osmium::io::file_compression compression, const int fd, osmium::thread::Pool& pool) const {
+                const auto it = m_parallel_decompressor_callbacks.find(compression);
+                if (it == m_parallel_decompressor_callbacks.end()) {
+                    return create_decompressor(compression, fd);
+                }
+                auto p = std::unique_ptr<osmium::io::Decompressor>(it->second(fd, pool));
+                p->set_file_size(osmium::file_size(fd));
+                return p;
+            }
+
         }; // class CompressionFactory
 
         class NoCompressor : public Compressor {
@@ -245,6 +313,10 @@ namespace osmium {
                 osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
             }
 
+            void write_all(const std::vector<std::string>& data) final {
+                osmium::io::detail::reliable_writev(m_fd, data);
+            }
+
             void close() final {
                 if (m_fd >= 0) {
                     const int fd = m_fd;
@@ -264,11 +336,14 @@ namespace osmium {
             const char* m_buffer = nullptr;
             std::size_t m_buffer_size = 0;
             std::size_t m_offset = 0;
+            std::size_t m_read_size = osmium::config::get_read_size();
+            detail::read_advisor m_advisor{};
 
         public:
 
             explicit NoDecompressor(const int fd) :
-                m_fd(fd) {
+                m_fd(fd),
+                m_advisor(fd) {
             }
 
             NoDecompressor(const char* buffer, const std::size_t size) :
@@ -300,19 +375,21 @@ namespace osmium {
                         buffer.append(m_buffer, size);
                     }
                 } else {
-                    buffer.resize(osmium::io::Decompressor::input_buffer_size);
-                    const auto nread = detail::reliable_read(m_fd, &*buffer.begin(), osmium::io::Decompressor::input_buffer_size);
+                    buffer.resize(m_read_size);
+                    const auto nread = detail::reliable_read(m_fd, &*buffer.begin(), static_cast<unsigned int>(m_read_size));
                     buffer.resize(std::string::size_type(nread));
                 }
 
                 m_offset += buffer.size();
                 set_offset(m_offset);
+                m_advisor.update(m_offset);
 
                 return buffer;
             }
 
             void close() final {
                 if (m_fd >= 0) {
+                    m_advisor.finish();
                     const int fd = m_fd;
                     m_fd = -1;
                     osmium::io::detail::reliable_close(fd);
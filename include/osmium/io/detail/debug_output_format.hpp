@@ -61,6 +61,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/visitor.hpp>
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <iterator>
 #include <memory>
@@ -103,10 +105,14 @@ namespace osmium {
                 /// Write in form of a diff file?
                 bool format_as_diff = false;
 
+                /// Write each object on a single line without colors?
+                bool compact = false;
+
             }; // struct debug_output_options
 
             /**
-             * Writes out one buffer with OSM data in Debug format.
+             * Writes out one buffer with OSM data in Debug format. Each
+             * buffer is encoded in the thread pool.
              */
             class DebugOutputBlock : public OutputBlock {
 
@@ -123,9 +129,33 @@ namespace osmium {
                     append_debug_encoded_string(*m_out, data, m_utf8_prefix, m_utf8_suffix);
                 }
 
-                template <typename... TArgs>
-                void output_formatted(const char* format, TArgs&&... args) {
-                    append_printf_formatted_string(*m_out, format, std::forward<TArgs>(args)...);
+                // Write integer right-aligned in a field of the given width
+                // filled with the fill character.
+                void output_padded_int(int64_t value, int width, char fill) {
+                    const auto pos = m_out->size();
+                    output_int(value);
+                    const auto len = static_cast<int>(m_out->size() - pos);
+                    if (len < width) {
+                        m_out->insert(pos, static_cast<std::size_t>(width - len), fill);
+                    }
+                }
+
+                void output_hex(uint32_t value) {
+                    static const char* lookup_hex = "0123456789abcdef";
+                    char temp[8];
+                    char* const end = temp + sizeof(temp);
+                    char* t = end;
+                    do {
+                        *--t = lookup_hex[value & 0xfu];
+                        value >>= 4u;
+                    } while (value > 0);
+                    m_out->append(t, end);
+                }
+
+                void output_location(const osmium::Location& location) {
+                    char temp[32];
+                    char* const end = location.as_string_without_check(temp);
+                    m_out->append(temp, end);
                 }
 
                 void write_color(const char* color) {
@@ -197,12 +227,9 @@ namespace osmium {
 
                 void write_counter(int width, int n) {
                     write_color(color_white);
-#pragma GCC diagnostic push
-#if !defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 7)
-#pragma GCC diagnostic ignored "-Wformat-truncation"
-#endif
-                    output_formatted("    %0*d: ", width, n++);
-#pragma GCC diagnostic pop
+                    *m_out += "    ";
+                    output_padded_int(n, width, '0');
+                    *m_out += ": ";
                     write_color(color_reset);
                 }
 
@@ -292,7 +319,7 @@ namespace osmium {
                 void write_location(const osmium::Location& location) {
                     write_fieldname("lon/lat");
                     *m_out += "  ";
-                    location.as_string_without_check(std::back_inserter(*m_out));
+                    output_location(location);
                     if (!location.valid()) {
                         write_error(" INVALID LOCATION!");
                     }
@@ -308,9 +335,9 @@ namespace osmium {
                     }
                     const auto& bl = box.bottom_left();
                     const auto& tr = box.top_right();
-                    bl.as_string_without_check(std::back_inserter(*m_out));
+                    output_location(bl);
                     *m_out += ' ';
-                    tr.as_string_without_check(std::back_inserter(*m_out));
+                    output_location(tr);
                     if (!box.valid()) {
                         write_error(" INVALID BOX!");
                     }
@@ -322,27 +349,197 @@ namespace osmium {
                     write_fieldname("crc32");
                     osmium::CRC<crc_type> crc32;
                     crc32.update(object);
-                    output_formatted("    %x\n", crc32().checksum());
+                    *m_out += "    ";
+                    output_hex(static_cast<uint32_t>(crc32().checksum()));
+                    *m_out += '\n';
                 }
 
                 void write_crc32(const osmium::Changeset& object) {
                     write_fieldname("crc32");
                     osmium::CRC<crc_type> crc32;
                     crc32.update(object);
-                    output_formatted("      %x\n", crc32().checksum());
+                    *m_out += "      ";
+                    output_hex(static_cast<uint32_t>(crc32().checksum()));
+                    *m_out += '\n';
+                }
+
+                // The compact format writes each object on a single line
+                // with "name=value" fields separated by spaces. It never
+                // uses colors.
+
+                void write_compact_string(const char* string) {
+                    *m_out += '"';
+                    append_encoded_string(string);
+                    *m_out += '"';
+                }
+
+                void write_compact_meta(const char* object_type, const osmium::OSMObject& object) {
+                    if (m_diff_char) {
+                        *m_out += m_diff_char;
+                    }
+                    *m_out += object_type;
+                    *m_out += ' ';
+                    output_int(object.id());
+                    *m_out += object.visible() ? " visible" : " deleted";
+                    if (m_options.add_metadata.version()) {
+                        *m_out += " version=";
+                        output_int(object.version());
+                    }
+                    if (m_options.add_metadata.changeset()) {
+                        *m_out += " changeset=";
+                        output_int(object.changeset());
+                    }
+                    if (m_options.add_metadata.timestamp()) {
+                        *m_out += " timestamp=";
+                        *m_out += object.timestamp().to_iso();
+                    }
+                    if (m_options.add_metadata.uid()) {
+                        *m_out += " uid=";
+                        output_int(object.uid());
+                    }
+                    if (m_options.add_metadata.user()) {
+                        *m_out += " user=";
+                        write_compact_string(object.user());
+                    }
+                }
+
+                void write_compact_tags(const osmium::TagList& tags) {
+                    if (tags.empty()) {
+                        return;
+                    }
+                    *m_out += " tags={";
+                    bool first = true;
+                    for (const auto& tag : tags) {
+                        if (!first) {
+                            *m_out += ' ';
+                        }
+                        first = false;
+                        write_compact_string(tag.key());
+                        *m_out += '=';
+                        write_compact_string(tag.value());
+                    }
+                    *m_out += '}';
+                }
+
+                template <typename T>
+                void write_compact_end(const T& object) {
+                    if (m_options.add_crc32) {
+                        *m_out += " crc32=";
+                        osmium::CRC<crc_type> crc32;
+                        crc32.update(object);
+                        output_hex(static_cast<uint32_t>(crc32().checksum()));
+                    }
+                    *m_out += '\n';
+                }
+
+                void compact_node(const osmium::Node& node) {
+                    write_compact_meta("node", node);
+                    if (node.visible()) {
+                        *m_out += " lon/lat=";
+                        output_location(node.location());
+                    }
+                    write_compact_tags(node.tags());
+                    write_compact_end(node);
+                }
+
+                void compact_way(const osmium::Way& way) {
+                    write_compact_meta("way", way);
+                    write_compact_tags(way.tags());
+                    *m_out += " nodes=[";
+                    bool first = true;
+                    for (const auto& node_ref : way.nodes()) {
+                        if (!first) {
+                            *m_out += ' ';
+                        }
+                        first = false;
+                        output_int(node_ref.ref());
+                        if (node_ref.location().valid()) {
+                            *m_out += '(';
+                            output_location(node_ref.location());
+                            *m_out += ')';
+                        }
+                    }
+                    *m_out += ']';
+                    write_compact_end(way);
+                }
+
+                void compact_relation(const osmium::Relation& relation) {
+                    write_compact_meta("relation", relation);
+                    write_compact_tags(relation.tags());
+                    *m_out += " members=[";
+                    bool first = true;
+                    for (const auto& member : relation.members()) {
+                        if (!first) {
+                            *m_out += ' ';
+                        }
+                        first = false;
+                        *m_out += osmium::item_type_to_char(member.type());
+                        output_int(member.ref());
+                        *m_out += '@';
+                        write_compact_string(member.role());
+                    }
+                    *m_out += ']';
+                    write_compact_end(relation);
+                }
+
+                void compact_changeset(const osmium::Changeset& changeset) {
+                    *m_out += "changeset ";
+                    output_int(changeset.id());
+                    *m_out += " num_changes=";
+                    output_int(changeset.num_changes());
+                    *m_out += " created_at=";
+                    *m_out += changeset.created_at().to_iso();
+                    *m_out += " closed_at=";
+                    *m_out += changeset.closed_at().to_iso();
+                    *m_out += " uid=";
+                    output_int(changeset.uid());
+                    *m_out += " user=";
+                    write_compact_string(changeset.user());
+                    const auto& box = changeset.bounds();
+                    if (box.valid()) {
+                        *m_out += " box=";
+                        output_location(box.bottom_left());
+                        *m_out += ' ';
+                        output_location(box.top_right());
+                    }
+                    write_compact_tags(changeset.tags());
+                    if (changeset.num_comments() > 0) {
+                        *m_out += " comments=[";
+                        bool first = true;
+                        for (const auto& comment : changeset.discussion()) {
+                            if (!first) {
+                                *m_out += ' ';
+                            }
+                            first = false;
+                            *m_out += "{date=";
+                            *m_out += comment.date().to_iso();
+                            *m_out += " uid=";
+                            output_int(comment.uid());
+                            *m_out += " user=";
+                            write_compact_string(comment.user());
+                            *m_out += " text=";
+                            write_compact_string(comment.text());
+                            *m_out += '}';
+                        }
+                        *m_out += ']';
+                    }
+                    write_compact_end(changeset);
                 }
 
             public:
 
-                DebugOutputBlock(osmium::memory::Buffer&& buffer, const debug_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                template <typename TInput>
+                DebugOutputBlock(TInput&& input, const debug_output_options& options) :
+                    OutputBlock(std::forward<TInput>(input)),
                     m_options(options),
                     m_utf8_prefix(options.use_color ? color_red  : ""),
                     m_utf8_suffix(options.use_color ? color_blue : "") {
                 }
 
                 std::string operator()() {
-                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    m_out->reserve(m_options.compact ? input_size() : input_size() * 3);
+
+                    apply_input(*this);
 
                     std::string out;
                     using std::swap;
@@ -354,6 +551,11 @@ namespace osmium {
                 void node(const osmium::Node& node) {
                     m_diff_char = m_options.format_as_diff ? node.diff_as_char() : '\0';
 
+                    if (m_options.compact) {
+                        compact_node(node);
+                        return;
+                    }
+
                     write_object_type("node", node.visible());
                     write_meta(node);
 
@@ -373,6 +575,11 @@ namespace osmium {
                 void way(const osmium::Way& way) {
                     m_diff_char = m_options.format_as_diff ? way.diff_as_char() : '\0';
 
+                    if (m_options.compact) {
+                        compact_way(way);
+                        return;
+                    }
+
                     write_object_type("way", way.visible());
                     write_meta(way);
                     write_tags(way.tags());
@@ -396,10 +603,10 @@ namespace osmium {
                     for (const auto& node_ref : way.nodes()) {
                         write_diff();
                         write_counter(width, n++);
-                        output_formatted("%10lld", static_cast<long long>(node_ref.ref())); // NOLINT(google-runtime-int)
+                        output_padded_int(node_ref.ref(), 10, ' ');
                         if (node_ref.location().valid()) {
                             *m_out += " (";
-                            node_ref.location().as_string(std::back_inserter(*m_out));
+                            output_location(node_ref.location());
                             *m_out += ')';
                         }
                         *m_out += '\n';
@@ -417,6 +624,11 @@ namespace osmium {
 
                     m_diff_char = m_options.format_as_diff ? relation.diff_as_char() : '\0';
 
+                    if (m_options.compact) {
+                        compact_relation(relation);
+                        return;
+                    }
+
                     write_object_type("relation", relation.visible());
                     write_meta(relation);
                     write_tags(relation.tags());
@@ -432,7 +644,9 @@ namespace osmium {
                         write_diff();
                         write_counter(width, n++);
                         *m_out += short_typename[item_type_to_nwr_index(member.type())];
-                        output_formatted(" %10lld ", static_cast<long long>(member.ref())); // NOLINT(google-runtime-int)
+                        *m_out += ' ';
+                        output_padded_int(member.ref(), 10, ' ');
+                        *m_out += ' ';
                         write_string(member.role());
                         *m_out += '\n';
                     }
@@ -445,6 +659,11 @@ namespace osmium {
                 }
 
                 void changeset(const osmium::Changeset& changeset) {
+                    if (m_options.compact) {
+                        compact_changeset(changeset);
+                        return;
+                    }
+
                     write_object_type("changeset");
                     output_int(changeset.id());
                     *m_out += '\n';
@@ -491,13 +710,14 @@ namespace osmium {
 
                             write_comment_field("date");
                             write_timestamp(comment.date());
-                            output_formatted("      %*s", width, "");
+                            m_out->append(6 + static_cast<std::size_t>(width), ' ');
 
                             write_comment_field("user");
                             output_int(comment.uid());
                             *m_out += ' ';
                             write_string(comment.user());
-                            output_formatted("\n      %*s", width, "");
+                            *m_out += '\n';
+                            m_out->append(6 + static_cast<std::size_t>(width), ' ');
 
                             write_comment_field("text");
                             write_string(comment.text());
@@ -538,10 +758,14 @@ namespace osmium {
                     m_options.use_color      = file.is_true("color");
                     m_options.add_crc32      = file.is_true("add_crc32");
                     m_options.format_as_diff = file.is_true("diff");
+                    m_options.compact        = file.is_true("compact");
+                    if (m_options.compact) {
+                        m_options.use_color = false;
+                    }
                 }
 
                 void write_header(const osmium::io::Header& header) final {
-                    if (m_options.format_as_diff) {
+                    if (m_options.format_as_diff || m_options.compact) {
                         return;
                     }
 
@@ -582,7 +806,11 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(buffer), m_options}, osmium::thread::task_priority::high));
+                }
+
+                void write_selection(osmium::memory::BufferSelection&& selection) final {
+                    m_output_queue.push(m_pool.submit(DebugOutputBlock{std::move(selection), m_options}, osmium::thread::task_priority::high));
                 }
 
             }; // class DebugOutputFormat
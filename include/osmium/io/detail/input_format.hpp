@@ -38,16 +38,28 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/reader_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/osm/changeset.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/object.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/util/memory_mapping.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <array>
+#include <condition_variable>
+#include <cstddef>
 #include <exception>
 #include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 namespace osmium {
@@ -63,8 +75,108 @@ namespace osmium {
                 std::promise<osmium::io::Header>& header_promise;
                 osmium::osm_entity_bits::type read_which_entities;
                 osmium::io::read_meta read_metadata;
+                osmium::metadata_options read_metadata_fields;
+                std::shared_ptr<osmium::util::MemoryMapping> mapped_input;
+                osmium::io::blob_selection read_blobs;
+                osmium::io::decode_window window;
+                osmium::io::tag_prefilter prefilter;
+                osmium::io::xml_tokenizer tokenizer;
+                osmium::io::read_buffers buffers;
+                osmium::io::buffer_transform transform;
+                osmium::io::PipelineStats* stats;
             };
 
+            /**
+             * Wraps a task creating a buffer in the thread pool and
+             * applies the buffer transform to the result.
+             */
+            template <typename TTask>
+            struct transform_task {
+
+                TTask task;
+                osmium::io::buffer_transform transform;
+
+                osmium::memory::Buffer operator()() {
+                    osmium::memory::Buffer buffer{task()};
+                    if (buffer) {
+                        transform(buffer);
+                    }
+                    return buffer;
+                }
+
+            }; // struct transform_task
+
+            /**
+             * Keeps track of the chunks of input (such as PBF blobs)
+             * submitted to the thread pool for decoding which haven't been
+             * decoded yet.
+             */
+            class DecodeWindow {
+
+                std::mutex m_mutex;
+                std::condition_variable m_done;
+                std::size_t m_max_chunks;
+                std::size_t m_max_bytes;
+                std::size_t m_chunks = 0;
+                std::size_t m_bytes = 0;
+
+            public:
+
+                DecodeWindow(std::size_t max_chunks, std::size_t max_bytes) noexcept :
+                    m_max_chunks(max_chunks),
+                    m_max_bytes(max_bytes) {
+                }
+
+                /**
+                 * Wait until there is space in the window for a chunk of the
+                 * given size and add it.
+                 */
+                void add(std::size_t bytes) {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_done.wait(lock, [this, bytes] {
+                        return m_chunks == 0 ||
+                               (m_chunks < m_max_chunks &&
+                                (m_max_bytes == 0 || m_bytes + bytes <= m_max_bytes));
+                    });
+                    ++m_chunks;
+                    m_bytes += bytes;
+                }
+
+                /// Remove a decoded chunk of the given size from the window.
+                void remove(std::size_t bytes) {
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        --m_chunks;
+                        m_bytes -= bytes;
+                    }
+                    m_done.notify_one();
+                }
+
+            }; // class DecodeWindow
+
+            /**
+             * Copy the items in the buffer accepted by the prefilter into a
+             * new buffer.
+             */
+            inline osmium::memory::Buffer apply_tag_prefilter(const osmium::io::tag_prefilter& prefilter, const osmium::memory::Buffer& buffer) {
+                osmium::memory::Buffer output{buffer.committed(), osmium::memory::Buffer::auto_grow::yes};
+                for (const auto& item : buffer) {
+                    bool accepted = true;
+                    if (prefilter.applies_to(item.type())) {
+                        if (item.type() == osmium::item_type::changeset) {
+                            accepted = prefilter.match_any_of(static_cast<const osmium::Changeset&>(item).tags());
+                        } else {
+                            accepted = prefilter.match_any_of(static_cast<const osmium::OSMObject&>(item).tags());
+                        }
+                    }
+                    if (accepted) {
+                        output.add_item(item);
+                        output.commit();
+                    }
+                }
+                return output;
+            }
+
             class Parser {
 
                 osmium::thread::Pool& m_pool;
@@ -73,7 +185,17 @@ namespace osmium {
                 queue_wrapper<std::string> m_input_queue;
                 osmium::osm_entity_bits::type m_read_which_entities;
                 osmium::io::read_meta m_read_metadata;
+                osmium::metadata_options m_read_metadata_fields;
+                std::shared_ptr<osmium::util::MemoryMapping> m_mapped_input;
+                osmium::io::blob_selection m_read_blobs;
+                osmium::io::decode_window m_decode_window;
+                osmium::io::tag_prefilter m_prefilter;
+                osmium::io::xml_tokenizer m_xml_tokenizer;
+                osmium::io::read_buffers m_read_buffers;
+                osmium::io::buffer_transform m_transform;
+                osmium::io::PipelineStats* m_stats;
                 bool m_header_is_done;
+                bool m_filter_output;
 
             protected:
 
@@ -89,6 +211,97 @@ namespace osmium {
                     return m_read_metadata;
                 }
 
+                /**
+                 * Which metadata fields should be read if read_metadata()
+                 * is yes. Parsers that can't skip single fields read all
+                 * of them.
+                 */
+                const osmium::metadata_options& read_metadata_fields() const noexcept {
+                    return m_read_metadata_fields;
+                }
+
+                /**
+                 * The memory-mapped input file if the Reader decided to map
+                 * it. In that case the input queue is empty and the parser
+                 * has to use the data from the mapping. Otherwise this is
+                 * a nullptr.
+                 */
+                const std::shared_ptr<osmium::util::MemoryMapping>& mapped_input() const noexcept {
+                    return m_mapped_input;
+                }
+
+                /**
+                 * The blobs the parser should read. Parsers for formats not
+                 * organized in blobs ignore this.
+                 */
+                const osmium::io::blob_selection& read_blobs() const noexcept {
+                    return m_read_blobs;
+                }
+
+                /**
+                 * How many blobs can be decoded in parallel. Parsers that
+                 * don't decode in the thread pool ignore this.
+                 */
+                const osmium::io::decode_window& get_decode_window() const noexcept {
+                    return m_decode_window;
+                }
+
+                /**
+                 * Create the window for decoding in the thread pool from
+                 * the decode_window option. Returns a nullptr if the data
+                 * should not be decoded in the pool.
+                 */
+                std::shared_ptr<DecodeWindow> make_decode_window() {
+                    if (!m_decode_window.parallel()) {
+                        return nullptr;
+                    }
+                    const auto max_chunks = m_decode_window.max_blobs() == osmium::io::decode_window::automatic() ?
+                                            2 * static_cast<std::size_t>(m_pool.num_threads()) :
+                                            m_decode_window.max_blobs();
+                    return std::make_shared<DecodeWindow>(max_chunks, m_decode_window.max_bytes());
+                }
+
+                /**
+                 * Objects the parser should not read based on their tags.
+                 * Unless the parser calls set_prefilter_applied(), this is
+                 * applied to all buffers sent to the output queue with
+                 * send_to_output_queue(Buffer&&).
+                 */
+                const osmium::io::tag_prefilter& prefilter() const noexcept {
+                    return m_prefilter;
+                }
+
+                /**
+                 * Which tokenizer to use. Only used by the XML parser.
+                 */
+                osmium::io::xml_tokenizer get_xml_tokenizer() const noexcept {
+                    return m_xml_tokenizer;
+                }
+
+                /**
+                 * Size of the output buffers and the pool they are taken
+                 * from. Only used by the XML, OPL, and o5m parsers.
+                 */
+                const osmium::io::read_buffers& read_buffers() const noexcept {
+                    return m_read_buffers;
+                }
+
+                /**
+                 * Where to record timing information. This is a nullptr
+                 * unless the user asked for it.
+                 */
+                osmium::io::PipelineStats* stats() const noexcept {
+                    return m_stats;
+                }
+
+                /**
+                 * Parsers applying the prefilter themselves while parsing
+                 * call this before sending any buffers.
+                 */
+                void set_prefilter_applied() noexcept {
+                    m_filter_output = false;
+                }
+
                 bool header_is_done() const noexcept {
                     return m_header_is_done;
                 }
@@ -108,16 +321,43 @@ namespace osmium {
                 }
 
                 /**
-                 * Wrap the buffer into a future and add it to the output queue.
+                 * Wrap the buffer into a future and add it to the output
+                 * queue. The buffer transform (if any) is applied to it
+                 * first.
                  */
                 void send_to_output_queue(osmium::memory::Buffer&& buffer) {
+                    if (m_filter_output) {
+                        buffer = apply_tag_prefilter(m_prefilter, buffer);
+                    }
+                    if (buffer && m_transform.enabled()) {
+                        m_transform(buffer);
+                    }
                     add_to_queue(m_output_queue, std::move(buffer));
                 }
 
+                /**
+                 * Add the future to the output queue. The buffer transform
+                 * is not applied, use submit_to_output_queue() for tasks
+                 * in the pool.
+                 */
                 void send_to_output_queue(std::future<osmium::memory::Buffer>&& future) {
                     m_output_queue.push(std::move(future));
                 }
 
+                /**
+                 * Submit a task creating a buffer to the thread pool and
+                 * add its future to the output queue. The buffer transform
+                 * (if any) is applied to the buffer in the same task.
+                 */
+                template <typename TTask>
+                void submit_to_output_queue(TTask&& task) {
+                    if (m_transform.enabled()) {
+                        send_to_output_queue(m_pool.submit(transform_task<typename std::decay<TTask>::type>{std::forward<TTask>(task), m_transform}));
+                        return;
+                    }
+                    send_to_output_queue(m_pool.submit(std::forward<TTask>(task)));
+                }
+
             public:
 
                 explicit Parser(parser_arguments& args) :
@@ -127,7 +367,17 @@ namespace osmium {
                     m_input_queue(args.input_queue),
                     m_read_which_entities(args.read_which_entities),
                     m_read_metadata(args.read_metadata),
-                    m_header_is_done(false) {
+                    m_read_metadata_fields(args.read_metadata_fields),
+                    m_mapped_input(args.mapped_input),
+                    m_read_blobs(args.read_blobs),
+                    m_decode_window(args.window),
+                    m_prefilter(args.prefilter),
+                    m_xml_tokenizer(args.tokenizer),
+                    m_read_buffers(args.buffers),
+                    m_transform(args.transform),
+                    m_stats(args.stats),
+                    m_header_is_done(false),
+                    m_filter_output(args.prefilter.enabled()) {
                 }
 
                 Parser(const Parser&) = delete;
@@ -141,6 +391,8 @@ namespace osmium {
                 virtual void run() = 0;
 
                 std::string get_input() {
+                    const stats_timer timer{m_stats, &PipelineStats::parser_input_wait};
+                    const osmium::trace::Span span{"parser_input_wait"};
                     return m_input_queue.pop();
                 }
 
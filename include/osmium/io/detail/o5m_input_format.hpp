@@ -61,10 +61,12 @@ DEALINGS IN THE SOFTWARE.
 #include <cstdint>
 #include <cstring>
 #include <future>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -101,11 +103,6 @@ namespace osmium {
                     number_of_entries = 15000u
                 };
 
-                // The size of one entry in the table.
-                enum {
-                    entry_size = 256u
-                };
-
                 // The maximum length of a string in the table including
                 // two \0 bytes.
                 enum {
@@ -123,6 +120,11 @@ namespace osmium {
 
             public:
 
+                // The size of one entry in the table.
+                enum {
+                    entry_size = 256u
+                };
+
                 void clear() {
                     current_entry = 0;
                 }
@@ -149,96 +151,40 @@ namespace osmium {
 
             }; // class ReferenceTable
 
-            class O5mParser : public Parser {
-
-                enum {
-                    initial_buffer_size = 1024ul * 1024ul
-                };
-
-                osmium::io::Header m_header{};
-
-                osmium::memory::Buffer m_buffer{initial_buffer_size,
-                                                osmium::memory::Buffer::auto_grow::internal};
-
-                std::string m_input{};
-
-                const char* m_data;
-                const char* m_end;
-
-                ReferenceTable m_reference_table;
-
-                static int64_t zvarint(const char** data, const char* end) {
-                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
-                }
-
-                bool ensure_bytes_available(std::size_t need_bytes) {
-                    if ((m_end - m_data) >= static_cast<int64_t>(need_bytes)) {
-                        return true;
-                    }
-
-                    if (input_done() && (m_input.size() < need_bytes)) {
-                        return false;
-                    }
-
-                    m_input.erase(0, m_data - m_input.data());
-
-                    while (m_input.size() < need_bytes) {
-                        const std::string data{get_input()};
-                        if (input_done()) {
-                            return false;
-                        }
-                        m_input.append(data);
-                    }
-
-                    m_data = m_input.data();
-                    m_end = m_input.data() + m_input.size();
+            enum class o5m_dataset_type : unsigned char {
+                node         = 0x10,
+                way          = 0x11,
+                relation     = 0x12,
+                bounding_box = 0xdb,
+                timestamp    = 0xdc,
+                header       = 0xe0,
+                sync         = 0xee,
+                jump         = 0xef,
+                reset        = 0xff
+            };
 
-                    return true;
-                }
+            /**
+             * Decodes the node, way, and relation datasets of an o5m file
+             * into a buffer. It keeps the string table and the delta
+             * decoding state which are cleared on each reset.
+             *
+             * If split_output is set, full buffers (see read_buffers) are
+             * moved to the list of full_buffers() and decoding continues
+             * in a new buffer. Otherwise all output goes into one buffer.
+             */
+            class O5mDecoder {
 
-                void check_header_magic() {
-                    static const unsigned char header_magic[] = { 0xff, 0xe0, 0x04, 'o', '5' };
+                osmium::io::read_buffers m_buffers;
 
-                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic)) != 0) {
-                        throw o5m_error{"wrong header magic"};
-                    }
+                osmium::memory::Buffer m_buffer;
 
-                    m_data += sizeof(header_magic);
-                }
-
-                void check_file_type() {
-                    if (*m_data == 'm') {         // o5m data file
-                        m_header.set_has_multiple_object_versions(false);
-                    } else if (*m_data == 'c') {  // o5c change file
-                        m_header.set_has_multiple_object_versions(true);
-                    } else {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data++;
-                }
-
-                void check_file_format_version() {
-                    if (*m_data != '2') {
-                        throw o5m_error{"wrong header magic"};
-                    }
-
-                    m_data++;
-                }
+                std::vector<osmium::memory::Buffer> m_full_buffers;
 
-                void decode_header() {
-                    if (! ensure_bytes_available(7)) { // overall length of header
-                        throw o5m_error{"file too short (incomplete header info)"};
-                    }
+                bool m_split_output;
 
-                    check_header_magic();
-                    check_file_type();
-                    check_file_format_version();
-                }
+                osmium::osm_entity_bits::type m_read_types;
 
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
+                ReferenceTable m_reference_table;
 
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_id;
 
@@ -250,45 +196,51 @@ namespace osmium {
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_way_node_id;
                 osmium::DeltaDecode<osmium::object_id_type> m_delta_member_ids[3];
 
-                void reset() {
-                    m_reference_table.clear();
-
-                    m_delta_id.clear();
-                    m_delta_timestamp.clear();
-                    m_delta_changeset.clear();
-                    m_delta_lon.clear();
-                    m_delta_lat.clear();
+                static int64_t zvarint(const char** data, const char* end) {
+                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
+                }
 
-                    m_delta_way_node_id.clear();
-                    m_delta_member_ids[0].clear();
-                    m_delta_member_ids[1].clear();
-                    m_delta_member_ids[2].clear();
+                // Find the end of the \0-terminated string starting at data
+                // and return the position after the \0.
+                static const char* skip_string(const char* data, const char* end, const char* error) {
+                    const auto* null = static_cast<const char*>(std::memchr(data, 0, static_cast<std::size_t>(end - data)));
+                    if (!null) {
+                        throw o5m_error{error};
+                    }
+                    return null + 1;
                 }
 
-                const char* decode_string(const char** dataptr, const char* const end) {
+                // Returns the string either inline at *dataptr or from the
+                // reference table. The string can not extend beyond
+                // *string_end.
+                const char* decode_string(const char** dataptr, const char* const end, const char** string_end) {
                     if (**dataptr == 0x00) { // get inline string
                         (*dataptr)++;
                         if (*dataptr == end) {
                             throw o5m_error{"string format error"};
                         }
+                        *string_end = end;
                         return *dataptr;
                     }
                     // get from reference table
                     const auto index = protozero::decode_varint(dataptr, end);
-                    return m_reference_table.get(index);
+                    const char* string = m_reference_table.get(index);
+                    *string_end = string + ReferenceTable::entry_size;
+                    return string;
                 }
 
                 std::pair<osmium::user_id_type, const char*> decode_user(const char** dataptr, const char* const end) {
                     const bool update_pointer = (**dataptr == 0x00);
-                    const char* data = decode_string(dataptr, end);
+                    const char* string_end;
+                    const char* data = decode_string(dataptr, end, &string_end);
                     const char* start = data;
 
-                    const auto uid = protozero::decode_varint(&data, end);
+                    const auto uid = protozero::decode_varint(&data, string_end);
                     if (uid > std::numeric_limits<user_id_type>::max()) {
                         throw o5m_error{"uid out of range"};
                     }
 
-                    if (data == end) {
+                    if (data == string_end) {
                         throw o5m_error{"missing user name"};
                     }
 
@@ -300,11 +252,10 @@ namespace osmium {
                         return {0, ""};
                     }
 
-                    while (*data++) {
-                        if (data == end) {
-                            throw o5m_error{"no null byte in user name"};
-                        }
+                    if (data == string_end) {
+                        throw o5m_error{"no null byte in user name"};
                     }
+                    data = skip_string(data, string_end, "no null byte in user name");
 
                     if (update_pointer) {
                         m_reference_table.add(start, data - start);
@@ -319,25 +270,18 @@ namespace osmium {
 
                     while (*dataptr != end) {
                         const bool update_pointer = (**dataptr == 0x00);
-                        const char* data = decode_string(dataptr, end);
+                        const char* string_end;
+                        const char* data = decode_string(dataptr, end, &string_end);
                         const char* start = data;
 
-                        while (*data++) {
-                            if (data == end) {
-                                throw o5m_error{"no null byte in tag key"};
-                            }
-                        }
+                        data = skip_string(data, string_end, "no null byte in tag key");
 
-                        if (data == end) {
+                        if (data == string_end) {
                             throw o5m_error{"no null byte in tag value"};
                         }
 
                         const char* value = data;
-                        while (*data++) {
-                            if (data == end) {
-                                throw o5m_error{"no null byte in tag value"};
-                            }
-                        }
+                        data = skip_string(data, string_end, "no null byte in tag value");
 
                         if (update_pointer) {
                             m_reference_table.add(start, data - start);
@@ -439,20 +383,17 @@ namespace osmium {
 
                 std::pair<osmium::item_type, const char*> decode_role(const char** dataptr, const char* const end) {
                     const bool update_pointer = (**dataptr == 0x00);
-                    const char* data = decode_string(dataptr, end);
+                    const char* string_end;
+                    const char* data = decode_string(dataptr, end, &string_end);
                     const char* start = data;
 
                     const auto member_type = decode_member_type(*data++);
-                    if (data == end) {
+                    if (data == string_end) {
                         throw o5m_error{"missing role"};
                     }
                     const char* role = data;
 
-                    while (*data++) {
-                        if (data == end) {
-                            throw o5m_error{"no null byte in role"};
-                        }
-                    }
+                    data = skip_string(data, string_end, "no null byte in role");
 
                     if (update_pointer) {
                         m_reference_table.add(start, data - start);
@@ -500,6 +441,265 @@ namespace osmium {
                     }
                 }
 
+            public:
+
+                O5mDecoder(osmium::osm_entity_bits::type read_types, const osmium::io::read_buffers& buffers, bool split_output) :
+                    m_buffers(buffers),
+                    m_buffer(buffers.get()),
+                    m_split_output(split_output),
+                    m_read_types(read_types) {
+                }
+
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_buffer;
+                }
+
+                std::vector<osmium::memory::Buffer>& full_buffers() noexcept {
+                    return m_full_buffers;
+                }
+
+                void reset() {
+                    m_reference_table.clear();
+
+                    m_delta_id.clear();
+                    m_delta_timestamp.clear();
+                    m_delta_changeset.clear();
+                    m_delta_lon.clear();
+                    m_delta_lat.clear();
+
+                    m_delta_way_node_id.clear();
+                    m_delta_member_ids[0].clear();
+                    m_delta_member_ids[1].clear();
+                    m_delta_member_ids[2].clear();
+                }
+
+                void commit() {
+                    m_buffer.commit();
+                    if (m_split_output && m_buffers.is_full(m_buffer)) {
+                        m_full_buffers.push_back(std::move(m_buffer));
+                        m_buffer = m_buffers.get();
+                    }
+                }
+
+                /**
+                 * Decode a node, way, or relation dataset if that type
+                 * should be read. Other datasets are ignored.
+                 */
+                void decode_dataset(o5m_dataset_type type, const char* data, const char* const end) {
+                    switch (type) {
+                        case o5m_dataset_type::node:
+                            if (m_read_types & osmium::osm_entity_bits::node) {
+                                decode_node(data, end);
+                                commit();
+                            }
+                            break;
+                        case o5m_dataset_type::way:
+                            if (m_read_types & osmium::osm_entity_bits::way) {
+                                decode_way(data, end);
+                                commit();
+                            }
+                            break;
+                        case o5m_dataset_type::relation:
+                            if (m_read_types & osmium::osm_entity_bits::relation) {
+                                decode_relation(data, end);
+                                commit();
+                            }
+                            break;
+                        default:
+                            break;
+                    }
+                }
+
+                /**
+                 * Decode a sequence of complete datasets and resets.
+                 */
+                void decode_datasets(const char* data, const char* const end) {
+                    while (data != end) {
+                        const auto type = static_cast<o5m_dataset_type>(*data++);
+                        if (type > o5m_dataset_type::jump) {
+                            if (type == o5m_dataset_type::reset) {
+                                reset();
+                            }
+                            continue;
+                        }
+                        const auto length = protozero::decode_varint(&data, end);
+                        if (length > static_cast<uint64_t>(end - data)) {
+                            throw o5m_error{"premature end of file"};
+                        }
+                        decode_dataset(type, data, data + length);
+                        data += length;
+                    }
+                }
+
+            }; // class O5mDecoder
+
+            /**
+             * Decodes a chunk of o5m data in the thread pool. The chunk
+             * contains complete datasets and starts right after a reset,
+             * so it doesn't depend on any earlier data.
+             */
+            class O5mChunkParser {
+
+                std::string m_data;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::io::tag_prefilter m_prefilter;
+                osmium::io::read_buffers m_buffers;
+                std::shared_ptr<DecodeWindow> m_window;
+
+                osmium::memory::Buffer parse() {
+                    O5mDecoder decoder{m_read_types, m_buffers, false};
+                    decoder.decode_datasets(m_data.data(), m_data.data() + m_data.size());
+                    if (m_prefilter.enabled()) {
+                        return apply_tag_prefilter(m_prefilter, decoder.buffer());
+                    }
+                    return std::move(decoder.buffer());
+                }
+
+            public:
+
+                O5mChunkParser(std::string&& data, osmium::osm_entity_bits::type read_types, const osmium::io::tag_prefilter& prefilter, const osmium::io::read_buffers& buffers, std::shared_ptr<DecodeWindow> window) :
+                    m_data(std::move(data)),
+                    m_read_types(read_types),
+                    m_prefilter(prefilter),
+                    m_buffers(buffers),
+                    m_window(std::move(window)) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    const std::size_t bytes = m_data.size();
+                    try {
+                        auto buffer = parse();
+                        m_window->remove(bytes);
+                        return buffer;
+                    } catch (...) {
+                        m_window->remove(bytes);
+                        throw;
+                    }
+                }
+
+            }; // class O5mChunkParser
+
+            class O5mParser : public Parser {
+
+                osmium::io::Header m_header{};
+
+                O5mDecoder m_decoder;
+
+                std::string m_input{};
+
+                const char* m_data;
+                const char* m_end;
+
+                std::shared_ptr<DecodeWindow> m_decode_window;
+
+                // Datasets since the last reset collected for decoding in
+                // the thread pool.
+                std::string m_chunk;
+
+                // Set if there was no reset for so long that the datasets
+                // are decoded in this thread until the next reset.
+                bool m_decode_here = false;
+
+                // If all objects are read, the datasets don't have to be
+                // copied into the chunk one by one. Instead the input is
+                // copied verbatim in large pieces starting here (or not at
+                // all if this is nullptr).
+                const char* m_run = nullptr;
+
+                bool copy_runs() const noexcept {
+                    return (read_types() & osmium::osm_entity_bits::nwr) == osmium::osm_entity_bits::nwr;
+                }
+
+                // Append the input from m_run up to end to the chunk.
+                void flush_run(const char* end) {
+                    if (m_run) {
+                        m_chunk.append(m_run, end);
+                        m_run = end;
+                    }
+                }
+
+                static int64_t zvarint(const char** data, const char* end) {
+                    return protozero::decode_zigzag64(protozero::decode_varint(data, end));
+                }
+
+                bool ensure_bytes_available(std::size_t need_bytes) {
+                    if ((m_end - m_data) >= static_cast<int64_t>(need_bytes)) {
+                        return true;
+                    }
+
+                    if (input_done() && (m_input.size() < need_bytes)) {
+                        return false;
+                    }
+
+                    flush_run(m_data);
+                    m_input.erase(0, m_data - m_input.data());
+                    m_data = m_input.data();
+                    m_end = m_input.data() + m_input.size();
+                    if (m_run) {
+                        m_run = m_data;
+                    }
+
+                    while (m_input.size() < need_bytes) {
+                        const std::string data{get_input()};
+                        if (input_done()) {
+                            return false;
+                        }
+                        m_input.append(data);
+                    }
+
+                    m_data = m_input.data();
+                    m_end = m_input.data() + m_input.size();
+                    if (m_run) {
+                        m_run = m_data;
+                    }
+
+                    return true;
+                }
+
+                void check_header_magic() {
+                    static const unsigned char header_magic[] = { 0xff, 0xe0, 0x04, 'o', '5' };
+
+                    if (std::strncmp(reinterpret_cast<const char*>(header_magic), m_data, sizeof(header_magic)) != 0) {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data += sizeof(header_magic);
+                }
+
+                void check_file_type() {
+                    if (*m_data == 'm') {         // o5m data file
+                        m_header.set_has_multiple_object_versions(false);
+                    } else if (*m_data == 'c') {  // o5c change file
+                        m_header.set_has_multiple_object_versions(true);
+                    } else {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void check_file_format_version() {
+                    if (*m_data != '2') {
+                        throw o5m_error{"wrong header magic"};
+                    }
+
+                    m_data++;
+                }
+
+                void decode_header() {
+                    if (! ensure_bytes_available(7)) { // overall length of header
+                        throw o5m_error{"file too short (incomplete header info)"};
+                    }
+
+                    check_header_magic();
+                    check_file_type();
+                    check_file_format_version();
+                }
+
+                void mark_header_as_done() {
+                    set_header_value(m_header);
+                }
+
                 void decode_bbox(const char* data, const char* const end) {
                     const auto sw_lon = zvarint(&data, end);
                     const auto sw_lat = zvarint(&data, end);
@@ -516,24 +716,124 @@ namespace osmium {
                     m_header.set("timestamp", timestamp);
                 }
 
-                enum class dataset_type : unsigned char {
-                    node         = 0x10,
-                    way          = 0x11,
-                    relation     = 0x12,
-                    bounding_box = 0xdb,
-                    timestamp    = 0xdc,
-                    header       = 0xe0,
-                    sync         = 0xee,
-                    jump         = 0xef,
-                    reset        = 0xff
-                };
+                void send_buffer(osmium::memory::Buffer&& buffer) {
+                    if (m_decode_window && prefilter().enabled()) {
+                        // The prefilter is applied here because it is
+                        // switched off for the whole output in pool mode.
+                        send_to_output_queue(apply_tag_prefilter(prefilter(), buffer));
+                        return;
+                    }
+                    send_to_output_queue(std::move(buffer));
+                }
+
+                void send_full_buffers() {
+                    for (auto& buffer : m_decoder.full_buffers()) {
+                        send_buffer(std::move(buffer));
+                    }
+                    m_decoder.full_buffers().clear();
+                }
+
+                void flush_decoder() {
+                    send_full_buffers();
+                    if (m_decoder.buffer().committed() > 0) {
+                        send_buffer(std::move(m_decoder.buffer()));
+                        m_decoder.buffer() = read_buffers().get();
+                    }
+                }
+
+                void submit_chunk() {
+                    const std::size_t bytes = m_chunk.size();
+                    // Wait for space in the window before the chunk is
+                    // submitted, because the futures go into the output
+                    // queue in order.
+                    m_decode_window->add(bytes);
+                    submit_to_output_queue(O5mChunkParser{std::move(m_chunk), read_types(), prefilter(), read_buffers(), m_decode_window});
+                    m_chunk.clear();
+                }
+
+                // Without a reset the data can't be split, so if there is
+                // none for a long time, the datasets are decoded here until
+                // the next one.
+                void decode_chunk_here() {
+                    m_decoder.reset();
+                    m_decoder.decode_datasets(m_chunk.data(), m_chunk.data() + m_chunk.size());
+                    m_chunk.clear();
+                    m_decode_here = true;
+                    send_full_buffers();
+                }
+
+                void handle_reset() {
+                    if (!m_decode_window) {
+                        m_decoder.reset();
+                        return;
+                    }
+
+                    if (m_decode_here) {
+                        flush_decoder();
+                        m_decode_here = false;
+                        if (copy_runs()) {
+                            m_run = m_data;
+                        }
+                        return;
+                    }
+
+                    if (m_run) {
+                        // The reset is already part of the run, it is only
+                        // left out if the chunk ends here.
+                        if (m_chunk.size() + static_cast<std::size_t>(m_data - m_run) > chunk_size) {
+                            flush_run(m_data - 1);
+                            submit_chunk();
+                            m_run = m_data;
+                        }
+                        return;
+                    }
+
+                    if (m_chunk.size() >= chunk_size) {
+                        submit_chunk();
+                    } else if (!m_chunk.empty()) {
+                        m_chunk += static_cast<char>(o5m_dataset_type::reset);
+                    }
+                }
+
+                void handle_object(o5m_dataset_type ds_type, uint64_t length) {
+                    if (!m_decode_window || m_decode_here) {
+                        m_decoder.decode_dataset(ds_type, m_data, m_data + length);
+                        send_full_buffers();
+                        return;
+                    }
+
+                    if (m_run) {
+                        if (m_chunk.size() + static_cast<std::size_t>(m_data - m_run) + length >= max_chunk_size) {
+                            flush_run(m_data + length);
+                            m_run = nullptr;
+                            decode_chunk_here();
+                        }
+                        return;
+                    }
+
+                    if (!(read_types() & osmium::osm_entity_bits::from_item_type(osmium::nwr_index_to_item_type(static_cast<unsigned int>(ds_type) - static_cast<unsigned int>(o5m_dataset_type::node))))) {
+                        return;
+                    }
+
+                    m_chunk += static_cast<char>(ds_type);
+                    protozero::write_varint(std::back_inserter(m_chunk), length);
+                    m_chunk.append(m_data, length);
+
+                    if (m_chunk.size() >= max_chunk_size) {
+                        decode_chunk_here();
+                    }
+                }
 
                 void decode_data() {
+                    if (m_decode_window && copy_runs()) {
+                        m_run = m_data;
+                    }
+
                     while (ensure_bytes_available(1)) {
-                        const auto ds_type = static_cast<dataset_type>(*m_data++);
-                        if (ds_type > dataset_type::jump) {
-                            if (ds_type == dataset_type::reset) {
-                                reset();
+                        const auto ds_type = static_cast<o5m_dataset_type>(*m_data++);
+                        if (ds_type > o5m_dataset_type::jump) {
+                            if (ds_type == o5m_dataset_type::reset) {
+                                handle_reset();
                             }
                         } else {
                             ensure_bytes_available(protozero::max_varint_length);
@@ -550,31 +850,16 @@ namespace osmium {
                             }
 
                             switch (ds_type) {
-                                case dataset_type::node:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::node) {
-                                        decode_node(m_data, m_data + length);
-                                        m_buffer.commit();
-                                    }
-                                    break;
-                                case dataset_type::way:
+                                case o5m_dataset_type::node:
+                                case o5m_dataset_type::way:
+                                case o5m_dataset_type::relation:
                                     mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::way) {
-                                        decode_way(m_data, m_data + length);
-                                        m_buffer.commit();
-                                    }
+                                    handle_object(ds_type, length);
                                     break;
-                                case dataset_type::relation:
-                                    mark_header_as_done();
-                                    if (read_types() & osmium::osm_entity_bits::relation) {
-                                        decode_relation(m_data, m_data + length);
-                                        m_buffer.commit();
-                                    }
-                                    break;
-                                case dataset_type::bounding_box:
+                                case o5m_dataset_type::bounding_box:
                                     decode_bbox(m_data, m_data + length);
                                     break;
-                                case dataset_type::timestamp:
+                                case o5m_dataset_type::timestamp:
                                     decode_timestamp(m_data, m_data + length);
                                     break;
                                 default:
@@ -587,27 +872,41 @@ namespace osmium {
                             }
 
                             m_data += length;
-
-                            if (m_buffer.has_nested_buffers()) {
-                                std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
-                                send_to_output_queue(std::move(*buffer_ptr));
-                            }
                         }
                     }
 
-                    if (m_buffer.committed() > 0) {
-                        send_to_output_queue(std::move(m_buffer));
+                    flush_run(m_data);
+                    m_run = nullptr;
+                    if (!m_chunk.empty()) {
+                        submit_chunk();
                     }
 
+                    flush_decoder();
+
                     mark_header_as_done();
                 }
 
             public:
 
+                enum : std::size_t {
+                    /// Minimum size of the chunks decoded in the thread pool.
+                    chunk_size = 1024ul * 1024ul,
+
+                    /// Size after which a chunk without a reset is decoded
+                    /// in the parser thread.
+                    max_chunk_size = 16ul * 1024ul * 1024ul
+                };
+
                 explicit O5mParser(parser_arguments& args) :
                     Parser(args),
+                    m_decoder(read_types(), read_buffers(), true),
                     m_data(m_input.data()),
-                    m_end(m_data) {
+                    m_end(m_data),
+                    m_decode_window(make_decode_window()) {
+                    if (m_decode_window) {
+                        // The chunk parsers apply the prefilter.
+                        set_prefilter_applied();
+                    }
                 }
 
                 O5mParser(const O5mParser&) = delete;
@@ -0,0 +1,477 @@
+#ifndef OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/handler.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/delta.hpp>
+#include <osmium/visitor.hpp>
+
+#include <protozero/varint.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            // Implementation of the o5m/o5c file formats according to the
+            // description at https://wiki.openstreetmap.org/wiki/O5m .
+            // See o5m_input_format.hpp for the parser.
+
+            struct o5m_output_options {
+
+                /// Which metadata of objects should be added?
+                osmium::metadata_options add_metadata;
+
+                /// Write an o5c change file instead of an o5m data file?
+                bool o5c_change_format = false;
+
+            }; // struct o5m_output_options
+
+            /**
+             * The encoder side of the ReferenceTable: Remembers which
+             * strings were written inline so that they can be written as
+             * references to the table the decoder keeps. This must add
+             * exactly the same strings as the decoder does.
+             */
+            class O5mStringTable {
+
+                // The maximum number of entries in the table of the
+                // decoder.
+                enum : uint64_t {
+                    number_of_entries = 15000u
+                };
+
+                // The maximum length of a string in the table including
+                // two \0 bytes.
+                enum : std::size_t {
+                    max_length = 250u + 2u
+                };
+
+                // The number of the last string added for each string
+                std::unordered_map<std::string, uint64_t> m_entries;
+
+                // The number of strings added so far
+                uint64_t m_count = 0;
+
+            public:
+
+                void clear() {
+                    m_entries.clear();
+                    m_count = 0;
+                }
+
+                /**
+                 * Look up a string in the table.
+                 *
+                 * @returns The index to write as reference to the string or
+                 *          0 if the string has to be written inline. In
+                 *          that case the string is added to the table if
+                 *          the decoder will do the same.
+                 */
+                uint64_t lookup(const std::string& str) {
+                    if (str.size() > max_length) {
+                        return 0;
+                    }
+
+                    const auto it = m_entries.find(str);
+                    if (it != m_entries.end() && m_count - it->second < number_of_entries) {
+                        return m_count - it->second + 1;
+                    }
+
+                    ++m_count;
+                    if (it == m_entries.end()) {
+                        m_entries.emplace(str, m_count);
+                    } else {
+                        it->second = m_count;
+                    }
+
+                    return 0;
+                }
+
+                /**
+                 * Count a string that is added to the table of the decoder
+                 * but must never be referenced.
+                 */
+                void add_unreferenced() noexcept {
+                    ++m_count;
+                }
+
+            }; // class O5mStringTable
+
+            /**
+             * Writes out one buffer with OSM data in o5m format. Each block
+             * starts with a reset, so the delta encoding and the string
+             * table only depend on the objects in this buffer and all
+             * buffers can be encoded in parallel. There is also a reset
+             * whenever the object type changes as the format requires.
+             */
+            class O5mOutputBlock : public OutputBlock {
+
+                enum : char {
+                    dataset_node     = 0x10,
+                    dataset_way      = 0x11,
+                    dataset_relation = 0x12,
+                    dataset_reset    = static_cast<char>(0xff)
+                };
+
+                o5m_output_options m_options;
+
+                // Type of the last dataset written, 0 at the beginning
+                char m_last_type = 0;
+
+                O5mStringTable m_string_table;
+
+                // Data of the current dataset. It is written to the output
+                // after the length which is only known at the end.
+                std::string m_data;
+
+                // Data of the reference section of ways and relations.
+                std::string m_refs;
+
+                // Used for building strings before looking them up.
+                std::string m_str;
+
+                osmium::DeltaEncode<osmium::object_id_type> m_delta_id;
+
+                osmium::DeltaEncode<int64_t> m_delta_timestamp;
+                osmium::DeltaEncode<osmium::changeset_id_type> m_delta_changeset;
+                osmium::DeltaEncode<int32_t> m_delta_lon;
+                osmium::DeltaEncode<int32_t> m_delta_lat;
+
+                osmium::DeltaEncode<osmium::object_id_type> m_delta_way_node_id;
+                osmium::DeltaEncode<osmium::object_id_type> m_delta_member_ids[3];
+
+                static void write_varint(std::string& out, uint64_t value) {
+                    protozero::write_varint(std::back_inserter(out), value);
+                }
+
+                static void write_zvarint(std::string& out, int64_t value) {
+                    write_varint(out, protozero::encode_zigzag64(value));
+                }
+
+                // Write the string in m_str either inline or as reference
+                // to the string table.
+                void write_string(std::string& out) {
+                    const auto index = m_string_table.lookup(m_str);
+                    if (index == 0) {
+                        out += '\0';
+                        out += m_str;
+                    } else {
+                        write_varint(out, index);
+                    }
+                }
+
+                void write_string_pair(std::string& out, const char* first, const char* second) {
+                    m_str.assign(first);
+                    m_str += '\0';
+                    m_str.append(second);
+                    m_str += '\0';
+                    write_string(out);
+                }
+
+                void write_user(const osmium::OSMObject& object) {
+                    m_str.clear();
+                    if (m_options.add_metadata.uid() && object.uid() != 0) {
+                        write_varint(m_str, object.uid());
+                        m_str += '\0';
+                        if (m_options.add_metadata.user()) {
+                            m_str.append(object.user());
+                        }
+                        m_str += '\0';
+                        write_string(m_data);
+                        return;
+                    }
+
+                    // The decoder adds an anonymous user to its string
+                    // table, but doesn't read it back correctly from there,
+                    // so it is always written inline.
+                    m_data.append(3, '\0');
+                    m_string_table.add_unreferenced();
+                }
+
+                // The o5m format can only store metadata if there is a
+                // version. Fields not in the add_metadata option are
+                // written as 0 or empty.
+                void write_info(const osmium::OSMObject& object) {
+                    if (!m_options.add_metadata.version() || object.version() == 0) {
+                        m_data += '\0';
+                        return;
+                    }
+
+                    write_varint(m_data, object.version());
+
+                    const int64_t timestamp = m_options.add_metadata.timestamp() ? uint32_t(object.timestamp()) : 0;
+                    write_zvarint(m_data, m_delta_timestamp.update(timestamp));
+                    if (timestamp == 0) {
+                        return;
+                    }
+
+                    const osmium::changeset_id_type changeset = m_options.add_metadata.changeset() ? object.changeset() : 0;
+                    write_zvarint(m_data, m_delta_changeset.update(changeset));
+
+                    write_user(object);
+                }
+
+                void write_tags(const osmium::TagList& tags) {
+                    for (const auto& tag : tags) {
+                        write_string_pair(m_data, tag.key(), tag.value());
+                    }
+                }
+
+                void reset() {
+                    m_string_table.clear();
+
+                    m_delta_id.clear();
+                    m_delta_timestamp.clear();
+                    m_delta_changeset.clear();
+                    m_delta_lon.clear();
+                    m_delta_lat.clear();
+
+                    m_delta_way_node_id.clear();
+                    m_delta_member_ids[0].clear();
+                    m_delta_member_ids[1].clear();
+                    m_delta_member_ids[2].clear();
+                }
+
+                void write_object_start(char type, const osmium::OSMObject& object) {
+                    if (type != m_last_type) {
+                        *m_out += dataset_reset;
+                        reset();
+                        m_last_type = type;
+                    }
+
+                    m_data.clear();
+                    write_zvarint(m_data, m_delta_id.update(object.id()));
+                    write_info(object);
+                }
+
+                void write_dataset(char type) {
+                    *m_out += type;
+                    write_varint(*m_out, m_data.size());
+                    *m_out += m_data;
+                }
+
+                // Write the reference section from m_refs.
+                void write_refs() {
+                    write_varint(m_data, m_refs.size());
+                    m_data += m_refs;
+                }
+
+            public:
+
+                template <typename TInput>
+                O5mOutputBlock(TInput&& input, const o5m_output_options& options) :
+                    OutputBlock(std::forward<TInput>(input)),
+                    m_options(options) {
+                }
+
+                std::string operator()() {
+                    // The o5m data is usually much smaller than the objects
+                    // in the buffer.
+                    m_out->reserve(input_size() / 2);
+
+                    apply_input(*this);
+
+                    std::string out;
+                    using std::swap;
+                    swap(out, *m_out);
+
+                    return out;
+                }
+
+                void node(const osmium::Node& node) {
+                    write_object_start(dataset_node, node);
+
+                    if (node.visible()) {
+                        write_zvarint(m_data, m_delta_lon.update(node.location().x()));
+                        write_zvarint(m_data, m_delta_lat.update(node.location().y()));
+                        write_tags(node.tags());
+                    }
+
+                    write_dataset(dataset_node);
+                }
+
+                void way(const osmium::Way& way) {
+                    write_object_start(dataset_way, way);
+
+                    if (way.visible()) {
+                        m_refs.clear();
+                        for (const auto& node_ref : way.nodes()) {
+                            write_zvarint(m_refs, m_delta_way_node_id.update(node_ref.ref()));
+                        }
+                        write_refs();
+                        write_tags(way.tags());
+                    }
+
+                    write_dataset(dataset_way);
+                }
+
+                void relation(const osmium::Relation& relation) {
+                    write_object_start(dataset_relation, relation);
+
+                    if (relation.visible()) {
+                        m_refs.clear();
+                        for (const auto& member : relation.members()) {
+                            const auto index = osmium::item_type_to_nwr_index(member.type());
+                            write_zvarint(m_refs, m_delta_member_ids[index].update(member.ref()));
+                            m_str.assign(1, static_cast<char>('0' + index));
+                            m_str.append(member.role());
+                            m_str += '\0';
+                            write_string(m_refs);
+                        }
+                        write_refs();
+                        write_tags(relation.tags());
+                    }
+
+                    write_dataset(dataset_relation);
+                }
+
+            }; // class O5mOutputBlock
+
+            class O5mOutputFormat : public osmium::io::detail::OutputFormat {
+
+                o5m_output_options m_options;
+
+                enum : char {
+                    dataset_bounding_box = static_cast<char>(0xdb),
+                    dataset_timestamp    = static_cast<char>(0xdc),
+                    dataset_end_of_file  = static_cast<char>(0xfe)
+                };
+
+                static void write_dataset(std::string& out, char type, const std::string& data) {
+                    out += type;
+                    protozero::write_varint(std::back_inserter(out), data.size());
+                    out += data;
+                }
+
+                static void write_zvarint(std::string& out, int64_t value) {
+                    protozero::write_varint(std::back_inserter(out), protozero::encode_zigzag64(value));
+                }
+
+            public:
+
+                O5mOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue) {
+                    m_options.add_metadata      = osmium::metadata_options{file.get("add_metadata")};
+                    m_options.o5c_change_format = file.is_true("o5c_change_format");
+                }
+
+                void write_header(const osmium::io::Header& header) final {
+                    // reset, header dataset with file type and version
+                    std::string out{"\xff\xe0\x04o5"};
+                    out += m_options.o5c_change_format ? 'c' : 'm';
+                    out += '2';
+
+                    for (const auto& box : header.boxes()) {
+                        std::string data;
+                        write_zvarint(data, box.bottom_left().x());
+                        write_zvarint(data, box.bottom_left().y());
+                        write_zvarint(data, box.top_right().x());
+                        write_zvarint(data, box.top_right().y());
+                        write_dataset(out, dataset_bounding_box, data);
+                    }
+
+                    std::string timestamp{header.get("o5m_timestamp")};
+                    if (timestamp.empty()) {
+                        timestamp = header.get("timestamp");
+                    }
+                    if (!timestamp.empty()) {
+                        std::string data;
+                        write_zvarint(data, uint32_t(osmium::Timestamp{timestamp.c_str()}));
+                        write_dataset(out, dataset_timestamp, data);
+                    }
+
+                    send_to_output_queue(std::move(out));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    m_output_queue.push(m_pool.submit(O5mOutputBlock{std::move(buffer), m_options}, osmium::thread::task_priority::high));
+                }
+
+                void write_selection(osmium::memory::BufferSelection&& selection) final {
+                    m_output_queue.push(m_pool.submit(O5mOutputBlock{std::move(selection), m_options}, osmium::thread::task_priority::high));
+                }
+
+                void write_end() final {
+                    send_to_output_queue(std::string(1, dataset_end_of_file));
+                }
+
+            }; // class O5mOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_o5m_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::o5m,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::O5mOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_o5m_output() noexcept {
+                return registered_o5m_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_O5M_OUTPUT_FORMAT_HPP
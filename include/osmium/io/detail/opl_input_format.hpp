@@ -40,6 +40,8 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/memory/buffer.hpp>
 #include <osmium/thread/util.hpp>
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -98,22 +100,163 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Count the lines in the data the same way line_by_line()
+             * does, ie. not counting empty lines.
+             */
+            inline uint64_t opl_count_lines(const std::string& data) {
+                uint64_t count = 0;
+                std::string::size_type ppos = 0;
+                while (ppos < data.size()) {
+                    auto pos = data.find_first_of("\n\r", ppos);
+                    if (pos == std::string::npos) {
+                        pos = data.size();
+                    }
+                    if (pos != ppos) {
+                        ++count;
+                    }
+                    ppos = pos + 1;
+                }
+                return count;
+            }
+
+            /**
+             * Parses a chunk of complete OPL lines in the thread pool.
+             */
+            class OPLChunkParser {
+
+                std::string m_data;
+                uint64_t m_first_line;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::io::tag_prefilter m_prefilter;
+                osmium::io::read_buffers m_buffers;
+                std::shared_ptr<DecodeWindow> m_window;
+
+                struct worker {
+
+                    std::string& data;
+                    uint64_t line_count;
+                    osmium::osm_entity_bits::type read_types;
+                    osmium::memory::Buffer& buffer;
+                    bool done;
+
+                    bool input_done() const noexcept {
+                        return done;
+                    }
+
+                    std::string get_input() {
+                        done = true;
+                        return std::move(data);
+                    }
+
+                    void parse_line(const char* line) {
+                        opl_parse_line(line_count, line, buffer, read_types);
+                        ++line_count;
+                    }
+
+                }; // struct worker
+
+                osmium::memory::Buffer parse() {
+                    osmium::memory::Buffer buffer{m_buffers.get()};
+                    worker w{m_data, m_first_line, m_read_types, buffer, false};
+                    line_by_line(w);
+                    if (m_prefilter.enabled()) {
+                        return apply_tag_prefilter(m_prefilter, buffer);
+                    }
+                    return buffer;
+                }
+
+            public:
+
+                OPLChunkParser(std::string&& data, uint64_t first_line, osmium::osm_entity_bits::type read_types, const osmium::io::tag_prefilter& prefilter, const osmium::io::read_buffers& buffers, std::shared_ptr<DecodeWindow> window) :
+                    m_data(std::move(data)),
+                    m_first_line(first_line),
+                    m_read_types(read_types),
+                    m_prefilter(prefilter),
+                    m_buffers(buffers),
+                    m_window(std::move(window)) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    const std::size_t bytes = m_data.size();
+                    try {
+                        auto buffer = parse();
+                        m_window->remove(bytes);
+                        return buffer;
+                    } catch (...) {
+                        m_window->remove(bytes);
+                        throw;
+                    }
+                }
+
+            }; // class OPLChunkParser
+
             class OPLParser : public Parser {
 
-                enum {
-                    initial_buffer_size = 1024ul * 1024ul
-                };
+                osmium::memory::Buffer m_buffer;
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size,
-                                                osmium::memory::Buffer::auto_grow::internal};
+                // When we started filling m_buffer, see read_buffers.
+                std::chrono::steady_clock::time_point m_buffer_started;
 
                 uint64_t m_line_count = 0;
 
+                std::shared_ptr<DecodeWindow> m_decode_window;
+
+                void submit_chunk(std::string&& chunk) {
+                    const uint64_t lines = opl_count_lines(chunk);
+                    const std::size_t bytes = chunk.size();
+                    // Wait for space in the window before the chunk is
+                    // submitted, because the futures go into the output
+                    // queue in order.
+                    m_decode_window->add(bytes);
+                    submit_to_output_queue(OPLChunkParser{std::move(chunk), m_line_count, read_types(), prefilter(), read_buffers(), m_decode_window});
+                    m_line_count += lines;
+                }
+
+                // Cut the input into chunks of complete lines which are
+                // parsed in the thread pool.
+                void run_in_pool() {
+                    std::string chunk;
+                    while (!input_done()) {
+                        if (chunk.empty()) {
+                            chunk = get_input();
+                        } else {
+                            chunk.append(get_input());
+                        }
+                        if (chunk.size() < chunk_size) {
+                            continue;
+                        }
+                        const auto pos = chunk.find_last_of("\n\r");
+                        if (pos == std::string::npos) {
+                            continue;
+                        }
+                        std::string rest{chunk, pos + 1};
+                        chunk.resize(pos + 1);
+                        submit_chunk(std::move(chunk));
+                        chunk = std::move(rest);
+                    }
+                    if (!chunk.empty()) {
+                        submit_chunk(std::move(chunk));
+                    }
+                }
+
             public:
 
+                enum : std::size_t {
+                    /// Minimum size of the chunks parsed in the thread pool.
+                    chunk_size = 1024ul * 1024ul
+                };
+
                 explicit OPLParser(parser_arguments& args) :
-                    Parser(args) {
+                    Parser(args),
+                    m_buffer(read_buffers().get()),
+                    m_buffer_started(read_buffers().start_time()),
+                    m_decode_window(make_decode_window()) {
                     set_header_value(osmium::io::Header{});
+                    if (m_decode_window) {
+                        // The chunk parsers apply the prefilter.
+                        set_prefilter_applied();
+                    }
                 }
 
                 OPLParser(const OPLParser&) = delete;
@@ -126,9 +269,12 @@ namespace osmium {
 
                 void parse_line(const char* data) {
                     if (opl_parse_line(m_line_count, data, m_buffer, read_types())) {
-                        if (m_buffer.has_nested_buffers()) {
-                            std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
-                            send_to_output_queue(std::move(*buffer_ptr));
+                        if (read_buffers().is_full(m_buffer, m_buffer_started)) {
+                            osmium::memory::Buffer buffer{read_buffers().get()};
+                            using std::swap;
+                            swap(m_buffer, buffer);
+                            m_buffer_started = read_buffers().start_time();
+                            send_to_output_queue(std::move(buffer));
                         }
                     }
                     ++m_line_count;
@@ -137,6 +283,11 @@ namespace osmium {
                 void run() final {
                     osmium::thread::set_thread_name("_osmium_opl_in");
 
+                    if (m_decode_window) {
+                        run_in_pool();
+                        return;
+                    }
+
                     line_by_line(*this);
 
                     if (m_buffer.committed() > 0) {
@@ -57,7 +57,6 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/visitor.hpp>
 
 #include <cstdint>
-#include <iterator>
 #include <memory>
 #include <string>
 #include <utility>
@@ -99,7 +98,9 @@ namespace osmium {
 
                 void write_field_timestamp(char c, const osmium::Timestamp& timestamp) {
                     *m_out += c;
-                    *m_out += timestamp.to_iso();
+                    if (timestamp) {
+                        output_timestamp(timestamp);
+                    }
                 }
 
                 void write_tags(const osmium::TagList& tags) {
@@ -151,18 +152,24 @@ namespace osmium {
                     write_tags(object.tags());
                 }
 
+                // Format both coordinates into a temporary buffer and
+                // append them in one go.
                 void write_location(const osmium::Location& location, const char x, const char y) {
+                    // Large enough for " x-214.7483648 y-214.7483648"
+                    char temp[32];
+                    char* t = temp;
                     const bool not_undefined = !location.is_undefined();
-                    *m_out += ' ';
-                    *m_out += x;
+                    *t++ = ' ';
+                    *t++ = x;
                     if (not_undefined) {
-                        osmium::detail::append_location_coordinate_to_string(std::back_inserter(*m_out), location.x());
+                        t = osmium::detail::append_location_coordinate_to_string(t, location.x());
                     }
-                    *m_out += ' ';
-                    *m_out += y;
+                    *t++ = ' ';
+                    *t++ = y;
                     if (not_undefined) {
-                        osmium::detail::append_location_coordinate_to_string(std::back_inserter(*m_out), location.y());
+                        t = osmium::detail::append_location_coordinate_to_string(t, location.y());
                     }
+                    m_out->append(temp, t);
                 }
 
                 void write_diff(const osmium::OSMObject& object) {
@@ -173,13 +180,18 @@ namespace osmium {
 
             public:
 
-                OPLOutputBlock(osmium::memory::Buffer&& buffer, const opl_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                template <typename TInput>
+                OPLOutputBlock(TInput&& input, const opl_output_options& options) :
+                    OutputBlock(std::forward<TInput>(input)),
                     m_options(options) {
                 }
 
                 std::string operator()() {
-                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    // The OPL is usually about as large as the objects in
+                    // the buffer.
+                    m_out->reserve(input_size());
+
+                    apply_input(*this);
 
                     std::string out;
                     using std::swap;
@@ -200,7 +212,8 @@ namespace osmium {
                     write_field_int('n', node_ref.ref());
                     *m_out += 'x';
                     if (node_ref.location()) {
-                        node_ref.location().as_string(std::back_inserter(*m_out), 'y');
+                        char temp[32];
+                        m_out->append(temp, node_ref.location().as_string(temp, 'y'));
                     } else {
                         *m_out += 'y';
                     }
@@ -295,7 +308,11 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(buffer), m_options}, osmium::thread::task_priority::high));
+                }
+
+                void write_selection(osmium::memory::BufferSelection&& selection) final {
+                    m_output_queue.push(m_pool.submit(OPLOutputBlock{std::move(selection), m_options}, osmium::thread::task_priority::high));
                 }
 
             }; // class OPLOutputFormat
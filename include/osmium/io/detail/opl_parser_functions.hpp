@@ -48,6 +48,20 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 
+#if defined(__SSE2__) && !defined(OSMIUM_NO_SIMD) && !defined(__SANITIZE_ADDRESS__)
+# if defined(__has_feature)
+#  if !__has_feature(address_sanitizer)
+#   define OSMIUM_OPL_USE_SSE2
+#  endif
+# else
+#  define OSMIUM_OPL_USE_SSE2
+# endif
+#endif
+
+#ifdef OSMIUM_OPL_USE_SSE2
+# include <emmintrin.h>
+#endif
+
 #include <cstdint>
 #include <cstdlib>
 #include <iterator>
@@ -173,27 +187,103 @@ namespace osmium {
                 throw opl_error{"hex escape too long", s};
             }
 
+            /**
+             * Is this character one that ends a plain run of characters in
+             * an OPL string? These are the end of string, space, tab, comma,
+             * and equal sign which end the string, and the percent sign
+             * which starts an escape sequence. All of them are below 64, so
+             * a single 64 bit mask can be used for the check.
+             */
+            inline bool opl_is_string_special(char c) noexcept {
+                constexpr const uint64_t mask = (1ULL << 0U)  | // '\0'
+                                                (1ULL << 9U)  | // '\t'
+                                                (1ULL << 32U) | // ' '
+                                                (1ULL << 37U) | // '%'
+                                                (1ULL << 44U) | // ','
+                                                (1ULL << 61U);  // '='
+                const auto uc = static_cast<unsigned char>(c);
+                return uc < 64U && ((mask >> uc) & 1U) != 0;
+            }
+
+            /**
+             * Find the first special character (see opl_is_string_special())
+             * at or after s. The string must be null-terminated.
+             */
+            inline const char* opl_find_string_special_scalar(const char* s) noexcept {
+                while (!opl_is_string_special(*s)) {
+                    ++s;
+                }
+                return s;
+            }
+
+#ifdef OSMIUM_OPL_USE_SSE2
+            inline unsigned int opl_string_special_mask(__m128i data) noexcept {
+                __m128i m = _mm_cmpeq_epi8(data, _mm_setzero_si128());
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('\t')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8(' ')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('%')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8(',')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('=')));
+                return static_cast<unsigned int>(_mm_movemask_epi8(m));
+            }
+
+            /**
+             * SSE2 version of opl_find_string_special_scalar() checking 16
+             * bytes at a time. Only aligned loads are used, so we never read
+             * across a page boundary even though we might read a few bytes
+             * after the terminating null byte.
+             */
+            inline const char* opl_find_string_special_sse2(const char* s) noexcept {
+                const auto offset = static_cast<unsigned int>(reinterpret_cast<uintptr_t>(s) & 15U);
+                const char* block = s - offset;
+                unsigned int mask = opl_string_special_mask(_mm_load_si128(reinterpret_cast<const __m128i*>(block))) & (0xffffU << offset);
+                while (mask == 0) {
+                    block += 16;
+                    mask = opl_string_special_mask(_mm_load_si128(reinterpret_cast<const __m128i*>(block)));
+                }
+                return block + __builtin_ctz(mask);
+            }
+#endif
+
+            /**
+             * Find the first special character (see opl_is_string_special())
+             * at or after s. The string must be null-terminated.
+             */
+            inline const char* opl_find_string_special(const char* s) noexcept {
+#ifdef OSMIUM_OPL_USE_SSE2
+                // Most strings in OPL files are short, check the first few
+                // characters before switching to SSE2.
+                for (int i = 0; i < 8; ++i, ++s) {
+                    if (opl_is_string_special(*s)) {
+                        return s;
+                    }
+                }
+                return opl_find_string_special_sse2(s);
+#else
+                return opl_find_string_special_scalar(s);
+#endif
+            }
+
             /**
              * Parse a string up to end of string or next space, tab, comma, or
              * equal sign.
              *
-             * Appends characters to the result string.
+             * Appends characters to the result string. Runs of characters
+             * without escapes are appended in one go.
              *
              * Returns a pointer to next character that needs to be consumed.
              */
             inline void opl_parse_string(const char** data, std::string& result) {
                 const char* s = *data;
                 while (true) {
-                    if (*s == '\0' || *s == ' ' || *s == '\t' || *s == ',' || *s == '=') {
+                    const char* end = opl_find_string_special(s);
+                    result.append(s, end);
+                    s = end;
+                    if (*s != '%') {
                         break;
                     }
-                    if (*s == '%') {
-                        ++s;
-                        opl_parse_escaped(&s, result);
-                    } else {
-                        result += *s;
-                        ++s;
-                    }
+                    ++s;
+                    opl_parse_escaped(&s, result);
                 }
                 *data = s;
             }
@@ -213,22 +303,29 @@ namespace osmium {
                     ++*s;
                 }
 
-                int64_t value = 0;
-
-                int n = max_int_len;
-                while (**s >= '0' && **s <= '9') {
-                    if (--n == 0) {
-                        throw opl_error{"integer too long", *s};
+                // Work on a local copy of the pointer and an unsigned
+                // accumulator, so the compiler can keep both in registers.
+                const char* p = *s;
+                const char* const start = p;
+                uint64_t uvalue = 0;
+                unsigned int digit;
+                while ((digit = static_cast<unsigned char>(*p) - static_cast<unsigned int>('0')) < 10U) {
+                    if (p - start == max_int_len - 1) {
+                        *s = p;
+                        throw opl_error{"integer too long", p};
                     }
-                    value *= 10;
-                    value += **s - '0';
-                    ++*s;
+                    uvalue = uvalue * 10U + digit;
+                    ++p;
                 }
+                *s = p;
 
-                if (n == max_int_len) {
-                    throw opl_error{"expected integer", *s};
+                if (p == start) {
+                    throw opl_error{"expected integer", p};
                 }
 
+                // Can not overflow, because there are at most 15 digits.
+                auto value = static_cast<int64_t>(uvalue);
+
                 if (negative) {
                     value = -value;
                     if (value < std::numeric_limits<T>::min()) {
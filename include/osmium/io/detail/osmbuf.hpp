@@ -0,0 +1,234 @@
+#ifndef OSMIUM_IO_DETAIL_OSMBUF_HPP
+#define OSMIUM_IO_DETAIL_OSMBUF_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/error.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace osmium {
+
+    /**
+     * Exception thrown when there was a problem with parsing the osmbuf
+     * format of a file.
+     */
+    struct osmbuf_error : public io_error {
+
+        explicit osmbuf_error(const char* what) :
+            io_error(std::string{"osmbuf format error: "} + what) {
+        }
+
+    }; // struct osmbuf_error
+
+    namespace io {
+
+        namespace detail {
+
+            /*
+             * The osmbuf format stores the contents of osmium::memory::Buffer
+             * objects exactly as they are laid out in memory. It can only be
+             * read on machines with the same byte order and alignment as the
+             * one it was written on. All integers are in native byte order.
+             *
+             * File header:
+             *   8 bytes  magic "OSMIUMBF"
+             *   4 bytes  format version
+             *   4 bytes  byte order mark 0x01020304
+             *   4 bytes  alignment of items in buffers
+             *   4 bytes  size of the following header data
+             *   header data (boxes and options), padded to the alignment
+             *
+             * Each block:
+             *   4 bytes  magic "BLCK"
+             *   4 bytes  CRC32 of the data
+             *   8 bytes  size of the data (a multiple of the alignment)
+             *   data     committed contents of one buffer
+             *
+             * Block index:
+             *   4 bytes  magic "INDX"
+             *   4 bytes  unused (0)
+             *   8 bytes  number of blocks
+             *   16 bytes per block: offset of the block header in the file
+             *            and size of the data
+             *
+             * Trailer:
+             *   8 bytes  offset of the block index in the file
+             *   8 bytes  magic "OSMBFEND"
+             */
+
+            const char osmbuf_file_magic[] = "OSMIUMBF";
+            const char osmbuf_block_magic[] = "BLCK";
+            const char osmbuf_index_magic[] = "INDX";
+            const char osmbuf_end_magic[] = "OSMBFEND";
+
+            enum : std::size_t {
+                osmbuf_file_header_size  = 24,
+                osmbuf_block_header_size = 16,
+                osmbuf_index_header_size = 16,
+                osmbuf_index_entry_size  = 16,
+                osmbuf_trailer_size      = 16
+            };
+
+            enum : uint32_t {
+                osmbuf_version = 1,
+                osmbuf_byte_order_mark = 0x01020304
+            };
+
+            // CRC32 is calculated with zlib which only takes 32 bit
+            // sizes.
+            const uint64_t osmbuf_max_block_size = 0xffffffffull & ~(osmium::memory::align_bytes - 1);
+
+            inline void osmbuf_append(std::string& out, uint32_t value) {
+                out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+
+            inline void osmbuf_append(std::string& out, uint64_t value) {
+                out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+            }
+
+            inline void osmbuf_append_string(std::string& out, const std::string& str) {
+                osmbuf_append(out, static_cast<uint32_t>(str.size()));
+                out += str;
+            }
+
+            inline uint32_t osmbuf_get_uint32(const char* data) noexcept {
+                uint32_t value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+            }
+
+            inline uint64_t osmbuf_get_uint64(const char* data) noexcept {
+                uint64_t value;
+                std::memcpy(&value, data, sizeof(value));
+                return value;
+            }
+
+            /**
+             * Encode the header data: A flag for multiple object versions,
+             * the bounding boxes, and the options.
+             */
+            inline std::string encode_osmbuf_header(const osmium::io::Header& header) {
+                std::string data;
+
+                osmbuf_append(data, static_cast<uint32_t>(header.has_multiple_object_versions()));
+
+                osmbuf_append(data, static_cast<uint32_t>(header.boxes().size()));
+                for (const auto& box : header.boxes()) {
+                    osmbuf_append(data, static_cast<uint32_t>(box.bottom_left().x()));
+                    osmbuf_append(data, static_cast<uint32_t>(box.bottom_left().y()));
+                    osmbuf_append(data, static_cast<uint32_t>(box.top_right().x()));
+                    osmbuf_append(data, static_cast<uint32_t>(box.top_right().y()));
+                }
+
+                osmbuf_append(data, static_cast<uint32_t>(header.size()));
+                for (const auto& option : header) {
+                    osmbuf_append_string(data, option.first);
+                    osmbuf_append_string(data, option.second);
+                }
+
+                return data;
+            }
+
+            class OsmbufHeaderDecoder {
+
+                const char* m_data;
+                const char* m_end;
+
+                uint32_t get_uint32() {
+                    if (m_end - m_data < 4) {
+                        throw osmium::osmbuf_error{"header data too short"};
+                    }
+                    const auto value = osmbuf_get_uint32(m_data);
+                    m_data += 4;
+                    return value;
+                }
+
+                int32_t get_coordinate() {
+                    return static_cast<int32_t>(get_uint32());
+                }
+
+                std::string get_string() {
+                    const auto size = get_uint32();
+                    if (static_cast<std::size_t>(m_end - m_data) < size) {
+                        throw osmium::osmbuf_error{"header data too short"};
+                    }
+                    std::string str(m_data, size);
+                    m_data += size;
+                    return str;
+                }
+
+            public:
+
+                OsmbufHeaderDecoder(const char* data, std::size_t size) noexcept :
+                    m_data(data),
+                    m_end(data + size) {
+                }
+
+                osmium::io::Header operator()() {
+                    osmium::io::Header header;
+
+                    header.set_has_multiple_object_versions(get_uint32() != 0);
+
+                    for (auto num_boxes = get_uint32(); num_boxes > 0; --num_boxes) {
+                        const auto x1 = get_coordinate();
+                        const auto y1 = get_coordinate();
+                        const auto x2 = get_coordinate();
+                        const auto y2 = get_coordinate();
+                        header.add_box(osmium::Box{osmium::Location{x1, y1}, osmium::Location{x2, y2}});
+                    }
+
+                    for (auto num_options = get_uint32(); num_options > 0; --num_options) {
+                        const std::string key{get_string()};
+                        header.set(key, get_string());
+                    }
+
+                    return header;
+                }
+
+            }; // class OsmbufHeaderDecoder
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_OSMBUF_HPP
@@ -0,0 +1,399 @@
+#ifndef OSMIUM_IO_DETAIL_OSMBUF_INPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_OSMBUF_INPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/osmbuf.hpp> // IWYU pragma: export
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/crc_zlib.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/util.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Turns the data of one block of an osmbuf file into a buffer.
+             * There is nothing to decode, the data is checked against the
+             * checksum and copied into the buffer. Only if not all entity
+             * types should be read or a prefilter is set, the items are
+             * copied one by one.
+             */
+            class OsmbufBlockDecoder {
+
+                std::shared_ptr<const void> m_input_owner;
+                const char* m_data;
+                std::size_t m_size;
+                uint32_t m_crc;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::io::tag_prefilter m_prefilter;
+
+            public:
+
+                OsmbufBlockDecoder(std::shared_ptr<const void> input_owner, const char* data, std::size_t size, uint32_t crc, osmium::osm_entity_bits::type read_types, const osmium::io::tag_prefilter& prefilter) :
+                    m_input_owner(std::move(input_owner)),
+                    m_data(data),
+                    m_size(size),
+                    m_crc(crc),
+                    m_read_types(read_types),
+                    m_prefilter(prefilter) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    osmium::CRC_zlib crc;
+                    crc.process_bytes(m_data, m_size);
+                    if (crc.checksum() != m_crc) {
+                        throw osmium::osmbuf_error{"checksum mismatch"};
+                    }
+
+                    std::unique_ptr<unsigned char[]> memory{new unsigned char[m_size]};
+                    std::memcpy(memory.get(), m_data, m_size);
+                    osmium::memory::Buffer buffer{std::move(memory), m_size, m_size};
+
+                    if ((m_read_types & osmium::osm_entity_bits::all) != osmium::osm_entity_bits::all) {
+                        osmium::memory::Buffer output{m_size, osmium::memory::Buffer::auto_grow::yes};
+                        for (const auto& item : buffer) {
+                            if (m_read_types & osmium::osm_entity_bits::from_item_type(item.type())) {
+                                output.add_item(item);
+                                output.commit();
+                            }
+                        }
+                        buffer = std::move(output);
+                    }
+
+                    if (m_prefilter.enabled()) {
+                        return apply_tag_prefilter(m_prefilter, buffer);
+                    }
+
+                    return buffer;
+                }
+
+            }; // class OsmbufBlockDecoder
+
+            class OsmbufWindowedBlockDecoder {
+
+                OsmbufBlockDecoder m_decoder;
+                std::shared_ptr<DecodeWindow> m_window;
+                std::size_t m_bytes;
+
+            public:
+
+                OsmbufWindowedBlockDecoder(OsmbufBlockDecoder&& decoder, std::shared_ptr<DecodeWindow> window, std::size_t bytes) :
+                    m_decoder(std::move(decoder)),
+                    m_window(std::move(window)),
+                    m_bytes(bytes) {
+                    m_window->add(m_bytes);
+                }
+
+                osmium::memory::Buffer operator()() {
+                    try {
+                        auto buffer = m_decoder();
+                        m_window->remove(m_bytes);
+                        return buffer;
+                    } catch (...) {
+                        m_window->remove(m_bytes);
+                        throw;
+                    }
+                }
+
+            }; // class OsmbufWindowedBlockDecoder
+
+            class OsmbufParser : public Parser {
+
+                // The chunk of input data we are currently working on, the
+                // object owning its memory (a string from the input queue or
+                // the memory mapping of the whole file) and the offset of the
+                // first byte in it not used yet.
+                std::shared_ptr<const void> m_input_owner{};
+                const char* m_input_data = nullptr;
+                std::size_t m_input_size = 0;
+                std::size_t m_input_offset = 0;
+
+                // Offset in the input file of the first byte not used yet.
+                std::size_t m_file_offset = 0;
+
+                // Blocks being checked and copied in the thread pool. This
+                // is a nullptr if this is done in the parser thread.
+                std::shared_ptr<DecodeWindow> m_decode_window;
+
+                std::size_t input_available() const noexcept {
+                    return m_input_size - m_input_offset;
+                }
+
+                void next_input_chunk() {
+                    std::string new_data{get_input()};
+                    if (input_done()) {
+                        throw osmium::osmbuf_error{"truncated data (EOF encountered)"};
+                    }
+                    auto chunk = std::make_shared<std::string>(std::move(new_data));
+                    m_input_data = chunk->data();
+                    m_input_size = chunk->size();
+                    m_input_owner = std::move(chunk);
+                    m_input_offset = 0;
+                }
+
+                /**
+                 * Read the given number of bytes from the input. Like in the
+                 * PBF parser the data is only copied if it spans several
+                 * input chunks, otherwise the result points into the chunk
+                 * which is kept alive by the shared pointer returned with it.
+                 */
+                std::pair<std::shared_ptr<const void>, const char*> read_from_input(std::size_t size) {
+                    m_file_offset += size;
+
+                    if (input_available() == 0 && size > 0) {
+                        next_input_chunk();
+                    }
+
+                    if (input_available() >= size) {
+                        const char* data = m_input_data + m_input_offset;
+                        m_input_offset += size;
+                        return std::make_pair(m_input_owner, data);
+                    }
+
+                    auto joined = std::make_shared<std::string>();
+                    joined->reserve(size);
+                    joined->append(m_input_data + m_input_offset, input_available());
+                    while (joined->size() < size) {
+                        next_input_chunk();
+                        const auto len = std::min(size - joined->size(), m_input_size);
+                        joined->append(m_input_data, len);
+                        m_input_offset = len;
+                    }
+
+                    const char* data = joined->data();
+                    return std::make_pair(std::shared_ptr<const void>{std::move(joined)}, data);
+                }
+
+                void skip_input(std::size_t size) {
+                    m_file_offset += size;
+
+                    while (size > input_available()) {
+                        size -= input_available();
+                        next_input_chunk();
+                    }
+                    m_input_offset += size;
+                }
+
+                void parse_file_header() {
+                    const char* data = read_from_input(osmbuf_file_header_size).second;
+
+                    if (std::memcmp(data, osmbuf_file_magic, 8) != 0) {
+                        throw osmium::osmbuf_error{"wrong file magic"};
+                    }
+                    if (osmbuf_get_uint32(data + 8) != osmbuf_version) {
+                        throw osmium::osmbuf_error{"unknown format version"};
+                    }
+                    if (osmbuf_get_uint32(data + 12) != osmbuf_byte_order_mark) {
+                        throw osmium::osmbuf_error{"file was written on a machine with different byte order"};
+                    }
+                    if (osmbuf_get_uint32(data + 16) != osmium::memory::align_bytes) {
+                        throw osmium::osmbuf_error{"file was written with different alignment"};
+                    }
+
+                    const std::size_t header_data_size = osmbuf_get_uint32(data + 20);
+                    const auto padded_size = osmium::memory::padded_length(osmbuf_file_header_size + header_data_size) - osmbuf_file_header_size;
+                    const auto header_data = read_from_input(padded_size);
+
+                    set_header_value(OsmbufHeaderDecoder{header_data.second, header_data_size}());
+                }
+
+                void decode_block(std::shared_ptr<const void>&& owner, const char* data, std::size_t size, uint32_t crc) {
+                    OsmbufBlockDecoder decoder{std::move(owner), data, size, crc, read_types(), prefilter()};
+
+                    if (m_decode_window) {
+                        submit_to_output_queue(OsmbufWindowedBlockDecoder{std::move(decoder), m_decode_window, size});
+                    } else {
+                        send_to_output_queue(decoder());
+                    }
+                }
+
+                static uint64_t check_block_size(uint64_t size) {
+                    if (size > osmbuf_max_block_size || size % osmium::memory::align_bytes != 0) {
+                        throw osmium::osmbuf_error{"invalid block size"};
+                    }
+                    return size;
+                }
+
+                // Read all blocks one after the other up to the index.
+                void parse_blocks() {
+                    while (true) {
+                        const auto block_offset = m_file_offset;
+                        const char* data = read_from_input(osmbuf_block_header_size).second;
+
+                        if (std::memcmp(data, osmbuf_index_magic, 4) == 0) {
+                            return;
+                        }
+                        if (std::memcmp(data, osmbuf_block_magic, 4) != 0) {
+                            throw osmium::osmbuf_error{"expected block header"};
+                        }
+
+                        const auto crc = osmbuf_get_uint32(data + 4);
+                        const auto size = static_cast<std::size_t>(check_block_size(osmbuf_get_uint64(data + 8)));
+
+                        if (read_blobs().contains(block_offset)) {
+                            auto block = read_from_input(size);
+                            decode_block(std::move(block.first), block.second, size, crc);
+                        } else {
+                            skip_input(size);
+                        }
+                    }
+                }
+
+                // Find the blocks through the index at the end of the
+                // memory-mapped file.
+                void parse_blocks_from_index() {
+                    const char* const file = m_input_data;
+                    const uint64_t file_size = m_input_size;
+
+                    if (file_size < m_file_offset + osmbuf_index_header_size + osmbuf_trailer_size) {
+                        throw osmium::osmbuf_error{"file too short"};
+                    }
+
+                    const char* trailer = file + file_size - osmbuf_trailer_size;
+                    if (std::memcmp(trailer + 8, osmbuf_end_magic, 8) != 0) {
+                        throw osmium::osmbuf_error{"missing trailer (truncated file?)"};
+                    }
+
+                    const auto index_offset = osmbuf_get_uint64(trailer);
+                    if (index_offset < m_file_offset ||
+                        index_offset > file_size - osmbuf_trailer_size - osmbuf_index_header_size ||
+                        std::memcmp(file + index_offset, osmbuf_index_magic, 4) != 0) {
+                        throw osmium::osmbuf_error{"invalid index offset"};
+                    }
+
+                    const auto num_blocks = osmbuf_get_uint64(file + index_offset + 8);
+                    if (num_blocks != (file_size - osmbuf_trailer_size - osmbuf_index_header_size - index_offset) / osmbuf_index_entry_size) {
+                        throw osmium::osmbuf_error{"invalid index size"};
+                    }
+
+                    const char* entry = file + index_offset + osmbuf_index_header_size;
+                    for (uint64_t n = 0; n < num_blocks; ++n, entry += osmbuf_index_entry_size) {
+                        const auto block_offset = osmbuf_get_uint64(entry);
+                        const auto size = check_block_size(osmbuf_get_uint64(entry + 8));
+
+                        if (block_offset < m_file_offset ||
+                            block_offset > index_offset ||
+                            size > index_offset - block_offset - osmbuf_block_header_size) {
+                            throw osmium::osmbuf_error{"invalid index entry"};
+                        }
+
+                        const char* data = file + block_offset;
+                        if (std::memcmp(data, osmbuf_block_magic, 4) != 0 ||
+                            osmbuf_get_uint64(data + 8) != size) {
+                            throw osmium::osmbuf_error{"index entry doesn't match block"};
+                        }
+
+                        if (read_blobs().contains(block_offset)) {
+                            decode_block(std::shared_ptr<const void>{m_input_owner}, data + osmbuf_block_header_size, static_cast<std::size_t>(size), osmbuf_get_uint32(data + 4));
+                        }
+                    }
+                }
+
+            public:
+
+                explicit OsmbufParser(parser_arguments& args) :
+                    Parser(args) {
+                    set_prefilter_applied();
+
+                    if (mapped_input()) {
+                        m_input_data = mapped_input()->get_addr<const char>();
+                        m_input_size = mapped_input()->size();
+                        m_input_owner = mapped_input();
+                    }
+
+                    m_decode_window = make_decode_window();
+                }
+
+                OsmbufParser(const OsmbufParser&) = delete;
+                OsmbufParser& operator=(const OsmbufParser&) = delete;
+
+                OsmbufParser(OsmbufParser&&) = delete;
+                OsmbufParser& operator=(OsmbufParser&&) = delete;
+
+                ~OsmbufParser() noexcept final = default;
+
+                void run() final {
+                    osmium::thread::set_thread_name("_osmium_obf_in");
+
+                    parse_file_header();
+
+                    if (read_types() == osmium::osm_entity_bits::nothing) {
+                        return;
+                    }
+
+                    if (mapped_input()) {
+                        parse_blocks_from_index();
+                    } else {
+                        parse_blocks();
+                    }
+                }
+
+            }; // class OsmbufParser
+
+            // we want the register_parser() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_osmbuf_parser = ParserFactory::instance().register_parser(
+                file_format::osmbuf,
+                [](parser_arguments& args) {
+                    return std::unique_ptr<Parser>(new OsmbufParser{args});
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_osmbuf_parser() noexcept {
+                return registered_osmbuf_parser;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_OSMBUF_INPUT_FORMAT_HPP
@@ -0,0 +1,173 @@
+#ifndef OSMIUM_IO_DETAIL_OSMBUF_OUTPUT_FORMAT_HPP
+#define OSMIUM_IO_DETAIL_OSMBUF_OUTPUT_FORMAT_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/osmbuf.hpp>
+#include <osmium/io/detail/output_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/crc_zlib.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Creates one block of an osmbuf file from a buffer: The block
+             * header with the checksum followed by the committed data of
+             * the buffer.
+             */
+            class OsmbufOutputBlock {
+
+                std::shared_ptr<osmium::memory::Buffer> m_input_buffer;
+
+            public:
+
+                explicit OsmbufOutputBlock(osmium::memory::Buffer&& buffer) :
+                    m_input_buffer(std::make_shared<osmium::memory::Buffer>(std::move(buffer))) {
+                }
+
+                std::string operator()() {
+                    const auto size = m_input_buffer->committed();
+
+                    osmium::CRC_zlib crc;
+                    crc.process_bytes(m_input_buffer->data(), size);
+
+                    std::string out;
+                    out.reserve(osmbuf_block_header_size + size);
+                    out.append(osmbuf_block_magic, 4);
+                    osmbuf_append(out, static_cast<uint32_t>(crc.checksum()));
+                    osmbuf_append(out, static_cast<uint64_t>(size));
+                    out.append(reinterpret_cast<const char*>(m_input_buffer->data()), size);
+
+                    return out;
+                }
+
+            }; // class OsmbufOutputBlock
+
+            class OsmbufOutputFormat : public osmium::io::detail::OutputFormat {
+
+                // Offset of the next block in the file.
+                uint64_t m_offset = 0;
+
+                // Offset and data size of all blocks written.
+                std::vector<std::pair<uint64_t, uint64_t>> m_index;
+
+            public:
+
+                OsmbufOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& /*file*/, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue) {
+                }
+
+                void write_header(const osmium::io::Header& header) final {
+                    const std::string data{encode_osmbuf_header(header)};
+
+                    std::string out{osmbuf_file_magic, 8};
+                    osmbuf_append(out, static_cast<uint32_t>(osmbuf_version));
+                    osmbuf_append(out, static_cast<uint32_t>(osmbuf_byte_order_mark));
+                    osmbuf_append(out, static_cast<uint32_t>(osmium::memory::align_bytes));
+                    osmbuf_append(out, static_cast<uint32_t>(data.size()));
+                    out += data;
+                    out.resize(osmium::memory::padded_length(out.size()));
+
+                    m_offset = out.size();
+                    send_to_output_queue(std::move(out));
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    const auto size = static_cast<uint64_t>(buffer.committed());
+                    if (size == 0) {
+                        return;
+                    }
+                    if (size > osmbuf_max_block_size) {
+                        throw osmium::osmbuf_error{"buffer too large"};
+                    }
+
+                    m_index.emplace_back(m_offset, size);
+                    m_offset += osmbuf_block_header_size + size;
+
+                    m_output_queue.push(m_pool.submit(OsmbufOutputBlock{std::move(buffer)}, osmium::thread::task_priority::high));
+                }
+
+                void write_end() final {
+                    std::string out{osmbuf_index_magic, 4};
+                    out.reserve(osmbuf_index_header_size + m_index.size() * osmbuf_index_entry_size + osmbuf_trailer_size);
+                    osmbuf_append(out, static_cast<uint32_t>(0));
+                    osmbuf_append(out, static_cast<uint64_t>(m_index.size()));
+                    for (const auto& entry : m_index) {
+                        osmbuf_append(out, entry.first);
+                        osmbuf_append(out, entry.second);
+                    }
+
+                    osmbuf_append(out, m_offset);
+                    out.append(osmbuf_end_magic, 8);
+
+                    send_to_output_queue(std::move(out));
+                }
+
+            }; // class OsmbufOutputFormat
+
+            // we want the register_output_format() function to run, setting
+            // the variable is only a side-effect, it will never be used
+            const bool registered_osmbuf_output = osmium::io::detail::OutputFormatFactory::instance().register_output_format(osmium::io::file_format::osmbuf,
+                [](osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) {
+                    return new osmium::io::detail::OsmbufOutputFormat(pool, file, output_queue);
+            });
+
+            // dummy function to silence the unused variable warning from above
+            inline bool get_registered_osmbuf_output() noexcept {
+                return registered_osmbuf_output;
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_OSMBUF_OUTPUT_FORMAT_HPP
@@ -38,8 +38,13 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
+#include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_selection.hpp>
+#include <osmium/osm/timestamp.hpp>
 #include <osmium/thread/pool.hpp>
+#include <osmium/util/number_format.hpp>
+#include <osmium/visitor.hpp>
 
 #include <array>
 #include <cstdint>
@@ -64,6 +69,11 @@ namespace osmium {
 
                 std::shared_ptr<osmium::memory::Buffer> m_input_buffer;
 
+                // If this is set, only the selected objects are written
+                // instead of the whole m_input_buffer (which is not set
+                // then).
+                std::shared_ptr<const osmium::memory::BufferSelection> m_input_selection;
+
                 std::shared_ptr<std::string> m_out;
 
                 explicit OutputBlock(osmium::memory::Buffer&& buffer) :
@@ -71,28 +81,38 @@ namespace osmium {
                     m_out(std::make_shared<std::string>()) {
                 }
 
-                // Simple function to convert integer to string. This is much
-                // faster than using sprintf, but could be further optimized.
-                // See https://github.com/miloyip/itoa-benchmark .
-                void output_int(int64_t value) {
-                    if (value < 0) {
-                        *m_out += '-';
-                        value = -value;
+                explicit OutputBlock(osmium::memory::BufferSelection&& selection) :
+                    m_input_selection(std::make_shared<const osmium::memory::BufferSelection>(std::move(selection))),
+                    m_out(std::make_shared<std::string>()) {
+                }
+
+                // Size of the input objects in bytes.
+                std::size_t input_size() const noexcept {
+                    return m_input_selection ? m_input_selection->byte_size() : m_input_buffer->committed();
+                }
+
+                // Call the handler for all input objects.
+                template <typename THandler>
+                void apply_input(THandler& handler) {
+                    if (m_input_selection) {
+                        osmium::apply(m_input_selection->cbegin(), m_input_selection->cend(), handler);
+                    } else {
+                        osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), handler);
                     }
+                }
 
+                // Convert integer to string two digits at a time using a
+                // lookup table. See https://github.com/miloyip/itoa-benchmark .
+                void output_int(int64_t value) {
                     char temp[20];
-                    char *t = temp;
-                    do {
-                        *t++ = char(value % 10) + '0';
-                        value /= 10;
-                    } while (value > 0);
+                    m_out->append(temp, osmium::detail::format_int(value, temp));
+                }
 
-                    const auto old_size = m_out->size();
-                    m_out->resize(old_size + (t - temp));
-                    char* data = &(*m_out)[old_size];
-                    do {
-                        *data++ += *--t;
-                    } while (t != temp);
+                // Append timestamp in ISO format without going through a
+                // temporary string.
+                void output_timestamp(const osmium::Timestamp& timestamp) {
+                    char temp[20];
+                    m_out->append(temp, timestamp.to_iso(temp));
                 }
 
             }; // class OutputBlock;
@@ -139,6 +159,36 @@ namespace osmium {
 
                 virtual void write_buffer(osmium::memory::Buffer&& /*buffer*/) = 0;
 
+                /**
+                 * Write the selected objects. Formats encoding objects one
+                 * by one override this to encode them directly from the
+                 * buffer of the selection. The default implementation
+                 * copies them into a new buffer and calls write_buffer().
+                 */
+                virtual void write_selection(osmium::memory::BufferSelection&& selection) {
+                    write_buffer(selection.copy());
+                }
+
+                /**
+                 * Write data which is already encoded in the given format,
+                 * usually a complete blob from another PBF file, to the
+                 * output as it is. Returns false if this output format can
+                 * not do that. The caller has to decode the data and use
+                 * write_buffer() then.
+                 */
+                virtual bool write_raw(std::string&& /*data*/, osmium::io::file_format /*format*/) {
+                    return false;
+                }
+
+                /**
+                 * Use the given lookup to add node locations to ways while
+                 * encoding them. Returns false if this output format can
+                 * not do that.
+                 */
+                virtual bool set_way_node_locations(const osmium::io::way_node_locations& /*lookup*/) {
+                    return false;
+                }
+
                 virtual void write_end() {
                 }
 
@@ -0,0 +1,200 @@
+#ifndef OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/trace.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Base class for compressors which cut the data into chunks
+             * and compress each chunk independently in the thread pool.
+             * The compressed chunks are written out in order. This works
+             * for formats where the concatenation of several compressed
+             * streams is a valid stream, such as multi-member gzip files
+             * or multi-stream bzip2 files.
+             */
+            class ParallelCompressor : public Compressor {
+
+            public:
+
+                using compress_function_type = std::function<std::string(const std::string&)>;
+
+            private:
+
+                class compress_task {
+
+                    compress_function_type m_compress;
+                    std::string m_data;
+
+                public:
+
+                    compress_task(const compress_function_type& compress, std::string&& data) :
+                        m_compress(compress),
+                        m_data(std::move(data)) {
+                    }
+
+                    std::string operator()() const {
+                        const osmium::trace::Span span{"compress"};
+                        return m_compress(m_data);
+                    }
+
+                }; // class compress_task
+
+                osmium::thread::Pool& m_pool;
+                compress_function_type m_compress;
+                std::deque<std::future<std::string>> m_results;
+                std::string m_chunk;
+                std::size_t m_chunk_size;
+                std::size_t m_max_in_flight;
+                int m_fd;
+                bool m_submitted = false;
+
+                void write_result() {
+                    const std::string data{m_results.front().get()};
+                    m_results.pop_front();
+                    osmium::io::detail::reliable_write(m_fd, data.data(), data.size());
+                }
+
+                void submit_chunk() {
+                    std::string chunk;
+                    using std::swap;
+                    swap(chunk, m_chunk);
+                    m_chunk.reserve(m_chunk_size);
+
+                    m_results.push_back(m_pool.submit(compress_task{m_compress, std::move(chunk)}, osmium::thread::task_priority::high));
+                    m_submitted = true;
+
+                    while (m_results.size() > m_max_in_flight ||
+                           (!m_results.empty() && m_results.front().wait_for(std::chrono::seconds{0}) == std::future_status::ready)) {
+                        write_result();
+                    }
+                }
+
+            public:
+
+                /**
+                 * @param fd File descriptor to write to.
+                 * @param sync Should fsync be called on close?
+                 * @param pool Thread pool used for compressing.
+                 * @param chunk_size Size of uncompressed chunks.
+                 * @param compress Function compressing one chunk into a
+                 *                 complete compressed stream.
+                 */
+                ParallelCompressor(const int fd, const fsync sync, osmium::thread::Pool& pool,
+                                   const std::size_t chunk_size, compress_function_type&& compress) :
+                    Compressor(sync),
+                    m_pool(pool),
+                    m_compress(std::move(compress)),
+                    m_chunk_size(chunk_size),
+                    m_max_in_flight(static_cast<std::size_t>(pool.num_threads()) * 2),
+                    m_fd(fd) {
+                    m_chunk.reserve(m_chunk_size);
+                }
+
+                ParallelCompressor(const ParallelCompressor&) = delete;
+                ParallelCompressor& operator=(const ParallelCompressor&) = delete;
+
+                ParallelCompressor(ParallelCompressor&&) = delete;
+                ParallelCompressor& operator=(ParallelCompressor&&) = delete;
+
+                ~ParallelCompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                void write(const std::string& data) final {
+                    m_chunk += data;
+                    if (m_chunk.size() >= m_chunk_size) {
+                        submit_chunk();
+                    }
+                }
+
+                void close() final {
+                    if (m_fd < 0) {
+                        return;
+                    }
+
+                    const int fd = m_fd;
+                    try {
+                        // An empty file still gets one (empty) compressed
+                        // stream so that it can be read.
+                        if (!m_chunk.empty() || !m_submitted) {
+                            submit_chunk();
+                        }
+                        while (!m_results.empty()) {
+                            write_result();
+                        }
+                    } catch (...) {
+                        m_fd = -1;
+                        m_results.clear();
+                        osmium::io::detail::reliable_close(fd);
+                        throw;
+                    }
+
+                    m_fd = -1;
+                    if (do_fsync()) {
+                        osmium::io::detail::reliable_fsync(fd);
+                    }
+                    osmium::io::detail::reliable_close(fd);
+                }
+
+            }; // class ParallelCompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PARALLEL_COMPRESSOR_HPP
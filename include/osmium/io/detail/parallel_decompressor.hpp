@@ -0,0 +1,317 @@
+#ifndef OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
+#define OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/config.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Decoder for compressed data consisting of one or more
+             * concatenated compressed streams (gzip members or bzip2
+             * streams). The data can be fed in pieces.
+             */
+            class stream_decoder {
+
+            public:
+
+                stream_decoder() = default;
+
+                stream_decoder(const stream_decoder&) = delete;
+                stream_decoder& operator=(const stream_decoder&) = delete;
+
+                stream_decoder(stream_decoder&&) = delete;
+                stream_decoder& operator=(stream_decoder&&) = delete;
+
+                virtual ~stream_decoder() noexcept = default;
+
+                /**
+                 * Decompress the data and append the result to output.
+                 *
+                 * @returns true if the data ended exactly at the end of a
+                 *          compressed stream, false if more data is
+                 *          needed.
+                 * @throws Some form of osmium::io_error if the data is
+                 *         invalid.
+                 */
+                virtual bool decode(const char* data, std::size_t size, std::string& output) = 0;
+
+                /**
+                 * Called if the input ends in the middle of a stream.
+                 *
+                 * @throws Some form of osmium::io_error.
+                 */
+                virtual void end_of_input() = 0;
+
+            }; // class stream_decoder
+
+            /**
+             * Base class for decompressors which decompress segments of
+             * the input in the thread pool. The parts of the input that
+             * look like the start of a compressed stream are candidates
+             * for cutting the input into segments. Each segment is then
+             * decompressed independently. If a segment doesn't end
+             * exactly at the end of a stream (because the candidate was a
+             * false positive or because there are no streams boundaries
+             * at all), the input is decompressed in the reading thread
+             * until the next stream boundary is reached.
+             */
+            class ParallelDecompressor : public Decompressor {
+
+            public:
+
+                using create_decoder_type = std::function<std::unique_ptr<stream_decoder>()>;
+
+                /// Does the data (with the given number of bytes available)
+                /// look like the start of a stream?
+                using is_stream_start_type = std::function<bool(const char*, std::size_t)>;
+
+            private:
+
+                struct segment_result {
+                    std::string data{};
+                    bool complete = false;
+                };
+
+                class decode_task {
+
+                    create_decoder_type m_create_decoder;
+                    std::shared_ptr<const std::string> m_input;
+
+                public:
+
+                    decode_task(const create_decoder_type& create_decoder, const std::shared_ptr<const std::string>& input) :
+                        m_create_decoder(create_decoder),
+                        m_input(input) {
+                    }
+
+                    segment_result operator()() const {
+                        segment_result result;
+                        try {
+                            const auto decoder = m_create_decoder();
+                            result.complete = decoder->decode(m_input->data(), m_input->size(), result.data);
+                        } catch (...) {
+                            // The segment is decoded again in the reading
+                            // thread which will report any errors.
+                            result.complete = false;
+                        }
+                        if (!result.complete) {
+                            result.data.clear();
+                        }
+                        return result;
+                    }
+
+                }; // class decode_task
+
+                struct segment {
+                    std::shared_ptr<const std::string> input;
+                    std::future<segment_result> result;
+                };
+
+                osmium::thread::Pool& m_pool;
+                create_decoder_type m_create_decoder;
+                is_stream_start_type m_is_stream_start;
+                std::size_t m_segment_size;
+                std::size_t m_max_in_flight;
+                std::string m_input;
+                std::deque<segment> m_segments;
+                std::unique_ptr<stream_decoder> m_serial_decoder;
+                std::size_t m_offset = 0;
+                std::size_t m_read_offset = 0;
+                std::size_t m_read_size = osmium::config::get_read_size();
+                int m_fd;
+                read_advisor m_advisor;
+                char m_magic;
+                bool m_input_at_stream_start = true;
+                bool m_eof = false;
+
+                // Find the last possible start of a stream in the input
+                // after the first byte.
+                std::size_t find_last_stream_start() const {
+                    for (std::size_t pos = m_input.size() - 1; pos > 0; --pos) {
+                        if (m_input[pos] == m_magic && m_is_stream_start(m_input.data() + pos, m_input.size() - pos)) {
+                            return pos;
+                        }
+                    }
+                    return 0;
+                }
+
+                void add_segment(std::size_t size, bool at_stream_start) {
+                    segment seg;
+                    seg.input = std::make_shared<const std::string>(m_input.substr(0, size));
+                    m_input.erase(0, size);
+                    if (m_input_at_stream_start) {
+                        seg.result = m_pool.submit(decode_task{m_create_decoder, seg.input});
+                    }
+                    m_input_at_stream_start = at_stream_start;
+                    m_segments.push_back(std::move(seg));
+                }
+
+                void fill() {
+                    while (!m_eof && m_segments.size() < m_max_in_flight) {
+                        const auto old_size = m_input.size();
+                        m_input.resize(old_size + m_read_size);
+                        const auto nread = osmium::io::detail::reliable_read(m_fd, &m_input[old_size], static_cast<unsigned int>(m_read_size));
+                        m_input.resize(old_size + static_cast<std::size_t>(nread));
+                        m_read_offset += static_cast<std::size_t>(nread);
+                        m_advisor.update(m_read_offset);
+
+                        if (nread == 0) {
+                            m_eof = true;
+                            if (!m_input.empty()) {
+                                add_segment(m_input.size(), true);
+                            }
+                        } else if (m_input.size() >= m_segment_size) {
+                            const std::size_t pos = find_last_stream_start();
+                            if (pos > 0) {
+                                add_segment(pos, true);
+                            } else {
+                                add_segment(m_input.size(), false);
+                            }
+                        }
+                    }
+                }
+
+            public:
+
+                /**
+                 * @param fd File descriptor to read from.
+                 * @param pool Thread pool used for decompressing.
+                 * @param segment_size Minimum size of segments of the input.
+                 * @param magic First byte of each compressed stream.
+                 * @param is_stream_start Function to check for the start of
+                 *                        a stream at some position.
+                 * @param create_decoder Function creating a decoder.
+                 */
+                ParallelDecompressor(const int fd, osmium::thread::Pool& pool,
+                                     const std::size_t segment_size, const char magic,
+                                     is_stream_start_type&& is_stream_start,
+                                     create_decoder_type&& create_decoder) :
+                    m_pool(pool),
+                    m_create_decoder(std::move(create_decoder)),
+                    m_is_stream_start(std::move(is_stream_start)),
+                    m_segment_size(segment_size),
+                    m_max_in_flight(static_cast<std::size_t>(pool.num_threads()) * 2),
+                    m_fd(fd),
+                    m_advisor(fd),
+                    m_magic(magic) {
+                }
+
+                ParallelDecompressor(const ParallelDecompressor&) = delete;
+                ParallelDecompressor& operator=(const ParallelDecompressor&) = delete;
+
+                ParallelDecompressor(ParallelDecompressor&&) = delete;
+                ParallelDecompressor& operator=(ParallelDecompressor&&) = delete;
+
+                ~ParallelDecompressor() noexcept override {
+                    try {
+                        close();
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                std::string read() final {
+                    while (true) {
+                        fill();
+                        if (m_segments.empty()) {
+                            if (m_serial_decoder) {
+                                m_serial_decoder->end_of_input();
+                            }
+                            return std::string{};
+                        }
+
+                        segment seg{std::move(m_segments.front())};
+                        m_segments.pop_front();
+                        m_offset += seg.input->size();
+                        set_offset(m_offset);
+
+                        std::string output;
+                        if (!m_serial_decoder && seg.result.valid()) {
+                            segment_result result = seg.result.get();
+                            if (result.complete) {
+                                output = std::move(result.data);
+                                if (output.empty()) {
+                                    continue;
+                                }
+                                return output;
+                            }
+                        }
+
+                        if (!m_serial_decoder) {
+                            m_serial_decoder = m_create_decoder();
+                        }
+                        if (m_serial_decoder->decode(seg.input->data(), seg.input->size(), output)) {
+                            m_serial_decoder.reset();
+                        }
+                        if (!output.empty()) {
+                            return output;
+                        }
+                    }
+                }
+
+                void close() final {
+                    if (m_fd >= 0) {
+                        const int fd = m_fd;
+                        m_fd = -1;
+                        m_segments.clear();
+                        m_advisor.finish();
+                        osmium::io::detail::reliable_close(fd);
+                    }
+                }
+
+            }; // class ParallelDecompressor
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PARALLEL_DECOMPRESSOR_HPP
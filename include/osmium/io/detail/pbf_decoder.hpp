@@ -35,15 +35,25 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
+#include <osmium/io/detail/pbf_packed.hpp>
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/zlib.hpp>
+#ifdef OSMIUM_WITH_LZ4
+# include <osmium/io/detail/lz4.hpp>
+#endif
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/reader_options.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/box.hpp>
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
+#include <osmium/osm/metadata_options.hpp>
 #include <osmium/osm/node.hpp>
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
@@ -51,11 +61,14 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/way.hpp>
 #include <osmium/util/delta.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <protozero/iterators.hpp>
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <limits>
@@ -78,14 +91,58 @@ namespace osmium {
             using protozero::data_view;
             using osm_string_len_type = std::pair<const char*, osmium::string_size_type>;
 
-            class PBFPrimitiveBlockDecoder {
+            /**
+             * Memory used while decoding a blob that is kept for the next
+             * blob decoded in the same thread. This avoids allocating,
+             * page faulting and freeing up to 32 MB of inflate buffer and
+             * the decoding arrays for every blob.
+             */
+            struct PBFDecodeBuffers {
 
                 enum {
-                    initial_buffer_size = 64ul * 1024ul
+                    initial_output_buffer_size = 64ul * 1024ul
                 };
 
+                std::string inflate_buffer{};
+                std::vector<osm_string_len_type> stringtable{};
+                std::vector<int64_t> ids{};
+                std::vector<int64_t> lats{};
+                std::vector<int64_t> lons{};
+                std::vector<int32_t> roles{};
+                std::vector<int32_t> types{};
+
+                // Capacity of the next output buffer. This is adapted to
+                // the block sizes seen so that usually the objects from a
+                // block fit into one buffer.
+                std::size_t output_buffer_size = initial_output_buffer_size;
+
+                void update_output_buffer_size(const osmium::memory::Buffer& buffer) noexcept {
+                    if (buffer.has_nested_buffers()) {
+                        if (output_buffer_size < max_uncompressed_blob_size) {
+                            output_buffer_size *= 2;
+                        }
+                    } else if (buffer.committed() < output_buffer_size / 4 &&
+                               output_buffer_size > initial_output_buffer_size) {
+                        output_buffer_size /= 2;
+                    }
+                }
+
+            }; // struct PBFDecodeBuffers
+
+            /**
+             * The decode buffers of the current thread.
+             */
+            inline PBFDecodeBuffers& thread_decode_buffers() {
+                static thread_local PBFDecodeBuffers buffers;
+                return buffers;
+            }
+
+            class PBFPrimitiveBlockDecoder {
+
+                PBFDecodeBuffers& m_buffers;
+
                 data_view m_data;
-                std::vector<osm_string_len_type> m_stringtable;
+                std::vector<osm_string_len_type>& m_stringtable;
 
                 int64_t m_lon_offset = 0;
                 int64_t m_lat_offset = 0;
@@ -94,10 +151,40 @@ namespace osmium {
 
                 osmium::osm_entity_bits::type m_read_types;
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+                osmium::memory::Buffer m_buffer;
 
                 osmium::io::read_meta m_read_metadata;
 
+                // Which metadata fields to decode if m_read_metadata is yes.
+                osmium::metadata_options m_read_metadata_fields;
+
+                // Decoded IDs and coordinates of the current DenseNodes
+                // group or way or the member IDs of the current relation.
+                std::vector<int64_t>& m_ids;
+                std::vector<int64_t>& m_lats;
+                std::vector<int64_t>& m_lons;
+
+                // Decoded member roles and types of the current relation.
+                std::vector<int32_t>& m_roles;
+                std::vector<int32_t>& m_types;
+
+                osmium::io::tag_prefilter m_prefilter;
+
+                using kv_type = protozero::iterator_range<protozero::pbf_reader::const_uint32_iterator>;
+
+                // NUL-terminated copies of the strings in the string table
+                // for the prefilter. Only filled if there is a prefilter.
+                std::string m_prefilter_string_data;
+                std::vector<const char*> m_prefilter_strings;
+
+                // If the prefilter has rules, bit n in the masks is set if
+                // the key or value matches the n-th rule.
+                std::vector<uint64_t> m_prefilter_key_masks;
+                std::vector<uint64_t> m_prefilter_value_masks;
+                uint64_t m_prefilter_result_mask = 0;
+                bool m_prefilter_default_result = false;
+                bool m_use_prefilter_masks = false;
+
                 void decode_stringtable(const data_view& data) {
                     if (!m_stringtable.empty()) {
                         throw osmium::pbf_error{"more than one stringtable in pbf file"};
@@ -138,6 +225,136 @@ namespace osmium {
                     }
                 }
 
+                void setup_prefilter_strings() {
+                    std::size_t size = 0;
+                    for (const auto& str : m_stringtable) {
+                        size += str.second + 1;
+                    }
+
+                    m_prefilter_string_data.reserve(size);
+                    for (const auto& str : m_stringtable) {
+                        m_prefilter_string_data.append(str.first, str.second);
+                        m_prefilter_string_data += '\0';
+                    }
+
+                    m_prefilter_strings.reserve(m_stringtable.size());
+                    const char* ptr = m_prefilter_string_data.data();
+                    for (const auto& str : m_stringtable) {
+                        m_prefilter_strings.push_back(ptr);
+                        ptr += str.second + 1;
+                    }
+                }
+
+                /**
+                 * Match all strings in the string table against the keys
+                 * and values of all rules. After this checking a tag is
+                 * a lookup of its key and value in the masks.
+                 */
+                void setup_prefilter_masks(const osmium::io::detail::tag_prefilter_rules& rules) {
+                    const auto num_rules = rules.count();
+                    m_prefilter_key_masks.assign(m_prefilter_strings.size(), 0);
+                    m_prefilter_value_masks.assign(m_prefilter_strings.size(), 0);
+
+                    for (std::size_t r = 0; r < num_rules; ++r) {
+                        const uint64_t bit = 1ULL << r;
+                        if (rules.result(r)) {
+                            m_prefilter_result_mask |= bit;
+                        }
+                        for (std::size_t n = 0; n < m_prefilter_strings.size(); ++n) {
+                            if (rules.match_key(r, m_prefilter_strings[n])) {
+                                m_prefilter_key_masks[n] |= bit;
+                            }
+                            if (rules.match_value(r, m_prefilter_strings[n])) {
+                                m_prefilter_value_masks[n] |= bit;
+                            }
+                        }
+                    }
+
+                    m_prefilter_default_result = rules.default_result();
+                    m_use_prefilter_masks = true;
+                }
+
+                bool prefilter_accepts_tag(uint32_t key, uint32_t value) const {
+                    if (m_use_prefilter_masks) {
+                        const uint64_t matches = m_prefilter_key_masks.at(key) & m_prefilter_value_masks.at(value);
+                        if (matches == 0) {
+                            return m_prefilter_default_result;
+                        }
+                        // The first matching rule decides.
+                        return (matches & (~matches + 1) & m_prefilter_result_mask) != 0;
+                    }
+                    return m_prefilter(m_prefilter_strings.at(key), m_prefilter_strings.at(value));
+                }
+
+                /**
+                 * Look only at the keys and values of the object in the
+                 * data and check whether the prefilter accepts it.
+                 */
+                template <typename TMessage>
+                bool prefilter_accepts_object(const osmium::item_type type, const data_view& data) const {
+                    if (!m_prefilter.applies_to(type)) {
+                        return true;
+                    }
+
+                    kv_type keys;
+                    kv_type vals;
+
+                    protozero::pbf_message<TMessage> pbf_object{data};
+                    while (pbf_object.next()) {
+                        switch (pbf_object.tag_and_type()) {
+                            case protozero::tag_and_type(TMessage::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                keys = pbf_object.get_packed_uint32();
+                                break;
+                            case protozero::tag_and_type(TMessage::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                                vals = pbf_object.get_packed_uint32();
+                                break;
+                            default:
+                                pbf_object.skip();
+                        }
+                    }
+
+                    auto kit = keys.begin();
+                    auto vit = vals.begin();
+                    while (kit != keys.end() && vit != vals.end()) {
+                        if (prefilter_accepts_tag(*kit++, *vit++)) {
+                            return true;
+                        }
+                    }
+
+                    return false;
+                }
+
+                /**
+                 * Check whether the prefilter accepts a node from a
+                 * DenseNodes group given the iterator pointing to its
+                 * tags in the keys_vals field. The iterator is not moved.
+                 */
+                bool prefilter_accepts_dense_node(protozero::pbf_reader::const_int32_iterator it, const protozero::pbf_reader::const_int32_iterator last) const {
+                    while (it != last && *it != 0) {
+                        const auto key = static_cast<uint32_t>(*it++);
+                        if (it == last) {
+                            throw osmium::pbf_error{"PBF format error"}; // this is against the spec, keys/vals must come in pairs
+                        }
+                        if (prefilter_accepts_tag(key, static_cast<uint32_t>(*it++))) {
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                static void skip_dense_node_tags(protozero::pbf_reader::const_int32_iterator& it, const protozero::pbf_reader::const_int32_iterator last) {
+                    while (it != last && *it++ != 0) {
+                    }
+                }
+
+                /**
+                 * Decode all primitive groups in the block. The entity types
+                 * to read and whether metadata is read are template
+                 * parameters, so each configuration gets its own decoder
+                 * without any runtime checks in the loop. Groups of types
+                 * that are not read are skipped without looking at them.
+                 */
+                template <osmium::osm_entity_bits::type TReadTypes, bool TReadMeta>
                 void decode_primitive_block_data() {
                     protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{m_data};
                     while (pbf_primitive_block.next(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited)) {
@@ -145,16 +362,19 @@ namespace osmium {
                         while (pbf_primitive_group.next()) {
                             switch (pbf_primitive_group.tag_and_type()) {
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
-                                    if (m_read_types & osmium::osm_entity_bits::node) {
-                                        decode_node(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                    if (TReadTypes & osmium::osm_entity_bits::node) {
+                                        const auto view = pbf_primitive_group.get_view();
+                                        if (prefilter_accepts_object<OSMFormat::Node>(osmium::item_type::node, view)) {
+                                            decode_node<TReadMeta>(view);
+                                            m_buffer.commit();
+                                        }
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
-                                    if (m_read_types & osmium::osm_entity_bits::node) {
-                                        if (m_read_metadata == osmium::io::read_meta::yes) {
+                                    if (TReadTypes & osmium::osm_entity_bits::node) {
+                                        if (TReadMeta) {
                                             decode_dense_nodes(pbf_primitive_group.get_view());
                                         } else {
                                             decode_dense_nodes_without_metadata(pbf_primitive_group.get_view());
@@ -165,17 +385,23 @@ namespace osmium {
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Way_ways, protozero::pbf_wire_type::length_delimited):
-                                    if (m_read_types & osmium::osm_entity_bits::way) {
-                                        decode_way(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                    if (TReadTypes & osmium::osm_entity_bits::way) {
+                                        const auto view = pbf_primitive_group.get_view();
+                                        if (prefilter_accepts_object<OSMFormat::Way>(osmium::item_type::way, view)) {
+                                            decode_way<TReadMeta>(view);
+                                            m_buffer.commit();
+                                        }
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
                                     break;
                                 case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations, protozero::pbf_wire_type::length_delimited):
-                                    if (m_read_types & osmium::osm_entity_bits::relation) {
-                                        decode_relation(pbf_primitive_group.get_view());
-                                        m_buffer.commit();
+                                    if (TReadTypes & osmium::osm_entity_bits::relation) {
+                                        const auto view = pbf_primitive_group.get_view();
+                                        if (prefilter_accepts_object<OSMFormat::Relation>(osmium::item_type::relation, view)) {
+                                            decode_relation<TReadMeta>(view);
+                                            m_buffer.commit();
+                                        }
                                     } else {
                                         pbf_primitive_group.skip();
                                     }
@@ -194,7 +420,9 @@ namespace osmium {
                     while (pbf_info.next()) {
                         switch (pbf_info.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::Info::optional_int32_version, protozero::pbf_wire_type::varint):
-                                {
+                                if (!m_read_metadata_fields.version()) {
+                                    pbf_info.skip();
+                                } else {
                                     const auto version = pbf_info.get_int32();
                                     if (version < -1) {
                                         throw osmium::pbf_error{"object version must not be negative"};
@@ -208,10 +436,16 @@ namespace osmium {
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_int64_timestamp, protozero::pbf_wire_type::varint):
-                                object.set_timestamp(pbf_info.get_int64() * m_date_factor / 1000);
+                                if (m_read_metadata_fields.timestamp()) {
+                                    object.set_timestamp(pbf_info.get_int64() * m_date_factor / 1000);
+                                } else {
+                                    pbf_info.skip();
+                                }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_int64_changeset, protozero::pbf_wire_type::varint):
-                                {
+                                if (!m_read_metadata_fields.changeset()) {
+                                    pbf_info.skip();
+                                } else {
                                     const auto changeset_id = pbf_info.get_int64();
                                     if (changeset_id < -1 || changeset_id >= std::numeric_limits<changeset_id_type>::max()) {
                                         throw osmium::pbf_error{"object changeset_id must be between 0 and 2^32-1"};
@@ -225,10 +459,18 @@ namespace osmium {
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_int32_uid, protozero::pbf_wire_type::varint):
-                                object.set_uid_from_signed(pbf_info.get_int32());
+                                if (m_read_metadata_fields.uid()) {
+                                    object.set_uid_from_signed(pbf_info.get_int32());
+                                } else {
+                                    pbf_info.skip();
+                                }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_uint32_user_sid, protozero::pbf_wire_type::varint):
-                                user = m_stringtable.at(pbf_info.get_uint32());
+                                if (m_read_metadata_fields.user()) {
+                                    user = m_stringtable.at(pbf_info.get_uint32());
+                                } else {
+                                    pbf_info.skip();
+                                }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Info::optional_bool_visible, protozero::pbf_wire_type::varint):
                                 object.set_visible(pbf_info.get_bool());
@@ -241,8 +483,6 @@ namespace osmium {
                     return user;
                 }
 
-                using kv_type = protozero::iterator_range<protozero::pbf_reader::const_uint32_iterator>;
-
                 void build_tag_list(osmium::builder::Builder& parent, const kv_type& keys, const kv_type& vals) {
                     if (!keys.empty()) {
                         osmium::builder::TagListBuilder builder{parent};
@@ -264,6 +504,7 @@ namespace osmium {
                     return int32_t((c * m_granularity + m_lon_offset) / resolution_convert);
                 }
 
+                template <bool TReadMeta>
                 void decode_node(const data_view& data) {
                     osmium::builder::NodeBuilder builder{m_buffer};
                     osmium::Node& node = builder.object();
@@ -288,7 +529,7 @@ namespace osmium {
                                 vals = pbf_node.get_packed_uint32();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Node::optional_Info_info, protozero::pbf_wire_type::length_delimited):
-                                if (m_read_metadata == osmium::io::read_meta::yes) {
+                                if (TReadMeta) {
                                     user = decode_info(pbf_node.get_view(), builder.object());
                                 } else {
                                     pbf_node.skip();
@@ -321,14 +562,15 @@ namespace osmium {
                     build_tag_list(builder, keys, vals);
                 }
 
+                template <bool TReadMeta>
                 void decode_way(const data_view& data) {
                     osmium::builder::WayBuilder builder{m_buffer};
 
                     kv_type keys;
                     kv_type vals;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> refs;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lats;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lons;
+                    data_view refs;
+                    data_view lats;
+                    data_view lons;
 
                     osm_string_len_type user{"", 0};
 
@@ -345,20 +587,20 @@ namespace osmium {
                                 vals = pbf_way.get_packed_uint32();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Way::optional_Info_info, protozero::pbf_wire_type::length_delimited):
-                                if (m_read_metadata == osmium::io::read_meta::yes) {
+                                if (TReadMeta) {
                                     user = decode_info(pbf_way.get_view(), builder.object());
                                 } else {
                                     pbf_way.skip();
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Way::packed_sint64_refs, protozero::pbf_wire_type::length_delimited):
-                                refs = pbf_way.get_packed_sint64();
+                                refs = pbf_way.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Way::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = pbf_way.get_packed_sint64();
+                                lats = pbf_way.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Way::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = pbf_way.get_packed_sint64();
+                                lons = pbf_way.get_view();
                                 break;
                             default:
                                 pbf_way.skip();
@@ -368,24 +610,29 @@ namespace osmium {
                     builder.set_user(user.first, user.second);
 
                     if (!refs.empty()) {
+                        // Decode the packed fields in one go each and then
+                        // build the node list from the decoded arrays.
+                        decode_packed_sint64(refs.data(), refs.size(), m_ids);
+                        delta_decode_in_place(m_ids);
+
                         osmium::builder::WayNodeListBuilder wnl_builder{builder};
-                        osmium::DeltaDecode<int64_t> ref;
                         if (lats.empty()) {
-                            for (const auto& ref_value : refs) {
-                                wnl_builder.add_node_ref(ref.update(ref_value));
+                            for (const auto id : m_ids) {
+                                wnl_builder.add_node_ref(id);
                             }
                         } else {
-                            osmium::DeltaDecode<int64_t> lon;
-                            osmium::DeltaDecode<int64_t> lat;
-                            while (!refs.empty() && !lons.empty() && !lats.empty()) {
+                            decode_packed_sint64(lats.data(), lats.size(), m_lats);
+                            decode_packed_sint64(lons.data(), lons.size(), m_lons);
+                            delta_decode_in_place(m_lats);
+                            delta_decode_in_place(m_lons);
+
+                            const auto size = std::min(m_ids.size(), std::min(m_lats.size(), m_lons.size()));
+                            for (std::size_t i = 0; i < size; ++i) {
                                 wnl_builder.add_node_ref(
-                                    ref.update(refs.front()),
-                                    osmium::Location{convert_pbf_coordinate(lon.update(lons.front())),
-                                                     convert_pbf_coordinate(lat.update(lats.front()))}
+                                    m_ids[i],
+                                    osmium::Location{convert_pbf_coordinate(m_lons[i]),
+                                                     convert_pbf_coordinate(m_lats[i])}
                                 );
-                                refs.drop_front();
-                                lons.drop_front();
-                                lats.drop_front();
                             }
                         }
                     }
@@ -393,14 +640,15 @@ namespace osmium {
                     build_tag_list(builder, keys, vals);
                 }
 
+                template <bool TReadMeta>
                 void decode_relation(const data_view& data) {
                     osmium::builder::RelationBuilder builder{m_buffer};
 
                     kv_type keys;
                     kv_type vals;
-                    protozero::iterator_range<protozero::pbf_reader::const_int32_iterator> roles;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> refs;
-                    protozero::iterator_range<protozero::pbf_reader::const_int32_iterator> types;
+                    data_view roles;
+                    data_view refs;
+                    data_view types;
 
                     osm_string_len_type user{"", 0};
 
@@ -417,20 +665,20 @@ namespace osmium {
                                 vals = pbf_relation.get_packed_uint32();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Relation::optional_Info_info, protozero::pbf_wire_type::length_delimited):
-                                if (m_read_metadata == osmium::io::read_meta::yes) {
+                                if (TReadMeta) {
                                     user = decode_info(pbf_relation.get_view(), builder.object());
                                 } else {
                                     pbf_relation.skip();
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::Relation::packed_int32_roles_sid, protozero::pbf_wire_type::length_delimited):
-                                roles = pbf_relation.get_packed_int32();
+                                roles = pbf_relation.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Relation::packed_sint64_memids, protozero::pbf_wire_type::length_delimited):
-                                refs = pbf_relation.get_packed_sint64();
+                                refs = pbf_relation.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::Relation::packed_MemberType_types, protozero::pbf_wire_type::length_delimited):
-                                types = pbf_relation.get_packed_enum();
+                                types = pbf_relation.get_view();
                                 break;
                             default:
                                 pbf_relation.skip();
@@ -440,23 +688,25 @@ namespace osmium {
                     builder.set_user(user.first, user.second);
 
                     if (!refs.empty()) {
+                        decode_packed_int32(roles.data(), roles.size(), m_roles);
+                        decode_packed_sint64(refs.data(), refs.size(), m_ids);
+                        decode_packed_int32(types.data(), types.size(), m_types);
+                        delta_decode_in_place(m_ids);
+
                         osmium::builder::RelationMemberListBuilder rml_builder{builder};
-                        osmium::DeltaDecode<int64_t> ref;
-                        while (!roles.empty() && !refs.empty() && !types.empty()) {
-                            const auto& r = m_stringtable.at(roles.front());
-                            const int type = types.front();
+                        const auto size = std::min(m_ids.size(), std::min(m_roles.size(), m_types.size()));
+                        for (std::size_t i = 0; i < size; ++i) {
+                            const auto& r = m_stringtable.at(m_roles[i]);
+                            const int type = m_types[i];
                             if (type < 0 || type > 2) {
                                 throw osmium::pbf_error{"unknown relation member type"};
                             }
                             rml_builder.add_member(
                                 osmium::item_type(type + 1),
-                                ref.update(refs.front()),
+                                m_ids[i],
                                 r.first,
                                 r.second
                             );
-                            roles.drop_front();
-                            refs.drop_front();
-                            types.drop_front();
                         }
                     }
 
@@ -479,10 +729,32 @@ namespace osmium {
                     }
                 }
 
+                /**
+                 * Decode the packed id, lat, and lon fields of a DenseNodes
+                 * group in one go each and undo the delta encoding. This is
+                 * much faster than decoding them value by value while
+                 * building the nodes.
+                 */
+                void decode_dense_ids_and_locations(const data_view& ids, const data_view& lats, const data_view& lons) {
+                    decode_packed_sint64(ids.data(), ids.size(), m_ids);
+                    decode_packed_sint64(lats.data(), lats.size(), m_lats);
+                    decode_packed_sint64(lons.data(), lons.size(), m_lons);
+
+                    if (m_lats.size() < m_ids.size() ||
+                        m_lons.size() < m_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
+                    delta_decode_in_place(m_ids);
+                    delta_decode_in_place(m_lats);
+                    delta_decode_in_place(m_lons);
+                }
+
                 void decode_dense_nodes_without_metadata(const data_view& data) {
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> ids;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lats;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lons;
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
 
                     protozero::iterator_range<protozero::pbf_reader::const_int32_iterator>  tags;
 
@@ -490,13 +762,13 @@ namespace osmium {
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
-                                ids = pbf_dense_nodes.get_packed_sint64();
+                                ids = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = pbf_dense_nodes.get_packed_sint64();
+                                lats = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = pbf_dense_nodes.get_packed_sint64();
+                                lons = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
                                 tags = pbf_dense_nodes.get_packed_int32();
@@ -506,33 +778,25 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    decode_dense_ids_and_locations(ids, lats, lons);
 
                     auto tag_it = tags.begin();
+                    const bool use_prefilter = m_prefilter.applies_to(osmium::item_type::node);
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+                        if (use_prefilter && !prefilter_accepts_dense_node(tag_it, tags.end())) {
+                            skip_dense_node_tags(tag_it, tags.end());
+                            continue;
                         }
 
                         {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.front()));
-                            ids.drop_front();
-
-                            const auto lon = dense_longitude.update(lons.front());
-                            lons.drop_front();
-                            const auto lat = dense_latitude.update(lats.front());
-                            lats.drop_front();
-                            builder.object().set_location(osmium::Location{
-                                    convert_pbf_coordinate(lon),
-                                    convert_pbf_coordinate(lat)
+                            node.set_id(m_ids[i]);
+                            node.set_location(osmium::Location{
+                                    convert_pbf_coordinate(m_lons[i]),
+                                    convert_pbf_coordinate(m_lats[i])
                             });
 
                             if (tag_it != tags.end()) {
@@ -547,9 +811,9 @@ namespace osmium {
                 void decode_dense_nodes(const data_view& data) {
                     bool has_info = false;
 
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> ids;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lats;
-                    protozero::iterator_range<protozero::pbf_reader::const_sint64_iterator> lons;
+                    data_view ids;
+                    data_view lats;
+                    data_view lons;
 
                     protozero::iterator_range<protozero::pbf_reader::const_int32_iterator>  tags;
 
@@ -564,28 +828,50 @@ namespace osmium {
                     while (pbf_dense_nodes.next()) {
                         switch (pbf_dense_nodes.tag_and_type()) {
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
-                                ids = pbf_dense_nodes.get_packed_sint64();
+                                ids = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
                                 {
+                                    // Arrays of metadata fields that are not
+                                    // read are skipped and stay empty.
                                     has_info = true;
                                     protozero::pbf_message<OSMFormat::DenseInfo> pbf_dense_info{pbf_dense_nodes.get_message()};
                                     while (pbf_dense_info.next()) {
                                         switch (pbf_dense_info.tag_and_type()) {
                                             case protozero::tag_and_type(OSMFormat::DenseInfo::packed_int32_version, protozero::pbf_wire_type::length_delimited):
-                                                versions = pbf_dense_info.get_packed_int32();
+                                                if (m_read_metadata_fields.version()) {
+                                                    versions = pbf_dense_info.get_packed_int32();
+                                                } else {
+                                                    pbf_dense_info.skip();
+                                                }
                                                 break;
                                             case protozero::tag_and_type(OSMFormat::DenseInfo::packed_sint64_timestamp, protozero::pbf_wire_type::length_delimited):
-                                                timestamps = pbf_dense_info.get_packed_sint64();
+                                                if (m_read_metadata_fields.timestamp()) {
+                                                    timestamps = pbf_dense_info.get_packed_sint64();
+                                                } else {
+                                                    pbf_dense_info.skip();
+                                                }
                                                 break;
                                             case protozero::tag_and_type(OSMFormat::DenseInfo::packed_sint64_changeset, protozero::pbf_wire_type::length_delimited):
-                                                changesets = pbf_dense_info.get_packed_sint64();
+                                                if (m_read_metadata_fields.changeset()) {
+                                                    changesets = pbf_dense_info.get_packed_sint64();
+                                                } else {
+                                                    pbf_dense_info.skip();
+                                                }
                                                 break;
                                             case protozero::tag_and_type(OSMFormat::DenseInfo::packed_sint32_uid, protozero::pbf_wire_type::length_delimited):
-                                                uids = pbf_dense_info.get_packed_sint32();
+                                                if (m_read_metadata_fields.uid()) {
+                                                    uids = pbf_dense_info.get_packed_sint32();
+                                                } else {
+                                                    pbf_dense_info.skip();
+                                                }
                                                 break;
                                             case protozero::tag_and_type(OSMFormat::DenseInfo::packed_sint32_user_sid, protozero::pbf_wire_type::length_delimited):
-                                                user_sids = pbf_dense_info.get_packed_sint32();
+                                                if (m_read_metadata_fields.user()) {
+                                                    user_sids = pbf_dense_info.get_packed_sint32();
+                                                } else {
+                                                    pbf_dense_info.skip();
+                                                }
                                                 break;
                                             case protozero::tag_and_type(OSMFormat::DenseInfo::packed_bool_visible, protozero::pbf_wire_type::length_delimited):
                                                 visibles = pbf_dense_info.get_packed_bool();
@@ -597,10 +883,10 @@ namespace osmium {
                                 }
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
-                                lats = pbf_dense_nodes.get_packed_sint64();
+                                lats = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
-                                lons = pbf_dense_nodes.get_packed_sint64();
+                                lons = pbf_dense_nodes.get_view();
                                 break;
                             case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
                                 tags = pbf_dense_nodes.get_packed_int32();
@@ -610,21 +896,46 @@ namespace osmium {
                         }
                     }
 
-                    osmium::DeltaDecode<int64_t> dense_id;
-                    osmium::DeltaDecode<int64_t> dense_latitude;
-                    osmium::DeltaDecode<int64_t> dense_longitude;
+                    decode_dense_ids_and_locations(ids, lats, lons);
+
                     osmium::DeltaDecode<int64_t> dense_uid;
                     osmium::DeltaDecode<int64_t> dense_user_sid;
                     osmium::DeltaDecode<int64_t> dense_changeset;
                     osmium::DeltaDecode<int64_t> dense_timestamp;
 
                     auto tag_it = tags.begin();
+                    const bool use_prefilter = m_prefilter.applies_to(osmium::item_type::node);
 
-                    while (!ids.empty()) {
-                        if (lons.empty() ||
-                            lats.empty()) {
-                            // this is against the spec, must have same number of elements
-                            throw osmium::pbf_error{"PBF format error"};
+                    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+                        if (use_prefilter && !prefilter_accepts_dense_node(tag_it, tags.end())) {
+                            // The delta decoding of the metadata must
+                            // continue even if the node isn't built.
+                            skip_dense_node_tags(tag_it, tags.end());
+                            if (has_info) {
+                                if (!versions.empty()) {
+                                    versions.drop_front();
+                                }
+                                if (!changesets.empty()) {
+                                    dense_changeset.update(changesets.front());
+                                    changesets.drop_front();
+                                }
+                                if (!timestamps.empty()) {
+                                    dense_timestamp.update(timestamps.front());
+                                    timestamps.drop_front();
+                                }
+                                if (!uids.empty()) {
+                                    dense_uid.update(uids.front());
+                                    uids.drop_front();
+                                }
+                                if (!visibles.empty()) {
+                                    visibles.drop_front();
+                                }
+                                if (!user_sids.empty()) {
+                                    dense_user_sid.update(user_sids.front());
+                                    user_sids.drop_front();
+                                }
+                            }
+                            continue;
                         }
 
                         bool visible = true;
@@ -633,8 +944,7 @@ namespace osmium {
                             osmium::builder::NodeBuilder builder{m_buffer};
                             osmium::Node& node = builder.object();
 
-                            node.set_id(dense_id.update(ids.front()));
-                            ids.drop_front();
+                            node.set_id(m_ids[i]);
 
                             if (has_info) {
                                 if (!versions.empty()) {
@@ -690,14 +1000,10 @@ namespace osmium {
 
                             // even if the node isn't visible, there's still a record
                             // of its lat/lon in the dense arrays.
-                            const auto lon = dense_longitude.update(lons.front());
-                            lons.drop_front();
-                            const auto lat = dense_latitude.update(lats.front());
-                            lats.drop_front();
                             if (visible) {
-                                builder.object().set_location(osmium::Location{
-                                        convert_pbf_coordinate(lon),
-                                        convert_pbf_coordinate(lat)
+                                node.set_location(osmium::Location{
+                                        convert_pbf_coordinate(m_lons[i]),
+                                        convert_pbf_coordinate(m_lats[i])
                                 });
                             }
 
@@ -709,12 +1015,64 @@ namespace osmium {
                     }
                 }
 
+                template <bool TReadMeta>
+                void decode_primitive_block_data_with_meta() {
+                    switch (m_read_types & osmium::osm_entity_bits::nwr) {
+                        case osmium::osm_entity_bits::nothing:
+                            break;
+                        case osmium::osm_entity_bits::node:
+                            decode_primitive_block_data<osmium::osm_entity_bits::node, TReadMeta>();
+                            break;
+                        case osmium::osm_entity_bits::way:
+                            decode_primitive_block_data<osmium::osm_entity_bits::way, TReadMeta>();
+                            break;
+                        case osmium::osm_entity_bits::node | osmium::osm_entity_bits::way:
+                            decode_primitive_block_data<osmium::osm_entity_bits::node | osmium::osm_entity_bits::way, TReadMeta>();
+                            break;
+                        case osmium::osm_entity_bits::relation:
+                            decode_primitive_block_data<osmium::osm_entity_bits::relation, TReadMeta>();
+                            break;
+                        case osmium::osm_entity_bits::node | osmium::osm_entity_bits::relation:
+                            decode_primitive_block_data<osmium::osm_entity_bits::node | osmium::osm_entity_bits::relation, TReadMeta>();
+                            break;
+                        case osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation:
+                            decode_primitive_block_data<osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation, TReadMeta>();
+                            break;
+                        default:
+                            decode_primitive_block_data<osmium::osm_entity_bits::nwr, TReadMeta>();
+                    }
+                }
+
+                /**
+                 * Pick the decoder specialized for the configured entity
+                 * types and metadata setting. This is done once per block,
+                 * the hot loops themselves don't check these settings.
+                 */
+                void dispatch_primitive_block_data() {
+                    if (m_read_metadata == osmium::io::read_meta::yes) {
+                        decode_primitive_block_data_with_meta<true>();
+                    } else {
+                        decode_primitive_block_data_with_meta<false>();
+                    }
+                }
+
             public:
 
-                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
+                PBFPrimitiveBlockDecoder(const data_view& data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, const osmium::io::tag_prefilter& prefilter = osmium::io::tag_prefilter{}, const osmium::metadata_options& read_metadata_fields = osmium::metadata_options{}) :
+                    m_buffers(thread_decode_buffers()),
                     m_data(data),
+                    m_stringtable(m_buffers.stringtable),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_buffer(m_buffers.output_buffer_size, osmium::memory::Buffer::auto_grow::internal),
+                    m_read_metadata(read_metadata),
+                    m_read_metadata_fields(read_metadata_fields),
+                    m_ids(m_buffers.ids),
+                    m_lats(m_buffers.lats),
+                    m_lons(m_buffers.lons),
+                    m_roles(m_buffers.roles),
+                    m_types(m_buffers.types),
+                    m_prefilter(prefilter) {
+                    m_stringtable.clear();
                 }
 
                 PBFPrimitiveBlockDecoder(const PBFPrimitiveBlockDecoder&) = delete;
@@ -728,19 +1086,43 @@ namespace osmium {
                 osmium::memory::Buffer operator()() {
                     try {
                         decode_primitive_block_metadata();
-                        decode_primitive_block_data();
+                        if (m_prefilter.enabled()) {
+                            setup_prefilter_strings();
+                            const auto* rules = m_prefilter.rules();
+                            if (rules && rules->count() <= 64) {
+                                setup_prefilter_masks(*rules);
+                            }
+                        }
+                        dispatch_primitive_block_data();
                     } catch (const std::out_of_range&) {
                         throw osmium::pbf_error{"string id out of range"};
                     }
 
+                    m_buffers.update_output_buffer_size(m_buffer);
+
                     return std::move(m_buffer);
                 }
 
             }; // class PBFPrimitiveBlockDecoder
 
-            inline data_view decode_blob(const std::string& blob_data, std::string& output) {
+            /**
+             * Decode a blob and uncompress the data if needed. Blobs with
+             * lz4 or zstd compressed data can only be read if libosmium
+             * was compiled with OSMIUM_WITH_LZ4 or OSMIUM_WITH_ZSTD,
+             * respectively.
+             *
+             * @param blob_data The Blob message.
+             * @param output Buffer for the uncompressed data.
+             * @returns Pointer and size of the uncompressed data. This
+             *          points either into blob_data or into output.
+             */
+            inline data_view decode_blob(const data_view& blob_data, std::string& output) {
                 int32_t raw_size = 0;
                 protozero::data_view zlib_data;
+#if defined(OSMIUM_WITH_LZ4) || defined(OSMIUM_WITH_ZSTD)
+                protozero::data_view compressed_data;
+                FileFormat::Blob compression = FileFormat::Blob::optional_bytes_raw;
+#endif
 
                 protozero::pbf_message<FileFormat::Blob> pbf_blob{blob_data};
                 while (pbf_blob.next()) {
@@ -764,11 +1146,49 @@ namespace osmium {
                             break;
                         case protozero::tag_and_type(FileFormat::Blob::optional_bytes_lzma_data, protozero::pbf_wire_type::length_delimited):
                             throw osmium::pbf_error{"lzma blobs not implemented"};
+                        case protozero::tag_and_type(FileFormat::Blob::optional_bytes_lz4_data, protozero::pbf_wire_type::length_delimited):
+#ifdef OSMIUM_WITH_LZ4
+                            compressed_data = pbf_blob.get_view();
+                            compression = FileFormat::Blob::optional_bytes_lz4_data;
+                            break;
+#else
+                            throw osmium::pbf_error{"lz4 blobs not supported (compile with OSMIUM_WITH_LZ4)"};
+#endif
+                        case protozero::tag_and_type(FileFormat::Blob::optional_bytes_zstd_data, protozero::pbf_wire_type::length_delimited):
+#ifdef OSMIUM_WITH_ZSTD
+                            compressed_data = pbf_blob.get_view();
+                            compression = FileFormat::Blob::optional_bytes_zstd_data;
+                            break;
+#else
+                            throw osmium::pbf_error{"zstd blobs not supported (compile with OSMIUM_WITH_ZSTD)"};
+#endif
                         default:
                             throw osmium::pbf_error{"unknown compression"};
                     }
                 }
 
+#ifdef OSMIUM_WITH_LZ4
+                if (compression == FileFormat::Blob::optional_bytes_lz4_data && raw_size != 0) {
+                    return osmium::io::detail::lz4_uncompress_string(
+                        compressed_data.data(),
+                        compressed_data.size(),
+                        static_cast<std::size_t>(raw_size),
+                        output
+                    );
+                }
+#endif
+
+#ifdef OSMIUM_WITH_ZSTD
+                if (compression == FileFormat::Blob::optional_bytes_zstd_data && raw_size != 0) {
+                    return osmium::io::detail::zstd_uncompress_string(
+                        compressed_data.data(),
+                        compressed_data.size(),
+                        static_cast<std::size_t>(raw_size),
+                        output
+                    );
+                }
+#endif
+
                 if (!zlib_data.empty() && raw_size != 0) {
                     return osmium::io::detail::zlib_uncompress_string(
                         zlib_data.data(),
@@ -781,6 +1201,152 @@ namespace osmium {
                 throw osmium::pbf_error{"blob contains no data"};
             }
 
+            // Read a varint from the data, returns false if there is not
+            // enough data.
+            inline bool read_varint_from_prefix(const char*& data, const char* end, uint64_t& value) noexcept {
+                value = 0;
+                for (unsigned int shift = 0; data != end && shift < 64; shift += 7) {
+                    const auto byte = static_cast<uint8_t>(*data++);
+                    value |= static_cast<uint64_t>(byte & 0x7fu) << shift;
+                    if ((byte & 0x80u) == 0) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            /**
+             * Find the type of the OSM entities in the first PrimitiveGroup
+             * of a PrimitiveBlock given only the beginning of its
+             * (uncompressed) data.
+             *
+             * @param data Beginning of the PrimitiveBlock.
+             * @param end End of the data available.
+             * @param type Set to the entity type or item_type::undefined if
+             *             this can't be determined.
+             * @returns false if more data is needed.
+             */
+            inline bool decode_first_group_type_from_prefix(const char* data, const char* end, osmium::item_type& type) noexcept {
+                type = osmium::item_type::undefined;
+                while (true) {
+                    uint64_t key;
+                    if (!read_varint_from_prefix(data, end, key)) {
+                        return false;
+                    }
+                    uint64_t value;
+                    switch (static_cast<protozero::pbf_wire_type>(key & 0x07u)) {
+                        case protozero::pbf_wire_type::varint:
+                            if (!read_varint_from_prefix(data, end, value)) {
+                                return false;
+                            }
+                            break;
+                        case protozero::pbf_wire_type::fixed64:
+                            if (end - data < 8) {
+                                return false;
+                            }
+                            data += 8;
+                            break;
+                        case protozero::pbf_wire_type::fixed32:
+                            if (end - data < 4) {
+                                return false;
+                            }
+                            data += 4;
+                            break;
+                        case protozero::pbf_wire_type::length_delimited:
+                            if (!read_varint_from_prefix(data, end, value)) {
+                                return false;
+                            }
+                            if ((key >> 3u) == static_cast<uint64_t>(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup)) {
+                                if (value == 0) {
+                                    return true;
+                                }
+                                uint64_t group_key;
+                                if (!read_varint_from_prefix(data, end, group_key)) {
+                                    return false;
+                                }
+                                switch (static_cast<OSMFormat::PrimitiveGroup>(group_key >> 3u)) {
+                                    case OSMFormat::PrimitiveGroup::repeated_Node_nodes:
+                                    case OSMFormat::PrimitiveGroup::optional_DenseNodes_dense:
+                                        type = osmium::item_type::node;
+                                        break;
+                                    case OSMFormat::PrimitiveGroup::repeated_Way_ways:
+                                        type = osmium::item_type::way;
+                                        break;
+                                    case OSMFormat::PrimitiveGroup::repeated_Relation_relations:
+                                        type = osmium::item_type::relation;
+                                        break;
+                                    case OSMFormat::PrimitiveGroup::repeated_ChangeSet_changesets:
+                                        type = osmium::item_type::changeset;
+                                        break;
+                                    default:
+                                        break;
+                                }
+                                return true;
+                            }
+                            if (static_cast<uint64_t>(end - data) < value) {
+                                return false;
+                            }
+                            data += value;
+                            break;
+                        default:
+                            return true;
+                    }
+                }
+            }
+
+            /**
+             * Find the type of the OSM entities in the first PrimitiveGroup
+             * of the PrimitiveBlock in this blob. Only as much of the blob
+             * as needed for this is uncompressed, usually this is only
+             * the string table.
+             *
+             * @returns The type or item_type::undefined if it can't be
+             *          determined.
+             */
+            inline osmium::item_type decode_blob_first_group_type(const data_view& blob_data) {
+                int32_t raw_size = 0;
+                protozero::data_view zlib_data;
+                osmium::item_type type = osmium::item_type::undefined;
+
+                protozero::pbf_message<FileFormat::Blob> pbf_blob{blob_data};
+                while (pbf_blob.next()) {
+                    switch (pbf_blob.tag_and_type()) {
+                        case protozero::tag_and_type(FileFormat::Blob::optional_bytes_raw, protozero::pbf_wire_type::length_delimited):
+                            {
+                                const auto data = pbf_blob.get_view();
+                                decode_first_group_type_from_prefix(data.data(), data.data() + data.size(), type);
+                                return type;
+                            }
+                        case protozero::tag_and_type(FileFormat::Blob::optional_int32_raw_size, protozero::pbf_wire_type::varint):
+                            raw_size = pbf_blob.get_int32();
+                            break;
+                        case protozero::tag_and_type(FileFormat::Blob::optional_bytes_zlib_data, protozero::pbf_wire_type::length_delimited):
+                            zlib_data = pbf_blob.get_view();
+                            break;
+                        default:
+                            return type;
+                    }
+                }
+
+                if (zlib_data.empty() || raw_size <= 0 || uint32_t(raw_size) > max_uncompressed_blob_size) {
+                    return type;
+                }
+
+                std::string output;
+                for (unsigned long prefix_size = 4096; ; prefix_size *= 4) { // NOLINT(google-runtime-int)
+                    const bool complete = prefix_size >= static_cast<unsigned long>(raw_size); // NOLINT(google-runtime-int)
+                    const auto data = osmium::io::detail::zlib_uncompress_prefix(
+                        zlib_data.data(),
+                        static_cast<unsigned long>(zlib_data.size()), // NOLINT(google-runtime-int)
+                        complete ? static_cast<unsigned long>(raw_size) : prefix_size, // NOLINT(google-runtime-int)
+                        output
+                    );
+                    if (decode_first_group_type_from_prefix(data.data(), data.data() + data.size(), type) || complete) {
+                        return type;
+                    }
+                }
+            }
+
             inline osmium::Box decode_header_bbox(const data_view& data) {
                     int64_t left   = std::numeric_limits<int64_t>::max();
                     int64_t right  = std::numeric_limits<int64_t>::max();
@@ -848,7 +1414,17 @@ namespace osmium {
                             }
                             break;
                         case protozero::tag_and_type(OSMFormat::HeaderBlock::repeated_string_optional_features, protozero::pbf_wire_type::length_delimited):
-                            header.set("pbf_optional_feature_" + std::to_string(i++), pbf_header_block.get_string());
+                            {
+                                const auto feature = pbf_header_block.get_string();
+                                if (feature == "Sort.Type_then_ID") {
+                                    header.set("sorting", "Type_then_ID");
+                                } else if (feature == "Sort.Spatial_Hilbert") {
+                                    header.set("sorting", "Spatial_Hilbert");
+                                } else if (feature == "Sort.Spatial_Morton") {
+                                    header.set("sorting", "Spatial_Morton");
+                                }
+                                header.set("pbf_optional_feature_" + std::to_string(i++), feature);
+                            }
                             break;
                         case protozero::tag_and_type(OSMFormat::HeaderBlock::optional_string_writingprogram, protozero::pbf_wire_type::length_delimited):
                             header.set("generator", pbf_header_block.get_string());
@@ -881,7 +1457,7 @@ namespace osmium {
              * @returns Header object
              * @throws osmium::pbf_error If there was a parsing error
              */
-            inline osmium::io::Header decode_header(const std::string& header_block_data) {
+            inline osmium::io::Header decode_header(const data_view& header_block_data) {
                 std::string output;
 
                 return decode_header_block(decode_blob(header_block_data, output));
@@ -889,21 +1465,62 @@ namespace osmium {
 
             class PBFDataBlobDecoder {
 
-                std::shared_ptr<std::string> m_input_buffer;
+                // Owner of the memory the blob data is in. This can be a
+                // string containing just this blob, a larger chunk of input
+                // data or the memory mapping of the whole input file.
+                std::shared_ptr<const void> m_input_buffer;
+                data_view m_input_data;
                 osmium::osm_entity_bits::type m_read_types;
                 osmium::io::read_meta m_read_metadata;
+                osmium::io::tag_prefilter m_prefilter;
+                osmium::metadata_options m_read_metadata_fields;
+                osmium::io::PipelineStats* m_stats = nullptr;
 
             public:
 
-                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata) :
-                    m_input_buffer(std::make_shared<std::string>(std::move(input_buffer))),
+                PBFDataBlobDecoder(std::string&& input_buffer, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, const osmium::io::tag_prefilter& prefilter = osmium::io::tag_prefilter{}, const osmium::metadata_options& read_metadata_fields = osmium::metadata_options{}) :
+                    m_input_buffer(),
+                    m_input_data(),
                     m_read_types(read_types),
-                    m_read_metadata(read_metadata) {
+                    m_read_metadata(read_metadata),
+                    m_prefilter(prefilter),
+                    m_read_metadata_fields(read_metadata_fields) {
+                    auto buffer = std::make_shared<std::string>(std::move(input_buffer));
+                    m_input_data = data_view{buffer->data(), buffer->size()};
+                    m_input_buffer = std::move(buffer);
+                }
+
+                /**
+                 * Create decoder for blob data that is somewhere inside
+                 * the memory owned by input_buffer.
+                 */
+                PBFDataBlobDecoder(std::shared_ptr<const void> input_buffer, const data_view& input_data, const osmium::osm_entity_bits::type read_types, const osmium::io::read_meta read_metadata, const osmium::io::tag_prefilter& prefilter = osmium::io::tag_prefilter{}, const osmium::metadata_options& read_metadata_fields = osmium::metadata_options{}) :
+                    m_input_buffer(std::move(input_buffer)),
+                    m_input_data(input_data),
+                    m_read_types(read_types),
+                    m_read_metadata(read_metadata),
+                    m_prefilter(prefilter),
+                    m_read_metadata_fields(read_metadata_fields) {
+                }
+
+                /**
+                 * Record the time needed for inflating and decoding the
+                 * blob in the given stats.
+                 */
+                void set_stats(osmium::io::PipelineStats* stats) noexcept {
+                    m_stats = stats;
                 }
 
                 osmium::memory::Buffer operator()() {
-                    std::string output;
-                    PBFPrimitiveBlockDecoder decoder{decode_blob(*m_input_buffer, output), m_read_types, m_read_metadata};
+                    data_view data;
+                    {
+                        const stats_timer timer{m_stats, &PipelineStats::inflate};
+                        const osmium::trace::Span span{"inflate"};
+                        data = decode_blob(m_input_data, thread_decode_buffers().inflate_buffer);
+                    }
+                    const stats_timer timer{m_stats, &PipelineStats::decode};
+                    const osmium::trace::Span span{"decode"};
+                    PBFPrimitiveBlockDecoder decoder{data, m_read_types, m_read_metadata, m_prefilter, m_read_metadata_fields};
                     return decoder();
                 }
 
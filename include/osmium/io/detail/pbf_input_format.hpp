@@ -42,16 +42,18 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/entity_bits.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
-#include <osmium/util/config.hpp>
 
 #include <protozero/pbf_message.hpp>
 #include <protozero/types.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -62,33 +64,210 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Decode the 4 bytes in network byte order at the beginning of
+             * each blob. They contain the length of the following BlobHeader.
+             */
+            inline uint32_t decode_blob_header_size(const char* d) noexcept {
+                return (static_cast<uint32_t>(static_cast<unsigned char>(d[3]))) |
+                       (static_cast<uint32_t>(static_cast<unsigned char>(d[2])) << 8u) |
+                       (static_cast<uint32_t>(static_cast<unsigned char>(d[1])) << 16u) |
+                       (static_cast<uint32_t>(static_cast<unsigned char>(d[0])) << 24u);
+            }
+
+            /**
+             * Decode the BlobHeader. Make sure it contains the expected
+             * type. Return the size of the following Blob.
+             */
+            inline size_t decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>&& pbf_blob_header, const char* expected_type) {
+                protozero::data_view blob_header_type;
+                size_t blob_header_datasize = 0;
+
+                while (pbf_blob_header.next()) {
+                    switch (pbf_blob_header.tag_and_type()) {
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
+                            blob_header_type = pbf_blob_header.get_view();
+                            break;
+                        case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
+                            blob_header_datasize = pbf_blob_header.get_int32();
+                            break;
+                        default:
+                            pbf_blob_header.skip();
+                    }
+                }
+
+                if (blob_header_datasize == 0) {
+                    throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
+                }
+
+                if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
+                    throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
+                }
+
+                return blob_header_datasize;
+            }
+
+            /**
+             * Call func(offset, size, blob) for each blob in the PBF data
+             * in memory. The offset is where the blob starts in the data,
+             * the size includes the BlobHeader and its size, and blob is
+             * the contents of the Blob. The first blob is the OSMHeader
+             * blob, all others must be OSMData blobs.
+             *
+             * @throws osmium::pbf_error If the data is invalid.
+             */
+            template <typename TFunction>
+            void for_each_pbf_blob(const char* data, std::size_t size, TFunction&& func) {
+                std::size_t offset = 0;
+                while (offset < size) {
+                    if (size - offset < sizeof(uint32_t)) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    const auto header_size = decode_blob_header_size(data + offset);
+                    if (header_size > static_cast<uint32_t>(max_blob_header_size)) {
+                        throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                    }
+                    const std::size_t header_offset = offset + sizeof(uint32_t);
+                    if (size - header_offset < header_size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+
+                    const char* expected_type = (offset == 0) ? "OSMHeader" : "OSMData";
+                    const std::size_t blob_size = decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>{data + header_offset, header_size}, expected_type);
+                    const std::size_t blob_offset = header_offset + header_size;
+                    if (blob_size > max_uncompressed_blob_size || size - blob_offset < blob_size) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+
+                    func(offset, blob_offset + blob_size - offset, data_view{data + blob_offset, blob_size});
+
+                    offset = blob_offset + blob_size;
+                }
+            }
+
+            /**
+             * Wraps a PBFDataBlobDecoder running in the thread pool and
+             * removes the blob from the decode window when done.
+             */
+            class PBFWindowedDataBlobDecoder {
+
+                PBFDataBlobDecoder m_decoder;
+                std::shared_ptr<DecodeWindow> m_window;
+                std::size_t m_bytes;
+
+            public:
+
+                PBFWindowedDataBlobDecoder(PBFDataBlobDecoder&& decoder, std::shared_ptr<DecodeWindow> window, std::size_t bytes) :
+                    m_decoder(std::move(decoder)),
+                    m_window(std::move(window)),
+                    m_bytes(bytes) {
+                    m_window->add(m_bytes);
+                }
+
+                osmium::memory::Buffer operator()() {
+                    try {
+                        auto buffer = m_decoder();
+                        m_window->remove(m_bytes);
+                        return buffer;
+                    } catch (...) {
+                        m_window->remove(m_bytes);
+                        throw;
+                    }
+                }
+
+            }; // class PBFWindowedDataBlobDecoder
+
             class PBFParser : public Parser {
 
-                std::string m_input_buffer{};
+                // The chunk of input data we are currently working on, the
+                // object owning its memory (a string from the input queue or
+                // the memory mapping of the whole file) and the offset of the
+                // first byte in it not used yet.
+                std::shared_ptr<const void> m_input_owner{};
+                data_view m_input_chunk{};
+                std::size_t m_input_offset = 0;
+
+                // Offset in the input file of the first byte not used yet.
+                std::size_t m_file_offset = 0;
+
+                // Does the header say the file is sorted by type and ID?
+                bool m_sorted_by_type = false;
+
+                // Blobs being decoded in the thread pool. This is a nullptr
+                // if blobs are decoded in the parser thread.
+                std::shared_ptr<DecodeWindow> m_decode_window{};
+
+                std::size_t input_available() const noexcept {
+                    return m_input_chunk.size() - m_input_offset;
+                }
+
+                void next_input_chunk() {
+                    std::string new_data{get_input()};
+                    if (input_done()) {
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    auto chunk = std::make_shared<std::string>(std::move(new_data));
+                    m_input_chunk = data_view{chunk->data(), chunk->size()};
+                    m_input_owner = std::move(chunk);
+                    m_input_offset = 0;
+                }
 
                 /**
-                 * Read the given number of bytes from the input queue.
+                 * Read the given number of bytes from the input.
+                 *
+                 * If the data is completely inside the current input chunk,
+                 * no data is copied, the result is a view into the chunk
+                 * which is kept alive by the shared pointer returned with it.
+                 * Only data spanning several input chunks is copied into a
+                 * new string. If the input file is memory-mapped, there is
+                 * only one chunk containing the whole file.
                  *
                  * @param size Number of bytes to read
-                 * @returns String with the data
+                 * @returns Owner of the data and view of the data
                  * @throws osmium::pbf_error If size bytes can't be read
                  */
-                std::string read_from_input_queue(size_t size) {
-                    while (m_input_buffer.size() < size) {
-                        const std::string new_data{get_input()};
-                        if (input_done()) {
-                            throw osmium::pbf_error{"truncated data (EOF encountered)"};
-                        }
-                        m_input_buffer += new_data;
+                std::pair<std::shared_ptr<const void>, data_view> read_from_input_queue(std::size_t size) {
+                    m_file_offset += size;
+
+                    if (input_available() == 0 && size > 0) {
+                        next_input_chunk();
                     }
 
-                    std::string output{m_input_buffer.substr(size)};
-                    m_input_buffer.resize(size);
+                    if (input_available() >= size) {
+                        const data_view data{m_input_chunk.data() + m_input_offset, size};
+                        m_input_offset += size;
+                        return std::make_pair(m_input_owner, data);
+                    }
 
-                    using std::swap;
-                    swap(output, m_input_buffer);
+                    auto joined = std::make_shared<std::string>();
+                    joined->reserve(size);
+                    joined->append(m_input_chunk.data() + m_input_offset, input_available());
+                    while (joined->size() < size) {
+                        next_input_chunk();
+                        const auto len = std::min(size - joined->size(), m_input_chunk.size());
+                        joined->append(m_input_chunk.data(), len);
+                        m_input_offset = len;
+                    }
 
-                    return output;
+                    const data_view data{joined->data(), joined->size()};
+                    return std::make_pair(std::shared_ptr<const void>{std::move(joined)}, data);
+                }
+
+                /**
+                 * Skip the given number of bytes in the input without
+                 * copying them anywhere.
+                 *
+                 * @param size Number of bytes to skip
+                 * @throws osmium::pbf_error If size bytes can't be skipped
+                 */
+                void skip_input(std::size_t size) {
+                    m_file_offset += size;
+
+                    while (size > input_available()) {
+                        size -= input_available();
+                        next_input_chunk();
+                    }
+                    m_input_offset += size;
                 }
 
                 /**
@@ -100,12 +279,8 @@ namespace osmium {
 
                     try {
                         // size is encoded in network byte order
-                        const std::string input_data{read_from_input_queue(sizeof(size))};
-                        const char* d = input_data.data();
-                        size = (static_cast<uint32_t>(d[3])) |
-                               (static_cast<uint32_t>(d[2]) << 8u) |
-                               (static_cast<uint32_t>(d[1]) << 16u) |
-                               (static_cast<uint32_t>(d[0]) << 24u);
+                        const auto input_data = read_from_input_queue(sizeof(size));
+                        size = decode_blob_header_size(input_data.second.data());
                     } catch (const osmium::pbf_error&) {
                         return 0; // EOF
                     }
@@ -117,38 +292,6 @@ namespace osmium {
                     return size;
                 }
 
-                /**
-                 * Decode the BlobHeader. Make sure it contains the expected
-                 * type. Return the size of the following Blob.
-                 */
-                size_t decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>&& pbf_blob_header, const char* expected_type) {
-                    protozero::data_view blob_header_type;
-                    size_t blob_header_datasize = 0;
-
-                    while (pbf_blob_header.next()) {
-                        switch (pbf_blob_header.tag_and_type()) {
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_string_type, protozero::pbf_wire_type::length_delimited):
-                                blob_header_type = pbf_blob_header.get_view();
-                                break;
-                            case protozero::tag_and_type(FileFormat::BlobHeader::required_int32_datasize, protozero::pbf_wire_type::varint):
-                                blob_header_datasize = pbf_blob_header.get_int32();
-                                break;
-                            default:
-                                pbf_blob_header.skip();
-                        }
-                    }
-
-                    if (blob_header_datasize == 0) {
-                        throw osmium::pbf_error{"PBF format error: BlobHeader.datasize missing or zero."};
-                    }
-
-                    if (std::strncmp(expected_type, blob_header_type.data(), blob_header_type.size()) != 0) {
-                        throw osmium::pbf_error{"blob does not have expected type (OSMHeader in first blob, OSMData in following blobs)"};
-                    }
-
-                    return blob_header_datasize;
-                }
-
                 size_t check_type_and_get_blob_size(const char* expected_type) {
                     assert(expected_type);
 
@@ -157,12 +300,12 @@ namespace osmium {
                         return 0;
                     }
 
-                    const std::string blob_header{read_from_input_queue(size)};
+                    const auto blob_header = read_from_input_queue(size);
 
-                    return decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>(blob_header), expected_type);
+                    return decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>(blob_header.second), expected_type);
                 }
 
-                std::string read_from_input_queue_with_check(size_t size) {
+                std::pair<std::shared_ptr<const void>, data_view> read_from_input_queue_with_check(size_t size) {
                     if (size > max_uncompressed_blob_size) {
                         throw osmium::pbf_error{std::string{"invalid blob size: "} +
                                                 std::to_string(size)};
@@ -173,21 +316,125 @@ namespace osmium {
                 // Parse the header in the PBF OSMHeader blob.
                 void parse_header_blob() {
                     const auto size = check_type_and_get_blob_size("OSMHeader");
-                    osmium::io::Header header{decode_header(read_from_input_queue_with_check(size))};
+                    osmium::io::Header header{decode_header(read_from_input_queue_with_check(size).second)};
+                    m_sorted_by_type = header.get("sorting") == "Type_then_ID";
                     set_header_value(header);
                 }
 
-                void parse_data_blobs() {
-                    while (const auto size = check_type_and_get_blob_size("OSMData")) {
-                        std::string input_buffer{read_from_input_queue_with_check(size)};
+                /**
+                 * Read the next data blob selected by read_blobs().
+                 *
+                 * @returns false on EOF.
+                 */
+                bool read_data_blob(std::pair<std::shared_ptr<const void>, data_view>& input_data) {
+                    while (true) {
+                        const auto blob_offset = m_file_offset;
+                        if (read_blobs().past_last(blob_offset)) {
+                            return false;
+                        }
+                        const auto size = check_type_and_get_blob_size("OSMData");
+                        if (size == 0) { // EOF
+                            return false;
+                        }
+
+                        if (read_blobs().contains(blob_offset)) {
+                            input_data = read_from_input_queue_with_check(size);
+                            return true;
+                        }
 
-                        PBFDataBlobDecoder data_blob_parser{std::move(input_buffer), read_types(), read_metadata()};
+                        skip_input(size);
+                    }
+                }
 
-                        if (osmium::config::use_pool_threads_for_pbf_parsing()) {
-                            send_to_output_queue(get_pool().submit(std::move(data_blob_parser)));
-                        } else {
-                            send_to_output_queue(data_blob_parser());
+                void decode_data_blob(std::pair<std::shared_ptr<const void>, data_view>&& input_data) {
+                    PBFDataBlobDecoder data_blob_parser{std::move(input_data.first), input_data.second, read_types(), read_metadata(), prefilter(), read_metadata_fields()};
+                    data_blob_parser.set_stats(stats());
+
+                    if (m_decode_window) {
+                        // Results are delivered in the order the blobs were
+                        // submitted, because the futures go into the output
+                        // queue in this order.
+                        submit_to_output_queue(PBFWindowedDataBlobDecoder{std::move(data_blob_parser), m_decode_window, input_data.second.size()});
+                    } else {
+                        send_to_output_queue(data_blob_parser());
+                    }
+                }
+
+                /**
+                 * The entity types that can be in a blob of a file sorted by
+                 * type, given the type of the entities in the first group of
+                 * the blob and of the first group of the next blob.
+                 */
+                static osmium::osm_entity_bits::type possible_types(osmium::item_type first, osmium::item_type next) noexcept {
+                    if (first == osmium::item_type::undefined) {
+                        first = osmium::item_type::node;
+                    }
+                    if (next == osmium::item_type::undefined) {
+                        next = osmium::item_type::changeset;
+                    }
+
+                    auto types = osmium::osm_entity_bits::nothing;
+                    for (auto t = static_cast<uint16_t>(first); t <= static_cast<uint16_t>(next); ++t) {
+                        types |= osmium::osm_entity_bits::from_item_type(static_cast<osmium::item_type>(t));
+                    }
+                    return types;
+                }
+
+                /**
+                 * In a file sorted by type all nodes come before all ways
+                 * which come before all relations. So the type of the first
+                 * group in a blob and in the following blob tell us which
+                 * types can be in the blob. This type can be found by only
+                 * uncompressing the beginning of the blob. Blobs that can't
+                 * contain any of the requested types are never uncompressed
+                 * completely. If it turns out that the file is not sorted,
+                 * all remaining blobs are decoded normally.
+                 */
+                void parse_sorted_data_blobs() {
+                    std::pair<std::shared_ptr<const void>, data_view> pending;
+                    auto pending_type = osmium::item_type::undefined;
+                    bool has_pending = false;
+
+                    std::pair<std::shared_ptr<const void>, data_view> input_data;
+                    while (read_data_blob(input_data)) {
+                        const auto type = decode_blob_first_group_type(input_data.second);
+                        if (has_pending) {
+                            if (type != osmium::item_type::undefined &&
+                                pending_type != osmium::item_type::undefined &&
+                                type < pending_type) {
+                                // File is not sorted after all, decode
+                                // everything from now on.
+                                decode_data_blob(std::move(pending));
+                                decode_data_blob(std::move(input_data));
+                                while (read_data_blob(input_data)) {
+                                    decode_data_blob(std::move(input_data));
+                                }
+                                return;
+                            }
+                            if (read_types() & possible_types(pending_type, type)) {
+                                decode_data_blob(std::move(pending));
+                            }
                         }
+
+                        pending = std::move(input_data);
+                        pending_type = type;
+                        has_pending = true;
+                    }
+
+                    if (has_pending && (read_types() & possible_types(pending_type, osmium::item_type::changeset))) {
+                        decode_data_blob(std::move(pending));
+                    }
+                }
+
+                void parse_data_blobs() {
+                    if (m_sorted_by_type && (read_types() & osmium::osm_entity_bits::nwr) != osmium::osm_entity_bits::nwr) {
+                        parse_sorted_data_blobs();
+                        return;
+                    }
+
+                    std::pair<std::shared_ptr<const void>, data_view> input_data;
+                    while (read_data_blob(input_data)) {
+                        decode_data_blob(std::move(input_data));
                     }
                 }
 
@@ -195,6 +442,14 @@ namespace osmium {
 
                 explicit PBFParser(parser_arguments& args) :
                     Parser(args) {
+                    set_prefilter_applied();
+
+                    if (mapped_input()) {
+                        m_input_chunk = data_view{mapped_input()->get_addr<const char>(), mapped_input()->size()};
+                        m_input_owner = mapped_input();
+                    }
+
+                    m_decode_window = make_decode_window();
                 }
 
                 PBFParser(const PBFParser&) = delete;
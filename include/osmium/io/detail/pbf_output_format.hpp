@@ -33,19 +33,30 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/geom/spatial_sort.hpp>
 #include <osmium/handler.hpp>
+#include <osmium/handler/check_order.hpp>
 #include <osmium/io/detail/output_format.hpp>
 #include <osmium/io/detail/pbf.hpp> // IWYU pragma: export
 #include <osmium/io/detail/protobuf_tags.hpp>
 #include <osmium/io/detail/queue_util.hpp>
 #include <osmium/io/detail/string_table.hpp>
 #include <osmium/io/detail/zlib.hpp>
+#ifdef OSMIUM_WITH_LZ4
+# include <osmium/io/detail/lz4.hpp>
+#endif
+#ifdef OSMIUM_WITH_ZSTD
+# include <osmium/io/detail/zstd.hpp>
+#endif
 #include <osmium/io/file.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item_iterator.hpp>
 #include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 #include <osmium/osm/location.hpp>
 #include <osmium/osm/metadata_options.hpp>
@@ -60,16 +71,24 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/thread/pool.hpp>
 #include <osmium/util/delta.hpp>
 #include <osmium/util/misc.hpp>
+#include <osmium/util/trace.hpp>
 #include <osmium/visitor.hpp>
 
 #include <protozero/pbf_builder.hpp>
+#include <protozero/pbf_message.hpp>
 #include <protozero/pbf_writer.hpp>
 #include <protozero/types.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <exception>
+#include <functional>
+#include <future>
+#include <stdexcept>
 #include <memory>
 #include <string>
 #include <utility>
@@ -81,6 +100,134 @@ namespace osmium {
 
         namespace detail {
 
+            /// Compression used for the blobs in a PBF file.
+            enum class pbf_compression {
+                none = 0,
+                zlib = 1,
+                lz4  = 2,
+                zstd = 3
+            };
+
+            /**
+             * Get the compression from the value of the "pbf_compression"
+             * file option.
+             *
+             * @throws std::invalid_argument if the value is unknown or the
+             *         compression is not compiled in.
+             */
+            inline pbf_compression get_pbf_compression(const std::string& value) {
+                if (value == "none" || value == "false" || value == "no") {
+                    return pbf_compression::none;
+                }
+                if (value.empty() || value == "zlib" || value == "true" || value == "yes") {
+                    return pbf_compression::zlib;
+                }
+                if (value == "lz4") {
+#ifdef OSMIUM_WITH_LZ4
+                    return pbf_compression::lz4;
+#else
+                    throw std::invalid_argument{"The 'pbf_compression' option 'lz4' needs libosmium compiled with OSMIUM_WITH_LZ4."};
+#endif
+                }
+                if (value == "zstd") {
+#ifdef OSMIUM_WITH_ZSTD
+                    return pbf_compression::zstd;
+#else
+                    throw std::invalid_argument{"The 'pbf_compression' option 'zstd' needs libosmium compiled with OSMIUM_WITH_ZSTD."};
+#endif
+                }
+                throw std::invalid_argument{"Unknown value for 'pbf_compression' option: '" + value + "'."};
+            }
+
+            /**
+             * Get the compression level from the value of the
+             * "pbf_compression_level" file option. An empty value means
+             * the default level of the compression.
+             *
+             * @throws std::invalid_argument if the level is not valid for
+             *         the compression.
+             */
+            inline int get_pbf_compression_level(const std::string& value, pbf_compression compression) {
+                int min_level = 0;
+                int max_level = 0;
+                int default_level = 0;
+
+                switch (compression) {
+                    case pbf_compression::zlib:
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                        max_level = 12;
+#else
+                        max_level = 9;
+#endif
+                        default_level = Z_DEFAULT_COMPRESSION;
+                        break;
+                    case pbf_compression::zstd:
+#ifdef OSMIUM_WITH_ZSTD
+                        min_level = 1;
+                        max_level = ::ZSTD_maxCLevel();
+                        default_level = 3;
+#endif
+                        break;
+                    default:
+                        break;
+                }
+
+                if (value.empty()) {
+                    return default_level;
+                }
+
+                char* end = nullptr;
+                const long level = std::strtol(value.c_str(), &end, 10); // NOLINT(google-runtime-int)
+                if (*end != '\0' || level < min_level || level > max_level || max_level == 0) {
+                    throw std::invalid_argument{"Invalid value for 'pbf_compression_level' option: '" + value + "'."};
+                }
+
+                return static_cast<int>(level);
+            }
+
+            /**
+             * Get the value of a numeric file option.
+             *
+             * @throws std::invalid_argument if the value is not a number
+             *         between min and max.
+             */
+            inline std::size_t get_pbf_size_option(const osmium::io::File& file, const char* name, std::size_t default_value, std::size_t min, std::size_t max) {
+                const std::string value{file.get(name)};
+                if (value.empty()) {
+                    return default_value;
+                }
+
+                char* end = nullptr;
+                const auto result = std::strtoull(value.c_str(), &end, 10);
+                if (*end != '\0' || value[0] == '-' || result < min || result > max) {
+                    throw std::invalid_argument{std::string{"Invalid value for '"} + name + "' option: '" + value + "'."};
+                }
+
+                return static_cast<std::size_t>(result);
+            }
+
+            /**
+             * Get the value of a file option containing an extent in
+             * degrees and return it in Location coordinate units.
+             *
+             * @throws std::invalid_argument if the value is not a number
+             *         between 0 and 180.
+             */
+            inline int32_t get_pbf_extent_option(const osmium::io::File& file, const char* name) {
+                const std::string value{file.get(name)};
+                if (value.empty()) {
+                    return 0;
+                }
+
+                char* end = nullptr;
+                const double result = std::strtod(value.c_str(), &end);
+                if (*end != '\0' || !(result >= 0.0 && result <= 180.0)) {
+                    throw std::invalid_argument{std::string{"Invalid value for '"} + name + "' option: '" + value + "'."};
+                }
+
+                return osmium::Location::double_to_fix(result);
+            }
+
             struct pbf_output_options {
 
                 /// Which metadata of objects should be added?
@@ -90,14 +237,19 @@ namespace osmium {
                 bool use_dense_nodes = true;
 
                 /**
-                 * Should the PBF blobs contain zlib compressed data?
+                 * How should the data in the PBF blobs be compressed?
                  *
-                 * The zlib compression is optional, it's possible to store the
-                 * blobs in raw format. Disabling the compression can improve
-                 * the writing speed a little but the output will be 2x to 3x
-                 * bigger.
+                 * The zlib compression is the default, it's also
+                 * possible to store the blobs in raw format. Disabling
+                 * the compression can improve the writing speed a little
+                 * but the output will be 2x to 3x bigger. The lz4 and
+                 * zstd compressions are faster than zlib but not all
+                 * programs can read them.
                  */
-                bool use_compression = true;
+                pbf_compression compression = pbf_compression::zlib;
+
+                /// Compression level, the meaning depends on the compression.
+                int compression_level = Z_DEFAULT_COMPRESSION;
 
                 /// Add the "HistoricalInformation" header flag.
                 bool add_historical_information_flag = false;
@@ -108,6 +260,56 @@ namespace osmium {
                 /// Should node locations be added to ways?
                 bool locations_on_ways = false;
 
+                /**
+                 * If set, the node locations added to ways are looked up
+                 * here instead of being taken from the ways.
+                 */
+                osmium::io::way_node_locations way_node_locations{};
+
+                /**
+                 * Should the string table of each block be sorted by how
+                 * often the strings are used? Frequent strings then get
+                 * small ids which need only one byte. This makes blocks
+                 * smaller but writing a bit slower.
+                 */
+                bool sort_stringtable = false;
+
+                /**
+                 * Should the primitive blocks be built in the thread pool?
+                 * Usually only the compression runs in the pool and the
+                 * objects are encoded in the writer thread. If this is set,
+                 * each buffer is split into block-sized ranges which are
+                 * encoded and compressed completely in the pool.
+                 */
+                bool build_blocks_in_pool = false;
+
+                /// Maximum number of entities in a block.
+                int max_block_entities = 8000;
+
+                /**
+                 * Maximum (estimated) uncompressed size of a block in bytes.
+                 * The block is stored when it reaches this size, so the
+                 * last object added can make it a bit larger.
+                 */
+                std::size_t max_block_size = max_uncompressed_blob_size * 95u / 100u;
+
+                /**
+                 * Maximum compressed size of a block in bytes, 0 for no
+                 * limit. The compressed size can only be known after the
+                 * compression, so the uncompressed size limit is derived
+                 * from the compression ratio of the blocks written so far.
+                 */
+                std::size_t max_compressed_block_size = 0;
+
+                /**
+                 * Maximum extent of the nodes in a block in lon and lat
+                 * direction in units of the Location coordinates, 0 for no
+                 * limit. If a node would make the bounding box of its block
+                 * larger, a new block is started. This keeps nodes which
+                 * are near each other in the same blocks.
+                 */
+                int32_t max_block_extent = 0;
+
             }; // struct pbf_output_options
 
             /**
@@ -126,6 +328,16 @@ namespace osmium {
                 max_entities_per_block = 8000
             };
 
+            /**
+             * Sizes of the blocks written so far before and after the
+             * compression. This is updated from the threads doing the
+             * compression.
+             */
+            struct pbf_compression_statistics {
+                std::atomic<uint64_t> uncompressed{0};
+                std::atomic<uint64_t> compressed{0};
+            };
+
             enum {
                 location_granularity = 100
             };
@@ -148,7 +360,11 @@ namespace osmium {
 
                 pbf_blob_type m_blob_type;
 
-                bool m_use_compression;
+                pbf_compression m_compression;
+
+                int m_compression_level;
+
+                std::shared_ptr<pbf_compression_statistics> m_statistics;
 
             public:
 
@@ -157,13 +373,17 @@ namespace osmium {
                  *
                  * @param msg Protobuf-message containing the blob data
                  * @param type Type of blob.
-                 * @param use_compression Should the output be compressed using
-                 *        zlib?
+                 * @param compression How should the output be compressed?
+                 * @param compression_level Level for the compression.
+                 * @param statistics If set, the sizes of the data before and
+                 *        after compression are added to it.
                  */
-                SerializeBlob(std::string&& msg, pbf_blob_type type, bool use_compression) :
+                SerializeBlob(std::string&& msg, pbf_blob_type type, pbf_compression compression, int compression_level = Z_DEFAULT_COMPRESSION, std::shared_ptr<pbf_compression_statistics> statistics = nullptr) :
                     m_msg(std::move(msg)),
                     m_blob_type(type),
-                    m_use_compression(use_compression) {
+                    m_compression(compression),
+                    m_compression_level(compression_level),
+                    m_statistics(std::move(statistics)) {
                 }
 
                 /**
@@ -172,16 +392,39 @@ namespace osmium {
                  * to be written to a file.
                  */
                 std::string operator()() {
+                    const osmium::trace::Span span{"compress"};
                     assert(m_msg.size() <= max_uncompressed_blob_size);
 
                     std::string blob_data;
                     protozero::pbf_builder<FileFormat::Blob> pbf_blob{blob_data};
 
-                    if (m_use_compression) {
-                        pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
-                        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zlib_data, osmium::io::detail::zlib_compress(m_msg));
-                    } else {
-                        pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_raw, m_msg);
+                    switch (m_compression) {
+                        case pbf_compression::none:
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_raw, m_msg);
+                            break;
+                        case pbf_compression::zlib:
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zlib_data, osmium::io::detail::zlib_compress(m_msg, m_compression_level));
+                            break;
+#ifdef OSMIUM_WITH_LZ4
+                        case pbf_compression::lz4:
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_lz4_data, osmium::io::detail::lz4_compress(m_msg));
+                            break;
+#endif
+#ifdef OSMIUM_WITH_ZSTD
+                        case pbf_compression::zstd:
+                            pbf_blob.add_int32(FileFormat::Blob::optional_int32_raw_size, int32_t(m_msg.size()));
+                            pbf_blob.add_bytes(FileFormat::Blob::optional_bytes_zstd_data, osmium::io::detail::zstd_compress(m_msg, m_compression_level));
+                            break;
+#endif
+                        default:
+                            throw std::invalid_argument{"compression not supported"};
+                    }
+
+                    if (m_statistics) {
+                        m_statistics->uncompressed += m_msg.size();
+                        m_statistics->compressed += blob_data.size();
                     }
 
                     std::string blob_header_data;
@@ -214,6 +457,101 @@ namespace osmium {
 
             }; // class SerializeBlob
 
+            /**
+             * Copy the current field from the reader to the writer.
+             */
+            inline void copy_pbf_field(protozero::pbf_reader& reader, protozero::pbf_writer& writer) {
+                const auto tag = reader.tag();
+                switch (reader.wire_type()) {
+                    case protozero::pbf_wire_type::varint:
+                        writer.add_uint64(tag, reader.get_uint64());
+                        break;
+                    case protozero::pbf_wire_type::fixed64:
+                        writer.add_fixed64(tag, reader.get_fixed64());
+                        break;
+                    case protozero::pbf_wire_type::length_delimited:
+                        {
+                            const auto view = reader.get_view();
+                            writer.add_bytes(tag, view.data(), view.size());
+                        }
+                        break;
+                    case protozero::pbf_wire_type::fixed32:
+                        writer.add_fixed32(tag, reader.get_fixed32());
+                        break;
+                    default:
+                        throw osmium::pbf_error{"unknown pbf wire type"};
+                }
+            }
+
+            /**
+             * Rewrite a Node, Way, or Relation message replacing all string
+             * ids with the ids from new_ids.
+             */
+            inline void remap_object_string_ids(const protozero::data_view& data, protozero::pbf_writer& writer, const std::vector<int32_t>& new_ids, bool is_relation) {
+                // Keys, values, and info use the same tags in nodes, ways,
+                // and relations, roles are only in relations. In ways the
+                // tag used for roles in relations is used for the refs.
+                std::vector<uint32_t> ids;
+                protozero::pbf_message<OSMFormat::Relation> pbf_object{data};
+                while (pbf_object.next()) {
+                    switch (pbf_object.tag_and_type()) {
+                        case protozero::tag_and_type(OSMFormat::Relation::packed_int32_roles_sid, protozero::pbf_wire_type::length_delimited):
+                            if (!is_relation) {
+                                copy_pbf_field(pbf_object, writer);
+                                break;
+                            }
+                            // fallthrough
+                        case protozero::tag_and_type(OSMFormat::Relation::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                        case protozero::tag_and_type(OSMFormat::Relation::packed_uint32_vals, protozero::pbf_wire_type::length_delimited):
+                            {
+                                const auto tag = protozero::pbf_tag_type(pbf_object.tag());
+                                ids.clear();
+                                for (const auto id : pbf_object.get_packed_uint32()) {
+                                    ids.push_back(static_cast<uint32_t>(new_ids.at(id)));
+                                }
+                                writer.add_packed_uint32(tag, ids.cbegin(), ids.cend());
+                            }
+                            break;
+                        case protozero::tag_and_type(OSMFormat::Relation::optional_Info_info, protozero::pbf_wire_type::length_delimited):
+                            {
+                                protozero::pbf_writer pbf_info{writer, protozero::pbf_tag_type(OSMFormat::Relation::optional_Info_info)};
+                                protozero::pbf_message<OSMFormat::Info> pbf_info_in{pbf_object.get_view()};
+                                while (pbf_info_in.next()) {
+                                    if (pbf_info_in.tag_and_type() == protozero::tag_and_type(OSMFormat::Info::optional_uint32_user_sid, protozero::pbf_wire_type::varint)) {
+                                        pbf_info.add_uint32(protozero::pbf_tag_type(OSMFormat::Info::optional_uint32_user_sid), static_cast<uint32_t>(new_ids.at(pbf_info_in.get_uint32())));
+                                    } else {
+                                        copy_pbf_field(pbf_info_in, pbf_info);
+                                    }
+                                }
+                            }
+                            break;
+                        default:
+                            copy_pbf_field(pbf_object, writer);
+                    }
+                }
+            }
+
+            /**
+             * Rewrite a PrimitiveGroup with nodes, ways, or relations
+             * replacing all string ids with the ids from new_ids.
+             */
+            inline std::string remap_group_string_ids(const std::string& group_data, const std::vector<int32_t>& new_ids, bool is_relation) {
+                std::string data;
+                protozero::pbf_writer pbf_group{data};
+
+                protozero::pbf_reader pbf_group_in{group_data};
+                while (pbf_group_in.next()) {
+                    if (pbf_group_in.wire_type() != protozero::pbf_wire_type::length_delimited) {
+                        copy_pbf_field(pbf_group_in, pbf_group);
+                        continue;
+                    }
+                    protozero::pbf_writer pbf_object{pbf_group, pbf_group_in.tag()};
+                    remap_object_string_ids(pbf_group_in.get_view(), pbf_object, new_ids, is_relation);
+                }
+
+                return data;
+            }
+
             /**
              * Contains the code to pack any number of nodes into a DenseNode
              * structure.
@@ -239,23 +577,22 @@ namespace osmium {
                 std::vector<int64_t> m_lons;
                 std::vector<int32_t> m_tags;
 
-                osmium::DeltaEncode<object_id_type, int64_t> m_delta_id;
-
                 osmium::DeltaEncode<uint32_t, int64_t> m_delta_timestamp;
                 osmium::DeltaEncode<changeset_id_type, int64_t> m_delta_changeset;
                 osmium::DeltaEncode<user_id_type, int32_t> m_delta_uid;
                 osmium::DeltaEncode<int32_t, int32_t> m_delta_user_sid;
 
-                osmium::DeltaEncode<int64_t, int64_t> m_delta_lat;
-                osmium::DeltaEncode<int64_t, int64_t> m_delta_lon;
-
-                const pbf_output_options& m_options;
+                const pbf_output_options* m_options;
 
             public:
 
                 DenseNodes(StringTable& stringtable, const pbf_output_options& options) :
                     m_stringtable(stringtable),
-                    m_options(options) {
+                    m_options(&options) {
+                }
+
+                void set_options(const pbf_output_options& options) noexcept {
+                    m_options = &options;
                 }
 
                 /// Clear object for re-use. Keep the allocated memory.
@@ -273,15 +610,10 @@ namespace osmium {
                     m_lons.clear();
                     m_tags.clear();
 
-                    m_delta_id.clear();
-
                     m_delta_timestamp.clear();
                     m_delta_changeset.clear();
                     m_delta_uid.clear();
                     m_delta_user_sid.clear();
-
-                    m_delta_lat.clear();
-                    m_delta_lon.clear();
                 }
 
                 std::size_t size() const noexcept {
@@ -289,30 +621,30 @@ namespace osmium {
                 }
 
                 void add_node(const osmium::Node& node) {
-                    m_ids.push_back(m_delta_id.update(node.id()));
+                    m_ids.push_back(node.id());
 
-                    if (m_options.add_metadata.version()) {
+                    if (m_options->add_metadata.version()) {
                         assert(node.version() <= static_cast<std::size_t>(std::numeric_limits<int32_t>::max()));
                         m_versions.push_back(static_cast<int32_t>(node.version()));
                     }
-                    if (m_options.add_metadata.timestamp()) {
+                    if (m_options->add_metadata.timestamp()) {
                         m_timestamps.push_back(m_delta_timestamp.update(uint32_t(node.timestamp())));
                     }
-                    if (m_options.add_metadata.changeset()) {
+                    if (m_options->add_metadata.changeset()) {
                         m_changesets.push_back(m_delta_changeset.update(node.changeset()));
                     }
-                    if (m_options.add_metadata.uid()) {
+                    if (m_options->add_metadata.uid()) {
                         m_uids.push_back(m_delta_uid.update(node.uid()));
                     }
-                    if (m_options.add_metadata.user()) {
+                    if (m_options->add_metadata.user()) {
                         m_user_sids.push_back(m_delta_user_sid.update(m_stringtable.add(node.user())));
                     }
-                    if (m_options.add_visible_flag) {
+                    if (m_options->add_visible_flag) {
                         m_visibles.push_back(node.visible());
                     }
 
-                    m_lats.push_back(m_delta_lat.update(lonlat2int(node.location().lat_without_check())));
-                    m_lons.push_back(m_delta_lon.update(lonlat2int(node.location().lon_without_check())));
+                    m_lats.push_back(lonlat2int(node.location().lat_without_check()));
+                    m_lons.push_back(lonlat2int(node.location().lon_without_check()));
 
                     for (const auto& tag : node.tags()) {
                         m_tags.push_back(m_stringtable.add(tag.key()));
@@ -321,38 +653,79 @@ namespace osmium {
                     m_tags.push_back(0);
                 }
 
-                std::string serialize() const {
+                /**
+                 * Serialize the nodes.
+                 *
+                 * @param new_ids If this is not empty, it maps string ids
+                 *                as stored to the ids that should be
+                 *                written.
+                 */
+                std::string serialize(const std::vector<int32_t>& new_ids = std::vector<int32_t>{}) const {
+                    if (!new_ids.empty()) {
+                        return serialize_with_new_string_ids(new_ids);
+                    }
+                    return serialize(m_user_sids, m_tags);
+                }
+
+                std::string serialize_with_new_string_ids(const std::vector<int32_t>& new_ids) const {
+                    std::vector<int32_t> user_sids;
+                    user_sids.reserve(m_user_sids.size());
+                    osmium::DeltaDecode<int32_t> delta_decode;
+                    osmium::DeltaEncode<int32_t, int32_t> delta_encode;
+                    for (const auto sid : m_user_sids) {
+                        user_sids.push_back(delta_encode.update(new_ids.at(delta_decode.update(sid))));
+                    }
+
+                    std::vector<int32_t> tags;
+                    tags.reserve(m_tags.size());
+                    for (const auto id : m_tags) {
+                        tags.push_back(new_ids.at(id));
+                    }
+
+                    return serialize(user_sids, tags);
+                }
+
+                std::string serialize(const std::vector<int32_t>& user_sids, const std::vector<int32_t>& tags) const {
                     std::string data;
                     protozero::pbf_builder<OSMFormat::DenseNodes> pbf_dense_nodes{data};
 
-                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_id, m_ids.cbegin(), m_ids.cend());
+                    // The IDs and coordinates are stored as they are and
+                    // delta encoded here in one go, which is much faster
+                    // than doing it node by node.
+                    std::vector<int64_t> deltas(m_ids.size());
 
-                    if (m_options.add_metadata.any() || m_options.add_visible_flag) {
+                    osmium::DeltaEncode<int64_t, int64_t>{}.encode_span(m_ids.data(), m_ids.data() + m_ids.size(), deltas.data());
+                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_id, deltas.cbegin(), deltas.cend());
+
+                    if (m_options->add_metadata.any() || m_options->add_visible_flag) {
                         protozero::pbf_builder<OSMFormat::DenseInfo> pbf_dense_info{pbf_dense_nodes, OSMFormat::DenseNodes::optional_DenseInfo_denseinfo};
-                        if (m_options.add_metadata.version()) {
+                        if (m_options->add_metadata.version()) {
                             pbf_dense_info.add_packed_int32(OSMFormat::DenseInfo::packed_int32_version, m_versions.cbegin(), m_versions.cend());
                         }
-                        if (m_options.add_metadata.timestamp()) {
+                        if (m_options->add_metadata.timestamp()) {
                             pbf_dense_info.add_packed_sint64(OSMFormat::DenseInfo::packed_sint64_timestamp, m_timestamps.cbegin(), m_timestamps.cend());
                         }
-                        if (m_options.add_metadata.changeset()) {
+                        if (m_options->add_metadata.changeset()) {
                             pbf_dense_info.add_packed_sint64(OSMFormat::DenseInfo::packed_sint64_changeset, m_changesets.cbegin(), m_changesets.cend());
                         }
-                        if (m_options.add_metadata.uid()) {
+                        if (m_options->add_metadata.uid()) {
                             pbf_dense_info.add_packed_sint32(OSMFormat::DenseInfo::packed_sint32_uid, m_uids.cbegin(), m_uids.cend());
                         }
-                        if (m_options.add_metadata.user()) {
-                            pbf_dense_info.add_packed_sint32(OSMFormat::DenseInfo::packed_sint32_user_sid, m_user_sids.cbegin(), m_user_sids.cend());
+                        if (m_options->add_metadata.user()) {
+                            pbf_dense_info.add_packed_sint32(OSMFormat::DenseInfo::packed_sint32_user_sid, user_sids.cbegin(), user_sids.cend());
                         }
-                        if (m_options.add_visible_flag) {
+                        if (m_options->add_visible_flag) {
                             pbf_dense_info.add_packed_bool(OSMFormat::DenseInfo::packed_bool_visible, m_visibles.cbegin(), m_visibles.cend());
                         }
                     }
 
-                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_lat, m_lats.cbegin(), m_lats.cend());
-                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_lon, m_lons.cbegin(), m_lons.cend());
+                    osmium::DeltaEncode<int64_t, int64_t>{}.encode_span(m_lats.data(), m_lats.data() + m_lats.size(), deltas.data());
+                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_lat, deltas.cbegin(), deltas.cend());
 
-                    pbf_dense_nodes.add_packed_int32(OSMFormat::DenseNodes::packed_int32_keys_vals, m_tags.cbegin(), m_tags.cend());
+                    osmium::DeltaEncode<int64_t, int64_t>{}.encode_span(m_lons.data(), m_lons.data() + m_lons.size(), deltas.data());
+                    pbf_dense_nodes.add_packed_sint64(OSMFormat::DenseNodes::packed_sint64_lon, deltas.cbegin(), deltas.cend());
+
+                    pbf_dense_nodes.add_packed_int32(OSMFormat::DenseNodes::packed_int32_keys_vals, tags.cbegin(), tags.cend());
 
                     return data;
                 }
@@ -382,6 +755,14 @@ namespace osmium {
                     return m_pbf_primitive_group_data;
                 }
 
+                /**
+                 * Use different options from now on. The block keeps
+                 * a reference to the options, they must outlive its use.
+                 */
+                void set_options(const pbf_output_options& options) noexcept {
+                    m_dense_nodes.set_options(options);
+                }
+
                 void reset(OSMFormat::PrimitiveGroup type) {
                     m_pbf_primitive_group_data.clear();
                     m_stringtable.clear();
@@ -390,12 +771,41 @@ namespace osmium {
                     m_count = 0;
                 }
 
+                /**
+                 * Serialize the group with the string ids replaced by the
+                 * ids in new_ids.
+                 */
+                std::string group_data_with_new_string_ids(const std::vector<int32_t>& new_ids) const {
+                    if (type() == OSMFormat::PrimitiveGroup::optional_DenseNodes_dense) {
+                        std::string data;
+                        protozero::pbf_builder<OSMFormat::PrimitiveGroup> pbf_group{data};
+                        pbf_group.add_message(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, m_dense_nodes.serialize(new_ids));
+                        return data;
+                    }
+                    return remap_group_string_ids(m_pbf_primitive_group_data, new_ids, type() == OSMFormat::PrimitiveGroup::repeated_Relation_relations);
+                }
+
+                std::vector<int32_t> string_ids_by_frequency() const {
+                    return m_stringtable.ids_by_frequency();
+                }
+
                 void write_stringtable(protozero::pbf_builder<OSMFormat::StringTable>& pbf_string_table) {
                     for (const char* s : m_stringtable) {
                         pbf_string_table.add_bytes(OSMFormat::StringTable::repeated_bytes_s, s);
                     }
                 }
 
+                void write_stringtable(protozero::pbf_builder<OSMFormat::StringTable>& pbf_string_table, const std::vector<int32_t>& new_ids) {
+                    std::vector<const char*> strings(new_ids.size());
+                    std::size_t id = 0;
+                    for (const char* s : m_stringtable) {
+                        strings[new_ids[id++]] = s;
+                    }
+                    for (const char* s : strings) {
+                        pbf_string_table.add_bytes(OSMFormat::StringTable::repeated_bytes_s, s);
+                    }
+                }
+
                 protozero::pbf_builder<OSMFormat::PrimitiveGroup>& group() noexcept {
                     ++m_count;
                     return m_pbf_primitive_group;
@@ -443,43 +853,108 @@ namespace osmium {
                 };
 
                 bool can_add(OSMFormat::PrimitiveGroup type) const noexcept {
+                    return can_add(type, max_entities_per_block, max_used_blob_size);
+                }
+
+                bool can_add(OSMFormat::PrimitiveGroup type, int max_entities, std::size_t max_size) const noexcept {
                     if (type != m_type) {
                         return false;
                     }
-                    if (count() >= max_entities_per_block) {
+                    if (count() >= max_entities) {
                         return false;
                     }
-                    return size() < max_used_blob_size;
+                    return size() < max_size && size() < max_used_blob_size;
                 }
 
             }; // class PrimitiveBlock
 
-            class PBFOutputFormat : public osmium::io::detail::OutputFormat, public osmium::handler::Handler {
+            /**
+             * Encodes OSM objects into PBF primitive blocks. Each finished
+             * block is handed to the store function as a serialized
+             * PrimitiveBlock message (without the surrounding blob).
+             *
+             * The PrimitiveBlock used for building the blocks is reset
+             * after each block, so its memory is re-used.
+             */
+            class PBFBlockEncoder : public osmium::handler::Handler {
+
+                const pbf_output_options& m_options;
 
-                pbf_output_options m_options;
+                PrimitiveBlock& m_primitive_block;
 
-                PrimitiveBlock m_primitive_block;
+                std::function<void(std::string&&, const PBFBlobIndex::entry&)> m_store;
+
+                std::shared_ptr<pbf_compression_statistics> m_statistics;
+
+                // Types, IDs and bounding box of the objects in the
+                // current block. The offset and size are not set.
+                PBFBlobIndex::entry m_entry;
+
+                // Locations of the nodes of the current way if they are
+                // looked up in the way_node_locations.
+                std::vector<osmium::Location> m_way_locations;
+
+                void add_to_entry(const osmium::OSMObject& object) noexcept {
+                    m_entry.types |= osmium::osm_entity_bits::from_item_type(object.type());
+                    m_entry.min_id = std::min(m_entry.min_id, object.id());
+                    m_entry.max_id = std::max(m_entry.max_id, object.id());
+                }
+
+                std::size_t max_block_size() const noexcept {
+                    if (m_options.max_compressed_block_size == 0 || !m_statistics) {
+                        return m_options.max_block_size;
+                    }
+
+                    // Until something was compressed assume the
+                    // data doesn't compress at all.
+                    const uint64_t uncompressed = m_statistics->uncompressed;
+                    const uint64_t compressed = m_statistics->compressed;
+                    uint64_t size = m_options.max_compressed_block_size;
+                    if (compressed > 0) {
+                        size = size * uncompressed / compressed;
+                    }
+
+                    return std::min(m_options.max_block_size, static_cast<std::size_t>(size));
+                }
+
+                bool fits_block_extent(const osmium::Location& location) const noexcept {
+                    if (m_options.max_block_extent == 0 || !location.valid() || !m_entry.bbox.valid()) {
+                        return true;
+                    }
+                    osmium::Box box{m_entry.bbox};
+                    box.extend(location);
+                    return int64_t(box.top_right().x()) - box.bottom_left().x() <= m_options.max_block_extent &&
+                           int64_t(box.top_right().y()) - box.bottom_left().y() <= m_options.max_block_extent;
+                }
 
                 void store_primitive_block() {
                     if (m_primitive_block.count() == 0) {
                         return;
                     }
 
+                    // The size of the block is an upper bound of the size
+                    // of the serialized data, so this will only allocate
+                    // once.
                     std::string primitive_block_data;
+                    primitive_block_data.reserve(m_primitive_block.size() + 64);
                     protozero::pbf_builder<OSMFormat::PrimitiveBlock> primitive_block{primitive_block_data};
 
-                    {
-                        protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table{primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable};
-                        m_primitive_block.write_stringtable(pbf_string_table);
+                    if (m_options.sort_stringtable) {
+                        const auto new_ids = m_primitive_block.string_ids_by_frequency();
+                        {
+                            protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table{primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable};
+                            m_primitive_block.write_stringtable(pbf_string_table, new_ids);
+                        }
+                        primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data_with_new_string_ids(new_ids));
+                    } else {
+                        {
+                            protozero::pbf_builder<OSMFormat::StringTable> pbf_string_table{primitive_block, OSMFormat::PrimitiveBlock::required_StringTable_stringtable};
+                            m_primitive_block.write_stringtable(pbf_string_table);
+                        }
+                        primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data());
                     }
 
-                    primitive_block.add_message(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, m_primitive_block.group_data());
-
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(primitive_block_data),
-                                      pbf_blob_type::data,
-                                      m_options.use_compression}
-                    ));
+                    m_store(std::move(primitive_block_data), m_entry);
                 }
 
                 template <typename T>
@@ -524,100 +999,92 @@ namespace osmium {
                     }
                 }
 
-                void switch_primitive_block_type(OSMFormat::PrimitiveGroup type) {
-                    if (!m_primitive_block.can_add(type)) {
-                        store_primitive_block();
-                        m_primitive_block.reset(type);
+                // Add the locations of the way nodes from the lookup
+                // function, each location is looked up only once.
+                void add_looked_up_locations(const osmium::Way& way, protozero::pbf_builder<OSMFormat::Way>& pbf_way) {
+                    m_way_locations.clear();
+                    for (const auto& node_ref : way.nodes()) {
+                        m_way_locations.push_back(m_options.way_node_locations(node_ref.ref()));
                     }
-                }
-
-            public:
 
-                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
-                    OutputFormat(pool, output_queue),
-                    m_primitive_block(m_options) {
-
-                    if (!file.get("pbf_add_metadata").empty()) {
-                        throw std::invalid_argument{"The 'pbf_add_metadata' option is deprecated. Please use 'add_metadata' instead."};
-                    }
-
-                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
-                    m_options.use_compression = file.get("pbf_compression") != "none" && file.is_not_false("pbf_compression");
-                    m_options.add_metadata = osmium::metadata_options{file.get("add_metadata")};
-                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
-                    m_options.add_visible_flag = file.has_multiple_object_versions();
-                    m_options.locations_on_ways = file.is_true("locations_on_ways");
-                }
-
-                void write_header(const osmium::io::Header& header) final {
-                    std::string data;
-                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block{data};
-
-                    if (!header.boxes().empty()) {
-                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox{pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox};
-
-                        osmium::Box box = header.joined_boxes();
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
-                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
-                    }
-
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
-
-                    if (m_options.use_dense_nodes) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
-                    }
-
-                    if (m_options.add_historical_information_flag) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
+                    {
+                        osmium::DeltaEncode<int64_t, int64_t> delta_id;
+                        protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lon)};
+                        for (const auto& location : m_way_locations) {
+                            field.add_element(delta_id.update(lonlat2int(location.lon_without_check())));
+                        }
                     }
-
-                    if (m_options.locations_on_ways) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
+                    {
+                        osmium::DeltaEncode<int64_t, int64_t> delta_id;
+                        protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lat)};
+                        for (const auto& location : m_way_locations) {
+                            field.add_element(delta_id.update(lonlat2int(location.lat_without_check())));
+                        }
                     }
+                }
 
-                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
-
-                    const std::string osmosis_replication_timestamp{header.get("osmosis_replication_timestamp")};
-                    if (!osmosis_replication_timestamp.empty()) {
-                        osmium::Timestamp ts{osmosis_replication_timestamp.c_str()};
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
-                    }
+                void start_new_block(OSMFormat::PrimitiveGroup type) {
+                    store_primitive_block();
+                    m_primitive_block.reset(type);
+                    m_entry = PBFBlobIndex::entry{};
+                }
 
-                    const std::string osmosis_replication_sequence_number{header.get("osmosis_replication_sequence_number")};
-                    if (!osmosis_replication_sequence_number.empty()) {
-                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, osmium::detail::str_to_int<int64_t>(osmosis_replication_sequence_number.c_str()));
+                void switch_primitive_block_type(OSMFormat::PrimitiveGroup type) {
+                    if (!m_primitive_block.can_add(type, m_options.max_block_entities, max_block_size())) {
+                        start_new_block(type);
                     }
+                }
 
-                    const std::string osmosis_replication_base_url{header.get("osmosis_replication_base_url")};
-                    if (!osmosis_replication_base_url.empty()) {
-                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
+                void switch_primitive_block_type(OSMFormat::PrimitiveGroup type, const osmium::Location& location) {
+                    if (!m_primitive_block.can_add(type, m_options.max_block_entities, max_block_size()) ||
+                        !fits_block_extent(location)) {
+                        start_new_block(type);
                     }
-
-                    m_output_queue.push(m_pool.submit(
-                        SerializeBlob{std::move(data),
-                                      pbf_blob_type::header,
-                                      m_options.use_compression}
-                        ));
+                    m_entry.bbox.extend(location);
                 }
 
-                void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    osmium::apply(buffer.cbegin(), buffer.cend(), *this);
+            public:
+
+                /**
+                 * Create a block encoder.
+                 *
+                 * @param options The output options.
+                 * @param primitive_block The block used for building the
+                 *        blocks.
+                 * @param store Function called with each finished block and
+                 *        the blob index entry for it (without offset and
+                 *        size).
+                 * @param statistics Compression statistics used if there
+                 *        is a maximum compressed block size.
+                 */
+                PBFBlockEncoder(const pbf_output_options& options, PrimitiveBlock& primitive_block, std::function<void(std::string&&, const PBFBlobIndex::entry&)> store, std::shared_ptr<pbf_compression_statistics> statistics = nullptr) :
+                    m_options(options),
+                    m_primitive_block(primitive_block),
+                    m_store(std::move(store)),
+                    m_statistics(std::move(statistics)) {
                 }
 
-                void write_end() final {
-                    store_primitive_block();
+                /**
+                 * Store the current block if it contains any objects.
+                 *
+                 * This is deliberately not called flush(), because
+                 * osmium::apply() calls flush() on the handler after each
+                 * buffer and blocks should span buffers.
+                 */
+                void finish_block() {
+                    start_new_block(OSMFormat::PrimitiveGroup::unknown);
                 }
 
                 void node(const osmium::Node& node) {
                     if (m_options.use_dense_nodes) {
-                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense);
+                        switch_primitive_block_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, node.location());
+                        add_to_entry(node);
                         m_primitive_block.add_dense_node(node);
                         return;
                     }
 
-                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes);
+                    switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, node.location());
+                    add_to_entry(node);
                     protozero::pbf_builder<OSMFormat::Node> pbf_node{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Node_nodes};
 
                     pbf_node.add_sint64(OSMFormat::Node::required_sint64_id, node.id());
@@ -629,6 +1096,7 @@ namespace osmium {
 
                 void way(const osmium::Way& way) {
                     switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Way_ways);
+                    add_to_entry(way);
                     protozero::pbf_builder<OSMFormat::Way> pbf_way{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Way_ways};
 
                     pbf_way.add_int64(OSMFormat::Way::required_int64_id, way.id());
@@ -642,7 +1110,9 @@ namespace osmium {
                         }
                     }
 
-                    if (m_options.locations_on_ways) {
+                    if (m_options.locations_on_ways && m_options.way_node_locations) {
+                        add_looked_up_locations(way, pbf_way);
+                    } else if (m_options.locations_on_ways) {
                         {
                             osmium::DeltaEncode<int64_t, int64_t> delta_id;
                             protozero::packed_field_sint64 field{pbf_way, protozero::pbf_tag_type(OSMFormat::Way::packed_sint64_lon)};
@@ -662,6 +1132,7 @@ namespace osmium {
 
                 void relation(const osmium::Relation& relation) {
                     switch_primitive_block_type(OSMFormat::PrimitiveGroup::repeated_Relation_relations);
+                    add_to_entry(relation);
                     protozero::pbf_builder<OSMFormat::Relation> pbf_relation{m_primitive_block.group(), OSMFormat::PrimitiveGroup::repeated_Relation_relations};
 
                     pbf_relation.add_int64(OSMFormat::Relation::required_int64_id, relation.id());
@@ -690,6 +1161,404 @@ namespace osmium {
                     }
                 }
 
+            }; // class PBFBlockEncoder
+
+            /**
+             * Get the PrimitiveBlock of this thread for building blocks
+             * in the thread pool. It is kept for the next task, so its
+             * string table and DenseNodes arrays don't have to be allocated
+             * again.
+             */
+            inline PrimitiveBlock& thread_primitive_block(const pbf_output_options& options) {
+                static thread_local PrimitiveBlock primitive_block{options};
+                primitive_block.set_options(options);
+                primitive_block.reset(OSMFormat::PrimitiveGroup::unknown);
+                return primitive_block;
+            }
+
+            /**
+             * Encodes a range of objects from a buffer into complete PBF
+             * blobs. This is used when the primitive blocks are built in
+             * the thread pool. The result contains one or more blobs in
+             * the order of the objects in the buffer.
+             */
+            class EncodeBlobs {
+
+                std::shared_ptr<const osmium::memory::Buffer> m_buffer;
+
+                std::size_t m_begin;
+
+                std::size_t m_end;
+
+                pbf_output_options m_options;
+
+                std::shared_ptr<pbf_compression_statistics> m_statistics;
+
+                std::vector<PBFBlobIndex::entry> m_entries;
+
+            public:
+
+                EncodeBlobs(std::shared_ptr<const osmium::memory::Buffer> buffer, std::size_t begin, std::size_t end, const pbf_output_options& options, std::shared_ptr<pbf_compression_statistics> statistics) :
+                    m_buffer(std::move(buffer)),
+                    m_begin(begin),
+                    m_end(end),
+                    m_options(options),
+                    m_statistics(std::move(statistics)) {
+                }
+
+                std::string operator()() {
+                    std::string output;
+
+                    PBFBlockEncoder encoder{m_options, thread_primitive_block(m_options), [&](std::string&& data, const PBFBlobIndex::entry& entry) {
+                        const auto offset = output.size();
+                        output.append(SerializeBlob{std::move(data),
+                                                    pbf_blob_type::data,
+                                                    m_options.compression,
+                                                    m_options.compression_level,
+                                                    m_statistics}());
+                        m_entries.push_back(entry);
+                        m_entries.back().offset = offset;
+                        m_entries.back().size = output.size() - offset;
+                    }, m_statistics};
+
+                    osmium::apply(m_buffer->get_iterator(m_begin), m_buffer->get_iterator(m_end), encoder);
+                    encoder.finish_block();
+
+                    return output;
+                }
+
+                /**
+                 * The blob index entries for the blobs created. The offsets
+                 * are relative to the start of the output.
+                 */
+                std::vector<PBFBlobIndex::entry>& entries() noexcept {
+                    return m_entries;
+                }
+
+            }; // class EncodeBlobs
+
+            /**
+             * The size of the output of a task writing blobs and the blob
+             * index entries for those blobs. The offsets in the entries are
+             * relative to the start of the output.
+             */
+            struct pbf_blob_index_part {
+                std::size_t size = 0;
+                std::vector<PBFBlobIndex::entry> entries;
+            };
+
+            // A SerializeBlob task creates exactly one blob, the entry
+            // for it is given when the task is submitted.
+            inline void add_task_entries(SerializeBlob& /*task*/, pbf_blob_index_part& part) noexcept {
+                for (auto& entry : part.entries) {
+                    entry.size = part.size;
+                }
+            }
+
+            inline void add_task_entries(EncodeBlobs& task, pbf_blob_index_part& part) {
+                part.entries.insert(part.entries.end(), task.entries().begin(), task.entries().end());
+            }
+
+            /**
+             * Wraps a task writing blobs and reports the size and blob
+             * index entries of its output through a promise. Used for
+             * building the blob index while writing.
+             */
+            template <typename TTask>
+            class ReportBlobIndexPart {
+
+                TTask m_task;
+
+                pbf_blob_index_part m_part;
+
+                std::shared_ptr<std::promise<pbf_blob_index_part>> m_promise;
+
+            public:
+
+                ReportBlobIndexPart(TTask&& task, std::vector<PBFBlobIndex::entry>&& entries, std::shared_ptr<std::promise<pbf_blob_index_part>> promise) :
+                    m_task(std::move(task)),
+                    m_promise(std::move(promise)) {
+                    m_part.entries = std::move(entries);
+                }
+
+                std::string operator()() {
+                    try {
+                        std::string output{m_task()};
+                        m_part.size = output.size();
+                        add_task_entries(m_task, m_part);
+                        m_promise->set_value(std::move(m_part));
+                        return output;
+                    } catch (...) {
+                        m_promise->set_exception(std::current_exception());
+                        throw;
+                    }
+                }
+
+            }; // class ReportBlobIndexPart
+
+            class PBFOutputFormat : public osmium::io::detail::OutputFormat {
+
+                pbf_output_options m_options;
+
+                std::shared_ptr<pbf_compression_statistics> m_statistics{std::make_shared<pbf_compression_statistics>()};
+
+                PrimitiveBlock m_primitive_block;
+
+                PBFBlockEncoder m_encoder;
+
+                // Name of the blob index sidecar file written at the end
+                // (if not empty) and the parts needed to build it.
+                std::string m_index_filename;
+                std::vector<std::future<pbf_blob_index_part>> m_index_parts;
+
+                // Used to check the order of the objects if the
+                // "pbf_check_order" option is set.
+                osmium::handler::CheckOrder m_check_order;
+                bool m_check_order_enabled = false;
+
+                // Set if the "pbf_spatial_sort" option is used. The objects
+                // in each buffer are then reordered along this curve.
+                bool m_spatial_sort_enabled = false;
+                osmium::geom::space_filling_curve m_spatial_sort_curve = osmium::geom::space_filling_curve::hilbert;
+
+                template <typename TTask>
+                void submit(TTask&& task, std::vector<PBFBlobIndex::entry>&& entries = {}) {
+                    if (m_index_filename.empty()) {
+                        m_output_queue.push(m_pool.submit(std::forward<TTask>(task), osmium::thread::task_priority::high));
+                        return;
+                    }
+
+                    auto promise = std::make_shared<std::promise<pbf_blob_index_part>>();
+                    m_index_parts.push_back(promise->get_future());
+                    m_output_queue.push(m_pool.submit(ReportBlobIndexPart<TTask>{std::forward<TTask>(task), std::move(entries), std::move(promise)}, osmium::thread::task_priority::high));
+                }
+
+                void submit_blobs(const std::shared_ptr<const osmium::memory::Buffer>& buffer, std::size_t begin, std::size_t end) {
+                    submit(EncodeBlobs{buffer, begin, end, m_options, m_statistics});
+                }
+
+                void write_index() {
+                    PBFBlobIndex index;
+
+                    std::size_t offset = 0;
+                    for (auto& future_part : m_index_parts) {
+                        auto part = future_part.get();
+                        for (auto& entry : part.entries) {
+                            entry.offset += offset;
+                            index.add(entry);
+                        }
+                        offset += part.size;
+                    }
+                    m_index_parts.clear();
+
+                    index.write(m_index_filename, osmium::io::overwrite::allow);
+                }
+
+                /**
+                 * Split the buffer into ranges of objects of the same type
+                 * which fit into one primitive block each and encode those
+                 * ranges in the thread pool. Blocks never span buffers in
+                 * this mode.
+                 */
+                void write_buffer_in_pool(osmium::memory::Buffer&& buffer) {
+                    const auto shared_buffer = std::make_shared<const osmium::memory::Buffer>(std::move(buffer));
+
+                    if (m_check_order_enabled) {
+                        m_check_order.check_buffer(*shared_buffer);
+                    }
+
+                    std::size_t begin = 0;
+                    std::size_t bytes = 0;
+                    int count = 0;
+                    osmium::item_type type = osmium::item_type::undefined;
+
+                    for (auto it = shared_buffer->cbegin(); it != shared_buffer->cend(); ++it) {
+                        if (count > 0 && (it->type() != type ||
+                                          count >= m_options.max_block_entities ||
+                                          bytes >= PrimitiveBlock::max_used_blob_size)) {
+                            const auto offset = static_cast<std::size_t>(it.data() - shared_buffer->data());
+                            submit_blobs(shared_buffer, begin, offset);
+                            begin = offset;
+                            bytes = 0;
+                            count = 0;
+                        }
+                        type = it->type();
+                        bytes += it->byte_size();
+                        ++count;
+                    }
+
+                    if (count > 0) {
+                        submit_blobs(shared_buffer, begin, shared_buffer->committed());
+                    }
+                }
+
+            public:
+
+                PBFOutputFormat(osmium::thread::Pool& pool, const osmium::io::File& file, future_string_queue_type& output_queue) :
+                    OutputFormat(pool, output_queue),
+                    m_primitive_block(m_options),
+                    m_encoder(m_options, m_primitive_block, [this](std::string&& data, const PBFBlobIndex::entry& entry) {
+                        submit(SerializeBlob{std::move(data),
+                                             pbf_blob_type::data,
+                                             m_options.compression,
+                                             m_options.compression_level,
+                                             m_statistics},
+                               std::vector<PBFBlobIndex::entry>{entry});
+                    }, m_statistics) {
+
+                    if (!file.get("pbf_add_metadata").empty()) {
+                        throw std::invalid_argument{"The 'pbf_add_metadata' option is deprecated. Please use 'add_metadata' instead."};
+                    }
+
+                    m_options.use_dense_nodes = file.is_not_false("pbf_dense_nodes");
+                    m_options.compression = get_pbf_compression(file.get("pbf_compression"));
+                    m_options.compression_level = get_pbf_compression_level(file.get("pbf_compression_level"), m_options.compression);
+                    m_options.add_metadata = osmium::metadata_options{file.get("add_metadata")};
+                    m_options.add_historical_information_flag = file.has_multiple_object_versions();
+                    m_options.add_visible_flag = file.has_multiple_object_versions();
+                    m_options.locations_on_ways = file.is_true("locations_on_ways");
+                    m_options.sort_stringtable = file.is_true("pbf_sort_stringtable");
+                    m_options.build_blocks_in_pool = file.is_true("pbf_parallel_blocks");
+                    m_options.max_block_entities = static_cast<int>(get_pbf_size_option(file, "pbf_max_block_entities", m_options.max_block_entities, 1, max_entities_per_block));
+                    m_options.max_block_size = get_pbf_size_option(file, "pbf_max_block_size", m_options.max_block_size, 1024, PrimitiveBlock::max_used_blob_size);
+                    m_options.max_compressed_block_size = get_pbf_size_option(file, "pbf_max_compressed_block_size", 0, 0, PrimitiveBlock::max_used_blob_size);
+                    m_options.max_block_extent = get_pbf_extent_option(file, "pbf_max_block_extent");
+                    m_index_filename = file.get("pbf_index_sidecar");
+                    m_check_order_enabled = file.is_true("pbf_check_order");
+
+                    if (m_check_order_enabled && file.has_multiple_object_versions()) {
+                        throw std::invalid_argument{"The 'pbf_check_order' option can not be used for history files."};
+                    }
+
+                    const std::string spatial_sort{file.get("pbf_spatial_sort")};
+                    if (!spatial_sort.empty() && spatial_sort != "false") {
+                        if (m_check_order_enabled) {
+                            throw std::invalid_argument{"The 'pbf_spatial_sort' option can not be used together with 'pbf_check_order'."};
+                        }
+                        if (file.has_multiple_object_versions()) {
+                            throw std::invalid_argument{"The 'pbf_spatial_sort' option can not be used for history files."};
+                        }
+                        m_spatial_sort_enabled = true;
+                        if (spatial_sort != "true") {
+                            m_spatial_sort_curve = osmium::geom::space_filling_curve_from_name(spatial_sort);
+                        }
+                    }
+                }
+
+                void write_header(const osmium::io::Header& header) final {
+                    std::string data;
+                    protozero::pbf_builder<OSMFormat::HeaderBlock> pbf_header_block{data};
+
+                    if (!header.boxes().empty()) {
+                        protozero::pbf_builder<OSMFormat::HeaderBBox> pbf_header_bbox{pbf_header_block, OSMFormat::HeaderBlock::optional_HeaderBBox_bbox};
+
+                        osmium::Box box = header.joined_boxes();
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_left,   int64_t(box.bottom_left().lon() * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_right,  int64_t(box.top_right().lon()   * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_top,    int64_t(box.top_right().lat()   * lonlat_resolution));
+                        pbf_header_bbox.add_sint64(OSMFormat::HeaderBBox::required_sint64_bottom, int64_t(box.bottom_left().lat() * lonlat_resolution));
+                    }
+
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "OsmSchema-V0.6");
+
+                    if (m_options.use_dense_nodes) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "DenseNodes");
+                    }
+
+                    if (m_options.add_historical_information_flag) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_required_features, "HistoricalInformation");
+                    }
+
+                    if (m_options.locations_on_ways) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "LocationsOnWays");
+                    }
+
+                    // If the order is checked, writing fails if the objects
+                    // are not sorted, so the feature can always be set.
+                    if (m_spatial_sort_enabled) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features,
+                                                    m_spatial_sort_curve == osmium::geom::space_filling_curve::hilbert ? "Sort.Spatial_Hilbert" : "Sort.Spatial_Morton");
+                    } else if (m_check_order_enabled || header.get("sorting") == "Type_then_ID") {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::repeated_string_optional_features, "Sort.Type_then_ID");
+                    }
+
+                    pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_writingprogram, header.get("generator"));
+
+                    const std::string osmosis_replication_timestamp{header.get("osmosis_replication_timestamp")};
+                    if (!osmosis_replication_timestamp.empty()) {
+                        osmium::Timestamp ts{osmosis_replication_timestamp.c_str()};
+                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_timestamp, uint32_t(ts));
+                    }
+
+                    const std::string osmosis_replication_sequence_number{header.get("osmosis_replication_sequence_number")};
+                    if (!osmosis_replication_sequence_number.empty()) {
+                        pbf_header_block.add_int64(OSMFormat::HeaderBlock::optional_int64_osmosis_replication_sequence_number, osmium::detail::str_to_int<int64_t>(osmosis_replication_sequence_number.c_str()));
+                    }
+
+                    const std::string osmosis_replication_base_url{header.get("osmosis_replication_base_url")};
+                    if (!osmosis_replication_base_url.empty()) {
+                        pbf_header_block.add_string(OSMFormat::HeaderBlock::optional_string_osmosis_replication_base_url, osmosis_replication_base_url);
+                    }
+
+                    submit(SerializeBlob{std::move(data),
+                                         pbf_blob_type::header,
+                                         m_options.compression,
+                                         m_options.compression_level});
+                }
+
+                void write_buffer(osmium::memory::Buffer&& buffer) final {
+                    if (m_spatial_sort_enabled) {
+                        osmium::geom::spatial_sort(buffer, m_spatial_sort_curve);
+                    }
+                    if (m_options.build_blocks_in_pool) {
+                        write_buffer_in_pool(std::move(buffer));
+                        return;
+                    }
+                    if (m_check_order_enabled) {
+                        m_check_order.check_buffer(buffer);
+                    }
+                    osmium::apply(buffer.cbegin(), buffer.cend(), m_encoder);
+                }
+
+                void write_selection(osmium::memory::BufferSelection&& selection) final {
+                    // Sorting and building blocks in the pool need a
+                    // buffer of their own.
+                    if (m_spatial_sort_enabled || m_options.build_blocks_in_pool) {
+                        write_buffer(selection.copy());
+                        return;
+                    }
+                    if (m_check_order_enabled) {
+                        osmium::apply(selection.cbegin(), selection.cend(), m_check_order, m_encoder);
+                    } else {
+                        osmium::apply(selection.cbegin(), selection.cend(), m_encoder);
+                    }
+                }
+
+                bool write_raw(std::string&& data, osmium::io::file_format format) final {
+                    // Blobs copied as they are can not be checked, sorted,
+                    // added to the blob index, or get node locations from
+                    // the lookup.
+                    if (format != osmium::io::file_format::pbf || m_check_order_enabled || m_spatial_sort_enabled || !m_index_filename.empty() || m_options.way_node_locations) {
+                        return false;
+                    }
+                    m_encoder.finish_block();
+                    send_to_output_queue(std::move(data));
+                    return true;
+                }
+
+                bool set_way_node_locations(const osmium::io::way_node_locations& lookup) final {
+                    m_options.way_node_locations = lookup;
+                    m_options.locations_on_ways = true;
+                    return true;
+                }
+
+                void write_end() final {
+                    m_encoder.finish_block();
+                    if (!m_index_filename.empty()) {
+                        write_index();
+                    }
+                }
+
             }; // class PBFOutputFormat
 
             // we want the register_output_format() function to run, setting
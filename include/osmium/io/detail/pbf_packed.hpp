@@ -0,0 +1,157 @@
+#ifndef OSMIUM_IO_DETAIL_PBF_PACKED_HPP
+#define OSMIUM_IO_DETAIL_PBF_PACKED_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/delta.hpp>
+
+#include <protozero/exception.hpp>
+#include <protozero/varint.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Decode a varint. There must be at least 10 bytes (the maximum
+             * length of a varint) available at data, so no bounds checks
+             * are needed.
+             *
+             * @throws protozero::varint_too_long_exception If the varint is
+             *         longer than 10 bytes.
+             */
+            inline uint64_t decode_varint_unchecked(const char*& data) {
+                const auto* d = reinterpret_cast<const uint8_t*>(data);
+                uint64_t value = 0;
+                for (unsigned int i = 0; i < 10; ++i) {
+                    const uint64_t byte = d[i];
+                    value |= (byte & 0x7fu) << (7u * i);
+                    if (byte < 0x80u) {
+                        data += i + 1;
+                        return value;
+                    }
+                }
+                throw protozero::varint_too_long_exception{};
+            }
+
+            /**
+             * Decode all varints in a packed repeated field into the output
+             * vector, converting each with the convert function. This is
+             * much faster than going through the protozero iterators one
+             * value at a time: Eight bytes at a time are checked for
+             * continuation bits so that runs of one-byte varints (which are
+             * common for delta encoded IDs and for member types and roles)
+             * are decoded in one go, and bounds checks are only needed for
+             * the last few bytes.
+             *
+             * @param data Pointer to the contents of the packed field.
+             * @param size Size of the contents of the packed field.
+             * @param output Decoded values. This is cleared first.
+             * @param convert Function converting the raw uint64_t varint
+             *                value into TValue.
+             * @throws protozero::end_of_buffer_exception If the data ends
+             *         inside a varint.
+             * @throws protozero::varint_too_long_exception If there is an
+             *         invalid varint.
+             */
+            template <typename TValue, typename TConvert>
+            inline void decode_packed_varints(const char* data, std::size_t size, std::vector<TValue>& output, TConvert&& convert) {
+                // There can't be more values than bytes.
+                output.resize(size);
+                TValue* out = output.data();
+
+                const char* end = data + size;
+                while (end - data >= 10) {
+                    uint64_t word;
+                    std::memcpy(&word, data, sizeof(word));
+                    if ((word & 0x8080808080808080ull) == 0) {
+                        for (unsigned int i = 0; i < 8; ++i) {
+                            *out++ = convert(static_cast<uint8_t>(data[i]));
+                        }
+                        data += 8;
+                    } else {
+                        *out++ = convert(decode_varint_unchecked(data));
+                    }
+                }
+
+                while (data != end) {
+                    *out++ = convert(protozero::decode_varint(&data, end));
+                }
+
+                output.resize(static_cast<std::size_t>(out - output.data()));
+            }
+
+            /**
+             * Decode all values in a packed repeated sint64 field into the
+             * output vector. See decode_packed_varints() for details.
+             */
+            inline void decode_packed_sint64(const char* data, std::size_t size, std::vector<int64_t>& output) {
+                decode_packed_varints(data, size, output, [](uint64_t value) noexcept {
+                    return protozero::decode_zigzag64(value);
+                });
+            }
+
+            /**
+             * Decode all values in a packed repeated int32 (or enum) field
+             * into the output vector. See decode_packed_varints() for
+             * details.
+             */
+            inline void decode_packed_int32(const char* data, std::size_t size, std::vector<int32_t>& output) {
+                decode_packed_varints(data, size, output, [](uint64_t value) noexcept {
+                    return static_cast<int32_t>(value);
+                });
+            }
+
+            /**
+             * Undo delta encoding in place, ie replace each value with the
+             * sum of itself and all values before it.
+             */
+            inline void delta_decode_in_place(std::vector<int64_t>& values) noexcept {
+                osmium::DeltaDecode<int64_t> delta;
+                delta.decode_span(values.data(), values.data() + values.size(), values.data());
+            }
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETAIL_PBF_PACKED_HPP
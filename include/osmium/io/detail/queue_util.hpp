@@ -34,9 +34,10 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/memory/buffer.hpp>
-#include <osmium/thread/queue.hpp>
+#include <osmium/thread/spsc_queue.hpp>
 
 #include <cassert>
+#include <chrono>
 #include <exception>
 #include <future>
 #include <string>
@@ -48,8 +49,14 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * The queues between the read thread, the parser, the reader,
+             * the writer and the write thread each have exactly one thread
+             * pushing to them and one thread popping from them, so they
+             * can use the lock-free single-producer single-consumer queue.
+             */
             template <typename T>
-            using future_queue_type = osmium::thread::Queue<std::future<T>>;
+            using future_queue_type = osmium::thread::SPSCQueue<std::future<T>>;
 
             /**
              * This type of queue contains buffers with OSM data in them.
@@ -101,6 +108,7 @@ namespace osmium {
             class queue_wrapper {
 
                 future_queue_type<T>& m_queue;
+                std::future<T> m_next{};
                 bool m_has_reached_end_of_data;
 
             public:
@@ -137,8 +145,10 @@ namespace osmium {
                 T pop() {
                     T data;
                     if (!m_has_reached_end_of_data) {
-                        std::future<T> data_future;
-                        m_queue.wait_and_pop(data_future);
+                        std::future<T> data_future{std::move(m_next)};
+                        if (!data_future.valid()) {
+                            m_queue.wait_and_pop(data_future);
+                        }
                         assert(data_future.valid());
                         data = std::move(data_future.get());
                         if (at_end_of_data(data)) {
@@ -148,6 +158,28 @@ namespace osmium {
                     return data;
                 }
 
+                /**
+                 * Get the next data from the queue if it is available
+                 * without waiting.
+                 *
+                 * @param data Set to the data if there was any.
+                 * @returns false if the queue is empty or the next data
+                 *          is not ready yet, true otherwise.
+                 */
+                bool try_pop(T& data) {
+                    if (m_has_reached_end_of_data) {
+                        return false;
+                    }
+                    if (!m_next.valid() && (m_queue.empty() || !m_queue.try_pop(m_next))) {
+                        return false;
+                    }
+                    if (m_next.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+                        return false;
+                    }
+                    data = pop();
+                    return true;
+                }
+
             }; // class queue_wrapper
 
         } // namespace detail
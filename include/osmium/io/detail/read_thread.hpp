@@ -35,10 +35,14 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <atomic>
 #include <exception>
+#include <memory>
 #include <string>
 #include <thread>
 #include <utility>
@@ -49,11 +53,97 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Read the next chunk of data from the decompressor and record
+             * the time needed and the number of bytes in the stats (if
+             * that isn't a nullptr).
+             */
+            inline std::string read_chunk(osmium::io::Decompressor& decompressor, PipelineStats* stats) {
+                std::string data;
+                {
+                    const stats_timer timer{stats, &PipelineStats::read};
+                    const osmium::trace::Span span{"read"};
+                    data = decompressor.read();
+                }
+                if (stats) {
+                    stats->bytes_read += data.size();
+                }
+                return data;
+            }
+
+            /**
+             * Reads data from the input file in steps on an IOExecutor.
+             * Does the same as ReadThreadManager::run_in_thread(), but never
+             * blocks on the queue.
+             */
+            class ReadStage : public io_stage {
+
+                osmium::io::Decompressor& m_decompressor;
+                future_string_queue_type& m_queue;
+                const std::atomic<bool>& m_done;
+                PipelineStats* m_stats;
+                std::exception_ptr m_exception{};
+                bool m_finishing = false;
+
+                bool queue_full() const {
+                    return m_queue.max_size() && m_queue.size() >= m_queue.max_size();
+                }
+
+            public:
+
+                ReadStage(osmium::io::Decompressor& decompressor,
+                          future_string_queue_type& queue,
+                          const std::atomic<bool>& done,
+                          PipelineStats* stats = nullptr) :
+                    m_decompressor(decompressor),
+                    m_queue(queue),
+                    m_done(done),
+                    m_stats(stats) {
+                }
+
+                io_stage_result step() override {
+                    // There is only one producer for the queue, so if it
+                    // isn't full now, the push will not block.
+                    if (queue_full()) {
+                        return io_stage_result::idle;
+                    }
+
+                    if (!m_finishing) {
+                        try {
+                            if (!m_done) {
+                                std::string data{read_chunk(m_decompressor, m_stats)};
+                                if (!at_end_of_data(data)) {
+                                    add_to_queue(m_queue, std::move(data));
+                                    return io_stage_result::progress;
+                                }
+                            }
+                            m_finishing = true;
+                            m_decompressor.close();
+                        } catch (...) {
+                            m_finishing = true;
+                            m_exception = std::current_exception();
+                        }
+                        return io_stage_result::progress;
+                    }
+
+                    if (m_exception) {
+                        add_to_queue(m_queue, std::move(m_exception));
+                        m_exception = nullptr;
+                        return io_stage_result::progress;
+                    }
+
+                    add_end_of_data_to_queue(m_queue);
+                    return io_stage_result::done;
+                }
+
+            }; // class ReadStage
+
             /**
              * This code uses an internally managed thread to read data from
              * the input file and (optionally) decompress it. The result is
              * sent to the given queue. Any exceptions will also be send to
-             * the queue.
+             * the queue. If an IOExecutor is given, a ReadStage on that
+             * executor is used instead of the thread.
              */
             class ReadThreadManager {
 
@@ -63,19 +153,25 @@ namespace osmium {
 
                 // used in both threads
                 std::atomic<bool> m_done;
+                PipelineStats* m_stats;
 
                 // only used in the main thread
-                std::thread m_thread;
+                std::thread m_thread{};
+
+                // only used with an IOExecutor
+                io_stage_handle m_stage{};
 
                 void run_in_thread() {
                     osmium::thread::set_thread_name("_osmium_read");
 
                     try {
                         while (!m_done) {
-                            std::string data{m_decompressor.read()};
+                            std::string data{read_chunk(m_decompressor, m_stats)};
                             if (at_end_of_data(data)) {
                                 break;
                             }
+                            const stats_timer timer{m_stats, &PipelineStats::input_queue_wait};
+                            const osmium::trace::Span span{"input_queue_wait"};
                             add_to_queue(m_queue, std::move(data));
                         }
 
@@ -90,13 +186,26 @@ namespace osmium {
             public:
 
                 ReadThreadManager(osmium::io::Decompressor& decompressor,
-                                  future_string_queue_type& queue) :
+                                  future_string_queue_type& queue,
+                                  PipelineStats* stats = nullptr) :
                     m_decompressor(decompressor),
                     m_queue(queue),
                     m_done(false),
+                    m_stats(stats),
                     m_thread(std::thread(&ReadThreadManager::run_in_thread, this)) {
                 }
 
+                ReadThreadManager(osmium::io::Decompressor& decompressor,
+                                  future_string_queue_type& queue,
+                                  osmium::io::IOExecutor& executor,
+                                  PipelineStats* stats = nullptr) :
+                    m_decompressor(decompressor),
+                    m_queue(queue),
+                    m_done(false),
+                    m_stats(stats) {
+                    m_stage = executor.add(std::unique_ptr<io_stage>{new ReadStage{m_decompressor, m_queue, m_done, m_stats}});
+                }
+
                 ReadThreadManager(const ReadThreadManager&) = delete;
                 ReadThreadManager& operator=(const ReadThreadManager&) = delete;
 
@@ -120,6 +229,7 @@ namespace osmium {
                     if (m_thread.joinable()) {
                         m_thread.join();
                     }
+                    m_stage.wait();
                 }
 
             }; // class ReadThreadManager
@@ -34,13 +34,22 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/io/writer_options.hpp>
+#include <osmium/util/config.hpp>
 #include <osmium/util/file.hpp>
 
+#include <algorithm>
 #include <cerrno>
+#include <climits>
 #include <cstddef>
 #include <fcntl.h>
 #include <string>
 #include <system_error>
+#include <vector>
+
+#ifndef _WIN32
+# include <sys/stat.h>
+# include <sys/uio.h>
+#endif
 
 namespace osmium {
 
@@ -168,6 +177,67 @@ namespace osmium {
                 reliable_write(fd, reinterpret_cast<const unsigned char*>(output_buffer), size);
             }
 
+            /**
+             * Writes all the given strings to the file descriptor in order.
+             * On systems that support it, this gathers many strings into
+             * one writev(2) call, otherwise the strings are written one
+             * at a time.
+             *
+             * @param fd File descriptor.
+             * @param data Strings with the data to be written.
+             * @throws std::system_error On error.
+             */
+            inline void reliable_writev(const int fd, const std::vector<std::string>& data) {
+#ifdef _WIN32
+                for (const auto& str : data) {
+                    reliable_write(fd, str.data(), str.size());
+                }
+#else
+                enum : std::size_t {
+# ifdef IOV_MAX
+                    max_iov = IOV_MAX < 1024 ? IOV_MAX : 1024
+# else
+                    max_iov = 16
+# endif
+                };
+                std::vector<::iovec> iov;
+                iov.reserve(std::min(data.size(), static_cast<std::size_t>(max_iov)));
+
+                auto it = data.begin();
+                while (it != data.end()) {
+                    iov.clear();
+                    for (; it != data.end() && iov.size() < max_iov; ++it) {
+                        if (!it->empty()) {
+                            iov.push_back(::iovec{const_cast<char*>(it->data()), it->size()});
+                        }
+                    }
+
+                    auto* next = iov.data();
+                    auto* const end = iov.data() + iov.size();
+                    while (next != end) {
+                        const auto length = ::writev(fd, next, static_cast<int>(end - next));
+                        if (length < 0) {
+                            if (errno == EINTR) {
+                                continue;
+                            }
+                            throw std::system_error{errno, std::system_category(), "Write failed"};
+                        }
+                        // Skip the parts that were written completely and
+                        // adjust the first part that was written partially.
+                        auto written = static_cast<std::size_t>(length);
+                        while (next != end && written >= next->iov_len) {
+                            written -= next->iov_len;
+                            ++next;
+                        }
+                        if (next != end) {
+                            next->iov_base = static_cast<char*>(next->iov_base) + written;
+                            next->iov_len -= written;
+                        }
+                    }
+                }
+#endif
+            }
+
             /**
              * Reads a maximum of size bytes from the file descriptor into the
              * input_buffer. This is just a wrapper around read(2) catching
@@ -200,6 +270,39 @@ namespace osmium {
                 return nread;
             }
 
+            /**
+             * Reads a maximum of size bytes starting at the specified offset
+             * from the file descriptor into the input_buffer without changing
+             * the file offset. This is a wrapper around pread(2) catching
+             * errors. On Windows the file offset is changed.
+             *
+             * @param fd File descriptor. Must be a regular file.
+             * @param input_buffer Buffer for data to be read. Must be at least size bytes long.
+             * @param size Maximum number of bytes to read.
+             * @param offset Offset in the file to read from.
+             * @returns the number of bytes read
+             * @throws std::system_error On error.
+             */
+            inline int64_t reliable_pread(const int fd, char* input_buffer, const unsigned int size, const int64_t offset) {
+#ifdef _WIN32
+                if (_lseeki64(fd, offset, SEEK_SET) < 0) {
+                    throw std::system_error{errno, std::system_category(), "Seek failed"};
+                }
+                return reliable_read(fd, input_buffer, size);
+#else
+                int64_t nread = 0;
+
+                do {
+                    nread = ::pread(fd, input_buffer, size, static_cast<off_t>(offset));
+                    if (nread < 0 && errno != EINTR) {
+                        throw std::system_error{errno, std::system_category(), "Read failed"};
+                    }
+                } while (nread < 0);
+
+                return nread;
+#endif
+            }
+
             inline void reliable_fsync(const int fd) {
 #ifdef _MSC_VER
                 osmium::detail::disable_invalid_parameter_handler diph;
@@ -247,6 +350,113 @@ namespace osmium {
                 return fd2;
             }
 
+            /**
+             * Gives the kernel hints about how an input file is read so
+             * that streaming through a huge file works well together with
+             * other data in the page cache: The file is marked as read
+             * sequentially, the next readahead bytes can be requested in
+             * advance, and data already read can be dropped from the page
+             * cache. This only works for regular files on systems with
+             * posix_fadvise(2), otherwise it does nothing.
+             */
+            class read_advisor {
+
+                enum : std::size_t {
+                    drop_chunk_size = 16ul * 1024ul * 1024ul
+                };
+
+                int m_fd = -1;
+                std::size_t m_readahead = 0;
+                std::size_t m_readahead_until = 0;
+                std::size_t m_dropped_until = 0;
+                bool m_drop_behind = false;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+                void advise(const std::size_t offset, const std::size_t len, const int advice) const noexcept {
+                    // Errors are ignored, these are only hints.
+                    ::posix_fadvise(m_fd, static_cast<off_t>(offset), static_cast<off_t>(len), advice);
+                }
+#endif
+
+            public:
+
+                read_advisor() = default;
+
+                /**
+                 * @param fd File descriptor of the input file.
+                 * @param readahead Number of bytes the kernel should read
+                 *                  ahead of the current position. If this
+                 *                  is 0, the kernel default is used.
+                 * @param drop_behind Drop data already read from the page
+                 *                    cache?
+                 */
+                read_advisor(const int fd, const std::size_t readahead, const bool drop_behind) noexcept :
+                    m_readahead(readahead),
+                    m_drop_behind(drop_behind) {
+#ifdef POSIX_FADV_SEQUENTIAL
+                    struct stat st; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
+                    if (fd < 0 || ::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { // NOLINT(hicpp-signed-bitwise)
+                        return;
+                    }
+                    m_fd = fd;
+                    advise(0, 0, POSIX_FADV_SEQUENTIAL);
+                    if (m_drop_behind) {
+                        advise(0, 0, POSIX_FADV_NOREUSE);
+                    }
+                    update(0);
+#else
+                    (void)fd;
+#endif
+                }
+
+                /// Use the settings from the environment (see osmium::config).
+                explicit read_advisor(const int fd) noexcept :
+                    read_advisor(fd, osmium::config::get_readahead_size(), osmium::config::drop_read_cache()) {
+                }
+
+                /// Is this advisor active (on a regular file)?
+                bool active() const noexcept {
+                    return m_fd >= 0;
+                }
+
+                /**
+                 * Tell the advisor that the file has been read up to this
+                 * offset.
+                 */
+                void update(const std::size_t offset) noexcept {
+                    if (m_fd < 0) {
+                        return;
+                    }
+#ifdef POSIX_FADV_SEQUENTIAL
+                    // Request the next readahead window when half of the
+                    // previous one has been used up.
+                    if (m_readahead > 0 && offset + m_readahead / 2 >= m_readahead_until) {
+                        const std::size_t start = std::max(offset, m_readahead_until);
+                        m_readahead_until = offset + m_readahead;
+                        advise(start, m_readahead_until - start, POSIX_FADV_WILLNEED);
+                    }
+                    if (m_drop_behind && offset >= m_dropped_until + drop_chunk_size) {
+                        advise(m_dropped_until, offset - m_dropped_until, POSIX_FADV_DONTNEED);
+                        m_dropped_until = offset;
+                    }
+#endif
+                }
+
+                /// Drop everything still in the cache if drop_behind is set.
+                void finish() noexcept {
+                    if (m_fd < 0) {
+                        return;
+                    }
+#ifdef POSIX_FADV_SEQUENTIAL
+                    if (m_drop_behind) {
+                        advise(0, 0, POSIX_FADV_DONTNEED);
+                    }
+#endif
+                    m_fd = -1;
+                }
+
+            }; // class read_advisor
+
         } // namespace detail
 
     } // namespace io
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/detail/pbf.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -42,8 +43,8 @@ DEALINGS IN THE SOFTWARE.
 #include <iterator>
 #include <list>
 #include <string>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -60,7 +61,8 @@ namespace osmium {
              * than the chunk size.
              *
              * All memory is released when the destructor is called. There is no other way
-             * to release all or part of the memory.
+             * to release all or part of the memory. When the store is cleared, the
+             * chunks are kept around and re-used later.
              *
              */
             class StringStore {
@@ -69,7 +71,15 @@ namespace osmium {
 
                 std::list<std::string> m_chunks;
 
+                // Chunks no longer in use after a clear(). They still have
+                // their memory allocated.
+                std::list<std::string> m_spare_chunks;
+
                 void add_chunk() {
+                    if (!m_spare_chunks.empty()) {
+                        m_chunks.splice(m_chunks.end(), m_spare_chunks, m_spare_chunks.begin());
+                        return;
+                    }
                     m_chunks.emplace_back();
                     m_chunks.back().reserve(m_chunk_size);
                 }
@@ -83,8 +93,10 @@ namespace osmium {
 
                 void clear() noexcept {
                     assert(!m_chunks.empty());
-                    m_chunks.erase(std::next(m_chunks.begin()), m_chunks.end());
-                    m_chunks.front().clear();
+                    for (auto& chunk : m_chunks) {
+                        chunk.clear();
+                    }
+                    m_spare_chunks.splice(m_spare_chunks.end(), m_chunks, std::next(m_chunks.begin()), m_chunks.end());
                 }
 
                 /**
@@ -199,15 +211,19 @@ namespace osmium {
                     return m_chunks.back().size();
                 }
 
-            }; // class StringStore
-
-            struct str_equal {
-
-                bool operator()(const char* lhs, const char* rhs) const noexcept {
-                    return lhs == rhs || std::strcmp(lhs, rhs) == 0;
+                /// Memory allocated for all chunks, including spare ones.
+                size_t used_memory() const noexcept {
+                    size_t size = 0;
+                    for (const auto& chunk : m_chunks) {
+                        size += chunk.capacity();
+                    }
+                    for (const auto& chunk : m_spare_chunks) {
+                        size += chunk.capacity();
+                    }
+                    return size;
                 }
 
-            }; // struct str_equal
+            }; // class StringStore
 
             struct djb2_hash {
 
@@ -246,44 +262,149 @@ namespace osmium {
                     default_stringtable_chunk_size = 100u * 1024u
                 };
 
+                // Initial number of slots in the index, must be a power
+                // of two.
+                enum {
+                    initial_index_size = 1024u
+                };
+
+                // The index from strings to their ids is an open addressing
+                // hash table with linear probing. It is not cleared when the
+                // string table is cleared, instead the generation is
+                // incremented. All slots from earlier generations count as
+                // empty. So no memory is allocated or freed for the index
+                // once it is large enough.
+                struct index_slot {
+                    const char* string = nullptr;
+                    std::size_t hash = 0;
+                    uint32_t generation = 0;
+                    int32_t id = 0;
+                };
+
                 StringStore m_strings;
-                std::unordered_map<const char*, int32_t, djb2_hash, str_equal> m_index;
+                std::vector<index_slot> m_index;
+                uint32_t m_generation = 1;
                 int32_t m_size = 0;
 
+                // How often each string was added, indexed by id.
+                std::vector<uint32_t> m_counts;
+
+                index_slot& find_slot(const char* s, std::size_t hash) {
+                    const std::size_t mask = m_index.size() - 1;
+                    for (std::size_t pos = hash & mask; ; pos = (pos + 1) & mask) {
+                        auto& slot = m_index[pos];
+                        if (slot.generation != m_generation ||
+                            (slot.hash == hash && std::strcmp(slot.string, s) == 0)) {
+                            return slot;
+                        }
+                    }
+                }
+
+                void grow_index() {
+                    std::vector<index_slot> old_index(m_index.size() * 2);
+                    m_index.swap(old_index);
+
+                    const std::size_t mask = m_index.size() - 1;
+                    for (const auto& old_slot : old_index) {
+                        if (old_slot.generation != m_generation) {
+                            continue;
+                        }
+                        std::size_t pos = old_slot.hash & mask;
+                        while (m_index[pos].generation == m_generation) {
+                            pos = (pos + 1) & mask;
+                        }
+                        m_index[pos] = old_slot;
+                    }
+                }
+
             public:
 
                 explicit StringTable(size_t size = default_stringtable_chunk_size) :
-                    m_strings(size) {
+                    m_strings(size),
+                    m_index(initial_index_size) {
                     m_strings.add("");
+                    m_counts.push_back(0);
                 }
 
                 void clear() {
                     m_strings.clear();
-                    m_index.clear();
+                    if (++m_generation == 0) {
+                        for (auto& slot : m_index) {
+                            slot.generation = 0;
+                        }
+                        m_generation = 1;
+                    }
                     m_size = 0;
                     m_strings.add("");
+                    m_counts.clear();
+                    m_counts.push_back(0);
                 }
 
                 int32_t size() const noexcept {
                     return m_size + 1;
                 }
 
+                /// Memory used by the strings and the index in bytes.
+                std::size_t used_memory() const noexcept {
+                    return m_strings.used_memory() +
+                           m_index.capacity() * sizeof(index_slot) +
+                           m_counts.capacity() * sizeof(uint32_t);
+                }
+
                 int32_t add(const char* s) {
-                    const auto f = m_index.find(s);
-                    if (f != m_index.end()) {
-                        return f->second;
+                    const auto hash = djb2_hash{}(s);
+                    auto& slot = find_slot(s, hash);
+                    if (slot.generation == m_generation) {
+                        ++m_counts[slot.id];
+                        return slot.id;
                     }
 
-                    const char* cs = m_strings.add(s);
-                    m_index[cs] = ++m_size;
+                    slot.string = m_strings.add(s);
+                    slot.hash = hash;
+                    slot.generation = m_generation;
+                    slot.id = ++m_size;
+                    m_counts.push_back(1);
 
                     if (m_size > max_entries) {
                         throw osmium::pbf_error{"string table has too many entries"};
                     }
 
+                    // Keep the load factor of the index below 50%.
+                    if (static_cast<std::size_t>(m_size) * 2 > m_index.size()) {
+                        grow_index();
+                    }
+
                     return m_size;
                 }
 
+                /**
+                 * Get new ids for all strings ordered by how often they were
+                 * added, most often used strings first. Strings used equally
+                 * often keep their relative order. The empty string at id 0
+                 * always stays there.
+                 *
+                 * @returns Vector mapping the current ids to the new ids.
+                 */
+                std::vector<int32_t> ids_by_frequency() const {
+                    std::vector<int32_t> order;
+                    order.reserve(m_size);
+                    for (int32_t id = 1; id <= m_size; ++id) {
+                        order.push_back(id);
+                    }
+
+                    std::stable_sort(order.begin(), order.end(), [this](int32_t a, int32_t b) {
+                        return m_counts[a] > m_counts[b];
+                    });
+
+                    std::vector<int32_t> new_ids(order.size() + 1, 0);
+                    int32_t new_id = 0;
+                    for (const auto id : order) {
+                        new_ids[id] = ++new_id;
+                    }
+
+                    return new_ids;
+                }
+
                 StringStore::const_iterator begin() const {
                     return m_strings.begin();
                 }
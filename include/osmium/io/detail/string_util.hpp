@@ -33,7 +33,16 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#if defined(__SSE2__) && !defined(OSMIUM_NO_SIMD)
+# define OSMIUM_STRING_UTIL_USE_SSE2
+#endif
+
+#ifdef OSMIUM_STRING_UTIL_USE_SSE2
+# include <emmintrin.h>
+#endif
+
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
@@ -203,11 +212,72 @@ namespace osmium {
                 out += hex_digits[ value         & 0xfu];
             }
 
+            // ASCII characters that append_utf8_encoded_string() doesn't
+            // escape: All printable characters except space, comma, equal
+            // sign, percent and at sign.
+            inline bool is_plain_opl_ascii(char c) noexcept {
+                return c > 0x20 && c < 0x7f && c != ',' && c != '=' && c != '%' && c != '@';
+            }
+
+#ifdef OSMIUM_STRING_UTIL_USE_SSE2
+            // Bit mask with one bit set for each of the 16 bytes that is
+            // not a printable ASCII character (0x21 to 0x7e) or is one of
+            // the given special characters. Bytes of multibyte UTF-8
+            // characters are negative as signed chars, so they are outside
+            // the printable range.
+            inline unsigned int ascii_special_mask(__m128i data, char min, char special1, char special2, char special3, char special4) noexcept {
+                __m128i m = _mm_or_si128(_mm_cmplt_epi8(data, _mm_set1_epi8(min)),
+                                         _mm_cmpgt_epi8(data, _mm_set1_epi8(0x7e)));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8(special1)));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8(special2)));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8(special3)));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8(special4)));
+                return static_cast<unsigned int>(_mm_movemask_epi8(m));
+            }
+
+            // Skip blocks of 16 bytes which are all printable ASCII
+            // characters except the special characters. Returns a
+            // pointer to the block containing the first other byte or to
+            // the last (incomplete) block. Unaligned loads are used, they
+            // never read beyond end.
+            inline const char* skip_plain_ascii_blocks(const char* data, const char* end, char min, char special1, char special2, char special3, char special4) noexcept {
+                while (end - data >= 16) {
+                    const unsigned int mask = ascii_special_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), min, special1, special2, special3, special4);
+                    if (mask != 0) {
+                        return data + __builtin_ctz(mask);
+                    }
+                    data += 16;
+                }
+                return data;
+            }
+#endif
+
+            // Find the end of the run of characters at data which
+            // append_utf8_encoded_string() doesn't escape.
+            inline const char* skip_plain_opl_ascii(const char* data, const char* end) noexcept {
+#ifdef OSMIUM_STRING_UTIL_USE_SSE2
+                data = skip_plain_ascii_blocks(data, end, 0x21, ',', '=', '%', '@');
+#endif
+                while (data != end && is_plain_opl_ascii(*data)) {
+                    ++data;
+                }
+                return data;
+            }
+
             inline void append_utf8_encoded_string(std::string& out, const char* data) {
                 static const char* lookup_hex = "0123456789abcdef";
                 const char* end = data + std::strlen(data);
 
                 while (data != end) {
+                    // Runs of ASCII characters that are let through are
+                    // appended in one go.
+                    const char* run = data;
+                    data = skip_plain_opl_ascii(data, end);
+                    if (data != run) {
+                        out.append(run, data);
+                        continue;
+                    }
+
                     const char* last = data;
                     const uint32_t c = next_utf8_codepoint(&data, end);
 
@@ -237,20 +307,127 @@ namespace osmium {
                 }
             }
 
+            /**
+             * Lookup table for append_xml_encoded_string(). For every byte
+             * it contains the index of its replacement in entities, 0 if
+             * the byte is copied as is or end_of_string for the final 0.
+             */
+            struct xml_escape_table {
+
+                enum : uint8_t {
+                    end_of_string = 0xff
+                };
+
+                struct entity {
+                    const char* str;
+                    std::size_t size;
+                };
+
+                static const entity* entities() noexcept {
+                    static const entity e[] = {
+                        {"",       0},
+                        {"&amp;",  5},
+                        {"&quot;", 6},
+                        {"&apos;", 6},
+                        {"&lt;",   4},
+                        {"&gt;",   4},
+                        {"&#xA;",  5},
+                        {"&#xD;",  5},
+                        {"&#x9;",  5}
+                    };
+                    return e;
+                }
+
+                uint8_t index[256];
+
+                xml_escape_table() noexcept :
+                    index() {
+                    index[static_cast<unsigned char>('\0')]  = end_of_string;
+                    index[static_cast<unsigned char>('&')]   = 1;
+                    index[static_cast<unsigned char>('\"')]  = 2;
+                    index[static_cast<unsigned char>('\'')]  = 3;
+                    index[static_cast<unsigned char>('<')]   = 4;
+                    index[static_cast<unsigned char>('>')]   = 5;
+                    index[static_cast<unsigned char>('\n')]  = 6;
+                    index[static_cast<unsigned char>('\r')]  = 7;
+                    index[static_cast<unsigned char>('\t')]  = 8;
+                }
+
+            }; // struct xml_escape_table
+
+#ifdef OSMIUM_STRING_UTIL_USE_SSE2
+            // Bit mask with one bit set for each of the 16 bytes that
+            // append_xml_encoded_string() replaces by an entity.
+            inline unsigned int xml_special_mask(__m128i data) noexcept {
+                __m128i m = _mm_cmpeq_epi8(data, _mm_set1_epi8('&'));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('\"')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('\'')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('<')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('>')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('\n')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('\r')));
+                m = _mm_or_si128(m, _mm_cmpeq_epi8(data, _mm_set1_epi8('\t')));
+                return static_cast<unsigned int>(_mm_movemask_epi8(m));
+            }
+#endif
+
             inline void append_xml_encoded_string(std::string& out, const char* data) {
-                for (; *data != '\0'; ++data) {
-                    switch (*data) {
-                        case '&':  out += "&amp;";  break;
-                        case '\"': out += "&quot;"; break;
-                        case '\'': out += "&apos;"; break;
-                        case '<':  out += "&lt;";   break;
-                        case '>':  out += "&gt;";   break;
-                        case '\n': out += "&#xA;";  break;
-                        case '\r': out += "&#xD;";  break;
-                        case '\t': out += "&#x9;";  break;
-                        default:   out += *data;    break;
+                static const xml_escape_table table;
+
+                // Runs of characters that don't need escaping are
+                // appended in one go.
+                const char* run = data;
+
+#ifdef OSMIUM_STRING_UTIL_USE_SSE2
+                // Long strings are checked 16 bytes at a time, the scalar
+                // loop below handles the rest.
+                const char* const end = data + std::strlen(data);
+                while (end - data >= 16) {
+                    const unsigned int mask = xml_special_mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+                    if (mask == 0) {
+                        data += 16;
+                        continue;
+                    }
+                    data += __builtin_ctz(mask);
+                    out.append(run, data);
+                    const auto& entity = xml_escape_table::entities()[table.index[static_cast<unsigned char>(*data)]];
+                    out.append(entity.str, entity.size);
+                    run = ++data;
+                }
+#endif
+
+                for (;; ++data) {
+                    const auto index = table.index[static_cast<unsigned char>(*data)];
+                    if (index == 0) {
+                        continue;
+                    }
+                    out.append(run, data);
+                    if (index == xml_escape_table::end_of_string) {
+                        return;
                     }
+                    const auto& entity = xml_escape_table::entities()[index];
+                    out.append(entity.str, entity.size);
+                    run = data + 1;
+                }
+            }
+
+            // ASCII characters that append_debug_encoded_string() doesn't
+            // escape: All printable characters except double quote, less
+            // than and greater than sign.
+            inline bool is_plain_debug_ascii(char c) noexcept {
+                return c >= 0x20 && c < 0x7f && c != '"' && c != '<' && c != '>';
+            }
+
+            // Find the end of the run of characters at data which
+            // append_debug_encoded_string() doesn't escape.
+            inline const char* skip_plain_debug_ascii(const char* data, const char* end) noexcept {
+#ifdef OSMIUM_STRING_UTIL_USE_SSE2
+                data = skip_plain_ascii_blocks(data, end, 0x20, '"', '<', '>', '>');
+#endif
+                while (data != end && is_plain_debug_ascii(*data)) {
+                    ++data;
                 }
+                return data;
             }
 
             inline void append_debug_encoded_string(std::string& out, const char* data, const char* prefix, const char* suffix) {
@@ -258,6 +435,15 @@ namespace osmium {
                 const char* end = data + std::strlen(data);
 
                 while (data != end) {
+                    // Runs of ASCII characters that are let through are
+                    // appended in one go.
+                    const char* run = data;
+                    data = skip_plain_debug_ascii(data, end);
+                    if (data != run) {
+                        out.append(run, data);
+                        continue;
+                    }
+
                     const char* last = data;
                     uint32_t c = next_utf8_codepoint(&data, end);
 
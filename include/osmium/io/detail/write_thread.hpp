@@ -35,13 +35,19 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/io/compression.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/thread/util.hpp>
+#include <osmium/util/trace.hpp>
 
+#include <atomic>
+#include <cstddef>
 #include <exception>
 #include <future>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -49,25 +55,79 @@ namespace osmium {
 
         namespace detail {
 
+            /**
+             * Write the gathered data with the compressor and update the
+             * counters and stats (if those are not nullptrs).
+             */
+            inline void write_gathered(osmium::io::Compressor& compressor,
+                                       const std::vector<std::string>& data,
+                                       std::size_t bytes,
+                                       std::atomic<std::size_t>* bytes_written,
+                                       PipelineStats* stats) {
+                if (data.empty()) {
+                    return;
+                }
+                {
+                    const stats_timer timer{stats, &PipelineStats::write};
+                    const osmium::trace::Span span{"write"};
+                    if (data.size() == 1) {
+                        compressor.write(data.front());
+                    } else {
+                        compressor.write_all(data);
+                    }
+                }
+                if (bytes_written) {
+                    *bytes_written += bytes;
+                }
+                if (stats) {
+                    stats->bytes_written += bytes;
+                }
+            }
+
             /**
              * This codes runs in its own thread, getting data from the given
              * queue, (optionally) compressing it, and writing it to the output
              * file.
+             *
+             * All data that is already available in the queue (up to some
+             * limits) is gathered and handed to the compressor together so
+             * that uncompressed output can be written with one writev(2)
+             * call.
              */
             class WriteThread {
 
+                enum : std::size_t {
+                    max_gather_count = 64,
+                    max_gather_bytes = 32ul * 1024ul * 1024ul
+                };
+
                 queue_wrapper<std::string> m_queue;
                 std::unique_ptr<osmium::io::Compressor> m_compressor;
                 std::promise<bool> m_promise;
+                std::atomic<std::size_t>* m_bytes_written;
+                PipelineStats* m_stats;
 
             public:
 
+                /**
+                 * @param input_queue Queue with the data to write.
+                 * @param compressor Compressor writing to the output file.
+                 * @param promise Set when all data is written.
+                 * @param bytes_written Optional counter incremented by the
+                 *                      number of bytes written (before
+                 *                      compression).
+                 * @param stats Optional stats recording the write time.
+                 */
                 WriteThread(future_string_queue_type& input_queue,
                             std::unique_ptr<osmium::io::Compressor>&& compressor,
-                            std::promise<bool>&& promise) :
+                            std::promise<bool>&& promise,
+                            std::atomic<std::size_t>* bytes_written = nullptr,
+                            PipelineStats* stats = nullptr) :
                     m_queue(input_queue),
                     m_compressor(std::move(compressor)),
-                    m_promise(std::move(promise)) {
+                    m_promise(std::move(promise)),
+                    m_bytes_written(bytes_written),
+                    m_stats(stats) {
                 }
 
                 WriteThread(const WriteThread&) = delete;
@@ -82,12 +142,28 @@ namespace osmium {
                     osmium::thread::set_thread_name("_osmium_write");
 
                     try {
+                        std::vector<std::string> data;
+                        data.reserve(max_gather_count);
+                        std::size_t bytes = 0;
                         while (true) {
-                            const std::string data{m_queue.pop()};
-                            if (at_end_of_data(data)) {
+                            std::string next{m_queue.pop()};
+                            bool done = at_end_of_data(next);
+                            while (!done) {
+                                bytes += next.size();
+                                data.push_back(std::move(next));
+                                if (data.size() >= max_gather_count ||
+                                    bytes >= max_gather_bytes ||
+                                    !m_queue.try_pop(next)) {
+                                    break;
+                                }
+                                done = at_end_of_data(next);
+                            }
+                            write_gathered(*m_compressor, data, bytes, m_bytes_written, m_stats);
+                            data.clear();
+                            bytes = 0;
+                            if (done) {
                                 break;
                             }
-                            m_compressor->write(data);
                         }
                         m_compressor->close();
                         m_promise.set_value(true);
@@ -99,6 +175,107 @@ namespace osmium {
 
             }; // class WriteThread
 
+            /**
+             * Does the same as the WriteThread, but in steps on an
+             * IOExecutor. Each step writes the data already available in
+             * the queue (up to the same limits as the WriteThread) and
+             * never waits for more.
+             */
+            class WriteStage : public io_stage {
+
+                enum : std::size_t {
+                    max_gather_count = 64,
+                    max_gather_bytes = 32ul * 1024ul * 1024ul
+                };
+
+                queue_wrapper<std::string> m_queue;
+                std::unique_ptr<osmium::io::Compressor> m_compressor;
+                std::promise<bool> m_promise;
+                std::atomic<std::size_t>* m_bytes_written;
+                PipelineStats* m_stats;
+                std::vector<std::string> m_data;
+                bool m_failed = false;
+
+                // After an error the rest of the data is thrown away so that
+                // the Writer never blocks on a full queue.
+                io_stage_result drain() {
+                    bool got_data = false;
+                    while (true) {
+                        try {
+                            std::string next;
+                            if (!m_queue.try_pop(next)) {
+                                break;
+                            }
+                            got_data = true;
+                        } catch (...) {
+                            got_data = true;
+                        }
+                        if (m_queue.has_reached_end_of_data()) {
+                            return io_stage_result::done;
+                        }
+                    }
+                    return got_data ? io_stage_result::progress : io_stage_result::idle;
+                }
+
+            public:
+
+                WriteStage(future_string_queue_type& input_queue,
+                           std::unique_ptr<osmium::io::Compressor>&& compressor,
+                           std::promise<bool>&& promise,
+                           std::atomic<std::size_t>* bytes_written = nullptr,
+                           PipelineStats* stats = nullptr) :
+                    m_queue(input_queue),
+                    m_compressor(std::move(compressor)),
+                    m_promise(std::move(promise)),
+                    m_bytes_written(bytes_written),
+                    m_stats(stats) {
+                    m_data.reserve(max_gather_count);
+                }
+
+                io_stage_result step() override {
+                    if (m_failed) {
+                        return drain();
+                    }
+
+                    try {
+                        std::size_t bytes = 0;
+                        bool done = false;
+                        std::string next;
+                        while (m_data.size() < max_gather_count &&
+                               bytes < max_gather_bytes &&
+                               m_queue.try_pop(next)) {
+                            if (at_end_of_data(next)) {
+                                done = true;
+                                break;
+                            }
+                            bytes += next.size();
+                            m_data.push_back(std::move(next));
+                        }
+
+                        if (m_data.empty() && !done) {
+                            return io_stage_result::idle;
+                        }
+
+                        write_gathered(*m_compressor, m_data, bytes, m_bytes_written, m_stats);
+                        m_data.clear();
+
+                        if (done) {
+                            m_compressor->close();
+                            m_promise.set_value(true);
+                            return io_stage_result::done;
+                        }
+                    } catch (...) {
+                        m_promise.set_exception(std::current_exception());
+                        m_failed = true;
+                        if (m_queue.has_reached_end_of_data()) {
+                            return io_stage_result::done;
+                        }
+                    }
+                    return io_stage_result::progress;
+                }
+
+            }; // class WriteStage
+
         } // namespace detail
 
     } // namespace io
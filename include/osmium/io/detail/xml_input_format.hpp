@@ -37,6 +37,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/builder/osm_object_builder.hpp>
 #include <osmium/io/detail/input_format.hpp>
 #include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/string_util.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
@@ -58,13 +59,20 @@ DEALINGS IN THE SOFTWARE.
 
 #include <expat.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
 #include <cstring>
+#include <functional>
 #include <future>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace osmium {
 
@@ -99,6 +107,19 @@ namespace osmium {
             error_string(message) {
         }
 
+        xml_error(uint64_t l, uint64_t c, const char* message) :
+            io_error(std::string{"XML parsing error at line "}
+                    + std::to_string(l)
+                    + ", column "
+                    + std::to_string(c)
+                    + ": "
+                    + message),
+            line(l),
+            column(c),
+            error_code(),
+            error_string(message) {
+        }
+
     }; // struct xml_error
 
     /**
@@ -124,12 +145,570 @@ namespace osmium {
 
         namespace detail {
 
-            class XMLParser : public Parser {
-
-                enum {
-                    initial_buffer_size = 1024ul * 1024ul
+            /**
+             * A tokenizer for the subset of XML used in OSM files. It calls
+             * start_element(), end_element(), and characters() on the
+             * handler with the same arguments as the Expat callbacks. All
+             * names and attribute values are decoded into one string which
+             * is reused for each element, so there are no allocations per
+             * element.
+             *
+             * This does fewer checks than Expat: Characters are not checked
+             * for validity and duplicate attributes are not detected.
+             * Document type declarations and encodings other than UTF-8 are
+             * not supported, in that case operator() returns false before
+             * anything was reported to the handler. The caller should then
+             * give the buffered_data() to Expat.
+             */
+            template <typename THandler>
+            class XMLTokenizer {
+
+                enum class result {
+                    ok,
+                    incomplete,
+                    unsupported
                 };
 
+                THandler& m_handler;
+
+                // Input data not completely consumed yet
+                std::string m_data;
+
+                // Position in m_data where the next token starts
+                std::size_t m_pos = 0;
+
+                // Decoded element name, attribute names, and attribute
+                // values, each followed by a null byte
+                std::string m_names;
+                std::vector<std::size_t> m_offsets;
+                std::vector<const char*> m_attrs;
+
+                // Decoded character data
+                std::string m_text;
+
+                std::vector<std::string> m_open_elements;
+
+                // Line and column of the beginning of m_data
+                uint64_t m_line = 1;
+                uint64_t m_column = 0;
+
+                bool m_last = false;
+                bool m_in_prolog = true;
+                bool m_document_done = false;
+                bool m_fragment = false;
+
+                static bool is_space(char c) noexcept {
+                    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+                }
+
+                static const char* find(const char* begin, const char* end, const char* str) noexcept {
+                    const char* const str_end = str + std::strlen(str);
+                    const char* pos = std::search(begin, end, str, str_end);
+                    return pos == end ? nullptr : pos;
+                }
+
+                static bool starts_with(const char* begin, const char* end, const char* str) noexcept {
+                    const auto len = std::strlen(str);
+                    return static_cast<std::size_t>(end - begin) >= len && !std::strncmp(begin, str, len);
+                }
+
+                [[noreturn]] void error(const char* pos, const char* message) const {
+                    uint64_t line = m_line;
+                    uint64_t column = m_column;
+                    for (const char* p = m_data.data(); p != pos; ++p) {
+                        if (*p == '\n') {
+                            ++line;
+                            column = 0;
+                        } else {
+                            ++column;
+                        }
+                    }
+                    throw osmium::xml_error{line, column, message};
+                }
+
+                // Decode an entity or character reference starting at the
+                // '&' at begin and append it to out. Returns a pointer to
+                // the character after the reference.
+                const char* decode_reference(const char* begin, const char* end, std::string& out) const {
+                    const char* semicolon = static_cast<const char*>(std::memchr(begin, ';', end - begin));
+                    if (!semicolon) {
+                        error(begin, "not well-formed (invalid token)");
+                    }
+                    const char* name = begin + 1;
+                    const auto len = static_cast<std::size_t>(semicolon - name);
+                    if (len == 2 && !std::strncmp(name, "lt", 2)) {
+                        out += '<';
+                    } else if (len == 2 && !std::strncmp(name, "gt", 2)) {
+                        out += '>';
+                    } else if (len == 3 && !std::strncmp(name, "amp", 3)) {
+                        out += '&';
+                    } else if (len == 4 && !std::strncmp(name, "quot", 4)) {
+                        out += '"';
+                    } else if (len == 4 && !std::strncmp(name, "apos", 4)) {
+                        out += '\'';
+                    } else if (len > 1 && *name == '#') {
+                        const bool hex = name[1] == 'x';
+                        const char* digit = name + (hex ? 2 : 1);
+                        if (digit == semicolon || semicolon - digit > 8) {
+                            error(begin, "reference to invalid character number");
+                        }
+                        uint32_t value = 0;
+                        for (; digit != semicolon; ++digit) {
+                            const char c = *digit;
+                            if (c >= '0' && c <= '9') {
+                                value = value * (hex ? 16 : 10) + static_cast<uint32_t>(c - '0');
+                            } else if (hex && c >= 'a' && c <= 'f') {
+                                value = value * 16 + static_cast<uint32_t>(c - 'a' + 10);
+                            } else if (hex && c >= 'A' && c <= 'F') {
+                                value = value * 16 + static_cast<uint32_t>(c - 'A' + 10);
+                            } else {
+                                error(begin, "not well-formed (invalid token)");
+                            }
+                        }
+                        if (value == 0 || value > 0x10ffffU || (value >= 0xd800U && value <= 0xdfffU)) {
+                            error(begin, "reference to invalid character number");
+                        }
+                        append_codepoint_as_utf8(value, std::back_inserter(out));
+                    } else {
+                        error(begin, "undefined entity");
+                    }
+                    return semicolon + 1;
+                }
+
+                void add_name(const char* begin, const char* end) {
+                    m_offsets.push_back(m_names.size());
+                    m_names.append(begin, end);
+                    m_names += '\0';
+                }
+
+                // Attribute values are normalized: References are replaced
+                // and whitespace characters become spaces.
+                void add_value(const char* begin, const char* end) {
+                    m_offsets.push_back(m_names.size());
+                    const char* run = begin;
+                    while (begin != end) {
+                        const char c = *begin;
+                        if (c == '&' || c == '<' || c == '\t' || c == '\n' || c == '\r') {
+                            m_names.append(run, begin);
+                            if (c == '&') {
+                                begin = decode_reference(begin, end, m_names);
+                            } else if (c == '<') {
+                                error(begin, "not well-formed (invalid token)");
+                            } else {
+                                m_names += ' ';
+                                if (c == '\r' && begin + 1 != end && begin[1] == '\n') {
+                                    ++begin;
+                                }
+                                ++begin;
+                            }
+                            run = begin;
+                        } else {
+                            ++begin;
+                        }
+                    }
+                    m_names.append(run, end);
+                    m_names += '\0';
+                }
+
+                void text(const char* begin, const char* end) {
+                    if (begin == end) {
+                        return;
+                    }
+                    if (m_open_elements.empty()) {
+                        for (; begin != end; ++begin) {
+                            if (!is_space(*begin)) {
+                                error(begin, m_in_prolog ? "syntax error" : "junk after document element");
+                            }
+                        }
+                        return;
+                    }
+
+                    const char* run = begin;
+                    const char* p = begin;
+                    while (p != end && *p != '&' && *p != '\r') {
+                        ++p;
+                    }
+                    if (p == end) {
+                        m_handler.characters(begin, static_cast<int>(end - begin));
+                        return;
+                    }
+
+                    // Slow path: Replace references and line endings
+                    m_text.clear();
+                    while (p != end) {
+                        if (*p == '&') {
+                            m_text.append(run, p);
+                            p = decode_reference(p, end, m_text);
+                            run = p;
+                        } else if (*p == '\r') {
+                            m_text.append(run, p);
+                            m_text += '\n';
+                            ++p;
+                            if (p != end && *p == '\n') {
+                                ++p;
+                            }
+                            run = p;
+                        } else {
+                            ++p;
+                        }
+                    }
+                    m_text.append(run, end);
+                    m_handler.characters(m_text.data(), static_cast<int>(m_text.size()));
+                }
+
+                void open_element(const char* name, const char** attrs) {
+                    m_in_prolog = false;
+                    m_open_elements.emplace_back(name);
+                    m_handler.start_element(name, attrs);
+                }
+
+                void close_element() {
+                    m_handler.end_element(m_open_elements.back().c_str());
+                    m_open_elements.pop_back();
+                    if (m_open_elements.empty()) {
+                        m_document_done = true;
+                    }
+                }
+
+                result start_tag(const char*& pos, const char* end) {
+                    if (m_document_done) {
+                        error(pos, "junk after document element");
+                    }
+
+                    m_names.clear();
+                    m_offsets.clear();
+
+                    const char* p = pos + 1;
+                    const char* name = p;
+                    while (p != end && !is_space(*p) && *p != '/' && *p != '>') {
+                        ++p;
+                    }
+                    if (p == end) {
+                        return result::incomplete;
+                    }
+                    if (p == name) {
+                        error(pos, "not well-formed (invalid token)");
+                    }
+                    add_name(name, p);
+
+                    bool empty_element = false;
+                    while (true) {
+                        while (p != end && is_space(*p)) {
+                            ++p;
+                        }
+                        if (p == end) {
+                            return result::incomplete;
+                        }
+                        if (*p == '>') {
+                            ++p;
+                            break;
+                        }
+                        if (*p == '/') {
+                            if (p + 1 == end) {
+                                return result::incomplete;
+                            }
+                            if (p[1] != '>') {
+                                error(p, "not well-formed (invalid token)");
+                            }
+                            p += 2;
+                            empty_element = true;
+                            break;
+                        }
+
+                        const char* attr_name = p;
+                        while (p != end && !is_space(*p) && *p != '=' && *p != '/' && *p != '>') {
+                            ++p;
+                        }
+                        while (p != end && is_space(*p)) {
+                            ++p;
+                        }
+                        if (p == end) {
+                            return result::incomplete;
+                        }
+                        if (*p != '=' || p == attr_name) {
+                            error(p, "not well-formed (invalid token)");
+                        }
+                        const char* attr_name_end = p;
+                        while (is_space(attr_name_end[-1])) {
+                            --attr_name_end;
+                        }
+                        ++p;
+                        while (p != end && is_space(*p)) {
+                            ++p;
+                        }
+                        if (p == end) {
+                            return result::incomplete;
+                        }
+                        const char quote = *p;
+                        if (quote != '"' && quote != '\'') {
+                            error(p, "not well-formed (invalid token)");
+                        }
+                        ++p;
+                        const char* value_end = static_cast<const char*>(std::memchr(p, quote, end - p));
+                        if (!value_end) {
+                            return result::incomplete;
+                        }
+                        add_name(attr_name, attr_name_end);
+                        add_value(p, value_end);
+                        p = value_end + 1;
+                        if (p != end && !is_space(*p) && *p != '/' && *p != '>') {
+                            error(p, "not well-formed (invalid token)");
+                        }
+                    }
+
+                    m_attrs.clear();
+                    for (std::size_t i = 1; i < m_offsets.size(); ++i) {
+                        m_attrs.push_back(m_names.data() + m_offsets[i]);
+                    }
+                    m_attrs.push_back(nullptr);
+
+                    pos = p;
+                    open_element(m_names.data(), m_attrs.data());
+                    if (empty_element) {
+                        close_element();
+                    }
+                    return result::ok;
+                }
+
+                result end_tag(const char*& pos, const char* end) {
+                    const char* gt = static_cast<const char*>(std::memchr(pos, '>', end - pos));
+                    if (!gt) {
+                        return result::incomplete;
+                    }
+                    const char* name = pos + 2;
+                    const char* name_end = gt;
+                    while (name_end != name && is_space(name_end[-1])) {
+                        --name_end;
+                    }
+                    if (m_open_elements.empty() ||
+                        m_open_elements.back().size() != static_cast<std::size_t>(name_end - name) ||
+                        std::strncmp(m_open_elements.back().data(), name, m_open_elements.back().size()) != 0) {
+                        error(pos, "mismatched tag");
+                    }
+                    pos = gt + 1;
+                    close_element();
+                    return result::ok;
+                }
+
+                result processing_instruction(const char*& pos, const char* end) {
+                    const char* pi_end = find(pos, end, "?>");
+                    if (!pi_end) {
+                        return result::incomplete;
+                    }
+                    if (m_in_prolog && starts_with(pos, pi_end, "<?xml ")) {
+                        const char* encoding = find(pos, pi_end, "encoding");
+                        if (encoding) {
+                            const char* p = encoding + 8;
+                            while (p != pi_end && (is_space(*p) || *p == '=')) {
+                                ++p;
+                            }
+                            if (p != pi_end) {
+                                const char quote = *p++;
+                                const char* value_end = std::find(p, pi_end, quote);
+                                std::string value{p, value_end};
+                                for (auto& c : value) {
+                                    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                                }
+                                if (value != "utf-8" && value != "us-ascii") {
+                                    return result::unsupported;
+                                }
+                            }
+                        }
+                    }
+                    pos = pi_end + 2;
+                    return result::ok;
+                }
+
+                result markup_declaration(const char*& pos, const char* end) {
+                    if (end - pos < 9 && !m_last) {
+                        return result::incomplete;
+                    }
+                    if (starts_with(pos, end, "<!--")) {
+                        const char* comment_end = find(pos + 4, end, "-->");
+                        if (!comment_end) {
+                            return result::incomplete;
+                        }
+                        pos = comment_end + 3;
+                        return result::ok;
+                    }
+                    if (starts_with(pos, end, "<![CDATA[")) {
+                        if (m_open_elements.empty()) {
+                            error(pos, "syntax error");
+                        }
+                        const char* cdata_end = find(pos + 9, end, "]]>");
+                        if (!cdata_end) {
+                            return result::incomplete;
+                        }
+                        if (cdata_end != pos + 9) {
+                            m_handler.characters(pos + 9, static_cast<int>(cdata_end - (pos + 9)));
+                        }
+                        pos = cdata_end + 3;
+                        return result::ok;
+                    }
+                    if (m_in_prolog) {
+                        return result::unsupported;
+                    }
+                    error(pos, "syntax error");
+                }
+
+                result next_token(const char*& pos, const char* end) {
+                    if (*pos != '<') {
+                        const char* lt = static_cast<const char*>(std::memchr(pos, '<', end - pos));
+                        if (!lt) {
+                            if (!m_last) {
+                                return result::incomplete;
+                            }
+                            lt = end;
+                        }
+                        text(pos, lt);
+                        pos = lt;
+                        return result::ok;
+                    }
+
+                    if (end - pos < 2) {
+                        return result::incomplete;
+                    }
+
+                    switch (pos[1]) {
+                        case '/':
+                            return end_tag(pos, end);
+                        case '?':
+                            return processing_instruction(pos, end);
+                        case '!':
+                            return markup_declaration(pos, end);
+                        default:
+                            break;
+                    }
+                    return start_tag(pos, end);
+                }
+
+                void consume(std::size_t size) {
+                    const char* const begin = m_data.data();
+                    for (const char* p = begin; p != begin + size; ++p) {
+                        if (*p == '\n') {
+                            ++m_line;
+                            m_column = 0;
+                        } else {
+                            ++m_column;
+                        }
+                    }
+                    m_data.erase(0, size);
+                    m_pos = 0;
+                }
+
+            public:
+
+                explicit XMLTokenizer(THandler& handler) :
+                    m_handler(handler) {
+                }
+
+                /**
+                 * Construct a tokenizer for a fragment of a document
+                 * starting inside the open_elements given. The line and
+                 * column of the beginning of the fragment in the document
+                 * are used for error messages. At the end of the fragment
+                 * elements can still be open, use open_elements() to check
+                 * them.
+                 */
+                XMLTokenizer(THandler& handler, std::vector<std::string> open_elements, uint64_t line, uint64_t column) :
+                    m_handler(handler),
+                    m_open_elements(std::move(open_elements)),
+                    m_line(line),
+                    m_column(column),
+                    m_in_prolog(m_open_elements.empty()),
+                    m_fragment(true) {
+                }
+
+                /**
+                 * Tokenize the next chunk of data. Tokens can span chunks.
+                 * Set last on the last chunk.
+                 *
+                 * @returns false if the data can not be handled by this
+                 *          tokenizer. This can only happen before the root
+                 *          element has been seen.
+                 * @throws osmium::xml_error if the data is not well-formed.
+                 */
+                bool operator()(std::string&& data, bool last) {
+                    if (m_data.empty()) {
+                        m_data = std::move(data);
+                        // Skip byte order mark
+                        if (m_in_prolog && m_pos == 0 && starts_with(m_data.data(), m_data.data() + m_data.size(), "\xef\xbb\xbf")) {
+                            m_pos = 3;
+                        }
+                    } else {
+                        m_data.append(data);
+                    }
+                    m_last = last;
+
+                    const char* const begin = m_data.data();
+                    const char* const end = begin + m_data.size();
+                    const char* pos = begin + m_pos;
+                    while (pos != end) {
+                        const result r = next_token(pos, end);
+                        if (r == result::incomplete) {
+                            break;
+                        }
+                        if (r == result::unsupported) {
+                            return false;
+                        }
+                    }
+
+                    if (last) {
+                        if (pos != end) {
+                            error(pos, "unclosed token");
+                        }
+                        if (!m_document_done && !m_fragment) {
+                            error(pos, "no element found");
+                        }
+                    }
+
+                    // As long as we are in the prolog, all data is kept in
+                    // case it has to be given to Expat later.
+                    m_pos = static_cast<std::size_t>(pos - begin);
+                    if (!m_in_prolog) {
+                        consume(m_pos);
+                    }
+
+                    return true;
+                }
+
+                /**
+                 * The data given to this tokenizer which was not completely
+                 * consumed yet. After operator() returned false, this is all
+                 * the data given to the tokenizer.
+                 */
+                std::string& buffered_data() noexcept {
+                    return m_data;
+                }
+
+                /**
+                 * The names of the currently open elements starting with
+                 * the root element.
+                 */
+                const std::vector<std::string>& open_elements() const noexcept {
+                    return m_open_elements;
+                }
+
+                /**
+                 * Check that the open elements are the ones expected at the
+                 * current position.
+                 *
+                 * @throws osmium::xml_error if they are not.
+                 */
+                void check_open_elements(const std::vector<std::string>& expected) const {
+                    if (m_open_elements != expected) {
+                        error(m_data.data() + m_pos, expected.empty() ? "no element found" : "mismatched tag");
+                    }
+                }
+
+            }; // class XMLTokenizer
+
+            /**
+             * Builds OSM objects from the XML elements reported by Expat or
+             * the XMLTokenizer.
+             */
+            class XMLContentHandler {
+
                 enum class context {
                     osm,
                     osmChange,
@@ -154,8 +733,12 @@ namespace osmium {
 
                 osmium::io::Header m_header{};
 
-                osmium::memory::Buffer m_buffer{initial_buffer_size,
-                                                osmium::memory::Buffer::auto_grow::internal};
+                osmium::io::read_buffers m_buffers;
+
+                osmium::memory::Buffer m_buffer;
+
+                // When we started filling m_buffer, see read_buffers.
+                std::chrono::steady_clock::time_point m_buffer_started{};
 
                 std::unique_ptr<osmium::builder::NodeBuilder>                m_node_builder{};
                 std::unique_ptr<osmium::builder::WayBuilder>                 m_way_builder{};
@@ -169,74 +752,35 @@ namespace osmium {
 
                 std::string m_comment_text;
 
-                /**
-                 * A C++ wrapper for the Expat parser that makes sure no memory
-                 * is leaked.
-                 */
-                class ExpatXMLParser {
+                osmium::osm_entity_bits::type m_read_types;
 
-                    XML_Parser m_parser;
+                std::function<void(const osmium::io::Header&)> m_header_done;
+                std::function<void(osmium::memory::Buffer&&)> m_buffer_full;
 
-                    static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) {
-                        static_cast<XMLParser*>(data)->start_element(element, attrs);
-                    }
+                bool m_header_is_done = false;
 
-                    static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) {
-                        static_cast<XMLParser*>(data)->end_element(element);
+                static context open_element_context(const std::string& name) {
+                    if (name == "osm") {
+                        return context::osm;
                     }
-
-                    static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) {
-                        static_cast<XMLParser*>(data)->characters(text, len);
+                    if (name == "osmChange") {
+                        return context::osmChange;
                     }
-
-                    // This handler is called when there are any XML entities
-                    // declared in the OSM file. Entities are normally not used,
-                    // but they can be misused. See
-                    // https://en.wikipedia.org/wiki/Billion_laughs
-                    // The handler will just throw an error.
-                    static void entity_declaration_handler(void* /*userData*/,
-                            const XML_Char* /*entityName*/,
-                            int /*is_parameter_entity*/,
-                            const XML_Char* /*value*/,
-                            int /*value_length*/,
-                            const XML_Char* /*base*/,
-                            const XML_Char* /*systemId*/,
-                            const XML_Char* /*publicId*/,
-                            const XML_Char* /*notationName*/) {
-                        throw osmium::xml_error{"XML entities are not supported"};
+                    if (name == "create") {
+                        return context::create_section;
                     }
-
-                public:
-
-                    explicit ExpatXMLParser(void* callback_object) :
-                        m_parser(XML_ParserCreate(nullptr)) {
-                        if (!m_parser) {
-                            throw osmium::io_error{"Internal error: Can not create parser"};
-                        }
-                        XML_SetUserData(m_parser, callback_object);
-                        XML_SetElementHandler(m_parser, start_element_wrapper, end_element_wrapper);
-                        XML_SetCharacterDataHandler(m_parser, character_data_wrapper);
-                        XML_SetEntityDeclHandler(m_parser, entity_declaration_handler);
+                    if (name == "modify") {
+                        return context::modify_section;
                     }
-
-                    ExpatXMLParser(const ExpatXMLParser&) = delete;
-                    ExpatXMLParser& operator=(const ExpatXMLParser&) = delete;
-
-                    ExpatXMLParser(ExpatXMLParser&&) = delete;
-                    ExpatXMLParser& operator=(ExpatXMLParser&&) = delete;
-
-                    ~ExpatXMLParser() noexcept {
-                        XML_ParserFree(m_parser);
-                    }
-
-                    void operator()(const std::string& data, bool last) {
-                        assert(data.size() < std::numeric_limits<int>::max());
-                        if (XML_Parse(m_parser, data.data(), static_cast<int>(data.size()), last) == XML_STATUS_ERROR) {
-                            throw osmium::xml_error{m_parser};
-                        }
+                    if (name == "delete") {
+                        return context::delete_section;
                     }
+                    throw xml_error{std::string{"Can not start parsing inside element: "} + name};
+                }
 
-                }; // class ExpatXMLParser
+                osmium::osm_entity_bits::type read_types() const noexcept {
+                    return m_read_types;
+                }
 
                 template <typename T>
                 static void check_attributes(const XML_Char** attrs, T&& check) {
@@ -314,10 +858,6 @@ namespace osmium {
                     m_tl_builder->add_tag(k, v);
                 }
 
-                void mark_header_as_done() {
-                    set_header_value(m_header);
-                }
-
                 void top_level_element(const XML_Char* element, const XML_Char** attrs) {
                     if (!std::strcmp(element, "osm")) {
                         m_context_stack.push_back(context::osm);
@@ -439,6 +979,78 @@ namespace osmium {
                     }
                 }
 
+                void flush_buffer() {
+                    if (m_buffer_full && m_buffers.is_full(m_buffer, m_buffer_started)) {
+                        osmium::memory::Buffer buffer{m_buffers.get()};
+                        using std::swap;
+                        swap(m_buffer, buffer);
+                        m_buffer_started = m_buffers.start_time();
+                        m_buffer_full(std::move(buffer));
+                    }
+                }
+
+            public:
+
+                /**
+                 * Construct a handler for a complete document. The
+                 * header_done function is called once the header is
+                 * complete, the buffer_full function is called with each
+                 * buffer when it is full.
+                 */
+                XMLContentHandler(osmium::osm_entity_bits::type read_types,
+                                  const osmium::io::read_buffers& buffers,
+                                  std::function<void(const osmium::io::Header&)> header_done,
+                                  std::function<void(osmium::memory::Buffer&&)> buffer_full) :
+                    m_buffers(buffers),
+                    m_buffer(buffers.get()),
+                    m_buffer_started(buffers.start_time()),
+                    m_read_types(read_types),
+                    m_header_done(std::move(header_done)),
+                    m_buffer_full(std::move(buffer_full)) {
+                }
+
+                /**
+                 * Construct a handler for a part of a document which
+                 * starts inside the open_elements given. They can only be
+                 * the root element and osmChange sections. The header is
+                 * ignored and all objects are added to one buffer which
+                 * grows as needed.
+                 */
+                XMLContentHandler(osmium::osm_entity_bits::type read_types,
+                                  const osmium::io::read_buffers& buffers,
+                                  const std::vector<std::string>& open_elements) :
+                    m_buffers(buffers),
+                    m_buffer(buffers.get()),
+                    m_read_types(read_types),
+                    m_header_is_done(true) {
+                    for (const auto& name : open_elements) {
+                        m_context_stack.push_back(open_element_context(name));
+                    }
+                }
+
+                XMLContentHandler(const XMLContentHandler&) = delete;
+                XMLContentHandler& operator=(const XMLContentHandler&) = delete;
+
+                XMLContentHandler(XMLContentHandler&&) = delete;
+                XMLContentHandler& operator=(XMLContentHandler&&) = delete;
+
+                ~XMLContentHandler() noexcept = default;
+
+                const osmium::io::Header& header() const noexcept {
+                    return m_header;
+                }
+
+                osmium::memory::Buffer& buffer() noexcept {
+                    return m_buffer;
+                }
+
+                void mark_header_as_done() {
+                    if (!m_header_is_done) {
+                        m_header_is_done = true;
+                        m_header_done(m_header);
+                    }
+                }
+
                 void start_element(const XML_Char* element, const XML_Char** attrs) {
                     if (m_context_stack.empty()) {
                         top_level_element(element, attrs);
@@ -704,17 +1316,450 @@ namespace osmium {
                     }
                 }
 
-                void flush_buffer() {
-                    if (m_buffer.has_nested_buffers()) {
-                        std::unique_ptr<osmium::memory::Buffer> buffer_ptr{m_buffer.get_last_nested()};
-                        send_to_output_queue(std::move(*buffer_ptr));
+            }; // class XMLContentHandler
+
+            /**
+             * Finds places in OSM XML data where it can be split into
+             * chunks which can be parsed independently. These are the
+             * start tags of nodes, ways, relations, and changesets, and of
+             * the create, modify, and delete sections in change files.
+             *
+             * This doesn't tokenize the data, it only looks at the start of
+             * each tag, skipping over comments, CDATA sections, and
+             * processing instructions. It keeps track of the open root
+             * element and sections, so that each chunk can be parsed
+             * knowing which elements it starts in.
+             */
+            class XMLSplitter {
+
+                std::vector<std::string> m_open_elements;
+
+                static bool is_name_end(char c) noexcept {
+                    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '/' || c == '>';
+                }
+
+                static bool is_split_element(const char* name, std::size_t len) noexcept {
+                    switch (len) {
+                        case 3:
+                            return !std::strncmp(name, "way", 3);
+                        case 4:
+                            return !std::strncmp(name, "node", 4);
+                        case 6:
+                            return !std::strncmp(name, "create", 6) ||
+                                   !std::strncmp(name, "modify", 6) ||
+                                   !std::strncmp(name, "delete", 6);
+                        case 8:
+                            return !std::strncmp(name, "relation", 8);
+                        case 9:
+                            return !std::strncmp(name, "changeset", 9);
+                        default:
+                            break;
+                    }
+                    return false;
+                }
+
+                static bool is_enclosing_element(const char* name, std::size_t len) noexcept {
+                    return (len == 3 && !std::strncmp(name, "osm", 3)) ||
+                           (len == 9 && !std::strncmp(name, "osmChange", 9)) ||
+                           (len == 6 && (!std::strncmp(name, "create", 6) ||
+                                         !std::strncmp(name, "modify", 6) ||
+                                         !std::strncmp(name, "delete", 6)));
+                }
+
+                // Find the end of a start tag beginning at pos, taking
+                // into account that attribute values can contain '>'.
+                static std::size_t find_tag_end(const std::string& data, std::size_t pos) noexcept {
+                    char quote = '\0';
+                    for (; pos < data.size(); ++pos) {
+                        const char c = data[pos];
+                        if (quote) {
+                            if (c == quote) {
+                                quote = '\0';
+                            }
+                        } else if (c == '"' || c == '\'') {
+                            quote = c;
+                        } else if (c == '>') {
+                            return pos;
+                        }
                     }
+                    return std::string::npos;
                 }
 
             public:
 
+                /**
+                 * Find the next split point in data. Tags starting before
+                 * min_pos are never split points. Scanning starts at pos.
+                 *
+                 * @returns The position of the split point or
+                 *          std::string::npos if there is none in the data
+                 *          available. In that case pos is set to where
+                 *          scanning has to continue once there is more
+                 *          data.
+                 */
+                std::size_t find(const std::string& data, std::size_t& pos, std::size_t min_pos) {
+                    while (true) {
+                        pos = data.find('<', pos);
+                        if (pos == std::string::npos) {
+                            pos = data.size();
+                            return std::string::npos;
+                        }
+                        if (data.size() - pos < 10) {
+                            return std::string::npos;
+                        }
+
+                        const char c = data[pos + 1];
+                        if (c == '!' || c == '?') {
+                            const char* end_marker = c == '?' ? "?>" : data.compare(pos, 4, "<!--") == 0 ? "-->" : data.compare(pos, 9, "<![CDATA[") == 0 ? "]]>" : ">";
+                            const auto end = data.find(end_marker, pos + 2);
+                            if (end == std::string::npos) {
+                                return std::string::npos;
+                            }
+                            pos = end + std::strlen(end_marker);
+                            continue;
+                        }
+
+                        const bool end_tag = (c == '/');
+                        const std::size_t name_begin = pos + (end_tag ? 2 : 1);
+                        std::size_t name_end = name_begin;
+                        while (name_end < data.size() && !is_name_end(data[name_end])) {
+                            ++name_end;
+                        }
+                        if (name_end == data.size()) {
+                            return std::string::npos;
+                        }
+                        const char* name = data.data() + name_begin;
+                        const std::size_t len = name_end - name_begin;
+
+                        if (end_tag) {
+                            if (!m_open_elements.empty() &&
+                                m_open_elements.back().size() == len &&
+                                !std::strncmp(m_open_elements.back().data(), name, len)) {
+                                m_open_elements.pop_back();
+                            }
+                            pos = name_end;
+                            continue;
+                        }
+
+                        if (pos >= min_pos && !m_open_elements.empty() && is_split_element(name, len)) {
+                            return pos;
+                        }
+
+                        if (is_enclosing_element(name, len)) {
+                            const auto tag_end = find_tag_end(data, name_end);
+                            if (tag_end == std::string::npos) {
+                                return std::string::npos;
+                            }
+                            if (data[tag_end - 1] != '/') {
+                                m_open_elements.emplace_back(name, len);
+                            }
+                            pos = tag_end + 1;
+                            continue;
+                        }
+
+                        pos = name_end;
+                    }
+                }
+
+                /**
+                 * The names of the root element and sections open at the
+                 * current position.
+                 */
+                const std::vector<std::string>& open_elements() const noexcept {
+                    return m_open_elements;
+                }
+
+            }; // class XMLSplitter
+
+            /**
+             * Parses a chunk of OSM XML data in the thread pool. The chunk
+             * starts and ends at split points found by the XMLSplitter.
+             */
+            class XMLChunkParser {
+
+                std::string m_data;
+                std::vector<std::string> m_open_elements_at_start;
+                std::vector<std::string> m_open_elements_at_end;
+                uint64_t m_line;
+                uint64_t m_column;
+                osmium::osm_entity_bits::type m_read_types;
+                osmium::io::tag_prefilter m_prefilter;
+                osmium::io::read_buffers m_buffers;
+                std::shared_ptr<DecodeWindow> m_window;
+
+                osmium::memory::Buffer parse() {
+                    XMLContentHandler handler{m_read_types, m_buffers, m_open_elements_at_start};
+                    XMLTokenizer<XMLContentHandler> tokenizer{handler, m_open_elements_at_start, m_line, m_column};
+                    tokenizer(std::move(m_data), true);
+                    tokenizer.check_open_elements(m_open_elements_at_end);
+                    if (m_prefilter.enabled()) {
+                        return apply_tag_prefilter(m_prefilter, handler.buffer());
+                    }
+                    return std::move(handler.buffer());
+                }
+
+            public:
+
+                XMLChunkParser(std::string&& data,
+                               std::vector<std::string> open_elements_at_start,
+                               std::vector<std::string> open_elements_at_end,
+                               uint64_t line,
+                               uint64_t column,
+                               osmium::osm_entity_bits::type read_types,
+                               const osmium::io::tag_prefilter& prefilter,
+                               const osmium::io::read_buffers& buffers,
+                               std::shared_ptr<DecodeWindow> window) :
+                    m_data(std::move(data)),
+                    m_open_elements_at_start(std::move(open_elements_at_start)),
+                    m_open_elements_at_end(std::move(open_elements_at_end)),
+                    m_line(line),
+                    m_column(column),
+                    m_read_types(read_types),
+                    m_prefilter(prefilter),
+                    m_buffers(buffers),
+                    m_window(std::move(window)) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    const std::size_t bytes = m_data.size();
+                    try {
+                        auto buffer = parse();
+                        m_window->remove(bytes);
+                        return buffer;
+                    } catch (...) {
+                        m_window->remove(bytes);
+                        throw;
+                    }
+                }
+
+            }; // class XMLChunkParser
+
+            class XMLParser : public Parser {
+
+                XMLContentHandler m_handler;
+
+                osmium::io::xml_tokenizer m_tokenizer;
+
+                std::shared_ptr<DecodeWindow> m_decode_window;
+
+                // Line and column of the next chunk in the input
+                uint64_t m_line = 1;
+                uint64_t m_column = 0;
+
+                /**
+                 * A C++ wrapper for the Expat parser that makes sure no memory
+                 * is leaked.
+                 */
+                class ExpatXMLParser {
+
+                    XML_Parser m_parser;
+
+                    static void XMLCALL start_element_wrapper(void* data, const XML_Char* element, const XML_Char** attrs) {
+                        static_cast<XMLContentHandler*>(data)->start_element(element, attrs);
+                    }
+
+                    static void XMLCALL end_element_wrapper(void* data, const XML_Char* element) {
+                        static_cast<XMLContentHandler*>(data)->end_element(element);
+                    }
+
+                    static void XMLCALL character_data_wrapper(void* data, const XML_Char* text, int len) {
+                        static_cast<XMLContentHandler*>(data)->characters(text, len);
+                    }
+
+                    // This handler is called when there are any XML entities
+                    // declared in the OSM file. Entities are normally not used,
+                    // but they can be misused. See
+                    // https://en.wikipedia.org/wiki/Billion_laughs
+                    // The handler will just throw an error.
+                    static void entity_declaration_handler(void* /*userData*/,
+                            const XML_Char* /*entityName*/,
+                            int /*is_parameter_entity*/,
+                            const XML_Char* /*value*/,
+                            int /*value_length*/,
+                            const XML_Char* /*base*/,
+                            const XML_Char* /*systemId*/,
+                            const XML_Char* /*publicId*/,
+                            const XML_Char* /*notationName*/) {
+                        throw osmium::xml_error{"XML entities are not supported"};
+                    }
+
+                public:
+
+                    explicit ExpatXMLParser(void* callback_object) :
+                        m_parser(XML_ParserCreate(nullptr)) {
+                        if (!m_parser) {
+                            throw osmium::io_error{"Internal error: Can not create parser"};
+                        }
+                        XML_SetUserData(m_parser, callback_object);
+                        XML_SetElementHandler(m_parser, start_element_wrapper, end_element_wrapper);
+                        XML_SetCharacterDataHandler(m_parser, character_data_wrapper);
+                        XML_SetEntityDeclHandler(m_parser, entity_declaration_handler);
+                    }
+
+                    ExpatXMLParser(const ExpatXMLParser&) = delete;
+                    ExpatXMLParser& operator=(const ExpatXMLParser&) = delete;
+
+                    ExpatXMLParser(ExpatXMLParser&&) = delete;
+                    ExpatXMLParser& operator=(ExpatXMLParser&&) = delete;
+
+                    ~ExpatXMLParser() noexcept {
+                        XML_ParserFree(m_parser);
+                    }
+
+                    void operator()(const std::string& data, bool last) {
+                        assert(data.size() < std::numeric_limits<int>::max());
+                        if (XML_Parse(m_parser, data.data(), static_cast<int>(data.size()), last) == XML_STATUS_ERROR) {
+                            throw osmium::xml_error{m_parser};
+                        }
+                    }
+
+                }; // class ExpatXMLParser
+
+                void parse_with_expat(const std::string& initial_data) {
+                    ExpatXMLParser parser{&m_handler};
+
+                    if (!initial_data.empty()) {
+                        parser(initial_data, input_done());
+                    }
+
+                    while (!input_done()) {
+                        const std::string data{get_input()};
+                        parser(data, input_done());
+                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
+                            break;
+                        }
+                    }
+                }
+
+                void parse_with_tokenizer() {
+                    XMLTokenizer<XMLContentHandler> tokenizer{m_handler};
+
+                    while (!input_done()) {
+                        std::string data{get_input()};
+                        if (!tokenizer(std::move(data), input_done())) {
+                            parse_with_expat(tokenizer.buffered_data());
+                            return;
+                        }
+                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
+                            break;
+                        }
+                    }
+                }
+
+                void submit_chunk(std::string&& chunk,
+                                  const std::vector<std::string>& open_elements_at_start,
+                                  const std::vector<std::string>& open_elements_at_end) {
+                    const uint64_t line = m_line;
+                    const uint64_t column = m_column;
+                    advance_position(chunk);
+                    const std::size_t bytes = chunk.size();
+                    // Wait for space in the window before the chunk is
+                    // submitted, because the futures go into the output
+                    // queue in order.
+                    m_decode_window->add(bytes);
+                    submit_to_output_queue(XMLChunkParser{std::move(chunk), open_elements_at_start, open_elements_at_end, line, column, read_types(), prefilter(), read_buffers(), m_decode_window});
+                }
+
+                void advance_position(const std::string& data) noexcept {
+                    m_line += static_cast<uint64_t>(std::count(data.cbegin(), data.cend(), '\n'));
+                    const auto last_newline = data.rfind('\n');
+                    if (last_newline == std::string::npos) {
+                        m_column += data.size();
+                    } else {
+                        m_column = data.size() - last_newline - 1;
+                    }
+                }
+
+                // Everything up to the first split point is tokenized in
+                // this thread to get the header. The rest of the input is
+                // cut into chunks at the split points that are parsed in
+                // the thread pool.
+                void run_in_pool() {
+                    XMLTokenizer<XMLContentHandler> tokenizer{m_handler};
+                    XMLSplitter splitter;
+                    std::vector<std::string> open_elements_at_start;
+                    std::string data;
+                    std::size_t pos = 0;
+                    bool header_done = false;
+
+                    while (!input_done()) {
+                        if (data.empty()) {
+                            data = get_input();
+                        } else {
+                            data.append(get_input());
+                        }
+
+                        if (!header_done) {
+                            const auto split = splitter.find(data, pos, 0);
+                            if (split == std::string::npos) {
+                                continue;
+                            }
+                            std::string rest{data, split};
+                            data.resize(split);
+                            advance_position(data);
+                            if (!tokenizer(std::move(data), false)) {
+                                std::string all{std::move(tokenizer.buffered_data())};
+                                all.append(rest);
+                                parse_with_expat(all);
+                                return;
+                            }
+                            tokenizer.check_open_elements(splitter.open_elements());
+                            m_handler.mark_header_as_done();
+                            if (read_types() == osmium::osm_entity_bits::nothing) {
+                                return;
+                            }
+                            // The chunk parsers apply the prefilter.
+                            set_prefilter_applied();
+                            header_done = true;
+                            open_elements_at_start = splitter.open_elements();
+                            data = std::move(rest);
+                            pos = 0;
+                        }
+
+                        while (true) {
+                            const auto split = splitter.find(data, pos, chunk_size);
+                            if (split == std::string::npos) {
+                                break;
+                            }
+                            std::string rest{data, split};
+                            data.resize(split);
+                            submit_chunk(std::move(data), open_elements_at_start, splitter.open_elements());
+                            open_elements_at_start = splitter.open_elements();
+                            data = std::move(rest);
+                            pos = 0;
+                        }
+                    }
+
+                    if (!header_done) {
+                        // There are no objects in the input
+                        if (!data.empty() && !tokenizer(std::move(data), true)) {
+                            parse_with_expat(tokenizer.buffered_data());
+                        }
+                        return;
+                    }
+
+                    submit_chunk(std::move(data), open_elements_at_start, std::vector<std::string>{});
+                }
+
+            public:
+
+                enum : std::size_t {
+                    /// Minimum size of the chunks parsed in the thread pool.
+                    chunk_size = 1024ul * 1024ul
+                };
+
                 explicit XMLParser(parser_arguments& args) :
-                    Parser(args) {
+                    Parser(args),
+                    m_handler(read_types(),
+                              read_buffers(),
+                              [this](const osmium::io::Header& header) {
+                                  set_header_value(header);
+                              },
+                              [this](osmium::memory::Buffer&& buffer) {
+                                  send_to_output_queue(std::move(buffer));
+                              }),
+                    m_tokenizer(args.tokenizer),
+                    m_decode_window(args.tokenizer == osmium::io::xml_tokenizer::builtin ? make_decode_window() : nullptr) {
                 }
 
                 XMLParser(const XMLParser&) = delete;
@@ -728,20 +1773,18 @@ namespace osmium {
                 void run() final {
                     osmium::thread::set_thread_name("_osmium_xml_in");
 
-                    ExpatXMLParser parser{this};
-
-                    while (!input_done()) {
-                        const std::string data{get_input()};
-                        parser(data, input_done());
-                        if (read_types() == osmium::osm_entity_bits::nothing && header_is_done()) {
-                            break;
-                        }
+                    if (m_decode_window) {
+                        run_in_pool();
+                    } else if (m_tokenizer == osmium::io::xml_tokenizer::builtin) {
+                        parse_with_tokenizer();
+                    } else {
+                        parse_with_expat(std::string{});
                     }
 
-                    mark_header_as_done();
+                    m_handler.mark_header_as_done();
 
-                    if (m_buffer.committed() > 0) {
-                        send_to_output_queue(std::move(m_buffer));
+                    if (m_handler.buffer().committed() > 0) {
+                        send_to_output_queue(std::move(m_handler.buffer()));
                     }
                 }
 
@@ -58,7 +58,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
 
-#include <iterator>
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <utility>
@@ -92,16 +92,32 @@ namespace osmium {
 
             namespace detail {
 
+                inline char* copy_attribute_name(const char* name, char* out) noexcept {
+                    while (*name) {
+                        *out++ = *name++;
+                    }
+                    *out++ = '=';
+                    *out++ = '"';
+                    return out;
+                }
+
+                // Format both attributes into a temporary buffer and append
+                // them in one go.
                 inline void append_lat_lon_attributes(std::string& out, const char* lat, const char* lon, const osmium::Location& location) {
-                    out += ' ';
-                    out += lat;
-                    out += "=\"";
-                    osmium::detail::append_location_coordinate_to_string(std::back_inserter(out), location.y());
-                    out += "\" ";
-                    out += lon;
-                    out += "=\"";
-                    osmium::detail::append_location_coordinate_to_string(std::back_inserter(out), location.x());
-                    out += "\"";
+                    // Large enough for the attribute names (up to 7 chars
+                    // each) and two times "-214.7483648"
+                    char temp[64];
+                    char* t = temp;
+
+                    *t++ = ' ';
+                    t = copy_attribute_name(lat, t);
+                    t = osmium::detail::append_location_coordinate_to_string(t, location.y());
+                    *t++ = '"';
+                    *t++ = ' ';
+                    t = copy_attribute_name(lon, t);
+                    t = osmium::detail::append_location_coordinate_to_string(t, location.x());
+                    *t++ = '"';
+                    out.append(temp, t);
                 }
 
             } // namespace detail
@@ -120,10 +136,14 @@ namespace osmium {
 
                 xml_output_options m_options;
 
+                // Append a string literal without looking for its end.
+                template <std::size_t N>
+                void append(const char (&str)[N]) {
+                    m_out->append(str, N - 1);
+                }
+
                 void write_spaces(int num) {
-                    for (; num != 0; --num) {
-                        *m_out += ' ';
-                    }
+                    m_out->append(static_cast<std::size_t>(num), ' ');
                 }
 
                 int prefix_spaces() {
@@ -131,14 +151,18 @@ namespace osmium {
                 }
 
                 void write_prefix() {
-                    write_spaces(prefix_spaces());
+                    if (m_options.use_change_ops) {
+                        append("    ");
+                    } else {
+                        append("  ");
+                    }
                 }
 
-                template <typename T>
-                void write_attribute(const char* name, T value) {
+                template <std::size_t N, typename T>
+                void write_attribute(const char (&name)[N], T value) {
                     *m_out += ' ';
-                    *m_out += name;
-                    *m_out += "=\"";
+                    append(name);
+                    append("=\"");
                     output_int(value);
                     *m_out += '"';
                 }
@@ -151,9 +175,9 @@ namespace osmium {
                     }
 
                     if (m_options.add_metadata.timestamp() && object.timestamp()) {
-                        *m_out += " timestamp=\"";
-                        *m_out += object.timestamp().to_iso_all();
-                        *m_out += "\"";
+                        append(" timestamp=\"");
+                        output_timestamp(object.timestamp());
+                        append("\"");
                     }
 
                     if (m_options.add_metadata.uid() && object.uid()) {
@@ -161,9 +185,9 @@ namespace osmium {
                     }
 
                     if (m_options.add_metadata.user() && object.user()[0] != '\0') {
-                        *m_out += " user=\"";
+                        append(" user=\"");
                         append_xml_encoded_string(*m_out, object.user());
-                        *m_out += "\"";
+                        append("\"");
                     }
 
                     if (m_options.add_metadata.changeset() && object.changeset()) {
@@ -172,9 +196,9 @@ namespace osmium {
 
                     if (m_options.add_visible_flag) {
                         if (object.visible()) {
-                            *m_out += " visible=\"true\"";
+                            append(" visible=\"true\"");
                         } else {
-                            *m_out += " visible=\"false\"";
+                            append(" visible=\"false\"");
                         }
                     }
                 }
@@ -182,29 +206,29 @@ namespace osmium {
                 void write_tags(const osmium::TagList& tags, int spaces) {
                     for (const auto& tag : tags) {
                         write_spaces(spaces);
-                        *m_out += "  <tag k=\"";
+                        append("  <tag k=\"");
                         append_xml_encoded_string(*m_out, tag.key());
-                        *m_out += "\" v=\"";
+                        append("\" v=\"");
                         append_xml_encoded_string(*m_out, tag.value());
-                        *m_out += "\"/>\n";
+                        append("\"/>\n");
                     }
                 }
 
                 void write_discussion(const osmium::ChangesetDiscussion& comments) {
-                    *m_out += "  <discussion>\n";
+                    append("  <discussion>\n");
                     for (const auto& comment : comments) {
-                        *m_out += "   <comment";
+                        append("   <comment");
                         write_attribute("uid", comment.uid());
-                        *m_out += " user=\"";
+                        append(" user=\"");
                         append_xml_encoded_string(*m_out, comment.user());
-                        *m_out += "\" date=\"";
-                        *m_out += comment.date().to_iso_all();
-                        *m_out += "\">\n";
-                        *m_out += "    <text>";
+                        append("\" date=\"");
+                        output_timestamp(comment.date());
+                        append("\">\n");
+                        append("    <text>");
                         append_xml_encoded_string(*m_out, comment.text());
-                        *m_out += "</text>\n   </comment>\n";
+                        append("</text>\n   </comment>\n");
                     }
-                    *m_out += "  </discussion>\n";
+                    append("  </discussion>\n");
                 }
 
                 void open_close_op_tag(const operation op = operation::op_none) {
@@ -216,13 +240,13 @@ namespace osmium {
                         case operation::op_none:
                             break;
                         case operation::op_create:
-                            *m_out += "  </create>\n";
+                            append("  </create>\n");
                             break;
                         case operation::op_modify:
-                            *m_out += "  </modify>\n";
+                            append("  </modify>\n");
                             break;
                         case operation::op_delete:
-                            *m_out += "  </delete>\n";
+                            append("  </delete>\n");
                             break;
                     }
 
@@ -230,13 +254,13 @@ namespace osmium {
                         case operation::op_none:
                             break;
                         case operation::op_create:
-                            *m_out += "  <create>\n";
+                            append("  <create>\n");
                             break;
                         case operation::op_modify:
-                            *m_out += "  <modify>\n";
+                            append("  <modify>\n");
                             break;
                         case operation::op_delete:
-                            *m_out += "  <delete>\n";
+                            append("  <delete>\n");
                             break;
                     }
 
@@ -245,13 +269,18 @@ namespace osmium {
 
             public:
 
-                XMLOutputBlock(osmium::memory::Buffer&& buffer, const xml_output_options& options) :
-                    OutputBlock(std::move(buffer)),
+                template <typename TInput>
+                XMLOutputBlock(TInput&& input, const xml_output_options& options) :
+                    OutputBlock(std::forward<TInput>(input)),
                     m_options(options) {
                 }
 
                 std::string operator()() {
-                    osmium::apply(m_input_buffer->cbegin(), m_input_buffer->cend(), *this);
+                    // The XML is usually at least twice the size of the
+                    // objects in the buffer.
+                    m_out->reserve(2 * input_size());
+
+                    apply_input(*this);
 
                     if (m_options.use_change_ops) {
                         open_close_op_tag();
@@ -270,7 +299,7 @@ namespace osmium {
                     }
 
                     write_prefix();
-                    *m_out += "<node";
+                    append("<node");
 
                     write_meta(node);
 
@@ -279,16 +308,16 @@ namespace osmium {
                     }
 
                     if (node.tags().empty()) {
-                        *m_out += "/>\n";
+                        append("/>\n");
                         return;
                     }
 
-                    *m_out += ">\n";
+                    append(">\n");
 
                     write_tags(node.tags(), prefix_spaces());
 
                     write_prefix();
-                    *m_out += "</node>\n";
+                    append("</node>\n");
                 }
 
                 void way(const osmium::Way& way) {
@@ -297,39 +326,39 @@ namespace osmium {
                     }
 
                     write_prefix();
-                    *m_out += "<way";
+                    append("<way");
                     write_meta(way);
 
                     if (way.tags().empty() && way.nodes().empty()) {
-                        *m_out += "/>\n";
+                        append("/>\n");
                         return;
                     }
 
-                    *m_out += ">\n";
+                    append(">\n");
 
                     if (m_options.locations_on_ways) {
                         for (const auto& node_ref : way.nodes()) {
                             write_prefix();
-                            *m_out += "  <nd";
+                            append("  <nd");
                             write_attribute("ref", node_ref.ref());
                             if (node_ref.location()) {
                                 detail::append_lat_lon_attributes(*m_out, "lat", "lon", node_ref.location());
                             }
-                            *m_out += "/>\n";
+                            append("/>\n");
                         }
                     } else {
                         for (const auto& node_ref : way.nodes()) {
                             write_prefix();
-                            *m_out += "  <nd";
+                            append("  <nd");
                             write_attribute("ref", node_ref.ref());
-                            *m_out += "/>\n";
+                            append("/>\n");
                         }
                     }
 
                     write_tags(way.tags(), prefix_spaces());
 
                     write_prefix();
-                    *m_out += "</way>\n";
+                    append("</way>\n");
                 }
 
                 void relation(const osmium::Relation& relation) {
@@ -338,54 +367,54 @@ namespace osmium {
                     }
 
                     write_prefix();
-                    *m_out += "<relation";
+                    append("<relation");
                     write_meta(relation);
 
                     if (relation.tags().empty() && relation.members().empty()) {
-                        *m_out += "/>\n";
+                        append("/>\n");
                         return;
                     }
 
-                    *m_out += ">\n";
+                    append(">\n");
 
                     for (const auto& member : relation.members()) {
                         write_prefix();
-                        *m_out += "  <member type=\"";
+                        append("  <member type=\"");
                         *m_out += item_type_to_name(member.type());
                         *m_out += '"';
                         write_attribute("ref", member.ref());
-                        *m_out += " role=\"";
+                        append(" role=\"");
                         append_xml_encoded_string(*m_out, member.role());
-                        *m_out += "\"/>\n";
+                        append("\"/>\n");
                     }
 
                     write_tags(relation.tags(), prefix_spaces());
 
                     write_prefix();
-                    *m_out += "</relation>\n";
+                    append("</relation>\n");
                 }
 
                 void changeset(const osmium::Changeset& changeset) {
-                    *m_out += " <changeset";
+                    append(" <changeset");
 
                     write_attribute("id", changeset.id());
 
                     if (changeset.created_at()) {
-                        *m_out += " created_at=\"";
-                        *m_out += changeset.created_at().to_iso();
-                        *m_out += "\"";
+                        append(" created_at=\"");
+                        output_timestamp(changeset.created_at());
+                        append("\"");
                     }
 
                     if (changeset.closed_at()) {
-                        *m_out += " closed_at=\"";
-                        *m_out += changeset.closed_at().to_iso();
-                        *m_out += "\" open=\"false\"";
+                        append(" closed_at=\"");
+                        output_timestamp(changeset.closed_at());
+                        append("\" open=\"false\"");
                     } else {
-                        *m_out += " open=\"true\"";
+                        append(" open=\"true\"");
                     }
 
                     if (!changeset.user_is_anonymous()) {
-                        *m_out += " user=\"";
+                        append(" user=\"");
                         append_xml_encoded_string(*m_out, changeset.user());
                         *m_out += '"';
                         write_attribute("uid", changeset.uid());
@@ -403,11 +432,11 @@ namespace osmium {
                     // If there are no tags and no comments, we can close the
                     // tag right here and are done.
                     if (changeset.tags().empty() && changeset.discussion().empty()) {
-                        *m_out += "/>\n";
+                        append("/>\n");
                         return;
                     }
 
-                    *m_out += ">\n";
+                    append(">\n");
 
                     write_tags(changeset.tags(), 0);
 
@@ -415,7 +444,7 @@ namespace osmium {
                         write_discussion(changeset.discussion());
                     }
 
-                    *m_out += " </changeset>\n";
+                    append(" </changeset>\n");
                 }
 
             }; // class XMLOutputBlock
@@ -464,7 +493,11 @@ namespace osmium {
                 }
 
                 void write_buffer(osmium::memory::Buffer&& buffer) final {
-                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options}));
+                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(buffer), m_options}, osmium::thread::task_priority::high));
+                }
+
+                void write_selection(osmium::memory::BufferSelection&& selection) final {
+                    m_output_queue.push(m_pool.submit(XMLOutputBlock{std::move(selection), m_options}, osmium::thread::task_priority::high));
                 }
 
                 void write_end() final {
@@ -45,8 +45,14 @@ DEALINGS IN THE SOFTWARE.
 
 #include <zlib.h>
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+# include <libdeflate.h>
+#endif
+
 #include <cassert>
+#include <cstddef>
 #include <limits>
+#include <memory>
 #include <string>
 
 namespace osmium {
@@ -55,31 +61,96 @@ namespace osmium {
 
         namespace detail {
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+            struct libdeflate_compressor_deleter {
+                void operator()(::libdeflate_compressor* compressor) const noexcept {
+                    ::libdeflate_free_compressor(compressor);
+                }
+            };
+
+            struct libdeflate_decompressor_deleter {
+                void operator()(::libdeflate_decompressor* decompressor) const noexcept {
+                    ::libdeflate_free_decompressor(decompressor);
+                }
+            };
+
             /**
-             * Compress data using zlib.
+             * Get the libdeflate compressor for the given level for this
+             * thread. The compressor is kept around for the next call.
+             */
+            inline ::libdeflate_compressor* thread_libdeflate_compressor(int level) {
+                static thread_local std::unique_ptr<::libdeflate_compressor, libdeflate_compressor_deleter> compressor;
+                static thread_local int compressor_level = -2;
+
+                if (!compressor || compressor_level != level) {
+                    compressor.reset(::libdeflate_alloc_compressor(level == Z_DEFAULT_COMPRESSION ? 6 : level));
+                    if (!compressor) {
+                        throw io_error{"failed to allocate libdeflate compressor"};
+                    }
+                    compressor_level = level;
+                }
+
+                return compressor.get();
+            }
+
+            inline ::libdeflate_decompressor* thread_libdeflate_decompressor() {
+                static thread_local std::unique_ptr<::libdeflate_decompressor, libdeflate_decompressor_deleter> decompressor{::libdeflate_alloc_decompressor()};
+
+                if (!decompressor) {
+                    throw io_error{"failed to allocate libdeflate decompressor"};
+                }
+
+                return decompressor.get();
+            }
+#endif
+
+            /**
+             * Compress data using zlib. If OSMIUM_WITH_LIBDEFLATE is
+             * defined, the libdeflate library is used instead which creates
+             * the same format but is faster.
              *
              * Note that this function can not compress data larger than
              * what fits in an unsigned long, on Windows this is usually 32bit.
              *
              * @param input Data to compress.
+             * @param level Compression level (0 to 9, or Z_DEFAULT_COMPRESSION).
              * @returns Compressed data.
              */
-            inline std::string zlib_compress(const std::string& input) {
+            inline std::string zlib_compress(const std::string& input, int level = Z_DEFAULT_COMPRESSION) {
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                auto* compressor = thread_libdeflate_compressor(level);
+
+                std::string output(::libdeflate_zlib_compress_bound(compressor, input.size()), '\0');
+
+                const std::size_t output_size = ::libdeflate_zlib_compress(
+                    compressor,
+                    input.data(),
+                    input.size(),
+                    &*output.begin(),
+                    output.size()
+                );
+
+                if (output_size == 0) {
+                    throw io_error{"failed to compress data"};
+                }
+#else
                 assert(input.size() < std::numeric_limits<unsigned long>::max());
                 unsigned long output_size = ::compressBound(static_cast<unsigned long>(input.size())); // NOLINT(google-runtime-int)
 
                 std::string output(output_size, '\0');
 
-                const auto result = ::compress(
+                const auto result = ::compress2(
                     reinterpret_cast<unsigned char*>(&*output.begin()),
                     &output_size,
                     reinterpret_cast<const unsigned char*>(input.data()),
-                    static_cast<unsigned long>(input.size()) // NOLINT(google-runtime-int)
+                    static_cast<unsigned long>(input.size()), // NOLINT(google-runtime-int)
+                    level
                 );
 
                 if (result != Z_OK) {
                     throw io_error{std::string{"failed to compress data: "} + zError(result)};
                 }
+#endif
 
                 output.resize(output_size);
 
@@ -100,6 +171,21 @@ namespace osmium {
             inline protozero::data_view zlib_uncompress_string(const char* input, unsigned long input_size, unsigned long raw_size, std::string& output) { // NOLINT(google-runtime-int)
                 output.resize(raw_size);
 
+#ifdef OSMIUM_WITH_LIBDEFLATE
+                std::size_t actual_size = 0;
+                const auto result = ::libdeflate_zlib_decompress(
+                    thread_libdeflate_decompressor(),
+                    input,
+                    input_size,
+                    &*output.begin(),
+                    raw_size,
+                    &actual_size
+                );
+
+                if (result != LIBDEFLATE_SUCCESS || actual_size != raw_size) {
+                    throw io_error{"failed to uncompress data"};
+                }
+#else
                 const auto result = ::uncompress(
                     reinterpret_cast<unsigned char*>(&*output.begin()),
                     &raw_size,
@@ -110,6 +196,47 @@ namespace osmium {
                 if (result != Z_OK) {
                     throw io_error{std::string{"failed to uncompress data: "} + zError(result)};
                 }
+#endif
+
+                return protozero::data_view{output.data(), output.size()};
+            }
+
+            /**
+             * Uncompress only the beginning of some data compressed using
+             * zlib. This is much cheaper than uncompressing everything if
+             * only the first few bytes are needed.
+             *
+             * @param input Compressed input data.
+             * @param prefix_size Number of bytes of uncompressed data wanted.
+             * @param output Uncompressed result data.
+             * @returns Pointer and size to uncompressed data. The size can
+             *          be smaller than prefix_size if there isn't that
+             *          much data.
+             */
+            inline protozero::data_view zlib_uncompress_prefix(const char* input, unsigned long input_size, unsigned long prefix_size, std::string& output) { // NOLINT(google-runtime-int)
+                assert(input_size < std::numeric_limits<unsigned int>::max());
+                assert(prefix_size < std::numeric_limits<unsigned int>::max());
+                output.resize(prefix_size);
+
+                z_stream stream{};
+                stream.next_in = const_cast<unsigned char*>(reinterpret_cast<const unsigned char*>(input)); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+                stream.avail_in = static_cast<unsigned int>(input_size);
+                stream.next_out = reinterpret_cast<unsigned char*>(&*output.begin());
+                stream.avail_out = static_cast<unsigned int>(prefix_size);
+
+                auto result = ::inflateInit(&stream);
+                if (result != Z_OK) {
+                    throw io_error{std::string{"failed to uncompress data: "} + zError(result)};
+                }
+
+                result = ::inflate(&stream, Z_SYNC_FLUSH);
+                ::inflateEnd(&stream);
+
+                if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+                    throw io_error{std::string{"failed to uncompress data: "} + zError(result)};
+                }
+
+                output.resize(prefix_size - stream.avail_out);
 
                 return protozero::data_view{output.data(), output.size()};
             }
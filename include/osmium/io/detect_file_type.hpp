@@ -0,0 +1,237 @@
+#ifndef OSMIUM_IO_DETECT_FILE_TYPE_HPP
+#define OSMIUM_IO_DETECT_FILE_TYPE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_compression.hpp>
+#include <osmium/io/file_format.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * File format and compression detected from the contents of a
+         * file. See detect_file_type().
+         */
+        struct detected_file_type {
+            file_format format = file_format::unknown;
+            file_compression compression = file_compression::none;
+        };
+
+        namespace detail {
+
+            inline bool starts_with(const char* data, std::size_t size, const char* prefix) noexcept {
+                const auto len = std::strlen(prefix);
+                return size >= len && std::memcmp(data, prefix, len) == 0;
+            }
+
+            // The first BlobHeader of a PBF file: Its 4 byte size in
+            // network byte order followed by the type field, which is
+            // "OSMHeader" (or "OSMData" for files without header).
+            inline bool looks_like_pbf(const char* data, std::size_t size) noexcept {
+                if (size < 8) {
+                    return false;
+                }
+                const auto* d = reinterpret_cast<const unsigned char*>(data);
+                const uint32_t header_size = (uint32_t(d[0]) << 24U) | (uint32_t(d[1]) << 16U) | (uint32_t(d[2]) << 8U) | uint32_t(d[3]);
+                if (header_size == 0 || header_size > 64U * 1024U || d[4] != 0x0a) {
+                    return false;
+                }
+                return starts_with(data + 5, size - 5, "\x09OSMHeader") ||
+                       starts_with(data + 5, size - 5, "\x07OSMData");
+            }
+
+            // An o5m or o5c file starts with a reset byte followed by the
+            // header dataset.
+            inline bool looks_like_o5m(const char* data, std::size_t size) noexcept {
+                return starts_with(data, size, "\xff\xe0\x04o5m2") ||
+                       starts_with(data, size, "\xff\xe0\x04o5c2");
+            }
+
+            inline bool looks_like_xml(const char* data, std::size_t size) noexcept {
+                const char* end = data + size;
+                if (starts_with(data, size, "\xef\xbb\xbf")) { // UTF-8 BOM
+                    data += 3;
+                }
+                while (data != end && (*data == ' ' || *data == '\t' || *data == '\r' || *data == '\n')) {
+                    ++data;
+                }
+                const auto rest = static_cast<std::size_t>(end - data);
+                return starts_with(data, rest, "<?xml") ||
+                       starts_with(data, rest, "<osm") ||
+                       starts_with(data, rest, "<!--");
+            }
+
+            // The first line which is not empty or a comment must start
+            // with an object type and an id: "n123 ...", "w-5 ...".
+            inline bool looks_like_opl(const char* data, std::size_t size) noexcept {
+                const char* end = data + size;
+                while (data != end && (*data == '\n' || *data == '#')) {
+                    if (*data == '#') {
+                        data = static_cast<const char*>(std::memchr(data, '\n', static_cast<std::size_t>(end - data)));
+                        if (!data) {
+                            return false;
+                        }
+                    }
+                    ++data;
+                }
+                if (data == end || std::strchr("nwrc", *data) == nullptr || *data == '\0') {
+                    return false;
+                }
+                ++data;
+                if (data != end && *data == '-') {
+                    ++data;
+                }
+                const char* digits = data;
+                while (data != end && *data >= '0' && *data <= '9') {
+                    ++data;
+                }
+                if (data == digits) {
+                    return false;
+                }
+                return data == end || *data == ' ' || *data == '\n' || *data == '\r';
+            }
+
+        } // namespace detail
+
+        /**
+         * Number of bytes read from the start of a file by
+         * detect_file_type().
+         */
+        enum : std::size_t {
+            detect_file_type_probe_size = 512
+        };
+
+        /**
+         * Detect the file format and compression from the first bytes of
+         * a file. This recognizes gzip and bzip2 compression, the PBF
+         * BlobHeader, the o5m header, the osmbuf file magic, the start of
+         * an XML document, and the shape of the first line of an OPL file.
+         *
+         * For compressed data only the compression is detected, the
+         * format can not be seen without decompressing the data.
+         *
+         * @param data Pointer to the start of the file contents.
+         * @param size Number of bytes available. Around
+         *             detect_file_type_probe_size are enough.
+         * @returns The detected format and compression. The format is
+         *          file_format::unknown if nothing was recognized.
+         */
+        inline detected_file_type detect_file_type(const char* data, std::size_t size) noexcept {
+            detected_file_type result;
+
+            if (detail::starts_with(data, size, "\x1f\x8b")) {
+                result.compression = file_compression::gzip;
+            } else if (size >= 4 && detail::starts_with(data, size, "BZh") && data[3] >= '1' && data[3] <= '9') {
+                result.compression = file_compression::bzip2;
+            } else if (detail::starts_with(data, size, "OSMIUMBF")) {
+                result.format = file_format::osmbuf;
+            } else if (detail::looks_like_pbf(data, size)) {
+                result.format = file_format::pbf;
+            } else if (detail::looks_like_o5m(data, size)) {
+                result.format = file_format::o5m;
+            } else if (detail::looks_like_xml(data, size)) {
+                result.format = file_format::xml;
+            } else if (detail::looks_like_opl(data, size)) {
+                result.format = file_format::opl;
+            }
+
+            return result;
+        }
+
+        /**
+         * Detect the file format and compression of a file from its
+         * contents. Only the first detect_file_type_probe_size bytes are
+         * read with a single pread(2), the file offset is not changed. No
+         * Reader, threads, or decompressors are involved, so this is
+         * cheap enough to be called for every file before it is opened.
+         *
+         * @param filename Name of the file. Must be a regular file, this
+         *                 doesn't work for stdin.
+         * @returns The detected format and compression.
+         * @throws std::system_error If the file could not be opened or read.
+         */
+        inline detected_file_type detect_file_type(const std::string& filename) {
+            char data[detect_file_type_probe_size];
+            const int fd = detail::open_for_reading(filename);
+            int64_t size = 0;
+            try {
+                size = detail::reliable_pread(fd, data, sizeof(data), 0);
+            } catch (...) {
+                detail::reliable_close(fd);
+                throw;
+            }
+            detail::reliable_close(fd);
+            return detect_file_type(data, static_cast<std::size_t>(size));
+        }
+
+        /**
+         * Detect the file format and compression of the file or buffer
+         * referenced by the File from its contents and set them in the
+         * File. If the contents are compressed, only the compression is
+         * changed and the format is kept. If nothing was detected, the
+         * File is not changed.
+         *
+         * @param file The File to update.
+         * @returns True if the format or compression was detected.
+         * @throws std::system_error If the file could not be opened or read.
+         */
+        inline bool set_file_type_from_content(osmium::io::File& file) {
+            const detected_file_type type = file.buffer() ? detect_file_type(file.buffer(), file.buffer_size())
+                                                          : detect_file_type(file.filename());
+            if (type.compression != file_compression::none) {
+                file.set_compression(type.compression);
+                return true;
+            }
+            if (type.format != file_format::unknown) {
+                file.set_format(type.format);
+                file.set_compression(file_compression::none);
+                return true;
+            }
+            return false;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_DETECT_FILE_TYPE_HPP
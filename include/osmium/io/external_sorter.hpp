@@ -0,0 +1,418 @@
+#ifndef OSMIUM_IO_EXTERNAL_SORTER_HPP
+#define OSMIUM_IO_EXTERNAL_SORTER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item_iterator.hpp>
+#include <osmium/object_pointer_collection.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+# include <unistd.h>
+#else
+# include <io.h>
+#endif
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * A sorted run written to a temporary file. The file contains
+             * blocks, each an 8 byte size followed by the committed
+             * contents of a Buffer in the native memory layout.
+             */
+            class sort_run {
+
+                int m_fd;
+
+                std::future<osmium::memory::Buffer> m_next{};
+
+                osmium::memory::Buffer m_buffer{};
+                osmium::memory::ItemIterator<osmium::OSMObject> m_it{};
+
+                static void read_exactly(int fd, char* data, std::size_t size) {
+                    while (size > 0) {
+                        const auto chunk = static_cast<unsigned int>(std::min(size, static_cast<std::size_t>(1024UL * 1024UL * 1024UL)));
+                        const auto nread = reliable_read(fd, data, chunk);
+                        if (nread <= 0) {
+                            throw osmium::io_error{"external sort: temporary file truncated"};
+                        }
+                        data += nread;
+                        size -= static_cast<std::size_t>(nread);
+                    }
+                }
+
+                // Returns an invalid buffer at the end of the file.
+                static osmium::memory::Buffer read_block(int fd) {
+                    uint64_t size = 0;
+                    const auto nread = reliable_read(fd, reinterpret_cast<char*>(&size), sizeof(size));
+                    if (nread == 0) {
+                        return osmium::memory::Buffer{};
+                    }
+                    if (nread != sizeof(size)) {
+                        read_exactly(fd, reinterpret_cast<char*>(&size) + nread, sizeof(size) - static_cast<std::size_t>(nread));
+                    }
+                    const auto block_size = static_cast<std::size_t>(size);
+                    std::unique_ptr<unsigned char[]> data{new unsigned char[block_size]};
+                    read_exactly(fd, reinterpret_cast<char*>(data.get()), block_size);
+                    return osmium::memory::Buffer{std::move(data), block_size, block_size};
+                }
+
+                void prefetch() {
+                    const int fd = m_fd;
+                    m_next = osmium::thread::Pool::default_instance().submit([fd]() {
+                        return read_block(fd);
+                    });
+                }
+
+            public:
+
+                explicit sort_run(int fd) noexcept :
+                    m_fd(fd) {
+                }
+
+                sort_run(const sort_run&) = delete;
+                sort_run& operator=(const sort_run&) = delete;
+
+                sort_run(sort_run&& other) noexcept :
+                    m_fd(other.m_fd),
+                    m_next(std::move(other.m_next)),
+                    m_buffer(std::move(other.m_buffer)),
+                    m_it(other.m_it) {
+                    other.m_fd = -1;
+                }
+
+                sort_run& operator=(sort_run&&) = delete;
+
+                ~sort_run() noexcept {
+                    try {
+                        if (m_next.valid()) {
+                            m_next.wait();
+                        }
+                        reliable_close(m_fd);
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+
+                /// Append a block to the file.
+                void write_block(const osmium::memory::Buffer& buffer) {
+                    const auto size = static_cast<uint64_t>(buffer.committed());
+                    reliable_write(m_fd, reinterpret_cast<const char*>(&size), sizeof(size));
+                    reliable_write(m_fd, buffer.data(), buffer.committed());
+                }
+
+                /**
+                 * Rewind the file and read the first block. Further blocks
+                 * are always read in the background while the current one
+                 * is merged.
+                 */
+                void start_reading() {
+#ifdef _MSC_VER
+                    const auto offset = _lseeki64(m_fd, 0, SEEK_SET);
+#else
+                    const auto offset = ::lseek(m_fd, 0, SEEK_SET);
+#endif
+                    if (offset != 0) {
+                        throw std::system_error{errno, std::system_category(), "lseek failed"};
+                    }
+                    prefetch();
+                    next_block();
+                }
+
+                bool next_block() {
+                    while (true) {
+                        m_buffer = m_next.get();
+                        if (!m_buffer) {
+                            m_it = osmium::memory::ItemIterator<osmium::OSMObject>{};
+                            return false;
+                        }
+                        prefetch();
+                        m_it = m_buffer.begin<osmium::OSMObject>();
+                        if (m_it != m_buffer.end<osmium::OSMObject>()) {
+                            return true;
+                        }
+                    }
+                }
+
+                bool empty() const noexcept {
+                    return !m_buffer;
+                }
+
+                const osmium::OSMObject& object() const noexcept {
+                    return *m_it;
+                }
+
+                void advance() {
+                    ++m_it;
+                    if (m_it == m_buffer.end<osmium::OSMObject>()) {
+                        next_block();
+                    }
+                }
+
+            }; // class sort_run
+
+        } // namespace detail
+
+        /**
+         * Sorts OSM objects that don't fit into memory. Add buffers with
+         * the objects using operator() (for instance from a Reader). When
+         * the buffers kept in memory reach the memory limit, the objects
+         * in them are sorted and written to a temporary file as a sorted
+         * run. The output() function then merges all runs and hands the
+         * objects in order to a callback in buffers, which can be a Writer.
+         *
+         * @code
+         * osmium::io::ExternalSorter<> sorter{8UL * 1024 * 1024 * 1024};
+         * osmium::io::Reader reader{input_file};
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     sorter(std::move(buffer));
+         * }
+         * reader.close();
+         * osmium::io::Writer writer{output_file, header};
+         * sorter.output(writer);
+         * writer.close();
+         * @endcode
+         *
+         * Only OSM objects (nodes, ways, relations, and areas) are sorted,
+         * any other items (such as changesets) are dropped. Every run
+         * needs an open file descriptor while merging.
+         *
+         * Memory use is about the memory limit plus the sort keys while
+         * sorting a run, and two blocks per run while merging.
+         *
+         * @tparam TCompare Comparison functor for OSM object pointers,
+         *         see osm/object_comparisons.hpp.
+         */
+        template <typename TCompare = osmium::object_order_type_id_version>
+        class ExternalSorter {
+
+            std::vector<osmium::memory::Buffer> m_buffers{};
+            std::vector<detail::sort_run> m_runs{};
+            std::string m_tmp_dir;
+            TCompare m_compare;
+            std::size_t m_memory_limit;
+            std::size_t m_block_size;
+            std::size_t m_memory_used = 0;
+
+            // Copy the object into the buffer. If it doesn't fit, the
+            // buffer is handed to the callback first.
+            template <typename TFunc>
+            void add_to_output(osmium::memory::Buffer& buffer, const osmium::OSMObject& object, TFunc&& func) {
+                if (buffer.committed() > 0 && buffer.capacity() - buffer.committed() < object.padded_size()) {
+                    osmium::memory::Buffer full{m_block_size, osmium::memory::Buffer::auto_grow::yes};
+                    using std::swap;
+                    swap(full, buffer);
+                    std::forward<TFunc>(func)(std::move(full));
+                }
+                buffer.push_back(object);
+            }
+
+            // Sort the objects from all buffers in memory and hand them to
+            // the function in buffers.
+            template <typename TFunc>
+            void sort_in_memory(TFunc&& func) {
+                osmium::ObjectPointerCollection collection;
+                for (auto& buffer : m_buffers) {
+                    osmium::apply(buffer, collection);
+                }
+                collection.sort(m_compare);
+
+                osmium::memory::Buffer output{m_block_size, osmium::memory::Buffer::auto_grow::yes};
+                for (const auto& object : collection) {
+                    add_to_output(output, object, func);
+                }
+                if (output.committed() > 0) {
+                    std::forward<TFunc>(func)(std::move(output));
+                }
+
+                m_buffers.clear();
+                m_memory_used = 0;
+            }
+
+            void write_run() {
+                m_runs.emplace_back(osmium::detail::create_tmp_file(m_tmp_dir));
+                auto& run = m_runs.back();
+                sort_in_memory([&run](osmium::memory::Buffer&& buffer) {
+                    run.write_block(buffer);
+                });
+            }
+
+            template <typename TFunc>
+            void merge_runs(TFunc&& func) {
+                if (!m_buffers.empty()) {
+                    write_run();
+                }
+
+                for (auto& run : m_runs) {
+                    run.start_reading();
+                }
+
+                // Min-heap of run numbers by their current objects. Equal
+                // objects come from the earlier run first.
+                const auto greater = [this](std::size_t a, std::size_t b) {
+                    const auto& oa = m_runs[a].object();
+                    const auto& ob = m_runs[b].object();
+                    if (m_compare(&ob, &oa)) {
+                        return true;
+                    }
+                    if (m_compare(&oa, &ob)) {
+                        return false;
+                    }
+                    return a > b;
+                };
+
+                std::vector<std::size_t> heap;
+                for (std::size_t n = 0; n < m_runs.size(); ++n) {
+                    if (!m_runs[n].empty()) {
+                        heap.push_back(n);
+                    }
+                }
+                std::make_heap(heap.begin(), heap.end(), greater);
+
+                osmium::memory::Buffer output{m_block_size, osmium::memory::Buffer::auto_grow::yes};
+                while (!heap.empty()) {
+                    std::pop_heap(heap.begin(), heap.end(), greater);
+                    auto& run = m_runs[heap.back()];
+                    add_to_output(output, run.object(), func);
+                    run.advance();
+                    if (run.empty()) {
+                        heap.pop_back();
+                    } else {
+                        std::push_heap(heap.begin(), heap.end(), greater);
+                    }
+                }
+                if (output.committed() > 0) {
+                    std::forward<TFunc>(func)(std::move(output));
+                }
+
+                m_runs.clear();
+            }
+
+        public:
+
+            enum : std::size_t {
+                default_block_size = 1024UL * 1024UL
+            };
+
+            /**
+             * Create sorter.
+             *
+             * @param memory_limit Write a sorted run to disk when the
+             *                     buffers kept in memory are this large.
+             * @param compare Comparison functor.
+             * @param tmp_dir Directory for the temporary files. If this is
+             *                empty, the system default is used.
+             * @param block_size Size of the blocks in the temporary files
+             *                   and of the output buffers.
+             */
+            explicit ExternalSorter(std::size_t memory_limit,
+                                    TCompare compare = TCompare{},
+                                    std::string tmp_dir = "",
+                                    std::size_t block_size = default_block_size) :
+                m_tmp_dir(std::move(tmp_dir)),
+                m_compare(std::move(compare)),
+                m_memory_limit(memory_limit),
+                m_block_size(block_size) {
+            }
+
+            /**
+             * Add a buffer with OSM objects. The sorter takes ownership of
+             * the buffer.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                m_memory_used += buffer.capacity();
+                m_buffers.push_back(std::move(buffer));
+                if (m_memory_used >= m_memory_limit) {
+                    write_run();
+                }
+            }
+
+            /// The number of sorted runs written to disk so far.
+            std::size_t num_runs() const noexcept {
+                return m_runs.size();
+            }
+
+            /// The number of bytes in buffers currently kept in memory.
+            std::size_t memory_used() const noexcept {
+                return m_memory_used;
+            }
+
+            /**
+             * Hand all objects added so far to the function in sorted
+             * order. The function is called with buffers (rvalue
+             * references), so a Writer can be used here. If all objects
+             * fit into memory they are sorted there, otherwise all runs
+             * are merged, reading ahead in the thread pool. Afterwards
+             * the sorter is empty and can be used again.
+             *
+             * @throws osmium::io_error or std::system_error if there was a
+             *         problem with the temporary files.
+             */
+            template <typename TFunc>
+            void output(TFunc&& func) {
+                if (m_runs.empty()) {
+                    sort_in_memory(std::forward<TFunc>(func));
+                } else {
+                    merge_runs(std::forward<TFunc>(func));
+                }
+            }
+
+        }; // class ExternalSorter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_EXTERNAL_SORTER_HPP
@@ -0,0 +1,310 @@
+#ifndef OSMIUM_IO_FANOUT_WRITER_HPP
+#define OSMIUM_IO_FANOUT_WRITER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/file.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_selection.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            // Keeps track of the number of bytes in input buffers which
+            // are still used by selections that have not been encoded.
+            class fanout_memory {
+
+                std::mutex m_mutex{};
+                std::condition_variable m_released{};
+                std::size_t m_bytes = 0;
+
+            public:
+
+                // Wait until there is room for this many bytes. A single
+                // buffer is always allowed even if it is larger than the
+                // maximum.
+                void acquire(std::size_t bytes, std::size_t max_bytes) {
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_released.wait(lock, [&] {
+                        return m_bytes == 0 || m_bytes + bytes <= max_bytes;
+                    });
+                    m_bytes += bytes;
+                }
+
+                void release(std::size_t bytes) {
+                    {
+                        std::lock_guard<std::mutex> lock{m_mutex};
+                        m_bytes -= bytes;
+                    }
+                    m_released.notify_all();
+                }
+
+                std::size_t bytes() {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_bytes;
+                }
+
+            }; // class fanout_memory
+
+        } // namespace detail
+
+        /**
+         * Writes the objects from one stream of buffers into any number of
+         * output files, each with its own filter. This is used to create
+         * many extracts (or other subsets) of a file reading and decoding
+         * it only once.
+         *
+         * The objects are not copied. For each input buffer and output
+         * file a BufferSelection with the objects matching the filter of
+         * that output is handed to its Writer. All Writers share the same
+         * thread pool for encoding (and compression if enabled) and an
+         * IOExecutor with a fixed number of threads for writing the files.
+         *
+         * Input buffers are kept until all selections referring to them
+         * are encoded. The combined size of these buffers is limited:
+         * When the limit is reached, operator() waits until enough of them
+         * are released. The encoded data waiting to be written is limited
+         * by the output queue size of each Writer.
+         *
+         * The filters are called in the thread calling operator(), for
+         * every object once per output file, in the order of the objects
+         * in the input. So they can keep state, for instance the IDs of
+         * the nodes matched so far to find the ways using them. Only OSM
+         * objects (nodes, ways, and relations) are written.
+         *
+         * @code
+         * osmium::io::FanoutWriter fanout{header, pool};
+         * fanout.add(osmium::io::File{"restaurants.osm.pbf"}, [&](const osmium::OSMObject& object) {
+         *     return osmium::tags::match_any_of(object.tags(), restaurant_filter);
+         * });
+         * fanout.add(osmium::io::File{"north.osm.pbf"}, [&](const osmium::OSMObject& object) {
+         *     return object.type() == osmium::item_type::node &&
+         *            index.contains(north, static_cast<const osmium::Node&>(object).location());
+         * });
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     fanout(std::move(buffer));
+         * }
+         * fanout.close();
+         * @endcode
+         */
+        class FanoutWriter {
+
+        public:
+
+            using filter_type = std::function<bool(const osmium::OSMObject&)>;
+
+            enum : std::size_t {
+                default_max_memory = 256UL * 1024UL * 1024UL
+            };
+
+        private:
+
+            struct destination {
+                std::unique_ptr<osmium::io::Writer> writer;
+                filter_type filter;
+            };
+
+            osmium::io::Header m_header;
+            osmium::thread::Pool* m_pool;
+            std::size_t m_max_memory;
+            std::shared_ptr<detail::fanout_memory> m_memory;
+
+            // The executor must outlive the writers using it.
+            osmium::io::IOExecutor m_executor;
+            std::vector<destination> m_destinations{};
+
+            bool m_closed = false;
+
+        public:
+
+            /**
+             * Create a FanoutWriter without any outputs. Use add() to add
+             * them.
+             *
+             * @param header Header written to all output files.
+             * @param pool Thread pool used for encoding by all Writers.
+             * @param max_memory Maximum combined size of the input buffers
+             *                   still waiting to be encoded.
+             * @param io_threads Number of threads writing the files.
+             */
+            explicit FanoutWriter(const osmium::io::Header& header,
+                                  osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                                  std::size_t max_memory = default_max_memory,
+                                  int io_threads = 2) :
+                m_header(header),
+                m_pool(&pool),
+                m_max_memory(max_memory),
+                m_memory(std::make_shared<detail::fanout_memory>()),
+                m_executor(io_threads) {
+            }
+
+            FanoutWriter(const FanoutWriter&) = delete;
+            FanoutWriter& operator=(const FanoutWriter&) = delete;
+
+            FanoutWriter(FanoutWriter&&) = delete;
+            FanoutWriter& operator=(FanoutWriter&&) = delete;
+
+            ~FanoutWriter() noexcept {
+                for (auto& d : m_destinations) {
+                    try {
+                        d.writer->close();
+                    } catch (...) { // NOLINT(bugprone-empty-catch)
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+            }
+
+            /**
+             * Add an output file. The header is written immediately.
+             *
+             * @param file The output file.
+             * @param filter Only objects for which this returns true are
+             *               written. If it is empty, all objects are.
+             * @param allow_overwrite Allow overwriting an existing file?
+             * @returns The index of this output (counting from 0).
+             * @throws Everything the Writer constructor throws.
+             */
+            std::size_t add(const osmium::io::File& file, filter_type filter = filter_type{}, overwrite allow_overwrite = overwrite::no) {
+                std::unique_ptr<osmium::io::Writer> writer{new osmium::io::Writer{file, m_header, allow_overwrite, *m_pool, m_executor}};
+                m_destinations.push_back(destination{std::move(writer), std::move(filter)});
+                return m_destinations.size() - 1;
+            }
+
+            /// The number of output files.
+            std::size_t size() const noexcept {
+                return m_destinations.size();
+            }
+
+            /// The Writer of the output with the specified index.
+            osmium::io::Writer& writer(std::size_t index) {
+                return *m_destinations[index].writer;
+            }
+
+            /**
+             * The number of bytes in input buffers which are still used by
+             * selections that have not been encoded yet.
+             */
+            std::size_t memory_in_use() const {
+                return m_memory->bytes();
+            }
+
+            /**
+             * Write the matching objects in the buffer to all outputs. The
+             * buffer is moved into this function. This waits if the limit
+             * on the memory use is reached.
+             *
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void operator()(osmium::memory::Buffer&& buffer) {
+                if (!buffer || buffer.committed() == 0) {
+                    return;
+                }
+
+                std::unique_ptr<osmium::memory::Buffer> owned{new osmium::memory::Buffer{std::move(buffer)}};
+                const std::size_t bytes = owned->capacity();
+                m_memory->acquire(bytes, m_max_memory);
+
+                // The memory is released when the last selection using
+                // the buffer is gone, which is usually in one of the
+                // threads of the pool.
+                const auto memory = m_memory;
+                const std::shared_ptr<const osmium::memory::Buffer> shared{owned.release(), [memory, bytes](const osmium::memory::Buffer* ptr) {
+                    delete ptr;
+                    memory->release(bytes);
+                }};
+
+                for (auto& d : m_destinations) {
+                    osmium::memory::BufferSelection selection{shared};
+                    for (const auto& object : shared->select<osmium::OSMObject>()) {
+                        if (!d.filter || d.filter(object)) {
+                            selection.add(object);
+                        }
+                    }
+                    (*d.writer)(std::move(selection));
+                }
+            }
+
+            /**
+             * Flush and close all output files. If there is an error, the
+             * remaining files are still closed and the first exception is
+             * rethrown.
+             *
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void close() {
+                if (m_closed) {
+                    return;
+                }
+                m_closed = true;
+
+                std::exception_ptr error;
+                for (auto& d : m_destinations) {
+                    try {
+                        d.writer->close();
+                    } catch (...) {
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+        }; // class FanoutWriter
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_FANOUT_WRITER_HPP
@@ -225,6 +225,9 @@ namespace osmium {
                 } else if (suffixes.back() == "blackhole") {
                     m_file_format = file_format::blackhole;
                     suffixes.pop_back();
+                } else if (suffixes.back() == "osmbuf") {
+                    m_file_format = file_format::osmbuf;
+                    suffixes.pop_back();
                 }
 
                 if (suffixes.empty()) {
@@ -0,0 +1,393 @@
+#ifndef OSMIUM_IO_FILE_METADATA_HPP
+#define OSMIUM_IO_FILE_METADATA_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/crc32c.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Summary of an OSM file: The contents of its header, the number
+         * of objects and their ID range for each type, the bounding box
+         * of all nodes, and the size and CRC32C checksum of the file.
+         *
+         * The Writer creates this if the "metadata_sidecar" file option
+         * is set and writes it to the file named in the option on close().
+         * Use read() to get the summary without opening the OSM file.
+         *
+         * The sidecar file is a text file with one "key=value" per line.
+         */
+        class FileMetadata {
+
+        public:
+
+            /// Number of objects of one type and their ID range.
+            struct type_summary {
+                uint64_t count = 0;
+                osmium::object_id_type min_id = std::numeric_limits<osmium::object_id_type>::max();
+                osmium::object_id_type max_id = std::numeric_limits<osmium::object_id_type>::min();
+            };
+
+        private:
+
+            static const char* sidecar_magic() noexcept {
+                return "osmium_file_metadata=1";
+            }
+
+            osmium::io::Header m_header{};
+            osmium::nwr_array<type_summary> m_types{};
+            osmium::Box m_bbox{};
+            uint64_t m_file_size = 0;
+            uint32_t m_crc32c = 0;
+
+            // Newlines and backslashes in header values are escaped.
+            static std::string escape(const std::string& str) {
+                std::string out;
+                for (const char c : str) {
+                    if (c == '\\') {
+                        out += "\\\\";
+                    } else if (c == '\n') {
+                        out += "\\n";
+                    } else {
+                        out += c;
+                    }
+                }
+                return out;
+            }
+
+            static std::string unescape(const std::string& str) {
+                std::string out;
+                for (auto it = str.cbegin(); it != str.cend(); ++it) {
+                    if (*it == '\\' && std::next(it) != str.cend()) {
+                        ++it;
+                        out += *it == 'n' ? '\n' : *it;
+                    } else {
+                        out += *it;
+                    }
+                }
+                return out;
+            }
+
+            static void append_box(std::string& out, const osmium::Box& box) {
+                if (!box) {
+                    return;
+                }
+                auto it = std::back_inserter(out);
+                it = osmium::detail::append_location_coordinate_to_string(it, box.bottom_left().x());
+                *it++ = ',';
+                it = osmium::detail::append_location_coordinate_to_string(it, box.bottom_left().y());
+                *it++ = ',';
+                it = osmium::detail::append_location_coordinate_to_string(it, box.top_right().x());
+                *it++ = ',';
+                osmium::detail::append_location_coordinate_to_string(it, box.top_right().y());
+            }
+
+            static osmium::Box parse_box(const std::string& str) {
+                if (str.empty()) {
+                    return osmium::Box{};
+                }
+                int32_t c[4];
+                const char* data = str.c_str();
+                for (int i = 0; i < 4; ++i) {
+                    c[i] = osmium::detail::string_to_location_coordinate(&data);
+                    if (*data != (i == 3 ? '\0' : ',')) {
+                        throw osmium::io_error{"invalid box in file metadata: '" + str + "'"};
+                    }
+                    ++data;
+                }
+                return osmium::Box{osmium::Location{c[0], c[1]}, osmium::Location{c[2], c[3]}};
+            }
+
+            template <typename T>
+            static T parse_int(const std::string& str) {
+                const bool is_signed = std::numeric_limits<T>::is_signed;
+                char* end = nullptr;
+                errno = 0;
+                const auto value = is_signed ? static_cast<T>(std::strtoll(str.c_str(), &end, 10))
+                                             : static_cast<T>(std::strtoull(str.c_str(), &end, 10));
+                if (str.empty() || errno != 0 || *end != '\0') {
+                    throw osmium::io_error{"invalid number in file metadata: '" + str + "'"};
+                }
+                return value;
+            }
+
+            void set_value(const std::string& key, const std::string& value) {
+                if (key.compare(0, 7, "header.") == 0) {
+                    m_header.set(key.substr(7), unescape(value));
+                } else if (key == "header_box") {
+                    m_header.add_box(parse_box(value));
+                } else if (key == "header_multiple_object_versions") {
+                    m_header.set_has_multiple_object_versions(value == "true");
+                } else if (key == "file_size") {
+                    m_file_size = parse_int<uint64_t>(value);
+                } else if (key == "crc32c") {
+                    m_crc32c = static_cast<uint32_t>(std::strtoul(value.c_str(), nullptr, 16));
+                } else if (key == "bbox") {
+                    m_bbox = parse_box(value);
+                } else {
+                    for (const auto type : {osmium::item_type::node, osmium::item_type::way, osmium::item_type::relation}) {
+                        if (key == osmium::item_type_to_name(type)) {
+                            const auto first = value.find(',');
+                            const auto second = value.find(',', first == std::string::npos ? first : first + 1);
+                            if (second == std::string::npos) {
+                                throw osmium::io_error{"invalid type summary in file metadata: '" + value + "'"};
+                            }
+                            auto& summary = m_types(type);
+                            summary.count = parse_int<uint64_t>(value.substr(0, first));
+                            summary.min_id = parse_int<osmium::object_id_type>(value.substr(first + 1, second - first - 1));
+                            summary.max_id = parse_int<osmium::object_id_type>(value.substr(second + 1));
+                        }
+                    }
+                    // Unknown keys are ignored so that later versions can
+                    // add more information.
+                }
+            }
+
+        public:
+
+            FileMetadata() = default;
+
+            /// The header of the file.
+            const osmium::io::Header& header() const noexcept {
+                return m_header;
+            }
+
+            void set_header(const osmium::io::Header& header) {
+                m_header = header;
+            }
+
+            /// Number of objects and ID range for nodes, ways or relations.
+            const type_summary& summary(osmium::item_type type) const noexcept {
+                return m_types(type);
+            }
+
+            /**
+             * Bounding box of all node locations. Invalid if there are no
+             * nodes with valid locations.
+             */
+            const osmium::Box& bbox() const noexcept {
+                return m_bbox;
+            }
+
+            /// Size of the file in bytes.
+            uint64_t file_size() const noexcept {
+                return m_file_size;
+            }
+
+            /// CRC32C checksum of the file contents.
+            uint32_t crc32c() const noexcept {
+                return m_crc32c;
+            }
+
+            /**
+             * Add all nodes, ways, and relations in the buffer to the
+             * counts, ID ranges, and bounding box.
+             */
+            void add(const osmium::memory::Buffer& buffer) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (object.type() != osmium::item_type::node &&
+                        object.type() != osmium::item_type::way &&
+                        object.type() != osmium::item_type::relation) {
+                        continue;
+                    }
+                    auto& summary = m_types(object.type());
+                    ++summary.count;
+                    summary.min_id = std::min(summary.min_id, object.id());
+                    summary.max_id = std::max(summary.max_id, object.id());
+                    if (object.type() == osmium::item_type::node) {
+                        const auto& location = static_cast<const osmium::Node&>(object).location();
+                        if (location.valid()) {
+                            m_bbox.extend(location);
+                        }
+                    }
+                }
+            }
+
+            /**
+             * Read the (finished) file to set its size and checksum.
+             *
+             * @throws std::system_error If the file could not be read.
+             */
+            void checksum_file(const std::string& filename) {
+                osmium::CRC32C crc;
+                m_file_size = 0;
+                std::vector<char> data(1024UL * 1024UL);
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                while (true) {
+                    const auto nread = osmium::io::detail::reliable_read(fd, data.data(), static_cast<unsigned int>(data.size()));
+                    if (nread == 0) {
+                        break;
+                    }
+                    crc.process_bytes(data.data(), static_cast<std::size_t>(nread));
+                    m_file_size += static_cast<uint64_t>(nread);
+                }
+                osmium::io::detail::reliable_close(fd);
+                m_crc32c = crc.checksum();
+            }
+
+            /**
+             * Write the metadata to a sidecar file.
+             *
+             * @throws std::system_error If the file could not be written.
+             */
+            void write(const std::string& filename, osmium::io::overwrite allow_overwrite = osmium::io::overwrite::no) const {
+                std::string out{sidecar_magic()};
+                out += '\n';
+
+                out += "file_size=";
+                out += std::to_string(m_file_size);
+                out += '\n';
+
+                char crc[9];
+                std::snprintf(crc, sizeof(crc), "%08x", m_crc32c);
+                out += "crc32c=";
+                out += crc;
+                out += '\n';
+
+                out += "bbox=";
+                append_box(out, m_bbox);
+                out += '\n';
+
+                for (const auto type : {osmium::item_type::node, osmium::item_type::way, osmium::item_type::relation}) {
+                    const auto& summary = m_types(type);
+                    out += osmium::item_type_to_name(type);
+                    out += '=';
+                    out += std::to_string(summary.count);
+                    out += ',';
+                    out += std::to_string(summary.count ? summary.min_id : 0);
+                    out += ',';
+                    out += std::to_string(summary.count ? summary.max_id : 0);
+                    out += '\n';
+                }
+
+                out += "header_multiple_object_versions=";
+                out += m_header.has_multiple_object_versions() ? "true" : "false";
+                out += '\n';
+
+                for (const auto& box : m_header.boxes()) {
+                    out += "header_box=";
+                    append_box(out, box);
+                    out += '\n';
+                }
+
+                for (const auto& option : m_header) {
+                    out += "header.";
+                    out += option.first;
+                    out += '=';
+                    out += escape(option.second);
+                    out += '\n';
+                }
+
+                const int fd = osmium::io::detail::open_for_writing(filename, allow_overwrite);
+                osmium::io::detail::reliable_write(fd, out.data(), out.size());
+                osmium::io::detail::reliable_close(fd);
+            }
+
+            /**
+             * Read metadata from a sidecar file written by write(). This
+             * is the fast way to get information about an OSM file
+             * without opening it.
+             *
+             * @throws osmium::io_error If the file is not a valid metadata file.
+             * @throws std::system_error If the file could not be opened.
+             */
+            static FileMetadata read(const std::string& filename) {
+                std::string data;
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                char buffer[4096];
+                while (true) {
+                    const auto nread = osmium::io::detail::reliable_read(fd, buffer, sizeof(buffer));
+                    if (nread == 0) {
+                        break;
+                    }
+                    data.append(buffer, static_cast<std::size_t>(nread));
+                }
+                osmium::io::detail::reliable_close(fd);
+
+                const std::string magic{sidecar_magic()};
+                if (data.compare(0, magic.size() + 1, magic + '\n') != 0) {
+                    throw osmium::io_error{"invalid file metadata file '" + filename + "'"};
+                }
+
+                FileMetadata metadata;
+                std::size_t pos = magic.size() + 1;
+                while (pos < data.size()) {
+                    auto end = data.find('\n', pos);
+                    if (end == std::string::npos) {
+                        end = data.size();
+                    }
+                    const auto eq = data.find('=', pos);
+                    if (eq == std::string::npos || eq > end) {
+                        throw osmium::io_error{"invalid line in file metadata file '" + filename + "'"};
+                    }
+                    metadata.set_value(data.substr(pos, eq - pos), data.substr(eq + 1, end - eq - 1));
+                    pos = end + 1;
+                }
+
+                return metadata;
+            }
+
+        }; // class FileMetadata
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_FILE_METADATA_HPP
@@ -43,18 +43,28 @@ DEALINGS IN THE SOFTWARE.
  */
 
 #include <osmium/io/compression.hpp>
+#include <osmium/io/detail/parallel_compressor.hpp>
+#include <osmium/io/detail/parallel_decompressor.hpp>
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file_compression.hpp>
 #include <osmium/io/writer_options.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/compatibility.hpp>
+#include <osmium/util/config.hpp>
 
 #include <zlib.h>
 
+#ifdef OSMIUM_WITH_ISAL
+# include <isa-l/igzip_lib.h>
+#endif
+
 #include <cassert>
 #include <cerrno>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
+#include <memory>
 #include <string>
 
 #ifndef _MSC_VER
@@ -101,6 +111,33 @@ namespace osmium {
                 throw osmium::gzip_error{error, error_code};
             }
 
+            /**
+             * Compress the input into one complete gzip member.
+             */
+            inline std::string gzip_compress_member(const std::string& input) {
+                z_stream stream{};
+                int result = ::deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+                if (result != Z_OK) {
+                    throw gzip_error{"gzip error: compression init failed", result};
+                }
+
+                std::string output(::deflateBound(&stream, static_cast<uLong>(input.size())), '\0');
+
+                stream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(input.data()));
+                stream.avail_in = static_cast<unsigned int>(input.size());
+                stream.next_out = reinterpret_cast<unsigned char*>(&*output.begin());
+                stream.avail_out = static_cast<unsigned int>(output.size());
+
+                result = ::deflate(&stream, Z_FINISH);
+                ::deflateEnd(&stream);
+                if (result != Z_STREAM_END) {
+                    throw gzip_error{"gzip error: compression failed", result};
+                }
+
+                output.resize(static_cast<std::size_t>(stream.total_out));
+                return output;
+            }
+
         } // namespace detail
 
         class GzipCompressor : public Compressor {
@@ -169,13 +206,151 @@ namespace osmium {
 
         }; // class GzipCompressor
 
+        /**
+         * Gzip compressor compressing chunks of the data in the thread
+         * pool. The result is a multi-member gzip file.
+         */
+        class ParallelGzipCompressor final : public detail::ParallelCompressor {
+
+        public:
+
+            enum : std::size_t {
+                chunk_size = 1024ul * 1024ul
+            };
+
+            ParallelGzipCompressor(const int fd, const fsync sync, osmium::thread::Pool& pool) :
+                ParallelCompressor(fd, sync, pool, chunk_size, detail::gzip_compress_member) {
+            }
+
+        }; // class ParallelGzipCompressor
+
+#ifdef OSMIUM_WITH_ISAL
+        /**
+         * Gzip decompressor using the inflate implementation of the
+         * Intel ISA-L library which is much faster than zlib. Used if
+         * OSMIUM_WITH_ISAL is defined.
+         */
         class GzipDecompressor : public Decompressor {
 
+            int m_fd;
+            std::size_t m_read_size = osmium::config::get_read_size();
+            detail::read_advisor m_advisor;
+            ::inflate_state m_state;
+            std::string m_input;
+            std::size_t m_file_offset = 0;
+            bool m_eof = false;
+
+            // Fill the input buffer, sets m_eof if nothing could be read.
+            void read_input() {
+                const auto nread = osmium::io::detail::reliable_read(m_fd, &*m_input.begin(), static_cast<unsigned int>(m_input.size()));
+                if (nread == 0) {
+                    m_eof = true;
+                    return;
+                }
+                m_file_offset += static_cast<std::size_t>(nread);
+                m_state.next_in = reinterpret_cast<uint8_t*>(&*m_input.begin());
+                m_state.avail_in = static_cast<uint32_t>(nread);
+            }
+
+            void start_member() noexcept {
+                ::isal_inflate_reset(&m_state);
+                m_state.crc_flag = ISAL_GZIP;
+            }
+
+        public:
+
+            explicit GzipDecompressor(const int fd) :
+                m_fd(fd),
+                m_advisor(fd),
+                m_state(),
+                m_input(m_read_size, '\0') {
+                assert(m_input.size() < std::numeric_limits<uint32_t>::max());
+                ::isal_inflate_init(&m_state);
+                m_state.crc_flag = ISAL_GZIP;
+            }
+
+            GzipDecompressor(const GzipDecompressor&) = delete;
+            GzipDecompressor& operator=(const GzipDecompressor&) = delete;
+
+            GzipDecompressor(GzipDecompressor&&) = delete;
+            GzipDecompressor& operator=(GzipDecompressor&&) = delete;
+
+            ~GzipDecompressor() noexcept final {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            std::string read() final {
+                assert(m_fd >= 0);
+                std::string buffer(m_read_size, '\0');
+                m_state.next_out = reinterpret_cast<uint8_t*>(&*buffer.begin());
+                m_state.avail_out = static_cast<uint32_t>(buffer.size());
+
+                while (m_state.avail_out > 0) {
+                    if (m_state.avail_in == 0) {
+                        if (m_eof) {
+                            break;
+                        }
+                        read_input();
+                        if (m_eof) {
+                            if (m_state.block_state != ISAL_BLOCK_FINISH && m_file_offset > 0) {
+                                throw gzip_error{"gzip error: read failed: unexpected end of file"};
+                            }
+                            break;
+                        }
+                    }
+
+                    if (m_state.block_state == ISAL_BLOCK_FINISH) {
+                        // Like zlib, ignore trailing data after the last
+                        // gzip member.
+                        if (*m_state.next_in != 0x1f) {
+                            m_state.avail_in = 0;
+                            m_eof = true;
+                            break;
+                        }
+                        start_member();
+                    }
+
+                    const int result = ::isal_inflate(&m_state);
+                    if (result < 0) {
+                        throw gzip_error{"gzip error: read failed: inflate failed", result};
+                    }
+                }
+
+                buffer.resize(buffer.size() - m_state.avail_out);
+                set_offset(m_file_offset);
+                m_advisor.update(m_file_offset);
+                return buffer;
+            }
+
+            void close() final {
+                if (m_fd >= 0) {
+                    m_advisor.finish();
+                    const int fd = m_fd;
+                    m_fd = -1;
+                    osmium::io::detail::reliable_close(fd);
+                }
+            }
+
+        }; // class GzipDecompressor
+#else
+        class GzipDecompressor : public Decompressor {
+
+            enum : unsigned int {
+                max_gzip_buffer_size = 1024u * 1024u
+            };
+
             gzFile m_gzfile = nullptr;
+            std::size_t m_read_size = osmium::config::get_read_size();
+            detail::read_advisor m_advisor;
 
         public:
 
-            explicit GzipDecompressor(const int fd) {
+            explicit GzipDecompressor(const int fd) :
+                m_advisor(fd) {
 #ifdef _MSC_VER
                 osmium::detail::disable_invalid_parameter_handler diph;
 #endif
@@ -187,6 +362,11 @@ namespace osmium {
                     }
                     throw gzip_error{"gzip error: read initialization failed"};
                 }
+#if ZLIB_VERNUM >= 0x1240
+                // The default buffer of zlib is only 8 kB which means lots
+                // of small read(2) calls.
+                ::gzbuffer(m_gzfile, m_read_size < max_gzip_buffer_size ? static_cast<unsigned int>(m_read_size) : max_gzip_buffer_size);
+#endif
             }
 
             GzipDecompressor(const GzipDecompressor&) = delete;
@@ -208,7 +388,7 @@ namespace osmium {
                 osmium::detail::disable_invalid_parameter_handler diph;
 #endif
                 assert(m_gzfile);
-                std::string buffer(osmium::io::Decompressor::input_buffer_size, '\0');
+                std::string buffer(m_read_size, '\0');
                 assert(buffer.size() < std::numeric_limits<unsigned int>::max());
                 int nread = ::gzread(m_gzfile, &*buffer.begin(), static_cast<unsigned int>(buffer.size()));
                 if (nread < 0) {
@@ -216,7 +396,9 @@ namespace osmium {
                 }
                 buffer.resize(static_cast<std::string::size_type>(nread));
 #if ZLIB_VERNUM >= 0x1240
-                set_offset(static_cast<std::size_t>(::gzoffset(m_gzfile)));
+                const auto offset = static_cast<std::size_t>(::gzoffset(m_gzfile));
+                set_offset(offset);
+                m_advisor.update(offset);
 #endif
                 return buffer;
             }
@@ -226,6 +408,7 @@ namespace osmium {
 #ifdef _MSC_VER
                     osmium::detail::disable_invalid_parameter_handler diph;
 #endif
+                    m_advisor.finish();
                     const int result = ::gzclose_r(m_gzfile);
                     m_gzfile = nullptr;
                     if (result != Z_OK) {
@@ -235,6 +418,106 @@ namespace osmium {
             }
 
         }; // class GzipDecompressor
+#endif
+
+        namespace detail {
+
+            /**
+             * Does the data look like the header of a gzip member? Checks
+             * the magic bytes, compression method, reserved flags and the
+             * extra flags and OS fields for plausible values.
+             */
+            inline bool is_gzip_member_start(const char* data, const std::size_t size) noexcept {
+                if (size < 10) {
+                    return false;
+                }
+                const auto* d = reinterpret_cast<const unsigned char*>(data);
+                return d[0] == 0x1f && d[1] == 0x8b && d[2] == 0x08 &&
+                       (d[3] & 0xe0U) == 0 &&
+                       (d[8] == 0 || d[8] == 2 || d[8] == 4) &&
+                       (d[9] <= 13 || d[9] == 255);
+            }
+
+            class gzip_stream_decoder : public stream_decoder {
+
+                enum : std::size_t {
+                    output_chunk_size = 256ul * 1024ul
+                };
+
+                z_stream m_zstream;
+
+            public:
+
+                gzip_stream_decoder() :
+                    m_zstream() {
+                    const int result = ::inflateInit2(&m_zstream, 15 + 16);
+                    if (result != Z_OK) {
+                        throw gzip_error{"gzip error: decompression init failed", result};
+                    }
+                }
+
+                ~gzip_stream_decoder() noexcept final {
+                    ::inflateEnd(&m_zstream);
+                }
+
+                bool decode(const char* data, const std::size_t size, std::string& output) final {
+                    assert(size < std::numeric_limits<unsigned int>::max());
+                    m_zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char*>(data));
+                    m_zstream.avail_in = static_cast<unsigned int>(size);
+
+                    while (true) {
+                        const auto old_size = output.size();
+                        output.resize(old_size + output_chunk_size);
+                        m_zstream.next_out = reinterpret_cast<unsigned char*>(&output[old_size]);
+                        m_zstream.avail_out = static_cast<unsigned int>(output_chunk_size);
+
+                        const int result = ::inflate(&m_zstream, Z_NO_FLUSH);
+                        const bool output_full = m_zstream.avail_out == 0;
+                        output.resize(old_size + output_chunk_size - m_zstream.avail_out);
+
+                        if (result == Z_STREAM_END) {
+                            if (m_zstream.avail_in == 0) {
+                                ::inflateReset(&m_zstream);
+                                return true;
+                            }
+                            ::inflateReset(&m_zstream);
+                        } else if (result == Z_OK || result == Z_BUF_ERROR) {
+                            if (m_zstream.avail_in == 0 && !output_full) {
+                                return false;
+                            }
+                        } else {
+                            throw gzip_error{"gzip error: inflate failed", result};
+                        }
+                    }
+                }
+
+                void end_of_input() final {
+                    throw gzip_error{"gzip error: unexpected end of file"};
+                }
+
+            }; // class gzip_stream_decoder
+
+        } // namespace detail
+
+        /**
+         * Gzip decompressor decompressing the members of a multi-member
+         * gzip file in the thread pool.
+         */
+        class ParallelGzipDecompressor final : public detail::ParallelDecompressor {
+
+        public:
+
+            enum : std::size_t {
+                segment_size = 1024ul * 1024ul
+            };
+
+            ParallelGzipDecompressor(const int fd, osmium::thread::Pool& pool) :
+                ParallelDecompressor(fd, pool, segment_size, '\x1f', detail::is_gzip_member_start, []() {
+                    return std::unique_ptr<detail::stream_decoder>{new detail::gzip_stream_decoder{}};
+                }) {
+            }
+
+        }; // class ParallelGzipDecompressor
 
         class GzipBufferDecompressor : public Decompressor {
 
@@ -320,9 +603,17 @@ namespace osmium {
                 [](const char* buffer, const std::size_t size) { return new osmium::io::GzipBufferDecompressor{buffer, size}; }
             );
 
+            const bool registered_parallel_gzip_compression = osmium::io::CompressionFactory::instance().register_parallel_compressor(osmium::io::file_compression::gzip,
+                [](const int fd, const fsync sync, osmium::thread::Pool& pool) { return new osmium::io::ParallelGzipCompressor{fd, sync, pool}; }
+            );
+
+            const bool registered_parallel_gzip_decompression = osmium::io::CompressionFactory::instance().register_parallel_decompressor(osmium::io::file_compression::gzip,
+                [](const int fd, osmium::thread::Pool& pool) { return new osmium::io::ParallelGzipDecompressor{fd, pool}; }
+            );
+
             // dummy function to silence the unused variable warning from above
             inline bool get_registered_gzip_compression() noexcept {
-                return registered_gzip_compression;
+                return registered_gzip_compression && registered_parallel_gzip_compression && registered_parallel_gzip_decompression;
             }
 
         } // namespace detail
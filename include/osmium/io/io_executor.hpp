@@ -0,0 +1,395 @@
+#ifndef OSMIUM_IO_IO_EXECUTOR_HPP
+#define OSMIUM_IO_IO_EXECUTOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/thread/util.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            enum class io_stage_result {
+                idle     = 0, // nothing could be done right now
+                progress = 1, // some work was done
+                done     = 2  // stage is finished and can be removed
+            };
+
+            /**
+             * A stage of the I/O pipeline (reading or writing) which can
+             * run on an IOExecutor. The step() function does a small piece
+             * of work (for instance reading or writing one chunk of data)
+             * and must never wait for other stages.
+             */
+            class io_stage {
+
+            public:
+
+                io_stage() = default;
+
+                io_stage(const io_stage&) = delete;
+                io_stage& operator=(const io_stage&) = delete;
+
+                io_stage(io_stage&&) = delete;
+                io_stage& operator=(io_stage&&) = delete;
+
+                virtual ~io_stage() noexcept = default;
+
+                virtual io_stage_result step() = 0;
+
+            }; // class io_stage
+
+            /**
+             * Returned when adding a stage or task to an IOExecutor. Waits
+             * for the stage or task to finish on destruction so that all
+             * data referenced by it stays around long enough.
+             */
+            class io_stage_handle {
+
+                std::future<void> m_finished{};
+
+            public:
+
+                io_stage_handle() = default;
+
+                explicit io_stage_handle(std::future<void>&& finished) :
+                    m_finished(std::move(finished)) {
+                }
+
+                io_stage_handle(const io_stage_handle&) = delete;
+                io_stage_handle& operator=(const io_stage_handle&) = delete;
+
+                io_stage_handle(io_stage_handle&&) noexcept = default;
+
+                io_stage_handle& operator=(io_stage_handle&& other) noexcept {
+                    wait();
+                    m_finished = std::move(other.m_finished);
+                    return *this;
+                }
+
+                ~io_stage_handle() noexcept {
+                    wait();
+                }
+
+                void wait() noexcept {
+                    if (m_finished.valid()) {
+                        m_finished.wait();
+                        m_finished = std::future<void>{};
+                    }
+                }
+
+            }; // class io_stage_handle
+
+        } // namespace detail
+
+        /**
+         * A fixed number of threads running the read and write stages of
+         * any number of Readers and Writers. Normally each Reader has its
+         * own thread reading the input file and each Writer has its own
+         * thread writing the output file. If an IOExecutor is given to
+         * the Reader or Writer as an option, this work is done in the
+         * threads of the executor instead, so the number of threads
+         * stays the same regardless of how many files are open.
+         *
+         * The threads go through all stages round-robin, each stage
+         * reads or writes one chunk of data at a time. Stages that can
+         * not do anything, because their queue is full (when reading) or
+         * empty (when writing), are skipped.
+         *
+         * Reading from pipes (stdin or URLs) can block an executor thread
+         * until data is available, so this works best with files.
+         *
+         * Readers also run their parser as a task on the executor (see
+         * run_task()). Task threads are started when needed and kept
+         * around when the task is done, so a Reader opened later doesn't
+         * have to start a thread. This lowers the latency when reading
+         * many small files one after the other, like minutely change
+         * files.
+         *
+         * The executor must live longer than all Readers and Writers
+         * using it.
+         */
+        class IOExecutor {
+
+            struct entry {
+                std::unique_ptr<detail::io_stage> stage;
+                std::promise<void> finished{};
+                bool running = false;
+
+                explicit entry(std::unique_ptr<detail::io_stage>&& s) :
+                    stage(std::move(s)) {
+                }
+            };
+
+            struct task {
+                std::function<void()> function;
+                std::promise<void> finished{};
+
+                explicit task(std::function<void()>&& f) :
+                    function(std::move(f)) {
+                }
+            };
+
+            // How long to sleep when no stage could do anything.
+            std::chrono::microseconds m_idle_wait;
+
+            std::mutex m_mutex;
+            std::condition_variable m_work_available;
+            std::vector<std::shared_ptr<entry>> m_entries;
+            std::size_t m_next = 0;
+            bool m_shutdown = false;
+            std::vector<std::thread> m_threads;
+
+            std::condition_variable m_task_available;
+            std::deque<task> m_tasks;
+            std::vector<std::thread> m_task_threads;
+            std::size_t m_idle_task_threads = 0;
+
+            // Get next stage not currently running in some other thread.
+            // Must be called with the mutex locked.
+            std::shared_ptr<entry> next_entry() {
+                for (std::size_t i = 0; i < m_entries.size(); ++i) {
+                    if (m_next >= m_entries.size()) {
+                        m_next = 0;
+                    }
+                    const auto& e = m_entries[m_next++];
+                    if (!e->running) {
+                        return e;
+                    }
+                }
+                return nullptr;
+            }
+
+            void remove_entry(const std::shared_ptr<entry>& e) {
+                for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+                    if (*it == e) {
+                        m_entries.erase(it);
+                        return;
+                    }
+                }
+            }
+
+            void worker() {
+                osmium::thread::set_thread_name("_osmium_io");
+
+                std::size_t idle_steps = 0;
+                std::unique_lock<std::mutex> lock{m_mutex};
+                while (!m_shutdown) {
+                    const std::shared_ptr<entry> e = next_entry();
+                    if (!e) {
+                        m_work_available.wait_for(lock, m_idle_wait);
+                        idle_steps = 0;
+                        continue;
+                    }
+
+                    e->running = true;
+                    lock.unlock();
+                    detail::io_stage_result result;
+                    try {
+                        result = e->stage->step();
+                    } catch (...) {
+                        // Stages handle their own errors, this is only
+                        // a safety net.
+                        result = detail::io_stage_result::done;
+                    }
+                    if (result == detail::io_stage_result::done) {
+                        e->stage.reset();
+                    }
+                    lock.lock();
+                    e->running = false;
+
+                    if (result == detail::io_stage_result::done) {
+                        remove_entry(e);
+                        e->finished.set_value();
+                        idle_steps = 0;
+                    } else if (result == detail::io_stage_result::progress) {
+                        idle_steps = 0;
+                    } else if (++idle_steps >= m_entries.size()) {
+                        m_work_available.wait_for(lock, m_idle_wait);
+                        idle_steps = 0;
+                    }
+                }
+            }
+
+            void task_worker() {
+                osmium::thread::set_thread_name("_osmium_task");
+
+                std::unique_lock<std::mutex> lock{m_mutex};
+                ++m_idle_task_threads;
+                while (true) {
+                    m_task_available.wait(lock, [this]() {
+                        return m_shutdown || !m_tasks.empty();
+                    });
+                    if (m_tasks.empty()) {
+                        return;
+                    }
+
+                    --m_idle_task_threads;
+                    task t{std::move(m_tasks.front())};
+                    m_tasks.pop_front();
+                    lock.unlock();
+                    try {
+                        t.function();
+                    } catch (...) {
+                        // Tasks handle their own errors, this is only
+                        // a safety net.
+                    }
+                    t.function = nullptr;
+
+                    // This thread is idle again before anybody waiting
+                    // for the task can start a new one.
+                    lock.lock();
+                    ++m_idle_task_threads;
+                    t.finished.set_value();
+                }
+            }
+
+        public:
+
+            /**
+             * Create executor with the specified number of threads. If the
+             * number is 0 or negative, it is added to the number of cores
+             * (but there is always at least one thread).
+             *
+             * The idle_wait is how long the threads sleep when no stage
+             * could do anything. Data written to a Writer waits at most
+             * this long before it is written out. Smaller values lower the
+             * latency at the cost of more CPU use while idle.
+             */
+            explicit IOExecutor(int num_threads = 2, std::chrono::microseconds idle_wait = std::chrono::milliseconds{1}) :
+                m_idle_wait(idle_wait) {
+                if (num_threads < 1) {
+                    num_threads += static_cast<int>(std::thread::hardware_concurrency());
+                }
+                if (num_threads < 1) {
+                    num_threads = 1;
+                }
+                for (int i = 0; i < num_threads; ++i) {
+                    m_threads.emplace_back(&IOExecutor::worker, this);
+                }
+            }
+
+            IOExecutor(const IOExecutor&) = delete;
+            IOExecutor& operator=(const IOExecutor&) = delete;
+
+            IOExecutor(IOExecutor&&) = delete;
+            IOExecutor& operator=(IOExecutor&&) = delete;
+
+            ~IOExecutor() noexcept {
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_shutdown = true;
+                }
+                m_work_available.notify_all();
+                m_task_available.notify_all();
+                for (auto& thread : m_threads) {
+                    if (thread.joinable()) {
+                        thread.join();
+                    }
+                }
+                for (auto& thread : m_task_threads) {
+                    if (thread.joinable()) {
+                        thread.join();
+                    }
+                }
+            }
+
+            /// The number of threads in this executor.
+            std::size_t num_threads() const noexcept {
+                return m_threads.size();
+            }
+
+            /// The number of stages currently handled by this executor.
+            std::size_t num_stages() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_entries.size();
+            }
+
+            /// The number of task threads started so far.
+            std::size_t num_task_threads() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_task_threads.size();
+            }
+
+            /**
+             * Add a stage to this executor. It will be run until its step()
+             * function returns io_stage_result::done.
+             */
+            detail::io_stage_handle add(std::unique_ptr<detail::io_stage>&& stage) {
+                auto e = std::make_shared<entry>(std::move(stage));
+                detail::io_stage_handle handle{e->finished.get_future()};
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_entries.push_back(std::move(e));
+                }
+                m_work_available.notify_one();
+                return handle;
+            }
+
+            /**
+             * Run a function on a task thread of this executor. Unlike
+             * stages, tasks can block for as long as they want, each one
+             * has a thread of its own while it runs. A new thread is only
+             * started if no task thread is idle.
+             */
+            detail::io_stage_handle run_task(std::function<void()>&& function) {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_tasks.emplace_back(std::move(function));
+                detail::io_stage_handle handle{m_tasks.back().finished.get_future()};
+                if (m_tasks.size() > m_idle_task_threads) {
+                    m_task_threads.emplace_back(&IOExecutor::task_worker, this);
+                }
+                m_task_available.notify_one();
+                return handle;
+            }
+
+        }; // class IOExecutor
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_IO_EXECUTOR_HPP
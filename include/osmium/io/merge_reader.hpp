@@ -0,0 +1,544 @@
+#ifndef OSMIUM_IO_MERGE_READER_HPP
+#define OSMIUM_IO_MERGE_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/error.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/input_iterator.hpp>
+#include <osmium/io/multi_reader.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * What to do with several objects with the same type and id when
+         * merging inputs with the MergeReader.
+         */
+        enum class merge_duplicates {
+            /// Keep all objects, for instance when merging history files.
+            keep_all = 0,
+            /// Keep only one object with the same type, id, and version.
+            unique_versions = 1,
+            /// Keep only the latest version of each object.
+            latest_version = 2
+        }; // enum class merge_duplicates
+
+        namespace detail {
+
+            /**
+             * Packed sort key of an OSM object for the order defined by
+             * osmium::object_order_type_id_version. Invalid timestamps
+             * sort before valid ones.
+             */
+            struct merge_key {
+
+                uint64_t type_sign = 0;
+                uint64_t id = 0;
+                uint64_t version_timestamp = 0;
+
+                merge_key() noexcept = default;
+
+                explicit merge_key(const osmium::OSMObject& object) noexcept :
+                    type_sign((static_cast<uint64_t>(object.type()) << 1U) | static_cast<uint64_t>(object.id() > 0)),
+                    id(object.positive_id()),
+                    version_timestamp((static_cast<uint64_t>(object.version()) << 32U) | object.timestamp().seconds_since_epoch()) {
+                }
+
+                bool same_object(const merge_key& other) const noexcept {
+                    return type_sign == other.type_sign && id == other.id;
+                }
+
+                bool same_version(const merge_key& other) const noexcept {
+                    return same_object(other) && (version_timestamp >> 32U) == (other.version_timestamp >> 32U);
+                }
+
+                friend bool operator<(const merge_key& lhs, const merge_key& rhs) noexcept {
+                    if (lhs.type_sign != rhs.type_sign) {
+                        return lhs.type_sign < rhs.type_sign;
+                    }
+                    if (lhs.id != rhs.id) {
+                        return lhs.id < rhs.id;
+                    }
+                    return lhs.version_timestamp < rhs.version_timestamp;
+                }
+
+            }; // struct merge_key
+
+            /**
+             * One input of the MergeReader with the current buffer and the
+             * keys of all objects in it.
+             */
+            class merge_input {
+
+                std::unique_ptr<osmium::io::Reader> m_reader;
+                osmium::memory::Buffer m_buffer{};
+                std::vector<merge_key> m_keys{};
+                std::vector<osmium::OSMObject*> m_objects{};
+                std::size_t m_pos = 0;
+
+                // Does the buffer only contain OSM objects?
+                bool m_clean = false;
+
+                bool m_eof = false;
+
+                void fill() {
+                    m_keys.clear();
+                    m_objects.clear();
+                    m_pos = 0;
+                    m_clean = true;
+                    for (auto& item : m_buffer.select<osmium::memory::Item>()) {
+                        if (!item.is_compatible_to(osmium::item_type::node) &&
+                            !item.is_compatible_to(osmium::item_type::way) &&
+                            !item.is_compatible_to(osmium::item_type::relation) &&
+                            !item.is_compatible_to(osmium::item_type::area)) {
+                            m_clean = false;
+                            continue;
+                        }
+                        auto& object = static_cast<osmium::OSMObject&>(item);
+                        m_keys.emplace_back(object);
+                        m_objects.push_back(&object);
+                    }
+                }
+
+            public:
+
+                explicit merge_input(std::unique_ptr<osmium::io::Reader>&& reader) noexcept :
+                    m_reader(std::move(reader)) {
+                }
+
+                osmium::io::Reader& reader() noexcept {
+                    return *m_reader;
+                }
+
+                /// Read buffers until there is one with objects or the end.
+                void next_buffer() {
+                    m_keys.clear();
+                    m_objects.clear();
+                    m_pos = 0;
+                    while (!m_eof) {
+                        m_buffer = m_reader->read();
+                        if (!m_buffer) {
+                            m_eof = true;
+                            return;
+                        }
+                        fill();
+                        if (!m_keys.empty()) {
+                            return;
+                        }
+                    }
+                }
+
+                bool eof() const noexcept {
+                    return m_pos == m_keys.size();
+                }
+
+                const merge_key& key() const noexcept {
+                    return m_keys[m_pos];
+                }
+
+                const osmium::OSMObject& object() const noexcept {
+                    return *m_objects[m_pos];
+                }
+
+                const merge_key& last_key() const noexcept {
+                    return m_keys.back();
+                }
+
+                bool at_buffer_start() const noexcept {
+                    return m_pos == 0 && m_clean;
+                }
+
+                osmium::memory::Buffer take_buffer() {
+                    osmium::memory::Buffer buffer{std::move(m_buffer)};
+                    next_buffer();
+                    return buffer;
+                }
+
+                void advance() {
+                    ++m_pos;
+                    if (m_pos == m_keys.size()) {
+                        next_buffer();
+                    }
+                }
+
+                void close() {
+                    m_eof = true;
+                    m_keys.clear();
+                    m_objects.clear();
+                    m_pos = 0;
+                    m_buffer = osmium::memory::Buffer{};
+                    m_reader->close();
+                }
+
+            }; // class merge_input
+
+        } // namespace detail
+
+        /**
+         * Merges several inputs, each sorted by type, id, and version (see
+         * osmium::object_order_type_id_version), into one sorted stream of
+         * buffers. Duplicate objects can be removed.
+         *
+         * All inputs are read at the same time. The next object is found
+         * with a loser tree over the inputs, comparing packed keys which
+         * are calculated once for each object. If all objects in the
+         * next buffer from an input come before anything in the other
+         * inputs and duplicates are kept, the buffer is returned as it is
+         * without copying the objects.
+         *
+         * Only OSM objects (nodes, ways, relations, and areas) are merged,
+         * any other items (such as changesets) are dropped.
+         */
+        class MergeReader {
+
+            enum : std::size_t {
+                output_buffer_size = 1024UL * 1024UL
+            };
+
+            std::vector<detail::merge_input> m_inputs{};
+
+            // The loser tree. m_tree[0] is the winner, the other entries
+            // the losers of the matches in the inner nodes. The input n is
+            // the leaf at position n + size.
+            std::vector<std::size_t> m_tree{};
+
+            osmium::memory::Buffer m_output{};
+
+            // The key of the object added to the output but not yet
+            // committed because it might be a duplicate.
+            detail::merge_key m_pending_key{};
+            bool m_pending = false;
+
+            merge_duplicates m_mode;
+            bool m_eof = false;
+
+            bool less(std::size_t a, std::size_t b) const noexcept {
+                if (m_inputs[a].eof()) {
+                    return false;
+                }
+                if (m_inputs[b].eof()) {
+                    return true;
+                }
+                const auto& ka = m_inputs[a].key();
+                const auto& kb = m_inputs[b].key();
+                if (ka < kb) {
+                    return true;
+                }
+                if (kb < ka) {
+                    return false;
+                }
+                return a < b;
+            }
+
+            void build_tree() {
+                const std::size_t size = m_inputs.size();
+                m_tree.assign(size, 0);
+                if (size == 0) {
+                    return;
+                }
+                std::vector<std::size_t> winners(2 * size);
+                for (std::size_t n = 0; n < size; ++n) {
+                    winners[n + size] = n;
+                }
+                for (std::size_t pos = size - 1; pos > 0; --pos) {
+                    const auto a = winners[2 * pos];
+                    const auto b = winners[2 * pos + 1];
+                    if (less(b, a)) {
+                        winners[pos] = b;
+                        m_tree[pos] = a;
+                    } else {
+                        winners[pos] = a;
+                        m_tree[pos] = b;
+                    }
+                }
+                m_tree[0] = size == 1 ? 0 : winners[1];
+            }
+
+            // Replay the matches from the leaf of the winner up to the
+            // root after the winner changed its key.
+            void replay() {
+                auto winner = m_tree[0];
+                for (auto pos = (winner + m_inputs.size()) / 2; pos > 0; pos /= 2) {
+                    if (less(m_tree[pos], winner)) {
+                        std::swap(m_tree[pos], winner);
+                    }
+                }
+                m_tree[0] = winner;
+            }
+
+            // The best input apart from the winner is one of the inputs
+            // that lost against the winner on its way up.
+            const detail::merge_key* runner_up_key() const noexcept {
+                const auto winner = m_tree[0];
+                const detail::merge_key* best = nullptr;
+                std::size_t best_input = 0;
+                for (auto pos = (winner + m_inputs.size()) / 2; pos > 0; pos /= 2) {
+                    const auto input = m_tree[pos];
+                    if (!m_inputs[input].eof() && (!best || less(input, best_input))) {
+                        best = &m_inputs[input].key();
+                        best_input = input;
+                    }
+                }
+                return best;
+            }
+
+            // A buffer can be returned as it is if all objects in it come
+            // before the objects in all other inputs. This is only done
+            // when duplicates are kept, because otherwise the next buffer
+            // of the same input might contain a duplicate of the last
+            // object.
+            bool can_pass_through(const detail::merge_input& input) const noexcept {
+                if (m_mode != merge_duplicates::keep_all || !input.at_buffer_start()) {
+                    return false;
+                }
+                const auto* next = runner_up_key();
+                return !next || input.last_key() < *next;
+            }
+
+            osmium::memory::Buffer take_output() {
+                osmium::memory::Buffer buffer{std::move(m_output)};
+                m_output = osmium::memory::Buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                return buffer;
+            }
+
+            template <typename... TArgs>
+            void open(const std::vector<osmium::io::File>& files, TArgs&&... args) {
+                using options_type = std::tuple<typename detail::reader_option_storage<TArgs>::type...>;
+                const options_type options{std::forward<TArgs>(args)...};
+                m_inputs.reserve(files.size());
+                for (const auto& file : files) {
+                    m_inputs.emplace_back(detail::make_reader(file, options, typename detail::make_index_list<sizeof...(TArgs)>::type{}));
+                }
+            }
+
+            void init() {
+                m_output = osmium::memory::Buffer{output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+                for (auto& input : m_inputs) {
+                    input.next_buffer();
+                }
+                build_tree();
+            }
+
+        public:
+
+            /**
+             * Create a MergeReader for the specified files.
+             *
+             * @param files The files to merge. Each must be sorted.
+             * @param mode What to do with duplicate objects.
+             * @param args Options for the Readers of all files. See the
+             *             osmium::io::Reader constructor for details.
+             * @throws Any exception the Reader constructor throws.
+             */
+            template <typename... TArgs>
+            explicit MergeReader(const std::vector<osmium::io::File>& files, merge_duplicates mode, TArgs&&... args) :
+                m_mode(mode) {
+                open(files, std::forward<TArgs>(args)...);
+                init();
+            }
+
+            /**
+             * Create a MergeReader for already opened Readers.
+             *
+             * @param readers The Readers to merge. Each must return
+             *                sorted data.
+             * @param mode What to do with duplicate objects.
+             */
+            explicit MergeReader(std::vector<std::unique_ptr<osmium::io::Reader>>&& readers, merge_duplicates mode = merge_duplicates::keep_all) :
+                m_mode(mode) {
+                m_inputs.reserve(readers.size());
+                for (auto& reader : readers) {
+                    m_inputs.emplace_back(std::move(reader));
+                }
+                init();
+            }
+
+            MergeReader(const MergeReader&) = delete;
+            MergeReader& operator=(const MergeReader&) = delete;
+
+            MergeReader(MergeReader&&) = delete;
+            MergeReader& operator=(MergeReader&&) = delete;
+
+            ~MergeReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Close all Readers.
+             *
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void close() {
+                m_eof = true;
+                for (auto& input : m_inputs) {
+                    input.close();
+                }
+            }
+
+            /// The number of inputs.
+            std::size_t num_inputs() const noexcept {
+                return m_inputs.size();
+            }
+
+            /**
+             * The header of the first input. It is marked as having
+             * multiple object versions if any input has them, unless only
+             * the latest versions are kept.
+             *
+             * @throws io_error if there are no inputs.
+             */
+            osmium::io::Header header() {
+                if (m_inputs.empty()) {
+                    throw io_error{"MergeReader has no inputs"};
+                }
+                osmium::io::Header header{m_inputs.front().reader().header()};
+                for (auto& input : m_inputs) {
+                    if (input.reader().header().has_multiple_object_versions()) {
+                        header.set_has_multiple_object_versions(true);
+                    }
+                }
+                if (m_mode == merge_duplicates::latest_version) {
+                    header.set_has_multiple_object_versions(false);
+                }
+                return header;
+            }
+
+            /**
+             * Has the end of all inputs been reached? This is also set by
+             * calling close().
+             */
+            bool eof() const noexcept {
+                return m_eof;
+            }
+
+            /**
+             * Read the next buffer with merged objects. This is either a
+             * buffer from one of the inputs or a new buffer with copies of
+             * the objects. An invalid buffer signals the end of the data.
+             *
+             * @returns Buffer.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            osmium::memory::Buffer read() {
+                if (m_eof) {
+                    return osmium::memory::Buffer{};
+                }
+
+                while (true) {
+                    if (m_inputs.empty() || m_inputs[m_tree[0]].eof()) {
+                        if (m_pending) {
+                            m_output.commit();
+                            m_pending = false;
+                        }
+                        m_eof = true;
+                        if (m_output && m_output.committed() > 0) {
+                            return take_output();
+                        }
+                        return osmium::memory::Buffer{};
+                    }
+
+                    auto& input = m_inputs[m_tree[0]];
+                    const auto& key = input.key();
+
+                    if (m_pending) {
+                        m_pending = false;
+                        if (m_mode == merge_duplicates::latest_version && m_pending_key.same_object(key)) {
+                            m_output.rollback();
+                        } else if (m_mode == merge_duplicates::unique_versions && m_pending_key.same_version(key)) {
+                            m_output.commit();
+                            input.advance();
+                            replay();
+                            continue;
+                        } else {
+                            m_output.commit();
+                        }
+                    }
+
+                    if (m_output.committed() >= output_buffer_size - output_buffer_size / 8) {
+                        return take_output();
+                    }
+
+                    if (can_pass_through(input)) {
+                        if (m_output.committed() > 0) {
+                            return take_output();
+                        }
+                        osmium::memory::Buffer buffer{input.take_buffer()};
+                        replay();
+                        return buffer;
+                    }
+
+                    m_output.add_item(input.object());
+                    if (m_mode == merge_duplicates::keep_all) {
+                        m_output.commit();
+                    } else {
+                        m_pending_key = key;
+                        m_pending = true;
+                    }
+                    input.advance();
+                    replay();
+                }
+            }
+
+        }; // class MergeReader
+
+        inline InputIterator<MergeReader> begin(MergeReader& reader) {
+            return InputIterator<MergeReader>(reader);
+        }
+
+        inline InputIterator<MergeReader> end(MergeReader& /*reader*/) {
+            return InputIterator<MergeReader>();
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_MERGE_READER_HPP
@@ -0,0 +1,308 @@
+#ifndef OSMIUM_IO_MULTI_READER_HPP
+#define OSMIUM_IO_MULTI_READER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/io/error.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/input_iterator.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            // Reader options are stored by value, except for the thread
+            // pool, the I/O executor, and the stats which are only
+            // referenced.
+            template <typename T>
+            struct reader_option_storage {
+                using type = typename std::decay<T>::type;
+            };
+
+            template <>
+            struct reader_option_storage<osmium::thread::Pool&> {
+                using type = std::reference_wrapper<osmium::thread::Pool>;
+            };
+
+            template <>
+            struct reader_option_storage<osmium::io::IOExecutor&> {
+                using type = std::reference_wrapper<osmium::io::IOExecutor>;
+            };
+
+            template <>
+            struct reader_option_storage<osmium::io::PipelineStats&> {
+                using type = std::reference_wrapper<osmium::io::PipelineStats>;
+            };
+
+            template <std::size_t... I>
+            struct index_list {};
+
+            template <std::size_t N, std::size_t... I>
+            struct make_index_list : make_index_list<N - 1, N - 1, I...> {};
+
+            template <std::size_t... I>
+            struct make_index_list<0, I...> {
+                using type = index_list<I...>;
+            };
+
+            template <typename TTuple, std::size_t... I>
+            std::unique_ptr<osmium::io::Reader> make_reader(const osmium::io::File& file, const TTuple& options, index_list<I...> /*indexes*/) {
+                return std::unique_ptr<osmium::io::Reader>{new osmium::io::Reader{file, std::get<I>(options)...}};
+            }
+
+        } // namespace detail
+
+        /**
+         * Reads a list of files one after the other as if they were one
+         * continuous input. While the buffers of one file are read, the
+         * Reader for the next file is already created in the background,
+         * so its threads are running and the first data is decoded by the
+         * time it is needed.
+         *
+         * Use file_index() and is_first_buffer_of_file() to find out
+         * where the buffers returned by read() come from. Files without
+         * any data don't return any buffers.
+         */
+        class MultiReader {
+
+            using create_reader_type = std::function<std::unique_ptr<osmium::io::Reader>(const osmium::io::File&)>;
+
+            std::vector<osmium::io::File> m_files;
+            create_reader_type m_create_reader;
+
+            std::unique_ptr<osmium::io::Reader> m_current{};
+            std::future<std::unique_ptr<osmium::io::Reader>> m_next{};
+
+            // Index of the next file to be opened.
+            std::size_t m_next_index = 0;
+
+            // Index of the file the current reader reads.
+            std::size_t m_current_index = 0;
+
+            bool m_at_file_start = false;
+            bool m_first_buffer_of_file = false;
+            bool m_eof = false;
+
+            void open_next() {
+                if (m_next_index < m_files.size()) {
+                    m_next = std::async(std::launch::async, m_create_reader, m_files[m_next_index]);
+                    ++m_next_index;
+                }
+            }
+
+            bool switch_to_next() {
+                if (!m_next.valid()) {
+                    return false;
+                }
+                m_current = m_next.get();
+                m_current_index = m_next_index - 1;
+                m_at_file_start = true;
+                open_next();
+                return true;
+            }
+
+            void init() {
+                open_next();
+                switch_to_next();
+            }
+
+        public:
+
+            /**
+             * Create a MultiReader for the specified files.
+             *
+             * @param files The files to read in this order.
+             * @param args Options for the Readers of all files. See the
+             *             osmium::io::Reader constructor for details.
+             *             The options are copied, except for a thread
+             *             pool or IOExecutor which must stay around until
+             *             this MultiReader is closed.
+             * @throws Any exception the Reader constructor throws for the
+             *         first file.
+             */
+            template <typename... TArgs>
+            explicit MultiReader(std::vector<osmium::io::File> files, TArgs&&... args) :
+                m_files(std::move(files)) {
+                using options_type = std::tuple<typename detail::reader_option_storage<TArgs>::type...>;
+                const auto options = std::make_shared<options_type>(std::forward<TArgs>(args)...);
+                m_create_reader = [options](const osmium::io::File& file) {
+                    return detail::make_reader(file, *options, typename detail::make_index_list<sizeof...(TArgs)>::type{});
+                };
+                init();
+            }
+
+            MultiReader(const MultiReader&) = delete;
+            MultiReader& operator=(const MultiReader&) = delete;
+
+            MultiReader(MultiReader&&) = delete;
+            MultiReader& operator=(MultiReader&&) = delete;
+
+            ~MultiReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /**
+             * Close the current Reader and the one for the next file if
+             * it is already open.
+             *
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void close() {
+                m_eof = true;
+                if (m_next.valid()) {
+                    try {
+                        m_next.get()->close();
+                    } catch (...) {
+                        // Ignore any exceptions, the file was never used.
+                    }
+                }
+                if (m_current) {
+                    std::unique_ptr<osmium::io::Reader> reader{std::move(m_current)};
+                    reader->close();
+                }
+            }
+
+            /**
+             * Reads the next buffer. Switches to the next file when the
+             * current one is at its end. An invalid buffer signals the end
+             * of the last file. After that all read() calls will throw an
+             * osmium::io_error.
+             *
+             * @returns Buffer.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            osmium::memory::Buffer read() {
+                if (m_eof) {
+                    throw io_error{"Can not read from MultiReader after end of last file or close()"};
+                }
+
+                while (m_current) {
+                    osmium::memory::Buffer buffer{m_current->read()};
+                    if (buffer) {
+                        m_first_buffer_of_file = m_at_file_start;
+                        m_at_file_start = false;
+                        return buffer;
+                    }
+                    m_current->close();
+                    m_current.reset();
+                    switch_to_next();
+                }
+
+                m_eof = true;
+                return osmium::memory::Buffer{};
+            }
+
+            /**
+             * Has the end of the last file been reached? This is also set
+             * by calling close().
+             */
+            bool eof() const noexcept {
+                return m_eof;
+            }
+
+            /// The number of files in this MultiReader.
+            std::size_t num_files() const noexcept {
+                return m_files.size();
+            }
+
+            /**
+             * The index of the file (in the list given to the constructor)
+             * from which the last buffer returned by read() came.
+             */
+            std::size_t file_index() const noexcept {
+                return m_current_index;
+            }
+
+            /// The file from which the last buffer returned by read() came.
+            const osmium::io::File& file() const {
+                return m_files.at(m_current_index);
+            }
+
+            /**
+             * Is the last buffer returned by read() the first one from its
+             * file?
+             */
+            bool is_first_buffer_of_file() const noexcept {
+                return m_first_buffer_of_file;
+            }
+
+            /**
+             * Get the header of the file currently read. Before the first
+             * read() this is the header of the first file.
+             *
+             * @throws Some form of osmium::io_error if there is an error or
+             *         if there is no current file.
+             */
+            osmium::io::Header header() {
+                if (!m_current) {
+                    throw io_error{"MultiReader has no current file"};
+                }
+                return m_current->header();
+            }
+
+        }; // class MultiReader
+
+        inline InputIterator<MultiReader> begin(MultiReader& reader) {
+            return InputIterator<MultiReader>(reader);
+        }
+
+        inline InputIterator<MultiReader> end(MultiReader& /*reader*/) {
+            return InputIterator<MultiReader>();
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_MULTI_READER_HPP
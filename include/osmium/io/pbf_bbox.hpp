@@ -0,0 +1,159 @@
+#ifndef OSMIUM_IO_PBF_BBOX_HPP
+#define OSMIUM_IO_PBF_BBOX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Find the IDs of all objects needed for an extract of the given
+         * box from a PBF file without reading the whole file. The result
+         * contains
+         *
+         * - all nodes inside the box,
+         * - all ways referencing any of those nodes and all nodes of
+         *   those ways (so the ways are complete),
+         * - all relations with any of those nodes or ways as members.
+         *
+         * Only the node blobs whose bounding box intersects the box are
+         * read (see PBFBlobIndex::select(const osmium::Box&)), together
+         * with all way and relation blobs. The file must be sorted by
+         * type, relations referencing relations are not followed.
+         * Objects with negative IDs are ignored.
+         *
+         * Read the objects themselves in an index-guided second pass:
+         *
+         * @code
+         * auto ids = osmium::io::ids_in_bbox(filename, index, box);
+         * osmium::io::Reader reader{filename, index.select(ids)};
+         * while (osmium::memory::Buffer buffer = reader.read()) {
+         *     for (const auto& object : buffer.select<osmium::OSMObject>()) {
+         *         if (ids(object.type()).get_binary_search(object.positive_id())) {
+         *             ...
+         *         }
+         *     }
+         * }
+         * @endcode
+         *
+         * @param filename Name of the PBF file.
+         * @param index Blob index of the file.
+         * @param box The box.
+         * @returns Sorted sets of node, way, and relation IDs.
+         * @pre @code box.valid() @endcode
+         * @throws Any exception the Reader throws.
+         */
+        inline osmium::nwr_array<osmium::index::IdSetSmall<osmium::unsigned_object_id_type>>
+        ids_in_bbox(const std::string& filename, const PBFBlobIndex& index, const osmium::Box& box) {
+            osmium::nwr_array<osmium::index::IdSetSmall<osmium::unsigned_object_id_type>> ids;
+
+            // Nodes inside the box and ways referencing them, these are
+            // looked up for every way and relation.
+            osmium::index::IdSetDense<osmium::unsigned_object_id_type> nodes_in_box;
+            osmium::index::IdSetDense<osmium::unsigned_object_id_type> ways;
+
+            osmium::io::Reader reader{filename, index.select(box)};
+            while (osmium::memory::Buffer buffer = reader.read()) {
+                for (const auto& node : buffer.select<osmium::Node>()) {
+                    if (node.id() > 0 && node.location().valid() && box.contains(node.location())) {
+                        nodes_in_box.set(node.positive_id());
+                        ids(osmium::item_type::node).set(node.positive_id());
+                    }
+                }
+                for (const auto& way : buffer.select<osmium::Way>()) {
+                    if (way.id() <= 0) {
+                        continue;
+                    }
+                    bool in_box = false;
+                    for (const auto& node_ref : way.nodes()) {
+                        if (node_ref.ref() > 0 && nodes_in_box.get(node_ref.positive_ref())) {
+                            in_box = true;
+                            break;
+                        }
+                    }
+                    if (in_box) {
+                        ways.set(way.positive_id());
+                        ids(osmium::item_type::way).set(way.positive_id());
+                        for (const auto& node_ref : way.nodes()) {
+                            if (node_ref.ref() > 0) {
+                                ids(osmium::item_type::node).set(node_ref.positive_ref());
+                            }
+                        }
+                    }
+                }
+                for (const auto& relation : buffer.select<osmium::Relation>()) {
+                    if (relation.id() <= 0) {
+                        continue;
+                    }
+                    for (const auto& member : relation.members()) {
+                        if (member.ref() <= 0) {
+                            continue;
+                        }
+                        if ((member.type() == osmium::item_type::node && nodes_in_box.get(member.positive_ref())) ||
+                            (member.type() == osmium::item_type::way && ways.get(member.positive_ref()))) {
+                            ids(osmium::item_type::relation).set(relation.positive_id());
+                            break;
+                        }
+                    }
+                }
+            }
+            reader.close();
+
+            ids(osmium::item_type::node).sort_unique();
+            ids(osmium::item_type::way).sort_unique();
+            ids(osmium::item_type::relation).sort_unique();
+
+            return ids;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BBOX_HPP
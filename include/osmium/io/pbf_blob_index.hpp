@@ -0,0 +1,638 @@
+#ifndef OSMIUM_IO_PBF_BLOB_INDEX_HPP
+#define OSMIUM_IO_PBF_BLOB_INDEX_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_input_format.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/reader_options.hpp>
+#include <osmium/io/writer_options.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <protozero/data_view.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Where the boundaries between shards of a PBF file can be, see
+         * PBFBlobIndex::partition().
+         */
+        enum class shard_boundaries {
+            /// Between any two blobs. Each shard is one contiguous range.
+            blobs        = 0,
+            /// The blobs of each entity type are partitioned separately,
+            /// each shard gets a part of the nodes, the ways, and the
+            /// relations.
+            entity_types = 1
+        };
+
+        /**
+         * Index of the data blobs in a PBF file. For each blob it contains
+         * the offset and size in the file, the types of the OSM entities
+         * in it, the range of their IDs and the bounding box of the nodes.
+         *
+         * Use build() to create the index in one pass over the file. The
+         * index can be stored in a sidecar file with write() and read back
+         * with read(). Use select() to get an osmium::io::blob_selection
+         * which can be given to the osmium::io::Reader to only read the
+         * selected blobs.
+         *
+         * The sidecar file is written in the native byte order.
+         */
+        class PBFBlobIndex {
+
+        public:
+
+            struct entry {
+
+                /// Offset of the blob in the file.
+                std::size_t offset = 0;
+
+                /// Size of the blob in the file including its BlobHeader.
+                std::size_t size = 0;
+
+                /// Types of the OSM entities in this blob.
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+                /// Smallest ID of any entity in this blob.
+                osmium::object_id_type min_id = std::numeric_limits<osmium::object_id_type>::max();
+
+                /// Largest ID of any entity in this blob.
+                osmium::object_id_type max_id = std::numeric_limits<osmium::object_id_type>::min();
+
+                /// Bounding box of all nodes in this blob.
+                osmium::Box bbox{};
+
+            }; // struct entry
+
+            /**
+             * A part of a PBF file created by partition(). Give the
+             * selection to an osmium::io::Reader to read only the blobs
+             * in this shard. The header is always read, so all shards
+             * see the same header.
+             */
+            struct shard {
+
+                /// The blobs in this shard. Empty shards select nothing.
+                osmium::io::blob_selection selection{std::vector<std::size_t>{}};
+
+                /// Byte ranges (offset and size) of the blobs in this
+                /// shard in file order. Adjacent blobs are merged.
+                std::vector<std::pair<std::size_t, std::size_t>> ranges;
+
+                /// Number of blobs in this shard.
+                std::size_t num_blobs = 0;
+
+                /// Size of all blobs in this shard in bytes.
+                std::size_t bytes = 0;
+
+                /// Types of the OSM entities in this shard (if known).
+                osmium::osm_entity_bits::type types = osmium::osm_entity_bits::nothing;
+
+            }; // struct shard
+
+        private:
+
+            enum {
+                sidecar_version = 1
+            };
+
+            static const char* sidecar_magic() noexcept {
+                return "OSMPBFIX";
+            }
+
+            static constexpr const std::size_t magic_size = 8;
+
+            struct sidecar_entry {
+                uint64_t offset;
+                uint64_t size;
+                uint32_t types;
+                uint32_t reserved;
+                int64_t min_id;
+                int64_t max_id;
+                int32_t bbox[4];
+            };
+
+            std::vector<entry> m_entries;
+
+            template <typename T>
+            static bool any_id_in_range(const osmium::index::IdSetSmall<T>& ids, osmium::object_id_type min_id, osmium::object_id_type max_id) {
+                if (std::is_unsigned<T>::value) {
+                    if (max_id < 0) {
+                        return false;
+                    }
+                    min_id = std::max(min_id, osmium::object_id_type{0});
+                }
+                const auto it = std::lower_bound(ids.cbegin(), ids.cend(), static_cast<T>(min_id));
+                return it != ids.cend() && *it <= static_cast<T>(max_id);
+            }
+
+            static bool intersects(const osmium::Box& a, const osmium::Box& b) noexcept {
+                return a.bottom_left().x() <= b.top_right().x() && b.bottom_left().x() <= a.top_right().x() &&
+                       a.bottom_left().y() <= b.top_right().y() && b.bottom_left().y() <= a.top_right().y();
+            }
+
+            static void add_to_entry(entry& e, const osmium::memory::Buffer& buffer) {
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    e.types |= osmium::osm_entity_bits::from_item_type(object.type());
+                    e.min_id = std::min(e.min_id, object.id());
+                    e.max_id = std::max(e.max_id, object.id());
+                    if (object.type() == osmium::item_type::node) {
+                        e.bbox.extend(static_cast<const osmium::Node&>(object).location());
+                    }
+                }
+            }
+
+            static entry index_blob(std::size_t offset, std::size_t size, const char* data, std::size_t data_size) {
+                entry e;
+                e.offset = offset;
+                e.size = size;
+
+                osmium::io::detail::PBFDataBlobDecoder decoder{std::string{data, data_size}, osmium::osm_entity_bits::all, osmium::io::read_meta::no};
+                auto buffer = decoder();
+                while (buffer.has_nested_buffers()) {
+                    add_to_entry(e, *buffer.get_last_nested());
+                }
+                add_to_entry(e, buffer);
+
+                return e;
+            }
+
+            // Distribute the given entries into the shards so that each
+            // shard gets a contiguous part of them with about the same
+            // number of bytes. Each entry goes to the shard the middle of
+            // the entry falls into.
+            void partition_entries(const std::vector<std::size_t>& entries, std::vector<std::vector<std::size_t>>& shard_entries) const {
+                uint64_t total = 0;
+                for (const auto n : entries) {
+                    total += m_entries[n].size;
+                }
+                if (total == 0) {
+                    for (const auto n : entries) {
+                        shard_entries.front().push_back(n);
+                    }
+                    return;
+                }
+
+                const uint64_t num_shards = shard_entries.size();
+                uint64_t before = 0;
+                for (const auto n : entries) {
+                    const uint64_t size = m_entries[n].size;
+                    const auto num = std::min(static_cast<std::size_t>((2 * before + size) * num_shards / (2 * total)), shard_entries.size() - 1);
+                    shard_entries[num].push_back(n);
+                    before += size;
+                }
+            }
+
+            shard make_shard(std::vector<std::size_t>& entries) const {
+                std::sort(entries.begin(), entries.end());
+                shard result;
+                std::vector<std::size_t> offsets;
+                offsets.reserve(entries.size());
+                for (const auto n : entries) {
+                    const auto& e = m_entries[n];
+                    if (!result.ranges.empty() && result.ranges.back().first + result.ranges.back().second == e.offset) {
+                        result.ranges.back().second += e.size;
+                    } else {
+                        result.ranges.emplace_back(e.offset, e.size);
+                    }
+                    offsets.push_back(e.offset);
+                    result.bytes += e.size;
+                    result.types |= e.types;
+                }
+                result.num_blobs = offsets.size();
+                result.selection = osmium::io::blob_selection{std::move(offsets)};
+                return result;
+            }
+
+        public:
+
+            PBFBlobIndex() = default;
+
+            /**
+             * Build the index for the given PBF file by reading all blobs
+             * in it.
+             *
+             * @param filename Name of the (uncompressed) PBF file.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             * @throws std::system_error If the file could not be opened.
+             */
+            static PBFBlobIndex build(const std::string& filename) {
+                PBFBlobIndex index;
+
+                const auto file_size = osmium::file_size(filename);
+                if (file_size == 0) {
+                    return index;
+                }
+
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                osmium::util::MemoryMapping mapping{file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                osmium::io::detail::reliable_close(fd);
+
+                osmium::io::detail::for_each_pbf_blob(mapping.get_addr<const char>(), file_size, [&index](std::size_t offset, std::size_t size, const protozero::data_view& blob) {
+                    if (offset != 0) {
+                        index.m_entries.push_back(index_blob(offset, size, blob.data(), blob.size()));
+                    }
+                });
+
+                return index;
+            }
+
+            /**
+             * Build an index for the given PBF file which only contains
+             * the offsets and sizes of the blobs. Only the BlobHeaders are
+             * read, the blobs are not decompressed or decoded, so this is
+             * much faster than build(). The index can be used for
+             * partition() with shard_boundaries::blobs, but not for
+             * selecting blobs by their contents.
+             *
+             * @param filename Name of the (uncompressed) PBF file.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             * @throws std::system_error If the file could not be opened.
+             */
+            static PBFBlobIndex scan(const std::string& filename) {
+                PBFBlobIndex index;
+
+                const auto file_size = osmium::file_size(filename);
+                if (file_size == 0) {
+                    return index;
+                }
+
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                osmium::util::MemoryMapping mapping{file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd};
+                osmium::io::detail::reliable_close(fd);
+
+                osmium::io::detail::for_each_pbf_blob(mapping.get_addr<const char>(), file_size, [&index](std::size_t offset, std::size_t size, const protozero::data_view& /*blob*/) {
+                    if (offset != 0) {
+                        entry e;
+                        e.offset = offset;
+                        e.size = size;
+                        index.m_entries.push_back(e);
+                    }
+                });
+
+                return index;
+            }
+
+            /**
+             * Read index from a sidecar file written by write().
+             *
+             * @throws osmium::io_error If the file is not a valid index file.
+             * @throws std::system_error If the file could not be opened.
+             */
+            static PBFBlobIndex read(const std::string& filename) {
+                const int fd = osmium::io::detail::open_for_reading(filename);
+                const auto file_size = osmium::file_size(fd);
+                std::string data(file_size, '\0');
+                std::size_t done = 0;
+                while (done < file_size) {
+                    const auto max_read = static_cast<unsigned int>(std::min(file_size - done, static_cast<std::size_t>(1024 * 1024)));
+                    const auto nread = osmium::io::detail::reliable_read(fd, &data[done], max_read);
+                    if (nread == 0) {
+                        break;
+                    }
+                    done += static_cast<std::size_t>(nread);
+                }
+                osmium::io::detail::reliable_close(fd);
+
+                if (done != file_size ||
+                    file_size < magic_size + sizeof(uint32_t) ||
+                    std::memcmp(data.data(), sidecar_magic(), magic_size) != 0) {
+                    throw osmium::io_error{"invalid PBF blob index file '" + filename + "'"};
+                }
+
+                uint32_t version;
+                std::memcpy(&version, data.data() + magic_size, sizeof(version));
+                const std::size_t entries_offset = magic_size + sizeof(version);
+                if (version != sidecar_version || (file_size - entries_offset) % sizeof(sidecar_entry) != 0) {
+                    throw osmium::io_error{"invalid PBF blob index file '" + filename + "'"};
+                }
+
+                PBFBlobIndex index;
+                const auto num_entries = (file_size - entries_offset) / sizeof(sidecar_entry);
+                index.m_entries.reserve(num_entries);
+                for (std::size_t i = 0; i < num_entries; ++i) {
+                    sidecar_entry se;
+                    std::memcpy(&se, data.data() + entries_offset + i * sizeof(sidecar_entry), sizeof(sidecar_entry));
+                    entry e;
+                    e.offset = static_cast<std::size_t>(se.offset);
+                    e.size = static_cast<std::size_t>(se.size);
+                    e.types = static_cast<osmium::osm_entity_bits::type>(se.types);
+                    e.min_id = se.min_id;
+                    e.max_id = se.max_id;
+                    e.bbox = osmium::Box{osmium::Location{se.bbox[0], se.bbox[1]},
+                                         osmium::Location{se.bbox[2], se.bbox[3]}};
+                    index.m_entries.push_back(e);
+                }
+
+                return index;
+            }
+
+            /**
+             * Write index to a sidecar file.
+             *
+             * @throws std::system_error If the file could not be written.
+             */
+            void write(const std::string& filename, osmium::io::overwrite allow_overwrite = osmium::io::overwrite::no) const {
+                std::string data{sidecar_magic(), magic_size};
+                const uint32_t version = sidecar_version;
+                data.append(reinterpret_cast<const char*>(&version), sizeof(version));
+
+                for (const auto& e : m_entries) {
+                    sidecar_entry se{};
+                    se.offset = e.offset;
+                    se.size = e.size;
+                    se.types = static_cast<uint32_t>(e.types);
+                    se.min_id = e.min_id;
+                    se.max_id = e.max_id;
+                    se.bbox[0] = e.bbox.bottom_left().x();
+                    se.bbox[1] = e.bbox.bottom_left().y();
+                    se.bbox[2] = e.bbox.top_right().x();
+                    se.bbox[3] = e.bbox.top_right().y();
+                    data.append(reinterpret_cast<const char*>(&se), sizeof(se));
+                }
+
+                const int fd = osmium::io::detail::open_for_writing(filename, allow_overwrite);
+                osmium::io::detail::reliable_write(fd, data.data(), data.size());
+                osmium::io::detail::reliable_close(fd);
+            }
+
+            /**
+             * Add an entry to the index. Entries must be added in file
+             * order.
+             */
+            void add(const entry& e) {
+                assert(m_entries.empty() || m_entries.back().offset < e.offset);
+                m_entries.push_back(e);
+            }
+
+            /// The number of data blobs in the index.
+            std::size_t size() const noexcept {
+                return m_entries.size();
+            }
+
+            bool empty() const noexcept {
+                return m_entries.empty();
+            }
+
+            /// The entries in the index in file order.
+            const std::vector<entry>& entries() const noexcept {
+                return m_entries;
+            }
+
+            std::vector<entry>::const_iterator begin() const noexcept {
+                return m_entries.cbegin();
+            }
+
+            std::vector<entry>::const_iterator end() const noexcept {
+                return m_entries.cend();
+            }
+
+            /**
+             * Select all blobs for which the predicate returns true.
+             *
+             * @tparam TPredicate Function object taking a const entry&
+             *                    and returning bool.
+             */
+            template <typename TPredicate>
+            osmium::io::blob_selection select_if(TPredicate&& predicate) const {
+                std::vector<std::size_t> offsets;
+                for (const auto& e : m_entries) {
+                    if (predicate(e)) {
+                        offsets.push_back(e.offset);
+                    }
+                }
+                return osmium::io::blob_selection{std::move(offsets)};
+            }
+
+            /**
+             * Select all blobs containing at least one entity of the given
+             * types with an ID in the range first_id to last_id (inclusive).
+             */
+            osmium::io::blob_selection select(osmium::osm_entity_bits::type types,
+                                              osmium::object_id_type first_id = std::numeric_limits<osmium::object_id_type>::min(),
+                                              osmium::object_id_type last_id = std::numeric_limits<osmium::object_id_type>::max()) const {
+                return select_if([types, first_id, last_id](const entry& e) {
+                    return (e.types & types) != 0 && e.min_id <= last_id && e.max_id >= first_id;
+                });
+            }
+
+            /**
+             * Select all blobs with nodes whose bounding box intersects
+             * the given box. Blobs with ways or relations can not be
+             * checked this way, so they are always selected. This works
+             * best for spatially sorted files (see the "pbf_spatial_sort"
+             * output option), in files sorted by ID the nodes in each
+             * blob are usually spread over a large area.
+             *
+             * Use osmium::io::ids_in_bbox() to also get the ways and
+             * relations referencing the nodes in the box.
+             *
+             * @pre @code box.valid() @endcode
+             */
+            osmium::io::blob_selection select(const osmium::Box& box) const {
+                return select_if([&box](const entry& e) {
+                    if ((e.types & (osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation)) != 0) {
+                        return true;
+                    }
+                    return (e.types & osmium::osm_entity_bits::node) != 0 && e.bbox.valid() && intersects(e.bbox, box);
+                });
+            }
+
+            /**
+             * Select all blobs which might contain an entity of the given
+             * type with one of the IDs in the set. This is used to read
+             * all versions of some objects from a history file: Because
+             * the blob ID ranges are inclusive, objects whose versions
+             * are spread over several blobs are found in all of them.
+             *
+             * The selected blobs can contain other objects, too, use
+             * ids.get_binary_search() to filter the objects read.
+             *
+             * @pre You must have called ids.sort_unique().
+             */
+            template <typename T>
+            osmium::io::blob_selection select(osmium::item_type type, const osmium::index::IdSetSmall<T>& ids) const {
+                const auto types = osmium::osm_entity_bits::from_item_type(type);
+                return select_if([types, &ids](const entry& e) {
+                    return (e.types & types) != 0 && any_id_in_range(ids, e.min_id, e.max_id);
+                });
+            }
+
+            /**
+             * Select all blobs which might contain a node, way, or
+             * relation with one of the IDs in the set for its type.
+             *
+             * @pre You must have called sort_unique() on all sets.
+             */
+            template <typename T>
+            osmium::io::blob_selection select(const osmium::nwr_array<osmium::index::IdSetSmall<T>>& ids) const {
+                return select_if([&ids](const entry& e) {
+                    for (const auto type : {osmium::item_type::node, osmium::item_type::way, osmium::item_type::relation}) {
+                        if ((e.types & osmium::osm_entity_bits::from_item_type(type)) != 0 &&
+                            any_id_in_range(ids(type), e.min_id, e.max_id)) {
+                            return true;
+                        }
+                    }
+                    return false;
+                });
+            }
+
+            /**
+             * Split the file into num_shards parts of about the same size
+             * in bytes along blob boundaries. Each shard can then be read
+             * by a different process or on a different machine with
+             * @code
+             * osmium::io::Reader reader{filename, shards[k].selection};
+             * @endcode
+             *
+             * With shard_boundaries::blobs each shard is a contiguous
+             * range of blobs and the shards are in file order, so
+             * concatenating the (ordered) output of all shards in shard
+             * order keeps the order of the input file.
+             *
+             * With shard_boundaries::entity_types the blobs with nodes,
+             * ways, and relations are partitioned separately, and shard k
+             * gets part k of each of them. This balances the different
+             * kinds of work between the shards. Each blob is assigned by
+             * the first type of entities in it. This needs an index
+             * created with build() or read from a sidecar file.
+             *
+             * Some shards can be empty if there are fewer blobs than
+             * shards.
+             *
+             * @param num_shards Number of shards.
+             * @param boundaries Where the shard boundaries can be.
+             * @returns Vector with num_shards shards.
+             * @throws std::invalid_argument If num_shards is 0 or the
+             *         index doesn't have the entity types needed for
+             *         shard_boundaries::entity_types.
+             */
+            std::vector<shard> partition(std::size_t num_shards, shard_boundaries boundaries = shard_boundaries::blobs) const {
+                if (num_shards == 0) {
+                    throw std::invalid_argument{"Number of shards must be at least 1"};
+                }
+
+                std::vector<std::vector<std::size_t>> shard_entries(num_shards);
+
+                if (boundaries == shard_boundaries::blobs) {
+                    std::vector<std::size_t> entries(m_entries.size());
+                    for (std::size_t n = 0; n < entries.size(); ++n) {
+                        entries[n] = n;
+                    }
+                    partition_entries(entries, shard_entries);
+                } else {
+                    if (!m_entries.empty() && std::all_of(m_entries.cbegin(), m_entries.cend(), [](const entry& e) {
+                            return e.types == osmium::osm_entity_bits::nothing;
+                        })) {
+                        throw std::invalid_argument{"Partitioning by entity types needs an index with entity types"};
+                    }
+
+                    // Nodes, ways, relations, and everything else.
+                    std::vector<std::size_t> entries_by_type[4];
+                    for (std::size_t n = 0; n < m_entries.size(); ++n) {
+                        const auto types = m_entries[n].types;
+                        if (types & osmium::osm_entity_bits::node) {
+                            entries_by_type[0].push_back(n);
+                        } else if (types & osmium::osm_entity_bits::way) {
+                            entries_by_type[1].push_back(n);
+                        } else if (types & osmium::osm_entity_bits::relation) {
+                            entries_by_type[2].push_back(n);
+                        } else {
+                            entries_by_type[3].push_back(n);
+                        }
+                    }
+                    for (const auto& entries : entries_by_type) {
+                        partition_entries(entries, shard_entries);
+                    }
+                }
+
+                std::vector<shard> shards;
+                shards.reserve(num_shards);
+                for (auto& entries : shard_entries) {
+                    shards.push_back(make_shard(entries));
+                }
+
+                return shards;
+            }
+
+            /**
+             * Get shard number shard_num (counting from 0) of num_shards
+             * shards. See partition() for details.
+             *
+             * @throws std::invalid_argument If shard_num >= num_shards
+             *         or for the reasons listed in partition().
+             */
+            shard get_shard(std::size_t shard_num, std::size_t num_shards, shard_boundaries boundaries = shard_boundaries::blobs) const {
+                if (shard_num >= num_shards) {
+                    throw std::invalid_argument{"Shard number must be smaller than number of shards"};
+                }
+                return std::move(partition(num_shards, boundaries)[shard_num]);
+            }
+
+        }; // class PBFBlobIndex
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BLOB_INDEX_HPP
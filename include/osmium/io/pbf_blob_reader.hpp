@@ -0,0 +1,281 @@
+#ifndef OSMIUM_IO_PBF_BLOB_READER_HPP
+#define OSMIUM_IO_PBF_BLOB_READER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_input_format.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/file_format.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/writer.hpp>
+
+#include <protozero/data_view.hpp>
+#include <protozero/pbf_message.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Reads the blobs of a PBF file one after the other without
+         * decoding them. Only the header blob is decoded. Use this
+         * together with osmium::io::Writer::write_raw() to copy blobs
+         * from one PBF file to another without decoding and encoding the
+         * objects in them. Check with pbf_raw_blobs_compatible() first
+         * that the blobs fit into the output file.
+         *
+         * @code
+         * osmium::io::PBFBlobReader reader{"input.osm.pbf"};
+         * const osmium::io::File output{"output.osm.pbf"};
+         * if (osmium::io::pbf_raw_blobs_compatible(reader.header(), output)) {
+         *     osmium::io::Writer writer{output, reader.header()};
+         *     osmium::io::copy_pbf_blobs(reader, writer);
+         *     writer.close();
+         * }
+         * @endcode
+         */
+        class PBFBlobReader {
+
+            int m_fd;
+
+            osmium::io::Header m_header{};
+
+            // Offset of the next blob in the file.
+            std::size_t m_offset = 0;
+
+            // Offset of the blob returned last by read().
+            std::size_t m_last_offset = 0;
+
+            // Read exactly size bytes. Returns false if the end of the file
+            // was reached before reading anything.
+            bool read_exactly(char* data, std::size_t size) {
+                std::size_t done = 0;
+                while (done < size) {
+                    const auto max_read = static_cast<unsigned int>(std::min(size - done, static_cast<std::size_t>(1024 * 1024)));
+                    const auto nread = osmium::io::detail::reliable_read(m_fd, data + done, max_read);
+                    if (nread == 0) {
+                        if (done == 0) {
+                            return false;
+                        }
+                        throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                    }
+                    done += static_cast<std::size_t>(nread);
+                }
+                return true;
+            }
+
+            // Read the next blob including its size and BlobHeader into
+            // data. Returns the offset of the Blob message in data or 0 at
+            // the end of the file.
+            std::size_t read_blob(std::string& data, const char* expected_type) {
+                data.resize(sizeof(uint32_t));
+                if (!read_exactly(&data[0], sizeof(uint32_t))) {
+                    data.clear();
+                    return 0;
+                }
+
+                const auto header_size = osmium::io::detail::decode_blob_header_size(data.data());
+                if (header_size > static_cast<uint32_t>(osmium::io::detail::max_blob_header_size)) {
+                    throw osmium::pbf_error{"invalid BlobHeader size (> max_blob_header_size)"};
+                }
+                data.resize(sizeof(uint32_t) + header_size);
+                if (!read_exactly(&data[sizeof(uint32_t)], header_size)) {
+                    throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                }
+
+                const std::size_t blob_size = osmium::io::detail::decode_blob_header(protozero::pbf_message<FileFormat::BlobHeader>{data.data() + sizeof(uint32_t), header_size}, expected_type);
+                if (blob_size > osmium::io::detail::max_uncompressed_blob_size) {
+                    throw osmium::pbf_error{"invalid Blob size (> max_uncompressed_blob_size)"};
+                }
+                const std::size_t blob_offset = data.size();
+                data.resize(blob_offset + blob_size);
+                if (!read_exactly(&data[blob_offset], blob_size)) {
+                    throw osmium::pbf_error{"truncated data (EOF encountered)"};
+                }
+
+                m_last_offset = m_offset;
+                m_offset += data.size();
+                return blob_offset;
+            }
+
+        public:
+
+            /**
+             * Open the PBF file and read its header.
+             *
+             * @param filename Name of the (uncompressed) PBF file.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             * @throws std::system_error If the file could not be opened.
+             */
+            explicit PBFBlobReader(const std::string& filename) :
+                m_fd(osmium::io::detail::open_for_reading(filename)) {
+                try {
+                    std::string data;
+                    const auto blob_offset = read_blob(data, "OSMHeader");
+                    if (blob_offset == 0) {
+                        throw osmium::pbf_error{"empty file"};
+                    }
+                    m_header = osmium::io::detail::decode_header(protozero::data_view{data.data() + blob_offset, data.size() - blob_offset});
+                } catch (...) {
+                    close();
+                    throw;
+                }
+            }
+
+            PBFBlobReader(const PBFBlobReader&) = delete;
+            PBFBlobReader& operator=(const PBFBlobReader&) = delete;
+
+            PBFBlobReader(PBFBlobReader&&) = delete;
+            PBFBlobReader& operator=(PBFBlobReader&&) = delete;
+
+            ~PBFBlobReader() noexcept {
+                try {
+                    close();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
+            /// The header of the file.
+            const osmium::io::Header& header() const noexcept {
+                return m_header;
+            }
+
+            /**
+             * Read the next data blob. The returned data contains the size
+             * of the BlobHeader, the BlobHeader, and the Blob, exactly as
+             * they are in the file.
+             *
+             * @returns The blob or an empty string at the end of the file.
+             * @throws osmium::pbf_error If the file is not a valid PBF file.
+             */
+            std::string read() {
+                std::string data;
+                if (m_fd >= 0) {
+                    read_blob(data, "OSMData");
+                }
+                return data;
+            }
+
+            /**
+             * The offset in the file of the blob returned by the last call
+             * to read(). This is the offset used in the PBFBlobIndex.
+             */
+            std::size_t offset() const noexcept {
+                return m_last_offset;
+            }
+
+            /**
+             * Close the file.
+             *
+             * @throws std::system_error If closing fails.
+             */
+            void close() {
+                const int fd = m_fd;
+                m_fd = -1;
+                osmium::io::detail::reliable_close(fd);
+            }
+
+        }; // class PBFBlobReader
+
+        /**
+         * Can the blobs of a PBF file with the given header be copied as
+         * they are into the output file? This checks that both are PBF
+         * files, that they agree on the features which change the meaning
+         * of the data ("HistoricalInformation" and "LocationsOnWays"), and
+         * that the output options don't need the decoded objects
+         * ("pbf_check_order" and "pbf_index_sidecar").
+         *
+         * Other options of the output file, such as the compression or
+         * "add_metadata", are not applied to copied blobs.
+         */
+        inline bool pbf_raw_blobs_compatible(const osmium::io::Header& input_header, const osmium::io::File& output) {
+            if (output.format() != osmium::io::file_format::pbf) {
+                return false;
+            }
+
+            if (input_header.has_multiple_object_versions() != output.has_multiple_object_versions()) {
+                return false;
+            }
+
+            bool input_locations_on_ways = false;
+            for (const auto& option : input_header) {
+                if (option.first.compare(0, 21, "pbf_optional_feature_") == 0 && option.second == "LocationsOnWays") {
+                    input_locations_on_ways = true;
+                }
+            }
+            if (input_locations_on_ways != output.is_true("locations_on_ways")) {
+                return false;
+            }
+
+            return !output.is_true("pbf_check_order") && output.get("pbf_index_sidecar").empty();
+        }
+
+        /**
+         * Copy all remaining blobs from the reader into the writer without
+         * decoding them.
+         *
+         * @returns The number of blobs copied.
+         * @throws osmium::io_error If the writer can not take raw blobs.
+         *         Check with pbf_raw_blobs_compatible() before.
+         * @throws osmium::pbf_error If the input is not a valid PBF file.
+         */
+        inline std::size_t copy_pbf_blobs(PBFBlobReader& reader, osmium::io::Writer& writer) {
+            std::size_t count = 0;
+            std::string data;
+            while (!(data = reader.read()).empty()) {
+                if (!writer.write_raw(std::move(data), osmium::io::file_format::pbf)) {
+                    throw osmium::io_error{"Writer can not write raw PBF blobs"};
+                }
+                ++count;
+            }
+            return count;
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_BLOB_READER_HPP
@@ -0,0 +1,389 @@
+#ifndef OSMIUM_IO_PBF_NODE_LOCATIONS_HPP
+#define OSMIUM_IO_PBF_NODE_LOCATIONS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/detail/pbf.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/pbf_input_format.hpp>
+#include <osmium/io/detail/pbf_packed.hpp>
+#include <osmium/io/detail/protobuf_tags.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+
+#include <protozero/data_view.hpp>
+#include <protozero/pbf_message.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * IDs and locations of the nodes from one blob of a PBF file in
+         * columnar form. The i-th entry in each vector belongs to the same
+         * node. The nodes are in the same order as in the file.
+         */
+        struct node_locations_block {
+
+            std::vector<osmium::object_id_type> ids;
+            std::vector<osmium::Location> locations;
+
+            /// Does the node have any tags?
+            std::vector<bool> has_tags;
+
+            std::size_t size() const noexcept {
+                return ids.size();
+            }
+
+            bool empty() const noexcept {
+                return ids.empty();
+            }
+
+        }; // struct node_locations_block
+
+        namespace detail {
+
+            /**
+             * Decodes only the IDs and locations of nodes in a PBF blob
+             * without creating any OSM objects. Blobs without nodes result
+             * in an empty block.
+             */
+            class PBFNodeLocationsDecoder {
+
+                // Owner of the memory the blob data is in.
+                std::shared_ptr<const void> m_input_buffer;
+                protozero::data_view m_input_data;
+
+                int64_t m_lon_offset = 0;
+                int64_t m_lat_offset = 0;
+                int64_t m_granularity = 100;
+
+                std::vector<int64_t> m_ids;
+                std::vector<int64_t> m_lats;
+                std::vector<int64_t> m_lons;
+
+                osmium::Location make_location(int64_t lon, int64_t lat) const noexcept {
+                    return osmium::Location{
+                        static_cast<int32_t>((lon * m_granularity + m_lon_offset) / resolution_convert),
+                        static_cast<int32_t>((lat * m_granularity + m_lat_offset) / resolution_convert)
+                    };
+                }
+
+                static std::vector<bool> decode_dense_visibles(const protozero::data_view& data) {
+                    std::vector<bool> visibles;
+                    protozero::pbf_message<OSMFormat::DenseInfo> pbf_dense_info{data};
+                    while (pbf_dense_info.next(OSMFormat::DenseInfo::packed_bool_visible, protozero::pbf_wire_type::length_delimited)) {
+                        for (const auto visible : pbf_dense_info.get_packed_bool()) {
+                            visibles.push_back(visible != 0);
+                        }
+                    }
+                    return visibles;
+                }
+
+                void decode_dense_nodes(const protozero::data_view& data, node_locations_block& block) {
+                    protozero::data_view ids;
+                    protozero::data_view lats;
+                    protozero::data_view lons;
+                    protozero::iterator_range<protozero::pbf_reader::const_int32_iterator> tags;
+                    std::vector<bool> visibles;
+
+                    protozero::pbf_message<OSMFormat::DenseNodes> pbf_dense_nodes{data};
+                    while (pbf_dense_nodes.next()) {
+                        switch (pbf_dense_nodes.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_id, protozero::pbf_wire_type::length_delimited):
+                                ids = pbf_dense_nodes.get_view();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::optional_DenseInfo_denseinfo, protozero::pbf_wire_type::length_delimited):
+                                visibles = decode_dense_visibles(pbf_dense_nodes.get_view());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lat, protozero::pbf_wire_type::length_delimited):
+                                lats = pbf_dense_nodes.get_view();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_sint64_lon, protozero::pbf_wire_type::length_delimited):
+                                lons = pbf_dense_nodes.get_view();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::DenseNodes::packed_int32_keys_vals, protozero::pbf_wire_type::length_delimited):
+                                tags = pbf_dense_nodes.get_packed_int32();
+                                break;
+                            default:
+                                pbf_dense_nodes.skip();
+                        }
+                    }
+
+                    decode_packed_sint64(ids.data(), ids.size(), m_ids);
+                    decode_packed_sint64(lats.data(), lats.size(), m_lats);
+                    decode_packed_sint64(lons.data(), lons.size(), m_lons);
+
+                    if (m_lats.size() < m_ids.size() ||
+                        m_lons.size() < m_ids.size()) {
+                        // this is against the spec, must have same number of elements
+                        throw osmium::pbf_error{"PBF format error"};
+                    }
+
+                    delta_decode_in_place(m_ids);
+                    delta_decode_in_place(m_lats);
+                    delta_decode_in_place(m_lons);
+
+                    auto tag_it = tags.begin();
+                    for (std::size_t i = 0; i < m_ids.size(); ++i) {
+                        block.ids.push_back(m_ids[i]);
+
+                        const bool visible = i >= visibles.size() || visibles[i];
+                        block.locations.push_back(visible ? make_location(m_lons[i], m_lats[i]) : osmium::Location{});
+
+                        // The keys_vals field contains key and value string
+                        // ids for each node terminated by a 0.
+                        bool has_tags = false;
+                        while (tag_it != tags.end()) {
+                            if (*tag_it++ == 0) {
+                                break;
+                            }
+                            has_tags = true;
+                            if (tag_it == tags.end()) {
+                                throw osmium::pbf_error{"PBF format error"};
+                            }
+                            ++tag_it;
+                        }
+                        block.has_tags.push_back(has_tags);
+                    }
+                }
+
+                void decode_node(const protozero::data_view& data, node_locations_block& block) {
+                    osmium::object_id_type id = 0;
+                    int64_t lon = std::numeric_limits<int64_t>::max();
+                    int64_t lat = std::numeric_limits<int64_t>::max();
+                    bool has_tags = false;
+                    bool visible = true;
+
+                    protozero::pbf_message<OSMFormat::Node> pbf_node{data};
+                    while (pbf_node.next()) {
+                        switch (pbf_node.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_id, protozero::pbf_wire_type::varint):
+                                id = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::packed_uint32_keys, protozero::pbf_wire_type::length_delimited):
+                                has_tags = !pbf_node.get_view().empty();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::optional_Info_info, protozero::pbf_wire_type::length_delimited):
+                                {
+                                    protozero::pbf_message<OSMFormat::Info> pbf_info{pbf_node.get_view()};
+                                    while (pbf_info.next(OSMFormat::Info::optional_bool_visible, protozero::pbf_wire_type::varint)) {
+                                        visible = pbf_info.get_bool();
+                                    }
+                                }
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lat, protozero::pbf_wire_type::varint):
+                                lat = pbf_node.get_sint64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::Node::required_sint64_lon, protozero::pbf_wire_type::varint):
+                                lon = pbf_node.get_sint64();
+                                break;
+                            default:
+                                pbf_node.skip();
+                        }
+                    }
+
+                    block.ids.push_back(id);
+                    const bool has_location = visible &&
+                                              lon != std::numeric_limits<int64_t>::max() &&
+                                              lat != std::numeric_limits<int64_t>::max();
+                    block.locations.push_back(has_location ? make_location(lon, lat) : osmium::Location{});
+                    block.has_tags.push_back(has_tags);
+                }
+
+                void decode_primitive_group(const protozero::data_view& data, node_locations_block& block) {
+                    protozero::pbf_message<OSMFormat::PrimitiveGroup> pbf_primitive_group{data};
+                    while (pbf_primitive_group.next()) {
+                        switch (pbf_primitive_group.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::repeated_Node_nodes, protozero::pbf_wire_type::length_delimited):
+                                decode_node(pbf_primitive_group.get_view(), block);
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveGroup::optional_DenseNodes_dense, protozero::pbf_wire_type::length_delimited):
+                                decode_dense_nodes(pbf_primitive_group.get_view(), block);
+                                break;
+                            default:
+                                // Anything but nodes ends the group.
+                                return;
+                        }
+                    }
+                }
+
+            public:
+
+                PBFNodeLocationsDecoder(std::shared_ptr<const void> input_buffer, const protozero::data_view& input_data) :
+                    m_input_buffer(std::move(input_buffer)),
+                    m_input_data(input_data) {
+                }
+
+                node_locations_block operator()() {
+                    node_locations_block block;
+
+                    // The first group tells us whether there are any nodes
+                    // in this blob, don't decompress the blob otherwise.
+                    const auto type = decode_blob_first_group_type(m_input_data);
+                    if (type != osmium::item_type::node && type != osmium::item_type::undefined) {
+                        return block;
+                    }
+
+                    const auto data = decode_blob(m_input_data, thread_decode_buffers().inflate_buffer);
+
+                    std::vector<protozero::data_view> groups;
+                    protozero::pbf_message<OSMFormat::PrimitiveBlock> pbf_primitive_block{data};
+                    while (pbf_primitive_block.next()) {
+                        switch (pbf_primitive_block.tag_and_type()) {
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::repeated_PrimitiveGroup_primitivegroup, protozero::pbf_wire_type::length_delimited):
+                                groups.push_back(pbf_primitive_block.get_view());
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int32_granularity, protozero::pbf_wire_type::varint):
+                                m_granularity = pbf_primitive_block.get_int32();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int64_lat_offset, protozero::pbf_wire_type::varint):
+                                m_lat_offset = pbf_primitive_block.get_int64();
+                                break;
+                            case protozero::tag_and_type(OSMFormat::PrimitiveBlock::optional_int64_lon_offset, protozero::pbf_wire_type::varint):
+                                m_lon_offset = pbf_primitive_block.get_int64();
+                                break;
+                            default:
+                                pbf_primitive_block.skip();
+                        }
+                    }
+
+                    for (const auto& group : groups) {
+                        decode_primitive_group(group, block);
+                    }
+
+                    return block;
+                }
+
+            }; // class PBFNodeLocationsDecoder
+
+        } // namespace detail
+
+        /**
+         * Read the IDs and locations of all nodes in a PBF file
+         * without building any OSM objects. This is much faster than
+         * reading the file with the Reader if only the node locations are
+         * needed, for instance to fill a location index.
+         *
+         * The blobs are decoded in parallel in the thread pool, the
+         * function is called in the calling thread for each blob
+         * containing nodes in the order they appear in the file.
+         *
+         * @param filename Name of the PBF file.
+         * @param func Function called with a const node_locations_block&.
+         * @param pool Thread pool used for decoding.
+         * @throws osmium::pbf_error If the file is not a valid PBF file.
+         * @throws std::system_error If the file could not be opened.
+         */
+        template <typename TFunction>
+        void read_pbf_node_locations(const std::string& filename, TFunction&& func, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            const auto file_size = osmium::file_size(filename);
+            if (file_size == 0) {
+                throw osmium::pbf_error{"truncated data (EOF encountered)"};
+            }
+
+            const int fd = osmium::io::detail::open_for_reading(filename);
+            const auto mapping = std::make_shared<osmium::util::MemoryMapping>(file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd);
+            osmium::io::detail::reliable_close(fd);
+
+            const auto max_in_flight = 2 * static_cast<std::size_t>(pool.num_threads());
+            std::deque<std::future<node_locations_block>> in_flight;
+
+            const auto deliver = [&func](std::future<node_locations_block>& future) {
+                const auto block = future.get();
+                if (!block.empty()) {
+                    func(block);
+                }
+            };
+
+            osmium::io::detail::for_each_pbf_blob(mapping->get_addr<const char>(), file_size, [&](std::size_t offset, std::size_t /*size*/, const protozero::data_view& blob) {
+                if (offset == 0) {
+                    // Checks that we can understand this file.
+                    osmium::io::detail::decode_header(blob);
+                    return;
+                }
+                if (in_flight.size() >= max_in_flight) {
+                    deliver(in_flight.front());
+                    in_flight.pop_front();
+                }
+                in_flight.push_back(pool.submit(osmium::io::detail::PBFNodeLocationsDecoder{mapping, blob}));
+            });
+
+            for (auto& future : in_flight) {
+                deliver(future);
+            }
+        }
+
+        /**
+         * Read the IDs and locations of all nodes in a PBF file into a
+         * location index (for instance one of the
+         * osmium::index::map classes used with NodeLocationsForWays).
+         * Nodes without a valid location are not added.
+         *
+         * @param filename Name of the PBF file.
+         * @param index Index with a set(id, location) function.
+         * @param pool Thread pool used for decoding.
+         * @throws osmium::pbf_error If the file is not a valid PBF file.
+         * @throws std::system_error If the file could not be opened.
+         */
+        template <typename TIndex>
+        void read_pbf_node_locations_into(const std::string& filename, TIndex& index, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+            read_pbf_node_locations(filename, [&index](const node_locations_block& block) {
+                for (std::size_t i = 0; i < block.size(); ++i) {
+                    if (block.locations[i].valid()) {
+                        index.set(static_cast<osmium::unsigned_object_id_type>(block.ids[i]), block.locations[i]);
+                    }
+                }
+            }, pool);
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PBF_NODE_LOCATIONS_HPP
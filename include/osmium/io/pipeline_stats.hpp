@@ -0,0 +1,221 @@
+#ifndef OSMIUM_IO_PIPELINE_STATS_HPP
+#define OSMIUM_IO_PIPELINE_STATS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace osmium {
+
+    namespace io {
+
+        /**
+         * Thread-safe histogram of durations. Durations are counted in
+         * buckets by powers of two of microseconds: Bucket 0 counts
+         * durations below 1 microsecond, bucket n durations from 2^(n-1)
+         * up to 2^n microseconds. The last bucket also counts all longer
+         * durations.
+         */
+        class DurationHistogram {
+
+        public:
+
+            enum : std::size_t {
+                num_buckets = 32
+            };
+
+        private:
+
+            std::atomic<uint64_t> m_buckets[num_buckets];
+            std::atomic<uint64_t> m_count{0};
+            std::atomic<uint64_t> m_total{0};
+            std::atomic<uint64_t> m_max{0};
+
+            static std::size_t bucket_for(uint64_t nanoseconds) noexcept {
+                std::size_t n = 0;
+                for (uint64_t us = nanoseconds / 1000; us > 0 && n < num_buckets - 1; us >>= 1U) {
+                    ++n;
+                }
+                return n;
+            }
+
+        public:
+
+            DurationHistogram() noexcept {
+                for (auto& bucket : m_buckets) {
+                    bucket = 0;
+                }
+            }
+
+            DurationHistogram(const DurationHistogram&) = delete;
+            DurationHistogram& operator=(const DurationHistogram&) = delete;
+
+            DurationHistogram(DurationHistogram&&) = delete;
+            DurationHistogram& operator=(DurationHistogram&&) = delete;
+
+            ~DurationHistogram() noexcept = default;
+
+            /// Add a duration to the histogram.
+            void add(std::chrono::nanoseconds duration) noexcept {
+                const auto ns = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+                ++m_buckets[bucket_for(ns)];
+                ++m_count;
+                m_total += ns;
+                uint64_t max = m_max;
+                while (ns > max && !m_max.compare_exchange_weak(max, ns)) {
+                }
+            }
+
+            /// The number of durations added.
+            uint64_t count() const noexcept {
+                return m_count;
+            }
+
+            /// The sum of all durations.
+            std::chrono::nanoseconds total() const noexcept {
+                return std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(m_total.load())};
+            }
+
+            /// The longest duration.
+            std::chrono::nanoseconds max() const noexcept {
+                return std::chrono::nanoseconds{static_cast<std::chrono::nanoseconds::rep>(m_max.load())};
+            }
+
+            /// The number of durations in bucket n.
+            uint64_t bucket(std::size_t n) const noexcept {
+                return n < num_buckets ? m_buckets[n].load() : 0;
+            }
+
+        }; // class DurationHistogram
+
+        /**
+         * Timing and volume of the stages inside Readers and Writers. This
+         * is opt-in: Create an object of this class and give it to the
+         * Reader and/or Writer as option. It must outlive them. Several
+         * Readers and Writers can share one PipelineStats object, the
+         * numbers are then added up.
+         *
+         * All members can be read at any time from any thread. Comparing
+         * the totals tells where the time goes: Long waits in one stage
+         * mean that another stage is the bottleneck.
+         */
+        struct PipelineStats {
+
+            /// Number of bytes read from the input (after decompression).
+            std::atomic<uint64_t> bytes_read{0};
+
+            /// Time to read (and, if the file is compressed, decompress)
+            /// each chunk of input in the read thread.
+            DurationHistogram read{};
+
+            /// Time the read thread waited for space in the full input
+            /// queue, ie. the parser was the bottleneck.
+            DurationHistogram input_queue_wait{};
+
+            /// Time the parser waited for input, ie. reading was the
+            /// bottleneck.
+            DurationHistogram parser_input_wait{};
+
+            /// Time to inflate each compressed PBF blob.
+            DurationHistogram inflate{};
+
+            /// Time to decode each PBF block into a buffer.
+            DurationHistogram decode{};
+
+            /// Time Reader::read() waited for the next buffer, ie.
+            /// reading or parsing was the bottleneck.
+            DurationHistogram reader_wait{};
+
+            /// Time between Reader::read() calls, ie. the time the
+            /// application spent handling each buffer.
+            DurationHistogram handler{};
+
+            /// Time spent in the thread calling the Writer for each buffer
+            /// to encode it and to queue the result. This includes waits
+            /// for space in the output queue.
+            DurationHistogram encode{};
+
+            /// Time to write (and, if needed, compress) the data in the
+            /// write thread.
+            DurationHistogram write{};
+
+            /// Number of bytes written to the output (before compression).
+            std::atomic<uint64_t> bytes_written{0};
+
+        }; // struct PipelineStats
+
+        namespace detail {
+
+            /**
+             * Adds the time between its construction and destruction to a
+             * histogram in the PipelineStats. Does nothing if stats is a
+             * nullptr.
+             */
+            class stats_timer {
+
+                DurationHistogram* m_histogram;
+                std::chrono::steady_clock::time_point m_start{};
+
+            public:
+
+                stats_timer(PipelineStats* stats, DurationHistogram PipelineStats::* histogram) noexcept :
+                    m_histogram(stats ? &(stats->*histogram) : nullptr) {
+                    if (m_histogram) {
+                        m_start = std::chrono::steady_clock::now();
+                    }
+                }
+
+                stats_timer(const stats_timer&) = delete;
+                stats_timer& operator=(const stats_timer&) = delete;
+
+                stats_timer(stats_timer&&) = delete;
+                stats_timer& operator=(stats_timer&&) = delete;
+
+                ~stats_timer() noexcept {
+                    if (m_histogram) {
+                        m_histogram->add(std::chrono::steady_clock::now() - m_start);
+                    }
+                }
+
+            }; // class stats_timer
+
+        } // namespace detail
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_PIPELINE_STATS_HPP
@@ -0,0 +1,189 @@
+#ifndef OSMIUM_IO_READ_HEADER_HPP
+#define OSMIUM_IO_READ_HEADER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/input_format.hpp>
+#include <osmium/io/detail/queue_util.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/io/reader_options.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    namespace io {
+
+        namespace detail {
+
+            /**
+             * Feeds the input queue of a parser running in the current
+             * thread. Each element in the queue is a deferred future which
+             * reads the next chunk of data from the decompressor when the
+             * parser asks for it and then adds the next element. Once the
+             * header is available (or stop() was called) the end of data
+             * is reported, so the rest of the file is never read.
+             */
+            class header_probe_input {
+
+                osmium::io::Decompressor& m_decompressor;
+                future_string_queue_type& m_queue;
+                const std::future<osmium::io::Header>& m_header;
+                bool m_done = false;
+
+                bool header_available() const {
+                    return m_header.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                }
+
+                std::string next_chunk() {
+                    if (m_done || header_available()) {
+                        return std::string{};
+                    }
+                    std::string data{m_decompressor.read()};
+                    if (!data.empty()) {
+                        add_next();
+                    }
+                    return data;
+                }
+
+            public:
+
+                header_probe_input(osmium::io::Decompressor& decompressor,
+                                   future_string_queue_type& queue,
+                                   const std::future<osmium::io::Header>& header) :
+                    m_decompressor(decompressor),
+                    m_queue(queue),
+                    m_header(header) {
+                }
+
+                void add_next() {
+                    m_queue.push(std::async(std::launch::deferred, [this]() {
+                        return next_chunk();
+                    }));
+                }
+
+                void stop() noexcept {
+                    m_done = true;
+                }
+
+            }; // class header_probe_input
+
+        } // namespace detail
+
+        /**
+         * Read only the header of an OSM file. This is much cheaper than
+         * creating a Reader and calling header() on it: No read or parser
+         * threads are started, the file is read and decoded in the calling
+         * thread and only as far as needed to get the header (the first blob of a PBF
+         * file, everything before the first object in XML and o5m files).
+         * OPL files have no header, an empty Header is returned for them.
+         *
+         * This works for files and stdin and for Files created from a
+         * buffer, but not for URLs. You have to include the headers for
+         * the formats and compression types you want to support, just
+         * like for the Reader (for instance osmium/io/any_input.hpp).
+         *
+         * @param file The file to read the header from.
+         * @returns The header.
+         * @throws osmium::io_error If there was an error or if the file
+         *         ended before the header was complete.
+         * @throws std::system_error If the file could not be opened.
+         */
+        inline osmium::io::Header read_header(const osmium::io::File& file) {
+            file.check();
+            const auto creator = detail::ParserFactory::instance().get_creator_function(file);
+
+            std::unique_ptr<osmium::io::Decompressor> decompressor;
+            if (file.buffer()) {
+                decompressor = osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), file.buffer(), file.buffer_size());
+            } else {
+                decompressor = osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), detail::open_for_reading(file.filename()));
+            }
+
+            detail::future_string_queue_type input_queue;
+            detail::future_buffer_queue_type output_queue;
+            std::promise<osmium::io::Header> header_promise;
+            std::future<osmium::io::Header> header_future = header_promise.get_future();
+
+            detail::header_probe_input input{*decompressor, input_queue, header_future};
+            input.add_next();
+
+            {
+                // The parsers need a pool, but don't use it when they read
+                // only the header without a decode window.
+                detail::parser_arguments args = {
+                    osmium::thread::Pool::default_instance(),
+                    input_queue,
+                    output_queue,
+                    header_promise,
+                    osmium::osm_entity_bits::nothing,
+                    osmium::io::read_meta::no,
+                    osmium::metadata_options{},
+                    nullptr,
+                    osmium::io::blob_selection{},
+                    osmium::io::decode_window{0},
+                    osmium::io::tag_prefilter{},
+                    osmium::io::xml_tokenizer::expat,
+                    osmium::io::read_buffers{},
+                    osmium::io::buffer_transform{},
+                    nullptr
+                };
+                const auto parser = creator(args);
+                parser->parse();
+                input.stop();
+            }
+
+            decompressor->close();
+
+            if (header_future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                throw osmium::io_error{"File ended before header was complete"};
+            }
+
+            return header_future.get();
+        }
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_READ_HEADER_HPP
@@ -41,13 +41,21 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/reader_options.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/metadata_options.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/file.hpp>
+#include <osmium/util/memory_mapping.hpp>
+#include <osmium/util/trace.hpp>
 
 #include <cerrno>
+#include <chrono>
 #include <cstdlib>
 #include <fcntl.h>
 #include <future>
@@ -98,6 +106,8 @@ namespace osmium {
 
             osmium::thread::Pool* m_pool = nullptr;
 
+            osmium::io::IOExecutor* m_io_executor = nullptr;
+
             detail::ParserFactory::create_parser_type m_creator;
 
             enum class status {
@@ -113,7 +123,10 @@ namespace osmium {
 
             std::unique_ptr<osmium::io::Decompressor> m_decompressor;
 
-            osmium::io::detail::ReadThreadManager m_read_thread_manager;
+            // This is not used if the input file is memory-mapped.
+            std::unique_ptr<osmium::io::detail::ReadThreadManager> m_read_thread_manager{};
+
+            std::shared_ptr<osmium::util::MemoryMapping> m_mapped_input{};
 
             detail::future_buffer_queue_type m_osmdata_queue;
             detail::queue_wrapper<osmium::memory::Buffer> m_osmdata_queue_wrapper;
@@ -123,15 +136,36 @@ namespace osmium {
 
             osmium::thread::thread_handler m_thread{};
 
+            // Only used if the Reader was created with an IOExecutor.
+            detail::io_stage_handle m_parser_task{};
+
             std::size_t m_file_size = 0;
 
             osmium::osm_entity_bits::type m_read_which_entities = osmium::osm_entity_bits::all;
             osmium::io::read_meta m_read_metadata = osmium::io::read_meta::yes;
+            osmium::metadata_options m_read_metadata_fields{};
+            osmium::io::mmap_input m_mmap_input = osmium::io::mmap_input::no;
+            osmium::io::parallel_decompression m_parallel_decompression = osmium::io::parallel_decompression::no;
+            osmium::io::blob_selection m_read_blobs{};
+            osmium::io::decode_window m_decode_window{osmium::config::use_pool_threads_for_pbf_parsing() ? osmium::io::decode_window{} : osmium::io::decode_window{0}};
+            osmium::io::tag_prefilter m_prefilter{};
+            osmium::io::xml_tokenizer m_xml_tokenizer = osmium::io::xml_tokenizer::expat;
+            osmium::io::read_buffers m_read_buffers{};
+            osmium::io::buffer_transform m_transform{};
+            osmium::io::PipelineStats* m_stats = nullptr;
+
+            // When the last buffer was returned from read(), only used
+            // if m_stats is set.
+            std::chrono::steady_clock::time_point m_last_read{};
 
             void set_option(osmium::thread::Pool& pool) noexcept {
                 m_pool = &pool;
             }
 
+            void set_option(osmium::io::IOExecutor& executor) noexcept {
+                m_io_executor = &executor;
+            }
+
             void set_option(osmium::osm_entity_bits::type value) noexcept {
                 m_read_which_entities = value;
             }
@@ -140,6 +174,81 @@ namespace osmium {
                 m_read_metadata = value;
             }
 
+            void set_option(const osmium::metadata_options& value) noexcept {
+                m_read_metadata = value.any() ? osmium::io::read_meta::yes : osmium::io::read_meta::no;
+                m_read_metadata_fields = value;
+            }
+
+            void set_option(osmium::io::mmap_input value) noexcept {
+                m_mmap_input = value;
+            }
+
+            void set_option(osmium::io::parallel_decompression value) noexcept {
+                m_parallel_decompression = value;
+            }
+
+            void set_option(const osmium::io::blob_selection& value) {
+                m_read_blobs = value;
+            }
+
+            void set_option(const osmium::io::decode_window& value) noexcept {
+                m_decode_window = value;
+            }
+
+            void set_option(const osmium::io::tag_prefilter& value) {
+                m_prefilter = value;
+            }
+
+            void set_option(osmium::io::xml_tokenizer value) noexcept {
+                m_xml_tokenizer = value;
+            }
+
+            void set_option(const osmium::io::read_buffers& value) noexcept {
+                m_read_buffers = value;
+            }
+
+            void set_option(const osmium::io::buffer_transform& value) {
+                m_transform = value;
+            }
+
+            void set_option(osmium::io::PipelineStats& stats) noexcept {
+                m_stats = &stats;
+            }
+
+            static bool is_url(const std::string& filename) {
+                const std::string protocol{filename.substr(0, filename.find_first_of(':'))};
+                return protocol == "http" || protocol == "https" || protocol == "ftp" || protocol == "file";
+            }
+
+            /**
+             * Can and should the input file be memory-mapped? This is only
+             * possible for uncompressed PBF and osmbuf files which are
+             * non-empty regular files.
+             */
+            bool use_mapped_input() const {
+                return m_mmap_input == osmium::io::mmap_input::yes &&
+                       (m_file.format() == osmium::io::file_format::pbf ||
+                        m_file.format() == osmium::io::file_format::osmbuf) &&
+                       m_file.compression() == osmium::io::file_compression::none &&
+                       !m_file.buffer() &&
+                       !m_file.filename().empty() &&
+                       m_file.filename() != "-" &&
+                       !is_url(m_file.filename()) &&
+                       m_file_size > 0;
+            }
+
+            void map_input_file() {
+                const int fd = osmium::io::detail::open_for_reading(m_file.filename());
+                try {
+                    m_mapped_input = std::make_shared<osmium::util::MemoryMapping>(m_file_size, osmium::util::MemoryMapping::mapping_mode::readonly, fd);
+                } catch (...) {
+                    ::close(fd);
+                    throw;
+                }
+                // The mapping stays valid after the file is closed.
+                ::close(fd);
+            }
+
             // This function will run in a separate thread.
             static void parser_thread(osmium::thread::Pool& pool,
                                       const detail::ParserFactory::create_parser_type& creator,
@@ -147,7 +256,16 @@ namespace osmium {
                                       detail::future_buffer_queue_type& osmdata_queue,
                                       std::promise<osmium::io::Header>&& header_promise,
                                       osmium::osm_entity_bits::type read_which_entities,
-                                      osmium::io::read_meta read_metadata) {
+                                      osmium::io::read_meta read_metadata,
+                                      const osmium::metadata_options& read_metadata_fields,
+                                      std::shared_ptr<osmium::util::MemoryMapping> mapped_input,
+                                      const osmium::io::blob_selection& read_blobs,
+                                      const osmium::io::decode_window& window,
+                                      const osmium::io::tag_prefilter& prefilter,
+                                      osmium::io::xml_tokenizer tokenizer,
+                                      const osmium::io::read_buffers& buffers,
+                                      const osmium::io::buffer_transform& transform,
+                                      osmium::io::PipelineStats* stats) {
                 std::promise<osmium::io::Header> promise{std::move(header_promise)};
                 osmium::io::detail::parser_arguments args = {
                     pool,
@@ -155,7 +273,16 @@ namespace osmium {
                     osmdata_queue,
                     promise,
                     read_which_entities,
-                    read_metadata
+                    read_metadata,
+                    read_metadata_fields,
+                    std::move(mapped_input),
+                    read_blobs,
+                    window,
+                    prefilter,
+                    tokenizer,
+                    buffers,
+                    transform,
+                    stats
                 };
                 creator(args)->parse();
             }
@@ -218,8 +345,7 @@ namespace osmium {
              * @throws std::system_error if a system call fails.
              */
             static int open_input_file_or_url(const std::string& filename, int* childpid) {
-                const std::string protocol{filename.substr(0, filename.find_first_of(':'))};
-                if (protocol == "http" || protocol == "https" || protocol == "ftp" || protocol == "file") {
+                if (is_url(filename)) {
 #ifndef _WIN32
                     return execute("curl", filename, childpid);
 #else
@@ -229,6 +355,69 @@ namespace osmium {
                 return osmium::io::detail::open_for_reading(filename);
             }
 
+            // Get the next buffer with data from the queue. If wait is
+            // false and the next buffer is not ready yet, returns false
+            // without changing the buffer.
+            bool next_buffer(osmium::memory::Buffer& buffer, bool wait) {
+                // If there are buffers on the stack, return those first.
+                if (m_back_buffers) {
+                    if (m_back_buffers.has_nested_buffers()) {
+                        buffer = std::move(*m_back_buffers.get_last_nested());
+                    } else {
+                        buffer = std::move(m_back_buffers);
+                        m_back_buffers = osmium::memory::Buffer{};
+                    }
+                    return true;
+                }
+
+                if (m_status != status::okay) {
+                    throw io_error{"Can not read from reader when in status 'closed', 'eof', or 'error'"};
+                }
+
+                if (m_read_which_entities == osmium::osm_entity_bits::nothing) {
+                    m_status = status::eof;
+                    buffer = osmium::memory::Buffer{};
+                    return true;
+                }
+
+                try {
+                    // m_input_format.read() can return an invalid buffer to signal EOF,
+                    // or a valid buffer with or without data. A valid buffer
+                    // without data is not an error, it just means we have to
+                    // keep getting the next buffer until there is one with data.
+                    while (true) {
+                        osmium::memory::Buffer next;
+                        if (wait) {
+                            const detail::stats_timer timer{m_stats, &PipelineStats::reader_wait};
+                            const osmium::trace::Span span{"reader_wait"};
+                            next = m_osmdata_queue_wrapper.pop();
+                        } else if (!m_osmdata_queue_wrapper.try_pop(next)) {
+                            return false;
+                        }
+                        if (detail::at_end_of_data(next)) {
+                            m_status = status::eof;
+                            if (m_read_thread_manager) {
+                                m_read_thread_manager->close();
+                            }
+                            buffer = std::move(next);
+                            return true;
+                        }
+                        if (next.has_nested_buffers()) {
+                            m_back_buffers = std::move(next);
+                            next = std::move(*m_back_buffers.get_last_nested());
+                        }
+                        if (next.committed() > 0) {
+                            buffer = std::move(next);
+                            return true;
+                        }
+                    }
+                } catch (...) {
+                    close();
+                    m_status = status::error;
+                    throw;
+                }
+            }
+
         public:
 
             /**
@@ -250,6 +439,75 @@ namespace osmium {
              *      etc.) is not read possibly speeding up the read. Not all
              *      file formats use this setting.
              *
+             * * osmium::metadata_options: Read only the given metadata
+             *      fields, for instance osmium::metadata_options{"version"}
+             *      to read only the object versions. Fields not in the set
+             *      are not decoded and keep their default values. This
+             *      implies osmium::io::read_meta::yes if any field is set
+             *      and osmium::io::read_meta::no otherwise. Currently only
+             *      the PBF parser reads single fields, all other parsers
+             *      read either all metadata or none.
+             *
+             * * osmium::io::mmap_input: Memory-map the input file instead of
+             *      reading it in a separate thread. The default is
+             *      osmium::io::mmap_input::no. This is only used for
+             *      uncompressed PBF and osmbuf files on disk, it is
+             *      silently ignored for all other inputs. When the input
+             *      is memory-mapped, offset() will always return 0.
+             *
+             * * osmium::io::blob_selection: Only read the data blobs in this
+             *      selection. Blobs not selected are skipped without being
+             *      decompressed. This is only used for PBF and osmbuf
+             *      files. See osmium::io::PBFBlobIndex for how to get a
+             *      selection for PBF files.
+             *
+             * * osmium::io::decode_window: How many blobs can be decoded in
+             *      parallel in the thread pool. The default is twice the
+             *      number of threads in the pool unless the environment
+             *      variable OSMIUM_USE_POOL_THREADS_FOR_PBF_PARSING is set
+             *      to "off", in which case all decoding is done in a single
+             *      thread. This is used for PBF, OPL, o5m, and osmbuf files
+             *      and for XML files read with
+             *      osmium::io::xml_tokenizer::builtin.
+             *
+             * * osmium::io::parallel_decompression: Decompress gzip or
+             *      bzip2 input in the thread pool? Can be
+             *      osmium::io::parallel_decompression::yes or
+             *      osmium::io::parallel_decompression::no (default).
+             *
+             * * osmium::io::tag_prefilter: Only read objects with at least
+             *      one tag matching the filter. The PBF parser skips
+             *      rejected objects without building them, other parsers
+             *      drop them after parsing.
+             *
+             * * osmium::io::IOExecutor&: Read the input file in the threads
+             *      of this executor instead of in a separate thread for
+             *      this Reader and run the parser on a task thread of the
+             *      executor which is reused by later Readers. Use this if
+             *      many Readers are open at the same time or for low
+             *      latency when reading many small files. The executor
+             *      must outlive the Reader.
+             *
+             * * osmium::io::xml_tokenizer: Tokenizer used for XML files.
+             *      Can be osmium::io::xml_tokenizer::expat (default) or
+             *      osmium::io::xml_tokenizer::builtin (faster, but only for
+             *      the subset of XML used in OSM files).
+             *
+             * * osmium::io::read_buffers: Size of the buffers returned by
+             *      read() and, optionally, an osmium::memory::BufferPool
+             *      they are taken from. This is used for XML, OPL, and o5m
+             *      files. For low latency set a small size and a maximum
+             *      delay after which buffers are sent on even if they are
+             *      not full.
+             *
+             * * osmium::io::buffer_transform: Function applied to each
+             *      buffer in the thread that decoded it, usually a thread
+             *      in the pool. Used, for instance, to add node locations
+             *      to ways in parallel.
+             *
+             * * osmium::io::PipelineStats&: Record timing of the stages in
+             *      the Reader. The stats object must outlive the Reader.
+             *
              * @throws osmium::io_error If there was an error.
              * @throws std::system_error If the file could not be opened.
              */
@@ -258,13 +516,8 @@ namespace osmium {
                 m_file(file.check()),
                 m_creator(detail::ParserFactory::instance().get_creator_function(m_file)),
                 m_input_queue(detail::get_input_queue_size(), "raw_input"),
-                m_decompressor(m_file.buffer() ?
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), m_file.buffer(), m_file.buffer_size()) :
-                    osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid))),
-                m_read_thread_manager(*m_decompressor, m_input_queue),
                 m_osmdata_queue(detail::get_osmdata_queue_size(), "parser_results"),
-                m_osmdata_queue_wrapper(m_osmdata_queue),
-                m_file_size(m_decompressor->file_size()) {
+                m_osmdata_queue_wrapper(m_osmdata_queue) {
 
                 (void)std::initializer_list<int>{
                     (set_option(args), 0)...
@@ -274,9 +527,54 @@ namespace osmium {
                     m_pool = &thread::Pool::default_instance();
                 }
 
+                try {
+                    if (m_file.buffer()) {
+                        m_decompressor = osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), m_file.buffer(), m_file.buffer_size());
+                    } else if (m_parallel_decompression == osmium::io::parallel_decompression::yes) {
+                        m_decompressor = osmium::io::CompressionFactory::instance().create_parallel_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid), *m_pool);
+                    } else {
+                        m_decompressor = osmium::io::CompressionFactory::instance().create_decompressor(file.compression(), open_input_file_or_url(m_file.filename(), &m_childpid));
+                    }
+                    m_file_size = m_decompressor->file_size();
+
+                    if (use_mapped_input()) {
+                        map_input_file();
+                        // The parser gets all data from the mapping, so the
+                        // input queue is empty.
+                        detail::add_end_of_data_to_queue(m_input_queue);
+                    } else {
+                        if (m_io_executor) {
+                            m_read_thread_manager.reset(new osmium::io::detail::ReadThreadManager{*m_decompressor, m_input_queue, *m_io_executor, m_stats});
+                        } else {
+                            m_read_thread_manager.reset(new osmium::io::detail::ReadThreadManager{*m_decompressor, m_input_queue, m_stats});
+                        }
+                    }
+                } catch (...) {
+                    // Nothing will ever be read, so the queue wrapper must
+                    // not wait for data when it is destroyed.
+                    detail::add_end_of_data_to_queue(m_osmdata_queue);
+                    throw;
+                }
+
+                if (m_io_executor) {
+                    // The task must be copyable, so the promise is shared.
+                    const auto header_promise = std::make_shared<std::promise<osmium::io::Header>>();
+                    m_header_future = header_promise->get_future();
+                    m_parser_task = m_io_executor->run_task([this, header_promise]() {
+                        try {
+                            parser_thread(*m_pool, m_creator, m_input_queue, m_osmdata_queue, std::move(*header_promise), m_read_which_entities, m_read_metadata, m_read_metadata_fields, m_mapped_input, m_read_blobs, m_decode_window, m_prefilter, m_xml_tokenizer, m_read_buffers, m_transform, m_stats);
+                        } catch (...) {
+                            // The parser could not be created.
+                            detail::add_to_queue(m_osmdata_queue, std::current_exception());
+                            detail::add_end_of_data_to_queue(m_osmdata_queue);
+                        }
+                    });
+                    return;
+                }
+
                 std::promise<osmium::io::Header> header_promise;
                 m_header_future = header_promise.get_future();
-                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata};
+                m_thread = osmium::thread::thread_handler{parser_thread, std::ref(*m_pool), std::ref(m_creator), std::ref(m_input_queue), std::ref(m_osmdata_queue), std::move(header_promise), m_read_which_entities, m_read_metadata, m_read_metadata_fields, m_mapped_input, m_read_blobs, m_decode_window, m_prefilter, m_xml_tokenizer, m_read_buffers, m_transform, m_stats};
             }
 
             template <typename... TArgs>
@@ -314,14 +612,18 @@ namespace osmium {
             void close() {
                 m_status = status::closed;
 
-                m_read_thread_manager.stop();
+                if (m_read_thread_manager) {
+                    m_read_thread_manager->stop();
+                }
 
                 m_osmdata_queue_wrapper.drain();
 
-                try {
-                    m_read_thread_manager.close();
-                } catch (...) {
-                    // Ignore any exceptions.
+                if (m_read_thread_manager) {
+                    try {
+                        m_read_thread_manager->close();
+                    } catch (...) {
+                        // Ignore any exceptions.
+                    }
                 }
 
 #ifndef _WIN32
@@ -372,53 +674,49 @@ namespace osmium {
              * @throws Some form of osmium::io_error if there is an error.
              */
             osmium::memory::Buffer read() {
-                osmium::memory::Buffer buffer;
-
-                // If there are buffers on the stack, return those first.
-                if (m_back_buffers) {
-                    if (m_back_buffers.has_nested_buffers()) {
-                        buffer = std::move(*m_back_buffers.get_last_nested());
-                    } else {
-                        buffer = std::move(m_back_buffers);
-                        m_back_buffers = osmium::memory::Buffer{};
+                if ((m_stats || osmium::trace::enabled()) && m_last_read != std::chrono::steady_clock::time_point{}) {
+                    const auto now = std::chrono::steady_clock::now();
+                    if (m_stats) {
+                        m_stats->handler.add(now - m_last_read);
                     }
-                    return buffer;
+                    osmium::trace::add("handler", m_last_read, now);
                 }
-
-                if (m_status != status::okay) {
-                    throw io_error{"Can not read from reader when in status 'closed', 'eof', or 'error'"};
+                osmium::memory::Buffer buffer;
+                next_buffer(buffer, true);
+                if (m_stats || osmium::trace::enabled()) {
+                    m_last_read = std::chrono::steady_clock::now();
                 }
+                return buffer;
+            }
 
-                if (m_read_which_entities == osmium::osm_entity_bits::nothing) {
-                    m_status = status::eof;
-                    return buffer;
-                }
+            /**
+             * Non-blocking version of read(). If the next buffer is already
+             * decoded, it is moved into the buffer parameter and true is
+             * returned. As with read() an invalid buffer signals end-of-file.
+             * If no data is available yet, false is returned immediately
+             * and the buffer parameter is not changed. Call this again
+             * later, for instance from a timer or idle callback of an event
+             * loop.
+             *
+             * Do not mix calls to this function with calls to read() from
+             * different threads.
+             *
+             * @param buffer Set to the next buffer if there is one.
+             * @returns true if a buffer (or end-of-file) was returned,
+             *          false if the caller should try again later.
+             * @throws Some form of osmium::io_error if there is an error.
+             */
+            bool try_read(osmium::memory::Buffer& buffer) {
+                return next_buffer(buffer, false);
+            }
 
-                try {
-                    // m_input_format.read() can return an invalid buffer to signal EOF,
-                    // or a valid buffer with or without data. A valid buffer
-                    // without data is not an error, it just means we have to
-                    // keep getting the next buffer until there is one with data.
-                    while (true) {
-                        buffer = m_osmdata_queue_wrapper.pop();
-                        if (detail::at_end_of_data(buffer)) {
-                            m_status = status::eof;
-                            m_read_thread_manager.close();
-                            return buffer;
-                        }
-                        if (buffer.has_nested_buffers()) {
-                            m_back_buffers = std::move(buffer);
-                            buffer = std::move(*m_back_buffers.get_last_nested());
-                        }
-                        if (buffer.committed() > 0) {
-                            return buffer;
-                        }
-                    }
-                } catch (...) {
-                    close();
-                    m_status = status::error;
-                    throw;
-                }
+            /**
+             * Is the header available? If this returns true, calling
+             * header() will not block.
+             */
+            bool header_ready() const {
+                return !m_header_future.valid() ||
+                       m_header_future.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
             }
 
             /**
@@ -440,7 +738,7 @@ namespace osmium {
             /**
              * Returns the current offset into the input file. Returns 0 if
              * the offset is not available (for instance when reading from
-             * stdin).
+             * stdin) or if the input file is memory-mapped.
              *
              * The offset can be used together with the result of file_size()
              * to estimate how much of the file has been read. Note that due
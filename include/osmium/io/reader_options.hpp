@@ -0,0 +1,572 @@
+#ifndef OSMIUM_IO_READER_OPTIONS_HPP
+#define OSMIUM_IO_READER_OPTIONS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/osm/item_type.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    template <typename TResult>
+    class TagsFilterBase;
+
+    namespace io {
+
+        /**
+         * Should the reader memory-map the input file instead of reading
+         * it through a separate thread? This is only used for uncompressed
+         * PBF and osmbuf files on disk, for all other inputs it is ignored.
+         */
+        enum class mmap_input : bool {
+            no  = false,
+            yes = true
+        };
+
+        /**
+         * Should the reader decompress gzip or bzip2 input in the thread
+         * pool? This is fastest for files consisting of many compressed
+         * streams (such as those written with parallel_compression), for
+         * other files most of the work is still done in one thread.
+         */
+        enum class parallel_decompression : bool {
+            no  = false,
+            yes = true
+        };
+
+        /**
+         * Which tokenizer should the XML parser use? The default is Expat,
+         * a full XML parser. The builtin tokenizer only understands the
+         * subset of XML used in OSM files, but it is faster. Files it can't
+         * handle (with a document type declaration or an encoding other
+         * than UTF-8) are given to Expat anyway.
+         */
+        enum class xml_tokenizer : bool {
+            expat   = false,
+            builtin = true
+        };
+
+        /**
+         * Selection of data blobs the reader should read. A blob is
+         * identified by its byte offset in the input file. A default
+         * constructed blob_selection selects all blobs.
+         *
+         * This is currently only used for PBF and osmbuf files. The header
+         * is always read. Usually you'll get a blob_selection from
+         * osmium::io::PBFBlobIndex::select().
+         */
+        class blob_selection {
+
+            std::shared_ptr<const std::vector<std::size_t>> m_offsets{};
+
+        public:
+
+            /// Select all blobs.
+            blob_selection() = default;
+
+            /// Select the blobs starting at the given offsets.
+            explicit blob_selection(std::vector<std::size_t> offsets) {
+                std::sort(offsets.begin(), offsets.end());
+                m_offsets = std::make_shared<const std::vector<std::size_t>>(std::move(offsets));
+            }
+
+            /// Are all blobs selected?
+            bool all() const noexcept {
+                return !m_offsets;
+            }
+
+            /// Is the blob starting at the given offset selected?
+            bool contains(std::size_t offset) const {
+                return all() || std::binary_search(m_offsets->cbegin(), m_offsets->cend(), offset);
+            }
+
+            /**
+             * Is the given offset behind the last selected blob? Readers
+             * can stop reading the file then.
+             */
+            bool past_last(std::size_t offset) const noexcept {
+                return !all() && (m_offsets->empty() || offset > m_offsets->back());
+            }
+
+        }; // class blob_selection
+
+        /**
+         * How many blobs of the input can be decoded in parallel in the
+         * thread pool. The data is always delivered in file order.
+         *
+         * The window limits the number of blobs submitted to the pool
+         * for decoding which haven't been decoded yet. Optionally the
+         * window is also limited by the sum of the sizes of those blobs
+         * in the input file. Results ready but not yet read by the
+         * application are limited separately by the size of the queue
+         * (see OSMIUM_MAX_OSMDATA_QUEUE_SIZE).
+         *
+         * This is used for PBF files, for OPL files, where the input is
+         * cut into chunks of lines, for o5m files, where the input is cut
+         * at reset datasets, for osmbuf files, and for XML files read with
+         * the builtin xml_tokenizer, where the input is cut before top-level
+         * elements.
+         */
+        class decode_window {
+
+            std::size_t m_max_blobs;
+            std::size_t m_max_bytes;
+
+        public:
+
+            /// Use a window of twice the number of threads in the pool.
+            static constexpr std::size_t automatic() noexcept {
+                return std::numeric_limits<std::size_t>::max();
+            }
+
+            /**
+             * Create decode window.
+             *
+             * @param max_blobs Maximum number of blobs being decoded at any
+             *                  time. If this is 0, all blobs are decoded in
+             *                  the parser thread and the pool isn't used.
+             * @param max_bytes Maximum sum of the sizes of the blobs being
+             *                  decoded at any time. 0 means no limit. At
+             *                  least one blob is always decoded regardless
+             *                  of its size.
+             */
+            explicit constexpr decode_window(std::size_t max_blobs = automatic(), std::size_t max_bytes = 0) noexcept :
+                m_max_blobs(max_blobs),
+                m_max_bytes(max_bytes) {
+            }
+
+            /// Are blobs decoded in the thread pool?
+            constexpr bool parallel() const noexcept {
+                return m_max_blobs > 0;
+            }
+
+            constexpr std::size_t max_blobs() const noexcept {
+                return m_max_blobs;
+            }
+
+            constexpr std::size_t max_bytes() const noexcept {
+                return m_max_bytes;
+            }
+
+        }; // class decode_window
+
+        namespace detail {
+
+            /**
+             * Rules of a tag_prefilter created from a TagsFilter. Parsers
+             * can use them to match the keys and values of a string table
+             * against each rule once instead of matching every tag.
+             */
+            class tag_prefilter_rules {
+
+            public:
+
+                tag_prefilter_rules() = default;
+
+                tag_prefilter_rules(const tag_prefilter_rules&) = delete;
+                tag_prefilter_rules& operator=(const tag_prefilter_rules&) = delete;
+
+                tag_prefilter_rules(tag_prefilter_rules&&) = delete;
+                tag_prefilter_rules& operator=(tag_prefilter_rules&&) = delete;
+
+                virtual ~tag_prefilter_rules() noexcept = default;
+
+                virtual std::size_t count() const noexcept = 0;
+
+                virtual bool match_key(std::size_t rule, const char* key) const = 0;
+
+                virtual bool match_value(std::size_t rule, const char* value) const = 0;
+
+                virtual bool result(std::size_t rule) const = 0;
+
+                virtual bool default_result() const = 0;
+
+            }; // class tag_prefilter_rules
+
+            template <typename TFilter>
+            class tags_filter_prefilter_rules : public tag_prefilter_rules {
+
+                TFilter m_filter;
+
+            public:
+
+                explicit tags_filter_prefilter_rules(const TFilter& filter) :
+                    m_filter(filter) {
+                }
+
+                const TFilter& filter() const noexcept {
+                    return m_filter;
+                }
+
+                std::size_t count() const noexcept override {
+                    return m_filter.rules().size();
+                }
+
+                bool match_key(std::size_t rule, const char* key) const override {
+                    return m_filter.rules()[rule].second.match_key(key);
+                }
+
+                bool match_value(std::size_t rule, const char* value) const override {
+                    return m_filter.rules()[rule].second.match_value(value);
+                }
+
+                bool result(std::size_t rule) const override {
+                    return static_cast<bool>(m_filter.rules()[rule].first);
+                }
+
+                bool default_result() const override {
+                    return static_cast<bool>(m_filter.default_result());
+                }
+
+            }; // class tags_filter_prefilter_rules
+
+        } // namespace detail
+
+        /**
+         * Filter on the tags of OSM objects applied while the input is
+         * parsed. Objects of the types given in the constructor are only
+         * read if the filter function returns true for at least one of
+         * their tags, so those objects without tags are never read.
+         * Objects of other types are always read. A default constructed
+         * tag_prefilter reads all objects.
+         *
+         * The PBF parser evaluates the filter on the raw data before the
+         * objects are built. It decodes metadata, tags and everything
+         * else only for objects accepted by the filter. Parsers for other
+         * formats have to build all objects and drop the rejected ones
+         * afterwards.
+         */
+        class tag_prefilter {
+
+        public:
+
+            using function_type = std::function<bool(const char* key, const char* value)>;
+
+        private:
+
+            std::shared_ptr<const function_type> m_function{};
+            std::shared_ptr<const detail::tag_prefilter_rules> m_rules{};
+            osmium::osm_entity_bits::type m_entities = osmium::osm_entity_bits::nothing;
+
+        public:
+
+            /// Read all objects.
+            tag_prefilter() = default;
+
+            /**
+             * Create prefilter.
+             *
+             * @param function Function called with the key and value of
+             *                 tags. Must be thread-safe, it is called from
+             *                 threads in the thread pool.
+             * @param entities The types of objects this filter is applied
+             *                 to.
+             */
+            explicit tag_prefilter(function_type function, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
+                m_function(std::make_shared<const function_type>(std::move(function))),
+                m_entities(entities) {
+            }
+
+            /**
+             * Create prefilter from a TagsFilter (or other TagsFilterBase).
+             * A tag matches if the filter returns true for it. The PBF
+             * parser matches all strings of a block against each rule
+             * once, so checking an object only needs a few integer
+             * operations per tag. This works for filters with up to 64
+             * rules, filters with more rules are checked tag by tag.
+             *
+             * @param filter The filter. It is copied.
+             * @param entities The types of objects this filter is applied
+             *                 to.
+             */
+            template <typename TResult>
+            explicit tag_prefilter(const osmium::TagsFilterBase<TResult>& filter, osmium::osm_entity_bits::type entities = osmium::osm_entity_bits::nwr) :
+                m_entities(entities) {
+                const auto rules = std::make_shared<const detail::tags_filter_prefilter_rules<osmium::TagsFilterBase<TResult>>>(filter);
+                m_function = std::make_shared<const function_type>([rules](const char* key, const char* value) {
+                    return static_cast<bool>(rules->filter()(key, value));
+                });
+                m_rules = rules;
+            }
+
+            /**
+             * The rules if this prefilter was created from a TagsFilter,
+             * nullptr otherwise.
+             */
+            const detail::tag_prefilter_rules* rules() const noexcept {
+                return m_rules.get();
+            }
+
+            /// Does this filter reject any objects at all?
+            bool enabled() const noexcept {
+                return m_function && m_entities != osmium::osm_entity_bits::nothing;
+            }
+
+            /// Is this filter applied to objects of the specified type?
+            bool applies_to(osmium::item_type type) const noexcept {
+                return m_function && (m_entities & osmium::osm_entity_bits::from_item_type(type)) != 0;
+            }
+
+            /// Does a tag with this key and value match the filter?
+            bool operator()(const char* key, const char* value) const {
+                return (*m_function)(key, value);
+            }
+
+            /// Does any of the tags match the filter?
+            template <typename TTags>
+            bool match_any_of(const TTags& tags) const {
+                for (const auto& tag : tags) {
+                    if ((*m_function)(tag.key(), tag.value())) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+        }; // class tag_prefilter
+
+        /**
+         * Function applied to every buffer read before it is returned
+         * from Reader::read(). It is called in the thread that created the
+         * buffer, which is a thread in the thread pool if the input is
+         * decoded there (see decode_window). This allows work on the
+         * buffers that would otherwise happen in the thread calling
+         * read() to be spread over all threads in the pool.
+         *
+         * The function must be thread-safe and must not depend on the
+         * order of the buffers, it can be called for several buffers at
+         * the same time. Exceptions thrown from it are reported by
+         * Reader::read(). A default constructed buffer_transform does
+         * nothing.
+         *
+         * See osmium::handler::NodeLocationsForWaysTransform for an
+         * example.
+         */
+        class buffer_transform {
+
+        public:
+
+            using function_type = std::function<void(osmium::memory::Buffer&)>;
+
+        private:
+
+            std::shared_ptr<const function_type> m_function{};
+
+        public:
+
+            /// Do not change buffers.
+            buffer_transform() = default;
+
+            /**
+             * Create transform.
+             *
+             * @param function Function called with every buffer. Must be
+             *                 thread-safe.
+             */
+            explicit buffer_transform(function_type function) :
+                m_function(std::make_shared<const function_type>(std::move(function))) {
+            }
+
+            /// Is there a function to apply?
+            bool enabled() const noexcept {
+                return m_function && *m_function;
+            }
+
+            /// Apply the function to the buffer.
+            void operator()(osmium::memory::Buffer& buffer) const {
+                (*m_function)(buffer);
+            }
+
+        }; // class buffer_transform
+
+        /**
+         * Size of the buffers returned by the Reader and, optionally, a
+         * pool the buffers are taken from. This is used by the XML, OPL,
+         * and o5m parsers, other formats have their own buffer sizes.
+         *
+         * Buffers are sent on when they are nearly full, so they usually
+         * have a capacity of the given size and are filled to at least
+         * seven eighths of it. Buffers can grow beyond the size if a
+         * single object doesn't fit or if the parser works on chunks of
+         * input in the thread pool, because the output from one chunk is
+         * always in one buffer.
+         *
+         * If a BufferPool is given, the pool must outlive the Reader. Give
+         * the buffers back to the pool using BufferPool::release() when
+         * you are done with them.
+         *
+         * If a BufferAllocator is given, it is used for the memory of all
+         * buffers and must outlive them.
+         *
+         * For low latency set a maximum delay with set_max_delay(). The XML
+         * parser (with the default Expat tokenizer) and the OPL parser
+         * (when not decoding in the thread pool) then also send a buffer
+         * on when it has been filled for longer than this delay. This is
+         * checked whenever an object is finished. A delay of 0 sends each
+         * object in its own buffer, use a small buffer size then.
+         */
+        class read_buffers {
+
+            osmium::memory::BufferPool* m_pool = nullptr;
+            osmium::memory::BufferAllocator* m_allocator = nullptr;
+            std::size_t m_size = default_size;
+            std::chrono::microseconds m_max_delay = no_max_delay();
+
+        public:
+
+            enum : std::size_t {
+                default_size = 1024UL * 1024UL,
+                min_size = 1024UL
+            };
+
+            /// Buffers are only sent on when they are full.
+            static constexpr std::chrono::microseconds no_max_delay() noexcept {
+                return std::chrono::microseconds::max();
+            }
+
+            /// Use buffers of the default size.
+            read_buffers() = default;
+
+            /// Use buffers of the given size.
+            explicit read_buffers(std::size_t size) noexcept :
+                m_size(size < min_size ? static_cast<std::size_t>(min_size) : size) {
+            }
+
+            /// Use buffers of the given size taken from the pool.
+            explicit read_buffers(osmium::memory::BufferPool& pool, std::size_t size = default_size) noexcept :
+                m_pool(&pool),
+                m_size(size < min_size ? static_cast<std::size_t>(min_size) : size) {
+            }
+
+            /// Use buffers of the given size allocated with the allocator.
+            explicit read_buffers(osmium::memory::BufferAllocator& allocator, std::size_t size = default_size) noexcept :
+                m_allocator(&allocator),
+                m_size(size < min_size ? static_cast<std::size_t>(min_size) : size) {
+            }
+
+            /// The target size of buffers.
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /// The pool buffers are taken from (or nullptr).
+            osmium::memory::BufferPool* pool() const noexcept {
+                return m_pool;
+            }
+
+            /// The allocator used for buffers (or nullptr).
+            osmium::memory::BufferAllocator* allocator() const noexcept {
+                return m_allocator;
+            }
+
+            /// Get a new buffer from the pool, the allocator, or the heap.
+            osmium::memory::Buffer get(osmium::memory::Buffer::auto_grow auto_grow = osmium::memory::Buffer::auto_grow::yes) const {
+                if (m_pool) {
+                    return m_pool->get(m_size, auto_grow);
+                }
+                if (m_allocator) {
+                    return osmium::memory::Buffer{m_size, auto_grow, *m_allocator};
+                }
+                return osmium::memory::Buffer{m_size, auto_grow};
+            }
+
+            /**
+             * Also send buffers on when they have been filled for longer
+             * than this.
+             *
+             * @returns Reference to this object to allow chaining.
+             */
+            read_buffers& set_max_delay(std::chrono::microseconds delay) noexcept {
+                m_max_delay = delay;
+                return *this;
+            }
+
+            /// The maximum delay (or no_max_delay()).
+            std::chrono::microseconds max_delay() const noexcept {
+                return m_max_delay;
+            }
+
+            /**
+             * The time a parser should remember when it starts filling a
+             * new buffer. This is only needed with a maximum delay, so the
+             * clock is only read if there is one.
+             */
+            std::chrono::steady_clock::time_point start_time() const noexcept {
+                if (m_max_delay == no_max_delay()) {
+                    return std::chrono::steady_clock::time_point{};
+                }
+                return std::chrono::steady_clock::now();
+            }
+
+            /// Is this buffer full enough to be sent on?
+            bool is_full(const osmium::memory::Buffer& buffer) const noexcept {
+                return buffer.committed() >= m_size - m_size / 8;
+            }
+
+            /**
+             * Is this buffer full enough to be sent on or has it been
+             * filled for longer than the maximum delay?
+             *
+             * @param buffer The buffer.
+             * @param started When the parser started filling the buffer
+             *                (see start_time()).
+             */
+            bool is_full(const osmium::memory::Buffer& buffer, std::chrono::steady_clock::time_point started) const noexcept {
+                if (is_full(buffer)) {
+                    return true;
+                }
+                if (m_max_delay == no_max_delay() || buffer.committed() == 0) {
+                    return false;
+                }
+                return m_max_delay.count() <= 0 ||
+                       std::chrono::steady_clock::now() - started >= m_max_delay;
+            }
+
+        }; // class read_buffers
+
+    } // namespace io
+
+} // namespace osmium
+
+#endif // OSMIUM_IO_READER_OPTIONS_HPP
@@ -40,21 +40,31 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/io/detail/write_thread.hpp>
 #include <osmium/io/error.hpp>
 #include <osmium/io/file.hpp>
+#include <osmium/io/file_metadata.hpp>
+#include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/pipeline_stats.hpp>
 #include <osmium/io/writer_options.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_selection.hpp>
 #include <osmium/thread/pool.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
+#include <osmium/util/trace.hpp>
 #include <osmium/version.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cstddef>
 #include <exception>
 #include <functional>
 #include <future>
 #include <initializer_list>
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <utility>
 
@@ -96,6 +106,9 @@ namespace osmium {
          * in osmium::memory::Buffers. But you can also write single
          * osmium::memory::Items. In this case the Writer uses an internal
          * Buffer.
+         *
+         * The pipeline inside the Writer can be configured with a
+         * writer_pipeline object and queried with statistics().
          */
         class Writer {
 
@@ -105,18 +118,33 @@ namespace osmium {
 
             osmium::io::File m_file;
 
-            detail::future_string_queue_type m_output_queue{detail::get_output_queue_size(), "raw_output"};
+            writer_pipeline m_pipeline;
+
+            detail::future_string_queue_type m_output_queue;
 
             std::unique_ptr<osmium::io::detail::OutputFormat> m_output{nullptr};
 
             osmium::memory::Buffer m_buffer{};
 
-            size_t m_buffer_size = default_buffer_size;
+            size_t m_buffer_size;
+
+            writer_statistics m_statistics{};
+
+            std::atomic<std::size_t> m_bytes_written{0};
+
+            osmium::io::PipelineStats* m_stats = nullptr;
+
+            // Only used if the "metadata_sidecar" file option is set.
+            std::unique_ptr<osmium::io::FileMetadata> m_metadata{};
+            std::string m_metadata_filename{};
 
             std::future<bool> m_write_future{};
 
             osmium::thread::thread_handler m_thread{};
 
+            // Only used if the Writer was created with an IOExecutor.
+            detail::io_stage_handle m_write_stage{};
+
             enum class status {
                 okay   = 0, // normal writing
                 error  = 1, // some error occurred while writing
@@ -126,16 +154,45 @@ namespace osmium {
             // This function will run in a separate thread.
             static void write_thread(detail::future_string_queue_type& output_queue,
                                      std::unique_ptr<osmium::io::Compressor>&& compressor,
-                                     std::promise<bool>&& write_promise) {
+                                     std::promise<bool>&& write_promise,
+                                     std::atomic<std::size_t>* bytes_written,
+                                     osmium::io::PipelineStats* stats) {
                 detail::WriteThread write_thread{output_queue,
                                                  std::move(compressor),
-                                                 std::move(write_promise)};
+                                                 std::move(write_promise),
+                                                 bytes_written,
+                                                 stats};
                 write_thread();
             }
 
+            void write_to_output(osmium::memory::Buffer&& buffer) {
+                const auto start = std::chrono::steady_clock::now();
+                const std::size_t size = buffer.committed();
+
+                if (m_metadata) {
+                    m_metadata->add(buffer);
+                }
+                m_output->write_buffer(std::move(buffer));
+
+                add_encode_statistics(start, size);
+            }
+
+            void add_encode_statistics(std::chrono::steady_clock::time_point start, std::size_t size) {
+                const auto end = std::chrono::steady_clock::now();
+                osmium::trace::add("encode", start, end);
+                const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+                ++m_statistics.buffers;
+                m_statistics.input_bytes += size;
+                m_statistics.encode_time += duration;
+                m_statistics.max_encode_time = std::max(m_statistics.max_encode_time, duration);
+                if (m_stats) {
+                    m_stats->encode.add(duration);
+                }
+            }
+
             void do_write(osmium::memory::Buffer&& buffer) {
                 if (buffer && buffer.committed() > 0) {
-                    m_output->write_buffer(std::move(buffer));
+                    write_to_output(std::move(buffer));
                 }
             }
 
@@ -147,10 +204,28 @@ namespace osmium {
                     using std::swap;
                     swap(m_buffer, buffer);
 
-                    m_output->write_buffer(std::move(buffer));
+                    write_to_output(std::move(buffer));
                 }
             }
 
+            // Copy the contents of small buffers into the internal buffer
+            // (flush_policy::coalesce).
+            void do_coalesce(osmium::memory::Buffer&& buffer) {
+                if (!m_buffer) {
+                    m_buffer = osmium::memory::Buffer{m_buffer_size,
+                                                      osmium::memory::Buffer::auto_grow::no};
+                }
+                if (m_buffer.committed() + buffer.committed() > m_buffer.capacity()) {
+                    do_flush();
+                }
+                if (buffer.committed() > m_buffer.capacity()) {
+                    do_write(std::move(buffer));
+                    return;
+                }
+                m_buffer.add_buffer(buffer);
+                m_buffer.commit();
+            }
+
             template <typename TFunction, typename... TArgs>
             void ensure_cleanup(TFunction func, TArgs&&... args) {
                 if (m_status != status::okay) {
@@ -171,13 +246,26 @@ namespace osmium {
                 osmium::io::Header header;
                 overwrite allow_overwrite = overwrite::no;
                 fsync sync = fsync::no;
+                parallel_compression compression = parallel_compression::no;
                 osmium::thread::Pool* pool = nullptr;
+                osmium::io::IOExecutor* io_executor = nullptr;
+                osmium::io::PipelineStats* stats = nullptr;
+                writer_pipeline pipeline{};
+                way_node_locations locations{};
             };
 
             static void set_option(options_type& options, osmium::thread::Pool& pool) {
                 options.pool = &pool;
             }
 
+            static void set_option(options_type& options, osmium::io::IOExecutor& executor) {
+                options.io_executor = &executor;
+            }
+
+            static void set_option(options_type& options, osmium::io::PipelineStats& stats) {
+                options.stats = &stats;
+            }
+
             static void set_option(options_type& options, const osmium::io::Header& header) {
                 options.header = header;
             }
@@ -190,6 +278,78 @@ namespace osmium {
                 options.sync = value;
             }
 
+            static void set_option(options_type& options, parallel_compression value) {
+                options.compression = value;
+            }
+
+            static void set_option(options_type& options, const writer_pipeline& value) {
+                options.pipeline = value;
+            }
+
+            static void set_option(options_type& options, const way_node_locations& value) {
+                options.locations = value;
+            }
+
+            template <typename... TArgs>
+            static options_type make_options(TArgs&&... args) {
+                options_type options;
+                (void)std::initializer_list<int>{
+                    (set_option(options, args), 0)...
+                };
+                return options;
+            }
+
+            Writer(const osmium::io::File& file, options_type&& options) :
+                m_file(file.check()),
+                m_pipeline(options.pipeline),
+                m_output_queue(m_pipeline.output_queue_size() != writer_pipeline::automatic() ? m_pipeline.output_queue_size() : detail::get_output_queue_size(), "raw_output"),
+                m_buffer_size(m_pipeline.buffer_size() != writer_pipeline::automatic() ? m_pipeline.buffer_size() : static_cast<std::size_t>(default_buffer_size)),
+                m_stats(options.stats) {
+                assert(!m_file.buffer()); // XXX can't handle pseudo-files
+
+                if (!options.pool) {
+                    options.pool = &thread::Pool::default_instance();
+                }
+
+                m_output = osmium::io::detail::OutputFormatFactory::instance().create_output(*options.pool, m_file, m_output_queue);
+
+                if (options.locations && !m_output->set_way_node_locations(options.locations)) {
+                    throw std::invalid_argument{"This output format can not add node locations to ways from a lookup."};
+                }
+
+                if (options.header.get("generator").empty()) {
+                    options.header.set("generator", "libosmium/" LIBOSMIUM_VERSION_STRING);
+                }
+
+                m_metadata_filename = m_file.get("metadata_sidecar");
+                if (!m_metadata_filename.empty()) {
+                    if (m_file.filename().empty() || m_file.filename() == "-") {
+                        throw std::invalid_argument{"The 'metadata_sidecar' option can not be used when writing to stdout."};
+                    }
+                    m_metadata.reset(new osmium::io::FileMetadata{});
+                    m_metadata->set_header(options.header);
+                }
+
+                const int fd = osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite);
+                std::unique_ptr<osmium::io::Compressor> compressor =
+                    options.compression == parallel_compression::yes
+                        ? CompressionFactory::instance().create_parallel_compressor(file.compression(), fd, options.sync, *options.pool)
+                        : CompressionFactory::instance().create_compressor(file.compression(), fd, options.sync);
+
+                std::promise<bool> write_promise;
+                m_write_future = write_promise.get_future();
+                if (options.io_executor) {
+                    m_write_stage = options.io_executor->add(std::unique_ptr<detail::io_stage>{
+                        new detail::WriteStage{m_output_queue, std::move(compressor), std::move(write_promise), &m_bytes_written, m_stats}});
+                } else {
+                    m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise), &m_bytes_written, m_stats};
+                }
+
+                ensure_cleanup([&](){
+                    m_output->write_header(options.header);
+                });
+            }
+
             void do_close() {
                 if (m_status == status::okay) {
                     ensure_cleanup([&](){
@@ -223,41 +383,42 @@ namespace osmium {
              *       before closing it? Can be osmium::io::fsync::yes or
              *       osmium::io::fsync::no (default).
              *
+             * * osmium::thread::Pool&: Thread pool used for encoding. If
+             *       this is not given, the default pool is used.
+             *
+             * * osmium::io::IOExecutor&: Write the output file in the
+             *       threads of this executor instead of in a separate
+             *       thread for this Writer. Use this if many Writers are
+             *       open at the same time. The executor must outlive the
+             *       Writer.
+             *
+             * * osmium::io::PipelineStats&: Record timing of the encoding
+             *       and writing stages. The stats object must outlive the
+             *       Writer.
+             *
+             * * osmium::io::parallel_compression: Compress gzip or bzip2
+             *       output in the thread pool? Can be
+             *       osmium::io::parallel_compression::yes or
+             *       osmium::io::parallel_compression::no (default).
+             *
+             * * osmium::io::writer_pipeline: Configuration of the output
+             *       queue size, the internal buffer size and the flush
+             *       policy.
+             *
+             * * osmium::io::way_node_locations: Look up the node
+             *       locations of ways while encoding them instead of
+             *       taking them from the ways. Implies the
+             *       "locations_on_ways" option. Only supported by the PBF
+             *       format.
+             *
              * @throws osmium::io_error If there was an error.
+             * @throws std::invalid_argument If way_node_locations are set
+             *         and the output format doesn't support them.
              * @throws std::system_error If the file could not be opened.
              */
             template <typename... TArgs>
             explicit Writer(const osmium::io::File& file, TArgs&&... args) :
-                m_file(file.check()) {
-                assert(!m_file.buffer()); // XXX can't handle pseudo-files
-
-                options_type options;
-                (void)std::initializer_list<int>{
-                    (set_option(options, args), 0)...
-                };
-
-                if (!options.pool) {
-                    options.pool = &thread::Pool::default_instance();
-                }
-
-                m_output = osmium::io::detail::OutputFormatFactory::instance().create_output(*options.pool, m_file, m_output_queue);
-
-                if (options.header.get("generator").empty()) {
-                    options.header.set("generator", "libosmium/" LIBOSMIUM_VERSION_STRING);
-                }
-
-                std::unique_ptr<osmium::io::Compressor> compressor =
-                    CompressionFactory::instance().create_compressor(file.compression(),
-                                                                     osmium::io::detail::open_for_writing(m_file.filename(), options.allow_overwrite),
-                                                                     options.sync);
-
-                std::promise<bool> write_promise;
-                m_write_future = write_promise.get_future();
-                m_thread = osmium::thread::thread_handler{write_thread, std::ref(m_output_queue), std::move(compressor), std::move(write_promise)};
-
-                ensure_cleanup([&](){
-                    m_output->write_header(options.header);
-                });
+                Writer(file, make_options(std::forward<TArgs>(args)...)) {
             }
 
             template <typename... TArgs>
@@ -299,6 +460,20 @@ namespace osmium {
                 m_buffer_size = size;
             }
 
+            /**
+             * Get the current statistics of the pipeline inside this
+             * Writer. This can be called at any time, also after close().
+             */
+            writer_statistics statistics() const {
+                writer_statistics stats = m_statistics;
+                stats.output_queue_full = m_output_queue.full_count();
+                stats.output_queue_empty = m_output_queue.empty_count();
+                stats.output_queue_largest = m_output_queue.largest_size();
+                stats.output_queue_size = m_output_queue.size();
+                stats.bytes_written = m_bytes_written;
+                return stats;
+            }
+
             /**
              * Flush the internal buffer if it contains any data. This is
              * usually not needed as the buffer gets flushed on close()
@@ -317,16 +492,53 @@ namespace osmium {
              * moved into this function and will be in an undefined moved-from
              * state afterwards.
              *
+             * With flush_policy::coalesce buffers smaller than the internal
+             * buffer are copied into it and written out later.
+             *
              * @param buffer Buffer that is being written out.
              * @throws Some form of osmium::io_error when there is a problem.
              */
             void operator()(osmium::memory::Buffer&& buffer) {
                 ensure_cleanup([&](){
+                    if (m_pipeline.policy() == flush_policy::coalesce &&
+                        buffer && buffer.committed() < m_buffer_size) {
+                        do_coalesce(std::move(buffer));
+                        return;
+                    }
                     do_flush();
                     do_write(std::move(buffer));
                 });
             }
 
+            /**
+             * Write the objects in a buffer selection to the output file
+             * without copying them into a buffer of their own first. The
+             * internal buffer is flushed before.
+             *
+             * The selection is moved into this function. The buffer it
+             * refers to is kept alive until the output is encoded.
+             *
+             * @param selection Selection that is being written out.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            void operator()(osmium::memory::BufferSelection&& selection) {
+                ensure_cleanup([&](){
+                    do_flush();
+                    if (selection.empty()) {
+                        return;
+                    }
+                    if (m_metadata) {
+                        // The metadata sidecar works on complete buffers.
+                        do_write(selection.copy());
+                        return;
+                    }
+                    const auto start = std::chrono::steady_clock::now();
+                    const std::size_t size = selection.byte_size();
+                    m_output->write_selection(std::move(selection));
+                    add_encode_statistics(start, size);
+                });
+            }
+
             /**
              * Add item to the internal buffer for eventual writing to the
              * output file.
@@ -349,6 +561,39 @@ namespace osmium {
                 });
             }
 
+            /**
+             * Write data which is already encoded in the format of the
+             * output file to it without decoding it. This is used to copy
+             * complete blobs from one PBF file into another. The data must
+             * contain everything needed to decode it on its own, for PBF
+             * this is the BlobHeader size, the BlobHeader and the Blob.
+             * Any objects written before are flushed first so the order is
+             * kept.
+             *
+             * This is not supported for all formats and options. The PBF
+             * output supports it unless the "pbf_check_order",
+             * "pbf_spatial_sort" or "pbf_index_sidecar" options are set. It
+             * is never supported if the "metadata_sidecar" option is set.
+             *
+             * @param data The encoded data.
+             * @param format The format the data is in.
+             * @returns true if the data was written, false if the output
+             *          can not take this data. Decode it and write the
+             *          objects in that case.
+             * @throws Some form of osmium::io_error when there is a problem.
+             */
+            bool write_raw(std::string&& data, osmium::io::file_format format) {
+                bool written = false;
+                ensure_cleanup([&](){
+                    do_flush();
+                    if (m_metadata) {
+                        return;
+                    }
+                    written = m_output->write_raw(std::move(data), format);
+                });
+                return written;
+            }
+
             /**
              * Flushes internal buffer and closes output file. If you do not
              * call this, the destructor of Writer will also do the same
@@ -356,6 +601,11 @@ namespace osmium {
              * the destructor will ignore, it is better to call close()
              * explicitly.
              *
+             * If the "metadata_sidecar" file option is set, the file is
+             * read back to calculate its checksum and the metadata file
+             * is written (see osmium::io::FileMetadata). This is only done
+             * by close(), not by the destructor.
+             *
              * @throws Some form of osmium::io_error when there is a problem.
              */
             void close() {
@@ -363,6 +613,10 @@ namespace osmium {
 
                 if (m_write_future.valid()) {
                     m_write_future.get();
+                    if (m_metadata) {
+                        m_metadata->checksum_file(m_file.filename());
+                        m_metadata->write(m_metadata_filename, osmium::io::overwrite::allow);
+                    }
                 }
             }
 
@@ -33,6 +33,14 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
 namespace osmium {
 
     namespace io {
@@ -53,6 +61,193 @@ namespace osmium {
             yes = true
         };
 
+        /**
+         * Should the Writer compress the output (gzip or bzip2) in the
+         * thread pool? The output then consists of several independently
+         * compressed gzip members or bzip2 streams.
+         */
+        enum class parallel_compression : bool {
+            no  = false,
+            yes = true
+        };
+
+        /**
+         * When does the Writer hand the data to the output format?
+         */
+        enum class flush_policy {
+            /// Buffers are handed over as they are written to the Writer.
+            immediate = 0,
+            /// Buffers smaller than the internal buffer of the Writer are
+            /// copied into it and handed over together when it is full.
+            /// This avoids many small blocks in the output file and many
+            /// small tasks in the thread pool.
+            coalesce  = 1
+        };
+
+        /**
+         * Configuration of the pipeline inside the Writer. The Writer
+         * encodes the data (usually in the thread pool), puts the results
+         * into the output queue, from where they are (optionally)
+         * compressed and written out in a separate thread.
+         */
+        class writer_pipeline {
+
+            std::size_t m_output_queue_size;
+            std::size_t m_buffer_size;
+            flush_policy m_flush_policy;
+
+        public:
+
+            /// Use the default for this setting.
+            static constexpr std::size_t automatic() noexcept {
+                return 0;
+            }
+
+            /**
+             * Create writer pipeline configuration.
+             *
+             * @param output_queue_size Maximum number of encoded blocks
+             *                          waiting to be written out. If this
+             *                          is full, writing to the Writer
+             *                          blocks. The default comes from the
+             *                          OSMIUM_MAX_OUTPUT_QUEUE_SIZE
+             *                          environment variable or is 20.
+             * @param buffer_size Size of the internal buffer of the Writer
+             *                    used for single items and for coalescing
+             *                    buffers. The default is 10 MBytes.
+             * @param policy Flush policy.
+             */
+            explicit constexpr writer_pipeline(std::size_t output_queue_size = automatic(),
+                                               std::size_t buffer_size = automatic(),
+                                               flush_policy policy = flush_policy::immediate) noexcept :
+                m_output_queue_size(output_queue_size),
+                m_buffer_size(buffer_size),
+                m_flush_policy(policy) {
+            }
+
+            constexpr std::size_t output_queue_size() const noexcept {
+                return m_output_queue_size;
+            }
+
+            constexpr std::size_t buffer_size() const noexcept {
+                return m_buffer_size;
+            }
+
+            constexpr flush_policy policy() const noexcept {
+                return m_flush_policy;
+            }
+
+        }; // class writer_pipeline
+
+        /**
+         * Statistics about the pipeline inside the Writer. Get them with
+         * Writer::statistics().
+         */
+        struct writer_statistics {
+
+            /// Number of buffers handed to the output format.
+            std::size_t buffers = 0;
+
+            /// Number of bytes of OSM data in those buffers.
+            std::size_t input_bytes = 0;
+
+            /// Time spent in the output format for all buffers. This is
+            /// the time spent in the thread calling the Writer, the work
+            /// done in the thread pool is not included.
+            std::chrono::nanoseconds encode_time{0};
+
+            /// Longest time spent in the output format for one buffer.
+            std::chrono::nanoseconds max_encode_time{0};
+
+            /// Number of pushes to the output queue that blocked because
+            /// the queue was full, ie. the writing stage was the bottleneck.
+            std::size_t output_queue_full = 0;
+
+            /// Number of times the write thread found the output queue
+            /// empty, ie. the encoding stage was the bottleneck.
+            std::size_t output_queue_empty = 0;
+
+            /// Largest number of entries in the output queue so far.
+            std::size_t output_queue_largest = 0;
+
+            /// Number of encoded blocks currently in flight between the
+            /// encoding and the writing stage.
+            std::size_t output_queue_size = 0;
+
+            /// Number of bytes written out (before compression).
+            std::size_t bytes_written = 0;
+
+        }; // struct writer_statistics
+
+        /**
+         * Lookup of node locations used by the Writer to add the locations
+         * to ways while encoding them. This is the same as running the
+         * osmium::handler::NodeLocationsForWays handler on the ways before
+         * writing them, but the locations are never written into the
+         * buffers, they go directly from the index into the output.
+         *
+         * Setting this on a Writer implies the "locations_on_ways" option.
+         * Currently only the PBF output format supports this. The index
+         * must contain all node locations (and be sorted, if the index
+         * type needs this) before the first way is written to the Writer,
+         * it is accessed from the thread pool.
+         */
+        class way_node_locations {
+
+            std::function<osmium::Location(osmium::object_id_type)> m_lookup;
+
+        public:
+
+            way_node_locations() = default;
+
+            /**
+             * Create from a function returning the location for a node
+             * id or an invalid location if the id is not known.
+             */
+            explicit way_node_locations(std::function<osmium::Location(osmium::object_id_type)> lookup) :
+                m_lookup(std::move(lookup)) {
+            }
+
+            /**
+             * Create from a location index (for instance any of the
+             * osmium::index::map classes) for positive ids. Nodes with
+             * negative ids get an invalid location.
+             *
+             * The index must stay alive as long as the Writer.
+             */
+            template <typename TIndex>
+            static way_node_locations from_index(const TIndex& index) {
+                return way_node_locations{[&index](osmium::object_id_type id) {
+                    return id >= 0 ? index.get_noexcept(static_cast<osmium::unsigned_object_id_type>(id))
+                                   : osmium::Location{};
+                }};
+            }
+
+            /**
+             * Create from two location indexes, one for positive and one
+             * for negative ids, like the ones used in the
+             * NodeLocationsForWays handler.
+             *
+             * The indexes must stay alive as long as the Writer.
+             */
+            template <typename TIndexPos, typename TIndexNeg>
+            static way_node_locations from_index(const TIndexPos& index_pos, const TIndexNeg& index_neg) {
+                return way_node_locations{[&index_pos, &index_neg](osmium::object_id_type id) {
+                    return id >= 0 ? index_pos.get_noexcept(static_cast<osmium::unsigned_object_id_type>(id))
+                                   : index_neg.get_noexcept(static_cast<osmium::unsigned_object_id_type>(-id));
+                }};
+            }
+
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(m_lookup);
+            }
+
+            osmium::Location operator()(osmium::object_id_type id) const {
+                return m_lookup(id);
+            }
+
+        }; // class way_node_locations
+
     } // namespace io
 
 } // namespace osmium
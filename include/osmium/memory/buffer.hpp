@@ -48,6 +48,10 @@ DEALINGS IN THE SOFTWARE.
 #include <stdexcept>
 #include <utility>
 
+#ifdef OSMIUM_WITH_MEMORY_ACCOUNTING
+# include <atomic>
+#endif
+
 namespace osmium {
 
     /**
@@ -68,6 +72,109 @@ namespace osmium {
      */
     namespace memory {
 
+        /**
+         * Interface for allocators providing the memory for Buffers. Use
+         * this to put buffers into memory pools, per-thread arenas, huge
+         * pages, or memory local to a NUMA node. See
+         * osmium/memory/buffer_allocator.hpp for some implementations.
+         *
+         * Allocators must be thread-safe if buffers using them are created
+         * or destroyed in different threads, which is usually the case when
+         * they are used with the Reader. An allocator must outlive all
+         * buffers using it.
+         */
+        class BufferAllocator {
+
+        public:
+
+            BufferAllocator() = default;
+
+            BufferAllocator(const BufferAllocator&) = delete;
+            BufferAllocator& operator=(const BufferAllocator&) = delete;
+
+            BufferAllocator(BufferAllocator&&) = delete;
+            BufferAllocator& operator=(BufferAllocator&&) = delete;
+
+            virtual ~BufferAllocator() noexcept = default;
+
+            /**
+             * Allocate memory of the given size. The memory must be aligned
+             * at least to osmium::memory::align_bytes.
+             *
+             * @throws std::bad_alloc (or an exception derived from it) if
+             *         the memory can not be allocated.
+             */
+            virtual unsigned char* allocate(std::size_t size) = 0;
+
+            /**
+             * Free memory allocated with allocate().
+             *
+             * @param data Pointer returned by allocate().
+             * @param size The size given to allocate().
+             */
+            virtual void deallocate(unsigned char* data, std::size_t size) noexcept = 0;
+
+        }; // class BufferAllocator
+
+        namespace detail {
+
+#ifdef OSMIUM_WITH_MEMORY_ACCOUNTING
+            inline std::atomic<std::size_t>& buffer_memory_counter() noexcept {
+                static std::atomic<std::size_t> counter{0};
+                return counter;
+            }
+#endif
+
+            class buffer_memory_deleter {
+
+                BufferAllocator* m_allocator = nullptr;
+                std::size_t m_size = 0;
+
+            public:
+
+                buffer_memory_deleter() noexcept = default;
+
+                buffer_memory_deleter(BufferAllocator* allocator, std::size_t size) noexcept :
+                    m_allocator(allocator),
+                    m_size(size) {
+                }
+
+                BufferAllocator* allocator() const noexcept {
+                    return m_allocator;
+                }
+
+                void operator()(unsigned char* data) const noexcept {
+#ifdef OSMIUM_WITH_MEMORY_ACCOUNTING
+                    buffer_memory_counter() -= m_size;
+#endif
+                    if (m_allocator) {
+                        m_allocator->deallocate(data, m_size);
+                    } else {
+                        delete[] data;
+                    }
+                }
+
+            }; // class buffer_memory_deleter
+
+        } // namespace detail
+
+        /**
+         * The number of bytes currently allocated by all buffers with
+         * internal memory management. Memory of buffers created from a
+         * std::unique_ptr is not counted.
+         *
+         * This is only tracked if libosmium was compiled with
+         * OSMIUM_WITH_MEMORY_ACCOUNTING defined, otherwise this always
+         * returns 0.
+         */
+        inline std::size_t buffer_memory_in_use() noexcept {
+#ifdef OSMIUM_WITH_MEMORY_ACCOUNTING
+            return detail::buffer_memory_counter();
+#else
+            return 0;
+#endif
+        }
+
         /**
          * A memory area for storing OSM objects and other items. Each item stored
          * has a type and a length. See the Item class for details.
@@ -88,6 +195,10 @@ namespace osmium {
          * create a Buffer object and have it manage the memory internally. It will
          * dynamically allocate memory and free it again after use.
          *
+         * Internally managed memory is allocated with new[] or, if one is
+         * given in the constructor, with a BufferAllocator. Buffers that
+         * grow get their new memory from the same allocator.
+         *
          * By default, if a buffer gets full it will throw a buffer_is_full exception.
          * You can use the set_full_callback() method to set a callback functor
          * which will be called instead of throwing an exception. The full
@@ -109,8 +220,10 @@ namespace osmium {
 
         private:
 
+            using memory_type = std::unique_ptr<unsigned char[], detail::buffer_memory_deleter>;
+
             std::unique_ptr<Buffer> m_next_buffer;
-            std::unique_ptr<unsigned char[]> m_memory{};
+            memory_type m_memory{};
             unsigned char* m_data = nullptr;
             std::size_t m_capacity = 0;
             std::size_t m_written = 0;
@@ -133,14 +246,33 @@ namespace osmium {
                 return padded_length(capacity);
             }
 
+            static memory_type allocate_memory(std::size_t size, BufferAllocator* allocator) {
+                memory_type memory{allocator ? allocator->allocate(size) : new unsigned char[size],
+                                   detail::buffer_memory_deleter{allocator, size}};
+#ifdef OSMIUM_WITH_MEMORY_ACCOUNTING
+                detail::buffer_memory_counter() += size;
+#endif
+                return memory;
+            }
+
+            explicit Buffer(memory_type&& memory, std::size_t capacity, std::size_t committed) noexcept :
+                m_next_buffer(),
+                m_memory(std::move(memory)),
+                m_data(m_memory.get()),
+                m_capacity(capacity),
+                m_written(committed),
+                m_committed(committed) {
+            }
+
             void grow_internal() {
                 assert(m_data && "This must be a valid buffer");
                 if (!m_memory) {
                     throw std::logic_error{"Can't grow Buffer if it doesn't use internal memory management."};
                 }
 
+                memory_type memory{allocate_memory(m_capacity, allocator())};
                 std::unique_ptr<Buffer> old{new Buffer{std::move(m_memory), m_capacity, m_committed}};
-                m_memory = std::unique_ptr<unsigned char[]>{new unsigned char[m_capacity]};
+                m_memory = std::move(memory);
                 m_data = m_memory.get();
 
                 m_written -= m_committed;
@@ -230,7 +362,7 @@ namespace osmium {
              */
             explicit Buffer(std::unique_ptr<unsigned char[]> data, std::size_t capacity, std::size_t committed) :
                 m_next_buffer(),
-                m_memory(std::move(data)),
+                m_memory(data.release()),
                 m_data(m_memory.get()),
                 m_capacity(capacity),
                 m_written(committed),
@@ -260,7 +392,27 @@ namespace osmium {
              */
             explicit Buffer(std::size_t capacity, auto_grow auto_grow = auto_grow::yes) :
                 m_next_buffer(),
-                m_memory(new unsigned char[calculate_capacity(capacity)]),
+                m_memory(allocate_memory(calculate_capacity(capacity), nullptr)),
+                m_data(m_memory.get()),
+                m_capacity(calculate_capacity(capacity)),
+                m_auto_grow(auto_grow) {
+            }
+
+            /**
+             * Constructs a valid internally memory-managed buffer with the
+             * given capacity using memory from the allocator. The memory
+             * will be given back to the allocator when the Buffer is
+             * destroyed.
+             *
+             * @param capacity The (initial) size of the memory for this buffer.
+             *        Actual capacity might be larger tue to alignment.
+             * @param auto_grow Should this buffer automatically grow when it
+             *        becomes to small?
+             * @param allocator The allocator. It must outlive the buffer.
+             */
+            Buffer(std::size_t capacity, auto_grow auto_grow, BufferAllocator& allocator) :
+                m_next_buffer(),
+                m_memory(allocate_memory(calculate_capacity(capacity), &allocator)),
                 m_data(m_memory.get()),
                 m_capacity(calculate_capacity(capacity)),
                 m_auto_grow(auto_grow) {
@@ -366,6 +518,38 @@ namespace osmium {
                 return m_written;
             }
 
+            /**
+             * Does this buffer manage its own memory? Only those buffers
+             * can grow.
+             */
+            bool has_internal_memory() const noexcept {
+                return m_memory != nullptr;
+            }
+
+            /**
+             * The allocator used for the memory of this buffer. Returns
+             * nullptr for buffers using new[] or external memory.
+             */
+            BufferAllocator* allocator() const noexcept {
+                return m_memory.get_deleter().allocator();
+            }
+
+            /**
+             * Returns the auto_grow setting of this buffer.
+             */
+            auto_grow get_auto_grow() const noexcept {
+                return m_auto_grow;
+            }
+
+            /**
+             * Change the auto_grow setting of this buffer. Setting it to
+             * anything but auto_grow::no only makes sense for buffers with
+             * internal memory management.
+             */
+            void set_auto_grow(auto_grow value) noexcept {
+                m_auto_grow = value;
+            }
+
             /**
              * This tests if the current state of the buffer is aligned
              * properly. Can be used for asserts.
@@ -419,7 +603,7 @@ namespace osmium {
                 }
                 size = calculate_capacity(size);
                 if (m_capacity < size) {
-                    std::unique_ptr<unsigned char[]> memory{new unsigned char[size]};
+                    memory_type memory{allocate_memory(size, allocator())};
                     std::copy_n(m_memory.get(), m_capacity, memory.get());
                     using std::swap;
                     swap(m_memory, memory);
@@ -0,0 +1,135 @@
+#ifndef OSMIUM_MEMORY_BUFFER_ALLOCATOR_HPP
+#define OSMIUM_MEMORY_BUFFER_ALLOCATOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/index/detail/mmap_hints.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+#ifndef _WIN32
+# include <sys/mman.h>
+#endif
+
+// for BSD systems
+#if !defined(_WIN32) && !defined(MAP_ANONYMOUS)
+# define MAP_ANONYMOUS MAP_ANON
+#endif
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Buffer allocator getting memory for large buffers directly from
+         * the operating system through anonymous memory mappings. Small
+         * buffers are allocated with new[].
+         *
+         * Because memory is only backed by physical pages when it is first
+         * written to, buffers are placed on the NUMA node of the thread
+         * filling them, for instance the worker thread decoding data in the
+         * Reader. Memory mapping hints can be used to ask for transparent
+         * huge pages or to interleave pages over all NUMA nodes instead.
+         *
+         * On Windows all memory is allocated with new[].
+         *
+         * The allocator is thread-safe.
+         */
+        class MmapBufferAllocator : public BufferAllocator {
+
+            osmium::detail::mmap_hints m_hints;
+            std::size_t m_min_mmap_size;
+            std::atomic<std::size_t> m_allocated{0};
+
+        public:
+
+            enum : std::size_t {
+                default_min_mmap_size = 64UL * 1024UL
+            };
+
+            /**
+             * Create allocator.
+             *
+             * @param hints Hints on how the kernel should back the memory.
+             * @param min_mmap_size Buffers smaller than this are allocated
+             *                      with new[].
+             */
+            explicit MmapBufferAllocator(const osmium::detail::mmap_hints& hints = osmium::detail::mmap_hints{},
+                                         std::size_t min_mmap_size = default_min_mmap_size) :
+                m_hints(hints),
+                m_min_mmap_size(min_mmap_size) {
+            }
+
+            unsigned char* allocate(std::size_t size) override {
+#ifndef _WIN32
+                if (size >= m_min_mmap_size) {
+                    void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0); // NOLINT(hicpp-signed-bitwise)
+                    if (addr == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                        throw std::bad_alloc{};
+                    }
+                    osmium::detail::apply_mmap_hints(addr, size, m_hints);
+                    m_allocated += size;
+                    return static_cast<unsigned char*>(addr);
+                }
+#endif
+                auto* data = new unsigned char[size];
+                m_allocated += size;
+                return data;
+            }
+
+            void deallocate(unsigned char* data, std::size_t size) noexcept override {
+                m_allocated -= size;
+#ifndef _WIN32
+                if (size >= m_min_mmap_size) {
+                    ::munmap(data, size);
+                    return;
+                }
+#endif
+                delete[] data;
+            }
+
+            /// The number of bytes currently allocated through this allocator.
+            std::size_t allocated() const noexcept {
+                return m_allocated;
+            }
+
+        }; // class MmapBufferAllocator
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_ALLOCATOR_HPP
@@ -0,0 +1,280 @@
+#ifndef OSMIUM_MEMORY_BUFFER_ARENA_HPP
+#define OSMIUM_MEMORY_BUFFER_ARENA_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        class BufferArena;
+
+        /**
+         * A buffer handed out by a BufferArena. Use buffer() with the
+         * builders like any other buffer. When the ArenaBuffer is
+         * destroyed, the buffer goes back to the arena and its memory is
+         * used again for the next ArenaBuffer. Call reset() to throw away
+         * the contents and build again in the same memory.
+         *
+         * An ArenaBuffer must be destroyed in the thread and before the
+         * arena it came from.
+         */
+        class ArenaBuffer {
+
+            BufferArena* m_arena;
+            Buffer m_buffer;
+
+        public:
+
+            ArenaBuffer(BufferArena& arena, Buffer&& buffer) noexcept :
+                m_arena(&arena),
+                m_buffer(std::move(buffer)) {
+            }
+
+            ArenaBuffer(const ArenaBuffer&) = delete;
+            ArenaBuffer& operator=(const ArenaBuffer&) = delete;
+
+            ArenaBuffer(ArenaBuffer&& other) noexcept :
+                m_arena(other.m_arena),
+                m_buffer(std::move(other.m_buffer)) {
+                other.m_arena = nullptr;
+            }
+
+            ArenaBuffer& operator=(ArenaBuffer&&) = delete;
+
+            ~ArenaBuffer() noexcept;
+
+            /// The buffer to build into.
+            Buffer& buffer() noexcept {
+                return m_buffer;
+            }
+
+            /// The buffer to build into.
+            const Buffer& buffer() const noexcept {
+                return m_buffer;
+            }
+
+            /**
+             * Throw away the contents of the buffer. This keeps the
+             * memory, so it is very cheap.
+             */
+            void reset() noexcept {
+                m_buffer.clear();
+            }
+
+        }; // class ArenaBuffer
+
+        /**
+         * A small arena of buffers for code building many short-lived
+         * objects, for instance per-object transformations in a handler.
+         * Instead of creating a Buffer for every object, get() one from
+         * the arena. Once the ArenaBuffer is destroyed, the memory is
+         * cleared and kept for reuse, so after a warm-up no memory is
+         * allocated or freed any more.
+         *
+         * The arena is not thread-safe. Use thread_local_instance() to get
+         * an arena for the current thread.
+         */
+        class BufferArena {
+
+            std::vector<Buffer> m_buffers{};
+            std::size_t m_capacity;
+            std::size_t m_max_buffers;
+
+        public:
+
+            enum : std::size_t {
+                default_capacity = 64UL * 1024UL,
+                default_max_buffers = 8
+            };
+
+            /**
+             * Create arena.
+             *
+             * @param capacity Initial capacity of new buffers. The buffers
+             *                 grow automatically if needed.
+             * @param max_buffers Maximum number of unused buffers kept in
+             *                    the arena.
+             */
+            explicit BufferArena(std::size_t capacity = default_capacity, std::size_t max_buffers = default_max_buffers) :
+                m_capacity(capacity),
+                m_max_buffers(max_buffers) {
+            }
+
+            BufferArena(const BufferArena&) = delete;
+            BufferArena& operator=(const BufferArena&) = delete;
+
+            BufferArena(BufferArena&&) = delete;
+            BufferArena& operator=(BufferArena&&) = delete;
+
+            ~BufferArena() noexcept = default;
+
+            /**
+             * The arena of the current thread. It is created on first use
+             * and destroyed when the thread ends.
+             */
+            static BufferArena& thread_local_instance() {
+                static thread_local BufferArena arena;
+                return arena;
+            }
+
+            /**
+             * Get an empty buffer. The most recently released buffer is
+             * used, if there is none, a new one is created.
+             */
+            ArenaBuffer get() {
+                if (m_buffers.empty()) {
+                    return ArenaBuffer{*this, Buffer{m_capacity, Buffer::auto_grow::yes}};
+                }
+                ArenaBuffer buffer{*this, std::move(m_buffers.back())};
+                m_buffers.pop_back();
+                return buffer;
+            }
+
+            /**
+             * Give a buffer back to the arena. This is called by the
+             * destructor of ArenaBuffer. The buffer is cleared. If the
+             * arena already holds max_buffers buffers, it is destroyed.
+             */
+            void release(Buffer&& buffer) noexcept {
+                if (!buffer || !buffer.has_internal_memory() || buffer.has_nested_buffers() || m_buffers.size() >= m_max_buffers) {
+                    return;
+                }
+                buffer.clear();
+                try {
+                    m_buffers.push_back(std::move(buffer));
+                } catch (...) {
+                    // ignore, the buffer is simply not reused
+                }
+            }
+
+            /// The number of unused buffers in the arena.
+            std::size_t size() const noexcept {
+                return m_buffers.size();
+            }
+
+            /// Destroy all unused buffers in the arena.
+            void clear() noexcept {
+                m_buffers.clear();
+            }
+
+        }; // class BufferArena
+
+        inline ArenaBuffer::~ArenaBuffer() noexcept {
+            if (m_arena) {
+                m_arena->release(std::move(m_buffer));
+            }
+        }
+
+        /**
+         * Helper for building many items in arena memory and moving them
+         * into a destination buffer in batches. Build the items in
+         * buffer() and commit them as usual, then call possibly_flush().
+         * Once the committed items reach the batch size they are appended
+         * to the destination buffer in one go and the arena buffer is
+         * reset.
+         *
+         * Call flush() at the end, the destructor does not do this.
+         */
+        class BatchedAppender {
+
+            Buffer& m_destination;
+            ArenaBuffer m_scratch;
+            std::size_t m_batch_size;
+
+        public:
+
+            enum : std::size_t {
+                default_batch_size = 32UL * 1024UL
+            };
+
+            /**
+             * Create a BatchedAppender.
+             *
+             * @param destination The buffer the items are appended to. It
+             *                    must outlive the BatchedAppender.
+             * @param batch_size Number of bytes after which the items
+             *                   are appended to the destination.
+             * @param arena The arena to get the memory from.
+             */
+            explicit BatchedAppender(Buffer& destination,
+                                     std::size_t batch_size = default_batch_size,
+                                     BufferArena& arena = BufferArena::thread_local_instance()) :
+                m_destination(destination),
+                m_scratch(arena.get()),
+                m_batch_size(batch_size) {
+            }
+
+            /// The buffer to build the items into.
+            Buffer& buffer() noexcept {
+                return m_scratch.buffer();
+            }
+
+            /**
+             * Append all committed items to the destination buffer and
+             * commit them there. Uncommitted data is thrown away.
+             *
+             * @throws osmium::buffer_is_full If the destination buffer is
+             *         full and can not grow.
+             */
+            void flush() {
+                Buffer& scratch = m_scratch.buffer();
+                if (scratch.committed() > 0) {
+                    m_destination.add_buffer(scratch);
+                    m_destination.commit();
+                }
+                m_scratch.reset();
+            }
+
+            /// Call flush() if the batch is full.
+            void possibly_flush() {
+                if (m_scratch.buffer().committed() >= m_batch_size) {
+                    flush();
+                }
+            }
+
+        }; // class BatchedAppender
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_ARENA_HPP
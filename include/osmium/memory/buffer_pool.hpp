@@ -0,0 +1,181 @@
+#ifndef OSMIUM_MEMORY_BUFFER_POOL_HPP
+#define OSMIUM_MEMORY_BUFFER_POOL_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * A thread-safe pool of buffers which are not needed any more and
+         * can be re-used instead of allocating new memory. This is useful
+         * if many buffers of similar size are created and destroyed, for
+         * instance when reading OSM files. Give the pool to the Reader as
+         * option (see osmium::io::read_buffers) and release() buffers back
+         * to the pool when you are done with them.
+         *
+         * Only buffers managing their own memory are kept in the pool, all
+         * others are simply destroyed when released.
+         */
+        class BufferPool {
+
+            mutable std::mutex m_mutex{};
+            std::vector<Buffer> m_buffers{};
+            std::size_t m_max_buffers;
+            BufferAllocator* m_allocator = nullptr;
+
+        public:
+
+            enum {
+                default_max_buffers = 16
+            };
+
+            /**
+             * Create buffer pool.
+             *
+             * @param max_buffers Maximum number of buffers kept in the
+             *                    pool. Buffers released into a full pool
+             *                    are destroyed.
+             */
+            explicit BufferPool(std::size_t max_buffers = default_max_buffers) :
+                m_max_buffers(max_buffers) {
+            }
+
+            /**
+             * Create buffer pool getting the memory for new buffers from
+             * the allocator.
+             *
+             * @param allocator The allocator. It must outlive the pool and
+             *                  all buffers taken from it.
+             * @param max_buffers Maximum number of buffers kept in the
+             *                    pool. Buffers released into a full pool
+             *                    are destroyed.
+             */
+            explicit BufferPool(BufferAllocator& allocator, std::size_t max_buffers = default_max_buffers) :
+                m_max_buffers(max_buffers),
+                m_allocator(&allocator) {
+            }
+
+            BufferPool(const BufferPool&) = delete;
+            BufferPool& operator=(const BufferPool&) = delete;
+
+            BufferPool(BufferPool&&) = delete;
+            BufferPool& operator=(BufferPool&&) = delete;
+
+            ~BufferPool() noexcept = default;
+
+            /**
+             * Get an empty buffer with at least the given capacity. The
+             * smallest buffer from the pool which is large enough is used,
+             * if there is none a new buffer is created (using the allocator
+             * if there is one).
+             *
+             * @param capacity Minimum capacity of the buffer.
+             * @param auto_grow Auto grow setting of the buffer returned.
+             */
+            Buffer get(std::size_t capacity, Buffer::auto_grow auto_grow = Buffer::auto_grow::yes) {
+                {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    auto best = m_buffers.end();
+                    for (auto it = m_buffers.begin(); it != m_buffers.end(); ++it) {
+                        if (it->capacity() >= capacity &&
+                            (best == m_buffers.end() || it->capacity() < best->capacity())) {
+                            best = it;
+                        }
+                    }
+                    if (best != m_buffers.end()) {
+                        Buffer buffer{std::move(*best)};
+                        if (best != m_buffers.end() - 1) {
+                            *best = std::move(m_buffers.back());
+                        }
+                        m_buffers.pop_back();
+                        buffer.set_auto_grow(auto_grow);
+                        return buffer;
+                    }
+                }
+                if (m_allocator) {
+                    return Buffer{capacity, auto_grow, *m_allocator};
+                }
+                return Buffer{capacity, auto_grow};
+            }
+
+            /**
+             * Give a buffer back to the pool. The buffer is cleared, its
+             * contents are lost. Nested buffers are released, too.
+             * Invalid buffers and buffers not managing their own memory
+             * are destroyed.
+             */
+            void release(Buffer&& buffer) {
+                while (buffer && buffer.has_nested_buffers()) {
+                    std::unique_ptr<Buffer> nested{buffer.get_last_nested()};
+                    release(std::move(*nested));
+                }
+                if (!buffer || !buffer.has_internal_memory()) {
+                    return;
+                }
+                Buffer released{std::move(buffer)};
+                released.clear();
+                std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_buffers.size() < m_max_buffers) {
+                    m_buffers.push_back(std::move(released));
+                }
+            }
+
+            /// The number of buffers currently in the pool.
+            std::size_t size() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_buffers.size();
+            }
+
+            /// Destroy all buffers in the pool.
+            void clear() {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                m_buffers.clear();
+            }
+
+        }; // class BufferPool
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_POOL_HPP
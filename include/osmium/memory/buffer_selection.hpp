@@ -0,0 +1,219 @@
+#ifndef OSMIUM_MEMORY_BUFFER_SELECTION_HPP
+#define OSMIUM_MEMORY_BUFFER_SELECTION_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/entity.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Some of the entities (OSM objects or changesets) in a buffer,
+         * referenced by their offsets in the buffer. This can be used to
+         * write a subset of a buffer with the Writer without copying the
+         * selected objects into a new buffer first.
+         *
+         * The buffer is held through a shared pointer, so several
+         * selections (for instance for different output files) can share
+         * the same buffer which is freed when the last of them goes away.
+         * The buffer must not be changed while a selection uses it.
+         *
+         * The entities are visited in the order they were added.
+         */
+        class BufferSelection {
+
+            std::shared_ptr<const Buffer> m_buffer;
+            std::vector<std::size_t> m_offsets;
+
+        public:
+
+            /**
+             * Iterator over the selected entities.
+             */
+            class const_iterator {
+
+                const unsigned char* m_data;
+                std::vector<std::size_t>::const_iterator m_it;
+
+            public:
+
+                using iterator_category = std::forward_iterator_tag;
+                using value_type        = const osmium::OSMEntity;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = value_type*;
+                using reference         = value_type&;
+
+                const_iterator(const unsigned char* data, std::vector<std::size_t>::const_iterator it) noexcept :
+                    m_data(data),
+                    m_it(it) {
+                }
+
+                const_iterator& operator++() noexcept {
+                    ++m_it;
+                    return *this;
+                }
+
+                const_iterator operator++(int) noexcept {
+                    const_iterator tmp{*this};
+                    ++m_it;
+                    return tmp;
+                }
+
+                bool operator==(const const_iterator& rhs) const noexcept {
+                    return m_it == rhs.m_it;
+                }
+
+                bool operator!=(const const_iterator& rhs) const noexcept {
+                    return m_it != rhs.m_it;
+                }
+
+                reference operator*() const noexcept {
+                    return *reinterpret_cast<pointer>(m_data + *m_it);
+                }
+
+                pointer operator->() const noexcept {
+                    return &operator*();
+                }
+
+            }; // class const_iterator
+
+            /**
+             * Create an empty selection from a buffer shared with other
+             * selections or other code.
+             */
+            explicit BufferSelection(std::shared_ptr<const Buffer> buffer) noexcept :
+                m_buffer(std::move(buffer)) {
+            }
+
+            /**
+             * Create an empty selection taking over the buffer.
+             */
+            explicit BufferSelection(Buffer&& buffer) :
+                m_buffer(std::make_shared<const Buffer>(std::move(buffer))) {
+            }
+
+            /// The buffer the selected entities are in.
+            const Buffer& buffer() const noexcept {
+                return *m_buffer;
+            }
+
+            /// The shared pointer to the buffer.
+            const std::shared_ptr<const Buffer>& shared_buffer() const noexcept {
+                return m_buffer;
+            }
+
+            /**
+             * Add an entity to the selection.
+             *
+             * @pre The entity must be in the committed part of the buffer
+             *      of this selection.
+             */
+            void add(const osmium::OSMEntity& entity) {
+                assert(m_buffer);
+                assert(entity.data() >= m_buffer->data() &&
+                       entity.data() < m_buffer->data() + m_buffer->committed());
+                m_offsets.push_back(static_cast<std::size_t>(entity.data() - m_buffer->data()));
+            }
+
+            /// Reserve space for this many entities.
+            void reserve(const std::size_t size) {
+                m_offsets.reserve(size);
+            }
+
+            /// The number of selected entities.
+            std::size_t size() const noexcept {
+                return m_offsets.size();
+            }
+
+            /// Is nothing selected?
+            bool empty() const noexcept {
+                return m_offsets.empty();
+            }
+
+            /// The number of bytes of all selected entities.
+            std::size_t byte_size() const noexcept {
+                std::size_t bytes = 0;
+                for (const auto& entity : *this) {
+                    bytes += entity.padded_size();
+                }
+                return bytes;
+            }
+
+            const_iterator begin() const noexcept {
+                return const_iterator{m_buffer ? m_buffer->data() : nullptr, m_offsets.cbegin()};
+            }
+
+            const_iterator end() const noexcept {
+                return const_iterator{m_buffer ? m_buffer->data() : nullptr, m_offsets.cend()};
+            }
+
+            const_iterator cbegin() const noexcept {
+                return begin();
+            }
+
+            const_iterator cend() const noexcept {
+                return end();
+            }
+
+            /**
+             * Copy the selected entities into a new buffer. This is used
+             * where a selection can't be handled directly.
+             */
+            Buffer copy() const {
+                Buffer out{std::max(byte_size(), std::size_t{64}), Buffer::auto_grow::no};
+                for (const auto& entity : *this) {
+                    out.push_back(entity);
+                }
+                return out;
+            }
+
+        }; // class BufferSelection
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_BUFFER_SELECTION_HPP
@@ -34,15 +34,48 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <cstddef>
 #include <functional>
+#include <future>
 #include <utility>
 
 namespace osmium {
 
     namespace memory {
 
+        namespace detail {
+
+            /**
+             * Task calling the callback of a CallbackBuffer in a background
+             * thread. Returns the buffer for re-use if the callback didn't
+             * move it away.
+             */
+            class callback_buffer_flush_task {
+
+                std::function<void(osmium::memory::Buffer&&)> m_callback;
+                osmium::memory::Buffer m_buffer;
+
+            public:
+
+                callback_buffer_flush_task(std::function<void(osmium::memory::Buffer&&)> callback, osmium::memory::Buffer&& buffer) :
+                    m_callback(std::move(callback)),
+                    m_buffer(std::move(buffer)) {
+                }
+
+                osmium::memory::Buffer operator()() {
+                    m_callback(std::move(m_buffer));
+                    if (m_buffer) {
+                        m_buffer.clear();
+                    }
+                    return std::move(m_buffer);
+                }
+
+            }; // class callback_buffer_flush_task
+
+        } // namespace detail
+
         /**
          * This is basically a wrapper around osmium::memory::Buffer with an
          * additional callback function that is called whenever the buffer is
@@ -57,6 +90,13 @@ namespace osmium {
          * needed. This can happen if a new object doesn't fit into the rest
          * of the buffer available or if no callback function is set (yet).
          *
+         * With enable_background_flush() the callback is called in a task
+         * in a thread pool when the buffer is full, while the producer keeps
+         * filling a second buffer. At most one of those tasks is running at
+         * any time, so the callback still sees the buffers one after the
+         * other in the right order. The buffer is re-used after the callback
+         * returns unless the callback moved it away.
+         *
          * Example:
          * @code
          *     CallbackBuffer cb;
@@ -89,6 +129,27 @@ namespace osmium {
             std::size_t m_max_buffer_size;
             callback_func_type m_callback;
 
+            // Buffer returned from the last background flush for re-use.
+            std::future<osmium::memory::Buffer> m_pending{};
+            osmium::thread::Pool* m_pool = nullptr;
+
+            osmium::memory::Buffer new_buffer() {
+                if (m_pending.valid()) {
+                    osmium::memory::Buffer buffer{m_pending.get()};
+                    if (buffer) {
+                        return buffer;
+                    }
+                }
+                return osmium::memory::Buffer{m_initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+            }
+
+            void flush_in_background() {
+                osmium::memory::Buffer buffer{new_buffer()};
+                using std::swap;
+                swap(buffer, m_buffer);
+                m_pending = m_pool->submit(detail::callback_buffer_flush_task{m_callback, std::move(buffer)});
+            }
+
         public:
 
             /**
@@ -124,6 +185,20 @@ namespace osmium {
                 m_callback(std::move(callback)) {
             }
 
+            CallbackBuffer(const CallbackBuffer&) = delete;
+            CallbackBuffer& operator=(const CallbackBuffer&) = delete;
+
+            CallbackBuffer(CallbackBuffer&&) = default;
+            CallbackBuffer& operator=(CallbackBuffer&&) = default;
+
+            ~CallbackBuffer() noexcept {
+                try {
+                    wait();
+                } catch (...) {
+                    // Ignore any exceptions because destructor must not throw.
+                }
+            }
+
             /**
              * Access the internal buffer. This is used to fill the buffer,
              * the CallbackBuffer still owns the buffer.
@@ -145,6 +220,45 @@ namespace osmium {
                 m_callback = callback;
             }
 
+            /**
+             * Call the callback in a task in the specified pool when the
+             * buffer is flushed from possibly_flush(). The callback must not
+             * access data used by the producer without synchronization.
+             *
+             * @param pool The thread pool to use.
+             */
+            void enable_background_flush(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) noexcept {
+                m_pool = &pool;
+            }
+
+            /**
+             * Wait for any background flush to finish and call the callback
+             * in the calling thread from now on.
+             *
+             * @throws Any exception thrown by the callback.
+             */
+            void disable_background_flush() {
+                wait();
+                m_pool = nullptr;
+            }
+
+            /// Is background flushing enabled?
+            bool background_flush() const noexcept {
+                return m_pool != nullptr;
+            }
+
+            /**
+             * Wait until the callback for the buffer handed to the
+             * background thread has returned.
+             *
+             * @throws Any exception thrown by the callback.
+             */
+            void wait() {
+                if (m_pending.valid()) {
+                    m_pending.get();
+                }
+            }
+
             /**
              * Flush the internal buffer regardless of how full it is. Calls
              * the callback with the buffer and creates an new empty internal
@@ -152,11 +266,21 @@ namespace osmium {
              *
              * This will do nothing if no callback is set or if the buffer
              * is empty.
+             *
+             * If background flushing is enabled, this waits until all
+             * buffers have been handed to the callback.
+             *
+             * @throws Any exception thrown by the callback.
              */
             void flush() {
                 if (m_callback && m_buffer.committed() > 0) {
-                    m_callback(read());
+                    if (m_pool) {
+                        flush_in_background();
+                    } else {
+                        m_callback(read());
+                    }
                 }
+                wait();
             }
 
             /**
@@ -166,10 +290,19 @@ namespace osmium {
              *
              * This will do nothing if no callback is set or if the buffer
              * is empty.
+             *
+             * If background flushing is enabled, the callback is called in
+             * a background task after the previous one has finished.
+             *
+             * @throws Any exception thrown by the callback.
              */
             void possibly_flush() {
-                if (m_buffer.committed() > m_max_buffer_size) {
-                    flush();
+                if (m_buffer.committed() > m_max_buffer_size && m_callback) {
+                    if (m_pool) {
+                        flush_in_background();
+                    } else {
+                        m_callback(read());
+                    }
                 }
             }
 
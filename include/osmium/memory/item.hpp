@@ -45,6 +45,10 @@ namespace osmium {
         class Builder;
     } // namespace builder
 
+    namespace tags {
+        class TagEditor;
+    } // namespace tags
+
     enum class diff_indicator_type {
         none  = 0,
         left  = 1,
@@ -118,6 +122,8 @@ namespace osmium {
 
             friend class osmium::builder::Builder;
 
+            friend class osmium::tags::TagEditor;
+
             Item& add_size(const item_size_type size) noexcept {
                 m_size += size;
                 return *this;
@@ -0,0 +1,189 @@
+#ifndef OSMIUM_MEMORY_NODE_COLUMNS_HPP
+#define OSMIUM_MEMORY_NODE_COLUMNS_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * A struct-of-arrays copy of the ids, locations, and versions of
+         * the nodes in one or more buffers. Loops over these arrays don't
+         * have to hop from item to item and can be vectorized by the
+         * compiler.
+         *
+         * Entry n in all arrays belongs to the node returned by node(n).
+         * The buffers must be kept around as long as node() is used.
+         */
+        class NodeColumns {
+
+            std::vector<osmium::object_id_type> m_ids{};
+            std::vector<int32_t> m_x{};
+            std::vector<int32_t> m_y{};
+            std::vector<osmium::object_version_type> m_versions{};
+            std::vector<const osmium::Node*> m_nodes{};
+
+        public:
+
+            NodeColumns() = default;
+
+            /// Create columns from all nodes in the buffer.
+            explicit NodeColumns(const osmium::memory::Buffer& buffer) {
+                append(buffer);
+            }
+
+            /// Add all nodes in the buffer. Other items are ignored.
+            void append(const osmium::memory::Buffer& buffer) {
+                for (const auto& node : buffer.select<osmium::Node>()) {
+                    m_ids.push_back(node.id());
+                    m_x.push_back(node.location().x());
+                    m_y.push_back(node.location().y());
+                    m_versions.push_back(node.version());
+                    m_nodes.push_back(&node);
+                }
+            }
+
+            /// Remove all entries.
+            void clear() noexcept {
+                m_ids.clear();
+                m_x.clear();
+                m_y.clear();
+                m_versions.clear();
+                m_nodes.clear();
+            }
+
+            /// The number of nodes.
+            std::size_t size() const noexcept {
+                return m_ids.size();
+            }
+
+            bool empty() const noexcept {
+                return m_ids.empty();
+            }
+
+            const std::vector<osmium::object_id_type>& ids() const noexcept {
+                return m_ids;
+            }
+
+            /// The x coordinates, undefined_coordinate for invalid locations.
+            const std::vector<int32_t>& x() const noexcept {
+                return m_x;
+            }
+
+            /// The y coordinates, undefined_coordinate for invalid locations.
+            const std::vector<int32_t>& y() const noexcept {
+                return m_y;
+            }
+
+            const std::vector<osmium::object_version_type>& versions() const noexcept {
+                return m_versions;
+            }
+
+            osmium::Location location(std::size_t n) const noexcept {
+                assert(n < size());
+                return osmium::Location{m_x[n], m_y[n]};
+            }
+
+            /// The node in the buffer for entry n.
+            const osmium::Node& node(std::size_t n) const noexcept {
+                assert(n < size());
+                return *m_nodes[n];
+            }
+
+            /**
+             * Mark the nodes inside the box (including its boundary). Nodes
+             * with invalid locations are never inside.
+             *
+             * @param box The box. Must be valid.
+             * @param mask Set to one entry for each node, 1 if the node is
+             *             inside, 0 otherwise.
+             * @returns The number of nodes inside.
+             */
+            std::size_t mask_in_box(const osmium::Box& box, std::vector<uint8_t>& mask) const {
+                assert(box.valid());
+                const int32_t min_x = box.bottom_left().x();
+                const int32_t min_y = box.bottom_left().y();
+                const int32_t max_x = box.top_right().x();
+                const int32_t max_y = box.top_right().y();
+                const std::size_t count = size();
+                mask.resize(count);
+                const int32_t* x = m_x.data();
+                const int32_t* y = m_y.data();
+                uint8_t* out = mask.data();
+                std::size_t num_inside = 0;
+                for (std::size_t n = 0; n < count; ++n) {
+                    const auto inside = static_cast<uint8_t>((x[n] >= min_x) & (x[n] <= max_x) & (y[n] >= min_y) & (y[n] <= max_y));
+                    out[n] = inside;
+                    num_inside += inside;
+                }
+                return num_inside;
+            }
+
+            /**
+             * Get the indexes of the nodes inside the box (including its
+             * boundary). Nodes with invalid locations are never inside.
+             *
+             * @param box The box. Must be valid.
+             * @returns Indexes into the columns in increasing order.
+             */
+            std::vector<std::size_t> in_box(const osmium::Box& box) const {
+                std::vector<uint8_t> mask;
+                std::vector<std::size_t> result;
+                result.reserve(mask_in_box(box, mask));
+                for (std::size_t n = 0; n < mask.size(); ++n) {
+                    if (mask[n]) {
+                        result.push_back(n);
+                    }
+                }
+                return result;
+            }
+
+        }; // class NodeColumns
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_NODE_COLUMNS_HPP
@@ -0,0 +1,439 @@
+#ifndef OSMIUM_MEMORY_SEGMENTED_BUFFER_HPP
+#define OSMIUM_MEMORY_SEGMENTED_BUFFER_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/memory/item_iterator.hpp>
+#include <osmium/osm/entity.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace memory {
+
+        /**
+         * Iterator over the items in all segments of a SegmentedBuffer.
+         * Only items of type TMember (or derived types) are returned.
+         */
+        template <typename TMember>
+        class SegmentedItemIterator {
+
+            const std::vector<Buffer>* m_segments = nullptr;
+            std::size_t m_segment = 0;
+            ItemIterator<TMember> m_it{};
+
+            static ItemIterator<TMember> segment_begin(const Buffer& buffer) noexcept {
+                return ItemIterator<TMember>{buffer.data(), buffer.data() + buffer.committed()};
+            }
+
+            // Move to the next segment with matching items if there are no
+            // more in the current one. At the end m_it is default
+            // constructed so all end iterators compare equal.
+            void skip_finished_segments() noexcept {
+                while (!m_it) {
+                    ++m_segment;
+                    if (m_segment >= m_segments->size()) {
+                        m_segment = m_segments->size();
+                        m_it = ItemIterator<TMember>{};
+                        return;
+                    }
+                    m_it = segment_begin((*m_segments)[m_segment]);
+                }
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = TMember;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = value_type*;
+            using reference         = value_type&;
+
+            SegmentedItemIterator() noexcept = default;
+
+            SegmentedItemIterator(const std::vector<Buffer>& segments, std::size_t segment) noexcept :
+                m_segments(&segments),
+                m_segment(segment) {
+                if (m_segment < segments.size()) {
+                    m_it = segment_begin(segments[m_segment]);
+                    skip_finished_segments();
+                }
+            }
+
+            SegmentedItemIterator<TMember>& operator++() noexcept {
+                assert(m_it);
+                ++m_it;
+                skip_finished_segments();
+                return *this;
+            }
+
+            SegmentedItemIterator<TMember> operator++(int) noexcept {
+                SegmentedItemIterator<TMember> tmp{*this};
+                operator++();
+                return tmp;
+            }
+
+            bool operator==(const SegmentedItemIterator<TMember>& rhs) const noexcept {
+                return m_segment == rhs.m_segment && m_it == rhs.m_it;
+            }
+
+            bool operator!=(const SegmentedItemIterator<TMember>& rhs) const noexcept {
+                return !(*this == rhs);
+            }
+
+            /// The number of the segment the current item is in.
+            std::size_t segment() const noexcept {
+                return m_segment;
+            }
+
+            TMember& operator*() const noexcept {
+                return *m_it;
+            }
+
+            TMember* operator->() const noexcept {
+                return m_it.operator->();
+            }
+
+            explicit operator bool() const noexcept {
+                return static_cast<bool>(m_it);
+            }
+
+        }; // class SegmentedItemIterator
+
+        /**
+         * A buffer for OSM objects and other items made up of several
+         * segments, each of them a Buffer. When a segment is full, a new
+         * one is started, existing data is never copied. Use this instead
+         * of a Buffer with auto_grow::yes if you collect lots of data.
+         *
+         * Items can be added with add_item(), push_back(), or add_buffer(),
+         * or written with the usual Builders into the Buffer returned by
+         * buffer(). That buffer uses auto_grow::internal: When it is full,
+         * only the unfinished item is copied to new memory.
+         *
+         * Iterators returned by begin(), end(), and select() cross segment
+         * boundaries. Adding items invalidates all iterators, pointers,
+         * and references into the SegmentedBuffer.
+         */
+        class SegmentedBuffer {
+
+            // The last segment is the one written to. Segments split off
+            // from it as nested buffers by the Builders are moved in here
+            // lazily, which doesn't change the contents, so this is mutable.
+            mutable std::vector<Buffer> m_segments{};
+            std::size_t m_segment_size;
+
+            void adopt_nested() const {
+                auto& current = m_segments.back();
+                if (!current.has_nested_buffers()) {
+                    return;
+                }
+                std::vector<Buffer> nested;
+                while (current.has_nested_buffers()) {
+                    const std::unique_ptr<Buffer> buffer{current.get_last_nested()};
+                    nested.push_back(std::move(*buffer));
+                }
+                m_segments.insert(m_segments.end() - 1,
+                                  std::make_move_iterator(nested.begin()),
+                                  std::make_move_iterator(nested.end()));
+            }
+
+            void start_segment(std::size_t min_size) {
+                m_segments.emplace_back(std::max(m_segment_size, min_size), Buffer::auto_grow::internal);
+            }
+
+        public:
+
+            enum : std::size_t {
+                default_segment_size = 1024UL * 1024UL
+            };
+
+            template <typename T>
+            using t_iterator = SegmentedItemIterator<T>;
+
+            template <typename T>
+            using t_const_iterator = SegmentedItemIterator<const T>;
+
+            using iterator = t_iterator<osmium::OSMEntity>;
+            using const_iterator = t_const_iterator<osmium::OSMEntity>;
+
+            /**
+             * Range of items of type T in a SegmentedBuffer as returned by
+             * select().
+             */
+            template <typename T>
+            class item_range {
+
+                SegmentedItemIterator<T> m_begin;
+                SegmentedItemIterator<T> m_end;
+
+            public:
+
+                explicit item_range(const std::vector<Buffer>& segments) noexcept :
+                    m_begin(segments, 0),
+                    m_end(segments, segments.size()) {
+                }
+
+                SegmentedItemIterator<T> begin() const noexcept {
+                    return m_begin;
+                }
+
+                SegmentedItemIterator<T> end() const noexcept {
+                    return m_end;
+                }
+
+                bool empty() const noexcept {
+                    return m_begin == m_end;
+                }
+
+            }; // class item_range
+
+            /**
+             * Create a SegmentedBuffer.
+             *
+             * @param segment_size The size of each segment. Items larger
+             *                     than this get a segment of their own.
+             */
+            explicit SegmentedBuffer(std::size_t segment_size = default_segment_size) :
+                m_segment_size(segment_size) {
+                start_segment(0);
+            }
+
+            /// The number of segments.
+            std::size_t num_segments() const {
+                adopt_nested();
+                return m_segments.size();
+            }
+
+            /// Access a segment. Use this to hand the data on segment by segment.
+            const Buffer& segment(std::size_t n) const {
+                adopt_nested();
+                assert(n < m_segments.size());
+                return m_segments[n];
+            }
+
+            /// The number of bytes committed in all segments.
+            std::size_t committed() const {
+                adopt_nested();
+                std::size_t sum = 0;
+                for (const auto& segment : m_segments) {
+                    sum += segment.committed();
+                }
+                return sum;
+            }
+
+            /// The number of bytes of memory in all segments.
+            std::size_t capacity() const {
+                adopt_nested();
+                std::size_t sum = 0;
+                for (const auto& segment : m_segments) {
+                    sum += segment.capacity();
+                }
+                return sum;
+            }
+
+            /**
+             * The buffer to write new items into, for instance with the
+             * Builders. Don't keep the reference around after adding items
+             * in other ways.
+             */
+            Buffer& buffer() {
+                adopt_nested();
+                return m_segments.back();
+            }
+
+            /**
+             * Add a copy of the item. If it doesn't fit into the current
+             * segment, a new one is started.
+             */
+            void add_item(const osmium::memory::Item& item) {
+                adopt_nested();
+                const auto& current = m_segments.back();
+                assert(current.written() == current.committed() && "Can not add item while another one is being built");
+                if (current.capacity() - current.committed() < item.padded_size()) {
+                    start_segment(item.padded_size());
+                }
+                auto& buffer = m_segments.back();
+                buffer.add_item(item);
+                buffer.commit();
+            }
+
+            /// Add a copy of the item.
+            void push_back(const osmium::memory::Item& item) {
+                add_item(item);
+            }
+
+            /**
+             * Add copies of all items in the buffer. The data is copied
+             * in one go if it fits into the current segment.
+             */
+            void add_buffer(const Buffer& buffer) {
+                adopt_nested();
+                auto& current = m_segments.back();
+                if (current.capacity() - current.committed() >= buffer.committed()) {
+                    current.add_buffer(buffer);
+                    current.commit();
+                    return;
+                }
+                for (const auto& item : buffer.select<osmium::memory::Item>()) {
+                    add_item(item);
+                }
+            }
+
+            /**
+             * Add the buffer as a new segment without copying its data.
+             * The buffer must not have any nested buffers.
+             */
+            void add_buffer(Buffer&& buffer) {
+                assert(buffer && !buffer.has_nested_buffers());
+                adopt_nested();
+                const auto& current = m_segments.back();
+                assert(current.written() == current.committed() && "Can not add buffer while an item is being built");
+                if (current.committed() == 0) {
+                    m_segments.back() = std::move(buffer);
+                    m_segments.back().set_auto_grow(Buffer::auto_grow::internal);
+                } else {
+                    m_segments.push_back(std::move(buffer));
+                    start_segment(0);
+                }
+            }
+
+            /**
+             * Remove all items and free all segments but one.
+             */
+            void clear() {
+                adopt_nested();
+                m_segments.erase(m_segments.begin(), m_segments.end() - 1);
+                m_segments.back().clear();
+            }
+
+            /**
+             * Move all segments out of this SegmentedBuffer. Afterwards
+             * it is empty.
+             */
+            std::vector<Buffer> release_segments() {
+                adopt_nested();
+                std::vector<Buffer> segments;
+                using std::swap;
+                swap(segments, m_segments);
+                start_segment(0);
+                return segments;
+            }
+
+            template <typename T>
+            item_range<T> select() {
+                adopt_nested();
+                return item_range<T>{m_segments};
+            }
+
+            template <typename T>
+            item_range<const T> select() const {
+                adopt_nested();
+                return item_range<const T>{m_segments};
+            }
+
+            template <typename T>
+            t_iterator<T> begin() {
+                adopt_nested();
+                return t_iterator<T>{m_segments, 0};
+            }
+
+            iterator begin() {
+                return begin<osmium::OSMEntity>();
+            }
+
+            template <typename T>
+            t_iterator<T> end() {
+                adopt_nested();
+                return t_iterator<T>{m_segments, m_segments.size()};
+            }
+
+            iterator end() {
+                return end<osmium::OSMEntity>();
+            }
+
+            template <typename T>
+            t_const_iterator<T> cbegin() const {
+                adopt_nested();
+                return t_const_iterator<T>{m_segments, 0};
+            }
+
+            const_iterator cbegin() const {
+                return cbegin<osmium::OSMEntity>();
+            }
+
+            template <typename T>
+            t_const_iterator<T> cend() const {
+                adopt_nested();
+                return t_const_iterator<T>{m_segments, m_segments.size()};
+            }
+
+            const_iterator cend() const {
+                return cend<osmium::OSMEntity>();
+            }
+
+            template <typename T>
+            t_const_iterator<T> begin() const {
+                return cbegin<T>();
+            }
+
+            const_iterator begin() const {
+                return cbegin();
+            }
+
+            template <typename T>
+            t_const_iterator<T> end() const {
+                return cend<T>();
+            }
+
+            const_iterator end() const {
+                return cend();
+            }
+
+        }; // class SegmentedBuffer
+
+    } // namespace memory
+
+} // namespace osmium
+
+#endif // OSMIUM_MEMORY_SEGMENTED_BUFFER_HPP
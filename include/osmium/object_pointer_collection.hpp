@@ -34,11 +34,17 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/handler.hpp>
+#include <osmium/index/detail/parallel_sort.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/osm/object_comparisons.hpp>
 
 #include <boost/iterator/indirect_iterator.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -46,6 +52,71 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Packed sort key for an OSM object. The high word contains the
+         * type, the sign of the id and the absolute id, the low word the
+         * version and timestamp.
+         */
+        struct object_sort_key {
+            uint64_t high;
+            uint64_t low;
+            osmium::OSMObject* object;
+        };
+
+        enum : uint64_t {
+            // Ids must be smaller than this to fit into the key.
+            max_sort_key_id = 1ULL << 55U
+        };
+
+        inline uint64_t object_sort_key_high(const osmium::OSMObject& object) noexcept {
+            return (static_cast<uint64_t>(object.type()) << 56U) |
+                   (static_cast<uint64_t>(object.id() > 0) << 55U) |
+                   object.positive_id();
+        }
+
+        inline uint64_t object_sort_key_low(const osmium::OSMObject& object) noexcept {
+            return (static_cast<uint64_t>(object.version()) << 32U) |
+                   object.timestamp().seconds_since_epoch();
+        }
+
+        /**
+         * For the comparison functors from object_comparisons.hpp this
+         * defines how to create the low word of the sort key. Sorting with
+         * other functors uses std::sort.
+         */
+        template <typename TCompare>
+        struct object_sort_key_traits {
+            static constexpr bool available = false;
+        };
+
+        template <>
+        struct object_sort_key_traits<osmium::object_order_type_id_version> {
+            static constexpr bool available = true;
+            static uint64_t low(const osmium::OSMObject& object) noexcept {
+                return object_sort_key_low(object);
+            }
+        };
+
+        template <>
+        struct object_sort_key_traits<osmium::object_order_type_id_version_without_timestamp> {
+            static constexpr bool available = true;
+            static uint64_t low(const osmium::OSMObject& object) noexcept {
+                return static_cast<uint64_t>(object.version());
+            }
+        };
+
+        template <>
+        struct object_sort_key_traits<osmium::object_order_type_id_reverse_version> {
+            static constexpr bool available = true;
+            static uint64_t low(const osmium::OSMObject& object) noexcept {
+                return ~object_sort_key_low(object);
+            }
+        };
+
+    } // namespace detail
+
     /**
      * A collection of pointers to OSM objects. The pointers can be easily
      * and quickly sorted or otherwise manipulated, while the objects
@@ -69,6 +140,63 @@ namespace osmium {
 
         std::vector<osmium::OSMObject*> m_objects{};
 
+        template <typename TCompare>
+        void sort_impl(TCompare&& compare, std::false_type /*has_sort_key*/) {
+            std::sort(m_objects.begin(), m_objects.end(), std::forward<TCompare>(compare));
+        }
+
+        // Extract the sort keys in parallel, radix sort them (also in
+        // parallel for large collections) and copy back the pointers.
+        // This avoids following the pointers into the buffers for every
+        // comparison.
+        template <typename TCompare>
+        void sort_impl(TCompare&& compare, std::true_type /*has_sort_key*/) {
+            using key_traits = detail::object_sort_key_traits<typename std::decay<TCompare>::type>;
+
+            const std::size_t size = m_objects.size();
+            if (size < osmium::index::detail::radix_sort_min_size) {
+                sort_impl(std::forward<TCompare>(compare), std::false_type{});
+                return;
+            }
+
+            std::vector<detail::object_sort_key> keys(size);
+            std::atomic<bool> ids_fit{true};
+            const int num_threads = osmium::index::detail::parallel_work_threads(size);
+            osmium::index::detail::run_in_threads(num_threads, [&](const int n) {
+                const std::size_t begin = size * static_cast<std::size_t>(n) / static_cast<std::size_t>(num_threads);
+                const std::size_t end = size * static_cast<std::size_t>(n + 1) / static_cast<std::size_t>(num_threads);
+                for (std::size_t i = begin; i < end; ++i) {
+                    auto* object = m_objects[i];
+                    if (object->positive_id() >= detail::max_sort_key_id) {
+                        ids_fit = false;
+                    }
+                    keys[i] = detail::object_sort_key{detail::object_sort_key_high(*object), key_traits::low(*object), object};
+                }
+            });
+
+            if (!ids_fit) {
+                sort_impl(std::forward<TCompare>(compare), std::false_type{});
+                return;
+            }
+
+            // LSD radix sort is stable, so sorting by the low word first
+            // and then by the high word sorts by both.
+            osmium::index::detail::radix_sort(keys, [](const detail::object_sort_key& key) noexcept {
+                return key.low;
+            });
+            osmium::index::detail::radix_sort(keys, [](const detail::object_sort_key& key) noexcept {
+                return key.high;
+            });
+
+            osmium::index::detail::run_in_threads(num_threads, [&](const int n) {
+                const std::size_t begin = size * static_cast<std::size_t>(n) / static_cast<std::size_t>(num_threads);
+                const std::size_t end = size * static_cast<std::size_t>(n + 1) / static_cast<std::size_t>(num_threads);
+                for (std::size_t i = begin; i < end; ++i) {
+                    m_objects[i] = keys[i].object;
+                }
+            });
+        }
+
     public:
 
         using iterator       = boost::indirect_iterator<std::vector<osmium::OSMObject*>::iterator, osmium::OSMObject>;
@@ -85,10 +213,20 @@ namespace osmium {
 
         /**
          * Sort objects according to the specified order functor.
+         *
+         * For the functors object_order_type_id_version,
+         * object_order_type_id_version_without_timestamp, and
+         * object_order_type_id_reverse_version large collections are
+         * sorted by packed keys with a radix sort using several threads
+         * (see OSMIUM_POOL_THREADS). The order of objects that are the
+         * same in type, id, and version, but where only one has a valid
+         * timestamp, might be different from std::sort then. All other
+         * functors use std::sort.
          */
         template <typename TCompare>
         void sort(TCompare&& compare) {
-            std::sort(m_objects.begin(), m_objects.end(), std::forward<TCompare>(compare));
+            using has_sort_key = std::integral_constant<bool, detail::object_sort_key_traits<typename std::decay<TCompare>::type>::available>;
+            sort_impl(std::forward<TCompare>(compare), has_sort_key{});
         }
 
         /**
@@ -42,6 +42,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/timestamp.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/types_from_string.hpp>
+#include <osmium/util/string_view.hpp>
 
 #include <cstdint>
 #include <cstring>
@@ -127,6 +128,16 @@ namespace osmium {
             return reinterpret_cast<const char*>(data() + sizeof(ChangesetComment) + m_user_size);
         }
 
+        /// Get user name including its length.
+        osmium::string_view user_view() const noexcept {
+            return osmium::detail::stored_string_view(user(), m_user_size);
+        }
+
+        /// Get comment text including its length.
+        osmium::string_view text_view() const noexcept {
+            return osmium::detail::stored_string_view(text(), m_text_size);
+        }
+
     }; // class ChangesetComment
 
     class ChangesetDiscussion : public osmium::memory::Collection<ChangesetComment, osmium::item_type::changeset_discussion> {
@@ -366,6 +377,14 @@ namespace osmium {
             return reinterpret_cast<const char*>(data() + sizeof(Changeset));
         }
 
+        /**
+         * Get user name including its length. Unlike with user() the
+         * length doesn't have to be found with strlen().
+         */
+        osmium::string_view user_view() const noexcept {
+            return osmium::detail::stored_string_view(user(), m_user_size);
+        }
+
         /// Clear user name.
         void clear_user() noexcept {
             std::memset(data() + sizeof(Changeset), 0, user_size());
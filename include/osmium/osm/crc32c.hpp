@@ -0,0 +1,195 @@
+#ifndef OSMIUM_OSM_CRC32C_HPP
+#define OSMIUM_OSM_CRC32C_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/util/endian.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE4_2__)
+# include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+# include <arm_acle.h>
+#endif
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Lookup tables for the software implementation of CRC32C
+         * (Castagnoli polynomial) processing eight bytes at a time.
+         */
+        struct crc32c_tables {
+
+            uint32_t table[8][256];
+
+            crc32c_tables() noexcept {
+                for (uint32_t n = 0; n < 256; ++n) {
+                    uint32_t crc = n;
+                    for (int k = 0; k < 8; ++k) {
+                        crc = (crc & 1U) ? (crc >> 1U) ^ 0x82f63b78U : crc >> 1U;
+                    }
+                    table[0][n] = crc;
+                }
+                for (uint32_t n = 0; n < 256; ++n) {
+                    for (int k = 1; k < 8; ++k) {
+                        table[k][n] = (table[k - 1][n] >> 8U) ^ table[0][table[k - 1][n] & 0xffU];
+                    }
+                }
+            }
+
+            static const crc32c_tables& instance() noexcept {
+                static const crc32c_tables tables;
+                return tables;
+            }
+
+        }; // struct crc32c_tables
+
+        inline uint32_t crc32c_software(uint32_t crc, const unsigned char* data, std::size_t size) noexcept {
+            const auto& t = crc32c_tables::instance().table;
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            for (; size >= 8; size -= 8, data += 8) {
+                uint64_t value;
+                std::memcpy(&value, data, sizeof(value));
+                value ^= crc;
+                crc = t[7][value & 0xffU] ^
+                      t[6][(value >> 8U) & 0xffU] ^
+                      t[5][(value >> 16U) & 0xffU] ^
+                      t[4][(value >> 24U) & 0xffU] ^
+                      t[3][(value >> 32U) & 0xffU] ^
+                      t[2][(value >> 40U) & 0xffU] ^
+                      t[1][(value >> 48U) & 0xffU] ^
+                      t[0][value >> 56U];
+            }
+#endif
+            for (; size > 0; --size, ++data) {
+                crc = (crc >> 8U) ^ t[0][(crc ^ *data) & 0xffU];
+            }
+            return crc;
+        }
+
+        inline uint32_t crc32c_update(uint32_t crc, const unsigned char* data, std::size_t size) noexcept {
+#if defined(__SSE4_2__)
+# if defined(__x86_64__) || defined(_M_X64)
+            uint64_t crc64 = crc;
+            for (; size >= 8; size -= 8, data += 8) {
+                uint64_t value;
+                std::memcpy(&value, data, sizeof(value));
+                crc64 = _mm_crc32_u64(crc64, value);
+            }
+            crc = static_cast<uint32_t>(crc64);
+# endif
+            for (; size >= 4; size -= 4, data += 4) {
+                uint32_t value;
+                std::memcpy(&value, data, sizeof(value));
+                crc = _mm_crc32_u32(crc, value);
+            }
+            for (; size > 0; --size, ++data) {
+                crc = _mm_crc32_u8(crc, *data);
+            }
+            return crc;
+#elif defined(__ARM_FEATURE_CRC32)
+            for (; size >= 8; size -= 8, data += 8) {
+                uint64_t value;
+                std::memcpy(&value, data, sizeof(value));
+                crc = __crc32cd(crc, value);
+            }
+            for (; size > 0; --size, ++data) {
+                crc = __crc32cb(crc, *data);
+            }
+            return crc;
+#else
+            return crc32c_software(crc, data, size);
+#endif
+        }
+
+    } // namespace detail
+
+    /**
+     * This class is used together with the CRC class to implement a CRC32C
+     * checksum (using the Castagnoli polynomial as in iSCSI, ext4, and
+     * many other places). Note that this is a different checksum than the
+     * CRC32 calculated by CRC_zlib.
+     *
+     * If the code is compiled with SSE 4.2 enabled on x86 (for instance
+     * with -msse4.2 or -march=native) or with the CRC extension on ARMv8
+     * (-march=armv8-a+crc), the CRC instructions of the CPU are used.
+     * Otherwise a table-driven software implementation is used which
+     * gives the same results.
+     *
+     * Usage:
+     *
+     * @code
+     * osmium::CRC<osmium::CRC32C> crc32c;
+     * const osmium::Node& node = ...;
+     * crc32c.update(node);
+     * std::cout << crc32c().checksum() << '\n';
+     * @endcode
+     */
+    class CRC32C {
+
+        uint32_t m_crc = 0xffffffffU;
+
+    public:
+
+        /// Does this use the CRC instructions of the CPU?
+        static constexpr bool hardware_accelerated() noexcept {
+#if defined(__SSE4_2__) || defined(__ARM_FEATURE_CRC32)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        void process_byte(const unsigned char byte) noexcept {
+            m_crc = detail::crc32c_update(m_crc, &byte, 1);
+        }
+
+        void process_bytes(const void* buffer, std::size_t byte_count) noexcept {
+            m_crc = detail::crc32c_update(m_crc, static_cast<const unsigned char*>(buffer), byte_count);
+        }
+
+        uint32_t checksum() const noexcept {
+            return m_crc ^ 0xffffffffU;
+        }
+
+    }; // class CRC32C
+
+} // namespace osmium
+
+#endif // OSMIUM_OSM_CRC32C_HPP
@@ -33,8 +33,12 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/util/endian.hpp>
+#include <osmium/util/number_format.hpp>
+
 #include <algorithm>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <functional>
@@ -68,9 +72,81 @@ namespace osmium {
             coordinate_precision = 10000000
         };
 
+        inline bool is_coordinate_digit(char c) noexcept {
+            return c >= '0' && c <= '9';
+        }
+
+        // Fast path for string_to_location_coordinate() handling the common
+        // case of one to three digits before and exactly seven digits after
+        // the decimal point ("[-]ddd.ddddddd"), the way coordinates are
+        // written by Osmium and most other software. Returns false for
+        // anything else, the general parser has to handle that then.
+        inline bool string_to_location_coordinate_fixed(const char** data, int32_t* value) noexcept {
+            const char* str = *data;
+
+            const bool negative = (*str == '-');
+            if (negative) {
+                ++str;
+            }
+
+            if (!is_coordinate_digit(*str)) {
+                return false;
+            }
+            int64_t result = *str++ - '0';
+            if (is_coordinate_digit(*str)) {
+                result = result * 10 + (*str++ - '0');
+                if (is_coordinate_digit(*str)) {
+                    result = result * 10 + (*str++ - '0');
+                }
+            }
+
+            // The digits are checked one after the other, so we never
+            // read beyond the end of the string.
+            const char* frac = str + 1;
+            if (*str != '.' ||
+                !is_coordinate_digit(frac[0]) || !is_coordinate_digit(frac[1]) ||
+                !is_coordinate_digit(frac[2]) || !is_coordinate_digit(frac[3]) ||
+                !is_coordinate_digit(frac[4]) || !is_coordinate_digit(frac[5]) ||
+                !is_coordinate_digit(frac[6]) ||
+                is_coordinate_digit(frac[7]) || frac[7] == 'e' || frac[7] == 'E') {
+                return false;
+            }
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+            // Convert the decimal point (as a '0') and the seven digits
+            // in one go: combine neighbouring digits to 2-digit numbers,
+            // those to 4-digit numbers and those to the final number.
+            uint64_t digits;
+            std::memcpy(&digits, str, sizeof(digits));
+            digits = (digits & ~uint64_t{0xffU}) | uint64_t{'0'};
+            digits -= 0x3030303030303030ULL;
+            digits = digits * 10 + (digits >> 8U);
+            digits = (((digits & 0x000000ff000000ffULL) * (100 + (1000000ULL << 32U))) +
+                      (((digits >> 16U) & 0x000000ff000000ffULL) * (1 + (10000ULL << 32U)))) >> 32U;
+            result = result * coordinate_precision + static_cast<int64_t>(digits);
+#else
+            for (int i = 0; i < 7; ++i) {
+                result = result * 10 + (frac[i] - '0');
+            }
+#endif
+
+            if (result > std::numeric_limits<int32_t>::max()) {
+                return false;
+            }
+
+            *data = frac + 7;
+            *value = static_cast<int32_t>(negative ? -result : result);
+            return true;
+        }
+
         // Convert string with a floating point number into integer suitable
         // for use as coordinate in a Location.
         inline int32_t string_to_location_coordinate(const char** data) {
+            int32_t value = 0;
+            if (string_to_location_coordinate_fixed(data, &value)) {
+                return value;
+            }
+
             const char* str = *data;
             const char* full = str;
 
@@ -209,44 +285,28 @@ namespace osmium {
                 value = -value;
             }
 
-            // write digits into temporary buffer
-            int32_t v = value;
+            // write digits before decimal point
+            const auto uvalue = static_cast<uint32_t>(value);
             char temp[10];
-            char* t = temp;
-            do {
-                *t++ = char(v % 10) + '0';
-                v /= 10;
-            } while (v != 0);
-
-            while (t - temp < 7) {
-                *t++ = '0';
-            }
-
-            // write out digits before decimal point
-            if (value >= coordinate_precision) {
-                if (value >= 10 * coordinate_precision) {
-                    if (value >= 100 * coordinate_precision) {
-                        *iterator++ = *--t;
-                    }
-                    *iterator++ = *--t;
+            char* const end = temp + sizeof(temp);
+            const char* t = format_uint_backwards(uvalue / coordinate_precision, end);
+            iterator = std::copy(t, static_cast<const char*>(end), iterator);
+
+            // write digits after decimal point without trailing zeros
+            uint32_t fraction = uvalue % coordinate_precision;
+            if (fraction != 0) {
+                std::ptrdiff_t num_digits = 7;
+                while (fraction % 10 == 0) {
+                    fraction /= 10;
+                    --num_digits;
                 }
-                *iterator++ = *--t;
-            } else {
-                *iterator++ = '0';
-            }
-
-            // remove trailing zeros
-            const char* tn = temp;
-            while (tn < t && *tn == '0') {
-                ++tn;
-            }
-
-            // decimal point
-            if (t != tn) {
-                *iterator++ = '.';
-                while (t != tn) {
-                    *iterator++ = *--t;
+                char* const fraction_end = temp + num_digits;
+                char* f = format_uint_backwards(fraction, fraction_end);
+                while (f != temp) {
+                    *--f = '0';
                 }
+                *iterator++ = '.';
+                iterator = std::copy(static_cast<const char*>(temp), static_cast<const char*>(fraction_end), iterator);
             }
 
             return iterator;
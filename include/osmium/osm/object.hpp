@@ -44,6 +44,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/osm/types_from_string.hpp>
 #include <osmium/util/misc.hpp>
+#include <osmium/util/string_view.hpp>
 
 #include <cstdlib>
 #include <cstring>
@@ -318,6 +319,14 @@ namespace osmium {
             return reinterpret_cast<const char*>(data() + sizeof_object());
         }
 
+        /**
+         * Get user name for this object including its length. Unlike
+         * with user() the length doesn't have to be found with strlen().
+         */
+        osmium::string_view user_view() const noexcept {
+            return osmium::detail::stored_string_view(user(), user_size());
+        }
+
         /// Clear user name.
         void clear_user() noexcept {
             std::memset(data() + sizeof_object(), 0, user_size());
@@ -40,6 +40,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/util/compatibility.hpp>
+#include <osmium/util/string_view.hpp>
 
 #include <cstdint>
 #include <cstdlib>
@@ -141,6 +142,14 @@ namespace osmium {
             return reinterpret_cast<const char*>(data() + sizeof(RelationMember));
         }
 
+        /**
+         * Get role including its length. Unlike with role() the length
+         * doesn't have to be found with strlen().
+         */
+        osmium::string_view role_view() const noexcept {
+            return osmium::detail::stored_string_view(role(), m_role_size);
+        }
+
         OSMObject& get_object() {
             return *reinterpret_cast<OSMObject*>(endpos());
         }
@@ -35,6 +35,7 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/util/compatibility.hpp>
 #include <osmium/util/minmax.hpp> // IWYU pragma: keep
+#include <osmium/util/number_format.hpp>
 
 #include <cassert>
 #include <cstdint>
@@ -79,6 +80,47 @@ namespace osmium {
             out += static_cast<char>('0' + value);
         }
 
+        /**
+         * Number of days since 1970-01-01 of the given date in the
+         * proleptic Gregorian calendar. The day can be one past the end
+         * of the month, it is then counted into the next month. (Algorithm
+         * from http://howardhinnant.github.io/date_algorithms.html)
+         */
+        inline int64_t days_from_civil(int64_t year, unsigned month, unsigned day) noexcept {
+            assert(month >= 1 && month <= 12);
+            year -= month <= 2 ? 1 : 0;
+            const int64_t era = (year >= 0 ? year : year - 399) / 400;
+            const auto yoe = static_cast<unsigned>(year - era * 400);
+            const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+            const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+            return era * 146097 + static_cast<int64_t>(doe) - 719468;
+        }
+
+        /**
+         * Inverse of days_from_civil() for days >= 0.
+         */
+        inline void civil_from_days(uint32_t days, unsigned* year, unsigned* month, unsigned* day) noexcept {
+            const uint32_t z = days + 719468;
+            const uint32_t era = z / 146097;
+            const uint32_t doe = z - era * 146097;
+            const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+            const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+            const uint32_t mp = (5 * doy + 2) / 153;
+            *day = doy - (153 * mp + 2) / 5 + 1;
+            *month = mp < 10 ? mp + 3 : mp - 9;
+            *year = yoe + era * 400 + (*month <= 2 ? 1 : 0);
+        }
+
+        /**
+         * Copy the two digits of a number between 0 and 99 to out.
+         */
+        inline char* copy_2digits(unsigned value, char* out) noexcept {
+            const char* digits = two_digits(value);
+            *out++ = digits[0];
+            *out++ = digits[1];
+            return out;
+        }
+
         inline time_t parse_timestamp(const char* str) {
             static const int mon_lengths[] = {
                 31, 29, 31, 30, 31, 30,
@@ -104,30 +146,25 @@ namespace osmium {
                 str[17] >= '0' && str[17] <= '9' &&
                 str[18] >= '0' && str[18] <= '9' &&
                 str[19] == 'Z') {
-                std::tm tm; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
-                tm.tm_year = (str[ 0] - '0') * 1000 +
-                             (str[ 1] - '0') *  100 +
-                             (str[ 2] - '0') *   10 +
-                             (str[ 3] - '0')        - 1900;
-                tm.tm_mon  = (str[ 5] - '0') * 10 + (str[ 6] - '0') - 1;
-                tm.tm_mday = (str[ 8] - '0') * 10 + (str[ 9] - '0');
-                tm.tm_hour = (str[11] - '0') * 10 + (str[12] - '0');
-                tm.tm_min  = (str[14] - '0') * 10 + (str[15] - '0');
-                tm.tm_sec  = (str[17] - '0') * 10 + (str[18] - '0');
-                tm.tm_wday = 0;
-                tm.tm_yday = 0;
-                tm.tm_isdst = 0;
-                if (tm.tm_year >= 0 &&
-                    tm.tm_mon  >= 0 && tm.tm_mon  <= 11 &&
-                    tm.tm_mday >= 1 && tm.tm_mday <= mon_lengths[tm.tm_mon] &&
-                    tm.tm_hour >= 0 && tm.tm_hour <= 23 &&
-                    tm.tm_min  >= 0 && tm.tm_min  <= 59 &&
-                    tm.tm_sec  >= 0 && tm.tm_sec  <= 60) {
-#ifndef _WIN32
-                    return timegm(&tm);
-#else
-                    return _mkgmtime(&tm);
-#endif
+                const int year  = (str[ 0] - '0') * 1000 +
+                                  (str[ 1] - '0') *  100 +
+                                  (str[ 2] - '0') *   10 +
+                                  (str[ 3] - '0');
+                const int month = (str[ 5] - '0') * 10 + (str[ 6] - '0');
+                const int day   = (str[ 8] - '0') * 10 + (str[ 9] - '0');
+                const int hour  = (str[11] - '0') * 10 + (str[12] - '0');
+                const int min   = (str[14] - '0') * 10 + (str[15] - '0');
+                const int sec   = (str[17] - '0') * 10 + (str[18] - '0');
+                if (year  >= 1900 &&
+                    month >= 1 && month <= 12 &&
+                    day   >= 1 && day   <= mon_lengths[month - 1] &&
+                    hour  <= 23 &&
+                    min   <= 59 &&
+                    sec   <= 60) {
+                    // Like timegm(), a February 29th in a non-leap year
+                    // is treated as March 1st.
+                    const int64_t days = days_from_civil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+                    return static_cast<time_t>(days * 86400 + hour * 3600 + min * 60 + sec);
                 }
             }
             throw std::invalid_argument{"can not parse timestamp"};
@@ -147,31 +184,8 @@ namespace osmium {
         uint32_t m_timestamp = 0;
 
         void to_iso_str(std::string& s) const {
-            std::tm tm; // NOLINT(cppcoreguidelines-pro-type-member-init,hicpp-member-init)
-            time_t sse = seconds_since_epoch();
-#ifndef NDEBUG
-            auto result =
-#endif
-#ifndef _WIN32
-            gmtime_r(&sse, &tm);
-            assert(result != nullptr);
-#else
-            gmtime_s(&tm, &sse);
-            assert(result == 0);
-#endif
-
-            detail::add_4digit_int_to_string(tm.tm_year + 1900, s);
-            s += '-';
-            detail::add_2digit_int_to_string(tm.tm_mon + 1, s);
-            s += '-';
-            detail::add_2digit_int_to_string(tm.tm_mday, s);
-            s += 'T';
-            detail::add_2digit_int_to_string(tm.tm_hour, s);
-            s += ':';
-            detail::add_2digit_int_to_string(tm.tm_min, s);
-            s += ':';
-            detail::add_2digit_int_to_string(tm.tm_sec, s);
-            s += 'Z';
+            char buffer[20];
+            s.append(buffer, to_iso(buffer));
         }
 
     public:
@@ -277,6 +291,38 @@ namespace osmium {
             return s;
         }
 
+        /**
+         * Write the timestamp in ISO date/time ("yyyy-mm-ddThh:mm:ssZ")
+         * format into the buffer which must have space for at least 20
+         * characters. No terminating null character is added. If the
+         * timestamp is invalid, "1970-01-01T00:00:00Z" is written.
+         *
+         * @returns Pointer one past the last character written.
+         */
+        char* to_iso(char* out) const noexcept {
+            uint32_t secs = m_timestamp % 86400;
+            unsigned year = 0;
+            unsigned month = 0;
+            unsigned day = 0;
+            detail::civil_from_days(m_timestamp / 86400, &year, &month, &day);
+
+            out = detail::copy_2digits(year / 100, out);
+            out = detail::copy_2digits(year % 100, out);
+            *out++ = '-';
+            out = detail::copy_2digits(month, out);
+            *out++ = '-';
+            out = detail::copy_2digits(day, out);
+            *out++ = 'T';
+            out = detail::copy_2digits(secs / 3600, out);
+            secs %= 3600;
+            *out++ = ':';
+            out = detail::copy_2digits(secs / 60, out);
+            *out++ = ':';
+            out = detail::copy_2digits(secs % 60, out);
+            *out++ = 'Z';
+            return out;
+        }
+
         /**
          * Return the timestamp as string in ISO date/time
          * ("yyyy-mm-ddThh:mm:ssZ") format. If the timestamp is invalid, the
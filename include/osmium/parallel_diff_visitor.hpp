@@ -0,0 +1,166 @@
+#ifndef OSMIUM_PARALLEL_DIFF_VISITOR_HPP
+#define OSMIUM_PARALLEL_DIFF_VISITOR_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/diff_visitor.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        enum {
+            diff_objects_per_chunk = 10000
+        };
+
+        using diff_chunk_iterator = osmium::memory::Buffer::t_const_iterator<osmium::OSMObject>;
+
+        /**
+         * Split the objects in the buffer into chunks of at least
+         * objects_per_chunk objects (except for the last one). A chunk
+         * never ends between two versions of the same object, so the
+         * DiffObjects seen in each chunk are the same as those seen when
+         * iterating over the whole buffer. Returns the boundaries of the
+         * chunks including the begin and end of the buffer.
+         */
+        inline std::vector<diff_chunk_iterator> diff_chunk_boundaries(const osmium::memory::Buffer& buffer, std::size_t objects_per_chunk) {
+            std::vector<diff_chunk_iterator> boundaries;
+
+            auto it = buffer.cbegin<osmium::OSMObject>();
+            const auto end = buffer.cend<osmium::OSMObject>();
+            boundaries.push_back(it);
+
+            if (it == end) {
+                boundaries.push_back(end);
+                return boundaries;
+            }
+
+            std::size_t count = 1;
+            auto prev = it;
+            for (++it; it != end; prev = it, ++it) {
+                if (count >= objects_per_chunk && (prev->type() != it->type() || prev->id() != it->id())) {
+                    boundaries.push_back(it);
+                    count = 0;
+                }
+                ++count;
+            }
+
+            boundaries.push_back(end);
+            return boundaries;
+        }
+
+    } // namespace detail
+
+    /**
+     * Apply a diff handler to all objects in a buffer using the threads
+     * in the pool. This is the parallel version of osmium::apply_diff()
+     * for history data.
+     *
+     * The objects in the buffer are split into chunks of roughly
+     * objects_per_chunk objects in the calling thread. Chunks only end
+     * where the next object has a different type or id than the previous
+     * one, so all versions of an object are always in the same chunk and
+     * the handlers get exactly the same DiffObjects as with apply_diff().
+     * Each chunk is handled by its own copy of the handler in a separate
+     * task. At the end the copies are combined with the merge function
+     * in the order of the chunks in the buffer.
+     *
+     * The buffer must contain the complete history of each object
+     * sorted in the usual order (type, id, version), like a history file
+     * or the result of osmium::ObjectPointerCollection sorting.
+     *
+     * @param buffer Buffer with the objects. Items other than OSM objects
+     *               are ignored.
+     * @param handler Diff handler which is copied for each chunk. It is
+     *                not changed itself.
+     * @param merge Function called as merge(THandler& result,
+     *              THandler&& other) in the calling thread to add the
+     *              results of other to result.
+     * @param pool Thread pool to use.
+     * @param objects_per_chunk Minimum number of objects in each chunk.
+     * @returns The merged handler.
+     * @throws Any exception thrown by the handlers or the merge function.
+     *         All tasks are finished before that.
+     */
+    template <typename THandler, typename TMerge>
+    THandler apply_diff_parallel(const osmium::memory::Buffer& buffer,
+                                 const THandler& handler,
+                                 TMerge&& merge,
+                                 osmium::thread::Pool& pool = osmium::thread::Pool::default_instance(),
+                                 std::size_t objects_per_chunk = detail::diff_objects_per_chunk) {
+        const auto boundaries = detail::diff_chunk_boundaries(buffer, objects_per_chunk);
+        const std::size_t num_chunks = boundaries.size() - 1;
+
+        if (num_chunks == 1) {
+            THandler result{handler};
+            osmium::apply_diff(boundaries[0], boundaries[1], result);
+            return result;
+        }
+
+        std::vector<THandler> handlers(num_chunks, handler);
+        std::vector<std::future<void>> futures;
+        futures.reserve(num_chunks);
+        for (std::size_t n = 0; n < num_chunks; ++n) {
+            THandler* chunk_handler = &handlers[n];
+            const auto begin = boundaries[n];
+            const auto end = boundaries[n + 1];
+            futures.push_back(pool.submit([chunk_handler, begin, end]() {
+                osmium::apply_diff(begin, end, *chunk_handler);
+            }));
+        }
+        for (auto& future : futures) {
+            future.wait();
+        }
+        for (auto& future : futures) {
+            future.get();
+        }
+
+        THandler result{std::move(handlers.front())};
+        for (std::size_t n = 1; n < num_chunks; ++n) {
+            merge(result, std::move(handlers[n]));
+        }
+        return result;
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_PARALLEL_DIFF_VISITOR_HPP
@@ -0,0 +1,326 @@
+#ifndef OSMIUM_PARALLEL_VISITOR_HPP
+#define OSMIUM_PARALLEL_VISITOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/util.hpp>
+#include <osmium/util/config.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <future>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * In which order the results of the workers in apply_parallel() are
+     * merged.
+     */
+    enum class apply_order {
+
+        /**
+         * Each worker thread has its own copy of the handler which sees
+         * an arbitrary subset of the buffers. The worker handlers are
+         * merged at the end.
+         */
+        unordered = 0,
+
+        /**
+         * Each buffer is handled by a fresh copy of the handler and the
+         * handlers are merged in the order of the buffers in the input.
+         * This is more expensive than the unordered mode but the merge
+         * function sees the data in the same order as osmium::apply().
+         */
+        ordered = 1
+
+    }; // enum class apply_order
+
+    /**
+     * Options for apply_parallel().
+     */
+    struct apply_parallel_options {
+
+        /**
+         * Number of worker threads. The default (0) uses the same number
+         * as the default thread pool, negative numbers are subtracted from
+         * the number of cores.
+         */
+        int num_threads = 0;
+
+        /// Merge order of the results.
+        apply_order order = apply_order::unordered;
+
+        /**
+         * Maximum number of buffers waiting for a worker. The default (0)
+         * is twice the number of worker threads.
+         */
+        std::size_t max_queue_size = 0;
+
+    }; // struct apply_parallel_options
+
+    namespace detail {
+
+        template <typename THandler>
+        inline void apply_buffer_without_flush(const osmium::memory::Buffer& buffer, THandler& handler) {
+            for (auto it = buffer.cbegin(); it != buffer.cend(); ++it) {
+                osmium::apply_item(*it, handler);
+            }
+        }
+
+        class apply_workers {
+
+            std::vector<std::thread> m_threads;
+
+        public:
+
+            apply_workers() = default;
+
+            apply_workers(const apply_workers&) = delete;
+            apply_workers& operator=(const apply_workers&) = delete;
+
+            apply_workers(apply_workers&&) = delete;
+            apply_workers& operator=(apply_workers&&) = delete;
+
+            ~apply_workers() noexcept {
+                join();
+            }
+
+            template <typename TFunction>
+            void start(TFunction&& func) {
+                m_threads.emplace_back(std::forward<TFunction>(func));
+            }
+
+            void join() noexcept {
+                for (auto& thread : m_threads) {
+                    if (thread.joinable()) {
+                        thread.join();
+                    }
+                }
+            }
+
+        }; // class apply_workers
+
+        template <typename TSource, typename THandler, typename TMerge>
+        THandler apply_parallel_unordered(TSource& source, const THandler& handler, TMerge& merge, int num_threads, std::size_t max_queue_size) {
+            osmium::thread::Queue<osmium::memory::Buffer> queue{max_queue_size, "apply_parallel"};
+            std::vector<THandler> handlers(static_cast<std::size_t>(num_threads), handler);
+            std::vector<std::exception_ptr> errors(static_cast<std::size_t>(num_threads));
+
+            std::exception_ptr read_error;
+            {
+                apply_workers workers;
+                for (std::size_t i = 0; i < handlers.size(); ++i) {
+                    workers.start([&queue, &handlers, &errors, i] {
+                        osmium::thread::set_thread_name("_osmium_apply");
+                        osmium::memory::Buffer buffer;
+                        while (true) {
+                            queue.wait_and_pop(buffer);
+                            if (!buffer) {
+                                break;
+                            }
+                            // After an error the buffers are only drained
+                            // so that the reading thread never blocks.
+                            if (!errors[i]) {
+                                try {
+                                    apply_buffer_without_flush(buffer, handlers[i]);
+                                } catch (...) {
+                                    errors[i] = std::current_exception();
+                                }
+                            }
+                        }
+                        if (!errors[i]) {
+                            try {
+                                osmium::apply_flush(handlers[i]);
+                            } catch (...) {
+                                errors[i] = std::current_exception();
+                            }
+                        }
+                    });
+                }
+
+                try {
+                    while (osmium::memory::Buffer buffer = source.read()) {
+                        queue.push(std::move(buffer));
+                    }
+                } catch (...) {
+                    read_error = std::current_exception();
+                }
+
+                for (std::size_t i = 0; i < handlers.size(); ++i) {
+                    queue.push(osmium::memory::Buffer{});
+                }
+            }
+
+            if (read_error) {
+                std::rethrow_exception(read_error);
+            }
+            for (const auto& error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+
+            THandler result{std::move(handlers.front())};
+            for (std::size_t i = 1; i < handlers.size(); ++i) {
+                merge(result, std::move(handlers[i]));
+            }
+            return result;
+        }
+
+        template <typename THandler>
+        struct apply_task {
+            osmium::memory::Buffer buffer;
+            std::promise<THandler> result;
+        };
+
+        template <typename TSource, typename THandler, typename TMerge>
+        THandler apply_parallel_ordered(TSource& source, const THandler& handler, TMerge& merge, int num_threads, std::size_t max_queue_size) {
+            osmium::thread::Queue<apply_task<THandler>> queue{max_queue_size, "apply_parallel"};
+            std::deque<std::future<THandler>> pending;
+            THandler result{handler};
+            bool first = true;
+
+            const auto merge_front = [&] {
+                THandler next{pending.front().get()};
+                pending.pop_front();
+                if (first) {
+                    result = std::move(next);
+                    first = false;
+                } else {
+                    merge(result, std::move(next));
+                }
+            };
+
+            std::exception_ptr error;
+            {
+                apply_workers workers;
+                for (int i = 0; i < num_threads; ++i) {
+                    workers.start([&queue, &handler] {
+                        osmium::thread::set_thread_name("_osmium_apply");
+                        apply_task<THandler> task;
+                        while (true) {
+                            queue.wait_and_pop(task);
+                            if (!task.buffer) {
+                                break;
+                            }
+                            try {
+                                THandler buffer_handler{handler};
+                                apply_buffer_without_flush(task.buffer, buffer_handler);
+                                osmium::apply_flush(buffer_handler);
+                                task.result.set_value(std::move(buffer_handler));
+                            } catch (...) {
+                                task.result.set_exception(std::current_exception());
+                            }
+                        }
+                    });
+                }
+
+                try {
+                    while (osmium::memory::Buffer buffer = source.read()) {
+                        apply_task<THandler> task;
+                        task.buffer = std::move(buffer);
+                        pending.push_back(task.result.get_future());
+                        queue.push(std::move(task));
+                        while (pending.size() > 2 * max_queue_size) {
+                            merge_front();
+                        }
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                }
+
+                for (int i = 0; i < num_threads; ++i) {
+                    queue.push(apply_task<THandler>{});
+                }
+            }
+
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            while (!pending.empty()) {
+                merge_front();
+            }
+            return result;
+        }
+
+    } // namespace detail
+
+    /**
+     * Apply a handler to all OSM objects read from a source (usually an
+     * osmium::io::Reader) using several worker threads. The calling
+     * thread reads the buffers from the source and hands them to the
+     * workers. Each worker works on its own copy of the handler, at the
+     * end the copies are combined with the merge function into one
+     * handler which is returned.
+     *
+     * This only makes sense for handlers which don't depend on seeing
+     * all objects in order, for instance handlers counting or collecting
+     * objects. The handler must be copyable. Its flush() function is
+     * called once for each copy after it has seen its last object.
+     *
+     * @param source Source with a read() function returning buffers, an
+     *               invalid buffer marks the end of data.
+     * @param handler Handler which is copied for the workers. It is not
+     *                changed itself.
+     * @param merge Function called as merge(THandler& result,
+     *              THandler&& other) in the calling thread to add the
+     *              results of other to result.
+     * @param options Number of threads, merge order and queue size.
+     * @returns The merged handler.
+     * @throws Any exception thrown by the source, the handlers or the
+     *         merge function. All threads are stopped before that.
+     */
+    template <typename TSource, typename THandler, typename TMerge>
+    THandler apply_parallel(TSource& source, const THandler& handler, TMerge&& merge, const apply_parallel_options& options = apply_parallel_options{}) {
+        const int num_threads = osmium::thread::detail::get_pool_size(options.num_threads,
+                                                                        osmium::config::get_pool_threads(),
+                                                                        std::thread::hardware_concurrency());
+        const std::size_t max_queue_size = options.max_queue_size ? options.max_queue_size
+                                                                  : 2 * static_cast<std::size_t>(num_threads);
+
+        if (options.order == apply_order::ordered) {
+            return detail::apply_parallel_ordered(source, handler, merge, num_threads, max_queue_size);
+        }
+        return detail::apply_parallel_unordered(source, handler, merge, num_threads, max_queue_size);
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_PARALLEL_VISITOR_HPP
@@ -0,0 +1,275 @@
+#ifndef OSMIUM_PIPELINED_VISITOR_HPP
+#define OSMIUM_PIPELINED_VISITOR_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <osmium/memory/buffer.hpp>
+#include <osmium/parallel_visitor.hpp>
+#include <osmium/thread/queue.hpp>
+#include <osmium/thread/util.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Declares how a stage in apply_pipelined() accesses the objects.
+     */
+    enum class stage_access {
+
+        /// The handler only reads objects, it sees them as const.
+        read_only = 0,
+
+        /// The handler changes objects in place (for instance the
+        /// NodeLocationsForWays handler), it sees them as non-const.
+        mutating = 1
+
+    }; // enum class stage_access
+
+    /**
+     * A handler wrapped as a stage for apply_pipelined(). Use the
+     * read_only_stage() and mutating_stage() functions to create these.
+     */
+    template <typename THandler, stage_access TAccess>
+    class pipeline_stage {
+
+        THandler* m_handler;
+
+    public:
+
+        explicit pipeline_stage(THandler& handler) noexcept :
+            m_handler(&handler) {
+        }
+
+        THandler& handler() const noexcept {
+            return *m_handler;
+        }
+
+        static constexpr stage_access access() noexcept {
+            return TAccess;
+        }
+
+    }; // class pipeline_stage
+
+    /**
+     * Wrap a handler which only reads the objects as pipeline stage.
+     */
+    template <typename THandler>
+    inline pipeline_stage<THandler, stage_access::read_only> read_only_stage(THandler& handler) noexcept {
+        return pipeline_stage<THandler, stage_access::read_only>{handler};
+    }
+
+    /**
+     * Wrap a handler which changes the objects as pipeline stage.
+     */
+    template <typename THandler>
+    inline pipeline_stage<THandler, stage_access::mutating> mutating_stage(THandler& handler) noexcept {
+        return pipeline_stage<THandler, stage_access::mutating>{handler};
+    }
+
+    /**
+     * Options for apply_pipelined().
+     */
+    struct apply_pipelined_options {
+
+        /**
+         * Maximum number of buffers waiting in front of each stage.
+         */
+        std::size_t max_queue_size = 4;
+
+    }; // struct apply_pipelined_options
+
+    namespace detail {
+
+        template <typename THandler>
+        inline void apply_stage(osmium::memory::Buffer& buffer, const pipeline_stage<THandler, stage_access::read_only>& stage) {
+            apply_buffer_without_flush(buffer, stage.handler());
+        }
+
+        template <typename THandler>
+        inline void apply_stage(osmium::memory::Buffer& buffer, const pipeline_stage<THandler, stage_access::mutating>& stage) {
+            for (auto it = buffer.begin(); it != buffer.end(); ++it) {
+                osmium::apply_item(*it, stage.handler());
+            }
+        }
+
+        using pipeline_queue = osmium::thread::Queue<osmium::memory::Buffer>;
+
+        /**
+         * Body of the thread running one stage. It takes buffers from the
+         * input queue, applies the handler and passes them on to the
+         * output queue (if there is one). An invalid buffer marks the end
+         * of data, it is passed on after the handler was flushed so that
+         * the flush() calls happen in the order of the stages.
+         */
+        template <typename TStage>
+        void run_pipeline_stage(const TStage& stage, pipeline_queue& input, pipeline_queue* output, std::exception_ptr& error) {
+            osmium::thread::set_thread_name("_osmium_stage");
+            osmium::memory::Buffer buffer;
+            while (true) {
+                input.wait_and_pop(buffer);
+                if (!buffer) {
+                    break;
+                }
+                // After an error the buffers are only drained so that the
+                // earlier stages never block. Later stages don't see any
+                // buffers after the one that failed.
+                if (!error) {
+                    try {
+                        apply_stage(buffer, stage);
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+                    if (output && !error) {
+                        output->push(std::move(buffer));
+                    }
+                }
+            }
+            if (!error) {
+                try {
+                    osmium::apply_flush(stage.handler());
+                } catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            if (output) {
+                output->push(osmium::memory::Buffer{});
+            }
+        }
+
+        template <std::size_t N, typename TStages>
+        inline typename std::enable_if<(N == std::tuple_size<TStages>::value)>::type
+        start_pipeline_stages(const TStages& /*stages*/, std::vector<std::unique_ptr<pipeline_queue>>& /*queues*/, std::vector<std::exception_ptr>& /*errors*/, apply_workers& /*workers*/) {
+        }
+
+        template <std::size_t N, typename TStages>
+        inline typename std::enable_if<(N < std::tuple_size<TStages>::value)>::type
+        start_pipeline_stages(const TStages& stages, std::vector<std::unique_ptr<pipeline_queue>>& queues, std::vector<std::exception_ptr>& errors, apply_workers& workers) {
+            pipeline_queue* output = N + 1 < queues.size() ? queues[N + 1].get() : nullptr;
+            const auto& stage = std::get<N>(stages);
+            workers.start([&stage, &queues, output, &errors] {
+                run_pipeline_stage(stage, *queues[N], output, errors[N]);
+            });
+            start_pipeline_stages<N + 1>(stages, queues, errors, workers);
+        }
+
+    } // namespace detail
+
+    /**
+     * Apply a chain of handlers to all buffers from the source with each
+     * handler running in its own thread. Whole buffers are passed from
+     * stage to stage through bounded queues, so while the first stage
+     * works on one buffer the later stages already work on earlier
+     * buffers.
+     *
+     * Each stage sees all buffers in the input order after the previous
+     * stage is done with them. Unlike with the ChainHandler the stages
+     * do not see the objects interleaved: the first stage has seen all
+     * objects in a buffer before the second stage sees the first object
+     * of that buffer. The flush() functions are called in stage order
+     * at the end.
+     *
+     * The stages have to be wrapped with read_only_stage() or
+     * mutating_stage() to declare whether they change the objects. Only
+     * mutating stages get non-const objects.
+     *
+     * @code
+     * osmium::apply_pipelined(reader, options,
+     *     osmium::mutating_stage(location_handler),
+     *     osmium::read_only_stage(my_handler));
+     * @endcode
+     *
+     * @param source Source with a read() function returning buffers, an
+     *               invalid buffer marks the end of data.
+     * @param options Size of the queues between the stages.
+     * @param stages One or more handlers wrapped as pipeline stages.
+     * @throws Any exception thrown by the source or the handlers. All
+     *         threads are stopped before that.
+     */
+    template <typename TSource, typename... TStages>
+    void apply_pipelined(TSource& source, const apply_pipelined_options& options, const TStages&... stages) {
+        static_assert(sizeof...(TStages) > 0, "apply_pipelined() needs at least one stage");
+        const std::tuple<const TStages&...> stage_tuple{stages...};
+        const std::size_t max_queue_size = options.max_queue_size ? options.max_queue_size : 1;
+
+        std::vector<std::unique_ptr<detail::pipeline_queue>> queues;
+        for (std::size_t i = 0; i < sizeof...(TStages); ++i) {
+            queues.emplace_back(new detail::pipeline_queue{max_queue_size, "apply_pipelined"});
+        }
+        std::vector<std::exception_ptr> errors(sizeof...(TStages));
+
+        std::exception_ptr read_error;
+        {
+            detail::apply_workers workers;
+            detail::start_pipeline_stages<0>(stage_tuple, queues, errors, workers);
+
+            try {
+                while (osmium::memory::Buffer buffer = source.read()) {
+                    queues.front()->push(std::move(buffer));
+                }
+            } catch (...) {
+                read_error = std::current_exception();
+            }
+
+            queues.front()->push(osmium::memory::Buffer{});
+        }
+
+        if (read_error) {
+            std::rethrow_exception(read_error);
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+    /**
+     * Apply a chain of handlers to all buffers from the source with each
+     * handler running in its own thread. This uses the default options.
+     */
+    template <typename TSource, typename TStage, typename... TStages>
+    void apply_pipelined(TSource& source, const TStage& stage, const TStages&... stages) {
+        apply_pipelined(source, apply_pipelined_options{}, stage, stages...);
+    }
+
+} // namespace osmium
+
+#endif // OSMIUM_PIPELINED_VISITOR_HPP
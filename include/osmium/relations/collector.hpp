@@ -42,6 +42,7 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/osm/types.hpp>
 #include <osmium/relations/detail/member_meta.hpp>
 #include <osmium/relations/detail/relation_meta.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/util/iterator.hpp>
 #include <osmium/visitor.hpp>
 
@@ -50,6 +51,7 @@ DEALINGS IN THE SOFTWARE.
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <future>
 #include <iomanip>
 #include <iostream>
 #include <utility>
@@ -189,6 +191,9 @@ namespace osmium {
 
             int m_count_complete = 0;
 
+            // Used to check the order of the objects in handle_buffer().
+            osmium::handler::CheckOrder m_check_order;
+
             using callback_func_type = std::function<void(osmium::memory::Buffer&&)>;
             callback_func_type m_callback;
 
@@ -201,6 +206,12 @@ namespace osmium {
                 return make_range(std::equal_range(mmv.begin(), mmv.end(), MemberMeta(id)));
             }
 
+            static constexpr bool wanted_type(osmium::item_type type) noexcept {
+                return (TNodes && type == osmium::item_type::node) ||
+                       (TWays && type == osmium::item_type::way) ||
+                       (TRelations && type == osmium::item_type::relation);
+            }
+
         public:
 
             /**
@@ -381,8 +392,17 @@ namespace osmium {
              *          relation and false otherwise
              */
             bool find_and_add_object(const osmium::OSMObject& object) {
-                auto range = find_member_meta(object.type(), object.id());
+                return add_object(object, find_member_meta(object.type(), object.id()));
+            }
 
+            /**
+             * Add the object to all relations that need it. The range
+             * must be the result of find_member_meta() for this object.
+             *
+             * @returns true if the member was added to at least one
+             *          relation and false otherwise
+             */
+            bool add_object(const osmium::OSMObject& object, const iterator_range<mm_iterator>& range) {
                 if (count_not_removed(range) == 0) {
                     // nothing found
                     return false;
@@ -542,6 +562,105 @@ namespace osmium {
                 return std::make_pair(false, 0);
             }
 
+            /**
+             * Minimum number of objects per thread used for the lookups
+             * in handle_buffer().
+             */
+            enum : std::size_t {
+                min_objects_per_shard = 1024
+            };
+
+            /**
+             * Handle all objects in the buffer for the second pass. This
+             * does the same as feeding all objects in the buffer to the
+             * handler(), but searches the member vectors for all objects
+             * in several threads first. Each thread works on a range of
+             * the objects, which, for sorted input, is a range of ids.
+             * The member vectors are not changed after the first pass
+             * apart from the flags of their entries, so these lookups
+             * don't need any locking. The objects are then added to the
+             * relations in order in the current thread, so the derived
+             * class sees the same calls in the same order as with the
+             * handler().
+             *
+             * Call handler() first to set the callback and flush() on the
+             * handler at the end:
+             *
+             * @code
+             * auto& handler = collector.handler(callback);
+             * while (osmium::memory::Buffer buffer = reader.read()) {
+             *     collector.handle_buffer(buffer, pool);
+             * }
+             * handler.flush();
+             * @endcode
+             *
+             * @param buffer Buffer with the objects.
+             * @param pool Thread pool to use.
+             */
+            void handle_buffer(const osmium::memory::Buffer& buffer, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                std::vector<const osmium::OSMObject*> objects;
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (wanted_type(object.type())) {
+                        objects.push_back(&object);
+                    }
+                }
+
+                std::vector<iterator_range<mm_iterator>> ranges(objects.size(), iterator_range<mm_iterator>{std::make_pair(mm_iterator{}, mm_iterator{})});
+                const auto lookup = [this, &objects, &ranges](const std::size_t begin, const std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        ranges[i] = find_member_meta(objects[i]->type(), objects[i]->id());
+                    }
+                };
+
+                const std::size_t num_shards = std::min(objects.size() / min_objects_per_shard, static_cast<std::size_t>(pool.num_threads()));
+                if (num_shards > 1) {
+                    std::vector<std::future<void>> futures;
+                    futures.reserve(num_shards);
+                    for (std::size_t n = 0; n < num_shards; ++n) {
+                        const std::size_t begin = objects.size() * n / num_shards;
+                        const std::size_t end = objects.size() * (n + 1) / num_shards;
+                        futures.push_back(pool.submit([&lookup, begin, end]() {
+                            lookup(begin, end);
+                        }));
+                    }
+                    // Wait for all tasks before getting their results, so
+                    // that exceptions are only rethrown after all are done.
+                    for (auto& future : futures) {
+                        future.wait();
+                    }
+                    for (auto& future : futures) {
+                        future.get();
+                    }
+                } else {
+                    lookup(0, objects.size());
+                }
+
+                auto& collector = *static_cast<TCollector*>(this);
+                for (std::size_t i = 0; i < objects.size(); ++i) {
+                    const osmium::OSMObject& object = *objects[i];
+                    switch (object.type()) {
+                        case osmium::item_type::node:
+                            m_check_order.node(static_cast<const osmium::Node&>(object));
+                            if (!add_object(object, ranges[i])) {
+                                collector.node_not_in_any_relation(static_cast<const osmium::Node&>(object));
+                            }
+                            break;
+                        case osmium::item_type::way:
+                            m_check_order.way(static_cast<const osmium::Way&>(object));
+                            if (!add_object(object, ranges[i])) {
+                                collector.way_not_in_any_relation(static_cast<const osmium::Way&>(object));
+                            }
+                            break;
+                        default: // osmium::item_type::relation
+                            m_check_order.relation(static_cast<const osmium::Relation&>(object));
+                            if (!add_object(object, ranges[i])) {
+                                collector.relation_not_in_any_relation(static_cast<const osmium::Relation&>(object));
+                            }
+                            break;
+                    }
+                }
+            }
+
             template <typename TIter>
             void read_relations(TIter begin, TIter end) {
                 HandlerPass1 handler(*static_cast<TCollector*>(this));
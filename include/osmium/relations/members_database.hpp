@@ -33,19 +33,21 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/index/detail/search_tree.hpp>
 #include <osmium/osm/object.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/types.hpp>
 #include <osmium/relations/relations_database.hpp>
 #include <osmium/storage/item_stash.hpp>
-#include <osmium/util/iterator.hpp>
 
 #include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <limits>
-#include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -61,28 +63,17 @@ namespace osmium {
          */
         class MembersDatabaseCommon {
 
+            // Data stored for each tracked member in addition to its id.
             struct element {
 
                 /**
-                 * Special value used for member_num to mark the element as
-                 * removed.
+                 * Special value used for relation_pos to mark the element
+                 * as removed.
                  */
-                enum {
+                enum : std::size_t {
                     removed_value = std::numeric_limits<std::size_t>::max()
                 };
 
-                /**
-                 * Object ID of this relation member. Can be a node, way,
-                 * or relation ID. It depends on the database in which this
-                 * object is stored which kind of object is referenced here.
-                 */
-                osmium::object_id_type member_id;
-
-                /**
-                 * Position of this member in the parent relation.
-                 */
-                std::size_t member_num;
-
                 /**
                  * Position of the parent relation in the relations database.
                  */
@@ -96,46 +87,41 @@ namespace osmium {
                  */
                 osmium::ItemStash::handle_type object_handle;
 
-                explicit element(std::size_t rel_pos, osmium::object_id_type memb_id, std::size_t memb_num) noexcept :
-                    member_id(memb_id),
-                    member_num(memb_num),
+                explicit element(std::size_t rel_pos) noexcept :
                     relation_pos(rel_pos) {
                 }
 
-                /**
-                 * This constructor is used to create dummy elements that
-                 * can be compared to the elements in a vector using the
-                 * equal_range algorithm.
-                 */
-                explicit element(osmium::object_id_type m_id) noexcept :
-                    member_id(m_id),
-                    member_num(0),
-                    relation_pos(0) {
-                }
-
                 bool is_removed() const noexcept {
-                    return member_num == removed_value;
+                    return relation_pos == removed_value;
                 }
 
                 void remove() noexcept {
-                    member_num = removed_value;
-                }
-
-                bool operator<(const element& other) const noexcept {
-                    return std::tie(member_id, member_num, relation_pos) <
-                           std::tie(other.member_id, other.member_num, other.relation_pos);
+                    relation_pos = removed_value;
                 }
 
             }; // struct element
 
-            // comparison function only comparing member_id.
-            struct compare_member_id {
-                bool operator()(const element& a, const element& b) const noexcept {
-                    return a.member_id < b.member_id;
-                }
+            // Removed elements are compacted away when there are at least
+            // this many and they make up more than half of all elements.
+            enum : std::size_t {
+                min_compact_size = 1024UL * 1024UL
             };
 
+            // Members tracked before prepare_for_lookup() as pairs of
+            // member id and relation position.
+            std::vector<std::pair<osmium::object_id_type, std::size_t>> m_tracked{};
+
+            // After prepare_for_lookup() the member ids are in this sorted
+            // vector and the other data for each member is in m_elements
+            // at the same position.
+            std::vector<osmium::object_id_type> m_ids{};
             std::vector<element> m_elements{};
+            osmium::index::detail::search_tree<osmium::object_id_type> m_search_tree{};
+
+            // The number of elements marked as removed and the number of
+            // removed elements already compacted away.
+            std::size_t m_removed = 0;
+            std::size_t m_compacted = 0;
 
         protected:
 
@@ -148,27 +134,34 @@ namespace osmium {
             bool m_init_phase = true;
 #endif
 
-            using iterator = std::vector<element>::iterator;
-            using const_iterator = std::vector<element>::const_iterator;
-
-            iterator_range<iterator> find(osmium::object_id_type id) {
-                return make_range(std::equal_range(m_elements.begin(), m_elements.end(), element{id}, compare_member_id{}));
+            // Return range of positions of all elements with the
+            // specified member id.
+            std::pair<std::size_t, std::size_t> find(osmium::object_id_type id) const noexcept {
+                const std::size_t begin = m_search_tree.lower_bound(m_ids, id);
+                std::size_t end = begin;
+                while (end < m_ids.size() && m_ids[end] == id) {
+                    ++end;
+                }
+                return {begin, end};
             }
 
-            iterator_range<const_iterator> find(osmium::object_id_type id) const {
-                return make_range(std::equal_range(m_elements.cbegin(), m_elements.cend(), element{id}, compare_member_id{}));
+            element& get_element(std::size_t pos) noexcept {
+                assert(pos < m_elements.size());
+                return m_elements[pos];
             }
 
-            static typename iterator_range<iterator>::iterator::difference_type count_not_removed(const iterator_range<iterator>& range) noexcept {
-                return std::count_if(range.begin(), range.end(), [](const element& elem) {
+            std::size_t count_not_removed(const std::pair<std::size_t, std::size_t>& range) const noexcept {
+                return static_cast<std::size_t>(std::count_if(m_elements.cbegin() + static_cast<std::ptrdiff_t>(range.first),
+                                                              m_elements.cbegin() + static_cast<std::ptrdiff_t>(range.second),
+                                                              [](const element& elem) {
                     return !elem.is_removed();
-                });
+                }));
             }
 
-            void add_object(const osmium::OSMObject& object, iterator_range<iterator>& range) {
+            void add_object(const osmium::OSMObject& object, const std::pair<std::size_t, std::size_t>& range) {
                 const auto handle = m_stash.add_item(object);
-                for (auto& elem : range) {
-                    elem.object_handle = handle;
+                for (std::size_t pos = range.first; pos < range.second; ++pos) {
+                    m_elements[pos].object_handle = handle;
                 }
             }
 
@@ -179,25 +172,50 @@ namespace osmium {
 
         public:
 
+            /**
+             * Positions of the first and one past the last element for a
+             * member id in the database as returned by lookup().
+             */
+            using positions_type = std::pair<std::size_t, std::size_t>;
+
+            /**
+             * Find the positions of all elements for the specified member
+             * id. The result can be given to MembersDatabase::add() later.
+             * This does not change the database, so it can be called from
+             * several threads at the same time as long as no other function
+             * changing the database is called. The positions are valid
+             * until the next call to compact() or possibly_compact().
+             *
+             * Complexity: Logarithmic in the number of members tracked (as
+             *             returned by size()).
+             */
+            positions_type lookup(osmium::object_id_type id) const {
+                assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling lookup().");
+                return find(id);
+            }
+
             /**
              * Return an estimate of the number of bytes currently needed
              * for the MembersDatabase. This does NOT include the memory used
              * in the stash. Used for debugging.
              */
             std::size_t used_memory() const noexcept {
-                return sizeof(element) * m_elements.capacity() +
+                return sizeof(std::pair<osmium::object_id_type, std::size_t>) * m_tracked.capacity() +
+                       sizeof(osmium::object_id_type) * m_ids.capacity() +
+                       sizeof(element) * m_elements.capacity() +
+                       m_search_tree.used_memory() +
                        sizeof(MembersDatabaseCommon);
             }
 
             /**
              * The number of members tracked in the database. Includes
              * members tracked, but not found yet, members found and members
-             * marked as removed.
+             * marked as removed, but not yet compacted away.
              *
              * Complexity: Constant.
              */
             std::size_t size() const noexcept {
-                return m_elements.size();
+                return m_tracked.size() + m_ids.size();
             }
 
             /**
@@ -221,6 +239,8 @@ namespace osmium {
             counts count() const noexcept {
                 counts c;
 
+                c.tracked = m_tracked.size();
+                c.removed = m_compacted;
                 for (const auto& elem : m_elements) {
                     if (elem.is_removed()) {
                         ++c.removed;
@@ -242,11 +262,13 @@ namespace osmium {
              * @param rel_handle Relation this object is a member of.
              * @param member_id Id of an object of type TObject.
              * @param member_num This is the nth member in the relation.
+             *                   (Not used any more.)
              */
             void track(RelationHandle& rel_handle, osmium::object_id_type member_id, std::size_t member_num) {
                 assert(m_init_phase && "Can not call MembersDatabase::track() after MembersDatabase::prepare_for_lookup().");
                 assert(rel_handle.relation_database() == &m_relations_db);
-                m_elements.emplace_back(rel_handle.pos(), member_id, member_num);
+                (void)member_num;
+                m_tracked.emplace_back(member_id, rel_handle.pos());
                 rel_handle.increment_members();
             }
 
@@ -258,7 +280,22 @@ namespace osmium {
              */
             void prepare_for_lookup() {
                 assert(m_init_phase && "Can not call MembersDatabase::prepare_for_lookup() twice.");
-                std::sort(m_elements.begin(), m_elements.end());
+
+                // Flip the sign bit so that negative ids sort first.
+                osmium::index::detail::radix_sort(m_tracked, [](const std::pair<osmium::object_id_type, std::size_t>& p) noexcept {
+                    return static_cast<uint64_t>(p.first) ^ (uint64_t(1) << 63U);
+                });
+
+                m_ids.reserve(m_tracked.size());
+                m_elements.reserve(m_tracked.size());
+                for (const auto& p : m_tracked) {
+                    m_ids.push_back(p.first);
+                    m_elements.emplace_back(p.second);
+                }
+                m_tracked.clear();
+                m_tracked.shrink_to_fit();
+                m_search_tree.build(m_ids);
+
 #ifndef NDEBUG
                 m_init_phase = false;
 #endif
@@ -267,28 +304,71 @@ namespace osmium {
             /**
              * Remove the entry with the specified member_id and relation_id
              * from the database. If the entry doesn't exist, nothing happens.
+             *
+             * The entry is only marked as removed. Removed entries are
+             * compacted away later, see possibly_compact().
              */
             void remove(osmium::object_id_type member_id, osmium::object_id_type relation_id) {
                 const auto range = find(member_id);
 
-                if (range.empty()) {
+                if (range.first == range.second) {
                     return;
                 }
 
                 // If this is the last time this object was needed, remove it
-                // from the stash.
-                if (count_not_removed(range) == 1) {
-                    m_stash.remove_item(range.begin()->object_handle);
+                // from the stash. The object might not have been found yet
+                // if the relation is removed before it is complete.
+                if (count_not_removed(range) == 1 && m_elements[range.first].object_handle.valid()) {
+                    m_stash.remove_item(m_elements[range.first].object_handle);
                 }
 
-                for (auto& elem : range) {
+                for (std::size_t pos = range.first; pos < range.second; ++pos) {
+                    auto& elem = m_elements[pos];
                     if (!elem.is_removed() && relation_id == m_relations_db[elem.relation_pos]->id()) {
                         elem.remove();
+                        ++m_removed;
                         break;
                     }
                 }
             }
 
+            /**
+             * Remove all entries marked as removed from the database. This
+             * invalidates all positions returned from lookup().
+             *
+             * Complexity: Linear in the number of members tracked.
+             */
+            void compact() {
+                assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling compact().");
+                std::size_t out = 0;
+                for (std::size_t pos = 0; pos < m_elements.size(); ++pos) {
+                    if (!m_elements[pos].is_removed()) {
+                        m_ids[out] = m_ids[pos];
+                        m_elements[out] = m_elements[pos];
+                        ++out;
+                    }
+                }
+                m_ids.resize(out);
+                m_ids.shrink_to_fit();
+                m_elements.resize(out, element{0});
+                m_elements.shrink_to_fit();
+                m_search_tree.build(m_ids);
+                m_compacted += m_removed;
+                m_removed = 0;
+            }
+
+            /**
+             * Call compact() if more than half of the entries are marked
+             * as removed and there are enough of them that it is worth
+             * it. This is called from MembersDatabase::add(), so you
+             * usually don't have to call it yourself.
+             */
+            void possibly_compact() {
+                if (m_removed >= min_compact_size && m_removed * 2 > m_elements.size()) {
+                    compact();
+                }
+            }
+
             /**
              * Find the object with the specified id in the database and
              * return a pointer to it. Returns nullptr if there is no object
@@ -300,10 +380,10 @@ namespace osmium {
             const osmium::OSMObject* get_object(osmium::object_id_type id) const {
                 assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling get_object().");
                 const auto range = find(id);
-                if (range.empty()) {
+                if (range.first == range.second) {
                     return nullptr;
                 }
-                const auto handle = range.begin()->object_handle;
+                const auto handle = m_elements[range.first].object_handle;
                 if (handle.valid()) {
                     return &m_stash.get<osmium::OSMObject>(handle);
                 }
@@ -358,23 +438,42 @@ namespace osmium {
             template <typename TFunc>
             bool add(const TObject& object, TFunc&& func) {
                 assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling add().");
-                auto range = find(object.id());
+                possibly_compact();
+                return add(object, lookup(object.id()), std::forward<TFunc>(func));
+            }
 
-                if (range.empty()) {
-                    // No relation needs this object.
+            /**
+             * Add the specified object to the database using the positions
+             * found with an earlier call to lookup() for the object id.
+             *
+             * @param object Object to add.
+             * @param positions Result of lookup(object.id()).
+             * @param func If the object is the last member to complete a
+             *             relation, this function is called with the relation
+             *             as a parameter.
+             * @returns true if the object was actually added, false if no
+             *          relation needed this object.
+             */
+            template <typename TFunc>
+            bool add(const TObject& object, const positions_type& positions, TFunc&& func) {
+                assert(!m_init_phase && "Call MembersDatabase::prepare_for_lookup() before calling add().");
+                if (count_not_removed(positions) == 0) {
+                    // No relation needs this object (any more).
                     return false;
                 }
 
                 // At least one relation needs this object. Store it and
                 // "tell" all relations.
-                add_object(object, range);
+                add_object(object, positions);
 
-                for (auto& elem : range) {
-                    assert(!elem.is_removed());
-                    assert(elem.member_id == object.id());
+                for (std::size_t pos = positions.first; pos < positions.second; ++pos) {
+                    const auto& elem = get_element(pos);
+                    if (elem.is_removed()) {
+                        // The relation was removed before it was complete.
+                        continue;
+                    }
 
                     auto rel_handle = m_relations_db[elem.relation_pos];
-                    assert(elem.member_num < rel_handle->members().size());
                     rel_handle.decrement_members();
 
                     if (rel_handle.has_all_members()) {
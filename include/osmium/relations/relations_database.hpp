@@ -175,6 +175,16 @@ namespace osmium {
              */
             RelationHandle operator[](std::size_t pos) noexcept;
 
+            /**
+             * Has the relation at the specified position been removed?
+             *
+             * Complexity: Constant.
+             */
+            bool is_removed(std::size_t pos) const noexcept {
+                assert(pos < m_elements.size());
+                return !m_elements[pos].handle.valid();
+            }
+
             /**
              * Return the number of non-removed relations in the database.
              *
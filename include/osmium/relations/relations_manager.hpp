@@ -35,9 +35,11 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/handler.hpp>
 #include <osmium/handler/check_order.hpp>
+#include <osmium/index/relations_map.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/callback_buffer.hpp>
 #include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object_comparisons.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/osm/tag.hpp>
 #include <osmium/osm/way.hpp>
@@ -47,14 +49,20 @@ DEALINGS IN THE SOFTWARE.
 #include <osmium/storage/item_stash.hpp>
 #include <osmium/tags/taglist.hpp>
 #include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <future>
+#include <limits>
+#include <memory>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace osmium {
@@ -97,6 +105,17 @@ namespace osmium {
                 m_member_relations_db(m_stash, m_relations_db) {
             }
 
+            /**
+             * Configure the ItemStash holding all relations and members,
+             * for instance to store them in segments which can be
+             * spilled to disk. This must be called before any relations
+             * are added, because it clears the stash.
+             */
+            void configure_stash(const osmium::ItemStash::config& cfg) {
+                assert(m_relations_db.size() == 0);
+                m_stash.configure(cfg);
+            }
+
             /// Access the internal RelationsDatabase.
             osmium::relations::RelationsDatabase& relations_database() noexcept {
                 return m_relations_db;
@@ -261,6 +280,15 @@ namespace osmium {
                 m_output.set_callback(callback);
             }
 
+            /**
+             * Call the output callback in a task in the specified pool, so
+             * that the output is written while relations are assembled.
+             * See CallbackBuffer::enable_background_flush().
+             */
+            void enable_background_flush(osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) noexcept {
+                m_output.enable_background_flush(pool);
+            }
+
             /// Flush the output buffer.
             void flush_output() {
                 m_output.flush();
@@ -278,6 +306,28 @@ namespace osmium {
 
         }; // class RelationsManagerBase
 
+        namespace detail {
+
+            /**
+             * Check whether TManager has a member function
+             * complete_relation(const osmium::Relation&, osmium::memory::Buffer&)
+             * which can be used from several threads at the same time.
+             */
+            template <typename TManager>
+            struct has_buffer_complete_relation {
+
+                template <typename T>
+                static auto test(int) -> decltype(std::declval<T&>().complete_relation(std::declval<const osmium::Relation&>(), std::declval<osmium::memory::Buffer&>()), std::true_type{});
+
+                template <typename>
+                static std::false_type test(...);
+
+                using type = decltype(test<TManager>(0));
+
+            }; // struct has_buffer_complete_relation
+
+        } // namespace detail
+
         /**
          * This is a base class for RelationManager classes. It keeps track of
          * all interesting relations and all interesting members of those
@@ -306,6 +356,24 @@ namespace osmium {
 
             SecondPassHandler<RelationsManager> m_handler_pass2;
 
+            // For each member type the largest member id of that type and
+            // the position of the relation, used by the early eviction.
+            // See enable_early_eviction().
+            using last_member_type = std::pair<osmium::object_id_type, std::size_t>;
+            std::array<std::vector<last_member_type>, 3> m_last_members{};
+            std::array<std::size_t, 3> m_next_eviction{{0, 0, 0}};
+            bool m_early_eviction = false;
+            bool m_eviction_sorted = false;
+
+            // Used for nested relations, see enable_nested_relations().
+            // The stash maps member relation ids to parent ids, the
+            // index built from it the other way around.
+            bool m_nested = false;
+            osmium::index::RelationsMapStash m_nested_stash{};
+            std::unique_ptr<osmium::index::RelationsMapIndex> m_nested_children{};
+            std::vector<std::pair<osmium::unsigned_object_id_type, std::size_t>> m_relation_positions{};
+            std::vector<bool> m_nested_pos{};
+
             static bool wanted_type(osmium::item_type type) noexcept {
                 return (TNodes     && type == osmium::item_type::node) ||
                        (TWays      && type == osmium::item_type::way) ||
@@ -438,14 +506,95 @@ namespace osmium {
             void after_relation(const osmium::Relation& /*relation*/) const noexcept {
             }
 
+            /**
+             * This method is called for every relation removed by the early
+             * eviction, because it is missing members and can never be
+             * complete. See enable_early_eviction().
+             *
+             * Overwrite this method in a derived class if you are interested
+             * in this.
+             */
+            void evict_relation(const osmium::Relation& /*relation*/) const noexcept {
+            }
+
             TManager& derived() noexcept {
                 return *static_cast<TManager*>(this);
             }
 
-            void handle_complete_relation(RelationHandle& rel_handle) {
-                derived().complete_relation(*rel_handle);
-                possibly_flush();
+            // Remember the largest id of each member type for the early
+            // eviction.
+            void add_last_members(const RelationHandle& rel_handle) {
+                std::array<osmium::object_id_type, 3> last{{0, 0, 0}};
+                for (const auto& member : rel_handle->members()) {
+                    if (member.ref() != 0) {
+                        auto& id = last[osmium::item_type_to_nwr_index(member.type())];
+                        if (id == 0 || osmium::id_order{}(id, member.ref())) {
+                            id = member.ref();
+                        }
+                    }
+                }
+                for (std::size_t i = 0; i < last.size(); ++i) {
+                    if (last[i] != 0) {
+                        m_last_members[i].emplace_back(last[i], rel_handle.pos());
+                    }
+                }
+            }
+
+            // Is the member of the specified type with the specified
+            // id missing in the relation?
+            bool has_missing_member(const osmium::Relation& relation, osmium::item_type type) const {
+                for (const auto& member : relation.members()) {
+                    if (member.type() == type && member.ref() != 0 && !get_member_object(member)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Evict all relations missing members of the type with the
+            // specified index which can not appear any more, because all
+            // members of this type have an id not larger than id. If all
+            // is set, all of them are checked.
+            void evict_relations(unsigned int index, osmium::object_id_type id, bool all) {
+                const auto& last_members = m_last_members[index];
+                auto& next = m_next_eviction[index];
+                const auto type = osmium::nwr_index_to_item_type(index);
+                while (next < last_members.size() &&
+                       (all || !osmium::id_order{}(id, last_members[next].first))) {
+                    auto rel_handle = relations_database()[last_members[next].second];
+                    ++next;
+                    if (!rel_handle.has_all_members() && has_missing_member(*rel_handle, type)) {
+                        derived().evict_relation(*rel_handle);
+                        remove_relation(rel_handle);
+                    }
+                }
+            }
 
+            // Called after an object was handled in the second pass. With
+            // sorted input all members of "smaller" types have been seen
+            // already.
+            void possibly_evict(osmium::item_type type, osmium::object_id_type id) {
+                if (!m_early_eviction) {
+                    return;
+                }
+                if (!m_eviction_sorted) {
+                    for (auto& last_members : m_last_members) {
+                        std::sort(last_members.begin(), last_members.end(), [](const last_member_type& lhs, const last_member_type& rhs) {
+                            return osmium::id_order{}(lhs.first, rhs.first);
+                        });
+                    }
+                    m_eviction_sorted = true;
+                }
+                const auto index = osmium::item_type_to_nwr_index(type);
+                for (unsigned int i = 0; i < index; ++i) {
+                    evict_relations(i, 0, true);
+                }
+                evict_relations(index, id, false);
+            }
+
+            // Remove members and the relation itself after the relation
+            // was completed or evicted.
+            void remove_relation(RelationHandle& rel_handle) {
                 for (const auto& member : rel_handle->members()) {
                     if (member.ref() != 0) {
                         member_database(member.type()).remove(member.ref(), rel_handle->id());
@@ -455,14 +604,325 @@ namespace osmium {
                 rel_handle.remove();
             }
 
+            // Is the relation at this position a parent or a child of
+            // another relation we are interested in? Those are completed
+            // in complete_nested_relations().
+            bool is_nested(std::size_t pos) const noexcept {
+                return m_nested && pos < m_nested_pos.size() && m_nested_pos[pos];
+            }
+
+            enum : std::size_t {
+                no_position = std::numeric_limits<std::size_t>::max()
+            };
+
+            // Position of the relation with the specified id in the
+            // relations database or no_position if we are not
+            // interested in it.
+            std::size_t nested_position(osmium::unsigned_object_id_type id) const noexcept {
+                const auto it = std::lower_bound(m_relation_positions.cbegin(), m_relation_positions.cend(), id, [](const std::pair<osmium::unsigned_object_id_type, std::size_t>& rp, osmium::unsigned_object_id_type rid) {
+                    return rp.first < rid;
+                });
+                if (it == m_relation_positions.cend() || it->first != id) {
+                    return no_position;
+                }
+                return it->second;
+            }
+
+            // Positions of all child relations we are interested in of
+            // the relation at the specified position.
+            std::vector<std::size_t> nested_children(std::size_t pos) {
+                std::vector<std::size_t> children;
+                if (relations_database().is_removed(pos)) {
+                    return children;
+                }
+                m_nested_children->for_each(relations_database()[pos]->positive_id(), [this, &children](osmium::unsigned_object_id_type id) {
+                    const auto child = nested_position(id);
+                    if (child != no_position) {
+                        children.push_back(child);
+                    }
+                });
+                return children;
+            }
+
+            void prepare_nested() {
+                std::sort(m_relation_positions.begin(), m_relation_positions.end());
+                m_nested_children.reset(new osmium::index::RelationsMapIndex{m_nested_stash.build_parent_to_member_index()});
+                m_nested_pos.assign(relations_database().size(), false);
+                for (const auto& rp : m_relation_positions) {
+                    m_nested_children->for_each(rp.first, [this, &rp](osmium::unsigned_object_id_type id) {
+                        const auto child = nested_position(id);
+                        if (child != no_position) {
+                            m_nested_pos[rp.second] = true;
+                            m_nested_pos[child] = true;
+                        }
+                    });
+                }
+            }
+
+            void handle_complete_relation(RelationHandle& rel_handle) {
+                if (is_nested(rel_handle.pos())) {
+                    return;
+                }
+                derived().complete_relation(*rel_handle);
+                possibly_flush();
+                remove_relation(rel_handle);
+            }
+
+            // Handle an object in handle_buffer(). Completed relations are
+            // only collected here.
+            void handle_batched(const osmium::OSMObject& object, const MembersDatabaseCommon::positions_type& positions, std::vector<std::size_t>& completed) {
+                const auto func = [this, &completed](RelationHandle& rel_handle) {
+                    if (!is_nested(rel_handle.pos())) {
+                        completed.push_back(rel_handle.pos());
+                    }
+                };
+                switch (object.type()) {
+                    case osmium::item_type::node: {
+                            const auto& node = static_cast<const osmium::Node&>(object);
+                            m_check_order_handler.node(node);
+                            derived().before_node(node);
+                            if (!member_nodes_database().add(node, positions, func)) {
+                                derived().node_not_in_any_relation(node);
+                            }
+                            derived().after_node(node);
+                        }
+                        break;
+                    case osmium::item_type::way: {
+                            const auto& way = static_cast<const osmium::Way&>(object);
+                            m_check_order_handler.way(way);
+                            derived().before_way(way);
+                            if (!member_ways_database().add(way, positions, func)) {
+                                derived().way_not_in_any_relation(way);
+                            }
+                            derived().after_way(way);
+                        }
+                        break;
+                    default: {
+                            const auto& relation = static_cast<const osmium::Relation&>(object);
+                            m_check_order_handler.relation(relation);
+                            derived().before_relation(relation);
+                            if (!member_relations_database().add(relation, positions, func)) {
+                                derived().relation_not_in_any_relation(relation);
+                            }
+                            derived().after_relation(relation);
+                        }
+                        break;
+                }
+                possibly_evict(object.type(), object.id());
+                possibly_flush();
+            }
+
+            // Wait for all futures and then get their results, so that
+            // exceptions are only rethrown after all tasks are done.
+            static void wait_for_all(std::vector<std::future<void>>& futures) {
+                for (auto& future : futures) {
+                    future.wait();
+                }
+                for (auto& future : futures) {
+                    future.get();
+                }
+            }
+
+            // Call complete_relation() for the completed relations in
+            // several threads, each writing into its own buffer. The
+            // buffers are then added to the output in order.
+            void complete_relations(const std::vector<std::size_t>& completed, osmium::thread::Pool& pool, std::true_type /*parallel*/) {
+                const std::size_t num_tasks = std::min(completed.size(), static_cast<std::size_t>(pool.num_threads()) * 4);
+                std::vector<osmium::memory::Buffer> buffers;
+                buffers.reserve(num_tasks);
+                std::vector<std::future<void>> futures;
+                futures.reserve(num_tasks);
+
+                for (std::size_t n = 0; n < num_tasks; ++n) {
+                    buffers.emplace_back(initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes);
+                    auto* buffer = &buffers.back();
+                    const std::size_t begin = completed.size() * n / num_tasks;
+                    const std::size_t end = completed.size() * (n + 1) / num_tasks;
+                    futures.push_back(pool.submit([this, &completed, buffer, begin, end]() {
+                        for (std::size_t i = begin; i < end; ++i) {
+                            derived().complete_relation(*relations_database()[completed[i]], *buffer);
+                        }
+                    }));
+                }
+                wait_for_all(futures);
+
+                for (const auto& buffer : buffers) {
+                    this->buffer().add_buffer(buffer);
+                    this->buffer().commit();
+                    possibly_flush();
+                }
+            }
+
+            void complete_relations(const std::vector<std::size_t>& completed, osmium::thread::Pool& /*pool*/, std::false_type /*parallel*/) {
+                for (const auto pos : completed) {
+                    derived().complete_relation(*relations_database()[pos]);
+                    possibly_flush();
+                }
+            }
+
         public:
 
+            /**
+             * Initial size of the per-thread output buffers used when
+             * completing relations in handle_buffer().
+             */
+            enum : std::size_t {
+                initial_output_buffer_size = 1024UL * 1024UL
+            };
+
+            /**
+             * Minimum number of objects per thread used for the lookups
+             * in handle_buffer().
+             */
+            enum : std::size_t {
+                min_objects_per_shard = 1024
+            };
+
             RelationsManager() :
                 RelationsManagerBase(),
                 m_check_order_handler(),
                 m_handler_pass2(*this) {
             }
 
+            /**
+             * Enable the early eviction of relations which are missing
+             * members. Relations are always completed and removed as soon
+             * as their last member is found. Relations with members missing
+             * in the input, for instance in extracts, would be kept until
+             * the end of the second pass though. With this enabled the
+             * largest member id of each type is remembered for each
+             * relation in the first pass and the relation is removed
+             * together with its members as soon as the second pass is past
+             * this id and a member of this type is still missing. The
+             * evict_relation() function of the derived class is called for
+             * these relations and they are not available from
+             * for_each_incomplete_relation().
+             *
+             * This must be called before the first pass.
+             *
+             * @pre The input data for the second pass must be sorted by
+             *      type and id.
+             */
+            void enable_early_eviction() noexcept {
+                assert(relations_database().size() == 0);
+                m_early_eviction = true;
+            }
+
+            /**
+             * Enable support for nested relations, ie. relations which
+             * have other relations we are interested in as members (for
+             * instance route_master relations with their routes). The
+             * child relations are then kept together with their members
+             * until the parent is completed, so complete_relation() for
+             * the parent can access the members of the children, too.
+             *
+             * The relations involved are not completed in the second pass,
+             * but only when complete_nested_relations() is called after
+             * it. This completes them in topological order, children
+             * before parents, without reading the input again. The member
+             * relations of all relations are recorded in the first pass
+             * in a RelationsMapStash for this.
+             *
+             * This must be called before the first pass.
+             */
+            void enable_nested_relations() noexcept {
+                static_assert(TRelations, "Nested relations need a RelationsManager interested in member relations");
+                assert(relations_database().size() == 0);
+                m_nested = true;
+            }
+
+            /**
+             * Sort the members databases to prepare them for reading. Usually
+             * this is called between the first and second pass reading through
+             * an OSM data file. If nested relations are enabled, this also
+             * builds the index of child relations.
+             */
+            void prepare_for_lookup() {
+                RelationsManagerBase::prepare_for_lookup();
+                if (m_nested) {
+                    prepare_nested();
+                }
+            }
+
+            /**
+             * Complete the nested relations after the second pass, see
+             * enable_nested_relations(). A relation is completed if all
+             * its members were found and all its child relations were
+             * completed before. The complete_relation() function of the
+             * derived class is called for them in the current thread.
+             * Relations which are part of a cycle or have missing members
+             * somewhere below them are not completed and remain available
+             * from for_each_incomplete_relation().
+             *
+             * Does nothing if nested relations are not enabled.
+             */
+            void complete_nested_relations() {
+                if (!m_nested) {
+                    return;
+                }
+
+                enum class state : uint8_t {
+                    unvisited,
+                    visiting,
+                    done,
+                    failed
+                };
+
+                struct frame {
+                    std::size_t pos;
+                    std::vector<std::size_t> children;
+                    std::size_t next;
+                };
+
+                std::vector<state> states(m_nested_pos.size(), state::unvisited);
+                std::vector<std::size_t> completed;
+
+                // Iterative depth first search, so that every relation is
+                // handled after its children.
+                for (std::size_t start = 0; start < m_nested_pos.size(); ++start) {
+                    if (!m_nested_pos[start] || states[start] != state::unvisited) {
+                        continue;
+                    }
+
+                    std::vector<frame> stack;
+                    states[start] = state::visiting;
+                    stack.push_back(frame{start, nested_children(start), 0});
+                    while (!stack.empty()) {
+                        auto& top = stack.back();
+                        if (top.next < top.children.size()) {
+                            const auto child = top.children[top.next++];
+                            if (states[child] == state::unvisited) {
+                                states[child] = state::visiting;
+                                stack.push_back(frame{child, nested_children(child), 0});
+                            }
+                            continue;
+                        }
+
+                        const auto pos = top.pos;
+                        const bool ok = !relations_database().is_removed(pos) &&
+                                        relations_database()[pos].has_all_members() &&
+                                        std::all_of(top.children.cbegin(), top.children.cend(), [&states](std::size_t child) {
+                                            return states[child] == state::done;
+                                        });
+                        stack.pop_back();
+
+                        if (ok) {
+                            states[pos] = state::done;
+                            derived().complete_relation(*relations_database()[pos]);
+                            possibly_flush();
+                            completed.push_back(pos);
+                        } else {
+                            states[pos] = state::failed;
+                        }
+                    }
+                }
+
+                for (const auto pos : completed) {
+                    auto rel_handle = relations_database()[pos];
+                    remove_relation(rel_handle);
+                }
+            }
+
             /**
              * Return reference to second pass handler.
              */
@@ -495,6 +955,19 @@ namespace osmium {
                         }
                         ++n;
                     }
+
+                    if (m_early_eviction) {
+                        add_last_members(rel_handle);
+                    }
+
+                    if (m_nested) {
+                        m_relation_positions.emplace_back(relation.positive_id(), rel_handle.pos());
+                        for (const auto& member : rel_handle->members()) {
+                            if (member.type() == osmium::item_type::relation && member.ref() != 0) {
+                                m_nested_stash.add(member.positive_ref(), relation.positive_id());
+                            }
+                        }
+                    }
                 }
             }
 
@@ -509,6 +982,7 @@ namespace osmium {
                         derived().node_not_in_any_relation(node);
                     }
                     derived().after_node(node);
+                    possibly_evict(osmium::item_type::node, node.id());
                     possibly_flush();
                 }
             }
@@ -524,6 +998,7 @@ namespace osmium {
                         derived().way_not_in_any_relation(way);
                     }
                     derived().after_way(way);
+                    possibly_evict(osmium::item_type::way, way.id());
                     possibly_flush();
                 }
             }
@@ -539,10 +1014,93 @@ namespace osmium {
                         derived().relation_not_in_any_relation(relation);
                     }
                     derived().after_relation(relation);
+                    possibly_evict(osmium::item_type::relation, relation.id());
                     possibly_flush();
                 }
             }
 
+            /**
+             * Handle all objects in the buffer for the second pass. This
+             * does the same as feeding all objects in the buffer to the
+             * handler(), but uses several threads:
+             *
+             * 1. The members databases are searched for all objects in the
+             *    buffer in several threads. Each thread works on a range
+             *    of objects, which, for sorted input, is a range of ids.
+             * 2. The objects are added to the members databases in order
+             *    in the current thread. The before_*(), after_*() and
+             *    *_not_in_any_relation() functions are called here.
+             * 3. If the derived class has a member function
+             *    complete_relation(const osmium::Relation&, osmium::memory::Buffer&)
+             *    it is called for the relations completed by this buffer
+             *    in several threads. Each thread writes into its own buffer
+             *    and all of them are appended to the output in order of
+             *    the relations. This function must be safe to be called
+             *    from several threads at the same time. Otherwise
+             *    complete_relation(const osmium::Relation&) is called in
+             *    the current thread.
+             *
+             * Unlike with the handler() relations completed by an object
+             * are not handled right away, but after all objects in the
+             * buffer. This changes the order of the output.
+             *
+             * @param buffer Buffer with the objects.
+             * @param pool Thread pool to use.
+             */
+            void handle_buffer(const osmium::memory::Buffer& buffer, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                // Positions found by the lookups must stay valid until
+                // all objects are added, so compaction is only done here.
+                member_nodes_database().possibly_compact();
+                member_ways_database().possibly_compact();
+                member_relations_database().possibly_compact();
+
+                std::vector<const osmium::OSMObject*> objects;
+                for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                    if (wanted_type(object.type())) {
+                        objects.push_back(&object);
+                    }
+                }
+
+                std::vector<MembersDatabaseCommon::positions_type> positions(objects.size());
+                const auto lookup = [this, &objects, &positions](const std::size_t begin, const std::size_t end) {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        positions[i] = member_database(objects[i]->type()).lookup(objects[i]->id());
+                    }
+                };
+
+                const std::size_t num_shards = std::min(objects.size() / min_objects_per_shard, static_cast<std::size_t>(pool.num_threads()));
+                if (num_shards > 1) {
+                    std::vector<std::future<void>> futures;
+                    futures.reserve(num_shards);
+                    for (std::size_t n = 0; n < num_shards; ++n) {
+                        const std::size_t begin = objects.size() * n / num_shards;
+                        const std::size_t end = objects.size() * (n + 1) / num_shards;
+                        futures.push_back(pool.submit([&lookup, begin, end]() {
+                            lookup(begin, end);
+                        }));
+                    }
+                    wait_for_all(futures);
+                } else {
+                    lookup(0, objects.size());
+                }
+
+                std::vector<std::size_t> completed;
+                for (std::size_t i = 0; i < objects.size(); ++i) {
+                    handle_batched(*objects[i], positions[i], completed);
+                }
+
+                if (completed.empty()) {
+                    return;
+                }
+
+                complete_relations(completed, pool, typename detail::has_buffer_complete_relation<TManager>::type{});
+
+                for (const auto pos : completed) {
+                    auto rel_handle = relations_database()[pos];
+                    remove_relation(rel_handle);
+                }
+            }
+
             /**
              * Call this function it will call your function back for every
              * incomplete relation, that is all relations that have missing
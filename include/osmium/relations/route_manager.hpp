@@ -0,0 +1,386 @@
+#ifndef OSMIUM_RELATIONS_ROUTE_MANAGER_HPP
+#define OSMIUM_RELATIONS_ROUTE_MANAGER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/geom/factory.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/relations/relations_manager.hpp>
+#include <osmium/tags/taglist.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    namespace relations {
+
+        /**
+         * Merge the ways of a route into as few lines as possible. Ways
+         * are joined where an end of one way has the same location as an
+         * end of another way, reversing ways as needed. Lines are started
+         * with the first unused way in the order given, so for a well
+         * ordered route the lines run in the direction of the first way.
+         *
+         * Nodes with invalid locations and consecutive nodes with the
+         * same location are removed. Ways with less than two different
+         * locations are ignored.
+         *
+         * @param ways The member ways of the route.
+         * @returns Lines, each a vector of node refs.
+         */
+        inline std::vector<std::vector<osmium::NodeRef>> merge_route_ways(const std::vector<const osmium::Way*>& ways) {
+            std::vector<std::vector<osmium::NodeRef>> segments;
+            segments.reserve(ways.size());
+            for (const auto* way : ways) {
+                assert(way);
+                std::vector<osmium::NodeRef> nodes;
+                nodes.reserve(way->nodes().size());
+                for (const auto& node_ref : way->nodes()) {
+                    if (node_ref.location().valid() && (nodes.empty() || nodes.back().location() != node_ref.location())) {
+                        nodes.push_back(node_ref);
+                    }
+                }
+                if (nodes.size() >= 2) {
+                    segments.push_back(std::move(nodes));
+                }
+            }
+
+            // Map from the locations of the ends of all segments to the
+            // indexes of the segments in member order.
+            std::unordered_map<osmium::Location, std::vector<std::size_t>> ends;
+            ends.reserve(segments.size() * 2);
+            for (std::size_t n = 0; n < segments.size(); ++n) {
+                ends[segments[n].front().location()].push_back(n);
+                if (segments[n].back().location() != segments[n].front().location()) {
+                    ends[segments[n].back().location()].push_back(n);
+                }
+            }
+
+            std::vector<bool> used(segments.size(), false);
+
+            const auto extend = [&](std::vector<osmium::NodeRef>& line) {
+                while (true) {
+                    const auto it = ends.find(line.back().location());
+                    if (it == ends.end()) {
+                        return;
+                    }
+                    const auto next = std::find_if(it->second.cbegin(), it->second.cend(), [&used](std::size_t n) {
+                        return !used[n];
+                    });
+                    if (next == it->second.cend()) {
+                        return;
+                    }
+                    used[*next] = true;
+                    const auto& segment = segments[*next];
+                    if (segment.front().location() == line.back().location()) {
+                        line.insert(line.end(), std::next(segment.cbegin()), segment.cend());
+                    } else {
+                        line.insert(line.end(), std::next(segment.crbegin()), segment.crend());
+                    }
+                }
+            };
+
+            std::vector<std::vector<osmium::NodeRef>> lines;
+            for (std::size_t n = 0; n < segments.size(); ++n) {
+                if (used[n]) {
+                    continue;
+                }
+                used[n] = true;
+                std::vector<osmium::NodeRef> line{std::move(segments[n])};
+                extend(line);
+                std::reverse(line.begin(), line.end());
+                extend(line);
+                std::reverse(line.begin(), line.end());
+                lines.push_back(std::move(line));
+            }
+
+            return lines;
+        }
+
+        /**
+         * This class collects all data needed for creating linestring
+         * geometries from relations tagged with type=route. The member
+         * ways of each route are merged with merge_route_ways() and the
+         * result is handed as multilinestring created by the geometry
+         * factory to the callback together with the relation.
+         *
+         * Way members with a role starting with "platform" or "stop"
+         * are not part of the route geometry and are ignored.
+         *
+         * If handle_buffer() is used for the second pass, the routes
+         * completed by a buffer are built in several threads, each with
+         * its own copy of the geometry factory. The callback is always
+         * called from the thread calling the handler or handle_buffer(),
+         * in the order the relations were completed.
+         *
+         * @tparam TGeomFactory Geometry factory supporting multilinestrings,
+         *         for instance osmium::geom::WKTFactory<>. When used with
+         *         handle_buffer() the factory must not append to an
+         *         output string.
+         * @pre The Ids of all objects must be unique in the input data.
+         */
+        template <typename TGeomFactory>
+        class RouteManager : public RelationsManager<RouteManager<TGeomFactory>, false, true, false> {
+
+            using base_type = RelationsManager<RouteManager<TGeomFactory>, false, true, false>;
+
+        public:
+
+            using multilinestring_type = typename TGeomFactory::multilinestring_type;
+
+            using callback_type = std::function<void(const osmium::Relation&, multilinestring_type&&)>;
+
+        private:
+
+            // A route completed in handle_buffer(). The relation and its
+            // member ways are removed from the stash when the relation
+            // is complete, so they are copied into m_pending_buffer.
+            struct pending_route {
+                std::size_t relation_offset;
+                std::vector<std::size_t> way_offsets;
+            };
+
+            TGeomFactory m_factory;
+            callback_type m_callback;
+            osmium::TagsFilter m_filter;
+
+            osmium::memory::Buffer m_pending_buffer{base_type::initial_output_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+            std::vector<pending_route> m_pending;
+            bool m_collect_routes = false;
+
+            std::vector<const osmium::Way*> member_ways(const osmium::Relation& relation) const {
+                std::vector<const osmium::Way*> ways;
+                ways.reserve(relation.members().size());
+                for (const auto& member : relation.members()) {
+                    if (member.ref() != 0) {
+                        ways.push_back(this->get_member_way(member.ref()));
+                        assert(ways.back() != nullptr);
+                    }
+                }
+                return ways;
+            }
+
+            std::vector<const osmium::Way*> pending_ways(const pending_route& route) const {
+                std::vector<const osmium::Way*> ways;
+                ways.reserve(route.way_offsets.size());
+                for (const auto offset : route.way_offsets) {
+                    ways.push_back(&m_pending_buffer.get<const osmium::Way>(offset));
+                }
+                return ways;
+            }
+
+            static bool build_route(TGeomFactory& factory, const std::vector<const osmium::Way*>& ways, multilinestring_type& geometry) {
+                const auto lines = merge_route_ways(ways);
+                if (lines.empty()) {
+                    return false;
+                }
+                try {
+                    geometry = factory.create_multilinestring(lines);
+                } catch (const osmium::geometry_error&) {
+                    return false;
+                }
+                return true;
+            }
+
+            void clear_pending() {
+                m_pending.clear();
+                m_pending_buffer.clear();
+            }
+
+            void build_pending_routes(osmium::thread::Pool& pool) {
+                std::vector<multilinestring_type> geometries(m_pending.size());
+                std::vector<char> built(m_pending.size(), 0);
+
+                const std::size_t num_tasks = std::min(m_pending.size() / min_routes_per_task, static_cast<std::size_t>(pool.num_threads()) * 4);
+                if (num_tasks <= 1) {
+                    for (std::size_t n = 0; n < m_pending.size(); ++n) {
+                        built[n] = build_route(m_factory, pending_ways(m_pending[n]), geometries[n]);
+                    }
+                } else {
+                    const TGeomFactory& prototype = m_factory;
+                    std::vector<std::future<void>> futures;
+                    futures.reserve(num_tasks);
+                    for (std::size_t t = 0; t < num_tasks; ++t) {
+                        const std::size_t begin = m_pending.size() * t / num_tasks;
+                        const std::size_t end = m_pending.size() * (t + 1) / num_tasks;
+                        futures.push_back(pool.submit([this, &prototype, &geometries, &built, begin, end]() {
+                            TGeomFactory factory{prototype};
+                            for (std::size_t n = begin; n < end; ++n) {
+                                built[n] = build_route(factory, pending_ways(m_pending[n]), geometries[n]);
+                            }
+                        }));
+                    }
+                    for (auto& future : futures) {
+                        future.wait();
+                    }
+                    for (auto& future : futures) {
+                        future.get();
+                    }
+                }
+
+                for (std::size_t n = 0; n < m_pending.size(); ++n) {
+                    if (built[n]) {
+                        m_callback(m_pending_buffer.get<const osmium::Relation>(m_pending[n].relation_offset), std::move(geometries[n]));
+                    }
+                }
+            }
+
+        public:
+
+            /**
+             * Minimum number of routes per task when route geometries
+             * are built in several threads.
+             */
+            enum : std::size_t {
+                min_routes_per_task = 16
+            };
+
+            /**
+             * Construct a RouteManager.
+             *
+             * @param factory The geometry factory used to create the
+             *                multilinestrings.
+             * @param callback Called for each route with the relation and
+             *                 its geometry.
+             * @param filter An optional filter specifying what tags are
+             *               needed on route relations, for instance
+             *               "route=bus".
+             */
+            RouteManager(TGeomFactory factory, callback_type callback, osmium::TagsFilter filter = osmium::TagsFilter{true}) :
+                m_factory(std::move(factory)),
+                m_callback(std::move(callback)),
+                m_filter(std::move(filter)) {
+                m_filter.compile();
+            }
+
+            /**
+             * We are interested in all relations tagged with type=route
+             * matching the filter with at least one way member.
+             */
+            bool new_relation(const osmium::Relation& relation) const {
+                const char* type = relation.tags().get_value_by_key("type");
+                if (type == nullptr || std::strcmp(type, "route") != 0) {
+                    return false;
+                }
+
+                if (!osmium::tags::match_any_of(relation.tags(), m_filter)) {
+                    return false;
+                }
+
+                return std::any_of(relation.members().cbegin(), relation.members().cend(), [](const RelationMember& member) {
+                    return member.type() == osmium::item_type::way;
+                });
+            }
+
+            /**
+             * Only way members which are not platforms or stops are part
+             * of the route geometry.
+             */
+            bool new_member(const osmium::Relation& /*relation*/, const osmium::RelationMember& member, std::size_t /*n*/) const noexcept {
+                return std::strncmp(member.role(), "platform", 8) != 0 &&
+                       std::strncmp(member.role(), "stop", 4) != 0;
+            }
+
+            /**
+             * This is called when a relation is complete, ie. all members
+             * were found in the input. Routes for which no geometry can be
+             * built, for instance because none of the ways have valid
+             * locations, are ignored.
+             */
+            void complete_relation(const osmium::Relation& relation) {
+                if (m_collect_routes) {
+                    pending_route route{m_pending_buffer.committed(), {}};
+                    m_pending_buffer.add_item(relation);
+                    m_pending_buffer.commit();
+                    for (const auto* way : member_ways(relation)) {
+                        route.way_offsets.push_back(m_pending_buffer.committed());
+                        m_pending_buffer.add_item(*way);
+                        m_pending_buffer.commit();
+                    }
+                    m_pending.push_back(std::move(route));
+                    return;
+                }
+
+                multilinestring_type geometry;
+                if (build_route(m_factory, member_ways(relation), geometry)) {
+                    m_callback(relation, std::move(geometry));
+                }
+            }
+
+            /**
+             * Handle all objects in the buffer for the second pass using
+             * several threads. See RelationsManager::handle_buffer() for
+             * details. The geometries of the routes completed by this
+             * buffer are built in several threads afterwards and handed
+             * to the callback in order.
+             *
+             * @param buffer Buffer with the objects.
+             * @param pool Thread pool to use.
+             */
+            void handle_buffer(const osmium::memory::Buffer& buffer, osmium::thread::Pool& pool = osmium::thread::Pool::default_instance()) {
+                m_collect_routes = true;
+                try {
+                    base_type::handle_buffer(buffer, pool);
+                    m_collect_routes = false;
+                    build_pending_routes(pool);
+                } catch (...) {
+                    m_collect_routes = false;
+                    clear_pending();
+                    throw;
+                }
+                clear_pending();
+            }
+
+        }; // class RouteManager
+
+    } // namespace relations
+
+} // namespace osmium
+
+#endif // OSMIUM_RELATIONS_ROUTE_MANAGER_HPP
@@ -0,0 +1,545 @@
+#ifndef OSMIUM_STORAGE_COMPACT_OBJECT_STORE_HPP
+#define OSMIUM_STORAGE_COMPACT_OBJECT_STORE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/io/detail/string_table.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Pool of interned strings. Every distinct string is stored only
+         * once and gets a 32 bit id. Strings are never removed from the
+         * pool.
+         */
+        class string_pool {
+
+            enum : std::size_t {
+                chunk_size = 64UL * 1024UL
+            };
+
+            struct str_equal {
+
+                bool operator()(const char* lhs, const char* rhs) const noexcept {
+                    return lhs == rhs || std::strcmp(lhs, rhs) == 0;
+                }
+
+            }; // struct str_equal
+
+            osmium::io::detail::StringStore m_strings{chunk_size};
+            std::unordered_map<const char*, uint32_t, osmium::io::detail::djb2_hash, str_equal> m_index{};
+            std::vector<const char*> m_lookup{};
+
+        public:
+
+            string_pool() {
+                add("");
+            }
+
+            /// Add a string (if it isn't in the pool already) and return its id.
+            uint32_t add(const char* string) {
+                const auto it = m_index.find(string);
+                if (it != m_index.end()) {
+                    return it->second;
+                }
+
+                if (m_lookup.size() >= std::numeric_limits<uint32_t>::max()) {
+                    throw std::length_error{"too many strings in string pool"};
+                }
+
+                const char* copy = m_strings.add(string);
+                const auto id = static_cast<uint32_t>(m_lookup.size());
+                m_index.emplace(copy, id);
+                m_lookup.push_back(copy);
+                return id;
+            }
+
+            /// Get the string with the specified id.
+            const char* get(uint32_t id) const noexcept {
+                assert(id < m_lookup.size());
+                return m_lookup[id];
+            }
+
+            /// The number of strings in the pool.
+            std::size_t size() const noexcept {
+                return m_lookup.size();
+            }
+
+            std::size_t used_memory() const noexcept {
+                return m_strings.used_memory() +
+                       m_index.size() * (sizeof(const char*) + sizeof(uint32_t) + 2 * sizeof(void*)) +
+                       m_index.bucket_count() * sizeof(void*) +
+                       m_lookup.capacity() * sizeof(const char*);
+            }
+
+        }; // class string_pool
+
+    } // namespace detail
+
+    /**
+     * Compact storage for nodes, ways, and relations that are kept in
+     * memory for a long time. Keys and values of tags, user names, and
+     * relation member roles are interned into a string pool shared by all
+     * objects and stored as 32 bit ids, so strings like "building=yes"
+     * that appear in many objects take up the space only once.
+     *
+     * Objects are expanded back into normal OSMObjects when they are
+     * accessed with get() or copy_to(). This takes some time, so this
+     * store is for data that is kept for a long time but not accessed
+     * often, use an ItemStash otherwise.
+     *
+     * The space of removed objects is reclaimed by garbage collection,
+     * which happens automatically when enough objects were removed.
+     * Strings stay in the pool until the store is destroyed.
+     */
+    class CompactObjectStore {
+
+    public:
+
+        /**
+         * This is the type of the handle returned by the add() call. It is
+         * used to access the object again with get() or copy_to() or erase
+         * it with remove().
+         *
+         * The default constructor creates an invalid handle. Valid handles
+         * can only be constructed by the CompactObjectStore class.
+         */
+        class handle_type {
+
+            friend class CompactObjectStore;
+
+            std::size_t value; // NOLINT(modernize-use-default-member-init)
+
+            explicit handle_type(std::size_t new_value) noexcept :
+                value(new_value) {
+                assert(new_value > 0);
+            }
+
+        public:
+
+            /// The default constructor creates an invalid handle.
+            handle_type() noexcept :
+                value(0) {
+            }
+
+            /// Is this a valid handle?
+            bool valid() const noexcept {
+                return value != 0;
+            }
+
+            /**
+             * Print the handle for debugging purposes. An invalid handle
+             * will be printed as the single letter '-'.
+             */
+            template <typename TChar, typename TTraits>
+            friend inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const CompactObjectStore::handle_type& handle) {
+                if (handle.valid()) {
+                    out << handle.value;
+                } else {
+                    out << '-';
+                }
+                return out;
+            }
+
+        }; // class handle_type
+
+    private:
+
+        enum : std::size_t {
+            removed_object = std::numeric_limits<std::size_t>::max()
+        };
+
+        // Fixed part of every record. It is followed by the tags as pairs
+        // of string ids and the type specific data: the location for nodes,
+        // the node refs with their locations for ways, and the members with
+        // type, ref and role id for relations.
+        struct record_header {
+            uint32_t size;
+            uint32_t version;
+            osmium::object_id_type id;
+            uint32_t changeset;
+            uint32_t timestamp;
+            uint32_t uid;
+            uint32_t user;
+            uint32_t num_tags;
+            uint32_t num_list;
+            uint8_t type;
+            uint8_t visible;
+        };
+
+        detail::string_pool m_strings{};
+        std::string m_data{};
+        std::vector<std::size_t> m_index{};
+        std::size_t m_count_objects = 0;
+        std::size_t m_count_removed = 0;
+        std::size_t m_removed_bytes = 0;
+
+        // Buffer for expanding objects on access.
+        osmium::memory::Buffer m_expanded{1024, osmium::memory::Buffer::auto_grow::yes};
+
+        template <typename T>
+        void append(const T& value) {
+            m_data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        static T read(const char*& data) noexcept {
+            T value;
+            std::memcpy(&value, data, sizeof(T));
+            data += sizeof(T);
+            return value;
+        }
+
+        std::size_t get_offset(handle_type handle) const noexcept {
+            assert(handle.valid() && "handle must be valid");
+            assert(handle.value <= m_index.size());
+            const auto offset = m_index[handle.value - 1];
+            assert(offset != removed_object && "object was removed");
+            return offset;
+        }
+
+        // Garbage collect if at least half of the data is removed objects
+        // and there is a reasonable amount of it.
+        bool should_gc() const noexcept {
+            return m_removed_bytes > 1024UL * 1024UL && m_removed_bytes * 2 > m_data.size();
+        }
+
+        static uint32_t checked_count(std::size_t count) {
+            if (count > std::numeric_limits<uint32_t>::max()) {
+                throw std::length_error{"list too long for CompactObjectStore"};
+            }
+            return static_cast<uint32_t>(count);
+        }
+
+        void encode(const osmium::OSMObject& object) {
+            const auto start = m_data.size();
+
+            record_header header{};
+            header.version = object.version();
+            header.id = object.id();
+            header.changeset = object.changeset();
+            header.timestamp = static_cast<uint32_t>(object.timestamp());
+            header.uid = object.uid();
+            header.user = m_strings.add(object.user());
+            header.num_tags = checked_count(object.tags().size());
+            header.type = static_cast<uint8_t>(object.type());
+            header.visible = object.visible() ? 1 : 0;
+            if (object.type() == osmium::item_type::way) {
+                header.num_list = checked_count(static_cast<const osmium::Way&>(object).nodes().size());
+            } else if (object.type() == osmium::item_type::relation) {
+                header.num_list = checked_count(static_cast<const osmium::Relation&>(object).members().size());
+            }
+            append(header);
+
+            for (const auto& tag : object.tags()) {
+                append(m_strings.add(tag.key()));
+                append(m_strings.add(tag.value()));
+            }
+
+            switch (object.type()) {
+                case osmium::item_type::node: {
+                        const auto& location = static_cast<const osmium::Node&>(object).location();
+                        append(location.x());
+                        append(location.y());
+                    }
+                    break;
+                case osmium::item_type::way:
+                    for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                        append(node_ref.ref());
+                        append(node_ref.location().x());
+                        append(node_ref.location().y());
+                    }
+                    break;
+                default: // relation
+                    for (const auto& member : static_cast<const osmium::Relation&>(object).members()) {
+                        append(static_cast<uint8_t>(member.type()));
+                        append(member.ref());
+                        append(m_strings.add(member.role()));
+                    }
+                    break;
+            }
+
+            const auto size = checked_count(m_data.size() - start);
+            std::memcpy(&m_data[start], &size, sizeof(size));
+        }
+
+        template <typename TBuilder>
+        const char* decode_common(TBuilder& builder, const record_header& header, const char* data) const {
+            builder.set_id(header.id);
+            builder.set_version(header.version);
+            builder.set_changeset(header.changeset);
+            builder.set_timestamp(osmium::Timestamp{header.timestamp});
+            builder.set_uid(header.uid);
+            builder.set_visible(header.visible != 0);
+            builder.set_user(m_strings.get(header.user));
+
+            if (header.num_tags > 0) {
+                osmium::builder::TagListBuilder tl_builder{builder};
+                for (uint32_t i = 0; i < header.num_tags; ++i) {
+                    const auto key = read<uint32_t>(data);
+                    const auto value = read<uint32_t>(data);
+                    tl_builder.add_tag(m_strings.get(key), m_strings.get(value));
+                }
+            }
+
+            return data;
+        }
+
+        void decode(std::size_t offset, osmium::memory::Buffer& buffer) const {
+            const char* data = m_data.data() + offset;
+            const auto header = read<record_header>(data);
+
+            switch (static_cast<osmium::item_type>(header.type)) {
+                case osmium::item_type::node: {
+                        osmium::builder::NodeBuilder builder{buffer};
+                        data = decode_common(builder, header, data);
+                        const auto x = read<int32_t>(data);
+                        const auto y = read<int32_t>(data);
+                        builder.set_location(osmium::Location{x, y});
+                    }
+                    break;
+                case osmium::item_type::way: {
+                        osmium::builder::WayBuilder builder{buffer};
+                        data = decode_common(builder, header, data);
+                        osmium::builder::WayNodeListBuilder wnl_builder{builder};
+                        for (uint32_t i = 0; i < header.num_list; ++i) {
+                            const auto ref = read<osmium::object_id_type>(data);
+                            const auto x = read<int32_t>(data);
+                            const auto y = read<int32_t>(data);
+                            wnl_builder.add_node_ref(ref, osmium::Location{x, y});
+                        }
+                    }
+                    break;
+                default: { // relation
+                        osmium::builder::RelationBuilder builder{buffer};
+                        data = decode_common(builder, header, data);
+                        osmium::builder::RelationMemberListBuilder rml_builder{builder};
+                        for (uint32_t i = 0; i < header.num_list; ++i) {
+                            const auto type = static_cast<osmium::item_type>(read<uint8_t>(data));
+                            const auto ref = read<osmium::object_id_type>(data);
+                            const auto role = read<uint32_t>(data);
+                            rml_builder.add_member(type, ref, m_strings.get(role));
+                        }
+                    }
+                    break;
+            }
+
+            buffer.commit();
+        }
+
+        std::size_t record_size(std::size_t offset) const noexcept {
+            uint32_t size = 0;
+            std::memcpy(&size, m_data.data() + offset, sizeof(size));
+            return size;
+        }
+
+    public:
+
+        CompactObjectStore() = default;
+
+        /**
+         * Return an estimate of the number of bytes currently used by this
+         * store including the string pool.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t used_memory() const noexcept {
+            return sizeof(CompactObjectStore) +
+                   m_strings.used_memory() +
+                   m_data.capacity() +
+                   m_index.capacity() * sizeof(std::size_t) +
+                   m_expanded.capacity();
+        }
+
+        /**
+         * The number of objects currently in the store. This is the number
+         * added minus the number removed.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t size() const noexcept {
+            return m_count_objects;
+        }
+
+        /**
+         * The number of removed objects currently still taking up memory
+         * in the store. You can call garbage_collect() to remove them.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t count_removed() const noexcept {
+            return m_count_removed;
+        }
+
+        /// The number of distinct strings in the string pool.
+        std::size_t count_strings() const noexcept {
+            return m_strings.size();
+        }
+
+        /**
+         * Clear all objects from the store. All handles are invalidated.
+         * The string pool is kept, so strings added again later don't need
+         * new memory.
+         */
+        void clear() {
+            m_data.clear();
+            m_index.clear();
+            m_count_objects = 0;
+            m_count_removed = 0;
+            m_removed_bytes = 0;
+        }
+
+        /**
+         * Add a node, way, or relation to the store. Handles of other
+         * objects stay valid.
+         *
+         * @throws std::invalid_argument if the object is of another type.
+         *
+         * Complexity: Amortized linear in the size of the object.
+         */
+        handle_type add(const osmium::OSMObject& object) {
+            if (object.type() != osmium::item_type::node &&
+                object.type() != osmium::item_type::way &&
+                object.type() != osmium::item_type::relation) {
+                throw std::invalid_argument{"CompactObjectStore only stores nodes, ways, and relations"};
+            }
+
+            if (should_gc()) {
+                garbage_collect();
+            }
+
+            m_index.push_back(m_data.size());
+            encode(object);
+            ++m_count_objects;
+
+            return handle_type{m_index.size()};
+        }
+
+        /**
+         * Get a reference to the object referenced by the handle. The
+         * object is expanded into a buffer in the store, so the reference
+         * is only valid until the next call to get() or get<>().
+         *
+         * Complexity: Linear in the size of the object.
+         */
+        const osmium::OSMObject& get(handle_type handle) {
+            m_expanded.clear();
+            decode(get_offset(handle), m_expanded);
+            return *m_expanded.begin<osmium::OSMObject>();
+        }
+
+        /**
+         * Get a reference to the object referenced by the handle cast to
+         * the specified type (Node, Way, or Relation). The reference is
+         * only valid until the next call to get() or get<>().
+         *
+         * Complexity: Linear in the size of the object.
+         */
+        template <typename T>
+        const T& get(handle_type handle) {
+            return static_cast<const T&>(get(handle));
+        }
+
+        /**
+         * Expand the object referenced by the handle into the buffer.
+         *
+         * Complexity: Linear in the size of the object.
+         */
+        void copy_to(handle_type handle, osmium::memory::Buffer& buffer) const {
+            decode(get_offset(handle), buffer);
+        }
+
+        /**
+         * Remove the object referenced by the handle from the store. The
+         * handle is invalid afterwards.
+         *
+         * Complexity: Constant.
+         */
+        void remove(handle_type handle) {
+            m_removed_bytes += record_size(get_offset(handle));
+            m_index[handle.value - 1] = removed_object;
+            --m_count_objects;
+            ++m_count_removed;
+        }
+
+        /**
+         * Reclaim the space of all removed objects. All handles stay valid.
+         * This is done automatically by add() when at least half of the
+         * memory is used by removed objects.
+         *
+         * Complexity: Linear in the size of the store.
+         */
+        void garbage_collect() {
+            std::string data;
+            data.reserve(m_data.size() - m_removed_bytes);
+            for (auto& offset : m_index) {
+                if (offset != removed_object) {
+                    const auto new_offset = data.size();
+                    data.append(m_data, offset, record_size(offset));
+                    offset = new_offset;
+                }
+            }
+            m_data.swap(data);
+            m_count_removed = 0;
+            m_removed_bytes = 0;
+        }
+
+    }; // class CompactObjectStore
+
+} // namespace osmium
+
+#endif // OSMIUM_STORAGE_COMPACT_OBJECT_STORE_HPP
@@ -0,0 +1,670 @@
+#ifndef OSMIUM_STORAGE_HISTORY_STORE_HPP
+#define OSMIUM_STORAGE_HISTORY_STORE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/timestamp.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Stores all versions of OSM objects (nodes, ways, and relations)
+     * with much less memory than full copies of all of them. Only the
+     * latest version of each object is stored in full. Each earlier
+     * version is stored as the difference to the version after it:
+     * the changed metadata, the tags (mostly as references to the
+     * tags of the newer version), the changed part of the node or member
+     * list, and the location delta for nodes. Consecutive versions of
+     * an object usually differ in only a few places, so the differences
+     * are small.
+     *
+     * Full objects are rebuilt on demand with get_version() and
+     * get_versions(). Rebuilding version n of an object with m versions
+     * means applying m-n differences, so this is meant for analyses
+     * going through the versions of an object once, not for many random
+     * lookups of old versions.
+     *
+     * All versions of an object must be added one after the other in
+     * ascending version order, which is the order in OSM history files.
+     * Node locations in way node lists are kept.
+     */
+    class HistoryStore {
+
+        struct entry {
+            osmium::item_type type;
+            osmium::object_id_type id;
+            std::size_t object_offset;  // latest version in m_objects
+            std::size_t diff_offset;    // first diff in m_diffs
+            std::size_t num_versions;
+        };
+
+        enum diff_flags : uint32_t {
+            user_changed     = 1U << 0U,
+            tags_changed     = 1U << 1U,
+            list_changed     = 1U << 2U,
+            location_changed = 1U << 3U,
+            visible          = 1U << 4U,
+            with_locations   = 1U << 5U
+        };
+
+        osmium::memory::Buffer m_objects{1024UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        std::string m_diffs{};
+        std::vector<entry> m_entries{};
+
+        // Versions of the object currently being added.
+        osmium::memory::Buffer m_pending{64UL * 1024UL, osmium::memory::Buffer::auto_grow::yes};
+        std::vector<std::size_t> m_pending_offsets{};
+
+        std::size_t m_num_versions = 0;
+        bool m_sorted = true;
+
+        static void write_varint(std::string& out, uint64_t value) {
+            while (value >= 0x80U) {
+                out += static_cast<char>((value & 0x7fU) | 0x80U);
+                value >>= 7U;
+            }
+            out += static_cast<char>(value);
+        }
+
+        static void write_sint(std::string& out, int64_t value) {
+            write_varint(out, (static_cast<uint64_t>(value) << 1U) ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        static void write_string(std::string& out, const char* str) {
+            const auto length = std::strlen(str);
+            write_varint(out, length);
+            out.append(str, length);
+        }
+
+        static uint64_t read_varint(const char*& data) noexcept {
+            uint64_t value = 0;
+            unsigned int shift = 0;
+            while (true) {
+                const auto byte = static_cast<unsigned char>(*data++);
+                value |= static_cast<uint64_t>(byte & 0x7fU) << shift;
+                if ((byte & 0x80U) == 0) {
+                    return value;
+                }
+                shift += 7;
+            }
+        }
+
+        static int64_t read_sint(const char*& data) noexcept {
+            const uint64_t value = read_varint(data);
+            return static_cast<int64_t>(value >> 1U) ^ -static_cast<int64_t>(value & 1U);
+        }
+
+        static std::string read_string(const char*& data) {
+            const auto length = static_cast<std::size_t>(read_varint(data));
+            std::string result{data, length};
+            data += length;
+            return result;
+        }
+
+        static bool same_node_ref(const osmium::NodeRef& a, const osmium::NodeRef& b) noexcept {
+            return a.ref() == b.ref() && a.location() == b.location();
+        }
+
+        static bool same_member(const osmium::RelationMember& a, const osmium::RelationMember& b) noexcept {
+            return a.type() == b.type() && a.ref() == b.ref() && !std::strcmp(a.role(), b.role());
+        }
+
+        // Find the length of the common prefix and suffix of two ranges
+        // (not overlapping in the shorter one).
+        template <typename TIter, typename TEqual>
+        static std::pair<std::size_t, std::size_t> common_prefix_suffix(TIter a_begin, std::size_t a_size, TIter b_begin, std::size_t b_size, TEqual&& equal) {
+            std::vector<const typename std::iterator_traits<TIter>::value_type*> a;
+            std::vector<const typename std::iterator_traits<TIter>::value_type*> b;
+            a.reserve(a_size);
+            b.reserve(b_size);
+            for (std::size_t i = 0; i < a_size; ++i, ++a_begin) {
+                a.push_back(&*a_begin);
+            }
+            for (std::size_t i = 0; i < b_size; ++i, ++b_begin) {
+                b.push_back(&*b_begin);
+            }
+
+            const std::size_t max = std::min(a_size, b_size);
+            std::size_t prefix = 0;
+            while (prefix < max && equal(*a[prefix], *b[prefix])) {
+                ++prefix;
+            }
+            std::size_t suffix = 0;
+            while (suffix < max - prefix && equal(*a[a_size - 1 - suffix], *b[b_size - 1 - suffix])) {
+                ++suffix;
+            }
+            return std::make_pair(prefix, suffix);
+        }
+
+        static bool same_tags(const osmium::TagList& a, const osmium::TagList& b) noexcept {
+            if (a.byte_size() != b.byte_size()) {
+                return false;
+            }
+            return std::equal(a.cbegin(), a.cend(), b.cbegin(), [](const osmium::Tag& t1, const osmium::Tag& t2) {
+                return !std::strcmp(t1.key(), t2.key()) && !std::strcmp(t1.value(), t2.value());
+            });
+        }
+
+        // Tags are encoded as references to tags of the newer version
+        // where possible.
+        static void encode_tags(std::string& out, const osmium::TagList& older, const osmium::TagList& newer) {
+            write_varint(out, older.size());
+            for (const auto& tag : older) {
+                std::size_t index = 0;
+                std::size_t n = 1;
+                for (const auto& newer_tag : newer) {
+                    if (!std::strcmp(tag.key(), newer_tag.key()) && !std::strcmp(tag.value(), newer_tag.value())) {
+                        index = n;
+                        break;
+                    }
+                    ++n;
+                }
+                write_varint(out, index);
+                if (index == 0) {
+                    write_string(out, tag.key());
+                    write_string(out, tag.value());
+                }
+            }
+        }
+
+        static void encode_locations(std::string& out, const osmium::Location& location) {
+            write_sint(out, location.x());
+            write_sint(out, location.y());
+        }
+
+        static bool has_locations(const osmium::WayNodeList& nodes) noexcept {
+            return std::any_of(nodes.cbegin(), nodes.cend(), [](const osmium::NodeRef& nr) {
+                return !nr.location().is_undefined();
+            });
+        }
+
+        // Encode the older version of an object as difference to the
+        // newer version.
+        static void encode_diff(std::string& out, const osmium::OSMObject& older, const osmium::OSMObject& newer) {
+            uint32_t flags = older.visible() ? static_cast<uint32_t>(visible) : 0U;
+
+            if (std::strcmp(older.user(), newer.user())) {
+                flags |= user_changed;
+            }
+            if (!same_tags(older.tags(), newer.tags())) {
+                flags |= tags_changed;
+            }
+
+            std::pair<std::size_t, std::size_t> prefix_suffix{0, 0};
+            switch (older.type()) {
+                case osmium::item_type::node:
+                    if (static_cast<const osmium::Node&>(older).location() != static_cast<const osmium::Node&>(newer).location()) {
+                        flags |= location_changed;
+                    }
+                    break;
+                case osmium::item_type::way: {
+                        const auto& o = static_cast<const osmium::Way&>(older).nodes();
+                        const auto& n = static_cast<const osmium::Way&>(newer).nodes();
+                        prefix_suffix = common_prefix_suffix(o.cbegin(), o.size(), n.cbegin(), n.size(), same_node_ref);
+                        if (prefix_suffix.first + prefix_suffix.second != o.size() || o.size() != n.size()) {
+                            flags |= list_changed;
+                            if (has_locations(o)) {
+                                flags |= with_locations;
+                            }
+                        }
+                    }
+                    break;
+                default: { // relation
+                        const auto& o = static_cast<const osmium::Relation&>(older).members();
+                        const auto& n = static_cast<const osmium::Relation&>(newer).members();
+                        prefix_suffix = common_prefix_suffix(o.cbegin(), o.size(), n.cbegin(), n.size(), same_member);
+                        if (prefix_suffix.first + prefix_suffix.second != o.size() || o.size() != n.size()) {
+                            flags |= list_changed;
+                        }
+                    }
+                    break;
+            }
+
+            write_varint(out, flags);
+            write_sint(out, int64_t{newer.version()} - int64_t{older.version()});
+            write_sint(out, int64_t{newer.changeset()} - int64_t{older.changeset()});
+            write_sint(out, int64_t{newer.timestamp().seconds_since_epoch()} - int64_t{older.timestamp().seconds_since_epoch()});
+            write_sint(out, int64_t{newer.uid()} - int64_t{older.uid()});
+
+            if (flags & user_changed) {
+                write_string(out, older.user());
+            }
+            if (flags & tags_changed) {
+                encode_tags(out, older.tags(), newer.tags());
+            }
+            if (flags & location_changed) {
+                encode_locations(out, static_cast<const osmium::Node&>(older).location());
+            }
+            if (!(flags & list_changed)) {
+                return;
+            }
+
+            write_varint(out, prefix_suffix.first);
+            write_varint(out, prefix_suffix.second);
+            if (older.type() == osmium::item_type::way) {
+                const auto& nodes = static_cast<const osmium::Way&>(older).nodes();
+                const auto end = nodes.size() - prefix_suffix.second;
+                write_varint(out, end - prefix_suffix.first);
+                osmium::object_id_type last = 0;
+                for (std::size_t i = prefix_suffix.first; i < end; ++i) {
+                    write_sint(out, nodes[i].ref() - last);
+                    last = nodes[i].ref();
+                    if (flags & with_locations) {
+                        encode_locations(out, nodes[i].location());
+                    }
+                }
+            } else {
+                const auto& members = static_cast<const osmium::Relation&>(older).members();
+                const auto end = members.size() - prefix_suffix.second;
+                write_varint(out, end - prefix_suffix.first);
+                osmium::object_id_type last = 0;
+                std::size_t i = 0;
+                for (const auto& member : members) {
+                    if (i >= prefix_suffix.first && i < end) {
+                        out += osmium::item_type_to_char(member.type());
+                        write_sint(out, member.ref() - last);
+                        last = member.ref();
+                        write_string(out, member.role());
+                    }
+                    ++i;
+                }
+            }
+        }
+
+        template <typename TBuilder>
+        static void decode_tags(TBuilder& builder, const char*& data, const osmium::TagList& newer) {
+            std::vector<const osmium::Tag*> newer_tags;
+            newer_tags.reserve(newer.size());
+            for (const auto& tag : newer) {
+                newer_tags.push_back(&tag);
+            }
+
+            osmium::builder::TagListBuilder tl_builder{builder};
+            const auto count = read_varint(data);
+            for (uint64_t i = 0; i < count; ++i) {
+                const auto index = static_cast<std::size_t>(read_varint(data));
+                if (index == 0) {
+                    const std::string key{read_string(data)};
+                    const std::string value{read_string(data)};
+                    tl_builder.add_tag(key, value);
+                } else {
+                    tl_builder.add_tag(*newer_tags[index - 1]);
+                }
+            }
+        }
+
+        static osmium::Location decode_location(const char*& data) noexcept {
+            const auto x = static_cast<int32_t>(read_sint(data));
+            const auto y = static_cast<int32_t>(read_sint(data));
+            return osmium::Location{x, y};
+        }
+
+        template <typename TBuilder>
+        static void decode_common(TBuilder& builder, const osmium::OSMObject& newer, uint32_t flags, const char*& data, std::string& user) {
+            builder.set_id(newer.id());
+            builder.set_visible((flags & visible) != 0);
+            builder.set_version(static_cast<osmium::object_version_type>(int64_t{newer.version()} - read_sint(data)));
+            builder.set_changeset(static_cast<osmium::changeset_id_type>(int64_t{newer.changeset()} - read_sint(data)));
+            builder.set_timestamp(osmium::Timestamp{static_cast<uint32_t>(int64_t{newer.timestamp().seconds_since_epoch()} - read_sint(data))});
+            builder.set_uid(static_cast<osmium::user_id_type>(int64_t{newer.uid()} - read_sint(data)));
+            if (flags & user_changed) {
+                user = read_string(data);
+            } else {
+                user = newer.user();
+            }
+            builder.set_user(user);
+        }
+
+        // Rebuild the older version of an object from the newer version
+        // and the diff. The object is added to the buffer and committed.
+        static std::size_t decode_diff(osmium::memory::Buffer& buffer, const osmium::OSMObject& newer, const char*& data) {
+            const auto flags = static_cast<uint32_t>(read_varint(data));
+            std::string user;
+
+            switch (newer.type()) {
+                case osmium::item_type::node: {
+                        osmium::builder::NodeBuilder builder{buffer};
+                        decode_common(builder, newer, flags, data, user);
+                        const auto& node = static_cast<const osmium::Node&>(newer);
+                        builder.set_location((flags & location_changed) ? osmium::Location{} : node.location());
+                        if (flags & tags_changed) {
+                            decode_tags(builder, data, newer.tags());
+                        } else {
+                            builder.add_item(newer.tags());
+                        }
+                        if (flags & location_changed) {
+                            builder.set_location(decode_location(data));
+                        }
+                    }
+                    break;
+                case osmium::item_type::way: {
+                        osmium::builder::WayBuilder builder{buffer};
+                        decode_common(builder, newer, flags, data, user);
+                        if (flags & tags_changed) {
+                            decode_tags(builder, data, newer.tags());
+                        } else {
+                            builder.add_item(newer.tags());
+                        }
+                        const auto& nodes = static_cast<const osmium::Way&>(newer).nodes();
+                        if (flags & list_changed) {
+                            const auto prefix = static_cast<std::size_t>(read_varint(data));
+                            const auto suffix = static_cast<std::size_t>(read_varint(data));
+                            const auto count = read_varint(data);
+                            osmium::builder::WayNodeListBuilder wnl_builder{builder};
+                            for (std::size_t i = 0; i < prefix; ++i) {
+                                wnl_builder.add_node_ref(nodes[i]);
+                            }
+                            osmium::object_id_type last = 0;
+                            for (uint64_t i = 0; i < count; ++i) {
+                                last += read_sint(data);
+                                const osmium::Location location = (flags & with_locations) ? decode_location(data) : osmium::Location{};
+                                wnl_builder.add_node_ref(last, location);
+                            }
+                            for (std::size_t i = nodes.size() - suffix; i < nodes.size(); ++i) {
+                                wnl_builder.add_node_ref(nodes[i]);
+                            }
+                        } else {
+                            builder.add_item(nodes);
+                        }
+                    }
+                    break;
+                default: { // relation
+                        osmium::builder::RelationBuilder builder{buffer};
+                        decode_common(builder, newer, flags, data, user);
+                        if (flags & tags_changed) {
+                            decode_tags(builder, data, newer.tags());
+                        } else {
+                            builder.add_item(newer.tags());
+                        }
+                        const auto& members = static_cast<const osmium::Relation&>(newer).members();
+                        if (flags & list_changed) {
+                            const auto prefix = static_cast<std::size_t>(read_varint(data));
+                            const auto suffix = static_cast<std::size_t>(read_varint(data));
+                            const auto count = read_varint(data);
+                            osmium::builder::RelationMemberListBuilder rml_builder{builder};
+                            std::size_t i = 0;
+                            for (const auto& member : members) {
+                                if (i == prefix) {
+                                    break;
+                                }
+                                rml_builder.add_member(member.type(), member.ref(), member.role());
+                                ++i;
+                            }
+                            osmium::object_id_type last = 0;
+                            for (uint64_t j = 0; j < count; ++j) {
+                                const auto type = osmium::char_to_item_type(*data++);
+                                last += read_sint(data);
+                                const std::string role{read_string(data)};
+                                rml_builder.add_member(type, last, role);
+                            }
+                            i = 0;
+                            for (const auto& member : members) {
+                                if (i >= members.size() - suffix) {
+                                    rml_builder.add_member(member.type(), member.ref(), member.role());
+                                }
+                                ++i;
+                            }
+                        } else {
+                            builder.add_item(members);
+                        }
+                    }
+                    break;
+            }
+
+            return buffer.commit();
+        }
+
+        void finish_pending() {
+            if (m_pending_offsets.empty()) {
+                return;
+            }
+
+            const auto& latest = m_pending.get<osmium::OSMObject>(m_pending_offsets.back());
+            entry e{latest.type(), latest.id(), m_objects.committed(), m_diffs.size(), m_pending_offsets.size()};
+            m_objects.add_item(latest);
+            m_objects.commit();
+
+            for (std::size_t i = m_pending_offsets.size() - 1; i > 0; --i) {
+                encode_diff(m_diffs,
+                            m_pending.get<osmium::OSMObject>(m_pending_offsets[i - 1]),
+                            m_pending.get<osmium::OSMObject>(m_pending_offsets[i]));
+            }
+
+            if (!m_entries.empty() && !less(m_entries.back(), e)) {
+                m_sorted = false;
+            }
+            m_entries.push_back(e);
+
+            m_pending.clear();
+            m_pending_offsets.clear();
+        }
+
+        static bool less(const entry& a, const entry& b) noexcept {
+            return std::make_pair(a.type, a.id) < std::make_pair(b.type, b.id);
+        }
+
+        const entry* find(osmium::item_type type, osmium::object_id_type id) {
+            finish_pending();
+            if (!m_sorted) {
+                std::sort(m_entries.begin(), m_entries.end(), less);
+                const auto it = std::adjacent_find(m_entries.cbegin(), m_entries.cend(), [](const entry& a, const entry& b) {
+                    return a.type == b.type && a.id == b.id;
+                });
+                if (it != m_entries.cend()) {
+                    throw std::runtime_error{"HistoryStore: versions of an object must be added one after the other"};
+                }
+                m_sorted = true;
+            }
+
+            const entry key{type, id, 0, 0, 0};
+            const auto it = std::lower_bound(m_entries.cbegin(), m_entries.cend(), key, less);
+            if (it == m_entries.cend() || it->type != type || it->id != id) {
+                return nullptr;
+            }
+            return &*it;
+        }
+
+    public:
+
+        HistoryStore() = default;
+
+        /**
+         * Add a version of an object. Versions of an object must be
+         * added one after the other in ascending order. Only nodes, ways,
+         * and relations are supported.
+         *
+         * @throws std::invalid_argument If the object is not a node, way,
+         *         or relation or if its version is not larger than the
+         *         version added before for the same object.
+         */
+        void add(const osmium::OSMObject& object) {
+            if (object.type() != osmium::item_type::node &&
+                object.type() != osmium::item_type::way &&
+                object.type() != osmium::item_type::relation) {
+                throw std::invalid_argument{"HistoryStore only stores nodes, ways, and relations"};
+            }
+
+            if (!m_pending_offsets.empty()) {
+                const auto& last = m_pending.get<osmium::OSMObject>(m_pending_offsets.back());
+                if (last.type() != object.type() || last.id() != object.id()) {
+                    finish_pending();
+                } else if (last.version() >= object.version()) {
+                    throw std::invalid_argument{"HistoryStore: versions must be added in ascending order"};
+                }
+            }
+
+            m_pending_offsets.push_back(m_pending.committed());
+            m_pending.add_item(object);
+            m_pending.commit();
+            ++m_num_versions;
+        }
+
+        /// The number of objects stored.
+        std::size_t size() const noexcept {
+            return m_entries.size() + (m_pending_offsets.empty() ? 0 : 1);
+        }
+
+        /// The number of versions of all objects stored.
+        std::size_t num_versions() const noexcept {
+            return m_num_versions;
+        }
+
+        /// The number of versions of the specified object.
+        std::size_t num_versions(osmium::item_type type, osmium::object_id_type id) {
+            const entry* e = find(type, id);
+            return e ? e->num_versions : 0;
+        }
+
+        /**
+         * The latest version of the specified object or nullptr if it is
+         * not in the store. The pointer is valid until the next call to
+         * add().
+         */
+        const osmium::OSMObject* latest(osmium::item_type type, osmium::object_id_type id) {
+            const entry* e = find(type, id);
+            return e ? &m_objects.get<osmium::OSMObject>(e->object_offset) : nullptr;
+        }
+
+        /**
+         * Rebuild all versions of the specified object and add them to
+         * the buffer in ascending version order.
+         *
+         * @returns The number of versions added to the buffer.
+         */
+        std::size_t get_versions(osmium::item_type type, osmium::object_id_type id, osmium::memory::Buffer& buffer) {
+            const entry* e = find(type, id);
+            if (!e) {
+                return 0;
+            }
+
+            // Rebuild from the newest to the oldest version, then copy
+            // into the output in the opposite order.
+            osmium::memory::Buffer tmp{1024, osmium::memory::Buffer::auto_grow::yes};
+            std::vector<std::size_t> offsets;
+            offsets.reserve(e->num_versions);
+            tmp.add_item(m_objects.get<osmium::OSMObject>(e->object_offset));
+            offsets.push_back(tmp.commit());
+
+            osmium::memory::Buffer current{1024, osmium::memory::Buffer::auto_grow::yes};
+            current.add_item(m_objects.get<osmium::OSMObject>(e->object_offset));
+            current.commit();
+
+            const char* data = m_diffs.data() + e->diff_offset;
+            for (std::size_t i = 1; i < e->num_versions; ++i) {
+                osmium::memory::Buffer older{1024, osmium::memory::Buffer::auto_grow::yes};
+                decode_diff(older, *current.begin<osmium::OSMObject>(), data);
+                offsets.push_back(tmp.committed());
+                tmp.add_item(*older.begin<osmium::OSMObject>());
+                tmp.commit();
+                using std::swap;
+                swap(current, older);
+            }
+
+            for (auto it = offsets.crbegin(); it != offsets.crend(); ++it) {
+                buffer.add_item(tmp.get<osmium::OSMObject>(*it));
+                buffer.commit();
+            }
+
+            return e->num_versions;
+        }
+
+        /**
+         * Rebuild the specified version of an object and add it to the
+         * buffer.
+         *
+         * @returns true if the object was found, false otherwise.
+         */
+        bool get_version(osmium::item_type type, osmium::object_id_type id, osmium::object_version_type version, osmium::memory::Buffer& buffer) {
+            const entry* e = find(type, id);
+            if (!e) {
+                return false;
+            }
+
+            osmium::memory::Buffer current{1024, osmium::memory::Buffer::auto_grow::yes};
+            current.add_item(m_objects.get<osmium::OSMObject>(e->object_offset));
+            current.commit();
+
+            const char* data = m_diffs.data() + e->diff_offset;
+            for (std::size_t i = 1; i < e->num_versions && current.begin<osmium::OSMObject>()->version() > version; ++i) {
+                osmium::memory::Buffer older{1024, osmium::memory::Buffer::auto_grow::yes};
+                decode_diff(older, *current.begin<osmium::OSMObject>(), data);
+                using std::swap;
+                swap(current, older);
+            }
+
+            const auto& object = *current.begin<osmium::OSMObject>();
+            if (object.version() != version) {
+                return false;
+            }
+            buffer.add_item(object);
+            buffer.commit();
+            return true;
+        }
+
+        /**
+         * The approximate number of bytes used for storing the objects.
+         */
+        std::size_t used_memory() const noexcept {
+            return m_objects.capacity() + m_diffs.capacity() +
+                   m_entries.capacity() * sizeof(entry) +
+                   m_pending.capacity() + m_pending_offsets.capacity() * sizeof(std::size_t);
+        }
+
+    }; // class HistoryStore
+
+} // namespace osmium
+
+#endif // OSMIUM_STORAGE_HISTORY_STORE_HPP
@@ -33,15 +33,31 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/io/detail/read_write.hpp>
 #include <osmium/memory/buffer.hpp>
 #include <osmium/memory/item.hpp>
+#include <osmium/util/memory_mapping.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
+#include <deque>
 #include <limits>
+#include <memory>
 #include <ostream>
+#include <system_error>
+#include <utility>
 #include <vector>
 
+#ifndef _WIN32
+# include <unistd.h>
+#else
+# include <io.h>
+#endif
+
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
 # include <iostream>
 # include <chrono>
@@ -49,10 +65,117 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Temporary file used by the ItemStash to spill segments to. The
+         * file is created lazily and closed (and thereby removed) in the
+         * destructor. Space of segments that are compacted or freed is
+         * reused for later spills.
+         */
+        class item_stash_spill_file {
+
+            int m_fd = -1;
+            std::size_t m_size = 0;
+            std::vector<std::pair<std::size_t, std::size_t>> m_free; // offset, size
+
+        public:
+
+            item_stash_spill_file() = default;
+
+            item_stash_spill_file(const item_stash_spill_file&) = delete;
+            item_stash_spill_file& operator=(const item_stash_spill_file&) = delete;
+
+            item_stash_spill_file(item_stash_spill_file&&) = delete;
+            item_stash_spill_file& operator=(item_stash_spill_file&&) = delete;
+
+            ~item_stash_spill_file() noexcept {
+                if (m_fd >= 0) {
+                    try {
+                        osmium::io::detail::reliable_close(m_fd);
+                    } catch (...) {
+                        // Ignore any exceptions because destructor must not throw.
+                    }
+                }
+            }
+
+            std::size_t size() const noexcept {
+                return m_size;
+            }
+
+            /**
+             * Reserve a region in the file, reusing the space of released
+             * regions if possible.
+             *
+             * @param region_size Size of the region, a multiple of the
+             *                    spill alignment.
+             * @returns Offset of the region in the file.
+             */
+            std::size_t allocate(std::size_t region_size) {
+                const auto it = std::find_if(m_free.begin(), m_free.end(), [region_size](const std::pair<std::size_t, std::size_t>& region) {
+                    return region.second >= region_size;
+                });
+                if (it == m_free.end()) {
+                    const auto offset = m_size;
+                    m_size += region_size;
+                    return offset;
+                }
+                const auto offset = it->first;
+                if (it->second == region_size) {
+                    m_free.erase(it);
+                } else {
+                    it->first += region_size;
+                    it->second -= region_size;
+                }
+                return offset;
+            }
+
+            /**
+             * Write data into a region of the file and map the region into
+             * memory. The data is written with write() instead of being
+             * copied into the mapping, so it doesn't count towards the
+             * resident memory of the process until it is accessed.
+             */
+            osmium::util::MemoryMapping write(std::size_t offset, std::size_t region_size, const unsigned char* data, std::size_t size) {
+                if (m_fd < 0) {
+                    m_fd = osmium::detail::create_tmp_file();
+                }
+
+#ifdef _MSC_VER
+                const auto pos = _lseeki64(m_fd, static_cast<__int64>(offset), SEEK_SET);
+#else
+                const auto pos = ::lseek(m_fd, static_cast<off_t>(offset), SEEK_SET);
+#endif
+                if (pos == -1) {
+                    throw std::system_error{errno, std::system_category(), "lseek failed"};
+                }
+                osmium::io::detail::reliable_write(m_fd, data, size);
+
+                return osmium::util::MemoryMapping{region_size, osmium::util::MemoryMapping::mapping_mode::write_shared, m_fd, static_cast<off_t>(offset)};
+            }
+
+            /// Mark a region of the file as unused.
+            void release(std::size_t offset, std::size_t size) {
+                m_free.emplace_back(offset, size);
+            }
+
+        }; // class item_stash_spill_file
+
+    } // namespace detail
+
     /**
      * Class for storing OSM data in memory. Any osmium::memory::Item can be
      * added to the stash and it will be copied into its internal Buffer. To
      * access the item again, an opaque handle is used.
+     *
+     * By default all items are stored in one growing Buffer which is
+     * garbage collected as a whole from time to time. If a segment_size
+     * is set in the config, items are stored in fixed-size segments
+     * instead. Segments where at least half of the data was removed are
+     * compacted one at a time by add_item(), so there is never a long
+     * pause for garbage collection. Segmented stashes can optionally spill
+     * full segments, except for the most recent ones, to a memory-mapped
+     * temporary file, so the operating system can page them out.
      */
     class ItemStash {
 
@@ -113,62 +236,140 @@ namespace osmium {
 
         }; // class handle_type
 
+        /**
+         * Configuration for the ItemStash.
+         */
+        struct config {
+
+            /**
+             * Size of the buffer segments in bytes. Items larger than this
+             * get a segment of their own. If this is 0 (the default), all
+             * items are stored in one growing buffer which is garbage
+             * collected as a whole.
+             */
+            std::size_t segment_size = 0;
+
+            /**
+             * Spill full segments to a memory-mapped temporary file. Only
+             * used if segment_size is set.
+             */
+            bool spill = false;
+
+            /**
+             * Number of full segments kept in memory when spilling. Older
+             * segments are spilled.
+             */
+            std::size_t hot_segments = 4;
+
+        }; // struct config
+
     private:
 
         enum {
             initial_buffer_size = 1024ul * 1024ul
         };
 
-        enum {
-            removed_item_offset = std::numeric_limits<std::size_t>::max()
+        // Locations in the index are stored as the segment number in the
+        // upper bits and the offset into the segment in the lower bits.
+        using location_type = std::uint64_t;
+
+        enum : location_type {
+            removed_item_offset = std::numeric_limits<location_type>::max()
+        };
+
+        enum : location_type {
+            segment_shift = 40,
+            offset_mask = (1ULL << segment_shift) - 1
+        };
+
+        // Spilled segments are aligned in the file to this many bytes,
+        // which is a multiple of the page size and of the allocation
+        // granularity on Windows.
+        enum : std::size_t {
+            spill_alignment = 64ul * 1024ul
         };
 
-        osmium::memory::Buffer m_buffer;
-        std::vector<std::size_t> m_index;
+        struct segment {
+
+            osmium::memory::Buffer buffer{};
+
+            // Set if the segment is spilled, buffer points into it then.
+            std::unique_ptr<osmium::util::MemoryMapping> mapping{};
+            std::size_t spill_offset = 0;
+
+            // Range of positions in m_index referring to this segment.
+            std::size_t first_index = 0;
+            std::size_t end_index = 0;
+
+            std::size_t count_removed = 0;
+            std::size_t removed_bytes = 0;
+
+            bool queued = false;
+
+        }; // struct segment
+
+        config m_config{};
+        std::vector<segment> m_segments{};
+        std::vector<location_type> m_index{};
+        std::deque<std::size_t> m_compact_queue{};
+        std::unique_ptr<detail::item_stash_spill_file> m_spill_file{};
         std::size_t m_count_items = 0;
         std::size_t m_count_removed = 0;
+        std::size_t m_full_segments_memory = 0;
+        std::size_t m_spilled_segments = 0;
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
         int64_t m_gc_time = 0;
 #endif
 
         class cleanup_helper {
 
-            std::vector<std::size_t>& m_index;
-            std::size_t m_pos = 0;
+            std::vector<location_type>& m_index;
+            location_type m_segment;
+            std::size_t m_pos;
 
         public:
 
-            explicit cleanup_helper(std::vector<std::size_t>& index) :
-                m_index(index) {
+            cleanup_helper(std::vector<location_type>& index, std::size_t segment, std::size_t pos) :
+                m_index(index),
+                m_segment(static_cast<location_type>(segment) << segment_shift),
+                m_pos(pos) {
             }
 
             void moving_in_buffer(std::size_t old_offset, std::size_t new_offset) {
-                while (m_index[m_pos] != old_offset) {
+                while (m_index[m_pos] != (m_segment | old_offset)) {
                     ++m_pos;
                     assert(m_pos < m_index.size());
                 }
-                m_index[m_pos] = new_offset;
+                m_index[m_pos] = m_segment | new_offset;
                 ++m_pos;
             }
 
         }; // cleanup_helper
 
-        std::size_t& get_item_offset_ref(handle_type handle) noexcept {
-            assert(handle.valid() && "handle must be valid");
-            assert(handle.value <= m_index.size());
-            auto& offset = m_index[handle.value - 1];
-            assert(offset != removed_item_offset);
-            assert(offset < m_buffer.committed());
-            return offset;
+        static location_type make_location(std::size_t num, std::size_t offset) noexcept {
+            return (static_cast<location_type>(num) << segment_shift) | offset;
+        }
+
+        static std::size_t segment_num(location_type location) noexcept {
+            return static_cast<std::size_t>(location >> segment_shift);
         }
 
-        std::size_t get_item_offset(handle_type handle) const noexcept {
+        static std::size_t segment_offset(location_type location) noexcept {
+            return static_cast<std::size_t>(location & offset_mask);
+        }
+
+        bool segmented() const noexcept {
+            return m_config.segment_size != 0;
+        }
+
+        location_type get_item_location(handle_type handle) const noexcept {
             assert(handle.valid() && "handle must be valid");
             assert(handle.value <= m_index.size());
-            const auto& offset = m_index[handle.value - 1];
-            assert(offset != removed_item_offset);
-            assert(offset < m_buffer.committed());
-            return offset;
+            const auto location = m_index[handle.value - 1];
+            assert(location != removed_item_offset);
+            assert(segment_num(location) < m_segments.size());
+            assert(segment_offset(location) < m_segments[segment_num(location)].buffer.committed());
+            return location;
         }
 
         // This function decides whether it makes sense to garbage collect the
@@ -190,25 +391,173 @@ namespace osmium {
             if (m_count_removed * 5 < m_count_items) { // *3
                 return false;
             }
-            return m_buffer.capacity() - m_buffer.committed() < 10 * 1024; // *4
+            const auto& buffer = m_segments.back().buffer;
+            return buffer.capacity() - buffer.committed() < 10 * 1024; // *4
+        }
+
+        // Full segments where at least half of the data was removed are
+        // queued for compaction.
+        void check_compact(std::size_t num) {
+            auto& seg = m_segments[num];
+            if (!seg.queued && num + 1 != m_segments.size() &&
+                seg.removed_bytes > 0 && seg.removed_bytes * 2 >= seg.buffer.committed()) {
+                seg.queued = true;
+                m_compact_queue.push_back(num);
+            }
+        }
+
+        void spill_segment(segment& seg) {
+            if (!m_spill_file) {
+                m_spill_file.reset(new detail::item_stash_spill_file{});
+            }
+            const auto committed = seg.buffer.committed();
+            const auto region_size = (committed + spill_alignment - 1) / spill_alignment * spill_alignment;
+            m_full_segments_memory -= seg.buffer.capacity();
+            seg.spill_offset = m_spill_file->allocate(region_size);
+            seg.mapping.reset(new osmium::util::MemoryMapping{m_spill_file->write(seg.spill_offset, region_size, seg.buffer.data(), committed)});
+            seg.buffer = osmium::memory::Buffer{seg.mapping->get_addr<unsigned char>(), region_size, committed};
+        }
+
+        void release_segment_memory(segment& seg) {
+            if (seg.mapping) {
+                seg.buffer = osmium::memory::Buffer{};
+                m_spill_file->release(seg.spill_offset, seg.mapping->size());
+                seg.mapping.reset();
+            } else {
+                m_full_segments_memory -= seg.buffer.capacity();
+                seg.buffer = osmium::memory::Buffer{};
+            }
+        }
+
+        void start_segment(std::size_t min_size) {
+            if (!m_segments.empty()) {
+                check_compact(m_segments.size() - 1);
+                m_full_segments_memory += m_segments.back().buffer.capacity();
+            }
+
+            m_segments.emplace_back();
+            auto& seg = m_segments.back();
+            seg.buffer = osmium::memory::Buffer{std::max(m_config.segment_size, min_size), osmium::memory::Buffer::auto_grow::no};
+            seg.first_index = m_index.size();
+            seg.end_index = m_index.size();
+
+            if (m_config.spill) {
+                while (m_spilled_segments + 1 + m_config.hot_segments < m_segments.size()) {
+                    auto& old_seg = m_segments[m_spilled_segments++];
+                    if (old_seg.buffer.committed() > 0) {
+                        spill_segment(old_seg);
+                    } else if (old_seg.buffer) {
+                        release_segment_memory(old_seg);
+                    }
+                }
+            }
+        }
+
+        void compact_segment(std::size_t num) {
+            auto& seg = m_segments[num];
+            seg.queued = false;
+            if (seg.count_removed == 0) {
+                return;
+            }
+
+            m_count_removed -= seg.count_removed;
+            const auto live_bytes = seg.buffer.committed() - seg.removed_bytes;
+            seg.count_removed = 0;
+            seg.removed_bytes = 0;
+
+            if (live_bytes == 0) {
+                release_segment_memory(seg);
+                return;
+            }
+
+            osmium::memory::Buffer buffer{live_bytes, osmium::memory::Buffer::auto_grow::no};
+            for (std::size_t i = seg.first_index; i < seg.end_index; ++i) {
+                auto& location = m_index[i];
+                if (location != removed_item_offset) {
+                    const auto offset = buffer.committed();
+                    buffer.add_item(seg.buffer.get<osmium::memory::Item>(segment_offset(location)));
+                    buffer.commit();
+                    location = make_location(num, offset);
+                }
+            }
+
+            const bool spilled = static_cast<bool>(seg.mapping);
+            release_segment_memory(seg);
+            seg.buffer = std::move(buffer);
+            m_full_segments_memory += seg.buffer.capacity();
+            if (spilled) {
+                spill_segment(seg);
+            }
+        }
+
+        void init() {
+            if (segmented()) {
+                start_segment(0);
+            } else {
+                m_segments.emplace_back();
+                m_segments.back().buffer = osmium::memory::Buffer{initial_buffer_size, osmium::memory::Buffer::auto_grow::yes};
+            }
+        }
+
+        void reset() {
+            m_segments.clear();
+            m_index.clear();
+            m_compact_queue.clear();
+            m_spill_file.reset();
+            m_count_items = 0;
+            m_count_removed = 0;
+            m_full_segments_memory = 0;
+            m_spilled_segments = 0;
         }
 
     public:
 
-        ItemStash() :
-            m_buffer(initial_buffer_size, osmium::memory::Buffer::auto_grow::yes) {
+        ItemStash() {
+            init();
+        }
+
+        explicit ItemStash(const config& cfg) :
+            m_config(cfg) {
+            init();
+        }
+
+        /**
+         * Change the configuration. This removes all items from the stash
+         * and invalidates all handles.
+         */
+        void configure(const config& cfg) {
+            reset();
+            m_config = cfg;
+            init();
+        }
+
+        /// The current configuration.
+        const config& get_config() const noexcept {
+            return m_config;
         }
 
         /**
          * Return an estimate of the number of bytes currently used by this
-         * ItemStash instance.
+         * ItemStash instance. This doesn't include spilled segments, see
+         * spilled_memory() for those.
          *
          * Complexity: Constant.
          */
         std::size_t used_memory() const noexcept {
             return sizeof(ItemStash) +
-                   m_buffer.capacity() +
-                   m_index.capacity() * sizeof(std::size_t);
+                   m_full_segments_memory +
+                   m_segments.back().buffer.capacity() +
+                   m_segments.capacity() * sizeof(segment) +
+                   m_index.capacity() * sizeof(location_type);
+        }
+
+        /**
+         * Return the size of the temporary file used for spilled segments.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t spilled_memory() const noexcept {
+            return m_spill_file ? m_spill_file->size() : 0;
         }
 
         /**
@@ -231,12 +580,27 @@ namespace osmium {
             return m_count_removed;
         }
 
+        /**
+         * The number of segments waiting to be compacted. This is always
+         * 0 for non-segmented stashes.
+         *
+         * Complexity: Constant.
+         */
+        std::size_t count_pending_segments() const noexcept {
+            return m_compact_queue.size();
+        }
+
         /**
          * Clear all items from the stash. This will not necessarily release
          * any memory. All handles are invalidated.
          */
         void clear() {
-            m_buffer.clear();
+            if (segmented()) {
+                reset();
+                init();
+                return;
+            }
+            m_segments.back().buffer.clear();
             m_index.clear();
             m_count_items = 0;
             m_count_removed = 0;
@@ -246,17 +610,31 @@ namespace osmium {
          * Add an item to the stash. This will invalidate any pointers and
          * references into the stash, but handles are still valid.
          *
+         * In segmented stashes this compacts at most one segment.
+         *
          * Complexity: Amortized constant.
          */
         handle_type add_item(const osmium::memory::Item& item) {
-            if (should_gc()) {
+            if (segmented()) {
+                if (!m_compact_queue.empty()) {
+                    const auto num = m_compact_queue.front();
+                    m_compact_queue.pop_front();
+                    compact_segment(num);
+                }
+                const auto& buffer = m_segments.back().buffer;
+                if (buffer.capacity() - buffer.committed() < item.padded_size()) {
+                    start_segment(item.padded_size());
+                }
+            } else if (should_gc()) {
                 garbage_collect();
             }
             ++m_count_items;
-            const auto offset = m_buffer.committed();
-            m_buffer.add_item(item);
-            m_buffer.commit();
-            m_index.push_back(offset);
+            auto& seg = m_segments.back();
+            const auto offset = seg.buffer.committed();
+            seg.buffer.add_item(item);
+            seg.buffer.commit();
+            m_index.push_back(make_location(m_segments.size() - 1, offset));
+            seg.end_index = m_index.size();
             return handle_type{m_index.size()};
         }
 
@@ -272,7 +650,8 @@ namespace osmium {
          *      item.
          */
         osmium::memory::Item& get_item(handle_type handle) const {
-            return m_buffer.get<osmium::memory::Item>(get_item_offset(handle));
+            const auto location = get_item_location(handle);
+            return m_segments[segment_num(location)].buffer.get<osmium::memory::Item>(segment_offset(location));
         }
 
         /**
@@ -297,22 +676,35 @@ namespace osmium {
 
         /**
          * Garbage collect the memory used by the ItemStash. This will free up
-         * memory for adding new items. No memory is actually returned to the
-         * OS. Usually you do not need to call this, because add_item() will
-         * call it for you as necessary.
+         * memory for adding new items. Usually you do not need to call this,
+         * because add_item() will call it for you as necessary.
+         *
+         * Non-segmented stashes don't return any memory to the OS.
+         * Segmented stashes compact all segments with removed items.
          *
          * Complexity: Linear in size() + count_removed().
          */
         void garbage_collect() {
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
-            std::cerr << "GC items=" << m_count_items << " removed=" << m_count_removed << " buffer.committed=" << m_buffer.committed() << " buffer.capacity=" << m_buffer.capacity() << "\n";
+            std::cerr << "GC items=" << m_count_items << " removed=" << m_count_removed << " segments=" << m_segments.size() << " used_memory=" << used_memory() << "\n";
             using clock = std::chrono::high_resolution_clock;
             std::chrono::time_point<clock> start = clock::now();
 #endif
 
-            m_count_removed = 0;
-            cleanup_helper helper{m_index};
-            m_buffer.purge_removed(&helper);
+            const auto last = m_segments.size() - 1;
+            for (std::size_t num = 0; num < last; ++num) {
+                compact_segment(num);
+            }
+            m_compact_queue.clear();
+
+            // The last segment is purged in place so new items can still
+            // be added to it.
+            auto& seg = m_segments.back();
+            m_count_removed -= seg.count_removed;
+            seg.count_removed = 0;
+            seg.removed_bytes = 0;
+            cleanup_helper helper{m_index, last, seg.first_index};
+            seg.buffer.purge_removed(&helper);
 
 #ifdef OSMIUM_ITEM_STORAGE_GC_DEBUG
             std::chrono::time_point<clock> stop = clock::now();
@@ -336,13 +728,20 @@ namespace osmium {
          *      item.
          */
         void remove_item(handle_type handle) {
-            auto& offset = get_item_offset_ref(handle);
-            auto& item = m_buffer.get<osmium::memory::Item>(offset);
+            const auto location = get_item_location(handle);
+            const auto num = segment_num(location);
+            auto& seg = m_segments[num];
+            auto& item = seg.buffer.get<osmium::memory::Item>(segment_offset(location));
             assert(!item.removed() && "can not call remove_item() on already removed item");
             item.set_removed(true);
-            offset = removed_item_offset;
+            m_index[handle.value - 1] = removed_item_offset;
+            ++seg.count_removed;
+            seg.removed_bytes += item.padded_size();
             --m_count_items;
             ++m_count_removed;
+            if (segmented()) {
+                check_compact(num);
+            }
         }
 
     }; // class ItemStash
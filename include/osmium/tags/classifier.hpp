@@ -0,0 +1,137 @@
+#ifndef OSMIUM_TAGS_CLASSIFIER_HPP
+#define OSMIUM_TAGS_CLASSIFIER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/tag.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Checks a tag list against several TagsFilters at once. This walks
+     * the tag list only once and returns a bitset with one bit for each
+     * filter that matched any of the tags, ie bit n is set if
+     * @code osmium::tags::match_any_of(tags, filter_n) @endcode
+     * would be true.
+     *
+     * @code
+     * osmium::TagsClassifier classifier;
+     * const auto roads = classifier.add(road_filter);
+     * const auto buildings = classifier.add(building_filter);
+     * ...
+     * const auto bits = classifier(way.tags());
+     * if (osmium::TagsClassifier::test(bits, roads)) {
+     *     ...
+     * }
+     * @endcode
+     */
+    class TagsClassifier {
+
+        std::vector<osmium::TagsFilter> m_filters;
+        uint64_t m_all = 0;
+
+    public:
+
+        using bits_type = uint64_t;
+
+        enum {
+            max_filters = 64
+        };
+
+        /**
+         * Add a filter. The filter is copied and compiled (see
+         * TagsFilter::compile()) if it wasn't already.
+         *
+         * @returns The number of the bit for this filter.
+         * @throws std::length_error if there are already max_filters
+         *         filters.
+         */
+        std::size_t add(osmium::TagsFilter filter) {
+            if (m_filters.size() == max_filters) {
+                throw std::length_error{"too many filters in TagsClassifier"};
+            }
+            if (!filter.compiled()) {
+                filter.compile();
+            }
+            m_filters.push_back(std::move(filter));
+            m_all = (m_all << 1U) | 1U;
+            return m_filters.size() - 1;
+        }
+
+        /// The number of filters in this classifier.
+        std::size_t size() const noexcept {
+            return m_filters.size();
+        }
+
+        /**
+         * Check the tags against all filters.
+         *
+         * @returns Bitset with bits set for all filters that matched.
+         */
+        bits_type operator()(const osmium::TagList& tags) const noexcept {
+            bits_type result = 0;
+            for (const auto& tag : tags) {
+                bits_type bit = 1;
+                for (const auto& filter : m_filters) {
+                    if (!(result & bit) && filter(tag)) {
+                        result |= bit;
+                    }
+                    bit <<= 1U;
+                }
+                if (result == m_all) {
+                    break;
+                }
+            }
+            return result;
+        }
+
+        /**
+         * Is the bit for the filter with the specified number set?
+         */
+        static bool test(bits_type bits, std::size_t filter) noexcept {
+            return (bits & (bits_type{1} << filter)) != 0;
+        }
+
+    }; // class TagsClassifier
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_CLASSIFIER_HPP
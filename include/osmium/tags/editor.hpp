@@ -0,0 +1,346 @@
+#ifndef OSMIUM_TAGS_EDITOR_HPP
+#define OSMIUM_TAGS_EDITOR_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/item.hpp>
+#include <osmium/osm/item_type.hpp>
+#include <osmium/osm/object.hpp>
+#include <osmium/osm/tag.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+namespace osmium {
+
+    namespace tags {
+
+        namespace detail {
+
+            /**
+             * Unused space at the end of the sub-items of an object. It is
+             * an item of type undefined marked as removed, so it is ignored
+             * by everything looking at the sub-items.
+             */
+            class slack_item : public osmium::memory::Item {
+
+            public:
+
+                explicit slack_item(osmium::memory::item_size_type size) noexcept :
+                    Item(size, osmium::item_type::undefined) {
+                    set_removed(true);
+                }
+
+            }; // class slack_item
+
+        } // namespace detail
+
+        /**
+         * Changes the tags of an OSM object in place in its buffer without
+         * rebuilding the object.
+         *
+         * Replacing a value with one that is not longer and removing tags
+         * always works. The space freed is kept as slack at the end of the
+         * object. Longer values and new tags only fit if there is enough
+         * slack, otherwise the function returns false and nothing is
+         * changed. In that case copy the object with copy_with_slack() into
+         * another buffer and edit the copy.
+         *
+         * Other sub-items of the object and references to them might be
+         * moved by any change.
+         *
+         * Usage:
+         * @code
+         * osmium::tags::TagEditor editor{way};
+         * editor.remove("created_by");
+         * if (!editor.set_value("highway", "residential")) {
+         *     const auto offset = osmium::tags::TagEditor::copy_with_slack(way, out, 64);
+         *     osmium::tags::TagEditor{out.get<osmium::Way>(offset)}.set_value("highway", "residential");
+         * }
+         * @endcode
+         */
+        class TagEditor {
+
+            osmium::OSMObject& m_object;
+
+            osmium::TagList* tag_list() noexcept {
+                for (auto& item : m_object) {
+                    if (item.type() == osmium::item_type::tag_list && !item.removed()) {
+                        return static_cast<osmium::TagList*>(&item);
+                    }
+                }
+                return nullptr;
+            }
+
+            unsigned char* object_end() noexcept {
+                return m_object.data() + m_object.padded_size();
+            }
+
+            // The size of an object without the slack at its end.
+            static std::size_t used_size(const osmium::OSMObject& object) noexcept {
+                const osmium::memory::Item* last = nullptr;
+                for (const auto& item : object) {
+                    last = &item;
+                }
+                if (last && last->type() == osmium::item_type::undefined && last->removed()) {
+                    return static_cast<std::size_t>(last->data() - object.data());
+                }
+                return object.padded_size();
+            }
+
+            unsigned char* used_end() noexcept {
+                return m_object.data() + used_size(m_object);
+            }
+
+            void set_slack(unsigned char* position) noexcept {
+                const auto size = static_cast<std::size_t>(object_end() - position);
+                if (size > 0) {
+                    new (position) detail::slack_item{static_cast<osmium::memory::item_size_type>(size)};
+                }
+            }
+
+            // Change the size of the tag list moving any sub-items after it.
+            // The contents of the tag list itself are not moved.
+            bool resize(osmium::TagList& tags, std::size_t new_size) noexcept {
+                unsigned char* const data = tags.data();
+                const std::size_t old_padded = tags.padded_size();
+                const std::size_t new_padded = osmium::memory::padded_length(new_size);
+                unsigned char* const end = used_end();
+                if (new_padded > old_padded + static_cast<std::size_t>(object_end() - end)) {
+                    return false;
+                }
+                std::memmove(data + new_padded, data + old_padded, static_cast<std::size_t>(end - (data + old_padded)));
+                set_slack(end - old_padded + new_padded);
+                static_cast<osmium::memory::Item&>(tags).m_size = static_cast<osmium::memory::item_size_type>(new_size);
+                std::fill(data + new_size, data + new_padded, 0);
+                return true;
+            }
+
+            static std::size_t tag_size(const char* key) noexcept {
+                const std::size_t key_size = std::strlen(key) + 1;
+                return key_size + std::strlen(key + key_size) + 1;
+            }
+
+            static void check_length(const char* key, const char* value) {
+                if (std::strlen(key) > osmium::max_osm_string_length) {
+                    throw std::length_error{"OSM tag key is too long"};
+                }
+                if (std::strlen(value) > osmium::max_osm_string_length) {
+                    throw std::length_error{"OSM tag value is too long"};
+                }
+            }
+
+        public:
+
+            /**
+             * Edit the tags of the specified object. The object must be
+             * in a buffer and stay there while the editor is used.
+             */
+            explicit TagEditor(osmium::OSMObject& object) noexcept :
+                m_object(object) {
+            }
+
+            /// The object being edited.
+            osmium::OSMObject& object() noexcept {
+                return m_object;
+            }
+
+            /**
+             * The number of bytes the tags can grow without needing more
+             * space. The space needed by a tag is the length of key and
+             * value plus 2.
+             */
+            std::size_t slack() noexcept {
+                std::size_t size = static_cast<std::size_t>(object_end() - used_end());
+                const auto* tags = tag_list();
+                if (tags) {
+                    size += tags->padded_size() - tags->byte_size();
+                } else if (size >= sizeof(osmium::TagList)) {
+                    size -= sizeof(osmium::TagList);
+                } else {
+                    size = 0;
+                }
+                return size;
+            }
+
+            /**
+             * Add a tag at the end of the tag list. Existing tags with the
+             * same key are not checked.
+             *
+             * @returns false if there is not enough slack.
+             * @throws std::length_error If the key or value is too long.
+             */
+            bool add_tag(const char* key, const char* value) {
+                check_length(key, value);
+                const std::size_t key_size = std::strlen(key) + 1;
+                const std::size_t value_size = std::strlen(value) + 1;
+                auto* tags = tag_list();
+                if (!tags) {
+                    unsigned char* end = used_end();
+                    const auto needed = osmium::memory::padded_length(sizeof(osmium::TagList) + key_size + value_size);
+                    if (needed > static_cast<std::size_t>(object_end() - end)) {
+                        return false;
+                    }
+                    tags = new (end) osmium::TagList{};
+                    set_slack(end + sizeof(osmium::TagList));
+                }
+                const std::size_t old_size = tags->byte_size();
+                if (!resize(*tags, old_size + key_size + value_size)) {
+                    return false;
+                }
+                unsigned char* position = tags->data() + old_size;
+                std::memcpy(position, key, key_size);
+                std::memcpy(position + key_size, value, value_size);
+                return true;
+            }
+
+            /**
+             * Set the value of the first tag with the specified key or add
+             * a new tag if there is none.
+             *
+             * @returns false if there is not enough slack.
+             * @throws std::length_error If the key or value is too long.
+             */
+            bool set_value(const char* key, const char* value) {
+                check_length(key, value);
+                auto* tags = tag_list();
+                if (!tags) {
+                    return add_tag(key, value);
+                }
+                unsigned char* const data = tags->data();
+                for (auto& tag : *tags) {
+                    if (std::strcmp(tag.key(), key) != 0) {
+                        continue;
+                    }
+                    const auto value_offset = static_cast<std::size_t>(reinterpret_cast<const unsigned char*>(tag.value()) - data);
+                    const std::size_t old_value_size = std::strlen(tag.value()) + 1;
+                    const std::size_t new_value_size = std::strlen(value) + 1;
+                    const std::size_t old_size = tags->byte_size();
+                    const std::size_t tail_offset = value_offset + old_value_size;
+                    if (new_value_size > old_value_size) {
+                        if (!resize(*tags, old_size + new_value_size - old_value_size)) {
+                            return false;
+                        }
+                        std::memmove(data + value_offset + new_value_size, data + tail_offset, old_size - tail_offset);
+                        std::memcpy(data + value_offset, value, new_value_size);
+                    } else {
+                        std::memcpy(data + value_offset, value, new_value_size);
+                        if (new_value_size < old_value_size) {
+                            std::memmove(data + value_offset + new_value_size, data + tail_offset, old_size - tail_offset);
+                            resize(*tags, old_size - old_value_size + new_value_size);
+                        }
+                    }
+                    return true;
+                }
+                return add_tag(key, value);
+            }
+
+            /**
+             * Remove all tags for which the predicate returns true. The
+             * predicate is called with a const osmium::Tag&.
+             *
+             * @returns The number of tags removed.
+             */
+            template <typename TPredicate>
+            std::size_t remove_if(TPredicate&& predicate) {
+                auto* tags = tag_list();
+                if (!tags) {
+                    return 0;
+                }
+                unsigned char* const data = tags->data();
+                const std::size_t end = tags->byte_size();
+                std::size_t read = sizeof(osmium::TagList);
+                std::size_t write = read;
+                std::size_t count = 0;
+                while (read < end) {
+                    const auto& tag = *reinterpret_cast<const osmium::Tag*>(data + read);
+                    const std::size_t size = tag_size(tag.key());
+                    if (predicate(tag)) {
+                        ++count;
+                    } else {
+                        if (write != read) {
+                            std::memmove(data + write, data + read, size);
+                        }
+                        write += size;
+                    }
+                    read += size;
+                }
+                if (count > 0) {
+                    resize(*tags, write);
+                }
+                return count;
+            }
+
+            /**
+             * Remove all tags with the specified key.
+             *
+             * @returns The number of tags removed.
+             */
+            std::size_t remove(const char* key) {
+                return remove_if([key](const osmium::Tag& tag) {
+                    return !std::strcmp(tag.key(), key);
+                });
+            }
+
+            /**
+             * Copy an object into a buffer adding slack at the end, so that
+             * its tags can grow by at least the specified number of bytes
+             * with a TagEditor. Any slack the object already has is not
+             * copied. The copy is committed.
+             *
+             * @returns The offset of the copy in the buffer.
+             * @throws osmium::buffer_is_full If the buffer can not grow.
+             */
+            static std::size_t copy_with_slack(const osmium::OSMObject& object, osmium::memory::Buffer& buffer, std::size_t slack) {
+                const std::size_t object_size = used_size(object);
+                const std::size_t slack_size = osmium::memory::padded_length(std::max(slack + sizeof(osmium::TagList), sizeof(detail::slack_item)));
+                unsigned char* target = buffer.reserve_space(object_size + slack_size);
+                std::memcpy(target, object.data(), object_size);
+                new (target + object_size) detail::slack_item{static_cast<osmium::memory::item_size_type>(slack_size)};
+                auto& copy = *reinterpret_cast<osmium::memory::Item*>(target);
+                copy.m_size = static_cast<osmium::memory::item_size_type>(object_size + slack_size);
+                return buffer.commit();
+            }
+
+        }; // class TagEditor
+
+    } // namespace tags
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_EDITOR_HPP
@@ -0,0 +1,243 @@
+#ifndef OSMIUM_TAGS_KEY_TABLE_HPP
+#define OSMIUM_TAGS_KEY_TABLE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/osm/tag.hpp>
+#include <osmium/util/string.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * A table of interned tag keys. Each key added to the table gets a
+     * small integer id (starting from 0 in the order the keys were added).
+     * Use this together with the TagValues class to look up the values
+     * of many keys in a tag list with a single pass over the list.
+     *
+     * @code
+     * osmium::KeyTable keys;
+     * const auto highway = keys.add("highway");
+     * const auto name = keys.add("name");
+     *
+     * osmium::TagValues values{keys};
+     * values.set(way.tags());
+     * if (values.has(highway)) {
+     *     std::cout << values.get(name, "(unnamed)") << '\n';
+     * }
+     * @endcode
+     */
+    class KeyTable {
+
+    public:
+
+        using id_type = uint32_t;
+
+        enum : id_type {
+            /// Returned by get() if the key is not in the table.
+            invalid_id = std::numeric_limits<id_type>::max()
+        };
+
+    private:
+
+        std::vector<std::string> m_keys;
+
+        // Open addressing hash table. Slots contain the id + 1 or 0 if
+        // they are empty.
+        std::vector<id_type> m_slots = std::vector<id_type>(16, 0);
+
+        std::size_t find_slot(const char* key) const noexcept {
+            const std::size_t mask = m_slots.size() - 1;
+            std::size_t slot = osmium::detail::c_string_hash{}(key) & mask;
+            while (m_slots[slot] != 0 && std::strcmp(m_keys[m_slots[slot] - 1].c_str(), key) != 0) {
+                slot = (slot + 1) & mask;
+            }
+            return slot;
+        }
+
+        void grow() {
+            std::vector<id_type> old_slots(m_slots.size() * 2, 0);
+            swap(old_slots, m_slots);
+            for (const auto entry : old_slots) {
+                if (entry != 0) {
+                    m_slots[find_slot(m_keys[entry - 1].c_str())] = entry;
+                }
+            }
+        }
+
+    public:
+
+        /**
+         * Add a key to the table. If the key is already in the table,
+         * its id is returned.
+         *
+         * @returns The id of the key.
+         */
+        id_type add(const char* key) {
+            assert(key);
+            const auto slot = find_slot(key);
+            if (m_slots[slot] != 0) {
+                return m_slots[slot] - 1;
+            }
+
+            const auto id = static_cast<id_type>(m_keys.size());
+            m_keys.emplace_back(key);
+            m_slots[slot] = id + 1;
+            if (m_keys.size() * 2 > m_slots.size()) {
+                grow();
+            }
+            return id;
+        }
+
+        /**
+         * Add a key to the table. If the key is already in the table,
+         * its id is returned.
+         *
+         * @returns The id of the key.
+         */
+        id_type add(const std::string& key) {
+            return add(key.c_str());
+        }
+
+        /**
+         * Get the id of a key.
+         *
+         * @returns The id or invalid_id if the key is not in the table.
+         */
+        id_type get(const char* key) const noexcept {
+            assert(key);
+            const auto entry = m_slots[find_slot(key)];
+            return entry == 0 ? invalid_id : entry - 1;
+        }
+
+        /**
+         * Get the key with the specified id.
+         *
+         * @pre @code id < size() @endcode
+         */
+        const char* key(id_type id) const noexcept {
+            assert(id < m_keys.size());
+            return m_keys[id].c_str();
+        }
+
+        /// The number of keys in the table.
+        std::size_t size() const noexcept {
+            return m_keys.size();
+        }
+
+        bool empty() const noexcept {
+            return m_keys.empty();
+        }
+
+    }; // class KeyTable
+
+    /**
+     * The values of the tags with the keys from a KeyTable in one tag
+     * list. After calling set() with a tag list, the value for any key
+     * in the table can be looked up in constant time using the key id.
+     * If a key appears more than once in a tag list, the first value is
+     * used, just like in TagList::get_value_by_key().
+     *
+     * The KeyTable must not be changed while this object is used. The
+     * value pointers point into the tag list, so they are only valid as
+     * long as the buffer with the tag list is.
+     */
+    class TagValues {
+
+        const KeyTable* m_table;
+        std::vector<const char*> m_values;
+
+    public:
+
+        explicit TagValues(const KeyTable& table) :
+            m_table(&table),
+            m_values(table.size(), nullptr) {
+        }
+
+        /**
+         * Look up the values of all keys in the table in the specified
+         * tag list. This does one pass over the tags and one hash table
+         * lookup per tag.
+         */
+        void set(const osmium::TagList& tags) {
+            m_values.assign(m_table->size(), nullptr);
+            for (const auto& tag : tags) {
+                const auto id = m_table->get(tag.key());
+                if (id != KeyTable::invalid_id && !m_values[id]) {
+                    m_values[id] = tag.value();
+                }
+            }
+        }
+
+        /**
+         * Get the value of the tag with the key with the specified id.
+         *
+         * @returns The value or default_value if the tag list has no tag
+         *          with this key.
+         */
+        const char* get(KeyTable::id_type id, const char* default_value = nullptr) const noexcept {
+            assert(id < m_values.size());
+            return m_values[id] ? m_values[id] : default_value;
+        }
+
+        /**
+         * Get the value of the tag with the key with the specified id.
+         *
+         * @returns The value or nullptr if the tag list has no tag with
+         *          this key.
+         */
+        const char* operator[](KeyTable::id_type id) const noexcept {
+            return get(id);
+        }
+
+        /**
+         * Does the tag list have a tag with the key with the specified id?
+         */
+        bool has(KeyTable::id_type id) const noexcept {
+            assert(id < m_values.size());
+            return m_values[id] != nullptr;
+        }
+
+    }; // class TagValues
+
+} // namespace osmium
+
+#endif // OSMIUM_TAGS_KEY_TABLE_HPP
@@ -90,14 +90,39 @@ namespace osmium {
             m_result(!invert) {
         }
 
+        /**
+         * The StringMatcher used for the key.
+         */
+        const osmium::StringMatcher& key_matcher() const noexcept {
+            return m_key_matcher;
+        }
+
+        /**
+         * Match only the key against the key matcher.
+         *
+         * @returns true if the key matches.
+         */
+        bool match_key(const char* key) const noexcept {
+            return m_key_matcher(key);
+        }
+
+        /**
+         * Match only the value against the value matcher taking the
+         * invert flag into account.
+         *
+         * @returns true if the value matches.
+         */
+        bool match_value(const char* value) const noexcept {
+            return m_value_matcher(value) == m_result;
+        }
+
         /**
          * Match against the specified key and value.
          *
          * @returns true if the tag matches.
          */
         bool operator()(const char* key, const char* value) const noexcept {
-            return m_key_matcher(key) &&
-                   (m_value_matcher(value) == m_result);
+            return match_key(key) && match_value(value);
         }
 
         /**
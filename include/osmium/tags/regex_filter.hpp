@@ -34,6 +34,7 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/tags/filter.hpp>
+#include <osmium/util/regex.hpp>
 
 #include <regex>
 #include <string>
@@ -56,6 +57,20 @@ namespace osmium {
             }
         }; // struct match_value<std::regex>
 
+        template <>
+        struct match_key<osmium::Regex> {
+            bool operator()(const osmium::Regex& rule_key, const char* tag_key) const {
+                return rule_key.full_match(tag_key);
+            }
+        }; // struct match_key<osmium::Regex>
+
+        template <>
+        struct match_value<osmium::Regex> {
+            bool operator()(const osmium::Regex& rule_value, const char* tag_value) const {
+                return rule_value.full_match(tag_value);
+            }
+        }; // struct match_value<osmium::Regex>
+
         /// @deprecated Use osmium::TagsFilter instead.
         using RegexFilter = Filter<std::string, std::regex>;
 
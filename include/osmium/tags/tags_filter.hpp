@@ -35,14 +35,113 @@ DEALINGS IN THE SOFTWARE.
 
 #include <osmium/osm/tag.hpp>
 #include <osmium/tags/matcher.hpp>
+#include <osmium/util/string.hpp>
+#include <osmium/util/string_matcher.hpp>
 
 #include <boost/iterator/filter_iterator.hpp>
 
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Index of the rules of a TagsFilterBase by key. For each key that
+         * appears in a rule with an "equal" or "list" key matcher, it
+         * stores the (ordered) list of rules that can possibly match a
+         * tag with this key: the rules with this key and all rules with
+         * other kinds of key matchers (prefix, substring, ...). Rules
+         * that can never match (always_false key matcher) are left out.
+         *
+         * The index is immutable once created, so it can be shared
+         * between copies of a filter.
+         */
+        class tags_filter_index {
+
+        public:
+
+            struct rule_ref {
+                std::size_t rule;
+                bool key_matched; // key matcher doesn't need to be checked
+            };
+
+        private:
+
+            std::vector<std::string> m_keys;
+            std::unordered_map<const char*, std::vector<rule_ref>, c_string_hash, c_string_equal> m_rules_by_key;
+            std::vector<rule_ref> m_other_rules;
+
+            void add_key(const std::string& key) {
+                for (const auto& k : m_keys) {
+                    if (k == key) {
+                        return;
+                    }
+                }
+                m_keys.push_back(key);
+            }
+
+        public:
+
+            template <typename TRules>
+            explicit tags_filter_index(const TRules& rules) {
+                for (const auto& rule : rules) {
+                    const auto& key_matcher = rule.second.key_matcher();
+                    if (const auto* equal = key_matcher.template get<osmium::StringMatcher::equal>()) {
+                        add_key(equal->str());
+                    } else if (const auto* list = key_matcher.template get<osmium::StringMatcher::list>()) {
+                        for (const auto& key : list->strings()) {
+                            add_key(key);
+                        }
+                    }
+                }
+
+                // m_keys doesn't change any more, so we can point into it
+                for (const auto& key : m_keys) {
+                    m_rules_by_key[key.c_str()];
+                }
+
+                for (std::size_t n = 0; n < rules.size(); ++n) {
+                    const auto& key_matcher = rules[n].second.key_matcher();
+                    if (key_matcher.template get<osmium::StringMatcher::always_false>()) {
+                        continue;
+                    }
+                    if (const auto* equal = key_matcher.template get<osmium::StringMatcher::equal>()) {
+                        m_rules_by_key[equal->str().c_str()].push_back(rule_ref{n, true});
+                    } else if (const auto* list = key_matcher.template get<osmium::StringMatcher::list>()) {
+                        for (const auto& key : list->strings()) {
+                            auto& refs = m_rules_by_key[key.c_str()];
+                            if (refs.empty() || refs.back().rule != n) {
+                                refs.push_back(rule_ref{n, true});
+                            }
+                        }
+                    } else {
+                        for (auto& entry : m_rules_by_key) {
+                            entry.second.push_back(rule_ref{n, false});
+                        }
+                        m_other_rules.push_back(rule_ref{n, false});
+                    }
+                }
+            }
+
+            /**
+             * Get the rules that have to be checked (in order) for a tag
+             * with the specified key.
+             */
+            const std::vector<rule_ref>& rules_for_key(const char* key) const {
+                const auto it = m_rules_by_key.find(key);
+                return it == m_rules_by_key.end() ? m_other_rules : it->second;
+            }
+
+        }; // class tags_filter_index
+
+    } // namespace detail
+
     /**
      * A TagsFilterBase is a list of rules (defined using TagMatchers) to
      * check tags against. The first rule that matches sets the result.
@@ -63,12 +162,17 @@ namespace osmium {
      * @endcode
      *
      * Use this instead of the old osmium::tags::Filter.
+     *
+     * For filters with many rules call compile() after all rules have
+     * been added. This builds an index of the rules by key so that only
+     * the rules that can possibly match a tag are checked.
      */
     template <typename TResult>
     class TagsFilterBase {
 
         std::vector<std::pair<TResult, TagMatcher>> m_rules;
         TResult m_default_result;
+        std::shared_ptr<const detail::tags_filter_index> m_index;
 
     public:
 
@@ -101,6 +205,7 @@ namespace osmium {
          */
         TagsFilterBase& add_rule(const TResult result, const TagMatcher& matcher) {
             m_rules.emplace_back(result, matcher);
+            m_index.reset();
             return *this;
         }
 
@@ -115,9 +220,34 @@ namespace osmium {
         template <typename... TArgs>
         TagsFilterBase& add_rule(const TResult result, TArgs&&... args) {
             m_rules.emplace_back(result, osmium::TagMatcher{std::forward<TArgs>(args)...});
+            m_index.reset();
+            return *this;
+        }
+
+        /**
+         * Build an index of the rules by key which makes the matching
+         * functions much faster for filters with many rules with "equal"
+         * or "list" key matchers. Rules with other key matchers are still
+         * checked one after the other. The result is always the same as
+         * without the index, ie the first rule that matches wins.
+         *
+         * Adding a rule removes the index, call compile() again after
+         * adding all rules.
+         *
+         * @returns A reference to this filter for chaining.
+         */
+        TagsFilterBase& compile() {
+            m_index = std::make_shared<const detail::tags_filter_index>(m_rules);
             return *this;
         }
 
+        /**
+         * Has compile() been called after the last rule was added?
+         */
+        bool compiled() const noexcept {
+            return static_cast<bool>(m_index);
+        }
+
         /**
          * Matching function. Check the specified tag against the rules.
          *
@@ -126,14 +256,53 @@ namespace osmium {
          *          matched, the default result.
          */
         TResult operator()(const osmium::Tag& tag) const noexcept {
+            return operator()(tag.key(), tag.value());
+        }
+
+        /**
+         * Matching function. Check the specified key and value against
+         * the rules.
+         *
+         * @param key The key of a tag.
+         * @param value The value of a tag.
+         * @returns The result of the matching rule, or, if none of the rules
+         *          matched, the default result.
+         */
+        TResult operator()(const char* key, const char* value) const noexcept {
+            if (m_index) {
+                for (const auto& ref : m_index->rules_for_key(key)) {
+                    const auto& rule = m_rules[ref.rule];
+                    if (ref.key_matched ? rule.second.match_value(value) : rule.second(key, value)) {
+                        return rule.first;
+                    }
+                }
+                return m_default_result;
+            }
+
             for (const auto& rule : m_rules) {
-                if (rule.second(tag)) {
+                if (rule.second(key, value)) {
                     return rule.first;
                 }
             }
             return m_default_result;
         }
 
+        /**
+         * Access the rules in the order they are checked. Each rule is a
+         * pair of the result and the TagMatcher.
+         */
+        const std::vector<std::pair<TResult, TagMatcher>>& rules() const noexcept {
+            return m_rules;
+        }
+
+        /**
+         * The result the matching function will return if none of the
+         * rules matched.
+         */
+        TResult default_result() const noexcept {
+            return m_default_result;
+        }
+
         /**
          * Return the number of rules in this filter.
          *
@@ -34,17 +34,31 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/thread/function_wrapper.hpp>
-#include <osmium/thread/queue.hpp>
 #include <osmium/thread/util.hpp>
 #include <osmium/util/config.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
 #include <future>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#ifdef __linux__
+# include <pthread.h>
+# include <sched.h>
+#endif
+
 namespace osmium {
 
     /**
@@ -52,8 +66,28 @@ namespace osmium {
      */
     namespace thread {
 
+        /**
+         * Priority of a task submitted to a Pool. Workers always take the
+         * tasks with the highest priority first. Tasks with the same
+         * priority are started in the order they were submitted.
+         *
+         * Use a higher priority for tasks that are closer to the output
+         * of a pipeline. The writers submit their encoding and compression
+         * tasks with high priority, so a burst of decoding tasks from a
+         * reader can not starve them.
+         */
+        enum class task_priority : std::size_t {
+            low    = 0,
+            normal = 1,
+            high   = 2
+        };
+
         namespace detail {
 
+            enum : std::size_t {
+                num_task_priorities = 3
+            };
+
             // Maximum number of allowed pool threads (just to keep the user
             // from setting something silly).
             enum {
@@ -82,8 +116,217 @@ namespace osmium {
                 return osmium::config::get_max_queue_size("WORK", 10);
             }
 
+            /**
+             * The work queue of a pool with shared queue scheduling. There
+             * is one FIFO queue for each task priority and tasks are taken
+             * from the queue with the highest priority that isn't empty.
+             * The maximum size applies to each priority separately, so
+             * a full queue of tasks with one priority doesn't block
+             * submitting tasks with another priority.
+             */
+            class PriorityWorkQueue {
+
+                const std::size_t m_max_size;
+
+                mutable std::mutex m_mutex;
+
+                std::deque<function_wrapper> m_queues[num_task_priorities];
+
+                std::size_t m_size = 0;
+
+                std::condition_variable m_data_available;
+
+                std::condition_variable m_space_available[num_task_priorities];
+
+            public:
+
+                /**
+                 * @param max_size Maximum number of tasks for each priority.
+                 *                 Set to 0 for an unlimited size.
+                 */
+                explicit PriorityWorkQueue(std::size_t max_size) :
+                    m_max_size(max_size) {
+                }
+
+                std::size_t max_size() const noexcept {
+                    return m_max_size;
+                }
+
+                /**
+                 * Add a task with the given priority. Blocks if there are
+                 * already max_size tasks with this priority queued.
+                 */
+                void push(function_wrapper&& task, task_priority priority) {
+                    const auto level = static_cast<std::size_t>(priority);
+                    {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        if (m_max_size) {
+                            m_space_available[level].wait(lock, [this, level] {
+                                return m_queues[level].size() < m_max_size;
+                            });
+                        }
+                        m_queues[level].push_back(std::move(task));
+                        ++m_size;
+                    }
+                    m_data_available.notify_one();
+                }
+
+                /// Wait for a task and take the one with the highest priority.
+                void wait_and_pop(function_wrapper& task) {
+                    std::size_t level = num_task_priorities;
+                    {
+                        std::unique_lock<std::mutex> lock{m_mutex};
+                        m_data_available.wait(lock, [this] {
+                            return m_size > 0;
+                        });
+                        while (m_queues[--level].empty()) {
+                        }
+                        task = std::move(m_queues[level].front());
+                        m_queues[level].pop_front();
+                        --m_size;
+                    }
+                    m_space_available[level].notify_one();
+                }
+
+                std::size_t size() const {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    return m_size;
+                }
+
+            }; // class PriorityWorkQueue
+
+            /**
+             * The tasks of one worker thread in a work-stealing pool. The
+             * worker takes tasks from the front, other workers steal from
+             * the front, too, because results are usually needed in the
+             * order the tasks were submitted. There is one deque for each
+             * task priority.
+             */
+            class WorkerDeque {
+
+                std::mutex m_mutex;
+                std::deque<function_wrapper> m_tasks[num_task_priorities];
+
+            public:
+
+                void push(function_wrapper&& task, std::size_t level) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    m_tasks[level].push_back(std::move(task));
+                }
+
+                bool try_pop(function_wrapper& task, std::size_t level) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    if (m_tasks[level].empty()) {
+                        return false;
+                    }
+                    task = std::move(m_tasks[level].front());
+                    m_tasks[level].pop_front();
+                    return true;
+                }
+
+            }; // class WorkerDeque
+
+            /**
+             * Parse a list of CPUs in the format used by Linux in /sys, for
+             * instance "0-3,8,10-11".
+             */
+            inline std::vector<int> parse_cpu_list(const std::string& list) {
+                std::vector<int> cpus;
+
+                const char* str = list.c_str();
+                while (*str >= '0' && *str <= '9') {
+                    char* end = nullptr;
+                    const auto first = static_cast<int>(std::strtol(str, &end, 10));
+                    auto last = first;
+                    if (*end == '-') {
+                        str = end + 1;
+                        last = static_cast<int>(std::strtol(str, &end, 10));
+                    }
+                    for (int cpu = first; cpu <= last; ++cpu) {
+                        cpus.push_back(cpu);
+                    }
+                    str = end;
+                    if (*str == ',') {
+                        ++str;
+                    }
+                }
+
+                return cpus;
+            }
+
+#ifdef __linux__
+            /// The CPUs this process is allowed to run on.
+            inline std::vector<int> allowed_cpus() {
+                std::vector<int> cpus;
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                        if (CPU_ISSET(cpu, &set)) {
+                            cpus.push_back(cpu);
+                        }
+                    }
+                }
+                return cpus;
+            }
+
+            /// The CPUs of each NUMA node as reported in /sys.
+            inline std::vector<std::vector<int>> numa_node_cpus() {
+                std::vector<std::vector<int>> nodes;
+                for (int node = 0;; ++node) {
+                    std::ifstream file{"/sys/devices/system/node/node" + std::to_string(node) + "/cpulist"};
+                    std::string list;
+                    if (!std::getline(file, list)) {
+                        break;
+                    }
+                    auto cpus = parse_cpu_list(list);
+                    if (!cpus.empty()) {
+                        nodes.push_back(std::move(cpus));
+                    }
+                }
+                return nodes;
+            }
+
+            /// Pin the thread to the given CPUs. Errors are ignored.
+            inline void pin_thread(std::thread& thread, const std::vector<int>& cpus) noexcept {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                for (const auto cpu : cpus) {
+                    if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                        CPU_SET(cpu, &set);
+                    }
+                }
+                pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+            }
+#endif
+
         } // namespace detail
 
+        /**
+         * How the tasks submitted to a Pool are handed to the worker
+         * threads.
+         */
+        enum class pool_scheduling {
+            /// All workers take tasks from one shared queue.
+            shared_queue = 0,
+            /// Each worker has its own queue, idle workers steal tasks
+            /// from the queues of other workers.
+            work_stealing = 1
+        };
+
+        /**
+         * Should the worker threads of a Pool be pinned to CPUs? This is
+         * only supported on Linux and ignored elsewhere.
+         */
+        enum class pool_affinity {
+            /// Don't pin the threads.
+            none = 0,
+            /// Pin each thread to one of the CPUs the process may run on.
+            cores = 1,
+            /// Pin the threads round-robin to the CPUs of the NUMA nodes.
+            numa_nodes = 2
+        };
+
         /**
          *  Thread pool.
          */
@@ -119,10 +362,26 @@ namespace osmium {
 
             }; // class thread_joiner
 
-            osmium::thread::Queue<function_wrapper> m_work_queue;
+            detail::PriorityWorkQueue m_work_queue;
+
+            // Only used for work stealing: The queues of the workers, the
+            // number of tasks in all of them and for each priority, and
+            // the number of workers waiting for tasks.
+            std::vector<std::unique_ptr<detail::WorkerDeque>> m_deques{};
+            std::size_t m_max_tasks;
+            std::atomic<std::size_t> m_num_tasks{0};
+            std::atomic<std::size_t> m_num_queued[detail::num_task_priorities];
+            std::atomic<std::size_t> m_next_deque{0};
+            std::atomic<int> m_num_sleeping{0};
+            std::atomic<bool> m_done{false};
+            std::mutex m_sleep_mutex{};
+            std::condition_variable m_work_available{};
+            std::condition_variable m_space_available{};
+
             std::vector<std::thread> m_threads{};
             thread_joiner m_joiner;
             int m_num_threads;
+            pool_scheduling m_scheduling;
 
             void worker_thread() {
                 osmium::thread::set_thread_name("_osmium_worker");
@@ -137,6 +396,112 @@ namespace osmium {
                 }
             }
 
+            // Take a task from the queue of this worker or steal one from
+            // the queue of another worker starting with a random one.
+            // Tasks with higher priority are looked for first.
+            bool find_task(std::size_t index, uint32_t& random, function_wrapper& task, std::size_t& level) {
+                random ^= random << 13u;
+                random ^= random >> 17u;
+                random ^= random << 5u;
+
+                const auto num = m_deques.size();
+                const auto start = random % num;
+                for (level = detail::num_task_priorities; level-- > 0;) {
+                    if (m_num_queued[level] == 0) {
+                        continue;
+                    }
+                    if (m_deques[index]->try_pop(task, level)) {
+                        return true;
+                    }
+                    for (std::size_t i = 0; i < num; ++i) {
+                        const auto victim = (start + i) % num;
+                        if (victim != index && m_deques[victim]->try_pop(task, level)) {
+                            return true;
+                        }
+                    }
+                }
+
+                return false;
+            }
+
+            void work_stealing_worker_thread(std::size_t index) {
+                osmium::thread::set_thread_name("_osmium_worker");
+                uint32_t random = static_cast<uint32_t>(index) * 2654435761u + 1u;
+                while (true) {
+                    function_wrapper task;
+                    std::size_t level = 0;
+                    if (find_task(index, random, task, level)) {
+                        --m_num_queued[level];
+                        --m_num_tasks;
+                        if (m_max_tasks) {
+                            m_space_available.notify_one();
+                        }
+                        task();
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock{m_sleep_mutex};
+                    ++m_num_sleeping;
+                    m_work_available.wait(lock, [this] {
+                        return m_num_tasks > 0 || m_done;
+                    });
+                    --m_num_sleeping;
+                    if (m_num_tasks == 0 && m_done) {
+                        return;
+                    }
+                }
+            }
+
+            void push_work_stealing(function_wrapper&& task, task_priority priority) {
+                const auto level = static_cast<std::size_t>(priority);
+                auto& queued = m_num_queued[level];
+                if (m_max_tasks && queued >= m_max_tasks) {
+                    constexpr const std::chrono::milliseconds max_wait{10};
+                    while (queued >= m_max_tasks) {
+                        std::unique_lock<std::mutex> lock{m_sleep_mutex};
+                        m_space_available.wait_for(lock, max_wait, [this, &queued] {
+                            return queued < m_max_tasks;
+                        });
+                    }
+                }
+
+                // The counters are incremented first, so they never drop
+                // below zero when a worker takes the task right away.
+                ++queued;
+                ++m_num_tasks;
+                m_deques[m_next_deque++ % m_deques.size()]->push(std::move(task), level);
+
+                // The sleeping workers check the number of tasks with the
+                // mutex locked, so they either see the new task or they
+                // are already waiting for this notification.
+                if (m_num_sleeping > 0) {
+                    { std::lock_guard<std::mutex> lock{m_sleep_mutex}; }
+                    m_work_available.notify_one();
+                }
+            }
+
+            void pin_threads(pool_affinity affinity) {
+#ifdef __linux__
+                if (affinity == pool_affinity::cores) {
+                    const auto cpus = detail::allowed_cpus();
+                    if (!cpus.empty()) {
+                        for (std::size_t i = 0; i < m_threads.size(); ++i) {
+                            detail::pin_thread(m_threads[i], {cpus[i % cpus.size()]});
+                        }
+                    }
+                } else if (affinity == pool_affinity::numa_nodes) {
+                    const auto nodes = detail::numa_node_cpus();
+                    if (!nodes.empty()) {
+                        for (std::size_t i = 0; i < m_threads.size(); ++i) {
+                            detail::pin_thread(m_threads[i], nodes[i % nodes.size()]);
+                        }
+                    }
+                }
+#else
+                (void)affinity;
+#endif
+            }
+
         public:
 
             enum {
@@ -160,32 +525,82 @@ namespace osmium {
              * In all cases the minimum number of threads in the pool is 1.
              *
              * If max_queue_size is 0, the queue size is read from
-             * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE.
+             * the environment variable OSMIUM_MAX_WORK_QUEUE_SIZE. The
+             * maximum applies to the tasks of each task_priority
+             * separately.
+             *
+             * With pool_scheduling::work_stealing each worker has its own
+             * queue and the max_queue_size limits the sum of all queued
+             * tasks (of each priority). This avoids contention on a single
+             * queue when there are many threads working on small tasks.
+             *
+             * The affinity sets whether the workers are pinned to CPUs
+             * (only on Linux).
              */
-            explicit Pool(int num_threads = default_num_threads, std::size_t max_queue_size = default_queue_size) :
-                m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size(), "work"),
+            explicit Pool(int num_threads = default_num_threads,
+                          std::size_t max_queue_size = default_queue_size,
+                          pool_scheduling scheduling = pool_scheduling::shared_queue,
+                          pool_affinity affinity = pool_affinity::none) :
+                m_work_queue(max_queue_size > 0 ? max_queue_size : detail::get_work_queue_size()),
+                m_max_tasks(m_work_queue.max_size()),
                 m_joiner(m_threads),
-                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())) {
+                m_num_threads(detail::get_pool_size(num_threads, osmium::config::get_pool_threads(), std::thread::hardware_concurrency())),
+                m_scheduling(scheduling) {
+
+                for (auto& queued : m_num_queued) {
+                    queued = 0;
+                }
 
                 try {
-                    for (int i = 0; i < m_num_threads; ++i) {
-                        m_threads.emplace_back(&Pool::worker_thread, this);
+                    if (m_scheduling == pool_scheduling::work_stealing) {
+                        for (int i = 0; i < m_num_threads; ++i) {
+                            m_deques.emplace_back(new detail::WorkerDeque{});
+                        }
+                        for (int i = 0; i < m_num_threads; ++i) {
+                            m_threads.emplace_back(&Pool::work_stealing_worker_thread, this, static_cast<std::size_t>(i));
+                        }
+                    } else {
+                        for (int i = 0; i < m_num_threads; ++i) {
+                            m_threads.emplace_back(&Pool::worker_thread, this);
+                        }
                     }
                 } catch (...) {
                     shutdown_all_workers();
                     throw;
                 }
+
+                pin_threads(affinity);
             }
 
+            /**
+             * The default pool. It uses work stealing if the environment
+             * variable OSMIUM_POOL_WORK_STEALING is set to "yes" and pins
+             * its threads if OSMIUM_POOL_AFFINITY is set to "cores" or
+             * "numa".
+             */
             static Pool& default_instance() {
-                static Pool pool{};
+                static Pool pool{default_num_threads,
+                                 default_queue_size,
+                                 osmium::config::use_work_stealing_pool() ? pool_scheduling::work_stealing : pool_scheduling::shared_queue,
+                                 static_cast<pool_affinity>(osmium::config::get_pool_affinity())};
                 return pool;
             }
 
             void shutdown_all_workers() {
+                if (m_scheduling == pool_scheduling::work_stealing) {
+                    // Workers shut down when there are no tasks left.
+                    {
+                        std::lock_guard<std::mutex> lock{m_sleep_mutex};
+                        m_done = true;
+                    }
+                    m_work_available.notify_all();
+                    return;
+                }
                 for (int i = 0; i < m_num_threads; ++i) {
                     // The special function wrapper makes a worker shut down.
-                    m_work_queue.push(function_wrapper{0});
+                    // It has the lowest priority, so all other tasks are
+                    // done first.
+                    m_work_queue.push(function_wrapper{0}, task_priority::low);
                 }
             }
 
@@ -203,21 +618,39 @@ namespace osmium {
                 return m_num_threads;
             }
 
+            pool_scheduling scheduling() const noexcept {
+                return m_scheduling;
+            }
+
             std::size_t queue_size() const {
+                if (m_scheduling == pool_scheduling::work_stealing) {
+                    return m_num_tasks;
+                }
                 return m_work_queue.size();
             }
 
             bool queue_empty() const {
-                return m_work_queue.empty();
+                return queue_size() == 0;
             }
 
+            /**
+             * Submit a task to the pool. Tasks with higher priority are
+             * started before all tasks with lower priority waiting in
+             * the queue.
+             *
+             * @returns A future for the result of the task.
+             */
             template <typename TFunction>
-            std::future<typename std::result_of<TFunction()>::type> submit(TFunction&& func) {
+            std::future<typename std::result_of<TFunction()>::type> submit(TFunction&& func, task_priority priority = task_priority::normal) {
                 using result_type = typename std::result_of<TFunction()>::type;
 
                 std::packaged_task<result_type()> task{std::forward<TFunction>(func)};
                 std::future<result_type> future_result{task.get_future()};
-                m_work_queue.push(std::move(task));
+                if (m_scheduling == pool_scheduling::work_stealing) {
+                    push_work_stealing(std::move(task), priority);
+                } else {
+                    m_work_queue.push(std::move(task), priority);
+                }
 
                 return future_result;
             }
@@ -33,6 +33,7 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
@@ -42,7 +43,6 @@ DEALINGS IN THE SOFTWARE.
 #include <utility> // IWYU pragma: keep
 
 #ifdef OSMIUM_DEBUG_QUEUE_SIZE
-# include <atomic>
 # include <iostream>
 #endif
 
@@ -73,27 +73,25 @@ namespace osmium {
             /// Used to signal producers when queue is not full.
             std::condition_variable m_space_available;
 
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
             /// The largest size the queue has been so far.
-            std::size_t m_largest_size;
+            std::size_t m_largest_size = 0;
 
             /// The number of times push() was called on the queue.
-            std::atomic<int> m_push_counter;
+            std::atomic<std::size_t> m_push_counter{0};
 
             /// The number of times the queue was full and a thread pushing
             /// to the queue was blocked.
-            std::atomic<int> m_full_counter;
+            std::atomic<std::size_t> m_full_counter{0};
 
             /**
              * The number of times wait_and_pop(with_timeout)() was called
              * on the queue.
              */
-            std::atomic<int> m_pop_counter;
+            std::atomic<std::size_t> m_pop_counter{0};
 
-            /// The number of times the queue was full and a thread pushing
-            /// to the queue was blocked.
-            std::atomic<int> m_empty_counter;
-#endif
+            /// The number of times the queue was empty when a thread tried
+            /// to pop from it.
+            std::atomic<std::size_t> m_empty_counter{0};
 
         public:
 
@@ -107,16 +105,7 @@ namespace osmium {
             explicit Queue(std::size_t max_size = 0, std::string name = "") :
                 m_max_size(max_size),
                 m_name(std::move(name)),
-                m_queue()
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                ,
-                m_largest_size(0),
-                m_push_counter(0),
-                m_full_counter(0),
-                m_pop_counter(0),
-                m_empty_counter(0)
-#endif
-            {
+                m_queue() {
             }
 
             Queue(const Queue&) = delete;
@@ -146,40 +135,30 @@ namespace osmium {
              */
             void push(T value) {
                 constexpr const std::chrono::milliseconds max_wait{10};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 ++m_push_counter;
-#endif
-                if (m_max_size) {
+                if (m_max_size && size() >= m_max_size) {
+                    ++m_full_counter;
                     while (size() >= m_max_size) {
                         std::unique_lock<std::mutex> lock{m_mutex};
                         m_space_available.wait_for(lock, max_wait, [this] {
                             return m_queue.size() < m_max_size;
                         });
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
-                        ++m_full_counter;
-#endif
                     }
                 }
                 std::lock_guard<std::mutex> lock{m_mutex};
                 m_queue.push(std::move(value));
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 if (m_largest_size < m_queue.size()) {
                     m_largest_size = m_queue.size();
                 }
-#endif
                 m_data_available.notify_one();
             }
 
             void wait_and_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 ++m_pop_counter;
-#endif
                 std::unique_lock<std::mutex> lock{m_mutex};
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 if (m_queue.empty()) {
                     ++m_empty_counter;
                 }
-#endif
                 m_data_available.wait(lock, [this] {
                     return !m_queue.empty();
                 });
@@ -194,15 +173,11 @@ namespace osmium {
             }
 
             bool try_pop(T& value) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                 ++m_pop_counter;
-#endif
                 {
                     std::lock_guard<std::mutex> lock{m_mutex};
                     if (m_queue.empty()) {
-#ifdef OSMIUM_DEBUG_QUEUE_SIZE
                         ++m_empty_counter;
-#endif
                         return false;
                     }
                     value = std::move(m_queue.front());
@@ -224,6 +199,38 @@ namespace osmium {
                 return m_queue.size();
             }
 
+            /// The maximum size of this queue (0 if unlimited).
+            std::size_t max_size() const noexcept {
+                return m_max_size;
+            }
+
+            /// The largest size the queue has been so far.
+            std::size_t largest_size() const {
+                std::lock_guard<std::mutex> lock{m_mutex};
+                return m_largest_size;
+            }
+
+            /// The number of times push() was called on the queue.
+            std::size_t push_count() const noexcept {
+                return m_push_counter;
+            }
+
+            /// The number of push() calls that blocked because the queue
+            /// was full.
+            std::size_t full_count() const noexcept {
+                return m_full_counter;
+            }
+
+            /// The number of times a pop function was called on the queue.
+            std::size_t pop_count() const noexcept {
+                return m_pop_counter;
+            }
+
+            /// The number of pop calls that found the queue empty.
+            std::size_t empty_count() const noexcept {
+                return m_empty_counter;
+            }
+
         }; // class Queue
 
     } // namespace thread
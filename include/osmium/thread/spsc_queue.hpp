@@ -0,0 +1,310 @@
+#ifndef OSMIUM_THREAD_SPSC_QUEUE_HPP
+#define OSMIUM_THREAD_SPSC_QUEUE_HPP
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <utility> // IWYU pragma: keep
+
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+# include <iostream>
+#endif
+
+namespace osmium {
+
+    namespace thread {
+
+        /**
+         * A thread-safe queue for exactly one producer and one consumer
+         * thread. Pushing and popping does not need a lock, only when the
+         * queue is full (or empty) the producer (or consumer) will go to
+         * sleep on a condition variable until the other side signals it.
+         *
+         * The elements are stored in a linked list of fixed-size blocks.
+         * The producer appends to the last block, the consumer removes
+         * from the first block. One used-up block is kept around so that
+         * a steady flow of elements does not need any memory allocation.
+         *
+         * The interface is the same as that of osmium::thread::Queue, but
+         * it is the responsibility of the caller to make sure that only
+         * one thread at a time calls push() and only one thread at a time
+         * calls wait_and_pop() or try_pop().
+         */
+        template <typename T>
+        class SPSCQueue {
+
+            enum {
+                block_size = 16
+            };
+
+            struct block {
+                T slots[block_size];
+                std::atomic<block*> next{nullptr};
+            };
+
+            /// Maximum size of this queue. If the queue is full pushing to
+            /// the queue will block.
+            const std::size_t m_max_size;
+
+            /// Name of this queue (for debugging only).
+            const std::string m_name;
+
+            /// Number of elements in the queue.
+            std::atomic<std::size_t> m_size{0};
+
+            /// Block and index where the next element will be popped from.
+            /// Only used by the consumer.
+            block* m_head_block;
+            std::size_t m_head_index = 0;
+
+            /// Block and index where the next element will be pushed to.
+            /// Only used by the producer.
+            block* m_tail_block;
+            std::size_t m_tail_index = 0;
+
+            /// A used-up block handed back from the consumer for reuse.
+            std::atomic<block*> m_spare_block{nullptr};
+
+            /// Only used for sleeping and waking up threads.
+            std::mutex m_mutex;
+
+            /// Used to signal the consumer when data is available.
+            std::condition_variable m_data_available;
+
+            /// Used to signal the producer when the queue is not full.
+            std::condition_variable m_space_available;
+
+            /// Set while the consumer is (about to go) asleep.
+            std::atomic<bool> m_consumer_waiting{false};
+
+            /// Set while the producer is (about to go) asleep.
+            std::atomic<bool> m_producer_waiting{false};
+
+            /// The largest size the queue has been so far.
+            std::atomic<std::size_t> m_largest_size{0};
+
+            /// The number of times push() was called on the queue.
+            std::atomic<std::size_t> m_push_counter{0};
+
+            /// The number of times the queue was full and a thread pushing
+            /// to the queue was blocked.
+            std::atomic<std::size_t> m_full_counter{0};
+
+            /// The number of times a pop function was called on the queue.
+            std::atomic<std::size_t> m_pop_counter{0};
+
+            /// The number of times the queue was empty when a thread tried
+            /// to pop from it.
+            std::atomic<std::size_t> m_empty_counter{0};
+
+            bool is_full() const noexcept {
+                return m_max_size && m_size.load() >= m_max_size;
+            }
+
+            block* new_block() {
+                block* b = m_spare_block.exchange(nullptr);
+                if (b) {
+                    b->next.store(nullptr, std::memory_order_relaxed);
+                    return b;
+                }
+                return new block{};
+            }
+
+            void wake_up(std::atomic<bool>& waiting, std::condition_variable& cv) {
+                if (waiting.load()) {
+                    std::lock_guard<std::mutex> lock{m_mutex};
+                    cv.notify_one();
+                }
+            }
+
+            void pop_front(T& value) {
+                if (m_head_index == block_size) {
+                    block* old_block = m_head_block;
+                    m_head_block = old_block->next.load(std::memory_order_acquire);
+                    m_head_index = 0;
+                    delete m_spare_block.exchange(old_block);
+                }
+                value = std::move(m_head_block->slots[m_head_index]);
+                m_head_block->slots[m_head_index] = T{};
+                ++m_head_index;
+                m_size.fetch_sub(1);
+                wake_up(m_producer_waiting, m_space_available);
+            }
+
+        public:
+
+            /**
+             * Construct a single-producer single-consumer queue.
+             *
+             * @param max_size Maximum number of elements in the queue. Set to
+             *                 0 for an unlimited size.
+             * @param name Optional name for this queue. (Used for debugging.)
+             */
+            explicit SPSCQueue(std::size_t max_size = 0, std::string name = "") :
+                m_max_size(max_size),
+                m_name(std::move(name)),
+                m_head_block(new block{}),
+                m_tail_block(m_head_block) {
+            }
+
+            SPSCQueue(const SPSCQueue&) = delete;
+            SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+            SPSCQueue(SPSCQueue&&) = delete;
+            SPSCQueue& operator=(SPSCQueue&&) = delete;
+
+            ~SPSCQueue() {
+#ifdef OSMIUM_DEBUG_QUEUE_SIZE
+                std::cerr << "queue '" << m_name
+                          << "' with max_size=" << m_max_size
+                          << " had largest size " << m_largest_size
+                          << " and was full " << m_full_counter
+                          << " times in " << m_push_counter
+                          << " push() calls and was empty " << m_empty_counter
+                          << " times in " << m_pop_counter
+                          << " pop() calls\n";
+#endif
+                block* b = m_head_block;
+                while (b) {
+                    block* next = b->next.load();
+                    delete b;
+                    b = next;
+                }
+                delete m_spare_block.load();
+            }
+
+            /**
+             * Push an element onto the queue. If the queue has a max size,
+             * this call will block if the queue is full.
+             */
+            void push(T value) {
+                ++m_push_counter;
+                if (is_full()) {
+                    ++m_full_counter;
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_producer_waiting.store(true);
+                    m_space_available.wait(lock, [this] {
+                        return !is_full();
+                    });
+                    m_producer_waiting.store(false);
+                }
+
+                if (m_tail_index == block_size) {
+                    block* b = new_block();
+                    m_tail_block->next.store(b, std::memory_order_release);
+                    m_tail_block = b;
+                    m_tail_index = 0;
+                }
+                m_tail_block->slots[m_tail_index] = std::move(value);
+                ++m_tail_index;
+
+                const std::size_t size = m_size.fetch_add(1) + 1;
+                if (m_largest_size.load(std::memory_order_relaxed) < size) {
+                    m_largest_size.store(size, std::memory_order_relaxed);
+                }
+                wake_up(m_consumer_waiting, m_data_available);
+            }
+
+            void wait_and_pop(T& value) {
+                ++m_pop_counter;
+                if (m_size.load() == 0) {
+                    ++m_empty_counter;
+                    std::unique_lock<std::mutex> lock{m_mutex};
+                    m_consumer_waiting.store(true);
+                    m_data_available.wait(lock, [this] {
+                        return m_size.load() != 0;
+                    });
+                    m_consumer_waiting.store(false);
+                }
+                pop_front(value);
+            }
+
+            bool try_pop(T& value) {
+                ++m_pop_counter;
+                if (m_size.load() == 0) {
+                    ++m_empty_counter;
+                    return false;
+                }
+                pop_front(value);
+                return true;
+            }
+
+            bool empty() const noexcept {
+                return m_size.load() == 0;
+            }
+
+            std::size_t size() const noexcept {
+                return m_size.load();
+            }
+
+            /// The maximum size of this queue (0 if unlimited).
+            std::size_t max_size() const noexcept {
+                return m_max_size;
+            }
+
+            /// The largest size the queue has been so far.
+            std::size_t largest_size() const noexcept {
+                return m_largest_size;
+            }
+
+            /// The number of times push() was called on the queue.
+            std::size_t push_count() const noexcept {
+                return m_push_counter;
+            }
+
+            /// The number of push() calls that blocked because the queue
+            /// was full.
+            std::size_t full_count() const noexcept {
+                return m_full_counter;
+            }
+
+            /// The number of times a pop function was called on the queue.
+            std::size_t pop_count() const noexcept {
+                return m_pop_counter;
+            }
+
+            /// The number of pop calls that found the queue empty.
+            std::size_t empty_count() const noexcept {
+                return m_empty_counter;
+            }
+
+        }; // class SPSCQueue
+
+    } // namespace thread
+
+} // namespace osmium
+
+#endif // OSMIUM_THREAD_SPSC_QUEUE_HPP
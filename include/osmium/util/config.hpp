@@ -80,6 +80,43 @@ namespace osmium {
             return true;
         }
 
+        /**
+         * Should the default thread pool use work stealing? Set from the
+         * environment variable OSMIUM_POOL_WORK_STEALING. The default is
+         * false.
+         */
+        inline bool use_work_stealing_pool() noexcept {
+            auto env = osmium::detail::getenv_wrapper("OSMIUM_POOL_WORK_STEALING");
+            if (env) {
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * How the threads of the default thread pool should be pinned to
+         * CPUs. Set from the environment variable OSMIUM_POOL_AFFINITY.
+         * Returns 0 for no pinning (the default), 1 for pinning to cores
+         * ("cores"), and 2 for pinning to NUMA nodes ("numa").
+         */
+        inline int get_pool_affinity() noexcept {
+            auto env = osmium::detail::getenv_wrapper("OSMIUM_POOL_AFFINITY");
+            if (env) {
+                if (!strcasecmp(env, "cores")) {
+                    return 1;
+                }
+                if (!strcasecmp(env, "numa")) {
+                    return 2;
+                }
+            }
+            return 0;
+        }
+
         inline std::size_t get_max_queue_size(const char* queue_name, const std::size_t default_value) noexcept {
             assert(queue_name);
             std::string name{"OSMIUM_MAX_"};
@@ -103,6 +140,57 @@ namespace osmium {
             return value;
         }
 
+        /**
+         * Size of the chunks read from input files in bytes. Set from the
+         * environment variable OSMIUM_READ_SIZE (in kB). The value is
+         * rounded up to a multiple of 64 kB and limited to 1 GB. The
+         * default is 1 MB.
+         */
+        inline std::size_t get_read_size() noexcept {
+            constexpr const std::size_t kb = 1024;
+            std::size_t value = 1024;
+            auto env = osmium::detail::getenv_wrapper("OSMIUM_READ_SIZE");
+            if (env) {
+                const auto new_value = osmium::detail::str_to_int<std::size_t>(env);
+                if (new_value != 0) {
+                    value = new_value < 1024 * kb ? new_value : 1024 * kb;
+                }
+            }
+            return (value + 63) / 64 * 64 * kb;
+        }
+
+        /**
+         * How far ahead of the current position the kernel should be asked
+         * to read input files in bytes. Set from the environment variable
+         * OSMIUM_READAHEAD (in kB). The default is 0 which leaves the
+         * readahead to the kernel.
+         */
+        inline std::size_t get_readahead_size() noexcept {
+            auto env = osmium::detail::getenv_wrapper("OSMIUM_READAHEAD");
+            if (env) {
+                return osmium::detail::str_to_int<std::size_t>(env) * 1024;
+            }
+            return 0;
+        }
+
+        /**
+         * Should data already read from input files be dropped from the
+         * page cache? Set from the environment variable
+         * OSMIUM_DROP_READ_CACHE. The default is false.
+         */
+        inline bool drop_read_cache() noexcept {
+            auto env = osmium::detail::getenv_wrapper("OSMIUM_DROP_READ_CACHE");
+            if (env) {
+                if (!strcasecmp(env, "on") ||
+                    !strcasecmp(env, "true") ||
+                    !strcasecmp(env, "yes") ||
+                    !strcasecmp(env, "1")) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
     } // namespace config
 
 } // namespace osmium
@@ -40,8 +40,90 @@ DEALINGS IN THE SOFTWARE.
 #include <type_traits>
 #include <utility>
 
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(_M_X64)) && !defined(OSMIUM_NO_SIMD)
+# define OSMIUM_DELTA_USE_SSE2
+# include <emmintrin.h>
+#endif
+
 namespace osmium {
 
+    namespace detail {
+
+        template <typename TValue, typename TDelta>
+        inline TValue delta_encode_span(TValue value, const TValue* first, const TValue* last, TDelta* out) noexcept {
+            for (; first != last; ++first, ++out) {
+                *out = static_cast<TDelta>(*first) - static_cast<TDelta>(value);
+                value = *first;
+            }
+            return value;
+        }
+
+        template <typename TValue, typename TDelta>
+        inline TValue delta_decode_span(TValue value, const TDelta* first, const TDelta* last, TValue* out) noexcept {
+            for (; first != last; ++first, ++out) {
+                value = static_cast<TValue>(static_cast<TDelta>(value) + *first);
+                *out = value;
+            }
+            return value;
+        }
+
+#ifdef OSMIUM_DELTA_USE_SSE2
+        // Overloads for the common case of 64bit values and deltas.
+        // They use wrapping arithmetic, which gives the same results
+        // as the generic versions for all input without overflows.
+
+        inline int64_t delta_encode_span(int64_t value, const int64_t* first, const int64_t* last, int64_t* out) noexcept {
+            if (first == last) {
+                return value;
+            }
+            *out++ = static_cast<int64_t>(static_cast<uint64_t>(*first) - static_cast<uint64_t>(value));
+            ++first;
+
+            // Subtract each value from the one after it, two at a time.
+            for (; last - first >= 2; first += 2, out += 2) {
+                const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                const __m128i previous = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first - 1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_sub_epi64(current, previous));
+            }
+
+            if (first != last) {
+                *out = static_cast<int64_t>(static_cast<uint64_t>(*first) - static_cast<uint64_t>(first[-1]));
+                ++first;
+            }
+
+            return first[-1];
+        }
+
+        inline int64_t delta_decode_span(int64_t value, const int64_t* first, const int64_t* last, int64_t* out) noexcept {
+            // Prefix sum over four values at a time: Both halves are
+            // summed up separately, then the sum of the lower half and
+            // the running total are added to them. This shortens the
+            // dependency chain to two instructions for four values.
+            __m128i total = _mm_set1_epi64x(value);
+            for (; last - first >= 4; first += 4, out += 4) {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 2));
+                a = _mm_add_epi64(a, _mm_slli_si128(a, 8));
+                b = _mm_add_epi64(b, _mm_slli_si128(b, 8));
+                b = _mm_add_epi64(b, _mm_shuffle_epi32(a, 0xee));
+                a = _mm_add_epi64(a, total);
+                b = _mm_add_epi64(b, total);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), a);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2), b);
+                total = _mm_shuffle_epi32(b, 0xee);
+            }
+
+            uint64_t sum = static_cast<uint64_t>(_mm_cvtsi128_si64(total));
+            for (; first != last; ++first, ++out) {
+                sum += static_cast<uint64_t>(*first);
+                *out = static_cast<int64_t>(sum);
+            }
+            return static_cast<int64_t>(sum);
+        }
+#endif
+
+    } // namespace detail
+
     inline namespace util {
 
         /**
@@ -90,6 +172,21 @@ namespace osmium {
                        static_cast<TDelta>(new_value);
             }
 
+            /**
+             * Delta encode all values in [first, last) and write the
+             * deltas to out. This gives the same result as calling
+             * update() for each value, but is faster for large arrays
+             * (it uses SIMD instructions for 64bit values if available).
+             *
+             * The output must not overlap the input.
+             *
+             * @returns Iterator pointing after the last delta written.
+             */
+            TDelta* encode_span(const TValue* first, const TValue* last, TDelta* out) noexcept {
+                m_value = detail::delta_encode_span(m_value, first, last, out);
+                return out + (last - first);
+            }
+
         }; // class DeltaEncode
 
         /**
@@ -129,6 +226,21 @@ namespace osmium {
                 return m_value;
             }
 
+            /**
+             * Delta decode all deltas in [first, last) and write the
+             * values to out. This gives the same result as calling
+             * update() for each delta, but is faster for large arrays
+             * (it uses SIMD instructions for 64bit values if available).
+             *
+             * Decoding in place (out == first) is allowed.
+             *
+             * @returns Iterator pointing after the last value written.
+             */
+            TValue* decode_span(const TDelta* first, const TDelta* last, TValue* out) noexcept {
+                m_value = detail::delta_decode_span(m_value, first, last, out);
+                return out + (last - first);
+            }
+
         }; // class DeltaDecode
 
     } // namespace util
@@ -0,0 +1,234 @@
+#ifndef OSMIUM_UTIL_MEMORY_ACCOUNTING_HPP
+#define OSMIUM_UTIL_MEMORY_ACCOUNTING_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/memory/buffer.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace osmium {
+
+    /**
+     * Memory used by one source registered with MemoryAccounting.
+     */
+    struct memory_account_usage {
+
+        /// Name of the source.
+        std::string name;
+
+        /// Memory used in bytes.
+        std::size_t bytes;
+
+    }; // struct memory_account_usage
+
+    /**
+     * Keeps track of the memory used by different parts of a program.
+     *
+     * Data structures that know how much memory they use (most of them
+     * have a used_memory() function) are registered under a name, usually
+     * through a MemoryAccount object. At any time a report with the memory
+     * used by each of them can be requested. This is much more useful than
+     * just the total memory use reported by MemoryUsage when you need to
+     * find out which data structure grew too large.
+     *
+     * If libosmium was compiled with OSMIUM_WITH_MEMORY_ACCOUNTING defined,
+     * the report also contains the memory held by all buffers (see
+     * osmium::memory::buffer_memory_in_use()) under the name "buffers".
+     *
+     * The functions of this class are thread safe, but the memory use of
+     * each source is queried from the thread calling report(). Make sure
+     * the registered objects are not modified at the same time or that
+     * their used_memory() function can be called while they are.
+     */
+    class MemoryAccounting {
+
+        struct source {
+            std::size_t id;
+            std::string name;
+            std::function<std::size_t()> used_memory;
+        };
+
+        mutable std::mutex m_mutex;
+        std::vector<source> m_sources;
+        std::size_t m_next_id = 1;
+
+    public:
+
+        MemoryAccounting() = default;
+
+        /**
+         * The global instance used by MemoryAccount objects by default.
+         */
+        static MemoryAccounting& instance() {
+            static MemoryAccounting accounting;
+            return accounting;
+        }
+
+        /**
+         * Register a source of memory use.
+         *
+         * @param name Name of the source used in reports.
+         * @param used_memory Function returning the memory used in bytes.
+         * @returns Id of the source needed for removing it.
+         */
+        std::size_t add(std::string name, std::function<std::size_t()> used_memory) {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            m_sources.push_back(source{m_next_id, std::move(name), std::move(used_memory)});
+            return m_next_id++;
+        }
+
+        /**
+         * Remove a source with the given id as returned by add(). Does
+         * nothing if there is no such source.
+         */
+        void remove(std::size_t id) {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            m_sources.erase(std::remove_if(m_sources.begin(), m_sources.end(), [id](const source& s) {
+                return s.id == id;
+            }), m_sources.end());
+        }
+
+        /// The number of registered sources.
+        std::size_t size() const {
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            return m_sources.size();
+        }
+
+        /**
+         * Get the memory currently used by each source in the order they
+         * were registered. Sources with the same name are reported
+         * separately.
+         */
+        std::vector<memory_account_usage> report() const {
+            std::vector<memory_account_usage> result;
+#ifdef OSMIUM_WITH_MEMORY_ACCOUNTING
+            result.push_back(memory_account_usage{"buffers", osmium::memory::buffer_memory_in_use()});
+#endif
+            const std::lock_guard<std::mutex> lock{m_mutex};
+            for (const auto& s : m_sources) {
+                result.push_back(memory_account_usage{s.name, s.used_memory()});
+            }
+            return result;
+        }
+
+        /// The memory used by all sources together in bytes.
+        std::size_t total() const {
+            std::size_t sum = 0;
+            for (const auto& usage : report()) {
+                sum += usage.bytes;
+            }
+            return sum;
+        }
+
+        /**
+         * Print a report with the memory used by each source and the total
+         * in kB to the given stream.
+         */
+        void print(std::ostream& out) const {
+            const auto usages = report();
+
+            std::size_t width = 5;
+            std::size_t sum = 0;
+            for (const auto& usage : usages) {
+                width = std::max(width, usage.name.size());
+                sum += usage.bytes;
+            }
+
+            for (const auto& usage : usages) {
+                out << "  " << std::left << std::setw(static_cast<int>(width + 1)) << (usage.name + ':')
+                    << std::right << std::setw(10) << (usage.bytes / 1024) << " kB\n";
+            }
+            out << "  " << std::left << std::setw(static_cast<int>(width + 1)) << "total:"
+                << std::right << std::setw(10) << (sum / 1024) << " kB\n";
+        }
+
+    }; // class MemoryAccounting
+
+    /**
+     * Registers an object with a used_memory() function with a
+     * MemoryAccounting (by default the global instance) for the lifetime
+     * of this MemoryAccount object. The object must live longer than
+     * the account.
+     *
+     * @code
+     * osmium::index::map::FlexMem<...> index;
+     * osmium::MemoryAccount index_account{"location index", index};
+     * ...
+     * osmium::MemoryAccounting::instance().print(std::cerr);
+     * @endcode
+     */
+    class MemoryAccount {
+
+        MemoryAccounting* m_accounting;
+        std::size_t m_id;
+
+    public:
+
+        template <typename T>
+        MemoryAccount(std::string name, const T& object, MemoryAccounting& accounting = MemoryAccounting::instance()) :
+            m_accounting(&accounting),
+            m_id(accounting.add(std::move(name), [&object]() {
+                return static_cast<std::size_t>(object.used_memory());
+            })) {
+        }
+
+        MemoryAccount(const MemoryAccount&) = delete;
+        MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+        MemoryAccount(MemoryAccount&&) = delete;
+        MemoryAccount& operator=(MemoryAccount&&) = delete;
+
+        ~MemoryAccount() {
+            try {
+                m_accounting->remove(m_id);
+            } catch (...) {
+                // Swallow any exceptions, because a destructor should
+                // not throw.
+            }
+        }
+
+    }; // class MemoryAccount
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_MEMORY_ACCOUNTING_HPP
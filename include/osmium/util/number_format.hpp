@@ -0,0 +1,122 @@
+#ifndef OSMIUM_UTIL_NUMBER_FORMAT_HPP
+#define OSMIUM_UTIL_NUMBER_FORMAT_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace osmium {
+
+    namespace detail {
+
+        /**
+         * Returns pointer to the two ASCII digits of a number between 0
+         * and 99.
+         */
+        inline const char* two_digits(uint32_t value) noexcept {
+            static const char digits[] =
+                "00010203040506070809"
+                "10111213141516171819"
+                "20212223242526272829"
+                "30313233343536373839"
+                "40414243444546474849"
+                "50515253545556575859"
+                "60616263646566676869"
+                "70717273747576777879"
+                "80818283848586878889"
+                "90919293949596979899";
+            assert(value <= 99);
+            return digits + value * 2;
+        }
+
+        /**
+         * Write the decimal digits of value into the buffer so that the
+         * last digit is just before end, two digits per step. The buffer
+         * must be large enough (20 chars for any uint64_t).
+         *
+         * @returns Pointer to the first digit written.
+         */
+        inline char* format_uint_backwards(uint64_t value, char* end) noexcept {
+            while (value >= 100) {
+                const auto d = static_cast<uint32_t>(value % 100);
+                value /= 100;
+                end -= 2;
+                std::memcpy(end, two_digits(d), 2);
+            }
+            if (value >= 10) {
+                end -= 2;
+                std::memcpy(end, two_digits(static_cast<uint32_t>(value)), 2);
+            } else {
+                *--end = static_cast<char>('0' + value);
+            }
+            return end;
+        }
+
+        /**
+         * Write the decimal representation of value to out. The buffer
+         * must have space for 20 characters.
+         *
+         * @returns Pointer one past the last character written.
+         */
+        inline char* format_uint(uint64_t value, char* out) noexcept {
+            char temp[20];
+            char* const end = temp + sizeof(temp);
+            const char* begin = format_uint_backwards(value, end);
+            const auto size = static_cast<std::size_t>(end - begin);
+            std::memcpy(out, begin, size);
+            return out + size;
+        }
+
+        /**
+         * Write the decimal representation of value to out. The buffer
+         * must have space for 20 characters.
+         *
+         * @returns Pointer one past the last character written.
+         */
+        inline char* format_int(int64_t value, char* out) noexcept {
+            auto uvalue = static_cast<uint64_t>(value);
+            if (value < 0) {
+                *out++ = '-';
+                uvalue = 0 - uvalue;
+            }
+            return format_uint(uvalue, out);
+        }
+
+    } // namespace detail
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_NUMBER_FORMAT_HPP
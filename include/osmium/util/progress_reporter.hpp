@@ -0,0 +1,282 @@
+#ifndef OSMIUM_UTIL_PROGRESS_REPORTER_HPP
+#define OSMIUM_UTIL_PROGRESS_REPORTER_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <osmium/thread/util.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <utility>
+
+namespace osmium {
+
+    /**
+     * A snapshot of the progress as reported by the ProgressReporter.
+     */
+    struct progress_report {
+
+        /// Seconds since the reporter was started.
+        double elapsed = 0.0;
+
+        /// Number of objects counted with ProgressReporter::add().
+        uint64_t objects = 0;
+
+        /// Number of bytes read from the input so far.
+        std::size_t bytes = 0;
+
+        /// Size of the input in bytes, 0 if unknown.
+        std::size_t total_bytes = 0;
+
+        /// Average objects per second since the start.
+        double objects_per_second = 0.0;
+
+        /// Average megabytes (2^20 bytes) per second since the start.
+        double mb_per_second = 0.0;
+
+        /// Percentage of the input read, negative if unknown.
+        double percent = -1.0;
+
+        /// Estimated seconds until the end, negative if unknown.
+        double eta = -1.0;
+
+        /// Is this the last report?
+        bool done = false;
+
+    }; // struct progress_report
+
+    /**
+     * Write a progress report as one line of JSON.
+     */
+    inline void write_progress_report_json(std::ostream& out, const progress_report& report) {
+        out << "{\"elapsed_s\":" << report.elapsed
+            << ",\"objects\":" << report.objects
+            << ",\"bytes\":" << report.bytes
+            << ",\"total_bytes\":" << report.total_bytes
+            << ",\"objects_per_s\":" << report.objects_per_second
+            << ",\"mb_per_s\":" << report.mb_per_second
+            << ",\"percent\":" << report.percent
+            << ",\"eta_s\":" << report.eta
+            << ",\"done\":" << (report.done ? "true" : "false")
+            << "}\n" << std::flush;
+    }
+
+    /**
+     * Reports progress, throughput and the estimated time remaining in
+     * regular intervals from its own thread. Unlike the ProgressBar it
+     * never writes anything itself, all reports go to a callback. Use
+     * write_progress_report_json() in the callback to get JSON lines.
+     *
+     * The only thing the thread doing the work has to do is to call
+     * add() for the objects it processed, which is a single atomic
+     * increment. The input position is queried from the reporter thread.
+     *
+     * Usage:
+     * @code
+     * osmium::io::Reader reader{"input.osm.pbf"};
+     * osmium::ProgressReporter progress{reader, [](const osmium::progress_report& report) {
+     *     osmium::write_progress_report_json(std::cout, report);
+     * }};
+     * while (osmium::memory::Buffer buffer = reader.read()) {
+     *     ...
+     *     progress.add(buffer_object_count);
+     * }
+     * progress.done();
+     * @endcode
+     */
+    class ProgressReporter {
+
+    public:
+
+        using callback_type = std::function<void(const progress_report&)>;
+        using offset_function_type = std::function<std::size_t()>;
+
+    private:
+
+        using clock = std::chrono::steady_clock;
+
+        std::atomic<uint64_t> m_objects{0};
+        std::size_t m_total_bytes;
+        offset_function_type m_offset;
+        callback_type m_callback;
+        std::chrono::milliseconds m_interval;
+        clock::time_point m_start;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_done = false;
+        std::thread m_thread;
+
+        void run() {
+            osmium::thread::set_thread_name("_osmium_progr");
+            std::unique_lock<std::mutex> lock{m_mutex};
+            while (!m_cv.wait_for(lock, m_interval, [this]() { return m_done; })) {
+                lock.unlock();
+                if (m_callback) {
+                    m_callback(report(false));
+                }
+                lock.lock();
+            }
+        }
+
+    public:
+
+        /**
+         * Start reporting.
+         *
+         * @param total_bytes Size of the input, 0 if unknown.
+         * @param offset Function returning the number of bytes read so
+         *               far. It is called from the reporter thread, so it
+         *               must be thread safe.
+         * @param callback Called from the reporter thread with each
+         *                 report and from done() with the last one.
+         * @param interval Time between reports.
+         */
+        ProgressReporter(std::size_t total_bytes,
+                         offset_function_type offset,
+                         callback_type callback,
+                         std::chrono::milliseconds interval = std::chrono::milliseconds{1000}) :
+            m_total_bytes(total_bytes),
+            m_offset(std::move(offset)),
+            m_callback(std::move(callback)),
+            m_interval(interval),
+            m_start(clock::now()),
+            m_thread(&ProgressReporter::run, this) {
+        }
+
+        /**
+         * Start reporting on the progress of a Reader (or anything else
+         * with file_size() and offset() functions). The reader must
+         * outlive the reporter or done() must be called before it is
+         * destroyed.
+         */
+        template <typename TReader>
+        ProgressReporter(const TReader& reader,
+                         callback_type callback,
+                         std::chrono::milliseconds interval = std::chrono::milliseconds{1000}) :
+            ProgressReporter(reader.file_size(),
+                             [&reader]() { return reader.offset(); },
+                             std::move(callback),
+                             interval) {
+        }
+
+        ProgressReporter(const ProgressReporter&) = delete;
+        ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+        ProgressReporter(ProgressReporter&&) = delete;
+        ProgressReporter& operator=(ProgressReporter&&) = delete;
+
+        ~ProgressReporter() noexcept {
+            try {
+                done();
+            } catch (...) { // NOLINT(bugprone-empty-catch)
+                // Ignore any exceptions because destructor must not throw.
+            }
+        }
+
+        /**
+         * Count processed objects. This is the only call needed in the
+         * processing loop.
+         */
+        void add(uint64_t count = 1) noexcept {
+            m_objects.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        /**
+         * Create a report of the current progress. This is usually
+         * called from the reporter thread, but can be called from
+         * anywhere.
+         */
+        progress_report report(bool done = false) const {
+            progress_report r;
+            r.elapsed = std::chrono::duration<double>(clock::now() - m_start).count();
+            r.objects = m_objects.load(std::memory_order_relaxed);
+            if (done && m_total_bytes > 0) {
+                r.bytes = m_total_bytes;
+            } else if (m_offset) {
+                r.bytes = m_offset();
+            }
+            r.total_bytes = m_total_bytes;
+            r.done = done;
+
+            if (r.elapsed > 0.0) {
+                r.objects_per_second = static_cast<double>(r.objects) / r.elapsed;
+                r.mb_per_second = static_cast<double>(r.bytes) / r.elapsed / (1024.0 * 1024.0);
+            }
+
+            if (m_total_bytes > 0) {
+                r.percent = 100.0 * static_cast<double>(r.bytes) / static_cast<double>(m_total_bytes);
+                if (done || r.bytes >= m_total_bytes) {
+                    r.eta = 0.0;
+                } else if (r.bytes > 0) {
+                    r.eta = r.elapsed * static_cast<double>(m_total_bytes - r.bytes) / static_cast<double>(r.bytes);
+                }
+            }
+
+            return r;
+        }
+
+        /**
+         * Stop the reporter thread and send the final report to the
+         * callback. Calling this more than once has no effect. If this
+         * is not called explicitly the destructor will call it.
+         */
+        void done() {
+            {
+                const std::lock_guard<std::mutex> lock{m_mutex};
+                if (m_done) {
+                    return;
+                }
+                m_done = true;
+            }
+            m_cv.notify_all();
+            if (m_thread.joinable()) {
+                m_thread.join();
+            }
+            if (m_callback) {
+                m_callback(report(true));
+            }
+        }
+
+    }; // class ProgressReporter
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_PROGRESS_REPORTER_HPP
@@ -0,0 +1,153 @@
+#ifndef OSMIUM_UTIL_REGEX_HPP
+#define OSMIUM_UTIL_REGEX_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+/**
+ * @file
+ *
+ * This file contains the osmium::Regex class which wraps a regular
+ * expression engine chosen at compile time.
+ *
+ * If OSMIUM_WITH_RE2 is defined, the RE2 library is used and you'll
+ * need to link with `libre2`. Otherwise std::regex is used.
+ */
+
+#ifdef OSMIUM_WITH_RE2
+# include <re2/re2.h>
+# include <memory>
+# include <stdexcept>
+#else
+# include <regex>
+#endif
+
+#include <cstddef>
+#include <string>
+#include <utility>
+
+namespace osmium {
+
+    /**
+     * A compiled regular expression. Depending on the compile time
+     * configuration this uses RE2 (if OSMIUM_WITH_RE2 is defined) or
+     * std::regex. RE2 is much faster than most std::regex implementations
+     * and doesn't allocate memory when matching.
+     *
+     * Note that the syntax of the regular expressions differs slightly
+     * between the engines: std::regex uses the ECMAScript grammar, RE2
+     * doesn't support backreferences and lookaround assertions.
+     *
+     * Copies share the compiled expression with RE2, so copying is cheap.
+     */
+    class Regex {
+
+        std::string m_pattern;
+
+#ifdef OSMIUM_WITH_RE2
+        std::shared_ptr<const re2::RE2> m_regex;
+#else
+        std::regex m_regex;
+#endif
+
+    public:
+
+        /**
+         * Compile a regular expression.
+         *
+         * @param pattern The regular expression.
+         * @throws std::regex_error (std::regex) or std::invalid_argument
+         *         (RE2) if the pattern is invalid.
+         */
+        explicit Regex(std::string pattern) :
+            m_pattern(std::move(pattern)) {
+#ifdef OSMIUM_WITH_RE2
+            re2::RE2::Options options;
+            options.set_log_errors(false);
+            m_regex = std::make_shared<const re2::RE2>(m_pattern, options);
+            if (!m_regex->ok()) {
+                throw std::invalid_argument{"invalid regex '" + m_pattern + "': " + m_regex->error()};
+            }
+#else
+            m_regex = std::regex{m_pattern};
+#endif
+        }
+
+        explicit Regex(const char* pattern) :
+            Regex(std::string{pattern}) {
+        }
+
+        /// The pattern this regular expression was created from.
+        const std::string& pattern() const noexcept {
+            return m_pattern;
+        }
+
+        /**
+         * Does the regular expression match any part of the string?
+         */
+        bool search(const char* str) const {
+#ifdef OSMIUM_WITH_RE2
+            return re2::RE2::PartialMatch(str, *m_regex);
+#else
+            return std::regex_search(str, m_regex);
+#endif
+        }
+
+        /**
+         * Does the regular expression match any part of the string with
+         * the given size?
+         */
+        bool search(const char* str, std::size_t size) const {
+#ifdef OSMIUM_WITH_RE2
+            return re2::RE2::PartialMatch(re2::StringPiece(str, size), *m_regex);
+#else
+            return std::regex_search(str, str + size, m_regex);
+#endif
+        }
+
+        /**
+         * Does the regular expression match the whole string?
+         */
+        bool full_match(const char* str) const {
+#ifdef OSMIUM_WITH_RE2
+            return re2::RE2::FullMatch(str, *m_regex);
+#else
+            return std::regex_match(str, m_regex);
+#endif
+        }
+
+    }; // class Regex
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_REGEX_HPP
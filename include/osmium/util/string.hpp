@@ -34,11 +34,36 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <cstddef>
+#include <cstring>
 #include <string>
 #include <vector>
 
 namespace osmium {
 
+    namespace detail {
+
+        struct c_string_hash {
+
+            std::size_t operator()(const char* str) const noexcept {
+                std::size_t hash = 5381;
+                for (; *str; ++str) {
+                    hash = hash * 33U + static_cast<unsigned char>(*str);
+                }
+                return hash;
+            }
+
+        }; // struct c_string_hash
+
+        struct c_string_equal {
+
+            bool operator()(const char* lhs, const char* rhs) const noexcept {
+                return !std::strcmp(lhs, rhs);
+            }
+
+        }; // struct c_string_equal
+
+    } // namespace detail
+
     /**
      * Split string on the separator character.
      *
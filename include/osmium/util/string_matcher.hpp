@@ -33,8 +33,14 @@ DEALINGS IN THE SOFTWARE.
 
 */
 
+#include <osmium/util/regex.hpp>
+#include <osmium/util/string_view.hpp>
+
 #include <boost/variant.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <iosfwd>
 #include <regex>
@@ -67,6 +73,177 @@ DEALINGS IN THE SOFTWARE.
 
 namespace osmium {
 
+    namespace detail {
+
+        /**
+         * Aho-Corasick automaton for checking whether any of a set of
+         * strings occurs in a text. The time needed is linear in the
+         * length of the text and independent of the number of strings.
+         *
+         * Transitions are stored sparsely (sorted by byte) in one array
+         * so memory use is proportional to the total length of the
+         * strings. Only the transitions from the root state, which are
+         * used most often, are stored in a full table.
+         */
+        class aho_corasick {
+
+            struct edge {
+                unsigned char byte;
+                uint32_t target;
+            };
+
+            std::vector<uint32_t> m_root_table;
+            std::vector<uint32_t> m_edges_begin;
+            std::vector<edge> m_edges;
+            std::vector<uint32_t> m_fail;
+            std::vector<bool> m_terminal;
+
+            // Returns the target state or 0 if there is no transition.
+            uint32_t child(uint32_t state, unsigned char byte) const noexcept {
+                if (state == 0) {
+                    return m_root_table[byte];
+                }
+                const auto begin = m_edges.begin() + m_edges_begin[state];
+                const auto end = m_edges.begin() + m_edges_begin[state + 1];
+                const auto it = std::lower_bound(begin, end, byte, [](const edge& e, unsigned char b) {
+                    return e.byte < b;
+                });
+                return (it != end && it->byte == byte) ? it->target : 0;
+            }
+
+        public:
+
+            aho_corasick() = default;
+
+            template <typename TIterator>
+            aho_corasick(TIterator begin, TIterator end) {
+                using edges_type = std::vector<edge>;
+                std::vector<edges_type> children(1);
+                m_terminal.push_back(false);
+
+                const auto find_child = [&children](uint32_t state, unsigned char byte) -> uint32_t {
+                    for (const auto& e : children[state]) {
+                        if (e.byte == byte) {
+                            return e.target;
+                        }
+                    }
+                    return 0;
+                };
+
+                for (; begin != end; ++begin) {
+                    uint32_t state = 0;
+                    for (const char c : *begin) {
+                        const auto byte = static_cast<unsigned char>(c);
+                        uint32_t next = find_child(state, byte);
+                        if (next == 0) {
+                            next = static_cast<uint32_t>(children.size());
+                            children[state].push_back(edge{byte, next});
+                            children.emplace_back();
+                            m_terminal.push_back(false);
+                        }
+                        state = next;
+                    }
+                    m_terminal[state] = true;
+                }
+
+                // Breadth-first search to set the failure links. A state
+                // is terminal if any state on its failure chain is.
+                m_fail.assign(children.size(), 0);
+                std::vector<uint32_t> queue;
+                queue.reserve(children.size());
+                for (const auto& e : children[0]) {
+                    queue.push_back(e.target);
+                }
+                for (std::size_t n = 0; n < queue.size(); ++n) {
+                    const uint32_t state = queue[n];
+                    for (const auto& e : children[state]) {
+                        uint32_t f = m_fail[state];
+                        while (f != 0 && find_child(f, e.byte) == 0) {
+                            f = m_fail[f];
+                        }
+                        m_fail[e.target] = find_child(f, e.byte);
+                        if (m_terminal[m_fail[e.target]]) {
+                            m_terminal[e.target] = true;
+                        }
+                        queue.push_back(e.target);
+                    }
+                }
+
+                m_root_table.assign(256, 0);
+                for (const auto& e : children[0]) {
+                    m_root_table[e.byte] = e.target;
+                }
+
+                m_edges_begin.reserve(children.size() + 1);
+                for (auto& edges : children) {
+                    std::sort(edges.begin(), edges.end(), [](const edge& a, const edge& b) {
+                        return a.byte < b.byte;
+                    });
+                    m_edges_begin.push_back(static_cast<uint32_t>(m_edges.size()));
+                    m_edges.insert(m_edges.end(), edges.begin(), edges.end());
+                }
+                m_edges_begin.push_back(static_cast<uint32_t>(m_edges.size()));
+            }
+
+            uint32_t step(uint32_t state, const char c) const noexcept {
+                const auto byte = static_cast<unsigned char>(c);
+                uint32_t next = child(state, byte);
+                while (next == 0 && state != 0) {
+                    state = m_fail[state];
+                    next = child(state, byte);
+                }
+                return next;
+            }
+
+            /**
+             * Does any of the strings occur in the text?
+             */
+            bool search(const char* text) const noexcept {
+                if (m_terminal.empty()) {
+                    return false;
+                }
+                if (m_terminal[0]) { // the empty string is in the set
+                    return true;
+                }
+
+                uint32_t state = 0;
+                for (; *text; ++text) {
+                    state = step(state, *text);
+                    if (m_terminal[state]) {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            /**
+             * Does any of the strings occur in the text with the given
+             * size?
+             */
+            bool search(const char* text, std::size_t size) const noexcept {
+                if (m_terminal.empty()) {
+                    return false;
+                }
+                if (m_terminal[0]) { // the empty string is in the set
+                    return true;
+                }
+
+                uint32_t state = 0;
+                for (const char* end = text + size; text != end; ++text) {
+                    state = step(state, *text);
+                    if (m_terminal[state]) {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+        }; // class aho_corasick
+
+    } // namespace detail
+
     /**
      * Implements various string matching functions.
      */
@@ -89,6 +266,10 @@ namespace osmium {
                 return false;
             }
 
+            bool match(const osmium::string_view& /*test_string*/) const noexcept {
+                return false;
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "always_false";
@@ -107,6 +288,10 @@ namespace osmium {
                 return true;
             }
 
+            bool match(const osmium::string_view& /*test_string*/) const noexcept {
+                return true;
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "always_true";
@@ -131,10 +316,18 @@ namespace osmium {
                 m_str(str) {
             }
 
+            const std::string& str() const noexcept {
+                return m_str;
+            }
+
             bool match(const char* test_string) const noexcept {
                 return !std::strcmp(m_str.c_str(), test_string);
             }
 
+            bool match(const osmium::string_view& test_string) const noexcept {
+                return osmium::string_view{m_str} == test_string;
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "equal[" << m_str << ']';
@@ -163,6 +356,10 @@ namespace osmium {
                 return m_str.compare(0, std::string::npos, test_string, 0, m_str.size()) == 0;
             }
 
+            bool match(const osmium::string_view& test_string) const noexcept {
+                return test_string.starts_with(m_str);
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "prefix[" << m_str << ']';
@@ -191,6 +388,11 @@ namespace osmium {
                 return std::strstr(test_string, m_str.c_str()) != nullptr;
             }
 
+            bool match(const osmium::string_view& test_string) const noexcept {
+                return m_str.empty() ||
+                       std::search(test_string.begin(), test_string.end(), m_str.cbegin(), m_str.cend()) != test_string.end();
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "substring[" << m_str << ']';
@@ -216,6 +418,10 @@ namespace osmium {
                 return std::regex_search(test_string, m_regex);
             }
 
+            bool match(const osmium::string_view& test_string) const noexcept {
+                return std::regex_search(test_string.begin(), test_string.end(), m_regex);
+            }
+
             template <typename TChar, typename TTraits>
             void print(std::basic_ostream<TChar, TTraits>& out) const {
                 out << "regex";
@@ -224,6 +430,45 @@ namespace osmium {
         }; // class regex
 #endif
 
+        /**
+         * Matches if the test string matches the regular expression.
+         * Uses osmium::Regex which uses the RE2 library if
+         * OSMIUM_WITH_RE2 is defined. This is much faster than the
+         * std::regex based regex matcher.
+         */
+        class compiled_regex : public matcher {
+
+            osmium::Regex m_regex;
+
+        public:
+
+            explicit compiled_regex(osmium::Regex regex) :
+                m_regex(std::move(regex)) {
+            }
+
+            explicit compiled_regex(const char* pattern) :
+                m_regex(pattern) {
+            }
+
+            explicit compiled_regex(const std::string& pattern) :
+                m_regex(pattern) {
+            }
+
+            bool match(const char* test_string) const noexcept {
+                return m_regex.search(test_string);
+            }
+
+            bool match(const osmium::string_view& test_string) const noexcept {
+                return m_regex.search(test_string.data(), test_string.size());
+            }
+
+            template <typename TChar, typename TTraits>
+            void print(std::basic_ostream<TChar, TTraits>& out) const {
+                out << "compiled_regex[" << m_regex.pattern() << ']';
+            }
+
+        }; // class compiled_regex
+
         /**
          * Matches if the test string is equal to any of the stored strings.
          */
@@ -231,32 +476,64 @@ namespace osmium {
 
             std::vector<std::string> m_strings;
 
+            // Indexes into m_strings in sorted order of the strings
+            std::vector<std::size_t> m_sorted;
+
+            bool less(std::size_t index, const char* str) const noexcept {
+                return std::strcmp(m_strings[index].c_str(), str) < 0;
+            }
+
+            void add_to_index(std::size_t index) {
+                const char* str = m_strings[index].c_str();
+                const auto it = std::lower_bound(m_sorted.begin(), m_sorted.end(), str, [this](std::size_t i, const char* s) {
+                    return less(i, s);
+                });
+                m_sorted.insert(it, index);
+            }
+
         public:
 
             explicit list() = default;
 
             explicit list(std::vector<std::string> strings) :
                 m_strings(std::move(strings)) {
+                m_sorted.reserve(m_strings.size());
+                for (std::size_t n = 0; n < m_strings.size(); ++n) {
+                    m_sorted.push_back(n);
+                }
+                std::sort(m_sorted.begin(), m_sorted.end(), [this](std::size_t a, std::size_t b) {
+                    return m_strings[a] < m_strings[b];
+                });
             }
 
             list& add_string(const char* str) {
                 m_strings.emplace_back(str);
+                add_to_index(m_strings.size() - 1);
                 return *this;
             }
 
             list& add_string(const std::string& str) {
                 m_strings.push_back(str);
+                add_to_index(m_strings.size() - 1);
                 return *this;
             }
 
+            const std::vector<std::string>& strings() const noexcept {
+                return m_strings;
+            }
+
             bool match(const char* test_string) const noexcept {
-                for (const auto& s : m_strings) {
-                    if (!std::strcmp(s.c_str(), test_string)) {
-                        return true;
-                    }
-                }
-                return false;
+                const auto it = std::lower_bound(m_sorted.begin(), m_sorted.end(), test_string, [this](std::size_t i, const char* s) {
+                    return less(i, s);
+                });
+                return it != m_sorted.end() && !std::strcmp(m_strings[*it].c_str(), test_string);
+            }
 
+            bool match(const osmium::string_view& test_string) const noexcept {
+                const auto it = std::lower_bound(m_sorted.begin(), m_sorted.end(), test_string, [this](std::size_t i, const osmium::string_view& s) {
+                    return osmium::string_view{m_strings[i]} < s;
+                });
+                return it != m_sorted.end() && osmium::string_view{m_strings[*it]} == test_string;
             }
 
             template <typename TChar, typename TTraits>
@@ -270,6 +547,46 @@ namespace osmium {
 
         }; // class list
 
+        /**
+         * Matches if any of the stored strings is a substring of the
+         * test string. Uses an Aho-Corasick automaton, so matching is
+         * fast even for thousands of strings.
+         */
+        class substring_list : public matcher {
+
+            std::vector<std::string> m_strings;
+            osmium::detail::aho_corasick m_automaton;
+
+        public:
+
+            explicit substring_list(std::vector<std::string> strings) :
+                m_strings(std::move(strings)),
+                m_automaton(m_strings.cbegin(), m_strings.cend()) {
+            }
+
+            const std::vector<std::string>& strings() const noexcept {
+                return m_strings;
+            }
+
+            bool match(const char* test_string) const noexcept {
+                return m_automaton.search(test_string);
+            }
+
+            bool match(const osmium::string_view& test_string) const noexcept {
+                return m_automaton.search(test_string.data(), test_string.size());
+            }
+
+            template <typename TChar, typename TTraits>
+            void print(std::basic_ostream<TChar, TTraits>& out) const {
+                out << "substring_list[";
+                for (const auto& s : m_strings) {
+                    out << '[' << s << ']';
+                }
+                out << ']';
+            }
+
+        }; // class substring_list
+
     private:
 
         using matcher_type = boost::variant<always_false,
@@ -280,17 +597,20 @@ namespace osmium {
 #ifdef OSMIUM_WITH_REGEX
                                             regex,
 #endif
-                                            list>;
+                                            compiled_regex,
+                                            list,
+                                            substring_list>;
 
         matcher_type m_matcher;
 
+        template <typename TString>
         class match_visitor : public boost::static_visitor<bool> {
 
-            const char* m_str;
+            const TString& m_str;
 
         public:
 
-            explicit match_visitor(const char* str) noexcept :
+            explicit match_visitor(const TString& str) noexcept :
                 m_str(str) {
             }
 
@@ -372,6 +692,15 @@ namespace osmium {
         }
 #endif
 
+        /**
+         * Create a string matcher that will match the specified regex.
+         * Shortcut for
+         * @code StringMatcher{StringMatcher::compiled_regex{aregex}}; @endcode
+         */
+        StringMatcher(const osmium::Regex& aregex) : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
+            m_matcher(compiled_regex{aregex}) {
+        }
+
         /**
          * Create a string matcher that will match if any of the strings
          * match.
@@ -387,7 +716,8 @@ namespace osmium {
          *
          * @tparam TMatcher Must be one of the matcher classes
          *                  osmium::StringMatcher::always_false, always_true,
-         *                  equal, prefix, substring, regex or list.
+         *                  equal, prefix, substring, regex,
+         *                  compiled_regex, list or substring_list.
          */
         template <typename TMatcher, typename X = typename std::enable_if<
             std::is_base_of<matcher, TMatcher>::value, void>::type>
@@ -395,11 +725,31 @@ namespace osmium {
             m_matcher(std::forward<TMatcher>(matcher)) {
         }
 
+        /**
+         * Get the matcher of the specified type.
+         *
+         * @tparam TMatcher One of the matcher classes.
+         * @returns Pointer to the matcher or nullptr if this StringMatcher
+         *          uses a different kind of matcher.
+         */
+        template <typename TMatcher>
+        const TMatcher* get() const noexcept {
+            return boost::get<TMatcher>(&m_matcher);
+        }
+
         /**
          * Match the specified string.
          */
         bool operator()(const char* str) const noexcept {
-            return boost::apply_visitor(match_visitor{str}, m_matcher);
+            return boost::apply_visitor(match_visitor<const char*>{str}, m_matcher);
+        }
+
+        /**
+         * Match the specified string. This uses the length of the string
+         * and doesn't need a null-terminated string.
+         */
+        bool operator()(const osmium::string_view& str) const noexcept {
+            return boost::apply_visitor(match_visitor<osmium::string_view>{str}, m_matcher);
         }
 
         /**
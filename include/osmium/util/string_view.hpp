@@ -0,0 +1,158 @@
+#ifndef OSMIUM_UTIL_STRING_VIEW_HPP
+#define OSMIUM_UTIL_STRING_VIEW_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iosfwd>
+#include <string>
+
+namespace osmium {
+
+    /**
+     * A non-owning reference to a string with known length. This is a
+     * small subset of C++17 std::string_view for use in C++11 code.
+     *
+     * The views returned by the accessors of OSM objects (for instance
+     * OSMObject::user_view()) always point into null-terminated strings,
+     * so data() can be used as C string for those.
+     */
+    class string_view {
+
+        const char* m_data = "";
+        std::size_t m_size = 0;
+
+    public:
+
+        constexpr string_view() noexcept = default;
+
+        constexpr string_view(const char* data, std::size_t size) noexcept :
+            m_data(data),
+            m_size(size) {
+        }
+
+        string_view(const char* str) noexcept : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
+            m_data(str),
+            m_size(std::strlen(str)) {
+        }
+
+        string_view(const std::string& str) noexcept : // NOLINT(google-explicit-constructor, hicpp-explicit-conversions)
+            m_data(str.data()),
+            m_size(str.size()) {
+        }
+
+        constexpr const char* data() const noexcept {
+            return m_data;
+        }
+
+        constexpr std::size_t size() const noexcept {
+            return m_size;
+        }
+
+        constexpr std::size_t length() const noexcept {
+            return m_size;
+        }
+
+        constexpr bool empty() const noexcept {
+            return m_size == 0;
+        }
+
+        constexpr const char* begin() const noexcept {
+            return m_data;
+        }
+
+        constexpr const char* end() const noexcept {
+            return m_data + m_size;
+        }
+
+        constexpr char operator[](std::size_t pos) const noexcept {
+            return m_data[pos];
+        }
+
+        /// Compare like std::string::compare().
+        int compare(const string_view& other) const noexcept {
+            const int result = m_size == 0 || other.m_size == 0 ? 0 : std::memcmp(m_data, other.m_data, std::min(m_size, other.m_size));
+            if (result != 0) {
+                return result;
+            }
+            if (m_size == other.m_size) {
+                return 0;
+            }
+            return m_size < other.m_size ? -1 : 1;
+        }
+
+        /// Does this string start with the other string?
+        bool starts_with(const string_view& other) const noexcept {
+            return m_size >= other.m_size && (other.m_size == 0 || !std::memcmp(m_data, other.m_data, other.m_size));
+        }
+
+        /// Copy into a std::string.
+        std::string to_string() const {
+            return std::string(m_data, m_size);
+        }
+
+    }; // class string_view
+
+    inline bool operator==(const string_view& lhs, const string_view& rhs) noexcept {
+        return lhs.size() == rhs.size() && (lhs.empty() || !std::memcmp(lhs.data(), rhs.data(), lhs.size()));
+    }
+
+    inline bool operator!=(const string_view& lhs, const string_view& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+    inline bool operator<(const string_view& lhs, const string_view& rhs) noexcept {
+        return lhs.compare(rhs) < 0;
+    }
+
+    template <typename TChar, typename TTraits>
+    inline std::basic_ostream<TChar, TTraits>& operator<<(std::basic_ostream<TChar, TTraits>& out, const string_view& str) {
+        return out.write(str.data(), static_cast<std::streamsize>(str.size()));
+    }
+
+    namespace detail {
+
+        // View on a string stored in an OSM item with the given size
+        // including the terminating null character. Cleared strings (see
+        // OSMObject::clear_user()) are zeroed but keep their size.
+        inline string_view stored_string_view(const char* str, std::size_t size_with_null) noexcept {
+            return string_view{str, (size_with_null > 1 && *str) ? size_with_null - 1 : 0};
+        }
+
+    } // namespace detail
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_STRING_VIEW_HPP
@@ -0,0 +1,351 @@
+#ifndef OSMIUM_UTIL_TRACE_HPP
+#define OSMIUM_UTIL_TRACE_HPP
+
+
+/*
+
+This file is part of Osmium (https://osmcode.org/libosmium).
+
+Copyright 2013-2018 Jochen Topf <jochen@topf.org> and others (see README).
+
+Boost Software License - Version 1.0 - August 17th, 2003
+
+Permission is hereby granted, free of charge, to any person or organization
+obtaining a copy of the software and accompanying documentation covered by
+this license (the "Software") to use, reproduce, display, distribute,
+execute, and transmit the Software, and to prepare derivative works of the
+Software, and to permit third-parties to whom the Software is furnished to
+do so, all subject to the following:
+
+The copyright notices in the Software and this entire statement, including
+the above license grant, this restriction and the following disclaimer,
+must be included in all copies of the Software, in whole or in part, and
+all derivative works of the Software, unless such copies or derivative
+works are solely in the form of machine-executable object code generated by
+a source language processor.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+DEALINGS IN THE SOFTWARE.
+
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef OSMIUM_WITH_TRACING
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+#ifndef _WIN32
+# include <unistd.h>
+#endif
+
+#endif
+
+namespace osmium {
+
+    /**
+     * @brief Lightweight tracing of the stages of the IO pipeline.
+     *
+     * Tracing is compiled in only if OSMIUM_WITH_TRACING is defined before
+     * any Osmium header is included. Otherwise all functions in here do
+     * nothing and the spans are optimized away.
+     *
+     * If enabled, every Span records an event with its name, the thread
+     * it was created in, and its start time and duration. The events can
+     * be written out in the Chrome trace event format with
+     * write_chrome_trace() to be looked at in chrome://tracing or
+     * Perfetto. Additionally the spans can be written as markers to the
+     * kernel trace_marker file (see open_trace_marker()), so that they
+     * show up in perf or trace-cmd recordings.
+     */
+    namespace trace {
+
+        using clock = std::chrono::steady_clock;
+
+        /**
+         * A recorded span. The name must be a string with static
+         * lifetime (usually a string literal).
+         */
+        struct event {
+            const char* name;
+            uint32_t thread;
+            clock::time_point start;
+            clock::duration duration;
+        }; // struct event
+
+#ifdef OSMIUM_WITH_TRACING
+
+        /// Is tracing compiled in?
+        constexpr bool enabled() noexcept {
+            return true;
+        }
+
+        namespace detail {
+
+            struct thread_events {
+                std::mutex mutex;
+                std::vector<event> events;
+                uint32_t thread;
+
+                explicit thread_events(uint32_t id) :
+                    thread(id) {
+                }
+            }; // struct thread_events
+
+            struct registry {
+                std::mutex mutex;
+                std::vector<std::shared_ptr<thread_events>> threads;
+                std::FILE* marker = nullptr;
+                clock::time_point epoch = clock::now();
+            }; // struct registry
+
+            inline registry& get_registry() {
+                static registry r;
+                return r;
+            }
+
+            /**
+             * Get the event list of the current thread, it is registered
+             * when this is first called in a thread. The list is kept
+             * alive by the registry after the thread ends.
+             */
+            inline thread_events& current_thread_events() {
+                static thread_local std::shared_ptr<thread_events> events;
+                if (!events) {
+                    auto& r = get_registry();
+                    const std::lock_guard<std::mutex> lock{r.mutex};
+                    events = std::make_shared<thread_events>(static_cast<uint32_t>(r.threads.size()));
+                    r.threads.push_back(events);
+                }
+                return *events;
+            }
+
+            inline void write_marker(const std::string& str) noexcept {
+                auto& r = get_registry();
+                const std::lock_guard<std::mutex> lock{r.mutex};
+                if (r.marker) {
+                    std::fwrite(str.data(), 1, str.size(), r.marker);
+                    std::fflush(r.marker);
+                }
+            }
+
+            inline bool has_marker() noexcept {
+                auto& r = get_registry();
+                const std::lock_guard<std::mutex> lock{r.mutex};
+                return r.marker != nullptr;
+            }
+
+            inline std::string process_id() {
+#ifndef _WIN32
+                return std::to_string(::getpid());
+#else
+                return "0";
+#endif
+            }
+
+            // Format nanoseconds as microseconds with three decimals.
+            inline std::string format_microseconds(int64_t ns) {
+                std::string frac = std::to_string(1000 + ns % 1000);
+                return std::to_string(ns / 1000) + "." + frac.substr(1);
+            }
+
+        } // namespace detail
+
+        /**
+         * Record a span with explicit start and end times. Use this if
+         * the span can not be expressed as a scope.
+         */
+        inline void add(const char* name, clock::time_point start, clock::time_point end) {
+            auto& te = detail::current_thread_events();
+            const std::lock_guard<std::mutex> lock{te.mutex};
+            te.events.push_back(event{name, te.thread, start, end - start});
+        }
+
+        /**
+         * Get all events recorded so far in all threads sorted by start
+         * time.
+         */
+        inline std::vector<event> events() {
+            std::vector<event> result;
+            auto& r = detail::get_registry();
+            const std::lock_guard<std::mutex> lock{r.mutex};
+            for (const auto& te : r.threads) {
+                const std::lock_guard<std::mutex> tlock{te->mutex};
+                result.insert(result.end(), te->events.begin(), te->events.end());
+            }
+            std::sort(result.begin(), result.end(), [](const event& a, const event& b) {
+                return a.start < b.start;
+            });
+            return result;
+        }
+
+        /**
+         * Remove all events recorded so far.
+         */
+        inline void clear() {
+            auto& r = detail::get_registry();
+            const std::lock_guard<std::mutex> lock{r.mutex};
+            for (const auto& te : r.threads) {
+                const std::lock_guard<std::mutex> tlock{te->mutex};
+                te->events.clear();
+            }
+        }
+
+        /**
+         * Write all spans into the kernel trace_marker file (from
+         * ftrace) in addition to recording them. The markers use the
+         * systrace format ("B|pid|name" and "E|pid") understood by
+         * Perfetto and visible as ftrace:print events in perf.
+         *
+         * @param filename The trace_marker file.
+         * @returns true if the file could be opened.
+         */
+        inline bool open_trace_marker(const std::string& filename = "/sys/kernel/tracing/trace_marker") {
+            std::FILE* file = std::fopen(filename.c_str(), "w");
+            if (!file) {
+                return false;
+            }
+            auto& r = detail::get_registry();
+            const std::lock_guard<std::mutex> lock{r.mutex};
+            if (r.marker) {
+                std::fclose(r.marker);
+            }
+            r.marker = file;
+            return true;
+        }
+
+        /**
+         * Stop writing spans to the trace_marker file.
+         */
+        inline void close_trace_marker() {
+            auto& r = detail::get_registry();
+            const std::lock_guard<std::mutex> lock{r.mutex};
+            if (r.marker) {
+                std::fclose(r.marker);
+                r.marker = nullptr;
+            }
+        }
+
+        /**
+         * Records the time between its construction and destruction as
+         * an event with the given name.
+         */
+        class Span {
+
+            const char* m_name;
+            clock::time_point m_start;
+
+        public:
+
+            explicit Span(const char* name) :
+                m_name(name) {
+                if (detail::has_marker()) {
+                    detail::write_marker(std::string{"B|"} + detail::process_id() + "|" + name);
+                }
+                m_start = clock::now();
+            }
+
+            Span(const Span&) = delete;
+            Span& operator=(const Span&) = delete;
+
+            Span(Span&&) = delete;
+            Span& operator=(Span&&) = delete;
+
+            ~Span() noexcept {
+                try {
+                    add(m_name, m_start, clock::now());
+                    if (detail::has_marker()) {
+                        detail::write_marker(std::string{"E|"} + detail::process_id());
+                    }
+                } catch (...) { // NOLINT(bugprone-empty-catch)
+                    // ignore, tracing must never break the pipeline
+                }
+            }
+
+        }; // class Span
+
+        /**
+         * Write all recorded events as JSON in the Chrome trace event
+         * format. Times are in microseconds since the start of the
+         * program.
+         */
+        inline void write_chrome_trace(std::ostream& out) {
+            const auto all = events();
+            const auto epoch = detail::get_registry().epoch;
+            const auto pid = detail::process_id();
+
+            out << "{\"traceEvents\":[";
+            bool first = true;
+            for (const auto& e : all) {
+                if (!first) {
+                    out << ',';
+                }
+                first = false;
+                const auto ts = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(e.start - epoch).count());
+                const auto dur = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(e.duration).count());
+                out << "\n{\"name\":\"" << e.name
+                    << "\",\"ph\":\"X\",\"ts\":" << detail::format_microseconds(ts)
+                    << ",\"dur\":" << detail::format_microseconds(dur)
+                    << ",\"pid\":" << pid
+                    << ",\"tid\":" << e.thread
+                    << '}';
+            }
+            out << "\n]}\n";
+        }
+
+#else
+
+        /// Is tracing compiled in?
+        constexpr bool enabled() noexcept {
+            return false;
+        }
+
+        inline void add(const char* /*name*/, clock::time_point /*start*/, clock::time_point /*end*/) noexcept {
+        }
+
+        inline std::vector<event> events() {
+            return {};
+        }
+
+        inline void clear() noexcept {
+        }
+
+        inline bool open_trace_marker(const std::string& /*filename*/ = "") noexcept {
+            return false;
+        }
+
+        inline void close_trace_marker() noexcept {
+        }
+
+        class Span {
+
+        public:
+
+            explicit Span(const char* /*name*/) noexcept {
+            }
+
+        }; // class Span
+
+        inline void write_chrome_trace(std::ostream& out) {
+            out << "{\"traceEvents\":[]}\n";
+        }
+
+#endif
+
+    } // namespace trace
+
+} // namespace osmium
+
+#endif // OSMIUM_UTIL_TRACE_HPP
@@ -34,12 +34,16 @@ DEALINGS IN THE SOFTWARE.
 */
 
 #include <osmium/fwd.hpp>
+#include <osmium/handler.hpp>
 #include <osmium/io/reader_iterator.hpp> // IWYU pragma: keep
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm.hpp>
 #include <osmium/osm/entity.hpp>
+#include <osmium/osm/entity_bits.hpp>
 #include <osmium/osm/item_type.hpp>
 
+#include <cstddef>
+#include <initializer_list>
 #include <type_traits>
 #include <utility>
 
@@ -198,6 +202,142 @@ namespace osmium {
             }
         }
 
+        /**
+         * Does THandler have its own version of the callback or is it the
+         * one inherited from osmium::handler::Handler? Handlers with
+         * overloaded or templated callbacks count as having their own.
+         */
+#define OSMIUM_HANDLER_OVERRIDES(callback) \
+        template <typename THandler, typename = void> \
+        struct handler_overrides_##callback : std::true_type {}; \
+        template <typename THandler> \
+        struct handler_overrides_##callback<THandler, typename std::enable_if<std::is_same<decltype(&THandler::callback), decltype(&osmium::handler::Handler::callback)>::value>::type> : std::false_type {};
+
+        OSMIUM_HANDLER_OVERRIDES(osm_object)
+        OSMIUM_HANDLER_OVERRIDES(node)
+        OSMIUM_HANDLER_OVERRIDES(way)
+        OSMIUM_HANDLER_OVERRIDES(relation)
+        OSMIUM_HANDLER_OVERRIDES(area)
+        OSMIUM_HANDLER_OVERRIDES(changeset)
+
+#undef OSMIUM_HANDLER_OVERRIDES
+
+        /**
+         * The osm_entity_bits of the entities for which THandler has
+         * callbacks.
+         */
+        template <typename THandler>
+        struct handler_entity_bits {
+
+            using handler_type = typename std::decay<THandler>::type;
+
+            static constexpr const unsigned int value =
+                (handler_overrides_osm_object<handler_type>::value ? static_cast<unsigned int>(osmium::osm_entity_bits::object) : 0U) |
+                (handler_overrides_node<handler_type>::value ? static_cast<unsigned int>(osmium::osm_entity_bits::node) : 0U) |
+                (handler_overrides_way<handler_type>::value ? static_cast<unsigned int>(osmium::osm_entity_bits::way) : 0U) |
+                (handler_overrides_relation<handler_type>::value ? static_cast<unsigned int>(osmium::osm_entity_bits::relation) : 0U) |
+                (handler_overrides_area<handler_type>::value ? static_cast<unsigned int>(osmium::osm_entity_bits::area) : 0U) |
+                (handler_overrides_changeset<handler_type>::value ? static_cast<unsigned int>(osmium::osm_entity_bits::changeset) : 0U);
+
+        }; // struct handler_entity_bits
+
+        template <typename THandler>
+        constexpr const unsigned int handler_entity_bits<THandler>::value;
+
+        inline constexpr unsigned int handlers_entity_bits() noexcept {
+            return 0;
+        }
+
+        template <typename THandler, typename... THandlers>
+        inline constexpr unsigned int handlers_entity_bits(THandler* /*handler*/, THandlers*... handlers) noexcept {
+            return handler_entity_bits<THandler>::value | handlers_entity_bits(handlers...);
+        }
+
+        /**
+         * The only entity type the handlers have callbacks for. This is
+         * void if they need several types and std::nullptr_t if they need
+         * none.
+         */
+        template <unsigned int TBits>
+        struct single_entity_type {
+            using type = void;
+        };
+
+        template <>
+        struct single_entity_type<osmium::osm_entity_bits::nothing> {
+            using type = std::nullptr_t;
+        };
+
+        template <>
+        struct single_entity_type<osmium::osm_entity_bits::node> {
+            using type = osmium::Node;
+        };
+
+        template <>
+        struct single_entity_type<osmium::osm_entity_bits::way> {
+            using type = osmium::Way;
+        };
+
+        template <>
+        struct single_entity_type<osmium::osm_entity_bits::relation> {
+            using type = osmium::Relation;
+        };
+
+        template <>
+        struct single_entity_type<osmium::osm_entity_bits::area> {
+            using type = osmium::Area;
+        };
+
+        template <>
+        struct single_entity_type<osmium::osm_entity_bits::changeset> {
+            using type = osmium::Changeset;
+        };
+
+        template <typename THandler>
+        inline void apply_typed(const osmium::Node& node, THandler&& handler) {
+            std::forward<THandler>(handler).osm_object(node);
+            std::forward<THandler>(handler).node(node);
+        }
+
+        template <typename THandler>
+        inline void apply_typed(const osmium::Way& way, THandler&& handler) {
+            std::forward<THandler>(handler).osm_object(way);
+            std::forward<THandler>(handler).way(way);
+        }
+
+        template <typename THandler>
+        inline void apply_typed(const osmium::Relation& relation, THandler&& handler) {
+            std::forward<THandler>(handler).osm_object(relation);
+            std::forward<THandler>(handler).relation(relation);
+        }
+
+        template <typename THandler>
+        inline void apply_typed(const osmium::Area& area, THandler&& handler) {
+            std::forward<THandler>(handler).osm_object(area);
+            std::forward<THandler>(handler).area(area);
+        }
+
+        template <typename THandler>
+        inline void apply_typed(const osmium::Changeset& changeset, THandler&& handler) {
+            std::forward<THandler>(handler).changeset(changeset);
+        }
+
+        // Handlers only have callbacks for one entity type: Only look at
+        // items of that type and call the callbacks without a switch.
+        template <typename TEntity, typename... THandlers>
+        inline void apply_buffer(const osmium::memory::Buffer& buffer, TEntity* /*entity_type*/, THandlers&&... handlers) {
+            for (const auto& entity : buffer.select<TEntity>()) {
+                (void)std::initializer_list<int>{
+                    (apply_typed(entity, std::forward<THandlers>(handlers)), 0)...
+                };
+            }
+        }
+
+        // Handlers don't have any callbacks.
+        template <typename... THandlers>
+        inline void apply_buffer(const osmium::memory::Buffer& /*buffer*/, std::nullptr_t* /*entity_type*/, THandlers&&... /*handlers*/) noexcept {
+        }
+
     } // namespace detail
 
     template <typename TItem, typename... THandlers>
@@ -229,9 +369,32 @@ namespace osmium {
         apply(begin(c), end(c), std::forward<THandlers>(handlers)...);
     }
 
+    namespace detail {
+
+        // Handlers have callbacks for several entity types.
+        template <typename... THandlers>
+        inline void apply_buffer(const osmium::memory::Buffer& buffer, void* /*entity_type*/, THandlers&&... handlers) {
+            for (auto it = buffer.cbegin(); it != buffer.cend(); ++it) {
+                apply_item(*it, std::forward<THandlers>(handlers)...);
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * Apply the handlers to all entities in the buffer and call their
+     * flush() functions.
+     *
+     * It is checked at compile time which callbacks the handlers actually
+     * have and which they inherited from osmium::handler::Handler. If
+     * all callbacks are for one entity type only, like way() or node()
+     * and osm_object(), only the items of that type are looked at.
+     */
     template <typename... THandlers>
     inline void apply(const osmium::memory::Buffer& buffer, THandlers&&... handlers) {
-        apply(buffer.cbegin(), buffer.cend(), std::forward<THandlers>(handlers)...);
+        using entity_type = typename detail::single_entity_type<detail::handlers_entity_bits(static_cast<typename std::decay<THandlers>::type*>(nullptr)...)>::type;
+        detail::apply_buffer(buffer, static_cast<entity_type*>(nullptr), std::forward<THandlers>(handlers)...);
+        apply_flush(std::forward<THandlers>(handlers)...);
     }
 
 } // namespace osmium
@@ -92,7 +92,16 @@ static header_buffer_type parse_xml(std::string input) {
         output_queue,
         header_promise,
         osmium::osm_entity_bits::all,
-        osmium::io::read_meta::yes
+        osmium::io::read_meta::yes,
+        osmium::metadata_options{},
+        nullptr,
+        osmium::io::blob_selection{},
+        osmium::io::decode_window{},
+        osmium::io::tag_prefilter{},
+        osmium::io::xml_tokenizer::expat,
+        osmium::io::read_buffers{},
+        osmium::io::buffer_transform{},
+        nullptr
     };
     osmium::io::detail::XMLParser parser{args};
     parser.parse();
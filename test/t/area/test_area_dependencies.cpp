@@ -0,0 +1,174 @@
+#include "catch.hpp"
+
+#include <osmium/area/area_dependencies.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/multimap/sparse_file_array.hpp>
+#include <osmium/index/multimap/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using index_type = osmium::index::multimap::SparseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+using id_list = std::vector<osmium::object_id_type>;
+
+static osmium::memory::Buffer create_data() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3, 4, 1}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({5, 6}));
+    osmium::builder::add_way(buffer, _id(3), _nodes({6, 7, 5}));
+    osmium::builder::add_way(buffer, _id(4), _nodes({8, 9, 8}));
+    osmium::builder::add_relation(buffer, _id(10), _tag("type", "multipolygon"),
+        _member(osmium::item_type::way, 2),
+        _member(osmium::item_type::way, 3));
+    osmium::builder::add_relation(buffer, _id(11), _tag("type", "route"),
+        _member(osmium::item_type::way, 4));
+    return buffer;
+}
+
+static osmium::memory::Buffer changed_nodes(const std::vector<osmium::object_id_type>& ids) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const auto id : ids) {
+        osmium::builder::add_node(buffer, _id(id), _version(2), _location(1.0, 1.0));
+    }
+    return buffer;
+}
+
+TEST_CASE("Find areas affected by changes") {
+    const auto data = create_data();
+
+    index_type node_to_way;
+    index_type way_to_node;
+    index_type way_to_relation;
+    index_type relation_to_way;
+    osmium::area::AreaDependencies<index_type> deps{node_to_way, way_to_node, way_to_relation, relation_to_way};
+
+    for (const auto& relation : data.select<osmium::Relation>()) {
+        deps.relation(relation);
+    }
+    deps.sort();
+    for (const auto& way : data.select<osmium::Way>()) {
+        deps.way(way);
+    }
+    deps.sort();
+
+    REQUIRE(way_to_relation.size() == 2);
+    REQUIRE(node_to_way.size() == 9);
+
+    SECTION("changed nodes") {
+        const auto affected = deps.update(changed_nodes({2, 6, 9, 100}));
+        REQUIRE(affected.ways == (id_list{1, 2, 3}));
+        REQUIRE(affected.relations == (id_list{10}));
+        REQUIRE(affected.untracked_ways.empty());
+        REQUIRE(node_to_way.size() == 9);
+    }
+
+    SECTION("deleted way") {
+        osmium::memory::Buffer changes{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_way(changes, _id(1), _version(2), _deleted());
+        auto affected = deps.update(changes);
+        REQUIRE(affected.ways == (id_list{1}));
+        REQUIRE(affected.relations.empty());
+
+        affected = deps.update(changed_nodes({2}));
+        REQUIRE(affected.ways.empty());
+    }
+
+    SECTION("changed member way") {
+        osmium::memory::Buffer changes{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_way(changes, _id(3), _version(2), _nodes({6, 7, 5}));
+        osmium::builder::add_way(changes, _id(3), _version(3), _nodes({6, 12, 5}));
+        auto affected = deps.update(changes);
+        REQUIRE(affected.ways == (id_list{3}));
+        REQUIRE(affected.relations == (id_list{10}));
+
+        affected = deps.update(changed_nodes({7}));
+        REQUIRE(affected.ways.empty());
+        REQUIRE(affected.relations.empty());
+
+        affected = deps.update(changed_nodes({12}));
+        REQUIRE(affected.ways == (id_list{3}));
+        REQUIRE(affected.relations == (id_list{10}));
+    }
+
+    SECTION("new relation member") {
+        osmium::memory::Buffer changes{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_relation(changes, _id(10), _version(2), _tag("type", "multipolygon"),
+            _member(osmium::item_type::way, 3),
+            _member(osmium::item_type::way, 13));
+        auto affected = deps.update(changes);
+        REQUIRE(affected.ways.empty());
+        REQUIRE(affected.relations == (id_list{10}));
+        REQUIRE(affected.untracked_ways == (id_list{13}));
+
+        affected = deps.update(changed_nodes({2, 5}));
+        REQUIRE(affected.ways == (id_list{1, 2, 3}));
+        REQUIRE(affected.relations == (id_list{10}));
+
+        osmium::memory::Buffer way_buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_way(way_buffer, _id(13), _nodes({20, 21}));
+        deps.way(way_buffer.get<osmium::Way>(0));
+        deps.sort();
+
+        affected = deps.update(changed_nodes({21}));
+        REQUIRE(affected.ways == (id_list{13}));
+        REQUIRE(affected.relations == (id_list{10}));
+    }
+
+    SECTION("relation which is not tracked any more") {
+        osmium::memory::Buffer changes{1024, osmium::memory::Buffer::auto_grow::yes};
+        osmium::builder::add_relation(changes, _id(10), _version(2), _tag("type", "route"),
+            _member(osmium::item_type::way, 2),
+            _member(osmium::item_type::way, 3));
+        auto affected = deps.update(changes);
+        REQUIRE(affected.relations == (id_list{10}));
+        REQUIRE(way_to_relation.size() == 0);
+
+        affected = deps.update(changed_nodes({5}));
+        REQUIRE(affected.ways == (id_list{2, 3}));
+        REQUIRE(affected.relations.empty());
+    }
+}
+
+TEST_CASE("Area dependencies in file based indexes") {
+    using file_index_type = osmium::index::multimap::SparseFileArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+
+    const auto data = create_data();
+    const int fds[4] = {osmium::detail::create_tmp_file(), osmium::detail::create_tmp_file(),
+                        osmium::detail::create_tmp_file(), osmium::detail::create_tmp_file()};
+
+    {
+        file_index_type node_to_way{fds[0]};
+        file_index_type way_to_node{fds[1]};
+        file_index_type way_to_relation{fds[2]};
+        file_index_type relation_to_way{fds[3]};
+        osmium::area::AreaDependencies<file_index_type> deps{node_to_way, way_to_node, way_to_relation, relation_to_way};
+
+        for (const auto& relation : data.select<osmium::Relation>()) {
+            deps.relation(relation);
+        }
+        deps.sort();
+        for (const auto& way : data.select<osmium::Way>()) {
+            deps.way(way);
+        }
+        deps.sort();
+    }
+
+    file_index_type node_to_way{fds[0]};
+    file_index_type way_to_node{fds[1]};
+    file_index_type way_to_relation{fds[2]};
+    file_index_type relation_to_way{fds[3]};
+    osmium::area::AreaDependencies<file_index_type> deps{node_to_way, way_to_node, way_to_relation, relation_to_way};
+
+    auto affected = deps.update(changed_nodes({3, 7}));
+    REQUIRE(affected.ways == (id_list{1, 3}));
+    REQUIRE(affected.relations == (id_list{10}));
+
+    osmium::memory::Buffer changes{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(changes, _id(1), _version(2), _deleted());
+    affected = deps.update(changes);
+    REQUIRE(affected.ways == (id_list{1}));
+    REQUIRE(node_to_way.size() == 5);
+}
@@ -5,6 +5,10 @@
 #include <osmium/memory/buffer.hpp>
 #include <osmium/osm/area.hpp>
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 TEST_CASE("Build area from way") {
@@ -141,3 +145,184 @@ TEST_CASE("Build area from way with ignored invalid location") {
     REQUIRE(s.invalid_locations == 1);
 }
 
+
+static void add_square(osmium::memory::Buffer& buffer, osmium::object_id_type id, osmium::object_id_type first_node, double x, double y, double size) {
+    osmium::builder::add_way(buffer,
+        _id(id),
+        _nodes({
+            osmium::NodeRef{first_node,     osmium::Location{x, y}},
+            osmium::NodeRef{first_node + 1, osmium::Location{x + size, y}},
+            osmium::NodeRef{first_node + 2, osmium::Location{x + size, y + size}},
+            osmium::NodeRef{first_node + 3, osmium::Location{x, y + size}},
+            osmium::NodeRef{first_node,     osmium::Location{x, y}}
+        })
+    );
+}
+
+TEST_CASE("Build multipolygon with many touching rings") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    // Outer ring with a row of holes touching each other at their
+    // corners. Every other hole contains an island.
+    add_square(buffer, 1, 1, 0.0, 0.0, 60.0);
+    const int num_holes = 40;
+    osmium::object_id_type id = 2;
+    for (int n = 0; n < num_holes; ++n) {
+        const double x = 10.0 + n;
+        const double y = (n % 2) ? 11.0 : 10.0;
+        add_square(buffer, id, id * 10, x, y, 1.0);
+        ++id;
+        if (n % 2 == 0) {
+            add_square(buffer, id, id * 10, x + 0.25, y + 0.25, 0.5);
+            ++id;
+        }
+    }
+
+    std::vector<member_type> members;
+    for (osmium::object_id_type way_id = 1; way_id < id; ++way_id) {
+        members.emplace_back(osmium::item_type::way, way_id);
+    }
+
+    const auto rpos = osmium::builder::add_relation(buffer,
+        _id(1),
+        _members(members),
+        _tag("type", "multipolygon"),
+        _tag("natural", "wood")
+    );
+    const auto& relation = buffer.get<osmium::Relation>(rpos);
+
+    std::vector<const osmium::Way*> ways;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        ways.push_back(&way);
+    }
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(assembler(relation, ways, area_buffer));
+
+    const auto& s = assembler.stats();
+    REQUIRE(s.area_touching_rings_case == 1);
+    REQUIRE(s.outer_rings == 1 + num_holes / 2);
+    REQUIRE(s.inner_rings == num_holes);
+
+    const auto& area = area_buffer.get<osmium::Area>(0);
+    REQUIRE(area.is_multipolygon());
+    const auto& outer = *area.outer_rings().begin();
+    REQUIRE(outer.size() == 5);
+    REQUIRE(std::distance(area.inner_rings(outer).begin(), area.inner_rings(outer).end()) == num_holes);
+    for (auto it = std::next(area.outer_rings().begin()); it != area.outer_rings().end(); ++it) {
+        REQUIRE(it->size() == 5);
+        REQUIRE(area.inner_rings(*it).empty());
+    }
+}
+
+TEST_CASE("Reuse assembler for several areas") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    add_square(buffer, 1, 1, 1.0, 1.0, 1.0);
+    add_square(buffer, 2, 10, 5.0, 5.0, 2.0);
+    add_square(buffer, 3, 20, 5.5, 5.5, 0.5);
+    add_square(buffer, 4, 30, 10.0, 10.0, 1.0);
+
+    std::vector<const osmium::Way*> ways;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        ways.push_back(&way);
+    }
+
+    osmium::area::AssemblerConfig config;
+
+    osmium::memory::Buffer expected{10240, osmium::memory::Buffer::auto_grow::yes};
+    for (const auto* way : ways) {
+        osmium::area::Assembler assembler{config};
+        REQUIRE(assembler(*way, expected));
+    }
+
+    osmium::area::Assembler assembler{config};
+    osmium::memory::Buffer area_buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    for (int round = 0; round < 3; ++round) {
+        area_buffer.clear();
+        for (const auto* way : ways) {
+            REQUIRE(assembler(*way, area_buffer));
+            REQUIRE(assembler.stats().from_ways == 1);
+            REQUIRE(assembler.stats().nodes == 4);
+            REQUIRE(assembler.stats().outer_rings == 1);
+        }
+        REQUIRE(area_buffer.committed() == expected.committed());
+        REQUIRE(std::equal(area_buffer.data(), area_buffer.data() + area_buffer.committed(), expected.data()));
+    }
+}
+
+TEST_CASE("Build area from simple clockwise way") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto wpos = osmium::builder::add_way(buffer,
+        _id(1),
+        _tag("building", "yes"),
+        _nodes({
+            {3, {2.0, 2.0}},
+            {4, {2.0, 1.0}},
+            {1, {1.0, 1.0}},
+            {2, {1.0, 2.0}},
+            {3, {2.0, 2.0}}
+        })
+    );
+
+    osmium::area::AssemblerConfig config;
+    osmium::area::Assembler assembler{config};
+
+    osmium::memory::Buffer area_buffer{10240};
+    REQUIRE(assembler(buffer.get<osmium::Way>(wpos), area_buffer));
+
+    const auto& area = area_buffer.get<osmium::Area>(0);
+    REQUIRE(area.tags().has_tag("building", "yes"));
+    REQUIRE(area.num_rings().first == 1);
+    REQUIRE(area.num_rings().second == 0);
+
+    const auto& ring = *area.outer_rings().begin();
+    REQUIRE(ring.size() == 5);
+    const osmium::object_id_type ids[] = {1, 4, 3, 2, 1};
+    int n = 0;
+    for (const auto& node_ref : ring) {
+        REQUIRE(node_ref.ref() == ids[n++]);
+    }
+
+    const auto& s = assembler.stats();
+    REQUIRE(s.area_simple_case == 1);
+    REQUIRE(s.nodes == 4);
+    REQUIRE(s.outer_rings == 1);
+}
+
+TEST_CASE("Self-intersecting way is not a simple area") {
+    osmium::memory::Buffer buffer{10240};
+
+    const auto wpos = osmium::builder::add_way(buffer,
+        _id(1),
+        _nodes({
+            {1, {1.0, 1.0}},
+            {2, {3.0, 3.0}},
+            {3, {3.0, 1.0}},
+            {4, {1.0, 2.0}},
+            {1, {1.0, 1.0}}
+        })
+    );
+
+    osmium::area::AssemblerConfig config;
+
+    SECTION("default config") {
+        osmium::area::Assembler assembler{config};
+        osmium::memory::Buffer area_buffer{10240};
+        assembler(buffer.get<osmium::Way>(wpos), area_buffer);
+        REQUIRE(assembler.stats().intersections == 1);
+        REQUIRE(assembler.stats().outer_rings == 0);
+    }
+
+    SECTION("assume valid ways") {
+        config.assume_valid_ways = true;
+        osmium::area::Assembler assembler{config};
+        osmium::memory::Buffer area_buffer{10240};
+        REQUIRE(assembler(buffer.get<osmium::Way>(wpos), area_buffer));
+        REQUIRE(assembler.stats().intersections == 0);
+        REQUIRE(assembler.stats().outer_rings == 1);
+    }
+}
@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include <osmium/area/assembler.hpp>
+#include <osmium/area/multipolygon_manager.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/tags/classifier.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <algorithm>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using manager_type = osmium::area::MultipolygonManager<osmium::area::Assembler>;
+
+static void add_square(osmium::memory::Buffer& buffer, osmium::object_id_type id, bool tagged) {
+    const double x = static_cast<double>(id % 100) * 0.01;
+    const double y = static_cast<double>(id / 100) * 0.01;
+    const osmium::object_id_type first = id * 10;
+    const std::vector<osmium::NodeRef> nodes = {
+        {first + 0, osmium::Location{x, y}},
+        {first + 1, osmium::Location{x + 0.005, y}},
+        {first + 2, osmium::Location{x + 0.005, y + 0.005}},
+        {first + 3, osmium::Location{x, y + 0.005}},
+        {first + 0, osmium::Location{x, y}}
+    };
+    if (tagged) {
+        osmium::builder::add_way(buffer, _id(id), _tag("building", "yes"), _nodes(nodes));
+    } else {
+        osmium::builder::add_way(buffer, _id(id), _nodes(nodes));
+    }
+}
+
+static osmium::memory::Buffer create_relations() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_relation(buffer, _id(1),
+        _member(osmium::item_type::way, 2000, "outer"),
+        _tag("type", "multipolygon"),
+        _tag("landuse", "forest"));
+    return buffer;
+}
+
+static osmium::memory::Buffer create_ways() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        add_square(buffer, id, true);
+    }
+    add_square(buffer, 2000, false);
+    return buffer;
+}
+
+static std::vector<osmium::object_id_type> area_ids(const osmium::memory::Buffer& buffer) {
+    std::vector<osmium::object_id_type> ids;
+    for (const auto& area : buffer.select<osmium::Area>()) {
+        ids.push_back(area.id());
+    }
+    return ids;
+}
+
+TEST_CASE("MultipolygonManager assembles closed ways in several threads") {
+    const auto relations = create_relations();
+    const auto ways = create_ways();
+
+    manager_type serial_manager{osmium::area::Assembler::config_type{}};
+    osmium::apply(relations, serial_manager);
+    serial_manager.prepare_for_lookup();
+    osmium::apply(ways, serial_manager.handler());
+    const auto serial_ids = area_ids(serial_manager.read());
+
+    manager_type parallel_manager{osmium::area::Assembler::config_type{}};
+    osmium::apply(relations, parallel_manager);
+    parallel_manager.prepare_for_lookup();
+    osmium::thread::Pool pool{4};
+    parallel_manager.handle_buffer(ways, pool);
+    const auto parallel_ids = area_ids(parallel_manager.read());
+
+    // areas from 1000 closed ways and one relation
+    REQUIRE(serial_ids.size() == 1001);
+    REQUIRE(parallel_ids.size() == 1001);
+
+    // area from the relation first, then the areas from the ways in order
+    REQUIRE(parallel_ids.front() == 3);
+    REQUIRE(std::is_sorted(parallel_ids.begin() + 1, parallel_ids.end()));
+
+    auto sorted_serial_ids = serial_ids;
+    std::sort(sorted_serial_ids.begin(), sorted_serial_ids.end());
+    auto sorted_parallel_ids = parallel_ids;
+    std::sort(sorted_parallel_ids.begin(), sorted_parallel_ids.end());
+    REQUIRE(sorted_serial_ids == sorted_parallel_ids);
+
+    REQUIRE(parallel_manager.stats().from_ways == serial_manager.stats().from_ways);
+    REQUIRE(parallel_manager.stats().from_relations == 1);
+}
+
+TEST_CASE("MultipolygonManager filter can be used in TagsClassifier") {
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "building");
+    const manager_type manager{osmium::area::Assembler::config_type{}, filter};
+    REQUIRE(manager.filter().compiled());
+
+    osmium::TagsClassifier classifier;
+    const auto areas = classifier.add(manager.filter());
+
+    const auto ways = create_ways();
+    const auto& tagged = ways.get<osmium::Way>(0);
+    REQUIRE(osmium::TagsClassifier::test(classifier(tagged.tags()), areas));
+}
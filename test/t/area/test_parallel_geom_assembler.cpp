@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <osmium/area/geom_assembler.hpp>
+#include <osmium/area/parallel_geom_assembler.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/wkb.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using wkb_factory = osmium::geom::WKBFactory<>;
+
+static osmium::memory::Buffer create_ways(int count) {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::object_id_type node_id = 1;
+    for (int n = 0; n < count; ++n) {
+        const double x = (n % 100) * 0.1;
+        const double y = (n / 100) * 0.1;
+        const osmium::object_id_type id = node_id;
+        node_id += 4;
+        if (n % 7 == 3) {
+            // self-intersecting
+            osmium::builder::add_way(buffer, _id(n + 1), _nodes({
+                osmium::NodeRef{id,     osmium::Location{x, y}},
+                osmium::NodeRef{id + 1, osmium::Location{x + 0.05, y + 0.05}},
+                osmium::NodeRef{id + 2, osmium::Location{x + 0.05, y}},
+                osmium::NodeRef{id + 3, osmium::Location{x, y + 0.02}},
+                osmium::NodeRef{id,     osmium::Location{x, y}}
+            }));
+        } else if (n % 7 == 5) {
+            // not closed
+            osmium::builder::add_way(buffer, _id(n + 1), _nodes({
+                osmium::NodeRef{id,     osmium::Location{x, y}},
+                osmium::NodeRef{id + 1, osmium::Location{x + 0.05, y}},
+                osmium::NodeRef{id + 2, osmium::Location{x + 0.05, y + 0.05}}
+            }));
+        } else {
+            osmium::builder::add_way(buffer, _id(n + 1), _nodes({
+                osmium::NodeRef{id,     osmium::Location{x, y}},
+                osmium::NodeRef{id + 1, osmium::Location{x + 0.05, y}},
+                osmium::NodeRef{id + 1, osmium::Location{x + 0.05, y}},
+                osmium::NodeRef{id + 2, osmium::Location{x + 0.05, y + 0.05}},
+                osmium::NodeRef{id + 3, osmium::Location{x, y + 0.05}},
+                osmium::NodeRef{id,     osmium::Location{x, y}}
+            }));
+        }
+        if (n % 10 == 0) {
+            osmium::builder::add_node(buffer, _id(n + 1), _location(x, y));
+        }
+    }
+
+    return buffer;
+}
+
+static std::vector<std::pair<osmium::object_id_type, std::string>> create_expected(const osmium::memory::Buffer& buffer, wkb_factory& factory) {
+    std::vector<std::pair<osmium::object_id_type, std::string>> expected;
+    const osmium::area::AssemblerConfig config;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        if (!way.ends_have_same_location()) {
+            continue;
+        }
+        osmium::area::GeomAssembler assembler{config};
+        osmium::memory::Buffer area_buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        if (assembler(way, area_buffer)) {
+            expected.emplace_back(way.id(), factory.create_multipolygon(area_buffer.get<osmium::Area>(0)));
+        }
+    }
+    return expected;
+}
+
+TEST_CASE("Create WKB geometries from closed ways in parallel") {
+    const osmium::memory::Buffer buffer{create_ways(2000)};
+
+    wkb_factory factory{osmium::geom::wkb_type::ewkb, osmium::geom::out_type::hex};
+    const auto expected = create_expected(buffer, factory);
+    REQUIRE(expected.size() > 1000);
+
+    osmium::thread::Pool pool{4};
+    const osmium::area::AssemblerConfig config;
+    const osmium::area::ParallelGeomAssembler<wkb_factory> assembler{config, factory, pool};
+
+    const auto result = assembler(buffer);
+    REQUIRE(result.size() == expected.size());
+    for (std::size_t n = 0; n < result.size(); ++n) {
+        REQUIRE(result[n].id == expected[n].first);
+        REQUIRE(result[n].geometry == expected[n].second);
+    }
+}
+
+TEST_CASE("Create WKB geometries from a few closed ways") {
+    const osmium::memory::Buffer buffer{create_ways(20)};
+
+    wkb_factory factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex};
+    const auto expected = create_expected(buffer, factory);
+
+    const osmium::area::AssemblerConfig config;
+    const osmium::area::ParallelGeomAssembler<wkb_factory> assembler{config, factory};
+
+    const auto result = assembler(buffer);
+    REQUIRE(result.size() == expected.size());
+    for (std::size_t n = 0; n < result.size(); ++n) {
+        REQUIRE(result[n].id == expected[n].first);
+        REQUIRE(result[n].geometry == expected[n].second);
+    }
+}
@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include <osmium/area/polygon_index.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/node_ref.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using ring_type = std::vector<osmium::NodeRef>;
+
+static ring_type circle(double cx, double cy, double radius, int points) {
+    ring_type ring;
+    for (int n = 0; n < points; ++n) {
+        // the wobble makes the ring more irregular
+        const double r = radius * (1.0 + 0.2 * std::sin(n * 0.37));
+        const double angle = 2 * 3.14159265358979323846 * n / points;
+        ring.emplace_back(n + 1, osmium::Location{cx + r * std::cos(angle), cy + r * std::sin(angle)});
+    }
+    ring.push_back(ring.front());
+    return ring;
+}
+
+static std::vector<osmium::area::detail::polygon_segment> segments(const ring_type& ring) {
+    std::vector<osmium::area::detail::polygon_segment> result;
+    for (std::size_t n = 1; n < ring.size(); ++n) {
+        const auto& l1 = ring[n - 1].location();
+        const auto& l2 = ring[n].location();
+        result.push_back(osmium::area::detail::polygon_segment{l1.x(), l1.y(), l2.x(), l2.y()});
+    }
+    return result;
+}
+
+static bool brute_force_contains(const std::vector<osmium::area::detail::polygon_segment>& segs, const osmium::Location& location) {
+    bool inside = false;
+    for (const auto& segment : segs) {
+        if (segment.crossed_by_ray(location.x(), location.y())) {
+            inside = !inside;
+        }
+    }
+    return inside;
+}
+
+TEST_CASE("Polygon index with single polygon with hole") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    const ring_type outer = circle(10.0, 50.0, 2.0, 5000);
+    const ring_type inner = circle(10.5, 50.2, 0.5, 300);
+    osmium::builder::add_area(buffer, _id(2), _outer_ring(outer), _inner_ring(inner));
+
+    osmium::area::PolygonIndex index;
+    REQUIRE(index.add(buffer.get<osmium::Area>(0)) == 0);
+    REQUIRE(index.size() == 1);
+
+    auto segs = segments(outer);
+    const auto inner_segs = segments(inner);
+    segs.insert(segs.end(), inner_segs.begin(), inner_segs.end());
+
+    std::size_t count_inside = 0;
+    for (int y = 0; y < 300; ++y) {
+        for (int x = 0; x < 300; ++x) {
+            const osmium::Location location{7.0 + x * 0.02001, 47.0 + y * 0.02001};
+            const bool expected = brute_force_contains(segs, location);
+            REQUIRE(index.contains(0, location) == expected);
+            if (expected) {
+                ++count_inside;
+            }
+        }
+    }
+    REQUIRE(count_inside > 10000);
+
+    // the vertices themselves
+    for (const auto& node : outer) {
+        REQUIRE(index.contains(0, node.location()) == brute_force_contains(segs, node.location()));
+    }
+
+    REQUIRE_FALSE(index.contains(0, osmium::Location{}));
+    REQUIRE_FALSE(index.contains(0, osmium::Location{10.5, 50.2})); // in hole
+    REQUIRE(index.contains(0, osmium::Location{9.0, 50.0}));
+}
+
+TEST_CASE("Polygon index with several polygons") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_area(buffer, _id(2), _outer_ring(circle(0.0, 0.0, 1.0, 100)));
+    osmium::builder::add_area(buffer, _id(4), _outer_ring(circle(0.5, 0.0, 1.0, 100)));
+    osmium::builder::add_area(buffer, _id(6));
+    osmium::builder::add_area(buffer, _id(8), _outer_ring({
+        {1, {179.0, 89.0}},
+        {2, {180.0, 89.0}},
+        {3, {180.0, 90.0}},
+        {1, {179.0, 89.0}}
+    }));
+
+    osmium::area::PolygonIndex index;
+    for (const auto& area : buffer.select<osmium::Area>()) {
+        index.add(area);
+    }
+    REQUIRE(index.size() == 4);
+
+    const auto find = [&](const osmium::Location& location) {
+        std::vector<std::size_t> ids;
+        index.for_each_containing(location, [&](std::size_t id) {
+            ids.push_back(id);
+        });
+        return ids;
+    };
+
+    REQUIRE(find(osmium::Location{-0.5, 0.0}) == std::vector<std::size_t>{0});
+    REQUIRE(find(osmium::Location{0.3, 0.0}) == (std::vector<std::size_t>{0, 1}));
+    REQUIRE(find(osmium::Location{1.2, 0.0}) == std::vector<std::size_t>{1});
+    REQUIRE(find(osmium::Location{5.0, 5.0}).empty());
+    REQUIRE(find(osmium::Location{179.9, 89.5}) == std::vector<std::size_t>{3});
+    REQUIRE(find(osmium::Location{}).empty());
+}
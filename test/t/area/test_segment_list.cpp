@@ -0,0 +1,144 @@
+#include "catch.hpp"
+
+#include <osmium/area/detail/segment_list.hpp>
+#include <osmium/area/problem_reporter.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class IntersectionRecorder : public osmium::area::ProblemReporter {
+
+    public:
+
+        std::vector<osmium::Location> intersections;
+
+        void report_intersection(osmium::object_id_type /*way1_id*/, osmium::Location /*way1_seg_start*/, osmium::Location /*way1_seg_end*/,
+                                 osmium::object_id_type /*way2_id*/, osmium::Location /*way2_seg_start*/, osmium::Location /*way2_seg_end*/, osmium::Location intersection) override {
+            intersections.push_back(intersection);
+        }
+
+    }; // class IntersectionRecorder
+
+} // anonymous namespace
+
+// A way zig-zagging through a box with long segments, so that the x ranges
+// of many segments overlap.
+static const osmium::Way& create_way(osmium::memory::Buffer& buffer, std::size_t num_nodes, double jump) {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_real_distribution<double> dist{-jump, jump};
+    std::vector<osmium::NodeRef> nodes;
+    double x = 0.0;
+    double y = 0.0;
+    for (std::size_t n = 0; n < num_nodes; ++n) {
+        x = std::max(-10.0, std::min(10.0, x + dist(gen)));
+        y = std::max(-10.0, std::min(10.0, y + dist(gen) / 10));
+        nodes.emplace_back(static_cast<osmium::object_id_type>(n + 1), osmium::Location{x, y});
+    }
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+    return buffer.get<osmium::Way>(pos);
+}
+
+static void compare_methods(std::size_t num_nodes, double jump) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto& way = create_way(buffer, num_nodes, jump);
+
+    osmium::area::detail::SegmentList segments{false};
+    uint64_t duplicate_nodes = 0;
+    uint64_t duplicate_segments = 0;
+    uint64_t overlapping_segments = 0;
+    segments.extract_segments_from_way(nullptr, duplicate_nodes, way);
+    segments.sort();
+    segments.erase_duplicate_segments(nullptr, duplicate_segments, overlapping_segments);
+
+    IntersectionRecorder simple;
+    IntersectionRecorder sweep;
+    const auto count_simple = segments.find_intersections_simple(&simple);
+    const auto count_sweep = segments.find_intersections_sweep(&sweep);
+
+    REQUIRE(count_simple > 0);
+    REQUIRE(count_sweep == count_simple);
+    REQUIRE(sweep.intersections == simple.intersections);
+    REQUIRE(segments.find_intersections(nullptr) == count_simple);
+}
+
+TEST_CASE("Sweep line finds same intersections as simple method") {
+    SECTION("few long segments") {
+        compare_methods(200, 5.0);
+    }
+    SECTION("many long segments") {
+        compare_methods(3000, 2.0);
+    }
+    SECTION("many short segments") {
+        compare_methods(5000, 0.05);
+    }
+}
+
+TEST_CASE("Sweep line without intersections") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<osmium::NodeRef> nodes;
+    for (int n = 0; n < 2000; ++n) {
+        nodes.emplace_back(n + 1, osmium::Location{n * 0.001, (n % 2) * 0.001});
+    }
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+
+    osmium::area::detail::SegmentList segments{false};
+    uint64_t duplicate_nodes = 0;
+    segments.extract_segments_from_way(nullptr, duplicate_nodes, buffer.get<osmium::Way>(pos));
+    segments.sort();
+    REQUIRE(segments.find_intersections_sweep(nullptr) == 0);
+    REQUIRE(segments.find_intersections_simple(nullptr) == 0);
+}
+
+TEST_CASE("Location keys compare like locations") {
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int32_t> dist{-1800000000, 1800000000};
+    for (int n = 0; n < 10000; ++n) {
+        const osmium::Location a{dist(gen), dist(gen) / 2};
+        const osmium::Location b{n % 2 ? a.x() : dist(gen), dist(gen) / 2};
+        REQUIRE((a < b) == (osmium::area::detail::location_key(a) < osmium::area::detail::location_key(b)));
+        REQUIRE((a == b) == (osmium::area::detail::location_key(a) == osmium::area::detail::location_key(b)));
+    }
+}
+
+TEST_CASE("Sorting large segment list gives same order as comparing segments") {
+    // Random walk on a small grid, so many segments share their first
+    // location.
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c, cert-msc51-cpp)
+    std::uniform_int_distribution<int> dist{-1, 1};
+    std::vector<osmium::NodeRef> nodes;
+    int x = 0;
+    int y = 0;
+    for (int n = 0; n < 20000; ++n) {
+        x = std::max(-20, std::min(20, x + dist(gen)));
+        y = std::max(-20, std::min(20, y + dist(gen)));
+        nodes.emplace_back(n + 1, osmium::Location{x * 0.01, y * 0.01});
+    }
+    const auto pos = osmium::builder::add_way(buffer, _id(1), _nodes(nodes));
+
+    osmium::area::detail::SegmentList segments{false};
+    uint64_t duplicate_nodes = 0;
+    segments.extract_segments_from_way(nullptr, duplicate_nodes, buffer.get<osmium::Way>(pos));
+    REQUIRE(segments.size() >= osmium::area::detail::SegmentList::sort_by_key_min_segments);
+
+    std::vector<osmium::area::detail::NodeRefSegment> expected{segments.begin(), segments.end()};
+    std::sort(expected.begin(), expected.end());
+    segments.sort();
+
+    REQUIRE(segments.size() == expected.size());
+    auto it = segments.begin();
+    for (const auto& segment : expected) {
+        REQUIRE(it->first().location() == segment.first().location());
+        REQUIRE(it->second().location() == segment.second().location());
+        ++it;
+    }
+}
@@ -5,6 +5,7 @@
 #include <osmium/osm.hpp>
 #include <osmium/osm/types.hpp>
 
+#include <algorithm>
 #include <cstdint>
 #include <initializer_list>
 #include <iterator>
@@ -573,3 +574,84 @@ TEST_CASE("create area using builders") {
 
 }
 
+
+TEST_CASE("node template creates same data as builder") {
+
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    const auto tmpl = osmium::builder::make_node_template(
+        _version(1),
+        _user("generator"),
+        _tag("amenity", "restaurant"),
+        _tag("cuisine", "pizza")
+    );
+
+    REQUIRE(tmpl.byte_size() == tmpl.prototype().padded_size());
+    REQUIRE(tmpl.prototype().tags().size() == 2);
+
+    osmium::memory::Buffer buffer{64, osmium::memory::Buffer::auto_grow::yes};
+    osmium::memory::Buffer expected{1024 * 10};
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        const osmium::Location location{static_cast<double>(id) / 10, 1.5};
+        const auto& node = tmpl.add(buffer, id, location);
+        REQUIRE(node.id() == id);
+        REQUIRE(node.location() == location);
+
+        osmium::builder::add_node(expected,
+            _id(id),
+            _version(1),
+            _user("generator"),
+            _location(location),
+            _tag("amenity", "restaurant"),
+            _tag("cuisine", "pizza")
+        );
+    }
+
+    REQUIRE(buffer.committed() == expected.committed());
+    REQUIRE(std::equal(buffer.data(), buffer.data() + buffer.committed(), expected.data()));
+}
+
+TEST_CASE("way template allows patching of node refs") {
+
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    const auto tmpl = osmium::builder::make_way_template(
+        _tag("highway", "service"),
+        _nodes({0, 0, 0})
+    );
+
+    osmium::memory::Buffer buffer{1024 * 10};
+    auto& way = tmpl.add(buffer, 17);
+    osmium::object_id_type ref = 10;
+    for (auto& node_ref : way.nodes()) {
+        node_ref.set_ref(ref++);
+    }
+
+    const auto& result = buffer.get<osmium::Way>(0);
+    REQUIRE(result.id() == 17);
+    REQUIRE(std::string{result.tags()["highway"]} == "service");
+    REQUIRE(result.nodes().size() == 3);
+    REQUIRE(result.nodes()[0].ref() == 10);
+    REQUIRE(result.nodes()[2].ref() == 12);
+    REQUIRE(tmpl.prototype().nodes()[0].ref() == 0);
+}
+
+TEST_CASE("relation template") {
+
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    const auto tmpl = osmium::builder::make_relation_template(
+        _tag("type", "site"),
+        _member(osmium::item_type::node, 1, "label")
+    );
+
+    osmium::memory::Buffer buffer{1024 * 10};
+    tmpl.add(buffer, 5);
+    tmpl.add(buffer, 6);
+
+    auto it = buffer.select<osmium::Relation>().begin();
+    REQUIRE(it->id() == 5);
+    ++it;
+    REQUIRE(it->id() == 6);
+    REQUIRE(it->members().size() == 1);
+}
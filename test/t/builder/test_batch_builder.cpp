@@ -0,0 +1,98 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/builder/batch_builder.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static bool same_content(const osmium::memory::Buffer& a, const osmium::memory::Buffer& b) {
+    return a.committed() == b.committed() && std::memcmp(a.data(), b.data(), a.committed()) == 0;
+}
+
+TEST_CASE("Batch builder for nodes creates same data as attr builder") {
+    const std::vector<osmium::object_id_type> ids = {1, 2, 3};
+    const std::vector<osmium::Location> locations = {osmium::Location{1.0, 2.0}, osmium::Location{3.0, 4.0}, osmium::Location{}};
+    const std::vector<const char*> keys = {"highway", "name", "amenity"};
+    const std::vector<const char*> values = {"primary", "Main Street", "pub"};
+    const std::vector<std::size_t> offsets = {0, 2, 2, 3};
+
+    osmium::memory::Buffer batch{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto offset = osmium::builder::add_nodes(batch, ids.size(), ids.data(), locations.data(),
+                                                   osmium::builder::batch_tags{keys.data(), values.data(), offsets.data()},
+                                                   [](osmium::OSMObject& object, std::size_t n) {
+        object.set_version(static_cast<osmium::object_version_type>(n + 1));
+    });
+    REQUIRE(offset == 0);
+
+    osmium::memory::Buffer expected{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(expected, _id(1), _version(1), _location(1.0, 2.0), _tag("highway", "primary"), _tag("name", "Main Street"));
+    osmium::builder::add_node(expected, _id(2), _version(2), _location(3.0, 4.0));
+    osmium::builder::add_node(expected, _id(3), _version(3), _tag("amenity", "pub"));
+
+    REQUIRE(same_content(batch, expected));
+
+    const auto& node = batch.get<osmium::Node>(0);
+    REQUIRE(node.id() == 1);
+    REQUIRE(std::string{node.tags()["name"]} == "Main Street");
+}
+
+TEST_CASE("Batch builder for ways creates same data as attr builder") {
+    const std::vector<osmium::object_id_type> ids = {10, 11, 12};
+    const std::vector<std::size_t> node_offsets = {0, 3, 3, 5};
+    const std::vector<osmium::object_id_type> refs = {1, 2, 3, 4, 5};
+    const std::vector<const char*> keys = {"highway", "oneway"};
+    const std::vector<const char*> values = {"residential", "yes"};
+    const std::vector<std::size_t> tag_offsets = {0, 0, 2, 2};
+
+    osmium::memory::Buffer batch{64, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_ways(batch, ids.size(), ids.data(), node_offsets.data(), refs.data(),
+                              osmium::builder::batch_tags{keys.data(), values.data(), tag_offsets.data()});
+
+    osmium::memory::Buffer expected{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(expected, _id(10), _nodes({1, 2, 3}));
+    osmium::builder::add_way(expected, _id(11), _tag("highway", "residential"), _tag("oneway", "yes"), _nodes(std::initializer_list<osmium::object_id_type>{}));
+    osmium::builder::add_way(expected, _id(12), _nodes({4, 5}));
+
+    REQUIRE(same_content(batch, expected));
+
+    const auto& way = batch.get<osmium::Way>(0);
+    REQUIRE(way.nodes().size() == 3);
+    REQUIRE(way.nodes()[2].ref() == 3);
+}
+
+TEST_CASE("Batch builder without tags") {
+    const std::vector<osmium::object_id_type> ids = {1, 2};
+    const std::vector<std::size_t> node_offsets = {0, 2, 4};
+    const std::vector<osmium::object_id_type> refs = {1, 2, 2, 3};
+
+    osmium::memory::Buffer batch{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_ways(batch, ids.size(), ids.data(), node_offsets.data(), refs.data());
+
+    osmium::memory::Buffer expected{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(expected, _id(1), _nodes({1, 2}));
+    osmium::builder::add_way(expected, _id(2), _nodes({2, 3}));
+
+    REQUIRE(same_content(batch, expected));
+}
+
+TEST_CASE("Batch builder with tag value that is too long") {
+    const std::string value(osmium::max_osm_string_length + 1, 'x');
+    const osmium::object_id_type id = 1;
+    const osmium::Location location{};
+    const char* key = "name";
+    const char* value_ptr = value.c_str();
+    const std::size_t offsets[] = {0, 1};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE_THROWS_AS(osmium::builder::add_nodes(buffer, 1, &id, &location, osmium::builder::batch_tags{&key, &value_ptr, offsets}), const std::length_error&);
+    REQUIRE(buffer.committed() == 0);
+}
@@ -3,10 +3,13 @@
 #include "area_helper.hpp"
 #include "wnl_helper.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/geom/geojson.hpp>
+#include <osmium/osm/node.hpp>
 
 #include <iterator>
 #include <string>
+#include <vector>
 
 TEST_CASE("GeoJSON point geometry") {
     osmium::geom::GeoJSONFactory<> factory;
@@ -80,6 +83,18 @@ TEST_CASE("GeoJSON linestring geometry") {
 
 }
 
+TEST_CASE("GeoJSON multilinestring geometry") {
+    osmium::geom::GeoJSONFactory<> factory;
+
+    const std::vector<std::vector<osmium::NodeRef>> lines{
+        {{1, {1.0, 1.0}}, {2, {2.0, 2.0}}},
+        {{3, {3.0, 3.0}}, {4, {4.0, 4.0}}, {5, {5.0, 5.0}}}
+    };
+
+    const std::string json{factory.create_multilinestring(lines)};
+    REQUIRE(std::string{"{\"type\":\"MultiLineString\",\"coordinates\":[[[1,1],[2,2]],[[3,3],[4,4],[5,5]]]}"} == json);
+}
+
 TEST_CASE("GeoJSON polygon geometry") {
     osmium::geom::GeoJSONFactory<> factory;
     osmium::memory::Buffer buffer{1000};
@@ -171,3 +186,53 @@ TEST_CASE("GeoJSON area geometry") {
 
 }
 
+
+TEST_CASE("GeoJSON factory appending to output string") {
+    osmium::memory::Buffer wnl_buffer{10000};
+    const auto& wnl = create_test_wnl_okay(wnl_buffer);
+    osmium::memory::Buffer area_buffer{10000};
+    const auto& area = create_test_area_2outer_2inner(area_buffer);
+    const osmium::Location loc{3.2, 4.2};
+
+    osmium::geom::GeoJSONFactory<> factory;
+    const std::string expected = "x" +
+                                 factory.create_point(loc) + "\n" +
+                                 factory.create_linestring(wnl) + "\n" +
+                                 factory.create_multipolygon(area) + "\n";
+
+    std::string output{"x"};
+    osmium::geom::GeoJSONFactory<> out_factory{7, output};
+    REQUIRE(out_factory.create_point(loc).empty());
+    output += '\n';
+    REQUIRE(out_factory.create_linestring(wnl).empty());
+    output += '\n';
+    REQUIRE(out_factory.create_multipolygon(area).empty());
+    output += '\n';
+
+    REQUIRE(output == expected);
+}
+
+TEST_CASE("GeoJSON feature with properties") {
+    osmium::memory::Buffer buffer{10000};
+    osmium::builder::add_node(buffer,
+        _id(17),
+        _location(3.2, 4.2),
+        _tag("name", "The \"Pub\""),
+        _tag("note", "a\\b\nc\x01")
+    );
+    const auto& node = buffer.get<osmium::Node>(0);
+
+    std::string output;
+    osmium::geom::GeoJSONFactory<> factory{7, output};
+    osmium::geom::append_geojson_feature(output, node.tags(), [&]() {
+        factory.create_point(node);
+    });
+
+    REQUIRE(output == R"({"type":"Feature","geometry":{"type":"Point","coordinates":[3.2,4.2]},"properties":{"name":"The \"Pub\"","note":"a\\b\nc\u0001"}})");
+
+    osmium::memory::Buffer untagged_buffer{10000};
+    osmium::builder::add_node(untagged_buffer, _id(18), _location(1, 2));
+    output.clear();
+    osmium::geom::append_geojson_properties(output, untagged_buffer.get<osmium::Node>(0).tags());
+    REQUIRE(output == "{}");
+}
@@ -150,5 +150,42 @@ TEST_CASE("GEOS geometry factory - create area with two outer and two inner ring
     REQUIRE(5 == l1e->getNumPoints());
 }
 
+TEST_CASE("GEOS geometry factory - use thread geos factory") {
+    osmium::geom::GEOSFactory<> factory{osmium::geom::thread_geos_factory()};
+
+    const std::unique_ptr<geos::geom::Point> point{factory.create_point(osmium::Location{3.2, 4.2})};
+    REQUIRE(3.2 == point->getX());
+    REQUIRE(&osmium::geom::thread_geos_factory() == point->getFactory());
+}
+
+TEST_CASE("GEOS geometry factory - prepared geometry from area") {
+    osmium::geom::GEOSFactory<> factory{osmium::geom::thread_geos_factory()};
+
+    osmium::memory::Buffer buffer{10000};
+    const osmium::Area& area = create_test_area_1outer_1inner(buffer);
+
+    const osmium::geom::GEOSPreparedGeometry prepared{factory.create_multipolygon(area)};
+    REQUIRE(prepared.geometry().getNumGeometries() == 1);
+
+    REQUIRE(prepared.contains(osmium::geom::Coordinates{0.5, 0.5}));
+    REQUIRE(prepared.contains(osmium::geom::Coordinates{8.5, 5.0}));
+    REQUIRE_FALSE(prepared.contains(osmium::geom::Coordinates{5.0, 5.0})); // in inner ring
+    REQUIRE_FALSE(prepared.contains(osmium::geom::Coordinates{20.0, 5.0})); // outside bbox
+    REQUIRE_FALSE(prepared.contains(osmium::geom::Coordinates{9.1, 5.0})); // on boundary
+
+    const std::unique_ptr<geos::geom::Point> inside{factory.create_point(osmium::Location{0.5, 0.5})};
+    REQUIRE(prepared.contains(*inside));
+    REQUIRE(prepared.intersects(*inside));
+
+    osmium::memory::Buffer wnl_buffer{10000};
+    const std::unique_ptr<geos::geom::LineString> in_hole{factory.create_linestring(create_test_wnl_okay(wnl_buffer))};
+    REQUIRE_FALSE(prepared.contains(*in_hole));
+    REQUIRE_FALSE(prepared.intersects(*in_hole));
+
+    const std::unique_ptr<geos::geom::Point> outside{factory.create_point(osmium::Location{50.0, 50.0})};
+    REQUIRE_FALSE(prepared.contains(*outside));
+    REQUIRE_FALSE(prepared.intersects(*outside));
+}
+
 #endif
 
@@ -0,0 +1,38 @@
+#include "catch.hpp"
+
+#include <osmium/geom/laea_projection.hpp>
+
+#include <cstddef>
+#include <vector>
+
+TEST_CASE("LAEA Europe projection") {
+    const osmium::geom::LAEAEuropeProjection projection;
+    REQUIRE(projection.epsg() == 3035);
+
+    SECTION("Natural origin") {
+        const auto c = projection(osmium::Location{10.0, 52.0});
+        REQUIRE(c.x == Approx(4321000.0).margin(0.001));
+        REQUIRE(c.y == Approx(3210000.0).margin(0.001));
+    }
+
+    SECTION("Example from EPSG guidance note 7-2") {
+        const auto c = projection(osmium::Location{5.0, 50.0});
+        REQUIRE(c.x == Approx(3962799.45).margin(0.01));
+        REQUIRE(c.y == Approx(2999718.85).margin(0.01));
+    }
+
+    SECTION("Invalid location") {
+        REQUIRE_THROWS_AS(projection(osmium::Location{}), const osmium::invalid_location&);
+    }
+}
+
+TEST_CASE("LAEA Europe projection: project_many") {
+    const osmium::geom::LAEAEuropeProjection projection;
+    const std::vector<osmium::Location> locations{{5.0, 50.0}, {-10.0, 38.0}, {25.0, 65.0}};
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    projection.project_many(locations.data(), locations.size(), coordinates.data());
+
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        REQUIRE(coordinates[n] == projection(locations[n]));
+    }
+}
@@ -2,6 +2,8 @@
 
 #include <osmium/geom/mercator_projection.hpp>
 
+#include <vector>
+
 TEST_CASE("Mercator projection") {
     const osmium::geom::MercatorProjection projection;
     REQUIRE(3857 == projection.epsg());
@@ -32,3 +34,31 @@ TEST_CASE("Mercator bounds") {
     REQUIRE(osmium::geom::detail::y_to_lat(osmium::geom::detail::lon_to_x(180.0)) == Approx(osmium::geom::MERCATOR_MAX_LAT).epsilon(0.0000001));
 }
 
+
+TEST_CASE("Project many locations at once") {
+    const osmium::geom::MercatorProjection projection;
+
+    std::vector<osmium::Location> locations;
+    for (int lat = -90; lat <= 90; lat += 3) {
+        for (int lon = -180; lon <= 180; lon += 17) {
+            locations.emplace_back(lon + 0.1234567, lat * 0.999);
+        }
+    }
+    locations.emplace_back(180.0, 90.0);
+    locations.emplace_back(-180.0, -90.0);
+
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    projection.project_many(locations.data(), locations.size(), coordinates.data());
+
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        const osmium::geom::Coordinates c = projection(locations[n]);
+        REQUIRE(coordinates[n].x == c.x);
+        REQUIRE(coordinates[n].y == c.y);
+    }
+
+    projection.project_many(locations.data(), 0, coordinates.data());
+
+    locations.emplace_back();
+    coordinates.resize(locations.size());
+    REQUIRE_THROWS_AS(projection.project_many(locations.data(), locations.size(), coordinates.data()), const osmium::invalid_location&);
+}
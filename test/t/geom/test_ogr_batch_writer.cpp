@@ -0,0 +1,69 @@
+#include "catch.hpp"
+
+#include <osmium/area/problem_reporter_ogr.hpp>
+#include <osmium/geom/ogr.hpp>
+#include <osmium/geom/ogr_batch_writer.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <gdalcpp.hpp>
+
+#include <cstdio>
+#include <string>
+#include <utility>
+
+static void write_points(gdalcpp::Dataset& dataset, osmium::geom::ogr_background_thread thread) {
+    gdalcpp::Layer layer{dataset, "points", wkbPoint};
+    layer.add_field("id", OFTInteger, 10);
+
+    osmium::geom::OGRFactory<> factory;
+    {
+        osmium::geom::OGRBatchWriter writer{dataset, 10, thread};
+        REQUIRE(writer.background_thread() == (thread == osmium::geom::ogr_background_thread::yes));
+        for (int id = 1; id <= 25; ++id) {
+            osmium::geom::OGRBatchWriter::Feature feature{layer, factory.create_point(osmium::Location{id * 0.1, 1.0})};
+            feature.set_field("id", id);
+            writer.add(std::move(feature));
+        }
+        REQUIRE(writer.count() == 25);
+        writer.close();
+        writer.close();
+    }
+
+    REQUIRE(layer.get().GetFeatureCount() == 25);
+}
+
+TEST_CASE("OGR batch writer") {
+    const std::string filename{"test-ogr-batch-writer.db"};
+
+    SECTION("in calling thread") {
+        std::remove(filename.c_str());
+        gdalcpp::Dataset dataset{"SQLite", filename};
+        write_points(dataset, osmium::geom::ogr_background_thread::no);
+    }
+
+    SECTION("in background thread") {
+        std::remove(filename.c_str());
+        gdalcpp::Dataset dataset{"SQLite", filename};
+        write_points(dataset, osmium::geom::ogr_background_thread::yes);
+    }
+}
+
+TEST_CASE("OGR problem reporter with batch writer") {
+    const std::string filename{"test-ogr-batch-writer-problems.db"};
+    std::remove(filename.c_str());
+    gdalcpp::Dataset dataset{"SQLite", filename};
+
+    osmium::area::ProblemReporterOGR reporter{dataset};
+    {
+        osmium::geom::OGRBatchWriter writer{dataset, 100, osmium::geom::ogr_background_thread::yes};
+        reporter.set_batch_writer(&writer);
+        for (int id = 1; id <= 150; ++id) {
+            reporter.report_duplicate_node(id, id + 1, osmium::Location{id * 0.1, 1.0});
+            reporter.report_role_should_be_inner(id, osmium::Location{1.0, 1.0}, osmium::Location{2.0, 2.0});
+        }
+        writer.close();
+        reporter.set_batch_writer(nullptr);
+    }
+
+    reporter.report_touching_ring(1, osmium::Location{1.0, 1.0});
+}
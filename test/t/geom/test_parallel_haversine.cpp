@@ -0,0 +1,70 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/parallel_haversine.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <cstring>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_ways(int count) {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int n = 0; n < count; ++n) {
+        const double x = (n % 100) * 0.1;
+        const double y = (n / 100) * 0.01;
+        osmium::builder::add_way(buffer,
+            _id(n + 1),
+            _nodes({{1, {x, y}}, {2, {x + 0.01, y}}, {3, {x + 0.01, y + 0.02}}}),
+            _tag("highway", n % 3 ? "primary" : "residential")
+        );
+    }
+
+    return buffer;
+}
+
+static bool is_primary(const osmium::Way& way) {
+    const char* highway = way.tags()["highway"];
+    return highway && !std::strcmp(highway, "primary");
+}
+
+TEST_CASE("Haversine distance of way") {
+    const auto buffer = create_ways(1);
+    const auto& way = buffer.get<osmium::Way>(0);
+
+    const auto& nodes = way.nodes();
+    const double expected = osmium::geom::haversine::distance(nodes[0].location(), nodes[1].location()) +
+                            osmium::geom::haversine::distance(nodes[1].location(), nodes[2].location());
+    REQUIRE(osmium::geom::haversine::distance(nodes) == Approx(expected));
+    REQUIRE(osmium::geom::haversine::distance(nodes) == Approx(1112.0 + 2224.0).epsilon(0.01));
+}
+
+TEST_CASE("Total length of ways in buffer") {
+    const auto buffer = create_ways(5000);
+
+    double all = 0;
+    double primary = 0;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        const double length = osmium::geom::haversine::distance(way.nodes());
+        all += length;
+        if (is_primary(way)) {
+            primary += length;
+        }
+    }
+
+    osmium::thread::Pool pool1{1};
+    osmium::thread::Pool pool4{4};
+
+    REQUIRE(osmium::geom::haversine::total_length(buffer, pool1) == Approx(all));
+    REQUIRE(osmium::geom::haversine::total_length(buffer, is_primary, pool1) == Approx(primary));
+
+    // result doesn't depend on the number of threads
+    REQUIRE(osmium::geom::haversine::total_length(buffer, pool1) == osmium::geom::haversine::total_length(buffer, pool4));
+    REQUIRE(osmium::geom::haversine::total_length(buffer, is_primary, pool4) == osmium::geom::haversine::total_length(buffer, is_primary, pool1));
+
+    REQUIRE(osmium::geom::haversine::total_length(create_ways(10), pool4) > 0.0);
+    REQUIRE(osmium::geom::haversine::total_length(osmium::memory::Buffer{1024}, pool4) == 0.0);
+}
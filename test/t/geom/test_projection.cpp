@@ -4,7 +4,10 @@
 #include <osmium/geom/mercator_projection.hpp>
 #include <osmium/geom/projection.hpp>
 
+#include <cstddef>
 #include <random>
+#include <string>
+#include <vector>
 
 TEST_CASE("Indentity Projection") {
     osmium::geom::IdentityProjection projection;
@@ -108,3 +111,44 @@ TEST_CASE("MercatorProjection: Max latitude") {
     REQUIRE(projection(loc).y == Approx(c.y).epsilon(0.00001));
 }
 
+
+TEST_CASE("Projection with built-in UTM and LAEA gives same results as proj") {
+    for (const int epsg : {32632, 32719, 3035}) {
+        const osmium::geom::Projection builtin{epsg};
+        const osmium::geom::Projection with_proj{std::string{"+init=epsg:"} + std::to_string(epsg)};
+
+        const osmium::Location loc{9.5, epsg == 32719 ? -33.5 : 50.5};
+        REQUIRE(builtin(loc).x == Approx(with_proj(loc).x).margin(0.001));
+        REQUIRE(builtin(loc).y == Approx(with_proj(loc).y).margin(0.001));
+    }
+}
+
+TEST_CASE("Projection: project_many gives same results as operator()") {
+    const osmium::geom::Projection projection{"+proj=lcc +lat_1=49 +lat_2=44 +lat_0=46.5 +lon_0=3 +x_0=700000 +y_0=6600000 +ellps=GRS80 +units=m +no_defs"};
+
+    std::vector<osmium::Location> locations;
+    for (int n = 0; n < 100; ++n) {
+        locations.emplace_back(-5.0 + n * 0.15, 42.0 + n * 0.08);
+    }
+    locations.push_back(locations.front());
+
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    projection.project_many(locations.data(), locations.size(), coordinates.data());
+
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        const auto c = projection(locations[n]);
+        REQUIRE(coordinates[n].x == Approx(c.x));
+        REQUIRE(coordinates[n].y == Approx(c.y));
+    }
+
+    // cached result
+    REQUIRE(projection(locations.front()) == projection(locations.back()));
+}
+
+TEST_CASE("Projection: project_many with invalid location throws") {
+    const osmium::geom::Projection projection{"+proj=lcc +lat_1=49 +lat_2=44 +lat_0=46.5 +lon_0=3 +x_0=700000 +y_0=6600000 +ellps=GRS80 +units=m +no_defs"};
+
+    const std::vector<osmium::Location> locations{osmium::Location{1.0, 45.0}, osmium::Location{}};
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    REQUIRE_THROWS_AS(projection.project_many(locations.data(), locations.size(), coordinates.data()), const osmium::invalid_location&);
+}
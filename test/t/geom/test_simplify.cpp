@@ -0,0 +1,137 @@
+#include "catch.hpp"
+
+#include "area_helper.hpp"
+#include "wnl_helper.hpp"
+
+#include <osmium/geom/simplify.hpp>
+#include <osmium/geom/wkt.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+TEST_CASE("Simplify tolerance for zoom") {
+    REQUIRE(osmium::geom::simplify_tolerance_for_zoom(0) == Approx(360.0 / 256.0));
+    REQUIRE(osmium::geom::simplify_tolerance_for_zoom(10) == Approx(360.0 / 256.0 / 1024.0));
+    REQUIRE(osmium::geom::simplify_tolerance_for_zoom(10, 0.5) == Approx(360.0 / 256.0 / 2048.0));
+}
+
+TEST_CASE("Simplify short sequences") {
+    std::vector<bool> keep;
+    std::vector<osmium::Location> locations;
+
+    osmium::geom::simplify_douglas_peucker(locations, 1.0, keep);
+    REQUIRE(locations.empty());
+
+    locations.emplace_back(1.0, 1.0);
+    locations.emplace_back(1.0, 1.0);
+    osmium::geom::simplify_douglas_peucker(locations, 1.0, keep);
+    REQUIRE(locations.size() == 2);
+}
+
+TEST_CASE("Simplify straight line") {
+    std::vector<bool> keep;
+    std::vector<osmium::Location> locations;
+    for (int n = 0; n <= 10; ++n) {
+        locations.emplace_back(n * 0.1, n * 0.1);
+    }
+
+    osmium::geom::simplify_douglas_peucker(locations, 0.0001, keep);
+    REQUIRE(locations.size() == 2);
+    REQUIRE(locations[0] == osmium::Location(0.0, 0.0));
+    REQUIRE(locations[1] == osmium::Location(1.0, 1.0));
+}
+
+TEST_CASE("Simplify keeps points outside tolerance") {
+    std::vector<bool> keep;
+    const std::vector<osmium::Location> input{
+        {0.0, 0.0}, {1.0, 0.1}, {2.0, -0.1}, {3.0, 5.0}, {4.0, 6.0}, {5.0, 7.0}, {6.0, 8.1}, {7.0, 9.0}
+    };
+
+    auto locations = input;
+    osmium::geom::simplify_douglas_peucker(locations, 0.5, keep);
+    const std::vector<osmium::Location> expected{{0.0, 0.0}, {2.0, -0.1}, {3.0, 5.0}, {7.0, 9.0}};
+    REQUIRE(locations == expected);
+
+    locations = input;
+    osmium::geom::simplify_douglas_peucker(locations, 0.05, keep);
+    REQUIRE(locations.size() == 6);
+
+    locations = input;
+    osmium::geom::simplify_douglas_peucker(locations, 100.0, keep);
+    REQUIRE(locations.size() == 2);
+}
+
+TEST_CASE("Simplify: all dropped points are within tolerance") {
+    std::vector<osmium::Location> locations;
+    for (int n = 0; n < 1000; ++n) {
+        locations.emplace_back(n * 0.001, std::sin(n * 0.05) * 0.1);
+    }
+
+    std::vector<bool> keep(locations.size());
+    const double tolerance = 0.002;
+    const auto num_kept = osmium::geom::simplify_douglas_peucker(locations.data(), locations.size(), tolerance, keep.begin());
+    REQUIRE(num_kept > 2);
+    REQUIRE(num_kept < locations.size() / 5);
+
+    std::size_t count = 0;
+    std::size_t prev = 0;
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        if (!keep[n]) {
+            continue;
+        }
+        ++count;
+        for (std::size_t m = prev + 1; m < n; ++m) {
+            const double d2 = osmium::geom::detail::squared_distance_from_segment(locations[m], locations[prev], locations[n]);
+            REQUIRE(std::sqrt(d2) / osmium::detail::coordinate_precision <= tolerance);
+        }
+        prev = n;
+    }
+    REQUIRE(count == num_kept);
+}
+
+TEST_CASE("Simplified linestring from factory") {
+    osmium::geom::WKTFactory<> factory;
+    osmium::memory::Buffer buffer{10000};
+    const auto pos = osmium::builder::add_way_node_list(buffer, _nodes({
+        {1, {3.0, 4.0}},
+        {2, {3.1, 4.00001}},
+        {3, {3.2, 4.0}},
+        {4, {3.2, 4.0}},
+        {5, {3.3, 4.5}}
+    }));
+    const auto& wnl = buffer.get<osmium::WayNodeList>(pos);
+
+    REQUIRE(factory.simplify_tolerance() == 0.0);
+    REQUIRE(std::string{factory.create_linestring(wnl)} == "LINESTRING(3 4,3.1 4.00001,3.2 4,3.3 4.5)");
+
+    factory.set_simplify_tolerance(0.001);
+    REQUIRE(std::string{factory.create_linestring(wnl)} == "LINESTRING(3 4,3.2 4,3.3 4.5)");
+    REQUIRE(std::string{factory.create_linestring(wnl, osmium::geom::use_nodes::unique, osmium::geom::direction::backward)} == "LINESTRING(3.3 4.5,3.2 4,3 4)");
+
+    factory.set_simplify_tolerance(10.0);
+    REQUIRE(std::string{factory.create_linestring(wnl)} == "LINESTRING(3 4,3.3 4.5)");
+}
+
+TEST_CASE("Simplified polygon and multipolygon from factory") {
+    osmium::geom::WKTFactory<> factory;
+    factory.set_simplify_tolerance(0.2);
+    osmium::memory::Buffer buffer{10000};
+
+    SECTION("Polygon is simplified") {
+        const auto& wnl = create_test_wnl_closed(buffer);
+        REQUIRE(std::string{factory.create_polygon(wnl)} == "POLYGON((3 3,4.1 4.1,3.6 4.1,3 3))");
+    }
+
+    SECTION("Ring is not simplified below four points") {
+        factory.set_simplify_tolerance(10.0);
+        const auto& wnl = create_test_wnl_closed(buffer);
+        REQUIRE(std::string{factory.create_polygon(wnl)} == "POLYGON((3 3,4.1 4.1,3.6 4.1,3.1 3.5,3 3))");
+    }
+
+    SECTION("Multipolygon rings") {
+        const auto& area = create_test_area_1outer_1inner(buffer);
+        REQUIRE(std::string{factory.create_multipolygon(area)} == "MULTIPOLYGON(((0.1 0.1,9.1 0.1,9.1 9.1,0.1 9.1,0.1 0.1),(1 1,8 1,8 8,1 8,1 1)))");
+    }
+}
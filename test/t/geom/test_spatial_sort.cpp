@@ -0,0 +1,120 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/spatial_sort.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using ids_type = std::vector<osmium::object_id_type>;
+
+static ids_type ids(const osmium::memory::Buffer& buffer) {
+    ids_type result;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        result.push_back(object.type() == osmium::item_type::way ? -object.id() : object.id());
+    }
+    return result;
+}
+
+TEST_CASE("Space filling curve names") {
+    REQUIRE(osmium::geom::space_filling_curve_from_name("morton") == osmium::geom::space_filling_curve::morton);
+    REQUIRE(osmium::geom::space_filling_curve_from_name("hilbert") == osmium::geom::space_filling_curve::hilbert);
+    REQUIRE(std::string{osmium::geom::space_filling_curve_name(osmium::geom::space_filling_curve::hilbert)} == "hilbert");
+    REQUIRE_THROWS_AS(osmium::geom::space_filling_curve_from_name("peano"), const std::invalid_argument&);
+}
+
+TEST_CASE("Morton key interleaves the coordinate bits") {
+    const osmium::Location min{-180.0, -90.0};
+    const osmium::Location max{180.0, 90.0};
+    REQUIRE(osmium::geom::morton_key(min) < osmium::geom::morton_key(max));
+
+    // Quadrants in Z order: bottom left, bottom right, top left, top right
+    const auto bl = osmium::geom::morton_key(osmium::Location{-10.0, -10.0});
+    const auto br = osmium::geom::morton_key(osmium::Location{10.0, -10.0});
+    const auto tl = osmium::geom::morton_key(osmium::Location{-10.0, 10.0});
+    const auto tr = osmium::geom::morton_key(osmium::Location{10.0, 10.0});
+    REQUIRE(bl < br);
+    REQUIRE(br < tl);
+    REQUIRE(tl < tr);
+
+    REQUIRE(osmium::geom::morton_key(osmium::Location{}) == osmium::geom::invalid_spatial_key);
+}
+
+TEST_CASE("Hilbert key follows the Hilbert curve") {
+    // Quadrants in Hilbert order: bottom left, top left, top right, bottom right
+    const auto bl = osmium::geom::hilbert_key(osmium::Location{-10.0, -10.0});
+    const auto tl = osmium::geom::hilbert_key(osmium::Location{-10.0, 10.0});
+    const auto tr = osmium::geom::hilbert_key(osmium::Location{10.0, 10.0});
+    const auto br = osmium::geom::hilbert_key(osmium::Location{10.0, -10.0});
+    REQUIRE(bl < tl);
+    REQUIRE(tl < tr);
+    REQUIRE(tr < br);
+
+    REQUIRE(osmium::geom::hilbert_key(osmium::Location{}) == osmium::geom::invalid_spatial_key);
+    REQUIRE(osmium::geom::hilbert_key(osmium::Location{1000.0, 0.0}) == osmium::geom::invalid_spatial_key);
+}
+
+TEST_CASE("Neighbouring Hilbert keys are adjacent locations") {
+    // Walk along a small part of the curve: all consecutive cells must
+    // be direct neighbours.
+    const int32_t base = 123456;
+    std::vector<std::pair<uint64_t, osmium::Location>> cells;
+    for (int32_t x = 0; x < 16; ++x) {
+        for (int32_t y = 0; y < 16; ++y) {
+            const osmium::Location location{base * 16 + x, base * 16 + y};
+            cells.emplace_back(osmium::geom::hilbert_key(location), location);
+        }
+    }
+    std::sort(cells.begin(), cells.end(), [](const std::pair<uint64_t, osmium::Location>& a, const std::pair<uint64_t, osmium::Location>& b) {
+        return a.first < b.first;
+    });
+
+    for (std::size_t i = 1; i < cells.size(); ++i) {
+        REQUIRE(cells[i].first == cells[i - 1].first + 1);
+        const auto dx = std::abs(cells[i].second.x() - cells[i - 1].second.x());
+        const auto dy = std::abs(cells[i].second.y() - cells[i - 1].second.y());
+        REQUIRE(dx + dy == 1);
+    }
+}
+
+TEST_CASE("Spatial sort of buffer") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1), _location(10.0, 10.0));
+    osmium::builder::add_node(buffer, _id(2), _location(-10.0, -10.0));
+    osmium::builder::add_node(buffer, _id(3));
+    osmium::builder::add_node(buffer, _id(4), _location(10.0, -10.0));
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {10.0, 10.0}}, {4, {10.0, -9.0}}}));
+    osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::node, 1));
+    osmium::builder::add_way(buffer, _id(2), _nodes({1, 2}));
+    osmium::builder::add_node(buffer, _id(5), _location(-10.0, 10.0));
+    osmium::builder::add_way(buffer, _id(3), _nodes({{2, {-10.0, -10.0}}, {5, {-10.0, -9.0}}}));
+
+    const auto committed = buffer.committed();
+
+    SECTION("hilbert") {
+        osmium::geom::spatial_sort(buffer, osmium::geom::space_filling_curve::hilbert);
+        REQUIRE(ids(buffer) == (ids_type{2, 5, 1, 4, 3, -3, -1, -2, 1}));
+    }
+
+    SECTION("morton") {
+        osmium::geom::spatial_sort(buffer, osmium::geom::space_filling_curve::morton);
+        REQUIRE(ids(buffer) == (ids_type{2, 4, 5, 1, 3, -3, -1, -2, 1}));
+    }
+
+    REQUIRE(buffer.committed() == committed);
+}
+
+TEST_CASE("Spatial sort of empty buffer") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::geom::spatial_sort(buffer, osmium::geom::space_filling_curve::hilbert);
+    REQUIRE(buffer.committed() == 0);
+}
@@ -4,7 +4,9 @@
 
 #include <osmium/geom/tile.hpp>
 
+#include <iterator>
 #include <sstream>
+#include <vector>
 
 TEST_CASE("Helper functions") {
     REQUIRE(osmium::geom::num_tiles_in_zoom(0) == 1);
@@ -141,3 +143,26 @@ TEST_CASE("Invalid tiles") {
     REQUIRE_FALSE(tile.valid());
 }
 
+
+TEST_CASE("Tiles for many locations at once") {
+    std::vector<osmium::Location> locations;
+    for (int lat = -900; lat <= 900; lat += 7) {
+        for (int lon = -1800; lon <= 1800; lon += 45) {
+            locations.emplace_back(lon * 0.1, lat * 0.1);
+        }
+    }
+    REQUIRE(locations.size() > 256);
+
+    for (const uint32_t zoom : {0u, 1u, 5u, 14u, 30u}) {
+        std::vector<osmium::geom::Tile> tiles;
+        osmium::geom::tiles_for_locations(zoom, locations.data(), locations.data() + locations.size(), std::back_inserter(tiles));
+        REQUIRE(tiles.size() == locations.size());
+        for (std::size_t n = 0; n < locations.size(); ++n) {
+            REQUIRE(tiles[n] == osmium::geom::Tile(zoom, locations[n]));
+        }
+    }
+
+    locations.emplace_back();
+    std::vector<osmium::geom::Tile> tiles;
+    REQUIRE_THROWS_AS(osmium::geom::tiles_for_locations(3, locations.data(), locations.data() + locations.size(), std::back_inserter(tiles)), const osmium::invalid_location&);
+}
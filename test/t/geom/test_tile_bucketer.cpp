@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/tile_bucketer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+
+#include <map>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using ids_type = std::vector<osmium::object_id_type>;
+
+static ids_type ids(const osmium::memory::Buffer& buffer) {
+    ids_type result;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        result.push_back(object.type() == osmium::item_type::way ? -object.id() : object.id());
+    }
+    return result;
+}
+
+static osmium::memory::Buffer create_buffer() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1), _location(10.0, 10.0));
+    osmium::builder::add_node(buffer, _id(2), _location(-10.0, 10.0));
+    osmium::builder::add_node(buffer, _id(3), _location(10.0, -10.0));
+    osmium::builder::add_node(buffer, _id(4));
+    osmium::builder::add_node(buffer, _id(5), _location(20.0, 20.0));
+
+    // way in two tiles
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {10.0, 10.0}}, {5, {20.0, 20.0}}, {2, {-10.0, 10.0}}}));
+
+    // way without locations
+    osmium::builder::add_way(buffer, _id(2), _nodes({1, 2}));
+
+    osmium::builder::add_relation(buffer, _id(1), _member(osmium::item_type::node, 1));
+
+    osmium::builder::add_way(buffer, _id(3), _nodes({{3, {10.0, -10.0}}, {4, osmium::Location{}}}));
+
+    return buffer;
+}
+
+TEST_CASE("Tile bucketer puts nodes and ways into their tiles") {
+    std::map<osmium::geom::Tile, ids_type> buckets;
+    osmium::geom::TileBucketer bucketer{1, [&](const osmium::geom::Tile& tile, osmium::memory::Buffer&& buffer) {
+        REQUIRE(buckets.count(tile) == 0);
+        buckets[tile] = ids(buffer);
+    }};
+    REQUIRE(bucketer.zoom() == 1);
+
+    bucketer(create_buffer());
+    REQUIRE(bucketer.num_buckets() == 3);
+    REQUIRE(buckets.empty());
+
+    bucketer.flush();
+    REQUIRE(bucketer.num_buckets() == 0);
+
+    REQUIRE(buckets.size() == 3);
+    REQUIRE(buckets[osmium::geom::Tile(1, 1, 0)] == (ids_type{1, 5, -1}));
+    REQUIRE(buckets[osmium::geom::Tile(1, 0, 0)] == (ids_type{2, -1}));
+    REQUIRE(buckets[osmium::geom::Tile(1, 1, 1)] == (ids_type{3, -3}));
+}
+
+TEST_CASE("Tile bucketer hands over full buckets") {
+    std::size_t count = 0;
+    std::size_t calls = 0;
+    osmium::geom::TileBucketer bucketer{0, [&](const osmium::geom::Tile& tile, osmium::memory::Buffer&& buffer) {
+        REQUIRE(tile == osmium::geom::Tile(0, 0, 0));
+        count += ids(buffer).size();
+        ++calls;
+    }, 500};
+
+    for (int n = 0; n < 10; ++n) {
+        bucketer(create_buffer());
+    }
+    REQUIRE(calls > 1);
+    bucketer.flush();
+    REQUIRE(count == 10 * 6);
+}
@@ -0,0 +1,161 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/factory.hpp>
+#include <osmium/geom/tile_clipper.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/area.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <initializer_list>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Tile 1/1/0 is the north-east quarter of the world: lon 0 to 180 and
+// lat 0 to 85.0511.
+static osmium::geom::TileClipper ne_clipper() {
+    return osmium::geom::TileClipper{osmium::geom::Tile{1, 1, 0}};
+}
+
+static const osmium::Way& add_way(osmium::memory::Buffer& buffer, const std::initializer_list<osmium::NodeRef>& nodes) {
+    const auto pos = osmium::builder::add_way(buffer, _id(17), _nodes(nodes));
+    return buffer.get<osmium::Way>(pos);
+}
+
+TEST_CASE("Tile clipper box") {
+    const auto clipper = ne_clipper();
+    REQUIRE(clipper.box().bottom_left() == osmium::Location(0.0, 0.0));
+    REQUIRE(clipper.box().top_right().lon() == Approx(180.0));
+    REQUIRE(clipper.box().top_right().lat() == Approx(85.0511288));
+
+    const osmium::geom::TileClipper buffered{osmium::geom::Tile{1, 1, 0}, 0.5};
+    REQUIRE(buffered.box().bottom_left().lon() == Approx(-90.0));
+    REQUIRE(buffered.box().bottom_left().lat() < -66.0);
+    REQUIRE(buffered.box().top_right().lon() == Approx(180.0));
+}
+
+TEST_CASE("Tile clipper clips linestring") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    auto clipper = ne_clipper();
+    osmium::geom::WKTFactory<> factory;
+
+    SECTION("line crossing the tile boundary twice") {
+        const auto& way = add_way(buffer, {{1, {-10.0, 10.0}}, {2, {10.0, 10.0}}, {3, {10.0, -10.0}}});
+        const auto& lines = clipper.clip_linestring(way.nodes());
+        REQUIRE(lines.size() == 1);
+        REQUIRE(lines[0].size() == 3);
+        REQUIRE(lines[0][0].location() == osmium::Location(0.0, 10.0));
+        REQUIRE(lines[0][1].location() == osmium::Location(10.0, 10.0));
+        REQUIRE(lines[0][2].location() == osmium::Location(10.0, 0.0));
+        REQUIRE(clipper.create_multilinestring(factory, way) == "MULTILINESTRING((0 10,10 10,10 0))");
+    }
+
+    SECTION("line leaving and entering the tile") {
+        const auto& way = add_way(buffer, {{1, {5.0, 5.0}}, {2, {5.0, -5.0}}, {3, {15.0, -5.0}}, {4, {15.0, 5.0}}});
+        REQUIRE(clipper.create_multilinestring(factory, way) == "MULTILINESTRING((5 5,5 0),(15 0,15 5))");
+    }
+
+    SECTION("line inside tile") {
+        const auto& way = add_way(buffer, {{1, {5.0, 5.0}}, {2, {5.0, 5.0}}, {3, {6.0, 7.0}}});
+        REQUIRE(clipper.create_multilinestring(factory, way) == "MULTILINESTRING((5 5,6 7))");
+    }
+
+    SECTION("line outside tile") {
+        const auto& way = add_way(buffer, {{1, {-5.0, 5.0}}, {2, {-5.0, -5.0}}, {3, {5.0, -5.0}}});
+        REQUIRE(clipper.clip_linestring(way.nodes()).empty());
+        REQUIRE_THROWS_AS(clipper.create_multilinestring(factory, way), const osmium::geometry_error&);
+    }
+
+    SECTION("line only touching the tile") {
+        const auto& way = add_way(buffer, {{1, {-5.0, 5.0}}, {2, {5.0, -5.0}}});
+        REQUIRE(clipper.clip_linestring(way.nodes()).empty());
+    }
+
+    SECTION("line with invalid location") {
+        const auto& way = add_way(buffer, {{1, {5.0, 5.0}}, {2, osmium::Location{}}});
+        REQUIRE_THROWS_AS(clipper.clip_linestring(way.nodes()), const osmium::invalid_location&);
+    }
+}
+
+TEST_CASE("Tile clipper clips polygon") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    auto clipper = ne_clipper();
+    osmium::geom::WKTFactory<> factory;
+
+    SECTION("polygon overlapping a tile corner") {
+        const auto& way = add_way(buffer, {{1, {-10.0, -10.0}}, {2, {10.0, -10.0}}, {3, {10.0, 10.0}}, {4, {-10.0, 10.0}}, {1, {-10.0, -10.0}}});
+        const auto& ring = clipper.clip_ring(way.nodes());
+        REQUIRE(ring.size() == 5);
+        REQUIRE(ring.front().location() == ring.back().location());
+        REQUIRE(clipper.create_polygon(factory, way) == "POLYGON((0 0,10 0,10 10,0 10,0 0))");
+    }
+
+    SECTION("polygon inside tile") {
+        const auto& way = add_way(buffer, {{1, {1.0, 1.0}}, {2, {2.0, 1.0}}, {3, {2.0, 2.0}}, {1, {1.0, 1.0}}});
+        REQUIRE(clipper.create_polygon(factory, way) == "POLYGON((1 1,2 1,2 2,1 1))");
+    }
+
+    SECTION("polygon with collinear points on the boundary") {
+        const auto& way = add_way(buffer, {{1, {-1.0, 1.0}}, {2, {1.0, 1.0}}, {3, {1.0, 4.0}}, {4, {-1.0, 4.0}}, {5, {-2.0, 3.0}}, {6, {-1.0, 2.0}}, {1, {-1.0, 1.0}}});
+        REQUIRE(clipper.create_polygon(factory, way) == "POLYGON((0 1,1 1,1 4,0 4,0 1))");
+    }
+
+    SECTION("polygon outside tile only touching it") {
+        const auto& way = add_way(buffer, {{1, {-1.0, 1.0}}, {2, {0.0, 1.0}}, {3, {0.0, 2.0}}, {4, {-1.0, 2.0}}, {1, {-1.0, 1.0}}});
+        REQUIRE(clipper.clip_ring(way.nodes()).empty());
+        REQUIRE_THROWS_AS(clipper.create_polygon(factory, way), const osmium::geometry_error&);
+    }
+
+    SECTION("polygon containing the whole tile") {
+        const auto& way = add_way(buffer, {{1, {-1.0, -1.0}}, {2, {179.0, -1.0}}, {3, {179.0, 89.0}}, {4, {-1.0, 89.0}}, {1, {-1.0, -1.0}}});
+        const auto& ring = clipper.clip_ring(way.nodes());
+        REQUIRE(ring.size() == 5);
+        REQUIRE(ring[0].location() == osmium::Location(0.0, 0.0));
+        REQUIRE(ring[1].location().lat() == Approx(0.0));
+        REQUIRE(ring[2].location().lat() == Approx(85.0511288));
+    }
+
+    SECTION("way not closed") {
+        const auto& way = add_way(buffer, {{1, {1.0, 1.0}}, {2, {2.0, 1.0}}, {3, {2.0, 2.0}}});
+        REQUIRE_THROWS_AS(clipper.create_polygon(factory, way), const osmium::geometry_error&);
+    }
+}
+
+TEST_CASE("Tile clipper clips multipolygon") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    auto clipper = ne_clipper();
+    osmium::geom::WKTFactory<> factory;
+
+    osmium::builder::add_area(buffer, _id(42),
+        _outer_ring({
+            {1, {-5.0, 1.0}}, {2, {5.0, 1.0}}, {3, {5.0, 5.0}}, {4, {-5.0, 5.0}}, {1, {-5.0, 1.0}}
+        }),
+        _inner_ring({
+            {5, {-2.0, 2.0}}, {6, {-2.0, 3.0}}, {7, {2.0, 3.0}}, {8, {2.0, 2.0}}, {5, {-2.0, 2.0}}
+        }),
+        _inner_ring({
+            {9, {-4.0, 2.0}}, {10, {-4.0, 3.0}}, {11, {-3.0, 3.0}}, {12, {-3.0, 2.0}}, {9, {-4.0, 2.0}}
+        }),
+        _outer_ring({
+            {13, {-5.0, -5.0}}, {14, {-4.0, -5.0}}, {15, {-4.0, -4.0}}, {13, {-5.0, -5.0}}
+        }),
+        _outer_ring({
+            {16, {10.0, 10.0}}, {17, {11.0, 10.0}}, {18, {11.0, 11.0}}, {16, {10.0, 10.0}}
+        })
+    );
+    const auto& area = buffer.get<osmium::Area>(0);
+
+    REQUIRE(clipper.create_multipolygon(factory, area) ==
+            "MULTIPOLYGON(((0 1,5 1,5 5,0 5,0 1),(0 2,0 3,2 3,2 2,0 2)),((10 10,11 10,11 11,10 10)))");
+
+    const osmium::geom::TileClipper other{osmium::geom::Tile{2, 3, 3}};
+    try {
+        auto c = other;
+        c.create_multipolygon(factory, area);
+        REQUIRE(false);
+    } catch (const osmium::geometry_error& e) {
+        REQUIRE(e.id() == 42);
+    }
+}
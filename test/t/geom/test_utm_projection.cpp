@@ -0,0 +1,77 @@
+#include "catch.hpp"
+
+#include <osmium/geom/utm_projection.hpp>
+
+#include <cstddef>
+#include <vector>
+
+TEST_CASE("Transverse Mercator example from EPSG guidance note 7-2 (OSGB)") {
+    const osmium::geom::detail::transverse_mercator tm{6377563.396, 299.3249646, -2.0, 49.0, 0.9996012717, 400000.0, -100000.0};
+    const auto c = tm(0.5, 50.5);
+    REQUIRE(c.x == Approx(577274.99).margin(0.01));
+    REQUIRE(c.y == Approx(69740.49).margin(0.01));
+}
+
+TEST_CASE("UTM projection") {
+    const osmium::geom::UTMProjection projection{32};
+    REQUIRE(projection.zone() == 32);
+    REQUIRE_FALSE(projection.south());
+    REQUIRE(projection.epsg() == 32632);
+    REQUIRE(projection.proj_string() == "+proj=utm +zone=32 +datum=WGS84 +units=m +no_defs");
+
+    SECTION("On central meridian") {
+        const auto c = projection(osmium::Location{9.0, 48.0});
+        REQUIRE(c.x == Approx(500000.0).margin(0.001));
+        REQUIRE(c.y == Approx(5316300.224).margin(0.001));
+    }
+
+    SECTION("Symmetric to central meridian") {
+        const auto c1 = projection(osmium::Location{7.5, 51.0});
+        const auto c2 = projection(osmium::Location{10.5, 51.0});
+        REQUIRE(c1.x + c2.x == Approx(1000000.0).margin(0.001));
+        REQUIRE(c1.y == Approx(c2.y).margin(0.001));
+    }
+
+    SECTION("Invalid location") {
+        REQUIRE_THROWS_AS(projection(osmium::Location{}), const osmium::invalid_location&);
+    }
+}
+
+TEST_CASE("UTM projection on southern hemisphere") {
+    const auto projection = osmium::geom::UTMProjection::from_epsg(32719);
+    REQUIRE(projection.zone() == 19);
+    REQUIRE(projection.south());
+    REQUIRE(projection.epsg() == 32719);
+
+    const auto c = projection(osmium::Location{-69.0, 0.0});
+    REQUIRE(c.x == Approx(500000.0).margin(0.001));
+    REQUIRE(c.y == Approx(10000000.0).margin(0.001));
+}
+
+TEST_CASE("UTM EPSG codes") {
+    REQUIRE(osmium::geom::UTMProjection::is_utm_epsg(32601));
+    REQUIRE(osmium::geom::UTMProjection::is_utm_epsg(32660));
+    REQUIRE(osmium::geom::UTMProjection::is_utm_epsg(32701));
+    REQUIRE(osmium::geom::UTMProjection::is_utm_epsg(32760));
+    REQUIRE_FALSE(osmium::geom::UTMProjection::is_utm_epsg(32600));
+    REQUIRE_FALSE(osmium::geom::UTMProjection::is_utm_epsg(32661));
+    REQUIRE_FALSE(osmium::geom::UTMProjection::is_utm_epsg(3857));
+}
+
+TEST_CASE("Invalid UTM zone") {
+    REQUIRE_THROWS_AS(osmium::geom::UTMProjection{0}, const osmium::projection_error&);
+    REQUIRE_THROWS_AS(osmium::geom::UTMProjection{61}, const osmium::projection_error&);
+}
+
+TEST_CASE("UTM projection: project_many") {
+    const osmium::geom::UTMProjection projection{33};
+    const std::vector<osmium::Location> locations{{13.405, 52.52}, {15.0, 0.0}, {12.0, 60.0}};
+    std::vector<osmium::geom::Coordinates> coordinates(locations.size());
+    projection.project_many(locations.data(), locations.size(), coordinates.data());
+
+    REQUIRE(coordinates[0].x == Approx(391779.259).margin(0.001));
+    REQUIRE(coordinates[0].y == Approx(5820072.159).margin(0.001));
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        REQUIRE(coordinates[n] == projection(locations[n]));
+    }
+}
@@ -0,0 +1,158 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/mercator_projection.hpp>
+#include <osmium/geom/way_geometry_cache.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    struct CountingProjection {
+
+        int* count;
+
+        osmium::geom::Coordinates operator()(osmium::Location location) const {
+            ++*count;
+            return osmium::geom::lonlat_to_mercator(osmium::geom::Coordinates{location});
+        }
+
+        int epsg() const noexcept {
+            return 3857;
+        }
+
+        std::string proj_string() const {
+            return "";
+        }
+
+    }; // struct CountingProjection
+
+} // anonymous namespace
+
+static const osmium::Way& add_way(osmium::memory::Buffer& buffer, osmium::object_id_type id, osmium::object_version_type version = 1) {
+    const auto pos = osmium::builder::add_way(buffer, _id(id), _version(version), _nodes({
+        {1, {3.0, 3.0}},
+        {2, {4.1, 4.1}},
+        {3, {4.1, 4.1}},
+        {4, {3.6, 4.1}},
+        {5, {3.1, 3.5}},
+        {6, {3.0, 3.0}}
+    }));
+    return buffer.get<osmium::Way>(pos);
+}
+
+TEST_CASE("Way geometry cache calculates geometry once") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto& way = add_way(buffer, 17);
+
+    int count = 0;
+    const CountingProjection projection{&count};
+    osmium::geom::WayGeometryCache cache;
+    REQUIRE_FALSE(cache.contains(way));
+
+    const auto& geom = cache.get(way, projection);
+    REQUIRE(count == 5);
+    REQUIRE(geom.coordinates.size() == 5);
+    REQUIRE(geom.envelope.bottom_left() == osmium::Location(3.0, 3.0));
+    REQUIRE(geom.envelope.top_right() == osmium::Location(4.1, 4.1));
+    REQUIRE(cache.contains(way));
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.used_memory() > 0);
+
+    cache.get(way, projection);
+    REQUIRE(count == 5);
+    REQUIRE(cache.hits() == 1);
+    REQUIRE(cache.misses() == 1);
+
+    const auto& way2 = add_way(buffer, 17, 2);
+    REQUIRE_FALSE(cache.contains(way2));
+    cache.get(way2, projection);
+    REQUIRE(count == 10);
+    REQUIRE(cache.size() == 1);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.used_memory() == 0);
+}
+
+TEST_CASE("Way geometry cache removes least recently used ways") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto& way1 = add_way(buffer, 1);
+    const auto& way2 = add_way(buffer, 2);
+    const auto& way3 = add_way(buffer, 3);
+
+    int count = 0;
+    const CountingProjection projection{&count};
+
+    osmium::geom::WayGeometryCache probe;
+    probe.get(way1, projection);
+    const auto size_of_one = probe.used_memory();
+
+    osmium::geom::WayGeometryCache cache{size_of_one * 2};
+    cache.get(way1, projection);
+    cache.get(way2, projection);
+    cache.get(way1, projection);
+    cache.get(way3, projection);
+
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.used_memory() <= cache.max_memory());
+    REQUIRE(cache.contains(way1));
+    REQUIRE_FALSE(cache.contains(way2));
+    REQUIRE(cache.contains(way3));
+
+    osmium::geom::WayGeometryCache tiny{1};
+    tiny.get(way1, projection);
+    REQUIRE(tiny.size() == 1);
+    tiny.get(way2, projection);
+    REQUIRE(tiny.size() == 1);
+    REQUIRE(tiny.contains(way2));
+}
+
+TEST_CASE("Geometry factory with way geometry cache") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto& way = add_way(buffer, 5);
+
+    osmium::geom::WKTFactory<osmium::geom::MercatorProjection> factory{7};
+    const std::string linestring = factory.create_linestring(way);
+    const std::string backward = factory.create_linestring(way, osmium::geom::use_nodes::unique, osmium::geom::direction::backward);
+    const std::string all = factory.create_linestring(way, osmium::geom::use_nodes::all);
+    const std::string polygon = factory.create_polygon(way);
+
+    osmium::geom::WayGeometryCache cache;
+    factory.set_way_geometry_cache(&cache);
+    REQUIRE(factory.way_geometry_cache() == &cache);
+
+    REQUIRE(factory.create_linestring(way) == linestring);
+    REQUIRE(factory.create_linestring(way, osmium::geom::use_nodes::unique, osmium::geom::direction::backward) == backward);
+    REQUIRE(factory.create_polygon(way) == polygon);
+    REQUIRE(cache.misses() == 1);
+    REQUIRE(cache.hits() == 2);
+
+    REQUIRE(factory.create_linestring(way, osmium::geom::use_nodes::all) == all);
+    REQUIRE(cache.hits() == 2);
+
+    factory.set_way_geometry_cache(nullptr);
+    REQUIRE(factory.create_linestring(way) == linestring);
+    REQUIRE(cache.hits() == 2);
+}
+
+TEST_CASE("Geometry factory with way geometry cache and too few points") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto pos = osmium::builder::add_way(buffer, _id(8), _nodes({
+        {1, {3.0, 3.0}},
+        {2, {3.0, 3.0}}
+    }));
+    const auto& way = buffer.get<osmium::Way>(pos);
+
+    osmium::geom::WayGeometryCache cache;
+    osmium::geom::WKTFactory<osmium::geom::MercatorProjection> factory;
+    factory.set_way_geometry_cache(&cache);
+
+    REQUIRE_THROWS_AS(factory.create_linestring(way), const osmium::geometry_error&);
+    REQUIRE_THROWS_AS(factory.create_polygon(way), const osmium::geometry_error&);
+}
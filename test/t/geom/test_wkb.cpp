@@ -1,5 +1,6 @@
 #include "catch.hpp"
 
+#include "area_helper.hpp"
 #include "wnl_helper.hpp"
 
 #include <osmium/geom/mercator_projection.hpp>
@@ -7,6 +8,7 @@
 #include <osmium/util/endian.hpp>
 
 #include <string>
+#include <vector>
 
 #if __BYTE_ORDER == __LITTLE_ENDIAN
 
@@ -110,6 +112,18 @@ TEST_CASE("WKB geometry factory (byte-order-dependent): linestring with two same
     }
 }
 
+TEST_CASE("WKB geometry factory (byte-order-dependent): multilinestring") {
+    osmium::geom::WKBFactory<> factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex};
+
+    const std::vector<std::vector<osmium::NodeRef>> lines{
+        {{1, {1.0, 1.0}}, {2, {2.0, 2.0}}},
+        {{3, {3.0, 3.0}}, {4, {4.0, 4.0}}}
+    };
+
+    const std::string wkb{factory.create_multilinestring(lines)};
+    REQUIRE(wkb == "010500000002000000010200000002000000000000000000F03F000000000000F03F000000000000004000000000000000400102000000020000000000000000000840000000000000084000000000000010400000000000001040");
+}
+
 TEST_CASE("WKB geometry factory (byte-order-dependent): linestring with undefined location") {
     osmium::memory::Buffer buffer{10000};
     osmium::geom::WKBFactory<> factory{osmium::geom::wkb_type::wkb, osmium::geom::out_type::hex};
@@ -137,3 +151,30 @@ TEST_CASE("WKB geometry (byte-order-independent) of empty linestring") {
     REQUIRE_THROWS_AS(factory.create_linestring(wnl, osmium::geom::use_nodes::all, osmium::geom::direction::backward), const osmium::geometry_error&);
 }
 
+
+TEST_CASE("WKB geometry factory appending to output string") {
+    osmium::memory::Buffer wnl_buffer{10000};
+    const auto& wnl = create_test_wnl_okay(wnl_buffer);
+    osmium::memory::Buffer area_buffer{10000};
+    const auto& area = create_test_area_2outer_2inner(area_buffer);
+    const osmium::Location loc{3.2, 4.2};
+
+    for (const auto otype : {osmium::geom::out_type::binary, osmium::geom::out_type::hex}) {
+        osmium::geom::WKBFactory<> factory{osmium::geom::wkb_type::ewkb, otype};
+        const std::string expected = "prefix" +
+                                     factory.create_point(loc) + "\t" +
+                                     factory.create_linestring(wnl) + "\t" +
+                                     factory.create_multipolygon(area) + "\n";
+
+        std::string output{"prefix"};
+        osmium::geom::WKBFactory<> out_factory{osmium::geom::wkb_type::ewkb, otype, output};
+        REQUIRE(out_factory.create_point(loc).empty());
+        output += '\t';
+        REQUIRE(out_factory.create_linestring(wnl).empty());
+        output += '\t';
+        REQUIRE(out_factory.create_multipolygon(area).empty());
+        output += '\n';
+
+        REQUIRE(output == expected);
+    }
+}
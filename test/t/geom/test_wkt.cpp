@@ -7,6 +7,7 @@
 #include <osmium/geom/wkt.hpp>
 
 #include <string>
+#include <vector>
 
 TEST_CASE("WKT geometry for point") {
     const osmium::geom::WKTFactory<> factory;
@@ -153,3 +154,40 @@ TEST_CASE("WKT geometry factory") {
 
 }
 
+
+TEST_CASE("WKT geometry for multilinestring") {
+    osmium::geom::WKTFactory<> factory;
+
+    std::vector<std::vector<osmium::NodeRef>> lines{
+        {{1, {1.0, 1.0}}, {2, {2.0, 2.0}}, {3, {2.0, 2.0}}},
+        {{4, {3.0, 3.0}}, {5, {4.0, 4.0}}}
+    };
+
+    REQUIRE(factory.create_multilinestring(lines) == "MULTILINESTRING((1 1,2 2),(3 3,4 4))");
+
+    lines.emplace_back(std::vector<osmium::NodeRef>{{6, {5.0, 5.0}}, {7, {5.0, 5.0}}});
+    REQUIRE_THROWS_AS(factory.create_multilinestring(lines), const osmium::geometry_error&);
+
+    lines.clear();
+    REQUIRE_THROWS_AS(factory.create_multilinestring(lines), const osmium::geometry_error&);
+}
+
+TEST_CASE("WKT from location gives same result as from coordinates") {
+    const osmium::Location locations[] = {
+        osmium::Location{0, 0},
+        osmium::Location{-5, 3},
+        osmium::Location{-1800000000, -900000000},
+        osmium::Location{1800000000, 900000000},
+        osmium::Location{1.2345678, -0.1},
+        osmium::Location{-179.9999999, 89.0000001},
+        osmium::Location{10000000, -10000000}
+    };
+
+    for (const int precision : {7, 3}) {
+        const osmium::geom::detail::WKTFactoryImpl impl{4326, precision};
+        for (const auto& location : locations) {
+            REQUIRE(impl.make_point(location) == impl.make_point(osmium::geom::Coordinates{location}));
+        }
+        REQUIRE_THROWS_AS(impl.make_point(osmium::Location{}), const osmium::invalid_location&);
+    }
+}
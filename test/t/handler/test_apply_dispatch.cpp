@@ -0,0 +1,135 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/entity_bits.hpp>
+#include <osmium/visitor.hpp>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    struct WayCounter : public osmium::handler::Handler {
+        int ways = 0;
+        int flushes = 0;
+
+        void way(const osmium::Way& /*way*/) noexcept {
+            ++ways;
+        }
+
+        void flush() noexcept {
+            ++flushes;
+        }
+    };
+
+    struct NodeAndObjectCounter : public osmium::handler::Handler {
+        int nodes = 0;
+        int objects = 0;
+
+        void osm_object(const osmium::OSMObject& /*object*/) noexcept {
+            ++objects;
+        }
+
+        void node(const osmium::Node& /*node*/) noexcept {
+            ++nodes;
+        }
+    };
+
+    struct ChangesetCounter : public osmium::handler::Handler {
+        int changesets = 0;
+
+        void changeset(const osmium::Changeset& /*changeset*/) noexcept {
+            ++changesets;
+        }
+    };
+
+    // Not derived from osmium::handler::Handler
+    struct AllCounter {
+        int count = 0;
+
+        template <typename T>
+        void osm_object(const T& /*object*/) noexcept {
+            ++count;
+        }
+
+        void node(const osmium::Node& /*node*/) const noexcept {
+        }
+
+        void way(const osmium::Way& /*way*/) const noexcept {
+        }
+
+        void relation(const osmium::Relation& /*relation*/) const noexcept {
+        }
+
+        void area(const osmium::Area& /*area*/) const noexcept {
+        }
+
+        void changeset(const osmium::Changeset& /*changeset*/) noexcept {
+            ++count;
+        }
+
+        void flush() const noexcept {
+        }
+    };
+
+} // anonymous namespace
+
+static osmium::memory::Buffer create_buffer() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1));
+    osmium::builder::add_node(buffer, _id(2));
+    osmium::builder::add_way(buffer, _id(1));
+    osmium::builder::add_relation(buffer, _id(1));
+    osmium::builder::add_way(buffer, _id(2));
+    osmium::builder::add_changeset(buffer, _cid(1));
+    return buffer;
+}
+
+TEST_CASE("Entity bits of handlers") {
+    REQUIRE(osmium::detail::handler_entity_bits<osmium::handler::Handler>::value == osmium::osm_entity_bits::nothing);
+    REQUIRE(osmium::detail::handler_entity_bits<WayCounter>::value == osmium::osm_entity_bits::way);
+    REQUIRE(osmium::detail::handler_entity_bits<WayCounter&>::value == osmium::osm_entity_bits::way);
+    REQUIRE(osmium::detail::handler_entity_bits<NodeAndObjectCounter>::value == osmium::osm_entity_bits::object);
+    REQUIRE(osmium::detail::handler_entity_bits<ChangesetCounter>::value == osmium::osm_entity_bits::changeset);
+    REQUIRE(osmium::detail::handler_entity_bits<AllCounter>::value == osmium::osm_entity_bits::all);
+}
+
+TEST_CASE("Apply handler with only way callback") {
+    const auto buffer = create_buffer();
+    WayCounter handler;
+    osmium::apply(buffer, handler);
+    REQUIRE(handler.ways == 2);
+    REQUIRE(handler.flushes == 1);
+}
+
+TEST_CASE("Apply several handlers with callbacks for one type") {
+    const auto buffer = create_buffer();
+    WayCounter handler1;
+    WayCounter handler2;
+    osmium::apply(buffer, handler1, handler2);
+    REQUIRE(handler1.ways == 2);
+    REQUIRE(handler2.ways == 2);
+
+    ChangesetCounter handler3;
+    osmium::apply(buffer, handler3);
+    REQUIRE(handler3.changesets == 1);
+}
+
+TEST_CASE("Apply handlers with callbacks for different types") {
+    const auto buffer = create_buffer();
+    WayCounter handler1;
+    NodeAndObjectCounter handler2;
+    AllCounter handler3;
+    osmium::apply(buffer, handler1, handler2, handler3);
+    REQUIRE(handler1.ways == 2);
+    REQUIRE(handler2.nodes == 2);
+    REQUIRE(handler2.objects == 5);
+    REQUIRE(handler3.count == 6);
+}
+
+TEST_CASE("Apply handler without callbacks") {
+    const auto buffer = create_buffer();
+    osmium::handler::Handler handler;
+    osmium::apply(buffer, handler);
+}
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/async_disk_store.hpp>
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer get_buffer(osmium::object_id_type first) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = first + 9; id >= first; --id) {
+        osmium::builder::add_node(buffer, _id(id), _tag("name", std::to_string(id)));
+    }
+    osmium::builder::add_way(buffer, _id(first), _nodes({first, first + 1}));
+    osmium::builder::add_relation(buffer, _id(first), _member(osmium::item_type::way, first, "outer"));
+    return buffer;
+}
+
+static std::string read_all(int fd, std::size_t size) {
+    std::string data(size, '\0');
+    REQUIRE(osmium::io::detail::reliable_pread(fd, &data[0], static_cast<unsigned int>(size), 0) == static_cast<int64_t>(size));
+    return data;
+}
+
+TEST_CASE("Async disk store writes buffers and records offsets") {
+    const int fd = osmium::detail::create_tmp_file();
+    REQUIRE(fd > 0);
+
+    std::size_t expected_size = 0;
+    {
+        osmium::handler::AsyncDiskStore store{fd, 2};
+        for (osmium::object_id_type first = 1; first < 100; first += 10) {
+            auto buffer = get_buffer(first);
+            expected_size += buffer.committed();
+            if (first % 20 == 1) {
+                store(buffer);
+            } else {
+                store(std::move(buffer));
+            }
+        }
+        store(osmium::memory::Buffer{});
+
+        REQUIRE(store.close() == expected_size);
+        REQUIRE(store.close() == expected_size);
+        REQUIRE_THROWS_AS(store(get_buffer(1)), const osmium::io_error&);
+
+        REQUIRE(store.node_offsets().size() == 100);
+        REQUIRE(store.way_offsets().size() == 10);
+        REQUIRE(store.relation_offsets().size() == 10);
+        REQUIRE(store.node_offsets().front().first == 1);
+        REQUIRE(store.node_offsets().back().first == 100);
+        REQUIRE(store.offset(osmium::item_type::node, 1000) == osmium::handler::AsyncDiskStore::not_found());
+        REQUIRE(store.offset(osmium::item_type::changeset, 1) == osmium::handler::AsyncDiskStore::not_found());
+
+        const std::string data = read_all(fd, expected_size);
+
+        for (osmium::object_id_type id = 1; id <= 100; ++id) {
+            const auto offset = store.offset(osmium::item_type::node, static_cast<osmium::unsigned_object_id_type>(id));
+            REQUIRE(offset < data.size());
+            const auto& node = *reinterpret_cast<const osmium::Node*>(data.data() + offset);
+            REQUIRE(node.type() == osmium::item_type::node);
+            REQUIRE(node.id() == id);
+            REQUIRE(std::string{node.tags()["name"]} == std::to_string(id));
+        }
+
+        const auto& way = *reinterpret_cast<const osmium::Way*>(data.data() + store.offset(osmium::item_type::way, 51));
+        REQUIRE(way.id() == 51);
+        REQUIRE(way.nodes().size() == 2);
+
+        const auto& relation = *reinterpret_cast<const osmium::Relation*>(data.data() + store.offset(osmium::item_type::relation, 91));
+        REQUIRE(relation.id() == 91);
+        REQUIRE(relation.members().begin()->ref() == 91);
+
+        const int node_fd = osmium::detail::create_tmp_file();
+        const int way_fd = osmium::detail::create_tmp_file();
+        const int relation_fd = osmium::detail::create_tmp_file();
+        store.dump_indexes(node_fd, way_fd, relation_fd);
+
+        const std::size_t element_size = sizeof(osmium::handler::AsyncDiskStore::element_type);
+        const std::string nodes = read_all(node_fd, 100 * element_size);
+        REQUIRE(std::equal(nodes.begin(), nodes.end(), reinterpret_cast<const char*>(store.node_offsets().data())));
+        const std::string ways = read_all(way_fd, 10 * element_size);
+        REQUIRE(std::equal(ways.begin(), ways.end(), reinterpret_cast<const char*>(store.way_offsets().data())));
+
+        osmium::io::detail::reliable_close(node_fd);
+        osmium::io::detail::reliable_close(way_fd);
+        osmium::io::detail::reliable_close(relation_fd);
+    }
+
+    osmium::io::detail::reliable_close(fd);
+}
+
+TEST_CASE("Async disk store reports write errors") {
+    osmium::handler::AsyncDiskStore store{-1};
+    store(get_buffer(1));
+    REQUIRE_THROWS_AS(store.close(), const std::system_error&);
+}
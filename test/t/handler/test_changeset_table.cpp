@@ -0,0 +1,107 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/changeset_table.hpp>
+#include <osmium/io/bzip2_compression.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_changesets(osmium::changeset_id_type first_id, int count) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int i = 0; i < count; ++i) {
+        const auto id = first_id + static_cast<osmium::changeset_id_type>(i);
+        const std::string user = "user" + std::to_string(id % 3);
+        const std::string editor = (id % 2) ? "JOSM" : "iD";
+        osmium::builder::add_changeset(buffer,
+            _cid(id),
+            _uid(id % 3 + 1),
+            _user(user.c_str()),
+            _created_at(osmium::Timestamp{1500000000 + id}),
+            _closed_at(osmium::Timestamp{id % 5 ? 1500003600 + id : 0}),
+            _num_changes(id * 2),
+            _tag("created_by", editor.c_str())
+        );
+    }
+    return buffer;
+}
+
+TEST_CASE("Changeset table stores columns") {
+    const auto buffer = create_changesets(10, 6);
+
+    osmium::handler::ChangesetTable table{{"created_by", "comment"}};
+    osmium::apply(buffer, table);
+
+    REQUIRE(table.size() == 6);
+    REQUIRE(table.ids().front() == 10);
+    REQUIRE(table.ids().back() == 15);
+    REQUIRE(table.uids()[1] == 3);
+    REQUIRE(table.user(1) == "user2");
+    REQUIRE(table.user(3) == "user1");
+    REQUIRE(table.users()[0] == table.users()[3]);
+    REQUIRE(table.created_at()[2] == osmium::Timestamp{1500000012});
+    REQUIRE_FALSE(table.closed_at()[0].valid());
+    REQUIRE(table.closed_at()[1] == osmium::Timestamp{1500003611});
+    REQUIRE(table.num_changes()[5] == 30);
+    REQUIRE(table.string(table.tag_values(0)[0]) == "iD");
+    REQUIRE(table.string(table.tag_values(0)[1]) == "JOSM");
+    REQUIRE(table.tag_values(1)[1] == 0);
+
+    // "", three users, two editors
+    REQUIRE(table.num_strings() == 6);
+    REQUIRE(table.used_memory() > 0);
+}
+
+TEST_CASE("Changeset tables can be appended") {
+    osmium::handler::ChangesetTable table1{{"created_by"}};
+    osmium::apply(create_changesets(1, 1), table1);
+
+    osmium::handler::ChangesetTable table2{{"created_by"}};
+    osmium::apply(create_changesets(2, 4), table2);
+
+    table1.append(std::move(table2));
+    REQUIRE(table2.empty());
+    REQUIRE(table1.size() == 5);
+    REQUIRE(table1.ids()[4] == 5);
+    REQUIRE(table1.user(0) == "user1");
+    REQUIRE(table1.user(3) == "user1");
+    REQUIRE(table1.users()[0] == table1.users()[3]);
+    REQUIRE(table1.string(table1.tag_values(0)[0]) == "JOSM");
+    REQUIRE(table1.string(table1.tag_values(0)[1]) == "iD");
+    REQUIRE(table1.num_strings() == 6);
+}
+
+TEST_CASE("Read compressed changeset file in parallel into changeset table") {
+    const std::string filename = "test-changeset-table.osm.bz2";
+
+    osmium::thread::Pool pool{2};
+    {
+        osmium::io::Writer writer{filename, pool, osmium::io::parallel_compression::yes, osmium::io::overwrite::allow};
+        for (int n = 0; n < 20; ++n) {
+            writer(create_changesets(static_cast<osmium::changeset_id_type>(n * 1000 + 1), 500));
+        }
+        writer.close();
+    }
+
+    osmium::handler::ChangesetTable table{{"created_by"}};
+    osmium::io::Reader reader{filename, pool,
+                              osmium::io::parallel_decompression::yes,
+                              osmium::io::xml_tokenizer::builtin};
+    osmium::apply(reader, table);
+    reader.close();
+
+    REQUIRE(table.size() == 10000);
+    REQUIRE(table.ids()[500] == 1001);
+    REQUIRE(table.num_changes()[500] == 2002);
+    REQUIRE(table.user(500) == "user2");
+    REQUIRE(table.string(table.tag_values(0)[500]) == "JOSM");
+}
@@ -126,3 +126,70 @@ TEST_CASE("CheckOrder handler: Ways after relations") {
     REQUIRE_THROWS_AS(osmium::apply(buffer, handler), const osmium::out_of_order_error&);
 }
 
+
+TEST_CASE("CheckOrder handler: check whole buffer") {
+    osmium::memory::Buffer buffer{1024};
+
+    REQUIRE(osmium::opl_parse("n-126", buffer));
+    REQUIRE(osmium::opl_parse("n123", buffer));
+    REQUIRE(osmium::opl_parse("n124", buffer));
+    REQUIRE(osmium::opl_parse("w-100", buffer));
+    REQUIRE(osmium::opl_parse("w102", buffer));
+    REQUIRE(osmium::opl_parse("r100", buffer));
+
+    osmium::handler::CheckOrder handler;
+    const auto summary = handler.check_buffer(buffer);
+    REQUIRE(summary.types == osmium::osm_entity_bits::nwr);
+    REQUIRE(summary.min_id == -126);
+    REQUIRE(summary.max_id == 124);
+    REQUIRE(summary.count == 6);
+    REQUIRE(handler.max_node_id()     == 124);
+    REQUIRE(handler.max_way_id()      == 102);
+    REQUIRE(handler.max_relation_id() == 100);
+
+    osmium::memory::Buffer buffer2{1024};
+    REQUIRE(osmium::opl_parse("r101", buffer2));
+    REQUIRE(osmium::opl_parse("r200", buffer2));
+    const auto summary2 = handler.check_buffer(buffer2);
+    REQUIRE(summary2.types == osmium::osm_entity_bits::relation);
+    REQUIRE(summary2.min_id == 101);
+    REQUIRE(summary2.max_id == 200);
+    REQUIRE(handler.max_relation_id() == 200);
+
+    osmium::memory::Buffer buffer3{1024};
+    REQUIRE(osmium::opl_parse("w103", buffer3));
+    REQUIRE_THROWS_AS(handler.check_buffer(buffer3), const osmium::out_of_order_error&);
+}
+
+TEST_CASE("CheckOrder handler: check empty buffer") {
+    osmium::memory::Buffer buffer{1024};
+
+    osmium::handler::CheckOrder handler;
+    const auto summary = handler.check_buffer(buffer);
+    REQUIRE(summary.types == osmium::osm_entity_bits::nothing);
+    REQUIRE(summary.count == 0);
+}
+
+TEST_CASE("CheckOrder handler: check buffer with objects out of order") {
+    osmium::memory::Buffer buffer{1024};
+
+    REQUIRE(osmium::opl_parse("n3", buffer));
+    REQUIRE(osmium::opl_parse("n4", buffer));
+
+    SECTION("Positive ID") {
+        REQUIRE(osmium::opl_parse("n2", buffer));
+    }
+    SECTION("Same ID") {
+        REQUIRE(osmium::opl_parse("n4", buffer));
+    }
+    SECTION("Negative ID") {
+        REQUIRE(osmium::opl_parse("n-2", buffer));
+    }
+    SECTION("Node after way") {
+        REQUIRE(osmium::opl_parse("w1", buffer));
+        REQUIRE(osmium::opl_parse("n5", buffer));
+    }
+
+    osmium::handler::CheckOrder handler;
+    REQUIRE_THROWS_AS(handler.check_buffer(buffer), const osmium::out_of_order_error&);
+}
@@ -114,3 +114,27 @@ TEST_CASE("Dynamic handler") {
     REQUIRE(count == 10);
 }
 
+
+TEST_CASE("Dynamic handler handles whole buffer") {
+    auto buffer = fill_buffer();
+
+    osmium::handler::DynamicHandler handler;
+    int count = 0;
+
+    handler.handle_buffer(buffer);
+    REQUIRE(count == 0);
+
+    handler.set<Handler1>(count);
+    handler.handle_buffer(buffer);
+    REQUIRE(count == 5);
+
+    count = 0;
+    osmium::apply(buffer, handler);
+    REQUIRE(count == 6);
+
+    count = 0;
+    handler.set<Handler2>(count);
+    const auto& cbuffer = buffer;
+    osmium::apply(cbuffer, handler);
+    REQUIRE(count == 10);
+}
@@ -0,0 +1,97 @@
+#include "catch.hpp"
+
+#include <osmium/area/polygon_index.hpp>
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/extract_filter.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::area::PolygonIndex create_index() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    // extract 0: 0..10, 0..10
+    osmium::builder::add_area(buffer, _id(2), _outer_ring({
+        {1, {0.0, 0.0}}, {2, {10.0, 0.0}}, {3, {10.0, 10.0}}, {4, {0.0, 10.0}}, {1, {0.0, 0.0}}
+    }));
+
+    // extract 1: 5..15, 0..10
+    osmium::builder::add_area(buffer, _id(4), _outer_ring({
+        {1, {5.0, 0.0}}, {2, {15.0, 0.0}}, {3, {15.0, 10.0}}, {4, {5.0, 10.0}}, {1, {5.0, 0.0}}
+    }));
+
+    osmium::area::PolygonIndex index;
+    for (const auto& area : buffer.select<osmium::Area>()) {
+        index.add(area);
+    }
+    return index;
+}
+
+static osmium::memory::Buffer create_data(bool with_locations) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.0));   // 0
+    osmium::builder::add_node(buffer, _id(2), _location(7.0, 1.0));   // 0, 1
+    osmium::builder::add_node(buffer, _id(3), _location(12.0, 1.0));  // 1
+    osmium::builder::add_node(buffer, _id(4), _location(20.0, 1.0));  // none
+    osmium::builder::add_node(buffer, _id(5));                        // none
+
+    const auto loc = [with_locations](double x, double y) {
+        return with_locations ? osmium::Location{x, y} : osmium::Location{};
+    };
+
+    osmium::builder::add_way(buffer, _id(10), _nodes({{1, loc(1.0, 1.0)}, {4, loc(20.0, 1.0)}}));  // 0
+    osmium::builder::add_way(buffer, _id(11), _nodes({{3, loc(12.0, 1.0)}, {4, loc(20.0, 1.0)}})); // 1
+    osmium::builder::add_way(buffer, _id(12), _nodes({{4, loc(20.0, 1.0)}, {5, loc(30.0, 1.0)}})); // none
+    osmium::builder::add_way(buffer, _id(13), _nodes({{1, loc(1.0, 1.0)}, {3, loc(12.0, 1.0)}}));  // 0, 1
+
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 11));   // 1
+    osmium::builder::add_relation(buffer, _id(21), _member(osmium::item_type::node, 4));   // none
+    osmium::builder::add_relation(buffer, _id(22), _member(osmium::item_type::relation, 20), _member(osmium::item_type::node, 1)); // 0, 1
+
+    return buffer;
+}
+
+static std::string ids(const osmium::memory::Buffer& buffer) {
+    std::string result;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        result += osmium::item_type_to_char(object.type());
+        result += std::to_string(object.id());
+        result += ' ';
+    }
+    return result;
+}
+
+static std::map<std::size_t, std::string> run_filter(const osmium::area::PolygonIndex& index, bool with_locations, std::size_t buffer_size) {
+    std::map<std::size_t, std::string> extracts;
+    osmium::handler::ExtractFilter filter{index, [&](std::size_t id, osmium::memory::Buffer&& buffer) {
+        extracts[id] += ids(buffer);
+    }, buffer_size};
+
+    const auto data = create_data(with_locations);
+    osmium::apply(data, filter);
+    filter.flush();
+
+    return extracts;
+}
+
+TEST_CASE("Extract filter") {
+    const auto index = create_index();
+    REQUIRE(index.size() == 2);
+
+    for (const bool with_locations : {true, false}) {
+        for (const std::size_t buffer_size : {std::size_t{1}, std::size_t{1024UL * 1024UL}}) {
+            const auto extracts = run_filter(index, with_locations, buffer_size);
+            REQUIRE(extracts.size() == 2);
+            REQUIRE(extracts.at(0) == "n1 n2 w10 w13 r22 ");
+            REQUIRE(extracts.at(1) == "n2 n3 w11 w13 r20 r22 ");
+        }
+    }
+}
@@ -0,0 +1,188 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/envelope_cache.hpp>
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using dense_index_type = osmium::index::map::DenseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+using sparse_index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id * 10), static_cast<int32_t>(id * -3)};
+}
+
+static osmium::memory::Buffer create_nodes() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = -5; id <= 100; ++id) {
+        if (id != 0) {
+            osmium::builder::add_node(buffer, _id(id), _location(location_for(id)));
+        }
+    }
+    return buffer;
+}
+
+static osmium::memory::Buffer create_ways(bool with_missing) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3, 99}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({-1, 5, -5, 7}));
+    osmium::builder::add_way(buffer, _id(3), _nodes({100, 50, 1}));
+    if (with_missing) {
+        osmium::builder::add_way(buffer, _id(4), _nodes({4, 101, 5}));
+    }
+    return buffer;
+}
+
+static void check_ways(const osmium::memory::Buffer& buffer) {
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        for (const auto& node_ref : way.nodes()) {
+            if (node_ref.ref() == 101) {
+                REQUIRE_FALSE(node_ref.location());
+            } else {
+                REQUIRE(node_ref.location() == location_for(node_ref.ref()));
+            }
+        }
+    }
+}
+
+static void check_envelopes(osmium::index::EnvelopeCache& cache, const osmium::memory::Buffer& buffer) {
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        const auto* box = cache.find(way);
+        REQUIRE(box);
+        REQUIRE(*box == way.envelope());
+    }
+}
+
+template <typename TIndex>
+void check_handler() {
+    TIndex index_pos;
+    TIndex index_neg;
+    osmium::handler::NodeLocationsForWays<TIndex, TIndex> handler{index_pos, index_neg};
+
+    const auto nodes = create_nodes();
+    for (const auto& node : nodes.select<osmium::Node>()) {
+        handler.node(node);
+    }
+
+    SECTION("way() for each way") {
+        auto ways = create_ways(false);
+        for (auto& way : ways.select<osmium::Way>()) {
+            handler.way(way);
+        }
+        check_ways(ways);
+    }
+
+    SECTION("ways() for whole buffer") {
+        auto ways = create_ways(false);
+        handler.ways(ways);
+        check_ways(ways);
+    }
+
+    SECTION("prefetch() before ways()") {
+        auto ways = create_ways(true);
+        handler.prefetch(ways);
+        REQUIRE_THROWS_AS(handler.ways(ways), const osmium::not_found&);
+        check_ways(ways);
+    }
+
+    SECTION("ways() with missing node throws but sets all locations") {
+        auto ways = create_ways(true);
+        REQUIRE_THROWS_AS(handler.ways(ways), const osmium::not_found&);
+        check_ways(ways);
+    }
+
+    SECTION("ways() with missing node and ignore_errors") {
+        handler.ignore_errors();
+        auto ways = create_ways(true);
+        handler.ways(ways);
+        check_ways(ways);
+    }
+
+    SECTION("way() and ways() fill envelope cache") {
+        osmium::index::EnvelopeCache cache;
+        handler.set_envelope_cache(&cache);
+        auto ways1 = create_ways(false);
+        auto ways2 = create_ways(true);
+        for (auto& way : ways1.select<osmium::Way>()) {
+            handler.way(way);
+        }
+        REQUIRE_THROWS_AS(handler.ways(ways2), const osmium::not_found&);
+        handler.set_envelope_cache(nullptr);
+
+        REQUIRE(cache.size() == 7);
+        cache.sort();
+        check_envelopes(cache, ways1);
+        check_envelopes(cache, ways2);
+    }
+}
+
+TEST_CASE("NodeLocationsForWays with dense index") {
+    check_handler<dense_index_type>();
+}
+
+TEST_CASE("NodeLocationsForWays with sparse index") {
+    check_handler<sparse_index_type>();
+}
+
+TEST_CASE("Map::get_many on dense index") {
+    dense_index_type index;
+    index.set(3, location_for(3));
+    index.set(1000, location_for(1000));
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 0; id < 2000; ++id) {
+        ids.push_back(id);
+    }
+    ids.push_back(1000);
+    ids.push_back(3);
+
+    std::vector<osmium::Location> locations(ids.size());
+    index.get_many(ids.data(), ids.size(), locations.data());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(locations[i] == index.get_noexcept(ids[i]));
+    }
+    REQUIRE(locations.back() == location_for(3));
+}
+
+TEST_CASE("NodeLocationsForWaysTransform") {
+    sparse_index_type index_pos;
+    sparse_index_type index_neg;
+    osmium::handler::NodeLocationsForWays<sparse_index_type, sparse_index_type> handler{index_pos, index_neg};
+
+    const auto nodes = create_nodes();
+    for (const auto& node : nodes.select<osmium::Node>()) {
+        handler.node(node);
+    }
+    index_pos.sort();
+    index_neg.sort();
+
+    osmium::handler::NodeLocationsForWaysTransform<sparse_index_type, sparse_index_type> transform{index_pos, index_neg};
+
+    SECTION("all locations found") {
+        auto ways = create_ways(false);
+        transform(ways);
+        check_ways(ways);
+    }
+
+    SECTION("missing node throws but sets all locations") {
+        auto ways = create_ways(true);
+        REQUIRE_THROWS_AS(transform(ways), const osmium::not_found&);
+        check_ways(ways);
+    }
+
+    SECTION("missing node and ignore_errors") {
+        transform.ignore_errors();
+        auto ways = create_ways(true);
+        transform(ways);
+        check_ways(ways);
+    }
+}
@@ -0,0 +1,123 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/diff_handler.hpp>
+#include <osmium/diff_visitor.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/parallel_diff_visitor.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class RecordHandler : public osmium::diff_handler::DiffHandler {
+
+        void record(char type, const osmium::DiffObject& diff) {
+            result += type;
+            result += std::to_string(diff.id());
+            result += ':';
+            result += std::to_string(diff.prev().version());
+            result += '-';
+            result += std::to_string(diff.curr().version());
+            result += '-';
+            result += std::to_string(diff.next().version());
+            result += ' ';
+        }
+
+    public:
+
+        std::string result;
+
+        void node(const osmium::DiffNode& diff) {
+            record('n', diff);
+        }
+
+        void way(const osmium::DiffWay& diff) {
+            record('w', diff);
+        }
+
+        void relation(const osmium::DiffRelation& diff) {
+            record('r', diff);
+        }
+
+    }; // class RecordHandler
+
+    void merge_records(RecordHandler& result, RecordHandler&& other) {
+        result.result += other.result;
+    }
+
+    osmium::memory::Buffer create_history() {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        for (int id = 1; id <= 200; ++id) {
+            for (int version = 1; version <= id % 4 + 1; ++version) {
+                osmium::builder::add_node(buffer, _id(id), _version(version));
+            }
+        }
+        for (int id = 1; id <= 50; ++id) {
+            for (int version = 1; version <= id % 3 + 1; ++version) {
+                osmium::builder::add_way(buffer, _id(id), _version(version));
+            }
+        }
+        osmium::builder::add_relation(buffer, _id(1), _version(1));
+        return buffer;
+    }
+
+    std::string sequential(const osmium::memory::Buffer& buffer) {
+        RecordHandler handler;
+        osmium::apply_diff(buffer.cbegin<osmium::OSMObject>(), buffer.cend<osmium::OSMObject>(), handler);
+        return handler.result;
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Chunks of parallel diff apply end at object boundaries") {
+    const auto buffer = create_history();
+    const auto boundaries = osmium::detail::diff_chunk_boundaries(buffer, 5);
+
+    REQUIRE(boundaries.size() > 10);
+    REQUIRE(boundaries.front() == buffer.cbegin<osmium::OSMObject>());
+    REQUIRE(boundaries.back() == buffer.cend<osmium::OSMObject>());
+    for (std::size_t n = 1; n < boundaries.size() - 1; ++n) {
+        REQUIRE(boundaries[n]->version() == 1);
+    }
+}
+
+TEST_CASE("Parallel diff apply gives same result as sequential diff apply") {
+    const auto buffer = create_history();
+    const std::string expected = sequential(buffer);
+    REQUIRE(expected.substr(0, 26) == "n1:1-1-2 n1:1-2-2 n2:1-1-2");
+
+    osmium::thread::Pool pool{2};
+    for (const std::size_t objects_per_chunk : {1, 2, 7, 100, 10000}) {
+        const auto handler = osmium::apply_diff_parallel(buffer, RecordHandler{}, merge_records, pool, objects_per_chunk);
+        REQUIRE(handler.result == expected);
+    }
+
+    const auto handler = osmium::apply_diff_parallel(buffer, RecordHandler{}, merge_records);
+    REQUIRE(handler.result == expected);
+}
+
+TEST_CASE("Parallel diff apply on empty buffer") {
+    const osmium::memory::Buffer buffer{1024};
+    const auto handler = osmium::apply_diff_parallel(buffer, RecordHandler{}, merge_records);
+    REQUIRE(handler.result.empty());
+}
+
+TEST_CASE("Parallel diff apply propagates exceptions from handlers") {
+    struct FailHandler : public osmium::diff_handler::DiffHandler {
+        void way(const osmium::DiffWay& diff) const {
+            if (diff.id() == 30) {
+                throw std::runtime_error{"fail"};
+            }
+        }
+    };
+
+    const auto buffer = create_history();
+    osmium::thread::Pool pool{2};
+    REQUIRE_THROWS_AS(osmium::apply_diff_parallel(buffer, FailHandler{}, [](FailHandler&, FailHandler&&) {}, pool, 10), const std::runtime_error&);
+}
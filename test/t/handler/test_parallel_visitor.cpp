@@ -0,0 +1,159 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/parallel_visitor.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class BufferSource {
+
+        int m_num_buffers;
+        int m_count = 0;
+        bool m_fail;
+
+    public:
+
+        explicit BufferSource(int num_buffers, bool fail = false) :
+            m_num_buffers(num_buffers),
+            m_fail(fail) {
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_count == m_num_buffers) {
+                if (m_fail) {
+                    throw std::runtime_error{"read error"};
+                }
+                return osmium::memory::Buffer{};
+            }
+            osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            for (int i = 0; i < 10; ++i) {
+                osmium::builder::add_node(buffer, _id(m_count * 10 + i));
+            }
+            osmium::builder::add_way(buffer, _id(m_count));
+            ++m_count;
+            return buffer;
+        }
+
+    }; // class BufferSource
+
+    struct CountHandler : public osmium::handler::Handler {
+
+        std::size_t nodes = 0;
+        std::size_t ways = 0;
+        int flushes = 0;
+
+        void node(const osmium::Node& /*node*/) noexcept {
+            ++nodes;
+        }
+
+        void way(const osmium::Way& /*way*/) noexcept {
+            ++ways;
+        }
+
+        void flush() noexcept {
+            ++flushes;
+        }
+
+    }; // struct CountHandler
+
+    struct IdHandler : public osmium::handler::Handler {
+
+        std::vector<osmium::object_id_type> ids;
+
+        void node(const osmium::Node& node) {
+            if (node.id() == 555) {
+                throw std::runtime_error{"handler error"};
+            }
+            ids.push_back(node.id());
+        }
+
+    }; // struct IdHandler
+
+    void merge_counts(CountHandler& result, CountHandler&& other) {
+        result.nodes += other.nodes;
+        result.ways += other.ways;
+        result.flushes += other.flushes;
+    }
+
+    void merge_ids(IdHandler& result, IdHandler&& other) {
+        result.ids.insert(result.ids.end(), other.ids.begin(), other.ids.end());
+    }
+
+} // anonymous namespace
+
+TEST_CASE("Apply handler in parallel") {
+    BufferSource source{50};
+    osmium::apply_parallel_options options;
+    options.num_threads = 3;
+
+    const auto result = osmium::apply_parallel(source, CountHandler{}, merge_counts, options);
+    REQUIRE(result.nodes == 500);
+    REQUIRE(result.ways == 50);
+    REQUIRE(result.flushes == 3);
+}
+
+TEST_CASE("Apply handler in parallel in ordered mode") {
+    BufferSource source{40};
+    osmium::apply_parallel_options options;
+    options.num_threads = 4;
+    options.order = osmium::apply_order::ordered;
+    options.max_queue_size = 2;
+
+    const auto result = osmium::apply_parallel(source, IdHandler{}, merge_ids, options);
+    REQUIRE(result.ids.size() == 400);
+    bool in_order = true;
+    for (std::size_t i = 0; i < result.ids.size(); ++i) {
+        if (result.ids[i] != static_cast<osmium::object_id_type>(i)) {
+            in_order = false;
+        }
+    }
+    REQUIRE(in_order);
+}
+
+TEST_CASE("Apply handler in parallel on empty input") {
+    BufferSource source{0};
+
+    const auto result = osmium::apply_parallel(source, CountHandler{}, merge_counts);
+    REQUIRE(result.nodes == 0);
+    REQUIRE(result.ways == 0);
+}
+
+TEST_CASE("Apply handler in parallel with exception in handler") {
+    osmium::apply_parallel_options options;
+    options.num_threads = 2;
+
+    SECTION("unordered") {
+        BufferSource source{100};
+        REQUIRE_THROWS_AS(osmium::apply_parallel(source, IdHandler{}, merge_ids, options), const std::runtime_error&);
+    }
+
+    SECTION("ordered") {
+        BufferSource source{100};
+        options.order = osmium::apply_order::ordered;
+        REQUIRE_THROWS_AS(osmium::apply_parallel(source, IdHandler{}, merge_ids, options), const std::runtime_error&);
+    }
+}
+
+TEST_CASE("Apply handler in parallel with exception in source") {
+    osmium::apply_parallel_options options;
+    options.num_threads = 2;
+
+    SECTION("unordered") {
+        BufferSource source{10, true};
+        REQUIRE_THROWS_AS(osmium::apply_parallel(source, CountHandler{}, merge_counts, options), const std::runtime_error&);
+    }
+
+    SECTION("ordered") {
+        BufferSource source{10, true};
+        options.order = osmium::apply_order::ordered;
+        REQUIRE_THROWS_AS(osmium::apply_parallel(source, CountHandler{}, merge_counts, options), const std::runtime_error&);
+    }
+}
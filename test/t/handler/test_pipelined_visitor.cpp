@@ -0,0 +1,165 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/pipelined_visitor.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+namespace {
+
+    class BufferSource {
+
+        int m_num_buffers;
+        int m_count = 0;
+        bool m_fail;
+
+    public:
+
+        explicit BufferSource(int num_buffers, bool fail = false) :
+            m_num_buffers(num_buffers),
+            m_fail(fail) {
+        }
+
+        osmium::memory::Buffer read() {
+            if (m_count == m_num_buffers) {
+                if (m_fail) {
+                    throw std::runtime_error{"read error"};
+                }
+                return osmium::memory::Buffer{};
+            }
+            osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+            for (int i = 0; i < 10; ++i) {
+                osmium::builder::add_node(buffer, _id(m_count * 10 + i), _version(1));
+            }
+            osmium::builder::add_way(buffer, _id(m_count), _version(1));
+            ++m_count;
+            return buffer;
+        }
+
+    }; // class BufferSource
+
+    // Changes the objects, so it has to run as mutating stage.
+    struct VersionHandler : public osmium::handler::Handler {
+
+        void node(osmium::Node& node) noexcept {
+            node.set_version(2);
+        }
+
+    }; // struct VersionHandler
+
+    struct CheckHandler : public osmium::handler::Handler {
+
+        std::vector<osmium::object_id_type> ids;
+        std::size_t ways = 0;
+        bool all_changed = true;
+        std::string* flush_log;
+        std::string name;
+
+        CheckHandler(std::string* log, const char* n) :
+            flush_log(log),
+            name(n) {
+        }
+
+        void node(const osmium::Node& node) {
+            if (node.id() == 555) {
+                throw std::runtime_error{"handler error"};
+            }
+            if (node.version() != 2) {
+                all_changed = false;
+            }
+            ids.push_back(node.id());
+        }
+
+        void way(const osmium::Way& /*way*/) noexcept {
+            ++ways;
+        }
+
+        void flush() {
+            *flush_log += name;
+        }
+
+    }; // struct CheckHandler
+
+} // anonymous namespace
+
+TEST_CASE("Apply handlers in pipeline") {
+    BufferSource source{50};
+    VersionHandler version_handler;
+    std::string log;
+    CheckHandler first{&log, "a"};
+    CheckHandler second{&log, "b"};
+
+    osmium::apply_pipelined(source,
+                            osmium::mutating_stage(version_handler),
+                            osmium::read_only_stage(first),
+                            osmium::read_only_stage(second));
+
+    REQUIRE(first.ids.size() == 500);
+    REQUIRE(first.ways == 50);
+    REQUIRE(first.all_changed);
+    REQUIRE(second.ids == first.ids);
+    REQUIRE(second.all_changed);
+    REQUIRE(log == "ab");
+
+    bool in_order = true;
+    for (std::size_t i = 0; i < first.ids.size(); ++i) {
+        if (first.ids[i] != static_cast<osmium::object_id_type>(i)) {
+            in_order = false;
+        }
+    }
+    REQUIRE(in_order);
+}
+
+TEST_CASE("Apply handlers in pipeline with small queues") {
+    BufferSource source{30};
+    std::string log;
+    CheckHandler handler{&log, "a"};
+    osmium::apply_pipelined_options options;
+    options.max_queue_size = 1;
+
+    osmium::apply_pipelined(source, options, osmium::read_only_stage(handler));
+
+    REQUIRE(handler.ids.size() == 300);
+    REQUIRE_FALSE(handler.all_changed);
+    REQUIRE(log == "a");
+}
+
+TEST_CASE("Apply handlers in pipeline on empty input") {
+    BufferSource source{0};
+    std::string log;
+    CheckHandler handler{&log, "a"};
+
+    osmium::apply_pipelined(source, osmium::read_only_stage(handler));
+    REQUIRE(handler.ids.empty());
+    REQUIRE(log == "a");
+}
+
+TEST_CASE("Apply handlers in pipeline with exception in handler") {
+    BufferSource source{100};
+    VersionHandler version_handler;
+    std::string log;
+    CheckHandler first{&log, "a"};
+    CheckHandler second{&log, "b"};
+
+    REQUIRE_THROWS_AS(osmium::apply_pipelined(source,
+                                              osmium::mutating_stage(version_handler),
+                                              osmium::read_only_stage(first),
+                                              osmium::read_only_stage(second)), const std::runtime_error&);
+    REQUIRE(second.ids.size() <= 550);
+    REQUIRE(log == "b");
+}
+
+TEST_CASE("Apply handlers in pipeline with exception in source") {
+    BufferSource source{20, true};
+    std::string log;
+    CheckHandler handler{&log, "a"};
+
+    REQUIRE_THROWS_AS(osmium::apply_pipelined(source, osmium::read_only_stage(handler)), const std::runtime_error&);
+}
@@ -0,0 +1,92 @@
+#include "catch.hpp"
+
+#include <osmium/index/auto_location_index.hpp>
+#include <osmium/io/header.hpp>
+#include <osmium/osm/box.hpp>
+
+#include <cstddef>
+#include <memory>
+
+static const std::size_t GB = 1024UL * 1024UL * 1024UL;
+
+TEST_CASE("Choose location index for small extract") {
+    osmium::index::location_index_input input;
+    input.file_size = 100UL * 1024UL * 1024UL;
+    input.format = osmium::io::file_format::pbf;
+    input.available_memory = 8 * GB;
+
+    const auto choice = osmium::index::choose_location_index(input);
+    REQUIRE(choice.map_type == "flex_mem");
+    REQUIRE(choice.negative_map_type.empty());
+    REQUIRE(choice.estimated_nodes == input.file_size / 8);
+    REQUIRE(choice.estimated_bytes == choice.estimated_nodes * 16);
+    REQUIRE_FALSE(choice.reason.empty());
+}
+
+TEST_CASE("Choose location index for large extract without enough memory") {
+    osmium::index::location_index_input input;
+    input.node_count = 500000000;
+    input.available_memory = 4 * GB;
+    input.negative_ids = true;
+
+    const auto choice = osmium::index::choose_location_index(input);
+    REQUIRE(choice.map_type == "sparse_file_array");
+    REQUIRE(choice.negative_map_type == "sparse_mem_array");
+}
+
+TEST_CASE("Choose location index for planet") {
+    osmium::index::location_index_input input;
+    input.max_id = 1000000000;
+
+    osmium::io::Header header;
+    header.add_box(osmium::Box{-180.0, -90.0, 180.0, 90.0});
+    input.set_header(header);
+    REQUIRE(input.planet);
+
+    SECTION("enough memory") {
+        input.available_memory = 16 * GB;
+        const auto choice = osmium::index::choose_location_index(input);
+        REQUIRE(choice.map_type == "dense_mmap_array");
+        REQUIRE(choice.estimated_bytes == 8 * input.max_id);
+    }
+
+    SECTION("not enough memory") {
+        input.available_memory = 4 * GB;
+        const auto choice = osmium::index::choose_location_index(input);
+        REQUIRE(choice.map_type == "dense_file_array");
+    }
+}
+
+TEST_CASE("Planet detection from header") {
+    osmium::index::location_index_input input;
+    osmium::io::Header header;
+
+    header.add_box(osmium::Box{5.0, 47.0, 15.0, 55.0});
+    input.set_header(header);
+    REQUIRE_FALSE(input.planet);
+
+    header.set("osmosis_replication_base_url", "https://planet.openstreetmap.org/replication/minute");
+    input.set_header(header);
+    REQUIRE(input.planet);
+}
+
+TEST_CASE("Choose location index with unknown size") {
+    osmium::index::location_index_input input;
+    input.available_memory = 8 * GB;
+    const auto choice = osmium::index::choose_location_index(input);
+    REQUIRE(choice.map_type == "flex_mem");
+    REQUIRE(choice.estimated_nodes == 0);
+}
+
+TEST_CASE("Create auto location index through map factory") {
+    const auto& factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+
+    const auto map = factory.create_map("auto,nodes=1000,memory=1024");
+    REQUIRE(map);
+    map->set(17, osmium::Location{1, 2});
+    map->sort();
+    REQUIRE(map->get(17) == osmium::Location(1, 2));
+
+    REQUIRE_THROWS_AS(factory.create_map("auto,foo"), const osmium::map_factory_error&);
+    REQUIRE_THROWS_AS(factory.create_map("auto,nodes=x"), const osmium::map_factory_error&);
+}
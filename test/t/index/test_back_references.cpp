@@ -0,0 +1,87 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/object_back_references.hpp>
+#include <osmium/index/back_references.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/types.hpp>
+#include <osmium/visitor.hpp>
+
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using id_vector = std::vector<osmium::unsigned_object_id_type>;
+using index_type = osmium::index::BackReferences<osmium::unsigned_object_id_type>;
+
+static id_vector values_for(const index_type& index, osmium::unsigned_object_id_type id) {
+    const auto range = index.get_all(id);
+    return id_vector(range.first, range.second);
+}
+
+TEST_CASE("BackReferences: empty") {
+    index_type index;
+    index.prepare();
+    REQUIRE(index.prepared());
+    REQUIRE(index.size() == 0);
+    REQUIRE(index.count(0) == 0);
+    REQUIRE(index.count(17) == 0);
+}
+
+TEST_CASE("BackReferences: two passes") {
+    index_type index;
+    const id_vector keys   = {17, 5, 17, 1000, 17, 0};
+    const id_vector values = { 3, 1,  2,    7,  9, 4};
+
+    for (const auto key : keys) {
+        index.reserve(key);
+    }
+    REQUIRE_FALSE(index.prepared());
+    index.prepare();
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        index.set(keys[i], values[i]);
+    }
+
+    REQUIRE(index.size() == 6);
+    REQUIRE(values_for(index, 17) == (id_vector{3, 2, 9}));
+    REQUIRE(values_for(index, 5) == id_vector{1});
+    REQUIRE(values_for(index, 1000) == id_vector{7});
+    REQUIRE(values_for(index, 0) == id_vector{4});
+    REQUIRE(index.count(6) == 0);
+    REQUIRE(index.count(999) == 0);
+    REQUIRE(index.count(1001) == 0);
+    REQUIRE(index.count(1000000) == 0);
+
+    index.clear();
+    REQUIRE_FALSE(index.prepared());
+    REQUIRE(index.size() == 0);
+}
+
+TEST_CASE("ObjectBackReferences handler") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(10), _nodes({1, 2, 3}));
+    osmium::builder::add_way(buffer, _id(11), _nodes({3, 4, 1}));
+    osmium::builder::add_relation(buffer, _id(20),
+        _member(osmium::item_type::node, 2),
+        _member(osmium::item_type::way, 10),
+        _member(osmium::item_type::way, 11));
+    osmium::builder::add_relation(buffer, _id(21),
+        _member(osmium::item_type::way, 10),
+        _member(osmium::item_type::relation, 20));
+
+    osmium::handler::ObjectBackReferences refs;
+    osmium::apply(buffer, refs);
+    refs.prepare();
+    osmium::apply(buffer, refs);
+
+    REQUIRE(values_for(refs.node_to_ways(), 1) == (id_vector{10, 11}));
+    REQUIRE(values_for(refs.node_to_ways(), 2) == id_vector{10});
+    REQUIRE(values_for(refs.node_to_ways(), 3) == (id_vector{10, 11}));
+    REQUIRE(values_for(refs.node_to_ways(), 4) == id_vector{11});
+    REQUIRE(refs.node_to_ways().count(5) == 0);
+    REQUIRE(values_for(refs.node_to_relations(), 2) == id_vector{20});
+    REQUIRE(values_for(refs.way_to_relations(), 10) == (id_vector{20, 21}));
+    REQUIRE(values_for(refs.way_to_relations(), 11) == id_vector{20});
+    REQUIRE(values_for(refs.relation_to_relations(), 20) == id_vector{21});
+    REQUIRE(refs.relation_to_relations().count(21) == 0);
+}
@@ -0,0 +1,83 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/compressed_mem_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using index_type = osmium::index::map::CompressedMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+TEST_CASE("CompressedMemArray: dense locations compress well") {
+    index_type index;
+
+    const std::size_t num = 100000;
+    for (std::size_t id = 0; id < num; ++id) {
+        index.set(id, osmium::Location{static_cast<int32_t>(100000000 + id * 37), static_cast<int32_t>(-50000000 - id * 11)});
+    }
+    index.sort();
+
+    REQUIRE(index.size() == num);
+    REQUIRE(index.compressed_bytes() < num * sizeof(osmium::Location) / 2);
+
+    for (std::size_t id = 0; id < num; ++id) {
+        REQUIRE(index.get(id) == osmium::Location(static_cast<int32_t>(100000000 + id * 37), static_cast<int32_t>(-50000000 - id * 11)));
+    }
+}
+
+TEST_CASE("CompressedMemArray: extreme and sparse values") {
+    index_type index;
+
+    std::vector<osmium::Location> locations = {
+        osmium::Location{-1800000000, -900000000},
+        osmium::Location{1800000000, 900000000},
+        osmium::Location{0, 0},
+        osmium::Location{-1800000000, 900000000},
+        osmium::Location{2147483646, -2147483647},
+        osmium::Location{1, -1}
+    };
+
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        index.set(n * 3 + 1000, locations[n]);
+    }
+    index.sort();
+
+    for (std::size_t n = 0; n < locations.size(); ++n) {
+        REQUIRE(index.get(n * 3 + 1000) == locations[n]);
+        REQUIRE(index.get_noexcept(n * 3 + 1001) == osmium::Location{});
+    }
+    REQUIRE_THROWS_AS(index.get(999), const osmium::not_found&);
+    REQUIRE_THROWS_AS(index.get(0), const osmium::not_found&);
+}
+
+TEST_CASE("CompressedMemArray: set out of order and overwrite") {
+    index_type index;
+
+    std::mt19937 gen{42}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_int_distribution<int32_t> dist{-1000000000, 1000000000};
+
+    std::vector<osmium::Location> expected(2000);
+    for (int pass = 0; pass < 2; ++pass) {
+        for (std::size_t id = 0; id < expected.size(); id += 7) {
+            expected[id] = osmium::Location{dist(gen), dist(gen)};
+            index.set(id, expected[id]);
+        }
+        for (std::size_t n = expected.size(); n >= 5; n -= 5) {
+            const std::size_t id = n - 1;
+            expected[id] = osmium::Location{dist(gen), dist(gen)};
+            index.set(id, expected[id]);
+        }
+    }
+
+    for (std::size_t id = 0; id < expected.size(); ++id) {
+        REQUIRE(index.get_noexcept(id) == expected[id]);
+    }
+
+    index.sort();
+
+    for (std::size_t id = 0; id < expected.size(); ++id) {
+        REQUIRE(index.get_noexcept(id) == expected[id]);
+    }
+}
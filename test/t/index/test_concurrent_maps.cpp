@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/concurrent_dense_mmap_array.hpp>
+#include <osmium/index/map/concurrent_sparse_mem_array.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+static const int num_threads = 4;
+static const int ids_per_thread = 10000;
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id) * 2};
+}
+
+template <typename TIndex>
+void set_in_parallel(TIndex& index) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&index, t]() {
+            // interleave IDs so all threads write to the same pages
+            for (int n = 0; n < ids_per_thread; ++n) {
+                const osmium::unsigned_object_id_type id = n * num_threads + t + 1;
+                index.set(id, location_for(id));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    index.sort();
+}
+
+template <typename TIndex>
+void check_all(const TIndex& index, osmium::unsigned_object_id_type max_id = num_threads * ids_per_thread) {
+    REQUIRE_THROWS_AS(index.get(0), const osmium::not_found&);
+    for (osmium::unsigned_object_id_type id = 1; id <= max_id; ++id) {
+        REQUIRE(index.get(id) == location_for(id));
+    }
+    REQUIRE(index.get_noexcept(max_id + 1) == osmium::Location{});
+}
+
+#ifndef _WIN32
+TEST_CASE("ConcurrentDenseMmapArray: set from several threads") {
+    osmium::index::map::ConcurrentDenseMmapArray<osmium::unsigned_object_id_type, osmium::Location> index{1000000};
+    set_in_parallel(index);
+    REQUIRE(index.size() == num_threads * ids_per_thread + 1);
+    check_all(index);
+
+    const std::vector<osmium::unsigned_object_id_type> ids = {5, 0, 17, 2000000, 40000, 3};
+    std::vector<osmium::Location> locations(ids.size());
+    index.get_many(ids.data(), ids.size(), locations.data());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(locations[i] == index.get_noexcept(ids[i]));
+    }
+}
+#endif
+
+TEST_CASE("ConcurrentSparseMemArray: set from several threads") {
+    osmium::index::map::ConcurrentSparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    set_in_parallel(index);
+    REQUIRE(index.size() == num_threads * ids_per_thread);
+    check_all(index);
+}
+
+TEST_CASE("ConcurrentSparseMemArray: several maps used by the same threads") {
+    using index_type = osmium::index::map::ConcurrentSparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    index_type index1;
+    index_type index2;
+
+    index1.set(1, location_for(1));
+    index2.set(2, location_for(2));
+    index1.set(3, location_for(3));
+
+    index1.sort();
+    index2.sort();
+
+    REQUIRE(index1.size() == 2);
+    REQUIRE(index2.size() == 1);
+    REQUIRE(index1.get(3) == location_for(3));
+    REQUIRE(index2.get(2) == location_for(2));
+
+    index1.clear();
+    index1.set(4, location_for(4));
+    index1.sort();
+    REQUIRE(index1.size() == 1);
+    REQUIRE(index1.get(4) == location_for(4));
+}
+
+TEST_CASE("NodeLocationsForWays handlers in several threads sharing one index") {
+    using index_type = osmium::index::map::ConcurrentSparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    using handler_type = osmium::handler::NodeLocationsForWays<index_type>;
+
+    index_type index;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&index, t]() {
+            handler_type handler{index};
+            osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+            for (int n = 0; n < 1000; ++n) {
+                const osmium::object_id_type id = n * num_threads + t + 1;
+                osmium::builder::add_node(buffer, osmium::builder::attr::_id(id), osmium::builder::attr::_location(location_for(id)));
+            }
+            for (auto& node : buffer.select<osmium::Node>()) {
+                handler.node(node);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    index.sort();
+
+    REQUIRE(index.size() == num_threads * 1000);
+    check_all(index, num_threads * 1000);
+}
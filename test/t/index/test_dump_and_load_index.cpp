@@ -4,6 +4,7 @@
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
+#include <osmium/index/map/flex_mem.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 #include <osmium/index/map/sparse_mem_array.hpp>
 #include <osmium/index/map/sparse_mmap_array.hpp>
@@ -82,3 +83,25 @@ TEST_CASE("Dump SparseMemArray, load as SparseFileArray") {
     auto dump_method = [](sparse_mem_array& index, const int fd) { index.dump_as_list(fd);};
     test_index<sparse_mem_array, sparse_file_array>(dump_method);
 }
+
+using flex_mem = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
+
+TEST_CASE("Dump sparse FlexMem, load as SparseFileArray") {
+    auto dump_method = [](flex_mem& index, const int fd) { index.dump_as_list(fd);};
+    test_index<flex_mem, sparse_file_array>(dump_method);
+}
+
+class dense_flex_mem : public flex_mem {
+
+public:
+
+    dense_flex_mem() :
+        flex_mem(true) {
+    }
+
+}; // class dense_flex_mem
+
+TEST_CASE("Dump dense FlexMem, load as SparseFileArray") {
+    auto dump_method = [](dense_flex_mem& index, const int fd) { index.dump_as_list(fd);};
+    test_index<dense_flex_mem, sparse_file_array>(dump_method);
+}
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/envelope_cache.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/way.hpp>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_ways() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= 10; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({
+            osmium::NodeRef{1, osmium::Location{id, 2 * id}},
+            osmium::NodeRef{2, osmium::Location{-id, id}},
+            osmium::NodeRef{3, osmium::Location{0, -id}}
+        }));
+    }
+    return buffer;
+}
+
+TEST_CASE("Empty envelope cache") {
+    osmium::index::EnvelopeCache cache;
+    REQUIRE(cache.empty());
+    REQUIRE(cache.size() == 0);
+
+    const auto buffer = create_ways();
+    const auto& way = *buffer.select<osmium::Way>().begin();
+    REQUIRE(cache.find(way) == nullptr);
+    REQUIRE(cache.envelope(way) == way.envelope());
+}
+
+TEST_CASE("Envelope cache with ways added in order") {
+    osmium::index::EnvelopeCache cache;
+    const auto buffer = create_ways();
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        cache.add(way);
+    }
+    REQUIRE(cache.size() == 10);
+
+    // twice in order and once in reverse order
+    for (int n = 0; n < 2; ++n) {
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            const auto* box = cache.find(way);
+            REQUIRE(box);
+            REQUIRE(*box == way.envelope());
+            REQUIRE(box->bottom_left() == osmium::Location(-way.id(), -way.id()));
+        }
+    }
+
+    std::vector<const osmium::Way*> ways;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        ways.push_back(&way);
+    }
+    for (auto it = ways.rbegin(); it != ways.rend(); ++it) {
+        REQUIRE(cache.envelope(**it) == (*it)->envelope());
+    }
+
+    cache.clear();
+    REQUIRE(cache.empty());
+    REQUIRE(cache.find(*ways.front()) == nullptr);
+}
+
+TEST_CASE("Envelope cache uses the box it was given") {
+    osmium::index::EnvelopeCache cache;
+    const auto buffer = create_ways();
+    const auto& way = *buffer.select<osmium::Way>().begin();
+    const osmium::Box box{1.0, 2.0, 3.0, 4.0};
+    cache.add(way, box);
+    REQUIRE(cache.envelope(way) == box);
+}
+
+TEST_CASE("Envelope cache with ways from several buffers") {
+    osmium::index::EnvelopeCache cache;
+    const auto buffer1 = create_ways();
+    const auto buffer2 = create_ways();
+
+    for (const auto* buffer : {&buffer2, &buffer1}) {
+        for (const auto& way : buffer->select<osmium::Way>()) {
+            cache.add(way, osmium::Box{});
+        }
+    }
+    // adding again replaces the earlier entry
+    for (const auto* buffer : {&buffer1, &buffer2}) {
+        for (const auto& way : buffer->select<osmium::Way>()) {
+            cache.add(way);
+        }
+    }
+    cache.sort();
+    REQUIRE(cache.size() == 20);
+
+    for (const auto* buffer : {&buffer1, &buffer2}) {
+        for (const auto& way : buffer->select<osmium::Way>()) {
+            const auto* box = cache.find(way);
+            REQUIRE(box);
+            REQUIRE(*box == way.envelope());
+        }
+    }
+}
@@ -9,6 +9,7 @@
 #include <osmium/util/file.hpp>
 
 #include <iterator>
+#include <vector>
 
 TEST_CASE("File based dense index") {
     const int fd = osmium::detail::create_tmp_file();
@@ -158,3 +159,29 @@ TEST_CASE("File based sparse index") {
     }
 }
 
+
+TEST_CASE("Prefetch from file based dense index") {
+    const int fd = osmium::detail::create_tmp_file();
+
+    using index_type = osmium::index::map::DenseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+    index_type index{fd};
+
+    std::vector<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 1; id < 1000000; id += 997) {
+        index.set(id, osmium::Location{static_cast<int32_t>(id), 7});
+        ids.push_back(id);
+    }
+    ids.push_back(2);
+    ids.push_back(5000000); // beyond end of index
+
+    index.prefetch(ids.data(), ids.size());
+    index.prefetch(ids.data(), 0);
+
+    std::vector<osmium::Location> locations(ids.size());
+    index.get_many(ids.data(), ids.size(), locations.data());
+    for (std::size_t i = 0; i < ids.size() - 2; ++i) {
+        REQUIRE(locations[i] == osmium::Location(static_cast<int32_t>(ids[i]), 7));
+    }
+    REQUIRE_FALSE(locations[ids.size() - 2]);
+    REQUIRE_FALSE(locations.back());
+}
@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <osmium/index/multimap/flat_multimap.hpp>
+#include <osmium/index/multimap/hybrid.hpp>
+#include <osmium/index/multimap/sparse_mem_array.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using flat_type = osmium::index::multimap::FlatMultimap<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type>;
+
+static std::vector<osmium::unsigned_object_id_type> values_for(const flat_type& map, osmium::unsigned_object_id_type id) {
+    const auto range = map.get_all(id);
+    return std::vector<osmium::unsigned_object_id_type>(range.first, range.second);
+}
+
+TEST_CASE("FlatMultimap: empty") {
+    flat_type map;
+    map.sort();
+    REQUIRE(map.size() == 0);
+    REQUIRE(map.num_keys() == 0);
+    REQUIRE(map.count(17) == 0);
+}
+
+TEST_CASE("FlatMultimap: set and get") {
+    flat_type map;
+    map.set(17, 3);
+    map.set(5, 1);
+    map.set(17, 2);
+    map.set(1000000, 7);
+    map.set(17, 9);
+    map.sort();
+
+    REQUIRE(map.size() == 5);
+    REQUIRE(map.num_keys() == 3);
+    REQUIRE(values_for(map, 17) == (std::vector<osmium::unsigned_object_id_type>{3, 2, 9}));
+    REQUIRE(values_for(map, 5) == std::vector<osmium::unsigned_object_id_type>{1});
+    REQUIRE(values_for(map, 1000000) == std::vector<osmium::unsigned_object_id_type>{7});
+    REQUIRE(map.count(0) == 0);
+    REQUIRE(map.count(6) == 0);
+    REQUIRE(map.count(999999) == 0);
+    REQUIRE(map.count(2000000) == 0);
+
+    SECTION("more values after sort") {
+        map.set(5, 4);
+        map.set(6, 8);
+        REQUIRE(map.count(6) == 0);
+        map.sort();
+        REQUIRE(values_for(map, 5) == (std::vector<osmium::unsigned_object_id_type>{1, 4}));
+        REQUIRE(values_for(map, 6) == std::vector<osmium::unsigned_object_id_type>{8});
+        REQUIRE(values_for(map, 17) == (std::vector<osmium::unsigned_object_id_type>{3, 2, 9}));
+    }
+
+    SECTION("clear") {
+        map.clear();
+        REQUIRE(map.size() == 0);
+        REQUIRE(map.count(17) == 0);
+    }
+}
+
+TEST_CASE("FlatMultimap: many keys") {
+    flat_type map;
+    for (osmium::unsigned_object_id_type id = 100000; id > 0; --id) {
+        map.set(id * 3, id);
+        if (id % 10 == 0) {
+            map.set(id * 3, id + 1);
+        }
+    }
+    map.sort();
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 100000; ++id) {
+        REQUIRE(map.count(id * 3) == (id % 10 == 0 ? 2 : 1));
+        REQUIRE(*map.get_all(id * 3).first == id);
+        REQUIRE(map.count(id * 3 + 1) == 0);
+    }
+}
+
+TEST_CASE("SparseMemArray multimap sorts values for same id") {
+    osmium::index::multimap::SparseMemArray<osmium::unsigned_object_id_type, osmium::unsigned_object_id_type> map;
+    for (osmium::unsigned_object_id_type id = 10000; id > 0; --id) {
+        map.set(id, 3);
+        map.set(id, 1);
+        map.set(id, 2);
+    }
+    map.sort();
+
+    const auto range = map.get_all(500);
+    REQUIRE(range.second - range.first == 3);
+    auto it = range.first;
+    REQUIRE(it->second == 1);
+    ++it;
+    REQUIRE(it->second == 2);
+    ++it;
+    REQUIRE(it->second == 3);
+}
@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_filter.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/id_set_compressed.hpp>
+#include <osmium/index/relations_map.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstddef>
+
+using filter_type = osmium::index::IdFilter<osmium::unsigned_object_id_type>;
+
+TEST_CASE("Empty IdFilter") {
+    const filter_type filter{1000};
+    REQUIRE(filter.empty());
+    REQUIRE(filter.size() == 0);
+    REQUIRE(filter.num_blocks() == 32);
+    REQUIRE(filter.num_hashes() == 7);
+    REQUIRE_FALSE(filter.get(0));
+    REQUIRE_FALSE(filter.get(17));
+}
+
+TEST_CASE("IdFilter has no false negatives and few false positives") {
+    const std::size_t num = 100000;
+    filter_type filter{num};
+    for (osmium::unsigned_object_id_type id = 1; id <= num; ++id) {
+        filter.set(id * 7);
+    }
+    REQUIRE_FALSE(filter.empty());
+    REQUIRE(filter.size() == num);
+    REQUIRE(filter.used_memory() < num * 2 * 10 / 8 + 64);
+
+    for (osmium::unsigned_object_id_type id = 1; id <= num; ++id) {
+        REQUIRE(filter.get(id * 7));
+    }
+
+    std::size_t false_positives = 0;
+    for (osmium::unsigned_object_id_type id = 1; id <= num; ++id) {
+        if (filter.get(id * 7 + 3)) {
+            ++false_positives;
+        }
+    }
+    REQUIRE(false_positives < num / 50);
+
+    filter.clear();
+    REQUIRE(filter.empty());
+    REQUIRE_FALSE(filter.get(7));
+}
+
+TEST_CASE("IdFilter with more bits per id has fewer false positives") {
+    const std::size_t num = 100000;
+    filter_type filter{num, 16};
+    for (osmium::unsigned_object_id_type id = 1; id <= num; ++id) {
+        filter.set(id);
+    }
+
+    std::size_t false_positives = 0;
+    for (osmium::unsigned_object_id_type id = num + 1; id <= 2 * num; ++id) {
+        if (filter.get(id)) {
+            ++false_positives;
+        }
+    }
+    REQUIRE(false_positives < num / 200);
+}
+
+TEST_CASE("IdFilter from IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type> ids;
+    ids.set(17);
+    ids.set(1000000);
+    ids.set(5000000000ULL);
+
+    const auto filter = filter_type::from_id_set(ids);
+    REQUIRE(filter.size() == 3);
+    REQUIRE(filter.get(17));
+    REQUIRE(filter.get(1000000));
+    REQUIRE(filter.get(5000000000ULL));
+}
+
+TEST_CASE("IdFilter from IdSetCompressed") {
+    osmium::index::IdSetCompressed<osmium::unsigned_object_id_type> ids;
+    for (osmium::unsigned_object_id_type id = 100; id < 200; ++id) {
+        ids.set(id);
+    }
+
+    const auto filter = filter_type::from_id_set(ids);
+    REQUIRE(filter.size() == 100);
+    for (osmium::unsigned_object_id_type id = 100; id < 200; ++id) {
+        REQUIRE(filter.get(id));
+    }
+}
+
+TEST_CASE("IdFilter from RelationsMapStash") {
+    osmium::index::RelationsMapStash stash;
+    stash.add(1, 10);
+    stash.add(2, 10);
+    stash.add(2, 11);
+
+    const auto filter = filter_type::from_relations_map_stash(stash);
+    REQUIRE(filter.size() == 3);
+    REQUIRE(filter.get(1));
+    REQUIRE(filter.get(2));
+
+    const auto index = stash.build_member_to_parent_index();
+    int count = 0;
+    index.for_each(2, [&](osmium::unsigned_object_id_type /*id*/) {
+        ++count;
+    });
+    REQUIRE(count == 2);
+}
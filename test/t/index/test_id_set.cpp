@@ -3,6 +3,8 @@
 #include <osmium/index/id_set.hpp>
 #include <osmium/osm/types.hpp>
 
+#include <vector>
+
 TEST_CASE("Basic functionality of IdSetDense") {
     osmium::index::IdSetDense<osmium::unsigned_object_id_type> s;
 
@@ -104,6 +106,61 @@ TEST_CASE("Large gap") {
     REQUIRE_FALSE(s.get(1u << 29u));
 }
 
+TEST_CASE("Iterating over IdSetDense with small chunks and gaps") {
+    // 2^3 bytes per chunk, so 64 Ids per chunk
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type, 3> s;
+
+    const std::vector<osmium::unsigned_object_id_type> ids = {0, 1, 63, 64, 127, 200, 1000, 1001, 100000, 100063};
+    for (const auto id : ids) {
+        s.set(id);
+    }
+
+    std::vector<osmium::unsigned_object_id_type> iterated;
+    for (const auto id : s) {
+        iterated.push_back(id);
+    }
+    REQUIRE(iterated == ids);
+
+    std::vector<osmium::unsigned_object_id_type> visited;
+    s.for_each_set([&](osmium::unsigned_object_id_type id) {
+        visited.push_back(id);
+    });
+    REQUIRE(visited == ids);
+}
+
+TEST_CASE("Counting ranges in IdSetDense") {
+    osmium::index::IdSetDense<osmium::unsigned_object_id_type, 3> s;
+
+    for (osmium::unsigned_object_id_type id = 10; id < 100000; id += 7) {
+        s.set(id);
+    }
+
+    REQUIRE(s.count_range(0, 1000000) == s.size());
+    REQUIRE(s.count_range(0, 10) == 0);
+    REQUIRE(s.count_range(0, 11) == 1);
+    REQUIRE(s.count_range(10, 11) == 1);
+    REQUIRE(s.count_range(11, 17) == 0);
+    REQUIRE(s.count_range(11, 18) == 1);
+    REQUIRE(s.count_range(100, 100) == 0);
+    REQUIRE(s.count_range(200, 100) == 0);
+
+    for (osmium::unsigned_object_id_type lo = 0; lo < 300; lo += 13) {
+        for (osmium::unsigned_object_id_type hi = lo; hi < 500; hi += 29) {
+            osmium::unsigned_object_id_type expected = 0;
+            for (osmium::unsigned_object_id_type id = lo; id < hi; ++id) {
+                expected += s.get(id) ? 1 : 0;
+            }
+            REQUIRE(s.count_range(lo, hi) == expected);
+        }
+    }
+
+    s.unset(10);
+    REQUIRE(s.count_range(0, 11) == 0);
+
+    const osmium::index::IdSetDense<osmium::unsigned_object_id_type> empty;
+    REQUIRE(empty.count_range(0, 1000) == 0);
+}
+
 TEST_CASE("Basic functionality of IdSetSmall") {
     osmium::index::IdSetSmall<osmium::unsigned_object_id_type> s;
 
@@ -0,0 +1,200 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_set_compressed.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using id_set_type = osmium::index::IdSetCompressed<osmium::unsigned_object_id_type>;
+using reference_type = std::set<osmium::unsigned_object_id_type>;
+
+static std::vector<osmium::unsigned_object_id_type> ids_of(const id_set_type& s) {
+    return std::vector<osmium::unsigned_object_id_type>(s.begin(), s.end());
+}
+
+static std::vector<osmium::unsigned_object_id_type> ids_of(const reference_type& s) {
+    return std::vector<osmium::unsigned_object_id_type>(s.begin(), s.end());
+}
+
+// Mix of sparse ids, dense ranges (bitmap containers), and long runs.
+static void fill(id_set_type& s, reference_type& r, unsigned int seed) {
+    std::mt19937 gen{seed};
+    std::uniform_int_distribution<osmium::unsigned_object_id_type> sparse{0, 1ULL << 34U};
+    for (int i = 0; i < 3000; ++i) {
+        const auto id = sparse(gen);
+        s.set(id);
+        r.insert(id);
+    }
+    std::uniform_int_distribution<osmium::unsigned_object_id_type> dense{1ULL << 20U, (1ULL << 20U) + 300000};
+    for (int i = 0; i < 60000; ++i) {
+        const auto id = dense(gen);
+        s.set(id);
+        r.insert(id);
+    }
+    const osmium::unsigned_object_id_type start = (1ULL << 24U) + seed * 1000;
+    for (osmium::unsigned_object_id_type id = start; id < start + 100000; ++id) {
+        s.set(id);
+        r.insert(id);
+    }
+}
+
+TEST_CASE("Basic functionality of IdSetCompressed") {
+    id_set_type s;
+
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.empty());
+    REQUIRE(s.size() == 0); // NOLINT(readability-container-size-empty)
+    REQUIRE(s.begin() == s.end());
+
+    s.set(17);
+    s.set(28);
+    s.set(17);
+    REQUIRE(s.get(17));
+    REQUIRE(s.get(28));
+    REQUIRE_FALSE(s.get(18));
+    REQUIRE(s.size() == 2);
+
+    REQUIRE_FALSE(s.check_and_set(17));
+    REQUIRE(s.check_and_set(1ULL << 40U));
+    REQUIRE(s.get(1ULL << 40U));
+    REQUIRE(s.num_containers() == 2);
+
+    s.unset(17);
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.size() == 2);
+
+    s.unset(1ULL << 40U);
+    REQUIRE(s.num_containers() == 1);
+
+    REQUIRE(ids_of(s) == std::vector<osmium::unsigned_object_id_type>{28});
+
+    s.clear();
+    REQUIRE(s.empty());
+    REQUIRE(s.num_containers() == 0);
+}
+
+TEST_CASE("IdSetCompressed switches between array and bitmap containers") {
+    id_set_type s;
+    for (osmium::unsigned_object_id_type id = 0; id < 20000; id += 2) {
+        s.set(id);
+    }
+    REQUIRE(s.size() == 10000);
+    REQUIRE(s.used_memory() < 10000 * sizeof(osmium::unsigned_object_id_type));
+    for (osmium::unsigned_object_id_type id = 0; id < 20000; ++id) {
+        REQUIRE(s.get(id) == (id % 2 == 0));
+    }
+
+    for (osmium::unsigned_object_id_type id = 0; id < 20000; id += 4) {
+        s.unset(id);
+    }
+    REQUIRE(s.size() == 5000);
+    for (osmium::unsigned_object_id_type id = 0; id < 19000; id += 4) {
+        s.unset(id + 2);
+    }
+    REQUIRE(s.size() == 250);
+    REQUIRE(ids_of(s).front() == 19002);
+}
+
+TEST_CASE("IdSetCompressed with runs") {
+    id_set_type s;
+    for (osmium::unsigned_object_id_type id = 1000; id < 1000000; ++id) {
+        s.set(id);
+    }
+    s.set(2000000);
+    const auto before = s.used_memory();
+    s.optimize();
+    REQUIRE(s.used_memory() < before / 10);
+    REQUIRE(s.size() == 999001);
+
+    REQUIRE_FALSE(s.get(999));
+    REQUIRE(s.get(1000));
+    REQUIRE(s.get(999999));
+    REQUIRE_FALSE(s.get(1000000));
+    REQUIRE(s.get(2000000));
+
+    std::size_t count = 0;
+    osmium::unsigned_object_id_type last = 0;
+    s.for_each([&](osmium::unsigned_object_id_type id) {
+        REQUIRE(id > last);
+        last = id;
+        ++count;
+    });
+    REQUIRE(count == s.size());
+    REQUIRE(static_cast<std::size_t>(std::distance(s.begin(), s.end())) == s.size());
+
+    // changing a run container
+    s.unset(5000);
+    REQUIRE_FALSE(s.get(5000));
+    REQUIRE(s.get(5001));
+    s.set(5000);
+    REQUIRE(s.get(5000));
+    REQUIRE(s.size() == 999001);
+}
+
+TEST_CASE("Set operations on IdSetCompressed") {
+    id_set_type a;
+    id_set_type b;
+    reference_type ra;
+    reference_type rb;
+    fill(a, ra, 1);
+    fill(b, rb, 2);
+
+    for (bool optimize : {false, true}) {
+        if (optimize) {
+            a.optimize();
+            b.optimize();
+        }
+
+        reference_type expected;
+        std::set_union(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expected, expected.end()));
+        const auto u = a | b;
+        REQUIRE(u.size() == expected.size());
+        REQUIRE(ids_of(u) == ids_of(expected));
+
+        expected.clear();
+        std::set_intersection(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expected, expected.end()));
+        const auto i = a & b;
+        REQUIRE(i.size() == expected.size());
+        REQUIRE(ids_of(i) == ids_of(expected));
+
+        expected.clear();
+        std::set_difference(ra.begin(), ra.end(), rb.begin(), rb.end(), std::inserter(expected, expected.end()));
+        const auto d = a - b;
+        REQUIRE(d.size() == expected.size());
+        REQUIRE(ids_of(d) == ids_of(expected));
+
+        REQUIRE((a - a).empty());
+        REQUIRE((a & a) == a);
+        id_set_type c{a};
+        c |= c;
+        REQUIRE(c == a);
+    }
+}
+
+TEST_CASE("Serialize and deserialize IdSetCompressed") {
+    id_set_type s;
+    reference_type r;
+    fill(s, r, 3);
+    s.optimize();
+
+    const std::string data{s.serialize()};
+    const auto s2 = id_set_type::deserialize(data);
+    REQUIRE(s2 == s);
+    REQUIRE(s2.size() == r.size());
+    REQUIRE(ids_of(s2) == ids_of(r));
+
+    REQUIRE_THROWS_AS(id_set_type::deserialize("foo"), const std::runtime_error&);
+    REQUIRE_THROWS_AS(id_set_type::deserialize(data.substr(0, data.size() - 1)), const std::runtime_error&);
+
+    std::string corrupt{data};
+    corrupt[16 + 8] = 7; // type of first container
+    REQUIRE_THROWS_AS(id_set_type::deserialize(corrupt), const std::runtime_error&);
+
+    REQUIRE(id_set_type::deserialize(id_set_type{}.serialize()).empty());
+}
@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_set_concurrent.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using id_set_type = osmium::index::IdSetDenseConcurrent<osmium::unsigned_object_id_type>;
+
+TEST_CASE("Basic functionality of IdSetDenseConcurrent") {
+    id_set_type s;
+
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.empty());
+    REQUIRE(s.size() == 0); // NOLINT(readability-container-size-empty)
+    REQUIRE(s.begin() == s.end());
+
+    s.set(17);
+    s.set(28);
+    s.set(17);
+    REQUIRE(s.get(17));
+    REQUIRE(s.get(28));
+    REQUIRE_FALSE(s.get(18));
+    REQUIRE(s.size() == 2);
+
+    REQUIRE_FALSE(s.check_and_set(17));
+    REQUIRE(s.check_and_set(1ULL << 33U));
+    REQUIRE(s.get(1ULL << 33U));
+
+    s.unset(17);
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.size() == 2);
+
+    const std::vector<osmium::unsigned_object_id_type> ids(s.begin(), s.end());
+    REQUIRE(ids == (std::vector<osmium::unsigned_object_id_type>{28, 1ULL << 33U}));
+
+    REQUIRE_FALSE(s.get(s.max_ids()));
+    REQUIRE_THROWS_AS(s.set(s.max_ids()), const std::out_of_range&);
+
+    s.clear();
+    REQUIRE(s.empty());
+    REQUIRE_FALSE(s.get(28));
+}
+
+TEST_CASE("IdSetDenseConcurrent used from several threads") {
+    id_set_type s;
+
+    const int num_threads = 4;
+    const osmium::unsigned_object_id_type num_ids = 200000;
+    std::atomic<std::size_t> added{0};
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([&s, &added, t]() {
+            std::size_t count = 0;
+            // All threads set the same ids in different orders, spread
+            // over several chunks.
+            for (osmium::unsigned_object_id_type n = 0; n < num_ids; ++n) {
+                const auto i = (n * 7919 + static_cast<osmium::unsigned_object_id_type>(t) * 104729) % num_ids;
+                if (s.check_and_set(i * 3001)) {
+                    ++count;
+                }
+            }
+            added += count;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    REQUIRE(added == num_ids);
+    REQUIRE(s.size() == num_ids);
+    for (osmium::unsigned_object_id_type n = 0; n < num_ids; ++n) {
+        REQUIRE(s.get(n * 3001));
+        REQUIRE_FALSE(s.get(n * 3001 + 1));
+    }
+}
@@ -0,0 +1,122 @@
+#include "catch.hpp"
+
+#include <osmium/index/id_set_mmap.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using id_set_type = osmium::index::IdSetDenseMmap<osmium::unsigned_object_id_type>;
+
+TEST_CASE("Basic functionality of anonymous IdSetDenseMmap") {
+    id_set_type s;
+
+    REQUIRE(s.filename().empty());
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.empty());
+    REQUIRE(s.begin() == s.end());
+
+    s.set(17);
+    s.set(28);
+    s.set(17);
+    REQUIRE(s.get(17));
+    REQUIRE(s.get(28));
+    REQUIRE_FALSE(s.get(18));
+    REQUIRE(s.size() == 2);
+
+    REQUIRE_FALSE(s.check_and_set(17));
+    REQUIRE(s.check_and_set(200000000));
+    REQUIRE(s.num_ids() > 200000000);
+
+    s.unset(17);
+    REQUIRE_FALSE(s.get(17));
+    REQUIRE(s.size() == 2);
+
+    const std::vector<osmium::unsigned_object_id_type> ids(s.begin(), s.end());
+    REQUIRE(ids == (std::vector<osmium::unsigned_object_id_type>{28, 200000000}));
+
+    s.clear();
+    REQUIRE(s.empty());
+    REQUIRE_FALSE(s.get(28));
+}
+
+TEST_CASE("Create, reopen, and update IdSetDenseMmap file") {
+    const std::string filename{"test-id-set-mmap.osmids"};
+
+    {
+        id_set_type s{filename, id_set_type::mode::create};
+        s.set(3);
+        s.set(100000000);
+        s.close();
+    }
+
+    {
+        const id_set_type s{filename};
+        REQUIRE(s.size() == 2);
+        REQUIRE(s.get(3));
+        REQUIRE(s.get(100000000));
+        REQUIRE_FALSE(s.get(4));
+    }
+
+    {
+        id_set_type s{filename, id_set_type::mode::read_write};
+        s.unset(3);
+        s.set(5);
+        // destructor closes the file
+    }
+
+    {
+        id_set_type s{filename};
+        REQUIRE_THROWS_AS(s.set(7), const osmium::id_set_file_error&);
+        const std::vector<osmium::unsigned_object_id_type> ids(s.begin(), s.end());
+        REQUIRE(ids == (std::vector<osmium::unsigned_object_id_type>{5, 100000000}));
+    }
+}
+
+TEST_CASE("Save anonymous IdSetDenseMmap to file") {
+    const std::string filename{"test-id-set-mmap-saved.osmids"};
+
+    id_set_type s;
+    for (osmium::unsigned_object_id_type id = 0; id < 100000; id += 7) {
+        s.set(id);
+    }
+    s.save(filename);
+
+    const id_set_type s2{filename};
+    REQUIRE(s2.size() == s.size());
+    REQUIRE(std::equal(s.begin(), s.end(), s2.begin()));
+}
+
+TEST_CASE("IdSetDenseMmap file not closed properly can not be opened") {
+    const std::string filename{"test-id-set-mmap-dirty.osmids"};
+
+    {
+        id_set_type s{filename, id_set_type::mode::create};
+        s.set(1);
+        s.flush();
+
+        // Opening again while still open for writing
+        REQUIRE_THROWS_AS(id_set_type(filename), const osmium::id_set_file_error&);
+    }
+}
+
+TEST_CASE("Opening invalid IdSetDenseMmap files fails") {
+    const std::string filename{"test-id-set-mmap-invalid.osmids"};
+
+    {
+        std::ofstream out{filename};
+        out << "foo";
+    }
+    REQUIRE_THROWS_AS(id_set_type(filename), const osmium::id_set_file_error&);
+
+    {
+        std::ofstream out{filename};
+        out << std::string(5000, 'x');
+    }
+    REQUIRE_THROWS_AS(id_set_type(filename), const osmium::id_set_file_error&);
+
+    REQUIRE_THROWS_AS(id_set_type("test-id-set-mmap-does-not-exist.osmids"), const std::system_error&);
+}
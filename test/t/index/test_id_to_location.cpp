@@ -1,5 +1,8 @@
 #include "catch.hpp"
 
+#include <osmium/index/map/compressed_mem_array.hpp>
+#include <osmium/index/map/concurrent_dense_mmap_array.hpp>
+#include <osmium/index/map/concurrent_sparse_mem_array.hpp>
 #include <osmium/index/map/dense_file_array.hpp>
 #include <osmium/index/map/dense_mem_array.hpp>
 #include <osmium/index/map/dense_mmap_array.hpp>
@@ -7,6 +10,8 @@
 #include <osmium/index/map/flex_mem.hpp>
 #include <osmium/index/map/sparse_file_array.hpp>
 #include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/map/sparse_mem_array_btree.hpp>
+#include <osmium/index/map/sparse_mem_array_compact.hpp>
 #include <osmium/index/map/sparse_mem_map.hpp>
 #include <osmium/index/map/sparse_mem_table.hpp>
 #include <osmium/index/map/sparse_mmap_array.hpp>
@@ -15,6 +20,7 @@
 #include <osmium/osm/types.hpp>
 
 #include <memory>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -183,7 +189,112 @@ TEST_CASE("Map Id to location: SparseMemArray") {
     test_func_real<index_type>(index2);
 }
 
+TEST_CASE("Map Id to location: SparseMemArrayBtree") {
+    using index_type = osmium::index::map::SparseMemArrayBtree<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+
+    REQUIRE(0 == index1.size());
+    REQUIRE(0 == index1.used_memory());
+
+    test_func_all<index_type>(index1);
+
+    REQUIRE(2 == index1.size());
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: SparseMemArrayBtree with many ids") {
+    using index_type = osmium::index::map::SparseMemArrayBtree<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index;
+    for (osmium::unsigned_object_id_type n = 1; n <= 10000; ++n) {
+        index.set(n * 5, osmium::Location{static_cast<int32_t>(n), 1});
+    }
+    index.sort();
+
+    for (osmium::unsigned_object_id_type id = 0; id <= 50010; ++id) {
+        if (id % 5 == 0 && id > 0 && id <= 50000) {
+            REQUIRE(index.get(id) == osmium::Location(static_cast<int32_t>(id / 5), 1));
+        } else {
+            REQUIRE(index.get_noexcept(id) == osmium::Location{});
+        }
+    }
+
+    index.set(3, osmium::Location{7, 7});
+    index.sort();
+    REQUIRE(index.get(3) == osmium::Location(7, 7));
+    REQUIRE(index.get(5) == osmium::Location(1, 1));
+    REQUIRE(index.size() == 10001);
+
+    // all tree shapes for small sizes
+    for (osmium::unsigned_object_id_type size = 1; size < 100; ++size) {
+        index_type small_index;
+        for (osmium::unsigned_object_id_type n = 1; n <= size; ++n) {
+            small_index.set(n * 2, osmium::Location{static_cast<int32_t>(n), 2});
+        }
+        small_index.sort();
+        for (osmium::unsigned_object_id_type id = 0; id <= size * 2 + 1; ++id) {
+            REQUIRE(small_index.get_noexcept(id) == (id % 2 == 0 && id > 0 ? osmium::Location(static_cast<int32_t>(id / 2), 2) : osmium::Location{}));
+        }
+    }
+}
+
 #ifdef __linux__
+TEST_CASE("Map Id to location: SparseMemArrayCompact") {
+    using index_type = osmium::index::map::SparseMemArrayCompact<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+
+    REQUIRE(0 == index1.size());
+    REQUIRE(0 == index1.used_memory());
+
+    test_func_all<index_type>(index1);
+
+    REQUIRE(2 == index1.size());
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+TEST_CASE("Map Id to location: SparseMemArrayCompact with ids above 32 bits") {
+    using index_type = osmium::index::map::SparseMemArrayCompact<osmium::unsigned_object_id_type, osmium::Location>;
+
+    const osmium::unsigned_object_id_type big = 1ULL << 32U;
+
+    index_type index;
+    index.set(big + 5, osmium::Location{1, 1});
+    index.set(5, osmium::Location{2, 2});
+    index.set(3 * big, osmium::Location{3, 3});
+    index.set(big - 1, osmium::Location{4, 4});
+    index.set(big + 2, osmium::Location{5, 5});
+    index.set(4, osmium::Location{6, 6});
+    index.sort();
+
+    REQUIRE(index.size() == 6);
+    REQUIRE(index.get(big + 5) == osmium::Location(1, 1));
+    REQUIRE(index.get(5) == osmium::Location(2, 2));
+    REQUIRE(index.get(3 * big) == osmium::Location(3, 3));
+    REQUIRE(index.get(big - 1) == osmium::Location(4, 4));
+    REQUIRE(index.get(big + 2) == osmium::Location(5, 5));
+    REQUIRE(index.get(4) == osmium::Location(6, 6));
+    REQUIRE(index.get_noexcept(big + 4) == osmium::Location{});
+    REQUIRE(index.get_noexcept(2 * big + 5) == osmium::Location{});
+    REQUIRE_THROWS_AS(index.get(big), const osmium::not_found&);
+
+    index_type sorted_index;
+    for (osmium::unsigned_object_id_type n = 0; n < 1000; ++n) {
+        sorted_index.set(big - 500 + n * 3, osmium::Location{static_cast<int32_t>(n), 1});
+    }
+    sorted_index.sort();
+    for (osmium::unsigned_object_id_type n = 0; n < 1000; ++n) {
+        REQUIRE(sorted_index.get(big - 500 + n * 3) == osmium::Location(static_cast<int32_t>(n), 1));
+        REQUIRE(sorted_index.get_noexcept(big - 500 + n * 3 + 1) == osmium::Location{});
+    }
+    REQUIRE(sorted_index.used_memory() < 1000 * sizeof(std::pair<osmium::unsigned_object_id_type, osmium::Location>));
+}
+
 TEST_CASE("Map Id to location: SparseMmapArray") {
     using index_type = osmium::index::map::SparseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
 
@@ -197,6 +308,58 @@ TEST_CASE("Map Id to location: SparseMmapArray") {
 # pragma message("not running 'SparseMmapArray' test case on this machine")
 #endif
 
+TEST_CASE("Map Id to location: CompressedMemArray") {
+    using index_type = osmium::index::map::CompressedMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+
+    REQUIRE(0 == index1.size());
+
+    test_func_all<index_type>(index1);
+
+    REQUIRE(13 == index1.size());
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
+#ifndef _WIN32
+TEST_CASE("Map Id to location: ConcurrentDenseMmapArray") {
+    using index_type = osmium::index::map::ConcurrentDenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1{1000};
+
+    REQUIRE(0 == index1.size());
+    REQUIRE(0 == index1.used_memory());
+
+    test_func_all<index_type>(index1);
+
+    REQUIRE(13 == index1.size());
+    REQUIRE_THROWS_AS(index1.set(1000, osmium::Location{}), const std::out_of_range&);
+
+    index_type index2{1000};
+    test_func_real<index_type>(index2);
+}
+#else
+# pragma message("not running 'ConcurrentDenseMmapArray' test case on this machine")
+#endif
+
+TEST_CASE("Map Id to location: ConcurrentSparseMemArray") {
+    using index_type = osmium::index::map::ConcurrentSparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+    index_type index1;
+
+    REQUIRE(0 == index1.size());
+    REQUIRE(0 == index1.used_memory());
+
+    test_func_all<index_type>(index1);
+
+    REQUIRE(2 == index1.size());
+
+    index_type index2;
+    test_func_real<index_type>(index2);
+}
+
 TEST_CASE("Map Id to location: FlexMem sparse") {
     using index_type = osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location>;
 
@@ -272,3 +435,23 @@ TEST_CASE("Map Id to location: Dynamic map choice") {
     }
 }
 
+
+#ifdef __linux__
+TEST_CASE("Map Id to location: mmap maps with hints from config string") {
+    using map_type = osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+
+    for (const char* config : {"dense_mmap_array,hugepages", "dense_mmap_array,hugepages,interleave,prefault", "sparse_mmap_array,prefault,interleave"}) {
+        std::unique_ptr<map_type> index1 = map_factory.create_map(config);
+        index1->reserve(1000);
+        test_func_all<map_type>(*index1);
+
+        std::unique_ptr<map_type> index2 = map_factory.create_map(config);
+        index2->reserve(100000000);
+        test_func_real<map_type>(*index2);
+    }
+
+    REQUIRE_THROWS_AS(map_factory.create_map("dense_mmap_array,foo"), const osmium::map_factory_error&);
+    REQUIRE_THROWS_WITH(map_factory.create_map("sparse_mmap_array,hugepages,foo"), "Unknown option 'foo' for map type 'sparse_mmap_array'");
+}
+#endif
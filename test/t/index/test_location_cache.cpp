@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/location_cache.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using cache_type = osmium::index::LocationCache;
+
+static const std::string filename{"test-location-cache.osmlc"};
+
+static void create_cache() {
+    cache_type cache{filename, cache_type::mode::create};
+    cache.set(1, osmium::Location{1.0, 2.0});
+    cache.set(17, osmium::Location{-3.0, 4.0});
+    cache.set(2000000, osmium::Location{5.5, -6.5});
+    cache.set_replication_state(osmium::Timestamp{"2018-01-02T03:04:05Z"}, 1234);
+    cache.close();
+}
+
+TEST_CASE("Create and read location cache") {
+    create_cache();
+
+    cache_type cache{filename};
+    REQUIRE(cache.size() >= 2000001);
+    REQUIRE(cache.timestamp() == osmium::Timestamp{"2018-01-02T03:04:05Z"});
+    REQUIRE(cache.sequence_number() == 1234);
+    REQUIRE(cache.bbox() == (osmium::Box{-3.0, -6.5, 5.5, 4.0}));
+
+    REQUIRE(cache.get(1) == osmium::Location(1.0, 2.0));
+    REQUIRE(cache.get(17) == osmium::Location(-3.0, 4.0));
+    REQUIRE(cache.get(2000000) == osmium::Location(5.5, -6.5));
+    REQUIRE_THROWS_AS(cache.get(2), const osmium::not_found&);
+    REQUIRE_THROWS_AS(cache.get(100000000), const osmium::not_found&);
+    REQUIRE(cache.get_noexcept(100000000) == osmium::Location{});
+
+    REQUIRE_THROWS_AS(cache.set(3, osmium::Location{}), const osmium::location_cache_error&);
+}
+
+TEST_CASE("Update location cache from change file") {
+    create_cache();
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _version(2), _location(1.5, 2.5));
+    osmium::builder::add_node(buffer, _id(17), _version(2), _deleted());
+    osmium::builder::add_node(buffer, _id(18), _version(1), _location(7.0, 8.0));
+    osmium::builder::add_node(buffer, _id(18), _version(2), _location(7.5, 8.5));
+    osmium::builder::add_node(buffer, _id(-5), _version(1), _location(0.0, 0.0));
+
+    {
+        cache_type cache{filename, cache_type::mode::read_write};
+        osmium::index::LocationCacheUpdater updater{cache};
+        osmium::apply(buffer, updater);
+        cache.set_replication_state(osmium::Timestamp{"2018-01-02T03:05:05Z"}, 1235);
+        cache.close();
+    }
+
+    cache_type cache{filename};
+    REQUIRE(cache.sequence_number() == 1235);
+    REQUIRE(cache.get(1) == osmium::Location(1.5, 2.5));
+    REQUIRE_THROWS_AS(cache.get(17), const osmium::not_found&);
+    REQUIRE(cache.get(18) == osmium::Location(7.5, 8.5));
+    REQUIRE(cache.get(2000000) == osmium::Location(5.5, -6.5));
+    REQUIRE(cache.bbox() == (osmium::Box{-3.0, -6.5, 7.5, 8.5}));
+}
+
+TEST_CASE("Use location cache with NodeLocationsForWays") {
+    create_cache();
+
+    cache_type cache{filename};
+    osmium::handler::NodeLocationsForWays<cache_type> handler{cache};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 17, 2000000}));
+    handler.ways(buffer);
+
+    const auto& way = buffer.get<osmium::Way>(0);
+    REQUIRE(way.nodes()[1].location() == osmium::Location(-3.0, 4.0));
+}
+
+TEST_CASE("Location cache not closed properly can not be opened") {
+    create_cache();
+
+    cache_type cache{filename, cache_type::mode::read_write};
+    cache.set(5, osmium::Location{1.0, 1.0});
+    cache.flush();
+
+    REQUIRE_THROWS_WITH(cache_type{filename}, "Location cache file 'test-location-cache.osmlc' was not closed properly");
+    REQUIRE_THROWS_AS(cache_type(filename, cache_type::mode::read_write), const osmium::location_cache_error&);
+
+    cache.close();
+    cache_type cache2{filename};
+    REQUIRE(cache2.get(5) == osmium::Location(1.0, 1.0));
+}
+
+TEST_CASE("Opening file that is not a location cache fails") {
+    const std::string bad_filename{"test-location-cache-bad.osmlc"};
+    {
+        std::ofstream out{bad_filename, std::ios::binary};
+        out << std::string(5000, 'x');
+    }
+    REQUIRE_THROWS_WITH(cache_type{bad_filename}, "File 'test-location-cache-bad.osmlc' is not a location cache");
+
+    {
+        std::ofstream out{bad_filename, std::ios::binary};
+        out << "short";
+    }
+    REQUIRE_THROWS_AS(cache_type{bad_filename}, const osmium::location_cache_error&);
+}
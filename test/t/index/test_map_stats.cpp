@@ -0,0 +1,123 @@
+#include "catch.hpp"
+
+#define OSMIUM_WITH_INDEX_STATS
+
+#include <osmium/index/map/dense_mem_array.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/multimap/sparse_mem_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <sstream>
+#include <string>
+
+using id_type = osmium::unsigned_object_id_type;
+
+TEST_CASE("Stats of dense map") {
+    osmium::index::map::DenseMemArray<id_type, osmium::Location> map;
+    map.set(3, osmium::Location{1, 1});
+    map.set(7, osmium::Location{2, 2});
+
+    REQUIRE(map.get(3) == osmium::Location(1, 1));
+    REQUIRE(map.get_noexcept(4) == osmium::Location{});
+    REQUIRE(map.get_noexcept(100) == osmium::Location{});
+    REQUIRE_THROWS_AS(map.get(5), const osmium::not_found&);
+
+    const auto stats = map.statistics();
+    REQUIRE(stats.size == 2);
+    REQUIRE(stats.capacity == 8);
+    REQUIRE(stats.fill_ratio() == Approx(0.25));
+    REQUIRE(stats.used_memory == map.used_memory());
+    REQUIRE(stats.lookups == 4);
+    REQUIRE(stats.misses == 3);
+}
+
+TEST_CASE("Stats of sparse map") {
+    osmium::index::map::SparseMemArray<id_type, osmium::Location> map;
+    map.set(7, osmium::Location{2, 2});
+    map.set(3, osmium::Location{1, 1});
+
+    REQUIRE_FALSE(map.statistics().sorted);
+    map.sort();
+
+    REQUIRE(map.get(7) == osmium::Location(2, 2));
+    REQUIRE(map.get_noexcept(4) == osmium::Location{});
+
+    const auto stats = map.statistics();
+    REQUIRE(stats.sorted);
+    REQUIRE(stats.size == 2);
+    REQUIRE(stats.capacity == 0);
+    REQUIRE(stats.fill_ratio() == Approx(1.0));
+    REQUIRE(stats.lookups == 2);
+    REQUIRE(stats.misses == 1);
+}
+
+TEST_CASE("Stats of FlexMem map in dense mode") {
+    osmium::index::map::FlexMem<id_type, osmium::Location> map{true};
+    map.set(1, osmium::Location{1, 1});
+    map.set(2, osmium::Location{2, 2});
+
+    const auto stats = map.statistics();
+    REQUIRE(stats.size == 2);
+    REQUIRE(stats.blocks == 1);
+    REQUIRE(stats.capacity > 2);
+}
+
+TEST_CASE("Stats of multimap") {
+    osmium::index::multimap::SparseMemArray<id_type, id_type> map;
+    map.set(2, 1);
+    map.set(1, 1);
+    map.set(1, 2);
+
+    REQUIRE_FALSE(map.statistics().sorted);
+    map.sort();
+
+    const auto stats = map.statistics();
+    REQUIRE(stats.sorted);
+    REQUIRE(stats.size == 3);
+    REQUIRE(stats.lookups == 0);
+}
+
+TEST_CASE("Dump stats of all live maps") {
+    const auto& factory = osmium::index::MapFactory<id_type, osmium::Location>::instance();
+    osmium::index::register_map<id_type, osmium::Location, osmium::index::map::SparseMemArray>("sparse_mem_array");
+    REQUIRE(factory.has_map_type("sparse_mem_array"));
+
+    std::ostringstream before;
+    factory.dump_stats(before);
+    REQUIRE(before.str().empty());
+
+    {
+        auto map = factory.create_map("sparse_mem_array");
+        map->set(1, osmium::Location{1, 1});
+        map->sort();
+        REQUIRE(map->get_noexcept(1) == osmium::Location(1, 1));
+
+        osmium::index::map::DenseMemArray<id_type, osmium::Location> unnamed;
+
+        std::ostringstream out;
+        factory.dump_stats(out);
+        const std::string result{out.str()};
+        REQUIRE(result.find("sparse_mem_array: size=1 ") != std::string::npos);
+        REQUIRE(result.find("lookups=1 misses=0") != std::string::npos);
+        REQUIRE(result.find("(unnamed): size=0 ") != std::string::npos);
+    }
+
+    std::ostringstream after;
+    factory.dump_stats(after);
+    REQUIRE(after.str().empty());
+}
+
+TEST_CASE("Print stats") {
+    osmium::index::map_stats stats;
+    stats.size = 5;
+    stats.used_memory = 80;
+    stats.capacity = 10;
+    stats.lookups = 3;
+    stats.misses = 1;
+
+    std::ostringstream out;
+    out << stats;
+    REQUIRE(out.str() == "size=5 used_memory=80 capacity=10 fill_ratio=0.500 sorted=yes lookups=3 misses=1");
+}
@@ -0,0 +1,81 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/index/nwr_index_bundle.hpp>
+#include <osmium/osm/location.hpp>
+
+#include <string>
+
+using bundle_type = osmium::index::NWRIndexBundle<osmium::Location>;
+
+static osmium::Location loc(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id * 2)};
+}
+
+TEST_CASE("NWRIndexBundle within budget") {
+    bundle_type bundle{1024UL * 1024UL * 1024UL};
+    REQUIRE(bundle.memory_budget() == 1024UL * 1024UL * 1024UL);
+
+    bundle.set(osmium::item_type::node, 17, loc(17));
+    bundle.set_id(osmium::item_type::way, 3);
+    bundle.set_id(osmium::item_type::relation, 4);
+    bundle.sort();
+
+    REQUIRE(bundle.get(osmium::item_type::node, 17) == loc(17));
+    REQUIRE_FALSE(bundle.get_noexcept(osmium::item_type::node, 18).valid());
+    const auto& way_map = bundle.map(osmium::item_type::way);
+    REQUIRE_THROWS_AS(way_map.get(17), const osmium::not_found&);
+    REQUIRE(bundle.get_id(osmium::item_type::way, 3));
+    REQUIRE_FALSE(bundle.get_id(osmium::item_type::way, 4));
+    REQUIRE(bundle.get_id(osmium::item_type::relation, 4));
+
+    REQUIRE(bundle.check_budget());
+    REQUIRE_FALSE(bundle.map_switched(osmium::item_type::node));
+    REQUIRE_FALSE(bundle.id_set_compressed(osmium::item_type::way));
+}
+
+static void check_switching(const std::string& map_type) {
+    bundle_type bundle{1024UL * 1024UL, map_type};
+
+    const osmium::unsigned_object_id_type num = 200000;
+    for (osmium::unsigned_object_id_type id = 1; id <= num; ++id) {
+        bundle.set(osmium::item_type::node, id * 3, loc(id));
+        bundle.set_id(osmium::item_type::way, id * 1000);
+    }
+    REQUIRE(bundle.check_budget());
+    REQUIRE(bundle.used_memory() <= bundle.memory_budget());
+
+    REQUIRE(bundle.id_set_compressed(osmium::item_type::way));
+    REQUIRE(bundle.map_switched(osmium::item_type::node));
+    REQUIRE_FALSE(bundle.map_switched(osmium::item_type::way));
+    REQUIRE_FALSE(bundle.id_set_compressed(osmium::item_type::relation));
+
+    bundle.sort();
+    for (osmium::unsigned_object_id_type id = 1; id <= num; ++id) {
+        REQUIRE(bundle.get(osmium::item_type::node, id * 3) == loc(id));
+        REQUIRE(bundle.get_id(osmium::item_type::way, id * 1000));
+        REQUIRE_FALSE(bundle.get_id(osmium::item_type::way, id * 1000 + 1));
+    }
+    REQUIRE(bundle.map(osmium::item_type::node).size() == num);
+}
+
+TEST_CASE("NWRIndexBundle switches structures when over budget") {
+    SECTION("flex_mem") {
+        check_switching("flex_mem");
+    }
+    SECTION("sparse_mem_array") {
+        check_switching("sparse_mem_array");
+    }
+}
+
+static void create_bundle(const std::string& map_type, const std::string& fallback_map_type) {
+    const bundle_type bundle{1000, map_type, fallback_map_type};
+}
+
+TEST_CASE("NWRIndexBundle with unknown map type") {
+    REQUIRE_THROWS_AS(create_bundle("does_not_exist", "sparse_file_array"), const osmium::map_factory_error&);
+    REQUIRE_THROWS_AS(create_bundle("flex_mem", "does_not_exist"), const osmium::map_factory_error&);
+}
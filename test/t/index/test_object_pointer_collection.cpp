@@ -82,3 +82,57 @@ TEST_CASE("Create ObjectPointerCollection") {
     REQUIRE(collection.empty());
 }
 
+
+TEST_CASE("Sort large ObjectPointerCollection") {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    uint32_t state = 1;
+    const auto next = [&state]() {
+        state = state * 1103515245U + 12345U;
+        return state >> 8U;
+    };
+
+    for (int i = 0; i < 20000; ++i) {
+        const auto id = static_cast<osmium::object_id_type>(next() % 3000) - 1000;
+        const auto version = next() % 5 + 1;
+        const osmium::Timestamp timestamp{next() % 4 == 0 ? 0 : 1500000000 + next() % 1000};
+        switch (next() % 3) {
+            case 0:
+                osmium::builder::add_node(buffer, _id(id), _version(version), _timestamp(timestamp));
+                break;
+            case 1:
+                osmium::builder::add_way(buffer, _id(id), _version(version), _timestamp(timestamp));
+                break;
+            default:
+                osmium::builder::add_relation(buffer, _id(id), _version(version), _timestamp(timestamp));
+                break;
+        }
+    }
+
+    osmium::ObjectPointerCollection collection;
+    osmium::apply(buffer, collection);
+    REQUIRE(collection.size() == 20000);
+
+    SECTION("type id version") {
+        collection.sort(osmium::object_order_type_id_version{});
+        REQUIRE(std::is_sorted(collection.cbegin(), collection.cend(), osmium::object_order_type_id_version{}));
+    }
+
+    SECTION("type id version without timestamp") {
+        collection.sort(osmium::object_order_type_id_version_without_timestamp{});
+        REQUIRE(std::is_sorted(collection.cbegin(), collection.cend(), osmium::object_order_type_id_version_without_timestamp{}));
+    }
+
+    SECTION("type id reverse version") {
+        const osmium::object_order_type_id_reverse_version order{};
+        collection.sort(order);
+        REQUIRE(std::is_sorted(collection.cbegin(), collection.cend(), order));
+    }
+
+    SECTION("sort and unique") {
+        collection.sort(osmium::object_order_type_id_version{});
+        collection.unique(osmium::object_equal_type_id_version{});
+        REQUIRE(collection.size() < 20000);
+        REQUIRE(std::adjacent_find(collection.cbegin(), collection.cend(), osmium::object_equal_type_id_version{}) == collection.cend());
+    }
+}
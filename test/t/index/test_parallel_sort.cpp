@@ -0,0 +1,98 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/parallel_sort.hpp>
+#include <osmium/index/map/flex_mem.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+using element_type = std::pair<uint64_t, uint32_t>;
+
+static std::vector<element_type> random_data(std::size_t size, uint64_t max_key) {
+    std::mt19937_64 gen{size}; // NOLINT(cert-msc32-c,cert-msc51-cpp)
+    std::uniform_int_distribution<uint64_t> dist{0, max_key};
+
+    std::vector<element_type> data;
+    data.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        data.emplace_back(dist(gen), static_cast<uint32_t>(i));
+    }
+    return data;
+}
+
+static void check_radix_sort(std::size_t size, uint64_t max_key) {
+    auto data = random_data(size, max_key);
+    auto expected = data;
+    std::stable_sort(expected.begin(), expected.end(), [](const element_type& a, const element_type& b) {
+        return a.first < b.first;
+    });
+
+    osmium::index::detail::radix_sort(data, [](const element_type& e) noexcept {
+        return e.first;
+    });
+
+    REQUIRE(data == expected);
+}
+
+TEST_CASE("Radix sort small input") {
+    check_radix_sort(0, 10);
+    check_radix_sort(1, 10);
+    check_radix_sort(1000, 100);
+}
+
+TEST_CASE("Radix sort medium input with duplicates is stable") {
+    check_radix_sort(100000, 1000);
+}
+
+TEST_CASE("Radix sort large input with large keys uses threads") {
+    check_radix_sort(3UL * 1024UL * 1024UL, 20000000000ULL);
+}
+
+TEST_CASE("Radix sort with all keys the same") {
+    check_radix_sort(10000, 0);
+}
+
+TEST_CASE("SparseMemArray sorted with radix sort") {
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+
+    for (osmium::unsigned_object_id_type id = 20000; id > 0; --id) {
+        index.set(id * 7, osmium::Location{static_cast<int32_t>(id), 1});
+    }
+    index.sort();
+
+    for (osmium::unsigned_object_id_type id = 1; id <= 20000; ++id) {
+        REQUIRE(index.get(id * 7) == osmium::Location(static_cast<int32_t>(id), 1));
+    }
+    REQUIRE_THROWS_AS(index.get(8), const osmium::not_found&);
+}
+
+TEST_CASE("FlexMem switch to dense with many entries") {
+    osmium::index::map::FlexMem<osmium::unsigned_object_id_type, osmium::Location> index;
+
+    const osmium::unsigned_object_id_type num = 2000000;
+    for (osmium::unsigned_object_id_type id = num; id > 0; --id) {
+        index.set(id * 3, osmium::Location{static_cast<int32_t>(id), 2});
+    }
+    index.set(6, osmium::Location{5, 5});
+    REQUIRE_FALSE(index.is_dense());
+
+    index.switch_to_dense();
+    REQUIRE(index.is_dense());
+
+    // duplicate id: the last value set wins
+    REQUIRE(index.get(6) == osmium::Location(5, 5));
+    for (osmium::unsigned_object_id_type id = 3; id <= num; ++id) {
+        REQUIRE(index.get(id * 3) == osmium::Location(static_cast<int32_t>(id), 2));
+    }
+    REQUIRE_THROWS_AS(index.get(4), const osmium::not_found&);
+
+    const auto stats = index.stats();
+    REQUIRE(stats.first == (num * 3) / (1U << 16U) + 1);
+    REQUIRE(stats.second == 0);
+}
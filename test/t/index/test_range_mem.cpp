@@ -0,0 +1,121 @@
+#include "catch.hpp"
+
+#include <osmium/index/detail/tmpfile.hpp>
+#include <osmium/index/map/range_mem.hpp>
+#include <osmium/index/map/sparse_file_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <memory>
+#include <string>
+
+using range_mem = osmium::index::map::RangeMem<osmium::unsigned_object_id_type, osmium::Location>;
+using sparse_file_array = osmium::index::map::SparseFileArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id % 1000), static_cast<int32_t>(id % 777)};
+}
+
+static void fill(range_mem& index) {
+    index.set(5, location_for(5));
+    for (osmium::unsigned_object_id_type id = 1000000; id < 1200000; id += 2) {
+        index.set(id, location_for(id));
+    }
+    index.set(99999999, location_for(99999999));
+    index.set(3, location_for(3));
+    index.sort();
+}
+
+static void check(const range_mem& index) {
+    REQUIRE(index.get(3) == location_for(3));
+    REQUIRE(index.get(5) == location_for(5));
+    REQUIRE(index.get(99999999) == location_for(99999999));
+    REQUIRE(index.get(1000000) == location_for(1000000));
+    REQUIRE(index.get(1199998) == location_for(1199998));
+    REQUIRE(index.get_noexcept(1000001) == osmium::Location{});
+    REQUIRE(index.get_noexcept(4) == osmium::Location{});
+    REQUIRE(index.get_noexcept(1200000) == osmium::Location{});
+    REQUIRE_THROWS_AS(index.get(7), const osmium::not_found&);
+}
+
+TEST_CASE("RangeMem without dense range") {
+    range_mem index;
+    fill(index);
+    check(index);
+
+    REQUIRE(index.size() == 100003);
+    const auto stats = index.statistics();
+    REQUIRE(stats.blocks == 0);
+    REQUIRE(stats.size == 100003);
+    REQUIRE(stats.sorted);
+}
+
+TEST_CASE("RangeMem with dense range") {
+    range_mem index{1000000, 1200000};
+    REQUIRE(index.dense_range().first <= 1000000);
+    REQUIRE(index.dense_range().second == 1200000);
+
+    fill(index);
+    check(index);
+
+    const auto stats = index.statistics();
+    REQUIRE(stats.blocks == 4);
+    REQUIRE(stats.size == 100003);
+    REQUIRE(index.used_memory() < 4 * 65536 * sizeof(osmium::Location) + 1000);
+
+    index.clear();
+    REQUIRE(index.get_noexcept(3) == osmium::Location{});
+    REQUIRE(index.get_noexcept(1000000) == osmium::Location{});
+}
+
+TEST_CASE("RangeMem with dense range from statistics") {
+    osmium::index::map::RangeMemStatistics statistics;
+    REQUIRE(statistics.dense_range().first == 0);
+    REQUIRE(statistics.dense_range().second == 0);
+
+    statistics.add(5);
+    statistics.add(3);
+    for (osmium::unsigned_object_id_type id = 1000000; id < 1200000; id += 2) {
+        statistics.add(id);
+    }
+    statistics.add(99999999);
+
+    const auto range = statistics.dense_range();
+    REQUIRE(range.first <= 1000000);
+    REQUIRE(range.first > 5);
+    REQUIRE(range.second > 1100000);
+    REQUIRE(range.second < 99999999);
+
+    range_mem index{statistics};
+    fill(index);
+    check(index);
+    REQUIRE(index.statistics().blocks > 0);
+}
+
+TEST_CASE("Dump RangeMem, load as SparseFileArray") {
+    range_mem index{1000000, 1200000};
+    fill(index);
+
+    const int fd = osmium::detail::create_tmp_file();
+    index.dump_as_list(fd);
+
+    sparse_file_array file_index{fd};
+    REQUIRE(file_index.size() == 100003);
+    REQUIRE(file_index.get(3) == location_for(3));
+    REQUIRE(file_index.get(1000000) == location_for(1000000));
+    REQUIRE(file_index.get(99999999) == location_for(99999999));
+    REQUIRE_THROWS_AS(file_index.get(7), const osmium::not_found&);
+}
+
+TEST_CASE("Create RangeMem from config string") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+
+    const auto index = map_factory.create_map("range_mem,1000000,1200000");
+    index->set(1000000, location_for(1000000));
+    index->set(17, location_for(17));
+    index->sort();
+    REQUIRE(index->get(1000000) == location_for(1000000));
+    REQUIRE(index->get(17) == location_for(17));
+    REQUIRE(index->statistics().blocks == 1);
+}
@@ -3,6 +3,7 @@
 #include <osmium/index/relations_map.hpp>
 
 #include <type_traits>
+#include <vector>
 
 static_assert(!std::is_default_constructible<osmium::index::RelationsMapIndex>::value, "RelationsMapIndex should not be default constructible");
 static_assert(!std::is_copy_constructible<osmium::index::RelationsMapIndex>::value, "RelationsMapIndex should not be copy constructible");
@@ -105,3 +106,39 @@ TEST_CASE("RelationsMapStash both indexes") {
     REQUIRE(count == 2);
 }
 
+
+TEST_CASE("RelationsMapStash large indexes with duplicates") {
+    osmium::index::RelationsMapStash stash;
+
+    // Enough pairs to use the parallel sort, added in reverse order and
+    // each one twice.
+    const osmium::unsigned_object_id_type num = 700000;
+    for (osmium::unsigned_object_id_type n = num; n > 0; --n) {
+        stash.add(n, n / 3 + 1000000);
+        stash.add(n, n / 3 + 1000000);
+    }
+    stash.add(5, 4000000000UL);
+    REQUIRE(stash.size() == 2 * num + 1);
+
+    const auto index = stash.build_indexes();
+    REQUIRE(index.size() == num + 1);
+
+    std::vector<osmium::unsigned_object_id_type> parents;
+    index.member_to_parent().for_each(5, [&](osmium::unsigned_object_id_type id) {
+        parents.push_back(id);
+    });
+    REQUIRE(parents == (std::vector<osmium::unsigned_object_id_type>{1000001, 4000000000UL}));
+
+    std::vector<osmium::unsigned_object_id_type> members;
+    index.parent_to_member().for_each(1000100, [&](osmium::unsigned_object_id_type id) {
+        members.push_back(id);
+    });
+    REQUIRE(members == (std::vector<osmium::unsigned_object_id_type>{300, 301, 302}));
+
+    int count = 0;
+    index.parent_to_member().for_each(4000000000UL, [&](osmium::unsigned_object_id_type id) {
+        REQUIRE(id == 5);
+        ++count;
+    });
+    REQUIRE(count == 1);
+}
@@ -0,0 +1,158 @@
+#include "catch.hpp"
+
+#include <osmium/index/map/shared_dense_mmap_array.hpp>
+#include <osmium/index/node_locations_map.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using shared_index_type = osmium::index::map::SharedDenseMmapArray<osmium::unsigned_object_id_type, osmium::Location>;
+
+static osmium::Location location_for(osmium::unsigned_object_id_type id) {
+    return osmium::Location{static_cast<int32_t>(id), static_cast<int32_t>(id) * 2};
+}
+
+TEST_CASE("SharedDenseMmapArray: load and attach") {
+    const std::string filename{"test_shared_dense_mmap_array.idx"};
+
+    shared_index_type loader{filename, 100000};
+    REQUIRE_FALSE(loader.read_only());
+    REQUIRE_FALSE(loader.ready());
+    REQUIRE(loader.max_ids() == 100000);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&loader, t]() {
+            for (int n = 0; n < 10000; ++n) {
+                const osmium::unsigned_object_id_type id = n * 4 + t + 1;
+                loader.set(id, location_for(id));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(loader.size() == 40001);
+    REQUIRE_THROWS_AS(loader.set(100000, location_for(1)), const std::out_of_range&);
+
+    // Consumers can't attach before the map is ready.
+    REQUIRE_THROWS_AS(shared_index_type{filename}, const std::runtime_error&);
+
+    loader.mark_ready();
+    REQUIRE(loader.ready());
+
+    const shared_index_type consumer{filename};
+    REQUIRE(consumer.read_only());
+    REQUIRE(consumer.ready());
+    REQUIRE(consumer.max_ids() == 100000);
+    REQUIRE(consumer.size() == 40001);
+    REQUIRE_THROWS_AS(consumer.get(0), const osmium::not_found&);
+    for (osmium::unsigned_object_id_type id = 1; id <= 40000; ++id) {
+        REQUIRE(consumer.get(id) == location_for(id));
+    }
+    REQUIRE(consumer.get_noexcept(40001) == osmium::Location{});
+    REQUIRE(consumer.get_noexcept(1000000) == osmium::Location{});
+
+    const std::vector<osmium::unsigned_object_id_type> ids = {5, 0, 17, 2000000, 40000, 3};
+    std::vector<osmium::Location> locations(ids.size());
+    consumer.get_many(ids.data(), ids.size(), locations.data());
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        REQUIRE(locations[i] == consumer.get_noexcept(ids[i]));
+    }
+
+    shared_index_type consumer2{filename};
+    REQUIRE_THROWS_AS(consumer2.set(1, location_for(1)), const std::runtime_error&);
+    REQUIRE_THROWS_AS(consumer2.clear(), const std::runtime_error&);
+    REQUIRE_THROWS_AS(consumer2.mark_ready(), const std::runtime_error&);
+
+    // Changes of the loader are visible to attached consumers.
+    loader.clear();
+    REQUIRE(loader.size() == 0);
+    REQUIRE_FALSE(consumer.ready());
+    REQUIRE(consumer.get_noexcept(5) == osmium::Location{});
+    loader.set(7, location_for(7));
+    REQUIRE(consumer.get(7) == location_for(7));
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("SharedDenseMmapArray: attach from other process") {
+    const std::string filename{"test_shared_dense_mmap_array_fork.idx"};
+
+    shared_index_type loader{filename, 1000};
+    loader.set(42, location_for(42));
+    loader.mark_ready();
+
+    const pid_t pid = fork();
+    REQUIRE(pid >= 0);
+    if (pid == 0) {
+        int result = 1;
+        try {
+            const shared_index_type consumer{filename};
+            if (consumer.get(42) == location_for(42) && consumer.size() == 43) {
+                result = 0;
+            }
+        } catch (...) {
+        }
+        _exit(result);
+    }
+
+    int status = 0;
+    REQUIRE(waitpid(pid, &status, 0) == pid);
+    REQUIRE(WIFEXITED(status));
+    REQUIRE(WEXITSTATUS(status) == 0);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("SharedDenseMmapArray: invalid files") {
+    const std::string filename{"test_shared_dense_mmap_array_invalid.idx"};
+
+    SECTION("file too small") {
+        std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+        out << "OSMSHDMA";
+    }
+
+    SECTION("wrong magic") {
+        std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+        out << std::string(8192, 'x');
+    }
+
+    REQUIRE_THROWS_AS(shared_index_type{filename}, const std::runtime_error&);
+    REQUIRE_THROWS_AS(shared_index_type{"test_shared_dense_mmap_array_does_not_exist.idx"}, const std::system_error&);
+
+    std::remove(filename.c_str());
+}
+
+TEST_CASE("SharedDenseMmapArray: create with map factory") {
+    const auto& map_factory = osmium::index::MapFactory<osmium::unsigned_object_id_type, osmium::Location>::instance();
+    REQUIRE(map_factory.has_map_type("shared_dense_mmap_array"));
+
+    REQUIRE_THROWS_AS(map_factory.create_map("shared_dense_mmap_array"), const osmium::map_factory_error&);
+
+    const std::string filename{"test_shared_dense_mmap_array_factory.idx"};
+    {
+        auto map = map_factory.create_map("shared_dense_mmap_array," + filename + ",create");
+        map->set(3, location_for(3));
+        static_cast<shared_index_type&>(*map).mark_ready();
+    }
+
+    const auto map = map_factory.create_map("shared_dense_mmap_array," + filename);
+    REQUIRE(map->get(3) == location_for(3));
+
+    std::remove(filename.c_str());
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/apply_changes.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static void write_file(const osmium::io::File& file, osmium::memory::Buffer&& buffer) {
+    osmium::io::Writer writer{file, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+// Nodes 1 to count in version 2 and ways 1 to 3.
+static osmium::memory::Buffer create_base(int count) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= count; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(2), _location(1, 1));
+    }
+    for (int id = 1; id <= 3; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}));
+    }
+    return buffer;
+}
+
+static void write_changes(const std::string& filename1, const std::string& filename2) {
+    osmium::memory::Buffer buffer1{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer1, _id(1), _version(1), _location(2, 2)); // older than base
+    osmium::builder::add_node(buffer1, _id(3), _version(3), _location(3, 3));
+    osmium::builder::add_node(buffer1, _id(5), _version(3), _deleted());
+    osmium::builder::add_node(buffer1, _id(20001), _version(1), _location(4, 4));
+    osmium::builder::add_way(buffer1, _id(2), _version(2), _deleted());
+    write_file(osmium::io::File{filename1}, std::move(buffer1));
+
+    osmium::memory::Buffer buffer2{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer2, _id(3), _version(4), _location(5, 5));
+    osmium::builder::add_node(buffer2, _id(6), _version(3), _deleted());
+    osmium::builder::add_node(buffer2, _id(20002), _version(1), _location(6, 6));
+    osmium::builder::add_way(buffer2, _id(4), _version(1), _nodes({1, 3}));
+    write_file(osmium::io::File{filename2}, std::move(buffer2));
+}
+
+struct object_info {
+    osmium::item_type type;
+    osmium::object_id_type id;
+    osmium::object_version_type version;
+};
+
+static std::vector<object_info> read_objects(const std::string& filename) {
+    std::vector<object_info> objects;
+    osmium::io::Reader reader{filename};
+    while (const osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            objects.push_back(object_info{object.type(), object.id(), object.version()});
+        }
+    }
+    reader.close();
+    return objects;
+}
+
+static void check_result(const std::vector<object_info>& objects, int count) {
+    REQUIRE(objects.size() == static_cast<std::size_t>(count) + 3);
+
+    int expected_id = 1;
+    for (int n = 0; n < count - 2; ++n) {
+        if (expected_id == 5) {
+            expected_id = 7;
+        }
+        REQUIRE(objects[n].type == osmium::item_type::node);
+        REQUIRE(objects[n].id == expected_id);
+        REQUIRE(objects[n].version == (expected_id == 3 ? 4 : 2));
+        ++expected_id;
+    }
+    REQUIRE(objects[count - 2].id == 20001);
+    REQUIRE(objects[count - 1].id == 20002);
+    REQUIRE(objects[count].type == osmium::item_type::way);
+    REQUIRE(objects[count].id == 1);
+    REQUIRE(objects[count + 1].id == 3);
+    REQUIRE(objects[count + 2].id == 4);
+}
+
+TEST_CASE("Apply changes to OPL file") {
+    write_file(osmium::io::File{"test-apply-changes-base.opl"}, create_base(100));
+    write_changes("test-apply-changes-1.osc", "test-apply-changes-2.opl");
+
+    const std::vector<osmium::io::File> changes{osmium::io::File{"test-apply-changes-1.osc"},
+                                                osmium::io::File{"test-apply-changes-2.opl"}};
+    osmium::io::Writer writer{"test-apply-changes-out.opl", osmium::io::overwrite::allow};
+    const auto stats = osmium::io::apply_changes(osmium::io::File{"test-apply-changes-base.opl"}, changes, writer);
+    writer.close();
+
+    REQUIRE(stats.blobs_copied == 0);
+    REQUIRE(stats.objects_changed == 4);
+    REQUIRE(stats.objects_deleted == 3);
+
+    check_result(read_objects("test-apply-changes-out.opl"), 100);
+}
+
+TEST_CASE("Apply changes to PBF file with blob index") {
+    const std::string base{"test-apply-changes-base.osm.pbf"};
+    write_file(osmium::io::File{base, "pbf,pbf_index_sidecar=" + base + ".idx"}, create_base(20000));
+    write_changes("test-apply-changes-pbf-1.osc", "test-apply-changes-pbf-2.osc");
+
+    const auto index = osmium::io::PBFBlobIndex::read(base + ".idx");
+    REQUIRE(index.size() == 4);
+
+    const std::vector<osmium::io::File> changes{osmium::io::File{"test-apply-changes-pbf-1.osc"},
+                                                osmium::io::File{"test-apply-changes-pbf-2.osc"}};
+
+    SECTION("copy blobs without changes") {
+        osmium::io::Writer writer{"test-apply-changes-out.osm.pbf", osmium::io::overwrite::allow};
+        const auto stats = osmium::io::apply_changes(osmium::io::File{base}, index, changes, writer);
+        writer.close();
+
+        REQUIRE(stats.blobs_copied == 2);
+        REQUIRE(stats.blobs_decoded == 2);
+        REQUIRE(stats.objects_changed == 4);
+        REQUIRE(stats.objects_deleted == 3);
+
+        check_result(read_objects("test-apply-changes-out.osm.pbf"), 20000);
+    }
+
+    SECTION("decode all blobs if writer can't copy them") {
+        osmium::io::Writer writer{"test-apply-changes-out.opl", osmium::io::overwrite::allow};
+        const auto stats = osmium::io::apply_changes(osmium::io::File{base}, index, changes, writer);
+        writer.close();
+
+        REQUIRE(stats.blobs_copied == 0);
+        REQUIRE(stats.blobs_decoded == 4);
+
+        check_result(read_objects("test-apply-changes-out.opl"), 20000);
+    }
+}
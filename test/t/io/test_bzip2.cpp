@@ -4,6 +4,7 @@
 
 #include <osmium/io/bzip2_compression.hpp>
 #include <osmium/io/detail/read_write.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <string>
 
@@ -134,3 +135,127 @@ TEST_CASE("Write bzip2-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+TEST_CASE("Write bzip2-compressed file in parallel and read it back") {
+    const int count = count_fds();
+
+    const std::string output_file = "test_bzip2_parallel_out.txt.bz2";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::string expected;
+    {
+        osmium::thread::Pool pool{2};
+        osmium::io::ParallelBzip2Compressor comp{fd, osmium::io::fsync::no, pool};
+        for (int i = 0; i < 200000; ++i) {
+            const std::string line = "line " + std::to_string(i) + "\n";
+            expected += line;
+            comp.write(line);
+        }
+        comp.close();
+    }
+    REQUIRE(count == count_fds());
+    REQUIRE(expected.size() > 2 * osmium::io::ParallelBzip2Compressor::chunk_size);
+
+    const int rfd = osmium::io::detail::open_for_reading(output_file);
+    REQUIRE(rfd > 0);
+
+    std::string all;
+    {
+        osmium::io::Bzip2Decompressor decomp{rfd};
+        for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+            all += data;
+        }
+        decomp.close();
+    }
+    REQUIRE(all == expected);
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write empty bzip2-compressed file in parallel") {
+    const std::string output_file = "test_bzip2_parallel_empty.txt.bz2";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::thread::Pool pool{1};
+        osmium::io::ParallelBzip2Compressor comp{fd, osmium::io::fsync::no, pool};
+    }
+
+    const int rfd = osmium::io::detail::open_for_reading(output_file);
+    osmium::io::Bzip2Decompressor decomp{rfd};
+    REQUIRE(decomp.read().empty());
+    decomp.close();
+}
+
+static std::string read_bzip2_in_parallel(const std::string& filename) {
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    REQUIRE(fd > 0);
+
+    osmium::thread::Pool pool{2};
+    osmium::io::ParallelBzip2Decompressor decomp{fd, pool};
+    std::string all;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+    return all;
+}
+
+TEST_CASE("Read bzip2-compressed file in parallel") {
+    const int count = count_fds();
+
+    std::string all = read_bzip2_in_parallel(with_data_dir("t/io/data_bzip2.txt.bz2"));
+    REQUIRE(all.size() >= 9);
+    all.resize(8);
+    REQUIRE("TESTDATA" == all);
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Read multi-stream bzip2-compressed file in parallel") {
+    const std::string output_file = "test_bzip2_parallel_in.txt.bz2";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::string expected;
+    {
+        osmium::thread::Pool pool{2};
+        osmium::io::ParallelBzip2Compressor comp{fd, osmium::io::fsync::no, pool};
+        for (int i = 0; i < 500000; ++i) {
+            const std::string line = "line " + std::to_string(i) + "\n";
+            expected += line;
+            comp.write(line);
+        }
+    }
+
+    REQUIRE(read_bzip2_in_parallel(output_file) == expected);
+}
+
+TEST_CASE("Read large single-stream bzip2-compressed file in parallel") {
+    const std::string output_file = "test_bzip2_parallel_single.txt.bz2";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    // Data that doesn't compress well so that the file is larger than
+    // the segments used for decompressing.
+    std::string expected;
+    {
+        osmium::io::Bzip2Compressor comp{fd, osmium::io::fsync::no};
+        uint32_t value = 1;
+        for (int i = 0; i < 500000; ++i) {
+            value = value * 1103515245U + 12345U;
+            const std::string line = std::to_string(value) + "\n";
+            expected += line;
+            comp.write(line);
+        }
+    }
+    REQUIRE(osmium::file_size(output_file) > 2 * osmium::io::ParallelBzip2Decompressor::segment_size);
+
+    REQUIRE(read_bzip2_in_parallel(output_file) == expected);
+}
+
+TEST_CASE("Corrupted bzip2-compressed file read in parallel") {
+    REQUIRE_THROWS_AS(read_bzip2_in_parallel(with_data_dir("t/io/corrupt_data_bzip2.txt.bz2")), const osmium::bzip2_error&);
+}
@@ -0,0 +1,105 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/detect_file_type.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/file.hpp>
+
+#include <cstdio>
+#include <string>
+#include <system_error>
+
+static osmium::io::detected_file_type detect(const std::string& data) {
+    return osmium::io::detect_file_type(data.data(), data.size());
+}
+
+TEST_CASE("Detect file type from data") {
+    SECTION("empty") {
+        REQUIRE(detect("").format == osmium::io::file_format::unknown);
+        REQUIRE(detect("").compression == osmium::io::file_compression::none);
+    }
+
+    SECTION("gzip") {
+        const auto type = detect(std::string{"\x1f\x8b\x08\x00\x00\x00", 6});
+        REQUIRE(type.format == osmium::io::file_format::unknown);
+        REQUIRE(type.compression == osmium::io::file_compression::gzip);
+    }
+
+    SECTION("bzip2") {
+        REQUIRE(detect("BZh91AY&SY").compression == osmium::io::file_compression::bzip2);
+        REQUIRE(detect("BZhx").compression == osmium::io::file_compression::none);
+    }
+
+    SECTION("pbf") {
+        REQUIRE(detect(std::string{"\x00\x00\x00\x0d\x0a\x09OSMHeader\x18", 16}).format == osmium::io::file_format::pbf);
+        REQUIRE(detect(std::string{"\x00\x00\x00\x0d\x0a\x07OSMData\x18", 14}).format == osmium::io::file_format::pbf);
+        REQUIRE(detect(std::string{"\x00\x00\x00\x0d\x0a\x09OSMHeadr\x18", 16}).format == osmium::io::file_format::unknown);
+        REQUIRE(detect(std::string{"\xff\x00\x00\x0d\x0a\x09OSMHeader\x18", 16}).format == osmium::io::file_format::unknown);
+    }
+
+    SECTION("o5m") {
+        REQUIRE(detect("\xff\xe0\x04o5m2\xff").format == osmium::io::file_format::o5m);
+        REQUIRE(detect("\xff\xe0\x04o5c2\xff").format == osmium::io::file_format::o5m);
+    }
+
+    SECTION("osmbuf") {
+        REQUIRE(detect("OSMIUMBF\x01").format == osmium::io::file_format::osmbuf);
+    }
+
+    SECTION("xml") {
+        REQUIRE(detect("<?xml version='1.0' encoding='UTF-8'?>\n<osm>").format == osmium::io::file_format::xml);
+        REQUIRE(detect("\xef\xbb\xbf\n  <osm version=\"0.6\">").format == osmium::io::file_format::xml);
+        REQUIRE(detect("<osmChange version=\"0.6\">").format == osmium::io::file_format::xml);
+        REQUIRE(detect("<html>").format == osmium::io::file_format::unknown);
+    }
+
+    SECTION("opl") {
+        REQUIRE(detect("n1 v1 dV c1 t2014-01-01T00:00:00Z i1 ufoo T x1 y1\n").format == osmium::io::file_format::opl);
+        REQUIRE(detect("# comment\n\nw-12 v1 Nn1,n2\n").format == osmium::io::file_format::opl);
+        REQUIRE(detect("r17").format == osmium::io::file_format::opl);
+        REQUIRE(detect("c1\n").format == osmium::io::file_format::opl);
+        REQUIRE(detect("node 1").format == osmium::io::file_format::unknown);
+        REQUIRE(detect("n\n").format == osmium::io::file_format::unknown);
+        REQUIRE(detect("x1 v1").format == osmium::io::file_format::unknown);
+        REQUIRE(detect("# only a comment").format == osmium::io::file_format::unknown);
+    }
+}
+
+TEST_CASE("Detect file type of files") {
+    REQUIRE(osmium::io::detect_file_type(with_data_dir("t/io/data.osm")).format == osmium::io::file_format::xml);
+    REQUIRE(osmium::io::detect_file_type(with_data_dir("t/io/data.opl")).format == osmium::io::file_format::opl);
+    REQUIRE(osmium::io::detect_file_type(with_data_dir("t/io/data_pbf_version-1.osm.pbf")).format == osmium::io::file_format::pbf);
+    REQUIRE(osmium::io::detect_file_type(with_data_dir("t/io/data.osm.gz")).compression == osmium::io::file_compression::gzip);
+    REQUIRE(osmium::io::detect_file_type(with_data_dir("t/io/data.osm.bz2")).compression == osmium::io::file_compression::bzip2);
+    REQUIRE(osmium::io::detect_file_type(with_data_dir("t/io/empty_file")).format == osmium::io::file_format::unknown);
+    REQUIRE_THROWS_AS(osmium::io::detect_file_type(with_data_dir("t/io/does-not-exist")), const std::system_error&);
+}
+
+TEST_CASE("Set file type of File with wrong suffix from content") {
+    const std::string filename{"test_detect_file_type.osm"};
+    {
+        const std::string data{"n1 v1 x1 y1\n"};
+        const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+        osmium::io::detail::reliable_write(fd, data.data(), data.size());
+        osmium::io::detail::reliable_close(fd);
+    }
+
+    osmium::io::File file{filename};
+    REQUIRE(file.format() == osmium::io::file_format::xml);
+    REQUIRE(osmium::io::set_file_type_from_content(file));
+    REQUIRE(file.format() == osmium::io::file_format::opl);
+
+    osmium::io::File gzfile{with_data_dir("t/io/data.osm.gz"), "osm"};
+    REQUIRE(gzfile.compression() == osmium::io::file_compression::none);
+    REQUIRE(osmium::io::set_file_type_from_content(gzfile));
+    REQUIRE(gzfile.format() == osmium::io::file_format::xml);
+    REQUIRE(gzfile.compression() == osmium::io::file_compression::gzip);
+
+    const std::string buffer{"<?xml version='1.0'?>"};
+    osmium::io::File bufferfile{buffer.data(), buffer.size(), "opl"};
+    REQUIRE(osmium::io::set_file_type_from_content(bufferfile));
+    REQUIRE(bufferfile.format() == osmium::io::file_format::xml);
+
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,124 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/external_sorter.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/object_pointer_collection.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+#include <osmium/visitor.hpp>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::vector<osmium::memory::Buffer> create_buffers(int num_buffers) {
+    std::vector<osmium::memory::Buffer> buffers;
+    uint32_t state = 42;
+    const auto next = [&state]() {
+        state = state * 1103515245U + 12345U;
+        return state >> 8U;
+    };
+
+    for (int n = 0; n < num_buffers; ++n) {
+        buffers.emplace_back(16 * 1024, osmium::memory::Buffer::auto_grow::yes);
+        auto& buffer = buffers.back();
+        for (int i = 0; i < 200; ++i) {
+            const auto id = static_cast<osmium::object_id_type>(next() % 5000);
+            const auto version = next() % 10 + 1;
+            if (next() % 2) {
+                osmium::builder::add_node(buffer, _id(id), _version(version), _location(1.0, 2.0), _tag("n", std::to_string(i)));
+            } else {
+                osmium::builder::add_way(buffer, _id(id), _version(version), _nodes({1, 2, 3}));
+            }
+        }
+    }
+
+    return buffers;
+}
+
+struct collect_ids {
+
+    std::vector<std::pair<osmium::object_id_type, osmium::object_version_type>>* ids;
+    std::size_t* num_buffers;
+
+    void operator()(osmium::memory::Buffer&& buffer) const {
+        ++*num_buffers;
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids->emplace_back(object.type() == osmium::item_type::node ? object.id() : -object.id(), object.version());
+        }
+    }
+
+}; // struct collect_ids
+
+static std::vector<std::pair<osmium::object_id_type, osmium::object_version_type>> sort_in_memory() {
+    auto buffers = create_buffers(50);
+    osmium::ObjectPointerCollection collection;
+    for (auto& buffer : buffers) {
+        osmium::apply(buffer, collection);
+    }
+    collection.sort(osmium::object_order_type_id_version{});
+
+    std::vector<std::pair<osmium::object_id_type, osmium::object_version_type>> ids;
+    for (const auto& object : collection) {
+        ids.emplace_back(object.type() == osmium::item_type::node ? object.id() : -object.id(), object.version());
+    }
+    return ids;
+}
+
+TEST_CASE("External sorter with everything in memory") {
+    osmium::io::ExternalSorter<> sorter{1024UL * 1024UL * 1024UL};
+    for (auto& buffer : create_buffers(50)) {
+        sorter(std::move(buffer));
+    }
+    REQUIRE(sorter.num_runs() == 0);
+
+    std::vector<std::pair<osmium::object_id_type, osmium::object_version_type>> ids;
+    std::size_t num_buffers = 0;
+    sorter.output(collect_ids{&ids, &num_buffers});
+
+    REQUIRE(ids.size() == 50 * 200);
+    REQUIRE(ids == sort_in_memory());
+    REQUIRE(sorter.memory_used() == 0);
+}
+
+TEST_CASE("External sorter with runs on disk") {
+    osmium::io::ExternalSorter<> sorter{100UL * 1024UL, osmium::object_order_type_id_version{}, "", 4096};
+    for (auto& buffer : create_buffers(50)) {
+        sorter(std::move(buffer));
+    }
+    REQUIRE(sorter.num_runs() > 5);
+
+    std::vector<std::pair<osmium::object_id_type, osmium::object_version_type>> ids;
+    std::size_t num_buffers = 0;
+    sorter.output(collect_ids{&ids, &num_buffers});
+
+    REQUIRE(num_buffers > 10);
+    REQUIRE(sorter.num_runs() == 0);
+    REQUIRE(ids.size() == 50 * 200);
+    REQUIRE(ids == sort_in_memory());
+}
+
+TEST_CASE("External sorter with temporary directory and reverse order") {
+    osmium::io::ExternalSorter<osmium::object_order_type_id_reverse_version> sorter{64UL * 1024UL, osmium::object_order_type_id_reverse_version{}, "."};
+    for (auto& buffer : create_buffers(20)) {
+        sorter(std::move(buffer));
+    }
+    REQUIRE(sorter.num_runs() > 1);
+
+    std::size_t count = 0;
+    std::vector<osmium::memory::Buffer> output;
+    sorter.output([&](osmium::memory::Buffer&& buffer) {
+        output.push_back(std::move(buffer));
+    });
+
+    osmium::ObjectPointerCollection collection;
+    for (auto& buffer : output) {
+        osmium::apply(buffer, collection);
+        count += std::distance(buffer.begin(), buffer.end());
+    }
+    REQUIRE(count == 20 * 200);
+    REQUIRE(std::is_sorted(collection.cbegin(), collection.cend(), osmium::object_order_type_id_reverse_version{}));
+}
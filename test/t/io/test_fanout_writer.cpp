@@ -0,0 +1,106 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/fanout_writer.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/tags/taglist.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer get_buffer(osmium::object_id_type first, osmium::object_id_type last) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = first; id <= last; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _location(id * 0.1, 1.0), _tag("amenity", id % 3 ? "bench" : "restaurant"));
+    }
+    return buffer;
+}
+
+static std::vector<osmium::object_id_type> read_ids(const std::string& filename) {
+    std::vector<osmium::object_id_type> ids;
+    osmium::io::Reader reader{filename};
+    while (const osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids.push_back(object.id());
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+TEST_CASE("Fanout writer writes filtered outputs") {
+    osmium::thread::Pool pool{2};
+    osmium::TagsFilter restaurants{false};
+    restaurants.add_rule(true, "amenity", "restaurant");
+
+    std::size_t max_memory = osmium::io::FanoutWriter::default_max_memory;
+    SECTION("default memory limit") {
+    }
+    SECTION("only one buffer at a time") {
+        max_memory = 1;
+    }
+
+    {
+        osmium::io::FanoutWriter fanout{osmium::io::Header{}, pool, max_memory};
+        REQUIRE(fanout.size() == 0);
+
+        REQUIRE(fanout.add(osmium::io::File{"test-fanout-all.opl"}, osmium::io::FanoutWriter::filter_type{}, osmium::io::overwrite::allow) == 0);
+        REQUIRE(fanout.add(osmium::io::File{"test-fanout-restaurants.opl"}, [&restaurants](const osmium::OSMObject& object) {
+            return osmium::tags::match_any_of(object.tags(), restaurants);
+        }, osmium::io::overwrite::allow) == 1);
+        REQUIRE(fanout.add(osmium::io::File{"test-fanout-east.opl"}, [](const osmium::OSMObject& object) {
+            return static_cast<const osmium::Node&>(object).location().lon() > 2.0;
+        }, osmium::io::overwrite::allow) == 2);
+        REQUIRE(fanout.add(osmium::io::File{"test-fanout-none.opl"}, [](const osmium::OSMObject& /*object*/) {
+            return false;
+        }, osmium::io::overwrite::allow) == 3);
+        REQUIRE(fanout.size() == 4);
+
+        for (osmium::object_id_type id = 1; id <= 30; id += 10) {
+            fanout(get_buffer(id, id + 9));
+        }
+        fanout(osmium::memory::Buffer{});
+        fanout.close();
+    }
+
+    std::vector<osmium::object_id_type> all;
+    std::vector<osmium::object_id_type> restaurant_ids;
+    std::vector<osmium::object_id_type> east;
+    for (osmium::object_id_type id = 1; id <= 30; ++id) {
+        all.push_back(id);
+        if (id % 3 == 0) {
+            restaurant_ids.push_back(id);
+        }
+        if (id > 20) {
+            east.push_back(id);
+        }
+    }
+
+    REQUIRE(read_ids("test-fanout-all.opl") == all);
+    REQUIRE(read_ids("test-fanout-restaurants.opl") == restaurant_ids);
+    REQUIRE(read_ids("test-fanout-east.opl") == east);
+    REQUIRE(read_ids("test-fanout-none.opl").empty());
+}
+
+TEST_CASE("Fanout writer releases input buffers") {
+    osmium::thread::Pool pool{1};
+    osmium::io::FanoutWriter fanout{osmium::io::Header{}, pool, 1};
+    fanout.add(osmium::io::File{"test-fanout-release.opl"}, osmium::io::FanoutWriter::filter_type{}, osmium::io::overwrite::allow);
+
+    for (osmium::object_id_type id = 1; id <= 100; id += 10) {
+        fanout(get_buffer(id, id + 9));
+        REQUIRE(fanout.memory_in_use() <= 1024);
+    }
+    fanout.close();
+
+    REQUIRE(read_ids("test-fanout-release.opl").size() == 100);
+}
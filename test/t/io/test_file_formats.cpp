@@ -190,6 +190,21 @@ TEST_CASE("Override file format by suffix 'osh.opl.gz'") {
     f.check();
 }
 
+TEST_CASE("File format by suffix 'osmbuf'") {
+    const osmium::io::File f{"test.osmbuf"};
+    REQUIRE(osmium::io::file_format::osmbuf == f.format());
+    REQUIRE(osmium::io::file_compression::none == f.compression());
+    REQUIRE_FALSE(f.has_multiple_object_versions());
+    f.check();
+}
+
+TEST_CASE("Override file format by suffix 'osmbuf.gz'") {
+    const osmium::io::File f{"test", "osmbuf.gz"};
+    REQUIRE(osmium::io::file_format::osmbuf == f.format());
+    REQUIRE(osmium::io::file_compression::gzip == f.compression());
+    f.check();
+}
+
 TEST_CASE("File format by suffix 'blackhole'") {
     const osmium::io::File f{"test.blackhole"};
     REQUIRE(osmium::io::file_format::blackhole == f.format());
@@ -0,0 +1,118 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/file_metadata.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/crc32c.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Writer writes metadata sidecar file on close") {
+    const std::string filename{"test-file-metadata.opl"};
+    const std::string metadata_filename{"test-file-metadata.opl.meta"};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(3), _location(1.5, 2.0));
+    osmium::builder::add_node(buffer, _id(-2), _location(-1.0, 3.25));
+    osmium::builder::add_node(buffer, _id(10));
+    osmium::builder::add_way(buffer, _id(20), _nodes({3, 10}));
+    osmium::builder::add_way(buffer, _id(21), _nodes({3, 10}));
+
+    osmium::io::Header header;
+    header.set("generator", "test");
+    header.set("osmosis_replication_sequence_number", "1234");
+    header.set("multi", "line 1\nline 2 \\ backslash");
+    header.add_box(osmium::Box{-1.0, 2.0, 1.5, 3.25});
+
+    osmium::io::Writer writer{osmium::io::File{filename, "opl,metadata_sidecar=" + metadata_filename}, header, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    REQUIRE_FALSE(writer.write_raw(std::string{"n1\n"}, osmium::io::file_format::opl));
+    writer.close();
+
+    const auto metadata = osmium::io::FileMetadata::read(metadata_filename);
+
+    REQUIRE(metadata.header().get("generator") == "test");
+    REQUIRE(metadata.header().get("osmosis_replication_sequence_number") == "1234");
+    REQUIRE(metadata.header().get("multi") == "line 1\nline 2 \\ backslash");
+    REQUIRE(metadata.header().boxes().size() == 1);
+    REQUIRE(metadata.header().boxes().front() == (osmium::Box{-1.0, 2.0, 1.5, 3.25}));
+    REQUIRE_FALSE(metadata.header().has_multiple_object_versions());
+
+    REQUIRE(metadata.summary(osmium::item_type::node).count == 3);
+    REQUIRE(metadata.summary(osmium::item_type::node).min_id == -2);
+    REQUIRE(metadata.summary(osmium::item_type::node).max_id == 10);
+    REQUIRE(metadata.summary(osmium::item_type::way).count == 2);
+    REQUIRE(metadata.summary(osmium::item_type::way).min_id == 20);
+    REQUIRE(metadata.summary(osmium::item_type::way).max_id == 21);
+    REQUIRE(metadata.summary(osmium::item_type::relation).count == 0);
+
+    REQUIRE(metadata.bbox() == (osmium::Box{-1.0, 2.0, 1.5, 3.25}));
+
+    const std::string data{read_file(filename)};
+    osmium::CRC32C crc;
+    crc.process_bytes(data.data(), data.size());
+    REQUIRE(metadata.file_size() == data.size());
+    REQUIRE(metadata.crc32c() == crc.checksum());
+}
+
+TEST_CASE("Metadata of empty file") {
+    const std::string filename{"test-file-metadata-empty.opl"};
+    const std::string metadata_filename{"test-file-metadata-empty.opl.meta"};
+
+    osmium::io::Writer writer{osmium::io::File{filename, "opl,metadata_sidecar=" + metadata_filename}, osmium::io::overwrite::allow};
+    writer.close();
+
+    const auto metadata = osmium::io::FileMetadata::read(metadata_filename);
+    REQUIRE(metadata.file_size() == 0);
+    REQUIRE(metadata.summary(osmium::item_type::node).count == 0);
+    REQUIRE_FALSE(metadata.bbox());
+    REQUIRE(metadata.header().get("generator").substr(0, 10) == "libosmium/");
+}
+
+TEST_CASE("Metadata sidecar can not be used when writing to stdout") {
+    REQUIRE_THROWS_AS(osmium::io::Writer(osmium::io::File{"-", "opl,metadata_sidecar=test-file-metadata-stdout.meta"}), const std::invalid_argument&);
+}
+
+TEST_CASE("Reading invalid metadata file") {
+    const std::string filename{"test-file-metadata-invalid.meta"};
+
+    SECTION("wrong magic") {
+        std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+        out << "something else\n";
+    }
+
+    SECTION("line without equal sign") {
+        std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+        out << "osmium_file_metadata=1\nfoo\n";
+    }
+
+    SECTION("invalid number") {
+        std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+        out << "osmium_file_metadata=1\nnode=1,x,3\n";
+    }
+
+    REQUIRE_THROWS_AS(osmium::io::FileMetadata::read(filename), const osmium::io_error&);
+}
+
+TEST_CASE("Unknown keys in metadata file are ignored") {
+    const std::string filename{"test-file-metadata-unknown.meta"};
+    {
+        std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+        out << "osmium_file_metadata=1\nfile_size=17\nsomething_new=value\n";
+    }
+
+    const auto metadata = osmium::io::FileMetadata::read(filename);
+    REQUIRE(metadata.file_size() == 17);
+}
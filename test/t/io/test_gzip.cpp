@@ -4,6 +4,7 @@
 
 #include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/gzip_compression.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <string>
 
@@ -135,3 +136,127 @@ TEST_CASE("Write gzip-compressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) > 10);
 }
 
+
+TEST_CASE("Write gzip-compressed file in parallel and read it back") {
+    const int count = count_fds();
+
+    const std::string output_file = "test_gzip_parallel_out.txt.gz";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::string expected;
+    {
+        osmium::thread::Pool pool{2};
+        osmium::io::ParallelGzipCompressor comp{fd, osmium::io::fsync::no, pool};
+        for (int i = 0; i < 200000; ++i) {
+            const std::string line = "line " + std::to_string(i) + "\n";
+            expected += line;
+            comp.write(line);
+        }
+        comp.close();
+    }
+    REQUIRE(count == count_fds());
+    REQUIRE(expected.size() > 2 * osmium::io::ParallelGzipCompressor::chunk_size);
+
+    const int rfd = osmium::io::detail::open_for_reading(output_file);
+    REQUIRE(rfd > 0);
+
+    std::string all;
+    {
+        osmium::io::GzipDecompressor decomp{rfd};
+        for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+            all += data;
+        }
+        decomp.close();
+    }
+    REQUIRE(all == expected);
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Write empty gzip-compressed file in parallel") {
+    const std::string output_file = "test_gzip_parallel_empty.txt.gz";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    {
+        osmium::thread::Pool pool{1};
+        osmium::io::ParallelGzipCompressor comp{fd, osmium::io::fsync::no, pool};
+    }
+
+    const int rfd = osmium::io::detail::open_for_reading(output_file);
+    osmium::io::GzipDecompressor decomp{rfd};
+    REQUIRE(decomp.read().empty());
+    decomp.close();
+}
+
+static std::string read_gzip_in_parallel(const std::string& filename) {
+    const int fd = osmium::io::detail::open_for_reading(filename);
+    REQUIRE(fd > 0);
+
+    osmium::thread::Pool pool{2};
+    osmium::io::ParallelGzipDecompressor decomp{fd, pool};
+    std::string all;
+    for (std::string data = decomp.read(); !data.empty(); data = decomp.read()) {
+        all += data;
+    }
+    decomp.close();
+    return all;
+}
+
+TEST_CASE("Read gzip-compressed file in parallel") {
+    const int count = count_fds();
+
+    std::string all = read_gzip_in_parallel(with_data_dir("t/io/data_gzip.txt.gz"));
+    REQUIRE(all.size() >= 9);
+    all.resize(8);
+    REQUIRE("TESTDATA" == all);
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Read multi-stream gzip-compressed file in parallel") {
+    const std::string output_file = "test_gzip_parallel_in.txt.gz";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::string expected;
+    {
+        osmium::thread::Pool pool{2};
+        osmium::io::ParallelGzipCompressor comp{fd, osmium::io::fsync::no, pool};
+        for (int i = 0; i < 500000; ++i) {
+            const std::string line = "line " + std::to_string(i) + "\n";
+            expected += line;
+            comp.write(line);
+        }
+    }
+
+    REQUIRE(read_gzip_in_parallel(output_file) == expected);
+}
+
+TEST_CASE("Read large single-stream gzip-compressed file in parallel") {
+    const std::string output_file = "test_gzip_parallel_single.txt.gz";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    // Data that doesn't compress well so that the file is larger than
+    // the segments used for decompressing.
+    std::string expected;
+    {
+        osmium::io::GzipCompressor comp{fd, osmium::io::fsync::no};
+        uint32_t value = 1;
+        for (int i = 0; i < 500000; ++i) {
+            value = value * 1103515245U + 12345U;
+            const std::string line = std::to_string(value) + "\n";
+            expected += line;
+            comp.write(line);
+        }
+    }
+    REQUIRE(osmium::file_size(output_file) > 2 * osmium::io::ParallelGzipDecompressor::segment_size);
+
+    REQUIRE(read_gzip_in_parallel(output_file) == expected);
+}
+
+TEST_CASE("Corrupted gzip-compressed file read in parallel") {
+    REQUIRE_THROWS_AS(read_gzip_in_parallel(with_data_dir("t/io/corrupt_data_gzip.txt.gz")), const osmium::gzip_error&);
+}
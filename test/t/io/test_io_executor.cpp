@@ -0,0 +1,177 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/io_executor.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer create_buffer(int first_id) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = first_id; id < first_id + 1000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _location(1.5, 2.5), _tag("name", "node"));
+    }
+    return buffer;
+}
+
+TEST_CASE("Many Readers and Writers sharing an IOExecutor") {
+    osmium::io::IOExecutor executor{2};
+    REQUIRE(executor.num_threads() == 2);
+
+    const int num_files = 12;
+    std::vector<std::string> filenames;
+    for (int n = 0; n < num_files; ++n) {
+        filenames.push_back("test-io-executor-" + std::to_string(n) + (n % 2 ? ".opl" : ".opl.gz"));
+    }
+
+    {
+        std::vector<std::unique_ptr<osmium::io::Writer>> writers;
+        for (const auto& filename : filenames) {
+            writers.emplace_back(new osmium::io::Writer{filename, osmium::io::overwrite::allow, executor});
+        }
+        REQUIRE(executor.num_stages() == num_files);
+        for (int i = 0; i < 20; ++i) {
+            for (auto& writer : writers) {
+                (*writer)(create_buffer(i * 1000 + 1));
+            }
+        }
+        for (auto& writer : writers) {
+            writer->close();
+        }
+    }
+    REQUIRE(executor.num_stages() == 0);
+
+    std::vector<std::unique_ptr<osmium::io::Reader>> readers;
+    for (const auto& filename : filenames) {
+        readers.emplace_back(new osmium::io::Reader{filename, executor});
+    }
+
+    std::vector<std::size_t> counts(num_files, 0);
+    std::vector<osmium::object_id_type> last_ids(num_files, 0);
+    bool in_order = true;
+    bool more = true;
+    while (more) {
+        more = false;
+        for (std::size_t n = 0; n < readers.size(); ++n) {
+            if (readers[n]->eof()) {
+                continue;
+            }
+            const osmium::memory::Buffer buffer = readers[n]->read();
+            if (!buffer) {
+                continue;
+            }
+            more = true;
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                if (node.id() != last_ids[n] + 1) {
+                    in_order = false;
+                }
+                last_ids[n] = node.id();
+                ++counts[n];
+            }
+        }
+    }
+
+    for (auto& reader : readers) {
+        reader->close();
+    }
+    readers.clear();
+
+    REQUIRE(in_order);
+    for (const auto count : counts) {
+        REQUIRE(count == 20000);
+    }
+    REQUIRE(executor.num_stages() == 0);
+}
+
+TEST_CASE("Reader on IOExecutor closed before end of file") {
+    osmium::io::IOExecutor executor{1};
+    const std::string filename = "test-io-executor-early-close.opl";
+
+    {
+        osmium::io::Writer writer{filename, osmium::io::overwrite::allow, executor};
+        for (int i = 0; i < 50; ++i) {
+            writer(create_buffer(i * 1000 + 1));
+        }
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename, executor};
+    REQUIRE(reader.read());
+    reader.close();
+    REQUIRE(executor.num_stages() == 0);
+}
+
+TEST_CASE("IOExecutor reuses task threads") {
+    osmium::io::IOExecutor executor{1};
+    REQUIRE(executor.num_task_threads() == 0);
+
+    std::atomic<int> count{0};
+    for (int i = 0; i < 5; ++i) {
+        auto handle = executor.run_task([&count]() {
+            ++count;
+        });
+        handle.wait();
+    }
+    REQUIRE(count == 5);
+    REQUIRE(executor.num_task_threads() == 1);
+
+    // Two tasks running at the same time need two threads.
+    std::promise<void> release;
+    std::shared_future<void> released{release.get_future().share()};
+    auto handle1 = executor.run_task([released]() {
+        released.wait();
+    });
+    auto handle2 = executor.run_task([released]() {
+        released.wait();
+    });
+    release.set_value();
+    handle1.wait();
+    handle2.wait();
+    REQUIRE(executor.num_task_threads() == 2);
+}
+
+TEST_CASE("Low latency reading of many small change files") {
+    osmium::io::IOExecutor executor{1, std::chrono::microseconds{50}};
+
+    const std::string data =
+        "<?xml version='1.0' encoding='UTF-8'?>\n"
+        "<osmChange version=\"0.6\" generator=\"test\">\n"
+        "  <create>\n"
+        "    <node id=\"1\" version=\"1\" lat=\"1.0\" lon=\"2.0\"/>\n"
+        "    <node id=\"2\" version=\"1\" lat=\"1.0\" lon=\"2.0\"/>\n"
+        "  </create>\n"
+        "  <modify>\n"
+        "    <way id=\"3\" version=\"2\"><nd ref=\"1\"/><nd ref=\"2\"/></way>\n"
+        "  </modify>\n"
+        "</osmChange>\n";
+
+    for (int n = 0; n < 5; ++n) {
+        const osmium::io::File file{data.data(), data.size(), "osc"};
+        osmium::io::Reader reader{file, executor, osmium::io::read_buffers{1024}.set_max_delay(std::chrono::microseconds{0})};
+        REQUIRE(reader.header().get("generator") == "test");
+        std::size_t buffers = 0;
+        while (auto buffer = reader.read()) {
+            REQUIRE(std::distance(buffer.begin(), buffer.end()) == 1);
+            ++buffers;
+        }
+        reader.close();
+        REQUIRE(buffers == 3);
+    }
+
+    REQUIRE(executor.num_task_threads() == 1);
+    REQUIRE(executor.num_stages() == 0);
+}
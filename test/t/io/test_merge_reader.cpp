@@ -0,0 +1,165 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/merge_reader.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/object_comparisons.hpp>
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string write_file(const std::string& name, osmium::memory::Buffer&& buffer) {
+    const std::string filename = "test-merge-reader-" + name + ".opl";
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+    return filename;
+}
+
+// Nodes with ids first, first + step, ... and one way with the same id.
+static std::string write_nodes(const std::string& name, int first, int step, int count, int version = 1) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int n = 0; n < count; ++n) {
+        osmium::builder::add_node(buffer, _id(first + n * step), _version(version), _location(1, 1));
+    }
+    osmium::builder::add_way(buffer, _id(first), _version(version), _nodes({1, 2}));
+    return write_file(name, std::move(buffer));
+}
+
+struct merge_result {
+    std::vector<std::pair<osmium::object_id_type, osmium::object_version_type>> nodes;
+    std::size_t ways = 0;
+    bool sorted = true;
+};
+
+static merge_result read_all(osmium::io::MergeReader& reader) {
+    merge_result result;
+    osmium::memory::Buffer last_buffer;
+    const osmium::OSMObject* last = nullptr;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (last && osmium::object_order_type_id_version{}(object, *last)) {
+                result.sorted = false;
+            }
+            if (object.type() == osmium::item_type::node) {
+                result.nodes.emplace_back(object.id(), object.version());
+            } else {
+                ++result.ways;
+            }
+            last = &object;
+        }
+        last_buffer = std::move(buffer);
+    }
+    return result;
+}
+
+TEST_CASE("Merge interleaved files with MergeReader") {
+    const std::vector<osmium::io::File> files = {
+        osmium::io::File{write_nodes("a", 1, 3, 20000)},
+        osmium::io::File{write_nodes("b", 2, 3, 20000)},
+        osmium::io::File{write_nodes("c", 3, 3, 20000)}
+    };
+
+    osmium::io::MergeReader reader{files, osmium::io::merge_duplicates::keep_all};
+    REQUIRE(reader.num_inputs() == 3);
+    REQUIRE_FALSE(reader.header().has_multiple_object_versions());
+
+    const auto result = read_all(reader);
+    REQUIRE(reader.eof());
+    REQUIRE(result.sorted);
+    REQUIRE(result.nodes.size() == 60000);
+    REQUIRE(result.nodes.front().first == 1);
+    REQUIRE(result.nodes.back().first == 60000);
+    REQUIRE(result.ways == 3);
+
+    REQUIRE_FALSE(reader.read());
+    reader.close();
+}
+
+TEST_CASE("Merge files with disjoint ranges with MergeReader") {
+    const std::vector<osmium::io::File> files = {
+        osmium::io::File{write_nodes("high", 100001, 1, 30000)},
+        osmium::io::File{write_nodes("empty", 1, 1, 0)},
+        osmium::io::File{write_nodes("low", 1, 1, 30000)}
+    };
+
+    osmium::io::MergeReader reader{files, osmium::io::merge_duplicates::keep_all};
+
+    const auto result = read_all(reader);
+    REQUIRE(result.sorted);
+    REQUIRE(result.nodes.size() == 60000);
+    REQUIRE(result.ways == 3);
+    reader.close();
+}
+
+TEST_CASE("Merge files with duplicates with MergeReader") {
+    const std::vector<osmium::io::File> files = {
+        osmium::io::File{write_nodes("v1", 1, 1, 1000, 1)},
+        osmium::io::File{write_nodes("v2", 1, 2, 1000, 2)},
+        osmium::io::File{write_nodes("v1copy", 1, 1, 1000, 1)}
+    };
+
+    SECTION("keep all") {
+        osmium::io::MergeReader reader{files, osmium::io::merge_duplicates::keep_all};
+        const auto result = read_all(reader);
+        REQUIRE(result.sorted);
+        REQUIRE(result.nodes.size() == 3000);
+        REQUIRE(result.ways == 3);
+    }
+
+    SECTION("unique versions") {
+        osmium::io::MergeReader reader{files, osmium::io::merge_duplicates::unique_versions};
+        const auto result = read_all(reader);
+        REQUIRE(result.sorted);
+        REQUIRE(result.nodes.size() == 2000);
+        REQUIRE(result.nodes[0] == std::make_pair(osmium::object_id_type{1}, osmium::object_version_type{1}));
+        REQUIRE(result.nodes[1] == std::make_pair(osmium::object_id_type{1}, osmium::object_version_type{2}));
+        REQUIRE(result.nodes[2] == std::make_pair(osmium::object_id_type{2}, osmium::object_version_type{1}));
+        REQUIRE(result.ways == 2);
+    }
+
+    SECTION("latest version") {
+        osmium::io::MergeReader reader{files, osmium::io::merge_duplicates::latest_version};
+        REQUIRE_FALSE(reader.header().has_multiple_object_versions());
+        const auto result = read_all(reader);
+        REQUIRE(result.sorted);
+        REQUIRE(result.nodes.size() == 1500);
+        REQUIRE(result.nodes[0] == std::make_pair(osmium::object_id_type{1}, osmium::object_version_type{2}));
+        REQUIRE(result.nodes[1] == std::make_pair(osmium::object_id_type{2}, osmium::object_version_type{1}));
+        REQUIRE(result.nodes[2] == std::make_pair(osmium::object_id_type{3}, osmium::object_version_type{2}));
+        REQUIRE(result.ways == 1);
+    }
+}
+
+TEST_CASE("MergeReader with opened readers and iterator") {
+    std::vector<std::unique_ptr<osmium::io::Reader>> readers;
+    readers.emplace_back(new osmium::io::Reader{write_nodes("r1", 1, 2, 100), osmium::osm_entity_bits::node});
+    readers.emplace_back(new osmium::io::Reader{write_nodes("r2", 2, 2, 100), osmium::osm_entity_bits::node});
+
+    osmium::io::MergeReader reader{std::move(readers)};
+
+    osmium::object_id_type id = 0;
+    osmium::io::InputIterator<osmium::io::MergeReader, osmium::OSMObject> it{reader};
+    const osmium::io::InputIterator<osmium::io::MergeReader, osmium::OSMObject> end{};
+    for (; it != end; ++it) {
+        REQUIRE(it->type() == osmium::item_type::node);
+        REQUIRE(it->id() == id + 1);
+        id = it->id();
+    }
+    REQUIRE(id == 200);
+}
+
+TEST_CASE("MergeReader without inputs") {
+    osmium::io::MergeReader reader{std::vector<osmium::io::File>{}, osmium::io::merge_duplicates::keep_all};
+    REQUIRE_FALSE(reader.read());
+    REQUIRE(reader.eof());
+    REQUIRE_THROWS_AS(reader.header(), const osmium::io_error&);
+}
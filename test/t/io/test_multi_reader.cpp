@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/multi_reader.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string write_file(int n, int count) {
+    const std::string filename = "test-multi-reader-" + std::to_string(n) + ".opl";
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= count; ++id) {
+        osmium::builder::add_node(buffer, _id(n * 100000 + id), _location(1, 1));
+        osmium::builder::add_way(buffer, _id(n * 100000 + id), _nodes({1, 2}));
+    }
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+    return filename;
+}
+
+TEST_CASE("Read several files with MultiReader") {
+    const std::vector<osmium::io::File> files = {
+        osmium::io::File{write_file(1, 1000)},
+        osmium::io::File{write_file(2, 0)},
+        osmium::io::File{write_file(3, 20000)},
+        osmium::io::File{write_file(4, 10)}
+    };
+
+    osmium::io::MultiReader reader{files};
+    REQUIRE(reader.num_files() == 4);
+    REQUIRE(reader.file_index() == 0);
+
+    std::vector<std::size_t> nodes_per_file(4, 0);
+    std::vector<std::size_t> first_buffers_per_file(4, 0);
+    bool ids_match_file = true;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        const auto index = reader.file_index();
+        REQUIRE(reader.file().filename() == files[index].filename());
+        if (reader.is_first_buffer_of_file()) {
+            ++first_buffers_per_file[index];
+        }
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            if (node.id() / 100000 != static_cast<osmium::object_id_type>(index + 1)) {
+                ids_match_file = false;
+            }
+            ++nodes_per_file[index];
+        }
+    }
+
+    REQUIRE(reader.eof());
+    REQUIRE(ids_match_file);
+    REQUIRE(nodes_per_file == (std::vector<std::size_t>{1000, 0, 20000, 10}));
+    REQUIRE(first_buffers_per_file == (std::vector<std::size_t>{1, 0, 1, 1}));
+    REQUIRE_THROWS_AS(reader.read(), const osmium::io_error&);
+    reader.close();
+}
+
+TEST_CASE("MultiReader with reader options") {
+    const std::vector<osmium::io::File> files = {
+        osmium::io::File{write_file(1, 100)},
+        osmium::io::File{write_file(2, 100)}
+    };
+
+    osmium::thread::Pool pool{2};
+    osmium::io::MultiReader reader{files, osmium::osm_entity_bits::way, pool};
+
+    std::size_t ways = 0;
+    for (auto it = osmium::io::begin(reader); it != osmium::io::end(reader); ++it) {
+        REQUIRE(it->type() == osmium::item_type::way);
+        ++ways;
+    }
+    REQUIRE(ways == 200);
+}
+
+TEST_CASE("MultiReader closed early") {
+    const std::vector<osmium::io::File> files = {
+        osmium::io::File{write_file(1, 1000)},
+        osmium::io::File{write_file(2, 1000)},
+        osmium::io::File{write_file(3, 1000)}
+    };
+
+    osmium::io::MultiReader reader{files};
+    REQUIRE(reader.read());
+    reader.close();
+    REQUIRE(reader.eof());
+}
+
+TEST_CASE("MultiReader with missing file") {
+    const std::vector<osmium::io::File> files = {
+        osmium::io::File{write_file(1, 10)},
+        osmium::io::File{"test-multi-reader-does-not-exist.opl"}
+    };
+
+    osmium::io::MultiReader reader{files};
+    REQUIRE(reader.read());
+    REQUIRE_THROWS_AS(reader.read(), const std::system_error&);
+}
+
+TEST_CASE("MultiReader without files") {
+    osmium::io::MultiReader reader{std::vector<osmium::io::File>{}};
+    REQUIRE_FALSE(reader.read());
+    REQUIRE(reader.eof());
+}
@@ -5,6 +5,7 @@
 #include <osmium/io/compression.hpp>
 
 #include <string>
+#include <vector>
 
 TEST_CASE("Invalid file descriptor of uncompressed file") {
     osmium::io::NoDecompressor decomp{-1};
@@ -123,3 +124,66 @@ TEST_CASE("Write uncompressed file with implicit close") {
     REQUIRE(osmium::file_size(output_file) == 3);
 }
 
+
+TEST_CASE("Write uncompressed file with gathered writes") {
+    const int count = count_fds();
+
+    const std::string output_file = "test_uncompressed_out_gathered.txt";
+    const int fd = osmium::io::detail::open_for_writing(output_file, osmium::io::overwrite::allow);
+    REQUIRE(fd > 0);
+
+    std::vector<std::string> data;
+    std::string expected;
+    for (int i = 0; i < 2000; ++i) {
+        data.push_back(std::to_string(i) + "\n");
+        expected += data.back();
+    }
+    data.emplace_back();
+
+    {
+        osmium::io::NoCompressor comp{fd, osmium::io::fsync::no};
+        comp.write("foo\n");
+        comp.write_all(data);
+        comp.close();
+    }
+    REQUIRE(count == count_fds());
+
+    REQUIRE(osmium::file_size(output_file) == expected.size() + 4);
+
+    const int rfd = osmium::io::detail::open_for_reading(output_file);
+    osmium::io::NoDecompressor decomp{rfd};
+    std::string all;
+    for (std::string str = decomp.read(); !str.empty(); str = decomp.read()) {
+        all += str;
+    }
+    decomp.close();
+    REQUIRE(all == "foo\n" + expected);
+}
+
+TEST_CASE("Read advisor on uncompressed file") {
+    const std::string input_file = with_data_dir("t/io/data.txt");
+    const int fd = osmium::io::detail::open_for_reading(input_file);
+    REQUIRE(fd > 0);
+
+    osmium::io::detail::read_advisor advisor{fd, 64 * 1024, true};
+    REQUIRE(advisor.active());
+    advisor.update(1000);
+    advisor.update(100 * 1024 * 1024);
+    advisor.finish();
+    REQUIRE_FALSE(advisor.active());
+
+    osmium::io::detail::reliable_close(fd);
+}
+
+#ifndef _WIN32
+TEST_CASE("Read advisor does nothing on pipes") {
+    int pipefd[2];
+    REQUIRE(::pipe(pipefd) == 0);
+
+    const osmium::io::detail::read_advisor advisor{pipefd[0], 64 * 1024, true};
+    REQUIRE_FALSE(advisor.active());
+
+    osmium::io::detail::reliable_close(pipefd[0]);
+    osmium::io::detail::reliable_close(pipefd[1]);
+}
+#endif
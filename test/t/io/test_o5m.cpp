@@ -0,0 +1,306 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/opl_output_format.hpp>
+#include <osmium/io/o5m_input.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string to_opl(osmium::memory::Buffer&& buffer) {
+    osmium::io::detail::opl_output_options options;
+    options.add_metadata = osmium::metadata_options{"all"};
+    return osmium::io::detail::OPLOutputBlock{std::move(buffer), options}();
+}
+
+static std::string read_as_opl(const std::string& filename, const osmium::io::decode_window& window = osmium::io::decode_window{}) {
+    std::string opl;
+    osmium::io::Reader reader{filename, window};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        opl += to_opl(std::move(buffer));
+    }
+    reader.close();
+    return opl;
+}
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+static osmium::memory::Buffer create_buffer(int first_id) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int id = first_id; id < first_id + 100; ++id) {
+        osmium::builder::add_node(buffer,
+            _id(id),
+            _version(id % 3 + 1),
+            _cid(1000 + id / 10),
+            _timestamp(osmium::Timestamp{1500000000 + id}),
+            _uid(id % 10),
+            _user(id % 10 ? "user" : ""),
+            _location(1.5 + id * 0.001, -2.5 - id * 0.001),
+            _tag("highway", id % 2 ? "primary" : "residential"),
+            _tag("name", std::string(id % 5 ? 10 : 300, 'x').c_str())
+        );
+    }
+
+    osmium::builder::add_way(buffer,
+        _id(-first_id),
+        _version(1),
+        _timestamp(osmium::Timestamp{1500000000}),
+        _uid(7),
+        _user("user"),
+        _nodes({first_id, first_id + 1, first_id + 1, first_id}),
+        _tag("highway", "primary")
+    );
+
+    osmium::builder::add_way(buffer, _id(first_id + 1));
+
+    osmium::builder::add_relation(buffer,
+        _id(first_id),
+        _version(2),
+        _timestamp(osmium::Timestamp{1500000001}),
+        _uid(8),
+        _user("user"),
+        _member(osmium::item_type::node, first_id, "stop"),
+        _member(osmium::item_type::way, -first_id, "stop"),
+        _member(osmium::item_type::way, first_id + 1, ""),
+        _member(osmium::item_type::relation, first_id + 2, "stop"),
+        _tag("type", "route")
+    );
+
+    return buffer;
+}
+
+TEST_CASE("Write and read o5m file") {
+    const std::string filename = "test-o5m-output.o5m";
+
+    osmium::io::Header header;
+    header.add_box(osmium::Box{1.5, -3.0, 2.5, 4.0});
+    header.set("timestamp", "2017-07-14T02:40:00Z");
+
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+    writer(create_buffer(1));
+    writer(create_buffer(1000));
+    writer.close();
+
+    const std::string data{read_file(filename)};
+    REQUIRE(data.substr(0, 7) == "\xff\xe0\x04o5m2");
+    REQUIRE(data.back() == '\xfe');
+
+    osmium::io::Reader reader{filename};
+    const auto& read_header = reader.header();
+    REQUIRE_FALSE(read_header.has_multiple_object_versions());
+    REQUIRE(read_header.boxes().size() == 1);
+    REQUIRE(read_header.box() == (osmium::Box{1.5, -3.0, 2.5, 4.0}));
+    REQUIRE(read_header.get("o5m_timestamp") == "2017-07-14T02:40:00Z");
+    reader.close();
+
+    REQUIRE(read_as_opl(filename) == to_opl(create_buffer(1)) + to_opl(create_buffer(1000)));
+}
+
+TEST_CASE("Write and read o5c file with deleted objects") {
+    const std::string filename = "test-o5m-output.o5c";
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _version(1), _timestamp(osmium::Timestamp{1}), _uid(1), _user("a"), _location(1, 1), _tag("a", "b"));
+    osmium::builder::add_node(buffer, _id(2), _version(2), _timestamp(osmium::Timestamp{2}), _uid(1), _user("a"), _deleted());
+    osmium::builder::add_way(buffer, _id(3), _version(3), _timestamp(osmium::Timestamp{3}), _uid(1), _user("a"), _deleted());
+    osmium::builder::add_relation(buffer, _id(4), _version(4), _timestamp(osmium::Timestamp{4}), _uid(1), _user("a"), _deleted());
+    const std::string expected{to_opl(osmium::memory::Buffer{buffer.data(), buffer.committed()})};
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(read_file(filename).substr(0, 7) == "\xff\xe0\x04o5c2");
+
+    osmium::io::Reader reader{filename};
+    REQUIRE(reader.header().has_multiple_object_versions());
+    reader.close();
+
+    REQUIRE(read_as_opl(filename) == expected);
+}
+
+TEST_CASE("Write o5m file without metadata") {
+    const std::string filename = "test-o5m-output-no-metadata.o5m";
+
+    osmium::io::Writer writer{osmium::io::File{filename, "o5m,add_metadata=false"}, osmium::io::overwrite::allow};
+    writer(create_buffer(1));
+    writer.close();
+
+    osmium::io::Reader reader{filename};
+    const osmium::memory::Buffer buffer = reader.read();
+    reader.close();
+    REQUIRE(buffer);
+
+    const auto& node = buffer.get<osmium::Node>(0);
+    REQUIRE(node.id() == 1);
+    REQUIRE(node.version() == 0);
+    REQUIRE(node.timestamp() == osmium::Timestamp{});
+    REQUIRE(node.tags().size() == 2);
+}
+
+TEST_CASE("Write o5m file with more strings than fit into the reference table") {
+    const std::string filename = "test-o5m-output-many-strings.o5m";
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= 40000; ++id) {
+        const auto value = std::to_string(id % 16000);
+        osmium::builder::add_node(buffer, _id(id), _location(1, 1), _tag("k", value));
+    }
+    const std::string expected{to_opl(osmium::memory::Buffer{buffer.data(), buffer.committed()})};
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(read_as_opl(filename) == expected);
+}
+
+TEST_CASE("Read only some object types from o5m file") {
+    const std::string filename = "test-o5m-output-types.o5m";
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(create_buffer(1));
+    writer.close();
+
+    osmium::io::Reader reader{filename, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation};
+    const osmium::memory::Buffer buffer = reader.read();
+    reader.close();
+    REQUIRE(buffer);
+
+    auto it = buffer.begin<osmium::OSMObject>();
+    const auto& way = static_cast<const osmium::Way&>(*it);
+    REQUIRE(way.id() == -1);
+    REQUIRE(way.nodes().size() == 4);
+    REQUIRE(way.nodes()[1].ref() == 2);
+    REQUIRE(std::string{way.tags()["highway"]} == "primary");
+
+    ++it;
+    ++it;
+    const auto& relation = static_cast<const osmium::Relation&>(*it);
+    REQUIRE(relation.id() == 1);
+    REQUIRE(relation.members().size() == 4);
+    REQUIRE(relation.members().begin()->ref() == 1);
+    REQUIRE(std::string{relation.members().begin()->role()} == "stop");
+}
+
+TEST_CASE("Read o5m file in thread pool and in parser thread") {
+    const std::string filename = "test-o5m-output-large.o5m";
+
+    std::string expected;
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    for (int n = 0; n < 300; ++n) {
+        expected += to_opl(create_buffer(n * 1000 + 1));
+        writer(create_buffer(n * 1000 + 1));
+    }
+    writer.close();
+
+    REQUIRE(read_file(filename).size() > 2 * osmium::io::detail::O5mParser::chunk_size);
+
+    REQUIRE(read_as_opl(filename, osmium::io::decode_window{0}) == expected);
+    REQUIRE(read_as_opl(filename, osmium::io::decode_window{}) == expected);
+    REQUIRE(read_as_opl(filename, osmium::io::decode_window{1}) == expected);
+}
+
+TEST_CASE("Read only some object types from large o5m file in thread pool") {
+    const std::string filename = "test-o5m-output-large-types.o5m";
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    for (int n = 0; n < 300; ++n) {
+        writer(create_buffer(n * 1000 + 1));
+    }
+    writer.close();
+
+    for (const auto window : {osmium::io::decode_window{0}, osmium::io::decode_window{}}) {
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation, window};
+        std::size_t ways = 0;
+        std::size_t relations = 0;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            ways += std::distance(buffer.select<osmium::Way>().begin(), buffer.select<osmium::Way>().end());
+            relations += std::distance(buffer.select<osmium::Relation>().begin(), buffer.select<osmium::Relation>().end());
+            REQUIRE(buffer.select<osmium::Node>().empty());
+        }
+        reader.close();
+        REQUIRE(ways == 600);
+        REQUIRE(relations == 300);
+    }
+}
+
+TEST_CASE("Read o5m file with long stretch without reset") {
+    const std::string filename = "test-o5m-output-no-reset.o5m";
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (int id = 1; id <= 60000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(id * 0.0001, 1), _tag("name", std::string(300, 'a' + id % 26).c_str()));
+    }
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2, 3}));
+    const std::string expected{to_opl(osmium::memory::Buffer{buffer.data(), buffer.committed()})};
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(read_file(filename).size() > osmium::io::detail::O5mParser::max_chunk_size);
+
+    REQUIRE(read_as_opl(filename) == expected);
+}
+
+TEST_CASE("Read o5m file with tag prefilter") {
+    const std::string filename = "test-o5m-output-prefilter.o5m";
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    for (int n = 0; n < 200; ++n) {
+        writer(create_buffer(n * 1000 + 1));
+    }
+    writer.close();
+
+    const osmium::io::tag_prefilter prefilter{[](const char* key, const char*) {
+        return !std::strcmp(key, "type");
+    }};
+
+    for (const auto window : {osmium::io::decode_window{0}, osmium::io::decode_window{}}) {
+        osmium::io::Reader reader{filename, prefilter, window};
+        std::size_t count = 0;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& object : buffer.select<osmium::OSMObject>()) {
+                REQUIRE(object.type() == osmium::item_type::relation);
+                ++count;
+            }
+        }
+        reader.close();
+        REQUIRE(count == 200);
+    }
+}
+
+TEST_CASE("Read o5m file into small buffers") {
+    const std::string filename = "test-o5m-output-read-buffers.o5m";
+
+    std::string expected;
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    for (int n = 0; n < 20; ++n) {
+        expected += to_opl(create_buffer(n * 1000 + 1));
+        writer(create_buffer(n * 1000 + 1));
+    }
+    writer.close();
+
+    const std::size_t size = 16UL * 1024UL;
+    std::string opl;
+    osmium::io::Reader reader{filename, osmium::io::decode_window{0}, osmium::io::read_buffers{size}};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        REQUIRE(buffer.capacity() == size);
+        opl += to_opl(std::move(buffer));
+    }
+    reader.close();
+
+    REQUIRE(opl == expected);
+}
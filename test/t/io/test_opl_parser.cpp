@@ -2,11 +2,17 @@
 
 #include "utils.hpp"
 
+#include <osmium/handler/node_locations_for_ways.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
 #include <osmium/io/detail/opl_input_format.hpp>
+#include <osmium/io/detail/read_write.hpp>
 #include <osmium/io/opl_input.hpp>
+#include <osmium/memory/buffer_pool.hpp>
 #include <osmium/opl.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
 #include <initializer_list>
 #include <string>
@@ -245,6 +251,56 @@ TEST_CASE("Parse OPL: parse string") {
 
 }
 
+TEST_CASE("Parse OPL: find special character in string") {
+    // Test all lengths and all alignments of the start of the string
+    // against the scalar version.
+    const std::string specials{"\t %,="};
+    std::string data(200, 'a');
+    for (std::size_t length = 0; length < 80; ++length) {
+        for (std::size_t offset = 0; offset < 32; ++offset) {
+            for (const char special : specials) {
+                std::string str(data, 0, offset + length);
+                str += special;
+                str += "aaaa";
+                const char* begin = str.c_str() + offset;
+                REQUIRE(oid::opl_find_string_special(begin) == begin + length);
+                REQUIRE(oid::opl_find_string_special_scalar(begin) == begin + length);
+            }
+            const std::string str(data, 0, offset + length);
+            const char* begin = str.c_str() + offset;
+            REQUIRE(oid::opl_find_string_special(begin) == begin + length);
+        }
+    }
+}
+
+TEST_CASE("Parse OPL: long strings with and without escapes") {
+    std::string result;
+    const std::string plain(1000, 'x');
+
+    SECTION("long plain string") {
+        const std::string input = plain + " rest";
+        const char* s = input.c_str();
+        oid::opl_parse_string(&s, result);
+        REQUIRE(result == plain);
+        REQUIRE(*s == ' ');
+    }
+
+    SECTION("long string with escapes") {
+        const std::string input = plain + "%20%" + plain + "%2c%" + plain + "=v";
+        const char* s = input.c_str();
+        oid::opl_parse_string(&s, result);
+        REQUIRE(result == plain + " " + plain + "," + plain);
+        REQUIRE(*s == '=');
+    }
+
+    SECTION("non-ASCII characters are copied") {
+        const char* s = "\xc3\xa4\xc3\xb6\xc3\xbc,";
+        oid::opl_parse_string(&s, result);
+        REQUIRE(result == "\xc3\xa4\xc3\xb6\xc3\xbc");
+        REQUIRE(*s == ',');
+    }
+}
+
 template <typename T = int64_t>
 T test_parse_int(const char* s) {
     const auto r = oid::opl_parse_int<T>(&s);
@@ -277,6 +333,21 @@ TEST_CASE("Parse OPL: integer") {
                         "OPL error: integer too long");
 }
 
+TEST_CASE("Parse OPL: integer length limit") {
+    REQUIRE(test_parse_int("999999999999999x") == 999999999999999);
+    REQUIRE(test_parse_int("-999999999999999x") == -999999999999999);
+
+    const char* s = "1234567890123456x";
+    try {
+        oid::opl_parse_int<int64_t>(&s);
+        REQUIRE(false);
+    } catch (const osmium::opl_error& e) {
+        REQUIRE(e.msg == "OPL error: integer too long");
+        REQUIRE(e.data == s);
+        REQUIRE(*s == '6');
+    }
+}
+
 TEST_CASE("Parse OPL: int32_t") {
     REQUIRE(test_parse_int<int32_t>("0x") == 0);
     REQUIRE(test_parse_int<int32_t>("123x") == 123);
@@ -1230,3 +1301,230 @@ TEST_CASE("line_by_line for OPL parser 28") {
     check_lbl({"foo\nb", "ar"}, {"foo", "bar"});
 }
 
+
+TEST_CASE("Count OPL lines") {
+    REQUIRE(oid::opl_count_lines("") == 0);
+    REQUIRE(oid::opl_count_lines("\n") == 0);
+    REQUIRE(oid::opl_count_lines("foo") == 1);
+    REQUIRE(oid::opl_count_lines("foo\n") == 1);
+    REQUIRE(oid::opl_count_lines("foo\r\nbar\r\n") == 2);
+    REQUIRE(oid::opl_count_lines("\nfoo\n\nbar") == 2);
+}
+
+static std::string write_large_opl_file(const std::string& filename, int error_line) {
+    std::string data;
+    for (int i = 1; i <= 100000; ++i) {
+        if (i == error_line) {
+            data += "x1\n";
+        } else {
+            data += "n" + std::to_string(i) + " v1 dV c1 t2014-01-01T00:00:00Z i1 ufoo T";
+            if (i % 10 == 0) {
+                data += "amenity=bench";
+            }
+            data += " x1.0 y1.0\n";
+        }
+    }
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+    return filename;
+}
+
+static std::vector<osmium::object_id_type> read_opl_ids(const std::string& filename, const osmium::io::decode_window& window) {
+    std::vector<osmium::object_id_type> ids;
+    osmium::io::Reader reader{filename, window};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids.push_back(object.id());
+        }
+    }
+    reader.close();
+    return ids;
+}
+
+TEST_CASE("Parse large OPL file in thread pool") {
+    const auto filename = write_large_opl_file("test-opl-parallel.opl", 0);
+    REQUIRE(osmium::file_size(filename) > 3 * oid::OPLParser::chunk_size);
+
+    const auto ids_serial = read_opl_ids(filename, osmium::io::decode_window{0});
+    const auto ids_parallel = read_opl_ids(filename, osmium::io::decode_window{});
+    REQUIRE(ids_serial.size() == 100000);
+    REQUIRE(ids_serial == ids_parallel);
+}
+
+TEST_CASE("Parse large OPL file in thread pool with prefilter") {
+    const auto filename = write_large_opl_file("test-opl-parallel-prefilter.opl", 0);
+
+    osmium::io::Reader reader{filename, osmium::io::decode_window{},
+                              osmium::io::tag_prefilter{[](const char* key, const char*) {
+                                  return !std::strcmp(key, "amenity");
+                              }}};
+    std::size_t count = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() % 10 == 0);
+            ++count;
+        }
+    }
+    reader.close();
+    REQUIRE(count == 10000);
+}
+
+TEST_CASE("Errors in large OPL file parsed in thread pool have correct line numbers") {
+    const auto filename = write_large_opl_file("test-opl-parallel-error.opl", 70000);
+
+    uint64_t line_serial = 0;
+    uint64_t line_parallel = 0;
+    try {
+        read_opl_ids(filename, osmium::io::decode_window{0});
+    } catch (const osmium::opl_error& e) {
+        line_serial = e.line;
+    }
+    try {
+        read_opl_ids(filename, osmium::io::decode_window{});
+    } catch (const osmium::opl_error& e) {
+        line_parallel = e.line;
+    }
+    REQUIRE(line_serial == 69999);
+    REQUIRE(line_parallel == line_serial);
+}
+
+TEST_CASE("Read large OPL file into buffers of given size from pool") {
+    const auto filename = write_large_opl_file("test-opl-read-buffers.opl", 0);
+    const std::size_t size = 64UL * 1024UL;
+
+    osmium::memory::BufferPool pool;
+    osmium::io::Reader reader{filename, osmium::io::decode_window{0}, osmium::io::read_buffers{pool, size}};
+    std::size_t count = 0;
+    std::size_t buffers = 0;
+    while (auto buffer = reader.read()) {
+        count += std::distance(buffer.begin(), buffer.end());
+        REQUIRE(buffer.capacity() == size);
+        ++buffers;
+        pool.release(std::move(buffer));
+    }
+    reader.close();
+
+    REQUIRE(count == 100000);
+    REQUIRE(buffers > 10);
+    REQUIRE(pool.size() > 0);
+}
+
+TEST_CASE("Read OPL file with maximum delay for buffers") {
+    const auto filename = write_large_opl_file("test-opl-max-delay.opl", 0);
+
+    SECTION("no delay sends each object in its own buffer") {
+        osmium::io::Reader reader{filename, osmium::io::decode_window{0}, osmium::io::read_buffers{1024}.set_max_delay(std::chrono::microseconds{0})};
+        std::size_t count = 0;
+        std::size_t buffers = 0;
+        while (auto buffer = reader.read()) {
+            REQUIRE(std::distance(buffer.begin(), buffer.end()) == 1);
+            ++count;
+            ++buffers;
+        }
+        reader.close();
+        REQUIRE(count == 100000);
+        REQUIRE(buffers == 100000);
+    }
+
+    SECTION("long delay only sends full buffers") {
+        const std::size_t size = 64UL * 1024UL;
+        osmium::io::Reader reader{filename, osmium::io::decode_window{0}, osmium::io::read_buffers{size}.set_max_delay(std::chrono::seconds{1000})};
+        std::size_t count = 0;
+        std::size_t buffers = 0;
+        while (auto buffer = reader.read()) {
+            count += std::distance(buffer.begin(), buffer.end());
+            ++buffers;
+        }
+        reader.close();
+        REQUIRE(count == 100000);
+        REQUIRE(buffers < 200);
+    }
+}
+
+TEST_CASE("Maximum delay of read_buffers") {
+    osmium::io::read_buffers buffers{1024};
+    REQUIRE(buffers.max_delay() == osmium::io::read_buffers::no_max_delay());
+    REQUIRE(buffers.start_time() == std::chrono::steady_clock::time_point{});
+
+    osmium::memory::Buffer buffer{buffers.get()};
+    osmium::opl_parse("n1", buffer);
+    REQUIRE_FALSE(buffers.is_full(buffer, std::chrono::steady_clock::time_point{}));
+
+    buffers.set_max_delay(std::chrono::milliseconds{10});
+    const auto started = buffers.start_time();
+    REQUIRE(started != std::chrono::steady_clock::time_point{});
+    REQUIRE_FALSE(buffers.is_full(buffer, started));
+    REQUIRE(buffers.is_full(buffer, started - std::chrono::milliseconds{10}));
+
+    osmium::memory::Buffer empty{buffers.get()};
+    REQUIRE_FALSE(buffers.is_full(empty, started - std::chrono::milliseconds{10}));
+}
+
+TEST_CASE("Apply buffer transform to large OPL file") {
+    const auto filename = write_large_opl_file("test-opl-transform.opl", 0);
+
+    for (const auto& window : {osmium::io::decode_window{0}, osmium::io::decode_window{}}) {
+        std::atomic<std::size_t> transformed{0};
+        osmium::io::Reader reader{filename, window, osmium::io::buffer_transform{[&transformed](osmium::memory::Buffer& buffer) {
+            for (auto& node : buffer.select<osmium::Node>()) {
+                node.set_version(2);
+                ++transformed;
+            }
+        }}};
+        std::size_t count = 0;
+        while (const auto buffer = reader.read()) {
+            for (const auto& node : buffer.select<osmium::Node>()) {
+                REQUIRE(node.version() == 2);
+                ++count;
+            }
+        }
+        reader.close();
+        REQUIRE(count == 100000);
+        REQUIRE(transformed == 100000);
+    }
+}
+
+TEST_CASE("Add node locations to ways in thread pool") {
+    using index_type = osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location>;
+    index_type index;
+    for (int i = 1; i <= 1000; ++i) {
+        index.set(static_cast<osmium::unsigned_object_id_type>(i), osmium::Location{i, -i});
+    }
+    index.sort();
+
+    std::string data;
+    for (int i = 1; i <= 100000; ++i) {
+        const int n = i % 998 + 1;
+        data += "w" + std::to_string(i) + " v1 dV c1 t2014-01-01T00:00:00Z i1 ufoo T Nn" +
+                std::to_string(n) + ",n" + std::to_string(n + 1) + ",n" + std::to_string(n + 2) + "\n";
+    }
+    const std::string filename{"test-opl-way-locations.opl"};
+    const int fd = osmium::io::detail::open_for_writing(filename, osmium::io::overwrite::allow);
+    osmium::io::detail::reliable_write(fd, data.data(), data.size());
+    osmium::io::detail::reliable_close(fd);
+
+    osmium::io::Reader reader{filename, osmium::io::decode_window{},
+                              osmium::io::buffer_transform{osmium::handler::NodeLocationsForWaysTransform<index_type>{index}}};
+    std::size_t count = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            for (const auto& node_ref : way.nodes()) {
+                REQUIRE(node_ref.location() == osmium::Location(static_cast<int32_t>(node_ref.ref()), static_cast<int32_t>(-node_ref.ref())));
+            }
+            ++count;
+        }
+    }
+    reader.close();
+    REQUIRE(count == 100000);
+}
+
+TEST_CASE("Errors in buffer transform are reported by the reader") {
+    const auto filename = write_large_opl_file("test-opl-transform-error.opl", 0);
+
+    osmium::io::Reader reader{filename, osmium::io::decode_window{}, osmium::io::buffer_transform{[](osmium::memory::Buffer& /*buffer*/) {
+        throw osmium::not_found{"test"};
+    }}};
+    REQUIRE_THROWS_AS(reader.read(), const osmium::not_found&);
+    reader.close();
+}
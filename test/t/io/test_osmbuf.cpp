@@ -0,0 +1,197 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/detail/opl_output_format.hpp>
+#include <osmium/io/osmbuf_input.hpp>
+#include <osmium/io/osmbuf_output.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string to_opl(const osmium::memory::Buffer& buffer) {
+    osmium::io::detail::opl_output_options options;
+    options.add_metadata = osmium::metadata_options{"all"};
+    return osmium::io::detail::OPLOutputBlock{osmium::memory::Buffer{buffer.data(), buffer.committed()}, options}();
+}
+
+template <typename... TArgs>
+static std::string read_as_opl(const std::string& filename, TArgs&&... args) {
+    std::string opl;
+    osmium::io::Reader reader{filename, std::forward<TArgs>(args)...};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        opl += to_opl(buffer);
+    }
+    reader.close();
+    return opl;
+}
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+static void write_file(const std::string& filename, const std::string& data) {
+    std::ofstream out{filename, std::ios::binary};
+    out << data;
+}
+
+static osmium::memory::Buffer create_buffer(int first_id) {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (int id = first_id; id < first_id + 100; ++id) {
+        osmium::builder::add_node(buffer,
+            _id(id),
+            _version(2),
+            _timestamp(osmium::Timestamp{1500000000 + id}),
+            _uid(id % 10),
+            _user("user"),
+            _location(1.5 + id * 0.001, -2.5 - id * 0.001),
+            _tag("highway", id % 2 ? "primary" : "residential")
+        );
+    }
+
+    osmium::builder::add_way(buffer,
+        _id(first_id),
+        _nodes({first_id, first_id + 1}),
+        _tag("highway", "primary")
+    );
+
+    osmium::builder::add_relation(buffer,
+        _id(first_id),
+        _member(osmium::item_type::way, first_id, "outer"),
+        _tag("type", "multipolygon")
+    );
+
+    return buffer;
+}
+
+static std::string write_test_file(const std::string& filename, int num_buffers) {
+    osmium::io::Header header;
+    header.add_box(osmium::Box{1.5, -3.0, 2.5, 4.0});
+    header.set("generator", "test");
+    header.set_has_multiple_object_versions(true);
+
+    std::string expected;
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+    for (int n = 0; n < num_buffers; ++n) {
+        auto buffer = create_buffer(n * 1000 + 1);
+        expected += to_opl(buffer);
+        writer(std::move(buffer));
+    }
+    writer.close();
+
+    return expected;
+}
+
+TEST_CASE("Write and read osmbuf file") {
+    const std::string filename = "test-osmbuf-output.osmbuf";
+    const std::string expected{write_test_file(filename, 20)};
+
+    const std::string data{read_file(filename)};
+    REQUIRE(data.substr(0, 8) == "OSMIUMBF");
+    REQUIRE(data.substr(data.size() - 8) == "OSMBFEND");
+
+    osmium::io::Reader reader{filename};
+    const auto& header = reader.header();
+    REQUIRE(header.has_multiple_object_versions());
+    REQUIRE(header.box() == (osmium::Box{1.5, -3.0, 2.5, 4.0}));
+    REQUIRE(header.get("generator") == "test");
+    reader.close();
+
+    SECTION("decode in thread pool") {
+        REQUIRE(read_as_opl(filename) == expected);
+    }
+
+    SECTION("decode in parser thread") {
+        REQUIRE(read_as_opl(filename, osmium::io::decode_window{0}) == expected);
+    }
+
+    SECTION("memory-mapped") {
+        REQUIRE(read_as_opl(filename, osmium::io::mmap_input::yes) == expected);
+    }
+
+    SECTION("memory-mapped and decode in parser thread") {
+        REQUIRE(read_as_opl(filename, osmium::io::mmap_input::yes, osmium::io::decode_window{0}) == expected);
+    }
+}
+
+TEST_CASE("Read only some entity types from osmbuf file") {
+    const std::string filename = "test-osmbuf-output-types.osmbuf";
+    write_test_file(filename, 3);
+
+    for (const auto mmap : {osmium::io::mmap_input::no, osmium::io::mmap_input::yes}) {
+        osmium::io::Reader reader{filename, osmium::osm_entity_bits::way, mmap};
+        int count = 0;
+        while (osmium::memory::Buffer buffer = reader.read()) {
+            for (const auto& item : buffer) {
+                REQUIRE(item.type() == osmium::item_type::way);
+                ++count;
+            }
+        }
+        reader.close();
+        REQUIRE(count == 3);
+    }
+}
+
+TEST_CASE("Read osmbuf file with tag prefilter") {
+    const std::string filename = "test-osmbuf-output-prefilter.osmbuf";
+    write_test_file(filename, 3);
+
+    const osmium::io::tag_prefilter prefilter{[](const char* key, const char* value) {
+        return !std::strcmp(key, "highway") && !std::strcmp(value, "primary");
+    }};
+
+    osmium::io::Reader reader{filename, prefilter};
+    int count = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        count += static_cast<int>(std::distance(buffer.begin(), buffer.end()));
+    }
+    reader.close();
+    REQUIRE(count == 3 * (50 + 1));
+}
+
+TEST_CASE("Read selected blocks from osmbuf file") {
+    const std::string filename = "test-osmbuf-output-selection.osmbuf";
+    write_test_file(filename, 3);
+
+    // find offset of the second block through the index
+    const std::string data{read_file(filename)};
+    const auto index_offset = osmium::io::detail::osmbuf_get_uint64(data.data() + data.size() - 16);
+    REQUIRE(osmium::io::detail::osmbuf_get_uint64(data.data() + index_offset + 8) == 3);
+    const auto offset = osmium::io::detail::osmbuf_get_uint64(data.data() + index_offset + 16 + 16);
+
+    const osmium::io::blob_selection selection{std::vector<std::size_t>{static_cast<std::size_t>(offset)}};
+    const std::string expected{to_opl(create_buffer(1001))};
+
+    REQUIRE(read_as_opl(filename, selection) == expected);
+    REQUIRE(read_as_opl(filename, selection, osmium::io::mmap_input::yes) == expected);
+}
+
+TEST_CASE("Reading broken osmbuf files fails") {
+    const std::string filename = "test-osmbuf-output-broken.osmbuf";
+    write_test_file(filename, 2);
+    std::string data{read_file(filename)};
+
+    SECTION("wrong magic") {
+        data[0] = 'X';
+    }
+
+    SECTION("corrupted data") {
+        data[data.size() / 2] ^= 0x01;
+    }
+
+    SECTION("truncated file") {
+        data.resize(data.size() - 100);
+    }
+
+    write_file(filename, data);
+    REQUIRE_THROWS_AS(read_as_opl(filename), const osmium::osmbuf_error&);
+    REQUIRE_THROWS_AS(read_as_opl(filename, osmium::io::mmap_input::yes), const osmium::osmbuf_error&);
+}
@@ -2,6 +2,7 @@
 
 #include <osmium/io/detail/string_util.hpp>
 
+#include <cstddef>
 #include <iterator>
 #include <locale>
 #include <stdexcept>
@@ -71,6 +72,12 @@ TEST_CASE("UTF8 encoding: encode characters that are special in OPL") {
     REQUIRE(out == "%20%%0a%%2c%%3d%%40%");
 }
 
+TEST_CASE("UTF8 encoding: runs of plain characters between encoded characters") {
+    std::string out{"x"};
+    osmium::io::detail::append_utf8_encoded_string(out, "abc def,ghi=jkl@m%n");
+    REQUIRE(out == "xabc%20%def%2c%ghi%3d%jkl%40%m%25%n");
+}
+
 // workaround for missing support for u8 string literals on Windows
 #if !defined(_MSC_VER)
 TEST_CASE("UTF8 encoding: encode multibyte character") {
@@ -94,6 +101,18 @@ TEST_CASE("html encoding encodes special XML characters") {
     REQUIRE(out == "&amp; &quot; &apos; &lt; &gt; &#xA; &#xD; &#x9;");
 }
 
+TEST_CASE("html encoding appends runs between special characters") {
+    std::string out{"x"};
+    osmium::io::detail::append_xml_encoded_string(out, u8"abc&def<\u30dc>'ghi\"");
+    REQUIRE(out == u8"xabc&amp;def&lt;\u30dc&gt;&apos;ghi&quot;");
+}
+
+TEST_CASE("html encoding of empty string") {
+    std::string out{"x"};
+    osmium::io::detail::append_xml_encoded_string(out, "");
+    REQUIRE(out == "x");
+}
+
 TEST_CASE("debug encoding does not encode normal characters") {
     const char* s = "abc123,.-";
     std::string out;
@@ -108,6 +127,12 @@ TEST_CASE("debug encoding encodes some unicode characters") {
     REQUIRE(out == "[<U+000A>]_[<U+30DC>]_[<U+1D11E>]_[<U+1F6EB>]");
 }
 
+TEST_CASE("debug encoding encodes quotes and angle brackets between plain runs") {
+    std::string out{"x"};
+    osmium::io::detail::append_debug_encoded_string(out, "a \"b\" <c>", "[", "]");
+    REQUIRE(out == "xa [<U+0022>]b[<U+0022>] [<U+003C>]c[<U+003E>]");
+}
+
 TEST_CASE("utf8 encoding of non-printable characters in the first 127 characters") {
     std::locale cloc{"C"};
     char s[] = "a\0";
@@ -210,3 +235,51 @@ TEST_CASE("incomplete Unicode codepoint") {
     }
 }
 
+
+TEST_CASE("encoding of long strings is the same as encoding each character") {
+    // Puts every ASCII character at every position in strings long
+    // enough to be checked in blocks.
+    for (int c = 1; c < 0x80; ++c) {
+        for (std::size_t pos = 0; pos < 40; ++pos) {
+            std::string str(40, 'x');
+            str[pos] = static_cast<char>(c);
+            str[39 - pos] = static_cast<char>(c);
+
+            std::string expected_utf8;
+            std::string expected_xml;
+            std::string expected_debug;
+            for (const char ch : str) {
+                const char single[2] = {ch, '\0'};
+                osmium::io::detail::append_utf8_encoded_string(expected_utf8, single);
+                osmium::io::detail::append_xml_encoded_string(expected_xml, single);
+                osmium::io::detail::append_debug_encoded_string(expected_debug, single, "[", "]");
+            }
+
+            std::string utf8;
+            std::string xml;
+            std::string debug;
+            osmium::io::detail::append_utf8_encoded_string(utf8, str.c_str());
+            osmium::io::detail::append_xml_encoded_string(xml, str.c_str());
+            osmium::io::detail::append_debug_encoded_string(debug, str.c_str(), "[", "]");
+            REQUIRE(utf8 == expected_utf8);
+            REQUIRE(xml == expected_xml);
+            REQUIRE(debug == expected_debug);
+        }
+    }
+}
+
+TEST_CASE("encoding of long strings with multibyte characters") {
+    const std::string str{u8"abcdefghijklmnopäbcdefghijklmnopq\U0001f680rstuvwxyzabcdefgä"};
+
+    std::string utf8;
+    osmium::io::detail::append_utf8_encoded_string(utf8, str.c_str());
+    REQUIRE(utf8 == u8"abcdefghijklmnopäbcdefghijklmnopq%1f680%rstuvwxyzabcdefgä");
+
+    std::string xml;
+    osmium::io::detail::append_xml_encoded_string(xml, str.c_str());
+    REQUIRE(xml == str);
+
+    std::string debug;
+    osmium::io::detail::append_debug_encoded_string(debug, str.c_str(), "[", "]");
+    REQUIRE(debug == u8"abcdefghijklmnopäbcdefghijklmnopq[<U+1F680>]rstuvwxyzabcdefgä");
+}
@@ -2,9 +2,32 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/compression.hpp>
+#include <osmium/io/detail/pbf_decoder.hpp>
+#include <osmium/io/detail/read_write.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
 #include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
 #include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/io/writer_options.hpp>
 #include <osmium/osm/object.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/util/file.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
 /**
  * Osmosis writes PBF with changeset=-1 if its input file did not contain the changeset field.
@@ -43,3 +66,996 @@ TEST_CASE("Read PBF file with version=-1 and changeset=-1 and DenseNodes (writte
     REQUIRE(object.version() == 0);
     REQUIRE(object.changeset() == 0);
 }
+
+// This "decompressor" doesn't decompress anything, it hands out the input
+// data in very small chunks. It is used to check that the PBF parser can
+// handle blobs spanning several chunks of input data.
+class ChunkedDecompressor : public osmium::io::Decompressor {
+
+    int m_fd;
+    std::size_t m_chunk_size;
+
+public:
+
+    ChunkedDecompressor(int fd, std::size_t chunk_size) :
+        m_fd(fd),
+        m_chunk_size(chunk_size) {
+    }
+
+    ChunkedDecompressor(const ChunkedDecompressor&) = delete;
+    ChunkedDecompressor& operator=(const ChunkedDecompressor&) = delete;
+
+    ChunkedDecompressor(ChunkedDecompressor&&) = delete;
+    ChunkedDecompressor& operator=(ChunkedDecompressor&&) = delete;
+
+    ~ChunkedDecompressor() noexcept final {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    std::string read() final {
+        std::string buffer(m_chunk_size, '\0');
+        const auto nread = osmium::io::detail::reliable_read(m_fd, &*buffer.begin(), static_cast<unsigned int>(m_chunk_size));
+        buffer.resize(static_cast<std::string::size_type>(nread));
+        return buffer;
+    }
+
+    void close() final {
+        if (m_fd >= 0) {
+            const int fd = m_fd;
+            m_fd = -1;
+            osmium::io::detail::reliable_close(fd);
+        }
+    }
+
+}; // class ChunkedDecompressor
+
+static void write_test_pbf_file(const std::string& filename) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_node(buffer,
+            _id(id),
+            _version(1),
+            _location(1.0 + 0.001 * id, 2.0),
+            _tag("id", std::to_string(id))
+        );
+    }
+
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _version(1),
+            _nodes({id, id + 1, id + 2}),
+            _tag("highway", "primary")
+        );
+    }
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static void check_test_pbf_data(osmium::io::Reader& reader) {
+    osmium::object_id_type node_id = 0;
+    osmium::object_id_type way_id = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            REQUIRE(node.id() == ++node_id);
+            REQUIRE(std::string{node.tags()["id"]} == std::to_string(node_id));
+        }
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            REQUIRE(way.id() == ++way_id);
+            REQUIRE(way.nodes().size() == 3);
+        }
+    }
+    reader.close();
+
+    REQUIRE(node_id == 1000);
+    REQUIRE(way_id == 100);
+}
+
+static void read_test_pbf_file_in_chunks(const std::string& filename, std::size_t chunk_size) {
+    osmium::io::CompressionFactory::instance().register_compression(osmium::io::file_compression::bzip2,
+        [](int, osmium::io::fsync) { return nullptr; },
+        [chunk_size](int fd) { return new ChunkedDecompressor(fd, chunk_size); },
+        [](const char*, size_t) { return nullptr; }
+    );
+
+    osmium::io::Reader reader{osmium::io::File{filename, "pbf.bz2"}};
+    check_test_pbf_data(reader);
+}
+
+TEST_CASE("Read PBF file in small chunks") {
+    const std::string filename{"test-pbf-chunks.osm.pbf"};
+    write_test_pbf_file(filename);
+
+    SECTION("chunks of 1 byte") {
+        read_test_pbf_file_in_chunks(filename, 1);
+    }
+
+    SECTION("chunks of 7 bytes") {
+        read_test_pbf_file_in_chunks(filename, 7);
+    }
+
+    SECTION("chunks of 1000 bytes") {
+        read_test_pbf_file_in_chunks(filename, 1000);
+    }
+
+    SECTION("one big chunk") {
+        read_test_pbf_file_in_chunks(filename, 1024 * 1024);
+    }
+}
+
+TEST_CASE("Read memory-mapped PBF file") {
+    const std::string filename{"test-pbf-mmap.osm.pbf"};
+    write_test_pbf_file(filename);
+
+    osmium::io::Reader reader{filename, osmium::io::mmap_input::yes};
+    REQUIRE(reader.header().get("pbf_dense_nodes") == "true");
+    check_test_pbf_data(reader);
+
+    // input was not read through the decompressor
+    REQUIRE(reader.offset() == 0);
+}
+
+TEST_CASE("Read truncated memory-mapped PBF file") {
+    const std::string filename{"test-pbf-mmap-truncated.osm.pbf"};
+    write_test_pbf_file(filename);
+    {
+        std::ifstream in{filename, std::ios::binary};
+        const std::string data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+        in.close();
+        std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+        out.write(data.data(), static_cast<std::streamsize>(data.size() - 10));
+    }
+
+    osmium::io::Reader reader{filename, osmium::io::mmap_input::yes};
+    const auto read_all = [&reader]() {
+        while (reader.read()) {
+        }
+    };
+    REQUIRE_THROWS_AS(read_all(), const osmium::pbf_error&);
+}
+
+static void write_sorted_test_pbf_file(const std::string& filename, bool ways_first) {
+    osmium::memory::Buffer nodes{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        osmium::builder::add_node(nodes,
+            _id(id),
+            _version(1),
+            _location(1.0 + 0.0001 * id, 2.0),
+            _tag("id", std::to_string(id))
+        );
+    }
+
+    osmium::memory::Buffer ways_and_relations{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(ways_and_relations,
+            _id(id),
+            _version(1),
+            _nodes({id, id + 1})
+        );
+    }
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        osmium::builder::add_relation(ways_and_relations,
+            _id(id),
+            _version(1),
+            _member(osmium::item_type::way, id, "outer")
+        );
+    }
+
+    osmium::io::Header header;
+    header.set("generator", "test");
+    header.set("sorting", "Type_then_ID");
+
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+    if (ways_first) {
+        writer(std::move(ways_and_relations));
+        writer(std::move(nodes));
+    } else {
+        writer(std::move(nodes));
+        writer(std::move(ways_and_relations));
+    }
+    writer.close();
+}
+
+static std::size_t count_entities(const std::string& filename, osmium::osm_entity_bits::type types) {
+    osmium::io::Reader reader{filename, types};
+    std::size_t count = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE((osmium::osm_entity_bits::from_item_type(object.type()) & types) != 0);
+            ++count;
+        }
+    }
+    reader.close();
+    return count;
+}
+
+TEST_CASE("Read only some entity types from PBF file sorted by type") {
+    const std::string filename{"test-pbf-sorted.osm.pbf"};
+    write_sorted_test_pbf_file(filename, false);
+
+    osmium::io::Reader reader{filename};
+    REQUIRE(reader.header().get("sorting") == "Type_then_ID");
+    reader.close();
+
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::node) == 20000);
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::way) == 100);
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::relation) == 10);
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::way | osmium::osm_entity_bits::relation) == 110);
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::node | osmium::osm_entity_bits::relation) == 20010);
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::changeset) == 0);
+}
+
+TEST_CASE("Read only some entity types from PBF file wrongly claiming to be sorted") {
+    const std::string filename{"test-pbf-not-sorted.osm.pbf"};
+    write_sorted_test_pbf_file(filename, true);
+
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::node) == 20000);
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::way) == 100);
+    REQUIRE(count_entities(filename, osmium::osm_entity_bits::relation) == 10);
+}
+
+static void check_sorted_test_pbf_file_in_order(const std::string& filename, const osmium::io::decode_window& window) {
+    osmium::thread::Pool pool{4};
+    osmium::io::Reader reader{filename, pool, window};
+
+    osmium::object_id_type node_id = 0;
+    osmium::object_id_type way_id = 0;
+    osmium::object_id_type relation_id = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    REQUIRE(way_id == 0);
+                    REQUIRE(object.id() == ++node_id);
+                    break;
+                case osmium::item_type::way:
+                    REQUIRE(relation_id == 0);
+                    REQUIRE(object.id() == ++way_id);
+                    break;
+                default:
+                    REQUIRE(object.id() == ++relation_id);
+                    break;
+            }
+        }
+    }
+    reader.close();
+
+    REQUIRE(node_id == 20000);
+    REQUIRE(way_id == 100);
+    REQUIRE(relation_id == 10);
+}
+
+TEST_CASE("Read PBF file with different decode windows") {
+    const std::string filename{"test-pbf-decode-window.osm.pbf"};
+    write_sorted_test_pbf_file(filename, false);
+
+    SECTION("automatic window") {
+        check_sorted_test_pbf_file_in_order(filename, osmium::io::decode_window{});
+    }
+
+    SECTION("decode in parser thread") {
+        REQUIRE_FALSE(osmium::io::decode_window{0}.parallel());
+        check_sorted_test_pbf_file_in_order(filename, osmium::io::decode_window{0});
+    }
+
+    SECTION("one blob at a time") {
+        check_sorted_test_pbf_file_in_order(filename, osmium::io::decode_window{1});
+    }
+
+    SECTION("window limited by bytes") {
+        check_sorted_test_pbf_file_in_order(filename, osmium::io::decode_window{8, 1});
+    }
+}
+
+static void write_prefilter_test_pbf_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_node(buffer,
+            _id(id),
+            _version(1),
+            _cid(static_cast<osmium::changeset_id_type>(id * 3)),
+            _uid(static_cast<osmium::user_id_type>(id * 2)),
+            _timestamp(osmium::Timestamp{static_cast<uint32_t>(1500000000 + id)}),
+            _user(("user" + std::to_string(id)).c_str()),
+            _location(1.0 + 0.001 * id, 2.0),
+            _tag("id", std::to_string(id)),
+            _tag("amenity", id % 10 == 0 ? "pub" : "bench")
+        );
+    }
+
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _version(1),
+            _nodes({id, id + 1, id + 2}),
+            _tag("highway", id % 2 == 0 ? "primary" : "secondary")
+        );
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static bool is_pub_or_primary(const char* key, const char* value) {
+    return (!std::strcmp(key, "amenity") && !std::strcmp(value, "pub")) ||
+           (!std::strcmp(key, "highway") && !std::strcmp(value, "primary"));
+}
+
+static void check_prefiltered_pbf_file(const std::string& filename, osmium::io::read_meta read_metadata) {
+    osmium::io::Reader reader{filename, osmium::io::tag_prefilter{is_pub_or_primary}, read_metadata};
+
+    int nodes = 0;
+    int ways = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            ++nodes;
+            REQUIRE(node.id() % 10 == 0);
+            REQUIRE(std::string{node.tags()["id"]} == std::to_string(node.id()));
+            REQUIRE(std::string{node.tags()["amenity"]} == "pub");
+            REQUIRE(node.location() == osmium::Location(1.0 + 0.001 * node.id(), 2.0));
+            if (read_metadata == osmium::io::read_meta::yes) {
+                REQUIRE(node.changeset() == node.id() * 3);
+                REQUIRE(node.uid() == node.id() * 2);
+                REQUIRE(node.timestamp() == osmium::Timestamp{static_cast<uint32_t>(1500000000 + node.id())});
+                REQUIRE(std::string{node.user()} == "user" + std::to_string(node.id()));
+            }
+        }
+        for (const auto& way : buffer.select<osmium::Way>()) {
+            ++ways;
+            REQUIRE(way.id() % 2 == 0);
+            REQUIRE(way.nodes().size() == 3);
+        }
+    }
+    reader.close();
+
+    REQUIRE(nodes == 100);
+    REQUIRE(ways == 50);
+}
+
+TEST_CASE("Read PBF file with tag prefilter") {
+    SECTION("dense nodes") {
+        const std::string filename{"test-pbf-prefilter-dense.osm.pbf"};
+        write_prefilter_test_pbf_file(filename, "pbf");
+        check_prefiltered_pbf_file(filename, osmium::io::read_meta::yes);
+        check_prefiltered_pbf_file(filename, osmium::io::read_meta::no);
+    }
+
+    SECTION("non-dense nodes") {
+        const std::string filename{"test-pbf-prefilter-sparse.osm.pbf"};
+        write_prefilter_test_pbf_file(filename, "pbf,pbf_dense_nodes=false");
+        check_prefiltered_pbf_file(filename, osmium::io::read_meta::yes);
+        check_prefiltered_pbf_file(filename, osmium::io::read_meta::no);
+    }
+}
+
+TEST_CASE("Read PBF file with tag prefilter only for ways") {
+    const std::string filename{"test-pbf-prefilter-ways.osm.pbf"};
+    write_prefilter_test_pbf_file(filename, "pbf");
+
+    osmium::io::Reader reader{filename, osmium::io::tag_prefilter{is_pub_or_primary, osmium::osm_entity_bits::way}};
+
+    int nodes = 0;
+    int ways = 0;
+    while (const auto buffer = reader.read()) {
+        nodes += static_cast<int>(std::distance(buffer.select<osmium::Node>().begin(), buffer.select<osmium::Node>().end()));
+        ways += static_cast<int>(std::distance(buffer.select<osmium::Way>().begin(), buffer.select<osmium::Way>().end()));
+    }
+    reader.close();
+
+    REQUIRE(nodes == 1000);
+    REQUIRE(ways == 50);
+}
+
+static std::pair<int, int> count_nodes_and_ways(const std::string& filename, const osmium::io::tag_prefilter& prefilter) {
+    osmium::io::Reader reader{filename, prefilter};
+
+    int nodes = 0;
+    int ways = 0;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            REQUIRE(object.tags().has_key("amenity") != object.tags().has_key("highway"));
+            if (object.type() == osmium::item_type::node) {
+                ++nodes;
+            } else {
+                ++ways;
+            }
+        }
+    }
+    reader.close();
+
+    return std::make_pair(nodes, ways);
+}
+
+TEST_CASE("Read PBF file with TagsFilter as prefilter") {
+    const std::string filename{"test-pbf-prefilter-tags-filter.osm.pbf"};
+    write_prefilter_test_pbf_file(filename, "pbf");
+
+    SECTION("key and value") {
+        osmium::TagsFilter filter{false};
+        filter.add_rule(true, "amenity", "pub");
+        filter.add_rule(true, "highway", "primary");
+        REQUIRE(count_nodes_and_ways(filename, osmium::io::tag_prefilter{filter}) == std::make_pair(100, 50));
+    }
+
+    SECTION("key only") {
+        osmium::TagsFilter filter{false};
+        filter.add_rule(true, osmium::StringMatcher::equal{"highway"});
+        REQUIRE(count_nodes_and_ways(filename, osmium::io::tag_prefilter{filter}) == std::make_pair(0, 100));
+    }
+
+    SECTION("first matching rule decides") {
+        osmium::TagsFilter filter{false};
+        filter.add_rule(false, "amenity", "bench");
+        filter.add_rule(true, "amenity");
+        REQUIRE(count_nodes_and_ways(filename, osmium::io::tag_prefilter{filter, osmium::osm_entity_bits::node}) == std::make_pair(100, 100));
+    }
+
+    SECTION("inverted value") {
+        osmium::TagsFilter filter{false};
+        filter.add_rule(true, "amenity", "bench", true);
+        REQUIRE(count_nodes_and_ways(filename, osmium::io::tag_prefilter{filter}) == std::make_pair(100, 0));
+    }
+
+    SECTION("default result") {
+        osmium::TagsFilter filter{true};
+        filter.add_rule(false, "id");
+        filter.add_rule(false, "amenity", "bench");
+        filter.add_rule(false, "highway", "secondary");
+        REQUIRE(count_nodes_and_ways(filename, osmium::io::tag_prefilter{filter}) == std::make_pair(100, 50));
+    }
+
+    SECTION("more rules than fit into the bitmaps") {
+        osmium::TagsFilter filter{false};
+        for (int i = 0; i < 70; ++i) {
+            filter.add_rule(true, "amenity", "pub" + std::to_string(i));
+        }
+        filter.add_rule(true, "amenity", "pub");
+        filter.add_rule(true, "highway", "primary");
+        REQUIRE(filter.count() > 64);
+        REQUIRE(count_nodes_and_ways(filename, osmium::io::tag_prefilter{filter}) == std::make_pair(100, 50));
+    }
+}
+
+TEST_CASE("PBF decode buffers adapt output buffer size") {
+    osmium::io::detail::PBFDecodeBuffers buffers;
+    const std::size_t initial_size = buffers.output_buffer_size;
+
+    osmium::memory::Buffer small{buffers.output_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+    buffers.update_output_buffer_size(small);
+    REQUIRE(buffers.output_buffer_size == initial_size);
+
+    osmium::memory::Buffer full{buffers.output_buffer_size, osmium::memory::Buffer::auto_grow::internal};
+    for (osmium::object_id_type id = 1; id <= 10000; ++id) {
+        osmium::builder::add_node(full, _id(id));
+    }
+    REQUIRE(full.has_nested_buffers());
+    buffers.update_output_buffer_size(full);
+    REQUIRE(buffers.output_buffer_size == 2 * initial_size);
+
+    buffers.update_output_buffer_size(small);
+    REQUIRE(buffers.output_buffer_size == initial_size);
+}
+
+static std::vector<std::string> read_first_data_stringtable(const std::string& filename) {
+    std::ifstream file{filename, std::ios::binary};
+    const std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+
+    std::vector<std::string> strings;
+    osmium::io::detail::for_each_pbf_blob(data.data(), data.size(), [&strings](std::size_t offset, std::size_t /*size*/, const protozero::data_view& blob) {
+        if (offset == 0 || !strings.empty()) {
+            return;
+        }
+        std::string output;
+        protozero::pbf_message<osmium::io::detail::OSMFormat::PrimitiveBlock> pbf_block{osmium::io::detail::decode_blob(blob, output)};
+        REQUIRE(pbf_block.next(osmium::io::detail::OSMFormat::PrimitiveBlock::required_StringTable_stringtable));
+        protozero::pbf_message<osmium::io::detail::OSMFormat::StringTable> pbf_stringtable{pbf_block.get_message()};
+        while (pbf_stringtable.next()) {
+            strings.push_back(pbf_stringtable.get_string());
+        }
+    });
+
+    return strings;
+}
+
+static std::vector<std::string> read_objects_as_strings(const std::string& filename) {
+    std::vector<std::string> objects;
+
+    osmium::io::Reader reader{filename};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            std::string str{osmium::item_type_to_char(object.type())};
+            str += std::to_string(object.id());
+            str += ' ';
+            str += object.user();
+            for (const auto& tag : object.tags()) {
+                str += ' ';
+                str += tag.key();
+                str += '=';
+                str += tag.value();
+            }
+            if (object.type() == osmium::item_type::way) {
+                for (const auto& node_ref : static_cast<const osmium::Way&>(object).nodes()) {
+                    str += ' ';
+                    str += std::to_string(node_ref.ref());
+                }
+            }
+            objects.push_back(str);
+        }
+    }
+    reader.close();
+
+    return objects;
+}
+
+static void write_relations_test_pbf_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_relation(buffer,
+            _id(id),
+            _version(1),
+            _user("foo"),
+            _member(osmium::item_type::way, id, id % 3 == 0 ? "inner" : "outer"),
+            _member(osmium::item_type::node, id, "label"),
+            _tag("type", "multipolygon")
+        );
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static std::vector<std::string> read_relations_as_strings(const std::string& filename) {
+    std::vector<std::string> relations;
+
+    osmium::io::Reader reader{filename};
+    while (const auto buffer = reader.read()) {
+        for (const auto& relation : buffer.select<osmium::Relation>()) {
+            std::string str{relation.user()};
+            for (const auto& member : relation.members()) {
+                str += ' ';
+                str += osmium::item_type_to_char(member.type());
+                str += std::to_string(member.ref());
+                str += '@';
+                str += member.role();
+            }
+            relations.push_back(str);
+        }
+    }
+    reader.close();
+
+    return relations;
+}
+
+TEST_CASE("Write PBF file with string tables sorted by frequency") {
+    const std::string filename_unsorted{"test-pbf-stringtable-unsorted.osm.pbf"};
+    write_prefilter_test_pbf_file(filename_unsorted, "pbf");
+    REQUIRE(read_first_data_stringtable(filename_unsorted)[1] == "user1");
+
+    const std::string filename_sorted{"test-pbf-stringtable-sorted.osm.pbf"};
+
+    SECTION("dense nodes") {
+        write_prefilter_test_pbf_file(filename_sorted, "pbf,pbf_sort_stringtable=true");
+    }
+
+    SECTION("non-dense nodes") {
+        write_prefilter_test_pbf_file(filename_sorted, "pbf,pbf_sort_stringtable=true,pbf_dense_nodes=false");
+    }
+
+    const auto strings = read_first_data_stringtable(filename_sorted);
+    REQUIRE(strings.size() > 4);
+    REQUIRE(strings[0].empty());
+    REQUIRE(strings[1] == "id");
+    REQUIRE(strings[2] == "amenity");
+    REQUIRE(strings[3] == "bench");
+
+    REQUIRE(read_objects_as_strings(filename_sorted) == read_objects_as_strings(filename_unsorted));
+}
+
+TEST_CASE("Write PBF file with relations and string tables sorted by frequency") {
+    const std::string filename_unsorted{"test-pbf-stringtable-relations-unsorted.osm.pbf"};
+    write_relations_test_pbf_file(filename_unsorted, "pbf");
+
+    const std::string filename_sorted{"test-pbf-stringtable-relations-sorted.osm.pbf"};
+    write_relations_test_pbf_file(filename_sorted, "pbf,pbf_sort_stringtable=true");
+
+    const auto strings = read_first_data_stringtable(filename_sorted);
+    REQUIRE(strings == std::vector<std::string>({"", "type", "multipolygon", "foo", "label", "outer", "inner"}));
+
+    REQUIRE(read_relations_as_strings(filename_sorted) == read_relations_as_strings(filename_unsorted));
+    REQUIRE(read_objects_as_strings(filename_sorted) == read_objects_as_strings(filename_unsorted));
+}
+
+static void write_many_objects_test_pbf_file(const std::string& filename, const char* format) {
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+
+    for (int n = 0; n < 3; ++n) {
+        osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+        for (osmium::object_id_type id = n * 10000 + 1; id <= (n + 1) * 10000; ++id) {
+            osmium::builder::add_node(buffer,
+                _id(id),
+                _version(1),
+                _user("foo"),
+                _location(1.0 + id / 100000.0, 2.0),
+                _tag("id", std::to_string(id))
+            );
+        }
+        writer(std::move(buffer));
+    }
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _user("bar"),
+            _nodes({id, id + 1}),
+            _tag("highway", "residential")
+        );
+    }
+    writer(std::move(buffer));
+    writer.close();
+}
+
+TEST_CASE("Write PBF file with primitive blocks built in the thread pool") {
+    const std::string filename_serial{"test-pbf-serial-blocks.osm.pbf"};
+    write_many_objects_test_pbf_file(filename_serial, "pbf");
+
+    const std::string filename_parallel{"test-pbf-parallel-blocks.osm.pbf"};
+
+    SECTION("dense nodes") {
+        write_many_objects_test_pbf_file(filename_parallel, "pbf,pbf_parallel_blocks=true");
+    }
+
+    SECTION("non-dense nodes with sorted string tables") {
+        write_many_objects_test_pbf_file(filename_parallel, "pbf,pbf_parallel_blocks=true,pbf_dense_nodes=false,pbf_sort_stringtable=true");
+    }
+
+    SECTION("without compression") {
+        write_many_objects_test_pbf_file(filename_parallel, "pbf,pbf_parallel_blocks=true,pbf_compression=none");
+    }
+
+    const auto objects = read_objects_as_strings(filename_parallel);
+    REQUIRE(objects.size() == 30100);
+    REQUIRE(objects == read_objects_as_strings(filename_serial));
+}
+
+TEST_CASE("Write PBF file with different compression levels") {
+    const std::string filename_default{"test-pbf-compression-default.osm.pbf"};
+    write_many_objects_test_pbf_file(filename_default, "pbf");
+
+    const std::string filename_fast{"test-pbf-compression-1.osm.pbf"};
+    write_many_objects_test_pbf_file(filename_fast, "pbf,pbf_compression_level=1");
+
+    const std::string filename_store{"test-pbf-compression-0.osm.pbf"};
+    write_many_objects_test_pbf_file(filename_store, "pbf,pbf_compression=zlib,pbf_compression_level=0");
+
+    REQUIRE(osmium::file_size(filename_store) > osmium::file_size(filename_fast));
+    REQUIRE(osmium::file_size(filename_fast) >= osmium::file_size(filename_default));
+
+    const auto objects = read_objects_as_strings(filename_default);
+    REQUIRE(objects == read_objects_as_strings(filename_fast));
+    REQUIRE(objects == read_objects_as_strings(filename_store));
+}
+
+TEST_CASE("Invalid PBF compression options") {
+    const std::string filename{"test-pbf-compression-invalid.osm.pbf"};
+
+    SECTION("unknown compression") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_compression=foo"), const std::invalid_argument&);
+    }
+
+    SECTION("level too large") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_compression_level=99"), const std::invalid_argument&);
+    }
+
+    SECTION("level not a number") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_compression_level=fast"), const std::invalid_argument&);
+    }
+
+    SECTION("level without compression") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_compression=none,pbf_compression_level=1"), const std::invalid_argument&);
+    }
+}
+
+static std::string make_blob(osmium::io::detail::FileFormat::Blob type, const std::string& data, const std::size_t raw_size) {
+    std::string blob;
+    protozero::pbf_builder<osmium::io::detail::FileFormat::Blob> pbf_blob{blob};
+    pbf_blob.add_int32(osmium::io::detail::FileFormat::Blob::optional_int32_raw_size, static_cast<int32_t>(raw_size));
+    pbf_blob.add_bytes(type, data);
+    return blob;
+}
+
+TEST_CASE("Decode lz4 and zstd compressed PBF blobs") {
+    const std::string data(1000, 'x');
+    std::string output;
+
+#ifdef OSMIUM_WITH_LZ4
+    SECTION("lz4") {
+        const auto blob = make_blob(osmium::io::detail::FileFormat::Blob::optional_bytes_lz4_data, osmium::io::detail::lz4_compress(data), data.size());
+        REQUIRE(std::string(osmium::io::detail::decode_blob(protozero::data_view{blob.data(), blob.size()}, output).data(), data.size()) == data);
+    }
+#else
+    SECTION("lz4 not supported") {
+        const auto blob = make_blob(osmium::io::detail::FileFormat::Blob::optional_bytes_lz4_data, "abc", 3);
+        REQUIRE_THROWS_AS(osmium::io::detail::decode_blob(protozero::data_view{blob.data(), blob.size()}, output), const osmium::pbf_error&);
+    }
+#endif
+
+#ifdef OSMIUM_WITH_ZSTD
+    SECTION("zstd") {
+        const auto blob = make_blob(osmium::io::detail::FileFormat::Blob::optional_bytes_zstd_data, osmium::io::detail::zstd_compress(data, 3), data.size());
+        REQUIRE(std::string(osmium::io::detail::decode_blob(protozero::data_view{blob.data(), blob.size()}, output).data(), data.size()) == data);
+    }
+#else
+    SECTION("zstd not supported") {
+        const auto blob = make_blob(osmium::io::detail::FileFormat::Blob::optional_bytes_zstd_data, "abc", 3);
+        REQUIRE_THROWS_AS(osmium::io::detail::decode_blob(protozero::data_view{blob.data(), blob.size()}, output), const osmium::pbf_error&);
+    }
+#endif
+}
+
+TEST_CASE("Write PBF file with lz4 or zstd compression") {
+    const std::string filename_zlib{"test-pbf-compression-zlib.osm.pbf"};
+    write_many_objects_test_pbf_file(filename_zlib, "pbf");
+
+    const std::string filename{"test-pbf-compression-other.osm.pbf"};
+
+#ifdef OSMIUM_WITH_LZ4
+    SECTION("lz4") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_compression=lz4");
+        REQUIRE(read_objects_as_strings(filename) == read_objects_as_strings(filename_zlib));
+    }
+#else
+    SECTION("lz4 not supported") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_compression=lz4"), const std::invalid_argument&);
+    }
+#endif
+
+#ifdef OSMIUM_WITH_ZSTD
+    SECTION("zstd") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_compression=zstd,pbf_compression_level=19");
+        REQUIRE(read_objects_as_strings(filename) == read_objects_as_strings(filename_zlib));
+    }
+#else
+    SECTION("zstd not supported") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_compression=zstd"), const std::invalid_argument&);
+    }
+#endif
+}
+
+TEST_CASE("Write PBF file with limits on block sizes") {
+    const std::string filename_default{"test-pbf-block-limits-default.osm.pbf"};
+    write_many_objects_test_pbf_file(filename_default, "pbf");
+    const auto index_default = osmium::io::PBFBlobIndex::build(filename_default);
+    REQUIRE(index_default.size() == 5);
+
+    const std::string filename{"test-pbf-block-limits.osm.pbf"};
+
+    SECTION("maximum number of entities") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_max_block_entities=1000");
+        const auto index = osmium::io::PBFBlobIndex::build(filename);
+        REQUIRE(index.size() == 31);
+        for (const auto& entry : index.entries()) {
+            REQUIRE(entry.max_id - entry.min_id < 1000);
+        }
+    }
+
+    SECTION("maximum number of entities with blocks built in pool") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_max_block_entities=1000,pbf_parallel_blocks=true");
+        REQUIRE(osmium::io::PBFBlobIndex::build(filename).size() == 31);
+    }
+
+    SECTION("maximum uncompressed size") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_max_block_size=10000");
+        REQUIRE(osmium::io::PBFBlobIndex::build(filename).size() > 20);
+    }
+
+    SECTION("maximum compressed size") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_max_compressed_block_size=4000");
+        const auto index = osmium::io::PBFBlobIndex::build(filename);
+        REQUIRE(index.size() > 10);
+        std::size_t large_blobs = 0;
+        for (const auto& entry : index.entries()) {
+            if (entry.size > 8000) {
+                ++large_blobs;
+            }
+        }
+        REQUIRE(large_blobs <= 2);
+    }
+
+    SECTION("maximum extent") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_max_block_extent=0.05");
+        const auto index = osmium::io::PBFBlobIndex::build(filename);
+        REQUIRE(index.size() > 6);
+        for (const auto& entry : index.entries()) {
+            if (entry.types == osmium::osm_entity_bits::node) {
+                REQUIRE(entry.bbox.top_right().x() - entry.bbox.bottom_left().x() <= 500000);
+            }
+        }
+    }
+
+    REQUIRE(read_objects_as_strings(filename) == read_objects_as_strings(filename_default));
+}
+
+TEST_CASE("Invalid PBF block limit options") {
+    const std::string filename{"test-pbf-block-limits-invalid.osm.pbf"};
+
+    SECTION("zero entities") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_max_block_entities=0"), const std::invalid_argument&);
+    }
+
+    SECTION("too many entities") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_max_block_entities=9000"), const std::invalid_argument&);
+    }
+
+    SECTION("size not a number") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_max_block_size=big"), const std::invalid_argument&);
+    }
+
+    SECTION("negative extent") {
+        REQUIRE_THROWS_AS(write_many_objects_test_pbf_file(filename, "pbf,pbf_max_block_extent=-1"), const std::invalid_argument&);
+    }
+}
+
+static void require_same_index_entries(const osmium::io::PBFBlobIndex& a, const osmium::io::PBFBlobIndex& b) {
+    REQUIRE(a.size() == b.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        const auto& ea = a.entries()[i];
+        const auto& eb = b.entries()[i];
+        REQUIRE(ea.offset == eb.offset);
+        REQUIRE(ea.size == eb.size);
+        REQUIRE(ea.types == eb.types);
+        REQUIRE(ea.min_id == eb.min_id);
+        REQUIRE(ea.max_id == eb.max_id);
+        REQUIRE(ea.bbox == eb.bbox);
+    }
+}
+
+TEST_CASE("Write blob index sidecar while writing PBF file") {
+    const std::string filename{"test-pbf-write-index.osm.pbf"};
+    const std::string sidecar{"test-pbf-write-index.osm.pbf.idx"};
+
+    SECTION("blocks built in writer thread") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_index_sidecar=test-pbf-write-index.osm.pbf.idx");
+    }
+
+    SECTION("blocks built in pool") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_parallel_blocks=true,pbf_index_sidecar=test-pbf-write-index.osm.pbf.idx");
+    }
+
+    SECTION("small blocks without compression") {
+        write_many_objects_test_pbf_file(filename, "pbf,pbf_compression=none,pbf_max_block_entities=333,pbf_index_sidecar=test-pbf-write-index.osm.pbf.idx");
+    }
+
+    const auto index = osmium::io::PBFBlobIndex::read(sidecar);
+    REQUIRE(index.size() > 4);
+    require_same_index_entries(index, osmium::io::PBFBlobIndex::build(filename));
+}
+
+TEST_CASE("Write PBF file with checked order") {
+    const std::string filename{"test-pbf-check-order.osm.pbf"};
+
+    write_many_objects_test_pbf_file(filename, "pbf,pbf_check_order=true");
+
+    osmium::io::Reader reader{filename};
+    REQUIRE(reader.header().get("sorting") == "Type_then_ID");
+    reader.close();
+}
+
+TEST_CASE("Write PBF file with checked order fails if objects are not sorted") {
+    const std::string filename{"test-pbf-check-order-fail.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(2), _location(1.0, 1.0));
+    osmium::builder::add_node(buffer, _id(1), _location(1.0, 1.0));
+
+    const char* format = "pbf,pbf_check_order=true";
+    SECTION("blocks built in writer thread") {
+    }
+    SECTION("blocks built in pool") {
+        format = "pbf,pbf_check_order=true,pbf_parallel_blocks=true";
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    REQUIRE_THROWS_AS(writer(std::move(buffer)), const osmium::out_of_order_error&);
+}
+
+TEST_CASE("Write PBF file with spatial sort") {
+    const std::string filename{"test-pbf-spatial-sort.osm.pbf"};
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _location(170.0, 80.0));
+    osmium::builder::add_node(buffer, _id(2), _location(-170.0, -80.0));
+    osmium::builder::add_node(buffer, _id(3), _location(170.0, 79.0));
+
+    {
+        osmium::io::Writer writer{osmium::io::File{filename, "pbf,pbf_spatial_sort=hilbert"}, osmium::io::overwrite::allow};
+        writer(std::move(buffer));
+        writer.close();
+    }
+
+    osmium::io::Reader reader{filename};
+    REQUIRE(reader.header().get("sorting") == "Spatial_Hilbert");
+    std::vector<osmium::object_id_type> ids;
+    while (const osmium::memory::Buffer read_buffer = reader.read()) {
+        for (const auto& node : read_buffer.select<osmium::Node>()) {
+            ids.push_back(node.id());
+        }
+    }
+    reader.close();
+
+    REQUIRE(ids == std::vector<osmium::object_id_type>{2, 1, 3});
+}
+
+TEST_CASE("Spatial sort can not be used with checked order") {
+    REQUIRE_THROWS_AS(osmium::io::Writer(osmium::io::File{"test-pbf-spatial-sort-fail.osm.pbf", "pbf,pbf_spatial_sort=true,pbf_check_order=true"}, osmium::io::overwrite::allow), const std::invalid_argument&);
+}
+
+static void write_way_locations_test_pbf_file(const std::string& filename, const char* format, bool with_locations, const osmium::io::way_node_locations& lookup) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        if (with_locations) {
+            osmium::builder::add_way(buffer,
+                _id(id),
+                _node(osmium::NodeRef{id, osmium::Location{1.0 + id / 1000.0, 2.0}}),
+                _node(osmium::NodeRef{id + 1, osmium::Location{1.0 + (id + 1) / 1000.0, 2.0}}),
+                _node(osmium::NodeRef{-5, osmium::Location{}})
+            );
+        } else {
+            osmium::builder::add_way(buffer, _id(id), _nodes({id, id + 1, -5}));
+        }
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, lookup, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static std::string read_whole_file(const std::string& filename) {
+    std::ifstream in{filename, std::ios::binary};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Write PBF file with node locations on ways looked up in index") {
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    for (osmium::object_id_type id = 101; id >= 1; --id) {
+        index.set(static_cast<osmium::unsigned_object_id_type>(id), osmium::Location{1.0 + id / 1000.0, 2.0});
+    }
+    index.sort();
+
+    const std::string filename_expected{"test-pbf-way-locations-expected.osm.pbf"};
+    write_way_locations_test_pbf_file(filename_expected, "pbf,locations_on_ways=true", true, osmium::io::way_node_locations{});
+
+    const std::string filename{"test-pbf-way-locations-lookup.osm.pbf"};
+
+    SECTION("blocks built in writer thread") {
+        write_way_locations_test_pbf_file(filename, "pbf", false, osmium::io::way_node_locations::from_index(index));
+    }
+
+    SECTION("blocks built in the thread pool") {
+        write_way_locations_test_pbf_file(filename, "pbf,pbf_parallel_blocks=true", false, osmium::io::way_node_locations::from_index(index));
+    }
+
+    REQUIRE(read_whole_file(filename) == read_whole_file(filename_expected));
+
+    osmium::io::Reader reader{filename};
+    int count = 0;
+    while (const osmium::memory::Buffer read_buffer = reader.read()) {
+        for (const auto& way : read_buffer.select<osmium::Way>()) {
+            REQUIRE(way.nodes()[0].location() == osmium::Location{1.0 + way.id() / 1000.0, 2.0});
+            REQUIRE_FALSE(way.nodes()[2].location().valid());
+            ++count;
+        }
+    }
+    reader.close();
+    REQUIRE(count == 100);
+}
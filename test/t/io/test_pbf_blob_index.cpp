@@ -0,0 +1,364 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/index/nwr_array.hpp>
+#include <osmium/io/pbf_bbox.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <cstddef>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Writes 20000 nodes (in three blobs), 100 ways and 10 relations.
+static void write_blob_index_test_file(const std::string& filename) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        osmium::builder::add_node(buffer,
+            _id(id),
+            _version(1),
+            _location(1.0 + 0.0001 * id, 2.0)
+        );
+    }
+
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _version(1),
+            _nodes({id, id + 1})
+        );
+    }
+
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        osmium::builder::add_relation(buffer,
+            _id(id),
+            _version(1),
+            _member(osmium::item_type::way, id, "outer")
+        );
+    }
+
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+struct counts {
+    int nodes = 0;
+    int ways = 0;
+    int relations = 0;
+    osmium::object_id_type first_node_id = 0;
+};
+
+template <typename... TArgs>
+static counts count_objects(TArgs&&... args) {
+    counts c;
+    osmium::io::Reader reader{std::forward<TArgs>(args)...};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            switch (object.type()) {
+                case osmium::item_type::node:
+                    if (c.nodes++ == 0) {
+                        c.first_node_id = object.id();
+                    }
+                    break;
+                case osmium::item_type::way:
+                    ++c.ways;
+                    break;
+                case osmium::item_type::relation:
+                    ++c.relations;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    reader.close();
+    return c;
+}
+
+TEST_CASE("Build PBF blob index") {
+    const std::string filename{"test-pbf-blob-index.osm.pbf"};
+    write_blob_index_test_file(filename);
+
+    const auto index = osmium::io::PBFBlobIndex::build(filename);
+    REQUIRE(index.size() == 5);
+
+    const auto& e = index.entries();
+    REQUIRE(e[0].types == osmium::osm_entity_bits::node);
+    REQUIRE(e[0].min_id == 1);
+    REQUIRE(e[0].max_id == 8000);
+    REQUIRE(e[0].bbox.valid());
+    REQUIRE(e[1].types == osmium::osm_entity_bits::node);
+    REQUIRE(e[1].min_id == 8001);
+    REQUIRE(e[1].max_id == 16000);
+    REQUIRE(e[2].types == osmium::osm_entity_bits::node);
+    REQUIRE(e[2].max_id == 20000);
+    REQUIRE(e[3].types == osmium::osm_entity_bits::way);
+    REQUIRE(e[3].min_id == 1);
+    REQUIRE(e[3].max_id == 100);
+    REQUIRE_FALSE(e[3].bbox.valid());
+    REQUIRE(e[4].types == osmium::osm_entity_bits::relation);
+
+    for (std::size_t i = 1; i < index.size(); ++i) {
+        REQUIRE(e[i].offset == e[i - 1].offset + e[i - 1].size);
+    }
+    REQUIRE(e[4].offset + e[4].size == osmium::file_size(filename));
+
+    SECTION("read everything") {
+        const auto c = count_objects(filename, osmium::io::blob_selection{});
+        REQUIRE(c.nodes == 20000);
+        REQUIRE(c.ways == 100);
+        REQUIRE(c.relations == 10);
+    }
+
+    SECTION("read only ways") {
+        const auto c = count_objects(filename, index.select(osmium::osm_entity_bits::way));
+        REQUIRE(c.nodes == 0);
+        REQUIRE(c.ways == 100);
+        REQUIRE(c.relations == 0);
+    }
+
+    SECTION("read only blob with node id range") {
+        const auto c = count_objects(filename, index.select(osmium::osm_entity_bits::node, 9000, 9001));
+        REQUIRE(c.nodes == 8000);
+        REQUIRE(c.first_node_id == 8001);
+        REQUIRE(c.ways == 0);
+        REQUIRE(c.relations == 0);
+    }
+
+    SECTION("read selected blobs from memory-mapped file") {
+        const auto c = count_objects(filename, osmium::io::mmap_input::yes, index.select(osmium::osm_entity_bits::node | osmium::osm_entity_bits::relation, 15000));
+        REQUIRE(c.nodes == 12000);
+        REQUIRE(c.ways == 0);
+        REQUIRE(c.relations == 0);
+    }
+
+    SECTION("select with predicate") {
+        const auto c = count_objects(filename, index.select_if([](const osmium::io::PBFBlobIndex::entry& entry) {
+            return entry.bbox.valid() && entry.bbox.bottom_left().lon() > 2.0;
+        }));
+        REQUIRE(c.nodes == 4000);
+    }
+
+    SECTION("select with id set") {
+        osmium::index::IdSetSmall<osmium::unsigned_object_id_type> ids;
+        ids.set(17000);
+        ids.set(5);
+        ids.set(7);
+        ids.sort_unique();
+        const auto c = count_objects(filename, index.select(osmium::item_type::node, ids));
+        REQUIRE(c.nodes == 12000);
+        REQUIRE(c.first_node_id == 1);
+        REQUIRE(c.ways == 0);
+        REQUIRE(c.relations == 0);
+    }
+
+    SECTION("select with id sets for all types") {
+        osmium::nwr_array<osmium::index::IdSetSmall<osmium::unsigned_object_id_type>> ids;
+        ids(osmium::item_type::node).set(9000);
+        ids(osmium::item_type::way).set(50);
+        ids(osmium::item_type::relation).set(500);
+        ids(osmium::item_type::node).sort_unique();
+        ids(osmium::item_type::way).sort_unique();
+        ids(osmium::item_type::relation).sort_unique();
+        const auto c = count_objects(filename, index.select(ids));
+        REQUIRE(c.nodes == 8000);
+        REQUIRE(c.first_node_id == 8001);
+        REQUIRE(c.ways == 100);
+        REQUIRE(c.relations == 0);
+    }
+
+    SECTION("empty selection") {
+        const auto c = count_objects(filename, index.select(osmium::osm_entity_bits::changeset));
+        REQUIRE(c.nodes == 0);
+        REQUIRE(c.ways == 0);
+        REQUIRE(c.relations == 0);
+    }
+}
+
+TEST_CASE("Select PBF blobs with bounding box") {
+    const std::string filename{"test-pbf-blob-index-bbox.osm.pbf"};
+    write_blob_index_test_file(filename);
+
+    const auto index = osmium::io::PBFBlobIndex::build(filename);
+
+    SECTION("select blobs") {
+        // contains node 17000 only
+        const osmium::Box box{osmium::Location{2.69995, 1.9}, osmium::Location{2.70005, 2.1}};
+        const auto c = count_objects(filename, index.select(box));
+        REQUIRE(c.nodes == 4000);
+        REQUIRE(c.first_node_id == 16001);
+        REQUIRE(c.ways == 100);
+        REQUIRE(c.relations == 10);
+    }
+
+    SECTION("box outside of all nodes") {
+        const osmium::Box box{osmium::Location{10.0, 10.0}, osmium::Location{11.0, 11.0}};
+        const auto c = count_objects(filename, index.select(box));
+        REQUIRE(c.nodes == 0);
+        REQUIRE(c.ways == 100);
+        REQUIRE(c.relations == 10);
+    }
+
+    SECTION("find ids of extract") {
+        // contains nodes 5 to 8
+        const osmium::Box box{osmium::Location{1.00045, 1.9}, osmium::Location{1.00085, 2.1}};
+        const auto ids = osmium::io::ids_in_bbox(filename, index, box);
+
+        REQUIRE(ids(osmium::item_type::node).size() == 6); // 4 to 9
+        REQUIRE(ids(osmium::item_type::node).get_binary_search(4));
+        REQUIRE(ids(osmium::item_type::node).get_binary_search(9));
+        REQUIRE_FALSE(ids(osmium::item_type::node).get_binary_search(10));
+        REQUIRE(ids(osmium::item_type::way).size() == 5); // 4 to 8
+        REQUIRE(ids(osmium::item_type::way).get_binary_search(4));
+        REQUIRE(ids(osmium::item_type::way).get_binary_search(8));
+        REQUIRE(ids(osmium::item_type::relation).size() == 5); // 4 to 8
+
+        const auto c = count_objects(filename, index.select(ids));
+        REQUIRE(c.nodes == 8000);
+        REQUIRE(c.first_node_id == 1);
+        REQUIRE(c.ways == 100);
+        REQUIRE(c.relations == 10);
+    }
+}
+
+TEST_CASE("Write and read PBF blob index sidecar file") {
+    const std::string filename{"test-pbf-blob-index-sidecar.osm.pbf"};
+    write_blob_index_test_file(filename);
+
+    const auto index = osmium::io::PBFBlobIndex::build(filename);
+    index.write(filename + ".idx", osmium::io::overwrite::allow);
+
+    const auto index2 = osmium::io::PBFBlobIndex::read(filename + ".idx");
+    REQUIRE(index2.size() == index.size());
+
+    auto it = index2.begin();
+    for (const auto& e : index) {
+        REQUIRE(it->offset == e.offset);
+        REQUIRE(it->size == e.size);
+        REQUIRE(it->types == e.types);
+        REQUIRE(it->min_id == e.min_id);
+        REQUIRE(it->max_id == e.max_id);
+        REQUIRE(it->bbox == e.bbox);
+        ++it;
+    }
+}
+
+TEST_CASE("Reading invalid PBF blob index sidecar file") {
+    const std::string filename{"test-pbf-blob-index-invalid.idx"};
+    {
+        std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+        out << "this is not an index";
+    }
+
+    REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::read(filename), const osmium::io_error&);
+}
+
+TEST_CASE("Scan PBF file for blob offsets") {
+    const std::string filename{"test-pbf-blob-index-scan.osm.pbf"};
+    write_blob_index_test_file(filename);
+
+    const auto index = osmium::io::PBFBlobIndex::build(filename);
+    const auto scanned = osmium::io::PBFBlobIndex::scan(filename);
+    REQUIRE(scanned.size() == index.size());
+
+    auto it = scanned.begin();
+    for (const auto& e : index) {
+        REQUIRE(it->offset == e.offset);
+        REQUIRE(it->size == e.size);
+        REQUIRE(it->types == osmium::osm_entity_bits::nothing);
+        ++it;
+    }
+}
+
+TEST_CASE("Partition PBF file into shards") {
+    const std::string filename{"test-pbf-blob-index-shards.osm.pbf"};
+    write_blob_index_test_file(filename);
+
+    const auto index = osmium::io::PBFBlobIndex::build(filename);
+    const auto data_size = osmium::file_size(filename) - index.entries().front().offset;
+
+    SECTION("contiguous shards") {
+        const auto shards = osmium::io::PBFBlobIndex::scan(filename).partition(2);
+        REQUIRE(shards.size() == 2);
+        REQUIRE(shards[0].num_blobs + shards[1].num_blobs == 5);
+        REQUIRE(shards[0].bytes + shards[1].bytes == data_size);
+        REQUIRE(shards[0].ranges.size() == 1);
+        REQUIRE(shards[1].ranges.size() == 1);
+        REQUIRE(shards[0].ranges[0].first == index.entries().front().offset);
+        REQUIRE(shards[0].ranges[0].first + shards[0].ranges[0].second == shards[1].ranges[0].first);
+
+        const auto c0 = count_objects(filename, shards[0].selection);
+        const auto c1 = count_objects(filename, shards[1].selection);
+        REQUIRE(c0.first_node_id == 1);
+        REQUIRE(c0.nodes + c1.nodes == 20000);
+        REQUIRE(c0.ways + c1.ways == 100);
+        REQUIRE(c0.relations + c1.relations == 10);
+        REQUIRE(c0.relations == 0);
+        REQUIRE(c1.relations == 10);
+    }
+
+    SECTION("shards on entity type boundaries") {
+        const auto shards = index.partition(3, osmium::io::shard_boundaries::entity_types);
+        REQUIRE(shards.size() == 3);
+
+        counts total;
+        for (const auto& shard : shards) {
+            REQUIRE(shard.types & osmium::osm_entity_bits::node);
+            const auto c = count_objects(filename, shard.selection);
+            REQUIRE(c.nodes > 0);
+            total.nodes += c.nodes;
+            total.ways += c.ways;
+            total.relations += c.relations;
+        }
+        REQUIRE(total.nodes == 20000);
+        REQUIRE(total.ways == 100);
+        REQUIRE(total.relations == 10);
+    }
+
+    SECTION("get single shard") {
+        const auto shard = index.get_shard(1, 2);
+        const auto shards = index.partition(2);
+        REQUIRE(shard.ranges == shards[1].ranges);
+        REQUIRE(shard.bytes == shards[1].bytes);
+    }
+
+    SECTION("more shards than blobs") {
+        const auto shards = index.partition(10);
+        REQUIRE(shards.size() == 10);
+
+        std::size_t blobs = 0;
+        int empty = 0;
+        for (const auto& shard : shards) {
+            blobs += shard.num_blobs;
+            if (shard.num_blobs == 0) {
+                ++empty;
+                const auto c = count_objects(filename, shard.selection);
+                REQUIRE(c.nodes == 0);
+                REQUIRE(c.ways == 0);
+                REQUIRE(c.relations == 0);
+            }
+        }
+        REQUIRE(blobs == 5);
+        REQUIRE(empty >= 5);
+    }
+
+    SECTION("invalid arguments") {
+        REQUIRE_THROWS_AS(index.partition(0), const std::invalid_argument&);
+        REQUIRE_THROWS_AS(index.get_shard(2, 2), const std::invalid_argument&);
+        REQUIRE_THROWS_AS(osmium::io::PBFBlobIndex::scan(filename).partition(2, osmium::io::shard_boundaries::entity_types), const std::invalid_argument&);
+    }
+}
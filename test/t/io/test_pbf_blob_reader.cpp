@@ -0,0 +1,113 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/error.hpp>
+#include <osmium/io/opl_output.hpp>
+#include <osmium/io/pbf_blob_index.hpp>
+#include <osmium/io/pbf_blob_reader.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/reader.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/object.hpp>
+
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static void write_blob_reader_test_file(const std::string& filename) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _version(1), _location(1.0 + 0.0001 * id, 2.0), _tag("n", "x"));
+    }
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _version(1), _nodes({id, id + 1}));
+    }
+
+    osmium::io::Header header;
+    header.set("generator", "test");
+    osmium::io::Writer writer{filename, header, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static std::size_t count_objects(const std::string& filename) {
+    std::size_t count = 0;
+    osmium::io::Reader reader{filename};
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            (void)object;
+            ++count;
+        }
+    }
+    reader.close();
+    return count;
+}
+
+TEST_CASE("Read raw blobs from PBF file") {
+    const std::string filename{"test-pbf-blob-reader.osm.pbf"};
+    write_blob_reader_test_file(filename);
+    const auto index = osmium::io::PBFBlobIndex::build(filename);
+
+    osmium::io::PBFBlobReader reader{filename};
+    REQUIRE(reader.header().get("generator") == "test");
+
+    std::size_t count = 0;
+    for (std::string data = reader.read(); !data.empty(); data = reader.read()) {
+        REQUIRE(count < index.size());
+        REQUIRE(reader.offset() == index.entries()[count].offset);
+        REQUIRE(data.size() == index.entries()[count].size);
+        ++count;
+    }
+    REQUIRE(count == index.size());
+    REQUIRE(reader.read().empty());
+}
+
+TEST_CASE("Copy raw blobs from PBF file to PBF file") {
+    const std::string filename{"test-pbf-blob-reader-copy-in.osm.pbf"};
+    write_blob_reader_test_file(filename);
+
+    osmium::io::PBFBlobReader reader{filename};
+    const osmium::io::File output{"test-pbf-blob-reader-copy-out.osm.pbf"};
+    REQUIRE(osmium::io::pbf_raw_blobs_compatible(reader.header(), output));
+
+    osmium::io::Writer writer{output, reader.header(), osmium::io::overwrite::allow};
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_relation(buffer, _id(1), _version(1));
+    const auto copied = osmium::io::copy_pbf_blobs(reader, writer);
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(copied == osmium::io::PBFBlobIndex::build(filename).size());
+    REQUIRE(count_objects(output.filename()) == 20101);
+}
+
+TEST_CASE("Check compatibility of PBF blobs with output file") {
+    osmium::io::Header header;
+
+    REQUIRE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.osm.pbf"}));
+    REQUIRE_FALSE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.opl"}));
+    REQUIRE_FALSE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.osh.pbf"}));
+    REQUIRE_FALSE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.osm.pbf", "pbf,locations_on_ways=true"}));
+    REQUIRE_FALSE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.osm.pbf", "pbf,pbf_check_order=true"}));
+    REQUIRE_FALSE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.osm.pbf", "pbf,pbf_index_sidecar=out.idx"}));
+
+    header.set("pbf_optional_feature_0", "LocationsOnWays");
+    REQUIRE_FALSE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.osm.pbf"}));
+    REQUIRE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.osm.pbf", "pbf,locations_on_ways=true"}));
+
+    header.set_has_multiple_object_versions(true);
+    REQUIRE(osmium::io::pbf_raw_blobs_compatible(header, osmium::io::File{"out.osh.pbf", "pbf,locations_on_ways=true"}));
+}
+
+TEST_CASE("Writer refuses raw blobs for output with blob index") {
+    const std::string filename{"test-pbf-blob-reader-refuse.osm.pbf"};
+    write_blob_reader_test_file(filename);
+
+    osmium::io::PBFBlobReader reader{filename};
+    osmium::io::Writer writer{osmium::io::File{"test-pbf-blob-reader-refuse-out.osm.pbf", "pbf,pbf_index_sidecar=test-pbf-blob-reader-refuse-out.idx"}, osmium::io::overwrite::allow};
+    REQUIRE_THROWS_AS(osmium::io::copy_pbf_blobs(reader, writer), const osmium::io_error&);
+}
@@ -0,0 +1,127 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/index/map/sparse_mem_array.hpp>
+#include <osmium/io/pbf_input.hpp>
+#include <osmium/io/pbf_node_locations.hpp>
+#include <osmium/io/pbf_output.hpp>
+#include <osmium/io/writer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+// Writes 20000 nodes, every tenth of them tagged, and some ways.
+static void write_node_locations_test_file(const std::string& filename, const char* format) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        if (id % 10 == 0) {
+            osmium::builder::add_node(buffer,
+                _id(id),
+                _version(1),
+                _location(1.0 + 0.0001 * id, -2.0 - 0.0001 * id),
+                _tag("foo", "bar")
+            );
+        } else {
+            osmium::builder::add_node(buffer,
+                _id(id),
+                _version(1),
+                _location(1.0 + 0.0001 * id, -2.0 - 0.0001 * id)
+            );
+        }
+    }
+
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_way(buffer,
+            _id(id),
+            _version(1),
+            _nodes({id, id + 1})
+        );
+    }
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+}
+
+static void check_node_locations(const std::string& filename) {
+    osmium::object_id_type expected_id = 1;
+    int blocks = 0;
+
+    osmium::io::read_pbf_node_locations(filename, [&](const osmium::io::node_locations_block& block) {
+        ++blocks;
+        REQUIRE(block.locations.size() == block.size());
+        REQUIRE(block.has_tags.size() == block.size());
+        for (std::size_t i = 0; i < block.size(); ++i) {
+            REQUIRE(block.ids[i] == expected_id);
+            REQUIRE(block.locations[i] == osmium::Location(1.0 + 0.0001 * expected_id, -2.0 - 0.0001 * expected_id));
+            REQUIRE(block.has_tags[i] == (expected_id % 10 == 0));
+            ++expected_id;
+        }
+    });
+
+    REQUIRE(blocks == 3);
+    REQUIRE(expected_id == 20001);
+}
+
+TEST_CASE("Read node locations from PBF file with dense nodes") {
+    const std::string filename{"test_pbf_node_locations_dense.osm.pbf"};
+    write_node_locations_test_file(filename, "pbf,pbf_compression=none");
+
+    check_node_locations(filename);
+}
+
+TEST_CASE("Read node locations from PBF file with non-dense nodes") {
+    const std::string filename{"test_pbf_node_locations_sparse.osm.pbf"};
+    write_node_locations_test_file(filename, "pbf,pbf_compression=none,pbf_dense_nodes=false");
+
+    check_node_locations(filename);
+}
+
+TEST_CASE("Read node locations from compressed PBF file") {
+    const std::string filename{"test_pbf_node_locations_zlib.osm.pbf"};
+    write_node_locations_test_file(filename, "pbf");
+
+    check_node_locations(filename);
+}
+
+TEST_CASE("Read node locations from PBF file into index") {
+    const std::string filename{"test_pbf_node_locations_index.osm.pbf"};
+    write_node_locations_test_file(filename, "pbf,pbf_compression=none");
+
+    osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type, osmium::Location> index;
+    osmium::io::read_pbf_node_locations_into(filename, index);
+
+    REQUIRE(index.size() == 20000);
+    REQUIRE(index.get(1) == osmium::Location(1.0001, -2.0001));
+    REQUIRE(index.get(20000) == osmium::Location(3.0, -4.0));
+}
+
+TEST_CASE("Reading node locations from a file that isn't a PBF file fails") {
+    const std::string filename{"test_pbf_node_locations_invalid.osm.pbf"};
+    {
+        std::ofstream file{filename};
+        file << "this is not a PBF file";
+    }
+
+    REQUIRE_THROWS_AS([&filename]() {
+        osmium::io::read_pbf_node_locations(filename, [](const osmium::io::node_locations_block&) {});
+    }(), const osmium::pbf_error&);
+}
+
+TEST_CASE("Reading node locations from an empty file fails") {
+    const std::string filename{"test_pbf_node_locations_empty.osm.pbf"};
+    {
+        std::ofstream file{filename};
+    }
+
+    REQUIRE_THROWS_AS([&filename]() {
+        osmium::io::read_pbf_node_locations(filename, [](const osmium::io::node_locations_block&) {});
+    }(), const osmium::pbf_error&);
+}
@@ -0,0 +1,90 @@
+#include "catch.hpp"
+
+#include <osmium/io/detail/pbf_packed.hpp>
+
+#include <protozero/pbf_writer.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+static std::string encode_packed(const std::vector<int64_t>& values) {
+    std::string data;
+    protozero::pbf_writer writer{data};
+    writer.add_packed_sint64(1, values.cbegin(), values.cend());
+
+    // strip tag and length of the packed field
+    const char* d = data.data() + 1;
+    protozero::decode_varint(&d, data.data() + data.size());
+    return std::string{d, data.data() + data.size()};
+}
+
+static std::vector<int64_t> decode_packed(const std::string& data) {
+    std::vector<int64_t> values;
+    osmium::io::detail::decode_packed_sint64(data.data(), data.size(), values);
+    return values;
+}
+
+TEST_CASE("Decode packed sint64 field with small values") {
+    std::vector<int64_t> values;
+    for (int64_t i = -30; i < 30; ++i) {
+        values.push_back(i);
+    }
+    REQUIRE(decode_packed(encode_packed(values)) == values);
+}
+
+TEST_CASE("Decode packed sint64 field with mixed values") {
+    std::vector<int64_t> values;
+    for (int64_t i = 0; i < 1000; ++i) {
+        values.push_back(i % 7 == 0 ? i * 1000003 : (i % 2 ? 1 : -1));
+    }
+    values.push_back(std::numeric_limits<int64_t>::max());
+    values.push_back(std::numeric_limits<int64_t>::min());
+    values.push_back(0);
+    REQUIRE(decode_packed(encode_packed(values)) == values);
+}
+
+TEST_CASE("Decode empty packed sint64 field") {
+    REQUIRE(decode_packed(std::string{}).empty());
+}
+
+TEST_CASE("Decode packed sint64 field with truncated varint") {
+    std::vector<int64_t> values(20, 1);
+    values.push_back(1000000);
+    std::string data{encode_packed(values)};
+    data.resize(data.size() - 1);
+    REQUIRE_THROWS_AS(decode_packed(data), const protozero::end_of_buffer_exception&);
+}
+
+TEST_CASE("Decode packed sint64 field with too long varint") {
+    const std::string data(20, '\xff');
+    REQUIRE_THROWS_AS(decode_packed(data), const protozero::varint_too_long_exception&);
+}
+
+TEST_CASE("Delta decode in place") {
+    std::vector<int64_t> values{5, 1, 1, -3, 10};
+    osmium::io::detail::delta_decode_in_place(values);
+    const std::vector<int64_t> expected{5, 6, 7, 4, 14};
+    REQUIRE(values == expected);
+}
+
+TEST_CASE("Decode packed int32 field") {
+    std::vector<int32_t> values;
+    for (int32_t i = 0; i < 300; ++i) {
+        values.push_back(i % 3 == 0 ? i * 1000 : i % 3);
+    }
+    values.push_back(std::numeric_limits<int32_t>::max());
+    values.push_back(-1);
+    values.push_back(std::numeric_limits<int32_t>::min());
+
+    std::string data;
+    protozero::pbf_writer writer{data};
+    writer.add_packed_int32(1, values.cbegin(), values.cend());
+    const char* d = data.data() + 1;
+    protozero::decode_varint(&d, data.data() + data.size());
+
+    std::vector<int32_t> result;
+    osmium::io::detail::decode_packed_int32(d, static_cast<std::size_t>(data.data() + data.size() - d), result);
+    REQUIRE(result == values);
+}
@@ -0,0 +1,78 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/pipeline_stats.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/io/xml_output.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/util/file.hpp>
+
+#include <chrono>
+#include <string>
+
+TEST_CASE("Duration histogram") {
+    osmium::io::DurationHistogram histogram;
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.total() == std::chrono::nanoseconds{0});
+
+    histogram.add(std::chrono::nanoseconds{500});
+    histogram.add(std::chrono::microseconds{1});
+    histogram.add(std::chrono::microseconds{3});
+    histogram.add(std::chrono::microseconds{3});
+    histogram.add(std::chrono::hours{1000});
+
+    REQUIRE(histogram.count() == 5);
+    REQUIRE(histogram.max() == std::chrono::hours{1000});
+    REQUIRE(histogram.bucket(0) == 1);
+    REQUIRE(histogram.bucket(1) == 1);
+    REQUIRE(histogram.bucket(2) == 2);
+    REQUIRE(histogram.bucket(osmium::io::DurationHistogram::num_buckets - 1) == 1);
+    REQUIRE(histogram.bucket(osmium::io::DurationHistogram::num_buckets) == 0);
+}
+
+TEST_CASE("Reader records pipeline stats") {
+    const std::string filename = with_data_dir("t/io/data.osm");
+
+    osmium::io::PipelineStats stats;
+    osmium::io::Reader reader{filename, stats};
+    std::size_t buffers = 0;
+    while (const auto buffer = reader.read()) {
+        ++buffers;
+    }
+    reader.close();
+
+    REQUIRE(buffers == 1);
+    REQUIRE(stats.bytes_read == osmium::file_size(filename));
+    REQUIRE(stats.read.count() >= 1);
+    REQUIRE(stats.parser_input_wait.count() >= 1);
+    REQUIRE(stats.reader_wait.count() == 2);
+    REQUIRE(stats.handler.count() == 1);
+    REQUIRE(stats.encode.count() == 0);
+}
+
+TEST_CASE("Reader without pipeline stats doesn't record anything") {
+    osmium::io::PipelineStats stats;
+    osmium::io::Reader reader{with_data_dir("t/io/data.opl")};
+    while (reader.read()) {
+    }
+    reader.close();
+    REQUIRE(stats.bytes_read == 0);
+}
+
+TEST_CASE("Writer records pipeline stats") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, osmium::builder::attr::_id(1));
+
+    osmium::io::PipelineStats stats;
+    osmium::io::Writer writer{"test-pipeline-stats.osm", osmium::io::overwrite::allow, stats};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(stats.encode.count() == 1);
+    REQUIRE(stats.write.count() >= 1);
+    REQUIRE(stats.bytes_written == osmium::file_size("test-pipeline-stats.osm"));
+    REQUIRE(stats.bytes_read == 0);
+}
@@ -0,0 +1,60 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/opl_input.hpp>
+#include <osmium/io/read_header.hpp>
+#include <osmium/io/xml_input.hpp>
+
+#include <string>
+
+TEST_CASE("Read header of XML file") {
+    const auto header = osmium::io::read_header(osmium::io::File{with_data_dir("t/io/data.osm")});
+    REQUIRE(header.get("generator") == "testdata");
+    REQUIRE_FALSE(header.has_multiple_object_versions());
+}
+
+TEST_CASE("Read header of compressed XML file") {
+    const auto header = osmium::io::read_header(osmium::io::File{with_data_dir("t/io/data.osm.gz")});
+    REQUIRE(header.get("generator") == "testdata");
+}
+
+TEST_CASE("Read header of XML data in buffer") {
+    const std::string data{
+        "<?xml version='1.0' encoding='UTF-8'?>\n"
+        "<osm version=\"0.6\" generator=\"probe\">\n"
+        "  <bounds minlon=\"1\" minlat=\"2\" maxlon=\"3\" maxlat=\"4\"/>\n"
+        "  <node id=\"1\" version=\"1\" lon=\"1.5\" lat=\"2.5\"/>\n"
+        "</osm>\n"
+    };
+
+    const auto header = osmium::io::read_header(osmium::io::File{data.data(), data.size(), "osm"});
+    REQUIRE(header.get("generator") == "probe");
+    REQUIRE(header.box() == (osmium::Box{1.0, 2.0, 3.0, 4.0}));
+}
+
+TEST_CASE("Read header of XML data stops before the objects") {
+    const std::string data{
+        "<?xml version='1.0' encoding='UTF-8'?>\n"
+        "<osm version=\"0.6\" generator=\"probe\">\n"
+        "  <node id=\"1\" version=\"1\" lon=\"1.5\" lat=\"2.5\"/>\n"
+        "  <this is not valid"
+    };
+
+    const auto header = osmium::io::read_header(osmium::io::File{data.data(), data.size(), "osm"});
+    REQUIRE(header.get("generator") == "probe");
+}
+
+TEST_CASE("Read header of OPL file") {
+    const auto header = osmium::io::read_header(osmium::io::File{with_data_dir("t/io/data.opl")});
+    REQUIRE(header.boxes().empty());
+}
+
+TEST_CASE("Read header of empty XML file fails") {
+    REQUIRE_THROWS_AS(osmium::io::read_header(osmium::io::File{with_data_dir("t/io/empty_file"), "osm"}), const osmium::io_error&);
+}
+
+TEST_CASE("Read header of nonexistent file fails") {
+    REQUIRE_THROWS(osmium::io::read_header(osmium::io::File{with_data_dir("t/io/nonexistent-file.osm")}));
+}
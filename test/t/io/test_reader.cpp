@@ -9,7 +9,10 @@
 #include <osmium/memory/buffer.hpp>
 #include <osmium/visitor.hpp>
 
+#include <cstring>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 struct CountHandler : public osmium::handler::Handler {
 
@@ -342,3 +345,39 @@ TEST_CASE("Can not read after close") {
     REQUIRE(count == count_fds());
 }
 
+
+TEST_CASE("Reader with tag prefilter on XML data") {
+    const std::string data{
+        "<?xml version='1.0' encoding='UTF-8'?>\n"
+        "<osm version=\"0.6\" generator=\"testdata\">\n"
+        "  <node id=\"1\" version=\"1\" lon=\"1.0\" lat=\"1.0\">\n"
+        "    <tag k=\"amenity\" v=\"pub\"/>\n"
+        "  </node>\n"
+        "  <node id=\"2\" version=\"1\" lon=\"2.0\" lat=\"2.0\">\n"
+        "    <tag k=\"amenity\" v=\"bench\"/>\n"
+        "  </node>\n"
+        "  <node id=\"3\" version=\"1\" lon=\"3.0\" lat=\"3.0\"/>\n"
+        "  <way id=\"1\" version=\"1\">\n"
+        "    <nd ref=\"1\"/>\n"
+        "    <nd ref=\"2\"/>\n"
+        "  </way>\n"
+        "</osm>\n"
+    };
+
+    const osmium::io::tag_prefilter prefilter{[](const char* key, const char* value) {
+        return !std::strcmp(key, "amenity") && !std::strcmp(value, "pub");
+    }, osmium::osm_entity_bits::node};
+
+    osmium::io::File file{data.data(), data.size(), "osm"};
+    osmium::io::Reader reader{file, prefilter};
+
+    std::vector<osmium::object_id_type> ids;
+    while (const auto buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            ids.push_back(object.type() == osmium::item_type::node ? object.id() : -object.id());
+        }
+    }
+    reader.close();
+
+    REQUIRE(ids == std::vector<osmium::object_id_type>({1, -1}));
+}
@@ -10,14 +10,22 @@
 #include <osmium/io/file_format.hpp>
 #include <osmium/io/header.hpp>
 #include <osmium/io/reader.hpp>
+#include <osmium/osm/metadata_options.hpp>
 #include <osmium/thread/queue.hpp>
 #include <osmium/thread/util.hpp>
 
+#include <chrono>
+#include <future>
 #include <memory>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <utility>
 
+static std::promise<void> gate;
+static osmium::io::read_meta last_read_metadata;
+static osmium::metadata_options last_read_metadata_fields;
+
 class MockParser : public osmium::io::detail::Parser {
 
     std::string m_fail_in;
@@ -33,12 +41,19 @@ public:
     void run() final {
         osmium::thread::set_thread_name("_osmium_mock_in");
 
+        last_read_metadata = read_metadata();
+        last_read_metadata_fields = read_metadata_fields();
+
         if (m_fail_in == "header") {
             throw std::runtime_error{"error in header"};
         }
 
         set_header_value(osmium::io::Header{});
 
+        if (m_fail_in == "gate") {
+            gate.get_future().wait();
+        }
+
         osmium::memory::Buffer buffer(1000);
         osmium::builder::add_node(buffer, osmium::builder::attr::_user("foo"));
         send_to_output_queue(std::move(buffer));
@@ -107,5 +122,59 @@ TEST_CASE("Test Reader using MockParser") {
         reader.close();
     }
 
-}
+    SECTION("non-blocking read") {
+        fail_in = "gate";
+        gate = std::promise<void>{};
+        osmium::io::Reader reader{with_data_dir("t/io/data.osm")};
+        reader.header();
+        REQUIRE(reader.header_ready());
+
+        osmium::memory::Buffer buffer;
+        const bool got_data = reader.try_read(buffer);
+        gate.set_value();
+        REQUIRE_FALSE(got_data);
+        REQUIRE_FALSE(buffer);
+
+        while (!reader.try_read(buffer)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        REQUIRE(buffer);
+        REQUIRE(buffer.committed() > 0);
+
+        while (!reader.try_read(buffer)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+        }
+        REQUIRE_FALSE(buffer);
+        REQUIRE(reader.eof());
+        reader.close();
+    }
+
+    SECTION("metadata options are passed to the parser") {
+        fail_in = "";
+        {
+            osmium::io::Reader reader{with_data_dir("t/io/data.osm")};
+            reader.header();
+            reader.close();
+        }
+        REQUIRE(last_read_metadata == osmium::io::read_meta::yes);
+        REQUIRE(last_read_metadata_fields.all());
+
+        {
+            osmium::io::Reader reader{with_data_dir("t/io/data.osm"), osmium::metadata_options{"version+timestamp"}};
+            reader.header();
+            reader.close();
+        }
+        REQUIRE(last_read_metadata == osmium::io::read_meta::yes);
+        REQUIRE(last_read_metadata_fields.version());
+        REQUIRE(last_read_metadata_fields.timestamp());
+        REQUIRE_FALSE(last_read_metadata_fields.user());
 
+        {
+            osmium::io::Reader reader{with_data_dir("t/io/data.osm"), osmium::metadata_options{"none"}};
+            reader.header();
+            reader.close();
+        }
+        REQUIRE(last_read_metadata == osmium::io::read_meta::no);
+    }
+
+}
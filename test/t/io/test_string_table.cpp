@@ -3,8 +3,11 @@
 #include <osmium/io/detail/string_table.hpp>
 #include <osmium/util/misc.hpp>
 
+#include <cstddef>
+#include <cstdint>
 #include <iterator>
 #include <string>
+#include <vector>
 
 TEST_CASE("Empty StringStore") {
     const osmium::io::detail::StringStore ss{100};
@@ -138,3 +141,75 @@ TEST_CASE("Lots of strings in string table so chunk overflows") {
     REQUIRE(it == st.end());
 }
 
+TEST_CASE("Lots of strings in string table with clear in between") {
+    osmium::io::detail::StringTable st{100};
+
+    for (int round = 0; round < 3; ++round) {
+        const int n = 5000;
+        for (int i = 0; i < n; ++i) {
+            const auto s = std::to_string(i + round);
+            REQUIRE(st.add(s.c_str()) == i + 1);
+        }
+        for (int i = 0; i < n; ++i) {
+            const auto s = std::to_string(i + round);
+            REQUIRE(st.add(s.c_str()) == i + 1);
+        }
+        REQUIRE(st.size() == n + 1);
+
+        auto it = st.begin();
+        REQUIRE(std::string{} == *it++);
+        for (int i = 0; i < n; ++i) {
+            REQUIRE(osmium::detail::str_to_int<int>(*it++) == i + round);
+        }
+        REQUIRE(it == st.end());
+
+        st.clear();
+        REQUIRE(st.size() == 1);
+        REQUIRE(std::next(st.begin()) == st.end());
+    }
+}
+
+TEST_CASE("StringStore re-uses chunks after clear") {
+    osmium::io::detail::StringStore ss{100};
+    std::size_t chunk_count = 0;
+
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 200; ++i) {
+            ss.add("abcde");
+        }
+        REQUIRE(ss.get_chunk_count() > 1);
+        if (round == 0) {
+            chunk_count = ss.get_chunk_count();
+        }
+        REQUIRE(ss.get_chunk_count() == chunk_count);
+
+        int count = 0;
+        for (const char* s : ss) {
+            REQUIRE(std::string{s} == "abcde");
+            ++count;
+        }
+        REQUIRE(count == 200);
+
+        ss.clear();
+        REQUIRE(ss.get_chunk_count() == 1);
+        REQUIRE(ss.begin() == ss.end());
+    }
+}
+
+TEST_CASE("Get StringTable ids by frequency") {
+    osmium::io::detail::StringTable st;
+
+    REQUIRE(st.add("name") == 1);
+    REQUIRE(st.add("highway") == 2);
+    REQUIRE(st.add("residential") == 3);
+    REQUIRE(st.add("highway") == 2);
+    REQUIRE(st.add("highway") == 2);
+    REQUIRE(st.add("residential") == 3);
+
+    const auto ids = st.ids_by_frequency();
+    REQUIRE(ids == std::vector<int32_t>({0, 3, 1, 2}));
+
+    st.clear();
+    REQUIRE(st.add("foo") == 1);
+    REQUIRE(st.ids_by_frequency() == std::vector<int32_t>({0, 1}));
+}
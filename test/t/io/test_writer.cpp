@@ -2,14 +2,21 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/io/any_compression.hpp>
+#include <osmium/io/debug_output.hpp>
+#include <osmium/io/o5m_output.hpp>
+#include <osmium/io/opl_output.hpp>
 #include <osmium/io/output_iterator.hpp>
 #include <osmium/io/xml_input.hpp>
 #include <osmium/io/xml_output.hpp>
 #include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_selection.hpp>
 
 #include <algorithm>
+#include <fstream>
 #include <iterator>
+#include <limits>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -223,3 +230,247 @@ TEST_CASE("Writer with user-provided pool with outlier positive number of thread
     REQUIRE(count == count_fds());
 }
 
+
+TEST_CASE("Writer with pipeline configuration keeps statistics") {
+    const int count = count_fds();
+
+    auto buffer = get_buffer();
+    const auto size = buffer.committed();
+
+    osmium::io::Writer writer{"test-writer-pipeline.osm",
+                              osmium::io::writer_pipeline{2, 1024 * 1024},
+                              osmium::io::overwrite::allow};
+    REQUIRE(writer.buffer_size() == 1024 * 1024);
+    writer(std::move(buffer));
+    writer.close();
+
+    const auto stats = writer.statistics();
+    REQUIRE(stats.buffers == 1);
+    REQUIRE(stats.input_bytes == size);
+    REQUIRE(stats.encode_time >= stats.max_encode_time);
+    REQUIRE(stats.output_queue_largest <= 2);
+    REQUIRE(stats.output_queue_size == 0);
+    REQUIRE(stats.bytes_written > 0);
+
+    REQUIRE(count == count_fds());
+}
+
+TEST_CASE("Writer with coalesce flush policy combines small buffers") {
+    const auto buffer = get_buffer();
+
+    osmium::io::Writer writer{"test-writer-pipeline-coalesce.osm",
+                              osmium::io::writer_pipeline{osmium::io::writer_pipeline::automatic(),
+                                                          osmium::io::writer_pipeline::automatic(),
+                                                          osmium::io::flush_policy::coalesce},
+                              osmium::io::overwrite::allow};
+    for (int i = 0; i < 5; ++i) {
+        osmium::memory::Buffer copy{buffer.committed()};
+        copy.add_buffer(buffer);
+        copy.commit();
+        writer(std::move(copy));
+    }
+    writer.close();
+
+    REQUIRE(writer.statistics().buffers == 1);
+    REQUIRE(writer.statistics().input_bytes == 5 * buffer.committed());
+
+    osmium::io::Reader reader{"test-writer-pipeline-coalesce.osm"};
+    std::size_t num = 0;
+    while (const auto b = reader.read()) {
+        num += std::distance(b.select<osmium::OSMObject>().cbegin(), b.select<osmium::OSMObject>().cend());
+    }
+    reader.close();
+
+    const auto expected = std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend());
+    REQUIRE(num == 5 * static_cast<std::size_t>(expected));
+}
+
+TEST_CASE("Writer with parallel compression") {
+    const int count = count_fds();
+
+    auto buffer = get_buffer();
+    const auto num = std::distance(buffer.select<osmium::OSMObject>().cbegin(), buffer.select<osmium::OSMObject>().cend());
+
+    std::string filename;
+
+    SECTION("gzip") {
+        filename = "test-writer-parallel-compression.osm.gz";
+    }
+
+    SECTION("bzip2") {
+        filename = "test-writer-parallel-compression.osm.bz2";
+    }
+
+    SECTION("no compression") {
+        filename = "test-writer-parallel-compression.osm";
+    }
+
+    osmium::thread::Pool pool{2};
+    osmium::io::Writer writer{filename, pool, osmium::io::parallel_compression::yes, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    REQUIRE(count == count_fds());
+
+    osmium::io::Reader reader{filename, pool, osmium::io::parallel_decompression::yes};
+    const auto buffer_check = reader.read();
+    reader.close();
+    REQUIRE(buffer_check);
+    REQUIRE(std::distance(buffer_check.select<osmium::OSMObject>().cbegin(), buffer_check.select<osmium::OSMObject>().cend()) == num);
+}
+
+TEST_CASE("Writer writes XML with extreme values and escaped strings") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer,
+        _id(std::numeric_limits<osmium::object_id_type>::min()),
+        _version(1),
+        _uid(4294967295u),
+        _user("a<b>"),
+        _location(-180.0, -90.0),
+        _tag("k&", "\"v\"\n")
+    );
+    osmium::builder::add_way(buffer, _id(9223372036854775807), _nodes({-1, 0}));
+
+    const std::string filename = "test-writer-xml-values.osm";
+    osmium::io::Writer writer{filename, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    std::ifstream in{filename};
+    const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    REQUIRE(content.find(
+        "  <node id=\"-9223372036854775808\" version=\"1\" uid=\"4294967295\" user=\"a&lt;b&gt;\" lat=\"-90\" lon=\"-180\">\n"
+        "    <tag k=\"k&amp;\" v=\"&quot;v&quot;&#xA;\"/>\n"
+        "  </node>\n"
+        "  <way id=\"9223372036854775807\">\n"
+        "    <nd ref=\"-1\"/>\n"
+        "    <nd ref=\"0\"/>\n"
+        "  </way>\n") != std::string::npos);
+}
+
+TEST_CASE("Writer writes OPL with locations on ways") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(-3), _location(-180.0, 1.5), _tag("a b", "c,d"));
+    osmium::builder::add_way(buffer, _id(4), _node(osmium::NodeRef{1, osmium::Location{2.25, -1.0}}), _node(2));
+
+    const std::string filename = "test-writer-opl-values.osm.opl";
+    osmium::io::Writer writer{osmium::io::File{filename, "opl,add_metadata=false,locations_on_ways=true"}, osmium::io::overwrite::allow};
+    writer(std::move(buffer));
+    writer.close();
+
+    std::ifstream in{filename};
+    const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    REQUIRE(content ==
+        "n-3 Ta%20%b=c%2c%d x-180 y1.5\n"
+        "w4 T Nn1x2.25y-1,n2xy\n");
+}
+
+static osmium::memory::Buffer get_debug_test_buffer() {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(-3), _version(2), _timestamp(osmium::Timestamp{"2018-01-01T00:00:00Z"}), _uid(5), _user("a\"b"), _location(-180.0, 1.5), _tag("a b", "c<d>"));
+    osmium::builder::add_way(buffer, _id(4), _node(osmium::NodeRef{1, osmium::Location{2.25, -1.0}}), _node(-22));
+    osmium::builder::add_relation(buffer, _id(5), _member(osmium::item_type::way, 4, "outer"), _member(osmium::item_type::node, 1, ""));
+    return buffer;
+}
+
+static std::string write_debug(const std::string& filename, const std::string& format) {
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    writer(get_debug_test_buffer());
+    writer.close();
+
+    std::ifstream in{filename};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Writer writes debug format") {
+    const std::string content{write_debug("test-writer-debug.debug", "debug,add_metadata=version+timestamp,add_crc32=true")};
+
+    REQUIRE(content.find("node -3 visible\n  version:   2\n  timestamp: 2018-01-01T00:00:00Z (1514764800)\n") != std::string::npos);
+    REQUIRE(content.find("  lon/lat:   -180,1.5\n") != std::string::npos);
+    REQUIRE(content.find("    \"a b\" = \"c<U+003C>d<U+003E>\"\n") != std::string::npos);
+    REQUIRE(content.find("    0:          1 (2.25,-1)\n    1:        -22\n") != std::string::npos);
+    REQUIRE(content.find("    0: way           4 \"outer\"\n    1: node          1 \"\"\n") != std::string::npos);
+    REQUIRE(content.find("  crc32:     1e1d069d\n") != std::string::npos);
+    REQUIRE(content.find('%') == std::string::npos);
+}
+
+TEST_CASE("Writer writes compact debug format") {
+    const std::string content{write_debug("test-writer-debug-compact.debug", "debug,compact=true,color=true")};
+
+    REQUIRE(content ==
+        "node -3 visible version=2 changeset=0 timestamp=2018-01-01T00:00:00Z uid=5 user=\"a<U+0022>b\" lon/lat=-180,1.5 tags={\"a b\"=\"c<U+003C>d<U+003E>\"}\n"
+        "way 4 visible version=0 changeset=0 timestamp= uid=0 user=\"\" nodes=[1(2.25,-1) -22]\n"
+        "relation 5 visible version=0 changeset=0 timestamp= uid=0 user=\"\" members=[w4@\"outer\" n1@\"\"]\n");
+}
+
+TEST_CASE("Writer writes compact debug format with crc32 and without metadata") {
+    const std::string content{write_debug("test-writer-debug-compact-crc.debug", "debug,compact=true,add_metadata=false,add_crc32=true")};
+
+    REQUIRE(content.substr(0, 49) == "node -3 visible lon/lat=-180,1.5 tags={\"a b\"=\"c<U");
+    REQUIRE(std::count(content.begin(), content.end(), '\n') == 3);
+    REQUIRE(content.find(" crc32=") != std::string::npos);
+}
+
+static std::string write_selection(const std::string& filename, const std::string& format, bool copy) {
+    osmium::memory::BufferSelection selection{get_debug_test_buffer()};
+    for (const auto& object : selection.buffer().select<osmium::OSMObject>()) {
+        if (object.id() != 4) {
+            selection.add(object);
+        }
+    }
+    REQUIRE(selection.size() == 2);
+
+    osmium::io::Writer writer{osmium::io::File{filename, format}, osmium::io::overwrite::allow};
+    if (copy) {
+        writer(selection.copy());
+    } else {
+        writer(std::move(selection));
+    }
+    writer.close();
+
+    std::ifstream in{filename};
+    return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+}
+
+TEST_CASE("Writer writes buffer selection") {
+    for (const char* format : {"opl", "xml", "o5m", "debug,add_crc32=true"}) {
+        const std::string content{write_selection("test-writer-selection.out", format, false)};
+        REQUIRE_FALSE(content.empty());
+        REQUIRE(content == write_selection("test-writer-selection-copy.out", format, true));
+    }
+}
+
+TEST_CASE("Writer writes empty buffer selection") {
+    osmium::io::Writer writer{osmium::io::File{"test-writer-selection-empty.opl"}, osmium::io::overwrite::allow};
+    writer(osmium::memory::BufferSelection{get_debug_test_buffer()});
+    writer.close();
+
+    std::ifstream in{"test-writer-selection-empty.opl"};
+    const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    REQUIRE(content.empty());
+}
+
+TEST_CASE("Writer does not write raw data to formats which don't support it") {
+    osmium::io::Writer writer{"test-writer-raw.opl", osmium::io::overwrite::allow};
+    REQUIRE_FALSE(writer.write_raw(std::string{"n1 v1"}, osmium::io::file_format::opl));
+    REQUIRE_FALSE(writer.write_raw(std::string{"data"}, osmium::io::file_format::pbf));
+    writer.close();
+
+    std::ifstream in{"test-writer-raw.opl"};
+    const std::string content{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    REQUIRE(content.empty());
+}
+
+TEST_CASE("Writer throws for way node locations lookup on unsupported format") {
+    const osmium::io::way_node_locations lookup{[](osmium::object_id_type /*id*/) {
+        return osmium::Location{};
+    }};
+
+    REQUIRE_THROWS_AS(osmium::io::Writer(osmium::io::File{"test-writer-way-node-locations.opl"}, lookup, osmium::io::overwrite::allow), const std::invalid_argument&);
+}
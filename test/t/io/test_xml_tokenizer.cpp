@@ -0,0 +1,305 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Records all callbacks in a string.
+struct RecordingHandler {
+
+    std::string log;
+
+    void start_element(const char* element, const char** attrs) {
+        log += '<';
+        log += element;
+        for (; *attrs; attrs += 2) {
+            log += ' ';
+            log += attrs[0];
+            log += "=[";
+            log += attrs[1];
+            log += ']';
+        }
+        log += '>';
+    }
+
+    void end_element(const char* element) {
+        log += "</";
+        log += element;
+        log += '>';
+    }
+
+    void characters(const char* text, int len) {
+        log += '|';
+        log.append(text, static_cast<std::size_t>(len));
+        log += '|';
+    }
+
+}; // struct RecordingHandler
+
+static std::string tokenize(const std::string& input) {
+    RecordingHandler handler;
+    osmium::io::detail::XMLTokenizer<RecordingHandler> tokenizer{handler};
+    REQUIRE(tokenizer(std::string{input}, true));
+    return handler.log;
+}
+
+// Give the input to the tokenizer one byte at a time
+static std::string tokenize_bytewise(const std::string& input) {
+    RecordingHandler handler;
+    osmium::io::detail::XMLTokenizer<RecordingHandler> tokenizer{handler};
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        REQUIRE(tokenizer(std::string(1, input[i]), i == input.size() - 1));
+    }
+    return handler.log;
+}
+
+TEST_CASE("XML tokenizer: elements and attributes") {
+    const std::string input{"<?xml version='1.0' encoding='UTF-8'?>\n<osm version=\"0.6\"><node id='1' lat=\"1.5\" ><tag k=\"a\" v='b'/></node></osm>\n"};
+    const std::string expected{"<osm version=[0.6]><node id=[1] lat=[1.5]><tag k=[a] v=[b]></tag></node></osm>"};
+    REQUIRE(tokenize(input) == expected);
+    REQUIRE(tokenize_bytewise(input) == expected);
+}
+
+TEST_CASE("XML tokenizer: references and normalization") {
+    const std::string input{"<a v=\"&lt;&gt;&amp;&quot;&apos;&#65;&#x42;&#xe4;\" w='x\ty\r\nz'>1&amp;2\r\n3<![CDATA[<&>]]><!-- <b> --></a>"};
+    const std::string expected{"<a v=[<>&\"'AB\xc3\xa4] w=[x y z]>|1&2\n3||<&>|</a>"};
+    REQUIRE(tokenize(input) == expected);
+    REQUIRE(tokenize_bytewise(input) == expected);
+}
+
+TEST_CASE("XML tokenizer: byte order mark and whitespace around root") {
+    REQUIRE(tokenize("\xef\xbb\xbf<a/>") == "<a></a>");
+    REQUIRE(tokenize("\n <a/>\n\n") == "<a></a>");
+    REQUIRE(tokenize("<a></a ><!-- end -->") == "<a></a>");
+}
+
+TEST_CASE("XML tokenizer: unsupported input") {
+    RecordingHandler handler;
+    osmium::io::detail::XMLTokenizer<RecordingHandler> tokenizer{handler};
+
+    SECTION("document type declaration") {
+        const std::string input{"<?xml version='1.0'?>\n<!DOCTYPE osm>\n<osm/>"};
+        REQUIRE_FALSE(tokenizer(std::string{input}, true));
+        REQUIRE(tokenizer.buffered_data() == input);
+    }
+
+    SECTION("other encoding") {
+        const std::string input{"<?xml version='1.0' encoding='ISO-8859-1'?>\n<osm/>"};
+        REQUIRE_FALSE(tokenizer(std::string{input}, true));
+        REQUIRE(tokenizer.buffered_data() == input);
+    }
+
+    SECTION("document type declaration in second chunk") {
+        REQUIRE(tokenizer(std::string{"<?xml version='1.0'?>\n"}, false));
+        REQUIRE_FALSE(tokenizer(std::string{"<!DOCTYPE osm><osm/>"}, true));
+        REQUIRE(tokenizer.buffered_data() == "<?xml version='1.0'?>\n<!DOCTYPE osm><osm/>");
+    }
+
+    REQUIRE(handler.log.empty());
+}
+
+static void check_error(const std::string& input, const char* message, uint64_t line, uint64_t column) {
+    RecordingHandler handler;
+    osmium::io::detail::XMLTokenizer<RecordingHandler> tokenizer{handler};
+    try {
+        tokenizer(std::string{input}, true);
+        REQUIRE(false);
+    } catch (const osmium::xml_error& e) {
+        REQUIRE(e.error_string == message);
+        REQUIRE(e.line == line);
+        REQUIRE(e.column == column);
+    }
+}
+
+TEST_CASE("XML tokenizer: errors") {
+    check_error("", "no element found", 1, 0);
+    check_error("<a>", "no element found", 1, 3);
+    check_error("<a><b></a>", "mismatched tag", 1, 6);
+    check_error("<a>\n  <b x='1\"/></a>", "unclosed token", 2, 2);
+    check_error("<a x=1/>", "not well-formed (invalid token)", 1, 5);
+    check_error("<a x='&foo;'/>", "undefined entity", 1, 6);
+    check_error("<a x='&#0;'/>", "reference to invalid character number", 1, 6);
+    check_error("<a/>\n<b/>", "junk after document element", 2, 0);
+    check_error("x<a/>", "syntax error", 1, 0);
+}
+
+TEST_CASE("XML tokenizer: errors are reported with correct line after some chunks") {
+    RecordingHandler handler;
+    osmium::io::detail::XMLTokenizer<RecordingHandler> tokenizer{handler};
+    REQUIRE(tokenizer(std::string{"<a>\n<b/>\n<"}, false));
+    REQUIRE(tokenizer(std::string{"c/>\n"}, false));
+    try {
+        tokenizer(std::string{"<d></e>"}, true);
+        REQUIRE(false);
+    } catch (const osmium::xml_error& e) {
+        REQUIRE(e.line == 4);
+        REQUIRE(e.column == 3);
+    }
+}
+
+static std::vector<osmium::memory::Buffer> read_all(const std::string& filename, osmium::io::xml_tokenizer tokenizer) {
+    std::vector<osmium::memory::Buffer> buffers;
+    osmium::io::Reader reader{with_data_dir(filename.c_str()), tokenizer};
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        buffers.push_back(std::move(buffer));
+    }
+    reader.close();
+    return buffers;
+}
+
+static std::string contents(const std::vector<osmium::memory::Buffer>& buffers) {
+    std::string data;
+    for (const auto& buffer : buffers) {
+        data.append(reinterpret_cast<const char*>(buffer.data()), buffer.committed());
+    }
+    return data;
+}
+
+TEST_CASE("XML parser creates the same objects with both tokenizers") {
+    std::string filename;
+
+    SECTION("data") {
+        filename = "t/io/data.osm";
+    }
+
+    SECTION("history") {
+        filename = "t/io/deleted_nodes.osh";
+    }
+
+    const auto expat = read_all(filename, osmium::io::xml_tokenizer::expat);
+    const auto builtin = read_all(filename, osmium::io::xml_tokenizer::builtin);
+    REQUIRE_FALSE(expat.empty());
+    REQUIRE(contents(expat) == contents(builtin));
+}
+
+TEST_CASE("XML parser with builtin tokenizer falls back to Expat") {
+    const std::string input{"<?xml version='1.0'?>\n<!DOCTYPE osm>\n<osm version='0.6'><node id='7' version='1'/></osm>\n"};
+    osmium::io::Reader reader{osmium::io::File{input.data(), input.size(), "osm"}, osmium::io::xml_tokenizer::builtin};
+    const osmium::memory::Buffer buffer = reader.read();
+    REQUIRE(buffer);
+    REQUIRE(buffer.get<osmium::Node>(0).id() == 7);
+    reader.close();
+}
+
+TEST_CASE("XML parser with builtin tokenizer reports errors") {
+    const std::string input{"<osm version='0.6'><node id='7' version='1'></way></osm>"};
+    osmium::io::Reader reader{osmium::io::File{input.data(), input.size(), "osm"}, osmium::io::xml_tokenizer::builtin};
+    REQUIRE_THROWS_AS(reader.read(), const osmium::xml_error&);
+}
+
+TEST_CASE("XML splitter finds split points") {
+    const std::string data{"<?xml version='1.0'?>\n<osmChange version='0.6'>\n<!-- <node> -->\n <create>\n  <node id='1'/>\n  <way id='2'><nd ref='1'/></way>\n </create>\n <delete generator='a>b'>\n  <relation id='3'/>\n </delete>\n</osmChange>\n"};
+    osmium::io::detail::XMLSplitter splitter;
+    std::size_t pos = 0;
+
+    auto split = splitter.find(data, pos, 0);
+    REQUIRE(split == data.find("<create>"));
+    REQUIRE(splitter.open_elements() == std::vector<std::string>{"osmChange"});
+
+    split = splitter.find(data, pos, split + 1);
+    REQUIRE(split == data.find("<node id"));
+    REQUIRE(splitter.open_elements() == (std::vector<std::string>{"osmChange", "create"}));
+
+    split = splitter.find(data, pos, split + 1);
+    REQUIRE(split == data.find("<way"));
+
+    split = splitter.find(data, pos, split + 1);
+    REQUIRE(split == data.find("<delete"));
+    REQUIRE(splitter.open_elements() == std::vector<std::string>{"osmChange"});
+
+    split = splitter.find(data, pos, split + 1);
+    REQUIRE(split == data.find("<relation"));
+    REQUIRE(splitter.open_elements() == (std::vector<std::string>{"osmChange", "delete"}));
+
+    split = splitter.find(data, pos, split + 1);
+    REQUIRE(split == std::string::npos);
+}
+
+static std::string create_large_change_file() {
+    std::string data{"<?xml version='1.0' encoding='UTF-8'?>\n<osmChange version=\"0.6\" generator=\"test\">\n"};
+    const char* sections[] = {"create", "modify", "delete"};
+    int id = 1;
+    for (int i = 0; i < 30; ++i) {
+        data += "  <";
+        data += sections[i % 3];
+        data += ">\n";
+        for (int j = 0; j < 1000; ++j, ++id) {
+            const auto ids = std::to_string(id);
+            data += "    <node id=\"" + ids + "\" version=\"1\" timestamp=\"2015-01-01T01:00:00Z\" uid=\"1\" user=\"a &amp; b\" changeset=\"1\" lat=\"1.5\" lon=\"2.5\">\n";
+            data += "      <tag k=\"name\" v=\"n&#228;me " + ids + "\"/>\n";
+            data += "    </node>\n";
+            data += "    <way id=\"" + ids + "\" version=\"1\"><nd ref=\"1\"/><nd ref=\"" + ids + "\"/></way>\n";
+        }
+        data += "  </";
+        data += sections[i % 3];
+        data += ">\n";
+    }
+    data += "</osmChange>\n";
+    return data;
+}
+
+static std::string read_from_string(const std::string& input, osmium::io::xml_tokenizer tokenizer, const osmium::io::decode_window& window) {
+    osmium::io::Reader reader{osmium::io::File{input.data(), input.size(), "osc"}, tokenizer, window};
+    std::vector<osmium::memory::Buffer> buffers;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        buffers.push_back(std::move(buffer));
+    }
+    reader.close();
+    return contents(buffers);
+}
+
+TEST_CASE("XML parser in thread pool") {
+    const std::string input{create_large_change_file()};
+    REQUIRE(input.size() > 3 * osmium::io::detail::XMLParser::chunk_size);
+
+    const auto expat = read_from_string(input, osmium::io::xml_tokenizer::expat, osmium::io::decode_window{0});
+    const auto parallel = read_from_string(input, osmium::io::xml_tokenizer::builtin, osmium::io::decode_window{});
+    REQUIRE_FALSE(expat.empty());
+    REQUIRE(expat == parallel);
+
+    osmium::io::Reader reader{osmium::io::File{input.data(), input.size(), "osc"}, osmium::io::xml_tokenizer::builtin, osmium::io::decode_window{}};
+    REQUIRE(reader.header().has_multiple_object_versions());
+    REQUIRE(reader.header().get("generator") == "test");
+    std::size_t deleted = 0;
+    while (osmium::memory::Buffer buffer = reader.read()) {
+        for (const auto& object : buffer.select<osmium::OSMObject>()) {
+            if (!object.visible()) {
+                ++deleted;
+            }
+        }
+    }
+    reader.close();
+    REQUIRE(deleted == 20000);
+}
+
+TEST_CASE("XML parser in thread pool reports errors with line numbers") {
+    std::string input{create_large_change_file()};
+    const auto pos = input.find("<nd ref=\"25000\"/>");
+    REQUIRE(pos != std::string::npos);
+    input.replace(pos, 17, "<nd ref=\"25000\">");
+    const auto line = 1 + std::count(input.begin(), input.begin() + static_cast<std::ptrdiff_t>(pos), '\n');
+
+    osmium::io::Reader reader{osmium::io::File{input.data(), input.size(), "osc"}, osmium::io::xml_tokenizer::builtin, osmium::io::decode_window{}};
+    try {
+        while (reader.read()) {
+        }
+        REQUIRE(false);
+    } catch (const osmium::xml_error& e) {
+        REQUIRE(e.line == static_cast<uint64_t>(line));
+    }
+    reader.close();
+}
+
+TEST_CASE("XML parser in thread pool detects missing end of document") {
+    std::string input{create_large_change_file()};
+    input.resize(input.rfind("</osmChange>"));
+    osmium::io::Reader reader{osmium::io::File{input.data(), input.size(), "osc"}, osmium::io::xml_tokenizer::builtin, osmium::io::decode_window{}};
+    REQUIRE_THROWS_AS([&reader](){ while (reader.read()) {} }(), const osmium::xml_error&);
+    reader.close();
+}
@@ -0,0 +1,146 @@
+#include "catch.hpp"
+
+#include "utils.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/io/xml_input.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/buffer_allocator.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+class CountingAllocator : public osmium::memory::BufferAllocator {
+
+public:
+
+    std::atomic<std::size_t> count_allocate{0};
+    std::atomic<std::size_t> count_deallocate{0};
+    std::atomic<std::size_t> bytes{0};
+
+    unsigned char* allocate(std::size_t size) override {
+        ++count_allocate;
+        bytes += size;
+        return new unsigned char[size];
+    }
+
+    void deallocate(unsigned char* data, std::size_t size) noexcept override {
+        ++count_deallocate;
+        bytes -= size;
+        delete[] data;
+    }
+
+}; // class CountingAllocator
+
+TEST_CASE("Buffer without allocator") {
+    const osmium::memory::Buffer buffer{1024};
+    REQUIRE(buffer.allocator() == nullptr);
+
+    std::unique_ptr<unsigned char[]> data{new unsigned char[1024]};
+    const osmium::memory::Buffer buffer_with_data{std::move(data), 1024, 0};
+    REQUIRE(buffer_with_data.has_internal_memory());
+    REQUIRE(buffer_with_data.allocator() == nullptr);
+}
+
+TEST_CASE("Buffer with allocator") {
+    CountingAllocator allocator;
+
+    {
+        osmium::memory::Buffer buffer{1000, osmium::memory::Buffer::auto_grow::yes, allocator};
+        REQUIRE(buffer.allocator() == &allocator);
+        REQUIRE(buffer.capacity() == 1000);
+        REQUIRE(allocator.count_allocate == 1);
+        REQUIRE(allocator.bytes == 1000);
+
+        osmium::builder::add_node(buffer, _id(1));
+        buffer.grow(4096);
+        REQUIRE(allocator.count_allocate == 2);
+        REQUIRE(allocator.count_deallocate == 1);
+        REQUIRE(allocator.bytes == 4096);
+        REQUIRE(buffer.get<osmium::Node>(0).id() == 1);
+
+        const osmium::memory::Buffer moved{std::move(buffer)};
+        REQUIRE(moved.allocator() == &allocator);
+    }
+
+    REQUIRE(allocator.count_deallocate == 2);
+    REQUIRE(allocator.bytes == 0);
+}
+
+TEST_CASE("Buffer with allocator growing internally") {
+    CountingAllocator allocator;
+
+    {
+        osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::internal, allocator};
+        for (int id = 1; id <= 20; ++id) {
+            osmium::builder::add_node(buffer, _id(id));
+        }
+        REQUIRE(buffer.has_nested_buffers());
+        REQUIRE(allocator.count_allocate > 1);
+
+        const std::unique_ptr<osmium::memory::Buffer> nested{buffer.get_last_nested()};
+        REQUIRE(nested->allocator() == &allocator);
+    }
+
+    REQUIRE(allocator.count_allocate == allocator.count_deallocate);
+    REQUIRE(allocator.bytes == 0);
+}
+
+TEST_CASE("Buffer pool with allocator") {
+    CountingAllocator allocator;
+
+    {
+        osmium::memory::BufferPool pool{allocator};
+        auto buffer = pool.get(2048);
+        REQUIRE(buffer.allocator() == &allocator);
+        REQUIRE(allocator.count_allocate == 1);
+
+        pool.release(std::move(buffer));
+        REQUIRE(pool.get(1024).allocator() == &allocator);
+        REQUIRE(allocator.count_allocate == 1);
+    }
+
+    REQUIRE(allocator.bytes == 0);
+}
+
+TEST_CASE("Mmap buffer allocator") {
+    osmium::memory::MmapBufferAllocator allocator;
+
+    {
+        osmium::memory::Buffer small{1024, osmium::memory::Buffer::auto_grow::yes, allocator};
+        osmium::memory::Buffer large{1024 * 1024, osmium::memory::Buffer::auto_grow::yes, allocator};
+        REQUIRE(allocator.allocated() == 1024 + 1024 * 1024);
+
+        osmium::builder::add_node(small, _id(1));
+        osmium::builder::add_node(large, _id(2));
+        large.grow(2 * 1024 * 1024);
+        REQUIRE(allocator.allocated() == 1024 + 2 * 1024 * 1024);
+        REQUIRE(small.get<osmium::Node>(0).id() == 1);
+        REQUIRE(large.get<osmium::Node>(0).id() == 2);
+    }
+
+    REQUIRE(allocator.allocated() == 0);
+}
+
+TEST_CASE("Reader with allocator for buffers") {
+    CountingAllocator allocator;
+
+    {
+        osmium::io::Reader reader{with_data_dir("t/relations/data.osm"), osmium::io::read_buffers{allocator}};
+        std::size_t count = 0;
+        while (const osmium::memory::Buffer buffer = reader.read()) {
+            REQUIRE(buffer.allocator() == &allocator);
+            count += std::distance(buffer.begin(), buffer.end());
+        }
+        reader.close();
+        REQUIRE(count > 0);
+    }
+
+    REQUIRE(allocator.count_allocate > 0);
+    REQUIRE(allocator.bytes == 0);
+}
@@ -0,0 +1,111 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer_arena.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Buffer arena creates new buffers if empty") {
+    osmium::memory::BufferArena arena{1024};
+    REQUIRE(arena.size() == 0);
+
+    const auto buffer = arena.get();
+    REQUIRE(buffer.buffer());
+    REQUIRE(buffer.buffer().capacity() == 1024);
+    REQUIRE(buffer.buffer().committed() == 0);
+    REQUIRE(buffer.buffer().get_auto_grow() == osmium::memory::Buffer::auto_grow::yes);
+}
+
+TEST_CASE("Buffer arena reuses memory of destroyed arena buffers") {
+    osmium::memory::BufferArena arena{1024};
+
+    const unsigned char* data = nullptr;
+    {
+        auto buffer = arena.get();
+        osmium::builder::add_node(buffer.buffer(), _id(1));
+        data = buffer.buffer().data();
+    }
+    REQUIRE(arena.size() == 1);
+
+    auto buffer = arena.get();
+    REQUIRE(arena.size() == 0);
+    REQUIRE(buffer.buffer().data() == data);
+    REQUIRE(buffer.buffer().committed() == 0);
+
+    osmium::builder::add_node(buffer.buffer(), _id(2));
+    REQUIRE(buffer.buffer().committed() > 0);
+    buffer.reset();
+    REQUIRE(buffer.buffer().committed() == 0);
+}
+
+TEST_CASE("Buffer arena keeps at most max_buffers buffers") {
+    osmium::memory::BufferArena arena{1024, 2};
+    {
+        auto b1 = arena.get();
+        auto b2 = arena.get();
+        auto b3 = arena.get();
+    }
+    REQUIRE(arena.size() == 2);
+    arena.clear();
+    REQUIRE(arena.size() == 0);
+}
+
+TEST_CASE("Moved arena buffer is released only once") {
+    osmium::memory::BufferArena arena{1024};
+    {
+        auto b1 = arena.get();
+        const auto b2{std::move(b1)};
+        REQUIRE(b2.buffer());
+    }
+    REQUIRE(arena.size() == 1);
+}
+
+TEST_CASE("Thread local buffer arenas are separate") {
+    auto& arena = osmium::memory::BufferArena::thread_local_instance();
+    REQUIRE(&arena == &osmium::memory::BufferArena::thread_local_instance());
+
+    osmium::memory::BufferArena* other = nullptr;
+    std::thread thread{[&other]() {
+        other = &osmium::memory::BufferArena::thread_local_instance();
+    }};
+    thread.join();
+    REQUIRE(other != &arena);
+}
+
+TEST_CASE("Batched appender moves items into destination in batches") {
+    osmium::memory::Buffer destination{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::memory::BufferArena arena{1024};
+
+    std::size_t flushes = 0;
+    {
+        osmium::memory::BatchedAppender appender{destination, 1000, arena};
+        for (osmium::object_id_type id = 1; id <= 100; ++id) {
+            osmium::builder::add_node(appender.buffer(), _id(id), _tag("x", "y"));
+            const auto committed = destination.committed();
+            appender.possibly_flush();
+            if (destination.committed() != committed) {
+                ++flushes;
+            }
+        }
+        appender.flush();
+    }
+
+    REQUIRE(flushes > 1);
+    REQUIRE(flushes < 100);
+    REQUIRE(arena.size() == 1);
+
+    std::vector<osmium::object_id_type> ids;
+    for (const auto& node : destination.select<osmium::Node>()) {
+        ids.push_back(node.id());
+        REQUIRE(node.tags().has_tag("x", "y"));
+    }
+    REQUIRE(ids.size() == 100);
+    REQUIRE(ids.front() == 1);
+    REQUIRE(ids.back() == 100);
+}
@@ -0,0 +1,82 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer_pool.hpp>
+
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Buffer pool creates new buffers if empty") {
+    osmium::memory::BufferPool pool;
+    REQUIRE(pool.size() == 0);
+
+    const auto buffer = pool.get(1024);
+    REQUIRE(buffer);
+    REQUIRE(buffer.capacity() == 1024);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(buffer.get_auto_grow() == osmium::memory::Buffer::auto_grow::yes);
+}
+
+TEST_CASE("Buffer pool re-uses released buffers") {
+    osmium::memory::BufferPool pool;
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::no};
+    osmium::builder::add_node(buffer, _id(1));
+    const auto* data = buffer.data();
+
+    pool.release(std::move(buffer));
+    REQUIRE(pool.size() == 1);
+
+    const auto reused = pool.get(512, osmium::memory::Buffer::auto_grow::internal);
+    REQUIRE(pool.size() == 0);
+    REQUIRE(reused.data() == data);
+    REQUIRE(reused.capacity() == 1024);
+    REQUIRE(reused.committed() == 0);
+    REQUIRE(reused.get_auto_grow() == osmium::memory::Buffer::auto_grow::internal);
+}
+
+TEST_CASE("Buffer pool returns the smallest buffer large enough") {
+    osmium::memory::BufferPool pool;
+    pool.release(osmium::memory::Buffer{4096});
+    pool.release(osmium::memory::Buffer{1024});
+    pool.release(osmium::memory::Buffer{2048});
+    REQUIRE(pool.size() == 3);
+
+    REQUIRE(pool.get(1500).capacity() == 2048);
+    REQUIRE(pool.get(1500).capacity() == 4096);
+    REQUIRE(pool.get(1600).capacity() == 1600);
+    REQUIRE(pool.size() == 1);
+
+    pool.clear();
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Buffer pool doesn't keep buffers with external memory") {
+    osmium::memory::BufferPool pool;
+    unsigned char data[1024];
+    pool.release(osmium::memory::Buffer{data, sizeof(data), 0});
+    pool.release(osmium::memory::Buffer{});
+    REQUIRE(pool.size() == 0);
+}
+
+TEST_CASE("Buffer pool releases nested buffers") {
+    osmium::memory::BufferPool pool;
+
+    osmium::memory::Buffer buffer{128, osmium::memory::Buffer::auto_grow::internal};
+    for (int id = 1; id < 20; ++id) {
+        osmium::builder::add_node(buffer, _id(id));
+    }
+    REQUIRE(buffer.has_nested_buffers());
+
+    pool.release(std::move(buffer));
+    REQUIRE(pool.size() > 1);
+}
+
+TEST_CASE("Buffer pool keeps only the maximum number of buffers") {
+    osmium::memory::BufferPool pool{2};
+    for (int n = 0; n < 5; ++n) {
+        pool.release(osmium::memory::Buffer{1024});
+    }
+    REQUIRE(pool.size() == 2);
+}
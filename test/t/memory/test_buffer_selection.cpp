@@ -0,0 +1,89 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer_selection.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static osmium::memory::Buffer get_test_buffer() {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _tag("n", id % 2 ? "odd" : "even"));
+    }
+    osmium::builder::add_way(buffer, _id(20), _node(1), _node(2));
+    return buffer;
+}
+
+TEST_CASE("Empty buffer selection") {
+    const osmium::memory::BufferSelection selection{get_test_buffer()};
+    REQUIRE(selection.empty());
+    REQUIRE(selection.size() == 0);
+    REQUIRE(selection.byte_size() == 0);
+    REQUIRE(selection.begin() == selection.end());
+
+    const auto buffer = selection.copy();
+    REQUIRE(buffer.committed() == 0);
+}
+
+TEST_CASE("Select some objects from a buffer") {
+    osmium::memory::BufferSelection selection{get_test_buffer()};
+    REQUIRE(selection.buffer().committed() > 0);
+
+    std::size_t bytes = 0;
+    for (const auto& object : selection.buffer().select<osmium::OSMObject>()) {
+        if (object.id() % 2 == 0) {
+            selection.add(object);
+            bytes += object.padded_size();
+        }
+    }
+
+    REQUIRE(selection.size() == 6);
+    REQUIRE(selection.byte_size() == bytes);
+    REQUIRE(std::distance(selection.cbegin(), selection.cend()) == 6);
+
+    std::vector<osmium::object_id_type> ids;
+    for (const auto& entity : selection) {
+        ids.push_back(static_cast<const osmium::OSMObject&>(entity).id());
+    }
+    REQUIRE(ids == (std::vector<osmium::object_id_type>{2, 4, 6, 8, 10, 20}));
+    REQUIRE(std::next(selection.begin(), 5)->type() == osmium::item_type::way);
+
+    const auto buffer = selection.copy();
+    REQUIRE(buffer.committed() == bytes);
+    ids.clear();
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        ids.push_back(object.id());
+    }
+    REQUIRE(ids == (std::vector<osmium::object_id_type>{2, 4, 6, 8, 10, 20}));
+}
+
+TEST_CASE("Buffer selections share the buffer") {
+    const auto buffer = std::make_shared<const osmium::memory::Buffer>(get_test_buffer());
+
+    osmium::memory::BufferSelection odd{buffer};
+    osmium::memory::BufferSelection even{buffer};
+    for (const auto& node : buffer->select<osmium::Node>()) {
+        if (node.id() % 2) {
+            odd.add(node);
+        } else {
+            even.add(node);
+        }
+    }
+
+    REQUIRE(buffer.use_count() == 3);
+    REQUIRE(odd.size() == 5);
+    REQUIRE(even.size() == 5);
+    REQUIRE(&odd.buffer() == &even.buffer());
+
+    const osmium::memory::BufferSelection moved{std::move(odd)};
+    REQUIRE(buffer.use_count() == 3);
+    REQUIRE(moved.size() == 5);
+    REQUIRE(static_cast<const osmium::Node&>(*moved.begin()).id() == 1);
+}
@@ -2,8 +2,13 @@
 
 #include <osmium/builder/attr.hpp>
 #include <osmium/memory/callback_buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/thread/pool.hpp>
 
 #include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
 
@@ -99,3 +104,52 @@ TEST_CASE("Callback buffer with callback set later") {
 }
 
 
+
+TEST_CASE("Callback buffer with background flush") {
+    osmium::thread::Pool pool{2};
+    std::vector<osmium::object_id_type> ids;
+    std::thread::id callback_thread;
+    int buffers = 0;
+
+    osmium::memory::CallbackBuffer cb{[&](osmium::memory::Buffer&& buffer){
+        callback_thread = std::this_thread::get_id();
+        for (const auto& node : buffer.select<osmium::Node>()) {
+            ids.push_back(node.id());
+        }
+        ++buffers;
+    }, 1000, 500};
+    cb.enable_background_flush(pool);
+    REQUIRE(cb.background_flush());
+
+    for (int id = 1; id <= 1000; ++id) {
+        osmium::builder::add_node(cb.buffer(), _id(id));
+        cb.possibly_flush();
+    }
+    cb.flush();
+
+    REQUIRE(buffers > 10);
+    REQUIRE(callback_thread != std::this_thread::get_id());
+    REQUIRE(ids.size() == 1000);
+    for (std::size_t n = 0; n < ids.size(); ++n) {
+        REQUIRE(ids[n] == static_cast<osmium::object_id_type>(n + 1));
+    }
+
+    cb.disable_background_flush();
+    REQUIRE_FALSE(cb.background_flush());
+    osmium::builder::add_node(cb.buffer(), _id(1001));
+    cb.flush();
+    REQUIRE(callback_thread == std::this_thread::get_id());
+    REQUIRE(ids.size() == 1001);
+}
+
+TEST_CASE("Callback buffer with background flush reports exceptions") {
+    osmium::thread::Pool pool{1};
+    osmium::memory::CallbackBuffer cb{[&](osmium::memory::Buffer&& /*buffer*/){
+        throw std::runtime_error{"callback failed"};
+    }, 1000, 10};
+    cb.enable_background_flush(pool);
+
+    osmium::builder::add_node(cb.buffer(), _id(1));
+    cb.possibly_flush();
+    REQUIRE_THROWS_AS(cb.wait(), const std::runtime_error&);
+}
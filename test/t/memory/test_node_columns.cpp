@@ -0,0 +1,42 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/memory/node_columns.hpp>
+#include <osmium/osm/box.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Node columns from buffer") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _version(3), _location(1.0, 1.0), _tag("amenity", "pub"));
+    osmium::builder::add_way(buffer, _id(1), _nodes({1, 2}));
+    osmium::builder::add_node(buffer, _id(2), _version(1), _location(5.0, 5.0));
+    osmium::builder::add_node(buffer, _id(3), _version(2));
+
+    osmium::memory::NodeColumns columns{buffer};
+    REQUIRE(columns.size() == 3);
+    REQUIRE(columns.ids() == (std::vector<osmium::object_id_type>{1, 2, 3}));
+    REQUIRE(columns.versions() == (std::vector<osmium::object_version_type>{3, 1, 2}));
+    REQUIRE(columns.location(0) == osmium::Location(1.0, 1.0));
+    REQUIRE_FALSE(columns.location(2).valid());
+    REQUIRE(columns.node(1).id() == 2);
+    REQUIRE(columns.node(0).tags().has_key("amenity"));
+
+    const osmium::Box box{0.0, 0.0, 2.0, 2.0};
+    std::vector<uint8_t> mask;
+    REQUIRE(columns.mask_in_box(box, mask) == 1);
+    REQUIRE(mask == (std::vector<uint8_t>{1, 0, 0}));
+    REQUIRE(columns.in_box(osmium::Box{0.0, 0.0, 5.0, 5.0}) == (std::vector<std::size_t>{0, 1}));
+
+    columns.append(buffer);
+    REQUIRE(columns.size() == 6);
+    REQUIRE(columns.in_box(box) == (std::vector<std::size_t>{0, 3}));
+
+    columns.clear();
+    REQUIRE(columns.empty());
+    REQUIRE(columns.in_box(box).empty());
+}
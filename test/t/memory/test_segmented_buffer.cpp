@@ -0,0 +1,126 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/segmented_buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include <string>
+#include <utility>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::size_t count_nodes(const osmium::memory::SegmentedBuffer& buffer) {
+    std::size_t count = 0;
+    osmium::object_id_type id = 1;
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        REQUIRE(node.id() == id);
+        ++id;
+        ++count;
+    }
+    return count;
+}
+
+TEST_CASE("Empty segmented buffer") {
+    const osmium::memory::SegmentedBuffer buffer{1024};
+    REQUIRE(buffer.num_segments() == 1);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(buffer.begin() == buffer.end());
+    REQUIRE(buffer.select<osmium::Node>().empty());
+}
+
+TEST_CASE("Add items to segmented buffer") {
+    osmium::memory::SegmentedBuffer buffer{1024};
+
+    osmium::memory::Buffer tmp{1024};
+    for (osmium::object_id_type id = 1; id <= 100; ++id) {
+        osmium::builder::add_node(tmp, _id(id), _tag("name", std::to_string(id)));
+        buffer.push_back(tmp.get<osmium::memory::Item>(0));
+        tmp.clear();
+    }
+
+    REQUIRE(buffer.num_segments() > 5);
+    REQUIRE(count_nodes(buffer) == 100);
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 100);
+    REQUIRE(buffer.committed() < buffer.capacity());
+
+    const auto* first_data = buffer.segment(0).data();
+    for (osmium::object_id_type id = 101; id <= 200; ++id) {
+        osmium::builder::add_node(tmp, _id(id));
+        buffer.add_item(tmp.get<osmium::memory::Item>(0));
+        tmp.clear();
+    }
+    REQUIRE(buffer.segment(0).data() == first_data);
+    REQUIRE(count_nodes(buffer) == 200);
+
+    buffer.clear();
+    REQUIRE(buffer.num_segments() == 1);
+    REQUIRE(buffer.committed() == 0);
+    REQUIRE(count_nodes(buffer) == 0);
+}
+
+TEST_CASE("Build items in segmented buffer") {
+    osmium::memory::SegmentedBuffer buffer{256};
+
+    for (osmium::object_id_type id = 1; id <= 50; ++id) {
+        osmium::builder::add_node(buffer.buffer(), _id(id), _tag("name", std::string(100, 'x')));
+        osmium::builder::add_way(buffer.buffer(), _id(id), _nodes({1, 2, 3}));
+    }
+
+    REQUIRE(buffer.num_segments() > 10);
+    REQUIRE(count_nodes(buffer) == 50);
+
+    osmium::object_id_type id = 1;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        REQUIRE(way.id() == id);
+        REQUIRE(way.nodes().size() == 3);
+        ++id;
+    }
+    REQUIRE(id == 51);
+
+    std::size_t count = 0;
+    for (auto it = buffer.begin<osmium::OSMObject>(); it != buffer.end<osmium::OSMObject>(); ++it) {
+        REQUIRE(it->id() == static_cast<osmium::object_id_type>(count / 2 + 1));
+        ++count;
+    }
+    REQUIRE(count == 100);
+}
+
+TEST_CASE("Add buffers to segmented buffer") {
+    osmium::memory::SegmentedBuffer buffer{1024};
+
+    osmium::memory::Buffer small{1024};
+    osmium::builder::add_node(small, _id(1));
+    buffer.add_buffer(small);
+    REQUIRE(buffer.num_segments() == 1);
+
+    osmium::memory::Buffer large{4096};
+    for (osmium::object_id_type id = 2; id <= 40; ++id) {
+        osmium::builder::add_node(large, _id(id));
+    }
+    const auto* data = large.data();
+    buffer.add_buffer(std::move(large));
+    REQUIRE(buffer.num_segments() == 3);
+    REQUIRE(buffer.segment(1).data() == data);
+
+    osmium::memory::Buffer copied{4096};
+    for (osmium::object_id_type id = 41; id <= 80; ++id) {
+        osmium::builder::add_node(copied, _id(id));
+    }
+    buffer.add_buffer(copied);
+    REQUIRE(count_nodes(buffer) == 80);
+
+    const auto segments = buffer.release_segments();
+    REQUIRE(segments.size() > 2);
+    REQUIRE(buffer.committed() == 0);
+}
+
+TEST_CASE("Segmented buffer with item larger than segment") {
+    osmium::memory::SegmentedBuffer buffer{128};
+
+    osmium::builder::add_node(buffer.buffer(), _id(1));
+    osmium::builder::add_node(buffer.buffer(), _id(2), _tag("name", std::string(1000, 'x')));
+    osmium::builder::add_node(buffer.buffer(), _id(3));
+
+    REQUIRE(count_nodes(buffer) == 3);
+}
@@ -76,3 +76,18 @@ TEST_CASE("CRC of Location") {
     REQUIRE(crc32().checksum() == 0xddee042c);
 }
 
+
+TEST_CASE("Buffered CRC gives same result as unbuffered CRC") {
+    osmium::CRC<crc_type> crc32;
+    osmium::CRC<osmium::CRC_buffered<crc_type, 16>> crc32_buffered;
+
+    for (int i = 0; i < 10; ++i) {
+        crc32.update_int64(0x0123456789abcdefULL * i);
+        crc32_buffered.update_int64(0x0123456789abcdefULL * i);
+        crc32.update_string("a string longer than the buffer");
+        crc32_buffered.update_string("a string longer than the buffer");
+        crc32.update_bool(true);
+        crc32_buffered.update_bool(true);
+        REQUIRE(crc32().checksum() == crc32_buffered().checksum());
+    }
+}
@@ -0,0 +1,77 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/crc.hpp>
+#include <osmium/osm/crc32c.hpp>
+#include <osmium/osm/node.hpp>
+
+#include <cstring>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("CRC32C of standard check string") {
+    osmium::CRC32C crc;
+    const char* str = "123456789";
+    crc.process_bytes(str, std::strlen(str));
+    REQUIRE(crc.checksum() == 0xe3069283U);
+}
+
+TEST_CASE("CRC32C of empty input") {
+    const osmium::CRC32C crc;
+    REQUIRE(crc.checksum() == 0);
+}
+
+TEST_CASE("CRC32C of single bytes and blocks are the same") {
+    const std::string data{"The quick brown fox jumps over the lazy dog, more than once, really."};
+
+    for (std::size_t split = 0; split <= data.size(); ++split) {
+        osmium::CRC32C crc_bytes;
+        for (std::size_t n = 0; n < split; ++n) {
+            crc_bytes.process_byte(static_cast<unsigned char>(data[n]));
+        }
+        crc_bytes.process_bytes(data.data() + split, data.size() - split);
+
+        osmium::CRC32C crc_block;
+        crc_block.process_bytes(data.data(), data.size());
+
+        REQUIRE(crc_bytes.checksum() == crc_block.checksum());
+        REQUIRE(crc_block.checksum() == 0xa9a0a37bU);
+    }
+}
+
+TEST_CASE("Hardware and software CRC32C give the same result") {
+    const std::string data(1000, 'x');
+    for (std::size_t size = 0; size < data.size(); size += 37) {
+        const auto* ptr = reinterpret_cast<const unsigned char*>(data.data()) + size % 8;
+        REQUIRE(osmium::detail::crc32c_update(0xffffffffU, ptr, size / 2) ==
+                osmium::detail::crc32c_software(0xffffffffU, ptr, size / 2));
+    }
+}
+
+TEST_CASE("CRC32C of node, buffered and unbuffered") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer,
+        _id(17),
+        _version(3),
+        _visible(true),
+        _cid(333),
+        _timestamp("2015-07-12T13:10:46Z"),
+        _uid(21),
+        _user("foo"),
+        _location(3.5, 4.7),
+        _tag("amenity", "pub"),
+        _tag("name", "OSM BAR")
+    );
+    const auto& node = buffer.get<osmium::Node>(0);
+
+    osmium::CRC<osmium::CRC32C> crc32c;
+    crc32c.update(node);
+
+    osmium::CRC<osmium::CRC_buffered<osmium::CRC32C>> crc32c_buffered;
+    crc32c_buffered.update(node);
+
+    REQUIRE(crc32c().checksum() == crc32c_buffered().checksum());
+    REQUIRE(crc32c().checksum() != 0);
+}
@@ -338,6 +338,42 @@ TEST_CASE("Parsing coordinates from strings") {
     C("1.1e2:", 1100000000, ":");
 }
 
+TEST_CASE("Parsing coordinates in fixed form from strings") {
+    C("0.0000000",            0);
+    C("1.1234567",     11234567);
+    C("12.1234567",   121234567);
+    C("123.1234567", 1231234567);
+    C("180.0000000", 1800000000);
+    C("214.7483647", 2147483647);
+    C("1.1234567 ",    11234567, " ");
+    C("1.1234567\"",   11234567, "\"");
+    C("1.1234567e1",  112345670);
+
+    for (int32_t v = 0; v < 1800000000; v += 999983) {
+        std::string str = std::to_string(v / 10000000) + ".";
+        const std::string frac = std::to_string(v % 10000000);
+        str.append(7 - frac.size(), '0');
+        str += frac;
+        C(str.c_str(), v);
+    }
+}
+
+TEST_CASE("Fast path for parsing coordinates only handles fixed form") {
+    for (const char* str : {"1.1234567", "-12.1234567", "123.1234567x"}) {
+        const char* data = str;
+        int32_t value = 0;
+        REQUIRE(osmium::detail::string_to_location_coordinate_fixed(&data, &value));
+    }
+
+    for (const char* str : {"1", "1.123456", "1.12345678", "1234.1234567", "1.1234567e1",
+                            ".1234567", "1.123456x", "-214.7483648", "999.9999999"}) {
+        const char* data = str;
+        int32_t value = 0;
+        REQUIRE_FALSE(osmium::detail::string_to_location_coordinate_fixed(&data, &value));
+        REQUIRE(data == str);
+    }
+}
+
 TEST_CASE("Parsing min coordinate from string") {
     const char* minval = "-214.7483648";
     const char** data = &minval;
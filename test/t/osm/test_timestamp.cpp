@@ -2,6 +2,7 @@
 
 #include <osmium/osm/timestamp.hpp>
 
+#include <ctime>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -126,6 +127,41 @@ TEST_CASE("Valid timestamps") {
     }
 }
 
+TEST_CASE("Timestamps are parsed like timegm() does") {
+    REQUIRE(uint32_t(osmium::Timestamp{"2015-02-29T00:00:00Z"}) == uint32_t(osmium::Timestamp{"2015-03-01T00:00:00Z"}));
+    REQUIRE(uint32_t(osmium::Timestamp{"2016-02-29T00:00:00Z"}) == 1456704000);
+    REQUIRE(uint32_t(osmium::Timestamp{"2016-12-31T23:59:60Z"}) == 1483228800);
+    REQUIRE(uint32_t(osmium::Timestamp{"2106-02-07T06:28:15Z"}) == 4294967295U);
+}
+
+TEST_CASE("Format timestamps into buffer") {
+    char buffer[21] = {};
+
+    REQUIRE(osmium::Timestamp{}.to_iso(buffer) == buffer + 20);
+    REQUIRE(std::string{buffer} == "1970-01-01T00:00:00Z");
+
+    osmium::Timestamp{"2020-02-29T12:34:56Z"}.to_iso(buffer);
+    REQUIRE(std::string{buffer} == "2020-02-29T12:34:56Z");
+
+    osmium::end_of_time().to_iso(buffer);
+    REQUIRE(std::string{buffer} == "2106-02-07T06:28:15Z");
+}
+
+TEST_CASE("Formatting timestamps is the same as with gmtime") {
+    char buffer[21] = {};
+    for (uint64_t t = 1; t < 4294967295ULL; t += 86400ULL * 7 + 3607) {
+        const osmium::Timestamp timestamp{t};
+        timestamp.to_iso(buffer);
+
+        const time_t sse = timestamp.seconds_since_epoch();
+        char expected[32];
+        std::strftime(expected, sizeof(expected), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&sse));
+
+        REQUIRE(std::string{buffer} == expected);
+        REQUIRE(uint32_t(osmium::Timestamp{buffer}) == uint32_t(timestamp));
+    }
+}
+
 TEST_CASE("Invalid timestamps") {
     REQUIRE_THROWS_AS(osmium::Timestamp{""}, const std::invalid_argument&);
     REQUIRE_THROWS_AS(osmium::Timestamp{"x"}, const std::invalid_argument&);
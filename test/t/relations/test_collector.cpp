@@ -0,0 +1,106 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/relations/collector.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+class TestCollector : public osmium::relations::Collector<TestCollector, false, true, false> {
+
+public:
+
+    std::vector<osmium::object_id_type> completed;
+    std::vector<osmium::object_id_type> not_in_any;
+
+    bool keep_member(const osmium::relations::RelationMeta& /*relation_meta*/, const osmium::RelationMember& member) const {
+        return member.type() == osmium::item_type::way;
+    }
+
+    void complete_relation(osmium::relations::RelationMeta& relation_meta) {
+        const osmium::Relation& relation = get_relation(relation_meta);
+        for (const auto& member : relation.members()) {
+            if (member.ref() != 0) {
+                REQUIRE(is_available(member.type(), member.ref()));
+                REQUIRE(get_member(get_offset(member.type(), member.ref())).id() == member.ref());
+            }
+        }
+        completed.push_back(relation.id());
+    }
+
+    void way_not_in_any_relation(const osmium::Way& way) {
+        not_in_any.push_back(way.id());
+    }
+
+}; // class TestCollector
+
+// Relation n has the ways 3n, 3n+1, and 3n+2 as members. The relations
+// with n divisible by 7 have a missing way.
+static osmium::memory::Buffer create_relations() {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type n = 1; n <= 2000; ++n) {
+        const osmium::object_id_type last = n % 7 == 0 ? 100000 + n : 3 * n + 2;
+        osmium::builder::add_relation(buffer, _id(n), _members({
+            {osmium::item_type::way, 3 * n},
+            {osmium::item_type::way, 3 * n + 1},
+            {osmium::item_type::node, 1},
+            {osmium::item_type::way, last}
+        }));
+    }
+    return buffer;
+}
+
+static osmium::memory::Buffer create_ways() {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 7000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({1, 2}));
+    }
+    return buffer;
+}
+
+TEST_CASE("Collector second pass with handle_buffer gives same result as handler") {
+    const auto relations = create_relations();
+    const auto ways = create_ways();
+
+    TestCollector collector1;
+    collector1.read_relations(relations.cbegin(), relations.cend());
+    auto& handler1 = collector1.handler();
+    osmium::apply(ways, handler1);
+    handler1.flush();
+
+    osmium::thread::Pool pool{4};
+    TestCollector collector2;
+    collector2.read_relations(relations.cbegin(), relations.cend());
+    auto& handler2 = collector2.handler();
+    collector2.handle_buffer(ways, pool);
+    handler2.flush();
+
+    REQUIRE(collector1.completed.size() == 2000 - 2000 / 7);
+    REQUIRE(collector1.not_in_any.size() == 7000 - 3 * 2000 + 2000 / 7);
+    REQUIRE(collector2.completed == collector1.completed);
+    REQUIRE(collector2.not_in_any == collector1.not_in_any);
+    REQUIRE(collector2.get_incomplete_relations().size() == 2000 / 7);
+}
+
+TEST_CASE("Collector handle_buffer with small buffer") {
+    const auto relations = create_relations();
+
+    osmium::memory::Buffer ways{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_way(ways, _id(3), _nodes({1, 2}));
+    osmium::builder::add_way(ways, _id(4), _nodes({1, 2}));
+    osmium::builder::add_way(ways, _id(5), _nodes({1, 2}));
+    osmium::builder::add_way(ways, _id(7000), _nodes({1, 2}));
+
+    TestCollector collector;
+    collector.read_relations(relations.cbegin(), relations.cend());
+    collector.handle_buffer(ways);
+
+    REQUIRE(collector.completed == std::vector<osmium::object_id_type>{1});
+    REQUIRE(collector.not_in_any == std::vector<osmium::object_id_type>{7000});
+}
@@ -45,7 +45,7 @@ TEST_CASE("Fill member database") {
     osmium::relations::RelationsDatabase rdb{stash};
     osmium::relations::MembersDatabase<osmium::Way> mdb{stash, rdb};
 
-    REQUIRE(mdb.used_memory() < 100);
+    REQUIRE(mdb.used_memory() < 200);
 
     for (const auto& relation : buffer.select<osmium::Relation>()) {
         auto handle = rdb.add(relation);
@@ -192,3 +192,71 @@ TEST_CASE("Remove non-existing object from members database doesn't do anything"
     REQUIRE(mdb.size() == 6);
 }
 
+
+TEST_CASE("Compact members database") {
+    const auto buffer = fill_buffer();
+
+    osmium::ItemStash stash;
+    osmium::relations::RelationsDatabase rdb{stash};
+    osmium::relations::MembersDatabase<osmium::Way> mdb{stash, rdb};
+
+    for (const auto& relation : buffer.select<osmium::Relation>()) {
+        auto handle = rdb.add(relation);
+        int n = 0;
+        for (const auto& member : relation.members()) {
+            mdb.track(handle, member.ref(), n);
+            ++n;
+        }
+    }
+
+    mdb.prepare_for_lookup();
+
+    // Add ways 10 to 12, which completes relations 20 and 21.
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        if (way.id() > 12) {
+            break;
+        }
+        mdb.add(way, [&](osmium::relations::RelationHandle& rel_handle) {
+            for (const auto& member : rel_handle->members()) {
+                mdb.remove(member.ref(), rel_handle->id());
+            }
+            rel_handle.remove();
+        });
+    }
+
+    REQUIRE(mdb.size() == 6);
+    {
+        const auto counts = mdb.count();
+        REQUIRE(counts.tracked   == 2);
+        REQUIRE(counts.available == 1);
+        REQUIRE(counts.removed   == 3);
+    }
+
+    mdb.compact();
+
+    REQUIRE(mdb.size() == 3);
+    {
+        const auto counts = mdb.count();
+        REQUIRE(counts.tracked   == 2);
+        REQUIRE(counts.available == 1);
+        REQUIRE(counts.removed   == 3);
+    }
+
+    REQUIRE(mdb.get(10));
+    REQUIRE_FALSE(mdb.get(11));
+    REQUIRE_FALSE(mdb.get(13));
+    REQUIRE(mdb.lookup(11).first == mdb.lookup(11).second);
+    REQUIRE(mdb.lookup(13).second - mdb.lookup(13).first == 1);
+
+    // Adding the rest of the ways completes relation 22.
+    int complete = 0;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        if (way.id() > 12) {
+            mdb.add(way, [&](osmium::relations::RelationHandle& rel_handle) {
+                REQUIRE(rel_handle->id() == 22);
+                ++complete;
+            });
+        }
+    }
+    REQUIRE(complete == 1);
+}
@@ -2,11 +2,15 @@
 
 #include "utils.hpp"
 
+#include <osmium/builder/attr.hpp>
 #include <osmium/io/xml_input.hpp>
 #include <osmium/osm/relation.hpp>
 #include <osmium/relations/relations_manager.hpp>
+#include <osmium/thread/pool.hpp>
 
+#include <atomic>
 #include <iterator>
+#include <vector>
 
 struct EmptyRM : public osmium::relations::RelationsManager<EmptyRM, true, true, true> {
 };
@@ -175,6 +179,28 @@ TEST_CASE("Relations manager derived class") {
     REQUIRE(n == 1);
 }
 
+TEST_CASE("Relations manager with segmented stash") {
+    osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    TestRM manager;
+
+    osmium::ItemStash::config config;
+    config.segment_size = 1024;
+    config.spill = true;
+    config.hot_segments = 1;
+    manager.configure_stash(config);
+
+    osmium::relations::read_relations(file, manager);
+
+    osmium::io::Reader reader{file};
+    osmium::apply(reader, manager.handler());
+    reader.close();
+
+    REQUIRE(manager.count_new_rels      ==  3);
+    REQUIRE(manager.count_new_members   ==  5);
+    REQUIRE(manager.count_complete_rels ==  2);
+}
+
 TEST_CASE("Relations manager with callback") {
     osmium::io::File file{with_data_dir("t/relations/data.osm")};
 
@@ -320,3 +346,305 @@ TEST_CASE("Check handling of missing members") {
     REQUIRE(missing_relations == 2);
 }
 
+struct EvictRM : public osmium::relations::RelationsManager<EvictRM, true, true, true> {
+
+    std::vector<osmium::object_id_type> complete;
+    std::vector<osmium::object_id_type> evicted;
+
+    void complete_relation(const osmium::Relation& relation) {
+        complete.push_back(relation.id());
+    }
+
+    void evict_relation(const osmium::Relation& relation) {
+        evicted.push_back(relation.id());
+    }
+
+};
+
+static osmium::memory::Buffer create_eviction_test_data() {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 10; ++id) {
+        if (id != 5) {
+            osmium::builder::add_node(buffer, _id(id), _location(1.0, 2.0));
+        }
+    }
+    osmium::builder::add_way(buffer, _id(20), _nodes({1, 2}));
+    osmium::builder::add_way(buffer, _id(21), _nodes({2, 3}));
+
+    // complete
+    osmium::builder::add_relation(buffer, _id(1),
+        _member(osmium::item_type::node, 1),
+        _member(osmium::item_type::node, 2));
+    // node 5 is missing
+    osmium::builder::add_relation(buffer, _id(2),
+        _member(osmium::item_type::node, 4),
+        _member(osmium::item_type::node, 5),
+        _member(osmium::item_type::way, 20));
+    // complete
+    osmium::builder::add_relation(buffer, _id(3),
+        _member(osmium::item_type::way, 20),
+        _member(osmium::item_type::way, 21));
+    // way 22 is missing
+    osmium::builder::add_relation(buffer, _id(4),
+        _member(osmium::item_type::way, 21),
+        _member(osmium::item_type::way, 22));
+    return buffer;
+}
+
+TEST_CASE("Relations manager with early eviction") {
+    const auto data = create_eviction_test_data();
+
+    EvictRM manager;
+    manager.enable_early_eviction();
+    for (const auto& relation : data.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+
+    SECTION("with handler") {
+        osmium::apply(data, manager.handler());
+    }
+
+    SECTION("with buffer") {
+        manager.handle_buffer(data);
+    }
+
+    REQUIRE(manager.complete.size() == 2);
+    REQUIRE(manager.evicted == (std::vector<osmium::object_id_type>{2, 4}));
+    REQUIRE(manager.relations_database().count_relations() == 0);
+    REQUIRE(manager.member_nodes_database().count().available == 0);
+    REQUIRE(manager.member_ways_database().count().available == 0);
+}
+
+TEST_CASE("Relations manager without early eviction keeps incomplete relations") {
+    const auto data = create_eviction_test_data();
+
+    EvictRM manager;
+    for (const auto& relation : data.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+    osmium::apply(data, manager.handler());
+
+    REQUIRE(manager.complete.size() == 2);
+    REQUIRE(manager.evicted.empty());
+    REQUIRE(manager.relations_database().count_relations() == 2);
+}
+
+TEST_CASE("Relations manager derived class handling buffers") {
+    osmium::io::File file{with_data_dir("t/relations/data.osm")};
+
+    TestRM manager;
+
+    osmium::relations::read_relations(file, manager);
+
+    osmium::io::Reader reader{file};
+    while (const auto buffer = reader.read()) {
+        manager.handle_buffer(buffer);
+    }
+    reader.close();
+
+    REQUIRE(manager.count_complete_rels ==  2);
+    REQUIRE(manager.count_before        == 10);
+    REQUIRE(manager.count_not_in_any    ==  6);
+    REQUIRE(manager.count_after         == 10);
+
+    int n = 0;
+    manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
+        ++n;
+        REQUIRE(handle->id() == 31);
+    });
+    REQUIRE(n == 1);
+}
+
+// Writes the member nodes of all complete relations into the buffer it
+// is given, can be called from several threads.
+struct ParallelRM : public osmium::relations::RelationsManager<ParallelRM, true, false, false> {
+
+    std::atomic<std::size_t> count_complete_rels{0};
+
+    void complete_relation(const osmium::Relation& relation) {
+        complete_relation(relation, buffer());
+    }
+
+    void complete_relation(const osmium::Relation& relation, osmium::memory::Buffer& out) {
+        ++count_complete_rels;
+        for (const auto& member : relation.members()) {
+            const auto* node = get_member_node(member.ref());
+            if (node) {
+                out.add_item(*node);
+                out.commit();
+            }
+        }
+    }
+
+};
+
+static osmium::memory::Buffer create_parallel_test_data(osmium::object_id_type num_relations) {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= num_relations * 3; ++id) {
+        osmium::builder::add_node(buffer, _id(id), _location(1.0, 2.0));
+    }
+    for (osmium::object_id_type id = 1; id <= num_relations; ++id) {
+        // Each relation has three nodes as members, the last one is also
+        // a member of the next relation.
+        osmium::builder::add_relation(buffer, _id(id),
+            _member(osmium::item_type::node, id * 3 - 2),
+            _member(osmium::item_type::node, id * 3 - 1),
+            _member(osmium::item_type::node, id * 3 + 2));
+    }
+    return buffer;
+}
+
+static std::vector<osmium::object_id_type> output_ids(osmium::memory::Buffer&& buffer) {
+    std::vector<osmium::object_id_type> ids;
+    for (const auto& node : buffer.select<osmium::Node>()) {
+        ids.push_back(node.id());
+    }
+    return ids;
+}
+
+TEST_CASE("Relations manager with parallel complete_relation") {
+    const osmium::object_id_type num_relations = 5000;
+    const auto data = create_parallel_test_data(num_relations);
+
+    ParallelRM serial_manager;
+    ParallelRM parallel_manager;
+    for (const auto& relation : data.select<osmium::Relation>()) {
+        serial_manager.relation(relation);
+        parallel_manager.relation(relation);
+    }
+    serial_manager.prepare_for_lookup();
+    parallel_manager.prepare_for_lookup();
+
+    osmium::apply(data, serial_manager.handler());
+    const auto serial_ids = output_ids(serial_manager.read());
+
+    osmium::thread::Pool pool{4};
+    parallel_manager.handle_buffer(data, pool);
+    const auto parallel_ids = output_ids(parallel_manager.read());
+
+    // The last relation is missing its last member.
+    REQUIRE(serial_manager.count_complete_rels == num_relations - 1);
+    REQUIRE(parallel_manager.count_complete_rels == num_relations - 1);
+    REQUIRE(serial_ids.size() == (num_relations - 1) * 3);
+
+    // The output of the threads is added in order of the relations.
+    REQUIRE(parallel_ids == serial_ids);
+
+    int incomplete = 0;
+    parallel_manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
+        ++incomplete;
+        REQUIRE(handle->id() == num_relations);
+    });
+    REQUIRE(incomplete == 1);
+    REQUIRE(parallel_manager.member_nodes_database().count().available == 2);
+}
+
+// Records the order in which relations are completed and how many ways
+// are reachable from them through their child relations.
+struct NestedRM : public osmium::relations::RelationsManager<NestedRM, false, true, true> {
+
+    std::vector<osmium::object_id_type> complete;
+    std::vector<std::size_t> reachable_ways;
+    bool count_reachable = true;
+
+    std::size_t count_ways(const osmium::Relation& relation) const {
+        std::size_t count = 0;
+        for (const auto& member : relation.members()) {
+            if (member.type() == osmium::item_type::way && member.ref() != 0) {
+                REQUIRE(get_member_way(member.ref()));
+                ++count;
+            } else if (member.type() == osmium::item_type::relation && member.ref() != 0) {
+                const auto* child = get_member_relation(member.ref());
+                REQUIRE(child);
+                count += count_ways(*child);
+            }
+        }
+        return count;
+    }
+
+    void complete_relation(const osmium::Relation& relation) {
+        complete.push_back(relation.id());
+        if (count_reachable) {
+            reachable_ways.push_back(count_ways(relation));
+        }
+    }
+
+};
+
+// Relation 10 has the children 20 and 30, relation 30 has the child 40.
+// Relation 50 is not nested. Relations 60 and 61 form a cycle. Relation
+// 71, the child of relation 70, has a missing member.
+static osmium::memory::Buffer create_nested_test_data() {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 7; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _nodes({1, 2}));
+    }
+    osmium::builder::add_relation(buffer, _id(10), _member(osmium::item_type::relation, 30), _member(osmium::item_type::relation, 20));
+    osmium::builder::add_relation(buffer, _id(20), _member(osmium::item_type::way, 1), _member(osmium::item_type::way, 2));
+    osmium::builder::add_relation(buffer, _id(30), _member(osmium::item_type::way, 3), _member(osmium::item_type::relation, 40));
+    osmium::builder::add_relation(buffer, _id(40), _member(osmium::item_type::way, 4));
+    osmium::builder::add_relation(buffer, _id(50), _member(osmium::item_type::way, 5));
+    osmium::builder::add_relation(buffer, _id(60), _member(osmium::item_type::relation, 61));
+    osmium::builder::add_relation(buffer, _id(61), _member(osmium::item_type::relation, 60), _member(osmium::item_type::way, 6));
+    osmium::builder::add_relation(buffer, _id(70), _member(osmium::item_type::relation, 71), _member(osmium::item_type::way, 7));
+    osmium::builder::add_relation(buffer, _id(71), _member(osmium::item_type::way, 99));
+    return buffer;
+}
+
+TEST_CASE("Relations manager with nested relations") {
+    const auto data = create_nested_test_data();
+
+    NestedRM manager;
+    manager.enable_nested_relations();
+    for (const auto& relation : data.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+
+    SECTION("with handler") {
+        osmium::apply(data, manager.handler());
+    }
+
+    SECTION("with buffer") {
+        osmium::thread::Pool pool{2};
+        manager.handle_buffer(data, pool);
+    }
+
+    // Only the relation which is not nested is completed in the second pass.
+    REQUIRE(manager.complete == (std::vector<osmium::object_id_type>{50}));
+
+    manager.complete_nested_relations();
+
+    REQUIRE(manager.complete == (std::vector<osmium::object_id_type>{50, 20, 40, 30, 10}));
+    REQUIRE(manager.reachable_ways == (std::vector<std::size_t>{1, 2, 1, 2, 4}));
+
+    std::vector<osmium::object_id_type> incomplete;
+    manager.for_each_incomplete_relation([&](const osmium::relations::RelationHandle& handle){
+        incomplete.push_back(handle->id());
+    });
+    REQUIRE(incomplete == (std::vector<osmium::object_id_type>{60, 61, 70, 71}));
+}
+
+TEST_CASE("Relations manager without nested relations completes relations in second pass") {
+    const auto data = create_nested_test_data();
+
+    NestedRM manager;
+    manager.count_reachable = false;
+    for (const auto& relation : data.select<osmium::Relation>()) {
+        manager.relation(relation);
+    }
+    manager.prepare_for_lookup();
+    osmium::apply(data, manager.handler());
+
+    REQUIRE(manager.complete.size() == 8);
+    manager.complete_nested_relations();
+    REQUIRE(manager.complete.size() == 8);
+}
@@ -0,0 +1,158 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/geom/wkt.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/relations/route_manager.hpp>
+#include <osmium/tags/tags_filter.hpp>
+#include <osmium/thread/pool.hpp>
+#include <osmium/visitor.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+using route_result = std::pair<osmium::object_id_type, std::string>;
+using route_manager_type = osmium::relations::RouteManager<osmium::geom::WKTFactory<>>;
+
+static std::vector<const osmium::Way*> all_ways(const osmium::memory::Buffer& buffer) {
+    std::vector<const osmium::Way*> ways;
+    for (const auto& way : buffer.select<osmium::Way>()) {
+        ways.push_back(&way);
+    }
+    return ways;
+}
+
+static std::vector<osmium::Location> locations(const std::vector<osmium::NodeRef>& line) {
+    std::vector<osmium::Location> result;
+    for (const auto& node_ref : line) {
+        result.push_back(node_ref.location());
+    }
+    return result;
+}
+
+TEST_CASE("Merge route ways joined at their ends") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    // second way is reversed, fourth way is not connected
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {1.0, 0.0}}, {2, {1.0, 1.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{4, {1.0, 3.0}}, {3, {1.0, 2.0}}, {2, {1.0, 1.0}}}));
+    osmium::builder::add_way(buffer, _id(3), _nodes({{5, {1.0, -1.0}}, {1, {1.0, 0.0}}}));
+    osmium::builder::add_way(buffer, _id(4), _nodes({{6, {5.0, 5.0}}, {7, {6.0, 6.0}}}));
+
+    const auto lines = osmium::relations::merge_route_ways(all_ways(buffer));
+
+    REQUIRE(lines.size() == 2);
+    REQUIRE(locations(lines[0]) == std::vector<osmium::Location>({{1.0, -1.0}, {1.0, 0.0}, {1.0, 1.0}, {1.0, 2.0}, {1.0, 3.0}}));
+    REQUIRE(locations(lines[1]) == std::vector<osmium::Location>({{5.0, 5.0}, {6.0, 6.0}}));
+}
+
+TEST_CASE("Merge route ways ignores ways without two valid locations") {
+    osmium::memory::Buffer buffer{10240, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_way(buffer, _id(1), _nodes({{1, {1.0, 1.0}}, {2, {1.0, 1.0}}}));
+    osmium::builder::add_way(buffer, _id(2), _nodes({{3, {2.0, 2.0}}, {4, osmium::Location{}}}));
+
+    REQUIRE(osmium::relations::merge_route_ways(all_ways(buffer)).empty());
+}
+
+// Route n has the ways 10n, 10n+1, and 10n+2 which are joined into one
+// line from (n 0) to (n 3), the second way is reversed. The platform way
+// 10n+5 is not part of the geometry. Routes with odd n are bus routes.
+static osmium::memory::Buffer create_relations(osmium::object_id_type num) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type n = 1; n <= num; ++n) {
+        osmium::builder::add_relation(buffer, _id(n), _members({
+            {osmium::item_type::way, 10 * n, ""},
+            {osmium::item_type::way, 10 * n + 5, "platform"},
+            {osmium::item_type::way, 10 * n + 1, ""},
+            {osmium::item_type::way, 10 * n + 2, "forward"}
+        }), _tag("type", "route"), _tag("route", n % 2 ? "bus" : "train"));
+    }
+    osmium::builder::add_relation(buffer, _id(num + 1), _member(osmium::item_type::way, 10), _tag("type", "multipolygon"));
+    return buffer;
+}
+
+static osmium::memory::Buffer create_ways(osmium::object_id_type num) {
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type n = 1; n <= num; ++n) {
+        const auto x = static_cast<double>(n);
+        osmium::builder::add_way(buffer, _id(10 * n), _nodes({{100 * n, {x, 0.0}}, {100 * n + 1, {x, 1.0}}}));
+        osmium::builder::add_way(buffer, _id(10 * n + 1), _nodes({{100 * n + 2, {x, 2.0}}, {100 * n + 1, {x, 1.0}}}));
+        osmium::builder::add_way(buffer, _id(10 * n + 2), _nodes({{100 * n + 2, {x, 2.0}}, {100 * n + 3, {x, 3.0}}}));
+    }
+    return buffer;
+}
+
+static std::string expected_wkt(osmium::object_id_type n) {
+    const auto x = std::to_string(n);
+    return "MULTILINESTRING((" + x + " 0," + x + " 1," + x + " 2," + x + " 3))";
+}
+
+TEST_CASE("Route manager builds multilinestrings for routes") {
+    const auto relations = create_relations(3);
+    const auto ways = create_ways(3);
+
+    std::vector<route_result> results;
+    route_manager_type manager{osmium::geom::WKTFactory<>{}, [&results](const osmium::Relation& relation, std::string&& wkt) {
+        results.emplace_back(relation.id(), std::move(wkt));
+    }};
+
+    osmium::apply(relations, manager);
+    manager.prepare_for_lookup();
+    osmium::apply(ways, manager.handler());
+
+    REQUIRE(results.size() == 3);
+    for (const auto& result : results) {
+        REQUIRE(result.second == expected_wkt(result.first));
+    }
+}
+
+TEST_CASE("Route manager with filter") {
+    const auto relations = create_relations(4);
+    const auto ways = create_ways(4);
+
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "route", "bus");
+
+    std::vector<route_result> results;
+    route_manager_type manager{osmium::geom::WKTFactory<>{}, [&results](const osmium::Relation& relation, std::string&& wkt) {
+        results.emplace_back(relation.id(), std::move(wkt));
+    }, filter};
+
+    osmium::apply(relations, manager);
+    manager.prepare_for_lookup();
+    osmium::apply(ways, manager.handler());
+
+    REQUIRE(results == std::vector<route_result>({{1, expected_wkt(1)}, {3, expected_wkt(3)}}));
+}
+
+TEST_CASE("Route manager second pass with handle_buffer gives same result as handler") {
+    const osmium::object_id_type num = 150;
+    const auto relations = create_relations(num);
+    const auto ways = create_ways(num);
+
+    std::vector<route_result> results1;
+    route_manager_type manager1{osmium::geom::WKTFactory<>{}, [&results1](const osmium::Relation& relation, std::string&& wkt) {
+        results1.emplace_back(relation.id(), std::move(wkt));
+    }};
+    osmium::apply(relations, manager1);
+    manager1.prepare_for_lookup();
+    osmium::apply(ways, manager1.handler());
+
+    osmium::thread::Pool pool{4};
+    std::vector<route_result> results2;
+    route_manager_type manager2{osmium::geom::WKTFactory<>{}, [&results2](const osmium::Relation& relation, std::string&& wkt) {
+        results2.emplace_back(relation.id(), std::move(wkt));
+    }};
+    osmium::apply(relations, manager2);
+    manager2.prepare_for_lookup();
+    manager2.handle_buffer(ways, pool);
+
+    REQUIRE(results1.size() == num);
+    REQUIRE(results2 == results1);
+}
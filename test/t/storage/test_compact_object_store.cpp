@@ -0,0 +1,187 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/storage/compact_object_store.hpp>
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+static osmium::memory::Buffer generate_test_data() {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1), _version(3), _cid(10), _timestamp(osmium::Timestamp{1000}), _uid(5), _user("foo"),
+                              _location(1.5, 2.5), _tag("amenity", "pub"), _tag("name", "Anchor"));
+    osmium::builder::add_node(buffer, _id(2), _version(1), _cid(11), _uid(6), _user("bar"));
+    osmium::builder::add_node(buffer, _id(3), _version(2), _deleted());
+    osmium::builder::add_way(buffer, _id(10), _version(2), _cid(12), _timestamp(osmium::Timestamp{2000}), _uid(5), _user("foo"),
+                             _nodes({{1, {1.5, 2.5}}, {2, osmium::Location{}}, {3, {3.0, 3.0}}}), _tag("building", "yes"));
+    osmium::builder::add_relation(buffer, _id(20), _version(1), _cid(13), _uid(6), _user("bar"),
+                                  _member(osmium::item_type::way, 10, "outer"), _member(osmium::item_type::node, 1, ""),
+                                  _member(osmium::item_type::relation, 21, "subarea"), _tag("type", "multipolygon"),
+                                  _tag("building", "yes"));
+
+    return buffer;
+}
+
+static void require_same(const osmium::OSMObject& a, const osmium::OSMObject& b) {
+    REQUIRE(a.type() == b.type());
+    REQUIRE(a.id() == b.id());
+    REQUIRE(a.version() == b.version());
+    REQUIRE(a.visible() == b.visible());
+    REQUIRE(a.changeset() == b.changeset());
+    REQUIRE(a.timestamp() == b.timestamp());
+    REQUIRE(a.uid() == b.uid());
+    REQUIRE(std::string{a.user()} == b.user());
+
+    REQUIRE(a.tags().size() == b.tags().size());
+    auto it = b.tags().cbegin();
+    for (const auto& tag : a.tags()) {
+        REQUIRE(std::string{tag.key()} == it->key());
+        REQUIRE(std::string{tag.value()} == it->value());
+        ++it;
+    }
+
+    switch (a.type()) {
+        case osmium::item_type::node:
+            REQUIRE(static_cast<const osmium::Node&>(a).location() == static_cast<const osmium::Node&>(b).location());
+            break;
+        case osmium::item_type::way: {
+                const auto& n1 = static_cast<const osmium::Way&>(a).nodes();
+                const auto& n2 = static_cast<const osmium::Way&>(b).nodes();
+                REQUIRE(n1.size() == n2.size());
+                for (std::size_t i = 0; i < n1.size(); ++i) {
+                    REQUIRE(n1[i].ref() == n2[i].ref());
+                    REQUIRE(n1[i].location() == n2[i].location());
+                }
+            }
+            break;
+        default: {
+                const auto& m1 = static_cast<const osmium::Relation&>(a).members();
+                const auto& m2 = static_cast<const osmium::Relation&>(b).members();
+                REQUIRE(m1.size() == m2.size());
+                auto mit = m2.cbegin();
+                for (const auto& member : m1) {
+                    REQUIRE(member.type() == mit->type());
+                    REQUIRE(member.ref() == mit->ref());
+                    REQUIRE(std::string{member.role()} == mit->role());
+                    ++mit;
+                }
+            }
+            break;
+    }
+}
+
+TEST_CASE("Compact object store handle") {
+    const osmium::CompactObjectStore::handle_type handle;
+    REQUIRE_FALSE(handle.valid());
+
+    std::stringstream ss;
+    ss << handle;
+    REQUIRE(ss.str() == "-");
+}
+
+TEST_CASE("Compact object store expands objects") {
+    const auto buffer = generate_test_data();
+
+    osmium::CompactObjectStore store;
+    REQUIRE(store.size() == 0);
+
+    std::vector<osmium::CompactObjectStore::handle_type> handles;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        handles.push_back(store.add(object));
+    }
+    REQUIRE(store.size() == 5);
+
+    // "", "foo", "amenity", "pub", "name", "Anchor", "bar", "building",
+    // "yes", "outer", "subarea", "type", "multipolygon"
+    REQUIRE(store.count_strings() == 13);
+
+    auto it = handles.cbegin();
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        require_same(object, store.get(*it));
+        ++it;
+    }
+
+    const auto& way = store.get<osmium::Way>(handles[3]);
+    REQUIRE(way.id() == 10);
+    REQUIRE(way.nodes().size() == 3);
+
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    for (const auto& handle : handles) {
+        store.copy_to(handle, out);
+    }
+    auto oit = out.select<osmium::OSMObject>().cbegin();
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        require_same(object, *oit);
+        ++oit;
+    }
+}
+
+TEST_CASE("Compact object store only stores nodes, ways, and relations") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto pos = osmium::builder::add_area(buffer, _id(2));
+
+    osmium::CompactObjectStore store;
+    REQUIRE_THROWS_AS(store.add(buffer.get<osmium::OSMObject>(pos)), const std::invalid_argument&);
+}
+
+TEST_CASE("Compact object store with removed objects") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 1000; ++id) {
+        osmium::builder::add_way(buffer, _id(id), _tag("building", "yes"), _nodes({1, 2, 3, 4, 1}));
+    }
+
+    osmium::CompactObjectStore store;
+    std::vector<osmium::CompactObjectStore::handle_type> handles;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        handles.push_back(store.add(object));
+    }
+
+    for (std::size_t i = 0; i < handles.size(); i += 2) {
+        store.remove(handles[i]);
+    }
+    REQUIRE(store.size() == 500);
+    REQUIRE(store.count_removed() == 500);
+
+    store.garbage_collect();
+    REQUIRE(store.size() == 500);
+    REQUIRE(store.count_removed() == 0);
+
+    for (std::size_t i = 1; i < handles.size(); i += 2) {
+        const auto& way = store.get<osmium::Way>(handles[i]);
+        REQUIRE(way.id() == static_cast<osmium::object_id_type>(i + 1));
+        REQUIRE(way.nodes().size() == 5);
+        REQUIRE(std::string{way.tags()["building"]} == "yes");
+    }
+
+    store.clear();
+    REQUIRE(store.size() == 0);
+}
+
+TEST_CASE("Compact object store uses less memory for repeated strings") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_id_type id = 1; id <= 20000; ++id) {
+        osmium::builder::add_relation(buffer, _id(id), _user("some_long_user_name"),
+                                      _tag("type", "multipolygon"), _tag("building", "residential"),
+                                      _tag("addr:city", "Some Long City Name"),
+                                      _member(osmium::item_type::way, id, "outer"));
+    }
+
+    osmium::CompactObjectStore store;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        store.add(object);
+    }
+
+    REQUIRE(store.count_strings() == 9);
+    REQUIRE(store.used_memory() < buffer.capacity());
+}
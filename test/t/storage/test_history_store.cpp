@@ -0,0 +1,214 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/storage/history_store.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+static bool same_object(const osmium::OSMObject& a, const osmium::OSMObject& b) {
+    if (a.type() != b.type() || a.id() != b.id() || a.version() != b.version() ||
+        a.visible() != b.visible() || a.changeset() != b.changeset() ||
+        a.timestamp() != b.timestamp() || a.uid() != b.uid() ||
+        std::strcmp(a.user(), b.user()) || a.tags().size() != b.tags().size()) {
+        return false;
+    }
+    if (!std::equal(a.tags().cbegin(), a.tags().cend(), b.tags().cbegin(), [](const osmium::Tag& t1, const osmium::Tag& t2) {
+            return !std::strcmp(t1.key(), t2.key()) && !std::strcmp(t1.value(), t2.value());
+        })) {
+        return false;
+    }
+    switch (a.type()) {
+        case osmium::item_type::node:
+            return static_cast<const osmium::Node&>(a).location() == static_cast<const osmium::Node&>(b).location();
+        case osmium::item_type::way: {
+                const auto& n1 = static_cast<const osmium::Way&>(a).nodes();
+                const auto& n2 = static_cast<const osmium::Way&>(b).nodes();
+                return n1.size() == n2.size() && std::equal(n1.cbegin(), n1.cend(), n2.cbegin(), [](const osmium::NodeRef& r1, const osmium::NodeRef& r2) {
+                    return r1.ref() == r2.ref() && r1.location() == r2.location();
+                });
+            }
+        default: {
+                const auto& m1 = static_cast<const osmium::Relation&>(a).members();
+                const auto& m2 = static_cast<const osmium::Relation&>(b).members();
+                return m1.size() == m2.size() && std::equal(m1.cbegin(), m1.cend(), m2.cbegin(), [](const osmium::RelationMember& r1, const osmium::RelationMember& r2) {
+                    return r1.type() == r2.type() && r1.ref() == r2.ref() && !std::strcmp(r1.role(), r2.role());
+                });
+            }
+    }
+}
+
+static osmium::memory::Buffer generate_history() {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1), _version(1), _cid(10), _timestamp(osmium::Timestamp{1000}), _uid(5), _user("foo"),
+                              _location(1.5, 2.5), _tag("amenity", "pub"));
+    osmium::builder::add_node(buffer, _id(1), _version(2), _cid(12), _timestamp(osmium::Timestamp{2000}), _uid(5), _user("foo"),
+                              _location(1.5, 2.5), _tag("amenity", "pub"), _tag("name", "Anchor"));
+    osmium::builder::add_node(buffer, _id(1), _version(4), _cid(20), _timestamp(osmium::Timestamp{3000}), _uid(7), _user("bar"),
+                              _location(1.6, 2.4), _tag("amenity", "pub"), _tag("name", "The Anchor"));
+    osmium::builder::add_node(buffer, _id(1), _version(5), _cid(21), _timestamp(osmium::Timestamp{4000}), _uid(7), _user("bar"),
+                              _deleted());
+    osmium::builder::add_node(buffer, _id(2), _version(1), _cid(10), _timestamp(osmium::Timestamp{1000}), _uid(5), _user("foo"),
+                              _location(3.0, 4.0));
+
+    osmium::builder::add_way(buffer, _id(10), _version(1), _cid(10), _timestamp(osmium::Timestamp{1000}), _uid(5), _user("foo"),
+                             _nodes({{1, {1.0, 1.0}}, {2, {2.0, 2.0}}, {3, {3.0, 3.0}}}), _tag("highway", "track"));
+    osmium::builder::add_way(buffer, _id(10), _version(2), _cid(11), _timestamp(osmium::Timestamp{1500}), _uid(5), _user("foo"),
+                             _nodes({{1, {1.0, 1.0}}, {4, {4.0, 4.0}}, {5, {5.0, 5.0}}, {3, {3.0, 3.0}}}), _tag("highway", "track"));
+    osmium::builder::add_way(buffer, _id(10), _version(3), _cid(15), _timestamp(osmium::Timestamp{2500}), _uid(6), _user("baz"),
+                             _nodes({{1, {1.0, 1.0}}, {4, {4.0, 4.1}}, {5, {5.0, 5.0}}, {3, {3.0, 3.0}}}), _tag("highway", "residential"), _tag("name", "Main St"));
+
+    osmium::builder::add_relation(buffer, _id(20), _version(1), _cid(10), _timestamp(osmium::Timestamp{1000}), _uid(5), _user("foo"),
+                                  _member(osmium::item_type::way, 10, "outer"), _member(osmium::item_type::node, 1, ""),
+                                  _tag("type", "multipolygon"));
+    osmium::builder::add_relation(buffer, _id(20), _version(2), _cid(30), _timestamp(osmium::Timestamp{5000}), _uid(5), _user("foo"),
+                                  _member(osmium::item_type::way, 10, "outer"), _member(osmium::item_type::way, 11, "inner"),
+                                  _member(osmium::item_type::node, 1, ""), _tag("type", "multipolygon"));
+    osmium::builder::add_relation(buffer, _id(20), _version(3), _cid(31), _timestamp(osmium::Timestamp{6000}), _uid(5), _user("foo"),
+                                  _member(osmium::item_type::way, 11, "inner"), _member(osmium::item_type::node, 1, "label"),
+                                  _tag("type", "multipolygon"), _tag("landuse", "forest"));
+
+    return buffer;
+}
+
+TEST_CASE("Empty history store") {
+    osmium::HistoryStore store;
+    REQUIRE(store.size() == 0);
+    REQUIRE(store.num_versions() == 0);
+    REQUIRE(store.num_versions(osmium::item_type::node, 1) == 0);
+    REQUIRE(store.latest(osmium::item_type::node, 1) == nullptr);
+
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(store.get_versions(osmium::item_type::node, 1, out) == 0);
+    REQUIRE_FALSE(store.get_version(osmium::item_type::node, 1, 1, out));
+    REQUIRE(out.committed() == 0);
+}
+
+TEST_CASE("History store rebuilds all versions") {
+    const auto input = generate_history();
+
+    osmium::HistoryStore store;
+    for (const auto& object : input.select<osmium::OSMObject>()) {
+        store.add(object);
+    }
+
+    REQUIRE(store.size() == 4);
+    REQUIRE(store.num_versions() == 11);
+    REQUIRE(store.num_versions(osmium::item_type::node, 1) == 4);
+    REQUIRE(store.num_versions(osmium::item_type::node, 2) == 1);
+    REQUIRE(store.num_versions(osmium::item_type::way, 10) == 3);
+    REQUIRE(store.num_versions(osmium::item_type::relation, 20) == 3);
+    REQUIRE(store.num_versions(osmium::item_type::way, 1) == 0);
+
+    const auto* latest = store.latest(osmium::item_type::way, 10);
+    REQUIRE(latest);
+    REQUIRE(latest->version() == 3);
+
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    std::size_t count = 0;
+    count += store.get_versions(osmium::item_type::node, 1, out);
+    count += store.get_versions(osmium::item_type::node, 2, out);
+    count += store.get_versions(osmium::item_type::way, 10, out);
+    count += store.get_versions(osmium::item_type::relation, 20, out);
+    REQUIRE(count == 11);
+
+    auto it = out.select<osmium::OSMObject>().cbegin();
+    for (const auto& object : input.select<osmium::OSMObject>()) {
+        REQUIRE(same_object(object, *it));
+        ++it;
+    }
+    REQUIRE(it == out.select<osmium::OSMObject>().cend());
+}
+
+TEST_CASE("History store rebuilds single versions") {
+    const auto input = generate_history();
+
+    osmium::HistoryStore store;
+    for (const auto& object : input.select<osmium::OSMObject>()) {
+        store.add(object);
+    }
+
+    for (const auto& object : input.select<osmium::OSMObject>()) {
+        osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+        REQUIRE(store.get_version(object.type(), object.id(), object.version(), out));
+        REQUIRE(same_object(object, *out.select<osmium::OSMObject>().cbegin()));
+    }
+
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE_FALSE(store.get_version(osmium::item_type::node, 1, 3, out));
+    REQUIRE_FALSE(store.get_version(osmium::item_type::node, 1, 6, out));
+    REQUIRE(out.committed() == 0);
+}
+
+TEST_CASE("History store with objects in any order") {
+    const auto input = generate_history();
+
+    osmium::HistoryStore store;
+    for (const auto& object : input.select<osmium::Relation>()) {
+        store.add(object);
+    }
+    for (const auto& object : input.select<osmium::Node>()) {
+        store.add(object);
+    }
+
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(store.get_version(osmium::item_type::node, 1, 2, out));
+    REQUIRE(store.get_version(osmium::item_type::relation, 20, 1, out));
+    REQUIRE(store.size() == 3);
+}
+
+TEST_CASE("History store needs versions in order") {
+    const auto input = generate_history();
+    const auto& node = *input.select<osmium::Node>().cbegin();
+
+    osmium::HistoryStore store;
+    store.add(node);
+    REQUIRE_THROWS_AS(store.add(node), const std::invalid_argument&);
+}
+
+TEST_CASE("History store needs all versions of an object together") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    osmium::builder::add_node(buffer, _id(1), _version(1));
+    osmium::builder::add_node(buffer, _id(2), _version(1));
+    osmium::builder::add_node(buffer, _id(1), _version(2));
+
+    osmium::HistoryStore store;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        store.add(object);
+    }
+
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE_THROWS_AS(store.get_versions(osmium::item_type::node, 1, out), const std::runtime_error&);
+}
+
+TEST_CASE("History store with many versions of an object") {
+    using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+    osmium::memory::Buffer buffer{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    for (osmium::object_version_type version = 1; version <= 100; ++version) {
+        osmium::builder::add_way(buffer, _id(1), _version(version), _cid(version), _timestamp(osmium::Timestamp{version * 100}), _uid(1), _user("someone"),
+                                 _tag("highway", "primary"), _tag("name", "Long Street Name"), _tag("ref", "B 123"),
+                                 _nodes({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 20 + version}));
+    }
+
+    osmium::HistoryStore store;
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        store.add(object);
+    }
+
+    osmium::memory::Buffer out{1024 * 1024, osmium::memory::Buffer::auto_grow::yes};
+    REQUIRE(store.get_versions(osmium::item_type::way, 1, out) == 100);
+    REQUIRE(out.committed() == buffer.committed());
+
+    auto it = out.select<osmium::OSMObject>().cbegin();
+    for (const auto& object : buffer.select<osmium::OSMObject>()) {
+        REQUIRE(same_object(object, *it));
+        ++it;
+    }
+}
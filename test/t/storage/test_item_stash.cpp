@@ -166,3 +166,122 @@ TEST_CASE("Fill item stash until it garbage collects") {
     REQUIRE(stash.count_removed() == 0);
 }
 
+
+static void check_items(const osmium::ItemStash& stash, const std::vector<osmium::ItemStash::handle_type>& handles) {
+    osmium::object_id_type id = 1;
+    for (const auto handle : handles) {
+        if (handle.valid()) {
+            REQUIRE(stash.get<osmium::OSMObject>(handle).id() == id);
+        }
+        ++id;
+    }
+}
+
+static void fill_segmented_stash(osmium::ItemStash& stash) {
+    const auto buffer = generate_test_data();
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    for (osmium::object_id_type id = 1; id <= 100000; ++id) {
+        osmium::memory::Buffer item_buffer{128, osmium::memory::Buffer::auto_grow::yes};
+        {
+            osmium::builder::NodeBuilder builder{item_buffer};
+            builder.set_id(id);
+        }
+        handles.push_back(stash.add_item(item_buffer.get<osmium::memory::Item>(0)));
+    }
+    REQUIRE(stash.size() == 100000);
+    check_items(stash, handles);
+
+    // remove most items from the first half
+    for (std::size_t i = 0; i < 50000; ++i) {
+        if (i % 10 != 0) {
+            stash.remove_item(handles[i]);
+            handles[i] = osmium::ItemStash::handle_type{};
+        }
+    }
+    REQUIRE(stash.size() == 55000);
+    REQUIRE(stash.count_removed() == 45000);
+    REQUIRE(stash.count_pending_segments() > 0);
+    check_items(stash, handles);
+
+    // every add compacts one segment
+    const auto pending = stash.count_pending_segments();
+    const auto removed = stash.count_removed();
+    handles.push_back(stash.add_item(buffer.get<osmium::memory::Item>(0)));
+    REQUIRE(stash.count_pending_segments() == pending - 1);
+    REQUIRE(stash.count_removed() < removed);
+    handles.back() = osmium::ItemStash::handle_type{};
+    check_items(stash, handles);
+
+    while (stash.count_pending_segments() > 0) {
+        stash.add_item(buffer.get<osmium::memory::Item>(0));
+    }
+    check_items(stash, handles);
+
+    // remove everything from the second half, whole segments get freed
+    for (std::size_t i = 50000; i < 100000; ++i) {
+        stash.remove_item(handles[i]);
+        handles[i] = osmium::ItemStash::handle_type{};
+    }
+    stash.garbage_collect();
+    REQUIRE(stash.count_removed() == 0);
+    REQUIRE(stash.count_pending_segments() == 0);
+    check_items(stash, handles);
+}
+
+TEST_CASE("Segmented item stash") {
+    osmium::ItemStash::config config;
+    config.segment_size = 64 * 1024;
+    osmium::ItemStash stash{config};
+    REQUIRE(stash.get_config().segment_size == 64 * 1024);
+
+    fill_segmented_stash(stash);
+    REQUIRE(stash.spilled_memory() == 0);
+
+    stash.clear();
+    REQUIRE(stash.size() == 0);
+    REQUIRE(stash.count_removed() == 0);
+}
+
+TEST_CASE("Segmented item stash spilling to disk") {
+    osmium::ItemStash stash;
+    osmium::ItemStash::config config;
+    config.segment_size = 64 * 1024;
+    config.spill = true;
+    config.hot_segments = 2;
+    stash.configure(config);
+
+    fill_segmented_stash(stash);
+    REQUIRE(stash.spilled_memory() > 0);
+}
+
+TEST_CASE("Segmented item stash with items larger than segment") {
+    osmium::ItemStash::config config;
+    config.segment_size = 1024;
+    config.spill = true;
+    config.hot_segments = 1;
+    osmium::ItemStash stash{config};
+
+    std::vector<osmium::ItemStash::handle_type> handles;
+    for (osmium::object_id_type id = 1; id <= 20; ++id) {
+        osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+        {
+            osmium::builder::WayBuilder builder{buffer};
+            builder.set_id(id);
+            osmium::builder::WayNodeListBuilder wnl_builder{builder};
+            for (int n = 0; n < id * 10; ++n) {
+                wnl_builder.add_node_ref(n);
+            }
+        }
+        handles.push_back(stash.add_item(buffer.get<osmium::memory::Item>(0)));
+    }
+
+    REQUIRE(stash.spilled_memory() > 0);
+    osmium::object_id_type id = 1;
+    for (const auto handle : handles) {
+        const auto& way = stash.get<osmium::Way>(handle);
+        REQUIRE(way.id() == id);
+        REQUIRE(way.nodes().size() == static_cast<std::size_t>(id * 10));
+        ++id;
+    }
+}
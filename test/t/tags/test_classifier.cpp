@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/tags/classifier.hpp>
+#include <osmium/tags/taglist.hpp>
+#include <osmium/tags/tags_filter.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Tags classifier") {
+    osmium::TagsFilter roads{false};
+    roads.add_rule(false, "highway", "proposed");
+    roads.add_rule(true, "highway");
+
+    osmium::TagsFilter buildings{false};
+    buildings.add_rule(true, "building");
+
+    osmium::TagsFilter named{false};
+    named.add_rule(true, osmium::StringMatcher::prefix{"name"});
+
+    osmium::TagsClassifier classifier;
+    REQUIRE(classifier.add(roads) == 0);
+    REQUIRE(classifier.add(buildings) == 1);
+    REQUIRE(classifier.add(named) == 2);
+    REQUIRE(classifier.size() == 3);
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    std::vector<std::size_t> positions;
+    positions.push_back(osmium::builder::add_tag_list(buffer, _tags({{"highway", "primary"}, {"name:de", "Hauptstraße"}})));
+    positions.push_back(osmium::builder::add_tag_list(buffer, _tags({{"building", "yes"}})));
+    positions.push_back(osmium::builder::add_tag_list(buffer, _tags({{"highway", "proposed"}, {"building", "no"}})));
+    positions.push_back(osmium::builder::add_tag_list(buffer, _tags({{"source", "GPS"}})));
+    positions.push_back(osmium::builder::add_tag_list(buffer, _tags({})));
+
+    const std::vector<osmium::TagsClassifier::bits_type> expected{5, 2, 2, 0, 0};
+
+    for (std::size_t n = 0; n < positions.size(); ++n) {
+        const auto& tags = buffer.get<osmium::TagList>(positions[n]);
+        const auto bits = classifier(tags);
+        REQUIRE(bits == expected[n]);
+        REQUIRE(osmium::TagsClassifier::test(bits, 0) == osmium::tags::match_any_of(tags, roads));
+        REQUIRE(osmium::TagsClassifier::test(bits, 1) == osmium::tags::match_any_of(tags, buildings));
+        REQUIRE(osmium::TagsClassifier::test(bits, 2) == osmium::tags::match_any_of(tags, named));
+    }
+}
+
+TEST_CASE("Tags classifier with too many filters") {
+    osmium::TagsClassifier classifier;
+    for (int n = 0; n < osmium::TagsClassifier::max_filters; ++n) {
+        osmium::TagsFilter filter{false};
+        filter.add_rule(true, "key");
+        classifier.add(filter);
+    }
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto pos = osmium::builder::add_tag_list(buffer, _tags({{"key", "value"}}));
+    REQUIRE(classifier(buffer.get<osmium::TagList>(pos)) == ~osmium::TagsClassifier::bits_type{0});
+
+    REQUIRE_THROWS_AS(classifier.add(osmium::TagsFilter{}), const std::length_error&);
+}
@@ -0,0 +1,143 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/tags/editor.hpp>
+
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+static std::string tags_as_string(const osmium::OSMObject& object) {
+    std::string result;
+    for (const auto& tag : object.tags()) {
+        result += tag.key();
+        result += '=';
+        result += tag.value();
+        result += ';';
+    }
+    return result;
+}
+
+static std::string nodes_as_string(const osmium::Way& way) {
+    std::string result;
+    for (const auto& node_ref : way.nodes()) {
+        result += std::to_string(node_ref.ref());
+        result += ';';
+    }
+    return result;
+}
+
+static osmium::Way& add_test_way(osmium::memory::Buffer& buffer) {
+    const auto pos = osmium::builder::add_way(buffer, _id(17),
+        _tag("highway", "residential"),
+        _tag("created_by", "JOSM"),
+        _tag("name", "Main Street"),
+        _nodes({1, 2, 3}));
+    return buffer.get<osmium::Way>(pos);
+}
+
+TEST_CASE("Replace tag value with value of same or shorter length") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::no};
+    auto& way = add_test_way(buffer);
+    const auto size = way.byte_size();
+    osmium::tags::TagEditor editor{way};
+
+    REQUIRE(editor.set_value("highway", "primary_xx"));
+    REQUIRE(tags_as_string(way) == "highway=primary_xx;created_by=JOSM;name=Main Street;");
+
+    REQUIRE(editor.set_value("name", "Main St"));
+    REQUIRE(tags_as_string(way) == "highway=primary_xx;created_by=JOSM;name=Main St;");
+    REQUIRE(nodes_as_string(way) == "1;2;3;");
+    REQUIRE(way.byte_size() == size);
+    REQUIRE(editor.slack() > 0);
+
+    REQUIRE(std::distance(buffer.begin(), buffer.end()) == 1);
+}
+
+TEST_CASE("Remove tags") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::no};
+    auto& way = add_test_way(buffer);
+    osmium::tags::TagEditor editor{way};
+
+    REQUIRE(editor.remove("created_by") == 1);
+    REQUIRE(editor.remove("foo") == 0);
+    REQUIRE(tags_as_string(way) == "highway=residential;name=Main Street;");
+    REQUIRE(nodes_as_string(way) == "1;2;3;");
+
+    REQUIRE(editor.remove_if([](const osmium::Tag&) { return true; }) == 2);
+    REQUIRE(way.tags().empty());
+    REQUIRE(nodes_as_string(way) == "1;2;3;");
+}
+
+TEST_CASE("Grow tags into slack") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::no};
+    auto& way = add_test_way(buffer);
+    osmium::tags::TagEditor editor{way};
+
+    REQUIRE(editor.remove("created_by") == 1);
+    const auto slack = editor.slack();
+    REQUIRE(slack >= std::strlen("created_by") + std::strlen("JOSM") + 2);
+
+    REQUIRE(editor.add_tag("oneway", "yes"));
+    REQUIRE(tags_as_string(way) == "highway=residential;name=Main Street;oneway=yes;");
+    REQUIRE(nodes_as_string(way) == "1;2;3;");
+    REQUIRE(editor.slack() == slack - std::strlen("oneway") - std::strlen("yes") - 2);
+
+    REQUIRE_FALSE(editor.set_value("name", "A very much longer name than there is space for"));
+    REQUIRE(tags_as_string(way) == "highway=residential;name=Main Street;oneway=yes;");
+}
+
+TEST_CASE("Copy object with slack and edit the copy") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::no};
+    auto& way = add_test_way(buffer);
+    REQUIRE_FALSE(osmium::tags::TagEditor{way}.add_tag("surface", "asphalt"));
+
+    osmium::memory::Buffer out{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto offset = osmium::tags::TagEditor::copy_with_slack(way, out, 100);
+    auto& copy = out.get<osmium::Way>(offset);
+    osmium::tags::TagEditor editor{copy};
+    REQUIRE(editor.slack() >= 100);
+
+    REQUIRE(editor.add_tag("surface", "asphalt"));
+    REQUIRE(editor.set_value("name", "A longer name than before"));
+    REQUIRE(tags_as_string(copy) == "highway=residential;created_by=JOSM;name=A longer name than before;surface=asphalt;");
+    REQUIRE(nodes_as_string(copy) == "1;2;3;");
+    REQUIRE(copy.id() == 17);
+
+    osmium::builder::add_node(out, _id(1));
+    REQUIRE(std::distance(out.begin(), out.end()) == 2);
+    auto it = out.select<osmium::OSMObject>().begin();
+    ++it;
+    REQUIRE(it->type() == osmium::item_type::node);
+    REQUIRE(it->id() == 1);
+}
+
+TEST_CASE("Add tag to object without tags") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto pos = osmium::builder::add_node(buffer, _id(1), _location(1.0, 2.0));
+    auto& node = buffer.get<osmium::Node>(pos);
+
+    REQUIRE_FALSE(osmium::tags::TagEditor{node}.add_tag("amenity", "pub"));
+
+    const auto offset = osmium::tags::TagEditor::copy_with_slack(node, buffer, 16);
+    auto& copy = buffer.get<osmium::Node>(offset);
+    osmium::tags::TagEditor editor{copy};
+    REQUIRE(editor.slack() >= 16);
+    REQUIRE(editor.set_value("amenity", "pub"));
+    REQUIRE(tags_as_string(copy) == "amenity=pub;");
+    REQUIRE(copy.location() == osmium::Location(1.0, 2.0));
+}
+
+TEST_CASE("Tag editor checks length of strings") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::no};
+    auto& way = add_test_way(buffer);
+    osmium::tags::TagEditor editor{way};
+    const std::string value(osmium::max_osm_string_length + 1, 'x');
+    REQUIRE_THROWS_AS(editor.set_value("name", value.c_str()), const std::length_error&);
+}
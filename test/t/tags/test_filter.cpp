@@ -5,6 +5,7 @@
 #include <osmium/osm/tag.hpp>
 #include <osmium/tags/filter.hpp>
 #include <osmium/tags/regex_filter.hpp>
+#include <osmium/util/regex.hpp>
 #include <osmium/tags/taglist.hpp>
 
 #include <algorithm>
@@ -252,3 +253,22 @@ TEST_CASE("Generic Filter with regex matches some keys") {
     check_filter(tag_list, filter, {false, false, true, true});
 
 }
+
+TEST_CASE("Filter with osmium::Regex matches some tags") {
+    osmium::memory::Buffer buffer{10240};
+
+    osmium::tags::Filter<std::string, osmium::Regex> filter{false};
+    filter.add(true, "highway", osmium::Regex{".*_link"});
+
+    const osmium::TagList& tag_list1 = make_tag_list(buffer, {
+        { "highway", "primary_link" },
+        { "source", "GPS" }
+    });
+    const osmium::TagList& tag_list2 = make_tag_list(buffer, {
+        { "highway", "primary_link_x" },
+        { "source", "GPS" }
+    });
+
+    check_filter(tag_list1, filter, {true, false});
+    check_filter(tag_list2, filter, {false, false});
+}
@@ -0,0 +1,76 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/tags/key_table.hpp>
+
+#include <cstring>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Key table") {
+    osmium::KeyTable table;
+    REQUIRE(table.empty());
+
+    const auto highway = table.add("highway");
+    const auto name = table.add(std::string{"name"});
+    REQUIRE(highway == 0);
+    REQUIRE(name == 1);
+    REQUIRE(table.add("highway") == highway);
+    REQUIRE(table.size() == 2);
+
+    REQUIRE(table.get("highway") == highway);
+    REQUIRE(table.get("name") == name);
+    REQUIRE(table.get("foo") == osmium::KeyTable::invalid_id);
+    REQUIRE(table.get("") == osmium::KeyTable::invalid_id);
+    REQUIRE(std::strcmp(table.key(name), "name") == 0);
+}
+
+TEST_CASE("Key table with many keys") {
+    osmium::KeyTable table;
+    for (int n = 0; n < 1000; ++n) {
+        REQUIRE(table.add("key" + std::to_string(n)) == static_cast<osmium::KeyTable::id_type>(n));
+    }
+
+    const osmium::KeyTable copy{table};
+    for (int n = 0; n < 1000; ++n) {
+        REQUIRE(table.get(("key" + std::to_string(n)).c_str()) == static_cast<osmium::KeyTable::id_type>(n));
+        REQUIRE(copy.get(("key" + std::to_string(n)).c_str()) == static_cast<osmium::KeyTable::id_type>(n));
+    }
+    REQUIRE(table.get("key1000") == osmium::KeyTable::invalid_id);
+}
+
+TEST_CASE("Tag values") {
+    osmium::KeyTable table;
+    const auto highway = table.add("highway");
+    const auto name = table.add("name");
+    const auto ref = table.add("ref");
+
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+    const auto pos1 = osmium::builder::add_tag_list(buffer, _tags({
+        {"highway", "primary"},
+        {"source", "GPS"},
+        {"name", "Main Street"},
+        {"highway", "secondary"}
+    }));
+    const auto pos2 = osmium::builder::add_tag_list(buffer, _tags({
+        {"ref", "B 1"}
+    }));
+
+    osmium::TagValues values{table};
+
+    const auto& tags1 = buffer.get<osmium::TagList>(pos1);
+    values.set(tags1);
+    REQUIRE(values.has(highway));
+    REQUIRE(std::string{values[highway]} == tags1.get_value_by_key("highway"));
+    REQUIRE(std::string{values.get(name)} == "Main Street");
+    REQUIRE_FALSE(values.has(ref));
+    REQUIRE(values[ref] == nullptr);
+    REQUIRE(std::string{values.get(ref, "none")} == "none");
+
+    values.set(buffer.get<osmium::TagList>(pos2));
+    REQUIRE_FALSE(values.has(highway));
+    REQUIRE_FALSE(values.has(name));
+    REQUIRE(std::string{values[ref]} == "B 1");
+}
@@ -141,3 +141,14 @@ TEST_CASE("Copy and move tag matcher") {
     REQUIRE_FALSE(c1("name", "High Street"));
 }
 
+
+TEST_CASE("Tag matcher matching key and value separately") {
+    const osmium::TagMatcher m{"highway", "motorway", true};
+
+    REQUIRE(m.match_key("highway"));
+    REQUIRE_FALSE(m.match_key("name"));
+    REQUIRE(m.match_value("primary"));
+    REQUIRE_FALSE(m.match_value("motorway"));
+    REQUIRE(m("highway", "primary"));
+    REQUIRE_FALSE(m("highway", "motorway"));
+}
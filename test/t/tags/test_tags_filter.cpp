@@ -4,9 +4,13 @@
 #include <osmium/memory/buffer.hpp>
 #include <osmium/tags/tags_filter.hpp>
 
+#include <cstddef>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 TEST_CASE("Tags filter") {
     osmium::memory::Buffer buffer{10240};
@@ -172,3 +176,94 @@ TEST_CASE("TagsFilterBase") {
 
 }
 
+
+TEST_CASE("Tags filter on key and value strings") {
+    osmium::TagsFilter filter{true};
+    filter.add_rule(false, "highway", "motorway");
+    filter.add_rule(true, "highway");
+
+    REQUIRE(filter.rules().size() == 2);
+    REQUIRE(filter.default_result());
+    REQUIRE_FALSE(filter.rules()[0].first);
+
+    REQUIRE(filter("highway", "primary"));
+    REQUIRE_FALSE(filter("highway", "motorway"));
+    REQUIRE(filter("name", "Main Street"));
+}
+
+TEST_CASE("Compiled tags filter gives same results as uncompiled") {
+    osmium::TagsFilterBase<int> filter{-1};
+    filter.add_rule(1, "highway", "motorway");
+    filter.add_rule(2, osmium::StringMatcher::prefix{"addr:"});
+    filter.add_rule(3, "highway");
+    filter.add_rule(4, osmium::StringMatcher::always_false{});
+    filter.add_rule(5, osmium::StringMatcher::list{{"name", "highway", "name"}}, "x");
+    filter.add_rule(6, osmium::StringMatcher::substring{"name"});
+    filter.add_rule(7, "building", osmium::StringMatcher::equal{"no"}, true);
+    filter.add_rule(8, osmium::StringMatcher::always_true{}, "yes");
+
+    const std::vector<std::pair<const char*, const char*>> tags{
+        {"highway", "motorway"}, {"highway", "x"}, {"addr:street", "x"},
+        {"name", "x"}, {"name", "y"}, {"old_name", "y"}, {"building", "no"},
+        {"building", "yes"}, {"foo", "yes"}, {"foo", "no"}, {"", ""}
+    };
+
+    std::vector<int> expected;
+    for (const auto& tag : tags) {
+        expected.push_back(filter(tag.first, tag.second));
+    }
+    REQUIRE(expected == (std::vector<int>{1, 3, 2, 5, 6, 6, -1, 7, 8, -1, -1}));
+
+    REQUIRE_FALSE(filter.compiled());
+    filter.compile();
+    REQUIRE(filter.compiled());
+
+    for (std::size_t n = 0; n < tags.size(); ++n) {
+        REQUIRE(filter(tags[n].first, tags[n].second) == expected[n]);
+    }
+
+    SECTION("Copied filter uses its own rules") {
+        const auto copy = std::make_shared<osmium::TagsFilterBase<int>>(filter);
+        filter = osmium::TagsFilterBase<int>{};
+        REQUIRE(copy->compiled());
+        for (std::size_t n = 0; n < tags.size(); ++n) {
+            REQUIRE((*copy)(tags[n].first, tags[n].second) == expected[n]);
+        }
+    }
+
+    SECTION("Adding a rule removes the index") {
+        filter.add_rule(9, "foo");
+        REQUIRE_FALSE(filter.compiled());
+        REQUIRE(filter("foo", "no") == 9);
+        filter.compile();
+        REQUIRE(filter("foo", "no") == 9);
+        REQUIRE(filter("highway", "motorway") == 1);
+    }
+}
+
+TEST_CASE("Compiled tags filter with many rules") {
+    osmium::TagsFilter filter{false};
+    for (int n = 0; n < 300; ++n) {
+        filter.add_rule(n % 2 == 0, "key" + std::to_string(n), "value" + std::to_string(n));
+    }
+    filter.add_rule(true, osmium::StringMatcher::prefix{"key1"});
+    filter.compile();
+
+    REQUIRE(filter("key0", "value0"));
+    REQUIRE_FALSE(filter("key1", "value1"));
+    REQUIRE(filter("key1", "other"));
+    REQUIRE_FALSE(filter("key2", "other"));
+    REQUIRE(filter("key100000", "value"));
+    REQUIRE_FALSE(filter("foo", "bar"));
+}
+
+TEST_CASE("Tags filter with substring_list value matcher") {
+    osmium::TagsFilter filter{false};
+    filter.add_rule(true, "name", osmium::StringMatcher::substring_list{{"Street", "Road", "Lane"}});
+    filter.compile();
+
+    REQUIRE(filter("name", "Main Street"));
+    REQUIRE(filter("name", "Roadside"));
+    REQUIRE_FALSE(filter("name", "Main Avenue"));
+    REQUIRE_FALSE(filter("ref", "Main Street"));
+}
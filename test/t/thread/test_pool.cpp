@@ -3,7 +3,10 @@
 #include <osmium/thread/pool.hpp>
 #include <osmium/util/compatibility.hpp>
 
+#include <atomic>
+#include <future>
 #include <stdexcept>
+#include <vector>
 
 struct test_job_with_result {
     int operator()() const {
@@ -105,3 +108,119 @@ TEST_CASE("can throw from job in user provided thread pool") {
     REQUIRE_THROWS_AS(future.get(), const std::runtime_error&);
 }
 
+
+TEST_CASE("parse list of cpus") {
+    REQUIRE(osmium::thread::detail::parse_cpu_list("").empty());
+    REQUIRE(osmium::thread::detail::parse_cpu_list("3\n") == std::vector<int>({3}));
+    REQUIRE(osmium::thread::detail::parse_cpu_list("0-3,8,10-11") == std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+}
+
+TEST_CASE("work-stealing pool runs all jobs") {
+    osmium::thread::Pool pool{4, 3, osmium::thread::pool_scheduling::work_stealing};
+    REQUIRE(pool.scheduling() == osmium::thread::pool_scheduling::work_stealing);
+    REQUIRE(pool.num_threads() == 4);
+
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 1000; ++i) {
+        futures.push_back(pool.submit([i]() {
+            return i * 2;
+        }));
+    }
+
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(futures[i].get() == i * 2);
+    }
+    REQUIRE(pool.queue_empty());
+}
+
+TEST_CASE("can throw from job in work-stealing pool") {
+    osmium::thread::Pool pool{2, 0, osmium::thread::pool_scheduling::work_stealing};
+    auto future = pool.submit(test_job_throw{});
+    REQUIRE_THROWS_AS(future.get(), const std::runtime_error&);
+}
+
+TEST_CASE("work-stealing pool finishes queued jobs before shutting down") {
+    std::atomic<int> count{0};
+    {
+        osmium::thread::Pool pool{3, 1000, osmium::thread::pool_scheduling::work_stealing};
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&count]() {
+                ++count;
+            });
+        }
+    }
+    REQUIRE(count == 100);
+}
+
+TEST_CASE("pools with pinned threads") {
+    for (const auto affinity : {osmium::thread::pool_affinity::cores, osmium::thread::pool_affinity::numa_nodes}) {
+        osmium::thread::Pool pool{2, 0, osmium::thread::pool_scheduling::work_stealing, affinity};
+        auto future = pool.submit(test_job_with_result{});
+        REQUIRE(future.get() == 42);
+
+        osmium::thread::Pool shared_pool{2, 0, osmium::thread::pool_scheduling::shared_queue, affinity};
+        auto shared_future = shared_pool.submit(test_job_with_result{});
+        REQUIRE(shared_future.get() == 42);
+    }
+}
+
+TEST_CASE("pool runs jobs with higher priority first") {
+    for (const auto scheduling : {osmium::thread::pool_scheduling::shared_queue, osmium::thread::pool_scheduling::work_stealing}) {
+        osmium::thread::Pool pool{1, 10, scheduling};
+
+        // Keep the only worker busy until all jobs are submitted.
+        std::promise<void> started;
+        std::promise<void> release;
+        auto release_future = release.get_future().share();
+        auto blocker = pool.submit([&started, release_future]() {
+            started.set_value();
+            release_future.wait();
+        });
+        started.get_future().wait();
+
+        std::vector<int> order;
+        std::vector<std::future<void>> futures;
+        futures.push_back(pool.submit([&order]() { order.push_back(1); }, osmium::thread::task_priority::low));
+        futures.push_back(pool.submit([&order]() { order.push_back(2); }));
+        futures.push_back(pool.submit([&order]() { order.push_back(3); }, osmium::thread::task_priority::high));
+        futures.push_back(pool.submit([&order]() { order.push_back(4); }));
+        futures.push_back(pool.submit([&order]() { order.push_back(5); }, osmium::thread::task_priority::high));
+        REQUIRE(pool.queue_size() == 5);
+
+        release.set_value();
+        blocker.get();
+        for (auto& future : futures) {
+            future.get();
+        }
+
+        REQUIRE(order == std::vector<int>({3, 5, 2, 4, 1}));
+    }
+}
+
+TEST_CASE("full queue of one priority doesn't block jobs with other priorities") {
+    for (const auto scheduling : {osmium::thread::pool_scheduling::shared_queue, osmium::thread::pool_scheduling::work_stealing}) {
+        osmium::thread::Pool pool{1, 1, scheduling};
+
+        std::promise<void> started;
+        std::promise<void> release;
+        auto release_future = release.get_future().share();
+        auto blocker = pool.submit([&started, release_future]() {
+            started.set_value();
+            release_future.wait();
+        });
+        started.get_future().wait();
+
+        // The queue for normal priority is full now, these would block
+        // if the limit was shared.
+        auto normal = pool.submit(test_job_with_result{});
+        auto high = pool.submit(test_job_with_result{}, osmium::thread::task_priority::high);
+        auto low = pool.submit(test_job_with_result{}, osmium::thread::task_priority::low);
+        REQUIRE(pool.queue_size() == 3);
+
+        release.set_value();
+        blocker.get();
+        REQUIRE(normal.get() == 42);
+        REQUIRE(high.get() == 42);
+        REQUIRE(low.get() == 42);
+    }
+}
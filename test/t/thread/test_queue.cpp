@@ -18,3 +18,23 @@ TEST_CASE("Queue can have max elements and can be named") {
     osmium::thread::Queue<int> queue{100, "Queue of max size 100"};
 }
 
+
+TEST_CASE("Queue keeps statistics") {
+    osmium::thread::Queue<int> queue{10};
+    REQUIRE(queue.max_size() == 10);
+
+    int value = 0;
+    REQUIRE_FALSE(queue.try_pop(value));
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    queue.wait_and_pop(value);
+    REQUIRE(queue.try_pop(value));
+
+    REQUIRE(queue.push_count() == 3);
+    REQUIRE(queue.full_count() == 0);
+    REQUIRE(queue.pop_count() == 3);
+    REQUIRE(queue.empty_count() == 1);
+    REQUIRE(queue.largest_size() == 3);
+    REQUIRE(queue.size() == 1);
+}
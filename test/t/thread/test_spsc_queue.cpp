@@ -0,0 +1,87 @@
+#include "catch.hpp"
+
+#include <osmium/thread/spsc_queue.hpp>
+
+#include <cstddef>
+#include <thread>
+
+TEST_CASE("Basic use of single-producer single-consumer queue") {
+    osmium::thread::SPSCQueue<int> queue;
+    REQUIRE(queue.empty());
+    queue.push(22);
+    REQUIRE_FALSE(queue.empty());
+    REQUIRE(queue.size() == 1);
+    int value = 0;
+    queue.wait_and_pop(value);
+    REQUIRE(value == 22);
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE("Unlimited SPSC queue can hold many elements") {
+    osmium::thread::SPSCQueue<int> queue;
+    for (int i = 0; i < 1000; ++i) {
+        queue.push(i);
+    }
+    REQUIRE(queue.size() == 1000);
+    REQUIRE(queue.largest_size() == 1000);
+
+    int value = 0;
+    for (int i = 0; i < 1000; ++i) {
+        REQUIRE(queue.try_pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE(queue.empty());
+    REQUIRE_FALSE(queue.try_pop(value));
+}
+
+TEST_CASE("SPSC queue keeps statistics") {
+    osmium::thread::SPSCQueue<int> queue{10};
+    REQUIRE(queue.max_size() == 10);
+
+    int value = 0;
+    REQUIRE_FALSE(queue.try_pop(value));
+    queue.push(1);
+    queue.push(2);
+    queue.push(3);
+    queue.wait_and_pop(value);
+    REQUIRE(queue.try_pop(value));
+
+    REQUIRE(queue.push_count() == 3);
+    REQUIRE(queue.full_count() == 0);
+    REQUIRE(queue.pop_count() == 3);
+    REQUIRE(queue.empty_count() == 1);
+    REQUIRE(queue.largest_size() == 3);
+    REQUIRE(queue.size() == 1);
+}
+
+TEST_CASE("Bounded SPSC queue between two threads keeps order") {
+    constexpr const int count = 100000;
+    osmium::thread::SPSCQueue<int> queue{5};
+
+    std::thread producer{[&queue] {
+        for (int i = 1; i <= count; ++i) {
+            queue.push(i);
+        }
+        queue.push(0);
+    }};
+
+    std::size_t n = 0;
+    int value = 0;
+    bool in_order = true;
+    while (true) {
+        queue.wait_and_pop(value);
+        if (value == 0) {
+            break;
+        }
+        ++n;
+        if (value != static_cast<int>(n)) {
+            in_order = false;
+        }
+    }
+    producer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(n == count);
+    REQUIRE(queue.largest_size() <= 5);
+    REQUIRE(queue.empty());
+}
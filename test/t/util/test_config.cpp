@@ -66,6 +66,37 @@ TEST_CASE("use_pool_threads_for_pbf_parsing") {
     REQUIRE(osmium::config::use_pool_threads_for_pbf_parsing());
 }
 
+TEST_CASE("use_work_stealing_pool") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::use_work_stealing_pool());
+    REQUIRE(osmium::detail::name == "OSMIUM_POOL_WORK_STEALING");
+    osmium::detail::env = "";
+    REQUIRE_FALSE(osmium::config::use_work_stealing_pool());
+    osmium::detail::env = "off";
+    REQUIRE_FALSE(osmium::config::use_work_stealing_pool());
+
+    osmium::detail::env = "on";
+    REQUIRE(osmium::config::use_work_stealing_pool());
+    osmium::detail::env = "Yes";
+    REQUIRE(osmium::config::use_work_stealing_pool());
+    osmium::detail::env = "1";
+    REQUIRE(osmium::config::use_work_stealing_pool());
+}
+
+TEST_CASE("get_pool_affinity") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_pool_affinity() == 0);
+    REQUIRE(osmium::detail::name == "OSMIUM_POOL_AFFINITY");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_pool_affinity() == 0);
+    osmium::detail::env = "cores";
+    REQUIRE(osmium::config::get_pool_affinity() == 1);
+    osmium::detail::env = "NUMA";
+    REQUIRE(osmium::config::get_pool_affinity() == 2);
+    osmium::detail::env = "foo";
+    REQUIRE(osmium::config::get_pool_affinity() == 0);
+}
+
 TEST_CASE("get_max_queue_size") {
     osmium::detail::env = nullptr;
     REQUIRE(osmium::config::get_max_queue_size("NAME", 0) == 2);
@@ -81,3 +112,36 @@ TEST_CASE("get_max_queue_size") {
     REQUIRE(osmium::config::get_max_queue_size("NAME", 7) == 3);
 }
 
+TEST_CASE("get_read_size") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_read_size() == 1024 * 1024);
+    REQUIRE(osmium::detail::name == "OSMIUM_READ_SIZE");
+    osmium::detail::env = "";
+    REQUIRE(osmium::config::get_read_size() == 1024 * 1024);
+    osmium::detail::env = "100";
+    REQUIRE(osmium::config::get_read_size() == 128 * 1024);
+    osmium::detail::env = "8192";
+    REQUIRE(osmium::config::get_read_size() == 8192 * 1024);
+    osmium::detail::env = "99999999";
+    REQUIRE(osmium::config::get_read_size() == 1024 * 1024 * 1024);
+}
+
+TEST_CASE("get_readahead_size") {
+    osmium::detail::env = nullptr;
+    REQUIRE(osmium::config::get_readahead_size() == 0);
+    REQUIRE(osmium::detail::name == "OSMIUM_READAHEAD");
+    osmium::detail::env = "foo";
+    REQUIRE(osmium::config::get_readahead_size() == 0);
+    osmium::detail::env = "4096";
+    REQUIRE(osmium::config::get_readahead_size() == 4096 * 1024);
+}
+
+TEST_CASE("drop_read_cache") {
+    osmium::detail::env = nullptr;
+    REQUIRE_FALSE(osmium::config::drop_read_cache());
+    REQUIRE(osmium::detail::name == "OSMIUM_DROP_READ_CACHE");
+    osmium::detail::env = "yes";
+    REQUIRE(osmium::config::drop_read_cache());
+    osmium::detail::env = "no";
+    REQUIRE_FALSE(osmium::config::drop_read_cache());
+}
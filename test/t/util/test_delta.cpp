@@ -2,6 +2,8 @@
 
 #include <osmium/util/delta.hpp>
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -87,3 +89,50 @@ TEST_CASE("delta encode and decode") {
     REQUIRE(a == c);
 }
 
+
+TEST_CASE("delta encode and decode spans of int") {
+    const std::vector<int> a = { 5, -9, 22, 13, 0, 23, 7 };
+
+    osmium::DeltaEncode<int, int> de{3};
+    std::vector<int> b(a.size());
+    REQUIRE(de.encode_span(a.data(), a.data() + a.size(), b.data()) == b.data() + b.size());
+    REQUIRE(de.value() == 7);
+    REQUIRE(b.front() == 2);
+    REQUIRE(b.back() == -16);
+
+    osmium::DeltaDecode<int, int> dd;
+    dd.update(3);
+    dd.decode_span(b.data(), b.data() + b.size(), b.data());
+    REQUIRE(a == b);
+}
+
+TEST_CASE("delta encode and decode spans of int64 match update()") {
+    std::vector<int64_t> values;
+    int64_t v = 1000000000000;
+    for (int i = 0; i < 1027; ++i) {
+        v += (i * 7919) % 201 - 100;
+        values.push_back(v);
+    }
+
+    for (std::size_t size : {0, 1, 2, 3, 4, 5, 8, 9, 1027}) {
+        osmium::DeltaEncode<int64_t, int64_t> de1;
+        osmium::DeltaEncode<int64_t, int64_t> de2;
+        de1.update(17);
+        de2.update(17);
+
+        std::vector<int64_t> expected;
+        for (std::size_t i = 0; i < size; ++i) {
+            expected.push_back(de1.update(values[i]));
+        }
+        std::vector<int64_t> deltas(size);
+        de2.encode_span(values.data(), values.data() + size, deltas.data());
+        REQUIRE(deltas == expected);
+        REQUIRE(de1.value() == de2.value());
+
+        osmium::DeltaDecode<int64_t, int64_t> dd;
+        dd.update(17);
+        dd.decode_span(deltas.data(), deltas.data() + size, deltas.data());
+        REQUIRE(std::equal(deltas.begin(), deltas.end(), values.begin()));
+        REQUIRE(dd.update(0) == (size ? values[size - 1] : 17));
+    }
+}
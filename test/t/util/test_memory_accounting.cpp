@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#define OSMIUM_WITH_MEMORY_ACCOUNTING
+#include <osmium/io/detail/string_table.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/util/memory_accounting.hpp>
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct FakeIndex {
+
+    std::size_t bytes = 0;
+
+    std::size_t used_memory() const noexcept {
+        return bytes;
+    }
+
+};
+
+TEST_CASE("Buffer memory is counted") {
+    const auto before = osmium::memory::buffer_memory_in_use();
+    {
+        osmium::memory::Buffer buffer{1024 * 1024};
+        REQUIRE(osmium::memory::buffer_memory_in_use() == before + buffer.capacity());
+
+        const auto capacity = buffer.capacity();
+        buffer.reserve_space(capacity + 100);
+        REQUIRE(osmium::memory::buffer_memory_in_use() == before + buffer.capacity());
+
+        osmium::memory::Buffer moved{std::move(buffer)};
+        REQUIRE(osmium::memory::buffer_memory_in_use() == before + moved.capacity());
+    }
+    REQUIRE(osmium::memory::buffer_memory_in_use() == before);
+}
+
+TEST_CASE("Memory accounting with sources") {
+    osmium::MemoryAccounting accounting;
+
+    FakeIndex index;
+    index.bytes = 4096;
+
+    {
+        const osmium::MemoryAccount account{"index", index, accounting};
+        REQUIRE(accounting.size() == 1);
+
+        osmium::memory::Buffer buffer{1024 * 1024};
+        const auto report = accounting.report();
+        REQUIRE(report.size() == 2);
+        REQUIRE(report[0].name == "buffers");
+        REQUIRE(report[0].bytes >= buffer.capacity());
+        REQUIRE(report[1].name == "index");
+        REQUIRE(report[1].bytes == 4096);
+
+        index.bytes = 8192;
+        REQUIRE(accounting.report()[1].bytes == 8192);
+        REQUIRE(accounting.total() == report[0].bytes + 8192);
+
+        std::ostringstream out;
+        accounting.print(out);
+        REQUIRE(out.str().find("index:") != std::string::npos);
+        REQUIRE(out.str().find("8 kB") != std::string::npos);
+        REQUIRE(out.str().find("total:") != std::string::npos);
+    }
+
+    REQUIRE(accounting.size() == 0);
+    REQUIRE(accounting.report().size() == 1);
+}
+
+TEST_CASE("Memory accounting with functions") {
+    osmium::MemoryAccounting accounting;
+
+    const auto id1 = accounting.add("one", []() { return std::size_t{1}; });
+    const auto id2 = accounting.add("two", []() { return std::size_t{2}; });
+    REQUIRE(id1 != id2);
+    REQUIRE(accounting.size() == 2);
+
+    accounting.remove(id1);
+    REQUIRE(accounting.size() == 1);
+    REQUIRE(accounting.report().back().name == "two");
+
+    accounting.remove(id1);
+    REQUIRE(accounting.size() == 1);
+}
+
+TEST_CASE("Global memory accounting instance") {
+    FakeIndex index;
+    index.bytes = 100;
+
+    const auto size = osmium::MemoryAccounting::instance().size();
+    {
+        const osmium::MemoryAccount account{"fake", index};
+        REQUIRE(osmium::MemoryAccounting::instance().size() == size + 1);
+    }
+    REQUIRE(osmium::MemoryAccounting::instance().size() == size);
+}
+
+TEST_CASE("String table reports used memory") {
+    osmium::io::detail::StringTable table;
+    const auto empty = table.used_memory();
+    REQUIRE(empty > 0);
+
+    for (int i = 0; i < 10000; ++i) {
+        table.add(std::to_string(i).c_str());
+    }
+    REQUIRE(table.used_memory() > empty);
+}
@@ -0,0 +1,53 @@
+#include "catch.hpp"
+
+#include <osmium/util/number_format.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+static std::string format_int(int64_t value) {
+    char buffer[20];
+    return std::string(buffer, osmium::detail::format_int(value, buffer));
+}
+
+static std::string format_uint(uint64_t value) {
+    char buffer[20];
+    return std::string(buffer, osmium::detail::format_uint(value, buffer));
+}
+
+TEST_CASE("Two digit table") {
+    REQUIRE(std::string(osmium::detail::two_digits(0), 2) == "00");
+    REQUIRE(std::string(osmium::detail::two_digits(7), 2) == "07");
+    REQUIRE(std::string(osmium::detail::two_digits(42), 2) == "42");
+    REQUIRE(std::string(osmium::detail::two_digits(99), 2) == "99");
+}
+
+TEST_CASE("Format unsigned integers") {
+    REQUIRE(format_uint(0) == "0");
+    REQUIRE(format_uint(9) == "9");
+    REQUIRE(format_uint(10) == "10");
+    REQUIRE(format_uint(99) == "99");
+    REQUIRE(format_uint(100) == "100");
+    REQUIRE(format_uint(12345) == "12345");
+    REQUIRE(format_uint(std::numeric_limits<uint64_t>::max()) == "18446744073709551615");
+}
+
+TEST_CASE("Format signed integers") {
+    REQUIRE(format_int(0) == "0");
+    REQUIRE(format_int(-1) == "-1");
+    REQUIRE(format_int(-10) == "-10");
+    REQUIRE(format_int(1000000) == "1000000");
+    REQUIRE(format_int(std::numeric_limits<int64_t>::max()) == "9223372036854775807");
+    REQUIRE(format_int(std::numeric_limits<int64_t>::min()) == "-9223372036854775808");
+}
+
+TEST_CASE("Format integers like std::to_string") {
+    int64_t value = 1;
+    for (int i = 0; i < 62; ++i) {
+        REQUIRE(format_int(value) == std::to_string(value));
+        REQUIRE(format_int(value - 1) == std::to_string(value - 1));
+        REQUIRE(format_int(-value) == std::to_string(-value));
+        value = value * 2 + (i % 3);
+    }
+}
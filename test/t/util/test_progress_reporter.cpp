@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include <osmium/util/progress_reporter.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FakeReader {
+
+    std::atomic<std::size_t> position{0};
+
+    std::size_t file_size() const noexcept {
+        return 1000;
+    }
+
+    std::size_t offset() const noexcept {
+        return position;
+    }
+
+};
+
+TEST_CASE("Progress reporter sends final report") {
+    std::vector<osmium::progress_report> reports;
+    std::mutex mutex;
+
+    FakeReader reader;
+    osmium::ProgressReporter progress{reader, [&](const osmium::progress_report& report) {
+        const std::lock_guard<std::mutex> lock{mutex};
+        reports.push_back(report);
+    }, std::chrono::milliseconds{1}};
+
+    reader.position = 250;
+    progress.add(10);
+    progress.add();
+    std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    progress.done();
+    progress.done();
+
+    REQUIRE(reports.size() > 1);
+
+    const auto& middle = reports[reports.size() - 2];
+    REQUIRE_FALSE(middle.done);
+    REQUIRE(middle.total_bytes == 1000);
+
+    const auto& last = reports.back();
+    REQUIRE(last.done);
+    REQUIRE(last.objects == 11);
+    REQUIRE(last.bytes == 1000);
+    REQUIRE(last.percent == Approx(100.0));
+    REQUIRE(last.eta == Approx(0.0));
+    REQUIRE(last.objects_per_second > 0.0);
+}
+
+TEST_CASE("Progress report calculates ETA") {
+    std::size_t position = 0;
+    osmium::ProgressReporter progress{400, [&position]() { return position; }, nullptr, std::chrono::milliseconds{1000}};
+
+    auto report = progress.report();
+    REQUIRE(report.bytes == 0);
+    REQUIRE(report.eta < 0.0);
+
+    position = 100;
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    report = progress.report();
+    REQUIRE(report.bytes == 100);
+    REQUIRE(report.percent == Approx(25.0));
+    REQUIRE(report.eta == Approx(report.elapsed * 3));
+    progress.done();
+}
+
+TEST_CASE("Progress report with unknown size") {
+    osmium::ProgressReporter progress{0, nullptr, nullptr};
+    progress.add(5);
+    const auto report = progress.report(true);
+    REQUIRE(report.objects == 5);
+    REQUIRE(report.bytes == 0);
+    REQUIRE(report.percent < 0.0);
+    REQUIRE(report.eta < 0.0);
+}
+
+TEST_CASE("Write progress report as JSON") {
+    osmium::progress_report report;
+    report.objects = 17;
+    report.bytes = 100;
+    report.total_bytes = 200;
+    report.percent = 50.0;
+    report.done = true;
+
+    std::ostringstream out;
+    osmium::write_progress_report_json(out, report);
+    const std::string json = out.str();
+    REQUIRE(json.find("{\"elapsed_s\":0,\"objects\":17,\"bytes\":100,\"total_bytes\":200,") == 0);
+    REQUIRE(json.find("\"percent\":50,") != std::string::npos);
+    REQUIRE(json.find("\"done\":true}\n") != std::string::npos);
+}
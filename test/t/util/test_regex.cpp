@@ -0,0 +1,43 @@
+#include "catch.hpp"
+
+#include <osmium/util/regex.hpp>
+
+#include <stdexcept>
+#include <string>
+
+TEST_CASE("Regex search and full match") {
+    const osmium::Regex regex{"a+b"};
+    REQUIRE(regex.pattern() == "a+b");
+
+    REQUIRE(regex.search("aab"));
+    REQUIRE(regex.search("xaabx"));
+    REQUIRE_FALSE(regex.search("ba"));
+
+    REQUIRE(regex.full_match("aab"));
+    REQUIRE_FALSE(regex.full_match("xaab"));
+    REQUIRE_FALSE(regex.full_match(""));
+}
+
+TEST_CASE("Regex with character classes and anchors") {
+    const osmium::Regex regex{std::string{"^[0-9]+ ?(km/h|mph)$"}};
+    REQUIRE(regex.search("50 km/h"));
+    REQUIRE(regex.search("30mph"));
+    REQUIRE_FALSE(regex.search("fast"));
+    REQUIRE_FALSE(regex.search("x50 km/h"));
+}
+
+TEST_CASE("Copied regex") {
+    const osmium::Regex regex{"foo|bar"};
+    const osmium::Regex copy{regex}; // NOLINT(performance-unnecessary-copy-initialization)
+    REQUIRE(copy.pattern() == "foo|bar");
+    REQUIRE(copy.search("xbar"));
+    REQUIRE(regex.search("foox"));
+}
+
+TEST_CASE("Invalid regex throws") {
+#ifdef OSMIUM_WITH_RE2
+    REQUIRE_THROWS_AS(osmium::Regex{"a(b"}, const std::invalid_argument&);
+#else
+    REQUIRE_THROWS_AS(osmium::Regex{"a(b"}, const std::regex_error&);
+#endif
+}
@@ -104,6 +104,19 @@ TEST_CASE("String matcher: regex substr") {
 }
 #endif
 
+TEST_CASE("String matcher: compiled_regex") {
+    const osmium::StringMatcher::compiled_regex m{"^foo.*bar$"};
+    REQUIRE(m.match("foobar"));
+    REQUIRE(m.match("foo to bar"));
+    REQUIRE_FALSE(m.match("xfoobar"));
+    REQUIRE_FALSE(m.match(""));
+
+    const osmium::StringMatcher sm{osmium::Regex{"o+"}};
+    REQUIRE(sm("foo"));
+    REQUIRE_FALSE(sm("bar"));
+    REQUIRE(print(sm) == "compiled_regex[o+]");
+}
+
 TEST_CASE("String matcher: list") {
     osmium::StringMatcher::list m{{"foo", "bar"}};
     REQUIRE(m.match("foo"));
@@ -126,6 +139,67 @@ TEST_CASE("String matcher: list with add") {
     REQUIRE_FALSE(m.match(""));
 }
 
+TEST_CASE("String matcher: list with many strings") {
+    osmium::StringMatcher::list m;
+    for (int n = 0; n < 1000; n += 2) {
+        m.add_string(std::to_string(n));
+    }
+    m.add_string("");
+    for (int n = 0; n < 1000; ++n) {
+        REQUIRE(m.match(std::to_string(n).c_str()) == (n % 2 == 0));
+    }
+    REQUIRE(m.match(""));
+    REQUIRE_FALSE(m.match("1000"));
+}
+
+TEST_CASE("String matcher: substring_list") {
+    const osmium::StringMatcher::substring_list m{{"he", "she", "hers", "his"}};
+    REQUIRE(m.match("he"));
+    REQUIRE(m.match("ushers"));
+    REQUIRE(m.match("this"));
+    REQUIRE(m.match("ahishers"));
+    REQUIRE(m.match("xxxshe"));
+    REQUIRE_FALSE(m.match("hi"));
+    REQUIRE_FALSE(m.match("sh"));
+    REQUIRE_FALSE(m.match(""));
+    REQUIRE(m.strings().size() == 4);
+    REQUIRE(print(osmium::StringMatcher{osmium::StringMatcher::substring_list{{"he", "she"}}}) == "substring_list[[he][she]]");
+}
+
+TEST_CASE("String matcher: substring_list with pattern found via failure link") {
+    const osmium::StringMatcher::substring_list m{{"abcd", "bc"}};
+    REQUIRE(m.match("xabcx"));
+    REQUIRE(m.match("abbcx"));
+    REQUIRE_FALSE(m.match("abdc"));
+}
+
+TEST_CASE("String matcher: empty substring_list") {
+    const osmium::StringMatcher::substring_list m{{}};
+    REQUIRE_FALSE(m.match("foo"));
+    REQUIRE_FALSE(m.match(""));
+
+    const osmium::StringMatcher::substring_list m2{{""}};
+    REQUIRE(m2.match("foo"));
+    REQUIRE(m2.match(""));
+}
+
+TEST_CASE("String matcher: substring_list gives same results as substring") {
+    std::vector<std::string> words;
+    for (int n = 0; n < 500; ++n) {
+        words.push_back(std::to_string(n * 7919 % 10007));
+    }
+    const osmium::StringMatcher::substring_list m{words};
+
+    for (int n = 0; n < 2000; ++n) {
+        const std::string test = "x" + std::to_string(n * 104729 % 1000003) + "y";
+        bool expected = false;
+        for (const auto& word : words) {
+            expected = expected || osmium::StringMatcher::substring{word}.match(test.c_str());
+        }
+        REQUIRE(m.match(test.c_str()) == expected);
+    }
+}
+
 TEST_CASE("Default constructed StringMatcher matches nothing") {
     osmium::StringMatcher m;
     REQUIRE_FALSE(m("foo"));
@@ -225,3 +299,63 @@ TEST_CASE("Move assign StringMatcher") {
     REQUIRE(print(m2) == "equal[foo]");
 }
 
+
+TEST_CASE("String matcher: match string views") {
+    // The views are not null-terminated
+    const char* data = "foobarbaz";
+    const osmium::string_view foobar{data, 6};
+    const osmium::string_view foo{data, 3};
+    const osmium::string_view empty{data, 0};
+
+    const osmium::StringMatcher always_false{false};
+    REQUIRE_FALSE(always_false(foobar));
+
+    const osmium::StringMatcher always_true{true};
+    REQUIRE(always_true(empty));
+
+    const osmium::StringMatcher equal{"foobar"};
+    REQUIRE(equal(foobar));
+    REQUIRE_FALSE(equal(foo));
+    REQUIRE_FALSE(equal(empty));
+
+    const osmium::StringMatcher prefix{osmium::StringMatcher::prefix{"foob"}};
+    REQUIRE(prefix(foobar));
+    REQUIRE_FALSE(prefix(foo));
+
+    const osmium::StringMatcher substring{osmium::StringMatcher::substring{"rba"}};
+    REQUIRE(substring(data));
+    REQUIRE_FALSE(substring(foobar));
+    REQUIRE(osmium::StringMatcher{osmium::StringMatcher::substring{""}}(empty));
+
+    const osmium::StringMatcher regex{osmium::StringMatcher::compiled_regex{"ar$"}};
+    REQUIRE(regex(foobar));
+    REQUIRE_FALSE(regex(foo));
+
+    const osmium::StringMatcher list{std::vector<std::string>{"x", "foo", "foobarbaz"}};
+    REQUIRE(list(foo));
+    REQUIRE_FALSE(list(foobar));
+    REQUIRE(list(data));
+    REQUIRE_FALSE(list(empty));
+
+    const osmium::StringMatcher substring_list{osmium::StringMatcher::substring_list{{"rb", "xx"}}};
+    REQUIRE(substring_list(data));
+    REQUIRE_FALSE(substring_list(foobar));
+}
+
+TEST_CASE("String matcher: string views give same results as C strings") {
+    const std::vector<osmium::StringMatcher> matchers = {
+        osmium::StringMatcher{"abc"},
+        osmium::StringMatcher{osmium::StringMatcher::prefix{"ab"}},
+        osmium::StringMatcher{osmium::StringMatcher::substring{"bc"}},
+        osmium::StringMatcher{osmium::StringMatcher::compiled_regex{"^a.c"}},
+        osmium::StringMatcher{std::vector<std::string>{"a", "abc", "cab", "bb"}},
+        osmium::StringMatcher{osmium::StringMatcher::substring_list{{"ca", "bb"}}}
+    };
+    const std::vector<std::string> tests = {"", "a", "ab", "abc", "abcd", "cab", "bb", "xbcx", "aacb"};
+
+    for (const auto& matcher : matchers) {
+        for (const auto& test : tests) {
+            REQUIRE(matcher(osmium::string_view{test}) == matcher(test.c_str()));
+        }
+    }
+}
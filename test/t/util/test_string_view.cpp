@@ -0,0 +1,79 @@
+#include "catch.hpp"
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/changeset.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/relation.hpp>
+#include <osmium/util/string_view.hpp>
+
+#include <sstream>
+#include <string>
+
+using namespace osmium::builder::attr; // NOLINT(google-build-using-namespace)
+
+TEST_CASE("Default constructed string_view is empty") {
+    const osmium::string_view view;
+    REQUIRE(view.empty());
+    REQUIRE(view.size() == 0);
+    REQUIRE(view == "");
+}
+
+TEST_CASE("Compare string views") {
+    const std::string str{"foobar"};
+    const osmium::string_view foobar{str};
+    const osmium::string_view foo{str.data(), 3};
+
+    REQUIRE(foobar.size() == 6);
+    REQUIRE(foo.length() == 3);
+    REQUIRE(foo[2] == 'o');
+    REQUIRE(foo == "foo");
+    REQUIRE(foo != foobar);
+    REQUIRE(foo < foobar);
+    REQUIRE_FALSE(foobar < foo);
+    REQUIRE(osmium::string_view{"bar"}.compare(foo) < 0);
+    REQUIRE(foobar.starts_with(foo));
+    REQUIRE_FALSE(foo.starts_with(foobar));
+    REQUIRE(foo.to_string() == "foo");
+
+    std::stringstream ss;
+    ss << foo;
+    REQUIRE(ss.str() == "foo");
+}
+
+TEST_CASE("String view accessors of OSM objects") {
+    osmium::memory::Buffer buffer{1024, osmium::memory::Buffer::auto_grow::yes};
+
+    osmium::builder::add_node(buffer, _id(1), _user("some user"));
+    osmium::builder::add_node(buffer, _id(2));
+    osmium::builder::add_relation(buffer, _id(3), _user("a"),
+        _member(osmium::item_type::way, 1, "outer"),
+        _member(osmium::item_type::way, 2, ""));
+    osmium::builder::add_changeset(buffer, _cid(4), _user("cuser"),
+        _comment({osmium::Timestamp{1}, 7, "cu", "some text"}));
+
+    auto it = buffer.begin();
+    auto& node1 = static_cast<osmium::Node&>(*it);
+    REQUIRE(node1.user_view() == "some user");
+    REQUIRE(node1.user_view().data() == node1.user());
+    node1.clear_user();
+    REQUIRE(node1.user_view().empty());
+
+    ++it;
+    REQUIRE(static_cast<const osmium::Node&>(*it).user_view().empty());
+
+    ++it;
+    const auto& relation = static_cast<const osmium::Relation&>(*it);
+    REQUIRE(relation.user_view() == "a");
+    auto mit = relation.members().begin();
+    REQUIRE(mit->role_view() == "outer");
+    ++mit;
+    REQUIRE(mit->role_view().empty());
+
+    ++it;
+    const auto& changeset = static_cast<const osmium::Changeset&>(*it);
+    REQUIRE(changeset.user_view() == "cuser");
+    const auto& comment = *changeset.discussion().begin();
+    REQUIRE(comment.user_view() == "cu");
+    REQUIRE(comment.text_view() == "some text");
+}
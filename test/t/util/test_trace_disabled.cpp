@@ -0,0 +1,17 @@
+#include "catch.hpp"
+
+#include <osmium/util/trace.hpp>
+
+#include <sstream>
+
+TEST_CASE("tracing is not compiled in by default") {
+    REQUIRE_FALSE(osmium::trace::enabled());
+    {
+        const osmium::trace::Span span{"test"};
+    }
+    REQUIRE(osmium::trace::events().empty());
+
+    std::ostringstream out;
+    osmium::trace::write_chrome_trace(out);
+    REQUIRE(out.str() == "{\"traceEvents\":[]}\n");
+}
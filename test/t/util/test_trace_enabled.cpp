@@ -0,0 +1,70 @@
+#include "catch.hpp"
+
+#define OSMIUM_WITH_TRACING
+#include <osmium/util/trace.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+
+TEST_CASE("Span records an event") {
+    osmium::trace::clear();
+    REQUIRE(osmium::trace::enabled());
+    {
+        const osmium::trace::Span span{"test"};
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const auto events = osmium::trace::events();
+    REQUIRE(events.size() == 1);
+    REQUIRE(std::strcmp(events[0].name, "test") == 0);
+    REQUIRE(events[0].duration >= std::chrono::milliseconds(1));
+}
+
+TEST_CASE("Events from different threads have different thread ids") {
+    osmium::trace::clear();
+    {
+        const osmium::trace::Span span{"main"};
+    }
+    std::thread thread{[]() {
+        const osmium::trace::Span span{"other"};
+    }};
+    thread.join();
+
+    const auto events = osmium::trace::events();
+    REQUIRE(events.size() == 2);
+    REQUIRE(std::strcmp(events[0].name, "main") == 0);
+    REQUIRE(std::strcmp(events[1].name, "other") == 0);
+    REQUIRE(events[0].thread != events[1].thread);
+}
+
+TEST_CASE("Add event with explicit times") {
+    osmium::trace::clear();
+    const auto start = osmium::trace::clock::now();
+    osmium::trace::add("explicit", start, start + std::chrono::microseconds(1500));
+
+    const auto events = osmium::trace::events();
+    REQUIRE(events.size() == 1);
+    REQUIRE(events[0].duration == std::chrono::microseconds(1500));
+
+    std::ostringstream out;
+    osmium::trace::write_chrome_trace(out);
+    const std::string json = out.str();
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    REQUIRE(json.find("\"name\":\"explicit\",\"ph\":\"X\"") != std::string::npos);
+    REQUIRE(json.find("\"dur\":1500.000,") != std::string::npos);
+}
+
+TEST_CASE("Clear removes all events") {
+    {
+        const osmium::trace::Span span{"test"};
+    }
+    osmium::trace::clear();
+    REQUIRE(osmium::trace::events().empty());
+}
+
+TEST_CASE("Opening trace marker file that can not be opened fails") {
+    REQUIRE_FALSE(osmium::trace::open_trace_marker("/nonexistent/trace_marker"));
+}